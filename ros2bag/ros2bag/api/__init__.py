@@ -21,6 +21,7 @@ from argparse import (
 import os
 from typing import Any
 from typing import Dict
+from typing import List
 from typing import Optional
 
 from rclpy.duration import Duration
@@ -98,6 +99,85 @@ def convert_yaml_to_qos_profile(qos_profile_dict: Dict) -> Dict[str, QoSProfile]
     return topic_profile_dict
 
 
+def convert_yaml_to_topic_decimation(
+    topic_decimation_dict: Dict
+) -> Dict[str, rosbag2_py.TopicDecimation]:
+    """Convert a YAML file of keep_every_n and max_frequency per topic to TopicDecimations."""
+    if not isinstance(topic_decimation_dict, dict):
+        raise ValueError('The topic decimation file must map topics to their decimation.')
+    topic_decimation = {}
+    for topic, settings in topic_decimation_dict.items():
+        unknown_keys = set(settings) - {'keep_every_n', 'max_frequency'}
+        if unknown_keys:
+            raise ValueError("Unknown decimation settings {} of topic '{}'.".format(
+                sorted(unknown_keys), topic))
+        keep_every_n = int(settings.get('keep_every_n', 1))
+        max_frequency = float(settings.get('max_frequency', 0.0))
+        if keep_every_n < 1:
+            raise ValueError("keep_every_n of topic '{}' must be at least 1.".format(topic))
+        if max_frequency < 0.0:
+            raise ValueError("max_frequency of topic '{}' must not be negative.".format(topic))
+        topic_decimation[topic] = rosbag2_py.TopicDecimation(
+            keep_every_n=keep_every_n, max_frequency=max_frequency)
+    return topic_decimation
+
+
+def convert_yaml_to_topic_publish_policies(
+    topic_policies_dict: Dict
+) -> Dict[str, rosbag2_py.TopicPublishPolicy]:
+    """Convert a YAML file of publish deadlines and overflow policies per topic."""
+    if not isinstance(topic_policies_dict, dict):
+        raise ValueError('The publish policy file must map topics to their policy.')
+    topic_policies = {}
+    for topic, settings in topic_policies_dict.items():
+        unknown_keys = set(settings) - {'deadline', 'overflow'}
+        if unknown_keys:
+            raise ValueError("Unknown publish policy settings {} of topic '{}'.".format(
+                sorted(unknown_keys), topic))
+        if 'deadline' not in settings:
+            raise ValueError("The publish policy of topic '{}' needs a deadline.".format(topic))
+        deadline = float(settings['deadline'])
+        overflow = str(settings.get('overflow', 'block'))
+        if deadline <= 0.0:
+            raise ValueError("The deadline of topic '{}' must be positive.".format(topic))
+        if overflow not in ('block', 'skip', 'detach'):
+            raise ValueError(
+                "overflow of topic '{}' must be 'block', 'skip' or 'detach'.".format(topic))
+        topic_policies[topic] = rosbag2_py.TopicPublishPolicy(
+            deadline=int(deadline * 1e9), overflow=overflow)
+    return topic_policies
+
+
+def convert_yaml_to_topic_routes(topic_routes_list: List) -> List[rosbag2_py.TopicRoute]:
+    """Convert a YAML list of routes of topics into sub-bags to TopicRoutes."""
+    if not isinstance(topic_routes_list, list):
+        raise ValueError('The topic routes file must be a list of routes.')
+    known_keys = {'name', 'topics_regex', 'compression_format', 'compression_mode',
+                  'max_bagfile_size', 'max_bagfile_duration', 'max_cache_size'}
+    topic_routes = []
+    for route in topic_routes_list:
+        if not isinstance(route, dict) or 'name' not in route or 'topics_regex' not in route:
+            raise ValueError('Every topic route must have a name and a topics_regex.')
+        unknown_keys = set(route) - known_keys
+        if unknown_keys:
+            raise ValueError("Unknown settings {} of topic route '{}'.".format(
+                sorted(unknown_keys), route['name']))
+        limits = {}
+        for key in ('max_bagfile_size', 'max_bagfile_duration', 'max_cache_size'):
+            if key in route:
+                limits[key] = int(route[key])
+                if limits[key] < 0:
+                    raise ValueError("{} of topic route '{}' must not be negative.".format(
+                        key, route['name']))
+        topic_routes.append(rosbag2_py.TopicRoute(
+            name=str(route['name']),
+            topics_regex=str(route['topics_regex']),
+            compression_format=str(route.get('compression_format', '')),
+            compression_mode=str(route.get('compression_mode', '')).upper(),
+            **limits))
+    return topic_routes
+
+
 def create_bag_directory(uri: str) -> Optional[str]:
     """Create a directory."""
     try:
@@ -117,6 +197,28 @@ def check_positive_float(value: Any) -> float:
         raise ArgumentTypeError('{} is not the valid type (float)'.format(value))
 
 
+def check_nonzero_float(value: Any) -> float:
+    """Argparse validator to verify that a value is a float and not zero."""
+    try:
+        fvalue = float(value)
+        if fvalue == 0.0:
+            raise ArgumentTypeError('{} is not in the valid range (!= 0.0)'.format(value))
+        return fvalue
+    except ValueError:
+        raise ArgumentTypeError('{} is not the valid type (float)'.format(value))
+
+
+def check_fraction(value: Any) -> float:
+    """Argparse validator to verify that a value is a float between 0.0 and 1.0."""
+    try:
+        fvalue = float(value)
+        if fvalue < 0.0 or fvalue > 1.0:
+            raise ArgumentTypeError('{} is not in the valid range [0.0, 1.0]'.format(value))
+        return fvalue
+    except ValueError:
+        raise ArgumentTypeError('{} is not the valid type (float)'.format(value))
+
+
 def check_path_exists(value: Any) -> str:
     """Argparse validator to verify a path exists."""
     try:
@@ -39,6 +39,16 @@ class BurstVerb(VerbExtension):
             help='size of message queue rosbag tries to hold in memory to help deterministic '
                  'playback. Larger size will result in larger memory needs but might prevent '
                  'delay of message playback.')
+        parser.add_argument(
+            '--read-ahead-queue-bytes', type=check_not_negative_int, default=0,
+            help='size in bytes of message queue rosbag tries to hold in memory. If set, it '
+                 'bounds the queue instead of --read-ahead-queue-size, which suits bags mixing '
+                 'small and large messages. Default is 0, which bounds the number of messages.')
+        parser.add_argument(
+            '--prefetch-queue-bytes', type=check_not_negative_int, default=0,
+            help='size in bytes of the serialized messages read from storage ahead of time on a '
+                 'separate thread, which hides the storage latency from playback. '
+                 'Default is 0, which reads messages on the thread filling the message queue.')
         parser.add_argument(
             '--topics', type=str, default=[], nargs='+',
             help='topics to replay, separated by space. If none specified, all topics will be '
@@ -87,6 +97,8 @@ class BurstVerb(VerbExtension):
         )
         play_options = PlayOptions()
         play_options.read_ahead_queue_size = args.read_ahead_queue_size
+        play_options.prefetch_queue_bytes = args.prefetch_queue_bytes
+        play_options.read_ahead_queue_bytes = args.read_ahead_queue_bytes
         play_options.node_prefix = NODE_NAME_PREFIX
         play_options.rate = 1.0
         play_options.topics_to_filter = args.topics
@@ -0,0 +1,70 @@
+# Copyright 2024 Open Source Robotics Foundation, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import time
+
+from ros2bag.api import print_error
+from ros2bag.verb import VerbExtension
+from rosbag2_py import BagCatalog
+
+
+class CatalogVerb(VerbExtension):
+    """Index the bags below directories and find bags by topic, time and size."""
+
+    def add_arguments(self, parser, cli_name):
+        parser.add_argument(
+            'catalog_file', help='File the summaries of the bags are kept in.')
+        parser.add_argument(
+            'directories', nargs='*', default=[],
+            help='Directories searched for bags. Without directories, only the catalog file '
+                 'is queried.')
+        parser.add_argument(
+            '--watch', type=float, default=0.0, metavar='SECONDS',
+            help='Update the catalog at this interval until interrupted, to pick up new bags '
+                 'and the closed splits of recordings.')
+        parser.add_argument(
+            '--topic', default='', help='Only list bags with messages of this topic.')
+        parser.add_argument(
+            '--start', type=int, default=-1, metavar='NANOSECONDS',
+            help='Only list bags with messages at or after this time.')
+        parser.add_argument(
+            '--end', type=int, default=-1, metavar='NANOSECONDS',
+            help='Only list bags with messages at or before this time.')
+
+    def main(self, *, args):
+        if args.watch < 0:
+            return print_error('--watch must not be negative')
+        if args.watch > 0 and not args.directories:
+            return print_error('--watch requires directories to search for bags')
+
+        try:
+            catalog = BagCatalog(args.catalog_file)
+            if args.directories:
+                catalog.update(args.directories)
+            if args.watch > 0:
+                while True:
+                    time.sleep(args.watch)
+                    updated = catalog.update(args.directories)
+                    if updated:
+                        print(f'updated {updated} bags')
+        except KeyboardInterrupt:
+            return
+        except RuntimeError as e:
+            return print_error(str(e))
+
+        for bag in catalog.find(
+                topic_name=args.topic, start_time_ns=args.start, end_time_ns=args.end):
+            state = '' if bag.closed else ', recording'
+            print(f'{bag.uri}: {bag.start_time_ns}-{bag.end_time_ns}, '
+                  f'{bag.message_count} messages, {bag.bag_size} bytes{state}')
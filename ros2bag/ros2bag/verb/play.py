@@ -16,9 +16,14 @@ from argparse import FileType
 
 from rclpy.qos import InvalidQoSProfileException
 from ros2bag.api import add_standard_reader_args
+from ros2bag.api import check_fraction
+from ros2bag.api import check_nonzero_float
 from ros2bag.api import check_not_negative_int
+from ros2bag.api import check_path_exists
 from ros2bag.api import check_positive_float
 from ros2bag.api import convert_yaml_to_qos_profile
+from ros2bag.api import convert_yaml_to_topic_decimation
+from ros2bag.api import convert_yaml_to_topic_publish_policies
 from ros2bag.api import print_error
 from ros2bag.verb import VerbExtension
 from ros2cli.node import NODE_NAME_PREFIX
@@ -46,8 +51,101 @@ class PlayVerb(VerbExtension):
                  'playback. Larger size will result in larger memory needs but might prevent '
                  'delay of message playback.')
         parser.add_argument(
-            '-r', '--rate', type=check_positive_float, default=1.0,
-            help='rate at which to play back messages. Valid range > 0.0.')
+            '--read-ahead-queue-bytes', type=check_not_negative_int, default=0,
+            help='size in bytes of message queue rosbag tries to hold in memory. If set, it '
+                 'bounds the queue instead of --read-ahead-queue-size, which suits bags mixing '
+                 'small and large messages. Default is 0, which bounds the number of messages.')
+        parser.add_argument(
+            '--publishing-threads', type=check_not_negative_int, default=0,
+            help='number of threads publishing the messages. The messages of a topic are '
+                 'published in order by the same thread, so a slow subscriber only delays its '
+                 'own topic. Default is 0, which publishes on the playback thread.')
+        parser.add_argument(
+            '--precise-timing-spin-us', type=check_not_negative_int, default=0,
+            help='time in microseconds before the publish time of each message which the '
+                 'playback thread spends spinning instead of sleeping, to publish more precisely '
+                 'at the cost of CPU load. Default is 0, which sleeps until the publish time.')
+        parser.add_argument(
+            '--playback-thread-priority', type=check_not_negative_int, default=0,
+            help='Real-time priority of the playback thread, on Linux only. Needs '
+                 'the privilege to raise the priority. Default is 0, which keeps the default '
+                 'scheduling policy.')
+        parser.add_argument(
+            '--playback-thread-policy', choices=['fifo', 'rr'], default='fifo',
+            help='Real-time scheduling policy of the playback thread, SCHED_FIFO or SCHED_RR, '
+                 'used with --playback-thread-priority. Default: %(default)s.')
+        parser.add_argument(
+            '--playback-thread-cpus', type=check_not_negative_int, nargs='+', default=[],
+            help='CPUs to pin the playback thread to, on Linux only. '
+                 'Default is no pinning.')
+        parser.add_argument(
+            '--storage-loading-thread-priority', type=check_not_negative_int, default=0,
+            help='Real-time priority of the thread reading messages from storage, like '
+                 '--playback-thread-priority.')
+        parser.add_argument(
+            '--storage-loading-thread-policy', choices=['fifo', 'rr'], default='fifo',
+            help='Real-time scheduling policy of the thread reading messages from storage. '
+                 'Default: %(default)s.')
+        parser.add_argument(
+            '--storage-loading-thread-cpus', type=check_not_negative_int, nargs='+', default=[],
+            help='CPUs to pin the thread reading messages from storage to, on Linux only. '
+                 'Default is no pinning.')
+        parser.add_argument(
+            '--release-window-us', type=check_not_negative_int, default=0,
+            help='time in microseconds of bag time after the time stamp of a message which is '
+                 'due. The messages up to that time stamp are published together with it, which '
+                 'saves a wake-up per message for bursts and high rates. Default is 0, which '
+                 'only publishes messages with the same time stamp together.')
+        parser.add_argument(
+            '--as-fast-as-possible', action='store_true', default=False,
+            help='publish the messages as fast as possible, ignoring their time stamps and the '
+                 'rate, e.g. to process a bag offline. Combined with --wait-for-all-acked, the '
+                 'subscribers pace playback by acknowledging the messages.')
+        parser.add_argument(
+            '--seek-history-ms', type=check_not_negative_int, default=0,
+            help='time in milliseconds of bag time before the playhead for which played '
+                 'messages are kept in memory. Seeking into them or into the messages read ahead '
+                 'does not access the storage. Default is 0, which keeps no played messages.')
+        parser.add_argument(
+            '--publisher-creation-threads', type=check_not_negative_int, default=0,
+            help='number of threads creating the publishers when the player starts, which '
+                 'shortens the startup for bags with many topics. Default is 0, which creates '
+                 'them one by one.')
+        parser.add_argument(
+            '--loop-cache-bytes', type=check_not_negative_int, default=0,
+            help='size in bytes of the messages kept in memory during the first pass through '
+                 'the bag. If the whole bag fits, --loop replays it from memory without '
+                 'accessing the storage. Default is 0, which keeps no messages.')
+        parser.add_argument(
+            '--preload', default=False, action='store_true',
+            help='read all messages to play into memory before playback starts, so that the '
+                 'timing of playback does not depend on the storage.')
+        parser.add_argument(
+            '--preload-max-bytes', type=check_not_negative_int, default=0,
+            help='maximum size in bytes of the messages read into memory with --preload. If '
+                 'they are larger, they are played from storage. Default is 0, which does not '
+                 'limit the size.')
+        parser.add_argument(
+            '--step-clock-topic', type=str, default='',
+            help='topic of rosgraph_msgs/msg/Clock steps of an external driver, e.g. a '
+                 'simulator running in lockstep with playback. The time of playback only '
+                 'advances to the time of each step, and is published on ~/step_completed once '
+                 'all messages up to it were published.')
+        parser.add_argument(
+            '--additional-bags', type=check_path_exists, nargs='+', default=[],
+            metavar='BAG_PATH',
+            help='further bags to play together with bag_path, merged by the time stamps of '
+                 'their messages from one clock and one playback thread. Their storage '
+                 'implementation is detected automatically.')
+        parser.add_argument(
+            '--prefetch-queue-bytes', type=check_not_negative_int, default=0,
+            help='size in bytes of the serialized messages read from storage ahead of time on a '
+                 'separate thread, which hides the storage latency from playback. '
+                 'Default is 0, which reads messages on the thread filling the message queue.')
+        parser.add_argument(
+            '-r', '--rate', type=check_nonzero_float, default=1.0,
+            help='rate at which to play back messages. A negative rate plays the bag backwards '
+                 'in time, from its end. Valid range != 0.0.')
         parser.add_argument(
             '--topics', type=str, default=[], nargs='+',
             help='Space-delimited list of topics to play.')
@@ -62,6 +160,19 @@ class PlayVerb(VerbExtension):
         parser.add_argument(
             '--qos-profile-overrides-path', type=FileType('r'),
             help='Path to a yaml file defining overrides of the QoS profile for specific topics.')
+        parser.add_argument(
+            '--topic-decimation-path', type=FileType('r'),
+            help='Path to a yaml file reducing the played messages of specific topics, e.g. '
+                 '"/camera: {keep_every_n: 5}" or "/imu: {max_frequency: 50.0}". Messages '
+                 'which are not played are dropped when they are read from the bag.')
+        parser.add_argument(
+            '--topic-publish-policies-path', type=FileType('r'),
+            help='Path to a yaml file of deadlines in seconds for publishing the messages of '
+                 'specific topics, and what to do if a subscriber holds up publishing beyond '
+                 'them, e.g. "/camera: {deadline: 0.05, overflow: detach}". "block" only reports '
+                 'missed deadlines, "skip" skips the messages of the topic while it still '
+                 'publishes an earlier one, and "detach" queues them for a publishing thread of '
+                 'the topic.')
         parser.add_argument(
             '-l', '--loop', action='store_true',
             help='enables loop playback when playing a bagfile: it starts back at the beginning '
@@ -74,6 +185,32 @@ class PlayVerb(VerbExtension):
             '--storage-config-file', type=FileType('r'),
             help='Path to a yaml file defining storage specific configurations. '
                  'See storage plugin documentation for the format of this file.')
+        parser.add_argument(
+            '--decompression-look-ahead-files', type=check_not_negative_int, default=0,
+            help='Number of split files after the one being played which are decompressed in '
+                 'the background, for bags compressed by file. Default is %(default)d, which '
+                 'decompresses each file when playback reaches it.')
+        parser.add_argument(
+            '--decompression-disk-budget', type=check_not_negative_int, default=0,
+            help='Maximum size in bytes of the decompressed files of a bag compressed by file '
+                 'which are kept on disk. Files which were played already are removed to stay '
+                 'within the budget. Default is %(default)d, which keeps all of them.')
+        parser.add_argument(
+            '--decompression-threads', type=check_not_negative_int, default=0,
+            help='Number of threads which decompress the messages of a bag compressed by '
+                 'message ahead of playback. Default is %(default)d, which decompresses each '
+                 'message when it is played.')
+        parser.add_argument(
+            '--next-file-open-fraction', type=check_fraction, default=0.0,
+            help='Fraction of the time range of a split file after which the next file is '
+                 'opened in the background, so that playback does not wait for the storage at '
+                 'split boundaries. Default is %(default)s, which opens each file when the '
+                 'previous one has been played.')
+        parser.add_argument(
+            '--read-buffer-pool-size', type=check_not_negative_int, default=0,
+            help='Bytes of payload buffers of played messages kept for reuse by the messages '
+                 'read next, instead of allocating a buffer for every message. Default is '
+                 '%(default)d, which allocates every message.')
         clock_args_group = parser.add_mutually_exclusive_group()
         clock_args_group.add_argument(
             '--clock', type=positive_float, nargs='?', const=40, default=0,
@@ -88,6 +225,21 @@ class PlayVerb(VerbExtension):
             '--clock-topics-all', default=False, action='store_true',
             help='Publishes an update on /clock immediately before each replayed message'
         )
+        parser.add_argument(
+            '--clock-thread', default=False, action='store_true',
+            help='publish /clock at the --clock frequency on a dedicated thread instead of a '
+                 'timer of the player node, so that busy callbacks do not delay the updates.')
+        parser.add_argument(
+            '--clock-thread-priority', type=check_not_negative_int, default=0,
+            help='SCHED_FIFO real-time priority of the --clock-thread, on Linux only. Needs the '
+                 'privilege to raise the priority. Default is 0, which keeps the default '
+                 'scheduling policy.')
+        parser.add_argument(
+            '--statistics-interval-ms', type=check_not_negative_int, default=0,
+            help='interval in milliseconds to publish how accurately messages are timed, the '
+                 'depth of the play queue, read and publish latencies and starvations of the '
+                 'play queue on the ~/play_statistics topic of the player. Default is 0, which '
+                 'does not measure them.')
         parser.add_argument(
             '-d', '--delay', type=positive_float, default=0.0,
             help='Sleep duration before play (each loop), in seconds. Negative durations invalid.')
@@ -163,6 +315,22 @@ class PlayVerb(VerbExtension):
             except (InvalidQoSProfileException, ValueError) as e:
                 return print_error(str(e))
 
+        topic_decimation = {}
+        if args.topic_decimation_path:
+            try:
+                topic_decimation = convert_yaml_to_topic_decimation(
+                    yaml.safe_load(args.topic_decimation_path))
+            except (TypeError, ValueError) as e:
+                return print_error(str(e))
+
+        topic_publish_policies = {}
+        if args.topic_publish_policies_path:
+            try:
+                topic_publish_policies = convert_yaml_to_topic_publish_policies(
+                    yaml.safe_load(args.topic_publish_policies_path))
+            except (TypeError, ValueError) as e:
+                return print_error(str(e))
+
         storage_config_file = ''
         if args.storage_config_file:
             storage_config_file = args.storage_config_file.name
@@ -172,13 +340,39 @@ class PlayVerb(VerbExtension):
             topic_remapping.append('--remap')
             topic_remapping.append(remap_rule)
 
-        storage_options = StorageOptions(
-            uri=args.bag_path,
-            storage_id=args.storage,
+        storage_options = [StorageOptions(
+            uri=bag_path,
+            storage_id=args.storage if index == 0 else '',
             storage_config_uri=storage_config_file,
-        )
+            decompression_look_ahead_files=args.decompression_look_ahead_files,
+            decompression_disk_budget=args.decompression_disk_budget,
+            decompression_threads=args.decompression_threads,
+            next_file_open_fraction=args.next_file_open_fraction,
+            read_buffer_pool_size=args.read_buffer_pool_size,
+        ) for index, bag_path in enumerate([args.bag_path] + args.additional_bags)]
         play_options = PlayOptions()
         play_options.read_ahead_queue_size = args.read_ahead_queue_size
+        play_options.prefetch_queue_bytes = args.prefetch_queue_bytes
+        play_options.read_ahead_queue_bytes = args.read_ahead_queue_bytes
+        play_options.publishing_threads = args.publishing_threads
+        play_options.precise_timing_spin_duration = args.precise_timing_spin_us * 1000
+        play_options.playback_thread_priority = args.playback_thread_priority
+        play_options.playback_thread_policy = args.playback_thread_policy
+        play_options.playback_thread_cpus = args.playback_thread_cpus
+        play_options.storage_loading_thread_priority = args.storage_loading_thread_priority
+        play_options.storage_loading_thread_policy = args.storage_loading_thread_policy
+        play_options.storage_loading_thread_cpus = args.storage_loading_thread_cpus
+        play_options.release_window = args.release_window_us * 1000
+        play_options.as_fast_as_possible = args.as_fast_as_possible
+        play_options.seek_history_duration = args.seek_history_ms * 1000000
+        play_options.publisher_creation_threads = args.publisher_creation_threads
+        play_options.loop_cache_bytes = args.loop_cache_bytes
+        play_options.preload = args.preload
+        play_options.preload_max_bytes = args.preload_max_bytes
+        play_options.step_clock_topic = args.step_clock_topic
+        play_options.clock_publish_thread = args.clock_thread
+        play_options.clock_publish_thread_priority = args.clock_thread_priority
+        play_options.statistics_publish_interval = args.statistics_interval_ms * 1000000
         play_options.node_prefix = NODE_NAME_PREFIX
         play_options.rate = args.rate
         play_options.topics_to_filter = args.topics
@@ -187,6 +381,8 @@ class PlayVerb(VerbExtension):
         play_options.topic_qos_profile_overrides = qos_profile_overrides
         play_options.loop = args.loop
         play_options.topic_remapping_options = topic_remapping
+        play_options.topic_decimation = topic_decimation
+        play_options.topic_publish_policies = topic_publish_policies
         play_options.clock_publish_frequency = args.clock
         if args.clock_topics_all or len(args.clock_topics) > 0:
             play_options.clock_publish_on_topic_publish = True
@@ -203,6 +399,6 @@ class PlayVerb(VerbExtension):
 
         player = Player()
         try:
-            player.play(storage_options, play_options)
+            player.play_bags(storage_options, play_options)
         except KeyboardInterrupt:
             pass
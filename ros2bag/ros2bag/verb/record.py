@@ -19,6 +19,8 @@ import os
 from rclpy.qos import InvalidQoSProfileException
 from ros2bag.api import add_writer_storage_plugin_extensions
 from ros2bag.api import convert_yaml_to_qos_profile
+from ros2bag.api import convert_yaml_to_topic_decimation
+from ros2bag.api import convert_yaml_to_topic_routes
 from ros2bag.api import print_error
 from ros2bag.api import SplitLineFormatter
 from ros2bag.verb import VerbExtension
@@ -99,6 +101,11 @@ class RecordVerb(VerbExtension):
         parser.add_argument(
             '--qos-profile-overrides-path', type=FileType('r'),
             help='Path to a yaml file defining overrides of the QoS profile for specific topics.')
+        parser.add_argument(
+            '--topic-decimation-path', type=FileType('r'),
+            help='Path to a yaml file reducing the recorded messages of specific topics, e.g. '
+                 '"/camera: {keep_every_n: 10}" or "/imu: {max_frequency: 50.0}". Messages '
+                 'which are not recorded are dropped as soon as they are received.')
 
         # Core config
         parser.add_argument(
@@ -116,14 +123,216 @@ class RecordVerb(VerbExtension):
                  'Default: %(default)d, recording written in single bagfile and splitting '
                  'is disabled. If both splitting by size and duration are enabled, '
                  'the bag will split at whichever threshold is reached first.')
+        parser.add_argument(
+            '--stripe-directories', type=str, nargs='+', metavar='DIRECTORY', default=[],
+            help='Stripe the bag over the directories, e.g. on separate disks. Every directory '
+                 'gets a bag of its own written by its own writer, and the metadata of the '
+                 'output bag lists their files, which are read merged by time. '
+                 'Not compatible with compression.')
+        parser.add_argument(
+            '--stripe-by', type=str, default='topic', choices=['topic', 'batch'],
+            help='Assignment of messages to the stripes of --stripe-directories or the shards '
+                 'of --writer-shards: all messages of a topic to one stripe, or batches of '
+                 '--stripe-batch-size bytes to the stripes in turns. Default: %(default)s.')
+        parser.add_argument(
+            '--stripe-batch-size', type=int, default=4*1024*1024,
+            help='Bytes of messages written to one stripe before the next one with '
+                 '--stripe-by batch. Default: %(default)d.')
+        parser.add_argument(
+            '--writer-shards', type=int, default=1, metavar='K',
+            help='Write the bag as K shards within the bag directory, each with its own cache, '
+                 'writer thread and files, for more write throughput than a single writer '
+                 'thread reaches. Messages are assigned to shards by --stripe-by, and the files '
+                 'of the shards are read merged by time. Not compatible with compression and '
+                 '--stripe-directories. Default: %(default)d.')
+        parser.add_argument(
+            '--topic-routes-path', type=FileType('r'),
+            help='Path to a yaml file listing routes of topics into sub-bags of the bag, e.g. '
+                 '"- {name: camera, topics_regex: /camera/.*, compression_format: zstd, '
+                 'compression_mode: file, max_bagfile_size: 4000000000}". Every sub-bag is '
+                 'written by its own writer with its own cache, compression and split policy. '
+                 'Topics matching no route are recorded into the sub-bag "default". '
+                 'Not compatible with --stripe-directories and --writer-shards.')
+        parser.add_argument(
+            '--upload-command', type=str, default='',
+            help='Command run in the background for every closed file of the bag while the '
+                 'recording continues, e.g. "aws s3 cp {file} s3://bucket/{key}". {file} is '
+                 'replaced with the path of the file and {key} with the names of the bag '
+                 'directory and the file. The command runs with the lowest CPU and IO priority '
+                 'and is retried until it succeeds.')
+        parser.add_argument(
+            '--upload-max-bandwidth', type=int, default=0,
+            help='Average upload rate in bytes per second of --upload-command. '
+                 'Default: %(default)d, not limited.')
+        parser.add_argument(
+            '--upload-journal', type=str, default='',
+            help='File listing the files not uploaded yet by --upload-command. Files still '
+                 'pending when the recording stops are uploaded first by the next recording '
+                 'with the same journal.')
         parser.add_argument(
             '--max-cache-size', type=int, default=100*1024*1024,
             help='Maximum size (in bytes) of messages to hold in each buffer of cache. '
+                 'Messages count with their allocated capacity and bookkeeping overhead. '
                  'Default: %(default)d. The cache is handled through double buffering, '
                  'which means that in pessimistic case up to twice the parameter value of memory '
                  'is needed. A rule of thumb is to cache an order of magnitude corresponding to '
                  'about one second of total recorded data volume. '
                  'If the value specified is 0, then every message is directly written to disk.')
+        parser.add_argument(
+            '--lock-free-cache', action='store_true', default=False,
+            help='Use a lock-free ring buffer of --max-cache-size bytes as message cache. '
+                 'Subscription callbacks running on different threads never block each other. '
+                 'Has no effect in snapshot mode.')
+        parser.add_argument(
+            '--cache-per-topic', action='store_true', default=False,
+            help='Split the message cache into one shard per topic. Every shard holds up to '
+                 '--max-cache-size bytes unless set with --cache-shard-size, so a high '
+                 'bandwidth topic can only cause drops on its own topic. '
+                 'Has no effect in snapshot mode.')
+        parser.add_argument(
+            '--cache-topic-group', type=str, metavar='GROUP=TOPIC[,TOPIC...]', nargs='*',
+            help='Topics sharing one cache shard. Enables cache sharding, topics outside of '
+                 'any group share a default shard unless --cache-per-topic is set.')
+        parser.add_argument(
+            '--cache-shard-size', type=str, metavar='NAME=BYTES', nargs='*',
+            help='Maximum size in bytes of the cache shard of a topic group or topic. '
+                 'Shards not listed hold up to --max-cache-size bytes.')
+        parser.add_argument(
+            '--cache-shard-policy', type=str, metavar='NAME=POLICY', nargs='*',
+            help='Overflow policy of the cache shard of a topic group or topic, one of '
+                 '"drop_newest", "drop_oldest" or "block". Shards not listed use '
+                 '--cache-overflow-policy.')
+        parser.add_argument(
+            '--cache-topic-priority', type=str, metavar='TOPIC=PRIORITY', nargs='*',
+            help='Priority of a topic in the cache. When the cache is full, the oldest messages '
+                 'of topics with lower priority are dropped first to make room for messages of '
+                 'higher priority. Topics not listed have priority 0. Only supported by the '
+                 'default cache with --cache-overflow-policy drop_newest.')
+        parser.add_argument(
+            '--cache-overflow-policy', default='drop_newest',
+            choices=['drop_newest', 'drop_oldest', 'block', 'spill_to_disk'],
+            help='What to do with messages received while the cache is full. '
+                 '"drop_newest" drops the new message, "drop_oldest" drops the oldest messages '
+                 'not yet written, "block" holds the subscription callback until the cache '
+                 'has space again and "spill_to_disk" appends messages to a spill file until '
+                 'writing caught up. Default: %(default)s. Snapshot mode and the lock-free '
+                 'cache only support "drop_newest", the sharded cache does not support '
+                 '"spill_to_disk".')
+        parser.add_argument(
+            '--cache-block-timeout', type=int, default=0,
+            help='Maximum time in milliseconds to wait for cache space with '
+                 '--cache-overflow-policy block before dropping the message. '
+                 'Default: %(default)d, wait without limit.')
+        parser.add_argument(
+            '--cache-spill-dir', type=str, default='',
+            help='Directory of the spill file for --cache-overflow-policy spill_to_disk, '
+                 'preferably on a different device than the bag. '
+                 'Default: the temporary directory of the system.')
+        parser.add_argument(
+            '--cache-spill-size', type=int, default=1024*1024*1024,
+            help='Size in bytes of the spill file, allocated when recording starts. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--cache-min-batch-size', type=int, default=0,
+            help='Minimum number of bytes collected from the cache before they are written '
+                 'to storage in one batch. Default: %(default)d, write every cache swap.')
+        parser.add_argument(
+            '--cache-max-batch-size', type=int, default=0,
+            help='Maximum number of bytes written to storage in one batch. '
+                 'Default: %(default)d, unlimited.')
+        parser.add_argument(
+            '--cache-max-batch-latency', type=int, default=100,
+            help='Maximum time in milliseconds a message waits in an incomplete batch. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--cache-adaptive-batching', action='store_true', default=False,
+            help='Adapt the batch size to the measured write throughput of the storage, within '
+                 '--cache-min-batch-size and --cache-max-batch-size.')
+        parser.add_argument(
+            '--cache-consumer-thread-priority', type=int, default=0,
+            help='Real-time priority from 1 to 99 of the thread writing the cache to storage, on '
+                 'Linux only. Needs the privilege to raise the priority. Default is 0, which '
+                 'keeps the default scheduling policy.')
+        parser.add_argument(
+            '--cache-consumer-thread-policy', choices=['fifo', 'rr'], default='fifo',
+            help='Real-time scheduling policy of the thread writing the cache to storage, '
+                 'SCHED_FIFO or SCHED_RR. Default: %(default)s.')
+        parser.add_argument(
+            '--cache-consumer-thread-cpus', type=int, nargs='+', default=[],
+            help='CPUs to pin the thread writing the cache to storage to, on Linux only, e.g. '
+                 'to keep it off the cores of real-time processes. Default is no pinning.')
+        parser.add_argument(
+            '--deduplication-min-payload-size', type=int, default=0,
+            help='Store messages of at least this many bytes which repeat an earlier message of '
+                 'the same topic in the same bag file as a reference to it, e.g. for latched '
+                 'maps. Readers resolve the references transparently. Default is 0, which '
+                 'disables deduplication.')
+        parser.add_argument(
+            '--deduplication-cache-size', type=int, default=64 * 1024 * 1024,
+            help='Maximum number of bytes of messages kept to detect repeats with '
+                 '--deduplication-min-payload-size. Default: %(default)d.')
+        parser.add_argument(
+            '--delta-encoded-topics', type=str, nargs='+', default=[],
+            help='Topics whose messages are stored as the bytes which differ from the last '
+                 'keyframe of the topic, e.g. occupancy grids or costmaps of which only small '
+                 'regions change. Readers reconstruct the messages transparently.')
+        parser.add_argument(
+            '--delta-keyframe-interval', type=int, default=10,
+            help='Store every n-th message of --delta-encoded-topics completely as a keyframe. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--preview-bucket-duration', type=int, default=0,
+            help='Store a preview of the bag in the bag directory when recording stops, with '
+                 'the message count and bytes of every topic per time bucket of this many '
+                 'milliseconds, for timeline views which should not read the whole bag. '
+                 'Default is 0, which disables the preview.')
+        parser.add_argument(
+            '--preview-sample-topics', type=str, nargs='+', default=[],
+            help='Topics of which the preview keeps every --preview-sample-interval-th message, '
+                 'e.g. to show thumbnails of camera topics.')
+        parser.add_argument(
+            '--preview-sample-interval', type=int, default=100,
+            help='Keep every n-th message of --preview-sample-topics in the preview. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--async-split', action='store_true', default=False,
+            help='Open the next bag file ahead of time and close the previous one in the '
+                 'background, so that splitting does not hold up recording.')
+        parser.add_argument(
+            '--max-bag-retention-size', type=int, default=0,
+            help='Keep only the newest bag files for always-on recording: after each split, the '
+                 'oldest files are deleted while the closed files exceed this many bytes '
+                 'together. The file being written comes on top of it. '
+                 'Default: %(default)d, keep all files.')
+        parser.add_argument(
+            '--max-bag-retention-duration', type=int, default=0,
+            help='Like --max-bag-retention-size, but deletes the closed bag files whose messages '
+                 'are all older than this many seconds before the newest message. '
+                 'Default: %(default)d, keep all files.')
+        parser.add_argument(
+            '--preallocate-bagfiles', action='store_true', default=False,
+            help='Reserve --max-bag-size bytes on disk for each new bag file and truncate the '
+                 'file to its recorded size when it is closed.')
+        parser.add_argument(
+            '--durability-interval-ms', type=int, default=0,
+            help='Commit or sync the recorded data to disk at the latest this many milliseconds '
+                 'after it was written, grouping all batches written in between. Bounds the data '
+                 'lost on a power cut. Default: %(default)d, left to the storage configuration.')
+        parser.add_argument(
+            '--durability-bytes', type=int, default=0,
+            help='Like --durability-interval-ms, but commit or sync the recorded data once this '
+                 'many bytes were written since the last commit. '
+                 'Default: %(default)d, left to the storage configuration.')
+        parser.add_argument(
+            '--message-definition-cache-dir', type=str, default='',
+            help='Directory in which the message definitions of recorded types are kept across '
+                 'recordings, keyed by type and type description hash. '
+                 'Default: no cache, definitions are read from their packages.')
+        parser.add_argument(
+            '--message-definition-threads', type=int, default=0,
+            help='Number of threads reading the message definitions of discovered topics in '
+                 'the background. Default: %(default)d, definitions are read when their topic '
+                 'is subscribed.')
         parser.add_argument(
             '--start-paused', action='store_true', default=False,
             help='Start the recorder in a paused state.')
@@ -131,6 +340,59 @@ class RecordVerb(VerbExtension):
             '--use-sim-time', action='store_true', default=False,
             help='Use simulation time for message timestamps by subscribing to the /clock topic. '
                  'Until first /clock message is received, no messages will be written to bag.')
+        parser.add_argument(
+            '--record-publish-info', action='store_true', default=False,
+            help='Record the publish time and the publisher sequence number of messages, as '
+                 'reported by the middleware. Written to the publishTime and sequence fields of '
+                 'MCAP messages and used for reading sqlite3 bags in publish time order.')
+        parser.add_argument(
+            '--use-receive-timestamp', action='store_true', default=False,
+            help='Stamp messages with the receive time reported by the middleware instead of '
+                 'the clock of the recorder, which is more accurate and cheaper. Not compatible '
+                 'with --use-sim-time.')
+        parser.add_argument(
+            '--message-buffer-pool-size', type=int, default=0,
+            help='Number of written messages per topic whose buffers are reused to receive the '
+                 'next messages, which saves allocating large messages, e.g. camera images, '
+                 'again and again. Default: %(default)d, allocate every message.')
+        parser.add_argument(
+            '--message-buffer-arena-size', type=int, default=0,
+            help='Bytes reserved on huge pages for the buffers of received messages, e.g. the '
+                 'size of the message cache. Messages which do not fit are allocated as usual. '
+                 'Default: %(default)d, allocate every message as usual.')
+        parser.add_argument(
+            '--message-buffer-numa-node', type=int, default=-1,
+            help='NUMA node the memory of --message-buffer-arena-size is bound to. The cache '
+                 'consumer thread is pinned to the CPUs of the node, unless '
+                 '--cache-consumer-thread-cpus is given. Only supported on Linux. '
+                 'Default: %(default)d, no node.')
+        parser.add_argument(
+            '--executor-threads', type=int, default=1,
+            help='Number of threads which take messages from the subscriptions. More than one '
+                 'thread requires --callback-groups. Default: %(default)d.')
+        parser.add_argument(
+            '--callback-groups', type=str, default='none', choices=['none', 'topic', 'qos'],
+            help='Partitioning of the subscriptions into callback groups, whose messages are '
+                 'taken in parallel by the --executor-threads. "none" subscribes all topics in '
+                 'one group, "topic" puts every --topics-per-callback-group topics into a group '
+                 'and "qos" groups the topics by reliability and durability. '
+                 'Default: %(default)s.')
+        parser.add_argument(
+            '--topics-per-callback-group', type=int, default=1,
+            help='Number of topics in each callback group with --callback-groups topic. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--subscription-creation-threads', type=int, default=0,
+            help='Number of threads subscribing to the discovered topics, which shortens the '
+                 'start of recordings with many topics. Topics with a higher '
+                 '--cache-topic-priority are subscribed first. Default is 0, which subscribes '
+                 'them one by one.')
+        parser.add_argument(
+            '--pipeline-statistics-interval', type=int, default=0,
+            help='Interval in milliseconds to publish the latency histograms and queue depths '
+                 'of the stages of the recording on the ~/record_statistics topic of the '
+                 'recorder. They are logged as well when the recording stops. '
+                 'Default: %(default)d, not measured.')
         parser.add_argument(
             '--node-name', type=str, default='rosbag2_recorder',
             help='Specify the recorder node name. Default is %(default)s.')
@@ -143,6 +405,21 @@ class RecordVerb(VerbExtension):
             '--snapshot-mode', action='store_true',
             help='Enable snapshot mode. Messages will not be written to the bagfile until '
                  'the "/rosbag2_recorder/snapshot" service is called.')
+        parser.add_argument(
+            '--snapshot-duration', type=int, default=0,
+            help='Maximum time span in milliseconds of the messages kept for a snapshot in '
+                 'snapshot mode, in addition to the --max-cache-size bound. '
+                 'Default: %(default)d, no time bound.')
+        parser.add_argument(
+            '--snapshot-post-trigger-duration', type=int, default=0,
+            help='Time in milliseconds after a snapshot in snapshot mode during which the '
+                 'recorded messages are written to the bag file of the snapshot as well. '
+                 'Default: %(default)d, only messages from before the snapshot.')
+        parser.add_argument(
+            '--snapshot-contiguous-buffer', action='store_true',
+            help='Copy the payloads of the messages kept in snapshot mode into contiguous '
+                 'blocks allocated up front instead of keeping the messages, so that more small '
+                 'messages fit into --max-cache-size.')
 
         # Storage configuration
         add_writer_storage_plugin_extensions(parser)
@@ -159,13 +436,80 @@ class RecordVerb(VerbExtension):
                  'Default is %(default)d, which will be interpreted as the number of CPU cores.')
         parser.add_argument(
             '--compression-mode', type=str, default='none',
-            choices=['none', 'file', 'message'],
-            help='Choose mode of compression for the storage. Default: %(default)s.')
+            choices=['none', 'file', 'message', 'batch'],
+            help='Choose mode of compression for the storage. '
+                 'The batch mode compresses the messages of each topic written together from '
+                 'the cache in one frame and requires a --max-cache-size greater than 0. '
+                 'Default: %(default)s.')
         parser.add_argument(
             '--compression-format', type=str, default='',
             choices=get_registered_compressors(),
             help='Choose the compression format/algorithm. '
                  'Has no effect if no compression mode is chosen. Default: %(default)s.')
+        parser.add_argument(
+            '--compression-dictionary-training-messages', type=int, default=0,
+            help='Train a compression dictionary for each topic from its first N messages, '
+                 'which makes small messages compress better in the message and batch modes. '
+                 'The dictionaries are stored in the bag. '
+                 'Default is %(default)d, which disables training.')
+        parser.add_argument(
+            '--compression-dictionary', type=str, default='',
+            help='Compress the messages of all topics with this dictionary, e.g. trained '
+                 'with "zstd --train", in the message and batch modes. '
+                 'It is stored in the bag.')
+        parser.add_argument(
+            '--compression-adaptive-level', action='store_true',
+            help='Lower the compression level while the compression queue or the cache fill '
+                 'up, instead of dropping messages, in the message and batch modes. '
+                 'The levels used are listed in the bag metadata.')
+        parser.add_argument(
+            '--compression-min-level', type=int, default=-5,
+            help='Fastest level of --compression-adaptive-level. Default: %(default)d.')
+        parser.add_argument(
+            '--compression-max-level', type=int, default=1,
+            help='Level of --compression-adaptive-level while the compression keeps up. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--compression-policy', default='always', choices=['always', 'never', 'auto'],
+            help='Whether messages are compressed in the message mode. "auto" compresses the '
+                 'first --compression-probe-messages messages of each topic, and stores the '
+                 'following ones without compression if these did not compress below '
+                 '--compression-skip-ratio of their size. Default: %(default)s.')
+        parser.add_argument(
+            '--compression-topic-policies', type=str, metavar='TOPIC=POLICY', nargs='*',
+            help='Compression policy of single topics, overriding --compression-policy.')
+        parser.add_argument(
+            '--compression-probe-messages', type=int, default=8,
+            help='Messages of each topic compressed by the "auto" compression policy before '
+                 'deciding whether to compress it. Default: %(default)d.')
+        parser.add_argument(
+            '--compression-skip-ratio', type=float, default=0.95,
+            help='Compressed to uncompressed size ratio above which the "auto" compression '
+                 'policy stops compressing a topic. Default: %(default)s.')
+        parser.add_argument(
+            '--compression-file-workers', type=int, default=0,
+            help='Worker threads of the compressor compressing each file in the file mode, '
+                 'in addition to its compression thread, if it supports them. '
+                 'Default: %(default)d.')
+        parser.add_argument(
+            '--compression-file-idle-io', action='store_true',
+            help='Lower the I/O priority of the threads compressing files in the file mode to '
+                 'the idle class, so that reading back closed files yields to the recording. '
+                 'Linux only.')
+        parser.add_argument(
+            '--compression-file-max-concurrent', type=int, default=0,
+            help='Files compressed at the same time in the file mode. '
+                 '0 compresses one file per compression thread. Default: %(default)d.')
+        parser.add_argument(
+            '--compression-file-read-bandwidth', type=int, default=0,
+            help='Bytes per second the file mode reads from the files it compresses while the '
+                 'message cache is filled to --compression-file-throttle-cache-fill or more. '
+                 '0 never throttles. Default: %(default)d.')
+        parser.add_argument(
+            '--compression-file-throttle-cache-fill', type=float, default=0.5,
+            help='Fill level of the message cache, from 0 to 1, from which on reads of the '
+                 'file mode are throttled to --compression-file-read-bandwidth. '
+                 'Default: %(default)s.')
 
     def main(self, *, args):  # noqa: D102
         # both all and topics cannot be true
@@ -194,6 +538,154 @@ class RecordVerb(VerbExtension):
         if args.compression_queue_size < 0:
             return print_error('Compression queue size must be at least 0.')
 
+        if args.compression_mode == 'batch' and args.max_cache_size == 0:
+            return print_error('Invalid choice: The batch compression mode requires a '
+                               '--max-cache-size greater than 0.')
+
+        if args.compression_dictionary_training_messages < 0:
+            return print_error('Compression dictionary training messages must be at least 0.')
+
+        if (args.compression_dictionary_training_messages or args.compression_dictionary) and \
+                args.compression_mode not in ('message', 'batch'):
+            return print_error('Invalid choice: Compression dictionaries require the message '
+                               'or batch compression mode.')
+
+        if args.compression_adaptive_level and \
+                args.compression_mode not in ('message', 'batch'):
+            return print_error('Invalid choice: The adaptive compression level requires the '
+                               'message or batch compression mode.')
+
+        compression_topic_policies = {}
+        for topic_policy in args.compression_topic_policies or []:
+            topic, _, policy = topic_policy.partition('=')
+            if policy not in ('always', 'never', 'auto'):
+                return print_error(
+                    f'Invalid --compression-topic-policies "{topic_policy}", expected '
+                    'TOPIC=always, TOPIC=never or TOPIC=auto.')
+            compression_topic_policies[topic] = policy
+
+        if (args.compression_policy != 'always' or compression_topic_policies) and \
+                args.compression_mode != 'message':
+            return print_error('Invalid choice: Compression policies require the message '
+                               'compression mode.')
+
+        if args.compression_probe_messages < 1:
+            return print_error('Compression probe messages must be at least 1.')
+
+        if args.compression_skip_ratio <= 0:
+            return print_error('Compression skip ratio must be greater than 0.')
+
+        if args.compression_file_workers < 0:
+            return print_error('Compression file workers must be at least 0.')
+
+        if args.compression_file_workers and args.compression_mode != 'file':
+            return print_error('Invalid choice: Compression file workers require the file '
+                               'compression mode.')
+
+        if args.compression_file_max_concurrent < 0:
+            return print_error('Compression file max concurrent must be at least 0.')
+
+        if args.compression_file_read_bandwidth < 0:
+            return print_error('Compression file read bandwidth must be at least 0.')
+
+        if not 0 <= args.compression_file_throttle_cache_fill <= 1:
+            return print_error('Compression file throttle cache fill must be between 0 and 1.')
+
+        if (args.compression_file_idle_io or args.compression_file_max_concurrent or
+                args.compression_file_read_bandwidth) and args.compression_mode != 'file':
+            return print_error('Invalid choice: Scheduling file compression requires the file '
+                               'compression mode.')
+
+        if args.use_sim_time and args.use_receive_timestamp:
+            return print_error('Invalid choice: --use-receive-timestamp is not compatible with '
+                               '--use-sim-time.')
+
+        if args.message_buffer_pool_size < 0:
+            return print_error('Message buffer pool size must be at least 0.')
+
+        if args.message_buffer_arena_size < 0:
+            return print_error('Message buffer arena size must be at least 0.')
+
+        if args.message_buffer_numa_node < -1:
+            return print_error('Message buffer NUMA node must be at least -1.')
+
+        if args.executor_threads < 1:
+            return print_error('Executor threads must be at least 1.')
+
+        if args.executor_threads > 1 and args.callback_groups == 'none':
+            return print_error('Invalid choice: More than one executor thread requires '
+                               '--callback-groups topic or qos.')
+
+        if args.topics_per_callback_group < 1:
+            return print_error('Topics per callback group must be at least 1.')
+
+        if args.subscription_creation_threads < 0:
+            return print_error('Subscription creation threads must not be negative.')
+
+        if args.stripe_directories and args.compression_mode != 'none':
+            return print_error('Invalid choice: --stripe-directories is not compatible with '
+                               'compression.')
+
+        if args.max_bag_retention_size < 0 or args.max_bag_retention_duration < 0:
+            return print_error('Bag retention budgets must be at least 0.')
+
+        if (args.max_bag_retention_size or args.max_bag_retention_duration) and \
+                args.compression_mode == 'file':
+            return print_error('Invalid choice: Bag retention budgets are not compatible with '
+                               'the file compression mode.')
+
+        if args.upload_max_bandwidth < 0:
+            return print_error('Upload max bandwidth must be at least 0.')
+
+        if args.stripe_batch_size < 1:
+            return print_error('Stripe batch size must be at least 1.')
+
+        if args.writer_shards < 1:
+            return print_error('Writer shards must be at least 1.')
+
+        if args.writer_shards > 1 and args.compression_mode != 'none':
+            return print_error('Invalid choice: --writer-shards is not compatible with '
+                               'compression.')
+
+        if args.writer_shards > 1 and args.stripe_directories:
+            return print_error('Invalid choice: --writer-shards is not compatible with '
+                               '--stripe-directories.')
+
+        if args.pipeline_statistics_interval < 0:
+            return print_error('Pipeline statistics interval must be at least 0.')
+
+        if args.message_definition_threads < 0:
+            return print_error('Message definition threads must be at least 0.')
+
+        if not 0 <= args.cache_consumer_thread_priority <= 99:
+            return print_error('Cache consumer thread priority must be between 0 and 99.')
+
+        if any(cpu < 0 for cpu in args.cache_consumer_thread_cpus):
+            return print_error('Cache consumer thread CPUs must be at least 0.')
+
+        if args.deduplication_min_payload_size < 0:
+            return print_error('Deduplication min payload size must be at least 0.')
+
+        if args.deduplication_cache_size < 0:
+            return print_error('Deduplication cache size must be at least 0.')
+
+        if args.delta_keyframe_interval < 1:
+            return print_error('Delta keyframe interval must be at least 1.')
+
+        if args.preview_bucket_duration < 0:
+            return print_error('Preview bucket duration must be at least 0.')
+
+        if args.preview_sample_interval < 1:
+            return print_error('Preview sample interval must be at least 1.')
+
+        if args.durability_interval_ms < 0 or args.durability_bytes < 0:
+            return print_error('--durability-interval-ms and --durability-bytes must be at '
+                               'least 0.')
+
+        if args.compression_min_level > args.compression_max_level:
+            return print_error('--compression-min-level must not be greater than '
+                               '--compression-max-level.')
+
         args.compression_mode = args.compression_mode.upper()
 
         qos_profile_overrides = {}  # Specify a valid default
@@ -205,6 +697,25 @@ class RecordVerb(VerbExtension):
             except (InvalidQoSProfileException, ValueError) as e:
                 return print_error(str(e))
 
+        topic_routes = []
+        if args.topic_routes_path:
+            if args.stripe_directories or args.writer_shards > 1:
+                return print_error('Invalid choice: --topic-routes-path is not compatible with '
+                                   '--stripe-directories and --writer-shards.')
+            try:
+                topic_routes = convert_yaml_to_topic_routes(
+                    yaml.safe_load(args.topic_routes_path))
+            except (TypeError, ValueError) as e:
+                return print_error(str(e))
+
+        topic_decimation = {}
+        if args.topic_decimation_path:
+            try:
+                topic_decimation = convert_yaml_to_topic_decimation(
+                    yaml.safe_load(args.topic_decimation_path))
+            except (TypeError, ValueError) as e:
+                return print_error(str(e))
+
         if args.use_sim_time and args.no_discovery:
             return print_error(
                 '--use-sim-time and --no-discovery both set, but are incompatible settings. '
@@ -216,6 +727,37 @@ class RecordVerb(VerbExtension):
             key_value_pairs = [pair.split('=') for pair in args.custom_data]
             custom_data = {pair[0]: pair[1] for pair in key_value_pairs}
 
+        cache_topic_groups = {}
+        for group in args.cache_topic_group or []:
+            name, _, topics = group.partition('=')
+            cache_topic_groups[name] = [topic for topic in topics.split(',') if topic]
+        cache_shard_sizes = {}
+        for shard_size in args.cache_shard_size or []:
+            name, _, size = shard_size.partition('=')
+            try:
+                cache_shard_sizes[name] = int(size)
+            except ValueError:
+                return print_error(
+                    f'Invalid --cache-shard-size "{shard_size}", expected NAME=BYTES.')
+        cache_shard_policies = {}
+        for shard_policy in args.cache_shard_policy or []:
+            name, _, policy = shard_policy.partition('=')
+            if policy not in ('drop_newest', 'drop_oldest', 'block'):
+                return print_error(
+                    f'Invalid --cache-shard-policy "{shard_policy}", expected NAME=POLICY with '
+                    'POLICY one of drop_newest, drop_oldest or block.')
+            cache_shard_policies[name] = policy
+        cache_topic_priorities = {}
+        for topic_priority in args.cache_topic_priority or []:
+            topic, _, priority = topic_priority.partition('=')
+            try:
+                cache_topic_priorities[topic] = int(priority)
+                if cache_topic_priorities[topic] < 0:
+                    raise ValueError(priority)
+            except ValueError:
+                return print_error(
+                    f'Invalid --cache-topic-priority "{topic_priority}", expected TOPIC=PRIORITY.')
+
         storage_config_file = ''
         if args.storage_config_file:
             storage_config_file = args.storage_config_file.name
@@ -229,7 +771,42 @@ class RecordVerb(VerbExtension):
             storage_preset_profile=args.storage_preset_profile,
             storage_config_uri=storage_config_file,
             snapshot_mode=args.snapshot_mode,
-            custom_data=custom_data
+            custom_data=custom_data,
+            lock_free_cache=args.lock_free_cache,
+            shard_cache_per_topic=args.cache_per_topic,
+            cache_topic_groups=cache_topic_groups,
+            cache_shard_sizes=cache_shard_sizes,
+            cache_shard_policies=cache_shard_policies,
+            cache_topic_priorities=cache_topic_priorities,
+            cache_overflow_policy=args.cache_overflow_policy,
+            cache_block_timeout_ms=args.cache_block_timeout,
+            cache_spill_directory=args.cache_spill_dir,
+            cache_spill_size=args.cache_spill_size,
+            cache_min_batch_size=args.cache_min_batch_size,
+            cache_max_batch_size=args.cache_max_batch_size,
+            cache_max_batch_latency_ms=args.cache_max_batch_latency,
+            cache_adaptive_batching=args.cache_adaptive_batching,
+            async_split=args.async_split,
+            max_bag_retention_size=args.max_bag_retention_size,
+            max_bag_retention_duration=args.max_bag_retention_duration,
+            preallocate_bagfiles=args.preallocate_bagfiles,
+            snapshot_duration_ms=args.snapshot_duration,
+            snapshot_post_trigger_duration_ms=args.snapshot_post_trigger_duration,
+            snapshot_contiguous_buffer=args.snapshot_contiguous_buffer,
+            message_definition_cache_directory=args.message_definition_cache_dir,
+            message_definition_threads=args.message_definition_threads,
+            cache_consumer_thread_policy=args.cache_consumer_thread_policy,
+            cache_consumer_thread_priority=args.cache_consumer_thread_priority,
+            cache_consumer_thread_cpus=args.cache_consumer_thread_cpus,
+            deduplication_min_payload_size=args.deduplication_min_payload_size,
+            deduplication_cache_size=args.deduplication_cache_size,
+            delta_encoded_topics=args.delta_encoded_topics,
+            delta_keyframe_interval=args.delta_keyframe_interval,
+            preview_bucket_duration_ms=args.preview_bucket_duration,
+            preview_sample_topics=args.preview_sample_topics,
+            preview_sample_interval=args.preview_sample_interval,
+            durability_interval_ms=args.durability_interval_ms,
+            durability_bytes=args.durability_bytes
         )
         record_options = RecordOptions()
         record_options.all = args.all
@@ -245,12 +822,49 @@ class RecordVerb(VerbExtension):
         record_options.compression_format = args.compression_format
         record_options.compression_queue_size = args.compression_queue_size
         record_options.compression_threads = args.compression_threads
+        record_options.compression_dictionary_training_messages = \
+            args.compression_dictionary_training_messages
+        record_options.compression_dictionary = args.compression_dictionary
+        record_options.compression_adaptive_level = args.compression_adaptive_level
+        record_options.compression_min_level = args.compression_min_level
+        record_options.compression_max_level = args.compression_max_level
+        record_options.compression_policy = args.compression_policy
+        record_options.compression_topic_policies = compression_topic_policies
+        record_options.compression_probe_messages = args.compression_probe_messages
+        record_options.compression_skip_ratio = args.compression_skip_ratio
+        record_options.compression_file_workers = args.compression_file_workers
+        record_options.compression_file_idle_io = args.compression_file_idle_io
+        record_options.compression_file_max_concurrent = args.compression_file_max_concurrent
+        record_options.compression_file_read_bandwidth = args.compression_file_read_bandwidth
+        record_options.compression_file_throttle_cache_fill = \
+            args.compression_file_throttle_cache_fill
         record_options.topic_qos_profile_overrides = qos_profile_overrides
         record_options.include_hidden_topics = args.include_hidden_topics
         record_options.include_unpublished_topics = args.include_unpublished_topics
         record_options.start_paused = args.start_paused
         record_options.ignore_leaf_topics = args.ignore_leaf_topics
+        record_options.record_publish_info = args.record_publish_info
         record_options.use_sim_time = args.use_sim_time
+        record_options.use_receive_timestamp = args.use_receive_timestamp
+        record_options.message_buffer_pool_size = args.message_buffer_pool_size
+        record_options.message_buffer_arena_size = args.message_buffer_arena_size
+        record_options.message_buffer_numa_node = args.message_buffer_numa_node
+        record_options.executor_threads = args.executor_threads
+        record_options.callback_groups = \
+            '' if args.callback_groups == 'none' else args.callback_groups
+        record_options.topics_per_callback_group = args.topics_per_callback_group
+        record_options.subscription_creation_threads = args.subscription_creation_threads
+        record_options.pipeline_statistics_interval = datetime.timedelta(
+            milliseconds=args.pipeline_statistics_interval)
+        record_options.stripe_directories = args.stripe_directories
+        record_options.stripe_by = args.stripe_by
+        record_options.stripe_batch_size = args.stripe_batch_size
+        record_options.writer_shards = args.writer_shards
+        record_options.upload_command = args.upload_command
+        record_options.upload_max_bandwidth = args.upload_max_bandwidth
+        record_options.upload_journal = args.upload_journal
+        record_options.topic_decimation = topic_decimation
+        record_options.topic_routes = topic_routes
 
         recorder = Recorder()
 
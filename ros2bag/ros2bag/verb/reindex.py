@@ -20,6 +20,7 @@
 #
 # This notice must appear in all copies of this file and its derivatives.
 
+from argparse import FileType
 import os
 
 from ros2bag.api import add_standard_reader_args
@@ -33,6 +34,14 @@ class ReindexVerb(VerbExtension):
 
     def add_arguments(self, parser, cli_name):
         add_standard_reader_args(parser)
+        parser.add_argument(
+            '--header-stamps', action='store_true',
+            help='Also index header.stamp of the messages in the bag directory, so that the bag '
+                 'can be read in order of header time stamps.')
+        parser.add_argument(
+            '--storage-config-file', type=FileType('r'),
+            help='Path to a yaml file defining storage specific configurations used to open the '
+                 'bag files. See storage plugin documentation for the format of this file.')
 
     def main(self, *, args):
         if not os.path.isdir(args.bag_path):
@@ -41,7 +50,11 @@ class ReindexVerb(VerbExtension):
         storage_options = StorageOptions(
             uri=args.bag_path,
             storage_id=args.storage,
+            storage_config_uri=args.storage_config_file.name if args.storage_config_file else '',
         )
 
         reindexer = Reindexer()
         reindexer.reindex(storage_options)
+        if args.header_stamps:
+            message_count = reindexer.index_header_stamps(storage_options)
+            print(f'Indexed header stamps of {message_count} messages')
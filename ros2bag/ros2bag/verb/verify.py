@@ -0,0 +1,72 @@
+# Copyright 2024 Open Source Robotics Foundation, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+
+from ros2bag.api import add_standard_reader_args
+from ros2bag.api import print_error
+from ros2bag.verb import VerbExtension
+from rosbag2_py import StorageOptions, Verifier
+
+
+def _format_problem(problem):
+    location = []
+    if problem.end_offset > 0:
+        location.append(f'bytes {problem.start_offset}-{problem.end_offset}')
+    if problem.end_time > 0:
+        location.append(f'time stamps {problem.start_time}-{problem.end_time}')
+    return f'{problem.description} ({", ".join(location)})' if location else problem.description
+
+
+class VerifyVerb(VerbExtension):
+    """Check the integrity of a bag and compare its messages with its metadata."""
+
+    def add_arguments(self, parser, cli_name):
+        add_standard_reader_args(parser)
+        parser.add_argument(
+            '-j', '--threads', type=int, default=0,
+            help='Number of files verified at a time. By default one per CPU core.')
+
+    def main(self, *, args):
+        if not os.path.isdir(args.bag_path):
+            return print_error('Must specify a bag directory')
+        if args.threads < 0:
+            return print_error('--threads must not be negative')
+
+        storage_options = StorageOptions(
+            uri=args.bag_path,
+            storage_id=args.storage,
+        )
+        try:
+            result = Verifier().verify(storage_options, args.threads)
+        except RuntimeError as e:
+            return print_error(str(e))
+
+        for file in result.files:
+            if file.error:
+                print(f'{file.path}: {file.error}')
+                continue
+            verification = file.verification
+            status = 'ok' if not verification.problems else 'DAMAGED'
+            if not verification.checked:
+                status += ', read only, no checksums'
+            print(f'{file.path}: {verification.message_count} messages, {status}')
+            for problem in verification.problems:
+                print(f'  {_format_problem(problem)}')
+        for mismatch in result.metadata_mismatches:
+            print(f'metadata mismatch: {mismatch}')
+
+        if not result.ok():
+            return print_error(f'{args.bag_path} failed verification')
+        print(f'{args.bag_path} verified')
@@ -39,12 +39,14 @@ The package provides the rosbag command for the ROS 2 command line tools.""",
         ],
         'ros2bag.verb': [
             'burst = ros2bag.verb.burst:BurstVerb',
+            'catalog = ros2bag.verb.catalog:CatalogVerb',
             'convert = ros2bag.verb.convert:ConvertVerb',
             'info = ros2bag.verb.info:InfoVerb',
             'list = ros2bag.verb.list:ListVerb',
             'play = ros2bag.verb.play:PlayVerb',
             'record = ros2bag.verb.record:RecordVerb',
-            'reindex = ros2bag.verb.reindex:ReindexVerb'
+            'reindex = ros2bag.verb.reindex:ReindexVerb',
+            'verify = ros2bag.verb.verify:VerifyVerb',
         ],
     }
 )
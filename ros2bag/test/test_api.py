@@ -18,6 +18,8 @@ from rclpy.qos import QoSDurabilityPolicy
 from rclpy.qos import QoSHistoryPolicy
 from rclpy.qos import QoSReliabilityPolicy
 from ros2bag.api import convert_yaml_to_qos_profile
+from ros2bag.api import convert_yaml_to_topic_decimation
+from ros2bag.api import convert_yaml_to_topic_routes
 from ros2bag.api import dict_to_duration
 from ros2bag.api import interpret_dict_as_qos_profile
 
@@ -88,3 +90,43 @@ class TestRos2BagRecord(unittest.TestCase):
         qos_dict = {'history': 'keep_all', 'liveliness_lease_duration': {'sec': -1, 'nsec': -1}}
         with self.assertRaises(ValueError):
             interpret_dict_as_qos_profile(qos_dict)
+
+    def test_convert_yaml_to_topic_decimation(self):
+        topic_decimation = convert_yaml_to_topic_decimation({
+            '/camera': {'keep_every_n': 10},
+            '/imu': {'max_frequency': 50}})
+        assert topic_decimation['/camera'].keep_every_n == 10
+        assert topic_decimation['/camera'].max_frequency == 0.0
+        assert topic_decimation['/imu'].keep_every_n == 1
+        assert topic_decimation['/imu'].max_frequency == 50.0
+
+    def test_convert_yaml_to_topic_decimation_invalid(self):
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_decimation({'/camera': {'keep_every_n': 0}})
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_decimation({'/imu': {'max_frequency': -1.0}})
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_decimation({'/imu': {'rate': 10}})
+
+    def test_convert_yaml_to_topic_routes(self):
+        topic_routes = convert_yaml_to_topic_routes([
+            {'name': 'camera', 'topics_regex': '/camera/.*', 'compression_format': 'zstd',
+             'compression_mode': 'file', 'max_bagfile_size': 4000},
+            {'name': 'lidar', 'topics_regex': '/lidar/.*'}])
+        assert len(topic_routes) == 2
+        assert topic_routes[0].name == 'camera'
+        assert topic_routes[0].compression_mode == 'FILE'
+        assert topic_routes[0].max_bagfile_size == 4000
+        assert topic_routes[0].max_cache_size is None
+        assert topic_routes[1].compression_format == ''
+
+    def test_convert_yaml_to_topic_routes_invalid(self):
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_routes({'camera': '/camera/.*'})
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_routes([{'name': 'camera'}])
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_routes(
+                [{'name': 'camera', 'topics_regex': '.*', 'max_bagfile_size': -1}])
+        with self.assertRaises(ValueError):
+            convert_yaml_to_topic_routes([{'name': 'camera', 'topics_regex': '.*', 'size': 1}])
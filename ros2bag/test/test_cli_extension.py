@@ -27,7 +27,7 @@ from rosbag2_test_common import TESTED_STORAGE_IDS
 
 UNIQUE_PRESET_PROFILES = {
     'mcap': ['zstd_small'],
-    'sqlite3': ['resilient'],
+    'sqlite3': ['resilient', 'high_throughput', 'fast_read'],
 }
 
 
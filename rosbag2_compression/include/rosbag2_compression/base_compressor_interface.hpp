@@ -15,7 +15,11 @@
 #ifndef ROSBAG2_COMPRESSION__BASE_COMPRESSOR_INTERFACE_HPP_
 #define ROSBAG2_COMPRESSION__BASE_COMPRESSOR_INTERFACE_HPP_
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
@@ -66,12 +70,105 @@ public:
     const rosbag2_storage::SerializedBagMessage * bag_message,
     rosbag2_storage::SerializedBagMessage * compressed_message) = 0;
 
+  /**
+   * Compress the serialized_data of several serialized bag messages at once.
+   * Compressors offloading to hardware accelerators override this to submit all messages before
+   * waiting for them to complete, instead of one round trip per message.
+   * The default compresses them one after the other.
+   *
+   * \param[in] bag_messages Serialized bag messages.
+   * \param[out] compressed_messages Compressed messages, one for each of bag_messages.
+   */
+  virtual void compress_serialized_bag_messages(
+    const std::vector<const rosbag2_storage::SerializedBagMessage *> & bag_messages,
+    const std::vector<rosbag2_storage::SerializedBagMessage *> & compressed_messages)
+  {
+    for (size_t i = 0; i < bag_messages.size(); i++) {
+      compress_serialized_bag_message(bag_messages[i], compressed_messages[i]);
+    }
+  }
+
+  /**
+   * Get the number of messages compress_serialized_bag_messages() is handed at most.
+   * Writers hand over several messages only if they are queued already, so a compressor asking
+   * for more than one doesn't delay messages. The default of 1 compresses message by message.
+   */
+  virtual size_t get_max_batch_messages() const
+  {
+    return 1;
+  }
+
   /**
    * Get the identifier of the compression algorithm.
    * This is appended to the extension of the compressed file.
    */
   virtual std::string get_compression_identifier() const = 0;
 
+  /**
+   * Configure the dictionaries used to compress serialized bag messages.
+   * Compressors which don't support dictionaries ignore this.
+   *
+   * \param training_messages Number of messages of a topic to train its dictionary from.
+   * 0 disables training.
+   * \param dictionary_path Dictionary file to compress the messages of all topics with.
+   * Takes precedence over training if not empty.
+   */
+  virtual void configure_dictionaries(
+    uint64_t /*training_messages*/, const std::string & /*dictionary_path*/)
+  {
+  }
+
+  /**
+   * Get the dictionaries messages were compressed with so far.
+   * They are stored with the bag and handed to the decompressor with add_dictionary().
+   */
+  virtual std::vector<std::vector<uint8_t>> get_dictionaries() const
+  {
+    return {};
+  }
+
+  /**
+   * Set the level serialized bag messages are compressed with from now on, e.g. by the
+   * adaptive compression level of the SequentialCompressionWriter.
+   * Compressors which don't support levels ignore this.
+   *
+   * \param level Compression level in the range of the compression format, lower is faster.
+   */
+  virtual void set_compression_level(int32_t /*level*/)
+  {
+  }
+
+  /**
+   * Set the number of worker threads compress_uri() compresses a file with, in addition to the
+   * thread calling it. Compressors which don't support this ignore it.
+   *
+   * \param workers Number of worker threads, 0 compresses in the calling thread.
+   */
+  virtual void set_file_compression_workers(uint64_t /*workers*/)
+  {
+  }
+
+  /**
+   * Set a callback which compress_uri() calls with the number of bytes it is about to read from
+   * the file, before reading them. The writer blocks in it to throttle the reads of background
+   * file compression while recording. Compressors which don't read files in chunks ignore this.
+   *
+   * \param throttle Callback blocking as long as the bytes may not be read yet, may be empty.
+   */
+  virtual void set_file_read_throttle(std::function<void(size_t)> /*throttle*/)
+  {
+  }
+
+  /**
+   * Whether the compressor encrypts what it compresses.
+   * Writers refuse to store messages without compression and to train dictionaries, which are
+   * stored with the bag, if it does, so that no message data ends up in the bag in plain text.
+   */
+  virtual bool encrypts() const
+  {
+    return false;
+  }
+
   /**
    * Get the compressor package name
    */
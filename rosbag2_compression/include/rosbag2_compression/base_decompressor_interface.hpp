@@ -15,9 +15,13 @@
 #ifndef ROSBAG2_COMPRESSION__BASE_DECOMPRESSOR_INTERFACE_HPP_
 #define ROSBAG2_COMPRESSION__BASE_DECOMPRESSOR_INTERFACE_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "rosbag2_storage/readable_file.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 #include "visibility_control.hpp"
@@ -58,6 +62,22 @@ public:
    */
   virtual std::string decompress_uri(const std::string & uri) = 0;
 
+  /**
+   * Open a compressed file on disk to be decompressed while it is read, instead of
+   * decompressing it to disk first.
+   * Decompressors which don't support this, or files which were compressed in a format that
+   * doesn't allow it, return nullptr and are decompressed with decompress_uri() instead.
+   *
+   * \param uri Input file to decompress with file extension.
+   * 
+eturn The decompressed content of the file or nullptr.
+   */
+  virtual std::shared_ptr<rosbag2_storage::ReadableFile> open_decompressed_uri(
+    const std::string & /*uri*/)
+  {
+    return nullptr;
+  }
+
   /**
    * Decompress the serialized_data of a serialized bag message in place.
    *
@@ -66,12 +86,45 @@ public:
   virtual void decompress_serialized_bag_message(
     rosbag2_storage::SerializedBagMessage * bag_message) = 0;
 
+  /**
+   * Decompress the serialized_data of several serialized bag messages in place at once.
+   * Decompressors offloading to hardware accelerators override this to submit all messages
+   * before waiting for them to complete. The default decompresses them one after the other.
+   *
+   * \param[in,out] bag_messages Serialized bag messages.
+   */
+  virtual void decompress_serialized_bag_messages(
+    const std::vector<rosbag2_storage::SerializedBagMessage *> & bag_messages)
+  {
+    for (auto bag_message : bag_messages) {
+      decompress_serialized_bag_message(bag_message);
+    }
+  }
+
+  /**
+   * Get the number of messages decompress_serialized_bag_messages() is handed at most.
+   * The default of 1 decompresses message by message.
+   */
+  virtual size_t get_max_batch_messages() const
+  {
+    return 1;
+  }
+
   /**
    * Get the identifier of the compression algorithm. This is appended to the extension of the
    * compressed file.
    */
   virtual std::string get_decompression_identifier() const = 0;
 
+  /**
+   * Add a dictionary serialized bag messages may have been compressed with.
+   * Decompressors which don't support dictionaries ignore this.
+   *
+   * \param dictionary A dictionary returned by BaseCompressorInterface::get_dictionaries().
+   */
+  virtual void add_dictionary(const std::vector<uint8_t> & /*dictionary*/)
+  {
+  }
 
   static std::string get_package_name()
   {
@@ -49,6 +49,8 @@ public:
 
   /**
    * Create a compressor based on the specified compression format.
+   * Formats of several plugins joined by '+', e.g. "zstd+aes_gcm", create a compressor which
+   * compresses with each plugin in turn.
    *
    * \param compression_format The compression format as a string.
    * \return A shared pointer to the newly created compressor.
@@ -59,6 +61,7 @@ public:
 
   /**
    * Create a decompressor based on the specified compression format.
+   * Stacked formats decompress with each plugin in reverse order.
    *
    * \param compression_format The compression format as a string.
    * \return A shared pointer to the newly created decompressor.
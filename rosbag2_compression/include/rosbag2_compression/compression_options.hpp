@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <string>
 #include <optional>
+#include <unordered_map>
 
 #include "visibility_control.hpp"
 
@@ -25,7 +26,10 @@ namespace rosbag2_compression
 {
 
 /**
- * Modes are used to specify whether to compress by individual serialized bag messages or by file.
+ * Modes are used to specify whether to compress by individual serialized bag messages, by
+ * batches of messages or by file.
+ * BATCH compresses the messages of each topic in a batch written by the message cache into one
+ * frame, see message_batch.hpp. It requires a message cache.
  * rosbag2_cpp defaults to NONE.
  */
 enum class ROSBAG2_COMPRESSION_PUBLIC CompressionMode: uint32_t
@@ -33,14 +37,15 @@ enum class ROSBAG2_COMPRESSION_PUBLIC CompressionMode: uint32_t
   NONE = 0,
   FILE,
   MESSAGE,
-  LAST_MODE = MESSAGE
+  BATCH,
+  LAST_MODE = BATCH
 };
 
 /**
  * Converts a string into a rosbag2_compression::CompressionMode enum.
  *
- * \param compression_mode A case insensitive string that is either "FILE" or "MESSAGE".
- * \return CompressionMode NONE if compression_mode is invalid. FILE or MESSAGE otherwise.
+ * \param compression_mode A case insensitive string that is either "FILE", "MESSAGE" or "BATCH".
+ * \return CompressionMode NONE if compression_mode is invalid. FILE, MESSAGE or BATCH otherwise.
  */
 ROSBAG2_COMPRESSION_PUBLIC CompressionMode compression_mode_from_string(
   const std::string & compression_mode);
@@ -53,6 +58,38 @@ ROSBAG2_COMPRESSION_PUBLIC CompressionMode compression_mode_from_string(
  */
 ROSBAG2_COMPRESSION_PUBLIC std::string compression_mode_to_string(CompressionMode compression_mode);
 
+/**
+ * Policies decide per topic whether its messages are compressed in MESSAGE mode.
+ * AUTO compresses the first messages of a topic as probes and stops compressing the topic if
+ * they hardly got smaller, e.g. images, video packets or point clouds which are compressed
+ * already. Messages which are not compressed are stored with a marker, so that readers know
+ * not to decompress them.
+ */
+enum class ROSBAG2_COMPRESSION_PUBLIC CompressionPolicy: uint32_t
+{
+  ALWAYS = 0,
+  NEVER,
+  AUTO
+};
+
+/**
+ * Converts a string into a rosbag2_compression::CompressionPolicy enum.
+ *
+ * \param compression_policy A case insensitive string that is either "ALWAYS", "NEVER" or "AUTO".
+ * \return CompressionPolicy ALWAYS if compression_policy is invalid. NEVER or AUTO otherwise.
+ */
+ROSBAG2_COMPRESSION_PUBLIC CompressionPolicy compression_policy_from_string(
+  const std::string & compression_policy);
+
+/**
+ * Converts a rosbag2_compression::CompressionPolicy enum into a string.
+ *
+ * \param compression_policy A CompressionPolicy enum.
+ * \return The corresponding policy as a string.
+ */
+ROSBAG2_COMPRESSION_PUBLIC std::string compression_policy_to_string(
+  CompressionPolicy compression_policy);
+
 /**
  * Compression options used in the writer which are passed down from the CLI in rosbag2_transport.
  */
@@ -67,6 +104,46 @@ struct CompressionOptions
   /// For Windows the valid values are: THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL and
   /// THREAD_PRIORITY_NORMAL. For POSIX compatible OSes this is the "nice" value.
   std::optional<int32_t> thread_priority;
+  /// \brief Number of messages of each topic a compression dictionary is trained from in
+  /// MESSAGE and BATCH mode, if the compressor supports dictionaries. 0 disables training.
+  uint64_t dictionary_training_messages = 0;
+  /// \brief Path of a dictionary to compress the messages of all topics with in MESSAGE and
+  /// BATCH mode, instead of training one per topic.
+  std::string dictionary_path = "";
+  /// \brief Lowers the compression level in MESSAGE and BATCH mode while the compression queue
+  /// or the message cache fill up, down to min_compression_level, instead of dropping messages.
+  /// Raises it back up to max_compression_level once they drained. The levels used are listed in
+  /// the custom data of the bag metadata.
+  bool adaptive_compression_level = false;
+  /// \brief Fastest compression level of the adaptive compression level.
+  int32_t min_compression_level = -5;
+  /// \brief Compression level of the adaptive compression level while there is no pressure.
+  int32_t max_compression_level = 1;
+  /// \brief Policy of the topics not listed in topic_compression_policies in MESSAGE mode.
+  CompressionPolicy compression_policy = CompressionPolicy::ALWAYS;
+  /// \brief Policies of individual topics in MESSAGE mode, by topic name.
+  std::unordered_map<std::string, CompressionPolicy> topic_compression_policies{};
+  /// \brief Number of messages of each topic the AUTO policy compresses as probes.
+  uint64_t compression_probe_messages = 8;
+  /// \brief The AUTO policy stops compressing a topic once its probes were compressed to more
+  /// than this fraction of their size.
+  double compression_skip_ratio = 0.95;
+  /// \brief Worker threads each file is compressed with in FILE mode, in addition to its
+  /// compression thread, by compressors which support it. 0 compresses in the compression thread.
+  uint64_t file_compression_workers = 0;
+  /// \brief Lowers the I/O priority of the compression threads to the idle class in FILE mode,
+  /// so that reading back closed files yields to the writes of the recording. Linux only.
+  bool file_compression_idle_io = false;
+  /// \brief Number of files compressed at the same time in FILE mode. 0 allows one per
+  /// compression thread.
+  uint64_t max_concurrent_file_compressions = 0;
+  /// \brief Bytes per second all compression threads together read from the files they compress
+  /// in FILE mode while the message cache is filled to file_compression_throttle_cache_fill or
+  /// more. 0 never throttles.
+  uint64_t file_compression_read_bandwidth = 0;
+  /// \brief Fill level of the message cache, from 0 to 1, from which on the reads of file
+  /// compression are throttled to file_compression_read_bandwidth.
+  double file_compression_throttle_cache_fill = 0.5;
 };
 
 }  // namespace rosbag2_compression
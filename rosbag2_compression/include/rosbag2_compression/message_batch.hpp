@@ -0,0 +1,67 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__MESSAGE_BATCH_HPP_
+#define ROSBAG2_COMPRESSION__MESSAGE_BATCH_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "visibility_control.hpp"
+
+namespace rosbag2_compression
+{
+
+/**
+ * Maximum time between the earliest and the latest message of a batch, in nanoseconds.
+ *
+ * Batches are stored with the time stamp of their earliest message. A reader finds every batch
+ * holding messages at or after a time stamp by seeking this much earlier.
+ */
+constexpr rcutils_duration_value_t MAX_MESSAGE_BATCH_DURATION = 1000000000;
+
+/**
+ * Packs messages into batches of the BATCH compression mode, which are written to storage
+ * like messages after they were compressed.
+ *
+ * Each batch holds messages of one topic, in the order they were passed in, and spans at most
+ * MAX_MESSAGE_BATCH_DURATION. It has the topic and the time stamp of its earliest message.
+ *
+ * \param messages Messages to pack, e.g. a batch handed over by the cache consumer.
+ * \return The uncompressed batches.
+ */
+ROSBAG2_COMPRESSION_PUBLIC
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> pack_message_batches(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
+/**
+ * Unpacks the messages of an uncompressed batch.
+ *
+ * The payloads of the messages refer to the serialized data of the batch without copies.
+ *
+ * \param batch A batch created by pack_message_batches().
+ * \return The messages, in the order they were packed.
+ * \throws std::runtime_error if the batch is malformed.
+ */
+ROSBAG2_COMPRESSION_PUBLIC
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> unpack_message_batch(
+  const rosbag2_storage::SerializedBagMessage & batch);
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__MESSAGE_BATCH_HPP_
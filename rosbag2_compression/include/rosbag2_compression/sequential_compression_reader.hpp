@@ -15,10 +15,21 @@
 #ifndef ROSBAG2_COMPRESSION__SEQUENTIAL_COMPRESSION_READER_HPP_
 #define ROSBAG2_COMPRESSION__SEQUENTIAL_COMPRESSION_READER_HPP_
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "rcutils/time.h"
+
 #include "rosbag2_compression/base_decompressor_interface.hpp"
 #include "rosbag2_compression/compression_options.hpp"
 
@@ -28,6 +39,7 @@
 #include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
 
 #include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/readable_file.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
 #include "rosbag2_storage/storage_factory_interface.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
@@ -65,14 +77,72 @@ public:
     const rosbag2_storage::StorageOptions & storage_options,
     const rosbag2_cpp::ConverterOptions & converter_options) override;
 
+  /**
+   * In BATCH mode, the messages are unpacked from their batches and merged in time stamp order.
+   */
+  bool has_next() override;
+
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
 
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0) override;
+
+  void for_each(const rosbag2_storage::MessageViewCallback & callback) override;
+
+  /**
+   * Bags compressed in BATCH mode can only be read in ascending order of received time stamps.
+   *
+   * \return false if the read order is not supported.
+   */
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  /**
+   * In BATCH mode, messages which were already unpacked are discarded. Changes of the topic
+   * filter with set_filter() only take effect for messages which were not unpacked yet.
+   */
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /**
+   * Messages which were read ahead for decompression threads in MESSAGE mode are discarded.
+   */
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void close() override;
+
 protected:
   /**
    * Decompress the current bagfile so that it can be opened by the storage implementation.
    */
   void preprocess_current_file() override;
 
+  /**
+   * Decompressed files which are read while they are decompressed are opened again through the
+   * decompressor every time.
+   */
+  std::shared_ptr<rosbag2_storage::ReadableFile> open_current_readable_file() override;
+
+  /**
+   * Files compressed by file are decompressed before they are opened, so they are not opened
+   * ahead of time. See storage_options.decompression_look_ahead_files instead.
+   */
+  bool can_open_next_file_ahead() const override;
+
+  /**
+   * Falls back to decompressing the current file to disk if the storage implementation fails to
+   * read it while it is decompressed.
+   *
+   * In FILE mode, decompression of the next storage_options.decompression_look_ahead_files
+   * files is started in the background afterwards, and decompressed files before the current
+   * one are removed once more than storage_options.decompression_disk_budget bytes are used.
+   */
+  void load_current_file() override;
+
+  /**
+   * In BATCH mode, batches are stored with the time stamp of their earliest message, so the
+   * start of the time window is moved MAX_MESSAGE_BATCH_DURATION earlier for the storage.
+   */
+  rosbag2_storage::StorageFilter get_storage_filter() const override;
+
 private:
   /**
    * Initializes the decompressor if a compression mode is specified in the metadata.
@@ -84,12 +154,120 @@ private:
    */
   void setup_decompression();
 
+  /**
+   * Reads and unpacks batches until the earliest unpacked message can not be preceded by a
+   * message of a batch which was not read yet.
+   */
+  void unpack_batches();
+
+  /**
+   * Decompresses a file to disk, or takes the file decompressed by the look-ahead if there is
+   * one, waiting for it to finish if necessary.
+   *
+   * \return the path to the decompressed file.
+   */
+  std::string decompress_file(const std::string & compressed_file);
+
+  /**
+   * Starts decompressing the files after the current one in the background, if look-ahead is
+   * enabled and it is not busy.
+   */
+  void start_look_ahead();
+
+  /// Waits for the look-ahead to finish.
+  void wait_for_look_ahead();
+
+  /// Removes decompressed files before the current one until the disk budget is met.
+  void remove_files_behind_current_file();
+
+  /// \return the size of all decompressed files on disk.
+  uint64_t get_decompressed_files_size();
+
+  /**
+   * Starts storage_options.decompression_threads threads in MESSAGE mode, each with a
+   * decompressor of its own.
+   *
+   * \param dictionaries Dictionaries of the bag which are added to the decompressors.
+   */
+  void setup_decompression_threads(const std::vector<std::vector<uint8_t>> & dictionaries);
+
+  /// Signals the decompression threads to stop and waits for them to exit.
+  void stop_decompression_threads();
+
+  /// Decompresses queued messages until the threads are stopped.
+  void decompression_thread_fn(BaseDecompressorInterface & decompressor);
+
+  /// Decompresses a message read in MESSAGE mode, unless it was stored without compression.
+  void decompress_message(
+    BaseDecompressorInterface & decompressor, rosbag2_storage::SerializedBagMessage & message);
+
+  /// Reads messages from storage and queues them until enough are being decompressed.
+  void prefetch_messages();
+
+  /// Discards messages which were read ahead for the decompression threads.
+  void clear_prefetched_messages();
+
   rosbag2_compression::CompressionMode compression_mode_{
     rosbag2_compression::CompressionMode::NONE};
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory_{};
   std::shared_ptr<rosbag2_compression::BaseDecompressorInterface> decompressor_{};
+  // Whether the writer may have stored messages without compression in MESSAGE mode
+  bool has_stored_messages_{false};
+
+  // Messages unpacked from batches in BATCH mode, in time stamp order and read order of their
+  // batches for equal time stamps
+  std::multimap<rcutils_time_point_value_t, std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+  unpacked_messages_;
+  // Time stamp of the last batch read from storage
+  rcutils_time_point_value_t last_batch_time_stamp_ = 0;
+  // Unpacked messages before the time stamp passed to seek() are skipped
+  rcutils_time_point_value_t batch_seek_time_ = 0;
+
+  // Compressed file of each decompressed file which is read while it is decompressed, in FILE
+  // mode
+  std::unordered_map<std::string, std::string> streamed_files_;
+  // Compressed file of each file which was decompressed to disk
+  std::unordered_map<std::string, std::string> decompressed_files_;
+
+  // The look-ahead decompresses with a decompressor of its own on a background thread
+  std::shared_ptr<rosbag2_compression::BaseDecompressorInterface> look_ahead_decompressor_{};
+  std::mutex look_ahead_mutex_;
+  std::condition_variable look_ahead_condition_;
+  // Compressed files the running look-ahead was started for
+  std::unordered_set<std::string> look_ahead_queue_;
+  // Decompressed file of each compressed file the look-ahead is done with, which is empty if
+  // decompressing it failed. Guarded by look_ahead_mutex_.
+  std::unordered_map<std::string, std::string> look_ahead_files_;
+
+  // A message read from storage which is decompressed by a decompression thread
+  struct PrefetchedMessage
+  {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    std::exception_ptr error;
+    bool decompressed = false;
+  };
+  // Decompresses messages taken from the queue with one call of the decompressor. If it fails,
+  // the error is reported for all of them.
+  void decompress_prefetched_messages(
+    BaseDecompressorInterface & decompressor,
+    const std::vector<std::shared_ptr<PrefetchedMessage>> & messages);
+
+  // Messages read ahead, in read order. Only used by the reading thread.
+  std::deque<std::shared_ptr<PrefetchedMessage>> prefetched_messages_;
+  std::vector<std::thread> decompression_threads_;
+  std::mutex decompression_mutex_;
+  // Signals new queued messages or stopping to the decompression threads
+  std::condition_variable decompression_queue_condition_;
+  // Signals decompressed messages to the reading thread
+  std::condition_variable decompressed_condition_;
+  // Messages waiting for a decompression thread. Guarded by decompression_mutex_.
+  std::deque<std::shared_ptr<PrefetchedMessage>> decompression_queue_;
+  bool stop_decompression_threads_ = false;
 
   rosbag2_storage::StorageOptions storage_options_;
+
+  // Last, so it is waited for before the members it uses are destroyed
+  std::future<void> look_ahead_;
 };
 
 }  // namespace rosbag2_compression
@@ -17,12 +17,16 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "rcpputils/thread_safety_annotations.hpp"
@@ -54,6 +58,10 @@
 namespace rosbag2_compression
 {
 
+class CompressionLevelController;
+class CompressionPolicies;
+class FileCompressionScheduler;
+
 class ROSBAG2_COMPRESSION_PUBLIC SequentialCompressionWriter
   : public rosbag2_cpp::writers::SequentialWriter
 {
@@ -105,7 +113,9 @@ public:
   /**
    * If the compression mode is FILE, write a message to a bagfile.
    * If the compression mode is MESSAGE, pushes the message into a queue that will be processed
-   * by the compression threads.
+   * by the compression threads. Compressed messages are written in the order they were pushed.
+   * If the compression mode is BATCH, pushes the message into the message cache. The cache
+   * consumer compresses the messages it writes in batches, see write_batch_to_storage().
    *
    * The topic needs to have been created before writing is possible.
    *
@@ -114,6 +124,13 @@ public:
    */
   void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
 
+  /**
+   * Copy the messages of a bag file as stored, only if the compression mode is FILE.
+   * Messages of the other modes are compressed one by one or in batches and can not be copied.
+   */
+  bool copy_bag_file(
+    const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter) override;
+
   /**
    * Opens a new bagfile and prepare it for writing messages. The bagfile must not exist.
    * This must be called before any other function is used.
@@ -160,6 +177,20 @@ protected:
     BaseCompressorInterface & compressor,
     std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
 
+  /**
+   * Compresses a group of serialized bag messages with one call of the compressor, for
+   * compressors which handle several messages at once. A single message is compressed with
+   * compress_message().
+   *
+   * \param compressor An initialized compression context.
+   * \param messages The messages to compress.
+   * \returns The compressed messages, in the order of messages.
+   */
+  virtual std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+  compress_message_group(
+    BaseCompressorInterface & compressor,
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
   /**
    * Initializes the compressor if a compression mode is specified.
    *
@@ -180,13 +211,55 @@ protected:
    */
   virtual void stop_compressor_threads();
 
+  /**
+   * In BATCH mode, packs the messages of every topic into batches, which are compressed and
+   * written to storage instead of the messages. Otherwise writes the messages as they are.
+   */
+  void write_batch_to_storage(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+  override;
+
 private:
+  using QueuedMessage =
+    std::pair<uint64_t, std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>;
+
+  // Messages waiting for compression, every compression thread owns one shard. Threads without
+  // work of their own steal from the other shards, so that only the producer and a thread
+  // running out of work contend for a shard.
+  struct MessageShard
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    // Ordered by sequence number
+    std::deque<QueuedMessage> messages RCPPUTILS_TSA_GUARDED_BY(mutex);
+  };
+
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory_{};
+  // Compresses batches in BATCH mode, only used by the cache consumer thread
   std::shared_ptr<rosbag2_compression::BaseCompressorInterface> compressor_{};
   std::mutex compressor_queue_mutex_;
-  std::queue<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>
-  compressor_message_queue_ RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_);
+  // Dictionaries of the compressors which finished, written with the bag on close
+  std::mutex dictionaries_mutex_;
+  std::vector<std::vector<uint8_t>> dictionaries_ RCPPUTILS_TSA_GUARDED_BY(dictionaries_mutex_);
   std::queue<std::string> compressor_file_queue_ RCPPUTILS_TSA_GUARDED_BY(compressor_queue_mutex_);
+
+  // Serializes write() in MESSAGE mode, which numbers the messages in arrival order
+  std::mutex message_queue_mutex_;
+  std::condition_variable message_queue_space_condition_;
+  uint64_t next_message_sequence_ RCPPUTILS_TSA_GUARDED_BY(message_queue_mutex_) = 0;
+  std::vector<std::unique_ptr<MessageShard>> message_shards_;
+  std::atomic<uint64_t> queued_messages_{0};
+  std::atomic_bool message_compression_is_running_{false};
+  std::atomic_bool producer_waits_for_space_{false};
+
+  // Compressed messages which are written once all messages before them were written
+  std::mutex reassembly_mutex_;
+  std::map<uint64_t, std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>
+  reassembled_messages_ RCPPUTILS_TSA_GUARDED_BY(reassembly_mutex_);
+  uint64_t next_sequence_to_write_ RCPPUTILS_TSA_GUARDED_BY(reassembly_mutex_) = 0;
+  // Set while a thread writes reassembled messages, the other threads hand theirs over to it
+  bool writing_reassembled_messages_ RCPPUTILS_TSA_GUARDED_BY(reassembly_mutex_) = false;
+
   std::vector<std::thread> compression_threads_;
   /* *INDENT-OFF* */  // uncrustify doesn't understand the macro + brace initializer
   std::atomic_bool compression_is_running_
@@ -199,9 +272,61 @@ private:
 
   bool should_compress_last_file_{true};
 
+  // Only set with the adaptive compression level. Updated by the producer in MESSAGE mode while
+  // holding message_queue_mutex_, and by the cache consumer in BATCH mode.
+  std::unique_ptr<CompressionLevelController> compression_level_controller_;
+  // Level the compression threads apply to their compressors before the next message
+  std::atomic<int32_t> compression_level_{0};
+
+  // Decides per topic whether messages are compressed in MESSAGE mode
+  std::unique_ptr<CompressionPolicies> compression_policies_;
+
+  // Limits and throttles the compression of closed files in FILE mode
+  std::unique_ptr<FileCompressionScheduler> file_compression_scheduler_;
+
+  // Updates the adaptive compression level from the fill level of the compression queue,
+  // every compression_queue_size messages
+  void update_message_compression_level(uint64_t sequence)
+  RCPPUTILS_TSA_REQUIRES(message_queue_mutex_);
+
+  // Updates the adaptive compression level of compressor_ from the size of a cache batch
+  void update_batch_compression_level(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
+  // Creates a compressor of the configured format, with dictionaries in MESSAGE and BATCH mode
+  // and the read throttle of the file compression scheduler in FILE mode
+  std::shared_ptr<BaseCompressorInterface> create_compressor();
+
+  // Keeps the dictionaries of a compressor which finished compressing
+  void collect_dictionaries(const BaseCompressorInterface & compressor);
+
   // Runs a while loop that pulls data from the compression queue until
   // compression_is_running_ is false; should be run in a separate thread
-  void compression_thread_fn();
+  void compression_thread_fn(size_t thread_index);
+
+  // Compresses queued messages, preferably from the shard of the thread, until
+  // compression_is_running_ is false and the shard is empty
+  void compress_messages(BaseCompressorInterface & compressor, size_t thread_index);
+
+  // Compresses messages taken from the queue in MESSAGE mode, or stores them with a marker if
+  // the compression policy of their topic says so, and writes them in order
+  void compress_or_store_messages(
+    BaseCompressorInterface & compressor, std::vector<QueuedMessage> & messages);
+
+  // Takes the oldest message of another shard than the one at thread_index
+  bool steal_message(size_t thread_index, QueuedMessage & message);
+
+  // Reports that a queued message was taken from its shard
+  void release_queue_space();
+
+  // Drops the oldest queued message and adds its sequence number to dropped,
+  // returns false if no message was queued
+  bool drop_oldest_message(std::vector<uint64_t> & dropped);
+
+  // Hands a compressed message over to be written in sequence order. A nullptr marks a
+  // dropped message.
+  void write_in_order(
+    uint64_t sequence, std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
 
   // Closes the current backed storage and opens the next bagfile.
   void split_bagfile() override;
@@ -0,0 +1,83 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compression_dictionaries.hpp"
+
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+namespace rosbag2_compression
+{
+
+void write_dictionaries(
+  const std::string & base_folder,
+  const std::vector<std::vector<uint8_t>> & dictionaries,
+  rosbag2_storage::BagMetadata & metadata)
+{
+  if (dictionaries.empty()) {
+    return;
+  }
+  std::string file_names;
+  for (size_t i = 0; i < dictionaries.size(); i++) {
+    const auto file_name = "compression_dictionary_" + std::to_string(i) + ".dict";
+    const auto path = rcpputils::fs::path(base_folder) / file_name;
+    std::ofstream output(path.string(), std::ios::out | std::ios::binary);
+    if (!output.is_open()) {
+      std::stringstream errmsg;
+      errmsg << "Failed to open file: \"" << path.string() <<
+        "\" for binary writing! errno(" << errno << ")";
+      throw std::runtime_error{errmsg.str()};
+    }
+    output.write(
+      reinterpret_cast<const char *>(dictionaries[i].data()),
+      static_cast<std::streamsize>(dictionaries[i].size()));
+    file_names += (i > 0 ? "," : "") + file_name;
+  }
+  metadata.custom_data[kDictionariesCustomDataKey] = file_names;
+}
+
+std::vector<std::vector<uint8_t>> read_dictionaries(
+  const std::string & base_folder,
+  const rosbag2_storage::BagMetadata & metadata)
+{
+  std::vector<std::vector<uint8_t>> dictionaries;
+  const auto file_names = metadata.custom_data.find(kDictionariesCustomDataKey);
+  if (file_names == metadata.custom_data.end()) {
+    return dictionaries;
+  }
+  std::istringstream names(file_names->second);
+  std::string file_name;
+  while (std::getline(names, file_name, ',')) {
+    const auto path = rcpputils::fs::path(base_folder) / file_name;
+    std::ifstream input(path.string(), std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+      std::stringstream errmsg;
+      errmsg << "Failed to open compression dictionary: \"" << path.string() <<
+        "\" for binary reading! errno(" << errno << ")";
+      throw std::runtime_error{errmsg.str()};
+    }
+    dictionaries.emplace_back(
+      std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+  }
+  return dictionaries;
+}
+
+}  // namespace rosbag2_compression
@@ -0,0 +1,58 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARIES_HPP_
+#define ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARIES_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+
+namespace rosbag2_compression
+{
+
+// Key of the custom data of the bag metadata which lists the dictionary files of a bag,
+// relative to the bag directory and separated by commas
+constexpr const char kDictionariesCustomDataKey[] = "rosbag2_compression.dictionaries";
+
+/**
+ * Writes compression dictionaries to files in the bag directory and lists them in the metadata.
+ *
+ * \param base_folder The bag directory.
+ * \param dictionaries Dictionaries returned by the compressors of the bag.
+ * \param metadata Metadata of the bag, which is written afterwards.
+ * \throws std::runtime_error if a dictionary file can't be written.
+ */
+void write_dictionaries(
+  const std::string & base_folder,
+  const std::vector<std::vector<uint8_t>> & dictionaries,
+  rosbag2_storage::BagMetadata & metadata);
+
+/**
+ * Reads the compression dictionaries listed in the metadata of a bag.
+ *
+ * \param base_folder The bag directory.
+ * \param metadata Metadata of the bag.
+ * \return The dictionaries, empty if the bag has none.
+ * \throws std::runtime_error if a dictionary file can't be read.
+ */
+std::vector<std::vector<uint8_t>> read_dictionaries(
+  const std::string & base_folder,
+  const rosbag2_storage::BagMetadata & metadata);
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__COMPRESSION_DICTIONARIES_HPP_
@@ -17,14 +17,18 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "pluginlib/class_loader.hpp"
 
 #include "logging.hpp"
 #include "rosbag2_compression/compression_factory.hpp"
+#include "rosbag2_storage/class_loader_cache.hpp"
+#include "stacked_compression.hpp"
 
 namespace rosbag2_compression
 {
@@ -32,13 +36,14 @@ namespace rosbag2_compression
 using rosbag2_compression::BaseCompressorInterface;
 using rosbag2_compression::BaseDecompressorInterface;
 
+// Shared by all compression factories of the process, every access goes through
+// rosbag2_storage::get_class_loader_mutex()
 template<typename InterfaceT>
 std::shared_ptr<pluginlib::ClassLoader<InterfaceT>>
 get_class_loader()
 {
-  const auto lookup_name = InterfaceT::get_base_class_name();
-  return std::make_shared<pluginlib::ClassLoader<InterfaceT>>(
-    "rosbag2_compression", lookup_name);
+  return rosbag2_storage::get_cached_class_loader<InterfaceT>(
+    "rosbag2_compression", InterfaceT::get_base_class_name());
 }
 
 template<typename InterfaceT>
@@ -47,7 +52,8 @@ get_interface_instance(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
   const std::string & compression_format)
 {
-  const auto & registered_classes = class_loader->getDeclaredClasses();
+  std::lock_guard<std::recursive_mutex> lock(rosbag2_storage::get_class_loader_mutex());
+  const auto registered_classes = class_loader->getDeclaredClasses();
   auto class_iter = std::find(
     registered_classes.begin(), registered_classes.end(), compression_format);
   if (class_iter == registered_classes.end()) {
@@ -93,6 +99,18 @@ public:
   std::shared_ptr<rosbag2_compression::BaseCompressorInterface>
   create_compressor(const std::string & compression_format)
   {
+    const auto stage_formats = split_stacked_format(compression_format);
+    if (stage_formats.size() > 1) {
+      std::vector<std::shared_ptr<BaseCompressorInterface>> stages;
+      for (const auto & stage_format : stage_formats) {
+        auto stage = create_compressor(stage_format);
+        if (stage == nullptr) {
+          return nullptr;
+        }
+        stages.push_back(std::move(stage));
+      }
+      return std::make_shared<StackedCompressor>(std::move(stages));
+    }
     auto instance = get_interface_instance(compressor_class_loader_, compression_format);
     if (instance == nullptr) {
       ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
@@ -106,6 +124,18 @@ public:
   std::shared_ptr<rosbag2_compression::BaseDecompressorInterface>
   create_decompressor(const std::string & compression_format)
   {
+    const auto stage_formats = split_stacked_format(compression_format);
+    if (stage_formats.size() > 1) {
+      std::vector<std::shared_ptr<BaseDecompressorInterface>> stages;
+      for (const auto & stage_format : stage_formats) {
+        auto stage = create_decompressor(stage_format);
+        if (stage == nullptr) {
+          return nullptr;
+        }
+        stages.push_back(std::move(stage));
+      }
+      return std::make_shared<StackedDecompressor>(std::move(stages));
+    }
     auto instance = get_interface_instance(decompressor_class_loader_, compression_format);
     if (instance == nullptr) {
       ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
@@ -117,6 +147,7 @@ public:
   /// See CompressionFactory::get_declared_compressor_plugins for documentation.
   std::vector<std::string> get_declared_compressor_plugins() const
   {
+    std::lock_guard<std::recursive_mutex> lock(rosbag2_storage::get_class_loader_mutex());
     return compressor_class_loader_->getDeclaredClasses();
   }
 
@@ -0,0 +1,62 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compression_level_controller.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace rosbag2_compression
+{
+
+namespace
+{
+// Fill levels at and above which the level is lowered, and below which it is raised
+constexpr double kHighPressure = 0.75;
+constexpr double kLowPressure = 0.25;
+}  // namespace
+
+CompressionLevelController::CompressionLevelController(int32_t min_level, int32_t max_level)
+: min_level_(min_level), max_level_(max_level), level_(max_level), used_levels_({max_level})
+{}
+
+int32_t CompressionLevelController::update(double pressure)
+{
+  if (pressure >= kHighPressure && level_ > min_level_) {
+    level_--;
+  } else if (pressure < kLowPressure && level_ < max_level_) {
+    level_++;
+  }
+  used_levels_.insert(level_);
+  return level_;
+}
+
+int32_t CompressionLevelController::get_level() const
+{
+  return level_;
+}
+
+std::string CompressionLevelController::get_used_levels() const
+{
+  std::string levels;
+  for (const auto level : used_levels_) {
+    if (!levels.empty()) {
+      levels += ",";
+    }
+    levels += std::to_string(level);
+  }
+  return levels;
+}
+
+}  // namespace rosbag2_compression
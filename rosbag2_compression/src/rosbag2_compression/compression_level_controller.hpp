@@ -0,0 +1,62 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__COMPRESSION_LEVEL_CONTROLLER_HPP_
+#define ROSBAG2_COMPRESSION__COMPRESSION_LEVEL_CONTROLLER_HPP_
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+namespace rosbag2_compression
+{
+
+// Key of the custom data of the bag metadata which lists the compression levels the adaptive
+// compression level used, separated by commas
+constexpr const char kCompressionLevelsCustomDataKey[] = "rosbag2_compression.compression_levels";
+
+/**
+ * Chooses the compression level of the adaptive compression level from the fill level of the
+ * compression queue or of the message cache.
+ *
+ * The level steps down by one per update while the fill level is high, and back up while it is
+ * low, so that a short burst doesn't change the level for long.
+ */
+class CompressionLevelController
+{
+public:
+  /// Starts at max_level, the level with the best compression ratio.
+  CompressionLevelController(int32_t min_level, int32_t max_level);
+
+  /**
+   * \param pressure Fill level of the compression queue or of the message cache, from 0 to 1.
+   * \return The level to compress with from now on.
+   */
+  int32_t update(double pressure);
+
+  int32_t get_level() const;
+
+  /// \return The levels used so far in ascending order, separated by commas.
+  std::string get_used_levels() const;
+
+private:
+  const int32_t min_level_;
+  const int32_t max_level_;
+  int32_t level_;
+  std::set<int32_t> used_levels_;
+};
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__COMPRESSION_LEVEL_CONTROLLER_HPP_
@@ -27,6 +27,10 @@ namespace
 constexpr const char kCompressionModeNoneStr[] = "NONE";
 constexpr const char kCompressionModeFileStr[] = "FILE";
 constexpr const char kCompressionModeMessageStr[] = "MESSAGE";
+constexpr const char kCompressionModeBatchStr[] = "BATCH";
+constexpr const char kCompressionPolicyAlwaysStr[] = "ALWAYS";
+constexpr const char kCompressionPolicyNeverStr[] = "NEVER";
+constexpr const char kCompressionPolicyAutoStr[] = "AUTO";
 
 std::string to_upper(const std::string & text)
 {
@@ -45,6 +49,8 @@ CompressionMode compression_mode_from_string(const std::string & compression_mod
     return CompressionMode::FILE;
   } else if (compression_mode_upper == kCompressionModeMessageStr) {
     return CompressionMode::MESSAGE;
+  } else if (compression_mode_upper == kCompressionModeBatchStr) {
+    return CompressionMode::BATCH;
   } else {
     ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
       "CompressionMode: \"" << compression_mode << "\" is not supported!");
@@ -61,9 +67,42 @@ std::string compression_mode_to_string(const CompressionMode compression_mode)
       return kCompressionModeFileStr;
     case CompressionMode::MESSAGE:
       return kCompressionModeMessageStr;
+    case CompressionMode::BATCH:
+      return kCompressionModeBatchStr;
     default:
       ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("CompressionMode not supported!");
       return kCompressionModeNoneStr;
   }
 }
+
+CompressionPolicy compression_policy_from_string(const std::string & compression_policy)
+{
+  const auto compression_policy_upper = to_upper(compression_policy);
+  if (compression_policy.empty() || compression_policy_upper == kCompressionPolicyAlwaysStr) {
+    return CompressionPolicy::ALWAYS;
+  } else if (compression_policy_upper == kCompressionPolicyNeverStr) {
+    return CompressionPolicy::NEVER;
+  } else if (compression_policy_upper == kCompressionPolicyAutoStr) {
+    return CompressionPolicy::AUTO;
+  } else {
+    ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
+      "CompressionPolicy: \"" << compression_policy << "\" is not supported!");
+    return CompressionPolicy::ALWAYS;
+  }
+}
+
+std::string compression_policy_to_string(const CompressionPolicy compression_policy)
+{
+  switch (compression_policy) {
+    case CompressionPolicy::ALWAYS:
+      return kCompressionPolicyAlwaysStr;
+    case CompressionPolicy::NEVER:
+      return kCompressionPolicyNeverStr;
+    case CompressionPolicy::AUTO:
+      return kCompressionPolicyAutoStr;
+    default:
+      ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("CompressionPolicy not supported!");
+      return kCompressionPolicyAlwaysStr;
+  }
+}
 }  // namespace rosbag2_compression
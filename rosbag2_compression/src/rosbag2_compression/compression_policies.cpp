@@ -0,0 +1,168 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "compression_policies.hpp"
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+namespace
+{
+// Frames of zstd start with 0x28 or 0x5?, frames of lz4 with 0x04 or 0x5?
+constexpr uint8_t kStoredMessageMarker[] = {0xFF, 'r', 'b', '2', 'r', 'a', 'w', 0xFF};
+constexpr size_t kStoredMessageMarkerSize = sizeof(kStoredMessageMarker);
+}  // namespace
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_stored_message(
+  const rosbag2_storage::SerializedBagMessage & message)
+{
+  auto stored_message = std::make_shared<rosbag2_storage::SerializedBagMessage>(message);
+  const size_t length = message.serialized_data ? message.serialized_data->buffer_length : 0u;
+  stored_message->serialized_data =
+    rosbag2_storage::make_empty_serialized_message(kStoredMessageMarkerSize + length);
+  std::memcpy(
+    stored_message->serialized_data->buffer, kStoredMessageMarker, kStoredMessageMarkerSize);
+  if (length > 0) {
+    std::memcpy(
+      stored_message->serialized_data->buffer + kStoredMessageMarkerSize,
+      message.serialized_data->buffer, length);
+  }
+  stored_message->serialized_data->buffer_length = kStoredMessageMarkerSize + length;
+  return stored_message;
+}
+
+bool unwrap_stored_message(rosbag2_storage::SerializedBagMessage & message)
+{
+  auto & data = message.serialized_data;
+  if (!data || data->buffer_length < kStoredMessageMarkerSize ||
+    std::memcmp(data->buffer, kStoredMessageMarker, kStoredMessageMarkerSize) != 0)
+  {
+    return false;
+  }
+  data->buffer_length -= kStoredMessageMarkerSize;
+  std::memmove(data->buffer, data->buffer + kStoredMessageMarkerSize, data->buffer_length);
+  return true;
+}
+
+CompressionPolicies::CompressionPolicies(const CompressionOptions & compression_options)
+: compression_options_(compression_options)
+{}
+
+CompressionPolicies::Topic & CompressionPolicies::get_topic(const std::string & topic_name)
+{
+  auto it = topics_.find(topic_name);
+  if (it == topics_.end()) {
+    Topic topic;
+    const auto policy_it = compression_options_.topic_compression_policies.find(topic_name);
+    topic.policy = policy_it != compression_options_.topic_compression_policies.end() ?
+      policy_it->second : compression_options_.compression_policy;
+    topic.compress = topic.policy != CompressionPolicy::NEVER;
+    it = topics_.emplace(topic_name, topic).first;
+  }
+  return it->second;
+}
+
+bool CompressionPolicies::should_compress(const std::string & topic_name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Topic & topic = get_topic(topic_name);
+  if (topic.policy == CompressionPolicy::AUTO &&
+    topic.started_probes < compression_options_.compression_probe_messages)
+  {
+    topic.started_probes++;
+    return true;
+  }
+  // Messages are compressed while the decision waits for probes of other threads
+  if (!topic.compress) {
+    topic.stored_any = true;
+  }
+  return topic.compress;
+}
+
+void CompressionPolicies::add_compressed_message(
+  const std::string & topic_name, size_t uncompressed_size, size_t compressed_size)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Topic & topic = get_topic(topic_name);
+  if (topic.policy != CompressionPolicy::AUTO ||
+    topic.finished_probes >= compression_options_.compression_probe_messages)
+  {
+    return;
+  }
+  topic.finished_probes++;
+  topic.uncompressed_bytes += uncompressed_size;
+  topic.compressed_bytes += compressed_size;
+  if (topic.finished_probes < compression_options_.compression_probe_messages ||
+    topic.uncompressed_bytes == 0)
+  {
+    return;
+  }
+  const double ratio =
+    static_cast<double>(topic.compressed_bytes) / static_cast<double>(topic.uncompressed_bytes);
+  topic.compress = ratio <= compression_options_.compression_skip_ratio;
+  if (!topic.compress) {
+    ROSBAG2_COMPRESSION_LOG_INFO_STREAM(
+      "Messages of " << topic_name << " are stored without compression, their first " <<
+        topic.finished_probes << " were compressed to " << static_cast<int>(ratio * 100) <<
+        "% of their size");
+  }
+}
+
+bool CompressionPolicies::may_store_messages(const CompressionOptions & compression_options)
+{
+  if (compression_options.compression_policy != CompressionPolicy::ALWAYS) {
+    return true;
+  }
+  for (const auto & [topic_name, policy] : compression_options.topic_compression_policies) {
+    (void)topic_name;
+    if (policy != CompressionPolicy::ALWAYS) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string CompressionPolicies::get_stored_topics() const
+{
+  std::set<std::string> stored_topics;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & [topic_name, topic] : topics_) {
+      if (topic.stored_any) {
+        stored_topics.insert(topic_name);
+      }
+    }
+  }
+  std::string topics;
+  for (const auto & topic_name : stored_topics) {
+    if (!topics.empty()) {
+      topics += ",";
+    }
+    topics += topic_name;
+  }
+  return topics;
+}
+
+}  // namespace rosbag2_compression
@@ -0,0 +1,102 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_COMPRESSION__COMPRESSION_POLICIES_HPP_
+#define ROSBAG2_COMPRESSION__COMPRESSION_POLICIES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+namespace rosbag2_compression
+{
+
+// Key of the custom data of the bag metadata which lists the topics with messages stored
+// without compression in MESSAGE mode, separated by commas. Readers only look for the marker
+// of stored messages in bags which have it.
+constexpr const char kStoredTopicsCustomDataKey[] = "rosbag2_compression.stored_topics";
+
+/**
+ * Copies a message into a message stored without compression, whose serialized data is
+ * prefixed by a marker.
+ *
+ * The marker starts with a byte that no compressed frame of the supported formats starts with.
+ */
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_stored_message(
+  const rosbag2_storage::SerializedBagMessage & message);
+
+/**
+ * Removes the marker from a message stored without compression.
+ *
+ * \return true if the message was stored without compression, false if it must be decompressed.
+ */
+bool unwrap_stored_message(rosbag2_storage::SerializedBagMessage & message);
+
+/**
+ * Decides per topic whether messages are compressed in MESSAGE mode, from the CompressionPolicy
+ * of the topic. Thread-safe, it is shared by the compression threads.
+ *
+ * Topics with the AUTO policy are compressed until compression_probe_messages of their messages
+ * were compressed. They are not compressed anymore if these were compressed to more than
+ * compression_skip_ratio of their size in total.
+ */
+class CompressionPolicies
+{
+public:
+  explicit CompressionPolicies(const CompressionOptions & compression_options);
+
+  /// \return true if the next message of the topic is to be compressed.
+  bool should_compress(const std::string & topic_name);
+
+  /// Account a compressed message of the topic while it is probed.
+  void add_compressed_message(
+    const std::string & topic_name, size_t uncompressed_size, size_t compressed_size);
+
+  /// \return true if the policies of the options may store any message without compression.
+  static bool may_store_messages(const CompressionOptions & compression_options);
+
+  /// \return The topics with messages stored without compression so far, in alphabetical order,
+  /// separated by commas.
+  std::string get_stored_topics() const;
+
+private:
+  struct Topic
+  {
+    CompressionPolicy policy = CompressionPolicy::ALWAYS;
+    // Probes handed out by should_compress() and the ones accounted so far
+    uint64_t started_probes = 0;
+    uint64_t finished_probes = 0;
+    uint64_t uncompressed_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    bool compress = true;
+    bool stored_any = false;
+  };
+
+  Topic & get_topic(const std::string & topic_name);
+
+  const CompressionOptions compression_options_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Topic> topics_;
+};
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__COMPRESSION_POLICIES_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "file_compression_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rosbag2_compression
+{
+
+FileCompressionScheduler::FileCompressionScheduler(
+  uint64_t max_concurrent_compressions,
+  uint64_t read_bandwidth,
+  double throttle_cache_fill,
+  std::function<double()> cache_fill)
+: max_concurrent_compressions_(std::max<uint64_t>(max_concurrent_compressions, 1u)),
+  read_bandwidth_(read_bandwidth),
+  throttle_cache_fill_(throttle_cache_fill),
+  cache_fill_(std::move(cache_fill))
+{}
+
+void FileCompressionScheduler::begin_compression()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  compression_ended_.wait(
+    lock, [this] {return running_compressions_ < max_concurrent_compressions_;});
+  running_compressions_++;
+}
+
+void FileCompressionScheduler::end_compression()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_compressions_--;
+  }
+  compression_ended_.notify_one();
+}
+
+void FileCompressionScheduler::throttle_read(size_t bytes)
+{
+  if (read_bandwidth_ == 0 || !cache_fill_ || cache_fill_() < throttle_cache_fill_) {
+    return;
+  }
+  const auto read_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(static_cast<double>(bytes) / read_bandwidth_));
+  std::chrono::steady_clock::time_point read_time;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Time spent without throttling isn't saved up for a burst of reads
+    read_time = std::max(std::chrono::steady_clock::now(), next_read_time_);
+    next_read_time_ = read_time + read_duration;
+  }
+  std::this_thread::sleep_until(read_time);
+}
+
+bool FileCompressionScheduler::set_idle_io_priority()
+{
+#ifdef __linux__
+  // ioprio_set(IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)) applies to the
+  // calling thread only. The idle class only gets disk time when no other process uses the disk.
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassIdle = 3;
+  constexpr int kIoprioClassShift = 13;
+  return syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace rosbag2_compression
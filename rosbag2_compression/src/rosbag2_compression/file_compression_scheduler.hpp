@@ -0,0 +1,80 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__FILE_COMPRESSION_SCHEDULER_HPP_
+#define ROSBAG2_COMPRESSION__FILE_COMPRESSION_SCHEDULER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace rosbag2_compression
+{
+
+/**
+ * Schedules the compression of closed files in FILE mode, which reads them back from the disk
+ * the recording writes to.
+ *
+ * Limits how many files the compression threads compress at the same time, and paces the reads
+ * of all of them together to a bandwidth while the message cache fills up, so that the writes of
+ * the recording get the disk first.
+ */
+class FileCompressionScheduler
+{
+public:
+  /**
+   * \param max_concurrent_compressions Number of files compressed at the same time, at least 1.
+   * \param read_bandwidth Bytes per second read while throttled. 0 never throttles.
+   * \param throttle_cache_fill Fill level of the message cache from which on reads are throttled.
+   * \param cache_fill Returns the fill level of the message cache, from 0 to 1. Reads are never
+   *   throttled without it.
+   */
+  FileCompressionScheduler(
+    uint64_t max_concurrent_compressions,
+    uint64_t read_bandwidth,
+    double throttle_cache_fill,
+    std::function<double()> cache_fill);
+
+  /// Blocks until fewer than max_concurrent_compressions files are compressed, then counts the
+  /// file of the calling thread until end_compression().
+  void begin_compression();
+
+  void end_compression();
+
+  /// Blocks until bytes may be read, if the message cache is filled to the throttle level.
+  void throttle_read(size_t bytes);
+
+  /// Lowers the I/O priority of the calling thread to the idle class.
+  /// \return false if that failed or isn't supported on this platform.
+  static bool set_idle_io_priority();
+
+private:
+  const uint64_t max_concurrent_compressions_;
+  const uint64_t read_bandwidth_;
+  const double throttle_cache_fill_;
+  const std::function<double()> cache_fill_;
+
+  std::mutex mutex_;
+  std::condition_variable compression_ended_;
+  uint64_t running_compressions_ = 0;
+  // Time the next throttled read may start at, reads are paced one after the other
+  std::chrono::steady_clock::time_point next_read_time_;
+};
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__FILE_COMPRESSION_SCHEDULER_HPP_
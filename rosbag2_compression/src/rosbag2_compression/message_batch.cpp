@@ -0,0 +1,188 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_compression/message_batch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression
+{
+
+namespace
+{
+
+constexpr uint32_t kMessageBatchVersion = 1;
+// Version and message count
+constexpr size_t kBatchHeaderSize = 4 + 4;
+// Time stamp, send time stamp, sequence number and payload size
+constexpr size_t kMessageHeaderSize = 8 + 8 + 8 + 8;
+
+struct Batch
+{
+  std::vector<const rosbag2_storage::SerializedBagMessage *> messages;
+  rcutils_time_point_value_t earliest_time_stamp = 0;
+  rcutils_time_point_value_t latest_time_stamp = 0;
+  size_t size = kBatchHeaderSize;
+};
+
+// Batches are little-endian, independent of the host
+template<typename T>
+uint8_t * write_value(uint8_t * data, T value)
+{
+  auto bits = static_cast<uint64_t>(value);
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    data[i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  return data + sizeof(T);
+}
+
+template<typename T>
+T read_value(const uint8_t * data)
+{
+  uint64_t bits = 0;
+  for (size_t i = sizeof(T); i > 0; --i) {
+    bits = (bits << 8) | data[i - 1];
+  }
+  return static_cast<T>(bits);
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> pack_batch(const Batch & batch)
+{
+  const auto & first = *batch.messages.front();
+  auto packed = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  packed->topic_name = first.topic_name;
+  packed->interned_topic = first.interned_topic;
+  packed->topic_id = first.topic_id;
+  packed->time_stamp = batch.earliest_time_stamp;
+  packed->serialized_data = rosbag2_storage::make_empty_serialized_message(batch.size);
+
+  uint8_t * data = packed->serialized_data->buffer;
+  data = write_value<uint32_t>(data, kMessageBatchVersion);
+  data = write_value<uint32_t>(data, static_cast<uint32_t>(batch.messages.size()));
+  for (const auto * message : batch.messages) {
+    const size_t payload_size = message->serialized_data->buffer_length;
+    data = write_value<int64_t>(data, message->time_stamp);
+    data = write_value<int64_t>(data, message->send_timestamp);
+    data = write_value<uint64_t>(data, message->sequence_number);
+    data = write_value<uint64_t>(data, payload_size);
+    if (payload_size > 0) {
+      std::memcpy(data, message->serialized_data->buffer, payload_size);
+      data += payload_size;
+    }
+  }
+  packed->serialized_data->buffer_length = batch.size;
+  return packed;
+}
+
+[[noreturn]] void throw_malformed(const rosbag2_storage::SerializedBagMessage & batch)
+{
+  throw std::runtime_error(
+          "Malformed message batch of topic '" + batch.topic_name + "' at time stamp " +
+          std::to_string(batch.time_stamp));
+}
+
+}  // namespace
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> pack_message_batches(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  std::vector<Batch> batches;
+  // Index of the batch messages of a topic are added to
+  std::unordered_map<std::string, size_t> open_batches;
+  for (const auto & message : messages) {
+    const auto time_stamp = message->time_stamp;
+    auto open_batch = open_batches.find(message->topic_name);
+    if (open_batch != open_batches.end()) {
+      const Batch & batch = batches[open_batch->second];
+      const auto earliest = std::min(batch.earliest_time_stamp, time_stamp);
+      const auto latest = std::max(batch.latest_time_stamp, time_stamp);
+      if (latest - earliest > MAX_MESSAGE_BATCH_DURATION) {
+        open_batches.erase(open_batch);
+        open_batch = open_batches.end();
+      }
+    }
+    if (open_batch == open_batches.end()) {
+      open_batch = open_batches.emplace(message->topic_name, batches.size()).first;
+      batches.emplace_back();
+      batches.back().earliest_time_stamp = time_stamp;
+      batches.back().latest_time_stamp = time_stamp;
+    }
+    Batch & batch = batches[open_batch->second];
+    batch.messages.push_back(message.get());
+    batch.earliest_time_stamp = std::min(batch.earliest_time_stamp, time_stamp);
+    batch.latest_time_stamp = std::max(batch.latest_time_stamp, time_stamp);
+    batch.size += kMessageHeaderSize + message->serialized_data->buffer_length;
+  }
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> packed_batches;
+  packed_batches.reserve(batches.size());
+  for (const auto & batch : batches) {
+    packed_batches.push_back(pack_batch(batch));
+  }
+  return packed_batches;
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> unpack_message_batch(
+  const rosbag2_storage::SerializedBagMessage & batch)
+{
+  if (!batch.serialized_data || batch.serialized_data->buffer_length < kBatchHeaderSize) {
+    throw_malformed(batch);
+  }
+  const uint8_t * data = batch.serialized_data->buffer;
+  const size_t size = batch.serialized_data->buffer_length;
+  if (read_value<uint32_t>(data) != kMessageBatchVersion) {
+    throw std::runtime_error(
+            "Unsupported version " + std::to_string(read_value<uint32_t>(data)) +
+            " of message batch of topic '" + batch.topic_name + "'");
+  }
+  const auto message_count = read_value<uint32_t>(data + 4);
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  messages.reserve(message_count);
+  size_t position = kBatchHeaderSize;
+  for (uint32_t i = 0; i < message_count; ++i) {
+    if (size - position < kMessageHeaderSize) {
+      throw_malformed(batch);
+    }
+    const uint8_t * header = data + position;
+    const auto payload_size = read_value<uint64_t>(header + 24);
+    position += kMessageHeaderSize;
+    if (size - position < payload_size) {
+      throw_malformed(batch);
+    }
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = batch.topic_name;
+    message->interned_topic = batch.interned_topic;
+    message->topic_id = batch.topic_id;
+    message->time_stamp = read_value<int64_t>(header);
+    message->send_timestamp = read_value<int64_t>(header + 8);
+    message->sequence_number = read_value<uint64_t>(header + 16);
+    message->serialized_data = rosbag2_storage::make_serialized_message_view(
+      data + position, static_cast<size_t>(payload_size), batch.serialized_data);
+    position += static_cast<size_t>(payload_size);
+    messages.push_back(std::move(message));
+  }
+  return messages;
+}
+
+}  // namespace rosbag2_compression
@@ -14,7 +14,13 @@
 
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -24,11 +30,21 @@
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_compression/message_batch.hpp"
 
+#include "compression_dictionaries.hpp"
+#include "compression_policies.hpp"
 #include "logging.hpp"
 
 namespace rosbag2_compression
 {
+
+namespace
+{
+// Messages read ahead of the reading thread for each decompression thread
+constexpr size_t kPrefetchedMessagesPerDecompressionThread = 4;
+}  // namespace
+
 SequentialCompressionReader::SequentialCompressionReader(
   std::unique_ptr<rosbag2_compression::CompressionFactory> compression_factory,
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
@@ -39,7 +55,10 @@ SequentialCompressionReader::SequentialCompressionReader(
 {}
 
 SequentialCompressionReader::~SequentialCompressionReader()
-{}
+{
+  stop_decompression_threads();
+  wait_for_look_ahead();
+}
 
 void SequentialCompressionReader::setup_decompression()
 {
@@ -54,6 +73,147 @@ void SequentialCompressionReader::setup_decompression()
 
   decompressor_ = compression_factory_->create_decompressor(metadata_.compression_format);
   rcpputils::check_true(decompressor_ != nullptr, "Couldn't initialize decompressor.");
+  has_stored_messages_ = compression_mode_ == rosbag2_compression::CompressionMode::MESSAGE &&
+    metadata_.custom_data.count(kStoredTopicsCustomDataKey) > 0;
+
+  if (compression_mode_ != rosbag2_compression::CompressionMode::FILE) {
+    const auto dictionaries = read_dictionaries(base_folder_, metadata_);
+    for (const auto & dictionary : dictionaries) {
+      decompressor_->add_dictionary(dictionary);
+    }
+    if (compression_mode_ == rosbag2_compression::CompressionMode::MESSAGE) {
+      setup_decompression_threads(dictionaries);
+    }
+  }
+}
+
+void SequentialCompressionReader::setup_decompression_threads(
+  const std::vector<std::vector<uint8_t>> & dictionaries)
+{
+  const auto thread_count = storage_options_.decompression_threads;
+  ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM("Starting " << thread_count << " decompression threads");
+  stop_decompression_threads_ = false;
+  for (uint64_t i = 0; i < thread_count; ++i) {
+    std::shared_ptr<BaseDecompressorInterface> decompressor =
+      compression_factory_->create_decompressor(metadata_.compression_format);
+    rcpputils::check_true(decompressor != nullptr, "Couldn't initialize decompressor.");
+    for (const auto & dictionary : dictionaries) {
+      decompressor->add_dictionary(dictionary);
+    }
+    decompression_threads_.emplace_back(
+      [this, decompressor]() {
+        decompression_thread_fn(*decompressor);
+      });
+  }
+}
+
+void SequentialCompressionReader::stop_decompression_threads()
+{
+  {
+    std::lock_guard<std::mutex> lock(decompression_mutex_);
+    stop_decompression_threads_ = true;
+    decompression_queue_.clear();
+  }
+  decompression_queue_condition_.notify_all();
+  for (auto & thread : decompression_threads_) {
+    thread.join();
+  }
+  decompression_threads_.clear();
+  prefetched_messages_.clear();
+}
+
+void SequentialCompressionReader::decompression_thread_fn(
+  BaseDecompressorInterface & decompressor)
+{
+  // Decompressors handling several messages at once get the ones queued already
+  const size_t max_group_size = std::max<size_t>(decompressor.get_max_batch_messages(), 1u);
+  std::vector<std::shared_ptr<PrefetchedMessage>> group;
+  std::unique_lock<std::mutex> lock(decompression_mutex_);
+  while (true) {
+    decompression_queue_condition_.wait(
+      lock, [this]() {
+        return stop_decompression_threads_ || !decompression_queue_.empty();
+      });
+    if (stop_decompression_threads_) {
+      return;
+    }
+    group.clear();
+    while (group.size() < max_group_size && !decompression_queue_.empty()) {
+      group.push_back(std::move(decompression_queue_.front()));
+      decompression_queue_.pop_front();
+    }
+    lock.unlock();
+    decompress_prefetched_messages(decompressor, group);
+    lock.lock();
+    for (const auto & prefetched : group) {
+      prefetched->decompressed = true;
+    }
+    decompressed_condition_.notify_all();
+  }
+}
+
+void SequentialCompressionReader::decompress_prefetched_messages(
+  BaseDecompressorInterface & decompressor,
+  const std::vector<std::shared_ptr<PrefetchedMessage>> & messages)
+{
+  try {
+    if (messages.size() == 1u) {
+      decompress_message(decompressor, *messages.front()->message);
+      return;
+    }
+    std::vector<rosbag2_storage::SerializedBagMessage *> compressed_messages;
+    for (const auto & prefetched : messages) {
+      if (!has_stored_messages_ || !unwrap_stored_message(*prefetched->message)) {
+        compressed_messages.push_back(prefetched->message.get());
+      }
+    }
+    if (!compressed_messages.empty()) {
+      decompressor.decompress_serialized_bag_messages(compressed_messages);
+    }
+  } catch (...) {
+    // Thrown by read_next() when the messages are read. They were decompressed in place, so
+    // the ones which failed can't be told apart by decompressing them again.
+    for (const auto & prefetched : messages) {
+      prefetched->error = std::current_exception();
+    }
+  }
+}
+
+void SequentialCompressionReader::decompress_message(
+  BaseDecompressorInterface & decompressor, rosbag2_storage::SerializedBagMessage & message)
+{
+  if (has_stored_messages_ && unwrap_stored_message(message)) {
+    return;
+  }
+  decompressor.decompress_serialized_bag_message(&message);
+}
+
+void SequentialCompressionReader::prefetch_messages()
+{
+  const auto max_prefetched_messages =
+    kPrefetchedMessagesPerDecompressionThread * decompression_threads_.size();
+  while (prefetched_messages_.size() < max_prefetched_messages &&
+    SequentialReader::has_next())
+  {
+    auto prefetched = std::make_shared<PrefetchedMessage>();
+    prefetched->message = read_next_from_storage();
+    prefetched_messages_.push_back(prefetched);
+    {
+      std::lock_guard<std::mutex> lock(decompression_mutex_);
+      decompression_queue_.push_back(std::move(prefetched));
+    }
+    decompression_queue_condition_.notify_one();
+  }
+}
+
+void SequentialCompressionReader::clear_prefetched_messages()
+{
+  // Messages which are being decompressed are dropped by their thread once it is done
+  {
+    std::lock_guard<std::mutex> lock(decompression_mutex_);
+    decompression_queue_.clear();
+  }
+  prefetched_messages_.clear();
 }
 
 void SequentialCompressionReader::preprocess_current_file()
@@ -84,9 +244,196 @@ void SequentialCompressionReader::preprocess_current_file()
   }
 
   if (compression_mode_ == CompressionMode::FILE) {
-    ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Decompressing " << get_current_file().c_str());
-    *current_file_iterator_ = decompressor_->decompress_uri(get_current_file());
+    const auto compressed_file = get_current_file();
+    if (decompressor_->open_decompressed_uri(compressed_file)) {
+      ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM(
+        "Decompressing " << compressed_file.c_str() << " while it is read");
+      *current_file_iterator_ =
+        rcpputils::fs::remove_extension(rcpputils::fs::path{compressed_file}).string();
+      streamed_files_[get_current_file()] = compressed_file;
+    } else {
+      *current_file_iterator_ = decompress_file(compressed_file);
+    }
+  }
+}
+
+std::string SequentialCompressionReader::decompress_file(const std::string & compressed_file)
+{
+  std::string decompressed_file;
+  {
+    std::unique_lock<std::mutex> lock(look_ahead_mutex_);
+    if (look_ahead_queue_.count(compressed_file) > 0) {
+      look_ahead_condition_.wait(
+        lock, [this, &compressed_file]() {
+          return look_ahead_files_.count(compressed_file) > 0;
+        });
+    }
+    const auto look_ahead_file = look_ahead_files_.find(compressed_file);
+    if (look_ahead_file != look_ahead_files_.end()) {
+      decompressed_file = look_ahead_file->second;
+      look_ahead_files_.erase(look_ahead_file);
+    }
+  }
+  if (decompressed_file.empty()) {
+    ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Decompressing " << compressed_file.c_str());
+    decompressed_file = decompressor_->decompress_uri(compressed_file);
   }
+  decompressed_files_[decompressed_file] = compressed_file;
+  return decompressed_file;
+}
+
+void SequentialCompressionReader::start_look_ahead()
+{
+  if (compression_mode_ != rosbag2_compression::CompressionMode::FILE ||
+    storage_options_.decompression_look_ahead_files == 0 ||
+    (look_ahead_.valid() &&
+    look_ahead_.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+  {
+    return;
+  }
+  const auto disk_budget = storage_options_.decompression_disk_budget;
+  if (disk_budget > 0 && get_decompressed_files_size() >= disk_budget) {
+    return;
+  }
+
+  std::vector<std::string> files;
+  {
+    std::lock_guard<std::mutex> lock(look_ahead_mutex_);
+    look_ahead_queue_.clear();
+    auto file = current_file_iterator_;
+    for (uint64_t i = 0; i < storage_options_.decompression_look_ahead_files; ++i) {
+      if (++file == file_paths_.end()) {
+        break;
+      }
+      // Skip files which were decompressed already or are read while they are decompressed
+      if (decompressed_files_.count(*file) > 0 || streamed_files_.count(*file) > 0 ||
+        look_ahead_files_.count(*file) > 0 || !rcpputils::fs::exists(*file) ||
+        decompressor_->open_decompressed_uri(*file))
+      {
+        continue;
+      }
+      files.push_back(*file);
+      look_ahead_queue_.insert(*file);
+    }
+  }
+  if (files.empty()) {
+    return;
+  }
+  if (!look_ahead_decompressor_) {
+    look_ahead_decompressor_ =
+      compression_factory_->create_decompressor(metadata_.compression_format);
+    rcpputils::check_true(
+      look_ahead_decompressor_ != nullptr, "Couldn't initialize look-ahead decompressor.");
+  }
+
+  look_ahead_ = std::async(
+    std::launch::async, [this, files]() {
+      for (const auto & file : files) {
+        std::string decompressed_file;
+        try {
+          ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM("Decompressing " << file.c_str() << " ahead");
+          decompressed_file = look_ahead_decompressor_->decompress_uri(file);
+        } catch (const std::exception & e) {
+          // The file is decompressed again when it is opened
+          ROSBAG2_COMPRESSION_LOG_WARN_STREAM(
+            "Failed to decompress " << file.c_str() << " ahead of reading it: " << e.what());
+        }
+        {
+          std::lock_guard<std::mutex> lock(look_ahead_mutex_);
+          look_ahead_files_[file] = decompressed_file;
+        }
+        look_ahead_condition_.notify_all();
+      }
+    });
+}
+
+void SequentialCompressionReader::wait_for_look_ahead()
+{
+  if (look_ahead_.valid()) {
+    look_ahead_.wait();
+  }
+}
+
+void SequentialCompressionReader::remove_files_behind_current_file()
+{
+  const auto disk_budget = storage_options_.decompression_disk_budget;
+  if (disk_budget == 0) {
+    return;
+  }
+  auto size = get_decompressed_files_size();
+  for (auto file = file_paths_.begin(); file != current_file_iterator_ && size > disk_budget;
+    ++file)
+  {
+    const auto decompressed_file = decompressed_files_.find(*file);
+    if (decompressed_file == decompressed_files_.end()) {
+      continue;
+    }
+    const rcpputils::fs::path path{*file};
+    const auto file_size = path.exists() ? path.file_size() : 0u;
+    ROSBAG2_COMPRESSION_LOG_DEBUG_STREAM("Removing decompressed file " << file->c_str());
+    rcpputils::fs::remove(path);
+    size -= std::min<uint64_t>(size, file_size);
+    // The file is decompressed again if it is opened again
+    preprocessed_file_paths_.erase(*file);
+    *file = decompressed_file->second;
+    decompressed_files_.erase(decompressed_file);
+  }
+}
+
+uint64_t SequentialCompressionReader::get_decompressed_files_size()
+{
+  uint64_t size = 0;
+  auto add_size = [&size](const std::string & file) {
+      const rcpputils::fs::path path{file};
+      if (!file.empty() && path.exists()) {
+        size += path.file_size();
+      }
+    };
+  for (const auto & decompressed_file : decompressed_files_) {
+    add_size(decompressed_file.first);
+  }
+  std::lock_guard<std::mutex> lock(look_ahead_mutex_);
+  for (const auto & look_ahead_file : look_ahead_files_) {
+    add_size(look_ahead_file.second);
+  }
+  return size;
+}
+
+std::shared_ptr<rosbag2_storage::ReadableFile>
+SequentialCompressionReader::open_current_readable_file()
+{
+  const auto streamed_file = streamed_files_.find(get_current_file());
+  if (streamed_file == streamed_files_.end()) {
+    return nullptr;
+  }
+  return decompressor_->open_decompressed_uri(streamed_file->second);
+}
+
+bool SequentialCompressionReader::can_open_next_file_ahead() const
+{
+  return compression_mode_ != rosbag2_compression::CompressionMode::FILE;
+}
+
+void SequentialCompressionReader::load_current_file()
+{
+  try {
+    SequentialReader::load_current_file();
+  } catch (const std::exception & e) {
+    const auto streamed_file = streamed_files_.find(get_current_file());
+    if (streamed_file == streamed_files_.end()) {
+      throw;
+    }
+    // The storage implementation may not be able to read files which aren't on disk
+    ROSBAG2_COMPRESSION_LOG_INFO_STREAM(
+      "Decompressing " << streamed_file->second.c_str() <<
+        " since it could not be read while it is decompressed: " << e.what());
+    const auto compressed_file = streamed_file->second;
+    streamed_files_.erase(streamed_file);
+    *current_file_iterator_ = decompress_file(compressed_file);
+    SequentialReader::load_current_file();
+  }
+  remove_files_behind_current_file();
+  start_look_ahead();
 }
 
 void SequentialCompressionReader::open(
@@ -99,21 +446,173 @@ void SequentialCompressionReader::open(
       "\". Bags without metadata (such as from ROS 1) not supported by rosbag2 decompression.";
     throw std::runtime_error{errmsg.str()};
   }
+  unpacked_messages_.clear();
+  last_batch_time_stamp_ = 0;
+  batch_seek_time_ = 0;
+  clear_prefetched_messages();
+  wait_for_look_ahead();
+  streamed_files_.clear();
+  decompressed_files_.clear();
+  look_ahead_queue_.clear();
+  look_ahead_files_.clear();
+  storage_options_ = storage_options;
   SequentialReader::open(storage_options, converter_options);
 }
 
+bool SequentialCompressionReader::has_next()
+{
+  if (storage_ && compression_mode_ == rosbag2_compression::CompressionMode::BATCH) {
+    unpack_batches();
+    return !unpacked_messages_.empty();
+  }
+  if (storage_ && !prefetched_messages_.empty()) {
+    return true;
+  }
+  return SequentialReader::has_next();
+}
+
 std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialCompressionReader::read_next()
 {
   if (storage_ && decompressor_) {
     // roll over if necessary
+    if (compression_mode_ == rosbag2_compression::CompressionMode::BATCH) {
+      if (!has_next()) {
+        throw std::runtime_error("Bag is at end. No next message.");
+      }
+      auto earliest = unpacked_messages_.begin();
+      auto message = std::move(earliest->second);
+      unpacked_messages_.erase(earliest);
+      return converter_ ? converter_->convert(message) : message;
+    }
+    if (!decompression_threads_.empty()) {
+      prefetch_messages();
+      if (prefetched_messages_.empty()) {
+        throw std::runtime_error("Bag is at end. No next message.");
+      }
+      auto prefetched = std::move(prefetched_messages_.front());
+      prefetched_messages_.pop_front();
+      // Keep the threads busy while the message is handed out
+      prefetch_messages();
+      {
+        std::unique_lock<std::mutex> lock(decompression_mutex_);
+        decompressed_condition_.wait(
+          lock, [&prefetched]() {
+            return prefetched->decompressed;
+          });
+      }
+      if (prefetched->error) {
+        std::rethrow_exception(prefetched->error);
+      }
+      return converter_ ? converter_->convert(prefetched->message) : prefetched->message;
+    }
     has_next();
-    auto message = storage_->read_next();
+    auto message = read_next_from_storage();
     if (compression_mode_ == rosbag2_compression::CompressionMode::MESSAGE) {
-      decompressor_->decompress_serialized_bag_message(message.get());
+      decompress_message(*decompressor_, *message);
     }
     return converter_ ? converter_->convert(message) : message;
   }
   throw std::runtime_error{"Bag is not open. Call open() before reading."};
 }
 
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+SequentialCompressionReader::read_next_batch(size_t max_messages, size_t max_bytes)
+{
+  if (storage_ && decompressor_) {
+    // Messages are decompressed one by one by read_next()
+    return rosbag2_cpp::reader_interfaces::BaseReaderInterface::read_next_batch(
+      max_messages, max_bytes);
+  }
+  return SequentialReader::read_next_batch(max_messages, max_bytes);
+}
+
+void SequentialCompressionReader::for_each(const rosbag2_storage::MessageViewCallback & callback)
+{
+  if (storage_ && decompressor_) {
+    // Messages are decompressed one by one by read_next()
+    rosbag2_cpp::reader_interfaces::BaseReaderInterface::for_each(callback);
+    return;
+  }
+  SequentialReader::for_each(callback);
+}
+
+bool SequentialCompressionReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  clear_prefetched_messages();
+  if (storage_ && compression_mode_ == rosbag2_compression::CompressionMode::BATCH &&
+    !(order == rosbag2_storage::ReadOrder()))
+  {
+    ROSBAG2_COMPRESSION_LOG_ERROR(
+      "Bags compressed in BATCH mode can only be read in order of received time stamps.");
+    return false;
+  }
+  return SequentialReader::set_read_order(order);
+}
+
+void SequentialCompressionReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  clear_prefetched_messages();
+  SequentialReader::set_filter(storage_filter);
+}
+
+void SequentialCompressionReader::close()
+{
+  clear_prefetched_messages();
+  SequentialReader::close();
+}
+
+void SequentialCompressionReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  clear_prefetched_messages();
+  if (!storage_ || compression_mode_ != rosbag2_compression::CompressionMode::BATCH) {
+    SequentialReader::seek(timestamp);
+    return;
+  }
+  // Batches which start up to MAX_MESSAGE_BATCH_DURATION earlier may hold messages at timestamp
+  constexpr auto kMinTimestamp = std::numeric_limits<rcutils_time_point_value_t>::min();
+  SequentialReader::seek(
+    timestamp < kMinTimestamp + MAX_MESSAGE_BATCH_DURATION ?
+    kMinTimestamp : timestamp - MAX_MESSAGE_BATCH_DURATION);
+  unpacked_messages_.clear();
+  batch_seek_time_ = timestamp;
+}
+
+rosbag2_storage::StorageFilter SequentialCompressionReader::get_storage_filter() const
+{
+  auto storage_filter = SequentialReader::get_storage_filter();
+  if (compression_mode_ == rosbag2_compression::CompressionMode::BATCH &&
+    storage_filter.start_time_ns >= 0)
+  {
+    storage_filter.start_time_ns =
+      std::max<rcutils_time_point_value_t>(
+      0, storage_filter.start_time_ns - MAX_MESSAGE_BATCH_DURATION);
+  }
+  return storage_filter;
+}
+
+void SequentialCompressionReader::unpack_batches()
+{
+  // Batches are read in order of the time stamps of their earliest messages. Once a batch starts
+  // after the earliest unpacked message, no batch which was not read yet can precede it.
+  while ((unpacked_messages_.empty() ||
+    last_batch_time_stamp_ <= unpacked_messages_.begin()->first) &&
+    SequentialReader::has_next())
+  {
+    auto batch = read_next_from_storage();
+    decompressor_->decompress_serialized_bag_message(batch.get());
+    last_batch_time_stamp_ = batch->time_stamp;
+    const auto start_time = topics_filter_.start_time_ns;
+    const auto end_time = topics_filter_.end_time_ns;
+    for (auto & message : unpack_message_batch(*batch)) {
+      if (message->time_stamp < batch_seek_time_ ||
+        (start_time >= 0 && message->time_stamp < start_time) ||
+        (end_time >= 0 && message->time_stamp > end_time))
+      {
+        continue;
+      }
+      unpacked_messages_.emplace(message->time_stamp, std::move(message));
+    }
+  }
+}
+
 }  // namespace rosbag2_compression
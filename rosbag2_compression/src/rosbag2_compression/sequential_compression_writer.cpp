@@ -19,9 +19,11 @@
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rcpputils/asserts.hpp"
 #include "rcpputils/filesystem_helper.hpp"
@@ -30,9 +32,15 @@
 
 #include "rosbag2_cpp/info.hpp"
 
+#include "rosbag2_compression/message_batch.hpp"
+
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 
+#include "compression_dictionaries.hpp"
+#include "compression_policies.hpp"
+#include "compression_level_controller.hpp"
+#include "file_compression_scheduler.hpp"
 #include "logging.hpp"
 #ifdef _WIN32
 #include <windows.h>
@@ -44,6 +52,23 @@
 namespace rosbag2_compression
 {
 
+namespace
+{
+// Creates the message a message is compressed into, with its fields but without data
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_compressed_message(
+  const rosbag2_storage::SerializedBagMessage & message)
+{
+  auto compressed_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  compressed_message->time_stamp = message.time_stamp;
+  compressed_message->topic_name = message.topic_name;
+  compressed_message->interned_topic = message.interned_topic;
+  compressed_message->topic_id = message.topic_id;
+  compressed_message->send_timestamp = message.send_timestamp;
+  compressed_message->sequence_number = message.sequence_number;
+  return compressed_message;
+}
+}  // namespace
+
 SequentialCompressionWriter::SequentialCompressionWriter(
   const rosbag2_compression::CompressionOptions & compression_options)
 : SequentialWriter(),
@@ -67,7 +92,7 @@ SequentialCompressionWriter::~SequentialCompressionWriter()
   close();
 }
 
-void SequentialCompressionWriter::compression_thread_fn()
+void SequentialCompressionWriter::compression_thread_fn(size_t thread_index)
 {
   if (compression_options_.thread_priority) {
 #ifdef _WIN32
@@ -109,47 +134,250 @@ void SequentialCompressionWriter::compression_thread_fn()
   }
 
   // Every thread needs to have its own compression context for thread safety.
-  auto compressor = compression_factory_->create_compressor(
-    compression_options_.compression_format);
-  rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+  auto compressor = create_compressor();
+
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::MESSAGE) {
+    compress_messages(*compressor, thread_index);
+    collect_dictionaries(*compressor);
+    return;
+  }
+
+  if (compression_options_.file_compression_idle_io &&
+    !FileCompressionScheduler::set_idle_io_priority())
+  {
+    ROSBAG2_COMPRESSION_LOG_WARN(
+      "Could not set the I/O priority of the compression thread to the idle class.");
+  }
 
   while (true) {
-    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message;
     std::string file;
     {
       std::unique_lock<std::mutex> lock(compressor_queue_mutex_);
       compressor_condition_.wait(
         lock,
         [&] {
-          return !compression_is_running_ ||
-          !compressor_message_queue_.empty() ||
-          !compressor_file_queue_.empty();
+          return !compression_is_running_ || !compressor_file_queue_.empty();
         });
 
-      if (!compressor_message_queue_.empty()) {
-        message = compressor_message_queue_.front();
-        compressor_message_queue_.pop();
-        compressor_condition_.notify_all();
-      } else if (!compressor_file_queue_.empty()) {
-        file = compressor_file_queue_.front();
-        compressor_file_queue_.pop();
-      } else if (!compression_is_running_) {
-        // I woke up, all work queues are empty, and the main thread has stopped execution. Exit.
+      if (compressor_file_queue_.empty()) {
+        // I woke up, the work queue is empty, and the main thread has stopped execution. Exit.
         break;
       }
+      file = compressor_file_queue_.front();
+      compressor_file_queue_.pop();
+    }
+    compress_file(*compressor, file);
+  }
+}
+
+std::shared_ptr<BaseCompressorInterface> SequentialCompressionWriter::create_compressor()
+{
+  auto compressor = compression_factory_->create_compressor(
+    compression_options_.compression_format);
+  rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+  if (compression_options_.compression_mode != rosbag2_compression::CompressionMode::FILE) {
+    compressor->configure_dictionaries(
+      compression_options_.dictionary_training_messages, compression_options_.dictionary_path);
+  } else {
+    compressor->set_file_compression_workers(compression_options_.file_compression_workers);
+    compressor->set_file_read_throttle(
+      [scheduler = file_compression_scheduler_.get()](size_t bytes) {
+        scheduler->throttle_read(bytes);
+      });
+  }
+  return compressor;
+}
+
+void SequentialCompressionWriter::collect_dictionaries(const BaseCompressorInterface & compressor)
+{
+  std::lock_guard<std::mutex> lock(dictionaries_mutex_);
+  for (auto & dictionary : compressor.get_dictionaries()) {
+    // Compressors loading the same dictionary file return the same dictionary
+    if (std::find(dictionaries_.begin(), dictionaries_.end(), dictionary) == dictionaries_.end()) {
+      dictionaries_.push_back(std::move(dictionary));
     }
+  }
+}
 
-    if (message) {
-      auto compressed_message = compress_message(*compressor, message);
+void SequentialCompressionWriter::compress_messages(
+  BaseCompressorInterface & compressor, size_t thread_index)
+{
+  MessageShard & shard = *message_shards_[thread_index];
+  // Level of the adaptive compression level applied to the compressor
+  std::optional<int32_t> compressor_level;
+  const size_t max_group_size = std::max<size_t>(compressor.get_max_batch_messages(), 1u);
+  std::vector<QueuedMessage> group;
+  while (true) {
+    QueuedMessage message;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (!shard.messages.empty()) {
+        message = std::move(shard.messages.front());
+        shard.messages.pop_front();
+      }
+    }
+    if (!message.second && !steal_message(thread_index, message)) {
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      shard.condition.wait(
+        lock,
+        [&] {
+          return !message_compression_is_running_ || !shard.messages.empty();
+        });
+      if (shard.messages.empty()) {
+        // Stopped, the other shards are emptied by their own threads
+        break;
+      }
+      message = std::move(shard.messages.front());
+      shard.messages.pop_front();
+    }
+    group.clear();
+    group.push_back(std::move(message));
+    if (max_group_size > 1u) {
+      // Compressors handling several messages at once get the ones queued already, without
+      // waiting for more
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      while (group.size() < max_group_size && !shard.messages.empty()) {
+        group.push_back(std::move(shard.messages.front()));
+        shard.messages.pop_front();
+      }
+    }
+    for (size_t i = 0; i < group.size(); i++) {
+      release_queue_space();
+    }
+    if (compression_level_controller_ && compressor_level != compression_level_.load()) {
+      compressor_level = compression_level_.load();
+      compressor.set_compression_level(*compressor_level);
+    }
+    compress_or_store_messages(compressor, group);
+  }
+}
 
+void SequentialCompressionWriter::compress_or_store_messages(
+  BaseCompressorInterface & compressor, std::vector<QueuedMessage> & messages)
+{
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> results(
+    messages.size());
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> uncompressed;
+  std::vector<size_t> uncompressed_indices;
+  for (size_t i = 0; i < messages.size(); i++) {
+    const auto & message = messages[i].second;
+    if (compression_policies_->should_compress(message->topic_name)) {
+      uncompressed.push_back(message);
+      uncompressed_indices.push_back(i);
+    } else {
+      results[i] = make_stored_message(*message);
+    }
+  }
+  const auto compressed = compress_message_group(compressor, uncompressed);
+  for (size_t i = 0; i < compressed.size(); i++) {
+    const auto & message = uncompressed[i];
+    if (message->serialized_data && compressed[i]->serialized_data) {
+      compression_policies_->add_compressed_message(
+        message->topic_name, message->serialized_data->buffer_length,
+        compressed[i]->serialized_data->buffer_length);
+    }
+    results[uncompressed_indices[i]] = compressed[i];
+  }
+  for (size_t i = 0; i < messages.size(); i++) {
+    write_in_order(messages[i].first, std::move(results[i]));
+  }
+}
+
+bool SequentialCompressionWriter::steal_message(size_t thread_index, QueuedMessage & message)
+{
+  for (size_t i = 1; i < message_shards_.size(); i++) {
+    MessageShard & shard = *message_shards_[(thread_index + i) % message_shards_.size()];
+    // A shard in use is skipped rather than waited for
+    std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+    if (lock.owns_lock() && !shard.messages.empty()) {
+      message = std::move(shard.messages.front());
+      shard.messages.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void SequentialCompressionWriter::release_queue_space()
+{
+  queued_messages_--;
+  if (producer_waits_for_space_) {
+    {
+      // Waits until the producer sleeps, so that the notification can not get lost
+      std::lock_guard<std::mutex> lock(message_queue_mutex_);
+    }
+    message_queue_space_condition_.notify_all();
+  }
+}
+
+bool SequentialCompressionWriter::drop_oldest_message(std::vector<uint64_t> & dropped)
+{
+  // The oldest message is at the front of one of the shards
+  size_t oldest_shard = message_shards_.size();
+  uint64_t oldest_sequence = 0;
+  for (size_t i = 0; i < message_shards_.size(); i++) {
+    std::lock_guard<std::mutex> lock(message_shards_[i]->mutex);
+    const auto & messages = message_shards_[i]->messages;
+    if (!messages.empty() &&
+      (oldest_shard == message_shards_.size() || messages.front().first < oldest_sequence))
+    {
+      oldest_shard = i;
+      oldest_sequence = messages.front().first;
+    }
+  }
+  if (oldest_shard == message_shards_.size()) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(message_shards_[oldest_shard]->mutex);
+    auto & messages = message_shards_[oldest_shard]->messages;
+    if (messages.empty() || messages.front().first != oldest_sequence) {
+      // Taken by a compression thread meanwhile
+      return true;
+    }
+    messages.pop_front();
+  }
+  queued_messages_--;
+  dropped.push_back(oldest_sequence);
+  return true;
+}
+
+void SequentialCompressionWriter::write_in_order(
+  uint64_t sequence, std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  {
+    std::lock_guard<std::mutex> lock(reassembly_mutex_);
+    reassembled_messages_.emplace(sequence, std::move(message));
+    if (writing_reassembled_messages_) {
+      return;
+    }
+    writing_reassembled_messages_ = true;
+  }
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+  while (true) {
+    messages.clear();
+    {
+      std::lock_guard<std::mutex> lock(reassembly_mutex_);
+      if (reassembled_messages_.empty() ||
+        reassembled_messages_.begin()->first != next_sequence_to_write_)
       {
-        // Now that the message is compressed, it can be written to file using the
-        // normal method.
-        std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
-        SequentialWriter::write(compressed_message);
+        writing_reassembled_messages_ = false;
+        return;
       }
-    } else if (!file.empty()) {
-      compress_file(*compressor, file);
+      auto it = reassembled_messages_.begin();
+      while (it != reassembled_messages_.end() && it->first == next_sequence_to_write_) {
+        if (it->second) {
+          messages.push_back(std::move(it->second));
+        }
+        it = reassembled_messages_.erase(it);
+        next_sequence_to_write_++;
+      }
+    }
+    // Now that the messages are compressed, they can be written to file using the
+    // normal method.
+    std::lock_guard<std::recursive_mutex> storage_lock(storage_mutex_);
+    for (const auto & compressed_message : messages) {
+      SequentialWriter::write(compressed_message);
     }
   }
 }
@@ -161,6 +389,12 @@ void SequentialCompressionWriter::init_metadata()
   metadata_.compression_format = compression_options_.compression_format;
   metadata_.compression_mode =
     rosbag2_compression::compression_mode_to_string(compression_options_.compression_mode);
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::MESSAGE &&
+    CompressionPolicies::may_store_messages(compression_options_))
+  {
+    // Set before any file is written, so that readers of unfinished bags look for the marker
+    metadata_.custom_data[kStoredTopicsCustomDataKey] = "";
+  }
 }
 
 void SequentialCompressionWriter::setup_compression()
@@ -169,6 +403,35 @@ void SequentialCompressionWriter::setup_compression()
     throw std::invalid_argument{
             "SequentialCompressionWriter requires a CompressionMode that is not NONE!"};
   }
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::BATCH &&
+    !use_cache_)
+  {
+    throw std::invalid_argument{
+            "The BATCH CompressionMode compresses the batches written by the message cache and "
+            "requires a max_cache_size greater than 0!"};
+  }
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::FILE &&
+    (storage_options_.max_bag_retention_size != 0 ||
+    storage_options_.max_bag_retention_duration != 0))
+  {
+    throw std::invalid_argument{
+            "Rolling retention of bag files is not supported with the FILE CompressionMode, "
+            "which compresses and renames files after they are closed!"};
+  }
+  compression_level_controller_.reset();
+  if (compression_options_.adaptive_compression_level &&
+    compression_options_.compression_mode != rosbag2_compression::CompressionMode::FILE)
+  {
+    if (compression_options_.min_compression_level > compression_options_.max_compression_level) {
+      throw std::invalid_argument{
+              "The min_compression_level of the adaptive compression level must not be greater "
+              "than its max_compression_level!"};
+    }
+    compression_level_controller_ = std::make_unique<CompressionLevelController>(
+      compression_options_.min_compression_level, compression_options_.max_compression_level);
+    compression_level_ = compression_level_controller_->get_level();
+  }
+  compression_policies_ = std::make_unique<CompressionPolicies>(compression_options_);
 
   setup_compressor_threads();
 }
@@ -188,17 +451,81 @@ void SequentialCompressionWriter::setup_compressor_threads()
     std::unique_lock<std::mutex> lock(compressor_queue_mutex_);
     compression_is_running_ = true;
   }
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::FILE) {
+    std::function<double()> cache_fill;
+    if (use_cache_) {
+      // The scheduler mustn't keep the cache alive, the writer resets it on close
+      std::weak_ptr<rosbag2_cpp::cache::MessageCacheInterface> weak_cache = message_cache_;
+      cache_fill = [cache = std::move(weak_cache),
+          max_cache_size = storage_options_.max_cache_size]() {
+          const auto message_cache = cache.lock();
+          return message_cache ?
+                 static_cast<double>(message_cache->get_memory_bytes()) / max_cache_size : 0.0;
+        };
+    }
+    const auto max_concurrent_compressions =
+      compression_options_.max_concurrent_file_compressions > 0 ?
+      compression_options_.max_concurrent_file_compressions :
+      compression_options_.compression_threads;
+    file_compression_scheduler_ = std::make_unique<FileCompressionScheduler>(
+      max_concurrent_compressions,
+      compression_options_.file_compression_read_bandwidth,
+      compression_options_.file_compression_throttle_cache_fill,
+      std::move(cache_fill));
+  }
 
   // This function needs to throw an exception if the compression format is invalid, but because
   // each thread creates its own compressor, we can't actually catch it here if one of the threads
   // fails.  Instead, we'll create a compressor that we don't actually use just so that it will
   // throw an exception if the format is invalid.
-  auto compressor = compression_factory_->create_compressor(
-    compression_options_.compression_format);
-  rcpputils::check_true(compressor != nullptr, "Could not create compressor.");
+  auto compressor = create_compressor();
+  if (compressor->encrypts() &&
+    compression_options_.compression_mode != rosbag2_compression::CompressionMode::FILE)
+  {
+    if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::MESSAGE &&
+      CompressionPolicies::may_store_messages(compression_options_))
+    {
+      throw std::invalid_argument{
+              "The compression format '" + compression_options_.compression_format +
+              "' encrypts messages, which compression policies must not store without it!"};
+    }
+    if (compression_options_.dictionary_training_messages > 0) {
+      throw std::invalid_argument{
+              "The compression format '" + compression_options_.compression_format +
+              "' encrypts messages, dictionaries trained from them would be stored in plain "
+              "text!"};
+    }
+  }
+
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::BATCH) {
+    // Batches are compressed by the cache consumer thread, which writes them
+    compressor_ = std::move(compressor);
+    if (compression_level_controller_) {
+      compressor_->set_compression_level(compression_level_);
+    }
+    return;
+  }
+
+  if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::MESSAGE) {
+    message_shards_.clear();
+    for (uint64_t i = 0; i < compression_options_.compression_threads; i++) {
+      message_shards_.push_back(std::make_unique<MessageShard>());
+    }
+    {
+      std::lock_guard<std::mutex> lock(message_queue_mutex_);
+      next_message_sequence_ = 0;
+    }
+    {
+      std::lock_guard<std::mutex> lock(reassembly_mutex_);
+      reassembled_messages_.clear();
+      next_sequence_to_write_ = 0;
+    }
+    queued_messages_ = 0;
+    message_compression_is_running_ = true;
+  }
 
   for (uint64_t i = 0; i < compression_options_.compression_threads; i++) {
-    compression_threads_.emplace_back([&] {compression_thread_fn();});
+    compression_threads_.emplace_back([this, i] {compression_thread_fn(i);});
   }
 }
 
@@ -211,6 +538,17 @@ void SequentialCompressionWriter::stop_compressor_threads()
       compression_is_running_ = false;
     }
     compressor_condition_.notify_all();
+    message_compression_is_running_ = false;
+    for (auto & shard : message_shards_) {
+      {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+      }
+      shard->condition.notify_all();
+    }
+    {
+      std::lock_guard<std::mutex> lock(message_queue_mutex_);
+    }
+    message_queue_space_condition_.notify_all();
     for (auto & thread : compression_threads_) {
       thread.join();
     }
@@ -229,7 +567,17 @@ void SequentialCompressionWriter::open(
 
 void SequentialCompressionWriter::close()
 {
+  discard_standby_storage();
+  wait_for_closing_storages();
   if (!base_folder_.empty()) {
+    if ((compression_options_.compression_mode == rosbag2_compression::CompressionMode::BATCH ||
+      storage_options_.snapshot_mode) && use_cache_)
+    {
+      // Batches and snapshots are written and counted by the cache consumer, flush it before the
+      // last file is compressed and the metadata is finalized
+      cache_consumer_.reset();
+      message_cache_.reset();
+    }
     // Reset may be called before initializing the compressor (ex. bad options).
     // We compress the last file only if it hasn't been compressed earlier (ex. in split_bagfile()).
     if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::FILE &&
@@ -251,11 +599,36 @@ void SequentialCompressionWriter::close()
 
     stop_compressor_threads();
 
+    if (compressor_) {
+      collect_dictionaries(*compressor_);
+      compressor_.reset();
+    }
+    {
+      std::lock_guard<std::mutex> lock(dictionaries_mutex_);
+      try {
+        write_dictionaries(base_folder_, dictionaries_, metadata_);
+      } catch (const std::runtime_error & e) {
+        ROSBAG2_COMPRESSION_LOG_ERROR_STREAM(
+          "Could not write the compression dictionaries.\n" << e.what());
+      }
+      dictionaries_.clear();
+    }
+    if (compression_level_controller_) {
+      metadata_.custom_data[kCompressionLevelsCustomDataKey] =
+        compression_level_controller_->get_used_levels();
+    }
+    if (metadata_.custom_data.count(kStoredTopicsCustomDataKey) > 0) {
+      metadata_.custom_data[kStoredTopicsCustomDataKey] =
+        compression_policies_->get_stored_topics();
+    }
+
     finalize_metadata();
     if (storage_) {
       storage_->update_metadata(metadata_);
     }
     metadata_io_->write_metadata(base_folder_, metadata_);
+    metadata_io_->remove_metadata_journal(base_folder_);
+    write_topic_statistics();
   }
 
   if (use_cache_) {
@@ -298,7 +671,18 @@ void SequentialCompressionWriter::compress_file(
   ROSBAG2_COMPRESSION_LOG_INFO_STREAM("Compressing file: " << file_relative_to_pwd.string());
 
   if (file_relative_to_pwd.exists() && file_relative_to_pwd.file_size() > 0u) {
-    const auto compressed_uri = compressor.compress_uri(file_relative_to_pwd.string());
+    std::string compressed_uri;
+    if (file_compression_scheduler_) {
+      file_compression_scheduler_->begin_compression();
+    }
+    {
+      rosbag2_cpp::StageTimer timer(
+        pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::COMPRESSION);
+      compressed_uri = compressor.compress_uri(file_relative_to_pwd.string());
+    }
+    if (file_compression_scheduler_) {
+      file_compression_scheduler_->end_compression();
+    }
     const auto relative_compressed_uri = path(compressed_uri).filename();
     {
       // After we've compressed the file, replace the name in the file list with the new name.
@@ -343,6 +727,8 @@ void SequentialCompressionWriter::split_bagfile()
   // If we're in FILE compression mode, push this file's name on to the queue so another
   // thread will handle compressing it.  If not, we can just carry on.
   if (compression_options_.compression_mode == rosbag2_compression::CompressionMode::FILE) {
+    // The file has to be closed before it can be compressed
+    wait_for_closing_storages();
     compressor_file_queue_.push(last_file);
     compressor_condition_.notify_one();
   }
@@ -359,45 +745,184 @@ SequentialCompressionWriter::compress_message(
   BaseCompressorInterface & compressor,
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
-  auto compressed_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
-  compressed_message->time_stamp = message->time_stamp;
-  compressed_message->topic_name = message->topic_name;
-  compressor.compress_serialized_bag_message(message.get(), compressed_message.get());
+  auto compressed_message = make_compressed_message(*message);
+  {
+    rosbag2_cpp::StageTimer timer(
+      pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::COMPRESSION);
+    compressor.compress_serialized_bag_message(message.get(), compressed_message.get());
+  }
+  if (message->serialized_data && compressed_message->serialized_data) {
+    count_compressed_bytes(
+      message->serialized_data->buffer_length, compressed_message->serialized_data->buffer_length);
+  }
   return compressed_message;
 }
 
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+SequentialCompressionWriter::compress_message_group(
+  BaseCompressorInterface & compressor,
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  if (messages.size() == 1u) {
+    return {compress_message(compressor, messages.front())};
+  }
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> compressed_messages;
+  if (messages.empty()) {
+    return compressed_messages;
+  }
+  std::vector<const rosbag2_storage::SerializedBagMessage *> bag_messages;
+  std::vector<rosbag2_storage::SerializedBagMessage *> compressed_bag_messages;
+  compressed_messages.reserve(messages.size());
+  bag_messages.reserve(messages.size());
+  compressed_bag_messages.reserve(messages.size());
+  for (const auto & message : messages) {
+    compressed_messages.push_back(make_compressed_message(*message));
+    bag_messages.push_back(message.get());
+    compressed_bag_messages.push_back(compressed_messages.back().get());
+  }
+  {
+    rosbag2_cpp::StageTimer timer(
+      pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::COMPRESSION);
+    compressor.compress_serialized_bag_messages(bag_messages, compressed_bag_messages);
+  }
+  for (size_t i = 0; i < bag_messages.size(); i++) {
+    if (bag_messages[i]->serialized_data && compressed_bag_messages[i]->serialized_data) {
+      count_compressed_bytes(
+        bag_messages[i]->serialized_data->buffer_length,
+        compressed_bag_messages[i]->serialized_data->buffer_length);
+    }
+  }
+  return compressed_messages;
+}
+
+bool SequentialCompressionWriter::copy_bag_file(
+  const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter)
+{
+  // Files are compressed once they are closed, like files written message by message
+  if (compression_options_.compression_mode != CompressionMode::FILE) {
+    return false;
+  }
+  return SequentialWriter::copy_bag_file(uri, storage_filter);
+}
+
 void SequentialCompressionWriter::write(
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
   // If the compression mode is FILE, write as normal here.  Compressing files doesn't
   // occur until after the bag file is split.
+  // If the compression mode is BATCH, write as normal too. The batches are compressed when the
+  // cache consumer writes them.
   // If the compression mode is MESSAGE, push the message into a queue that will be handled
   // by the compression threads.
-  if (compression_options_.compression_mode == CompressionMode::FILE) {
+  if (compression_options_.compression_mode == CompressionMode::FILE ||
+    compression_options_.compression_mode == CompressionMode::BATCH)
+  {
     SequentialWriter::write(message);
   } else {
-    std::unique_lock<std::mutex> lock(compressor_queue_mutex_);
-    while (compressor_message_queue_.size() > compression_options_.compression_queue_size &&
-      compression_options_.compression_queue_size > 0u)
-    {
-      compressor_message_queue_.pop();
+    std::vector<uint64_t> dropped;
+    std::unique_lock<std::mutex> lock(message_queue_mutex_);
+    if (message_shards_.empty()) {
+      throw std::runtime_error("Bag is not open. Call open() before writing.");
+    }
+    const uint64_t queue_size = compression_options_.compression_queue_size;
+    // The oldest messages are dropped if the queue is full
+    while (queue_size > 0u && queued_messages_ > queue_size && drop_oldest_message(dropped)) {
     }
 
     // If no message should be dropped and the queue has still messages,
-    // compress and write immediately
-    if (compression_options_.compression_queue_size == 0u &&
-      compressor_message_queue_.size() > compression_options_.compression_threads)
-    {
-      compressor_condition_.wait(
+    // wait for the compression threads to catch up
+    if (queue_size == 0u && queued_messages_ > compression_options_.compression_threads) {
+      producer_waits_for_space_ = true;
+      message_queue_space_condition_.wait(
         lock,
         [&] {
-          return !compression_is_running_ ||
-          compressor_message_queue_.size() <= compression_options_.compression_threads;
+          return !message_compression_is_running_ ||
+          queued_messages_ <= compression_options_.compression_threads;
         });
+      producer_waits_for_space_ = false;
     }
 
-    compressor_message_queue_.push(message);
-    compressor_condition_.notify_one();
+    // Messages are spread over the shards round-robin and written in the order of their
+    // sequence numbers, whichever thread compresses them
+    const uint64_t sequence = next_message_sequence_++;
+    MessageShard & shard = *message_shards_[sequence % message_shards_.size()];
+    {
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      shard.messages.emplace_back(sequence, std::move(message));
+      queued_messages_++;
+    }
+    if (pipeline_statistics_) {
+      pipeline_statistics_->set_queue_depth(
+        rosbag2_cpp::PipelineQueue::COMPRESSION_QUEUE_MESSAGES, queued_messages_);
+    }
+    shard.condition.notify_one();
+    if (compression_level_controller_) {
+      update_message_compression_level(sequence);
+    }
+    lock.unlock();
+
+    // Messages following the dropped ones may wait for them to be written. The storage is not
+    // locked while holding the queue mutex, open() takes them in the opposite order.
+    for (const uint64_t sequence : dropped) {
+      write_in_order(sequence, nullptr);
+    }
+  }
+}
+
+void SequentialCompressionWriter::write_batch_to_storage(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  if (compression_options_.compression_mode != CompressionMode::BATCH) {
+    SequentialWriter::write_batch_to_storage(messages);
+    return;
+  }
+  if (compression_level_controller_) {
+    update_batch_compression_level(messages);
+  }
+  const auto batches = pack_message_batches(messages);
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> compressed_batches;
+  // Batches of several topics are compressed in groups, which compressors offloading to
+  // hardware accelerators handle with one round trip
+  const size_t max_group_size = std::max<size_t>(compressor_->get_max_batch_messages(), 1u);
+  for (size_t i = 0; i < batches.size(); i += max_group_size) {
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> group(
+      batches.begin() + i, batches.begin() + std::min(i + max_group_size, batches.size()));
+    const auto compressed_group = compress_message_group(*compressor_, group);
+    compressed_batches.insert(
+      compressed_batches.end(), compressed_group.begin(), compressed_group.end());
+  }
+  SequentialWriter::write_batch_to_storage(compressed_batches);
+}
+
+void SequentialCompressionWriter::update_message_compression_level(uint64_t sequence)
+{
+  // Without a queue size the producer waits once every compression thread has a message
+  const uint64_t capacity = compression_options_.compression_queue_size > 0u ?
+    compression_options_.compression_queue_size : compression_options_.compression_threads;
+  if (capacity == 0u || sequence % capacity != 0u) {
+    return;
+  }
+  const auto pressure = static_cast<double>(queued_messages_) / static_cast<double>(capacity);
+  compression_level_ = compression_level_controller_->update(pressure);
+}
+
+void SequentialCompressionWriter::update_batch_compression_level(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  // A batch filling the cache buffer means the messages arrived faster than they were written
+  uint64_t batch_size = 0;
+  for (const auto & message : messages) {
+    if (message->serialized_data) {
+      batch_size += message->serialized_data->buffer_length;
+    }
+  }
+  const auto pressure =
+    static_cast<double>(batch_size) / static_cast<double>(storage_options_.max_cache_size);
+  const auto previous_level = compression_level_controller_->get_level();
+  const auto level = compression_level_controller_->update(pressure);
+  if (level != previous_level) {
+    compressor_->set_compression_level(level);
+    compression_level_ = level;
   }
 }
 
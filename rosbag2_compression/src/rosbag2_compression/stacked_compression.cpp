@@ -0,0 +1,246 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stacked_compression.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "logging.hpp"
+
+namespace rosbag2_compression
+{
+
+namespace
+{
+// Removes a file a stage wrote for the next one, once that one is done with it
+void remove_intermediate_file(const std::string & uri)
+{
+  const rcpputils::fs::path path{uri};
+  if (rcpputils::fs::exists(path) && !rcpputils::fs::remove(path)) {
+    ROSBAG2_COMPRESSION_LOG_ERROR_STREAM("Failed to remove intermediate file: " << uri);
+  }
+}
+}  // namespace
+
+std::vector<std::string> split_stacked_format(const std::string & compression_format)
+{
+  std::vector<std::string> formats;
+  size_t begin = 0;
+  while (true) {
+    const auto end = compression_format.find(kStackedFormatSeparator, begin);
+    formats.push_back(compression_format.substr(begin, end - begin));
+    if (end == std::string::npos) {
+      return formats;
+    }
+    begin = end + 1;
+  }
+}
+
+StackedCompressor::StackedCompressor(
+  std::vector<std::shared_ptr<BaseCompressorInterface>> stages)
+: stages_(std::move(stages))
+{}
+
+std::string StackedCompressor::compress_uri(const std::string & uri)
+{
+  std::string current_uri = uri;
+  for (const auto & stage : stages_) {
+    auto compressed_uri = stage->compress_uri(current_uri);
+    // The writer removes the file it handed over itself
+    if (current_uri != uri) {
+      remove_intermediate_file(current_uri);
+    }
+    current_uri = std::move(compressed_uri);
+  }
+  return current_uri;
+}
+
+void StackedCompressor::compress_serialized_bag_message(
+  const rosbag2_storage::SerializedBagMessage * bag_message,
+  rosbag2_storage::SerializedBagMessage * compressed_message)
+{
+  // Stages don't compress in place, so the ones in between alternate between two messages
+  rosbag2_storage::SerializedBagMessage intermediates[2] = {*bag_message, *bag_message};
+  const rosbag2_storage::SerializedBagMessage * input = bag_message;
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    auto output = i + 1 == stages_.size() ? compressed_message : &intermediates[i % 2];
+    stages_[i]->compress_serialized_bag_message(input, output);
+    input = output;
+  }
+}
+
+void StackedCompressor::compress_serialized_bag_messages(
+  const std::vector<const rosbag2_storage::SerializedBagMessage *> & bag_messages,
+  const std::vector<rosbag2_storage::SerializedBagMessage *> & compressed_messages)
+{
+  // Every stage compresses all messages at once, for stages which offload them
+  std::vector<rosbag2_storage::SerializedBagMessage> intermediates[2];
+  std::vector<const rosbag2_storage::SerializedBagMessage *> inputs = bag_messages;
+  std::vector<rosbag2_storage::SerializedBagMessage *> outputs(bag_messages.size());
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    if (i + 1 == stages_.size()) {
+      outputs = compressed_messages;
+    } else {
+      auto & intermediate = intermediates[i % 2];
+      intermediate.clear();
+      for (const auto bag_message : bag_messages) {
+        intermediate.push_back(*bag_message);
+      }
+      for (size_t j = 0; j < intermediate.size(); ++j) {
+        outputs[j] = &intermediate[j];
+      }
+    }
+    stages_[i]->compress_serialized_bag_messages(inputs, outputs);
+    inputs.assign(outputs.begin(), outputs.end());
+  }
+}
+
+size_t StackedCompressor::get_max_batch_messages() const
+{
+  size_t max_batch_messages = 1;
+  for (const auto & stage : stages_) {
+    max_batch_messages = std::max(max_batch_messages, stage->get_max_batch_messages());
+  }
+  return max_batch_messages;
+}
+
+std::string StackedCompressor::get_compression_identifier() const
+{
+  std::string identifier;
+  for (const auto & stage : stages_) {
+    if (!identifier.empty()) {
+      identifier += kStackedFormatSeparator;
+    }
+    identifier += stage->get_compression_identifier();
+  }
+  return identifier;
+}
+
+void StackedCompressor::configure_dictionaries(
+  uint64_t training_messages, const std::string & dictionary_path)
+{
+  for (const auto & stage : stages_) {
+    stage->configure_dictionaries(training_messages, dictionary_path);
+  }
+}
+
+std::vector<std::vector<uint8_t>> StackedCompressor::get_dictionaries() const
+{
+  std::vector<std::vector<uint8_t>> dictionaries;
+  for (const auto & stage : stages_) {
+    for (auto & dictionary : stage->get_dictionaries()) {
+      dictionaries.push_back(std::move(dictionary));
+    }
+  }
+  return dictionaries;
+}
+
+void StackedCompressor::set_compression_level(int32_t level)
+{
+  for (const auto & stage : stages_) {
+    stage->set_compression_level(level);
+  }
+}
+
+void StackedCompressor::set_file_compression_workers(uint64_t workers)
+{
+  for (const auto & stage : stages_) {
+    stage->set_file_compression_workers(workers);
+  }
+}
+
+void StackedCompressor::set_file_read_throttle(std::function<void(size_t)> throttle)
+{
+  // Every stage reads a file, the intermediate ones are on the same disk as the bag
+  for (const auto & stage : stages_) {
+    stage->set_file_read_throttle(throttle);
+  }
+}
+
+bool StackedCompressor::encrypts() const
+{
+  return std::any_of(
+    stages_.begin(), stages_.end(), [](const auto & stage) {return stage->encrypts();});
+}
+
+StackedDecompressor::StackedDecompressor(
+  std::vector<std::shared_ptr<BaseDecompressorInterface>> stages)
+: stages_(std::move(stages))
+{}
+
+std::string StackedDecompressor::decompress_uri(const std::string & uri)
+{
+  std::string current_uri = uri;
+  for (auto stage = stages_.rbegin(); stage != stages_.rend(); ++stage) {
+    auto decompressed_uri = (*stage)->decompress_uri(current_uri);
+    if (current_uri != uri) {
+      remove_intermediate_file(current_uri);
+    }
+    current_uri = std::move(decompressed_uri);
+  }
+  return current_uri;
+}
+
+void StackedDecompressor::decompress_serialized_bag_message(
+  rosbag2_storage::SerializedBagMessage * bag_message)
+{
+  for (auto stage = stages_.rbegin(); stage != stages_.rend(); ++stage) {
+    (*stage)->decompress_serialized_bag_message(bag_message);
+  }
+}
+
+void StackedDecompressor::decompress_serialized_bag_messages(
+  const std::vector<rosbag2_storage::SerializedBagMessage *> & bag_messages)
+{
+  for (auto stage = stages_.rbegin(); stage != stages_.rend(); ++stage) {
+    (*stage)->decompress_serialized_bag_messages(bag_messages);
+  }
+}
+
+size_t StackedDecompressor::get_max_batch_messages() const
+{
+  size_t max_batch_messages = 1;
+  for (const auto & stage : stages_) {
+    max_batch_messages = std::max(max_batch_messages, stage->get_max_batch_messages());
+  }
+  return max_batch_messages;
+}
+
+std::string StackedDecompressor::get_decompression_identifier() const
+{
+  std::string identifier;
+  for (const auto & stage : stages_) {
+    if (!identifier.empty()) {
+      identifier += kStackedFormatSeparator;
+    }
+    identifier += stage->get_decompression_identifier();
+  }
+  return identifier;
+}
+
+void StackedDecompressor::add_dictionary(const std::vector<uint8_t> & dictionary)
+{
+  for (const auto & stage : stages_) {
+    stage->add_dictionary(dictionary);
+  }
+}
+
+}  // namespace rosbag2_compression
@@ -0,0 +1,113 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION__STACKED_COMPRESSION_HPP_
+#define ROSBAG2_COMPRESSION__STACKED_COMPRESSION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/base_compressor_interface.hpp"
+#include "rosbag2_compression/base_decompressor_interface.hpp"
+
+namespace rosbag2_compression
+{
+
+// Separates the formats of a stacked compression format, e.g. "zstd+aes_gcm" compresses with
+// zstd and encrypts the result with aes_gcm
+constexpr const char kStackedFormatSeparator = '+';
+
+/// Splits a compression format into the formats of its stages, in the order they compress.
+std::vector<std::string> split_stacked_format(const std::string & compression_format);
+
+/**
+ * Compresses with several compressors, each one compressing the output of the one before.
+ *
+ * Stacked compressors run on the compression threads of the writer like any other compressor,
+ * e.g. to encrypt messages right after they were compressed, without another pass over them.
+ * The options of the writer, like dictionaries or the compression level, are applied to all
+ * stages, which ignore what they don't support.
+ */
+class StackedCompressor : public BaseCompressorInterface
+{
+public:
+  explicit StackedCompressor(std::vector<std::shared_ptr<BaseCompressorInterface>> stages);
+
+  /// Compresses the file with every stage and removes the files in between.
+  std::string compress_uri(const std::string & uri) override;
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage * bag_message,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override;
+
+  void compress_serialized_bag_messages(
+    const std::vector<const rosbag2_storage::SerializedBagMessage *> & bag_messages,
+    const std::vector<rosbag2_storage::SerializedBagMessage *> & compressed_messages) override;
+
+  size_t get_max_batch_messages() const override;
+
+  std::string get_compression_identifier() const override;
+
+  void configure_dictionaries(uint64_t training_messages, const std::string & dictionary_path)
+  override;
+
+  std::vector<std::vector<uint8_t>> get_dictionaries() const override;
+
+  void set_compression_level(int32_t level) override;
+
+  void set_file_compression_workers(uint64_t workers) override;
+
+  void set_file_read_throttle(std::function<void(size_t)> throttle) override;
+
+  bool encrypts() const override;
+
+private:
+  std::vector<std::shared_ptr<BaseCompressorInterface>> stages_;
+};
+
+/**
+ * Decompresses what a StackedCompressor compressed, with the stages in reverse order.
+ */
+class StackedDecompressor : public BaseDecompressorInterface
+{
+public:
+  /// \param stages Decompressors of the stages, in the order the stages compressed.
+  explicit StackedDecompressor(std::vector<std::shared_ptr<BaseDecompressorInterface>> stages);
+
+  /// Decompresses the file with every stage and removes the files in between.
+  std::string decompress_uri(const std::string & uri) override;
+
+  void decompress_serialized_bag_message(rosbag2_storage::SerializedBagMessage * bag_message)
+  override;
+
+  void decompress_serialized_bag_messages(
+    const std::vector<rosbag2_storage::SerializedBagMessage *> & bag_messages) override;
+
+  size_t get_max_batch_messages() const override;
+
+  std::string get_decompression_identifier() const override;
+
+  void add_dictionary(const std::vector<uint8_t> & dictionary) override;
+
+private:
+  std::vector<std::shared_ptr<BaseDecompressorInterface>> stages_;
+};
+
+}  // namespace rosbag2_compression
+
+#endif  // ROSBAG2_COMPRESSION__STACKED_COMPRESSION_HPP_
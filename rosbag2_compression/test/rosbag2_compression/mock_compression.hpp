@@ -17,8 +17,11 @@
 
 #include <gmock/gmock.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rosbag2_compression/base_compressor_interface.hpp"
 #include "rosbag2_compression/base_decompressor_interface.hpp"
@@ -32,16 +35,32 @@ public:
     void(const rosbag2_storage::SerializedBagMessage *,
     rosbag2_storage::SerializedBagMessage *));
   MOCK_CONST_METHOD0(get_compression_identifier, std::string());
+  MOCK_METHOD2(configure_dictionaries, void(uint64_t, const std::string &));
+  MOCK_CONST_METHOD0(get_dictionaries, std::vector<std::vector<uint8_t>>());
+  MOCK_METHOD1(set_compression_level, void(int32_t));
+  MOCK_METHOD2(
+    compress_serialized_bag_messages,
+    void(const std::vector<const rosbag2_storage::SerializedBagMessage *> &,
+    const std::vector<rosbag2_storage::SerializedBagMessage *> &));
+  MOCK_CONST_METHOD0(get_max_batch_messages, size_t());
 };
 
 class MockDecompressor : public rosbag2_compression::BaseDecompressorInterface
 {
 public:
   MOCK_METHOD1(decompress_uri, std::string(const std::string & uri));
+  MOCK_METHOD1(
+    open_decompressed_uri,
+    std::shared_ptr<rosbag2_storage::ReadableFile>(const std::string & uri));
   MOCK_METHOD1(
     decompress_serialized_bag_message,
     void(rosbag2_storage::SerializedBagMessage * bag_message));
   MOCK_CONST_METHOD0(get_decompression_identifier, std::string());
+  MOCK_METHOD1(add_dictionary, void(const std::vector<uint8_t> &));
+  MOCK_METHOD1(
+    decompress_serialized_bag_messages,
+    void(const std::vector<rosbag2_storage::SerializedBagMessage *> &));
+  MOCK_CONST_METHOD0(get_max_batch_messages, size_t());
 };
 
 #endif  // ROSBAG2_COMPRESSION__MOCK_COMPRESSION_HPP_
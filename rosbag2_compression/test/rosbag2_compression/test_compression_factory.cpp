@@ -64,3 +64,21 @@ TEST_F(CompressionFactoryTest, load_compression_plugins_test) {
   }
   ASSERT_TRUE(found_compressor);
 }
+
+TEST_F(CompressionFactoryTest, load_stacked_compressor_and_decompressor) {
+  const auto compression_format = "fake_comp+fake_comp";
+  auto compressor = factory.create_compressor(compression_format);
+  ASSERT_TRUE(compressor != nullptr);
+  EXPECT_EQ(compression_format, compressor->get_compression_identifier());
+  EXPECT_EQ(compressor->compress_uri("bag_0.db3"), "bag_0.db3.fake_comp.fake_comp");
+
+  auto decompressor = factory.create_decompressor(compression_format);
+  ASSERT_TRUE(decompressor != nullptr);
+  EXPECT_EQ(compression_format, decompressor->get_decompression_identifier());
+  EXPECT_EQ(decompressor->decompress_uri("bag_0.db3.fake_comp.fake_comp"), "bag_0.db3");
+}
+
+TEST_F(CompressionFactoryTest, stacked_format_with_unknown_stage_is_not_loaded) {
+  EXPECT_EQ(factory.create_compressor("fake_comp+foo"), nullptr);
+  EXPECT_EQ(factory.create_decompressor("foo+fake_comp"), nullptr);
+}
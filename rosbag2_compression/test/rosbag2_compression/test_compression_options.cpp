@@ -74,6 +74,14 @@ TEST(CompressionOptionsFromStringTest, MessageStringReturnsMessageMode)
   EXPECT_EQ(compression_mode, rosbag2_compression::CompressionMode::MESSAGE);
 }
 
+TEST(CompressionOptionsFromStringTest, MixedCaseBatchStringReturnsBatchMode)
+{
+  const std::string compression_mode_string{"BaTcH"};
+  const auto compression_mode = rosbag2_compression::compression_mode_from_string(
+    compression_mode_string);
+  EXPECT_EQ(compression_mode, rosbag2_compression::CompressionMode::BATCH);
+}
+
 TEST(CompressionOptionsToStringTest, BadModeReturnsNoneString)
 {
   // Get an out of bounds enum from CompressionMode
@@ -92,6 +100,14 @@ TEST(CompressionOptionsToStringTest, MessageModeReturnsMessageString)
   EXPECT_EQ(compression_mode_string, "MESSAGE");
 }
 
+TEST(CompressionOptionsToStringTest, BatchModeReturnsBatchString)
+{
+  const auto compression_mode = rosbag2_compression::CompressionMode::BATCH;
+  const auto compression_mode_string = rosbag2_compression::compression_mode_to_string(
+    compression_mode);
+  EXPECT_EQ(compression_mode_string, "BATCH");
+}
+
 TEST(CompressionOptionsToStringTest, FileModeReturnsFileString)
 {
   const auto compression_mode = rosbag2_compression::CompressionMode::FILE;
@@ -107,3 +123,30 @@ TEST(CompressionOptionsToStringTest, NoneModeReturnsNoneString)
     compression_mode);
   EXPECT_EQ(compression_mode_string, "NONE");
 }
+
+TEST(CompressionOptionsFromStringTest, MixedCaseAutoStringReturnsAutoPolicy)
+{
+  const std::string compression_policy_string{"AuTo"};
+  const auto compression_policy = rosbag2_compression::compression_policy_from_string(
+    compression_policy_string);
+  EXPECT_EQ(compression_policy, rosbag2_compression::CompressionPolicy::AUTO);
+}
+
+TEST(CompressionOptionsFromStringTest, BadInputReturnsAlwaysPolicy)
+{
+  const std::string compression_policy_string{"bad_policy"};
+  const auto compression_policy = rosbag2_compression::compression_policy_from_string(
+    compression_policy_string);
+  EXPECT_EQ(compression_policy, rosbag2_compression::CompressionPolicy::ALWAYS);
+}
+
+TEST(CompressionOptionsToStringTest, PolicyRoundTrips)
+{
+  for (const auto policy : {rosbag2_compression::CompressionPolicy::ALWAYS,
+      rosbag2_compression::CompressionPolicy::NEVER, rosbag2_compression::CompressionPolicy::AUTO})
+  {
+    EXPECT_EQ(
+      rosbag2_compression::compression_policy_from_string(
+        rosbag2_compression::compression_policy_to_string(policy)), policy);
+  }
+}
@@ -0,0 +1,112 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_compression/message_batch.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp,
+  const std::string & payload)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->send_timestamp = time_stamp - 1;
+  message->sequence_number = static_cast<uint64_t>(time_stamp);
+  message->serialized_data =
+    rosbag2_storage::make_serialized_message(payload.data(), payload.size());
+  return message;
+}
+
+std::string payload_of(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+}  // namespace
+
+TEST(MessageBatchTest, pack_and_unpack_keep_messages_of_every_topic)
+{
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages = {
+    make_message("/a", 30, "first"),
+    make_message("/b", 10, ""),
+    make_message("/a", 20, "second"),
+    make_message("/b", 40, "third"),
+  };
+
+  const auto batches = rosbag2_compression::pack_message_batches(messages);
+  ASSERT_EQ(batches.size(), 2u);
+  EXPECT_EQ(batches[0]->topic_name, "/a");
+  EXPECT_EQ(batches[0]->time_stamp, 20);
+  EXPECT_EQ(batches[1]->topic_name, "/b");
+  EXPECT_EQ(batches[1]->time_stamp, 10);
+
+  const auto a_messages = rosbag2_compression::unpack_message_batch(*batches[0]);
+  ASSERT_EQ(a_messages.size(), 2u);
+  EXPECT_EQ(a_messages[0]->topic_name, "/a");
+  EXPECT_EQ(a_messages[0]->time_stamp, 30);
+  EXPECT_EQ(a_messages[0]->send_timestamp, 29);
+  EXPECT_EQ(a_messages[0]->sequence_number, 30u);
+  EXPECT_EQ(payload_of(*a_messages[0]), "first");
+  EXPECT_EQ(a_messages[1]->time_stamp, 20);
+  EXPECT_EQ(payload_of(*a_messages[1]), "second");
+
+  const auto b_messages = rosbag2_compression::unpack_message_batch(*batches[1]);
+  ASSERT_EQ(b_messages.size(), 2u);
+  EXPECT_EQ(payload_of(*b_messages[0]), "");
+  EXPECT_EQ(b_messages[1]->time_stamp, 40);
+  EXPECT_EQ(payload_of(*b_messages[1]), "third");
+}
+
+TEST(MessageBatchTest, batches_do_not_span_more_than_max_duration)
+{
+  const auto max_duration = rosbag2_compression::MAX_MESSAGE_BATCH_DURATION;
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages = {
+    make_message("/a", 0, "0"),
+    make_message("/a", max_duration, "1"),
+    make_message("/a", max_duration + 1, "2"),
+    make_message("/a", 0, "3"),
+  };
+
+  const auto batches = rosbag2_compression::pack_message_batches(messages);
+  ASSERT_EQ(batches.size(), 3u);
+  EXPECT_EQ(rosbag2_compression::unpack_message_batch(*batches[0]).size(), 2u);
+  EXPECT_EQ(batches[1]->time_stamp, max_duration + 1);
+  EXPECT_EQ(rosbag2_compression::unpack_message_batch(*batches[1]).size(), 1u);
+  EXPECT_EQ(batches[2]->time_stamp, 0);
+}
+
+TEST(MessageBatchTest, unpack_throws_on_truncated_batch)
+{
+  const auto batches = rosbag2_compression::pack_message_batches({make_message("/a", 1, "data")});
+  ASSERT_EQ(batches.size(), 1u);
+  batches[0]->serialized_data->buffer_length -= 1;
+  EXPECT_THROW(rosbag2_compression::unpack_message_batch(*batches[0]), std::runtime_error);
+
+  rosbag2_storage::SerializedBagMessage empty_batch;
+  EXPECT_THROW(rosbag2_compression::unpack_message_batch(empty_batch), std::runtime_error);
+}
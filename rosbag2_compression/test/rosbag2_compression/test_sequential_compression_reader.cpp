@@ -14,19 +14,25 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "rcpputils/asserts.hpp"
 #include "rcpputils/filesystem_helper.hpp"
 
+#include "rosbag2_compression/message_batch.hpp"
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 
 #include "rosbag2_cpp/reader.hpp"
 
+#include "rosbag2_storage/ros_helper.hpp"
+
 #include "mock_converter_factory.hpp"
 #include "mock_metadata_io.hpp"
 #include "mock_storage.hpp"
@@ -39,6 +45,23 @@ using namespace testing;  // NOLINT
 
 static constexpr const char * DefaultTestCompressor = "fake_comp";
 
+namespace
+{
+class EmptyReadableFile : public rosbag2_storage::ReadableFile
+{
+public:
+  uint64_t size() const override
+  {
+    return 0;
+  }
+
+  uint64_t read(uint8_t * /*data*/, uint64_t /*offset*/, uint64_t /*size*/) override
+  {
+    return 0;
+  }
+};
+}  // namespace
+
 class SequentialCompressionReaderTest : public Test
 {
 public:
@@ -308,3 +331,353 @@ TEST_F(SequentialCompressionReaderTest, does_not_decompress_again_on_seek)
   reader_->open(storage_options_, converter_options_);
   reader_->seek(0);
 }
+
+TEST_F(SequentialCompressionReaderTest, reads_messages_of_batches_in_time_stamp_order)
+{
+  metadata_.relative_file_paths = {"bagfile_0." + std::string(DefaultTestCompressor)};
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::BATCH);
+
+  auto make_message = [](const std::string & topic_name, rcutils_time_point_value_t time_stamp) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = topic_name;
+      message->time_stamp = time_stamp;
+      message->serialized_data = rosbag2_storage::make_empty_serialized_message(0);
+      return std::shared_ptr<const rosbag2_storage::SerializedBagMessage>(message);
+    };
+  // Two batches of the cache consumer, which overlap in time
+  auto batches = rosbag2_compression::pack_message_batches(
+    {make_message("/a", 10), make_message("/a", 30), make_message("/b", 20)});
+  for (auto & batch : rosbag2_compression::pack_message_batches(
+      {make_message("/a", 40), make_message("/b", 35)}))
+  {
+    batches.push_back(std::move(batch));
+  }
+  // Storage returns the batches in order of their time stamps
+  std::sort(
+    batches.begin(), batches.end(), [](const auto & lhs, const auto & rhs) {
+      return lhs->time_stamp < rhs->time_stamp;
+    });
+  size_t next_batch = 0;
+  ON_CALL(*storage_, has_next()).WillByDefault(
+    [&batches, &next_batch]() {
+      return next_batch < batches.size();
+    });
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&batches, &next_batch]() {
+      return std::make_shared<rosbag2_storage::SerializedBagMessage>(*batches[next_batch++]);
+    });
+  ON_CALL(*storage_, seek(_)).WillByDefault(
+    [&batches, &next_batch](const rcutils_time_point_value_t & timestamp) {
+      next_batch = 0;
+      while (next_batch < batches.size() && batches[next_batch]->time_stamp < timestamp) {
+        next_batch++;
+      }
+    });
+
+  auto reader = create_reader();
+  reader->open(storage_options_, converter_options_);
+  EXPECT_FALSE(reader->set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  while (reader->has_next()) {
+    time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(10, 20, 30, 35, 40));
+
+  // The batch of /a starting at 10 holds a message after the seek time stamp
+  reader->seek(25);
+  time_stamps.clear();
+  while (reader->has_next()) {
+    time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(30, 35, 40));
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_hands_dictionaries_of_bag_to_decompressor)
+{
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  metadata_.custom_data["rosbag2_compression.dictionaries"] = "compression_dictionary_0.dict";
+  const std::vector<uint8_t> dictionary = {'d', 'i', 'c', 't'};
+  {
+    std::ofstream output(
+      (tmp_dir_ / "compression_dictionary_0.dict").string(), std::ios::out | std::ios::binary);
+    output.write(reinterpret_cast<const char *>(dictionary.data()), dictionary.size());
+  }
+
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*decompressor, add_dictionary(dictionary)).Times(1);
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_reads_files_while_they_are_decompressed)
+{
+  const auto file = std::make_shared<EmptyReadableFile>();
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, open_decompressed_uri(_)).WillByDefault(Return(file));
+  EXPECT_CALL(*decompressor, decompress_uri(_)).Times(0);
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(1)
+  .WillOnce(
+    [this, file](const rosbag2_storage::StorageOptions & storage_options) {
+      EXPECT_EQ(storage_options.uri, (tmp_dir_ / "bagfile_0").string());
+      EXPECT_EQ(storage_options.readable_file, file);
+      return storage_;
+    });
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_files_storage_fails_to_read)
+{
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, open_decompressed_uri(_))
+  .WillByDefault(Return(std::make_shared<EmptyReadableFile>()));
+  EXPECT_CALL(*decompressor, decompress_uri((tmp_dir_ / metadata_.relative_file_paths[0]).string()))
+  .Times(1).WillOnce(Return((tmp_dir_ / "bagfile_0").string()));
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(2)
+  .WillOnce(
+    [](const rosbag2_storage::StorageOptions & storage_options)
+    -> std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> {
+      EXPECT_NE(storage_options.readable_file, nullptr);
+      throw std::runtime_error("not supported");
+    })
+  .WillOnce(
+    [this](const rosbag2_storage::StorageOptions & storage_options) {
+      EXPECT_EQ(storage_options.readable_file, nullptr);
+      return storage_;
+    });
+
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+  auto sequential_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(sequential_reader));
+  reader_->open(storage_options_, converter_options_);
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_next_file_ahead)
+{
+  storage_options_.decompression_look_ahead_files = 1;
+  const auto compressed_file_1 = (tmp_dir_ / metadata_.relative_file_paths[1]).string();
+  const auto decompressed_file_1 = (tmp_dir_ / "bagfile_1").string();
+
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*decompressor, decompress_uri(_)).Times(1)
+  .WillOnce(Return((tmp_dir_ / "bagfile_0").string()));
+  auto look_ahead_decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  EXPECT_CALL(*look_ahead_decompressor, decompress_uri(compressed_file_1)).Times(1)
+  .WillOnce(Return(decompressed_file_1));
+
+  auto compression_factory = std::make_unique<StrictMock<MockCompressionFactory>>();
+  EXPECT_CALL(*compression_factory, create_decompressor(_)).Times(2)
+  .WillOnce(Return(ByMove(std::move(decompressor))))
+  .WillOnce(Return(ByMove(std::move(look_ahead_decompressor))));
+  std::vector<std::string> opened_files;
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(2)
+  .WillRepeatedly(
+    [this, &opened_files](const rosbag2_storage::StorageOptions & storage_options) {
+      opened_files.push_back(storage_options.uri);
+      return storage_;
+    });
+  EXPECT_CALL(*storage_, has_next()).Times(2)
+  .WillOnce(Return(false))  // Load the next file
+  .WillOnce(Return(true));
+
+  auto compression_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  compression_reader->open(storage_options_, converter_options_);
+  EXPECT_TRUE(compression_reader->has_next());
+  EXPECT_THAT(opened_files, ElementsAre((tmp_dir_ / "bagfile_0").string(), decompressed_file_1));
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_removes_decompressed_files_behind_current_file)
+{
+  // Everything beyond the current file exceeds the budget
+  storage_options_.decompression_disk_budget = 1;
+
+  auto decompressor = std::make_unique<NiceMock<MockDecompressor>>();
+  ON_CALL(*decompressor, decompress_uri).WillByDefault(
+    [](auto uri) {
+      const auto decompressed_file = rcpputils::fs::remove_extension(uri).string();
+      std::ofstream output(decompressed_file);
+      output << "Decompressed storage data" << std::endl;
+      return decompressed_file;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_))
+  .WillByDefault(Return(ByMove(std::move(decompressor))));
+  EXPECT_CALL(*storage_, has_next()).Times(2)
+  .WillOnce(Return(false))  // Load the next file
+  .WillOnce(Return(true));
+
+  auto compression_reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+
+  compression_reader->open(storage_options_, converter_options_);
+  EXPECT_TRUE(rcpputils::fs::exists(tmp_dir_ / "bagfile_0"));
+  EXPECT_TRUE(compression_reader->has_next());
+  EXPECT_FALSE(rcpputils::fs::exists(tmp_dir_ / "bagfile_0"));
+  EXPECT_TRUE(rcpputils::fs::exists(tmp_dir_ / "bagfile_1"));
+  // The compressed files are kept
+  EXPECT_TRUE(rcpputils::fs::exists(tmp_dir_ / metadata_.relative_file_paths[0]));
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_decompresses_messages_on_multiple_threads_in_order)
+{
+  metadata_.relative_file_paths = {"bagfile_0." + std::string(DefaultTestCompressor)};
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  storage_options_.decompression_threads = 3;
+
+  const rcutils_time_point_value_t message_count = 50;
+  rcutils_time_point_value_t next_message = 0;
+  ON_CALL(*storage_, has_next()).WillByDefault(
+    [&next_message, message_count]() {
+      return next_message < message_count;
+    });
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&next_message]() {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "topic";
+      message->time_stamp = next_message++;
+      return message;
+    });
+  ON_CALL(*storage_, seek(_)).WillByDefault(
+    [&next_message](const rcutils_time_point_value_t & timestamp) {
+      next_message = timestamp;
+    });
+
+  const auto reading_thread = std::this_thread::get_id();
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  // One decompressor for reading and one for each thread
+  EXPECT_CALL(*compression_factory, create_decompressor(_)).Times(4)
+  .WillRepeatedly(
+    [reading_thread](const std::string &) {
+      auto decompressor = std::make_shared<NiceMock<MockDecompressor>>();
+      ON_CALL(*decompressor, decompress_serialized_bag_message(_)).WillByDefault(
+        [reading_thread](rosbag2_storage::SerializedBagMessage * message) {
+          EXPECT_NE(std::this_thread::get_id(), reading_thread);
+          if (message->time_stamp == 42) {
+            throw std::runtime_error("corrupt message");
+          }
+          message->topic_name = "decompressed";
+        });
+      return decompressor;
+    });
+  auto reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  reader->open(storage_options_, converter_options_);
+
+  for (rcutils_time_point_value_t i = 0; i < 42; ++i) {
+    ASSERT_TRUE(reader->has_next());
+    const auto message = reader->read_next();
+    EXPECT_EQ(message->time_stamp, i);
+    EXPECT_EQ(message->topic_name, "decompressed");
+  }
+  EXPECT_THROW(reader->read_next(), std::runtime_error);
+
+  // Messages which were read ahead are dropped
+  reader->seek(45);
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  while (reader->has_next()) {
+    time_stamps.push_back(reader->read_next()->time_stamp);
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(45, 46, 47, 48, 49));
+}
+
+TEST_F(SequentialCompressionReaderTest, reader_hands_queued_messages_to_decompressor_in_groups)
+{
+  metadata_.relative_file_paths = {"bagfile_0." + std::string(DefaultTestCompressor)};
+  metadata_.compression_mode =
+    rosbag2_compression::compression_mode_to_string(rosbag2_compression::CompressionMode::MESSAGE);
+  storage_options_.decompression_threads = 1;
+
+  const rcutils_time_point_value_t message_count = 20;
+  rcutils_time_point_value_t next_message = 0;
+  ON_CALL(*storage_, has_next()).WillByDefault(
+    [&next_message, message_count]() {
+      return next_message < message_count;
+    });
+  ON_CALL(*storage_, read_next()).WillByDefault(
+    [&next_message]() {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "topic";
+      message->time_stamp = next_message++;
+      return message;
+    });
+
+  const size_t kMaxGroupSize = 4;
+  std::mutex group_sizes_mutex;
+  std::vector<size_t> group_sizes;
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_decompressor(_)).WillByDefault(
+    [&](const std::string &) {
+      auto decompressor = std::make_shared<NiceMock<MockDecompressor>>();
+      ON_CALL(*decompressor, get_max_batch_messages()).WillByDefault(Return(kMaxGroupSize));
+      ON_CALL(*decompressor, decompress_serialized_bag_message(_)).WillByDefault(
+        [](rosbag2_storage::SerializedBagMessage * message) {
+          message->topic_name = "decompressed";
+        });
+      ON_CALL(*decompressor, decompress_serialized_bag_messages(_)).WillByDefault(
+        [&](const std::vector<rosbag2_storage::SerializedBagMessage *> & messages) {
+          std::lock_guard<std::mutex> lock(group_sizes_mutex);
+          group_sizes.push_back(messages.size());
+          for (auto message : messages) {
+            message->topic_name = "decompressed";
+          }
+        });
+      return decompressor;
+    });
+  auto reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>(
+    std::move(compression_factory),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  reader->open(storage_options_, converter_options_);
+
+  for (rcutils_time_point_value_t i = 0; i < message_count; ++i) {
+    ASSERT_TRUE(reader->has_next());
+    const auto message = reader->read_next();
+    EXPECT_EQ(message->time_stamp, i);
+    EXPECT_EQ(message->topic_name, "decompressed");
+  }
+  reader.reset();
+  EXPECT_THAT(group_sizes, Each(AllOf(Gt(1u), Le(kMaxGroupSize))));
+}
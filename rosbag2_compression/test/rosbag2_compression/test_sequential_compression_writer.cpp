@@ -14,9 +14,15 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -24,10 +30,12 @@
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_compression/message_batch.hpp"
 #include "rosbag2_compression/sequential_compression_writer.hpp"
 
 #include "rosbag2_cpp/writer.hpp"
 
+#include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 
 #include "mock_converter_factory.hpp"
@@ -35,6 +43,7 @@
 #include "mock_storage.hpp"
 #include "mock_storage_factory.hpp"
 
+#include "mock_compression.hpp"
 #include "mock_compression_factory.hpp"
 #include "fake_compression_factory.hpp"
 
@@ -49,6 +58,28 @@ using namespace testing;  // NOLINT
 
 static constexpr const char * DefaultTestCompressor = "fake_comp";
 
+// Takes longer to compress some messages than others, so the threads finish them out of order
+class SlowSequentialCompressionWriter : public rosbag2_compression::SequentialCompressionWriter
+{
+public:
+  using rosbag2_compression::SequentialCompressionWriter::SequentialCompressionWriter;
+
+  ~SlowSequentialCompressionWriter() override
+  {
+    // Stop the compression threads before compress_message() is destroyed
+    close();
+  }
+
+protected:
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> compress_message(
+    rosbag2_compression::BaseCompressorInterface & compressor,
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds((message->time_stamp * 7919) % 500));
+    return SequentialCompressionWriter::compress_message(compressor, message);
+  }
+};
+
 class SequentialCompressionWriterTest : public TestWithParam<uint64_t>
 {
 public:
@@ -282,6 +313,62 @@ TEST_F(SequentialCompressionWriterTest, writer_creates_correct_metadata_relative
   }
 }
 
+TEST_F(SequentialCompressionWriterTest, writer_limits_concurrent_file_compressions)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+  rosbag2_compression::CompressionOptions compression_options {
+    DefaultTestCompressor,
+    rosbag2_compression::CompressionMode::FILE,
+    kDefaultCompressionQueueSize,
+    kDefaultCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority
+  };
+  compression_options.max_concurrent_file_compressions = 1;
+
+  std::mutex compressions_mutex;
+  int running_compressions = 0;
+  int max_running_compressions = 0;
+  int compressed_files = 0;
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  ON_CALL(*compressor, compress_uri(_)).WillByDefault(
+    [&](const std::string & uri) {
+      {
+        std::lock_guard<std::mutex> lock(compressions_mutex);
+        running_compressions++;
+        max_running_compressions = std::max(max_running_compressions, running_compressions);
+      }
+      // Long enough for the other compression threads to pick up the queued files
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      std::lock_guard<std::mutex> lock(compressions_mutex);
+      running_compressions--;
+      compressed_files++;
+      return uri + ".mock";
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  initializeFakeFileStorage();
+  initializeWriter(compression_options, std::move(compression_factory));
+
+  tmp_dir_storage_options_.max_bagfile_size = 1;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = test_topic_name;
+
+  const size_t kNumMessagesToWrite = 4;
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    // bag size == max_bagfile_size, every message splits the file
+    writer_->write(message);
+  }
+  writer_.reset();
+
+  EXPECT_EQ(compressed_files, static_cast<int>(kNumMessagesToWrite));
+  EXPECT_EQ(max_running_compressions, 1);
+}
+
 TEST_F(SequentialCompressionWriterTest, writer_call_metadata_update_on_open_and_destruction)
 {
   const std::string test_topic_name = "test_topic";
@@ -456,6 +543,409 @@ TEST_P(SequentialCompressionWriterTest, writer_sets_threads_priority)
   EXPECT_EQ(fake_storage_size_, kNumMessagesToWrite);
 }
 
+TEST_F(SequentialCompressionWriterTest, writer_writes_compressed_messages_in_order)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+  const uint64_t kCompressionQueueThreads = 8;
+
+  rosbag2_compression::CompressionOptions compression_options {
+    DefaultTestCompressor,
+    rosbag2_compression::CompressionMode::MESSAGE,
+    0,
+    kCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority
+  };
+
+  initializeFakeFileStorage();
+  std::vector<rcutils_time_point_value_t> written_time_stamps;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&written_time_stamps](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      written_time_stamps.push_back(message->time_stamp);
+    });
+  auto sequential_writer = std::make_unique<SlowSequentialCompressionWriter>(
+    compression_options,
+    std::make_unique<rosbag2_compression::CompressionFactory>(),
+    std::move(storage_factory_),
+    converter_factory_,
+    std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+
+  const size_t kNumMessagesToWrite = 200;
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  ASSERT_EQ(written_time_stamps.size(), kNumMessagesToWrite);
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    EXPECT_EQ(written_time_stamps[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+}
+
+TEST_F(SequentialCompressionWriterTest, open_throws_on_batch_mode_without_cache)
+{
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::BATCH,
+    kDefaultCompressionQueueSize, kDefaultCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority};
+  initializeWriter(compression_options);
+
+  EXPECT_THROW(writer_->open(tmp_dir_storage_options_), std::invalid_argument);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_writes_compressed_batches_in_batch_mode)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::BATCH,
+    kDefaultCompressionQueueSize, kDefaultCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority};
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  size_t compressed_batches = 0;
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [&compressed_batches](
+      const rosbag2_storage::SerializedBagMessage * batch,
+      rosbag2_storage::SerializedBagMessage * compressed_batch) {
+      compressed_batches++;
+      compressed_batch->serialized_data = batch->serialized_data;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> written_batches;
+  ON_CALL(
+    *storage_,
+    write(An<const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>()))
+  .WillByDefault(
+    [&written_batches](
+      const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & batches) {
+      written_batches.insert(written_batches.end(), batches.begin(), batches.end());
+    });
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  tmp_dir_storage_options_.max_cache_size = 1024 * 1024;
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+
+  const size_t kNumMessagesToWrite = 5;
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    message->serialized_data = rosbag2_storage::make_serialized_message(&i, sizeof(i));
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  EXPECT_EQ(compressed_batches, written_batches.size());
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  for (const auto & batch : written_batches) {
+    EXPECT_EQ(batch->topic_name, test_topic_name);
+    for (const auto & message : rosbag2_compression::unpack_message_batch(*batch)) {
+      time_stamps.push_back(message->time_stamp);
+    }
+  }
+  EXPECT_THAT(time_stamps, ElementsAre(0, 1, 2, 3, 4));
+  // Metadata counts the messages, not the batches
+  EXPECT_EQ(intercepted_write_metadata_.message_count, kNumMessagesToWrite);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stores_dictionaries_of_compressors)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+  const uint64_t kTrainingMessages = 10;
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    kDefaultCompressionQueueSize, kDefaultCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority};
+  compression_options.dictionary_training_messages = kTrainingMessages;
+  const std::vector<uint8_t> dictionary = {'d', 'i', 'c', 't'};
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  EXPECT_CALL(*compressor, configure_dictionaries(kTrainingMessages, "")).Times(AtLeast(1));
+  ON_CALL(*compressor, get_dictionaries()).WillByDefault(
+    Return(std::vector<std::vector<uint8_t>>{dictionary}));
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [](
+      const rosbag2_storage::SerializedBagMessage * message,
+      rosbag2_storage::SerializedBagMessage * compressed_message) {
+      compressed_message->serialized_data = message->serialized_data;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = test_topic_name;
+  const uint8_t payload = 42;
+  message->serialized_data = rosbag2_storage::make_serialized_message(&payload, sizeof(payload));
+  writer_->write(message);
+  writer_.reset();  // reset will call writer destructor
+
+  // Every compression thread returns the same dictionary, which is stored once
+  EXPECT_EQ(
+    intercepted_write_metadata_.custom_data["rosbag2_compression.dictionaries"],
+    "compression_dictionary_0.dict");
+  std::ifstream input(
+    (tmp_dir_ / "compression_dictionary_0.dict").string(), std::ios::in | std::ios::binary);
+  ASSERT_TRUE(input.is_open());
+  EXPECT_EQ(
+    std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()),
+    dictionary);
+}
+
+TEST_F(SequentialCompressionWriterTest, open_throws_on_invalid_adaptive_compression_levels)
+{
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    kDefaultCompressionQueueSize, kDefaultCompressionQueueThreads,
+    kDefaultCompressionQueueThreadsPriority};
+  compression_options.adaptive_compression_level = true;
+  compression_options.min_compression_level = 3;
+  compression_options.max_compression_level = 1;
+  initializeWriter(compression_options);
+
+  EXPECT_THROW(writer_->open(tmp_dir_storage_options_), std::invalid_argument);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_lowers_compression_level_while_queue_is_full)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+  const uint64_t kCompressionQueueSize = 4;
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    kCompressionQueueSize, 1, kDefaultCompressionQueueThreadsPriority};
+  compression_options.adaptive_compression_level = true;
+  compression_options.min_compression_level = -2;
+  compression_options.max_compression_level = 1;
+  std::mutex levels_mutex;
+  std::vector<int32_t> levels;
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  ON_CALL(*compressor, set_compression_level(_)).WillByDefault(
+    [&levels_mutex, &levels](int32_t level) {
+      std::lock_guard<std::mutex> lock(levels_mutex);
+      levels.push_back(level);
+    });
+  // Compresses slower than messages are written, so that the queue stays full
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [](
+      const rosbag2_storage::SerializedBagMessage * message,
+      rosbag2_storage::SerializedBagMessage * compressed_message) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      compressed_message->serialized_data = message->serialized_data;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+  for (size_t i = 0; i < 100; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  EXPECT_THAT(levels, Contains(-2));
+  EXPECT_THAT(levels, Each(AllOf(Ge(-2), Le(1))));
+  EXPECT_EQ(
+    intercepted_write_metadata_.custom_data["rosbag2_compression.compression_levels"],
+    "-2,-1,0,1");
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stores_messages_of_never_compressed_topics)
+{
+  const std::string compressed_topic_name = "compressed_topic";
+  const std::string stored_topic_name = "stored_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    0, 1, kDefaultCompressionQueueThreadsPriority};
+  compression_options.topic_compression_policies[stored_topic_name] =
+    rosbag2_compression::CompressionPolicy::NEVER;
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  std::atomic<size_t> compressed_messages{0};
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [&compressed_messages](
+      const rosbag2_storage::SerializedBagMessage * message,
+      rosbag2_storage::SerializedBagMessage * compressed_message) {
+      ++compressed_messages;
+      compressed_message->serialized_data = message->serialized_data;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  std::mutex written_mutex;
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> written_messages;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&written_mutex, &written_messages](
+      std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      std::lock_guard<std::mutex> lock(written_mutex);
+      written_messages.push_back(message);
+    });
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({compressed_topic_name, test_topic_type, "", {}, ""});
+  writer_->create_topic({stored_topic_name, test_topic_type, "", {}, ""});
+  const std::string payload = "payload";
+  for (size_t i = 0; i < 10; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = i % 2 ? stored_topic_name : compressed_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    message->serialized_data = rosbag2_storage::make_serialized_message(
+      payload.data(), payload.size());
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  EXPECT_EQ(compressed_messages, 5u);
+  ASSERT_THAT(written_messages, SizeIs(10));
+  for (const auto & message : written_messages) {
+    const auto length = message->serialized_data->buffer_length;
+    if (message->topic_name == stored_topic_name) {
+      EXPECT_GT(length, payload.size());
+    } else {
+      EXPECT_EQ(length, payload.size());
+    }
+    // The payload is kept at the end of stored messages
+    ASSERT_GE(length, payload.size());
+    EXPECT_EQ(
+      std::string(
+        reinterpret_cast<const char *>(message->serialized_data->buffer) + length -
+        payload.size(), payload.size()),
+      payload);
+  }
+  EXPECT_EQ(
+    intercepted_write_metadata_.custom_data["rosbag2_compression.stored_topics"],
+    stored_topic_name);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_stops_compressing_incompressible_auto_topics)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    0, 1, kDefaultCompressionQueueThreadsPriority};
+  compression_options.compression_policy = rosbag2_compression::CompressionPolicy::AUTO;
+  compression_options.compression_probe_messages = 4;
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  std::atomic<size_t> compressed_messages{0};
+  // Compressed messages are as large as the uncompressed ones
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [&compressed_messages](
+      const rosbag2_storage::SerializedBagMessage * message,
+      rosbag2_storage::SerializedBagMessage * compressed_message) {
+      ++compressed_messages;
+      compressed_message->serialized_data = message->serialized_data;
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+  const std::string payload = "incompressible";
+  for (size_t i = 0; i < 20; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    message->serialized_data = rosbag2_storage::make_serialized_message(
+      payload.data(), payload.size());
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  EXPECT_EQ(compressed_messages, 4u);
+  EXPECT_EQ(
+    intercepted_write_metadata_.custom_data["rosbag2_compression.stored_topics"],
+    test_topic_name);
+}
+
+TEST_F(SequentialCompressionWriterTest, writer_hands_queued_messages_to_compressor_in_groups)
+{
+  const std::string test_topic_name = "test_topic";
+  const std::string test_topic_type = "test_msgs/BasicTypes";
+  const size_t kMaxGroupSize = 8;
+  const size_t kNumMessagesToWrite = 40;
+
+  rosbag2_compression::CompressionOptions compression_options{
+    DefaultTestCompressor, rosbag2_compression::CompressionMode::MESSAGE,
+    kNumMessagesToWrite, 1, kDefaultCompressionQueueThreadsPriority};
+  auto compressor = std::make_shared<NiceMock<MockCompressor>>();
+  ON_CALL(*compressor, get_max_batch_messages()).WillByDefault(Return(kMaxGroupSize));
+  // Compresses slower than messages are written, so that messages queue up meanwhile
+  ON_CALL(*compressor, compress_serialized_bag_message(_, _)).WillByDefault(
+    [](
+      const rosbag2_storage::SerializedBagMessage * message,
+      rosbag2_storage::SerializedBagMessage * compressed_message) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      compressed_message->serialized_data = message->serialized_data;
+    });
+  std::vector<size_t> group_sizes;
+  ON_CALL(*compressor, compress_serialized_bag_messages(_, _)).WillByDefault(
+    [&group_sizes](
+      const std::vector<const rosbag2_storage::SerializedBagMessage *> & messages,
+      const std::vector<rosbag2_storage::SerializedBagMessage *> & compressed_messages) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      group_sizes.push_back(messages.size());
+      for (size_t i = 0; i < messages.size(); i++) {
+        compressed_messages[i]->serialized_data = messages[i]->serialized_data;
+      }
+    });
+  auto compression_factory = std::make_unique<NiceMock<MockCompressionFactory>>();
+  ON_CALL(*compression_factory, create_compressor(_)).WillByDefault(Return(compressor));
+
+  std::vector<rcutils_time_point_value_t> written_time_stamps;
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [&written_time_stamps](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) {
+      written_time_stamps.push_back(message->time_stamp);
+    });
+
+  initializeWriter(compression_options, std::move(compression_factory));
+  writer_->open(tmp_dir_storage_options_);
+  writer_->create_topic({test_topic_name, test_topic_type, "", {}, ""});
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = test_topic_name;
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    writer_->write(message);
+  }
+  writer_.reset();  // reset will call writer destructor
+
+  ASSERT_EQ(written_time_stamps.size(), kNumMessagesToWrite);
+  for (size_t i = 0; i < kNumMessagesToWrite; i++) {
+    EXPECT_EQ(written_time_stamps[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+  ASSERT_THAT(group_sizes, Not(IsEmpty()));
+  EXPECT_THAT(group_sizes, Each(AllOf(Gt(1u), Le(kMaxGroupSize))));
+}
+
 INSTANTIATE_TEST_SUITE_P(
   SequentialCompressionWriterTestQueueSizes,
   SequentialCompressionWriterTest,
@@ -0,0 +1,73 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_AES__AES_GCM_COMPRESSOR_HPP_
+#define ROSBAG2_COMPRESSION_AES__AES_GCM_COMPRESSOR_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "rosbag2_compression/base_compressor_interface.hpp"
+
+#include "rosbag2_compression_aes/encryption_key.hpp"
+#include "rosbag2_compression_aes/visibility_control.hpp"
+
+namespace rosbag2_compression_aes
+{
+
+class AesGcm;
+
+/**
+ * A BaseCompressorInterface that encrypts bagfiles and messages with AES-256-GCM.
+ *
+ * It doesn't compress, it is stacked after a compressor to encrypt what that one compressed,
+ * e.g. with the compression format "zstd+aes_gcm". Messages are encrypted on the compression
+ * threads of the writer like they are compressed, so that the bag is never written in plain
+ * text. Files are encrypted in chunks, which readers decrypt while reading.
+ *
+ * The key is read from the file named by the ROSBAG2_ENCRYPTION_KEY_FILE environment variable,
+ * as 64 hexadecimal digits.
+ */
+class ROSBAG2_COMPRESSION_AES_PUBLIC AesGcmCompressor
+  : public rosbag2_compression::BaseCompressorInterface
+{
+public:
+  /// \throws std::runtime_error if the key can't be loaded.
+  AesGcmCompressor();
+
+  explicit AesGcmCompressor(const EncryptionKey & key);
+
+  ~AesGcmCompressor() override;
+
+  std::string compress_uri(const std::string & uri) override;
+
+  void compress_serialized_bag_message(
+    const rosbag2_storage::SerializedBagMessage * bag_message,
+    rosbag2_storage::SerializedBagMessage * compressed_message) override;
+
+  std::string get_compression_identifier() const override;
+
+  bool encrypts() const override;
+
+  void set_file_read_throttle(std::function<void(size_t)> throttle) override;
+
+private:
+  std::unique_ptr<AesGcm> aes_gcm_;
+  std::function<void(size_t)> file_read_throttle_;
+};
+
+}  // namespace rosbag2_compression_aes
+
+#endif  // ROSBAG2_COMPRESSION_AES__AES_GCM_COMPRESSOR_HPP_
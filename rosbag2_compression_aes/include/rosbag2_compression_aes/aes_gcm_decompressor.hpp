@@ -0,0 +1,65 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_AES__AES_GCM_DECOMPRESSOR_HPP_
+#define ROSBAG2_COMPRESSION_AES__AES_GCM_DECOMPRESSOR_HPP_
+
+#include <memory>
+#include <string>
+
+#include "rosbag2_compression/base_decompressor_interface.hpp"
+
+#include "rosbag2_compression_aes/encryption_key.hpp"
+#include "rosbag2_compression_aes/visibility_control.hpp"
+
+namespace rosbag2_compression_aes
+{
+
+class AesGcm;
+
+/**
+ * A BaseDecompressorInterface that decrypts bagfiles and messages encrypted by AesGcmCompressor.
+ */
+class ROSBAG2_COMPRESSION_AES_PUBLIC AesGcmDecompressor
+  : public rosbag2_compression::BaseDecompressorInterface
+{
+public:
+  /// \throws std::runtime_error if the key can't be loaded.
+  AesGcmDecompressor();
+
+  explicit AesGcmDecompressor(const EncryptionKey & key);
+
+  ~AesGcmDecompressor() override;
+
+  /// \throws std::runtime_error if the file was modified, cut off or encrypted with another key.
+  std::string decompress_uri(const std::string & uri) override;
+
+  /// Decrypts the chunks of the file as they are read, without writing it to disk in plain text.
+  std::shared_ptr<rosbag2_storage::ReadableFile> open_decompressed_uri(const std::string & uri)
+  override;
+
+  /// \throws std::runtime_error if the message was modified or encrypted with another key.
+  void decompress_serialized_bag_message(
+    rosbag2_storage::SerializedBagMessage * bag_message) override;
+
+  std::string get_decompression_identifier() const override;
+
+private:
+  EncryptionKey key_;
+  std::unique_ptr<AesGcm> aes_gcm_;
+};
+
+}  // namespace rosbag2_compression_aes
+
+#endif  // ROSBAG2_COMPRESSION_AES__AES_GCM_DECOMPRESSOR_HPP_
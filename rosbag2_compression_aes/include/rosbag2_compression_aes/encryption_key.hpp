@@ -0,0 +1,29 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_AES__ENCRYPTION_KEY_HPP_
+#define ROSBAG2_COMPRESSION_AES__ENCRYPTION_KEY_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace rosbag2_compression_aes
+{
+
+/// AES-256 key bags are encrypted with.
+using EncryptionKey = std::array<uint8_t, 32>;
+
+}  // namespace rosbag2_compression_aes
+
+#endif  // ROSBAG2_COMPRESSION_AES__ENCRYPTION_KEY_HPP_
@@ -0,0 +1,127 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "encryption_utils.hpp"
+#include "rosbag2_compression_aes/aes_gcm_compressor.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression_aes
+{
+AesGcmCompressor::AesGcmCompressor()
+: AesGcmCompressor(load_encryption_key())
+{}
+
+AesGcmCompressor::AesGcmCompressor(const EncryptionKey & key)
+: aes_gcm_(std::make_unique<AesGcm>(key))
+{}
+
+AesGcmCompressor::~AesGcmCompressor() = default;
+
+std::string AesGcmCompressor::compress_uri(const std::string & uri)
+{
+  const auto compressed_uri = uri + "." + get_compression_identifier();
+
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  std::ofstream output(compressed_uri, std::ios::out | std::ios::binary);
+  if (!output.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary writing! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  uint8_t header[kEncryptedFileHeaderSize];
+  std::copy(std::begin(kEncryptedFileMagic), std::end(kEncryptedFileMagic), header);
+  write_uint32(header + sizeof(kEncryptedFileMagic), kEncryptedFileChunkSize);
+  output.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+  // Every chunk is full but the last one, which is empty if the file ends with a full chunk
+  std::vector<uint8_t> in_buffer(kEncryptedFileChunkSize);
+  std::vector<uint8_t> out_buffer(kEncryptedFileChunkSize + kEncryptionOverhead);
+  bool last = false;
+  for (uint64_t index = 0; !last; ++index) {
+    if (file_read_throttle_) {
+      file_read_throttle_(in_buffer.size());
+    }
+    input.read(
+      reinterpret_cast<char *>(in_buffer.data()), static_cast<std::streamsize>(in_buffer.size()));
+    const auto read_size = size_t(input.gcount());
+    last = read_size < in_buffer.size();
+    const auto aad = make_chunk_aad(index, last);
+    aes_gcm_->seal(aad.data(), aad.size(), in_buffer.data(), read_size, out_buffer.data());
+    output.write(
+      reinterpret_cast<const char *>(out_buffer.data()),
+      static_cast<std::streamsize>(read_size + kEncryptionOverhead));
+  }
+  output.flush();
+  if (!output) {
+    throw std::runtime_error{"Failed to write encrypted file: \"" + compressed_uri + "\""};
+  }
+  output.close();
+  input.close();
+  return compressed_uri;
+}
+
+void AesGcmCompressor::compress_serialized_bag_message(
+  const rosbag2_storage::SerializedBagMessage * bag_message,
+  rosbag2_storage::SerializedBagMessage * compressed_message)
+{
+  const auto message_length = bag_message->serialized_data->buffer_length;
+  // Encrypt straight into the payload of the compressed message
+  auto encrypted_data =
+    rosbag2_storage::make_empty_serialized_message(message_length + kEncryptionOverhead);
+  aes_gcm_->seal(
+    nullptr, 0, bag_message->serialized_data->buffer, message_length, encrypted_data->buffer);
+  encrypted_data->buffer_length = message_length + kEncryptionOverhead;
+  compressed_message->serialized_data = std::move(encrypted_data);
+}
+
+std::string AesGcmCompressor::get_compression_identifier() const
+{
+  return kCompressionIdentifier;
+}
+
+bool AesGcmCompressor::encrypts() const
+{
+  return true;
+}
+
+void AesGcmCompressor::set_file_read_throttle(std::function<void(size_t)> throttle)
+{
+  file_read_throttle_ = std::move(throttle);
+}
+}  // namespace rosbag2_compression_aes
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_aes::AesGcmCompressor,
+  rosbag2_compression::BaseCompressorInterface)
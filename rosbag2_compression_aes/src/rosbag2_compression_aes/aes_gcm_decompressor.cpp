@@ -0,0 +1,139 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "encrypted_file.hpp"
+#include "encryption_utils.hpp"
+#include "rosbag2_compression_aes/aes_gcm_decompressor.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression_aes
+{
+AesGcmDecompressor::AesGcmDecompressor()
+: AesGcmDecompressor(load_encryption_key())
+{}
+
+AesGcmDecompressor::AesGcmDecompressor(const EncryptionKey & key)
+: key_(key), aes_gcm_(std::make_unique<AesGcm>(key))
+{}
+
+AesGcmDecompressor::~AesGcmDecompressor() = default;
+
+std::string AesGcmDecompressor::decompress_uri(const std::string & uri)
+{
+  const auto uri_path = rcpputils::fs::path{uri};
+  const auto decompressed_uri = rcpputils::fs::remove_extension(uri_path).string();
+
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  uint8_t header[kEncryptedFileHeaderSize];
+  input.read(reinterpret_cast<char *>(header), sizeof(header));
+  const auto chunk_size = read_uint32(header + sizeof(kEncryptedFileMagic));
+  if (!input || std::memcmp(header, kEncryptedFileMagic, sizeof(kEncryptedFileMagic)) != 0 ||
+    chunk_size == 0)
+  {
+    throw std::runtime_error{"Malformed encrypted file: \"" + uri + "\""};
+  }
+  std::ofstream output(decompressed_uri, std::ios::out | std::ios::binary);
+  if (!output.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary writing! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  std::vector<uint8_t> in_buffer(chunk_size + kEncryptionOverhead);
+  std::vector<uint8_t> out_buffer(chunk_size);
+  bool last = false;
+  for (uint64_t index = 0; !last; ++index) {
+    input.read(
+      reinterpret_cast<char *>(in_buffer.data()), static_cast<std::streamsize>(in_buffer.size()));
+    const auto read_size = size_t(input.gcount());
+    // A file which ends with a full chunk was cut off, it fails with the last flag of its aad
+    last = read_size < in_buffer.size() || input.peek() == std::ifstream::traits_type::eof();
+    const auto aad = make_chunk_aad(index, last);
+    if (!aes_gcm_->open(aad.data(), aad.size(), in_buffer.data(), read_size, out_buffer.data())) {
+      output.close();
+      rcpputils::fs::remove(rcpputils::fs::path{decompressed_uri});
+      std::stringstream errmsg;
+      errmsg << "Chunk " << index << " of encrypted file: \"" << uri <<
+        "\" was modified, cut off or encrypted with another key!";
+
+      throw std::runtime_error{errmsg.str()};
+    }
+    output.write(
+      reinterpret_cast<const char *>(out_buffer.data()),
+      static_cast<std::streamsize>(read_size - kEncryptionOverhead));
+  }
+  output.flush();
+  output.close();
+  input.close();
+  return decompressed_uri;
+}
+
+std::shared_ptr<rosbag2_storage::ReadableFile> AesGcmDecompressor::open_decompressed_uri(
+  const std::string & uri)
+{
+  return EncryptedFile::open(uri, key_);
+}
+
+void AesGcmDecompressor::decompress_serialized_bag_message(
+  rosbag2_storage::SerializedBagMessage * message)
+{
+  const auto encrypted_length = message->serialized_data->buffer_length;
+  if (encrypted_length < kEncryptionOverhead) {
+    throw std::runtime_error{
+            "Encrypted message of topic '" + message->topic_name + "' is truncated"};
+  }
+  // Decrypt into a new payload, the encrypted payload may be a read-only view
+  const auto decrypted_length = encrypted_length - kEncryptionOverhead;
+  auto decrypted_data = rosbag2_storage::make_empty_serialized_message(decrypted_length);
+  if (!aes_gcm_->open(
+      nullptr, 0, message->serialized_data->buffer, encrypted_length, decrypted_data->buffer))
+  {
+    throw std::runtime_error{
+            "Encrypted message of topic '" + message->topic_name +
+            "' was modified or encrypted with another key"};
+  }
+  decrypted_data->buffer_length = decrypted_length;
+  message->serialized_data = std::move(decrypted_data);
+}
+
+std::string AesGcmDecompressor::get_decompression_identifier() const
+{
+  return kDecompressionIdentifier;
+}
+}  // namespace rosbag2_compression_aes
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_aes::AesGcmDecompressor,
+  rosbag2_compression::BaseDecompressorInterface)
@@ -0,0 +1,152 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "encrypted_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_compression_aes
+{
+
+namespace
+{
+[[noreturn]] void throw_malformed(const std::string & uri)
+{
+  throw std::runtime_error{"Malformed encrypted file: \"" + uri + "\""};
+}
+}  // namespace
+
+std::shared_ptr<EncryptedFile> EncryptedFile::open(
+  const std::string & uri, const EncryptionKey & key)
+{
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  input.seekg(0, std::ios::end);
+  const auto file_size = static_cast<uint64_t>(input.tellg());
+  if (file_size < kEncryptedFileHeaderSize) {
+    throw_malformed(uri);
+  }
+  uint8_t header[kEncryptedFileHeaderSize];
+  input.seekg(0);
+  input.read(reinterpret_cast<char *>(header), sizeof(header));
+  const auto chunk_size = read_uint32(header + sizeof(kEncryptedFileMagic));
+  if (!input || std::memcmp(header, kEncryptedFileMagic, sizeof(kEncryptedFileMagic)) != 0 ||
+    chunk_size == 0)
+  {
+    throw_malformed(uri);
+  }
+
+  // All chunks are full but the last one, so the file ends with a shorter one
+  const uint64_t encrypted_chunk_size = uint64_t{chunk_size} + kEncryptionOverhead;
+  const uint64_t encrypted_size = file_size - kEncryptedFileHeaderSize;
+  if (encrypted_size % encrypted_chunk_size < kEncryptionOverhead) {
+    throw_malformed(uri);
+  }
+  const uint64_t chunk_count = encrypted_size / encrypted_chunk_size + 1;
+  const uint64_t size = encrypted_size - chunk_count * kEncryptionOverhead;
+  return std::shared_ptr<EncryptedFile>(
+    new EncryptedFile(uri, std::move(input), key, chunk_size, chunk_count, size));
+}
+
+EncryptedFile::EncryptedFile(
+  const std::string & uri, std::ifstream input, const EncryptionKey & key, uint32_t chunk_size,
+  uint64_t chunk_count, uint64_t size)
+: uri_(uri), chunk_size_(chunk_size), chunk_count_(chunk_count), size_(size),
+  input_(std::move(input)), aes_gcm_(key)
+{}
+
+uint64_t EncryptedFile::size() const
+{
+  return size_;
+}
+
+uint64_t EncryptedFile::read(uint8_t * data, uint64_t offset, uint64_t size)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t end = std::min(offset + size, size_);
+  uint64_t position = offset;
+  while (position < end) {
+    const uint64_t index = position / chunk_size_;
+    const auto & chunk = get_chunk(index);
+    const uint64_t chunk_offset = position - index * chunk_size_;
+    const uint64_t count = std::min<uint64_t>(end - position, chunk.size() - chunk_offset);
+    std::memcpy(data, chunk.data() + chunk_offset, static_cast<size_t>(count));
+    data += count;
+    position += count;
+  }
+  return position > offset ? position - offset : 0;
+}
+
+const std::vector<uint8_t> & EncryptedFile::get_chunk(uint64_t index)
+{
+  for (auto it = chunks_.begin(); it != chunks_.end(); ++it) {
+    if (it->first == index) {
+      chunks_.splice(chunks_.begin(), chunks_, it);
+      return chunks_.front().second;
+    }
+  }
+
+  const bool last = index + 1 == chunk_count_;
+  const uint64_t encrypted_chunk_size = uint64_t{chunk_size_} + kEncryptionOverhead;
+  const uint64_t chunk_size = last ? size_ - index * chunk_size_ : chunk_size_;
+  encrypted_buffer_.resize(static_cast<size_t>(chunk_size + kEncryptionOverhead));
+  input_.seekg(
+    static_cast<std::streamoff>(kEncryptedFileHeaderSize + index * encrypted_chunk_size));
+  input_.read(
+    reinterpret_cast<char *>(encrypted_buffer_.data()),
+    static_cast<std::streamsize>(encrypted_buffer_.size()));
+  if (!input_) {
+    input_.clear();
+    std::stringstream errmsg;
+    errmsg << "Failed to read chunk " << index << " of encrypted file: \"" << uri_ << "\"";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  // Reuse the buffer of the least recently used chunk
+  std::vector<uint8_t> chunk;
+  if (chunks_.size() >= kEncryptedFileChunkCacheSize) {
+    chunk = std::move(chunks_.back().second);
+    chunks_.pop_back();
+  }
+  chunk.resize(static_cast<size_t>(chunk_size));
+  const auto aad = make_chunk_aad(index, last);
+  if (!aes_gcm_.open(
+      aad.data(), aad.size(), encrypted_buffer_.data(), encrypted_buffer_.size(), chunk.data()))
+  {
+    std::stringstream errmsg;
+    errmsg << "Chunk " << index << " of encrypted file: \"" << uri_ <<
+      "\" was modified or encrypted with another key!";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  chunks_.emplace_front(index, std::move(chunk));
+  return chunks_.front().second;
+}
+
+}  // namespace rosbag2_compression_aes
@@ -0,0 +1,79 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_AES__ENCRYPTED_FILE_HPP_
+#define ROSBAG2_COMPRESSION_AES__ENCRYPTED_FILE_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/readable_file.hpp"
+
+#include "encryption_utils.hpp"
+
+namespace rosbag2_compression_aes
+{
+// Number of decrypted chunks an EncryptedFile keeps for following reads.
+constexpr const size_t kEncryptedFileChunkCacheSize = 2;
+
+/**
+ * The decrypted content of a file encrypted by AesGcmCompressor.
+ *
+ * Chunks are decrypted and authenticated when they are read. Reading the last chunk also
+ * detects files which were cut off after a chunk.
+ */
+class EncryptedFile : public rosbag2_storage::ReadableFile
+{
+public:
+  /**
+   * Opens an encrypted file.
+   * \param uri is the path to the file.
+   * \param key is the key the file was encrypted with.
+   * \throws std::runtime_error if the file can't be read or isn't an encrypted file.
+   */
+  static std::shared_ptr<EncryptedFile> open(const std::string & uri, const EncryptionKey & key);
+
+  uint64_t size() const override;
+
+  uint64_t read(uint8_t * data, uint64_t offset, uint64_t size) override;
+
+private:
+  EncryptedFile(
+    const std::string & uri, std::ifstream input, const EncryptionKey & key, uint32_t chunk_size,
+    uint64_t chunk_count, uint64_t size);
+
+  const std::vector<uint8_t> & get_chunk(uint64_t index);
+
+  const std::string uri_;
+  const uint32_t chunk_size_;
+  const uint64_t chunk_count_;
+  const uint64_t size_;
+
+  std::mutex mutex_;
+  std::ifstream input_;
+  AesGcm aes_gcm_;
+  std::vector<uint8_t> encrypted_buffer_;
+  // Decrypted chunks by index, most recently used first
+  std::list<std::pair<uint64_t, std::vector<uint8_t>>> chunks_;
+};
+
+}  // namespace rosbag2_compression_aes
+
+#endif  // ROSBAG2_COMPRESSION_AES__ENCRYPTED_FILE_HPP_
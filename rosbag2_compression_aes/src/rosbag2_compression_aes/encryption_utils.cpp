@@ -0,0 +1,225 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <openssl/err.h>
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "rcpputils/env.hpp"
+
+#include "encryption_utils.hpp"
+
+namespace rosbag2_compression_aes
+{
+
+namespace
+{
+// The EVP interface takes sizes as int, larger data is passed in pieces
+constexpr size_t kMaxUpdateSize = 1 << 30;
+
+void throw_on_openssl_error(int result, const char * operation)
+{
+  if (result != 1) {
+    char error[256];
+    ERR_error_string_n(ERR_get_error(), error, sizeof(error));
+    throw std::runtime_error{std::string("OpenSSL ") + operation + " failed: " + error};
+  }
+}
+
+int hex_digit_value(char digit)
+{
+  if (digit >= '0' && digit <= '9') {
+    return digit - '0';
+  }
+  const auto lower = std::tolower(static_cast<unsigned char>(digit));
+  if (lower >= 'a' && lower <= 'f') {
+    return lower - 'a' + 10;
+  }
+  return -1;
+}
+}  // namespace
+
+EncryptionKey load_encryption_key()
+{
+  const auto key_file = rcpputils::get_env_var(kEncryptionKeyFileVariable);
+  if (key_file.empty()) {
+    throw std::runtime_error{
+            std::string("Set ") + kEncryptionKeyFileVariable +
+            " to the file with the key to encrypt and decrypt bags with!"};
+  }
+  std::ifstream input(key_file);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open key file: \"" << key_file << "\"! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  std::string digits;
+  char character;
+  while (input.get(character)) {
+    if (!std::isspace(static_cast<unsigned char>(character))) {
+      digits.push_back(character);
+    }
+  }
+
+  EncryptionKey key;
+  bool valid = digits.size() == 2 * key.size();
+  for (size_t i = 0; valid && i < key.size(); ++i) {
+    const auto high = hex_digit_value(digits[2 * i]);
+    const auto low = hex_digit_value(digits[2 * i + 1]);
+    valid = high >= 0 && low >= 0;
+    key[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+  if (!valid) {
+    throw std::runtime_error{
+            "Key file: \"" + key_file + "\" does not hold a 256 bit key as 64 hexadecimal digits!"};
+  }
+  return key;
+}
+
+AesGcm::AesGcm(const EncryptionKey & key)
+: encrypt_context_(EVP_CIPHER_CTX_new()), decrypt_context_(EVP_CIPHER_CTX_new())
+{
+  if (encrypt_context_ == nullptr || decrypt_context_ == nullptr) {
+    EVP_CIPHER_CTX_free(encrypt_context_);
+    EVP_CIPHER_CTX_free(decrypt_context_);
+    throw std::runtime_error{"Failed to create OpenSSL cipher contexts"};
+  }
+  try {
+    // The key is expanded once, messages only set their nonce
+    throw_on_openssl_error(
+      EVP_EncryptInit_ex(encrypt_context_, EVP_aes_256_gcm(), nullptr, key.data(), nullptr),
+      "encryption setup");
+    throw_on_openssl_error(
+      EVP_DecryptInit_ex(decrypt_context_, EVP_aes_256_gcm(), nullptr, key.data(), nullptr),
+      "decryption setup");
+    throw_on_openssl_error(RAND_bytes(nonce_base_.data(), kNonceSize), "random nonce");
+  } catch (...) {
+    EVP_CIPHER_CTX_free(encrypt_context_);
+    EVP_CIPHER_CTX_free(decrypt_context_);
+    throw;
+  }
+}
+
+AesGcm::~AesGcm()
+{
+  EVP_CIPHER_CTX_free(encrypt_context_);
+  EVP_CIPHER_CTX_free(decrypt_context_);
+}
+
+void AesGcm::seal(
+  const uint8_t * aad, size_t aad_size, const uint8_t * data, size_t size, uint8_t * output)
+{
+  uint8_t * nonce = output;
+  std::memcpy(nonce, nonce_base_.data(), kNonceSize);
+  for (size_t i = 0; i < sizeof(nonce_counter_); ++i) {
+    nonce[kNonceSize - 1 - i] ^= static_cast<uint8_t>(nonce_counter_ >> (8 * i));
+  }
+  ++nonce_counter_;
+
+  int length = 0;
+  throw_on_openssl_error(
+    EVP_EncryptInit_ex(encrypt_context_, nullptr, nullptr, nullptr, nonce), "encryption");
+  if (aad_size > 0) {
+    throw_on_openssl_error(
+      EVP_EncryptUpdate(encrypt_context_, nullptr, &length, aad, static_cast<int>(aad_size)),
+      "encryption");
+  }
+  uint8_t * encrypted = output + kNonceSize;
+  for (size_t position = 0; position < size; position += kMaxUpdateSize) {
+    const auto piece_size = std::min(size - position, kMaxUpdateSize);
+    throw_on_openssl_error(
+      EVP_EncryptUpdate(
+        encrypt_context_, encrypted + position, &length, data + position,
+        static_cast<int>(piece_size)),
+      "encryption");
+  }
+  // GCM doesn't pad, the final call only completes the tag
+  uint8_t final_block[16];
+  throw_on_openssl_error(
+    EVP_EncryptFinal_ex(encrypt_context_, final_block, &length), "encryption");
+  throw_on_openssl_error(
+    EVP_CIPHER_CTX_ctrl(
+      encrypt_context_, EVP_CTRL_GCM_GET_TAG, static_cast<int>(kTagSize), encrypted + size),
+    "encryption");
+}
+
+bool AesGcm::open(
+  const uint8_t * aad, size_t aad_size, const uint8_t * input, size_t input_size,
+  uint8_t * output)
+{
+  if (input_size < kEncryptionOverhead) {
+    return false;
+  }
+  const uint8_t * nonce = input;
+  const uint8_t * encrypted = input + kNonceSize;
+  const size_t size = input_size - kEncryptionOverhead;
+
+  int length = 0;
+  throw_on_openssl_error(
+    EVP_DecryptInit_ex(decrypt_context_, nullptr, nullptr, nullptr, nonce), "decryption");
+  if (aad_size > 0) {
+    throw_on_openssl_error(
+      EVP_DecryptUpdate(decrypt_context_, nullptr, &length, aad, static_cast<int>(aad_size)),
+      "decryption");
+  }
+  for (size_t position = 0; position < size; position += kMaxUpdateSize) {
+    const auto piece_size = std::min(size - position, kMaxUpdateSize);
+    throw_on_openssl_error(
+      EVP_DecryptUpdate(
+        decrypt_context_, output + position, &length, encrypted + position,
+        static_cast<int>(piece_size)),
+      "decryption");
+  }
+  throw_on_openssl_error(
+    EVP_CIPHER_CTX_ctrl(
+      decrypt_context_, EVP_CTRL_GCM_SET_TAG, static_cast<int>(kTagSize),
+      const_cast<uint8_t *>(encrypted + size)),
+    "decryption");
+  uint8_t final_block[16];
+  return EVP_DecryptFinal_ex(decrypt_context_, final_block, &length) == 1;
+}
+
+std::array<uint8_t, 9> make_chunk_aad(uint64_t index, bool last)
+{
+  std::array<uint8_t, 9> aad;
+  for (size_t i = 0; i < 8; ++i) {
+    aad[i] = static_cast<uint8_t>(index >> (8 * i));
+  }
+  aad[8] = last ? 1 : 0;
+  return aad;
+}
+
+void write_uint32(uint8_t * data, uint32_t value)
+{
+  for (size_t i = 0; i < 4; ++i) {
+    data[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t read_uint32(const uint8_t * data)
+{
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+}  // namespace rosbag2_compression_aes
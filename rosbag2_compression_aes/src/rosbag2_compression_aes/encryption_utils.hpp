@@ -0,0 +1,105 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_AES__ENCRYPTION_UTILS_HPP_
+#define ROSBAG2_COMPRESSION_AES__ENCRYPTION_UTILS_HPP_
+
+#include <openssl/evp.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "rosbag2_compression_aes/encryption_key.hpp"
+
+namespace rosbag2_compression_aes
+{
+// String constant used to identify AesGcmCompressor.
+constexpr const char kCompressionIdentifier[] = "aes_gcm";
+// String constant used to identify AesGcmDecompressor.
+constexpr const char kDecompressionIdentifier[] = "aes_gcm";
+// Environment variable with the path of the file holding the key, as hexadecimal digits.
+constexpr const char kEncryptionKeyFileVariable[] = "ROSBAG2_ENCRYPTION_KEY_FILE";
+constexpr const size_t kNonceSize = 12;
+constexpr const size_t kTagSize = 16;
+// Every encrypted message and chunk is stored with its nonce and its tag.
+constexpr const size_t kEncryptionOverhead = kNonceSize + kTagSize;
+// Files are encrypted in chunks of this size, so that readers decrypt only the chunks they read.
+constexpr const uint32_t kEncryptedFileChunkSize = 1024 * 1024;
+// Encrypted files start with this magic and the chunk size, as little-endian uint32.
+constexpr const char kEncryptedFileMagic[] = {'R', '2', 'A', 'E', 'S', 'G', 'C', 'M'};
+constexpr const size_t kEncryptedFileHeaderSize = sizeof(kEncryptedFileMagic) + 4;
+
+/**
+ * Loads the key of the file named by the ROSBAG2_ENCRYPTION_KEY_FILE environment variable.
+ * \throws std::runtime_error if the variable isn't set or the file doesn't hold 64 hexadecimal
+ *   digits, apart from white space.
+ */
+EncryptionKey load_encryption_key();
+
+/**
+ * AES-256-GCM with one key, through the EVP interface of OpenSSL, which uses AES-NI on x86 and
+ * the cryptography extension on ARMv8 where the CPU has them.
+ * Not thread-safe, every compression or decompression thread has its own.
+ */
+class AesGcm
+{
+public:
+  explicit AesGcm(const EncryptionKey & key);
+
+  ~AesGcm();
+
+  AesGcm(const AesGcm &) = delete;
+  AesGcm & operator=(const AesGcm &) = delete;
+
+  /**
+   * Encrypts data with a nonce which this instance never used before.
+   * \param aad is authenticated with the data without being stored, may be nullptr.
+   * \param output receives the nonce, the encrypted data and the tag, size + kEncryptionOverhead.
+   */
+  void seal(
+    const uint8_t * aad, size_t aad_size, const uint8_t * data, size_t size, uint8_t * output);
+
+  /**
+   * Decrypts data sealed with the same key and aad.
+   * \param input is the output of seal(), of input_size of at least kEncryptionOverhead.
+   * \param output receives input_size - kEncryptionOverhead bytes.
+   * \return false if the data or aad were modified or sealed with another key.
+   */
+  bool open(
+    const uint8_t * aad, size_t aad_size, const uint8_t * input, size_t input_size,
+    uint8_t * output);
+
+private:
+  EVP_CIPHER_CTX * encrypt_context_;
+  EVP_CIPHER_CTX * decrypt_context_;
+  // Nonces are a random base xor'ed with a counter, so that an instance never repeats one and
+  // instances are unlikely to share one
+  std::array<uint8_t, kNonceSize> nonce_base_;
+  uint64_t nonce_counter_ = 0;
+};
+
+/**
+ * Additional authenticated data of a chunk of an encrypted file, which binds the chunk to its
+ * position and marks the last one, so that chunks can't be reordered, dropped or cut off.
+ */
+std::array<uint8_t, 9> make_chunk_aad(uint64_t index, bool last);
+
+void write_uint32(uint8_t * data, uint32_t value);
+
+uint32_t read_uint32(const uint8_t * data);
+
+}  // namespace rosbag2_compression_aes
+
+#endif  // ROSBAG2_COMPRESSION_AES__ENCRYPTION_UTILS_HPP_
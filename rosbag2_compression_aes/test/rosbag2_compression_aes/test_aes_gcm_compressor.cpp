@@ -0,0 +1,153 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_compression_aes/aes_gcm_compressor.hpp"
+#include "rosbag2_compression_aes/aes_gcm_decompressor.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "gmock/gmock.h"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+namespace
+{
+rosbag2_compression_aes::EncryptionKey make_key(uint8_t seed)
+{
+  rosbag2_compression_aes::EncryptionKey key;
+  for (size_t i = 0; i < key.size(); ++i) {
+    key[i] = static_cast<uint8_t>(seed + i);
+  }
+  return key;
+}
+
+std::vector<uint8_t> make_data(size_t size)
+{
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return data;
+}
+
+void write_file(const std::string & uri, const std::vector<uint8_t> & data)
+{
+  std::ofstream output(uri, std::ios::out | std::ios::binary);
+  output.write(
+    reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::vector<uint8_t> read_file(const std::string & uri)
+{
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), {});
+}
+}  // namespace
+
+class AesGcmCompressorTest : public TemporaryDirectoryFixture
+{
+public:
+  std::string file_path(const std::string & name) const
+  {
+    return (rcpputils::fs::path(temporary_dir_path_) / name).string();
+  }
+
+  rosbag2_compression_aes::AesGcmCompressor compressor_{make_key(1)};
+  rosbag2_compression_aes::AesGcmDecompressor decompressor_{make_key(1)};
+};
+
+TEST_F(AesGcmCompressorTest, message_roundtrip_and_tamper_detection) {
+  const auto data = make_data(1000);
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = "/topic";
+  message.serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  rosbag2_storage::SerializedBagMessage encrypted = message;
+  compressor_.compress_serialized_bag_message(&message, &encrypted);
+  ASSERT_EQ(encrypted.serialized_data->buffer_length, data.size() + 28u);
+  EXPECT_NE(std::memcmp(encrypted.serialized_data->buffer + 12, data.data(), data.size()), 0);
+
+  // Nonces are never reused, the same message encrypts differently
+  rosbag2_storage::SerializedBagMessage encrypted_again = message;
+  compressor_.compress_serialized_bag_message(&message, &encrypted_again);
+  EXPECT_NE(
+    std::memcmp(
+      encrypted.serialized_data->buffer, encrypted_again.serialized_data->buffer,
+      encrypted.serialized_data->buffer_length), 0);
+
+  auto tampered = encrypted;
+  tampered.serialized_data = rosbag2_storage::make_serialized_message(
+    encrypted.serialized_data->buffer, encrypted.serialized_data->buffer_length);
+  tampered.serialized_data->buffer[20] ^= 1;
+
+  decompressor_.decompress_serialized_bag_message(&encrypted);
+  ASSERT_EQ(encrypted.serialized_data->buffer_length, data.size());
+  EXPECT_EQ(std::memcmp(encrypted.serialized_data->buffer, data.data(), data.size()), 0);
+  EXPECT_THROW(decompressor_.decompress_serialized_bag_message(&tampered), std::runtime_error);
+
+  rosbag2_compression_aes::AesGcmDecompressor other_key_decompressor{make_key(2)};
+  EXPECT_THROW(
+    other_key_decompressor.decompress_serialized_bag_message(&encrypted_again),
+    std::runtime_error);
+}
+
+TEST_F(AesGcmCompressorTest, file_roundtrip_with_random_access) {
+  // Two full chunks and part of a third one
+  const auto data = make_data(2 * 1024 * 1024 + 12345);
+  const auto uri = file_path("bag_0.mcap");
+  write_file(uri, data);
+
+  const auto encrypted_uri = compressor_.compress_uri(uri);
+  EXPECT_EQ(encrypted_uri, uri + ".aes_gcm");
+
+  auto readable_file = decompressor_.open_decompressed_uri(encrypted_uri);
+  ASSERT_NE(readable_file, nullptr);
+  EXPECT_EQ(readable_file->size(), data.size());
+  std::vector<uint8_t> range(5000);
+  const uint64_t offset = 1024 * 1024 - 2000;
+  ASSERT_EQ(readable_file->read(range.data(), offset, range.size()), range.size());
+  EXPECT_EQ(std::memcmp(range.data(), data.data() + offset, range.size()), 0);
+  EXPECT_EQ(readable_file->read(range.data(), data.size() - 10, range.size()), 10u);
+
+  rcpputils::fs::remove(rcpputils::fs::path{uri});
+  EXPECT_EQ(decompressor_.decompress_uri(encrypted_uri), uri);
+  EXPECT_EQ(read_file(uri), data);
+}
+
+TEST_F(AesGcmCompressorTest, file_cut_after_a_chunk_is_detected) {
+  const auto data = make_data(1024 * 1024 + 100);
+  const auto uri = file_path("bag_0.mcap");
+  write_file(uri, data);
+  const auto encrypted_uri = compressor_.compress_uri(uri);
+
+  // Header and the first full chunk only
+  auto encrypted = read_file(encrypted_uri);
+  encrypted.resize(12 + 1024 * 1024 + 28);
+  write_file(encrypted_uri, encrypted);
+
+  EXPECT_THROW(decompressor_.decompress_uri(encrypted_uri), std::runtime_error);
+  EXPECT_THROW(decompressor_.open_decompressed_uri(encrypted_uri), std::runtime_error);
+}
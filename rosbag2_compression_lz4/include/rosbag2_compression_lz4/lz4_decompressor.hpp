@@ -0,0 +1,58 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
+#define ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
+
+#include <lz4frame.h>
+
+#include <string>
+
+#include "rosbag2_compression/base_decompressor_interface.hpp"
+
+#include "rosbag2_compression_lz4/visibility_control.hpp"
+
+namespace rosbag2_compression_lz4
+{
+
+/**
+ * A BaseDecompressorInterface that decompresses bagfiles and messages stored as LZ4 frames.
+ */
+class ROSBAG2_COMPRESSION_LZ4_PUBLIC Lz4Decompressor
+  : public rosbag2_compression::BaseDecompressorInterface
+{
+public:
+  Lz4Decompressor();
+
+  ~Lz4Decompressor() override;
+
+  std::string decompress_uri(const std::string & uri) override;
+
+  /**
+   * Decompresses a message compressed by Lz4Compressor.
+   *
+   * \throws std::runtime_error if the message is not a single LZ4 frame with its content size.
+   */
+  void decompress_serialized_bag_message(
+    rosbag2_storage::SerializedBagMessage * bag_message) override;
+
+  std::string get_decompression_identifier() const override;
+
+private:
+  LZ4F_dctx * lz4_context_;
+};
+
+}  // namespace rosbag2_compression_lz4
+
+#endif  // ROSBAG2_COMPRESSION_LZ4__LZ4_DECOMPRESSOR_HPP_
@@ -0,0 +1,66 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compression_utils.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace rosbag2_compression_lz4
+{
+
+LZ4F_preferences_t make_lz4_preferences(
+  unsigned long long content_size,  // NOLINT
+  int compression_level)
+{
+  LZ4F_preferences_t preferences;
+  std::memset(&preferences, 0, sizeof(preferences));
+  preferences.frameInfo.blockSizeID = LZ4F_max64KB;
+  preferences.frameInfo.blockMode = LZ4F_blockLinked;
+  // Checksums are not needed to decompress and would only add to the time to record
+  preferences.frameInfo.contentChecksumFlag = LZ4F_noContentChecksum;
+  preferences.frameInfo.blockChecksumFlag = LZ4F_noBlockChecksum;
+  preferences.frameInfo.contentSize = content_size;
+  preferences.compressionLevel = compression_level;
+  return preferences;
+}
+
+void throw_on_lz4_error(const size_t result)
+{
+  if (LZ4F_isError(result)) {
+    std::stringstream error;
+    error << "LZ4 error: " << LZ4F_getErrorName(result);
+
+    throw std::runtime_error{error.str()};
+  }
+}
+
+void print_compression_statistics(
+  const std::chrono::high_resolution_clock::time_point start,
+  const std::chrono::high_resolution_clock::time_point end,
+  const size_t decompressed_size,
+  const size_t compressed_size)
+{
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+  const auto decompression_ratio =
+    static_cast<double>(decompressed_size) / static_cast<double>(compressed_size);
+
+  ROSBAG2_COMPRESSION_LZ4_LOG_DEBUG_STREAM(
+    "\"Compression statistics\" : {" <<
+      "\"Time\" : " << (duration.count() / 1000.0) <<
+      ", \"Compression Ratio\" : " << decompression_ratio <<
+      "}");
+}
+}  // namespace rosbag2_compression_lz4
@@ -0,0 +1,73 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
+#define ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
+
+#include <lz4frame.h>
+
+#include <chrono>
+#include <cstddef>
+
+#include "logging.hpp"
+
+namespace rosbag2_compression_lz4
+{
+// Compression level of the frames. 0 is the default fast mode of LZ4, negative levels are
+// faster, levels of 3 and above switch to LZ4HC, which compresses several times slower.
+constexpr const int kDefaultLz4CompressionLevel = 0;
+// Size of the chunks files are read and written in while they are (de)compressed.
+constexpr const size_t kLz4FileChunkSize = 64 * 1024;
+// String constant used to identify Lz4Compressor.
+constexpr const char kCompressionIdentifier[] = "lz4";
+// String constant used to identify Lz4Decompressor.
+constexpr const char kDecompressionIdentifier[] = "lz4";
+
+/**
+ * Returns the preferences frames are compressed with.
+ * \param content_size is the size of the uncompressed content, stored in the frame header.
+ *   0 if it is not known before the frame is compressed, like for files.
+ * \param compression_level is the compression level of the frame.
+ */
+LZ4F_preferences_t make_lz4_preferences(
+  unsigned long long content_size,  // NOLINT
+  int compression_level = kDefaultLz4CompressionLevel);
+
+/**
+ * Checks result and throws a runtime_error if there was an LZ4 error.
+ * \param result is the return value of a LZ4F_* function.
+ */
+void throw_on_lz4_error(const size_t result);
+
+/**
+ * Prints compression statistics to the debug log stream.
+ * The log statement is formatted as JSON.
+ * Time is formatted as a decimal of seconds.
+ *
+ * Example:
+ *  "Compression statistics" : {"Time" : 1.2, "Compression Ratio" : 0.5}
+ *
+ * \param start is the time_point when compression or decompression started.
+ * \param end is the time_point when compression or decompression ended.
+ * \param decompressed_size is the decompressed data size
+ * \param compressed_size is the compressed data size
+ */
+void print_compression_statistics(
+  const std::chrono::high_resolution_clock::time_point start,
+  const std::chrono::high_resolution_clock::time_point end,
+  const size_t decompressed_size,
+  const size_t compressed_size);
+}  // namespace rosbag2_compression_lz4
+
+#endif  // ROSBAG2_COMPRESSION_LZ4__COMPRESSION_UTILS_HPP_
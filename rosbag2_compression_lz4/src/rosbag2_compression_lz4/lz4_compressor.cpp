@@ -0,0 +1,166 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compression_utils.hpp"
+#include "rosbag2_compression_lz4/lz4_compressor.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression_lz4
+{
+Lz4Compressor::Lz4Compressor()
+: compression_level_(kDefaultLz4CompressionLevel)
+{
+  // The context is reused for every file and message, like the context of the zstd compressor
+  throw_on_lz4_error(LZ4F_createCompressionContext(&lz4_context_, LZ4F_VERSION));
+}
+
+Lz4Compressor::~Lz4Compressor()
+{
+  LZ4F_freeCompressionContext(lz4_context_);
+}
+
+std::string Lz4Compressor::compress_uri(const std::string & uri)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto compressed_uri = uri + "." + get_compression_identifier();
+
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  std::ofstream output(compressed_uri, std::ios::out | std::ios::binary);
+  if (!output.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary writing! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  // The file is compressed into a single frame, streamed in chunks
+  const auto preferences = make_lz4_preferences(0);
+  std::vector<char> in_buffer(kLz4FileChunkSize);
+  // Large enough for the header, any chunk and the end of the frame
+  std::vector<char> out_buffer(
+    std::max<size_t>(LZ4F_HEADER_SIZE_MAX, LZ4F_compressBound(kLz4FileChunkSize, &preferences)));
+  size_t total_size = 0;
+  size_t decompressed_size = 0;
+
+  auto size = LZ4F_compressBegin(
+    lz4_context_, out_buffer.data(), out_buffer.size(), &preferences);
+  throw_on_lz4_error(size);
+  output.write(out_buffer.data(), static_cast<std::streamsize>(size));
+  total_size += size;
+  do {
+    if (file_read_throttle_) {
+      file_read_throttle_(in_buffer.size());
+    }
+    input.read(in_buffer.data(), static_cast<std::streamsize>(in_buffer.size()));
+    const auto read_size = size_t(input.gcount());
+    if (read_size > 0) {
+      size = LZ4F_compressUpdate(
+        lz4_context_, out_buffer.data(), out_buffer.size(), in_buffer.data(), read_size, nullptr);
+      throw_on_lz4_error(size);
+      output.write(out_buffer.data(), static_cast<std::streamsize>(size));
+      total_size += size;
+      decompressed_size += read_size;
+    }
+  } while (!input.eof());
+  size = LZ4F_compressEnd(lz4_context_, out_buffer.data(), out_buffer.size(), nullptr);
+  throw_on_lz4_error(size);
+  output.write(out_buffer.data(), static_cast<std::streamsize>(size));
+  total_size += size;
+  output.flush();
+  output.close();
+  input.close();
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, decompressed_size, total_size);
+  return compressed_uri;
+}
+
+void Lz4Compressor::compress_serialized_bag_message(
+  const rosbag2_storage::SerializedBagMessage * bag_message,
+  rosbag2_storage::SerializedBagMessage * compressed_message)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto message_length = bag_message->serialized_data->buffer_length;
+  // The frame header carries the size of the message, so that it is decompressed in one go
+  const auto preferences = make_lz4_preferences(message_length, compression_level_);
+  // Bound of the header and of the compressed blocks with the end of the frame
+  const auto maximum_compressed_length =
+    LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(message_length, &preferences);
+  if (compression_buffer_.size() < maximum_compressed_length) {
+    compression_buffer_.resize(maximum_compressed_length);
+  }
+
+  // Compresses with the context, LZ4F_compressFrame() would allocate a new one for every message
+  auto compression_result = LZ4F_compressBegin(
+    lz4_context_, compression_buffer_.data(), compression_buffer_.size(), &preferences);
+  throw_on_lz4_error(compression_result);
+  auto size = LZ4F_compressUpdate(
+    lz4_context_,
+    compression_buffer_.data() + compression_result,
+    compression_buffer_.size() - compression_result,
+    bag_message->serialized_data->buffer, message_length, nullptr);
+  throw_on_lz4_error(size);
+  compression_result += size;
+  size = LZ4F_compressEnd(
+    lz4_context_,
+    compression_buffer_.data() + compression_result,
+    compression_buffer_.size() - compression_result, nullptr);
+  throw_on_lz4_error(size);
+  compression_result += size;
+
+  compressed_message->serialized_data =
+    rosbag2_storage::make_serialized_message(compression_buffer_.data(), compression_result);
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, message_length, compression_result);
+}
+
+std::string Lz4Compressor::get_compression_identifier() const
+{
+  return kCompressionIdentifier;
+}
+
+void Lz4Compressor::set_compression_level(int32_t level)
+{
+  compression_level_ = level;
+}
+
+void Lz4Compressor::set_file_read_throttle(std::function<void(size_t)> throttle)
+{
+  file_read_throttle_ = std::move(throttle);
+}
+}  // namespace rosbag2_compression_lz4
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_lz4::Lz4Compressor,
+  rosbag2_compression::BaseCompressorInterface)
@@ -0,0 +1,155 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "compression_utils.hpp"
+#include "rosbag2_compression_lz4/lz4_decompressor.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_compression_lz4
+{
+Lz4Decompressor::Lz4Decompressor()
+{
+  throw_on_lz4_error(LZ4F_createDecompressionContext(&lz4_context_, LZ4F_VERSION));
+}
+
+Lz4Decompressor::~Lz4Decompressor()
+{
+  LZ4F_freeDecompressionContext(lz4_context_);
+}
+
+std::string Lz4Decompressor::decompress_uri(const std::string & uri)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto uri_path = rcpputils::fs::path{uri};
+  const auto decompressed_uri = rcpputils::fs::remove_extension(uri_path).string();
+
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  std::ofstream output(decompressed_uri, std::ios::out | std::ios::binary);
+  if (!output.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary writing! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  // A context which failed in the middle of a frame must not continue with the next file
+  LZ4F_resetDecompressionContext(lz4_context_);
+  std::vector<char> in_buffer(kLz4FileChunkSize);
+  std::vector<char> out_buffer(kLz4FileChunkSize);
+  size_t total_size = 0;
+  size_t compressed_size = 0;
+  // Hint of the bytes left in the current frame, 0 once it ended
+  size_t remaining = 1;
+  do {
+    input.read(in_buffer.data(), static_cast<std::streamsize>(in_buffer.size()));
+    const auto size = size_t(input.gcount());
+    compressed_size += size;
+    size_t position = 0;
+    while (position < size) {
+      size_t in_size = size - position;
+      size_t out_size = out_buffer.size();
+      remaining = LZ4F_decompress(
+        lz4_context_, out_buffer.data(), &out_size, in_buffer.data() + position, &in_size,
+        nullptr);
+      throw_on_lz4_error(remaining);
+      output.write(out_buffer.data(), static_cast<std::streamsize>(out_size));
+      total_size += out_size;
+      position += in_size;
+    }
+  } while (!input.eof());
+  output.flush();
+  output.close();
+  input.close();
+  if (remaining != 0) {
+    std::stringstream errmsg;
+    errmsg << "LZ4 compressed file: \"" << uri << "\" is truncated!";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, total_size, compressed_size);
+
+  return decompressed_uri;
+}
+
+void Lz4Decompressor::decompress_serialized_bag_message(
+  rosbag2_storage::SerializedBagMessage * message)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto compressed_buffer_length = message->serialized_data->buffer_length;
+
+  LZ4F_resetDecompressionContext(lz4_context_);
+  LZ4F_frameInfo_t frame_info;
+  size_t header_length = compressed_buffer_length;
+  throw_on_lz4_error(
+    LZ4F_getFrameInfo(
+      lz4_context_, &frame_info, message->serialized_data->buffer, &header_length));
+
+  // Decompress straight into the new payload of the message instead of copying it over, the
+  // compressed payload may be a read-only view which can't be resized anyway
+  const auto decompressed_buffer_length = static_cast<size_t>(frame_info.contentSize);
+  auto decompressed_data =
+    rosbag2_storage::make_empty_serialized_message(decompressed_buffer_length);
+
+  size_t decompressed_length = decompressed_buffer_length;
+  size_t remaining_length = compressed_buffer_length - header_length;
+  const auto remaining = LZ4F_decompress(
+    lz4_context_,
+    decompressed_data->buffer, &decompressed_length,
+    message->serialized_data->buffer + header_length, &remaining_length,
+    nullptr);
+  throw_on_lz4_error(remaining);
+  // Frames of empty messages don't carry a content size, like the ones of other compressors
+  if (remaining != 0 || decompressed_length != decompressed_buffer_length) {
+    throw std::runtime_error{
+            "LZ4 frame of message of topic '" + message->topic_name +
+            "' is truncated or does not carry its content size"};
+  }
+
+  decompressed_data->buffer_length = decompressed_length;
+  message->serialized_data = std::move(decompressed_data);
+
+  const auto end = std::chrono::high_resolution_clock::now();
+  print_compression_statistics(start, end, decompressed_length, compressed_buffer_length);
+}
+
+std::string Lz4Decompressor::get_decompression_identifier() const
+{
+  return kDecompressionIdentifier;
+}
+}  // namespace rosbag2_compression_lz4
+
+#include "pluginlib/class_list_macros.hpp"  // NOLINT
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_compression_lz4::Lz4Decompressor,
+  rosbag2_compression::BaseDecompressorInterface)
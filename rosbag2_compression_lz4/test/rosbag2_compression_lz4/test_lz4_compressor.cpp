@@ -0,0 +1,236 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <lz4frame.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_compression_lz4/lz4_compressor.hpp"
+#include "rosbag2_compression_lz4/lz4_decompressor.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "gmock/gmock.h"
+
+namespace
+{
+constexpr const char kGarbageStatement[] = "garbage";
+constexpr const int kDefaultGarbageFileSize = 10;  // MiB
+// Bit of the FLG byte of the frame header, after the 4 byte magic number
+constexpr const uint8_t kContentChecksumFlag = 1 << 2;
+
+/**
+ * Writes 1M * size garbage data to a stream.
+ * \param out The stream to write to.
+ * \param size The number of times to write.
+ */
+void write_garbage_stream(std::ostream & out, int size = kDefaultGarbageFileSize)
+{
+  const auto output_size = size * 1024 * 1024;
+  const auto num_iterations = output_size / static_cast<int>(strlen(kGarbageStatement));
+
+  for (int i = 0; i < num_iterations; i++) {
+    out << kGarbageStatement;
+  }
+}
+
+void create_garbage_file(const std::string & uri, int size = kDefaultGarbageFileSize)
+{
+  auto out = std::ofstream{uri};
+  out.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+  write_garbage_stream(out, size);
+}
+
+std::vector<char> read_file(const std::string & uri)
+{
+  auto infile = std::ifstream{uri, std::ios_base::binary | std::ios::ate};
+  infile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+  const auto file_size = infile.tellg();
+  auto contents = std::vector<char>(file_size);
+
+  infile.seekg(0, std::ios_base::beg);
+  infile.read(contents.data(), file_size);
+
+  return contents;
+}
+
+std::string payload_of(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+
+std::unique_ptr<rosbag2_storage::SerializedBagMessage> make_message(const std::string & payload)
+{
+  auto message = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "/topic";
+  message->serialized_data =
+    rosbag2_storage::make_serialized_message(payload.data(), payload.size());
+  return message;
+}
+}  // namespace
+
+class Lz4CompressionFixture : public rosbag2_test_common::TemporaryDirectoryFixture
+{
+protected:
+  Lz4CompressionFixture() = default;
+};
+
+TEST_F(Lz4CompressionFixture, lz4_compress_and_decompress_file_uri)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file1.txt").string();
+  create_garbage_file(uri);
+  const auto initial_data = read_file(uri);
+
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri);
+
+  EXPECT_EQ(compressed_uri, uri + ".lz4");
+  ASSERT_TRUE(rcpputils::fs::exists(compressed_uri)) <<
+    "Expected compressed URI: \"" << compressed_uri << "\" to exist.";
+  const auto compressed_data = read_file(compressed_uri);
+  EXPECT_LT(compressed_data.size(), initial_data.size());
+  ASSERT_GT(compressed_data.size(), 4u);
+  EXPECT_EQ(static_cast<uint8_t>(compressed_data[4]) & kContentChecksumFlag, 0);
+
+  ASSERT_EQ(0, std::remove(uri.c_str())) <<
+    "Removal of initial file: \"" << uri << "\" failed!";
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  const auto decompressed_uri = decompressor.decompress_uri(compressed_uri);
+
+  EXPECT_EQ(decompressed_uri, uri);
+  EXPECT_EQ(read_file(decompressed_uri), initial_data);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_bad_file)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file2.txt").string();
+  create_garbage_file(uri, 1);
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_THROW(decompressor.decompress_uri(uri), std::runtime_error);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_bad_uri)
+{
+  const auto bad_uri = (rcpputils::fs::path(temporary_dir_path_) / "bad_uri.txt").string();
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+
+  EXPECT_THROW(decompressor.decompress_uri(bad_uri), std::runtime_error);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_truncated_file)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
+  create_garbage_file(uri, 1);
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  const auto compressed_uri = compressor.compress_uri(uri);
+
+  auto compressed_data = read_file(compressed_uri);
+  compressed_data.resize(compressed_data.size() / 2);
+  {
+    std::ofstream out(compressed_uri, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(compressed_data.data(), static_cast<std::streamsize>(compressed_data.size()));
+  }
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_THROW(decompressor.decompress_uri(compressed_uri), std::runtime_error);
+}
+
+TEST_F(Lz4CompressionFixture, lz4_compress_and_decompress_serialized_bag_messages)
+{
+  std::stringstream garbage;
+  write_garbage_stream(garbage, 1);
+  const std::vector<std::string> payloads = {garbage.str(), "short", "", garbage.str()};
+
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  for (const auto & payload : payloads) {
+    const auto message = make_message(payload);
+    auto compressed_message = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    compressed_message->topic_name = message->topic_name;
+    compressor.compress_serialized_bag_message(message.get(), compressed_message.get());
+
+    ASSERT_GT(compressed_message->serialized_data->buffer_length, 4u);
+    EXPECT_EQ(compressed_message->serialized_data->buffer[4] & kContentChecksumFlag, 0);
+    if (payload.size() > 1024) {
+      EXPECT_LT(compressed_message->serialized_data->buffer_length, payload.size() / 10);
+    }
+
+    decompressor.decompress_serialized_bag_message(compressed_message.get());
+    EXPECT_EQ(payload_of(*compressed_message), payload);
+  }
+}
+
+TEST_F(Lz4CompressionFixture, lz4_decompress_fails_on_truncated_message)
+{
+  std::stringstream garbage;
+  write_garbage_stream(garbage, 1);
+  const auto message = make_message(garbage.str());
+  auto compressed_message = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  compressor.compress_serialized_bag_message(message.get(), compressed_message.get());
+  compressed_message->serialized_data->buffer_length /= 2;
+
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  EXPECT_THROW(
+    decompressor.decompress_serialized_bag_message(compressed_message.get()),
+    std::runtime_error);
+
+  // The context recovers for the next message
+  const auto next_message = make_message("next");
+  compressor.compress_serialized_bag_message(next_message.get(), compressed_message.get());
+  decompressor.decompress_serialized_bag_message(compressed_message.get());
+  EXPECT_EQ(payload_of(*compressed_message), "next");
+}
+
+TEST_F(Lz4CompressionFixture, lz4_compresses_messages_with_the_set_compression_level)
+{
+  // Text which compresses differently at different levels, unlike the repeated garbage
+  std::mt19937 generator(42);
+  std::string payload;
+  const std::vector<std::string> words = {"stamp ", "frame_id ", "odom ", "base_link ", "42 "};
+  while (payload.size() < 100000) {
+    payload += words[generator() % words.size()];
+  }
+  const auto message = make_message(payload);
+
+  rosbag2_compression_lz4::Lz4Compressor compressor;
+  rosbag2_compression_lz4::Lz4Decompressor decompressor;
+  std::vector<size_t> compressed_lengths;
+  for (const int32_t level : {-5, 9}) {
+    compressor.set_compression_level(level);
+    auto compressed_message = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    compressor.compress_serialized_bag_message(message.get(), compressed_message.get());
+    compressed_lengths.push_back(compressed_message->serialized_data->buffer_length);
+    decompressor.decompress_serialized_bag_message(compressed_message.get());
+    EXPECT_EQ(payload_of(*compressed_message), payload);
+  }
+  EXPECT_GT(compressed_lengths[0], compressed_lengths[1]);
+}
@@ -17,11 +17,15 @@
 
 #include <zstd.h>
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "rosbag2_compression/base_compressor_interface.hpp"
 
@@ -49,8 +53,69 @@ public:
 
   std::string get_compression_identifier() const override;
 
+  /**
+   * Compresses messages with a dictionary loaded from dictionary_path, or with one dictionary
+   * per topic trained from the first training_messages messages of the topic.
+   * Messages compressed before the dictionary of their topic was trained are compressed without.
+   *
+   * \throws std::invalid_argument if dictionary_path is not a zstd dictionary.
+   */
+  void configure_dictionaries(
+    uint64_t training_messages, const std::string & dictionary_path) override;
+
+  std::vector<std::vector<uint8_t>> get_dictionaries() const override;
+
+  /**
+   * Sets the level of messages compressed without a dictionary.
+   * Dictionaries are created with the default level and keep it.
+   */
+  void set_compression_level(int32_t level) override;
+
+  /**
+   * Sets the number of zstd worker threads files are compressed with. Each frame of the seekable
+   * format is split into jobs for them. Ignored with a warning if zstd was built without
+   * multithreading support.
+   */
+  void set_file_compression_workers(uint64_t workers) override;
+
+  /// Called with the size of every frame of the seekable format before it is compressed.
+  void set_file_read_throttle(std::function<void(size_t)> throttle) override;
+
 private:
+  struct TopicDictionary
+  {
+    // Concatenated messages the dictionary is trained from
+    std::vector<uint8_t> samples;
+    std::vector<size_t> sample_sizes;
+    bool trained = false;
+    ZSTD_CDict * dictionary = nullptr;
+  };
+
+  // Sets the parameters of the context for compressing messages, which stick between messages
+  void set_message_parameters();
+
+  // Sets the parameters of the context for compressing a file
+  void set_file_parameters();
+
+  // Returns the dictionary to compress a message with, nullptr if there is none (yet)
+  ZSTD_CDict * get_dictionary(const rosbag2_storage::SerializedBagMessage & bag_message);
+
+  // Adds a compressed message to the samples of its topic and trains once there are enough
+  void add_training_sample(const rosbag2_storage::SerializedBagMessage & bag_message);
+
+  void train_dictionary(const std::string & topic_name, TopicDictionary & topic_dictionary);
+
   ZSTD_CCtx * zstd_context_;
+  int compression_level_;
+  uint64_t file_compression_workers_ = 0;
+  std::function<void(size_t)> file_read_throttle_;
+  // Output of message compression, grows to the largest compression bound so far
+  std::vector<uint8_t> compression_buffer_;
+  uint64_t training_messages_ = 0;
+  ZSTD_CDict * loaded_dictionary_ = nullptr;
+  std::unordered_map<std::string, TopicDictionary> topic_dictionaries_;
+  // Every dictionary used so far, loaded or trained
+  std::vector<std::vector<uint8_t>> dictionaries_;
 };
 
 }  // namespace rosbag2_compression_zstd
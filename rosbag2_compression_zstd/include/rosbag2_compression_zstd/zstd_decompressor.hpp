@@ -17,11 +17,14 @@
 
 #include <zstd.h>
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "rosbag2_compression/base_decompressor_interface.hpp"
 
@@ -43,13 +46,31 @@ public:
 
   std::string decompress_uri(const std::string & uri) override;
 
+  /**
+   * Opens files compressed in the zstd seekable format, which are decompressed in frames of
+   * a few MiB as they are read.
+   *
+   * eturn nullptr for files written without a seek table.
+   */
+  std::shared_ptr<rosbag2_storage::ReadableFile> open_decompressed_uri(
+    const std::string & uri) override;
+
   void decompress_serialized_bag_message(
     rosbag2_storage::SerializedBagMessage * bag_message) override;
 
   std::string get_decompression_identifier() const override;
 
+  /**
+   * Adds a dictionary, which is used for the frames carrying its ID.
+   *
+   * \throws std::runtime_error if dictionary is not a zstd dictionary.
+   */
+  void add_dictionary(const std::vector<uint8_t> & dictionary) override;
+
 private:
   ZSTD_DCtx * zstd_context_;
+  // By dictionary ID
+  std::unordered_map<unsigned, ZSTD_DDict *> dictionaries_;
 };
 
 }  // namespace rosbag2_compression_zstd
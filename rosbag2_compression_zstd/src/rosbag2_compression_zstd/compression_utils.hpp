@@ -33,6 +33,15 @@ namespace rosbag2_compression_zstd
 //   - Decrease the size of the compressed data
 // Setting to zero uses Zstd's default value of 3.
 constexpr const int kDefaultZstdCompressionLevel = 1;
+// Maximum size of a trained dictionary, the default of the zstd command line tool.
+constexpr const size_t kMaxZstdDictionarySize = 112640;
+// Minimum size of a trained dictionary.
+constexpr const size_t kMinZstdDictionarySize = 1024;
+// Training stops collecting messages of a topic at this size, even if there are fewer messages
+// than requested.
+constexpr const size_t kMaxZstdTrainingSamplesSize = 100 * kMaxZstdDictionarySize;
+// Smallest job zstd splits its input into for worker threads, ZSTDMT_JOBSIZE_MIN of zstd.
+constexpr const size_t kMinZstdJobSize = 512 * 1024;
 // String constant used to identify ZstdCompressor.
 constexpr const char kCompressionIdentifier[] = "zstd";
 // String constant used to identify ZstdDecompressor.
@@ -0,0 +1,141 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace rosbag2_compression_zstd
+{
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string & uri)
+{
+  file_ = CreateFileA(
+    uri.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    file_ = nullptr;
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri << "\" for binary reading! error(" <<
+      GetLastError() << ")";
+    throw std::runtime_error{errmsg.str()};
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_, &file_size)) {
+    CloseHandle(file_);
+    throw std::runtime_error{"Failed to get the size of file: \"" + uri + "\""};
+  }
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  // Empty files can't be mapped
+  if (size_ == 0) {
+    return;
+  }
+  mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ != nullptr) {
+    data_ = static_cast<const uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (data_ == nullptr) {
+    std::stringstream errmsg;
+    errmsg << "Failed to map file: \"" << uri << "\"! error(" << GetLastError() << ")";
+    if (mapping_ != nullptr) {
+      CloseHandle(mapping_);
+    }
+    CloseHandle(file_);
+    throw std::runtime_error{errmsg.str()};
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+}
+#else
+MappedFile::MappedFile(const std::string & uri)
+{
+  const int fd = ::open(uri.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri << "\" for binary reading! errno(" << errno << ")";
+    throw std::runtime_error{errmsg.str()};
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+    static_cast<uint64_t>(file_stat.st_size) > std::numeric_limits<size_t>::max())
+  {
+    ::close(fd);
+    throw std::runtime_error{"Failed to get the size of file: \"" + uri + "\""};
+  }
+  size_ = static_cast<size_t>(file_stat.st_size);
+  // Empty files can't be mapped
+  if (size_ == 0) {
+    ::close(fd);
+    return;
+  }
+  void * data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  const int map_errno = errno;
+  // The mapping keeps the file referenced
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    std::stringstream errmsg;
+    errmsg << "Failed to map file: \"" << uri << "\"! " << std::strerror(map_errno);
+    throw std::runtime_error{errmsg.str()};
+  }
+  // Only a hint, the file is read either way
+  (void)madvise(data, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8_t *>(data);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+}
+#endif
+
+const uint8_t * MappedFile::data() const
+{
+  return data_;
+}
+
+size_t MappedFile::size() const
+{
+  return size_;
+}
+
+}  // namespace rosbag2_compression_zstd
@@ -0,0 +1,61 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_COMPRESSION_ZSTD__MAPPED_FILE_HPP_
+#define ROSBAG2_COMPRESSION_ZSTD__MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rosbag2_compression_zstd
+{
+
+/**
+ * A file mapped into memory for reading, so that it is compressed without being copied into
+ * buffers first. The pages are read ahead sequentially where the system supports it.
+ */
+class MappedFile
+{
+public:
+  /**
+   * Maps a file.
+   * \param uri is the path to the file.
+   * \throws std::runtime_error if the file can't be opened or mapped.
+   */
+  explicit MappedFile(const std::string & uri);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  /// \return The content of the file, nullptr if it is empty.
+  const uint8_t * data() const;
+
+  size_t size() const;
+
+private:
+  const uint8_t * data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void * file_ = nullptr;
+  void * mapping_ = nullptr;
+#endif
+};
+
+}  // namespace rosbag2_compression_zstd
+
+#endif  // ROSBAG2_COMPRESSION_ZSTD__MAPPED_FILE_HPP_
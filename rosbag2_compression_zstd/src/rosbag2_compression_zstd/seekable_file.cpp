@@ -0,0 +1,227 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "seekable_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compression_utils.hpp"
+
+namespace rosbag2_compression_zstd
+{
+
+namespace
+{
+
+constexpr uint32_t kSkippableFrameMagicNumber = 0x184D2A5E;
+constexpr uint32_t kSeekableMagicNumber = 0x8F92EAB1;
+// Magic number and size of the skippable frame
+constexpr size_t kSkippableFrameHeaderSize = 4 + 4;
+// Number of frames, descriptor and magic number
+constexpr size_t kSeekTableFooterSize = 4 + 1 + 4;
+constexpr size_t kSeekTableEntrySize = 4 + 4;
+// Bits of the descriptor which have to be zero, the only other one flags checksums
+constexpr uint8_t kReservedDescriptorBits = 0x7C;
+constexpr uint8_t kChecksumFlag = 0x80;
+
+// The seek table is little-endian, independent of the host
+void write_uint32(std::ostream & output, uint32_t value)
+{
+  char bytes[4];
+  for (size_t i = 0; i < sizeof(bytes); ++i) {
+    bytes[i] = static_cast<char>(static_cast<uint8_t>(value >> (8 * i)));
+  }
+  output.write(bytes, sizeof(bytes));
+}
+
+uint32_t read_uint32(const uint8_t * data)
+{
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+[[noreturn]] void throw_malformed(const std::string & uri)
+{
+  throw std::runtime_error{"Malformed seek table in compressed file: \"" + uri + "\""};
+}
+
+}  // namespace
+
+void write_seek_table(std::ostream & output, const std::vector<SeekTableEntry> & seek_table)
+{
+  write_uint32(output, kSkippableFrameMagicNumber);
+  write_uint32(
+    output,
+    static_cast<uint32_t>(seek_table.size() * kSeekTableEntrySize + kSeekTableFooterSize));
+  for (const auto & entry : seek_table) {
+    write_uint32(output, entry.compressed_size);
+    write_uint32(output, entry.decompressed_size);
+  }
+  write_uint32(output, static_cast<uint32_t>(seek_table.size()));
+  output.put(0);
+  write_uint32(output, kSeekableMagicNumber);
+}
+
+std::shared_ptr<SeekableFile> SeekableFile::open(const std::string & uri)
+{
+  std::ifstream input(uri, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open file: \"" << uri <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+  input.seekg(0, std::ios::end);
+  const auto file_size = static_cast<uint64_t>(input.tellg());
+  if (file_size < kSkippableFrameHeaderSize + kSeekTableFooterSize) {
+    return nullptr;
+  }
+
+  uint8_t footer[kSeekTableFooterSize];
+  input.seekg(static_cast<std::streamoff>(file_size - kSeekTableFooterSize));
+  input.read(reinterpret_cast<char *>(footer), kSeekTableFooterSize);
+  if (!input || read_uint32(footer + 5) != kSeekableMagicNumber) {
+    return nullptr;
+  }
+  const uint64_t frame_count = read_uint32(footer);
+  const uint8_t descriptor = footer[4];
+  if ((descriptor & kReservedDescriptorBits) != 0) {
+    throw_malformed(uri);
+  }
+  const uint64_t entry_size = kSeekTableEntrySize + ((descriptor & kChecksumFlag) ? 4 : 0);
+  const uint64_t table_size = frame_count * entry_size + kSeekTableFooterSize;
+  if (file_size < kSkippableFrameHeaderSize + table_size) {
+    throw_malformed(uri);
+  }
+
+  std::vector<uint8_t> table(kSkippableFrameHeaderSize + table_size);
+  input.seekg(static_cast<std::streamoff>(file_size - table.size()));
+  input.read(reinterpret_cast<char *>(table.data()), static_cast<std::streamsize>(table.size()));
+  if (!input || read_uint32(table.data()) != kSkippableFrameMagicNumber ||
+    read_uint32(table.data() + 4) != table_size)
+  {
+    throw_malformed(uri);
+  }
+  std::vector<SeekTableEntry> seek_table(static_cast<size_t>(frame_count));
+  uint64_t compressed_size = 0;
+  for (size_t i = 0; i < seek_table.size(); ++i) {
+    const uint8_t * entry = table.data() + kSkippableFrameHeaderSize + i * entry_size;
+    seek_table[i].compressed_size = read_uint32(entry);
+    seek_table[i].decompressed_size = read_uint32(entry + 4);
+    compressed_size += seek_table[i].compressed_size;
+  }
+  if (compressed_size != file_size - table.size()) {
+    throw_malformed(uri);
+  }
+  input.clear();
+  return std::shared_ptr<SeekableFile>(new SeekableFile(uri, std::move(input), seek_table));
+}
+
+SeekableFile::SeekableFile(
+  const std::string & uri, std::ifstream input, const std::vector<SeekTableEntry> & seek_table)
+: uri_(uri), input_(std::move(input)), zstd_context_(ZSTD_createDCtx())
+{
+  compressed_offsets_.reserve(seek_table.size() + 1);
+  decompressed_offsets_.reserve(seek_table.size() + 1);
+  compressed_offsets_.push_back(0);
+  decompressed_offsets_.push_back(0);
+  for (const auto & entry : seek_table) {
+    compressed_offsets_.push_back(compressed_offsets_.back() + entry.compressed_size);
+    decompressed_offsets_.push_back(decompressed_offsets_.back() + entry.decompressed_size);
+  }
+}
+
+SeekableFile::~SeekableFile()
+{
+  ZSTD_freeDCtx(zstd_context_);
+}
+
+uint64_t SeekableFile::size() const
+{
+  return decompressed_offsets_.back();
+}
+
+uint64_t SeekableFile::read(uint8_t * data, uint64_t offset, uint64_t size)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t end = std::min(offset + size, decompressed_offsets_.back());
+  uint64_t position = offset;
+  while (position < end) {
+    // Index of the frame position is part of
+    const auto index = static_cast<size_t>(
+      std::upper_bound(decompressed_offsets_.begin(), decompressed_offsets_.end(), position) -
+      decompressed_offsets_.begin() - 1);
+    const auto & frame = get_frame(index);
+    const uint64_t frame_offset = position - decompressed_offsets_[index];
+    const uint64_t count = std::min<uint64_t>(end - position, frame.size() - frame_offset);
+    std::memcpy(data, frame.data() + frame_offset, static_cast<size_t>(count));
+    data += count;
+    position += count;
+  }
+  return position > offset ? position - offset : 0;
+}
+
+const std::vector<uint8_t> & SeekableFile::get_frame(size_t index)
+{
+  for (auto it = frames_.begin(); it != frames_.end(); ++it) {
+    if (it->first == index) {
+      frames_.splice(frames_.begin(), frames_, it);
+      return frames_.front().second;
+    }
+  }
+
+  const auto compressed_size = compressed_offsets_[index + 1] - compressed_offsets_[index];
+  compressed_buffer_.resize(static_cast<size_t>(compressed_size));
+  input_.seekg(static_cast<std::streamoff>(compressed_offsets_[index]));
+  input_.read(
+    reinterpret_cast<char *>(compressed_buffer_.data()),
+    static_cast<std::streamsize>(compressed_size));
+  if (!input_) {
+    input_.clear();
+    std::stringstream errmsg;
+    errmsg << "Failed to read frame " << index << " of compressed file: \"" << uri_ << "\"";
+
+    throw std::runtime_error{errmsg.str()};
+  }
+
+  // Reuse the buffer of the least recently used frame
+  std::vector<uint8_t> frame;
+  if (frames_.size() >= kSeekableFrameCacheSize) {
+    frame = std::move(frames_.back().second);
+    frames_.pop_back();
+  }
+  const auto decompressed_size = decompressed_offsets_[index + 1] - decompressed_offsets_[index];
+  frame.resize(static_cast<size_t>(decompressed_size));
+  const auto result = ZSTD_decompressDCtx(
+    zstd_context_, frame.data(), frame.size(),
+    compressed_buffer_.data(), compressed_buffer_.size());
+  throw_on_zstd_error(result);
+  if (result != frame.size()) {
+    throw_malformed(uri_);
+  }
+  frames_.emplace_front(index, std::move(frame));
+  return frames_.front().second;
+}
+
+}  // namespace rosbag2_compression_zstd
@@ -0,0 +1,99 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_COMPRESSION_ZSTD__SEEKABLE_FILE_HPP_
+#define ROSBAG2_COMPRESSION_ZSTD__SEEKABLE_FILE_HPP_
+
+#include <zstd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/readable_file.hpp"
+
+namespace rosbag2_compression_zstd
+{
+// Compressed files are split into independent frames of this decompressed size, so a reader
+// only has to decompress the frames a range is part of.
+constexpr const uint32_t kSeekableFrameSize = 4 * 1024 * 1024;
+// Number of decompressed frames a SeekableFile keeps for following reads.
+constexpr const size_t kSeekableFrameCacheSize = 2;
+
+// Entry of the seek table of the zstd seekable format, which is specified in
+// contrib/seekable_format/zstd_seekable_compression_format.md of zstd.
+struct SeekTableEntry
+{
+  uint32_t compressed_size;
+  uint32_t decompressed_size;
+};
+
+/**
+ * Writes the seek table of the frames written to output before as a skippable frame, which
+ * decompressors unaware of the seekable format ignore.
+ * \param output is the stream the frames were written to.
+ * \param seek_table has an entry for each frame, in order.
+ */
+void write_seek_table(std::ostream & output, const std::vector<SeekTableEntry> & seek_table);
+
+/**
+ * The decompressed content of a file in the zstd seekable format.
+ */
+class SeekableFile : public rosbag2_storage::ReadableFile
+{
+public:
+  /**
+   * Opens a compressed file.
+   * \param uri is the path to the file.
+   * \return the file or nullptr if it has no seek table, e.g. because it was written before
+   *   files were compressed in the seekable format.
+   * \throws std::runtime_error if the file can't be read or its seek table is malformed.
+   */
+  static std::shared_ptr<SeekableFile> open(const std::string & uri);
+
+  ~SeekableFile() override;
+
+  uint64_t size() const override;
+
+  uint64_t read(uint8_t * data, uint64_t offset, uint64_t size) override;
+
+private:
+  SeekableFile(
+    const std::string & uri, std::ifstream input, const std::vector<SeekTableEntry> & seek_table);
+
+  const std::vector<uint8_t> & get_frame(size_t index);
+
+  const std::string uri_;
+  // Start of each frame and the end of the last one
+  std::vector<uint64_t> compressed_offsets_;
+  std::vector<uint64_t> decompressed_offsets_;
+
+  std::mutex mutex_;
+  std::ifstream input_;
+  ZSTD_DCtx * zstd_context_;
+  std::vector<uint8_t> compressed_buffer_;
+  // Decompressed frames by index, most recently used first
+  std::list<std::pair<size_t, std::vector<uint8_t>>> frames_;
+};
+
+}  // namespace rosbag2_compression_zstd
+
+#endif  // ROSBAG2_COMPRESSION_ZSTD__SEEKABLE_FILE_HPP_
@@ -12,22 +12,31 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <zdict.h>
+
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "compression_utils.hpp"
+#include "mapped_file.hpp"
 #include "rosbag2_compression_zstd/zstd_compressor.hpp"
 #include "rosbag2_storage/ros_helper.hpp"
+#include "seekable_file.hpp"
 
 namespace rosbag2_compression_zstd
 {
 ZstdCompressor::ZstdCompressor()
+: compression_level_(kDefaultZstdCompressionLevel)
 {
   // From the zstd manual: https://facebook.github.io/zstd/zstd_manual.html#Chapter4
   // When compressing many times,
@@ -39,10 +48,15 @@ ZstdCompressor::ZstdCompressor()
   // Note 2 : In multi-threaded environments,
   //        use one different context per thread for parallel execution.
   zstd_context_ = ZSTD_createCCtx();
+  set_message_parameters();
 }
 
 ZstdCompressor::~ZstdCompressor()
 {
+  for (auto & topic_dictionary : topic_dictionaries_) {
+    ZSTD_freeCDict(topic_dictionary.second.dictionary);
+  }
+  ZSTD_freeCDict(loaded_dictionary_);
   ZSTD_freeCCtx(zstd_context_);
 }
 
@@ -51,14 +65,8 @@ std::string ZstdCompressor::compress_uri(const std::string & uri)
   const auto start = std::chrono::high_resolution_clock::now();
   const auto compressed_uri = uri + "." + get_compression_identifier();
 
-  std::ifstream input(uri, std::ios::in | std::ios::binary);
-  if (!input.is_open()) {
-    std::stringstream errmsg;
-    errmsg << "Failed to open file: \"" << uri <<
-      "\" for binary reading! errno(" << errno << ")";
-
-    throw std::runtime_error{errmsg.str()};
-  }
+  // The file is compressed straight from the mapping, without copying it into buffers
+  const MappedFile input(uri);
   std::ofstream output(compressed_uri, std::ios::out | std::ios::binary);
   if (!output.is_open()) {
     std::stringstream errmsg;
@@ -67,38 +75,44 @@ std::string ZstdCompressor::compress_uri(const std::string & uri)
 
     throw std::runtime_error{errmsg.str()};
   }
+  // Files are compressed with the default parameters of zstd, not the ones for messages
+  throw_on_zstd_error(ZSTD_CCtx_reset(zstd_context_, ZSTD_reset_session_and_parameters));
+  set_file_parameters();
   // Based on the example from https://github.com/facebook/zstd/blob/dev/examples/streaming_compression.c
-  const size_t buff_in_size = ZSTD_CStreamInSize();
-  const size_t buff_out_size = ZSTD_CStreamOutSize();
-  std::vector<char> in_buffer(buff_in_size);
-  std::vector<char> out_buffer(buff_out_size);
+  // The file is written in the zstd seekable format: the content is split into independent
+  // frames, which a reader finds by the seek table at the end, see seekable_file.hpp.
+  std::vector<char> out_buffer(ZSTD_CStreamOutSize());
   size_t total_size = 0;
-  size_t final_result = 0;
-  do {
-    input.read(in_buffer.data(), buff_in_size);
-    const auto size = size_t(input.gcount());
-    if (size > 0) {
-      const ZSTD_EndDirective mode = input.eof() ? ZSTD_e_end : ZSTD_e_continue;
-      ZSTD_inBuffer z_in_buffer = {in_buffer.data(), static_cast<size_t>(size), 0};
-      int finished;
-      do {
-        ZSTD_outBuffer z_out_buffer = {out_buffer.data(), out_buffer.size(), 0};
-        const auto remaining =
-          ZSTD_compressStream2(zstd_context_, &z_out_buffer, &z_in_buffer, mode);
-        throw_on_zstd_error(remaining);
-        output.write(out_buffer.data(), z_out_buffer.pos);
-        total_size += z_out_buffer.pos;
-        finished = input.eof() ? (remaining == 0) : (z_in_buffer.pos == z_in_buffer.size);
-        final_result = remaining;
-      } while (!finished);
+  std::vector<SeekTableEntry> seek_table;
+  for (size_t offset = 0; offset < input.size(); offset += kSeekableFrameSize) {
+    SeekTableEntry frame{};
+    frame.decompressed_size =
+      static_cast<uint32_t>(std::min<size_t>(kSeekableFrameSize, input.size() - offset));
+    // The mapping reads the frame from disk once it is compressed
+    if (file_read_throttle_) {
+      file_read_throttle_(frame.decompressed_size);
     }
-  } while (!input.eof());
+    // The whole frame is passed at once, so that the workers can compress its jobs in parallel
+    ZSTD_inBuffer z_in_buffer = {input.data() + offset, frame.decompressed_size, 0};
+    size_t remaining;
+    do {
+      ZSTD_outBuffer z_out_buffer = {out_buffer.data(), out_buffer.size(), 0};
+      remaining = ZSTD_compressStream2(zstd_context_, &z_out_buffer, &z_in_buffer, ZSTD_e_end);
+      throw_on_zstd_error(remaining);
+      output.write(out_buffer.data(), static_cast<std::streamsize>(z_out_buffer.pos));
+      frame.compressed_size += static_cast<uint32_t>(z_out_buffer.pos);
+    } while (remaining != 0);
+    total_size += frame.compressed_size;
+    seek_table.push_back(frame);
+  }
+  write_seek_table(output, seek_table);
   output.flush();
   output.close();
-  input.close();
+  throw_on_zstd_error(ZSTD_CCtx_reset(zstd_context_, ZSTD_reset_session_and_parameters));
+  set_message_parameters();
 
   const auto end = std::chrono::high_resolution_clock::now();
-  print_compression_statistics(start, end, total_size, final_result);
+  print_compression_statistics(start, end, input.size(), total_size);
   return compressed_uri;
 }
 
@@ -107,22 +121,39 @@ void ZstdCompressor::compress_serialized_bag_message(
   rosbag2_storage::SerializedBagMessage * compressed_message)
 {
   const auto start = std::chrono::high_resolution_clock::now();
-  // Allocate based on compression bound and compress
+  // Compress into the scratch buffer, which only grows, so that the compressed message doesn't
+  // hold on to a buffer of the compression bound while it is queued for writing
   const auto maximum_compressed_length =
     ZSTD_compressBound(bag_message->serialized_data->buffer_length);
-  compressed_message->serialized_data =
-    rosbag2_storage::make_empty_serialized_message(maximum_compressed_length);
+  if (compression_buffer_.size() < maximum_compressed_length) {
+    compression_buffer_.resize(maximum_compressed_length);
+  }
 
   // Perform compression and check.
   // compression_result is either the actual compressed size or an error code.
-  const auto compression_result = ZSTD_compressCCtx(
-    zstd_context_,
-    compressed_message->serialized_data->buffer, maximum_compressed_length,
-    bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length,
-    kDefaultZstdCompressionLevel);
+  // Frames compressed with a dictionary carry its ID, which the decompressor looks it up by.
+  const auto dictionary = get_dictionary(*bag_message);
+  size_t compression_result;
+  if (dictionary != nullptr) {
+    compression_result = ZSTD_compress_usingCDict(
+      zstd_context_,
+      compression_buffer_.data(), compression_buffer_.size(),
+      bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length,
+      dictionary);
+  } else {
+    // Uses the parameters set on the context once instead of resetting them for every message
+    compression_result = ZSTD_compress2(
+      zstd_context_,
+      compression_buffer_.data(), compression_buffer_.size(),
+      bag_message->serialized_data->buffer, bag_message->serialized_data->buffer_length);
+  }
   throw_on_zstd_error(compression_result);
 
-  compressed_message->serialized_data->buffer_length = compression_result;
+  compressed_message->serialized_data =
+    rosbag2_storage::make_serialized_message(compression_buffer_.data(), compression_result);
+  if (dictionary == nullptr && training_messages_ > 0) {
+    add_training_sample(*bag_message);
+  }
 
   const auto end = std::chrono::high_resolution_clock::now();
   print_compression_statistics(start, end, maximum_compressed_length, compression_result);
@@ -133,6 +164,151 @@ std::string ZstdCompressor::get_compression_identifier() const
   return kCompressionIdentifier;
 }
 
+void ZstdCompressor::set_message_parameters()
+{
+  throw_on_zstd_error(
+    ZSTD_CCtx_setParameter(
+      zstd_context_, ZSTD_c_compressionLevel,
+      compression_level_));
+}
+
+void ZstdCompressor::set_file_parameters()
+{
+  if (file_compression_workers_ == 0) {
+    return;
+  }
+  const auto result = ZSTD_CCtx_setParameter(
+    zstd_context_, ZSTD_c_nbWorkers, static_cast<int>(file_compression_workers_));
+  if (ZSTD_isError(result)) {
+    ROSBAG2_COMPRESSION_ZSTD_LOG_WARN_STREAM(
+      "Compressing files in the compression thread, zstd does not support worker threads: " <<
+        ZSTD_getErrorName(result));
+    file_compression_workers_ = 0;
+    return;
+  }
+  // Split each frame into a job per worker
+  const auto job_size = std::max<size_t>(
+    kSeekableFrameSize / file_compression_workers_, kMinZstdJobSize);
+  throw_on_zstd_error(
+    ZSTD_CCtx_setParameter(zstd_context_, ZSTD_c_jobSize, static_cast<int>(job_size)));
+}
+
+void ZstdCompressor::set_file_compression_workers(uint64_t workers)
+{
+  file_compression_workers_ = workers;
+}
+
+void ZstdCompressor::set_file_read_throttle(std::function<void(size_t)> throttle)
+{
+  file_read_throttle_ = std::move(throttle);
+}
+
+void ZstdCompressor::set_compression_level(int32_t level)
+{
+  // zstd clamps levels outside of its range itself
+  compression_level_ = level;
+  set_message_parameters();
+}
+
+void ZstdCompressor::configure_dictionaries(
+  uint64_t training_messages, const std::string & dictionary_path)
+{
+  if (dictionary_path.empty()) {
+    training_messages_ = training_messages;
+    return;
+  }
+
+  std::ifstream input(dictionary_path, std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    std::stringstream errmsg;
+    errmsg << "Failed to open dictionary: \"" << dictionary_path <<
+      "\" for binary reading! errno(" << errno << ")";
+
+    throw std::invalid_argument{errmsg.str()};
+  }
+  std::vector<uint8_t> dictionary(
+    (std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  // Raw content dictionaries have no ID, the decompressor couldn't tell which frames need them
+  if (ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size()) == 0) {
+    throw std::invalid_argument{
+            "\"" + dictionary_path + "\" is not a zstd dictionary, e.g. from zstd --train"};
+  }
+  loaded_dictionary_ =
+    ZSTD_createCDict(dictionary.data(), dictionary.size(), kDefaultZstdCompressionLevel);
+  if (loaded_dictionary_ == nullptr) {
+    throw std::invalid_argument{"Failed to load zstd dictionary \"" + dictionary_path + "\""};
+  }
+  dictionaries_.push_back(std::move(dictionary));
+}
+
+std::vector<std::vector<uint8_t>> ZstdCompressor::get_dictionaries() const
+{
+  return dictionaries_;
+}
+
+ZSTD_CDict * ZstdCompressor::get_dictionary(
+  const rosbag2_storage::SerializedBagMessage & bag_message)
+{
+  if (loaded_dictionary_ != nullptr || training_messages_ == 0) {
+    return loaded_dictionary_;
+  }
+  const auto topic_dictionary = topic_dictionaries_.find(bag_message.topic_name);
+  return topic_dictionary != topic_dictionaries_.end() ?
+         topic_dictionary->second.dictionary : nullptr;
+}
+
+void ZstdCompressor::add_training_sample(
+  const rosbag2_storage::SerializedBagMessage & bag_message)
+{
+  auto & topic_dictionary = topic_dictionaries_[bag_message.topic_name];
+  if (topic_dictionary.trained) {
+    return;
+  }
+  const auto & data = *bag_message.serialized_data;
+  topic_dictionary.samples.insert(
+    topic_dictionary.samples.end(), data.buffer, data.buffer + data.buffer_length);
+  topic_dictionary.sample_sizes.push_back(data.buffer_length);
+  if (topic_dictionary.sample_sizes.size() >= training_messages_ ||
+    topic_dictionary.samples.size() >= kMaxZstdTrainingSamplesSize)
+  {
+    train_dictionary(bag_message.topic_name, topic_dictionary);
+  }
+}
+
+void ZstdCompressor::train_dictionary(
+  const std::string & topic_name, TopicDictionary & topic_dictionary)
+{
+  topic_dictionary.trained = true;
+  // A dictionary about a tenth of the size of the samples is a good trade-off
+  std::vector<uint8_t> dictionary(
+    std::clamp(
+      topic_dictionary.samples.size() / 10, kMinZstdDictionarySize, kMaxZstdDictionarySize));
+  const auto dictionary_size = ZDICT_trainFromBuffer(
+    dictionary.data(), dictionary.size(),
+    topic_dictionary.samples.data(), topic_dictionary.sample_sizes.data(),
+    static_cast<unsigned>(topic_dictionary.sample_sizes.size()));
+  topic_dictionary.samples = {};
+  topic_dictionary.sample_sizes = {};
+  if (ZDICT_isError(dictionary_size)) {
+    // Too few or too small messages, the topic is compressed without a dictionary
+    ROSBAG2_COMPRESSION_ZSTD_LOG_WARN_STREAM(
+      "Could not train a dictionary for topic '" << topic_name << "': " <<
+        ZDICT_getErrorName(dictionary_size));
+    return;
+  }
+  dictionary.resize(dictionary_size);
+  topic_dictionary.dictionary =
+    ZSTD_createCDict(dictionary.data(), dictionary.size(), kDefaultZstdCompressionLevel);
+  if (topic_dictionary.dictionary == nullptr) {
+    ROSBAG2_COMPRESSION_ZSTD_LOG_WARN_STREAM(
+      "Could not create the trained dictionary for topic '" << topic_name << "'");
+    return;
+  }
+  ROSBAG2_COMPRESSION_ZSTD_LOG_DEBUG_STREAM(
+    "Trained a dictionary of " << dictionary.size() << " bytes for topic '" << topic_name << "'");
+  dictionaries_.push_back(std::move(dictionary));
+}
+
 }  // namespace rosbag2_compression_zstd
 
 #include "pluginlib/class_list_macros.hpp"  // NOLINT
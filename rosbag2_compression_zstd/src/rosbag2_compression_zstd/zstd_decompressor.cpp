@@ -15,14 +15,19 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "compression_utils.hpp"
 #include "rosbag2_compression_zstd/zstd_decompressor.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "seekable_file.hpp"
 
 namespace rosbag2_compression_zstd
 {
@@ -39,6 +44,9 @@ ZstdDecompressor::ZstdDecompressor()
 
 ZstdDecompressor::~ZstdDecompressor()
 {
+  for (auto & dictionary : dictionaries_) {
+    ZSTD_freeDDict(dictionary.second);
+  }
   ZSTD_freeDCtx(zstd_context_);
 }
 
@@ -96,6 +104,12 @@ std::string ZstdDecompressor::decompress_uri(const std::string & uri)
   return decompressed_uri;
 }
 
+std::shared_ptr<rosbag2_storage::ReadableFile> ZstdDecompressor::open_decompressed_uri(
+  const std::string & uri)
+{
+  return SeekableFile::open(uri);
+}
+
 void ZstdDecompressor::decompress_serialized_bag_message(
   rosbag2_storage::SerializedBagMessage * message)
 {
@@ -107,26 +121,40 @@ void ZstdDecompressor::decompress_serialized_bag_message(
 
   throw_on_invalid_frame_content(decompressed_buffer_length);
 
-  // Initializes decompressed_buffer with size = decompressed_buffer_length.
-  // Uniform initialization cannot be used here since it will choose
-  // the initializer list constructor instead.
-  std::vector<uint8_t> decompressed_buffer(decompressed_buffer_length);
-
-  const auto decompression_result = ZSTD_decompressDCtx(
-    zstd_context_,
-    decompressed_buffer.data(), decompressed_buffer_length,
-    message->serialized_data->buffer, compressed_buffer_length);
+  // Decompress straight into the new payload of the message instead of copying it over, the
+  // compressed payload may be a read-only view which can't be resized anyway
+  auto decompressed_data =
+    rosbag2_storage::make_empty_serialized_message(decompressed_buffer_length);
+  auto decompressed_buffer = decompressed_data->buffer;
+
+  size_t decompression_result;
+  const auto dictionary_id =
+    ZSTD_getDictID_fromFrame(message->serialized_data->buffer, compressed_buffer_length);
+  if (dictionary_id != 0) {
+    const auto dictionary = dictionaries_.find(dictionary_id);
+    if (dictionary == dictionaries_.end()) {
+      std::stringstream errmsg;
+      errmsg << "Message of topic '" << message->topic_name <<
+        "' was compressed with missing dictionary " << dictionary_id;
+
+      throw std::runtime_error{errmsg.str()};
+    }
+    decompression_result = ZSTD_decompress_usingDDict(
+      zstd_context_,
+      decompressed_buffer, decompressed_buffer_length,
+      message->serialized_data->buffer, compressed_buffer_length,
+      dictionary->second);
+  } else {
+    decompression_result = ZSTD_decompressDCtx(
+      zstd_context_,
+      decompressed_buffer, decompressed_buffer_length,
+      message->serialized_data->buffer, compressed_buffer_length);
+  }
 
   throw_on_zstd_error(decompression_result);
 
-  const auto resize_result =
-    rcutils_uint8_array_resize(message->serialized_data.get(), decompression_result);
-  throw_on_rcutils_resize_error(resize_result);
-
-  message->serialized_data->buffer_length = decompression_result;
-  std::copy(
-    decompressed_buffer.begin(), decompressed_buffer.end(),
-    message->serialized_data->buffer);
+  decompressed_data->buffer_length = decompression_result;
+  message->serialized_data = std::move(decompressed_data);
 
   const auto end = std::chrono::high_resolution_clock::now();
   print_compression_statistics(start, end, decompression_result, compressed_buffer_length);
@@ -136,6 +164,23 @@ std::string ZstdDecompressor::get_decompression_identifier() const
 {
   return kDecompressionIdentifier;
 }
+
+void ZstdDecompressor::add_dictionary(const std::vector<uint8_t> & dictionary)
+{
+  const auto dictionary_id = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+  if (dictionary_id == 0) {
+    throw std::runtime_error{"Compression dictionary is not a zstd dictionary"};
+  }
+  if (dictionaries_.count(dictionary_id) > 0) {
+    return;
+  }
+  auto ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+  if (ddict == nullptr) {
+    throw std::runtime_error{
+            "Failed to load zstd dictionary " + std::to_string(dictionary_id)};
+  }
+  dictionaries_.emplace(dictionary_id, ddict);
+}
 }  // namespace rosbag2_compression_zstd
 
 #include "pluginlib/class_list_macros.hpp"  // NOLINT
@@ -0,0 +1,54 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "rosbag2_compression_zstd/zstd_compressor.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+// Compresses messages of range(0) bytes at compression level range(1). Every thread has its own
+// compressor, as the compression threads of the writer do. The data is random over 16 byte
+// values, so that it compresses to about half of its size.
+static void BM_zstd_compress_serialized_bag_message(benchmark::State & state)
+{
+  std::vector<uint8_t> data(static_cast<size_t>(state.range(0)));
+  std::mt19937 generator(static_cast<unsigned int>(state.thread_index()));
+  std::uniform_int_distribution<int> byte_distribution(0, 15);
+  for (auto & byte : data) {
+    byte = static_cast<uint8_t>(byte_distribution(generator));
+  }
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = "/benchmark";
+  message.serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.set_compression_level(static_cast<int32_t>(state.range(1)));
+  rosbag2_storage::SerializedBagMessage compressed_message;
+  for (auto _ : state) {
+    compressor.compress_serialized_bag_message(&message, &compressed_message);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_zstd_compress_serialized_bag_message)
+->ArgNames({"message_size", "level"})
+->ArgsProduct({{64, 4 * 1024, 256 * 1024, 4 * 1024 * 1024}, {1, 3, 9}})
+->ThreadRange(1, 8)
+->UseRealTime();
@@ -12,11 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <zstd.h>
+
 #include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <memory>
+#include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rclcpp/rclcpp.hpp"
@@ -247,6 +251,45 @@ TEST_F(CompressionHelperFixture, zstd_decompress_file_contents)
   EXPECT_EQ(initial_data, decompressed_data);
 }
 
+TEST_F(CompressionHelperFixture, zstd_decompress_file_compressed_by_workers)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
+  create_garbage_file(uri);
+  const auto initial_data = read_file(uri);
+
+  auto compressor = rosbag2_compression_zstd::ZstdCompressor{};
+  compressor.set_file_compression_workers(4);
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_EQ(0, std::remove(uri.c_str()));
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  const auto decompressed_uri = decompressor.decompress_uri(compressed_uri);
+  EXPECT_EQ(initial_data, read_file(decompressed_uri));
+
+  // Messages are still compressed without workers afterwards
+  auto msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  msg->serialized_data = rosbag2_storage::make_serialized_message(
+    message_.data(), message_.length());
+  auto compressed_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressor.compress_serialized_bag_message(msg.get(), compressed_msg.get());
+  decompressor.decompress_serialized_bag_message(compressed_msg.get());
+  EXPECT_EQ(deserialize_message(compressed_msg->serialized_data), message_);
+}
+
+TEST_F(CompressionHelperFixture, zstd_compress_empty_file_uri)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "empty.txt").string();
+  std::ofstream{uri}.close();
+
+  auto compressor = rosbag2_compression_zstd::ZstdCompressor{};
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_EQ(0, std::remove(uri.c_str()));
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  const auto decompressed_uri = decompressor.decompress_uri(compressed_uri);
+  EXPECT_EQ(rcpputils::fs::file_size(rcpputils::fs::path{decompressed_uri}), 0u);
+}
+
 TEST_F(CompressionHelperFixture, zstd_decompress_fails_on_bad_file)
 {
   const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
@@ -299,3 +342,208 @@ TEST_F(CompressionHelperFixture, zstd_decompress_serialized_bag_message)
   std::string new_msg = deserialize_message(msg->serialized_data);
   EXPECT_EQ(new_msg, message_);
 }
+
+TEST_F(CompressionHelperFixture, zstd_compresses_messages_with_trained_dictionary)
+{
+  const size_t kTrainingMessages = 500;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (size_t i = 0; i < 2 * kTrainingMessages; i++) {
+    const auto content = "header: {stamp: " + std::to_string(i * 7919) +
+      ", frame_id: odom}, child_frame_id: base_link, translation: {x: " +
+      std::to_string(i % 13) + ", y: " + std::to_string(i % 17) + ", z: 0.0}";
+    auto msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    msg->topic_name = "/tf";
+    msg->serialized_data = rosbag2_storage::make_serialized_message(
+      content.data(), content.length());
+    messages.push_back(msg);
+  }
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.configure_dictionaries(kTrainingMessages, "");
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> compressed_messages;
+  size_t size_without_dictionary = 0;
+  size_t size_with_dictionary = 0;
+  for (size_t i = 0; i < messages.size(); i++) {
+    auto compressed_msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    compressed_msg->topic_name = messages[i]->topic_name;
+    compressor.compress_serialized_bag_message(messages[i].get(), compressed_msg.get());
+    const auto compressed_length = compressed_msg->serialized_data->buffer_length;
+    (i < kTrainingMessages ? size_without_dictionary : size_with_dictionary) += compressed_length;
+    compressed_messages.push_back(compressed_msg);
+  }
+  const auto dictionaries = compressor.get_dictionaries();
+  ASSERT_EQ(dictionaries.size(), 1u);
+  EXPECT_LT(2 * size_with_dictionary, size_without_dictionary);
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  EXPECT_THROW(
+    decompressor.decompress_serialized_bag_message(compressed_messages.back().get()),
+    std::runtime_error);
+  decompressor.add_dictionary(dictionaries[0]);
+  for (size_t i = 0; i < messages.size(); i++) {
+    decompressor.decompress_serialized_bag_message(compressed_messages[i].get());
+    EXPECT_EQ(
+      deserialize_message(compressed_messages[i]->serialized_data),
+      deserialize_message(messages[i]->serialized_data));
+  }
+}
+
+TEST_F(CompressionHelperFixture, zstd_compresses_messages_with_loaded_dictionary)
+{
+  const auto content = std::string{"header: {stamp: 42, frame_id: odom}"};
+  auto msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  msg->serialized_data = rosbag2_storage::make_serialized_message(
+    content.data(), content.length());
+
+  rosbag2_compression_zstd::ZstdCompressor training_compressor;
+  training_compressor.configure_dictionaries(100, "");
+  for (size_t i = 0; i < 100; i++) {
+    auto compressed_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    const auto sample = content + std::to_string(i * 7919) + ", child_frame_id: base_link";
+    auto sample_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    sample_msg->serialized_data = rosbag2_storage::make_serialized_message(
+      sample.data(), sample.length());
+    training_compressor.compress_serialized_bag_message(sample_msg.get(), compressed_msg.get());
+  }
+  const auto dictionaries = training_compressor.get_dictionaries();
+  ASSERT_EQ(dictionaries.size(), 1u);
+  const auto dictionary_path = (rcpputils::fs::path(temporary_dir_path_) / "tf.dict").string();
+  std::ofstream(dictionary_path, std::ios::binary).write(
+    reinterpret_cast<const char *>(dictionaries[0].data()),
+    static_cast<std::streamsize>(dictionaries[0].size()));
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  compressor.configure_dictionaries(0, dictionary_path);
+  EXPECT_EQ(compressor.get_dictionaries(), dictionaries);
+  auto compressed_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  compressor.compress_serialized_bag_message(msg.get(), compressed_msg.get());
+
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  decompressor.add_dictionary(dictionaries[0]);
+  decompressor.decompress_serialized_bag_message(compressed_msg.get());
+  EXPECT_EQ(deserialize_message(compressed_msg->serialized_data), content);
+}
+
+TEST_F(CompressionHelperFixture, zstd_configure_dictionaries_fails_on_bad_dictionary)
+{
+  const auto bad_uri = (rcpputils::fs::path(temporary_dir_path_) / "bad_uri.dict").string();
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  EXPECT_THROW(compressor.configure_dictionaries(0, bad_uri), std::invalid_argument);
+
+  const auto garbage_uri = (rcpputils::fs::path(temporary_dir_path_) / "garbage.dict").string();
+  create_garbage_file(garbage_uri, 1);
+  EXPECT_THROW(compressor.configure_dictionaries(0, garbage_uri), std::invalid_argument);
+}
+
+TEST_F(CompressionHelperFixture, zstd_compresses_and_decompresses_messages_without_extra_memory)
+{
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  // The large message grows the scratch buffer of the compressor, which the small one reuses
+  for (const auto & content : {message_, std::string{"header: {stamp: 42, frame_id: odom}"}}) {
+    auto msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    msg->serialized_data = rosbag2_storage::make_serialized_message(
+      content.data(), content.length());
+
+    auto compressed_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    compressor.compress_serialized_bag_message(msg.get(), compressed_msg.get());
+    EXPECT_EQ(
+      compressed_msg->serialized_data->buffer_capacity,
+      compressed_msg->serialized_data->buffer_length);
+
+    // Payloads read from storage may be read-only views
+    auto compressed_data = compressed_msg->serialized_data;
+    compressed_msg->serialized_data = rosbag2_storage::make_serialized_message_view(
+      compressed_data->buffer, compressed_data->buffer_length, compressed_data);
+    decompressor.decompress_serialized_bag_message(compressed_msg.get());
+    EXPECT_EQ(deserialize_message(compressed_msg->serialized_data), content);
+  }
+}
+
+TEST_F(CompressionHelperFixture, zstd_compresses_messages_with_the_set_compression_level)
+{
+  // Text which compresses differently at different levels, unlike the repeated garbage
+  std::mt19937 generator(42);
+  std::string content;
+  const std::vector<std::string> words = {"stamp ", "frame_id ", "odom ", "base_link ", "42 "};
+  while (content.size() < 100000) {
+    content += words[generator() % words.size()];
+  }
+  auto msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+  msg->serialized_data = rosbag2_storage::make_serialized_message(
+    content.data(), content.length());
+
+  rosbag2_compression_zstd::ZstdCompressor compressor;
+  rosbag2_compression_zstd::ZstdDecompressor decompressor;
+  std::vector<size_t> compressed_lengths;
+  for (const int32_t level : {-5, 19}) {
+    compressor.set_compression_level(level);
+    auto compressed_msg = std::make_unique<rosbag2_storage::SerializedBagMessage>();
+    compressor.compress_serialized_bag_message(msg.get(), compressed_msg.get());
+    compressed_lengths.push_back(compressed_msg->serialized_data->buffer_length);
+    decompressor.decompress_serialized_bag_message(compressed_msg.get());
+    EXPECT_EQ(deserialize_message(compressed_msg->serialized_data), content);
+  }
+  EXPECT_GT(compressed_lengths[0], compressed_lengths[1]);
+}
+
+TEST_F(CompressionHelperFixture, zstd_reads_ranges_of_compressed_file_without_decompressing_it)
+{
+  const auto uri = (rcpputils::fs::path(temporary_dir_path_) / "file3.txt").string();
+  create_garbage_file(uri);
+  const auto initial_data = read_file(uri);
+
+  auto compressor = rosbag2_compression_zstd::ZstdCompressor{};
+  const auto compressed_uri = compressor.compress_uri(uri);
+  ASSERT_EQ(0, std::remove(uri.c_str()));
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  const auto file = decompressor.open_decompressed_uri(compressed_uri);
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(file->size(), initial_data.size());
+  EXPECT_FALSE(rcpputils::fs::exists(uri));
+
+  // Ranges within a frame, across frame boundaries, back to earlier frames and past the end
+  const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+    {0, 100}, {4 * 1024 * 1024 - 10, 20}, {100, 9 * 1024 * 1024}, {5, 1},
+    {initial_data.size() - 3, 10}, {initial_data.size(), 10}};
+  for (const auto & range : ranges) {
+    std::vector<uint8_t> data(range.second);
+    const auto count = file->read(data.data(), range.first, range.second);
+    const auto expected_count =
+      std::min<uint64_t>(range.second, initial_data.size() - range.first);
+    ASSERT_EQ(count, expected_count) << "at offset " << range.first;
+    EXPECT_TRUE(
+      std::equal(
+        data.begin(), data.begin() + count,
+        reinterpret_cast<const uint8_t *>(initial_data.data()) + range.first)) <<
+      "at offset " << range.first;
+  }
+
+  // Files in the seekable format are still decompressed to disk as before
+  const auto decompressed_uri = decompressor.decompress_uri(compressed_uri);
+  EXPECT_EQ(initial_data, read_file(decompressed_uri));
+}
+
+TEST_F(CompressionHelperFixture, zstd_open_decompressed_uri_skips_files_without_seek_table)
+{
+  // A single frame, as files were compressed before the seekable format
+  const auto compressed_uri =
+    (rcpputils::fs::path(temporary_dir_path_) / "file4.txt.zstd").string();
+  std::vector<uint8_t> compressed(ZSTD_compressBound(message_.size()));
+  const auto compressed_size = ZSTD_compress(
+    compressed.data(), compressed.size(), message_.data(), message_.size(), 1);
+  ASSERT_FALSE(ZSTD_isError(compressed_size));
+  {
+    std::ofstream out(compressed_uri, std::ios::out | std::ios::binary);
+    out.write(
+      reinterpret_cast<const char *>(compressed.data()),
+      static_cast<std::streamsize>(compressed_size));
+  }
+
+  auto decompressor = rosbag2_compression_zstd::ZstdDecompressor{};
+  EXPECT_EQ(decompressor.open_decompressed_uri(compressed_uri), nullptr);
+  const auto decompressed_uri = decompressor.decompress_uri(compressed_uri);
+  const auto decompressed_data = read_file(decompressed_uri);
+  EXPECT_EQ(std::string(decompressed_data.begin(), decompressed_data.end()), message_);
+}
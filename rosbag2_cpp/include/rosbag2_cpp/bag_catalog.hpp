@@ -0,0 +1,135 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__BAG_CATALOG_HPP_
+#define ROSBAG2_CPP__BAG_CATALOG_HPP_
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/**
+ * Index of the bags below a set of directories, to answer queries about them without opening
+ * the bags.
+ *
+ * update() keeps a summary of every bag directory below the roots, read from its metadata and
+ * topic statistics. A bag is only read again when these files changed, so calling update()
+ * periodically picks up new bags and the splits which recordings close, from their metadata
+ * journal, at the cost of a directory scan. The summaries are saved to a catalog file, which
+ * the next catalog loads instead of reading all bags again.
+ *
+ * The queries may be called while another thread updates the catalog.
+ */
+class ROSBAG2_CPP_PUBLIC BagCatalog
+{
+public:
+  struct TopicSummary
+  {
+    std::string name;
+    std::string type;
+    size_t message_count = 0;
+    // Size of the serialized messages, 0 if the bag has no topic statistics
+    uint64_t total_bytes = 0;
+  };
+
+  struct BagSummary
+  {
+    std::string uri;
+    std::string storage_identifier;
+    // Inclusive time range of the messages
+    rcutils_time_point_value_t start_time_ns = 0;
+    rcutils_time_point_value_t end_time_ns = 0;
+    size_t message_count = 0;
+    size_t file_count = 0;
+    // Size of the bag directory
+    uint64_t bag_size = 0;
+    // False while the bag is recorded, only its closed files are summarized then
+    bool closed = false;
+    std::vector<TopicSummary> topics;
+    // Newest modification time and total size of the metadata files, to notice changes
+    int64_t metadata_write_time = 0;
+    uint64_t metadata_bytes = 0;
+  };
+
+  /// Conditions of find(), the bags have to meet all of them.
+  struct Query
+  {
+    // Bags with messages of the topic, any bag if empty
+    std::string topic_name;
+    // Bags with messages in the inclusive time range, -1 if unbounded
+    rcutils_time_point_value_t start_time_ns = -1;
+    rcutils_time_point_value_t end_time_ns = -1;
+    uint64_t min_bag_size = 0;
+    uint64_t max_bag_size = std::numeric_limits<uint64_t>::max();
+  };
+
+  /// Create a catalog, with the summaries of the catalog file if it exists.
+  /**
+   * \param catalog_file File the catalog is saved to, the catalog is not saved if empty
+   * \throws std::runtime_error if the catalog file can not be parsed
+   */
+  explicit BagCatalog(std::string catalog_file = "");
+
+  virtual ~BagCatalog() = default;
+
+  /// Index the bag directories below the roots and save the catalog file.
+  /**
+   * Bags which are no longer found below the roots are dropped. Bags whose metadata can not be
+   * read are left out with a warning.
+   * \return Number of bags which were read, because they are new or changed
+   */
+  size_t update(const std::vector<std::string> & root_directories);
+
+  /// Bags meeting the conditions of the query, in the order of their start times.
+  std::vector<BagSummary> find(const Query & query) const;
+
+  /// Summary of a bag, as indexed by the last update().
+  std::optional<BagSummary> lookup(const std::string & uri) const;
+
+  /// Write the summaries to the catalog file, replacing it at once.
+  void save() const;
+
+private:
+  std::string catalog_file_;
+  mutable std::mutex mutex_;
+  // By the uri of the bag directory
+  std::map<std::string, BagSummary> bags_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__BAG_CATALOG_HPP_
@@ -15,6 +15,8 @@
 #ifndef ROSBAG2_CPP__BAG_EVENTS_HPP_
 #define ROSBAG2_CPP__BAG_EVENTS_HPP_
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -40,6 +42,30 @@ enum class BagEvent
   READ_SPLIT,
 };
 
+/**
+ * \brief Statistics of a bag file which was written, gathered until it was split off.
+ */
+struct BagFileStatistics
+{
+  /// Bytes written to the file, as reported by the storage before it was closed.
+  uint64_t size = 0;
+  /// Messages written to the file.
+  uint64_t message_count = 0;
+  /// Percentiles of the latency of writing a message or a batch of the cache to storage.
+  std::chrono::nanoseconds write_latency_p50{0};
+  std::chrono::nanoseconds write_latency_p90{0};
+  std::chrono::nanoseconds write_latency_p99{0};
+  std::chrono::nanoseconds write_latency_max{0};
+  /// Messages the message cache dropped while the file was written.
+  uint64_t dropped_message_count = 0;
+  /// Bytes of the messages before compression divided by the bytes after compression,
+  /// 0 if no message of the file was compressed. Files compressed as a whole are compressed
+  /// after the WRITE_SPLIT event and are not accounted.
+  double compression_ratio = 0.0;
+  /// Time spent updating the metadata of the file and closing it.
+  std::chrono::nanoseconds close_duration{0};
+};
+
 /**
  * \brief The information structure passed to callbacks for the WRITE_SPLIT and READ_SPLIT events.
  */
@@ -49,6 +75,8 @@ struct BagSplitInfo
   std::string closed_file;
   /// The URI of the file that was opened.
   std::string opened_file;
+  /// Statistics of the closed file. Only filled in for WRITE_SPLIT events of writers.
+  BagFileStatistics closed_file_statistics;
 };
 
 using BagSplitCallbackType = std::function<void (BagSplitInfo &)>;
@@ -0,0 +1,95 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__BAG_MANIFEST_HPP_
+#define ROSBAG2_CPP__BAG_MANIFEST_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/**
+ * Tool to define a bag as parts of other bags, without copying their files.
+ *
+ * A manifest is a bag directory holding only a metadata.yaml, which lists the files of other
+ * bags by their paths relative to it, each with the time window of its messages which belongs
+ * to the manifest. Readers open it like any other bag and apply the time windows on top of
+ * their filter, seeking by the time ranges of the files as for split bags.
+ */
+class ROSBAG2_CPP_PUBLIC BagManifest
+{
+public:
+  /// A bag, or the messages of a bag in a time window, to reference.
+  struct Entry
+  {
+    std::string bag_uri;
+    // Inclusive time window of the messages, -1 if unbounded
+    rcutils_time_point_value_t start_time_ns = -1;
+    rcutils_time_point_value_t end_time_ns = -1;
+  };
+
+  BagManifest(
+    std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory =
+    std::make_unique<rosbag2_storage::StorageFactory>(),
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  virtual ~BagManifest() = default;
+
+  /// Build the metadata of a manifest of the entries, in their order, without writing it.
+  /*
+  * Files outside of the time window of their entry are left out. The messages of files cut by
+  * the window are counted with ReadOnlyInterface::estimate(), which only opens the files.
+  * \param manifest_uri Directory of the manifest, the files are referenced relative to it.
+  * \throws std::runtime_error if a bag has no metadata or its files are compressed as a whole,
+  *   or if the bags differ in storage or compression.
+  */
+  rosbag2_storage::BagMetadata create(
+    const std::string & manifest_uri, const std::vector<Entry> & entries);
+
+  /// Build the metadata of a manifest like create() and write it to manifest_uri.
+  void write(const std::string & manifest_uri, const std::vector<Entry> & entries);
+
+protected:
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_{};
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_{};
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__BAG_MANIFEST_HPP_
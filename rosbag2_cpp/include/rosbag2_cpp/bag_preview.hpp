@@ -0,0 +1,133 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__BAG_PREVIEW_HPP_
+#define ROSBAG2_CPP__BAG_PREVIEW_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Downsampled overview of a bag for timeline views, which do not have to read the bag.
+/**
+ * The preview counts the messages and bytes of every topic per time bucket of a fixed duration
+ * and keeps every n-th message of chosen topics, e.g. as thumbnails of camera topics. The
+ * writer builds it while recording if StorageOptions::preview_bucket_duration_ms is set and
+ * stores it in the bag directory, next to the metadata, when it is closed.
+ */
+class ROSBAG2_CPP_PUBLIC BagPreview
+{
+public:
+  struct Bucket
+  {
+    uint64_t message_count = 0;
+    uint64_t size = 0;
+  };
+
+  struct Sample
+  {
+    rcutils_time_point_value_t time_stamp = 0;
+    std::vector<uint8_t> serialized_data;
+  };
+
+  struct Topic
+  {
+    // Buckets with messages by their start time
+    std::map<rcutils_time_point_value_t, Bucket> buckets;
+    std::vector<Sample> samples;
+    uint64_t message_count = 0;
+  };
+
+  /// Name of the preview file in the bag directory.
+  static constexpr const char * kFileName = "preview";
+
+  /**
+   * \param bucket_duration Duration of the time buckets in nanoseconds, which start at
+   *   multiples of it.
+   * \param sample_topics Topics of which messages are kept.
+   * \param sample_interval Keep every n-th message of the sample topics, starting with the first.
+   * \throws std::invalid_argument if bucket_duration or sample_interval is not positive
+   */
+  explicit BagPreview(
+    rcutils_duration_value_t bucket_duration = RCUTILS_S_TO_NS(1),
+    const std::vector<std::string> & sample_topics = {},
+    uint64_t sample_interval = 1);
+
+  /// Account a message, keeping a copy of it if it is a sample.
+  void add_message(const rosbag2_storage::SerializedBagMessage & message);
+
+  rcutils_duration_value_t bucket_duration() const;
+
+  const std::map<std::string, Topic> & topics() const;
+
+  /**
+   * Buckets of a topic merged to a coarser resolution, for views zoomed out further than the
+   * stored buckets.
+   * \param duration Duration of the merged buckets, rounded up to a multiple of
+   *   bucket_duration().
+   * \return Merged buckets with messages by their start time, empty for unknown topics.
+   */
+  std::map<rcutils_time_point_value_t, Bucket> get_buckets(
+    const std::string & topic_name, rcutils_duration_value_t duration) const;
+
+  /// Whether a bag directory holds a preview.
+  static bool exists(const std::string & bag_directory);
+
+  /**
+   * Write the preview to a bag directory, replacing the preview stored there.
+   * \throws std::runtime_error if the preview could not be written
+   */
+  void write(const std::string & bag_directory) const;
+
+  /// \throws std::runtime_error if the bag directory has no preview or it is malformed
+  static BagPreview read(const std::string & bag_directory);
+
+  std::string serialize() const;
+
+  /// \throws std::runtime_error if serialized_preview is malformed
+  static BagPreview deserialize(const std::string & serialized_preview);
+
+private:
+  rcutils_duration_value_t bucket_duration_;
+  std::unordered_set<std::string> sample_topics_;
+  uint64_t sample_interval_;
+  std::map<std::string, Topic> topics_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__BAG_PREVIEW_HPP_
@@ -66,6 +66,17 @@ public:
    *   \return a vector containing messages in the buffer.
    */
   virtual const std::vector<buffer_element_t> & data() = 0;
+
+  /**
+   *   Get the memory held by the messages in the buffer, see get_message_memory_bytes().
+   *   May be called concurrently with push() and clear().
+   *
+   *   \return allocated bytes of the buffered messages.
+   */
+  virtual size_t get_bytes_size() const
+  {
+    return 0u;
+  }
 };
 
 }  // namespace cache
@@ -16,6 +16,7 @@
 #define ROSBAG2_CPP__CACHE__CACHE_CONSUMER_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -25,6 +26,7 @@
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/cache/message_cache.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/thread_scheduling.hpp"
 
 // This is necessary because of using stl types here. It is completely safe, because
 // a) the member is not accessible from the outside
@@ -38,6 +40,34 @@ namespace rosbag2_cpp
 {
 namespace cache
 {
+/**
+* Controls how many bytes CacheConsumer hands to the consume callback at once.
+*
+* By default (min_batch_bytes 0, adaptive off) every swapped buffer is consumed right away.
+* With batching, swapped messages are collected until the batch reaches its target size or its
+* oldest message waited for max_batch_latency. Batches larger than max_batch_bytes are split.
+*
+* In adaptive mode the target size follows the observed consume throughput, so that consuming
+* one batch takes about half of max_batch_latency. The target stays within
+* [min_batch_bytes, max_batch_bytes].
+*/
+struct WriteBatchingOptions
+{
+  /// Minimum batch size in bytes. 0 disables batching unless adaptive is set.
+  size_t min_batch_bytes = 0;
+  /// Maximum batch size in bytes. 0 means unlimited.
+  size_t max_batch_bytes = 0;
+  /// Maximum time a message waits in an incomplete batch.
+  std::chrono::milliseconds max_batch_latency {100};
+  /// Derive the target batch size from the measured consume throughput.
+  bool adaptive = false;
+
+  bool is_enabled() const
+  {
+    return min_batch_bytes > 0 || adaptive;
+  }
+};
+
 /**
 * This class is responsible for consuming the cache using provided fuction.
 * It can work with any callback conforming to the consume_callback_function_t
@@ -58,17 +88,31 @@ namespace cache
 * in each loop iteration as a separate transaction. This results in a balancing
 * mechanism for high-performance cases, where transaction size can be increased
 * dynamically as previous, smaller transactions introduce delays in loop iteration.
+* With WriteBatchingOptions, swapped buffers are collected into batches of a configured or
+* throughput-derived size instead, bounded by a maximum latency.
 */
 class ROSBAG2_CPP_PUBLIC CacheConsumer
 {
 public:
   using consume_callback_function_t = std::function<void (const
       std::vector<CacheBufferInterface::buffer_element_t> &)>;
+  using periodic_callback_function_t = std::function<void ()>;
 
   CacheConsumer(
     std::shared_ptr<MessageCacheInterface> message_cache,
     consume_callback_function_t consume_callback);
 
+  /// \param thread_scheduling Scheduling applied to the consumer thread
+  /// \param periodic_callback Called on the consumer thread after every consume iteration and
+  /// at least every periodic_interval while no messages arrive, e.g. to commit written data
+  CacheConsumer(
+    std::shared_ptr<MessageCacheInterface> message_cache,
+    consume_callback_function_t consume_callback,
+    const WriteBatchingOptions & batching_options,
+    const ThreadScheduling & thread_scheduling = ThreadScheduling{},
+    periodic_callback_function_t periodic_callback = nullptr,
+    std::chrono::milliseconds periodic_interval = std::chrono::milliseconds(100));
+
   ~CacheConsumer();
 
   /// \brief start inner consumer thread if it hasn't been started yet
@@ -77,13 +121,40 @@ public:
   /// \brief shut down the consumer thread
   void stop();
 
+  /// \return batch size in bytes the consumer currently aims for. 0 without batching.
+  size_t get_target_batch_bytes() const;
+
 private:
   std::shared_ptr<MessageCacheInterface> message_cache_;
   consume_callback_function_t consume_callback_;
 
+  /// Start the consumer thread with thread_scheduling_
+  void start_consumer_thread();
+
   /// Write buffer data to a storage
   void exec_consuming();
 
+  /// Write buffer data to a storage in batches as configured by batching_options_
+  void exec_consuming_batched();
+
+  /// Hand the pending batch to the consume callback, split by max_batch_bytes
+  void consume_pending_batch();
+
+  /// Adapt target_batch_bytes_ to the throughput observed for the last batch
+  void update_target_batch_bytes(size_t batch_bytes, std::chrono::nanoseconds duration);
+
+  /// Wait for data until deadline, or at most until the next periodic callback is due
+  void wait_for_data_until(std::chrono::steady_clock::time_point deadline);
+
+  const WriteBatchingOptions batching_options_;
+  const ThreadScheduling thread_scheduling_;
+  periodic_callback_function_t periodic_callback_;
+  const std::chrono::milliseconds periodic_interval_;
+  std::vector<CacheBufferInterface::buffer_element_t> pending_batch_;
+  size_t pending_batch_bytes_ {0};
+  std::atomic<size_t> target_batch_bytes_ {0};
+  double consume_bytes_per_second_ {0.0};
+
   /// Consumer thread shutdown sync
   std::atomic_bool is_stop_issued_ {false};
   std::thread consumer_thread_;
@@ -0,0 +1,68 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__CACHE_OVERFLOW_POLICY_HPP_
+#define ROSBAG2_CPP__CACHE__CACHE_OVERFLOW_POLICY_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/**
+ * Behaviour of a message cache when a message is pushed while the cache is full.
+ */
+enum class ROSBAG2_CPP_PUBLIC CacheOverflowPolicy: uint32_t
+{
+  /// The new message is dropped and counted as lost.
+  DROP_NEWEST = 0,
+  /// The oldest messages not yet handed to the consumer are dropped to make room.
+  DROP_OLDEST,
+  /// The producer waits until the consumer frees space, up to a timeout.
+  BLOCK,
+  /// The message and all following ones are appended to a spill file until the consumer
+  /// caught up. Messages are only dropped if the spill file is full as well.
+  SPILL_TO_DISK,
+  LAST_POLICY = SPILL_TO_DISK
+};
+
+/**
+ * Converts a string into a rosbag2_cpp::cache::CacheOverflowPolicy enum.
+ *
+ * \param policy A case insensitive string, one of "drop_newest", "drop_oldest", "block" or
+ * "spill_to_disk".
+ * An empty string selects DROP_NEWEST.
+ * \return The corresponding CacheOverflowPolicy.
+ * \throws std::invalid_argument if policy is not a known overflow policy.
+ */
+ROSBAG2_CPP_PUBLIC CacheOverflowPolicy cache_overflow_policy_from_string(
+  const std::string & policy);
+
+/**
+ * Converts a rosbag2_cpp::cache::CacheOverflowPolicy enum into a string.
+ *
+ * \param policy A CacheOverflowPolicy enum.
+ * \return The corresponding policy as a lowercase string.
+ */
+ROSBAG2_CPP_PUBLIC std::string cache_overflow_policy_to_string(CacheOverflowPolicy policy);
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#endif  // ROSBAG2_CPP__CACHE__CACHE_OVERFLOW_POLICY_HPP_
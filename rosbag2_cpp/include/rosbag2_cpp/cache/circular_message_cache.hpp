@@ -16,14 +16,19 @@
 #define ROSBAG2_CPP__CACHE__CIRCULAR_MESSAGE_CACHE_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "rcpputils/thread_safety_annotations.hpp"
 
-#include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
@@ -45,18 +50,47 @@ namespace cache
 
 /// Provides a "deferred-consumption" implementation of the MessageCacheInterface.
 /// When a consumer asks for a buffer, it will not receive a new buffer until some control
-/// source calls `swap_buffers` manually.
+/// source calls `notify_data_ready` to take a snapshot.
 /// This is useful for a snapshot mode, where no data is written to disk until asked for,
-/// then the full circular buffer is dumped all at once, giving historical context.
+/// then the messages of the recent past are dumped all at once, giving historical context.
+///
+/// The messages are kept in a ring of segments, bounded by max_buffer_size bytes and,
+/// optionally, by the time between the oldest and the newest message. A snapshot refers to the
+/// segments of the current window without copying the messages, and leaves them in the ring,
+/// so snapshots may overlap. Snapshots are queued for the consumer, so that taking another
+/// snapshot never waits for the previous one to be consumed.
+///
+/// With a post-trigger duration, the messages pushed after a snapshot are streamed to the
+/// consumer as a continuation of the snapshot, until their time stamp is more than the
+/// post-trigger duration after the newest message of the snapshot.
+///
+/// With contiguous payloads, the payloads of the kept messages are copied into blocks of bytes
+/// which are allocated when the cache is created and reused, one after the other, and the ring
+/// keeps a compact index of their positions, time stamps and topics instead of the messages.
+/// This avoids an allocation per kept message and the overhead of the messages, which
+/// dominates for small messages. Snapshot messages refer to the payloads in the blocks without
+/// copying them.
 class ROSBAG2_CPP_PUBLIC CircularMessageCache
   : public MessageCacheInterface
 {
 public:
-  explicit CircularMessageCache(size_t max_buffer_size);
+  /// \param max_buffer_size Maximum memory held by the kept messages, in bytes.
+  /// \param max_duration Maximum time between the time stamps of the oldest and the newest kept
+  /// message, or 0 to only bound the kept messages by size.
+  /// \param post_trigger_duration Time after a snapshot during which pushed messages are
+  /// streamed to the consumer as a continuation of the snapshot, or 0 to not stream them.
+  /// \param contiguous_payloads Whether to copy the payloads of the kept messages into
+  /// contiguous blocks, see above. The kept messages are then bounded by the size of their
+  /// payloads and index entries instead of the memory the messages hold.
+  explicit CircularMessageCache(
+    size_t max_buffer_size,
+    std::chrono::nanoseconds max_duration = std::chrono::nanoseconds(0),
+    std::chrono::nanoseconds post_trigger_duration = std::chrono::nanoseconds(0),
+    bool contiguous_payloads = false);
 
   ~CircularMessageCache() override;
 
-  /// Puts msg into circular buffer, replacing the oldest msg when buffer is full
+  /// Puts msg into the ring, dropping the oldest messages which are out of bounds
   void push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) override;
 
   /// Get current buffer to consume.
@@ -68,31 +102,136 @@ public:
   /// Unlock access to the consumer buffer.
   void release_consumer_buffer() override RCPPUTILS_TSA_RELEASE(consumer_buffer_mutex_);
 
-  /// \brief Blocks current thread and going to wait on condition variable until notify_data_ready
-  /// will be called.
+  /// \brief Blocks current thread and going to wait on condition variable until a snapshot is
+  /// taken or flushing begins.
   void wait_for_data() override;
 
-  /// Swap the primary and secondary buffer before consumption.
-  /// NOTE: If swap_buffers is called again before consuming via get_consumer_buffer,
-  /// that data will be cleared for use by the producer.
+  /// Move the oldest snapshot which was not consumed yet, or else the messages streamed since
+  /// the last swap, into the consumer buffer.
+  /// The consumer buffer is cleared if there is none.
   void swap_buffers() override;
 
+  /// \return true if the consumer buffer continues the snapshot of the previous consumer buffer
+  /// with streamed messages, false if it starts a new snapshot.
+  /// Only valid between get_consumer_buffer and release_consumer_buffer.
+  bool consumer_buffer_continues_snapshot() const;
+
   /// Signal wait_for_data to wake up and unblock consumer thread on exit or during bag split
   void begin_flushing() override;
 
   /// Notify that flushing is complete
   void done_flushing() override;
 
-  /// Snapshot API: notify cache consumer to wake-up for dumping buffer
+  /// Snapshot API: take a snapshot of the kept messages and wake up the cache consumer to dump
+  /// it, then start streaming messages if there is a post-trigger duration. Ends streaming the
+  /// previous snapshot. Does nothing if no messages are kept and nothing would be streamed.
   void notify_data_ready() override;
 
+  /// \return true if snapshots or streamed messages are waiting to be moved into the consumer
+  /// buffer.
+  bool has_pending_data() override;
+
 private:
-  std::shared_ptr<MessageCacheCircularBuffer> producer_buffer_;
+  // Bytes the payloads are copied into, see PayloadBlockPool in the implementation
+  struct PayloadBlock;
+  struct PayloadBlockPool;
+
+  // Message whose payload was copied into a payload block
+  struct MessageEntry
+  {
+    size_t offset = 0;
+    size_t size = 0;
+    rcutils_time_point_value_t time_stamp = 0;
+    rcutils_time_point_value_t send_timestamp = 0;
+    uint64_t sequence_number = 0;
+    uint32_t topic_id = 0;
+    // Index of the topic name in topic_names_
+    uint32_t topic_index = 0;
+  };
+
+  struct Segment
+  {
+    // The messages, or with contiguous payloads the entries of the messages in block
+    std::vector<CacheBufferInterface::buffer_element_t> messages;
+    std::shared_ptr<PayloadBlock> block;
+    std::vector<MessageEntry> entries;
+    size_t bytes = 0;
+
+    size_t size() const;
+    rcutils_time_point_value_t time_stamp(size_t index) const;
+    // Bytes the message at index is accounted with
+    size_t message_bytes(size_t index) const;
+  };
+
+  // Messages of a segment from the first one on
+  struct SegmentView
+  {
+    std::shared_ptr<Segment> segment;
+    size_t first = 0;
+  };
+
+  struct Snapshot
+  {
+    std::vector<SegmentView> segments;
+    // Messages streamed after the snapshot was taken
+    std::vector<CacheBufferInterface::buffer_element_t> streamed_messages;
+    bool continues_previous = false;
+    // Names of the topics of the message entries
+    std::shared_ptr<const std::vector<std::string>> topic_names;
+  };
+
+  // Copy the payload of msg into the current payload block and append its entry to the ring
+  void push_contiguous(const rosbag2_storage::SerializedBagMessage & msg, size_t msg_size)
+  RCPPUTILS_TSA_REQUIRES(producer_buffer_mutex_);
+
+  // Index of topic_name in topic_names_, which is added if it is new
+  uint32_t get_topic_index(const std::string & topic_name)
+  RCPPUTILS_TSA_REQUIRES(producer_buffer_mutex_);
+
+  // Queue the messages streamed so far as a continuation of the last snapshot
+  void queue_streamed_messages() RCPPUTILS_TSA_REQUIRES(producer_buffer_mutex_);
+
+  // Drop the oldest message of the ring
+  void drop_oldest() RCPPUTILS_TSA_REQUIRES(producer_buffer_mutex_);
+
+  const size_t max_bytes_size_;
+  const std::chrono::nanoseconds max_duration_;
+  const std::chrono::nanoseconds post_trigger_duration_;
+  // A segment is sealed and no longer appended to once it reaches this size or is snapshotted
+  const size_t max_segment_bytes_size_;
+  const bool contiguous_payloads_;
+
   std::mutex producer_buffer_mutex_;
-  std::shared_ptr<MessageCacheCircularBuffer> consumer_buffer_;
+  std::deque<SegmentView> segments_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+  // Whether new messages are appended to the last segment
+  bool last_segment_open_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_) = false;
+  size_t buffer_bytes_size_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_) = 0;
+  std::deque<Snapshot> pending_snapshots_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+
+  // Block new payloads are copied into, after its first current_block_used_ bytes. Segments
+  // following each other share the block until it is full.
+  std::shared_ptr<PayloadBlock> current_block_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+  size_t current_block_used_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_) = 0;
+  std::shared_ptr<PayloadBlockPool> block_pool_;
+  // Replaced by a copy when a topic is added, so that snapshots keep the names they refer to
+  std::shared_ptr<const std::vector<std::string>> topic_names_
+  RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+  std::unordered_map<std::string, uint32_t> topic_indices_
+  RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+
+  // Whether pushed messages are streamed, until the time stamp stream_end_ if it is known
+  bool streaming_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_) = false;
+  std::optional<rcutils_time_point_value_t> stream_end_ RCPPUTILS_TSA_GUARDED_BY(
+    producer_buffer_mutex_);
+  // Whether the streamed messages follow a snapshot which was queued or consumed already
+  bool stream_continues_snapshot_ RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_) = false;
+  std::vector<CacheBufferInterface::buffer_element_t> streamed_messages_
+  RCPPUTILS_TSA_GUARDED_BY(producer_buffer_mutex_);
+
+  std::shared_ptr<CacheBufferInterface> consumer_buffer_;
+  bool consumer_buffer_continues_snapshot_ = false;
   std::mutex consumer_buffer_mutex_;
 
-  bool data_ready_ {false};
   std::condition_variable cache_condition_var_;
 
   /// Synchronization flag. Needs for unblock wait_for_data on exit.
@@ -0,0 +1,165 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__LOCK_FREE_MESSAGE_CACHE_HPP_
+#define ROSBAG2_CPP__CACHE__LOCK_FREE_MESSAGE_CACHE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rcpputils/thread_safety_annotations.hpp"
+
+#include "rosbag2_cpp/cache/message_cache_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+/**
+* Message cache backed by a bounded lock-free multi-producer single-consumer ring.
+*
+* Producers (subscription callbacks, possibly running on several executor threads) never take a
+* lock on the regular path: a slot is reserved with a single compare-and-swap and the message is
+* published with a release store of the slot sequence number.
+* The consumer drains the ring into its own buffer in swap_buffers(), so producers are never
+* blocked by the consumer either.
+*
+* Like MessageCache, the cache is limited by the total byte size of the messages it holds
+* (max_buffer_size). Additionally the ring has a fixed number of slots (max_message_count).
+* Messages pushed while one of these limits is reached are dropped and accounted per topic.
+*/
+class ROSBAG2_CPP_PUBLIC LockFreeMessageCache
+  : public MessageCacheInterface
+{
+public:
+  static constexpr size_t kDefaultMaxMessageCount = 64 * 1024;
+
+  /// \param max_buffer_size Maximum number of bytes held by the cache.
+  /// \param max_message_count Number of ring slots, rounded up to a power of two.
+  explicit LockFreeMessageCache(
+    size_t max_buffer_size,
+    size_t max_message_count = kDefaultMaxMessageCount);
+
+  ~LockFreeMessageCache() override;
+
+  /// Puts msg into the ring. With full cache, msg is ignored and counted as lost.
+  void push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) override;
+
+  /// Gets the consumer buffer filled by the last call to swap_buffers().
+  std::shared_ptr<CacheBufferInterface>
+  get_consumer_buffer() override RCPPUTILS_TSA_ACQUIRE(consumer_buffer_mutex_);
+
+  /// \brief Signals that the consumer is done consuming.
+  void release_consumer_buffer() override RCPPUTILS_TSA_RELEASE(consumer_buffer_mutex_);
+
+  /// \brief Blocks current thread until there is data in the ring or the cache is flushing.
+  void wait_for_data() override;
+
+  /// \brief Same as wait_for_data(), but returns at deadline at the latest.
+  void wait_for_data_until(std::chrono::steady_clock::time_point deadline) override;
+
+  /// Move all messages currently published in the ring into the consumer buffer.
+  void swap_buffers() override;
+
+  /// Set the cache to consume-only mode for final buffer flush before closing
+  void begin_flushing() override;
+
+  /// Notify that flushing is complete
+  void done_flushing() override;
+
+  /// Summarize dropped/remaining messages
+  void log_dropped() override;
+
+  uint64_t get_dropped_message_count() const override;
+
+  /// Producer API: notify consumer to wake-up
+  void notify_data_ready() override;
+
+  /// \return number of messages waiting in the ring.
+  size_t size() const;
+
+  /// \return bytes held by the ring and the consumer buffer together.
+  size_t get_memory_bytes() override;
+
+  size_t get_peak_memory_bytes() override;
+
+protected:
+  /// Dropped messages per topic. Used for printing in alphabetic order
+  std::unordered_map<std::string, uint32_t> messages_dropped_per_topic_;
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg;
+  };
+
+  bool try_enqueue(const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg);
+  bool try_dequeue(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg);
+  bool has_published_data() const;
+  void count_dropped(const std::string & topic_name);
+
+  const size_t max_bytes_size_;
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Producer and consumer positions live on different cache lines to avoid false sharing.
+  alignas(64) std::atomic<size_t> enqueue_pos_ {0};
+  alignas(64) std::atomic<size_t> dequeue_pos_ {0};
+  alignas(64) std::atomic<size_t> buffer_bytes_size_ {0};
+  alignas(64) std::atomic<size_t> peak_memory_bytes_ {0};
+
+  std::mutex dropped_mutex_;
+  std::atomic<uint64_t> dropped_message_count_ {0};
+
+  std::shared_ptr<MessageCacheBuffer> consumer_buffer_;
+  std::mutex consumer_buffer_mutex_;
+
+  /// Consumer wake-up. Producers only touch the mutex when the consumer is actually sleeping.
+  std::mutex wait_mutex_;
+  std::condition_variable cache_condition_var_;
+  std::atomic_bool consumer_waiting_ {false};
+  std::atomic_bool data_ready_ {false};
+
+  /// Cache is in the process of flushing
+  std::atomic_bool flushing_ {false};
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__LOCK_FREE_MESSAGE_CACHE_HPP_
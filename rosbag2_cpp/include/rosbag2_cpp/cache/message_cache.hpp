@@ -16,7 +16,9 @@
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_HPP_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <unordered_map>
 #include <memory>
 #include <mutex>
@@ -25,8 +27,12 @@
 
 #include "rcpputils/thread_safety_annotations.hpp"
 
+#include "rosbag2_cpp/cache/cache_overflow_policy.hpp"
 #include "rosbag2_cpp/cache/message_cache_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_priority_buffer.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/cache/spill_file.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
@@ -66,6 +72,20 @@ namespace cache
 * The cache holds infomation about dropped messages (per topic). These are
 * messages that were pushed to the cache when it was full. Such situation signals
 * performance issues, most likely with the CacheConsumer consumer callback.
+*
+* What happens to a message pushed into a full cache is set by the CacheOverflowPolicy:
+* it is dropped (DROP_NEWEST, the default), the oldest messages of the producer buffer are
+* dropped to make room for it (DROP_OLDEST), or the producer waits until the consumer swaps
+* the buffers (BLOCK). The time producers spend blocked is accumulated and logged on close.
+*
+* With SPILL_TO_DISK, the message and every following one are appended to a SpillFile while
+* the producer buffer stays frozen. Once the consumer has taken the frozen buffer, it reads
+* the spilled messages back in batches of at most max_buffer_size bytes, in order, until the
+* spill file is empty and producers return to the in-memory buffer.
+*
+* With topic priorities, DROP_NEWEST makes room for a message in the full producer buffer by
+* dropping the oldest messages of topics with a lower priority first, see
+* MessageCachePriorityBuffer. Drops are then also accounted per priority.
 */
 class ROSBAG2_CPP_PUBLIC MessageCache
   : public MessageCacheInterface
@@ -73,9 +93,26 @@ class ROSBAG2_CPP_PUBLIC MessageCache
 public:
   explicit MessageCache(size_t max_buffer_size);
 
+  /// \param max_buffer_size Maximum number of bytes held by each of the buffers.
+  /// \param overflow_policy Behaviour of push() while the producer buffer is full.
+  /// \param block_timeout Maximum time push() waits for free space with
+  /// CacheOverflowPolicy::BLOCK before dropping the message. Zero waits without limit.
+  /// \param spill_file Overflow tier, required for CacheOverflowPolicy::SPILL_TO_DISK.
+  /// \param topic_priorities Priority of topics, higher values are dropped last. Topics which
+  /// are not listed have priority 0. Empty drops messages regardless of their topic.
+  /// \throws std::invalid_argument if SPILL_TO_DISK is requested without spill_file, or if
+  /// topic_priorities are given with another overflow policy than DROP_NEWEST.
+  MessageCache(
+    size_t max_buffer_size,
+    CacheOverflowPolicy overflow_policy,
+    std::chrono::milliseconds block_timeout = std::chrono::milliseconds(0),
+    std::shared_ptr<SpillFile> spill_file = nullptr,
+    const std::unordered_map<std::string, uint32_t> & topic_priorities = {});
+
   ~MessageCache() override;
 
-  /// Puts msg into primary buffer. With full cache, msg is ignored and counted as lost
+  /// Puts msg into primary buffer. With full cache, the overflow policy decides whether msg or
+  /// older messages are counted as lost, or whether the call blocks until there is space.
   void push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) override;
 
   /// Gets a consumer buffer.
@@ -90,6 +127,9 @@ public:
   /// will be called.
   void wait_for_data() override;
 
+  /// \brief Same as wait_for_data(), but returns at deadline at the latest.
+  void wait_for_data_until(std::chrono::steady_clock::time_point deadline) override;
+
   /**
   * Consumer API: wait until primary buffer is ready and swap it with consumer buffer.
   * The caller thread (consumer thread) will sleep on a conditional variable
@@ -108,20 +148,78 @@ public:
   /// Summarize dropped/remaining messages
   void log_dropped() override;
 
+  uint64_t get_dropped_message_count() const override;
+
+  std::map<uint32_t, uint64_t> get_dropped_message_counts_per_priority() const override;
+
   /// Producer API: notify consumer to wake-up (primary buffer has data)
   void notify_data_ready() override;
 
+  CacheOverflowPolicy get_overflow_policy() const override;
+
+  std::chrono::nanoseconds get_time_blocked() const override;
+
+  /// \return number of push() calls which had to wait for free space.
+  uint64_t get_blocked_push_count() const;
+
+  /// \return true while spilled messages wait to be handed to the consumer.
+  bool has_pending_data() override;
+
+  /// \return number of messages which were written to the spill file.
+  uint64_t get_spilled_message_count() const;
+
+  /// \return bytes held by the producer and the consumer buffer together.
+  size_t get_memory_bytes() override;
+
+  size_t get_peak_memory_bytes() override;
+
 protected:
   /// Dropped messages per topic. Used for printing in alphabetic order
   std::unordered_map<std::string, uint32_t> messages_dropped_per_topic_;
 
 private:
+  /// Wait for the consumer to swap the buffers and retry pushing msg, within block_timeout_
+  bool push_blocking(
+    std::unique_lock<std::mutex> & producer_lock,
+    const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg);
+
+  /// Move the next batch of spilled messages into the consumer buffer
+  void read_spilled_messages();
+
+  /// Record the bytes held by both buffers as new peak if they exceed it
+  void update_peak_memory_bytes();
+
+  /// Account a message dropped by the producer buffer or rejected by push()
+  void count_dropped(const rosbag2_storage::SerializedBagMessage & msg);
+
+  const size_t max_buffer_size_;
+  const CacheOverflowPolicy overflow_policy_;
+  const std::chrono::milliseconds block_timeout_;
+
+  /// Overflow tier. While spilling, producers append to the spill file instead of the
+  /// producer buffer to keep the order of messages.
+  std::shared_ptr<SpillFile> spill_file_;
+  bool spilling_ {false};
+  std::atomic<uint64_t> spilled_message_count_ {0};
+  size_t spill_file_peak_bytes_ {0};
+
   /// Double buffers
-  std::shared_ptr<MessageCacheBuffer> producer_buffer_;
+  std::shared_ptr<CacheBufferInterface> producer_buffer_;
   std::mutex producer_buffer_mutex_;
-  std::shared_ptr<MessageCacheBuffer> consumer_buffer_;
+  std::shared_ptr<CacheBufferInterface> consumer_buffer_;
   std::mutex consumer_buffer_mutex_;
 
+  /// Producers blocked by a full buffer wait for the next swap
+  std::condition_variable buffers_swapped_condition_var_;
+  uint64_t swap_count_ {0};
+  std::atomic<int64_t> time_blocked_ns_ {0};
+  std::atomic<uint64_t> blocked_push_count_ {0};
+  std::atomic<uint64_t> dropped_message_count_ {0};
+  /// Set if topics have priorities, dropped messages are counted per priority class then
+  std::shared_ptr<const CachePriorityClasses> priority_classes_;
+  std::vector<std::atomic<uint64_t>> dropped_message_counts_per_class_;
+  std::atomic<size_t> peak_memory_bytes_ {0};
+
   /// Double buffers sync (following cpp core guidelines for condition variables)
   bool data_ready_ {false};
   std::condition_variable cache_condition_var_;
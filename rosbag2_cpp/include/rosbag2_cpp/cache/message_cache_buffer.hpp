@@ -38,9 +38,10 @@ namespace cache
 /**
 * This class implements a single buffer for message cache. The buffer is byte size
 * limited and won't accept any messages when current buffer byte size is already
-* over the limit set by max_cache_size. This means that buffer can at times use
-* more memory than max_cache_size, but never by more than a single message. When
-* the buffer is full, the next incoming message is dropped.
+* over the limit set by max_cache_size. Messages are accounted with the memory they hold,
+* including the unused capacity of their serialized data and per message overhead. This means
+* that buffer can at times use more memory than max_cache_size, but never by more than a single
+* message. When the buffer is full, the next incoming message is dropped.
 *
 * Note that it could be reused as a template with any class that has
 * ->byte_size() - like interface
@@ -67,9 +68,15 @@ public:
   /// Get buffer data
   const std::vector<CacheBufferInterface::buffer_element_t> & data() override;
 
+  size_t get_bytes_size() const override;
+
+  /// Get the largest number of bytes the buffer held since its construction
+  size_t get_peak_bytes_size() const;
+
 private:
   std::vector<CacheBufferInterface::buffer_element_t> buffer_;
-  size_t buffer_bytes_size_ {0u};
+  std::atomic<size_t> buffer_bytes_size_ {0u};
+  std::atomic<size_t> peak_bytes_size_ {0u};
   const size_t max_bytes_size_;
 
   /// set when buffer is full and should drop messages instead of inserting them
@@ -15,7 +15,9 @@
 #ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_CIRCULAR_BUFFER_HPP_
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_CIRCULAR_BUFFER_HPP_
 
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -43,7 +45,8 @@ namespace cache
 * older messages can always be dropped from the front and new messages added
 * to the end. The buffer will never consume more than max_cache_size bytes,
 * and will log a warning message if an individual message exceeds the buffer
-* size.
+* size. Messages are accounted with the memory they hold, including the unused
+* capacity of their serialized data and per message overhead.
 */
 class ROSBAG2_CPP_PUBLIC MessageCacheCircularBuffer
   : public CacheBufferInterface
@@ -53,6 +56,11 @@ public:
   MessageCacheCircularBuffer() = delete;
   explicit MessageCacheCircularBuffer(size_t max_cache_size);
 
+  /// Callback invoked with every message dropped from the front of the buffer.
+  using drop_callback_t = std::function<void (const CacheBufferInterface::buffer_element_t &)>;
+
+  MessageCacheCircularBuffer(size_t max_cache_size, drop_callback_t on_message_dropped);
+
   /**
   * If buffer size has some space left, we push the message regardless of its size,
   *  but if this results in exceeding buffer size, we begin dropping old messages.
@@ -68,11 +76,14 @@ public:
   /// Get buffer data
   const std::vector<CacheBufferInterface::buffer_element_t> & data() override;
 
+  size_t get_bytes_size() const override;
+
 private:
   std::deque<CacheBufferInterface::buffer_element_t> buffer_;
   std::vector<CacheBufferInterface::buffer_element_t> msg_vector_;
-  size_t buffer_bytes_size_ {0u};
+  std::atomic<size_t> buffer_bytes_size_ {0u};
   const size_t max_bytes_size_;
+  drop_callback_t on_message_dropped_;
 };
 
 }  // namespace cache
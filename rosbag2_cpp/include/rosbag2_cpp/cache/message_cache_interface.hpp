@@ -15,10 +15,14 @@
 #ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_INTERFACE_HPP_
 #define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_INTERFACE_HPP_
 
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <memory>
 
 #include "rosbag2_cpp/visibility_control.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/cache_overflow_policy.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 namespace rosbag2_cpp
@@ -56,6 +60,14 @@ public:
   /// \brief Blocks current thread and going to wait until notify_data_ready will be called.
   virtual void wait_for_data() {}
 
+  /// \brief Same as wait_for_data(), but returns at deadline at the latest.
+  /// Implementations without deadline support fall back to wait_for_data().
+  virtual void wait_for_data_until(std::chrono::steady_clock::time_point deadline)
+  {
+    (void)deadline;
+    wait_for_data();
+  }
+
   /// Swap producer and consumer buffers.
   /// Note: this will block if `get_consumer_buffer` has been called but `release_consumer_buffer`
   /// has not been called yet to signal end of consuming.
@@ -70,8 +82,53 @@ public:
   /// Print a log message with details of any dropped messages.
   virtual void log_dropped() {}
 
+  /// \return number of messages dropped since the cache was created, over all topics.
+  virtual uint64_t get_dropped_message_count() const
+  {
+    return 0u;
+  }
+
+  /// \return number of messages dropped since the cache was created, per topic priority.
+  /// Empty if the cache does not drop by priority.
+  virtual std::map<uint32_t, uint64_t> get_dropped_message_counts_per_priority() const
+  {
+    return {};
+  }
+
   /// \brief Producer API: notify wait_for_data() to wake up and unblock consumer thread.
   virtual void notify_data_ready() {}
+
+  /// \return how push() handles messages while the cache is full.
+  virtual CacheOverflowPolicy get_overflow_policy() const
+  {
+    return CacheOverflowPolicy::DROP_NEWEST;
+  }
+
+  /// \return true if the cache holds messages outside of its buffers, e.g. spilled to disk,
+  /// which need further swap_buffers() calls to reach the consumer.
+  virtual bool has_pending_data()
+  {
+    return false;
+  }
+
+  /// \return total time producers spent blocked in push() waiting for free space.
+  virtual std::chrono::nanoseconds get_time_blocked() const
+  {
+    return std::chrono::nanoseconds(0);
+  }
+
+  /// \return memory currently held by the cached messages, in bytes, including the unused
+  /// capacity of their serialized data and per message overhead.
+  virtual size_t get_memory_bytes()
+  {
+    return 0u;
+  }
+
+  /// \return largest value of get_memory_bytes() since the cache was created.
+  virtual size_t get_peak_memory_bytes()
+  {
+    return 0u;
+  }
 };
 
 }  // namespace cache
@@ -0,0 +1,129 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__MESSAGE_CACHE_PRIORITY_BUFFER_HPP_
+#define ROSBAG2_CPP__CACHE__MESSAGE_CACHE_PRIORITY_BUFFER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/**
+* Priority classes of the topics of a message cache.
+*
+* Every distinct priority is a class, numbered from the lowest priority up. Topics which are
+* not listed have priority 0.
+*/
+class ROSBAG2_CPP_PUBLIC CachePriorityClasses
+{
+public:
+  explicit CachePriorityClasses(
+    const std::unordered_map<std::string, uint32_t> & topic_priorities);
+
+  size_t class_of(const std::string & topic_name) const;
+
+  size_t class_count() const;
+
+  uint32_t priority_of_class(size_t priority_class) const;
+
+private:
+  std::unordered_map<std::string, size_t> topic_classes_;
+  // Ascending
+  std::vector<uint32_t> priorities_;
+  size_t default_class_ = 0;
+};
+
+/**
+* This class implements a byte size limited cache buffer which drops messages of low priority
+* topics first.
+*
+* Like MessageCacheBuffer, the buffer accepts messages until it holds max_cache_size bytes or
+* more. A message pushed into the full buffer evicts the oldest messages of lower priority
+* classes, lowest class first, until the buffer is below max_cache_size again. If the lower
+* classes do not free enough, the message is rejected. Every class has a queue of its own, so
+* an eviction takes constant time in the number of cached messages.
+*/
+class ROSBAG2_CPP_PUBLIC MessageCachePriorityBuffer
+  : public CacheBufferInterface
+{
+public:
+  /// Callback invoked with every message evicted to make room for a message of higher priority.
+  using drop_callback_t = std::function<void (const CacheBufferInterface::buffer_element_t &)>;
+
+  MessageCachePriorityBuffer(
+    size_t max_cache_size,
+    std::shared_ptr<const CachePriorityClasses> priority_classes,
+    drop_callback_t on_message_evicted = nullptr);
+
+  bool push(CacheBufferInterface::buffer_element_t msg) override;
+
+  /// Clear buffer
+  void clear() override;
+
+  /// Get number of elements in the buffer
+  size_t size() override;
+
+  /// Get buffer data, in the order the messages were pushed
+  const std::vector<CacheBufferInterface::buffer_element_t> & data() override;
+
+  size_t get_bytes_size() const override;
+
+private:
+  struct Entry
+  {
+    uint64_t sequence;
+    CacheBufferInterface::buffer_element_t message;
+  };
+
+  const size_t max_bytes_size_;
+  const std::shared_ptr<const CachePriorityClasses> priority_classes_;
+  drop_callback_t on_message_evicted_;
+  // Indexed by priority class
+  std::vector<std::deque<Entry>> queues_;
+  std::vector<CacheBufferInterface::buffer_element_t> msg_vector_;
+  std::atomic<size_t> buffer_bytes_size_ {0u};
+  size_t message_count_ {0u};
+  uint64_t next_sequence_ {0u};
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__MESSAGE_CACHE_PRIORITY_BUFFER_HPP_
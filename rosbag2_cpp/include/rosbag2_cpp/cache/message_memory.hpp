@@ -0,0 +1,41 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_CPP__CACHE__MESSAGE_MEMORY_HPP_
+#define ROSBAG2_CPP__CACHE__MESSAGE_MEMORY_HPP_
+
+#include <cstddef>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/// \brief Estimate the heap memory held by a cached message.
+/// Counts the full capacity of the serialized data, which is often larger than its length,
+/// together with the message itself, the shared_ptr control blocks and the topic name.
+/// Caches use it to enforce their byte limits on the memory they actually hold.
+/// \param message Message to measure.
+/// \return allocated bytes attributed to the message.
+ROSBAG2_CPP_PUBLIC
+size_t get_message_memory_bytes(const rosbag2_storage::SerializedBagMessage & message);
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#endif  // ROSBAG2_CPP__CACHE__MESSAGE_MEMORY_HPP_
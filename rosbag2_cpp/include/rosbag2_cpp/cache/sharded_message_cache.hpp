@@ -0,0 +1,202 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__SHARDED_MESSAGE_CACHE_HPP_
+#define ROSBAG2_CPP__CACHE__SHARDED_MESSAGE_CACHE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rcpputils/thread_safety_annotations.hpp"
+
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/cache_overflow_policy.hpp"
+#include "rosbag2_cpp/cache/message_cache_buffer.hpp"
+#include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+/**
+* Message cache made of independent shards, each one with its own double buffer and byte budget.
+*
+* Messages are routed to a shard by topic: topics listed in a topic group share the shard of that
+* group, every other topic either gets a shard of its own (shard_per_topic) or goes to a common
+* default shard. A shard which is full drops only messages of its own topics, so a single
+* high-bandwidth topic can no longer cause drops on low-rate topics.
+*
+* Each shard handles overflow with its own CacheOverflowPolicy: it drops the new message
+* (DROP_NEWEST), drops its oldest messages to make room (DROP_OLDEST), or blocks the producers
+* of its topics until the consumer swapped the shard (BLOCK). SPILL_TO_DISK is not supported.
+*
+* All shards are consumed by a single consumer: swap_buffers() swaps every shard and merges
+* their content, ordered by time stamp, into one consumer buffer.
+*/
+class ROSBAG2_CPP_PUBLIC ShardedMessageCache
+  : public MessageCacheInterface
+{
+public:
+  /// \param default_shard_size Byte budget of shards which are not listed in shard_sizes.
+  /// \param shard_per_topic Give every topic which is not part of a group its own shard.
+  /// \param topic_groups Topics sharing one shard, keyed by the group name.
+  /// \param shard_sizes Byte budget per shard, keyed by group or topic name.
+  /// \param shard_policies Overflow policy per shard, keyed by group or topic name.
+  /// \param default_policy Overflow policy of shards which are not listed in shard_policies.
+  /// \param block_timeout Maximum time push() waits for free space in a shard with
+  /// CacheOverflowPolicy::BLOCK before dropping the message. Zero waits without limit.
+  /// \throws std::invalid_argument if any shard uses CacheOverflowPolicy::SPILL_TO_DISK.
+  ShardedMessageCache(
+    size_t default_shard_size,
+    bool shard_per_topic,
+    const std::unordered_map<std::string, std::vector<std::string>> & topic_groups = {},
+    const std::unordered_map<std::string, uint64_t> & shard_sizes = {},
+    const std::unordered_map<std::string, CacheOverflowPolicy> & shard_policies = {},
+    CacheOverflowPolicy default_policy = CacheOverflowPolicy::DROP_NEWEST,
+    std::chrono::milliseconds block_timeout = std::chrono::milliseconds(0));
+
+  ~ShardedMessageCache() override;
+
+  /// Puts msg into the producer buffer of its shard. With full shard, the overflow policy of
+  /// the shard decides which message is counted as lost, or whether to wait for free space.
+  void push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) override;
+
+  /// Gets the consumer buffer with the messages merged by the last swap_buffers().
+  std::shared_ptr<CacheBufferInterface>
+  get_consumer_buffer() override RCPPUTILS_TSA_ACQUIRE(consumer_buffer_mutex_);
+
+  /// \brief Signals that the consumer is done consuming.
+  void release_consumer_buffer() override RCPPUTILS_TSA_RELEASE(consumer_buffer_mutex_);
+
+  /// \brief Blocks current thread until data was pushed to any of the shards.
+  void wait_for_data() override;
+
+  /// \brief Same as wait_for_data(), but returns at deadline at the latest.
+  void wait_for_data_until(std::chrono::steady_clock::time_point deadline) override;
+
+  /// Swap the buffers of all shards and merge their content into the consumer buffer.
+  void swap_buffers() override;
+
+  /// Set the cache to consume-only mode for final buffer flush before closing
+  void begin_flushing() override;
+
+  /// Notify that flushing is complete
+  void done_flushing() override;
+
+  /// Summarize dropped/remaining messages
+  void log_dropped() override;
+
+  uint64_t get_dropped_message_count() const override;
+
+  /// \return total time producers spent blocked in push() waiting for free space in a shard.
+  std::chrono::nanoseconds get_time_blocked() const override;
+
+  /// Producer API: notify consumer to wake-up
+  void notify_data_ready() override;
+
+  /// \return name of the shard messages of topic_name are cached in.
+  std::string get_shard_name(const std::string & topic_name) const;
+
+  /// \return overflow policy of the shard messages of topic_name are cached in.
+  CacheOverflowPolicy get_shard_policy(const std::string & topic_name) const;
+
+  /// \return number of shards created so far.
+  size_t get_shard_count() const;
+
+  /// Name of the shard for topics which are neither grouped nor cached per topic.
+  static constexpr const char * kDefaultShardName = "";
+
+protected:
+  /// Dropped messages per topic. Used for printing in alphabetic order
+  std::unordered_map<std::string, uint32_t> get_messages_dropped_per_topic() const;
+
+private:
+  struct Shard
+  {
+    Shard(size_t max_size, CacheOverflowPolicy overflow_policy);
+
+    const CacheOverflowPolicy policy;
+    std::mutex mutex;
+    std::shared_ptr<CacheBufferInterface> producer_buffer;
+    std::shared_ptr<CacheBufferInterface> consumer_buffer;
+    std::unordered_map<std::string, uint32_t> messages_dropped_per_topic;
+    /// Incremented by every swap_buffers(), producers blocked on the shard wait for a change
+    uint64_t swap_count {0};
+    std::condition_variable swapped_condition_var;
+  };
+
+  Shard & get_shard_for_topic(const std::string & topic_name);
+
+  /// Wait for the consumer to swap the full shard, then push msg. Returns false on timeout or
+  /// flushing. The shard mutex is held by producer_lock.
+  bool push_blocking(
+    Shard & shard, std::unique_lock<std::mutex> & producer_lock,
+    const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg);
+
+  /// Wake up producers blocked on any shard
+  void notify_blocked_producers();
+
+  const size_t default_shard_size_;
+  const bool shard_per_topic_;
+  std::unordered_map<std::string, std::string> topic_to_group_;
+  const std::unordered_map<std::string, uint64_t> shard_sizes_;
+  const std::unordered_map<std::string, CacheOverflowPolicy> shard_policies_;
+  const CacheOverflowPolicy default_policy_;
+  const std::chrono::milliseconds block_timeout_;
+  std::atomic<int64_t> time_blocked_ns_ {0};
+  std::atomic<uint64_t> blocked_push_count_ {0};
+
+  /// Shards by name and the cached topic -> shard resolution
+  mutable std::shared_mutex shards_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<Shard>> shards_;
+  std::unordered_map<std::string, Shard *> topic_to_shard_;
+
+  std::shared_ptr<MessageCacheBuffer> consumer_buffer_;
+  std::mutex consumer_buffer_mutex_;
+
+  std::mutex wait_mutex_;
+  std::condition_variable cache_condition_var_;
+  std::atomic_bool consumer_waiting_ {false};
+  std::atomic_bool data_ready_ {false};
+
+  /// Cache is in the process of flushing
+  std::atomic_bool flushing_ {false};
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__SHARDED_MESSAGE_CACHE_HPP_
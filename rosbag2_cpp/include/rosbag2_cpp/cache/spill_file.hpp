@@ -0,0 +1,124 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CACHE__SPILL_FILE_HPP_
+#define ROSBAG2_CPP__CACHE__SPILL_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+/**
+* Pre-allocated, memory-mapped FIFO file used as overflow tier of the message cache.
+*
+* Messages are appended as records behind each other and read back in the same order.
+* The file is used as a ring buffer: writing wraps around to the beginning of the file and
+* records at the end of the file continue at its beginning, so the space of read records is
+* reused right away. The file holds at most capacity bytes of records which were not read yet.
+*
+* The file is created in the given directory, which is best put on a different device than
+* the bag itself, and is removed when the SpillFile is destroyed.
+* All methods are thread-safe.
+*/
+class ROSBAG2_CPP_PUBLIC SpillFile
+{
+public:
+  /// \param directory Directory to create the spill file in.
+  /// An empty string selects the temporary directory of the system.
+  /// \param capacity Size of the file in bytes. The file is allocated on construction.
+  /// \throws std::runtime_error if the file can not be created, allocated or mapped.
+  SpillFile(const std::string & directory, size_t capacity);
+
+  ~SpillFile();
+
+  SpillFile(const SpillFile &) = delete;
+  SpillFile & operator=(const SpillFile &) = delete;
+
+  /// Append msg behind the last appended message.
+  /// \return false if there is not enough space left for msg.
+  bool append(const rosbag2_storage::SerializedBagMessage & msg);
+
+  /// Read the oldest messages, until at least max_bytes of serialized data were read or the
+  /// file ran empty.
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> read(
+    size_t max_bytes);
+
+  /// \return true if all appended messages were read.
+  bool empty() const;
+
+  /// \return number of messages waiting to be read.
+  size_t size() const;
+
+  /// \return number of bytes used by messages waiting to be read.
+  size_t get_used_bytes() const;
+
+  /// \return size of the file in bytes.
+  size_t get_capacity() const;
+
+  /// \return path of the spill file.
+  const std::string & get_path() const;
+
+private:
+  void map_file();
+  void unmap_file();
+  // Copy from or to the ring buffer starting at offset, wrapping around at capacity_. The
+  // caller holds mutex_. \return the offset behind the copied bytes.
+  size_t write_at(size_t offset, const void * source, size_t length);
+  size_t read_at(size_t offset, void * destination, size_t length) const;
+
+  std::string path_;
+  const size_t capacity_;
+  uint8_t * data_ {nullptr};
+#ifdef _WIN32
+  void * file_handle_ {nullptr};
+  void * mapping_handle_ {nullptr};
+#else
+  int file_descriptor_ {-1};
+#endif
+
+  mutable std::mutex mutex_;
+  size_t write_offset_ {0};
+  size_t read_offset_ {0};
+  size_t used_bytes_ {0};
+  size_t message_count_ {0};
+};
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__CACHE__SPILL_FILE_HPP_
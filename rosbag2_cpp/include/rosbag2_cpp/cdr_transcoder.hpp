@@ -0,0 +1,90 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CDR_TRANSCODER_HPP_
+#define ROSBAG2_CPP__CDR_TRANSCODER_HPP_
+
+#include <optional>
+#include <string>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rosidl_runtime_c/message_type_support_struct.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+namespace rosbag2_cpp
+{
+
+/// Rewrites CDR serialized messages of one type into another CDR encoding, without
+/// deserializing them.
+/**
+ * The serialized message is walked along the introspection type support of its type and copied
+ * into the output in one pass, changing the byte order of primitives and the alignment and
+ * headers between XCDR1 and final XCDR2 (PLAIN_CDR2) as needed. The encoding of the input is
+ * read from its encapsulation header.
+ *
+ * Types with wide characters, wide strings or long doubles are not supported, as their
+ * serialized size differs between middleware implementations.
+ */
+class ROSBAG2_CPP_PUBLIC CdrTranscoder
+{
+public:
+  struct Encapsulation
+  {
+    bool xcdr2 = false;
+    bool big_endian = false;
+
+    bool operator==(const Encapsulation & other) const
+    {
+      return xcdr2 == other.xcdr2 && big_endian == other.big_endian;
+    }
+  };
+
+  /**
+   * Encapsulation written for a serialization format, or nullopt if the format is not transcoded.
+   *
+   * The formats are "cdr", XCDR1 in the byte order of this machine, as written by the rmw
+   * implementations, and "cdr_le", "cdr_be", "xcdr2_le" and "xcdr2_be".
+   */
+  static std::optional<Encapsulation> encapsulation_of_format(const std::string & format);
+
+  /**
+   * \param introspection_type_support Type support of the type from
+   *   rosidl_typesupport_introspection_cpp
+   * \throws std::invalid_argument if the type has members which are not supported
+   */
+  explicit CdrTranscoder(const rosidl_message_type_support_t * introspection_type_support);
+
+  /**
+   * Transcode a serialized message into an encapsulation.
+   *
+   * \param input Serialized message in any XCDR1 or PLAIN_CDR2 encapsulation
+   * \param encapsulation Encapsulation to write
+   * \param output Array to write the message to. It is resized as needed, so sizing it for the
+   *   message up front saves reallocations.
+   * \throws std::runtime_error if the input is truncated or of an unsupported encapsulation
+   */
+  void transcode(
+    const rcutils_uint8_array_t & input,
+    const Encapsulation & encapsulation,
+    rcutils_uint8_array_t & output) const;
+
+private:
+  const rosidl_message_type_support_t * introspection_type_support_;
+};
+
+}  // namespace rosbag2_cpp
+
+#endif  // ROSBAG2_CPP__CDR_TRANSCODER_HPP_
@@ -0,0 +1,161 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__CLOCKS__EXTERNAL_STEP_CLOCK_HPP_
+#define ROSBAG2_CPP__CLOCKS__EXTERNAL_STEP_CLOCK_HPP_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "rosbag2_cpp/clocks/player_clock.hpp"
+
+namespace rosbag2_cpp
+{
+
+/**
+ * Version of the PlayerClock interface whose time is advanced in steps by an external driver,
+ * such as a simulator running in lockstep with playback.
+ *
+ * Time stands still between steps. `step` advances it to a time point, after which
+ * `sleep_until` returns true at once for everything up to that time point. The first
+ * `sleep_until` past it calls the step completed callback, telling the driver that everything
+ * up to the time point was played, and then waits for the next step.
+ */
+class ExternalStepClockImpl;
+class ExternalStepClock : public PlayerClock
+{
+public:
+  /// Called with the time point of a step once it is completed.
+  using StepCompletedCallback = std::function<void (rcutils_time_point_value_t)>;
+
+  /**
+   * Constructor.
+   *
+   * \param starting_time: The initial time, until the first step.
+   * \param sleep_time_while_waiting: Amount of time to wait in `sleep_until` for the next step,
+   *   or while the clock is paused. Allows the caller to spin at a defined rate while receiving
+   *   `false`.
+   * \param start_paused: Start the clock paused
+   */
+  ROSBAG2_CPP_PUBLIC
+  ExternalStepClock(
+    rcutils_time_point_value_t starting_time,
+    std::chrono::milliseconds sleep_time_while_waiting = std::chrono::milliseconds{100},
+    bool start_paused = false);
+
+  ROSBAG2_CPP_PUBLIC
+  virtual ~ExternalStepClock();
+
+  /**
+   * Advance the time to time_point and wake any waiting `sleep_until`.
+   * A time point before the current time completes a step without moving time backwards.
+   */
+  ROSBAG2_CPP_PUBLIC
+  void step(rcutils_time_point_value_t time_point);
+
+  /// Set the callback of completed steps. It is called from the thread of `sleep_until` or
+  /// `complete_step`, without holding any lock of the clock.
+  ROSBAG2_CPP_PUBLIC
+  void set_step_completed_callback(StepCompletedCallback callback);
+
+  /**
+   * Complete the pending step, if any, e.g. once there is nothing more to play.
+   * \return true if a step was pending
+   */
+  ROSBAG2_CPP_PUBLIC
+  bool complete_step();
+
+  /**
+   * Return the time point of the last step.
+   */
+  ROSBAG2_CPP_PUBLIC
+  rcutils_time_point_value_t now() const override;
+
+  /**
+   * The time between steps is up to the driver of the clock, so a ROS time can't be matched to
+   * a steady time.
+   * \return the current steady time
+   */
+  ROSBAG2_CPP_PUBLIC
+  std::chrono::steady_clock::time_point
+  ros_to_steady(rcutils_time_point_value_t ros_time) const override;
+
+  /**
+   * Return true at once if the time of the last step has reached until.
+   * Otherwise complete the pending step, and wait for the next step for up to the sleep time.
+   *
+   * Return false while paused or if the time was not reached.
+   * The user should not take action based on this sleep until it returns true.
+   */
+  ROSBAG2_CPP_PUBLIC
+  bool sleep_until(rcutils_time_point_value_t until) override;
+
+  ROSBAG2_CPP_PUBLIC
+  bool sleep_until(rclcpp::Time until) override;
+
+  /**
+   * The flow of time is driven by the steps, so the rate has no effect. It is only kept to be
+   * returned by `get_rate`.
+   * \return false if rate is not positive, true otherwise.
+   */
+  ROSBAG2_CPP_PUBLIC
+  bool set_rate(double rate) override;
+
+  ROSBAG2_CPP_PUBLIC
+  double get_rate() const override;
+
+  /**
+   * Stop playback at the current time, even if later steps arrive.
+   * If this changes the pause state, this will wake any waiting `sleep_until`
+   */
+  ROSBAG2_CPP_PUBLIC
+  void pause() override;
+
+  /**
+   * Continue playback up to the time of the last step.
+   * If this changes the pause state, this will wake any waiting `sleep_until`
+   */
+  ROSBAG2_CPP_PUBLIC
+  void resume() override;
+
+  ROSBAG2_CPP_PUBLIC
+  bool is_paused() const override;
+
+  /**
+   * Change the current time to an arbitrary time, e.g. to restart playback.
+   * \note This will wake any waiting `sleep_until`.
+   */
+  ROSBAG2_CPP_PUBLIC
+  void jump(rcutils_time_point_value_t ros_time) override;
+
+  ROSBAG2_CPP_PUBLIC
+  void jump(rclcpp::Time ros_time) override;
+
+  /// Jumps only occur via a `jump` call by the owner of this Clock, so jump callbacks are not
+  /// handled in this clock.
+  /// \return nullptr
+  ROSBAG2_CPP_PUBLIC
+  rclcpp::JumpHandler::SharedPtr create_jump_callback(
+    rclcpp::JumpHandler::pre_callback_t pre_callback,
+    rclcpp::JumpHandler::post_callback_t post_callback,
+    const rcl_jump_threshold_t & threshold) override;
+
+private:
+  std::unique_ptr<ExternalStepClockImpl> impl_;
+};
+
+}  // namespace rosbag2_cpp
+
+#endif  // ROSBAG2_CPP__CLOCKS__EXTERNAL_STEP_CLOCK_HPP_
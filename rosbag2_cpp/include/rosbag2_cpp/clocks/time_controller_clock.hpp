@@ -42,13 +42,17 @@ public:
    * \param sleep_time_while_paused: Amount of time to sleep in `sleep_until` when the clock
    *   is paused. Allows the caller to spin at a defined rate while receiving `false`
    * \param paused: Start the clock paused
+   * \param spin_duration: Time before the end of each `sleep_until` which is spent spinning
+   *   on the thread instead of sleeping, to wake up more precisely than the scheduler does.
+   *   Defaults to sleeping the whole time.
    */
   ROSBAG2_CPP_PUBLIC
   TimeControllerClock(
     rcutils_time_point_value_t starting_time,
     NowFunction now_fn = std::chrono::steady_clock::now,
     std::chrono::milliseconds sleep_time_while_paused = std::chrono::milliseconds{100},
-    bool start_paused = false);
+    bool start_paused = false,
+    std::chrono::nanoseconds spin_duration = std::chrono::nanoseconds{0});
 
   ROSBAG2_CPP_PUBLIC
   virtual ~TimeControllerClock();
@@ -70,6 +74,7 @@ public:
 
   /**
    * Try to sleep (non-busy) the current thread until the provided time is reached - according to this Clock
+   * If a spin duration was given, the thread sleeps until that much earlier and then spins.
    *
    * Return true if the time has been reached, false if it was not successfully reached after sleeping
    * for the appropriate duration.
@@ -85,9 +90,10 @@ public:
    * Change the rate of the flow of time for the clock.
    *
    * To stop time, \sa pause.
-   * It is not currently valid behavior to move time backwards.
+   * A negative rate moves time backwards, e.g. for reverse playback. `sleep_until` then
+   * waits until the time has fallen to `until`.
    * \param rate The new rate of time
-   * \return false if rate <= 0, true otherwise.
+   * \return false if rate is 0 or NaN, true otherwise.
    */
   ROSBAG2_CPP_PUBLIC
   bool set_rate(double rate) override;
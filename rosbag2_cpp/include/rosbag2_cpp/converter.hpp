@@ -16,14 +16,18 @@
 #define ROSBAG2_CPP__CONVERTER_HPP_
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "rosbag2_cpp/cdr_transcoder.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
 #include "rosbag2_cpp/converter_interfaces/serialization_format_converter.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
+#include "rosbag2_cpp/typed_fast_paths.hpp"
+#include "rosbag2_cpp/types/introspection_message.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
@@ -50,6 +54,21 @@ struct ConverterTypeSupport
 
   std::shared_ptr<rcpputils::SharedLibrary> introspection_type_support_library;
   const rosidl_message_type_support_t * introspection_type_support;
+
+  // Message which all messages of the topic are deserialized into, allocated on first use
+  std::shared_ptr<rosbag2_introspection_message_t> introspection_message;
+  // Size of the last converted message of the topic, to allocate the next one at once
+  size_t last_serialized_size = 0;
+
+  // Rewrites the messages of the topic between CDR encodings without deserializing them, if
+  // both formats are CDR formats and the type can be transcoded
+  std::shared_ptr<CdrTranscoder> transcoder;
+
+  // Operations registered in TypedFastPathRegistry for the type, used instead of the converter
+  // plugins on the side whose format is the one of the rmw implementation
+  std::shared_ptr<TypedMessageOperations> typed_operations;
+  bool typed_input = false;
+  bool typed_output = false;
 };
 
 class ROSBAG2_CPP_PUBLIC Converter
@@ -74,6 +93,18 @@ public:
    * serialization format of the input message must be identical to the input format of the
    * converter.
    *
+   * The messages of a topic are deserialized into the same message, so that its members are
+   * not allocated again for every message, and the converted message is allocated with the
+   * size of the previous one. Hence messages must not be converted on several threads at once.
+   *
+   * Between the CDR formats of CdrTranscoder::encapsulation_of_format, messages are transcoded
+   * instead, without deserializing them. Types which can not be transcoded are converted through
+   * the rmw implementation if the output format is "cdr".
+   *
+   * Messages of types registered in TypedFastPathRegistry are deserialized or serialized
+   * through their generated code if the input or output format is the one of the rmw
+   * implementation.
+   *
    * \param message Message to convert
    * \returns Converted message
    */
@@ -83,9 +114,19 @@ public:
   void add_topic(const std::string & topic, const std::string & type);
 
 private:
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> transcode(
+    ConverterTypeSupport & type_support,
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
+
   std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_;
   std::unique_ptr<converter_interfaces::SerializationFormatDeserializer> input_converter_;
   std::unique_ptr<converter_interfaces::SerializationFormatSerializer> output_converter_;
+  // Encapsulation to transcode to, if both formats are CDR formats
+  std::optional<CdrTranscoder::Encapsulation> output_encapsulation_;
+  std::string input_format_;
+  std::string output_format_;
+  // Holds the introspection messages of all topics, so it is declared before them
+  IntrospectionMessageArena message_arena_;
   std::unordered_map<std::string, ConverterTypeSupport> topics_and_types_;
 };
 
@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_CPP__CONVERTER_OPTIONS_HPP_
 #define ROSBAG2_CPP__CONVERTER_OPTIONS_HPP_
 
+#include <cstddef>
 #include <string>
 
 namespace rosbag2_cpp
@@ -24,6 +25,10 @@ struct ConverterOptions
 {
   std::string input_serialization_format;
   std::string output_serialization_format;
+  // Number of threads converting the batches of messages which the cache writes to storage,
+  // or which are read with read_next_batch(). 0 or 1 converts every message on the thread
+  // writing or reading it.
+  size_t conversion_threads = 0;
 };
 
 }  // namespace rosbag2_cpp
@@ -0,0 +1,111 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__FIELD_EXTRACTOR_HPP_
+#define ROSBAG2_CPP__FIELD_EXTRACTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rosbag2_cpp/serialization_format_converter_factory.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+class FieldExtractorImpl;
+
+/// Reads selected fields out of serialized messages of one type, without converting the
+/// messages into any language binding.
+/**
+ * Fields are given as paths of member names separated by dots, e.g. "header.stamp.sec" or
+ * "pose.position.x". All but the last member must be nested messages and the last member must
+ * be a primitive (numeric, bool, char or octet). Arrays and strings are not supported.
+ *
+ * All messages are deserialized into the same message, which is allocated once. Hence one
+ * extractor must not be used on several threads at once. Types registered in
+ * TypedFastPathRegistry are deserialized through their generated code if the serialization
+ * format is the one of the rmw implementation.
+ */
+class ROSBAG2_CPP_PUBLIC FieldExtractor
+{
+public:
+  /**
+   * \param type Message type, e.g. "geometry_msgs/msg/PoseStamped"
+   * \param field_paths Paths of the fields to extract
+   * \param serialization_format Serialization format of the messages
+   * \throws std::invalid_argument if a field path does not name a primitive member of the type
+   * \throws std::runtime_error if the type support or the deserializer cannot be loaded
+   */
+  FieldExtractor(
+    const std::string & type,
+    const std::vector<std::string> & field_paths,
+    const std::string & serialization_format = "cdr",
+    std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory =
+    std::make_shared<SerializationFormatConverterFactory>());
+
+  ~FieldExtractor();
+
+  const std::vector<std::string> & field_paths() const;
+
+  /// Type ids (rosidl_typesupport_introspection_cpp::ROS_TYPE_*) of the fields, in order of
+  /// the field paths.
+  const std::vector<uint8_t> & field_types() const;
+
+  /// Size in bytes of a value of a primitive field type, or 0 if the type is not supported.
+  static size_t field_type_size(uint8_t type_id);
+
+  /// Paths of all fields of a type which can be extracted, in order of declaration, i.e. all
+  /// primitive members of the type and of its nested messages.
+  /// \throws std::runtime_error if the type support cannot be loaded
+  static std::vector<std::string> primitive_field_paths(const std::string & type);
+
+  /**
+   * Deserialize a message and copy the value of each field into its column.
+   *
+   * \param serialized_data Serialized message
+   * \param columns One column per field path. The value of the field is written to
+   *   columns[i] + row * field_type_size(field_types()[i]).
+   * \param row Row of the columns to write the values to
+   */
+  void extract(
+    const rcutils_uint8_array_t & serialized_data,
+    const std::vector<void *> & columns,
+    size_t row);
+
+private:
+  std::unique_ptr<FieldExtractorImpl> impl_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__FIELD_EXTRACTOR_HPP_
@@ -0,0 +1,116 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__HEADER_STAMP_INDEX_HPP_
+#define ROSBAG2_CPP__HEADER_STAMP_INDEX_HPP_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Header time stamps of the messages of a bag, per topic in order of received time stamps.
+/**
+ * The index is built in one pass over the bag, which extracts header.stamp of the messages of
+ * every topic whose type has one through the introspection type support. Messages of other
+ * topics are indexed with their received time stamp. It is stored in the bag directory, next
+ * to the metadata, and lets readers::HeaderStampOrderReader read in order of header time stamps
+ * without sorting the bag in memory.
+ */
+class ROSBAG2_CPP_PUBLIC HeaderStampIndex
+{
+public:
+  struct Entry
+  {
+    rcutils_time_point_value_t received_time_stamp;
+    rcutils_time_point_value_t header_time_stamp;
+  };
+
+  /// Name of the index file in the bag directory.
+  static constexpr const char * kFileName = "header_stamp_index";
+
+  /// Account a message. Messages of a topic have to be added in order of received time stamps.
+  void add_message(
+    const std::string & topic_name,
+    rcutils_time_point_value_t received_time_stamp,
+    rcutils_time_point_value_t header_time_stamp);
+
+  /// Entries of each topic, in order of received time stamps.
+  const std::map<std::string, std::vector<Entry>> & topics() const;
+
+  /// Number of indexed messages.
+  size_t size() const;
+
+  /**
+   * Read all messages of an opened reader in order of received time stamps and index them.
+   *
+   * Changes the read order, filter and position of the reader.
+   * \param reader The reader, which has to return the messages in their stored serialization.
+   * \param stamp_field Path of the builtin_interfaces/msg/Time member to index.
+   * \param converter_factory Factory of the deserializers of the messages.
+   */
+  static HeaderStampIndex build(
+    reader_interfaces::BaseReaderInterface & reader,
+    const std::string & stamp_field = "header.stamp",
+    std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory =
+    std::make_shared<SerializationFormatConverterFactory>());
+
+  /// Whether a bag directory holds an index.
+  static bool exists(const std::string & bag_directory);
+
+  /**
+   * Write the index to a bag directory, replacing the index stored there.
+   * \throws std::runtime_error if the index could not be written
+   */
+  void write(const std::string & bag_directory) const;
+
+  /// \throws std::runtime_error if the bag directory has no index or it is malformed
+  static HeaderStampIndex read(const std::string & bag_directory);
+
+  std::string serialize() const;
+
+  /// \throws std::runtime_error if serialized_index is malformed
+  static HeaderStampIndex deserialize(const std::string & serialized_index);
+
+private:
+  std::map<std::string, std::vector<Entry>> topics_;
+  size_t size_ = 0;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__HEADER_STAMP_INDEX_HPP_
@@ -16,14 +16,30 @@
 #define ROSBAG2_CPP__INFO_HPP_
 
 #include <string>
+#include <vector>
+
+#include "rcutils/time.h"
 
 #include "rosbag2_cpp/visibility_control.hpp"
 
 #include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 
 namespace rosbag2_cpp
 {
 
+/// Part of a bag covering a time range, to be read independently of the other parts
+struct TimeShard
+{
+  // Bag files with messages in the time range, as listed in the metadata
+  std::vector<std::string> files;
+  // Inclusive time range, to be set as start_time_ns and end_time_ns of a StorageFilter
+  rcutils_time_point_value_t start_time_ns;
+  rcutils_time_point_value_t end_time_ns;
+  // Size of the messages in the time range, estimated from the file sizes
+  uint64_t estimated_bytes;
+};
+
 class ROSBAG2_CPP_PUBLIC Info
 {
 public:
@@ -31,6 +47,41 @@ public:
 
   virtual rosbag2_storage::BagMetadata read_metadata(
     const std::string & uri, const std::string & storage_id = "");
+
+  /// Read the metadata of several bags concurrently.
+  /**
+   * The bags are read as by read_metadata(), sharing one storage factory, so the storage plugins
+   * are only loaded once.
+   * \param uris Bag directories or files
+   * \param threads Number of bags read at a time, one per CPU core if 0
+   * \return Metadata in the order of the uris
+   * \throws std::runtime_error of the first bag which could not be read, after all bags were read
+   */
+  virtual std::vector<rosbag2_storage::BagMetadata> read_metadata_many(
+    const std::vector<std::string> & uris, size_t threads = 0,
+    const std::string & storage_id = "");
+
+  /// Statistics of the topics of a bag, as written by the recorder next to its metadata.
+  /// Empty if the bag has no statistics, e.g. because it was not closed.
+  virtual std::vector<rosbag2_storage::TopicStatistics> read_topic_statistics(
+    const std::string & uri);
+
+  /// Split a bag into time ranges with about the same amount of data, which can be read
+  /// concurrently by separate readers.
+  /**
+   * A reader reads a shard by filtering for its time range and seeking to its start time, which
+   * opens the first file of the shard without reading the files before.
+   *
+   * Only the metadata and the file sizes are used. The data of a file is assumed to be spread
+   * evenly over its time range.
+   * \param uri Bag directory or file
+   * \param shard_count Number of shards to split the bag into. Fewer shards are returned if the
+   *   time range of the bag is too short.
+   * \return Shards in order of their time ranges, none if the bag has no messages
+   * \throws std::invalid_argument if shard_count is 0
+   */
+  virtual std::vector<TimeShard> split_into_time_shards(
+    const std::string & uri, size_t shard_count, const std::string & storage_id = "");
 };
 
 }  // namespace rosbag2_cpp
@@ -19,11 +19,20 @@
 #define ROSBAG2_CPP_LOCAL_MESSAGE_DEFINITION_SOURCE_MAX_RECURSION_DEPTH 50
 #endif
 
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_cpp/visibility_control.hpp"
 #include "rosbag2_storage/message_definition.hpp"
@@ -65,8 +74,19 @@ public:
    * docs/message_definition_encoding.md
    * Throws DefinitionNotFoundError if one or more definition files are missing for the given
    * package resource name.
+   * The result is kept for later calls, and in the cache directory if one is set and the
+   * type description hash is known. Thread-safe.
    */
-  rosbag2_storage::MessageDefinition get_full_text(const std::string & root_topic_type);
+  rosbag2_storage::MessageDefinition get_full_text(
+    const std::string & root_topic_type, const std::string & type_description_hash = "");
+
+  /**
+   * Start resolving the definition of a type on the threads of the source, so that a later
+   * get_full_text() for the type does not have to read the definition files.
+   * Does nothing if the source has no threads, or if the type was resolved already.
+   */
+  void prefetch(
+    const std::string & root_topic_type, const std::string & type_description_hash = "");
 
   enum struct Format
   {
@@ -75,12 +95,50 @@ public:
     IDL = 2,
   };
 
-  explicit LocalMessageDefinitionSource() = default;
+  /**
+   * \param cache_directory Directory of a persistent cache of the concatenated definitions,
+   *   keyed by type and type description hash, shared by all sources using it.
+   *   No cache is used if empty.
+   * \param number_of_threads Number of threads resolving the definitions passed to prefetch().
+   */
+  explicit LocalMessageDefinitionSource(
+    std::string cache_directory = "", size_t number_of_threads = 0);
+
+  /// Joins the threads, after they resolved the definitions which they started resolving.
+  ~LocalMessageDefinitionSource();
 
   LocalMessageDefinitionSource(const LocalMessageDefinitionSource &) = delete;
   LocalMessageDefinitionSource(const LocalMessageDefinitionSource &&) = delete;
 
 private:
+  // The full text of a type, resolved once by a thread of the source or by get_full_text()
+  struct Resolution
+  {
+    std::once_flag once;
+    std::packaged_task<rosbag2_storage::MessageDefinition()> task;
+    std::shared_future<rosbag2_storage::MessageDefinition> full_text;
+  };
+
+  /// Find the resolution of a type, or add it. The flag is true if the resolution was added.
+  std::pair<std::shared_ptr<Resolution>, bool> get_resolution(
+    const std::string & root_topic_type, const std::string & type_description_hash);
+
+  /// Resolve the full text from the cache directory, or from the definition files.
+  rosbag2_storage::MessageDefinition resolve_full_text(
+    const std::string & root_topic_type, const std::string & type_description_hash);
+
+  /// Concatenate the definition files of the type and its dependencies.
+  rosbag2_storage::MessageDefinition concatenate_definitions(const std::string & root_topic_type);
+
+  std::string cache_file_path(
+    const std::string & root_topic_type, const std::string & type_description_hash) const;
+  std::optional<rosbag2_storage::MessageDefinition> read_cache_file(
+    const std::string & root_topic_type, const std::string & path) const;
+  void write_cache_file(
+    const rosbag2_storage::MessageDefinition & full_text, const std::string & path) const;
+
+  void resolve_prefetched_types();
+
   struct MessageSpec
   {
     MessageSpec(Format format, std::string text, const std::string & package_context);
@@ -142,8 +200,20 @@ private:
 
   static std::string delimiter(const DefinitionIdentifier & definition_identifier);
 
+  std::mutex msg_specs_mutex_;
   std::unordered_map<DefinitionIdentifier,
     MessageSpec, DefinitionIdentifierHash> msg_specs_by_definition_identifier_;
+
+  const std::string cache_directory_;
+
+  std::mutex resolutions_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Resolution>> resolutions_by_topic_type_;
+
+  // Resolutions passed to prefetch(), which are run by the threads
+  std::condition_variable prefetched_resolution_available_;
+  std::deque<std::shared_ptr<Resolution>> prefetched_resolutions_;
+  bool should_exit_ = false;
+  std::vector<std::thread> threads_;
 };
 
 ROSBAG2_CPP_PUBLIC
@@ -0,0 +1,112 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__PARALLEL_CONVERTER_HPP_
+#define ROSBAG2_CPP__PARALLEL_CONVERTER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/**
+ * Converts batches of messages on several threads.
+ *
+ * Every thread converts with a Converter of its own, since a Converter reuses its messages.
+ * The messages of a batch are handed out to the threads one by one and the converted messages
+ * are returned in the order of the batch.
+ */
+class ROSBAG2_CPP_PUBLIC ParallelConverter
+{
+public:
+  /// \throws std::runtime_error if there is no converter for one of the formats.
+  ParallelConverter(
+    const ConverterOptions & converter_options,
+    std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory,
+    size_t number_of_threads);
+
+  /// Joins the threads.
+  virtual ~ParallelConverter();
+
+  ParallelConverter(const ParallelConverter &) = delete;
+  ParallelConverter & operator=(const ParallelConverter &) = delete;
+
+  /// Add a topic to the converters of all threads. Waits for a batch being converted.
+  void add_topic(const std::string & topic, const std::string & type);
+
+  /**
+   * Convert messages on all threads and wait until they are converted.
+   *
+   * \param messages Messages to convert, of topics added with add_topic().
+   * \return The converted messages, in the order of messages.
+   * \throws the first exception thrown while converting one of the messages, after all
+   *   messages were converted.
+   */
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> convert(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
+  size_t get_number_of_threads() const;
+
+private:
+  void convert_messages_of_batches(size_t thread_index);
+
+  std::vector<std::unique_ptr<Converter>> converters_;
+  std::vector<std::thread> threads_;
+
+  // Serializes convert() and add_topic()
+  std::mutex batch_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable messages_available_;
+  std::condition_variable batch_converted_;
+  bool should_exit_ = false;
+  // Batch being converted, and the index of the next message to hand out
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> * batch_ =
+    nullptr;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> * converted_batch_ =
+    nullptr;
+  size_t next_message_ = 0;
+  size_t messages_to_convert_ = 0;
+  std::exception_ptr error_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__PARALLEL_CONVERTER_HPP_
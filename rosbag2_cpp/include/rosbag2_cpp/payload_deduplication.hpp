@@ -0,0 +1,172 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__PAYLOAD_DEDUPLICATION_HPP_
+#define ROSBAG2_CPP__PAYLOAD_DEDUPLICATION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Key of the custom data in the metadata of bags whose payloads may be references.
+constexpr const char kDeduplicatedPayloadsKey[] = "rosbag2_cpp.deduplicated_payloads";
+
+/**
+ * Reference to an earlier message of the same topic and bag file with an identical payload,
+ * stored as the payload of a repeated message instead of a copy.
+ */
+struct PayloadReference
+{
+  /// hash_payload() of the payload
+  uint64_t hash = 0;
+  /// Time stamp of the message which holds the payload
+  rcutils_time_point_value_t time_stamp = 0;
+  /// Size of the payload in bytes
+  uint64_t size = 0;
+};
+
+/// Size in bytes of a reference payload. Only larger payloads are replaced by references.
+constexpr size_t kPayloadReferenceSize = 32;
+
+/// Fast non-cryptographic 64 bit hash of a payload.
+ROSBAG2_CPP_PUBLIC
+uint64_t hash_payload(const uint8_t * data, size_t size);
+
+ROSBAG2_CPP_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t> make_reference_payload(const PayloadReference & reference);
+
+/// \return the reference held by payload, or std::nullopt if payload is not a reference.
+ROSBAG2_CPP_PUBLIC
+std::optional<PayloadReference> parse_reference_payload(const rcutils_uint8_array_t & payload);
+
+/// Payloads of topics remembered up to a byte budget, the oldest are forgotten first.
+class ROSBAG2_CPP_PUBLIC RememberedPayloads
+{
+public:
+  struct Entry
+  {
+    std::shared_ptr<rcutils_uint8_array_t> payload;
+    rcutils_time_point_value_t time_stamp = 0;
+  };
+
+  explicit RememberedPayloads(uint64_t max_bytes);
+
+  /// \return the payload remembered for a topic with a hash and size, or nullptr.
+  const Entry * find(const std::string & topic, uint64_t hash, uint64_t size) const;
+
+  /// Remember a payload, replacing one remembered for the same topic, hash and size.
+  void insert(const std::string & topic, uint64_t hash, Entry entry);
+
+  void clear();
+
+  uint64_t get_bytes() const;
+
+private:
+  static std::string make_key(const std::string & topic, uint64_t hash, uint64_t size);
+
+  uint64_t max_bytes_;
+  uint64_t bytes_ = 0;
+  std::unordered_map<std::string, Entry> entries_;
+  // Keys in the order they were remembered
+  std::deque<std::string> order_;
+};
+
+/**
+ * Replaces payloads which repeat an earlier payload of the same topic by references to it.
+ *
+ * Payloads of at least the minimum size are hashed, and a payload is only replaced if its bytes
+ * equal the remembered one. A reference may only refer to a message of the same bag file, so
+ * the writer calls reset() whenever it starts a new file.
+ */
+class ROSBAG2_CPP_PUBLIC PayloadDeduplicator
+{
+public:
+  /**
+   * \param min_payload_size Minimum size in bytes of payloads to deduplicate.
+   * \param max_remembered_bytes Byte budget of the payloads kept to compare repeats with.
+   */
+  PayloadDeduplicator(uint64_t min_payload_size, uint64_t max_remembered_bytes);
+
+  /// \return message itself, or a copy of it holding a reference instead of its payload.
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> deduplicate(
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
+
+  /// Forget all payloads, e.g. when the next bag file is started.
+  void reset();
+
+  /// Number of payloads replaced by references so far.
+  uint64_t get_deduplicated_count() const;
+
+private:
+  uint64_t min_payload_size_;
+  RememberedPayloads payloads_;
+  uint64_t deduplicated_count_ = 0;
+};
+
+/**
+ * Replaces references written by a PayloadDeduplicator by the payloads they refer to.
+ *
+ * Resolved payloads are kept up to a byte budget and shared by all messages referring to them,
+ * payloads which are not kept are looked up in the bag file.
+ */
+class ROSBAG2_CPP_PUBLIC PayloadResolver
+{
+public:
+  /// Look up the payload a reference of a topic refers to, nullptr if there is none.
+  using LookUp = std::function<std::shared_ptr<rcutils_uint8_array_t>(
+        const std::string & topic, const PayloadReference & reference)>;
+
+  explicit PayloadResolver(uint64_t max_cached_bytes);
+
+  /**
+   * Replace the payload of message if it is a reference.
+   *
+   * \return true if the payload was a reference.
+   * \throws std::runtime_error if look_up does not find the payload.
+   */
+  bool resolve(rosbag2_storage::SerializedBagMessage & message, const LookUp & look_up);
+
+private:
+  RememberedPayloads payloads_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__PAYLOAD_DEDUPLICATION_HPP_
@@ -0,0 +1,163 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__PAYLOAD_DELTA_ENCODING_HPP_
+#define ROSBAG2_CPP__PAYLOAD_DELTA_ENCODING_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rosbag2_cpp/payload_deduplication.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Key of the custom data in the metadata of bags with delta encoded topics, the value lists
+/// the topics separated by commas.
+constexpr const char kDeltaEncodedTopicsKey[] = "rosbag2_cpp.delta_encoded_topics";
+
+/**
+ * Encode a payload as the bytes which differ from a keyframe of the same size.
+ *
+ * The delta payload starts with a reference to the keyframe, a message of the same topic and
+ * bag file. Runs of bytes equal to the keyframe follow as their length, the other bytes as
+ * they are.
+ *
+ * \return the delta payload, or nullptr if it would not be smaller than payload.
+ */
+ROSBAG2_CPP_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t> make_delta_payload(
+  const PayloadReference & keyframe_reference, const rcutils_uint8_array_t & keyframe,
+  const rcutils_uint8_array_t & payload);
+
+/// \return the keyframe a delta payload refers to, or std::nullopt if payload is not a delta.
+ROSBAG2_CPP_PUBLIC
+std::optional<PayloadReference> parse_delta_payload(const rcutils_uint8_array_t & payload);
+
+/**
+ * Apply a delta payload to its keyframe.
+ *
+ * \throws std::runtime_error if the delta is malformed or does not fit the keyframe.
+ */
+ROSBAG2_CPP_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t> apply_delta_payload(
+  const rcutils_uint8_array_t & delta, const rcutils_uint8_array_t & keyframe);
+
+/// Topics of kDeltaEncodedTopicsKey joined by commas, as stored in the metadata
+ROSBAG2_CPP_PUBLIC
+std::string join_delta_encoded_topics(const std::vector<std::string> & topics);
+
+ROSBAG2_CPP_PUBLIC
+std::vector<std::string> split_delta_encoded_topics(const std::string & joined_topics);
+
+/**
+ * Stores messages of some topics as deltas to the last keyframe of their topic.
+ *
+ * Every keyframe_interval-th message of a topic is stored completely as a keyframe, and the
+ * messages in between as the bytes which differ from it. A message is stored as a keyframe as
+ * well if its size differs from the keyframe, or if its delta would not be smaller. Since
+ * deltas refer to a keyframe and not to each other, a reader only needs the keyframe to
+ * reconstruct any message. A delta may only refer to a message of the same bag file, so the
+ * writer calls reset() whenever it starts a new file.
+ */
+class ROSBAG2_CPP_PUBLIC PayloadDeltaEncoder
+{
+public:
+  PayloadDeltaEncoder(const std::vector<std::string> & topics, uint64_t keyframe_interval);
+
+  bool is_encoded_topic(const std::string & topic) const;
+
+  /// \return message itself, or a copy of it holding a delta instead of its payload.
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> encode(
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
+
+  /// Forget all keyframes, e.g. when the next bag file is started.
+  void reset();
+
+  /// Number of payloads replaced by deltas so far.
+  uint64_t get_delta_count() const;
+
+private:
+  struct Keyframe
+  {
+    std::shared_ptr<rcutils_uint8_array_t> payload;
+    PayloadReference reference;
+    uint64_t messages_since = 0;
+  };
+
+  std::unordered_set<std::string> topics_;
+  uint64_t keyframe_interval_;
+  std::unordered_map<std::string, Keyframe> keyframes_;
+  uint64_t delta_count_ = 0;
+};
+
+/**
+ * Reconstructs the payloads of messages written by a PayloadDeltaEncoder.
+ *
+ * The last keyframe read of every delta encoded topic is kept, keyframes of deltas read before
+ * their keyframe, e.g. after a seek or in reverse order, are looked up in the bag file.
+ */
+class ROSBAG2_CPP_PUBLIC PayloadDeltaDecoder
+{
+public:
+  explicit PayloadDeltaDecoder(const std::vector<std::string> & topics);
+
+  /**
+   * Replace the payload of message if it is a delta, or keep it if it is a keyframe.
+   *
+   * \param look_up Looks up keyframes which are not kept.
+   * \return true if the payload was a delta.
+   * \throws std::runtime_error if look_up does not find the keyframe.
+   */
+  bool decode(
+    rosbag2_storage::SerializedBagMessage & message, const PayloadResolver::LookUp & look_up);
+
+private:
+  struct Keyframe
+  {
+    std::shared_ptr<rcutils_uint8_array_t> payload;
+    rcutils_time_point_value_t time_stamp = 0;
+    // The hash is only computed once a delta refers to the keyframe
+    std::optional<uint64_t> hash;
+  };
+
+  std::unordered_set<std::string> topics_;
+  std::unordered_map<std::string, Keyframe> keyframes_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__PAYLOAD_DELTA_ENCODING_HPP_
@@ -0,0 +1,213 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__PIPELINE_STATISTICS_HPP_
+#define ROSBAG2_CPP__PIPELINE_STATISTICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "rosbag2_cpp/tracing.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Stages of the record pipeline whose latency is measured, in the order a message passes them.
+enum class PipelineStage : uint8_t
+{
+  /// Subscription callback of the recorder, including Writer::write
+  SUBSCRIPTION_CALLBACK = 0,
+  /// Writer::write, including waiting for the writer
+  WRITER_WRITE,
+  /// Pushing a message into the message cache
+  CACHE_PUSH,
+  /// Consuming a batch of the message cache, from the start of the batch until it is written
+  CONSUMER_BATCH,
+  /// Writing a batch or a single message to storage
+  STORAGE_WRITE,
+  /// Compressing a message, a batch or a file
+  COMPRESSION,
+  COUNT
+};
+
+/// Queues of the record pipeline whose depth is sampled.
+enum class PipelineQueue : uint8_t
+{
+  /// Messages of the batch the cache consumer started to write last
+  CACHE_BATCH_MESSAGES = 0,
+  /// Bytes of the batch the cache consumer started to write last
+  CACHE_BATCH_BYTES,
+  /// Messages waiting for a compression thread, in MESSAGE compression mode
+  COMPRESSION_QUEUE_MESSAGES,
+  COUNT
+};
+
+ROSBAG2_CPP_PUBLIC std::string pipeline_stage_to_string(PipelineStage stage);
+
+ROSBAG2_CPP_PUBLIC std::string pipeline_queue_to_string(PipelineQueue queue);
+
+/// Histogram of latencies in the style of an HDR histogram.
+/**
+ * Latencies are counted in log-linear buckets: every power of two is split into 16 buckets,
+ * so that percentiles are accurate to 1/16 of their value, from nanoseconds up to about
+ * 18 minutes. Longer latencies are counted in the last bucket.
+ *
+ * Recording is wait-free and safe from any number of threads at once. Reading while latencies
+ * are recorded gives a consistent enough view for monitoring, but not an atomic snapshot.
+ */
+class ROSBAG2_CPP_PUBLIC LatencyHistogram
+{
+public:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBucketCount = size_t{1} << kSubBucketBits;
+  static constexpr size_t kMaxExponent = 40;
+  static constexpr size_t kBucketCount =
+    kSubBucketCount + (kMaxExponent - kSubBucketBits) * kSubBucketCount;
+
+  LatencyHistogram();
+
+  void record(std::chrono::nanoseconds latency);
+
+  uint64_t count() const;
+
+  std::chrono::nanoseconds max() const;
+
+  std::chrono::nanoseconds mean() const;
+
+  /// \param percentile Percentile in [0, 100]
+  /// \return Upper bound of the bucket of the percentile, at most max(). 0 if empty.
+  std::chrono::nanoseconds percentile(double percentile) const;
+
+  void reset();
+
+  /// Bucket a latency in nanoseconds is counted in.
+  static size_t bucket_index(uint64_t value);
+
+  /// Largest latency in nanoseconds which is counted in a bucket.
+  static uint64_t bucket_upper_bound(size_t index);
+
+private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/// Latency histograms and queue depths of the stages of the record pipeline.
+/**
+ * Shared by the recorder and its writer, which record into it from their threads. The
+ * histograms and maximum queue depths accumulate until reset().
+ */
+class ROSBAG2_CPP_PUBLIC PipelineStatistics
+{
+public:
+  PipelineStatistics();
+
+  void record(PipelineStage stage, std::chrono::nanoseconds latency);
+
+  const LatencyHistogram & histogram(PipelineStage stage) const;
+
+  void set_queue_depth(PipelineQueue queue, uint64_t depth);
+
+  /// Depth of a queue when it was sampled last.
+  uint64_t queue_depth(PipelineQueue queue) const;
+
+  /// Maximum depth of a queue since the last reset().
+  uint64_t max_queue_depth(PipelineQueue queue) const;
+
+  /// Set the messages the message cache dropped since it was created, per topic priority.
+  void set_cache_dropped_messages(std::map<uint32_t, uint64_t> dropped_per_priority);
+
+  /// Messages the message cache dropped per topic priority when they were set last. Not
+  /// cleared by reset(). Empty if the cache does not drop by priority.
+  std::map<uint32_t, uint64_t> cache_dropped_messages() const;
+
+  void reset();
+
+  /// One line per stage with measurements and per sampled queue, for logging.
+  std::string summary() const;
+
+private:
+  std::array<LatencyHistogram, static_cast<size_t>(PipelineStage::COUNT)> histograms_;
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(PipelineQueue::COUNT)> queue_depths_;
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(PipelineQueue::COUNT)>
+  max_queue_depths_;
+  mutable std::mutex cache_dropped_messages_mutex_;
+  std::map<uint32_t, uint64_t> cache_dropped_messages_;
+};
+
+/// Records the time from its construction to its destruction as latency of a stage.
+/// Does not read the clock if statistics and histogram are nullptr. Emits the stage_begin and
+/// stage_end tracepoints if tracing is enabled, with or without statistics.
+class StageTimer
+{
+public:
+  /// \param histogram Also records the latency into it, if not nullptr
+  StageTimer(
+    PipelineStatistics * statistics, PipelineStage stage,
+    LatencyHistogram * histogram = nullptr)
+  : statistics_(statistics), histogram_(histogram), stage_(stage)
+  {
+    ROSBAG2_CPP_TRACEPOINT(stage_begin, static_cast<uint8_t>(stage_));
+    if (statistics_ || histogram_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~StageTimer()
+  {
+    ROSBAG2_CPP_TRACEPOINT(stage_end, static_cast<uint8_t>(stage_));
+    if (statistics_ || histogram_) {
+      const auto latency = std::chrono::steady_clock::now() - start_;
+      if (statistics_) {
+        statistics_->record(stage_, latency);
+      }
+      if (histogram_) {
+        histogram_->record(latency);
+      }
+    }
+  }
+
+  StageTimer(const StageTimer &) = delete;
+  StageTimer & operator=(const StageTimer &) = delete;
+
+private:
+  PipelineStatistics * statistics_;
+  LatencyHistogram * histogram_;
+  PipelineStage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__PIPELINE_STATISTICS_HPP_
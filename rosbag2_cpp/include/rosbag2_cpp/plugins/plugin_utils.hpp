@@ -16,11 +16,13 @@
 #define ROSBAG2_CPP__PLUGINS__PLUGIN_UTILS_HPP_
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "pluginlib/class_loader.hpp"
+#include "rosbag2_storage/class_loader_cache.hpp"
 
 namespace rosbag2_cpp
 {
@@ -32,8 +34,9 @@ std::unordered_set<std::string> get_class_plugins()
   std::string package_name = InterfaceT::get_package_name();
   std::string base_class = InterfaceT::get_base_class_name();
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader =
-    std::make_shared<pluginlib::ClassLoader<InterfaceT>>(package_name, base_class);
+    rosbag2_storage::get_cached_class_loader<InterfaceT>(package_name, base_class);
 
+  std::lock_guard<std::recursive_mutex> lock(rosbag2_storage::get_class_loader_mutex());
   std::vector<std::string> plugin_list = class_loader->getDeclaredClasses();
   return std::unordered_set<std::string>(plugin_list.begin(), plugin_list.end());
 }
@@ -131,6 +131,44 @@ public:
    */
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next();
 
+  /**
+   * Read the next messages from storage at once, up to a number of messages or bytes.
+   * The messages will be serialized in the format given to `open`.
+   *
+   * Expected usage:
+   * for (auto batch = reader.read_next_batch(1000); !batch.empty();
+   *   batch = reader.read_next_batch(1000)) {...}
+   *
+   * \param max_messages Maximum number of messages to return, 0 for no limit.
+   * \param max_bytes Stop once the serialized data of the messages reaches this size, 0 for no
+   *   limit. A batch holds at least one message, however large it is.
+   * \return next messages in serialized form, empty at the end of the bag
+   * \throws runtime_error if the Reader is not open.
+   */
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0);
+
+  /**
+   * Set a filter and hand the remaining messages it selects to a callback, without allocating
+   * anything per message if the storage supports it. The filter stays set afterwards.
+   * The messages are serialized in the format given to `open`.
+   *
+   * Expected usage:
+   * size_t bytes = 0;
+   * reader.for_each(filter, [&bytes](const rosbag2_storage::SerializedBagMessageView & message) {
+   *     bytes += message.size;
+   *     return true;
+   *   });
+   *
+   * \param storage_filter Filter to apply to reading
+   * \param callback Called for every message in read order, returns false to stop reading. The
+   *   view and its data are only valid during the call.
+   * \throws runtime_error if the Reader is not open.
+   */
+  void for_each(
+    const rosbag2_storage::StorageFilter & storage_filter,
+    const rosbag2_storage::MessageViewCallback & callback);
+
   /**
    * Read next message from storage. Will throw if no more messages are available.
    * The message will be serialized in the format given to `open`.
@@ -190,6 +228,17 @@ public:
    */
   void reset_filter();
 
+  /**
+   * Estimate the number and serialized size of the messages a filter would select, without
+   * reading them. The filter and position of the reader are not changed.
+   *
+   * \param storage_filter Topics and time window to estimate
+   * 
+eturn The estimate, which is exact if the storage could count the messages.
+   * 	hrows runtime_error if the Reader is not open.
+   */
+  rosbag2_storage::ReadEstimate estimate(const rosbag2_storage::StorageFilter & storage_filter);
+
   /**
    * Skip to a specific timestamp for reading.
    */
@@ -24,6 +24,7 @@
 #include "rosbag2_cpp/visibility_control.hpp"
 
 #include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/read_estimate.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_interfaces/base_read_interface.hpp"
@@ -53,6 +54,58 @@ public:
 
   virtual std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() = 0;
 
+  /**
+   * Read the next messages at once, as if read_next() was called while has_next().
+   *
+   * The default implementation does exactly that, readers may read batches from the storage.
+   * \param max_messages Maximum number of messages to return, 0 for no limit.
+   * \param max_bytes Stop once the serialized data of the returned messages reaches this size,
+   *   0 for no limit. A batch holds at least one message, however large it is.
+   * \return The messages in read order, empty at the end of the bag.
+   */
+  virtual std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0)
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    size_t bytes = 0;
+    while ((max_messages == 0 || messages.size() < max_messages) &&
+      (max_bytes == 0 || bytes < max_bytes) && has_next())
+    {
+      messages.push_back(read_next());
+      if (messages.back()->serialized_data) {
+        bytes += messages.back()->serialized_data->buffer_length;
+      }
+    }
+    return messages;
+  }
+
+  /**
+   * Read the next messages as views handed to a callback, as if read_next() was called while
+   * has_next(), until the end of the bag or until the callback returns false.
+   *
+   * The default implementation reads the messages with read_next(), readers may hand out the
+   * messages of the storage without allocating anything per message.
+   * \param callback Called in read order, the view is only valid during the call.
+   */
+  virtual void for_each(const rosbag2_storage::MessageViewCallback & callback)
+  {
+    while (has_next()) {
+      const auto message = read_next();
+      rosbag2_storage::SerializedBagMessageView view;
+      if (message->serialized_data) {
+        view.data = message->serialized_data->buffer;
+        view.size = message->serialized_data->buffer_length;
+      }
+      view.time_stamp = message->time_stamp;
+      view.topic_name = message->topic_name;
+      view.send_timestamp = message->send_timestamp;
+      view.sequence_number = message->sequence_number;
+      if (!callback(view)) {
+        return;
+      }
+    }
+  }
+
   virtual const rosbag2_storage::BagMetadata & get_metadata() const = 0;
 
   virtual std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const = 0;
@@ -62,6 +115,18 @@ public:
 
   virtual void set_filter(const rosbag2_storage::StorageFilter & storage_filter) = 0;
 
+  /**
+   * Estimate the number and serialized size of the messages a filter selects, without reading
+   * them and without changing the filter or the position of the reader.
+   *
+   * The default implementation scales the metadata of the bag, readers may ask the storage.
+   */
+  virtual rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter)
+  {
+    return rosbag2_storage::estimate_from_metadata(get_metadata(), storage_filter);
+  }
+
   virtual void reset_filter() = 0;
 
   virtual void seek(const rcutils_time_point_value_t & timestamp) = 0;
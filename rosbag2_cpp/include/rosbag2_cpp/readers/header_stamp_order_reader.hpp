@@ -0,0 +1,172 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__READERS__HEADER_STAMP_ORDER_READER_HPP_
+#define ROSBAG2_CPP__READERS__HEADER_STAMP_ORDER_READER_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/header_stamp_index.hpp"
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * Reader which adds ReadOrder::HeaderTimestamp to another reader, using a HeaderStampIndex.
+ *
+ * In that order, the wrapped reader is read in order of received time stamps and its messages
+ * are held back until the index shows that no message which is not read yet has an earlier
+ * header time stamp. Only the messages whose header time stamps are out of order are buffered,
+ * not the bag. The time window of the filter and the time stamps of the returned messages stay
+ * received time stamps, while seek() goes to the first message with a header time stamp at or
+ * after the given one.
+ *
+ * The index is read from the bag directory when the order is set, unless one was given to the
+ * constructor. All other read orders are passed on to the wrapped reader. Setting the read order
+ * discards the buffered messages without moving the wrapped reader, seek() to start over.
+ */
+class ROSBAG2_CPP_PUBLIC HeaderStampOrderReader
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  explicit HeaderStampOrderReader(
+    std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl =
+    std::make_unique<SequentialReader>());
+
+  HeaderStampOrderReader(
+    std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl,
+    HeaderStampIndex index);
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  /// \return false for a reverse header time stamp order, or if the bag has no index.
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0) override;
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+  /// Return the number of messages held back to be returned in header time stamp order.
+  size_t get_buffered_messages() const;
+
+private:
+  // The entries of a topic in the index and the next one not read yet
+  struct TopicCursor
+  {
+    const std::vector<HeaderStampIndex::Entry> * entries = nullptr;
+    // Minimum header time stamp of the entries from an entry on
+    std::vector<rcutils_time_point_value_t> min_header_time_stamps;
+    // Maximum header time stamp of the entries up to an entry
+    std::vector<rcutils_time_point_value_t> max_header_time_stamps;
+    size_t next = 0;
+    bool selected = true;
+  };
+
+  struct BufferedMessage
+  {
+    rcutils_time_point_value_t header_time_stamp;
+    uint64_t sequence;
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+
+    bool operator>(const BufferedMessage & other) const
+    {
+      return header_time_stamp != other.header_time_stamp ?
+             header_time_stamp > other.header_time_stamp : sequence > other.sequence;
+    }
+  };
+
+  void use_index(HeaderStampIndex index);
+  // Select the topics of the filter and skip their entries before its time window
+  void apply_filter_to_cursors();
+  // Move the cursors to the first entries received at or after a time stamp
+  void position_cursors(rcutils_time_point_value_t received_time_stamp);
+  void clear_buffer();
+  // Look up the header time stamp of a message read from the wrapped reader and buffer it
+  void buffer(std::shared_ptr<rosbag2_storage::SerializedBagMessage> message);
+  // Upper bound of the header time stamps which may be returned, as no message with an earlier
+  // header time stamp is left to read
+  rcutils_time_point_value_t min_unread_header_time_stamp() const;
+
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl_;
+  std::string bag_directory_;
+  std::optional<HeaderStampIndex> index_;
+  // Whether index_ was read from the bag directory, rather than given to the constructor
+  bool index_read_from_bag_ = false;
+  std::unordered_map<std::string, TopicCursor> cursors_;
+  bool in_header_order_ = false;
+  // Whether the bag has topics which are not in the index, whose messages are ordered by their
+  // received time stamps
+  bool has_unindexed_topics_ = false;
+  rcutils_time_point_value_t last_received_time_stamp_ = 0;
+  rosbag2_storage::StorageFilter storage_filter_;
+  // Messages with an earlier header time stamp than the last seek are dropped
+  std::optional<rcutils_time_point_value_t> seek_header_time_stamp_;
+  std::priority_queue<
+    BufferedMessage, std::vector<BufferedMessage>, std::greater<BufferedMessage>> buffer_;
+  uint64_t next_sequence_ = 0;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__HEADER_STAMP_ORDER_READER_HPP_
@@ -0,0 +1,200 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_CPP__READERS__MERGING_READER_HPP_
+#define ROSBAG2_CPP__READERS__MERGING_READER_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/metadata_io.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * Reader which reads the files of a split bag concurrently and merges their messages by time.
+ *
+ * Unlike the SequentialReader, which reads one file after the other, the files may overlap in
+ * time, e.g. when messages arrived out of order while recording. Each file is read by its own
+ * file reader, by default a PrefetchingReader, so that up to max_open_files files are read ahead
+ * in parallel. A file is opened once the merged messages reach its time range, and up to
+ * max_open_files ahead of that. Files overlapping the time of the next message are always open,
+ * even if there are more than max_open_files of them.
+ * Messages with the same time stamp are returned in the order their files are opened in.
+ *
+ * The time ranges of the files are taken from the metadata. seek() skips the files which end
+ * before the time stamp, without opening them.
+ * set_read_order(), set_filter() and reset_filter() restart reading at the time stamp of the
+ * last message returned by read_next(), skipping the messages returned before at that time stamp.
+ *
+ * \note Compressed bags are not supported.
+ */
+class ROSBAG2_CPP_PUBLIC MergingReader
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  using FileReaderFactory =
+    std::function<std::unique_ptr<reader_interfaces::BaseReaderInterface>()>;
+
+  static constexpr size_t kDefaultMaxOpenFiles = 4;
+  static constexpr size_t kDefaultMaxPrefetchedBytesPerFile = 16 * 1024 * 1024;
+
+  /**
+   * \param max_open_files Number of files read ahead in parallel.
+   * \param max_prefetched_bytes_per_file Serialized data read ahead from each file, or 0 to read
+   *   each file on the reading thread.
+   * \param metadata_io Reads the metadata of the bag.
+   * \param file_reader_factory Creates the readers of the single files. By default, a
+   *   PrefetchingReader of a SequentialReader with max_prefetched_bytes_per_file, or a
+   *   SequentialReader if max_prefetched_bytes_per_file is 0.
+   */
+  explicit MergingReader(
+    size_t max_open_files = kDefaultMaxOpenFiles,
+    size_t max_prefetched_bytes_per_file = kDefaultMaxPrefetchedBytesPerFile,
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>(),
+    FileReaderFactory file_reader_factory = nullptr);
+
+  virtual ~MergingReader();
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /**
+   * Add callbacks which are executed when reading goes over to another file.
+   *
+   * The READ_SPLIT callback is executed when a file is opened, with the last file read to its end
+   * as the closed file.
+   */
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+  /// Return the number of files currently open.
+  size_t get_open_files_count() const;
+
+  /// Whether the time ranges of the files of a bag overlap, e.g. for a striped bag, so that the
+  /// messages are only in time order if the files are read merged.
+  static bool files_overlap(const rosbag2_storage::BagMetadata & metadata);
+
+private:
+  struct File
+  {
+    std::string path;
+    rcutils_time_point_value_t starting_time;
+    rcutils_time_point_value_t ending_time;
+  };
+
+  // Next message of an open file. rank is the position of the file in files_opening_order_.
+  struct NextMessage
+  {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    size_t rank;
+  };
+
+  void check_open() const;
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> open_file(const File & file);
+  // Close all files and read again from time_stamp, or from the beginning
+  void restart(const std::optional<rcutils_time_point_value_t> & time_stamp);
+  void restart_at_read_head();
+  void open_due_files();
+  bool is_due(const File & file) const;
+  // Whether a file is before the seek time or outside the time window of the filter
+  bool is_skipped(const File & file) const;
+  // Queue the next message of a file or close it at its end
+  void read_ahead(size_t rank);
+  // Heap order of the next messages, so that the next message to return is at the front
+  bool is_after(const NextMessage & lhs, const NextMessage & rhs) const;
+
+  const size_t max_open_files_;
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
+  FileReaderFactory file_reader_factory_;
+
+  bool is_open_ = false;
+  rosbag2_storage::StorageOptions storage_options_;
+  ConverterOptions converter_options_;
+  rosbag2_storage::BagMetadata metadata_;
+  std::vector<File> files_;
+  // Indices into files_ in the order files are opened for read_order_
+  std::vector<size_t> files_opening_order_;
+  size_t next_file_to_open_ = 0;
+  std::map<size_t, std::unique_ptr<reader_interfaces::BaseReaderInterface>> open_readers_;
+  std::vector<NextMessage> next_messages_;
+  std::string last_closed_file_;
+
+  rosbag2_storage::ReadOrder read_order_{};
+  rosbag2_storage::StorageFilter storage_filter_{};
+  std::optional<rcutils_time_point_value_t> seek_time_;
+  bool read_order_supported_ = true;
+  // Time stamp of the last message returned by read_next() or of the last seek, and the topics
+  // of the messages returned at that time stamp
+  std::optional<rcutils_time_point_value_t> read_head_;
+  std::vector<std::string> topics_read_at_read_head_;
+  // Messages which were returned before a restart and must not be returned again
+  std::optional<rcutils_time_point_value_t> skip_time_stamp_;
+  std::vector<std::string> topics_to_skip_;
+
+  bag_events::EventCallbackManager callback_manager_;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__MERGING_READER_HPP_
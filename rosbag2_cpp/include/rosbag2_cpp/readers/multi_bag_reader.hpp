@@ -0,0 +1,157 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__READERS__MULTI_BAG_READER_HPP_
+#define ROSBAG2_CPP__READERS__MULTI_BAG_READER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * Reader which reads several bags at once and merges their messages by time.
+ *
+ * This allows to play e.g. a bag of sensor data together with a separately recorded bag of
+ * ground truth from one clock. Each bag is read by its own reader, by default a
+ * PrefetchingReader, so that the bags are read ahead in parallel. The next message of each bag
+ * is kept in a heap. Messages with the same time stamp are returned in the order of the bags.
+ *
+ * The metadata of the bags is merged: the bag starts with the earliest and ends with the latest
+ * bag, and topics which are in several bags are listed once, with the sum of their message
+ * counts. A topic must have the same type in all bags.
+ * set_read_order(), set_filter(), reset_filter() and seek() apply to all bags. The first three
+ * restart reading at the time stamp of the last message returned by read_next(), skipping the
+ * messages returned before at that time stamp.
+ */
+class ROSBAG2_CPP_PUBLIC MultiBagReader
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  struct Bag
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    /// Reader of the bag. By default, a PrefetchingReader of a SequentialReader.
+    std::unique_ptr<reader_interfaces::BaseReaderInterface> reader;
+  };
+
+  /// \param bags Bags to read, opened with their own storage options.
+  /// \throws std::invalid_argument if there are no bags.
+  explicit MultiBagReader(std::vector<Bag> bags);
+
+  virtual ~MultiBagReader();
+
+  /**
+   * Open all bags.
+   *
+   * \param storage_options Unused, each bag is opened with the storage options it was
+   *   constructed with.
+   * \param converter_options Converter options of all bags.
+   * \throws std::runtime_error if a topic has different types in two bags.
+   */
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  /// The sum of the estimates of the bags.
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /// Add callbacks to the readers of all bags.
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+private:
+  // Next message of a bag. rank is the position of the bag in bags_.
+  struct NextMessage
+  {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    size_t rank;
+  };
+
+  void check_open() const;
+  void merge_metadata();
+  // Seek all bags back to the read head, so that the messages in the heap are read again
+  void restart_at_read_head();
+  // Queue the next message of the bags whose last message was returned by read_next()
+  void read_ahead();
+  // Heap order of the next messages, so that the next message to return is at the front
+  bool is_after(const NextMessage & lhs, const NextMessage & rhs) const;
+
+  std::vector<Bag> bags_;
+  bool is_open_ = false;
+  rosbag2_storage::BagMetadata metadata_;
+  std::vector<rosbag2_storage::TopicMetadata> topics_;
+
+  std::vector<NextMessage> next_messages_;
+  // Ranks of the bags without a message in next_messages_, which may not be at their end
+  std::vector<size_t> bags_to_read_ahead_;
+
+  rosbag2_storage::ReadOrder read_order_{};
+  // Time stamp of the last message returned by read_next() or of the last seek, and the topics
+  // of the messages returned at that time stamp
+  std::optional<rcutils_time_point_value_t> read_head_;
+  std::vector<std::string> topics_read_at_read_head_;
+  // Messages which were returned before a restart and must not be returned again
+  std::optional<rcutils_time_point_value_t> skip_time_stamp_;
+  std::vector<std::string> topics_to_skip_;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__MULTI_BAG_READER_HPP_
@@ -0,0 +1,156 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_CPP__READERS__PREFETCHING_READER_HPP_
+#define ROSBAG2_CPP__READERS__PREFETCHING_READER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * Reader which reads messages of another reader on a background thread ahead of time.
+ *
+ * Messages are queued until their serialized data reaches max_prefetched_bytes, so that
+ * has_next() and read_next() return without waiting for the storage as long as the consumer
+ * isn't faster than the storage. The queue holds at least one message, however large it is.
+ * set_read_order(), set_filter(), reset_filter() and seek() discard the queued messages before
+ * they are forwarded to the wrapped reader. Since the wrapped reader has already read the
+ * discarded messages, it is then seeked back to the time stamp of the last message returned by
+ * read_next(), and the messages returned before at that time stamp are skipped.
+ *
+ * \note Event callbacks of the wrapped reader, e.g. on a file split, are called from the
+ * background thread.
+ */
+class ROSBAG2_CPP_PUBLIC PrefetchingReader
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  static constexpr size_t kDefaultMaxPrefetchedBytes = 64 * 1024 * 1024;
+
+  explicit PrefetchingReader(
+    std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl =
+    std::make_unique<SequentialReader>(),
+    size_t max_prefetched_bytes = kDefaultMaxPrefetchedBytes);
+
+  virtual ~PrefetchingReader();
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  /**
+   * Wait until the next message has been read ahead or the wrapped reader is at its end.
+   *
+   * \throws the exception thrown by the wrapped reader while reading ahead.
+   */
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+  /// Return the number of bytes of serialized data currently read ahead.
+  size_t get_prefetched_bytes() const;
+
+private:
+  void start_prefetching();
+  void stop_prefetching();
+  // Must be called with reader_mutex_ locked, so that no message read before is queued after.
+  // Return the time stamp to rewind the wrapped reader to if any messages were discarded.
+  std::optional<rcutils_time_point_value_t> discard_prefetched_messages();
+  // Must be called with reader_mutex_ locked.
+  void rewind(const std::optional<rcutils_time_point_value_t> & time_stamp);
+  void reset_read_head(const std::optional<rcutils_time_point_value_t> & time_stamp);
+  // Must be called with queue_mutex_ locked. Return false if there is no next message.
+  bool wait_for_prefetched_message(std::unique_lock<std::mutex> & queue_lock);
+  void prefetch_messages();
+
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl_;
+  const size_t max_prefetched_bytes_;
+
+  // Serializes the access to reader_impl_. Locked before queue_mutex_ when both are needed.
+  // Recursive, so that event callbacks may call into the reader.
+  mutable std::recursive_mutex reader_mutex_;
+  mutable std::mutex queue_mutex_;
+  std::condition_variable message_read_condition_var_;
+  std::condition_variable message_taken_condition_var_;
+  std::deque<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> prefetched_messages_;
+  size_t prefetched_bytes_ = 0;
+  bool reader_at_end_ = false;
+  // Time stamp of the last message returned by read_next() or of the last seek, and the topics
+  // of the messages returned at that time stamp.
+  std::optional<rcutils_time_point_value_t> read_head_;
+  std::vector<std::string> topics_read_at_read_head_;
+  // Messages which were returned before a rewind and must not be queued again
+  std::optional<rcutils_time_point_value_t> skip_time_stamp_;
+  std::vector<std::string> topics_to_skip_;
+  bool stop_prefetching_ = false;
+  std::exception_ptr prefetch_error_;
+  std::thread prefetch_thread_;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__PREFETCHING_READER_HPP_
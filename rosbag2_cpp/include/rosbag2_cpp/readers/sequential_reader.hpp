@@ -15,19 +15,26 @@
 #ifndef ROSBAG2_CPP__READERS__SEQUENTIAL_READER_HPP_
 #define ROSBAG2_CPP__READERS__SEQUENTIAL_READER_HPP_
 
+#include <future>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_cpp/parallel_converter.hpp"
+#include "rosbag2_cpp/payload_deduplication.hpp"
+#include "rosbag2_cpp/payload_delta_encoding.hpp"
 #include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
+#include "rosbag2_storage/buffer_pool.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/readable_file.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
 #include "rosbag2_storage/storage_factory_interface.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
@@ -77,6 +84,19 @@ public:
 
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
 
+  /**
+   * Read the next messages in batches of the storage, going over to the next file as needed.
+   */
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0) override;
+
+  /**
+   * Hand out the messages of the storage without copying them, going over to the next file as
+   * needed. Messages which are converted or whose payloads are resolved are read with
+   * read_next() instead.
+   */
+  void for_each(const rosbag2_storage::MessageViewCallback & callback) override;
+
   const rosbag2_storage::BagMetadata & get_metadata() const override;
 
   std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
@@ -88,6 +108,13 @@ public:
 
   void reset_filter() override;
 
+  /**
+   * Ask the storage of each file which overlaps the time window of the filter for its estimate.
+   * Falls back to the metadata of the bag if a file can not be opened.
+   */
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
   /**
    * seek(t) will cause subsequent reads to return messages that satisfy
    * timestamp >= time t.
@@ -192,9 +219,51 @@ protected:
     */
   virtual void preprocess_current_file() {}
 
+  /**
+    * Get the content of the current file if it isn't read from disk as it is, e.g. because it
+    * is decompressed while it is read. Called every time the current file is opened.
+    *
+    * \return the content, or nullptr to let the storage implementation open the file itself.
+    */
+  virtual std::shared_ptr<rosbag2_storage::ReadableFile> open_current_readable_file()
+  {
+    return nullptr;
+  }
+
+  /**
+    * Whether the storage implementation can open the next file as it is, without
+    * preprocess_current_file() or open_current_readable_file(). Only then the next file is
+    * opened in the background as configured by StorageOptions::next_file_open_fraction.
+    */
+  virtual bool can_open_next_file_ahead() const
+  {
+    return true;
+  }
+
+  /**
+    * Get the filter set on the storage of each file. Files outside of its time window are
+    * skipped without opening them.
+    *
+    * \return the filter set with set_filter(), unless a subclass needs a wider one.
+    */
+  virtual rosbag2_storage::StorageFilter get_storage_filter() const;
+
+  /**
+    * Read the next message of the current storage, without converting it. Opens the next file
+    * in the background once the current one has been read far enough.
+    */
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next_from_storage();
+
+  /// Read the next messages of the current storage like read_next_from_storage().
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+  read_next_batch_from_storage(size_t max_messages, size_t max_bytes);
+
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_{};
   std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage_{};
   std::unique_ptr<Converter> converter_{};
+  // Converts the messages of read_next_batch() instead of converter_, if conversion_threads > 1
+  std::unique_ptr<ParallelConverter> parallel_converter_{};
+  size_t conversion_threads_ = 0;
   std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_{};
   rosbag2_storage::BagMetadata metadata_{};
   rcutils_time_point_value_t seek_time_ = 0;
@@ -208,9 +277,65 @@ protected:
   std::string base_folder_;
 
 private:
+  // Discard the standby storage and decide when to open the next one for the current file
+  void reset_standby_storage();
+  void open_standby_storage();
+  // Open the standby storage once a message reaches standby_storage_open_time_
+  void check_standby_storage_open_time(rcutils_time_point_value_t time_stamp);
+  // Make the standby storage the current one if it was opened for the current file
+  bool load_standby_storage();
+  // Index the time range of each file so seek() can go straight to the file holding a time stamp
+  void build_file_time_index();
+  // Load the file a time stamp lies in without opening the files in between
+  bool seek_file(const rcutils_time_point_value_t & timestamp);
+  // Make a file the current one and open its storage, or load the standby storage opened for it
+  void load_file(std::vector<std::string>::iterator file);
+  // Whether the file at an index of file_paths_ has no messages in the time window of the filter
+  bool is_outside_time_filter(size_t file_index) const;
+  // Next file in read order which is not outside the time window, file_paths_.end() if none
+  std::vector<std::string>::iterator next_file_in_time_filter();
+  // Filter set on the storage of the file at an index of file_paths_: storage_filter narrowed to
+  // the time window the metadata gives the file, which manifests of other bags' files do
+  rosbag2_storage::StorageFilter get_file_storage_filter(
+    size_t file_index, rosbag2_storage::StorageFilter storage_filter) const;
+  // Replace the payload of a message by the one it refers to, if the bag has references, and
+  // reconstruct it if it is a delta
+  void resolve_payload(rosbag2_storage::SerializedBagMessage & message);
+  // Look up the payload a reference or delta in the current file refers to, nullptr if there
+  // is none
+  std::shared_ptr<rcutils_uint8_array_t> look_up_payload(
+    const std::string & topic, const PayloadReference & reference);
+  // Install a pool for the payloads of read messages if storage_options_.read_buffer_pool_size
+  // is set and no other pool is installed, and uninstall the pool of this reader
+  void install_read_buffer_pool();
+  void uninstall_read_buffer_pool();
+
   rosbag2_storage::StorageOptions storage_options_;
   std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_{};
 
+  // Storage of the file after the current one in read order, opened in the background
+  std::future<std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>>
+  standby_storage_;
+  std::string standby_file_;
+  // Time stamp of the current file after which the standby storage is opened
+  std::optional<rcutils_time_point_value_t> standby_storage_open_time_;
+
+  // Start and end time stamps of each file in file_paths_, empty if the metadata has no
+  // ordered time range for every file
+  std::vector<rcutils_time_point_value_t> file_start_times_;
+  std::vector<rcutils_time_point_value_t> file_end_times_;
+
+  // Resolves references to repeated payloads, if the bag was written with deduplication
+  std::unique_ptr<PayloadResolver> payload_resolver_;
+  // Reconstructs the messages of delta encoded topics, if the bag has any
+  std::unique_ptr<PayloadDeltaDecoder> payload_delta_decoder_;
+  // Second storage of the current file to look up referenced payloads and keyframes, opened on
+  // demand
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> payload_storage_;
+  std::string payload_storage_file_;
+  // Pool this reader installed with rosbag2_storage::set_serialized_message_buffer_pool()
+  std::shared_ptr<rosbag2_storage::BufferPool> read_buffer_pool_;
+
   bag_events::EventCallbackManager callback_manager_;
   rosbag2_storage::ReadOrder read_order_{};
 };
@@ -0,0 +1,182 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__READERS__SHARED_STORAGE_HPP_
+#define ROSBAG2_CPP__READERS__SHARED_STORAGE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * A storage opened once and read through any number of StorageCursor objects.
+ *
+ * The cursors share the storage plugin, and thus its file handles, the parsed summary and the
+ * caches of the plugin, instead of opening the bag once per reader. The metadata, topics and
+ * message definitions are read once when the storage is shared.
+ *
+ * The storage plugin is only accessed with the lock of the shared storage held, so that cursors
+ * may be used from different threads.
+ */
+class ROSBAG2_CPP_PUBLIC SharedStorage
+{
+public:
+  /// \param storage An opened storage, which must not be used but through this object anymore.
+  explicit SharedStorage(
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage);
+
+  /**
+   * Open a single storage file to share it.
+   *
+   * \throws std::runtime_error if the storage could not be opened.
+   */
+  static std::shared_ptr<SharedStorage> open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    rosbag2_storage::StorageFactoryInterface & storage_factory);
+
+  static std::shared_ptr<SharedStorage> open(
+    const rosbag2_storage::StorageOptions & storage_options);
+
+  const rosbag2_storage::BagMetadata & get_metadata() const;
+
+  const std::vector<rosbag2_storage::TopicMetadata> & get_all_topics_and_types() const;
+
+  const std::vector<rosbag2_storage::MessageDefinition> & get_all_message_definitions() const;
+
+private:
+  friend class StorageCursor;
+
+  std::mutex storage_mutex_;
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage_;
+  // The cursor which read from the storage last, which may continue to read without setting
+  // its filter, read order and position again
+  uint64_t last_cursor_id_ = 0;
+  uint64_t next_cursor_id_ = 1;
+  rosbag2_storage::BagMetadata metadata_;
+  std::vector<rosbag2_storage::TopicMetadata> topics_;
+  std::vector<rosbag2_storage::MessageDefinition> message_definitions_;
+};
+
+/**
+ * Reader with its own filter, read order and position in a SharedStorage.
+ *
+ * Messages are read from the shared storage in batches of batch_size messages. For each batch,
+ * the filter and read order of the cursor are applied to the storage, which is then seeked to
+ * the time stamp of the last message read by the cursor. The messages which the cursor has
+ * already read at that time stamp are skipped. Thus, only read orders by received time stamp
+ * are supported.
+ *
+ * A cursor is open from its creation and is not thread safe itself: use one cursor per thread.
+ * Messages are returned in the serialization format of the storage.
+ */
+class ROSBAG2_CPP_PUBLIC StorageCursor
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  static constexpr size_t kDefaultBatchSize = 100;
+
+  explicit StorageCursor(
+    std::shared_ptr<SharedStorage> shared_storage, size_t batch_size = kDefaultBatchSize);
+
+  /// \throws std::runtime_error since cursors are opened by creating them on a SharedStorage.
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  /// Releases the shared storage, which is closed once no cursor uses it anymore.
+  void close() override;
+
+  /// \return false for read orders not sorted by received time stamp.
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  /// Ask the shared storage, without changing its position.
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /// A shared storage is a single file, so that no events are ever raised.
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+private:
+  const SharedStorage & shared_storage() const;
+  // Read the next batch of messages from the shared storage
+  void read_batch();
+  // Drop the messages read ahead and continue reading after the last message returned
+  void discard_read_messages();
+
+  std::shared_ptr<SharedStorage> shared_storage_;
+  uint64_t id_;
+  const size_t batch_size_;
+  rosbag2_storage::StorageFilter storage_filter_;
+  rosbag2_storage::ReadOrder read_order_;
+  std::deque<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages_;
+  bool at_end_ = false;
+  // False once the filter, read order or position of the cursor changed
+  bool storage_in_sync_ = false;
+  // Time stamp of the last message read from the storage, or of the last seek, and the topics
+  // of the messages read at that time stamp, which are skipped when reading the next batch
+  rcutils_time_point_value_t read_time_stamp_ = 0;
+  std::vector<std::string> topics_read_at_read_time_stamp_;
+  // The same for the last message returned by read_next()
+  rcutils_time_point_value_t returned_time_stamp_ = 0;
+  std::vector<std::string> topics_returned_at_returned_time_stamp_;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__SHARED_STORAGE_HPP_
@@ -0,0 +1,179 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__READERS__TAILING_READER_HPP_
+#define ROSBAG2_CPP__READERS__TAILING_READER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_cpp/reader_interfaces/base_reader_interface.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory.hpp"
+#include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+/**
+ * Reader of a bag which is still recorded, which waits for the messages the recorder writes
+ * instead of stopping at the current end of the bag.
+ *
+ * has_next() blocks until the next message is written. The file being recorded is refreshed
+ * with ReadOnlyInterface::refresh() every poll interval, so messages are returned about a poll
+ * interval after the recorder committed them to the file. When the recorder splits the bag, the
+ * reader goes over to the next file once it exists and the previous file gave no messages for
+ * another poll interval, and calls the READ_SPLIT callbacks.
+ *
+ * has_next() returns false once the metadata file of the bag is written and all files are read,
+ * when no message was written for the idle timeout, if one is set, after which has_next() may be
+ * called again to keep waiting, or instead of waiting after stop(). A finished bag is read to its
+ * end.
+ *
+ * Messages are read in file order, which is the order they were written in. The files are found
+ * by the names the recorder gives them, <bag>_<index> with the extension of the storage, so bags
+ * recorded with file compression can not be followed. seek() positions the reader in the file
+ * being read.
+ */
+class ROSBAG2_CPP_PUBLIC TailingReader
+  : public ::rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  explicit TailingReader(
+    std::chrono::milliseconds poll_interval = std::chrono::milliseconds(100),
+    std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0),
+    std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory =
+    std::make_unique<rosbag2_storage::StorageFactory>(),
+    std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory =
+    std::make_shared<SerializationFormatConverterFactory>(),
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  ~TailingReader() override;
+
+  /**
+   * Open the first file of the bag in the directory storage_options.uri, waiting for the
+   * recorder to create it for up to the idle timeout, or until stop() if there is none.
+   *
+   * \throws runtime_error if the first file was not created in time or can not be opened.
+   */
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  void close() override;
+
+  /// \return true for file order only, which is the order messages are written in.
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override;
+
+  /// Wait for the next message. \return false if the recording finished and all its messages
+  /// are read, after stop(), or after the idle timeout.
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  /// The metadata of the file being read, listing the files of the bag read so far.
+  const rosbag2_storage::BagMetadata & get_metadata() const override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  void add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks) override;
+
+  /// Make has_next() return false instead of waiting for messages, until the reader is opened
+  /// again. Can be called from any thread.
+  void stop();
+
+  /// Path of the file being read.
+  std::string get_current_file() const;
+
+private:
+  // Path of the file of the bag with an index, empty if the recorder has not created it yet
+  std::string find_file(size_t index) const;
+  void open_file(const std::string & path);
+  // Add the topics which appeared in the file being read to the converter
+  void add_new_topics_to_converter();
+  // Wait up to a duration, \return false if stop() was called
+  bool wait_for(std::chrono::milliseconds duration);
+
+  std::chrono::milliseconds poll_interval_;
+  std::chrono::milliseconds idle_timeout_;
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_;
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_;
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage_;
+  rosbag2_storage::StorageOptions storage_options_;
+  ConverterOptions converter_options_;
+  std::unique_ptr<Converter> converter_;
+  // Serialization format of the topics and the topics added to the converter so far
+  std::string storage_serialization_format_;
+  std::unordered_set<std::string> converter_topics_;
+  rosbag2_storage::BagMetadata metadata_;
+  rosbag2_storage::StorageFilter storage_filter_;
+  std::string base_folder_;
+  std::vector<std::string> file_paths_;
+  size_t file_index_ = 0;
+  // Extension of the files of the bag, taken from the first one
+  std::string file_extension_;
+  // Whether the storage could not follow appended messages, which is warned about once
+  bool refresh_unsupported_ = false;
+
+  std::atomic_bool stopped_{false};
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+
+  bag_events::EventCallbackManager callback_manager_;
+};
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__READERS__TAILING_READER_HPP_
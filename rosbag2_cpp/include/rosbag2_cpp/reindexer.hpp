@@ -23,9 +23,11 @@
 #ifndef ROSBAG2_CPP__REINDEXER_HPP_
 #define ROSBAG2_CPP__REINDEXER_HPP_
 
+#include <functional>
 #include <memory>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
@@ -83,6 +85,17 @@ public:
   */
   void reindex(const rosbag2_storage::StorageOptions & storage_options);
 
+  /// Reconstruct the metadata of the bag defined by the storage options URI, without writing it.
+  /*
+  * The bag files are opened concurrently. Set storage_options.metadata_only to let the storage
+  * plugins fail instead of scanning bag files which have no summary of their metadata.
+  * \param storage_options Provides best-guess parameters for the bag's original settings.
+  * \return The metadata aggregated from all bag files.
+  * \throws std::runtime_error if no bag files are found, or a bag file can not be read.
+  */
+  rosbag2_storage::BagMetadata reconstruct_metadata(
+    const rosbag2_storage::StorageOptions & storage_options);
+
 protected:
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_{};
   std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_{};
@@ -91,6 +104,8 @@ protected:
 
 private:
   std::string regex_bag_pattern_;
+  // Compiled regex_bag_pattern_
+  std::regex regex_bag_rule_;
   rcpputils::fs::path base_folder_;   // The folder that the bag files are in
   std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory_{};
   void get_bag_files(
@@ -102,16 +117,24 @@ private:
     const std::vector<rcpputils::fs::path> & files,
     const rosbag2_storage::StorageOptions & storage_options);
 
-  // Attempts to harvest metadata from all bag files, and aggregates the result
+  // Attempts to harvest metadata from all bag files, and aggregates the result.
+  // Files are opened concurrently, storage_factory_ has to support concurrent calls.
   void aggregate_metadata(
     const std::vector<rcpputils::fs::path> & files,
-    const std::unique_ptr<rosbag2_cpp::readers::SequentialReader> & bag_reader,
     const rosbag2_storage::StorageOptions & storage_options);
 
-  // Comparison function for std::sort with our filepath convention
-  bool compare_relative_file(
-    const rcpputils::fs::path & first_path,
-    const rcpputils::fs::path & second_path);
+  // Opens a file read-only and returns its metadata
+  rosbag2_storage::BagMetadata read_metadata_of_file(
+    const rcpputils::fs::path & file,
+    const rosbag2_storage::StorageOptions & storage_options);
+
+  // Hands the metadata of every file to on_file_metadata, in the order of files. Files which are
+  // not in journaled_metadata are opened read-only.
+  void read_file_metadata(
+    const std::vector<rcpputils::fs::path> & files,
+    const rosbag2_storage::StorageOptions & storage_options,
+    const std::unordered_map<std::string, rosbag2_storage::BagMetadata> & journaled_metadata,
+    const std::function<void(size_t, const rosbag2_storage::BagMetadata &)> & on_file_metadata);
 };
 
 }  // namespace rosbag2_cpp
@@ -0,0 +1,68 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__THREAD_SCHEDULING_HPP_
+#define ROSBAG2_CPP__THREAD_SCHEDULING_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Scheduling of an internal thread, e.g. to keep it off the cores of real-time processes.
+/// Only supported on Linux.
+struct ThreadScheduling
+{
+  /// Real-time scheduling policy, "fifo" or "rr", used if priority is set.
+  std::string policy = "fifo";
+  /// Real-time priority from 1 to 99. 0 keeps the default scheduling policy.
+  int priority = 0;
+  /// CPUs the thread is pinned to. Empty lets it run on any CPU.
+  std::vector<size_t> cpus;
+
+  bool is_default() const
+  {
+    return priority == 0 && cpus.empty();
+  }
+};
+
+/// Apply the scheduling to the calling thread. Failures, e.g. for lack of the permission to use
+/// real-time priorities, are logged as warnings naming the thread, and leave it as it is.
+ROSBAG2_CPP_PUBLIC
+void apply_thread_scheduling(const std::string & thread_name, const ThreadScheduling & scheduling);
+
+/// CPUs of a NUMA node, e.g. to pin a thread to the node its memory is bound to.
+/// \returns the CPUs, or an empty list if the node is unknown or not on Linux.
+ROSBAG2_CPP_PUBLIC
+std::vector<size_t> get_numa_node_cpus(int numa_node);
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__THREAD_SCHEDULING_HPP_
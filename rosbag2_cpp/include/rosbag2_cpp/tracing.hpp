@@ -0,0 +1,68 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__TRACING_HPP_
+#define ROSBAG2_CPP__TRACING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+/// Emit a tracepoint of the LTTng provider ros2_rosbag2, e.g.
+/// ROSBAG2_CPP_TRACEPOINT(player_publish, topic_name.c_str(), time_stamp).
+/**
+ * Tracepoints are compiled in only if rosbag2_cpp is built with the CMake option
+ * ROSBAG2_ENABLE_TRACING, which requires LTTng-UST. Otherwise the arguments are not evaluated.
+ * The events are recorded with ros2_tracing by enabling "ros2_rosbag2:*" next to "ros2:*".
+ */
+#ifdef ROSBAG2_CPP_TRACING_ENABLED
+# define ROSBAG2_CPP_TRACEPOINT(event_name, ...) \
+  ::rosbag2_cpp::tracing::event_name(__VA_ARGS__)
+#else
+# define ROSBAG2_CPP_TRACEPOINT(event_name, ...) ((void)0)
+#endif
+
+#ifdef ROSBAG2_CPP_TRACING_ENABLED
+namespace rosbag2_cpp
+{
+namespace tracing
+{
+
+/// Start of a rosbag2_cpp::PipelineStage of the recorder.
+ROSBAG2_CPP_PUBLIC void stage_begin(uint8_t stage);
+
+/// End of a rosbag2_cpp::PipelineStage of the recorder.
+ROSBAG2_CPP_PUBLIC void stage_end(uint8_t stage);
+
+/// The cache consumer swapped the buffers of the message cache and took its messages.
+ROSBAG2_CPP_PUBLIC void cache_swap_buffers(size_t messages);
+
+/// The player read a message from the bag.
+ROSBAG2_CPP_PUBLIC void player_read(const char * topic_name, int64_t time_stamp);
+
+/// The player queued a message for playback.
+ROSBAG2_CPP_PUBLIC void player_enqueue(const char * topic_name, int64_t time_stamp);
+
+/// The player woke up from waiting on the clock for the time stamp of the next message.
+ROSBAG2_CPP_PUBLIC void player_wake(int64_t time_stamp, bool due);
+
+/// The player publishes a message.
+ROSBAG2_CPP_PUBLIC void player_publish(const char * topic_name, int64_t time_stamp);
+
+}  // namespace tracing
+}  // namespace rosbag2_cpp
+#endif  // ROSBAG2_CPP_TRACING_ENABLED
+
+#endif  // ROSBAG2_CPP__TRACING_HPP_
@@ -0,0 +1,183 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__TYPED_FAST_PATHS_HPP_
+#define ROSBAG2_CPP__TYPED_FAST_PATHS_HPP_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "rcutils/types/uint8_array.h"
+
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+
+#include "rosidl_runtime_cpp/traits.hpp"
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Operations on serialized messages of one type through the code generated for the type.
+/**
+ * The messages are in the serialization format of the rmw implementation. All operations work
+ * on one message of the C++ type, which is reused, so one instance must not be used on several
+ * threads at once.
+ */
+class ROSBAG2_CPP_PUBLIC TypedMessageOperations
+{
+public:
+  virtual ~TypedMessageOperations() = default;
+
+  /// The message of the C++ type, laid out as described by its introspection type support.
+  virtual void * message() = 0;
+
+  /// \throws std::runtime_error if the message can not be deserialized
+  virtual void deserialize(const rcutils_uint8_array_t & serialized_data) = 0;
+
+  /// Serialize the message into an array, which is resized as needed.
+  /// \throws std::runtime_error if the message can not be serialized
+  virtual void serialize(rcutils_uint8_array_t & serialized_data) = 0;
+
+  /// Deserialize a message and check it.
+  /// \return An empty string if the message is valid, otherwise why it is not
+  virtual std::string validate(const rcutils_uint8_array_t & serialized_data) = 0;
+};
+
+/// Checks of a message type beyond deserialization, to specialize for hot types.
+/**
+ * E.g. a specialization for sensor_msgs::msg::Image may check that the size of the data matches
+ * the step and height of the image.
+ */
+template<typename MessageT>
+struct TypedMessageTraits
+{
+  /// \return An empty string if the message is valid, otherwise why it is not
+  static std::string validate(const MessageT &)
+  {
+    return "";
+  }
+};
+
+template<typename MessageT>
+class TypedMessageOperationsImpl : public TypedMessageOperations
+{
+public:
+  TypedMessageOperationsImpl()
+  : type_support_(rosidl_typesupport_cpp::get_message_type_support_handle<MessageT>())
+  {}
+
+  void * message() override
+  {
+    return &message_;
+  }
+
+  void deserialize(const rcutils_uint8_array_t & serialized_data) override
+  {
+    if (rmw_deserialize(&serialized_data, type_support_, &message_) != RMW_RET_OK) {
+      throw_rmw_error("deserialize");
+    }
+  }
+
+  void serialize(rcutils_uint8_array_t & serialized_data) override
+  {
+    if (rmw_serialize(&message_, type_support_, &serialized_data) != RMW_RET_OK) {
+      throw_rmw_error("serialize");
+    }
+  }
+
+  std::string validate(const rcutils_uint8_array_t & serialized_data) override
+  {
+    try {
+      deserialize(serialized_data);
+    } catch (const std::runtime_error & e) {
+      return e.what();
+    }
+    return TypedMessageTraits<MessageT>::validate(message_);
+  }
+
+private:
+  [[noreturn]] void throw_rmw_error(const std::string & operation) const
+  {
+    const std::string error = rmw_get_error_string().str;
+    rmw_reset_error();
+    throw std::runtime_error(
+            "Failed to " + operation + " " + rosidl_generator_traits::name<MessageT>() + ": " +
+            error);
+  }
+
+  const rosidl_message_type_support_t * type_support_;
+  MessageT message_;
+};
+
+/// Registry of the typed operations of message types, keyed by type name.
+/**
+ * Converter and FieldExtractor use the operations of a registered type instead of the generic
+ * introspection path when the messages are in the serialization format of the rmw
+ * implementation. Register the types which dominate the recorded bytes, e.g.
+ *
+ *   rosbag2_cpp::TypedFastPathRegistry::instance().add<sensor_msgs::msg::PointCloud2>();
+ *
+ * before opening readers or writers.
+ */
+class ROSBAG2_CPP_PUBLIC TypedFastPathRegistry
+{
+public:
+  using Factory = std::function<std::unique_ptr<TypedMessageOperations>()>;
+
+  static TypedFastPathRegistry & instance();
+
+  /// Register the operations of a type, e.g. "sensor_msgs/msg/Imu", replacing earlier ones.
+  void add(const std::string & type, Factory factory);
+
+  template<typename MessageT>
+  void add()
+  {
+    add(
+      rosidl_generator_traits::name<MessageT>(),
+      []() {return std::make_unique<TypedMessageOperationsImpl<MessageT>>();});
+  }
+
+  /// \return Whether operations of the type were registered
+  bool remove(const std::string & type);
+
+  /// \return New operations for messages of a type, or nullptr if none are registered
+  std::unique_ptr<TypedMessageOperations> make_operations(const std::string & type) const;
+
+private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Factory> factories_;
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__TYPED_FAST_PATHS_HPP_
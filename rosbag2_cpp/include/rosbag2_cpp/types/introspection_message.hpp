@@ -15,7 +15,9 @@
 #ifndef ROSBAG2_CPP__TYPES__INTROSPECTION_MESSAGE_HPP_
 #define ROSBAG2_CPP__TYPES__INTROSPECTION_MESSAGE_HPP_
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "rcutils/allocator.h"
 #include "rcutils/time.h"
@@ -26,6 +28,14 @@
 
 struct rosidl_message_type_support_t;
 
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
 namespace rosbag2_cpp
 {
 
@@ -37,6 +47,58 @@ typedef struct ROSBAG2_CPP_PUBLIC_TYPE rosbag2_introspection_message_t
   rcutils_allocator_t allocator;
 } rosbag2_introspection_message_t;
 
+/// Monotonic allocator for introspection messages, usable through an rcutils_allocator_t.
+/**
+ * Allocations are carved one after another from blocks of block_size bytes, deallocations are
+ * no-ops. reset() hands out the same blocks again, so an arena which is reset once its messages
+ * are destroyed, e.g. per message or per batch of messages of a topic, stops allocating memory
+ * after the first round.
+ *
+ * Only the memory allocated through the rcutils allocator comes from the arena, i.e. the message
+ * itself and its topic name. The sequences and strings of C++ messages are allocated by their
+ * std containers.
+ *
+ * The arena is not thread-safe and must outlive every allocation from it.
+ */
+class ROSBAG2_CPP_PUBLIC IntrospectionMessageArena
+{
+public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit IntrospectionMessageArena(size_t block_size = kDefaultBlockSize);
+
+  IntrospectionMessageArena(const IntrospectionMessageArena &) = delete;
+  IntrospectionMessageArena & operator=(const IntrospectionMessageArena &) = delete;
+
+  /// Get size bytes aligned for any type, from a new block if the current one is full.
+  void * allocate(size_t size);
+
+  /// Allocate size bytes keeping the content of pointer, which was allocated from this arena.
+  void * reallocate(void * pointer, size_t size);
+
+  /// Hand out the blocks again from the start. Invalidates every allocation from the arena.
+  void reset();
+
+  /// \return an rcutils allocator which allocates from this arena.
+  rcutils_allocator_t get_allocator();
+
+  /// \return number of bytes handed out since the last reset().
+  size_t get_used_bytes() const;
+
+private:
+  struct Block
+  {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  const size_t block_size_;
+  std::vector<Block> blocks_;
+  size_t current_block_ {0};
+  size_t block_offset_ {0};
+  size_t used_bytes_ {0};
+};
+
 ROSBAG2_CPP_PUBLIC
 std::shared_ptr<rosbag2_introspection_message_t>
 allocate_introspection_message(
@@ -57,4 +119,8 @@ void deallocate_introspection_message(
 
 }  // namespace rosbag2_cpp
 
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
 #endif  // ROSBAG2_CPP__TYPES__INTROSPECTION_MESSAGE_HPP_
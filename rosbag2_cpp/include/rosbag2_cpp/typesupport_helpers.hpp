@@ -29,6 +29,11 @@
 namespace rosbag2_cpp
 {
 
+/// Load the typesupport library of the package of a message type.
+///
+/// The library is shared by all callers until the last of them releases it, so that the library
+/// of a package is only looked up and loaded once for all of its message types. Thread-safe.
+/// \throws std::runtime_error if the package or library cannot be found.
 ROSBAG2_CPP_PUBLIC
 std::shared_ptr<rcpputils::SharedLibrary>
 get_typesupport_library(const std::string & type, const std::string & typesupport_identifier);
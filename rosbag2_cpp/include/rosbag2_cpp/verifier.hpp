@@ -0,0 +1,100 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__VERIFIER_HPP_
+#define ROSBAG2_CPP__VERIFIER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/visibility_control.hpp"
+
+#include "rosbag2_storage/file_verification.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+
+/// Result of verifying a bag, see Verifier::verify().
+struct ROSBAG2_CPP_PUBLIC BagVerification
+{
+  struct File
+  {
+    // Path of the file as listed in the metadata
+    std::string path;
+    rosbag2_storage::FileVerification verification;
+    // Set if the file could not be opened, verification is empty then
+    std::string error;
+  };
+
+  // In the order of the metadata
+  std::vector<File> files;
+  // Message counts of files and topics which differ from the metadata
+  std::vector<std::string> metadata_mismatches;
+
+  /// Whether every file could be verified without problems and matches the metadata.
+  bool ok() const;
+};
+
+/**
+ * Tool to check the integrity of a bag without playing or converting it.
+ *
+ * Every file listed in the metadata is verified by its storage plugin, see
+ * ReadOnlyInterface::verify(), and the intact messages are counted against the metadata. Files
+ * are verified concurrently, so that bags split over several files or disks are read at their
+ * aggregate bandwidth.
+ */
+class ROSBAG2_CPP_PUBLIC Verifier
+{
+public:
+  Verifier(
+    std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory =
+    std::make_unique<rosbag2_storage::StorageFactory>(),
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  virtual ~Verifier() = default;
+
+  /// Verify the bag defined by the storage options URI.
+  /*
+  * \param threads Number of files verified at a time, 0 for one per CPU core.
+  * \throws std::runtime_error if the bag has no metadata, or its files are compressed as a whole.
+  */
+  BagVerification verify(
+    const rosbag2_storage::StorageOptions & storage_options, size_t threads = 0);
+
+protected:
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_{};
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_{};
+};
+
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__VERIFIER_HPP_
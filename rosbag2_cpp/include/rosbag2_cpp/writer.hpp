@@ -15,6 +15,8 @@
 #ifndef ROSBAG2_CPP__WRITER_HPP_
 #define ROSBAG2_CPP__WRITER_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -27,10 +29,12 @@
 
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 #include "rosbag2_cpp/writers/sequential_writer.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
 
@@ -114,6 +118,28 @@ public:
     const rosbag2_storage::TopicMetadata & topic_with_type,
     const rosbag2_storage::MessageDefinition & message_definition);
 
+  /**
+   * Start looking up the message definitions of topics which are about to be created with
+   * create_topic(topic_with_type), if the writer looks them up in the background, see
+   * rosbag2_storage::StorageOptions::message_definition_threads.
+   *
+   * \param topics name, type identifier and type description hash of the topics
+   */
+  void prefetch_message_definitions(const std::vector<rosbag2_storage::TopicMetadata> & topics);
+
+  /**
+   * Copy the messages of a bag file of the same storage format into the bag, as stored.
+   * Has to be called before any topic is created, the topics of the copied messages are created
+   * by the copy. Messages are neither converted nor compressed and the bag is not split.
+   *
+   * \param uri Path of the bag file to copy from
+   * \param storage_filter Topics and time range of the messages to copy
+   * \returns true if the messages were copied, false if the writer or its storage can not copy
+   * the file, nothing was written then.
+   */
+  bool copy_bag_file(
+    const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter);
+
   /**
    * Trigger a snapshot when snapshot mode is enabled.
    * \returns true if snapshot is successful, false if snapshot fails or is not supported
@@ -135,6 +161,16 @@ public:
    */
   void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type);
 
+  /**
+   * Whether a message with a time stamp would be written, i.e. whether the time stamp lies within
+   * StorageOptions::start_time_ns and end_time_ns of the open bag. Messages outside of the
+   * window are discarded by write() before anything is allocated or copied for them.
+   *
+   * \note Lock-free, so that e.g. subscription callbacks can discard messages before they
+   * prepare them for writing.
+   */
+  bool is_within_time_window(rcutils_time_point_value_t time_stamp) const;
+
   /**
    * Write a message to a bagfile. The topic needs to have been created before writing is possible.
    *
@@ -185,7 +221,9 @@ public:
    * Write a serialized message to a bagfile.
    * The topic will be created if it has not been created already.
    *
-   * \warning after calling this function, the serialized data will no longer be managed by message.
+   * \note The payload is not copied. The bag message references the buffer of message and keeps
+   * message alive until the last reference to the bag message (e.g. in the cache, in the
+   * compression queue or in the snapshot buffer) has been released.
    *
    * \param message rclcpp::SerializedMessage The serialized message to be written to the bagfile
    * \param topic_name the string of the topic this messages belongs to
@@ -199,6 +237,29 @@ public:
     const std::string & type_name,
     const rclcpp::Time & time);
 
+  /**
+   * Write a serialized message to a bagfile along with the publish information of the message.
+   * The topic will be created if it has not been created already.
+   *
+   * \note The payload is not copied, see write(std::shared_ptr<const rclcpp::SerializedMessage>,
+   * const std::string &, const std::string &, const rclcpp::Time &).
+   *
+   * \param message rclcpp::SerializedMessage The serialized message to be written to the bagfile
+   * \param topic_name the string of the topic this messages belongs to
+   * \param type_name the string of the type associated with this message
+   * \param time The time stamp of the message
+   * \param send_timestamp Time the message was published, 0 if unknown
+   * \param sequence_number Sequence number the publisher assigned to the message, 0 if unknown
+   * \throws runtime_error if the Writer is not open.
+   */
+  void write(
+    std::shared_ptr<const rclcpp::SerializedMessage> message,
+    const std::string & topic_name,
+    const std::string & type_name,
+    const rclcpp::Time & time,
+    rcutils_time_point_value_t send_timestamp,
+    uint64_t sequence_number);
+
   /**
    * Write a non-serialized message to a bagfile.
    * The topic will be created if it has not been created already.
@@ -233,9 +294,28 @@ public:
    */
   void add_event_callbacks(bag_events::WriterEventCallbacks & callbacks);
 
+  /**
+   * Record the latencies of write() and of the stages of the writer implementation into
+   * statistics. Has to be called before open(). nullptr stops recording.
+   */
+  void set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics);
+
+  std::shared_ptr<PipelineStatistics> get_pipeline_statistics() const;
+
 private:
+  /// Create the topic of message if needed and write message tagged with its topic id,
+  /// so that the topic is looked up by name only once per message.
+  void write_tagged(
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message,
+    const std::string & type_name,
+    const std::string & serialization_format);
+
   std::mutex writer_mutex_;
   std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> writer_impl_;
+  // Time window of the open bag, negative for no bound. Read without taking writer_mutex_.
+  std::atomic<rcutils_time_point_value_t> start_time_ns_{-1};
+  std::atomic<rcutils_time_point_value_t> end_time_ns_{-1};
+  std::shared_ptr<PipelineStatistics> pipeline_statistics_;
 };
 
 }  // namespace rosbag2_cpp
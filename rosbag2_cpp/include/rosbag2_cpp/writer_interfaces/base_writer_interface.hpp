@@ -15,14 +15,19 @@
 #ifndef ROSBAG2_CPP__WRITER_INTERFACES__BASE_WRITER_INTERFACE_HPP_
 #define ROSBAG2_CPP__WRITER_INTERFACES__BASE_WRITER_INTERFACE_HPP_
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "rosbag2_cpp/bag_events.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/message_definition.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
 
@@ -50,8 +55,43 @@ public:
 
   virtual void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) = 0;
 
+  /**
+   * Start looking up the message definitions of topics which are about to be created, so that
+   * create_topic() does not have to wait for them. Does nothing for writers which do not look up
+   * message definitions in the background.
+   */
+  virtual void prefetch_message_definitions(
+    const std::vector<rosbag2_storage::TopicMetadata> & /* topics */)
+  {
+  }
+
+  /**
+   * Id of a created topic, to be set as SerializedBagMessage::topic_id of messages written
+   * on the topic.
+   * \returns rosbag2_storage::UNASSIGNED_TOPIC_ID if the topic was not created or the writer
+   * does not assign topic ids.
+   */
+  virtual uint32_t get_topic_id(const std::string & /* topic_name */) const
+  {
+    return rosbag2_storage::UNASSIGNED_TOPIC_ID;
+  }
+
   virtual void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) = 0;
 
+  /**
+   * Copy the messages of a bag file of the same storage format into the bag, without
+   * deserializing them and without re-encoding them where the storage allows.
+   * Has to be called before any topic is created, the topics of the copied messages are created
+   * by the copy.
+   * \returns true if the messages were copied, false if the writer or its storage can not copy
+   * the file. Nothing was written then.
+   */
+  virtual bool copy_bag_file(
+    const std::string & /* uri */, const rosbag2_storage::StorageFilter & /* storage_filter */)
+  {
+    return false;
+  }
+
   /**
    * Triggers a snapshot for writers that support it.
    * \returns true if snapshot is successful, false if snapshot fails or is not supported
@@ -64,6 +104,15 @@ public:
   virtual void split_bagfile() = 0;
 
   virtual void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) = 0;
+
+  /**
+   * Record the latencies of the cache, storage and compression stages of the writer into
+   * statistics. Has to be called before open(). Does nothing for writers which are not
+   * instrumented.
+   */
+  virtual void set_pipeline_statistics(std::shared_ptr<PipelineStatistics> /* statistics */)
+  {
+  }
 };
 
 }  // namespace writer_interfaces
@@ -0,0 +1,166 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__WRITERS__ROUTING_WRITER_HPP_
+#define ROSBAG2_CPP__WRITERS__ROUTING_WRITER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
+
+#include "rosbag2_storage/metadata_io.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+/**
+ * Writer which routes the topics of a bag into separate sub-bags, e.g. camera images apart from
+ * light telemetry, so that reading the telemetry does not go through the images.
+ *
+ * Every route is a sub-bag of its own in a directory named after the route in the bag directory,
+ * written by its own writer. Every sub-bag thus has its own message cache, written on its own
+ * thread, and may have its own compression and split policy. Topics which match no route are
+ * written into the sub-bag kDefaultRouteName with the storage options of the bag.
+ *
+ * On close(), the metadata of the sub-bags is merged into the metadata of the bag, which lists
+ * the files of all sub-bags and the sub-bags under kSubBagsKey of its custom data. The files of
+ * the sub-bags overlap in time, so the bag is read merged by time, with a MergingReader of its
+ * files or, if the sub-bags are compressed, a MultiBagReader of the sub-bags.
+ */
+class ROSBAG2_CPP_PUBLIC RoutingWriter
+  : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  struct Route
+  {
+    /// Name of the sub-bag, which is a directory in the bag directory.
+    std::string name;
+    /// Regular expression which the whole name of the routed topics matches.
+    std::string topics_regex;
+    /// Split policy and message cache of the sub-bag, if not those of the bag.
+    std::optional<uint64_t> max_bagfile_size;
+    std::optional<uint64_t> max_bagfile_duration;
+    std::optional<uint64_t> max_cache_size;
+  };
+
+  /// Creates the writer of the sub-bag of a route, given the name of the route.
+  using SubBagWriterFactory =
+    std::function<std::unique_ptr<writer_interfaces::BaseWriterInterface>(const std::string &)>;
+
+  static constexpr const char * kDefaultRouteName = "default";
+  /// Key of the custom data of the bag metadata listing the sub-bags, separated by commas.
+  static constexpr const char * kSubBagsKey = "routed_sub_bags";
+
+  /**
+   * \param routes Routes of topics into sub-bags. A topic is routed by the first route it
+   *   matches.
+   * \param sub_bag_writer_factory Creates the writers of the sub-bags. By default, a
+   *   SequentialWriter.
+   * \throws std::invalid_argument if there are no routes, or a route has an invalid or a
+   *   duplicate name, or an invalid regular expression.
+   */
+  explicit RoutingWriter(
+    std::vector<Route> routes,
+    SubBagWriterFactory sub_bag_writer_factory = nullptr,
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  ~RoutingWriter() override;
+
+  /**
+   * Create the bag directory at storage_options.uri and open a writer for every sub-bag.
+   *
+   * \throws std::runtime_error if the bag directory exists.
+   */
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  /// Close the writers of all sub-bags and write the merged metadata of the bag.
+  void close() override;
+
+  void create_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata & topic_with_type,
+    const rosbag2_storage::MessageDefinition & message_definition) override;
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  void prefetch_message_definitions(
+    const std::vector<rosbag2_storage::TopicMetadata> & topics) override;
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
+
+  /// Take a snapshot on all sub-bags. \returns true if all sub-bags took their snapshot.
+  bool take_snapshot() override;
+
+  /// Split the bag files of all sub-bags.
+  void split_bagfile() override;
+
+  void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) override;
+
+  void set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics) override;
+
+  /// Name of the route of a topic, kDefaultRouteName if it matches no route.
+  std::string get_route_name(const std::string & topic_name) const;
+
+private:
+  // Index of the first route a topic matches, routes_.size() for the default route
+  size_t match_route(const std::string & topic_name) const;
+  // Index of the sub-bag of a topic in sub_bags_, cached per topic
+  size_t route_of(const std::string & topic_name);
+
+  std::vector<Route> routes_;
+  std::vector<std::regex> route_regexes_;
+  SubBagWriterFactory sub_bag_writer_factory_;
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
+  std::shared_ptr<PipelineStatistics> pipeline_statistics_;
+
+  std::string base_folder_;
+  std::vector<std::string> sub_bag_uris_;
+  std::vector<std::unique_ptr<writer_interfaces::BaseWriterInterface>> sub_bags_;
+  std::unordered_map<std::string, size_t> topic_routes_;
+};
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__WRITERS__ROUTING_WRITER_HPP_
@@ -15,6 +15,9 @@
 #ifndef ROSBAG2_CPP__WRITERS__SEQUENTIAL_WRITER_HPP_
 #define ROSBAG2_CPP__WRITERS__SEQUENTIAL_WRITER_HPP_
 
+#include <atomic>
+#include <deque>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -22,12 +25,19 @@
 #include <vector>
 
 #include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/bag_preview.hpp"
 #include "rosbag2_cpp/cache/cache_consumer.hpp"
 #include "rosbag2_cpp/cache/circular_message_cache.hpp"
+#include "rosbag2_cpp/cache/lock_free_message_cache.hpp"
 #include "rosbag2_cpp/cache/message_cache.hpp"
 #include "rosbag2_cpp/cache/message_cache_interface.hpp"
+#include "rosbag2_cpp/cache/sharded_message_cache.hpp"
 #include "rosbag2_cpp/converter.hpp"
 #include "rosbag2_cpp/message_definitions/local_message_definition_source.hpp"
+#include "rosbag2_cpp/parallel_converter.hpp"
+#include "rosbag2_cpp/payload_deduplication.hpp"
+#include "rosbag2_cpp/payload_delta_encoding.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
 #include "rosbag2_cpp/serialization_format_converter_factory.hpp"
 #include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
@@ -38,6 +48,7 @@
 #include "rosbag2_storage/storage_factory_interface.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 
 // This is necessary because of using stl types here. It is completely safe, because
 // a) the member is not accessible from the outside
@@ -96,6 +107,8 @@ public:
   /**
    * Create a new topic in the underlying storage. Needs to be called for every topic used within
    * a message which is passed to write(...).
+   * With a cache, the topic is registered with the storage by the cache consumer thread before
+   * it writes the next batch of messages, so that this does not wait for a batch being written.
    *
    * \param topic_with_type name and type identifier of topic to be created
    * \param message_definition message definition content for this topic's type
@@ -115,6 +128,19 @@ public:
    */
   void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
 
+  /**
+   * Look up the message definitions of the topics on the message definition threads.
+   * Does nothing if StorageOptions::message_definition_threads is 0.
+   */
+  void prefetch_message_definitions(
+    const std::vector<rosbag2_storage::TopicMetadata> & topics) override;
+
+  /**
+   * Ids are assigned by create_topic() and are not reused after remove_topic().
+   * Messages carrying the id of their topic are written without any topic name lookup.
+   */
+  uint32_t get_topic_id(const std::string & topic_name) const override;
+
   /**
    * Write a message to a bagfile. The topic needs to have been created before writing is possible.
    * Only writes message if within start_time_ns and end_time_ns (from storage_options).
@@ -124,6 +150,18 @@ public:
    */
   void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
 
+  /**
+   * Copy the messages of a bag file into the current bag file through the storage, see
+   * rosbag2_storage::storage_interfaces::ReadWriteInterface::copy_file().
+   * Not possible once a topic was created, with a serialization format conversion, with
+   * splitting or in snapshot mode. The time range of the storage options is applied on top of
+   * the one of storage_filter.
+   *
+   * \throws runtime_error if the Writer is not open.
+   */
+  bool copy_bag_file(
+    const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter) override;
+
   /**
    * Take a snapshot by triggering a circular buffer flip, writing data to disk.
    * *\returns true if snapshot is successful
@@ -141,6 +179,12 @@ public:
    */
   void split_bagfile() override;
 
+  /**
+   * Record the latencies of pushing messages into the cache, of consuming the batches of the
+   * cache and of writing to storage, and the sizes of the batches of the cache.
+   */
+  void set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics) override;
+
 protected:
   std::string base_folder_;
   std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory_;
@@ -148,29 +192,152 @@ protected:
   std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage_;
   std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
   std::unique_ptr<Converter> converter_;
+  // Converts the batches of the cache consumer instead of converter_, if conversion_threads > 1
+  std::unique_ptr<ParallelConverter> parallel_converter_;
 
   bool use_cache_ {false};
   std::shared_ptr<rosbag2_cpp::cache::MessageCacheInterface> message_cache_;
   std::unique_ptr<rosbag2_cpp::cache::CacheConsumer> cache_consumer_;
 
-  void switch_to_next_storage();
+  // Latencies of the stages of the writer are recorded into it, if set
+  std::shared_ptr<PipelineStatistics> pipeline_statistics_;
+
+  // Statistics of the current bag file, reported with the WRITE_SPLIT event
+  LatencyHistogram file_write_latencies_;
+  uint64_t file_start_dropped_message_count_ = 0;
+  std::atomic<uint64_t> file_uncompressed_bytes_ {0};
+  std::atomic<uint64_t> file_compressed_bytes_ {0};
+
+  /**
+   * Flushes the cache and continues writing into the next storage.
+   * \param closed_file_statistics Filled in with the statistics of the previous file. Its
+   * close_duration is only filled in if the file is closed here.
+   * \returns the previous storage if it is closed in the background (async_split),
+   * nullptr if it was closed already.
+   */
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+  switch_to_next_storage(bag_events::BagFileStatistics & closed_file_statistics);
+
+  /// Count the bytes of a message before and after compression into the statistics of the
+  /// current bag file. Safe to call from any thread.
+  void count_compressed_bytes(uint64_t uncompressed_size, uint64_t compressed_size);
+
+  /// Open the storage for the next bag file in the background, if async_split is enabled and
+  /// the bag is split by size or duration.
+  void prepare_standby_storage();
+
+  /// Close the standby storage which was not used and remove its file.
+  void discard_standby_storage();
+
+  /// Update metadata of storage and close it in the background, then call the WRITE_SPLIT
+  /// callbacks with split_info. Storages are closed in the order they are passed in.
+  void close_storage_async(
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage,
+    const rosbag2_storage::BagMetadata & metadata,
+    std::shared_ptr<bag_events::BagSplitInfo> split_info);
+
+  /// Block until all storages passed to close_storage_async() are closed.
+  void wait_for_closing_storages();
+
+  /// Remove the oldest closed bag files beyond the retention budgets of the storage options
+  /// from the metadata, once the current file was split off, and delete them in the background.
+  /// The most recently closed file is always kept.
+  void apply_retention_budgets(
+    uint64_t closed_file_size, std::vector<size_t> closed_file_topic_message_counts);
+
+  /// Block until the files removed by apply_retention_budgets() are deleted.
+  void wait_for_retention_deletions();
+
+  /// Append the metadata of the current bag file to the metadata journal of the bag, before
+  /// the writer continues with the next file. Failures are only logged.
+  void append_current_file_to_metadata_journal();
+
+  /// Fill in the statistics of the current bag file except its size and close duration, once
+  /// all its messages are written, and start the statistics of the next one.
+  void collect_file_statistics(bag_events::BagFileStatistics & statistics);
+
+  /// Write the statistics of the topics written so far next to the metadata of the bag.
+  /// Failures are only logged.
+  void write_topic_statistics();
+
+  /// Write the preview of the messages written so far next to the metadata of the bag, if
+  /// enabled. Failures are only logged.
+  void write_preview();
 
   std::string format_storage_uri(
     const std::string & base_folder, uint64_t storage_count);
 
   rosbag2_storage::StorageOptions storage_options_;
 
-  // Used to track topic -> message count. If cache is present, it is updated by CacheConsumer
+  // Used to track created topics. Message counts are filled in by finalize_metadata()
   std::unordered_map<std::string, rosbag2_storage::TopicInformation> topics_names_to_info_;
   std::mutex topics_info_mutex_;
 
-  LocalMessageDefinitionSource message_definitions_;
+  // Topic ids assigned by create_topic(). The name is empty for ids of removed topics.
+  struct TopicIds
+  {
+    std::unordered_map<std::string, uint32_t> names_to_ids;
+    std::vector<std::string> ids_to_names;
+  };
+  // Replaced as a whole under topics_info_mutex_ when a topic is created or removed, so that
+  // threads writing messages look ids up without locking. Accessed with std::atomic_load() and
+  // std::atomic_store().
+  std::shared_ptr<const TopicIds> topic_ids_ = std::make_shared<const TopicIds>();
+
+  // Topics created or removed while the cache consumer writes to storage, in order. The cache
+  // consumer registers them with the storage before writing its next batch. Guarded by
+  // topics_info_mutex_.
+  struct TopicRegistration
+  {
+    rosbag2_storage::TopicMetadata topic_metadata;
+    rosbag2_storage::MessageDefinition message_definition;
+    bool remove;
+  };
+  std::vector<TopicRegistration> pending_topic_registrations_;
+
+  // Messages written to storage per topic id. Only accessed by the thread writing to storage,
+  // which is the cache consumer thread if cache is present.
+  std::vector<size_t> topic_message_counts_;
+  // topic_message_counts_ when the current bag file was opened
+  std::vector<size_t> file_start_topic_message_counts_;
+  // Statistics of the messages written to storage per topic id, accessed like
+  // topic_message_counts_
+  std::vector<rosbag2_storage::TopicStatistics> topic_statistics_;
+  // Preview of the messages written to storage, accessed like topic_message_counts_, if enabled
+  std::unique_ptr<BagPreview> preview_;
+
+  // Created by open(), with the cache directory and threads of the storage options
+  std::unique_ptr<LocalMessageDefinitionSource> message_definitions_;
   // used to track message definitions written to the bag.
   std::unordered_map<std::string,
     rosbag2_storage::MessageDefinition> topic_names_to_message_definitions_;
 
   rosbag2_storage::BagMetadata metadata_;
 
+  // Storage opened in the background for the next bag file and its uri
+  std::future<std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>>
+  standby_storage_;
+  std::string standby_storage_uri_;
+
+  // Completes when the last storage handed to close_storage_async() is closed
+  std::future<void> closing_storage_;
+
+  // Size and messages per topic id of the closed bag files in metadata_.files, oldest first.
+  // Only tracked if a retention budget is set.
+  struct RetainedFile
+  {
+    uint64_t size;
+    std::vector<size_t> topic_message_counts;
+  };
+  std::deque<RetainedFile> retained_files_;
+  uint64_t retained_bytes_ = 0;
+  // Messages per topic id in the bag files deleted for the retention budgets
+  std::vector<size_t> deleted_topic_message_counts_;
+  // New bag files are numbered after the deleted ones
+  size_t deleted_file_count_ = 0;
+  // Completes when the files removed by apply_retention_budgets() so far are deleted
+  std::future<void> retention_deletion_;
+
   // Checks if the current recording bagfile needs to be split and rolled over to a new file.
   bool should_split_bagfile(
     const std::chrono::time_point<std::chrono::high_resolution_clock> & current_time) const;
@@ -192,13 +359,63 @@ protected:
   get_writeable_message(
     std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
 
+  // Writes a batch of messages handed over by the cache consumer to storage.
+  // Called on the cache consumer thread, before the messages are counted.
+  virtual void write_batch_to_storage(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
 private:
+  /// Whether topics are registered with the storage by the cache consumer thread
+  bool registers_topics_on_cache_consumer() const;
+
+  /// Assign the next topic id to a topic and publish it. Called with topics_info_mutex_ held.
+  uint32_t assign_topic_id(const std::string & topic_name);
+
+  /// Register the topics created or removed since the last call with the storage
+  void register_pending_topics();
+
+  /// Id of the topic of message, looked up by name if message is not tagged with an id.
+  /// \throws runtime_error if the topic was not created or the id does not match the topic.
+  uint32_t resolve_topic_id(const rosbag2_storage::SerializedBagMessage & message) const;
+
+  /// Message as it is stored: delta encoded or deduplicated, if enabled
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> encode_payload(
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message);
+
+  /// Count a message written to storage and add it to the statistics of its topic
+  void count_written_message(
+    uint32_t topic_id, const rosbag2_storage::SerializedBagMessage & message);
+
   /// Helper method to write messages while also updating tracked metadata.
   void write_messages(
     const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages);
+
+  /// Write a snapshot taken in snapshot mode to a bag file of its own and update its metadata.
+  /// Messages streamed after a snapshot continue it and go to the same bag file.
+  /// Called on the cache consumer thread, which writes the snapshots one after another.
+  void write_snapshot(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages,
+    bool continues_snapshot);
+
   bool is_first_message_ {true};
 
+  // Replaces repeated payloads by references as they are written to storage, if enabled.
+  // Only used on the thread writing to storage, and reset for every bag file.
+  std::unique_ptr<PayloadDeduplicator> payload_deduplicator_;
+  // Replaces messages of delta encoded topics by deltas to keyframes, if enabled.
+  // Only used on the thread writing to storage, and reset for every bag file.
+  std::unique_ptr<PayloadDeltaEncoder> payload_delta_encoder_;
+
+  // In snapshot mode, the storage is switched on the cache consumer thread. Guards switching
+  // the storage and the metadata of the bag files against splits and topic changes requested by
+  // other threads.
+  std::mutex snapshot_storage_mutex_;
+  // Whether a snapshot was written to the current bag file
+  bool snapshot_in_current_file_ {false};
+
   bag_events::EventCallbackManager callback_manager_;
+  // Callbacks are also called from the thread closing storages in the background
+  std::mutex callback_manager_mutex_;
 };
 
 }  // namespace writers
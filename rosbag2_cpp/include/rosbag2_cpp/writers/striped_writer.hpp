@@ -0,0 +1,162 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__WRITERS__STRIPED_WRITER_HPP_
+#define ROSBAG2_CPP__WRITERS__STRIPED_WRITER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
+#include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
+
+#include "rosbag2_storage/metadata_io.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+/**
+ * Writer which stripes the messages of a bag over several directories, e.g. on separate disks.
+ *
+ * Every stripe is a bag of its own, written by its own writer into a directory named after the
+ * bag in one of the stripe directories. With a message cache, every stripe writer writes on its
+ * own thread, so that the write bandwidth scales with the number of disks.
+ * Messages are assigned to stripes by a hash of their topic, so that all messages of a topic are
+ * in one stripe, or in turns in batches of batch_bytes of serialized data.
+ *
+ * Stripes in the bag directory itself shard the bag instead, each shard is written on a thread
+ * of its own from a cache of its own, so that the write bandwidth scales with the cores when a
+ * single writer thread can not keep up.
+ *
+ * On close(), the metadata of the stripes is merged into the metadata of the bag, which lists
+ * the files of all stripes. The files of the stripes overlap in time, the bag is read merged by
+ * time with a MergingReader.
+ */
+class ROSBAG2_CPP_PUBLIC StripedWriter
+  : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  using StripeWriterFactory =
+    std::function<std::unique_ptr<writer_interfaces::BaseWriterInterface>()>;
+
+  enum class StripeBy
+  {
+    TOPIC,
+    BATCH,
+  };
+
+  static constexpr size_t kDefaultBatchBytes = 4 * 1024 * 1024;
+
+  /**
+   * \param stripe_directories Directories to write a stripe into each. An empty directory stands
+   *   for the bag directory.
+   * \param stripe_writer_factory Creates the writers of the stripes. By default, a
+   *   SequentialWriter.
+   * \param stripe_by How messages are assigned to stripes.
+   * \param batch_bytes Serialized data written to a stripe before the next one, for
+   *   StripeBy::BATCH.
+   * \throws std::invalid_argument if there are no stripe directories.
+   */
+  explicit StripedWriter(
+    std::vector<std::string> stripe_directories,
+    StripeWriterFactory stripe_writer_factory = nullptr,
+    StripeBy stripe_by = StripeBy::TOPIC,
+    size_t batch_bytes = kDefaultBatchBytes,
+    std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io =
+    std::make_unique<rosbag2_storage::MetadataIo>());
+
+  ~StripedWriter() override;
+
+  /**
+   * Create the bag directory at storage_options.uri and open a writer for every stripe.
+   *
+   * \throws std::runtime_error if the bag directory or the directory of a stripe exists.
+   */
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const ConverterOptions & converter_options) override;
+
+  /// Close the writers of all stripes and write the merged metadata of the bag.
+  void close() override;
+
+  void create_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata & topic_with_type,
+    const rosbag2_storage::MessageDefinition & message_definition) override;
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override;
+
+  void prefetch_message_definitions(
+    const std::vector<rosbag2_storage::TopicMetadata> & topics) override;
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
+
+  /// Take a snapshot on all stripes. \returns true if all stripes took their snapshot.
+  bool take_snapshot() override;
+
+  /// Split the bag files of all stripes.
+  void split_bagfile() override;
+
+  void add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks) override;
+
+  void set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics) override;
+
+  /// Path of the bag directory of a stripe, for a bag written to storage_uri.
+  static std::string get_stripe_uri(
+    const std::string & stripe_directory, const std::string & storage_uri, size_t stripe_index);
+
+private:
+  size_t assign_stripe(const rosbag2_storage::SerializedBagMessage & message);
+  void write_metadata();
+
+  const std::vector<std::string> stripe_directories_;
+  StripeWriterFactory stripe_writer_factory_;
+  const StripeBy stripe_by_;
+  const size_t batch_bytes_;
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io_;
+  std::shared_ptr<PipelineStatistics> pipeline_statistics_;
+
+  std::string base_folder_;
+  std::vector<std::string> stripe_uris_;
+  std::vector<std::unique_ptr<writer_interfaces::BaseWriterInterface>> stripes_;
+  size_t batch_stripe_ = 0;
+  size_t bytes_in_batch_ = 0;
+};
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_CPP__WRITERS__STRIPED_WRITER_HPP_
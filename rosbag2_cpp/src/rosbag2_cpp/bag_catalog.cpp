@@ -0,0 +1,361 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/bag_catalog.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/yaml.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+namespace fs = std::filesystem;
+
+// Absolute path without a trailing separator, so that every bag has a single uri
+std::string normalize_uri(const std::string & uri)
+{
+  auto path = fs::absolute(uri).lexically_normal();
+  if (!path.has_filename() && path.has_parent_path()) {
+    path = path.parent_path();
+  }
+  return path.string();
+}
+
+bool is_bag_directory(const fs::path & path)
+{
+  std::error_code error;
+  return fs::exists(path / rosbag2_storage::MetadataIo::metadata_filename, error) ||
+    fs::exists(path / rosbag2_storage::MetadataIo::metadata_journal_filename, error);
+}
+
+// Bag directories below root, without looking into the bag directories
+void find_bag_directories(const std::string & root, std::vector<std::string> & bag_uris)
+{
+  std::error_code error;
+  if (!fs::is_directory(root, error)) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Catalog root " << root << " is not a directory.");
+    return;
+  }
+  if (is_bag_directory(root)) {
+    bag_uris.push_back(normalize_uri(root));
+    return;
+  }
+  fs::recursive_directory_iterator it(
+    root, fs::directory_options::skip_permission_denied, error);
+  for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+    if (it->is_directory(error) && is_bag_directory(it->path())) {
+      bag_uris.push_back(normalize_uri(it->path().string()));
+      it.disable_recursion_pending();
+    }
+  }
+  if (error) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Could not scan catalog root " << root << " completely: " << error.message());
+  }
+}
+
+// Newest modification time and total size of the files a bag summary is read from
+std::pair<int64_t, uint64_t> metadata_files_state(const std::string & uri)
+{
+  const std::vector<std::string> file_names = {
+    rosbag2_storage::MetadataIo::metadata_filename,
+    rosbag2_storage::MetadataIo::metadata_journal_filename,
+    rosbag2_storage::MetadataIo::topic_statistics_filename};
+  int64_t write_time = 0;
+  uint64_t bytes = 0;
+  for (const auto & file_name : file_names) {
+    const auto path = fs::path(uri) / file_name;
+    std::error_code error;
+    const auto file_write_time = fs::last_write_time(path, error);
+    if (error) {
+      continue;
+    }
+    write_time = std::max<int64_t>(
+      write_time,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        file_write_time.time_since_epoch()).count());
+    bytes += fs::file_size(path, error);
+  }
+  return {write_time, bytes};
+}
+
+uint64_t directory_size(const std::string & uri)
+{
+  uint64_t size = 0;
+  std::error_code error;
+  for (const auto & entry : fs::recursive_directory_iterator(uri, error)) {
+    if (entry.is_regular_file(error)) {
+      size += entry.file_size(error);
+    }
+  }
+  return size;
+}
+
+// Summary of a closed bag from its metadata, or of a bag being recorded from its journal
+BagCatalog::BagSummary summarize_bag(const std::string & uri)
+{
+  rosbag2_storage::MetadataIo metadata_io;
+  BagCatalog::BagSummary summary;
+  summary.uri = uri;
+  std::vector<rosbag2_storage::BagMetadata> parts;
+  if (metadata_io.metadata_file_exists(uri)) {
+    parts.push_back(metadata_io.read_metadata(uri));
+    summary.closed = true;
+    summary.bag_size = parts.back().bag_size;
+  } else {
+    parts = metadata_io.read_metadata_journal(uri);
+    summary.bag_size = directory_size(uri);
+  }
+
+  std::unordered_map<std::string, size_t> topic_indexes;
+  auto start_time = std::numeric_limits<rcutils_time_point_value_t>::max();
+  auto end_time = std::numeric_limits<rcutils_time_point_value_t>::min();
+  for (const auto & part : parts) {
+    if (summary.storage_identifier.empty()) {
+      summary.storage_identifier = part.storage_identifier;
+    }
+    summary.message_count += part.message_count;
+    summary.file_count += part.relative_file_paths.size();
+    if (part.message_count > 0) {
+      const auto part_start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        part.starting_time.time_since_epoch()).count();
+      start_time = std::min(start_time, part_start);
+      end_time = std::max(end_time, part_start + part.duration.count());
+    }
+    for (const auto & topic_information : part.topics_with_message_count) {
+      const auto & topic = topic_information.topic_metadata;
+      const auto topic_index = topic_indexes.emplace(topic.name, summary.topics.size());
+      if (topic_index.second) {
+        summary.topics.push_back({topic.name, topic.type, 0, 0});
+      }
+      summary.topics[topic_index.first->second].message_count +=
+        topic_information.message_count;
+    }
+  }
+  if (summary.message_count > 0) {
+    summary.start_time_ns = start_time;
+    summary.end_time_ns = end_time;
+  }
+
+  if (summary.closed) {
+    // The statistics are optional, a bag without them is summarized from its metadata
+    try {
+      for (const auto & statistics : metadata_io.read_topic_statistics(uri)) {
+        const auto topic_index = topic_indexes.find(statistics.topic_name);
+        if (topic_index != topic_indexes.end()) {
+          summary.topics[topic_index->second].total_bytes = statistics.total_bytes;
+        }
+      }
+    } catch (const std::exception & e) {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Could not read the topic statistics of bag " << uri << ": " << e.what());
+    }
+  }
+  return summary;
+}
+
+bool has_topic(const BagCatalog::BagSummary & bag, const std::string & topic_name)
+{
+  return std::any_of(
+    bag.topics.begin(), bag.topics.end(), [&topic_name](const auto & topic) {
+      return topic.name == topic_name && topic.message_count > 0;
+    });
+}
+}  // namespace
+
+BagCatalog::BagCatalog(std::string catalog_file)
+: catalog_file_(std::move(catalog_file))
+{
+  if (catalog_file_.empty() || !fs::exists(catalog_file_)) {
+    return;
+  }
+  try {
+    const YAML::Node catalog = YAML::LoadFile(catalog_file_);
+    for (const auto & bag_node : catalog["bags"]) {
+      BagSummary bag;
+      bag.uri = bag_node["uri"].as<std::string>();
+      bag.storage_identifier = bag_node["storage_identifier"].as<std::string>();
+      bag.start_time_ns = bag_node["start_time_ns"].as<rcutils_time_point_value_t>();
+      bag.end_time_ns = bag_node["end_time_ns"].as<rcutils_time_point_value_t>();
+      bag.message_count = bag_node["message_count"].as<size_t>();
+      bag.file_count = bag_node["file_count"].as<size_t>();
+      bag.bag_size = bag_node["bag_size"].as<uint64_t>();
+      bag.closed = bag_node["closed"].as<bool>();
+      bag.metadata_write_time = bag_node["metadata_write_time"].as<int64_t>();
+      bag.metadata_bytes = bag_node["metadata_bytes"].as<uint64_t>();
+      for (const auto & topic_node : bag_node["topics"]) {
+        TopicSummary topic;
+        topic.name = topic_node["name"].as<std::string>();
+        topic.type = topic_node["type"].as<std::string>();
+        topic.message_count = topic_node["message_count"].as<size_t>();
+        topic.total_bytes = topic_node["total_bytes"].as<uint64_t>();
+        bag.topics.push_back(std::move(topic));
+      }
+      bags_.emplace(bag.uri, std::move(bag));
+    }
+  } catch (const YAML::Exception & e) {
+    throw std::runtime_error(
+            "Exception on parsing catalog file " + catalog_file_ + ": " + e.what());
+  }
+}
+
+size_t BagCatalog::update(const std::vector<std::string> & root_directories)
+{
+  std::vector<std::string> bag_uris;
+  for (const auto & root : root_directories) {
+    find_bag_directories(root, bag_uris);
+  }
+
+  // The bags are read without holding the lock, so that queries are answered meanwhile
+  std::map<std::string, BagSummary> bags;
+  size_t read_bags = 0;
+  for (const auto & uri : bag_uris) {
+    const auto [write_time, bytes] = metadata_files_state(uri);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto known_bag = bags_.find(uri);
+      if (known_bag != bags_.end() && known_bag->second.metadata_write_time == write_time &&
+        known_bag->second.metadata_bytes == bytes)
+      {
+        bags.emplace(uri, known_bag->second);
+        continue;
+      }
+    }
+    try {
+      auto summary = summarize_bag(uri);
+      summary.metadata_write_time = write_time;
+      summary.metadata_bytes = bytes;
+      bags.emplace(uri, std::move(summary));
+      ++read_bags;
+    } catch (const std::exception & e) {
+      ROSBAG2_CPP_LOG_WARN_STREAM("Could not add bag " << uri << " to the catalog: " << e.what());
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bags_ = std::move(bags);
+  }
+  if (!catalog_file_.empty()) {
+    save();
+  }
+  return read_bags;
+}
+
+std::vector<BagCatalog::BagSummary> BagCatalog::find(const Query & query) const
+{
+  std::vector<BagSummary> found;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & [uri, bag] : bags_) {
+      if (bag.bag_size < query.min_bag_size || bag.bag_size > query.max_bag_size) {
+        continue;
+      }
+      if (!query.topic_name.empty() && !has_topic(bag, query.topic_name)) {
+        continue;
+      }
+      if ((query.start_time_ns >= 0 || query.end_time_ns >= 0) &&
+        (bag.message_count == 0 ||
+        (query.start_time_ns >= 0 && bag.end_time_ns < query.start_time_ns) ||
+        (query.end_time_ns >= 0 && bag.start_time_ns > query.end_time_ns)))
+      {
+        continue;
+      }
+      found.push_back(bag);
+    }
+  }
+  std::stable_sort(
+    found.begin(), found.end(), [](const BagSummary & a, const BagSummary & b) {
+      return a.start_time_ns < b.start_time_ns;
+    });
+  return found;
+}
+
+std::optional<BagCatalog::BagSummary> BagCatalog::lookup(const std::string & uri) const
+{
+  const auto normalized_uri = normalize_uri(uri);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto bag = bags_.find(normalized_uri);
+  if (bag == bags_.end()) {
+    return std::nullopt;
+  }
+  return bag->second;
+}
+
+void BagCatalog::save() const
+{
+  if (catalog_file_.empty()) {
+    throw std::runtime_error("The catalog has no catalog file to save to.");
+  }
+  YAML::Node catalog;
+  catalog["bags"] = YAML::Node(YAML::NodeType::Sequence);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & [uri, bag] : bags_) {
+      YAML::Node bag_node;
+      bag_node["uri"] = bag.uri;
+      bag_node["storage_identifier"] = bag.storage_identifier;
+      bag_node["start_time_ns"] = bag.start_time_ns;
+      bag_node["end_time_ns"] = bag.end_time_ns;
+      bag_node["message_count"] = bag.message_count;
+      bag_node["file_count"] = bag.file_count;
+      bag_node["bag_size"] = bag.bag_size;
+      bag_node["closed"] = bag.closed;
+      bag_node["metadata_write_time"] = bag.metadata_write_time;
+      bag_node["metadata_bytes"] = bag.metadata_bytes;
+      bag_node["topics"] = YAML::Node(YAML::NodeType::Sequence);
+      for (const auto & topic : bag.topics) {
+        YAML::Node topic_node;
+        topic_node["name"] = topic.name;
+        topic_node["type"] = topic.type;
+        topic_node["message_count"] = topic.message_count;
+        topic_node["total_bytes"] = topic.total_bytes;
+        bag_node["topics"].push_back(topic_node);
+      }
+      catalog["bags"].push_back(bag_node);
+    }
+  }
+
+  // Readers of the catalog file never see a partially written one
+  const std::string temporary_file = catalog_file_ + ".tmp";
+  {
+    std::ofstream fout(temporary_file, std::ios::trunc);
+    fout << catalog;
+    if (!fout) {
+      throw std::runtime_error("Failed to write catalog file " + temporary_file);
+    }
+  }
+  fs::rename(temporary_file, catalog_file_);
+}
+
+}  // namespace rosbag2_cpp
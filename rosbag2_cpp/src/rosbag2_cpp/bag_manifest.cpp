@@ -0,0 +1,184 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/bag_manifest.hpp"
+
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+namespace rosbag2_cpp
+{
+
+BagManifest::BagManifest(
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: storage_factory_(std::move(storage_factory)),
+  metadata_io_(std::move(metadata_io))
+{}
+
+rosbag2_storage::BagMetadata BagManifest::create(
+  const std::string & manifest_uri, const std::vector<Entry> & entries)
+{
+  rosbag2_storage::BagMetadata manifest;
+  manifest.message_count = 0;
+  std::unordered_map<std::string, size_t> topic_indexes;
+  auto add_topic = [&manifest, &topic_indexes](
+    const rosbag2_storage::TopicMetadata & topic_metadata, size_t message_count) {
+      auto topic_index = topic_indexes.emplace(
+        topic_metadata.name, manifest.topics_with_message_count.size());
+      if (topic_index.second) {
+        manifest.topics_with_message_count.push_back({topic_metadata, 0});
+      }
+      manifest.topics_with_message_count[topic_index.first->second].message_count +=
+        message_count;
+    };
+  auto start_time = std::numeric_limits<rcutils_time_point_value_t>::max();
+  auto end_time = std::numeric_limits<rcutils_time_point_value_t>::min();
+  const auto manifest_path = std::filesystem::absolute(manifest_uri);
+
+  for (size_t entry_index = 0; entry_index < entries.size(); ++entry_index) {
+    const auto & entry = entries[entry_index];
+    if (!metadata_io_->metadata_file_exists(entry.bag_uri)) {
+      throw std::runtime_error("No metadata found in " + entry.bag_uri);
+    }
+    const auto metadata = metadata_io_->read_metadata(entry.bag_uri);
+    if (metadata.compression_mode == "FILE") {
+      throw std::runtime_error(
+              "The files of " + entry.bag_uri + " are compressed, a manifest can only reference "
+              "uncompressed files.");
+    }
+    // Readers open all files of a bag with the same storage plugin and decompressor
+    if (entry_index == 0) {
+      manifest.storage_identifier = metadata.storage_identifier;
+      manifest.compression_format = metadata.compression_format;
+      manifest.compression_mode = metadata.compression_mode;
+      manifest.ros_distro = metadata.ros_distro;
+    } else if (metadata.storage_identifier != manifest.storage_identifier ||
+      metadata.compression_format != manifest.compression_format ||
+      metadata.compression_mode != manifest.compression_mode)
+    {
+      throw std::runtime_error(
+              entry.bag_uri + " differs from the other bags of the manifest in storage or "
+              "compression.");
+    }
+    manifest.custom_data.insert(metadata.custom_data.begin(), metadata.custom_data.end());
+
+    // Bags before version 4 list their files relative to the parent of the bag directory
+    auto base_path = std::filesystem::absolute(entry.bag_uri);
+    if (metadata.version < 4) {
+      base_path = base_path.parent_path();
+    }
+    const bool windowed = entry.start_time_ns >= 0 || entry.end_time_ns >= 0;
+    for (size_t i = 0; i < metadata.relative_file_paths.size(); ++i) {
+      const auto file_path = (base_path / metadata.relative_file_paths[i]).lexically_normal();
+      std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage;
+      auto open_storage = [&]() {
+          if (!storage) {
+            rosbag2_storage::StorageOptions storage_options;
+            storage_options.uri = file_path.string();
+            storage_options.storage_id = metadata.storage_identifier;
+            storage = storage_factory_->open_read_only(storage_options);
+            if (!storage) {
+              throw std::runtime_error("No storage could be initialized for " + file_path.string());
+            }
+          }
+          return storage;
+        };
+
+      rosbag2_storage::FileInformation file;
+      if (metadata.files.size() == metadata.relative_file_paths.size()) {
+        file = metadata.files[i];
+      } else {
+        const auto file_metadata = open_storage()->get_metadata();
+        file.starting_time = file_metadata.starting_time;
+        file.duration = file_metadata.duration;
+        file.message_count = file_metadata.message_count;
+      }
+      auto file_start_time = file.starting_time.time_since_epoch().count();
+      auto file_end_time = file_start_time + file.duration.count();
+      if ((entry.end_time_ns >= 0 && file_start_time > entry.end_time_ns) ||
+        (entry.start_time_ns >= 0 && file_end_time < entry.start_time_ns))
+      {
+        continue;
+      }
+      // Referenced by absolute path if there is no relative one, e.g. on another drive
+      auto relative_path = std::filesystem::relative(file_path, manifest_path);
+      file.path = (relative_path.empty() ? file_path : relative_path).generic_string();
+
+      if (windowed) {
+        // Bags count their messages per topic only for all files, so count those in the window
+        rosbag2_storage::StorageFilter storage_filter;
+        storage_filter.start_time_ns = entry.start_time_ns;
+        storage_filter.end_time_ns = entry.end_time_ns;
+        file.message_count = 0;
+        for (const auto & topic : metadata.topics_with_message_count) {
+          storage_filter.topics = {topic.topic_metadata.name};
+          const auto message_count = open_storage()->estimate(storage_filter).message_count;
+          add_topic(topic.topic_metadata, message_count);
+          file.message_count += message_count;
+        }
+        if (entry.start_time_ns > file_start_time) {
+          file.window_start_time_ns = entry.start_time_ns;
+          file_start_time = entry.start_time_ns;
+        }
+        if (entry.end_time_ns >= 0 && entry.end_time_ns < file_end_time) {
+          file.window_end_time_ns = entry.end_time_ns;
+          file_end_time = entry.end_time_ns;
+        }
+      }
+      start_time = std::min(start_time, file_start_time);
+      end_time = std::max(end_time, file_end_time);
+      manifest.message_count += file.message_count;
+      manifest.relative_file_paths.push_back(file.path);
+      manifest.files.push_back(std::move(file));
+    }
+    if (!windowed) {
+      for (const auto & topic : metadata.topics_with_message_count) {
+        add_topic(topic.topic_metadata, topic.message_count);
+      }
+    }
+  }
+
+  if (manifest.files.empty()) {
+    manifest.starting_time = {};
+    manifest.duration = std::chrono::nanoseconds(0);
+  } else {
+    manifest.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+      std::chrono::nanoseconds(start_time));
+    manifest.duration = std::chrono::nanoseconds(end_time - start_time);
+  }
+  return manifest;
+}
+
+void BagManifest::write(const std::string & manifest_uri, const std::vector<Entry> & entries)
+{
+  const auto manifest = create(manifest_uri, entries);
+  std::filesystem::create_directories(manifest_uri);
+  metadata_io_->write_metadata(manifest_uri, manifest);
+}
+
+}  // namespace rosbag2_cpp
@@ -0,0 +1,220 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/bag_preview.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+// Start of the bucket of a time stamp, also for time stamps before the epoch
+rcutils_time_point_value_t bucket_start(
+  rcutils_time_point_value_t time_stamp, rcutils_duration_value_t bucket_duration)
+{
+  return time_stamp - (time_stamp % bucket_duration + bucket_duration) % bucket_duration;
+}
+}  // namespace
+
+BagPreview::BagPreview(
+  rcutils_duration_value_t bucket_duration,
+  const std::vector<std::string> & sample_topics,
+  uint64_t sample_interval)
+: bucket_duration_(bucket_duration),
+  sample_topics_(sample_topics.begin(), sample_topics.end()),
+  sample_interval_(sample_interval)
+{
+  if (bucket_duration_ <= 0) {
+    throw std::invalid_argument("The bucket duration of a bag preview has to be positive");
+  }
+  if (sample_interval_ == 0) {
+    throw std::invalid_argument("The sample interval of a bag preview has to be positive");
+  }
+}
+
+void BagPreview::add_message(const rosbag2_storage::SerializedBagMessage & message)
+{
+  auto & topic = topics_[message.topic_name];
+  const uint64_t size = message.serialized_data ? message.serialized_data->buffer_length : 0u;
+  auto & bucket = topic.buckets[bucket_start(message.time_stamp, bucket_duration_)];
+  ++bucket.message_count;
+  bucket.size += size;
+
+  if (topic.message_count++ % sample_interval_ == 0 &&
+    sample_topics_.count(message.topic_name) > 0)
+  {
+    Sample sample;
+    sample.time_stamp = message.time_stamp;
+    if (message.serialized_data) {
+      const auto * data = message.serialized_data->buffer;
+      sample.serialized_data.assign(data, data + size);
+    }
+    topic.samples.push_back(std::move(sample));
+  }
+}
+
+rcutils_duration_value_t BagPreview::bucket_duration() const
+{
+  return bucket_duration_;
+}
+
+const std::map<std::string, BagPreview::Topic> & BagPreview::topics() const
+{
+  return topics_;
+}
+
+std::map<rcutils_time_point_value_t, BagPreview::Bucket> BagPreview::get_buckets(
+  const std::string & topic_name, rcutils_duration_value_t duration) const
+{
+  std::map<rcutils_time_point_value_t, Bucket> merged;
+  auto topic = topics_.find(topic_name);
+  if (topic == topics_.end()) {
+    return merged;
+  }
+  const auto factor = duration > bucket_duration_ ?
+    (duration + bucket_duration_ - 1) / bucket_duration_ : 1;
+  const auto merged_duration = factor * bucket_duration_;
+  for (const auto & [start, bucket] : topic->second.buckets) {
+    auto & merged_bucket = merged[bucket_start(start, merged_duration)];
+    merged_bucket.message_count += bucket.message_count;
+    merged_bucket.size += bucket.size;
+  }
+  return merged;
+}
+
+bool BagPreview::exists(const std::string & bag_directory)
+{
+  std::error_code error;
+  return std::filesystem::is_regular_file(
+    std::filesystem::path(bag_directory) / kFileName, error);
+}
+
+void BagPreview::write(const std::string & bag_directory) const
+{
+  // Written to a file of its own first, so that readers never read it incomplete
+  const auto path = (std::filesystem::path(bag_directory) / kFileName).string();
+  const std::string temporary_path = path + "." + std::to_string(
+    std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+  std::error_code error;
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    file << serialize();
+    if (!file.good()) {
+      file.close();
+      std::filesystem::remove(temporary_path, error);
+      throw std::runtime_error("Failed to write bag preview " + path);
+    }
+  }
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    throw std::runtime_error("Failed to write bag preview " + path);
+  }
+}
+
+BagPreview BagPreview::read(const std::string & bag_directory)
+{
+  const auto path = (std::filesystem::path(bag_directory) / kFileName).string();
+  std::ifstream file{path, std::ios::binary};
+  if (!file.good()) {
+    throw std::runtime_error("No bag preview " + path);
+  }
+  return deserialize(std::string(std::istreambuf_iterator<char>(file), {}));
+}
+
+std::string BagPreview::serialize() const
+{
+  // Text, except for the samples, which are stored as their length followed by their bytes
+  std::stringstream out;
+  out << "bucket_duration " << bucket_duration_ << "\n";
+  for (const auto & [topic_name, topic] : topics_) {
+    out << "topic " << topic_name << " " << topic.message_count << " " <<
+      topic.buckets.size() << " " << topic.samples.size() << "\n";
+    for (const auto & [start, bucket] : topic.buckets) {
+      out << start << " " << bucket.message_count << " " << bucket.size << "\n";
+    }
+    for (const auto & sample : topic.samples) {
+      out << sample.time_stamp << " " << sample.serialized_data.size() << "\n";
+      out.write(
+        reinterpret_cast<const char *>(sample.serialized_data.data()),
+        static_cast<std::streamsize>(sample.serialized_data.size()));
+      out << "\n";
+    }
+  }
+  return out.str();
+}
+
+BagPreview BagPreview::deserialize(const std::string & serialized_preview)
+{
+  std::istringstream in(serialized_preview);
+  std::string keyword;
+  rcutils_duration_value_t bucket_duration = 0;
+  if (!(in >> keyword >> bucket_duration) || keyword != "bucket_duration" ||
+    bucket_duration <= 0)
+  {
+    throw std::runtime_error("Malformed bag preview");
+  }
+  BagPreview preview(bucket_duration);
+  while (in >> keyword) {
+    std::string topic_name;
+    Topic topic;
+    size_t bucket_count = 0;
+    size_t sample_count = 0;
+    if (keyword != "topic" ||
+      !(in >> topic_name >> topic.message_count >> bucket_count >> sample_count))
+    {
+      throw std::runtime_error("Malformed bag preview");
+    }
+    for (size_t i = 0; i < bucket_count; ++i) {
+      rcutils_time_point_value_t start = 0;
+      Bucket bucket;
+      if (!(in >> start >> bucket.message_count >> bucket.size)) {
+        throw std::runtime_error("Malformed bag preview");
+      }
+      topic.buckets[start] = bucket;
+    }
+    for (size_t i = 0; i < sample_count; ++i) {
+      Sample sample;
+      size_t size = 0;
+      if (!(in >> sample.time_stamp >> size) || in.get() != '\n') {
+        throw std::runtime_error("Malformed bag preview");
+      }
+      sample.serialized_data.resize(size);
+      if (!in.read(
+          reinterpret_cast<char *>(sample.serialized_data.data()),
+          static_cast<std::streamsize>(size)))
+      {
+        throw std::runtime_error("Malformed bag preview");
+      }
+      topic.samples.push_back(std::move(sample));
+    }
+    preview.topics_[topic_name] = std::move(topic);
+  }
+  return preview;
+}
+
+}  // namespace rosbag2_cpp
@@ -12,10 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "rosbag2_cpp/cache/cache_consumer.hpp"
 #include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_cpp/tracing.hpp"
 
 namespace rosbag2_cpp
 {
@@ -25,10 +31,28 @@ namespace cache
 CacheConsumer::CacheConsumer(
   std::shared_ptr<MessageCacheInterface> message_cache,
   consume_callback_function_t consume_callback)
+: CacheConsumer(message_cache, consume_callback, WriteBatchingOptions{})
+{
+}
+
+CacheConsumer::CacheConsumer(
+  std::shared_ptr<MessageCacheInterface> message_cache,
+  consume_callback_function_t consume_callback,
+  const WriteBatchingOptions & batching_options,
+  const ThreadScheduling & thread_scheduling,
+  periodic_callback_function_t periodic_callback,
+  std::chrono::milliseconds periodic_interval)
 : message_cache_(message_cache),
-  consume_callback_(consume_callback)
+  consume_callback_(consume_callback),
+  batching_options_(batching_options),
+  thread_scheduling_(thread_scheduling),
+  periodic_callback_(std::move(periodic_callback)),
+  periodic_interval_(periodic_interval)
 {
-  consumer_thread_ = std::thread(&CacheConsumer::exec_consuming, this);
+  if (batching_options_.is_enabled()) {
+    target_batch_bytes_ = std::max<size_t>(batching_options_.min_batch_bytes, 1u);
+  }
+  start_consumer_thread();
 }
 
 CacheConsumer::~CacheConsumer()
@@ -54,27 +78,160 @@ void CacheConsumer::start()
 {
   is_stop_issued_ = false;
   if (!consumer_thread_.joinable()) {
-    consumer_thread_ = std::thread(&CacheConsumer::exec_consuming, this);
+    start_consumer_thread();
   }
 }
 
+void CacheConsumer::start_consumer_thread()
+{
+  consumer_thread_ = std::thread(
+    [this]() {
+      apply_thread_scheduling("cache consumer", thread_scheduling_);
+      if (batching_options_.is_enabled()) {
+        exec_consuming_batched();
+      } else {
+        exec_consuming();
+      }
+    });
+}
+
+size_t CacheConsumer::get_target_batch_bytes() const
+{
+  return target_batch_bytes_;
+}
+
 void CacheConsumer::exec_consuming()
 {
   bool exit_flag = false;
   bool flushing = false;
   while (!exit_flag) {
-    message_cache_->wait_for_data();
+    wait_for_data_until(std::chrono::steady_clock::time_point::max());
     message_cache_->swap_buffers();
     // Get the current consumer buffer.
     auto consumer_buffer = message_cache_->get_consumer_buffer();
+    ROSBAG2_CPP_TRACEPOINT(cache_swap_buffers, consumer_buffer->size());
     consume_callback_(consumer_buffer->data());
     consumer_buffer->clear();
     message_cache_->release_consumer_buffer();
+    if (periodic_callback_) {
+      periodic_callback_();
+    }
 
-    if (flushing) {exit_flag = true;}  // this was the final run
+    // this was the final run, unless the cache still holds messages outside of its buffers
+    if (flushing && !message_cache_->has_pending_data()) {exit_flag = true;}
     if (is_stop_issued_) {flushing = true;}  // run one final time to flush
   }
 }
 
+void CacheConsumer::exec_consuming_batched()
+{
+  bool exit_flag = false;
+  bool flushing = false;
+  auto batch_deadline = std::chrono::steady_clock::time_point::max();
+  while (!exit_flag) {
+    wait_for_data_until(
+      pending_batch_.empty() ? std::chrono::steady_clock::time_point::max() : batch_deadline);
+    message_cache_->swap_buffers();
+    // Collect the current consumer buffer into the pending batch.
+    auto consumer_buffer = message_cache_->get_consumer_buffer();
+    ROSBAG2_CPP_TRACEPOINT(cache_swap_buffers, consumer_buffer->size());
+    const auto & data = consumer_buffer->data();
+    if (pending_batch_.empty() && !data.empty()) {
+      batch_deadline = std::chrono::steady_clock::now() + batching_options_.max_batch_latency;
+    }
+    for (const auto & msg : data) {
+      pending_batch_bytes_ += msg->serialized_data ? msg->serialized_data->buffer_length : 0u;
+      pending_batch_.push_back(msg);
+    }
+    consumer_buffer->clear();
+    message_cache_->release_consumer_buffer();
+
+    if (!pending_batch_.empty() &&
+      (flushing || pending_batch_bytes_ >= target_batch_bytes_ ||
+      std::chrono::steady_clock::now() >= batch_deadline))
+    {
+      consume_pending_batch();
+    }
+    if (periodic_callback_) {
+      periodic_callback_();
+    }
+
+    // this was the final run, unless the cache still holds messages outside of its buffers
+    if (flushing && !message_cache_->has_pending_data()) {exit_flag = true;}
+    if (is_stop_issued_) {flushing = true;}  // run one final time to flush
+  }
+  if (!pending_batch_.empty()) {
+    consume_pending_batch();
+  }
+}
+
+void CacheConsumer::wait_for_data_until(std::chrono::steady_clock::time_point deadline)
+{
+  if (periodic_callback_) {
+    deadline = std::min(deadline, std::chrono::steady_clock::now() + periodic_interval_);
+  }
+  if (deadline == std::chrono::steady_clock::time_point::max()) {
+    message_cache_->wait_for_data();
+  } else {
+    message_cache_->wait_for_data_until(deadline);
+  }
+}
+
+void CacheConsumer::consume_pending_batch()
+{
+  const auto start = std::chrono::steady_clock::now();
+  const size_t max_batch_bytes = batching_options_.max_batch_bytes > 0 ?
+    batching_options_.max_batch_bytes : std::numeric_limits<size_t>::max();
+  if (pending_batch_bytes_ <= max_batch_bytes) {
+    consume_callback_(pending_batch_);
+  } else {
+    std::vector<CacheBufferInterface::buffer_element_t> batch;
+    size_t batch_bytes = 0;
+    for (auto & msg : pending_batch_) {
+      const size_t msg_bytes = msg->serialized_data ? msg->serialized_data->buffer_length : 0u;
+      if (!batch.empty() && batch_bytes + msg_bytes > max_batch_bytes) {
+        consume_callback_(batch);
+        batch.clear();
+        batch_bytes = 0;
+      }
+      batch_bytes += msg_bytes;
+      batch.push_back(std::move(msg));
+    }
+    if (!batch.empty()) {
+      consume_callback_(batch);
+    }
+  }
+  update_target_batch_bytes(pending_batch_bytes_, std::chrono::steady_clock::now() - start);
+  pending_batch_.clear();
+  pending_batch_bytes_ = 0;
+}
+
+void CacheConsumer::update_target_batch_bytes(
+  size_t batch_bytes, std::chrono::nanoseconds duration)
+{
+  if (!batching_options_.adaptive || batch_bytes == 0 || duration.count() <= 0) {
+    return;
+  }
+  // Exponential moving average, a single slow write should not collapse the batch size
+  constexpr double kSmoothing = 0.2;
+  const double bytes_per_second =
+    static_cast<double>(batch_bytes) / std::chrono::duration<double>(duration).count();
+  consume_bytes_per_second_ = consume_bytes_per_second_ > 0.0 ?
+    (1.0 - kSmoothing) * consume_bytes_per_second_ + kSmoothing * bytes_per_second :
+    bytes_per_second;
+
+  // Consuming one batch should take about half of the latency budget
+  const double target_seconds =
+    std::chrono::duration<double>(batching_options_.max_batch_latency).count() / 2.0;
+  const double max_batch_bytes = batching_options_.max_batch_bytes > 0 ?
+    static_cast<double>(batching_options_.max_batch_bytes) :
+    static_cast<double>(std::numeric_limits<size_t>::max() / 2);
+  const double min_batch_bytes =
+    static_cast<double>(std::max<size_t>(batching_options_.min_batch_bytes, 1u));
+  const double target = std::clamp(
+    consume_bytes_per_second_ * target_seconds, min_batch_bytes, max_batch_bytes);
+  target_batch_bytes_ = static_cast<size_t>(target);
+}
+
 }  // namespace cache
 }  // namespace rosbag2_cpp
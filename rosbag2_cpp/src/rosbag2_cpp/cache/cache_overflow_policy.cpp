@@ -0,0 +1,73 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "rosbag2_cpp/cache/cache_overflow_policy.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+namespace
+{
+
+constexpr const char kDropNewestStr[] = "drop_newest";
+constexpr const char kDropOldestStr[] = "drop_oldest";
+constexpr const char kBlockStr[] = "block";
+constexpr const char kSpillToDiskStr[] = "spill_to_disk";
+
+std::string to_lower(const std::string & text)
+{
+  std::string lowercase_text = text;
+  std::transform(lowercase_text.begin(), lowercase_text.end(), lowercase_text.begin(), ::tolower);
+  return lowercase_text;
+}
+}  // namespace
+
+CacheOverflowPolicy cache_overflow_policy_from_string(const std::string & policy)
+{
+  const auto policy_lower = to_lower(policy);
+  if (policy.empty() || policy_lower == kDropNewestStr) {
+    return CacheOverflowPolicy::DROP_NEWEST;
+  } else if (policy_lower == kDropOldestStr) {
+    return CacheOverflowPolicy::DROP_OLDEST;
+  } else if (policy_lower == kBlockStr) {
+    return CacheOverflowPolicy::BLOCK;
+  } else if (policy_lower == kSpillToDiskStr) {
+    return CacheOverflowPolicy::SPILL_TO_DISK;
+  }
+  throw std::invalid_argument("Cache overflow policy \"" + policy + "\" is not supported!");
+}
+
+std::string cache_overflow_policy_to_string(const CacheOverflowPolicy policy)
+{
+  switch (policy) {
+    case CacheOverflowPolicy::DROP_OLDEST:
+      return kDropOldestStr;
+    case CacheOverflowPolicy::BLOCK:
+      return kBlockStr;
+    case CacheOverflowPolicy::SPILL_TO_DISK:
+      return kSpillToDiskStr;
+    case CacheOverflowPolicy::DROP_NEWEST:
+    default:
+      return kDropNewestStr;
+  }
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
@@ -13,24 +13,158 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_cpp/cache/circular_message_cache.hpp"
-#include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
 #include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
 
 namespace rosbag2_cpp
 {
 namespace cache
 {
 
-CircularMessageCache::CircularMessageCache(size_t max_buffer_size)
+namespace
 {
-  producer_buffer_ = std::make_shared<MessageCacheCircularBuffer>(max_buffer_size);
-  consumer_buffer_ = std::make_shared<MessageCacheCircularBuffer>(max_buffer_size);
+// The ring is split into about this many segments, which bounds the memory kept for messages
+// which were dropped from a segment still referred to by the ring.
+constexpr size_t kSegmentsPerRing = 16;
+
+// Consumer buffer holding the messages of one snapshot
+class SnapshotBuffer : public CacheBufferInterface
+{
+public:
+  bool push(buffer_element_t msg) override
+  {
+    messages_.push_back(std::move(msg));
+    return true;
+  }
+
+  void clear() override
+  {
+    messages_.clear();
+  }
+
+  size_t size() override
+  {
+    return messages_.size();
+  }
+
+  const std::vector<buffer_element_t> & data() override
+  {
+    return messages_;
+  }
+
+private:
+  std::vector<buffer_element_t> messages_;
+};
+
+size_t message_size(const CacheBufferInterface::buffer_element_t & msg)
+{
+  return get_message_memory_bytes(*msg);
+}
+
+size_t payload_size(const rosbag2_storage::SerializedBagMessage & msg)
+{
+  return msg.serialized_data ? msg.serialized_data->buffer_length : 0u;
+}
+}  // namespace
+
+// Blocks of block_size bytes, which payload blocks return their bytes to once no segment or
+// snapshot message refers to them any more. The blocks of a full ring are allocated up front.
+struct CircularMessageCache::PayloadBlockPool
+{
+  PayloadBlockPool(size_t size, size_t count)
+  : block_size(size), max_blocks(count)
+  {
+    for (size_t i = 0; i < max_blocks; ++i) {
+      blocks.emplace_back(new uint8_t[block_size]);
+    }
+  }
+
+  std::unique_ptr<uint8_t[]> acquire()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!blocks.empty()) {
+        auto block = std::move(blocks.back());
+        blocks.pop_back();
+        return block;
+      }
+    }
+    // Snapshots which were not written yet hold on to blocks of the ring
+    return std::unique_ptr<uint8_t[]>(new uint8_t[block_size]);
+  }
+
+  void release(std::unique_ptr<uint8_t[]> block)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blocks.size() < max_blocks) {
+      blocks.push_back(std::move(block));
+    }
+  }
+
+  const size_t block_size;
+  const size_t max_blocks;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<uint8_t[]>> blocks;
+};
+
+struct CircularMessageCache::PayloadBlock
+{
+  ~PayloadBlock()
+  {
+    // Payloads larger than a block have a block of their own, which is not reused
+    if (pool && capacity == pool->block_size) {
+      pool->release(std::move(data));
+    }
+  }
+
+  std::unique_ptr<uint8_t[]> data;
+  size_t capacity = 0;
+  std::shared_ptr<PayloadBlockPool> pool;
+};
+
+size_t CircularMessageCache::Segment::size() const
+{
+  return block ? entries.size() : messages.size();
+}
+
+rcutils_time_point_value_t CircularMessageCache::Segment::time_stamp(size_t index) const
+{
+  return block ? entries[index].time_stamp : messages[index]->time_stamp;
+}
+
+size_t CircularMessageCache::Segment::message_bytes(size_t index) const
+{
+  return block ? entries[index].size + sizeof(MessageEntry) : message_size(messages[index]);
+}
+
+CircularMessageCache::CircularMessageCache(
+  size_t max_buffer_size,
+  std::chrono::nanoseconds max_duration,
+  std::chrono::nanoseconds post_trigger_duration,
+  bool contiguous_payloads)
+: max_bytes_size_(max_buffer_size),
+  max_duration_(max_duration),
+  post_trigger_duration_(post_trigger_duration),
+  max_segment_bytes_size_(std::max<size_t>(max_buffer_size / kSegmentsPerRing, 1u)),
+  contiguous_payloads_(contiguous_payloads),
+  topic_names_(std::make_shared<const std::vector<std::string>>()),
+  consumer_buffer_(std::make_shared<SnapshotBuffer>())
+{
+  if (contiguous_payloads_) {
+    // The kept payloads span at most one block more than fit into the ring, which is partially
+    // used at its start and its end
+    block_pool_ = std::make_shared<PayloadBlockPool>(
+      max_segment_bytes_size_, max_bytes_size_ / max_segment_bytes_size_ + 1u);
+  }
 }
 
 CircularMessageCache::~CircularMessageCache()
@@ -42,8 +176,140 @@ CircularMessageCache::~CircularMessageCache()
 
 void CircularMessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg)
 {
-  std::lock_guard<std::mutex> cache_lock(producer_buffer_mutex_);
-  producer_buffer_->push(msg);
+  const size_t msg_size = contiguous_payloads_ ?
+    payload_size(*msg) + sizeof(MessageEntry) : message_size(msg);
+  // Drop message if it exceeds the buffer size
+  if (msg_size > max_bytes_size_) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Last message exceeds snapshot buffer size. Dropping message!");
+    return;
+  }
+
+  std::unique_lock<std::mutex> cache_lock(producer_buffer_mutex_);
+  bool streamed = false;
+  if (streaming_) {
+    if (!stream_end_) {
+      stream_end_ = msg->time_stamp + post_trigger_duration_.count();
+    }
+    if (msg->time_stamp > *stream_end_) {
+      queue_streamed_messages();
+      streaming_ = false;
+    } else {
+      streamed_messages_.push_back(msg);
+      streamed = true;
+    }
+  }
+
+  // Remove any old messages until there is room for the new message
+  while (buffer_bytes_size_ > max_bytes_size_ - msg_size) {
+    drop_oldest();
+  }
+  if (contiguous_payloads_) {
+    push_contiguous(*msg, msg_size);
+  } else {
+    if (!last_segment_open_ || segments_.back().segment->bytes >= max_segment_bytes_size_) {
+      segments_.push_back({std::make_shared<Segment>(), 0u});
+      last_segment_open_ = true;
+    }
+    auto & segment = *segments_.back().segment;
+    segment.bytes += msg_size;
+    segment.messages.push_back(msg);
+  }
+  buffer_bytes_size_ += msg_size;
+
+  if (max_duration_.count() > 0) {
+    // Remove the messages which are older than max_duration_ before the new message
+    while (msg->time_stamp - segments_.front().segment->time_stamp(segments_.front().first) >
+      max_duration_.count())
+    {
+      drop_oldest();
+    }
+  }
+
+  if (streamed) {
+    cache_lock.unlock();
+    cache_condition_var_.notify_one();
+  }
+}
+
+void CircularMessageCache::push_contiguous(
+  const rosbag2_storage::SerializedBagMessage & msg, size_t msg_size)
+{
+  const size_t size = payload_size(msg);
+  if (!current_block_ || current_block_->capacity - current_block_used_ < size) {
+    auto block = std::make_shared<PayloadBlock>();
+    if (size <= block_pool_->block_size) {
+      block->data = block_pool_->acquire();
+      block->capacity = block_pool_->block_size;
+      block->pool = block_pool_;
+    } else {
+      block->data.reset(new uint8_t[size]);
+      block->capacity = size;
+    }
+    current_block_ = std::move(block);
+    current_block_used_ = 0;
+    last_segment_open_ = false;
+  }
+  if (!last_segment_open_) {
+    segments_.push_back({std::make_shared<Segment>(), 0u});
+    segments_.back().segment->block = current_block_;
+    last_segment_open_ = true;
+  }
+
+  MessageEntry entry;
+  entry.offset = current_block_used_;
+  entry.size = size;
+  entry.time_stamp = msg.time_stamp;
+  entry.send_timestamp = msg.send_timestamp;
+  entry.sequence_number = msg.sequence_number;
+  entry.topic_id = msg.topic_id;
+  entry.topic_index = get_topic_index(msg.topic_name);
+  if (size > 0) {
+    std::memcpy(current_block_->data.get() + entry.offset, msg.serialized_data->buffer, size);
+  }
+  current_block_used_ += size;
+  auto & segment = *segments_.back().segment;
+  segment.entries.push_back(entry);
+  segment.bytes += msg_size;
+}
+
+uint32_t CircularMessageCache::get_topic_index(const std::string & topic_name)
+{
+  const auto topic_index = topic_indices_.find(topic_name);
+  if (topic_index != topic_indices_.end()) {
+    return topic_index->second;
+  }
+  auto topic_names = std::make_shared<std::vector<std::string>>(*topic_names_);
+  topic_names->push_back(topic_name);
+  const auto index = static_cast<uint32_t>(topic_names->size() - 1u);
+  topic_names_ = std::move(topic_names);
+  topic_indices_.emplace(topic_name, index);
+  return index;
+}
+
+void CircularMessageCache::queue_streamed_messages()
+{
+  if (streamed_messages_.empty()) {
+    return;
+  }
+  Snapshot continuation;
+  continuation.streamed_messages = std::move(streamed_messages_);
+  continuation.continues_previous = stream_continues_snapshot_;
+  pending_snapshots_.push_back(std::move(continuation));
+  streamed_messages_.clear();
+  stream_continues_snapshot_ = true;
+}
+
+void CircularMessageCache::drop_oldest()
+{
+  auto & oldest = segments_.front();
+  buffer_bytes_size_ -= oldest.segment->message_bytes(oldest.first);
+  ++oldest.first;
+  if (oldest.first == oldest.segment->size()) {
+    if (segments_.size() == 1u) {
+      last_segment_open_ = false;
+    }
+    segments_.pop_front();
+  }
 }
 
 std::shared_ptr<CacheBufferInterface> CircularMessageCache::get_consumer_buffer()
@@ -75,11 +341,35 @@ void CircularMessageCache::notify_data_ready()
 {
   {
     std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
-    data_ready_ = true;
+    // Messages streamed so far belong to the previous snapshot
+    queue_streamed_messages();
+    streaming_ = post_trigger_duration_.count() > 0;
+    stream_end_.reset();
+    stream_continues_snapshot_ = false;
+    if (!segments_.empty()) {
+      // The segments are shared with the snapshot from now on, so that they must not change
+      last_segment_open_ = false;
+      Snapshot snapshot;
+      snapshot.segments.assign(segments_.begin(), segments_.end());
+      snapshot.topic_names = topic_names_;
+      pending_snapshots_.push_back(std::move(snapshot));
+      const auto & newest_segment = *segments_.back().segment;
+      stream_end_ = newest_segment.time_stamp(newest_segment.size() - 1u) +
+        post_trigger_duration_.count();
+      stream_continues_snapshot_ = true;
+    } else if (!streaming_) {
+      return;
+    }
   }
   cache_condition_var_.notify_one();
 }
 
+bool CircularMessageCache::has_pending_data()
+{
+  std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
+  return !pending_snapshots_.empty() || !streamed_messages_.empty();
+}
+
 void CircularMessageCache::wait_for_data()
 {
   std::unique_lock<std::mutex> producer_lock(producer_buffer_mutex_);
@@ -87,22 +377,60 @@ void CircularMessageCache::wait_for_data()
     // Required condition check to protect against spurious wakeups
     cache_condition_var_.wait(
       producer_lock, [this] {
-        return data_ready_ || flushing_;
+        return !pending_snapshots_.empty() || !streamed_messages_.empty() || flushing_;
       });
   }
 }
 
 void CircularMessageCache::swap_buffers()
 {
-  std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
-  // Swap buffers only if data is ready. Data not ready when we are calling flushing on exit and
-  // we should not dump buffer on exit if snapshot has not been triggered.
-  if (data_ready_) {
-    std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
-    consumer_buffer_->clear();
-    std::swap(producer_buffer_, consumer_buffer_);
-    data_ready_ = false;
+  // Take snapshots only if they were triggered. We should not dump the ring on exit if no
+  // snapshot has been triggered.
+  Snapshot snapshot;
+  {
+    std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+    // Streamed messages follow the queued snapshots
+    queue_streamed_messages();
+    if (!pending_snapshots_.empty()) {
+      snapshot = std::move(pending_snapshots_.front());
+      pending_snapshots_.pop_front();
+    }
   }
+  // The segments of the snapshot are no longer changed, so that they are read without blocking
+  // the producer
+  std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+  consumer_buffer_->clear();
+  for (const auto & view : snapshot.segments) {
+    const auto & segment = *view.segment;
+    if (!segment.block) {
+      for (size_t i = view.first; i < segment.messages.size(); ++i) {
+        consumer_buffer_->push(segment.messages[i]);
+      }
+      continue;
+    }
+    // The messages refer to their payloads in the block, which they keep
+    for (size_t i = view.first; i < segment.entries.size(); ++i) {
+      const auto & entry = segment.entries[i];
+      auto msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      msg->serialized_data = rosbag2_storage::make_serialized_message_view(
+        segment.block->data.get() + entry.offset, entry.size, segment.block);
+      msg->time_stamp = entry.time_stamp;
+      msg->topic_name = (*snapshot.topic_names)[entry.topic_index];
+      msg->topic_id = entry.topic_id;
+      msg->send_timestamp = entry.send_timestamp;
+      msg->sequence_number = entry.sequence_number;
+      consumer_buffer_->push(std::move(msg));
+    }
+  }
+  for (auto & msg : snapshot.streamed_messages) {
+    consumer_buffer_->push(std::move(msg));
+  }
+  consumer_buffer_continues_snapshot_ = snapshot.continues_previous;
+}
+
+bool CircularMessageCache::consumer_buffer_continues_snapshot() const
+{
+  return consumer_buffer_continues_snapshot_;
 }
 
 }  // namespace cache
@@ -0,0 +1,276 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "rosbag2_cpp/cache/lock_free_message_cache.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+namespace
+{
+size_t round_up_to_power_of_two(size_t value)
+{
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace
+
+LockFreeMessageCache::LockFreeMessageCache(size_t max_buffer_size, size_t max_message_count)
+: max_bytes_size_(max_buffer_size),
+  mask_(round_up_to_power_of_two(max_message_count) - 1),
+  slots_(new Slot[mask_ + 1])
+{
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  consumer_buffer_ = std::make_shared<MessageCacheBuffer>(std::numeric_limits<size_t>::max());
+}
+
+LockFreeMessageCache::~LockFreeMessageCache()
+{
+  // Initiate flushing on destruction to unblock wait_for_data.
+  flushing_ = true;
+  cache_condition_var_.notify_one();
+  log_dropped();
+}
+
+bool LockFreeMessageCache::try_enqueue(
+  const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg)
+{
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot * slot = nullptr;
+  while (true) {
+    slot = &slots_[pos & mask_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The consumer did not release this slot yet, the ring is full
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->msg = msg;
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool LockFreeMessageCache::try_dequeue(
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg)
+{
+  const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  Slot & slot = slots_[pos & mask_];
+  if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+    return false;
+  }
+  msg = std::move(slot.msg);
+  slot.msg.reset();
+  slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+  dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool LockFreeMessageCache::has_published_data() const
+{
+  const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  return slots_[pos & mask_].sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+void LockFreeMessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg)
+{
+  const size_t msg_size = get_message_memory_bytes(*msg);
+  // Same semantics as MessageCacheBuffer: accept messages while the cache is below its limit,
+  // so it may exceed max_buffer_size by at most one message per producer thread.
+  const size_t bytes_before = buffer_bytes_size_.fetch_add(msg_size);
+  if (bytes_before >= max_bytes_size_) {
+    buffer_bytes_size_.fetch_sub(msg_size);
+    count_dropped(msg->topic_name);
+    return;
+  }
+
+  if (!try_enqueue(msg)) {
+    buffer_bytes_size_.fetch_sub(msg_size);
+    count_dropped(msg->topic_name);
+    return;
+  }
+
+  const size_t bytes = bytes_before + msg_size + consumer_buffer_->get_bytes_size();
+  size_t peak = peak_memory_bytes_.load(std::memory_order_relaxed);
+  while (bytes > peak && !peak_memory_bytes_.compare_exchange_weak(peak, bytes)) {}
+
+  // Pairs with the fence in wait_for_data(): either the consumer sees the published slot, or
+  // this thread sees that the consumer is sleeping and wakes it up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_waiting_.load(std::memory_order_relaxed)) {
+    notify_data_ready();
+  }
+}
+
+void LockFreeMessageCache::count_dropped(const std::string & topic_name)
+{
+  std::lock_guard<std::mutex> lock(dropped_mutex_);
+  messages_dropped_per_topic_[topic_name]++;
+  dropped_message_count_++;
+}
+
+uint64_t LockFreeMessageCache::get_dropped_message_count() const
+{
+  return dropped_message_count_;
+}
+
+std::shared_ptr<CacheBufferInterface> LockFreeMessageCache::get_consumer_buffer()
+{
+  consumer_buffer_mutex_.lock();
+  return consumer_buffer_;
+}
+
+void LockFreeMessageCache::release_consumer_buffer()
+{
+  consumer_buffer_mutex_.unlock();
+}
+
+void LockFreeMessageCache::notify_data_ready()
+{
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    data_ready_ = true;
+  }
+  cache_condition_var_.notify_one();
+}
+
+void LockFreeMessageCache::wait_for_data()
+{
+  std::unique_lock<std::mutex> lock(wait_mutex_);
+  if (!flushing_) {
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Required condition check to protect against spurious wakeups
+    cache_condition_var_.wait(
+      lock, [this] {
+        return data_ready_ || flushing_ || has_published_data();
+      });
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+    data_ready_ = false;
+  }
+}
+
+void LockFreeMessageCache::wait_for_data_until(std::chrono::steady_clock::time_point deadline)
+{
+  std::unique_lock<std::mutex> lock(wait_mutex_);
+  if (!flushing_) {
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cache_condition_var_.wait_until(
+      lock, deadline, [this] {
+        return data_ready_ || flushing_ || has_published_data();
+      });
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+    data_ready_ = false;
+  }
+}
+
+void LockFreeMessageCache::swap_buffers()
+{
+  std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg;
+  while (try_dequeue(msg)) {
+    buffer_bytes_size_.fetch_sub(get_message_memory_bytes(*msg));
+    consumer_buffer_->push(std::move(msg));
+  }
+}
+
+void LockFreeMessageCache::begin_flushing()
+{
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    flushing_ = true;
+  }
+  cache_condition_var_.notify_one();
+}
+
+void LockFreeMessageCache::done_flushing()
+{
+  flushing_ = false;
+}
+
+size_t LockFreeMessageCache::size() const
+{
+  return enqueue_pos_.load(std::memory_order_acquire) -
+         dequeue_pos_.load(std::memory_order_acquire);
+}
+
+size_t LockFreeMessageCache::get_memory_bytes()
+{
+  return buffer_bytes_size_.load() + consumer_buffer_->get_bytes_size();
+}
+
+size_t LockFreeMessageCache::get_peak_memory_bytes()
+{
+  return peak_memory_bytes_;
+}
+
+void LockFreeMessageCache::log_dropped()
+{
+  uint64_t total_lost = 0;
+  std::string log_text("Cache buffers lost messages per topic: ");
+
+  std::map<std::string, uint32_t> messages_dropped_per_topic_sorted;
+  {
+    std::lock_guard<std::mutex> lock(dropped_mutex_);
+    messages_dropped_per_topic_sorted.insert(
+      messages_dropped_per_topic_.begin(), messages_dropped_per_topic_.end());
+  }
+
+  for (const auto & e : messages_dropped_per_topic_sorted) {
+    uint32_t lost = e.second;
+    if (lost > 0) {
+      log_text += "\n\t" + e.first + ": " + std::to_string(lost);
+      total_lost += lost;
+    }
+  }
+
+  if (total_lost > 0) {
+    log_text += "\nTotal lost: " + std::to_string(total_lost);
+    ROSBAG2_CPP_LOG_WARN_STREAM(log_text);
+  }
+
+  size_t remaining = size() + consumer_buffer_->size();
+  if (remaining > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Cache buffers were unflushed with " << remaining << " remaining messages"
+    );
+  }
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
@@ -13,8 +13,10 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -29,9 +31,49 @@ namespace cache
 {
 
 MessageCache::MessageCache(size_t max_buffer_size)
+: MessageCache(max_buffer_size, CacheOverflowPolicy::DROP_NEWEST)
 {
-  producer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
-  consumer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
+}
+
+MessageCache::MessageCache(
+  size_t max_buffer_size,
+  CacheOverflowPolicy overflow_policy,
+  std::chrono::milliseconds block_timeout,
+  std::shared_ptr<SpillFile> spill_file,
+  const std::unordered_map<std::string, uint32_t> & topic_priorities)
+: max_buffer_size_(max_buffer_size),
+  overflow_policy_(overflow_policy),
+  block_timeout_(block_timeout),
+  spill_file_(std::move(spill_file))
+{
+  if (overflow_policy_ == CacheOverflowPolicy::SPILL_TO_DISK && !spill_file_) {
+    throw std::invalid_argument("The spill_to_disk cache overflow policy requires a spill file");
+  }
+  if (!topic_priorities.empty() && overflow_policy_ != CacheOverflowPolicy::DROP_NEWEST) {
+    throw std::invalid_argument(
+            "Cache topic priorities are only supported by the drop_newest cache overflow policy");
+  }
+  // Called from push() with the producer buffer mutex held
+  auto on_dropped = [this](const CacheBufferInterface::buffer_element_t & msg) {
+      count_dropped(*msg);
+    };
+  if (!topic_priorities.empty()) {
+    priority_classes_ = std::make_shared<const CachePriorityClasses>(topic_priorities);
+    dropped_message_counts_per_class_ =
+      std::vector<std::atomic<uint64_t>>(priority_classes_->class_count());
+    producer_buffer_ = std::make_shared<MessageCachePriorityBuffer>(
+      max_buffer_size, priority_classes_, on_dropped);
+    consumer_buffer_ = std::make_shared<MessageCachePriorityBuffer>(
+      max_buffer_size, priority_classes_, on_dropped);
+  } else if (overflow_policy_ == CacheOverflowPolicy::DROP_OLDEST) {
+    producer_buffer_ =
+      std::make_shared<MessageCacheCircularBuffer>(max_buffer_size, on_dropped);
+    consumer_buffer_ =
+      std::make_shared<MessageCacheCircularBuffer>(max_buffer_size, on_dropped);
+  } else {
+    producer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
+    consumer_buffer_ = std::make_shared<MessageCacheBuffer>(max_buffer_size);
+  }
 }
 
 MessageCache::~MessageCache()
@@ -41,6 +83,7 @@ MessageCache::~MessageCache()
   // exceptional situations.
   flushing_ = true;
   cache_condition_var_.notify_one();
+  buffers_swapped_condition_var_.notify_all();
   log_dropped();
 }
 
@@ -49,15 +92,61 @@ void MessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMess
   // While pushing, we keep track of inserted and dropped messages as well
   bool pushed = false;
   {
-    std::lock_guard<std::mutex> lock(producer_buffer_mutex_);
-    pushed = producer_buffer_->push(msg);
+    std::unique_lock<std::mutex> lock(producer_buffer_mutex_);
+    if (spilling_) {
+      pushed = spill_file_->append(*msg);
+      spilled_message_count_ += pushed ? 1 : 0;
+    } else {
+      pushed = producer_buffer_->push(msg);
+      if (!pushed && overflow_policy_ == CacheOverflowPolicy::BLOCK) {
+        pushed = push_blocking(lock, msg);
+      } else if (!pushed && overflow_policy_ == CacheOverflowPolicy::SPILL_TO_DISK) {
+        pushed = spill_file_->append(*msg);
+        spilling_ = pushed;
+        spilled_message_count_ += pushed ? 1 : 0;
+      }
+    }
+    if (!pushed) {
+      count_dropped(*msg);
+    } else {
+      update_peak_memory_bytes();
+    }
   }
 
-  if (!pushed) {
-    messages_dropped_per_topic_[msg->topic_name]++;
+  notify_data_ready();
+}
+
+bool MessageCache::push_blocking(
+  std::unique_lock<std::mutex> & producer_lock,
+  const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + block_timeout_;
+  blocked_push_count_++;
+
+  // The consumer might be sleeping, make sure it comes to swap the full buffer
+  data_ready_ = true;
+  cache_condition_var_.notify_one();
+
+  bool pushed = false;
+  while (!pushed && !flushing_) {
+    const uint64_t swap_count = swap_count_;
+    auto buffers_swapped = [this, swap_count] {
+        return swap_count_ != swap_count || flushing_;
+      };
+    if (block_timeout_.count() > 0) {
+      if (!buffers_swapped_condition_var_.wait_until(producer_lock, deadline, buffers_swapped)) {
+        break;
+      }
+    } else {
+      buffers_swapped_condition_var_.wait(producer_lock, buffers_swapped);
+    }
+    pushed = producer_buffer_->push(msg);
   }
 
-  notify_data_ready();
+  time_blocked_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+  return pushed;
 }
 
 std::shared_ptr<CacheBufferInterface> MessageCache::get_consumer_buffer()
@@ -87,17 +176,90 @@ void MessageCache::wait_for_data()
     // Required condition check to protect against spurious wakeups
     cache_condition_var_.wait(
       producer_lock, [this] {
-        return data_ready_ || flushing_;
+        return data_ready_ || flushing_ || spilling_;
+      });
+    data_ready_ = false;
+  }
+}
+
+void MessageCache::wait_for_data_until(std::chrono::steady_clock::time_point deadline)
+{
+  std::unique_lock<std::mutex> producer_lock(producer_buffer_mutex_);
+  if (!flushing_) {
+    cache_condition_var_.wait_until(
+      producer_lock, deadline, [this] {
+        return data_ready_ || flushing_ || spilling_;
       });
     data_ready_ = false;
   }
 }
 
 void MessageCache::swap_buffers()
+{
+  bool read_spill_file = false;
+  {
+    std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+    // Spilled messages are newer than the frozen producer buffer, so they are consumed after it
+    read_spill_file = spilling_ && producer_buffer_->size() == 0;
+    if (!read_spill_file) {
+      std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+      std::swap(producer_buffer_, consumer_buffer_);
+      swap_count_++;
+    }
+  }
+  buffers_swapped_condition_var_.notify_all();
+  if (read_spill_file) {
+    read_spilled_messages();
+  }
+}
+
+void MessageCache::read_spilled_messages()
+{
+  {
+    std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+    spill_file_peak_bytes_ = std::max(spill_file_peak_bytes_, spill_file_->get_used_bytes());
+    // Reading happens without the producer lock, producers keep appending meanwhile
+    for (auto & msg : spill_file_->read(max_buffer_size_)) {
+      consumer_buffer_->push(std::move(msg));
+    }
+    // Buffers are only swapped with both mutexes held, producer_buffer_ is stable here
+    update_peak_memory_bytes();
+  }
+
+  std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+  if (spill_file_->empty()) {
+    // All spilled messages reached the consumer, producers go back to the producer buffer
+    spilling_ = false;
+  }
+}
+
+bool MessageCache::has_pending_data()
 {
   std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
-  std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
-  std::swap(producer_buffer_, consumer_buffer_);
+  return spilling_;
+}
+
+uint64_t MessageCache::get_spilled_message_count() const
+{
+  return spilled_message_count_;
+}
+
+void MessageCache::update_peak_memory_bytes()
+{
+  const size_t bytes = producer_buffer_->get_bytes_size() + consumer_buffer_->get_bytes_size();
+  size_t peak = peak_memory_bytes_.load();
+  while (bytes > peak && !peak_memory_bytes_.compare_exchange_weak(peak, bytes)) {}
+}
+
+size_t MessageCache::get_memory_bytes()
+{
+  std::lock_guard<std::mutex> producer_lock(producer_buffer_mutex_);
+  return producer_buffer_->get_bytes_size() + consumer_buffer_->get_bytes_size();
+}
+
+size_t MessageCache::get_peak_memory_bytes()
+{
+  return peak_memory_bytes_;
 }
 
 void MessageCache::begin_flushing()
@@ -107,6 +269,8 @@ void MessageCache::begin_flushing()
     flushing_ = true;
   }
   cache_condition_var_.notify_one();
+  // Producers waiting for space must not hold up the final flush
+  buffers_swapped_condition_var_.notify_all();
 }
 
 void MessageCache::done_flushing()
@@ -114,6 +278,29 @@ void MessageCache::done_flushing()
   flushing_ = false;
 }
 
+uint64_t MessageCache::get_dropped_message_count() const
+{
+  return dropped_message_count_;
+}
+
+std::map<uint32_t, uint64_t> MessageCache::get_dropped_message_counts_per_priority() const
+{
+  std::map<uint32_t, uint64_t> counts;
+  for (size_t i = 0; i < dropped_message_counts_per_class_.size(); ++i) {
+    counts[priority_classes_->priority_of_class(i)] = dropped_message_counts_per_class_[i];
+  }
+  return counts;
+}
+
+void MessageCache::count_dropped(const rosbag2_storage::SerializedBagMessage & msg)
+{
+  messages_dropped_per_topic_[msg.topic_name]++;
+  dropped_message_count_++;
+  if (priority_classes_) {
+    dropped_message_counts_per_class_[priority_classes_->class_of(msg.topic_name)]++;
+  }
+}
+
 void MessageCache::log_dropped()
 {
   uint64_t total_lost = 0;
@@ -139,7 +326,35 @@ void MessageCache::log_dropped()
     ROSBAG2_CPP_LOG_WARN_STREAM(log_text);
   }
 
-  size_t remaining = producer_buffer_->size() + consumer_buffer_->size();
+  std::string priority_log_text("Cache buffers lost messages per topic priority: ");
+  bool lost_by_priority = false;
+  for (const auto & [priority, lost] : get_dropped_message_counts_per_priority()) {
+    if (lost > 0) {
+      priority_log_text += "\n\t" + std::to_string(priority) + ": " + std::to_string(lost);
+      lost_by_priority = true;
+    }
+  }
+  if (lost_by_priority) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(priority_log_text);
+  }
+
+  const uint64_t blocked_push_count = blocked_push_count_;
+  if (blocked_push_count > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Producers were blocked by a full cache " << blocked_push_count << " times for " <<
+        std::chrono::duration_cast<std::chrono::milliseconds>(get_time_blocked()).count() <<
+        " ms in total");
+  }
+
+  const uint64_t spilled_message_count = spilled_message_count_;
+  if (spilled_message_count > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Cache overflowed, " << spilled_message_count << " messages were spilled to " <<
+        spill_file_->get_path() << " using up to " << spill_file_peak_bytes_ << " bytes");
+  }
+
+  size_t remaining = producer_buffer_->size() + consumer_buffer_->size() +
+    (spill_file_ ? spill_file_->size() : 0u);
   if (remaining > 0) {
     ROSBAG2_CPP_LOG_WARN_STREAM(
       "Cache buffers were unflushed with " << remaining << " remaining messages"
@@ -147,5 +362,20 @@ void MessageCache::log_dropped()
   }
 }
 
+CacheOverflowPolicy MessageCache::get_overflow_policy() const
+{
+  return overflow_policy_;
+}
+
+std::chrono::nanoseconds MessageCache::get_time_blocked() const
+{
+  return std::chrono::nanoseconds(time_blocked_ns_.load());
+}
+
+uint64_t MessageCache::get_blocked_push_count() const
+{
+  return blocked_push_count_;
+}
+
 }  // namespace cache
 }  // namespace rosbag2_cpp
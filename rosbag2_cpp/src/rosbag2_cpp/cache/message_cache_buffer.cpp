@@ -12,11 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/cache/message_cache_buffer.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
 
 namespace rosbag2_cpp
 {
@@ -32,9 +34,11 @@ bool MessageCacheBuffer::push(CacheBufferInterface::buffer_element_t msg)
 {
   bool pushed = false;
   if (!drop_messages_) {
-    buffer_bytes_size_ += msg->serialized_data->buffer_length;
+    buffer_bytes_size_ += get_message_memory_bytes(*msg);
     buffer_.push_back(msg);
     pushed = true;
+    // Only the producer pushes, the peak needs no compare-and-swap
+    peak_bytes_size_ = std::max(peak_bytes_size_.load(), buffer_bytes_size_.load());
   }
 
   if (buffer_bytes_size_ >= max_bytes_size_) {
@@ -60,5 +64,15 @@ const std::vector<CacheBufferInterface::buffer_element_t> & MessageCacheBuffer::
   return buffer_;
 }
 
+size_t MessageCacheBuffer::get_bytes_size() const
+{
+  return buffer_bytes_size_;
+}
+
+size_t MessageCacheBuffer::get_peak_bytes_size() const
+{
+  return peak_bytes_size_;
+}
+
 }  // namespace cache
 }  // namespace rosbag2_cpp
@@ -14,11 +14,13 @@
 
 #include <deque>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "rosbag2_cpp/logging.hpp"
 #include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
 #include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
 
 namespace rosbag2_cpp
 {
@@ -30,21 +32,33 @@ MessageCacheCircularBuffer::MessageCacheCircularBuffer(size_t max_cache_size)
 {
 }
 
+MessageCacheCircularBuffer::MessageCacheCircularBuffer(
+  size_t max_cache_size,
+  drop_callback_t on_message_dropped)
+: max_bytes_size_(max_cache_size),
+  on_message_dropped_(std::move(on_message_dropped))
+{
+}
+
 bool MessageCacheCircularBuffer::push(CacheBufferInterface::buffer_element_t msg)
 {
+  const size_t msg_bytes = get_message_memory_bytes(*msg);
   // Drop message if it exceeds the buffer size
-  if (msg->serialized_data->buffer_length > max_bytes_size_) {
+  if (msg_bytes > max_bytes_size_) {
     ROSBAG2_CPP_LOG_WARN_STREAM("Last message exceeds snapshot buffer size. Dropping message!");
     return false;
   }
 
   // Remove any old items until there is room for new message
-  while (buffer_bytes_size_ > (max_bytes_size_ - msg->serialized_data->buffer_length)) {
-    buffer_bytes_size_ -= buffer_.front()->serialized_data->buffer_length;
+  while (buffer_bytes_size_ > (max_bytes_size_ - msg_bytes)) {
+    buffer_bytes_size_ -= get_message_memory_bytes(*buffer_.front());
+    if (on_message_dropped_) {
+      on_message_dropped_(buffer_.front());
+    }
     buffer_.pop_front();
   }
   // Add new message to end of buffer
-  buffer_bytes_size_ += msg->serialized_data->buffer_length;
+  buffer_bytes_size_ += msg_bytes;
   buffer_.push_back(msg);
 
   return true;
@@ -61,6 +75,11 @@ size_t MessageCacheCircularBuffer::size()
   return buffer_.size();
 }
 
+size_t MessageCacheCircularBuffer::get_bytes_size() const
+{
+  return buffer_bytes_size_;
+}
+
 const std::vector<CacheBufferInterface::buffer_element_t> & MessageCacheCircularBuffer::data()
 {
   // Copy data to vector to maintain same interface as MessageCacheBuffer
@@ -0,0 +1,149 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/cache/cache_buffer_interface.hpp"
+#include "rosbag2_cpp/cache/message_cache_priority_buffer.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+CachePriorityClasses::CachePriorityClasses(
+  const std::unordered_map<std::string, uint32_t> & topic_priorities)
+{
+  priorities_.push_back(0u);
+  for (const auto & topic_priority : topic_priorities) {
+    priorities_.push_back(topic_priority.second);
+  }
+  std::sort(priorities_.begin(), priorities_.end());
+  priorities_.erase(std::unique(priorities_.begin(), priorities_.end()), priorities_.end());
+
+  auto class_of_priority = [this](uint32_t priority) {
+      return static_cast<size_t>(
+        std::lower_bound(priorities_.begin(), priorities_.end(), priority) - priorities_.begin());
+    };
+  default_class_ = class_of_priority(0u);
+  for (const auto & [topic_name, priority] : topic_priorities) {
+    topic_classes_.emplace(topic_name, class_of_priority(priority));
+  }
+}
+
+size_t CachePriorityClasses::class_of(const std::string & topic_name) const
+{
+  const auto topic_class = topic_classes_.find(topic_name);
+  return topic_class != topic_classes_.end() ? topic_class->second : default_class_;
+}
+
+size_t CachePriorityClasses::class_count() const
+{
+  return priorities_.size();
+}
+
+uint32_t CachePriorityClasses::priority_of_class(size_t priority_class) const
+{
+  return priorities_.at(priority_class);
+}
+
+MessageCachePriorityBuffer::MessageCachePriorityBuffer(
+  size_t max_cache_size,
+  std::shared_ptr<const CachePriorityClasses> priority_classes,
+  drop_callback_t on_message_evicted)
+: max_bytes_size_(max_cache_size),
+  priority_classes_(std::move(priority_classes)),
+  on_message_evicted_(std::move(on_message_evicted)),
+  queues_(priority_classes_->class_count())
+{
+}
+
+bool MessageCachePriorityBuffer::push(CacheBufferInterface::buffer_element_t msg)
+{
+  const size_t priority_class = priority_classes_->class_of(msg->topic_name);
+  // Evict the oldest messages of the lowest classes first
+  size_t evicted_class = 0;
+  while (buffer_bytes_size_ >= max_bytes_size_ && evicted_class < priority_class) {
+    auto & queue = queues_[evicted_class];
+    if (queue.empty()) {
+      ++evicted_class;
+      continue;
+    }
+    buffer_bytes_size_ -= get_message_memory_bytes(*queue.front().message);
+    if (on_message_evicted_) {
+      on_message_evicted_(queue.front().message);
+    }
+    queue.pop_front();
+    --message_count_;
+  }
+  if (buffer_bytes_size_ >= max_bytes_size_) {
+    return false;
+  }
+
+  buffer_bytes_size_ += get_message_memory_bytes(*msg);
+  queues_[priority_class].push_back({next_sequence_++, std::move(msg)});
+  ++message_count_;
+  return true;
+}
+
+void MessageCachePriorityBuffer::clear()
+{
+  for (auto & queue : queues_) {
+    queue.clear();
+  }
+  msg_vector_.clear();
+  buffer_bytes_size_ = 0u;
+  message_count_ = 0u;
+}
+
+size_t MessageCachePriorityBuffer::size()
+{
+  return message_count_;
+}
+
+const std::vector<CacheBufferInterface::buffer_element_t> & MessageCachePriorityBuffer::data()
+{
+  // Merge the queues back into the order the messages were pushed in
+  msg_vector_.clear();
+  msg_vector_.reserve(message_count_);
+  std::vector<size_t> positions(queues_.size(), 0u);
+  while (msg_vector_.size() < message_count_) {
+    size_t next_class = queues_.size();
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      if (positions[i] < queues_[i].size() &&
+        (next_class == queues_.size() ||
+        queues_[i][positions[i]].sequence < queues_[next_class][positions[next_class]].sequence))
+      {
+        next_class = i;
+      }
+    }
+    msg_vector_.push_back(queues_[next_class][positions[next_class]++].message);
+  }
+  return msg_vector_;
+}
+
+size_t MessageCachePriorityBuffer::get_bytes_size() const
+{
+  return buffer_bytes_size_;
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
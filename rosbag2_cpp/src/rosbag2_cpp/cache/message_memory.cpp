@@ -0,0 +1,57 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "rosbag2_cpp/cache/message_memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+namespace
+{
+// Control block of a shared_ptr: two reference counts plus a deleter or allocator, padded
+// by the allocator. Exact sizes depend on the standard library, this is an upper estimate.
+constexpr size_t kSharedPtrControlBlockBytes = 4 * sizeof(void *);
+
+size_t get_string_heap_bytes(const std::string & str)
+{
+  // Short strings live inside the string object and take no extra memory
+  const auto data = reinterpret_cast<std::uintptr_t>(str.data());
+  const auto object = reinterpret_cast<std::uintptr_t>(&str);
+  if (data >= object && data < object + sizeof(std::string)) {
+    return 0u;
+  }
+  return str.capacity() + 1u;
+}
+}  // namespace
+
+size_t get_message_memory_bytes(const rosbag2_storage::SerializedBagMessage & message)
+{
+  size_t bytes = sizeof(rosbag2_storage::SerializedBagMessage) + kSharedPtrControlBlockBytes +
+    get_string_heap_bytes(message.topic_name);
+  if (message.serialized_data) {
+    bytes += sizeof(rcutils_uint8_array_t) + kSharedPtrControlBlockBytes +
+      std::max(message.serialized_data->buffer_capacity, message.serialized_data->buffer_length);
+  }
+  return bytes;
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
@@ -0,0 +1,399 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/cache/message_cache_circular_buffer.hpp"
+#include "rosbag2_cpp/cache/sharded_message_cache.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+ShardedMessageCache::Shard::Shard(size_t max_size, CacheOverflowPolicy overflow_policy)
+: policy(overflow_policy)
+{
+  if (policy == CacheOverflowPolicy::DROP_OLDEST) {
+    // Called from push() with the shard mutex held
+    auto on_dropped = [this](const CacheBufferInterface::buffer_element_t & msg) {
+        messages_dropped_per_topic[msg->topic_name]++;
+      };
+    producer_buffer = std::make_shared<MessageCacheCircularBuffer>(max_size, on_dropped);
+    consumer_buffer = std::make_shared<MessageCacheCircularBuffer>(max_size, on_dropped);
+  } else {
+    producer_buffer = std::make_shared<MessageCacheBuffer>(max_size);
+    consumer_buffer = std::make_shared<MessageCacheBuffer>(max_size);
+  }
+}
+
+ShardedMessageCache::ShardedMessageCache(
+  size_t default_shard_size,
+  bool shard_per_topic,
+  const std::unordered_map<std::string, std::vector<std::string>> & topic_groups,
+  const std::unordered_map<std::string, uint64_t> & shard_sizes,
+  const std::unordered_map<std::string, CacheOverflowPolicy> & shard_policies,
+  CacheOverflowPolicy default_policy,
+  std::chrono::milliseconds block_timeout)
+: default_shard_size_(default_shard_size),
+  shard_per_topic_(shard_per_topic),
+  shard_sizes_(shard_sizes),
+  shard_policies_(shard_policies),
+  default_policy_(default_policy),
+  block_timeout_(block_timeout)
+{
+  if (default_policy_ == CacheOverflowPolicy::SPILL_TO_DISK) {
+    throw std::invalid_argument(
+            "The spill_to_disk cache overflow policy is not supported by the sharded cache");
+  }
+  for (const auto & [shard_name, policy] : shard_policies_) {
+    if (policy == CacheOverflowPolicy::SPILL_TO_DISK) {
+      throw std::invalid_argument(
+              "The spill_to_disk cache overflow policy of shard '" + shard_name +
+              "' is not supported by the sharded cache");
+    }
+  }
+  for (const auto & [group_name, topics] : topic_groups) {
+    for (const auto & topic : topics) {
+      auto inserted = topic_to_group_.emplace(topic, group_name);
+      if (!inserted.second && inserted.first->second != group_name) {
+        ROSBAG2_CPP_LOG_WARN_STREAM(
+          "Topic '" << topic << "' is listed in cache topic groups '" <<
+            inserted.first->second << "' and '" << group_name << "'. Using '" <<
+            inserted.first->second << "'.");
+      }
+    }
+  }
+  consumer_buffer_ = std::make_shared<MessageCacheBuffer>(std::numeric_limits<size_t>::max());
+}
+
+ShardedMessageCache::~ShardedMessageCache()
+{
+  // Initiate flushing on destruction to unblock wait_for_data.
+  flushing_ = true;
+  cache_condition_var_.notify_one();
+  notify_blocked_producers();
+  log_dropped();
+}
+
+std::string ShardedMessageCache::get_shard_name(const std::string & topic_name) const
+{
+  auto group = topic_to_group_.find(topic_name);
+  if (group != topic_to_group_.end()) {
+    return group->second;
+  }
+  return shard_per_topic_ ? topic_name : std::string(kDefaultShardName);
+}
+
+CacheOverflowPolicy ShardedMessageCache::get_shard_policy(const std::string & topic_name) const
+{
+  auto policy = shard_policies_.find(get_shard_name(topic_name));
+  return policy != shard_policies_.end() ? policy->second : default_policy_;
+}
+
+size_t ShardedMessageCache::get_shard_count() const
+{
+  std::shared_lock<std::shared_mutex> lock(shards_mutex_);
+  return shards_.size();
+}
+
+ShardedMessageCache::Shard & ShardedMessageCache::get_shard_for_topic(
+  const std::string & topic_name)
+{
+  {
+    std::shared_lock<std::shared_mutex> lock(shards_mutex_);
+    auto it = topic_to_shard_.find(topic_name);
+    if (it != topic_to_shard_.end()) {
+      return *it->second;
+    }
+  }
+
+  // First message on this topic: resolve its shard, creating the shard when needed.
+  const std::string shard_name = get_shard_name(topic_name);
+  std::unique_lock<std::shared_mutex> lock(shards_mutex_);
+  auto shard = shards_.find(shard_name);
+  if (shard == shards_.end()) {
+    auto size = shard_sizes_.find(shard_name);
+    const size_t max_size =
+      size != shard_sizes_.end() ? static_cast<size_t>(size->second) : default_shard_size_;
+    auto policy = shard_policies_.find(shard_name);
+    shard = shards_.emplace(
+      shard_name, std::make_unique<Shard>(
+        max_size, policy != shard_policies_.end() ? policy->second : default_policy_)).first;
+  }
+  topic_to_shard_[topic_name] = shard->second.get();
+  return *shard->second;
+}
+
+void ShardedMessageCache::push(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg)
+{
+  Shard & shard = get_shard_for_topic(msg->topic_name);
+  {
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    bool pushed = shard.producer_buffer->push(msg);
+    if (!pushed && shard.policy == CacheOverflowPolicy::BLOCK) {
+      pushed = push_blocking(shard, lock, msg);
+    }
+    if (!pushed) {
+      shard.messages_dropped_per_topic[msg->topic_name]++;
+      return;
+    }
+  }
+
+  // Pairs with the fence in wait_for_data(): producers only take the wait mutex when the
+  // consumer is actually sleeping, so shards do not contend on a common lock.
+  data_ready_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_waiting_.load(std::memory_order_relaxed)) {
+    notify_data_ready();
+  }
+}
+
+bool ShardedMessageCache::push_blocking(
+  Shard & shard, std::unique_lock<std::mutex> & producer_lock,
+  const std::shared_ptr<const rosbag2_storage::SerializedBagMessage> & msg)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + block_timeout_;
+  blocked_push_count_++;
+
+  // The consumer might be sleeping, make sure it comes to swap the full shard
+  notify_data_ready();
+
+  bool pushed = false;
+  while (!pushed && !flushing_) {
+    const uint64_t swap_count = shard.swap_count;
+    auto shard_swapped = [this, &shard, swap_count] {
+        return shard.swap_count != swap_count || flushing_;
+      };
+    if (block_timeout_.count() > 0) {
+      if (!shard.swapped_condition_var.wait_until(producer_lock, deadline, shard_swapped)) {
+        break;
+      }
+    } else {
+      shard.swapped_condition_var.wait(producer_lock, shard_swapped);
+    }
+    pushed = shard.producer_buffer->push(msg);
+  }
+
+  time_blocked_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+  return pushed;
+}
+
+void ShardedMessageCache::notify_blocked_producers()
+{
+  std::shared_lock<std::shared_mutex> shards_lock(shards_mutex_);
+  for (auto & [name, shard] : shards_) {
+    (void)name;
+    if (shard->policy == CacheOverflowPolicy::BLOCK) {
+      // Taking the shard mutex makes sure waiting producers see flushing_
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->swapped_condition_var.notify_all();
+    }
+  }
+}
+
+std::shared_ptr<CacheBufferInterface> ShardedMessageCache::get_consumer_buffer()
+{
+  consumer_buffer_mutex_.lock();
+  return consumer_buffer_;
+}
+
+void ShardedMessageCache::release_consumer_buffer()
+{
+  consumer_buffer_mutex_.unlock();
+}
+
+void ShardedMessageCache::notify_data_ready()
+{
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    data_ready_ = true;
+  }
+  cache_condition_var_.notify_one();
+}
+
+void ShardedMessageCache::wait_for_data()
+{
+  std::unique_lock<std::mutex> lock(wait_mutex_);
+  if (!flushing_) {
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Required condition check to protect against spurious wakeups
+    cache_condition_var_.wait(
+      lock, [this] {
+        return data_ready_ || flushing_;
+      });
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+    data_ready_ = false;
+  }
+}
+
+void ShardedMessageCache::wait_for_data_until(std::chrono::steady_clock::time_point deadline)
+{
+  std::unique_lock<std::mutex> lock(wait_mutex_);
+  if (!flushing_) {
+    consumer_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cache_condition_var_.wait_until(
+      lock, deadline, [this] {
+        return data_ready_ || flushing_;
+      });
+    consumer_waiting_.store(false, std::memory_order_relaxed);
+    data_ready_ = false;
+  }
+}
+
+void ShardedMessageCache::swap_buffers()
+{
+  std::lock_guard<std::mutex> consumer_lock(consumer_buffer_mutex_);
+  std::vector<CacheBufferInterface::buffer_element_t> merged;
+  size_t shards_with_data = 0;
+  {
+    std::shared_lock<std::shared_mutex> shards_lock(shards_mutex_);
+    for (auto & [name, shard] : shards_) {
+      (void)name;
+      {
+        // Producers of this shard are blocked only for the pointer swap
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        std::swap(shard->producer_buffer, shard->consumer_buffer);
+        shard->swap_count++;
+      }
+      shard->swapped_condition_var.notify_all();
+      const auto & data = shard->consumer_buffer->data();
+      if (!data.empty()) {
+        ++shards_with_data;
+        merged.insert(merged.end(), data.begin(), data.end());
+      }
+      shard->consumer_buffer->clear();
+    }
+  }
+
+  // Every shard is in arrival order already, only interleave the shards.
+  if (shards_with_data > 1) {
+    std::stable_sort(
+      merged.begin(), merged.end(),
+      [](const auto & lhs, const auto & rhs) {
+        return lhs->time_stamp < rhs->time_stamp;
+      });
+  }
+  for (auto & msg : merged) {
+    consumer_buffer_->push(std::move(msg));
+  }
+}
+
+void ShardedMessageCache::begin_flushing()
+{
+  {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    flushing_ = true;
+  }
+  cache_condition_var_.notify_one();
+  notify_blocked_producers();
+}
+
+void ShardedMessageCache::done_flushing()
+{
+  flushing_ = false;
+}
+
+std::unordered_map<std::string, uint32_t>
+ShardedMessageCache::get_messages_dropped_per_topic() const
+{
+  std::unordered_map<std::string, uint32_t> messages_dropped_per_topic;
+  std::shared_lock<std::shared_mutex> shards_lock(shards_mutex_);
+  for (const auto & [name, shard] : shards_) {
+    (void)name;
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    for (const auto & [topic, lost] : shard->messages_dropped_per_topic) {
+      messages_dropped_per_topic[topic] += lost;
+    }
+  }
+  return messages_dropped_per_topic;
+}
+
+uint64_t ShardedMessageCache::get_dropped_message_count() const
+{
+  uint64_t dropped_message_count = 0;
+  for (const auto & [topic, lost] : get_messages_dropped_per_topic()) {
+    (void)topic;
+    dropped_message_count += lost;
+  }
+  return dropped_message_count;
+}
+
+std::chrono::nanoseconds ShardedMessageCache::get_time_blocked() const
+{
+  return std::chrono::nanoseconds(time_blocked_ns_.load());
+}
+
+void ShardedMessageCache::log_dropped()
+{
+  uint64_t total_lost = 0;
+  std::string log_text("Cache buffers lost messages per topic: ");
+
+  const auto messages_dropped_per_topic = get_messages_dropped_per_topic();
+  std::map<std::string, uint32_t> messages_dropped_per_topic_sorted(
+    messages_dropped_per_topic.begin(), messages_dropped_per_topic.end());
+
+  for (const auto & e : messages_dropped_per_topic_sorted) {
+    uint32_t lost = e.second;
+    if (lost > 0) {
+      log_text += "\n\t" + e.first + ": " + std::to_string(lost);
+      total_lost += lost;
+    }
+  }
+
+  if (total_lost > 0) {
+    log_text += "\nTotal lost: " + std::to_string(total_lost);
+    ROSBAG2_CPP_LOG_WARN_STREAM(log_text);
+  }
+
+  const uint64_t blocked_push_count = blocked_push_count_;
+  if (blocked_push_count > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Producers were blocked by a full cache shard " << blocked_push_count << " times for " <<
+        std::chrono::duration_cast<std::chrono::milliseconds>(get_time_blocked()).count() <<
+        " ms in total");
+  }
+
+  size_t remaining = consumer_buffer_->size();
+  {
+    std::shared_lock<std::shared_mutex> shards_lock(shards_mutex_);
+    for (const auto & [name, shard] : shards_) {
+      (void)name;
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      remaining += shard->producer_buffer->size();
+    }
+  }
+  if (remaining > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Cache buffers were unflushed with " << remaining << " remaining messages"
+    );
+  }
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
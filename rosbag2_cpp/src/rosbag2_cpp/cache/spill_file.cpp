@@ -0,0 +1,294 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/cache/spill_file.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_cpp
+{
+namespace cache
+{
+
+namespace
+{
+struct RecordHeader
+{
+  uint64_t data_length;
+  int64_t time_stamp;
+  int64_t send_timestamp;
+  uint64_t sequence_number;
+  uint32_t topic_name_length;
+  uint32_t topic_id;
+};
+
+constexpr size_t kRecordAlignment = 8;
+
+size_t record_size(size_t topic_name_length, size_t data_length)
+{
+  const size_t size = sizeof(RecordHeader) + topic_name_length + data_length;
+  return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+std::string make_spill_file_path(const std::string & directory)
+{
+  const std::filesystem::path base =
+    directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory);
+  std::random_device random_device;
+  const auto suffix = std::to_string(random_device()) + std::to_string(random_device());
+  return (base / ("rosbag2_cache_spill_" + suffix + ".bin")).string();
+}
+}  // namespace
+
+SpillFile::SpillFile(const std::string & directory, size_t capacity)
+: path_(make_spill_file_path(directory)),
+  capacity_(capacity)
+{
+  if (capacity_ == 0) {
+    throw std::runtime_error("Cache spill file capacity must be greater than 0");
+  }
+  map_file();
+}
+
+SpillFile::~SpillFile()
+{
+  if (message_count_ > 0) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Cache spill file was closed with " << message_count_ << " unread messages");
+  }
+  unmap_file();
+}
+
+#ifdef _WIN32
+void SpillFile::map_file()
+{
+  // The file is removed by the system once the last handle is closed
+  HANDLE file = CreateFileA(
+    path_.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+    FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Failed to create cache spill file " + path_);
+  }
+  file_handle_ = file;
+  const auto size = static_cast<uint64_t>(capacity_);
+  HANDLE mapping = CreateFileMappingA(
+    file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+    static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+  if (mapping == nullptr) {
+    unmap_file();
+    throw std::runtime_error("Failed to allocate cache spill file " + path_);
+  }
+  mapping_handle_ = mapping;
+  data_ = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity_));
+  if (data_ == nullptr) {
+    unmap_file();
+    throw std::runtime_error("Failed to map cache spill file " + path_);
+  }
+}
+
+void SpillFile::unmap_file()
+{
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+    data_ = nullptr;
+  }
+  if (mapping_handle_ != nullptr) {
+    CloseHandle(mapping_handle_);
+    mapping_handle_ = nullptr;
+  }
+  if (file_handle_ != nullptr) {
+    CloseHandle(file_handle_);
+    file_handle_ = nullptr;
+  }
+}
+#else
+void SpillFile::map_file()
+{
+  file_descriptor_ = open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (file_descriptor_ < 0) {
+    throw std::runtime_error(
+            "Failed to create cache spill file " + path_ + ": " + std::strerror(errno));
+  }
+  // The file stays accessible through the mapping, unlinking right away makes sure it is
+  // removed even if the process does not shut down cleanly.
+  unlink(path_.c_str());
+
+#ifdef __linux__
+  // Reserve the blocks up front, running out of disk space while spilling would fault the mapping
+  const int allocate_result = posix_fallocate(file_descriptor_, 0, static_cast<off_t>(capacity_));
+#else
+  const int allocate_result =
+    ftruncate(file_descriptor_, static_cast<off_t>(capacity_)) == 0 ? 0 : errno;
+#endif
+  if (allocate_result != 0) {
+    unmap_file();
+    throw std::runtime_error(
+            "Failed to allocate " + std::to_string(capacity_) + " bytes for cache spill file " +
+            path_ + ": " + std::strerror(allocate_result));
+  }
+
+  void * data = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor_, 0);
+  if (data == MAP_FAILED) {
+    unmap_file();
+    throw std::runtime_error(
+            "Failed to map cache spill file " + path_ + ": " + std::strerror(errno));
+  }
+  data_ = static_cast<uint8_t *>(data);
+  madvise(data_, capacity_, MADV_SEQUENTIAL);
+}
+
+void SpillFile::unmap_file()
+{
+  if (data_ != nullptr) {
+    munmap(data_, capacity_);
+    data_ = nullptr;
+  }
+  if (file_descriptor_ >= 0) {
+    close(file_descriptor_);
+    file_descriptor_ = -1;
+  }
+}
+#endif
+
+size_t SpillFile::write_at(size_t offset, const void * source, size_t length)
+{
+  const size_t head_length = std::min(length, capacity_ - offset);
+  std::memcpy(data_ + offset, source, head_length);
+  std::memcpy(data_, static_cast<const uint8_t *>(source) + head_length, length - head_length);
+  return (offset + length) % capacity_;
+}
+
+size_t SpillFile::read_at(size_t offset, void * destination, size_t length) const
+{
+  const size_t head_length = std::min(length, capacity_ - offset);
+  std::memcpy(destination, data_ + offset, head_length);
+  std::memcpy(static_cast<uint8_t *>(destination) + head_length, data_, length - head_length);
+  return (offset + length) % capacity_;
+}
+
+bool SpillFile::append(const rosbag2_storage::SerializedBagMessage & msg)
+{
+  const size_t data_length = msg.serialized_data ? msg.serialized_data->buffer_length : 0u;
+  const size_t size = record_size(msg.topic_name.size(), data_length);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size > capacity_ - used_bytes_) {
+    return false;
+  }
+  RecordHeader header{
+    data_length, msg.time_stamp, msg.send_timestamp, msg.sequence_number,
+    static_cast<uint32_t>(msg.topic_name.size()), msg.topic_id};
+  // Records which reach the end of the file are split and continue at its beginning
+  size_t offset = write_at(write_offset_, &header, sizeof(header));
+  offset = write_at(offset, msg.topic_name.data(), msg.topic_name.size());
+  if (data_length > 0) {
+    write_at(offset, msg.serialized_data->buffer, data_length);
+  }
+  write_offset_ = (write_offset_ + size) % capacity_;
+  used_bytes_ += size;
+  message_count_++;
+  return true;
+}
+
+std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> SpillFile::read(
+  size_t max_bytes)
+{
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+  size_t bytes_read = 0;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (message_count_ > 0 && bytes_read < max_bytes) {
+    RecordHeader header;
+    size_t offset = read_at(read_offset_, &header, sizeof(header));
+
+    auto msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    msg->time_stamp = header.time_stamp;
+    msg->send_timestamp = header.send_timestamp;
+    msg->sequence_number = header.sequence_number;
+    msg->topic_id = header.topic_id;
+    msg->topic_name.resize(static_cast<size_t>(header.topic_name_length));
+    offset = read_at(offset, msg->topic_name.data(), msg->topic_name.size());
+    const auto data_length = static_cast<size_t>(header.data_length);
+    msg->serialized_data = rosbag2_storage::make_empty_serialized_message(data_length);
+    if (data_length > 0) {
+      read_at(offset, msg->serialized_data->buffer, data_length);
+    }
+    msg->serialized_data->buffer_length = data_length;
+    messages.push_back(std::move(msg));
+
+    bytes_read += data_length;
+    const size_t size = record_size(
+      static_cast<size_t>(header.topic_name_length), data_length);
+    read_offset_ = (read_offset_ + size) % capacity_;
+    used_bytes_ -= size;
+    message_count_--;
+  }
+  if (message_count_ == 0) {
+    // Everything was read, keep writing contiguously from the beginning of the file
+    read_offset_ = 0;
+    write_offset_ = 0;
+  }
+  return messages;
+}
+
+bool SpillFile::empty() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return message_count_ == 0;
+}
+
+size_t SpillFile::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return message_count_;
+}
+
+size_t SpillFile::get_used_bytes() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return used_bytes_;
+}
+
+size_t SpillFile::get_capacity() const
+{
+  return capacity_;
+}
+
+const std::string & SpillFile::get_path() const
+{
+  return path_;
+}
+
+}  // namespace cache
+}  // namespace rosbag2_cpp
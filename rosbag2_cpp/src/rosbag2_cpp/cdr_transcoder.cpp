@@ -0,0 +1,415 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/cdr_transcoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include "rcutils/error_handling.h"
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+#include "rosidl_typesupport_introspection_cpp/message_introspection.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+using rosidl_typesupport_introspection_cpp::MessageMember;
+using rosidl_typesupport_introspection_cpp::MessageMembers;
+
+// Alignment is relative to the end of the encapsulation header
+constexpr size_t kEncapsulationSize = 4;
+constexpr uint8_t kCdrBigEndian = 0x00;
+constexpr uint8_t kCdrLittleEndian = 0x01;
+constexpr uint8_t kPlainCdr2BigEndian = 0x06;
+constexpr uint8_t kPlainCdr2LittleEndian = 0x07;
+
+bool host_is_big_endian()
+{
+  const uint16_t one = 1;
+  uint8_t first_byte = 0;
+  std::memcpy(&first_byte, &one, 1);
+  return first_byte == 0;
+}
+
+// Size of a primitive in CDR, or 0 if the type is not a primitive
+size_t primitive_size(uint8_t type_id)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  switch (type_id) {
+    case ts::ROS_TYPE_BOOLEAN:
+    case ts::ROS_TYPE_CHAR:
+    case ts::ROS_TYPE_OCTET:
+    case ts::ROS_TYPE_UINT8:
+    case ts::ROS_TYPE_INT8:
+      return 1;
+    case ts::ROS_TYPE_UINT16:
+    case ts::ROS_TYPE_INT16:
+      return 2;
+    case ts::ROS_TYPE_FLOAT:
+    case ts::ROS_TYPE_UINT32:
+    case ts::ROS_TYPE_INT32:
+      return 4;
+    case ts::ROS_TYPE_DOUBLE:
+    case ts::ROS_TYPE_UINT64:
+    case ts::ROS_TYPE_INT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+void check_members(const MessageMembers * members)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  for (uint32_t i = 0; i < members->member_count_; ++i) {
+    const MessageMember & member = members->members_[i];
+    if (member.type_id_ == ts::ROS_TYPE_MESSAGE) {
+      check_members(static_cast<const MessageMembers *>(member.members_->data));
+    } else if (member.type_id_ != ts::ROS_TYPE_STRING && primitive_size(member.type_id_) == 0) {
+      throw std::invalid_argument(
+              std::string("Member '") + member.name_ + "' of " + members->message_namespace_ +
+              "::" + members->message_name_ + " can not be transcoded");
+    }
+  }
+}
+
+uint16_t byte_swap(uint16_t value)
+{
+  return static_cast<uint16_t>((value >> 8) | (value << 8));
+}
+
+uint32_t byte_swap(uint32_t value)
+{
+  return ((value & 0x000000ffu) << 24) | ((value & 0x0000ff00u) << 8) |
+         ((value & 0x00ff0000u) >> 8) | ((value & 0xff000000u) >> 24);
+}
+
+uint64_t byte_swap(uint64_t value)
+{
+  return (static_cast<uint64_t>(byte_swap(static_cast<uint32_t>(value))) << 32) |
+         byte_swap(static_cast<uint32_t>(value >> 32));
+}
+
+// Written as a plain loop over the contiguous elements, which compilers vectorize
+template<typename T>
+void byte_swap_elements(uint8_t * data, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    T value;
+    std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+    value = byte_swap(value);
+    std::memcpy(data + i * sizeof(T), &value, sizeof(T));
+  }
+}
+
+void byte_swap_elements(uint8_t * data, size_t element_size, size_t count)
+{
+  switch (element_size) {
+    case 2:
+      byte_swap_elements<uint16_t>(data, count);
+      break;
+    case 4:
+      byte_swap_elements<uint32_t>(data, count);
+      break;
+    case 8:
+      byte_swap_elements<uint64_t>(data, count);
+      break;
+    default:
+      break;
+  }
+}
+
+size_t aligned_position(size_t position, size_t alignment)
+{
+  const size_t offset = position - kEncapsulationSize;
+  return position + (alignment - offset % alignment) % alignment;
+}
+
+class InputCursor
+{
+public:
+  InputCursor(
+    const rcutils_uint8_array_t & input, const CdrTranscoder::Encapsulation & encapsulation)
+  : data_(input.buffer),
+    size_(input.buffer_length),
+    xcdr2_(encapsulation.xcdr2),
+    swap_(encapsulation.big_endian != host_is_big_endian())
+  {}
+
+  bool xcdr2() const
+  {
+    return xcdr2_;
+  }
+
+  void align(size_t size)
+  {
+    position_ = aligned_position(position_, std::min<size_t>(size, xcdr2_ ? 4 : 8));
+  }
+
+  size_t remaining() const
+  {
+    return position_ < size_ ? size_ - position_ : 0;
+  }
+
+  const uint8_t * take(size_t size)
+  {
+    if (size > remaining()) {
+      throw std::runtime_error("Serialized message is truncated");
+    }
+    const uint8_t * data = data_ + position_;
+    position_ += size;
+    return data;
+  }
+
+  uint32_t read_uint32()
+  {
+    align(4);
+    uint32_t value;
+    std::memcpy(&value, take(4), 4);
+    return swap_ ? byte_swap(value) : value;
+  }
+
+private:
+  const uint8_t * data_;
+  size_t size_;
+  size_t position_ = kEncapsulationSize;
+  bool xcdr2_;
+  bool swap_;
+};
+
+class OutputBuffer
+{
+public:
+  OutputBuffer(rcutils_uint8_array_t & output, const CdrTranscoder::Encapsulation & encapsulation)
+  : output_(output),
+    xcdr2_(encapsulation.xcdr2),
+    swap_(encapsulation.big_endian != host_is_big_endian())
+  {}
+
+  bool xcdr2() const
+  {
+    return xcdr2_;
+  }
+
+  size_t position() const
+  {
+    return position_;
+  }
+
+  void align(size_t size)
+  {
+    const size_t padding =
+      aligned_position(position_, std::min<size_t>(size, xcdr2_ ? 4 : 8)) - position_;
+    if (padding > 0) {
+      std::memset(append(padding), 0, padding);
+    }
+  }
+
+  uint8_t * append(size_t size)
+  {
+    if (output_.buffer_capacity < position_ + size) {
+      const size_t capacity = std::max(position_ + size, 2 * output_.buffer_capacity);
+      if (rcutils_uint8_array_resize(&output_, capacity) != RCUTILS_RET_OK) {
+        const std::string error = rcutils_get_error_string().str;
+        rcutils_reset_error();
+        throw std::runtime_error("Failed to allocate transcoded message: " + error);
+      }
+    }
+    uint8_t * data = output_.buffer + position_;
+    position_ += size;
+    output_.buffer_length = position_;
+    return data;
+  }
+
+  void write_uint32(uint32_t value)
+  {
+    align(4);
+    write_uint32_at(append(4) - output_.buffer, value);
+  }
+
+  void write_uint32_at(size_t position, uint32_t value)
+  {
+    value = swap_ ? byte_swap(value) : value;
+    std::memcpy(output_.buffer + position, &value, 4);
+  }
+
+private:
+  rcutils_uint8_array_t & output_;
+  size_t position_ = 0;
+  bool xcdr2_;
+  bool swap_;
+};
+
+void transcode_members(
+  const MessageMembers * members, InputCursor & input, OutputBuffer & output, bool swap);
+
+void transcode_elements(
+  const MessageMember & member, size_t count, InputCursor & input, OutputBuffer & output,
+  bool swap)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  if (member.type_id_ == ts::ROS_TYPE_MESSAGE) {
+    const auto members = static_cast<const MessageMembers *>(member.members_->data);
+    for (size_t i = 0; i < count; ++i) {
+      transcode_members(members, input, output, swap);
+    }
+  } else if (member.type_id_ == ts::ROS_TYPE_STRING) {
+    for (size_t i = 0; i < count; ++i) {
+      const uint32_t length = input.read_uint32();
+      output.write_uint32(length);
+      const uint8_t * data = input.take(length);
+      std::memcpy(output.append(length), data, length);
+    }
+  } else if (count > 0) {
+    const size_t size = primitive_size(member.type_id_);
+    input.align(size);
+    if (count > input.remaining() / size) {
+      throw std::runtime_error("Serialized message is truncated");
+    }
+    output.align(size);
+    const uint8_t * data = input.take(count * size);
+    uint8_t * transcoded = output.append(count * size);
+    std::memcpy(transcoded, data, count * size);
+    if (swap) {
+      byte_swap_elements(transcoded, size, count);
+    }
+  }
+}
+
+void transcode_members(
+  const MessageMembers * members, InputCursor & input, OutputBuffer & output, bool swap)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  for (uint32_t i = 0; i < members->member_count_; ++i) {
+    const MessageMember & member = members->members_[i];
+    if (!member.is_array_) {
+      transcode_elements(member, 1, input, output, swap);
+      continue;
+    }
+    // XCDR2 prefixes collections of strings and messages with their size in bytes
+    const bool delimited =
+      member.type_id_ == ts::ROS_TYPE_STRING || member.type_id_ == ts::ROS_TYPE_MESSAGE;
+    if (delimited && input.xcdr2()) {
+      input.read_uint32();
+    }
+    size_t delimited_start = 0;
+    if (delimited && output.xcdr2()) {
+      output.write_uint32(0);
+      delimited_start = output.position();
+    }
+    size_t count = member.array_size_;
+    if (member.array_size_ == 0 || member.is_upper_bound_) {
+      count = input.read_uint32();
+      output.write_uint32(static_cast<uint32_t>(count));
+    }
+    transcode_elements(member, count, input, output, swap);
+    if (delimited && output.xcdr2()) {
+      output.write_uint32_at(
+        delimited_start - 4, static_cast<uint32_t>(output.position() - delimited_start));
+    }
+  }
+}
+
+CdrTranscoder::Encapsulation read_encapsulation(const rcutils_uint8_array_t & input)
+{
+  if (input.buffer_length < kEncapsulationSize || input.buffer[0] != 0) {
+    throw std::runtime_error("Serialized message has no CDR encapsulation header");
+  }
+  switch (input.buffer[1]) {
+    case kCdrBigEndian:
+      return {false, true};
+    case kCdrLittleEndian:
+      return {false, false};
+    case kPlainCdr2BigEndian:
+      return {true, true};
+    case kPlainCdr2LittleEndian:
+      return {true, false};
+    default:
+      throw std::runtime_error(
+              "Unsupported CDR encapsulation " + std::to_string(input.buffer[1]));
+  }
+}
+}  // namespace
+
+std::optional<CdrTranscoder::Encapsulation> CdrTranscoder::encapsulation_of_format(
+  const std::string & format)
+{
+  if (format == "cdr") {
+    return Encapsulation{false, host_is_big_endian()};
+  }
+  if (format == "cdr_le") {
+    return Encapsulation{false, false};
+  }
+  if (format == "cdr_be") {
+    return Encapsulation{false, true};
+  }
+  if (format == "xcdr2_le") {
+    return Encapsulation{true, false};
+  }
+  if (format == "xcdr2_be") {
+    return Encapsulation{true, true};
+  }
+  return std::nullopt;
+}
+
+CdrTranscoder::CdrTranscoder(const rosidl_message_type_support_t * introspection_type_support)
+: introspection_type_support_(introspection_type_support)
+{
+  if (!introspection_type_support_) {
+    throw std::invalid_argument("No introspection type support to transcode messages with");
+  }
+  check_members(static_cast<const MessageMembers *>(introspection_type_support_->data));
+}
+
+void CdrTranscoder::transcode(
+  const rcutils_uint8_array_t & input,
+  const Encapsulation & encapsulation,
+  rcutils_uint8_array_t & output) const
+{
+  const auto input_encapsulation = read_encapsulation(input);
+  OutputBuffer output_buffer(output, encapsulation);
+  if (input_encapsulation == encapsulation) {
+    std::memcpy(output_buffer.append(input.buffer_length), input.buffer, input.buffer_length);
+    return;
+  }
+
+  uint8_t * header = output_buffer.append(kEncapsulationSize);
+  header[0] = 0;
+  header[1] = encapsulation.xcdr2 ?
+    (encapsulation.big_endian ? kPlainCdr2BigEndian : kPlainCdr2LittleEndian) :
+    (encapsulation.big_endian ? kCdrBigEndian : kCdrLittleEndian);
+  header[2] = 0;
+  header[3] = 0;
+  InputCursor input_cursor(input, input_encapsulation);
+  transcode_members(
+    static_cast<const MessageMembers *>(introspection_type_support_->data),
+    input_cursor, output_buffer, input_encapsulation.big_endian != encapsulation.big_endian);
+  if (encapsulation.xcdr2) {
+    // XCDR2 messages are padded to 4 bytes, with the padding in the options of the header
+    const size_t padding = (4 - output_buffer.position() % 4) % 4;
+    if (padding > 0) {
+      std::memset(output_buffer.append(padding), 0, padding);
+      output.buffer[3] = static_cast<uint8_t>(padding);
+    }
+  }
+}
+
+}  // namespace rosbag2_cpp
@@ -0,0 +1,208 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "rcpputils/thread_safety_annotations.hpp"
+#include "rcpputils/unique_lock.hpp"
+#include "rosbag2_cpp/clocks/external_step_clock.hpp"
+
+namespace rosbag2_cpp
+{
+
+class ExternalStepClockImpl
+{
+public:
+  ExternalStepClockImpl(
+    rcutils_time_point_value_t starting_time,
+    std::chrono::milliseconds sleep_time_while_waiting,
+    bool start_paused)
+  : sleep_time_while_waiting(sleep_time_while_waiting),
+    time(starting_time),
+    paused(start_paused)
+  {}
+
+  /**
+   * Call the step completed callback if a step is pending.
+   * The lock is released during the callback, so that it may wait for steps to be published
+   * while new steps arrive.
+   */
+  bool complete_step(rcpputils::unique_lock<std::mutex> & lock)
+  RCPPUTILS_TSA_REQUIRES(state_mutex)
+  {
+    if (completed_steps == steps) {
+      return false;
+    }
+    completed_steps = steps;
+    const auto completed_time = time;
+    auto callback = step_completed_callback;
+    if (callback) {
+      lock.unlock();
+      callback(completed_time);
+      lock.lock();
+    }
+    return true;
+  }
+
+  const std::chrono::milliseconds sleep_time_while_waiting;
+
+  std::mutex state_mutex;
+  std::condition_variable cv RCPPUTILS_TSA_GUARDED_BY(state_mutex);
+  rcutils_time_point_value_t time RCPPUTILS_TSA_GUARDED_BY(state_mutex);
+  bool paused RCPPUTILS_TSA_GUARDED_BY(state_mutex);
+  double rate RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 1.0;
+  uint64_t steps RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 0;
+  uint64_t completed_steps RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 0;
+  uint64_t jumps RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 0;
+  ExternalStepClock::StepCompletedCallback step_completed_callback
+  RCPPUTILS_TSA_GUARDED_BY(state_mutex);
+};
+
+ExternalStepClock::ExternalStepClock(
+  rcutils_time_point_value_t starting_time,
+  std::chrono::milliseconds sleep_time_while_waiting,
+  bool start_paused)
+: impl_(std::make_unique<ExternalStepClockImpl>(
+      starting_time, sleep_time_while_waiting, start_paused))
+{}
+
+ExternalStepClock::~ExternalStepClock()
+{}
+
+void ExternalStepClock::step(rcutils_time_point_value_t time_point)
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  impl_->time = std::max(impl_->time, time_point);
+  ++impl_->steps;
+  impl_->cv.notify_all();
+}
+
+void ExternalStepClock::set_step_completed_callback(StepCompletedCallback callback)
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  impl_->step_completed_callback = std::move(callback);
+}
+
+bool ExternalStepClock::complete_step()
+{
+  rcpputils::unique_lock<std::mutex> lock(impl_->state_mutex);
+  return impl_->complete_step(lock);
+}
+
+rcutils_time_point_value_t ExternalStepClock::now() const
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  return impl_->time;
+}
+
+std::chrono::steady_clock::time_point
+ExternalStepClock::ros_to_steady(rcutils_time_point_value_t /* ros_time */) const
+{
+  return std::chrono::steady_clock::now();
+}
+
+bool ExternalStepClock::sleep_until(rcutils_time_point_value_t until)
+{
+  rcpputils::unique_lock<std::mutex> lock(impl_->state_mutex);
+  if (impl_->paused) {
+    impl_->cv.wait_for(lock, impl_->sleep_time_while_waiting);
+    return false;
+  }
+  if (until <= impl_->time) {
+    return true;
+  }
+  // Everything up to the time of the last step was played
+  impl_->complete_step(lock);
+  // Steps arriving during the callback are pending already, and are completed by the next call
+  // if they don't reach until
+  const auto jumps = impl_->jumps;
+  impl_->cv.wait_for(
+    lock, impl_->sleep_time_while_waiting, [this, jumps]() {
+      return impl_->steps != impl_->completed_steps || impl_->paused || impl_->jumps != jumps;
+    });
+  return !impl_->paused && until <= impl_->time;
+}
+
+bool ExternalStepClock::sleep_until(rclcpp::Time until)
+{
+  return sleep_until(until.nanoseconds());
+}
+
+bool ExternalStepClock::set_rate(double rate)
+{
+  if (!(rate > 0)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  impl_->rate = rate;
+  return true;
+}
+
+double ExternalStepClock::get_rate() const
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  return impl_->rate;
+}
+
+void ExternalStepClock::pause()
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  if (!impl_->paused) {
+    impl_->paused = true;
+    impl_->cv.notify_all();
+  }
+}
+
+void ExternalStepClock::resume()
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  if (impl_->paused) {
+    impl_->paused = false;
+    impl_->cv.notify_all();
+  }
+}
+
+bool ExternalStepClock::is_paused() const
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  return impl_->paused;
+}
+
+void ExternalStepClock::jump(rcutils_time_point_value_t ros_time)
+{
+  std::lock_guard<std::mutex> lock(impl_->state_mutex);
+  impl_->time = ros_time;
+  ++impl_->jumps;
+  impl_->cv.notify_all();
+}
+
+void ExternalStepClock::jump(rclcpp::Time ros_time)
+{
+  jump(ros_time.nanoseconds());
+}
+
+rclcpp::JumpHandler::SharedPtr ExternalStepClock::create_jump_callback(
+  rclcpp::JumpHandler::pre_callback_t /* pre_callback */,
+  rclcpp::JumpHandler::post_callback_t /* post_callback */,
+  const rcl_jump_threshold_t & /* threshold */)
+{
+  return nullptr;
+}
+
+}  // namespace rosbag2_cpp
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -43,9 +44,11 @@ public:
   explicit TimeControllerClockImpl(
     PlayerClock::NowFunction now_fn,
     std::chrono::milliseconds sleep_time_while_paused,
-    bool start_paused)
+    bool start_paused,
+    std::chrono::nanoseconds spin_duration)
   : now_fn(now_fn),
     sleep_time_while_paused(sleep_time_while_paused),
+    spin_duration(spin_duration),
     paused(start_paused)
   {}
   virtual ~TimeControllerClockImpl() = default;
@@ -90,6 +93,7 @@ public:
   {
     reference.ros = ros_time;
     reference.steady = now_fn();
+    ++reference_version;
   }
 
   /**
@@ -116,22 +120,49 @@ public:
     cv.notify_all();
   }
 
+  /**
+   * Sleep until spin_duration before steady_until, then spin until steady_until unless the
+   * sleep was interrupted or the reference changed meanwhile.
+   */
+  void wait_until_precisely(
+    rcpputils::unique_lock<std::mutex> & lock, std::chrono::steady_clock::time_point steady_until)
+  RCPPUTILS_TSA_REQUIRES(state_mutex)
+  {
+    const auto version = reference_version;
+    const auto spin_from = steady_until - spin_duration;
+    cv.wait_until(lock, spin_from);
+    while (reference_version == version && !paused) {
+      const auto steady_now = now_fn();
+      if (steady_now < spin_from || steady_now >= steady_until) {
+        break;
+      }
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+    }
+  }
+
   const PlayerClock::NowFunction now_fn;
   const std::chrono::milliseconds sleep_time_while_paused;
+  const std::chrono::nanoseconds spin_duration;
 
   std::mutex state_mutex;
   std::condition_variable cv RCPPUTILS_TSA_GUARDED_BY(state_mutex);
   double rate RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 1.0;
   bool paused RCPPUTILS_TSA_GUARDED_BY(state_mutex) = false;
   TimeReference reference RCPPUTILS_TSA_GUARDED_BY(state_mutex);
+  // Incremented by every snapshot, which changes the steady time of ROS times
+  uint64_t reference_version RCPPUTILS_TSA_GUARDED_BY(state_mutex) = 0;
 };
 
 TimeControllerClock::TimeControllerClock(
   rcutils_time_point_value_t starting_time,
   NowFunction now_fn,
   std::chrono::milliseconds sleep_time_while_paused,
-  bool paused)
-: impl_(std::make_unique<TimeControllerClockImpl>(now_fn, sleep_time_while_paused, paused))
+  bool paused,
+  std::chrono::nanoseconds spin_duration)
+: impl_(std::make_unique<TimeControllerClockImpl>(
+      now_fn, sleep_time_while_paused, paused, spin_duration))
 {
   if (now_fn == nullptr) {
     throw std::invalid_argument("TimeControllerClock now_fn must be non-empty.");
@@ -162,13 +193,19 @@ TimeControllerClock::ros_to_steady(rcutils_time_point_value_t ros_time) const
 
 bool TimeControllerClock::sleep_until(rcutils_time_point_value_t until)
 {
+  bool reverse = false;
   {
     rcpputils::unique_lock<std::mutex> lock(impl_->state_mutex);
+    reverse = impl_->rate < 0;
     if (impl_->paused) {
       impl_->cv.wait_for(lock, impl_->sleep_time_while_paused);
     } else {
       const auto steady_until = impl_->ros_to_steady(until);
-      impl_->cv.wait_until(lock, steady_until);
+      if (impl_->spin_duration > std::chrono::nanoseconds{0}) {
+        impl_->wait_until_precisely(lock, steady_until);
+      } else {
+        impl_->cv.wait_until(lock, steady_until);
+      }
     }
     if (impl_->paused) {
       // Don't allow publishing any messages while paused
@@ -176,7 +213,8 @@ bool TimeControllerClock::sleep_until(rcutils_time_point_value_t until)
       return false;
     }
   }
-  return now() >= until;
+  // With a negative rate, the time runs backwards towards until
+  return reverse ? now() <= until : now() >= until;
 }
 
 bool TimeControllerClock::sleep_until(rclcpp::Time until)
@@ -186,7 +224,7 @@ bool TimeControllerClock::sleep_until(rclcpp::Time until)
 
 bool TimeControllerClock::set_rate(double rate)
 {
-  if (rate <= 0) {
+  if (rate == 0 || std::isnan(rate)) {
     return false;
   }
   std::lock_guard<std::mutex> lock(impl_->state_mutex);
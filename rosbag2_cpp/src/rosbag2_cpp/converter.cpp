@@ -14,12 +14,15 @@
 
 #include "rosbag2_cpp/converter.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "rmw/rmw.h"
+
 #include "rosbag2_cpp/info.hpp"
 #include "rosbag2_cpp/typesupport_helpers.hpp"
 
@@ -30,6 +33,24 @@
 namespace rosbag2_cpp
 {
 
+namespace
+{
+// Introspection message referring to the message of typed operations, which keep owning it
+std::shared_ptr<rosbag2_introspection_message_t> wrap_typed_message(
+  TypedMessageOperations & typed_operations, const rcutils_allocator_t & allocator)
+{
+  auto wrapper = new rosbag2_introspection_message_t();
+  wrapper->allocator = allocator;
+  wrapper->topic_name = nullptr;
+  wrapper->message = typed_operations.message();
+  return std::shared_ptr<rosbag2_introspection_message_t>(
+    wrapper, [](rosbag2_introspection_message_t * msg) {
+      msg->allocator.deallocate(msg->topic_name, msg->allocator.state);
+      delete msg;
+    });
+}
+}  // namespace
+
 Converter::Converter(
   const std::string & input_format,
   const std::string & output_format,
@@ -41,11 +62,23 @@ Converter::Converter(
   const ConverterOptions & converter_options,
   std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory)
 : converter_factory_(converter_factory),
-  input_converter_(converter_factory_->load_deserializer(
-      converter_options.input_serialization_format)),
-  output_converter_(converter_factory_->load_serializer(
-      converter_options.output_serialization_format))
+  input_format_(converter_options.input_serialization_format),
+  output_format_(converter_options.output_serialization_format)
 {
+  if (CdrTranscoder::encapsulation_of_format(input_format_)) {
+    output_encapsulation_ = CdrTranscoder::encapsulation_of_format(output_format_);
+  }
+  if (output_encapsulation_) {
+    // Only needed for types which can not be transcoded, which the rmw implementation
+    // deserializes in any CDR encoding but serializes in its own only
+    input_converter_ = converter_factory_->load_deserializer("cdr");
+    if (output_format_ == "cdr") {
+      output_converter_ = converter_factory_->load_serializer("cdr");
+    }
+    return;
+  }
+  input_converter_ = converter_factory_->load_deserializer(input_format_);
+  output_converter_ = converter_factory_->load_serializer(output_format_);
   if (!input_converter_) {
     throw std::runtime_error(
             "Could not find converter for format " + converter_options.input_serialization_format);
@@ -66,23 +99,71 @@ Converter::~Converter()
 std::shared_ptr<rosbag2_storage::SerializedBagMessage> Converter::convert(
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
-  auto introspection_ts = topics_and_types_.at(message->topic_name).introspection_type_support;
-  auto allocator = rcutils_get_default_allocator();
-  std::shared_ptr<rosbag2_introspection_message_t> allocated_ros_message =
-    allocate_introspection_message(introspection_ts, &allocator);
+  auto & type_support = topics_and_types_.at(message->topic_name);
+  if (type_support.transcoder) {
+    return transcode(type_support, message);
+  }
+  auto introspection_ts = type_support.introspection_type_support;
+  if (!type_support.introspection_message) {
+    auto allocator = message_arena_.get_allocator();
+    type_support.introspection_message = type_support.typed_operations ?
+      wrap_typed_message(*type_support.typed_operations, allocator) :
+      allocate_introspection_message(introspection_ts, &allocator);
+    rosbag2_cpp::introspection_message_set_topic_name(
+      type_support.introspection_message.get(), message->topic_name.c_str());
+  }
+  // Deserializing overwrites all members of the previous message of the topic,
+  // but keeps the capacity of its sequences and strings
+  auto & allocated_ros_message = type_support.introspection_message;
   auto output_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
 
   // deserialize
-  rosbag2_cpp::introspection_message_set_topic_name(
-    allocated_ros_message.get(), message->topic_name.c_str());
   allocated_ros_message->time_stamp = message->time_stamp;
-  input_converter_->deserialize(message, introspection_ts, allocated_ros_message);
+  if (type_support.typed_input) {
+    type_support.typed_operations->deserialize(*message->serialized_data);
+  } else {
+    input_converter_->deserialize(message, introspection_ts, allocated_ros_message);
+  }
 
   // re-serialize
-  output_message->serialized_data = rosbag2_storage::make_empty_serialized_message(0);
-  output_message->topic_name = std::string(allocated_ros_message->topic_name);
+  output_message->serialized_data =
+    rosbag2_storage::make_empty_serialized_message(type_support.last_serialized_size);
+  output_message->topic_name = message->topic_name;
+  output_message->interned_topic = message->interned_topic;
   output_message->time_stamp = allocated_ros_message->time_stamp;
-  output_converter_->serialize(allocated_ros_message, introspection_ts, output_message);
+  output_message->topic_id = message->topic_id;
+  output_message->send_timestamp = message->send_timestamp;
+  output_message->sequence_number = message->sequence_number;
+  if (type_support.typed_output) {
+    type_support.typed_operations->serialize(*output_message->serialized_data);
+  } else {
+    output_converter_->serialize(allocated_ros_message, introspection_ts, output_message);
+  }
+  if (output_message->serialized_data) {
+    type_support.last_serialized_size = output_message->serialized_data->buffer_length;
+  }
+  return output_message;
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> Converter::transcode(
+  ConverterTypeSupport & type_support,
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  auto output_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  output_message->topic_name = message->topic_name;
+  output_message->interned_topic = message->interned_topic;
+  output_message->time_stamp = message->time_stamp;
+  output_message->topic_id = message->topic_id;
+  output_message->send_timestamp = message->send_timestamp;
+  output_message->sequence_number = message->sequence_number;
+  if (!message->serialized_data) {
+    return output_message;
+  }
+  output_message->serialized_data = rosbag2_storage::make_empty_serialized_message(
+    std::max(type_support.last_serialized_size, message->serialized_data->buffer_length));
+  type_support.transcoder->transcode(
+    *message->serialized_data, *output_encapsulation_, *output_message->serialized_data);
+  type_support.last_serialized_size = output_message->serialized_data->buffer_length;
   return output_message;
 }
 
@@ -102,6 +183,28 @@ void Converter::add_topic(const std::string & topic, const std::string & type)
     type, "rosidl_typesupport_introspection_cpp",
     type_support.introspection_type_support_library);
 
+  if (output_encapsulation_) {
+    try {
+      type_support.transcoder =
+        std::make_shared<CdrTranscoder>(type_support.introspection_type_support);
+    } catch (const std::invalid_argument & e) {
+      if (!input_converter_ || !output_converter_) {
+        throw std::runtime_error(
+                "Messages of topic " + topic + " can not be converted to " + output_format_ +
+                ": " + e.what());
+      }
+    }
+  }
+  if (!type_support.transcoder) {
+    auto typed_operations = TypedFastPathRegistry::instance().make_operations(type);
+    const std::string rmw_format = rmw_get_serialization_format();
+    type_support.typed_input = typed_operations && input_format_ == rmw_format;
+    type_support.typed_output = typed_operations && output_format_ == rmw_format;
+    if (type_support.typed_input || type_support.typed_output) {
+      type_support.typed_operations = std::move(typed_operations);
+    }
+  }
+
   topics_and_types_.insert({topic, type_support});
 }
 
@@ -0,0 +1,271 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/field_extractor.hpp"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/shared_library.hpp"
+#include "rcpputils/split.hpp"
+
+#include "rmw/rmw.h"
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+#include "rosidl_typesupport_introspection_cpp/message_introspection.hpp"
+
+#include "rosbag2_cpp/converter_interfaces/serialization_format_converter.hpp"
+#include "rosbag2_cpp/typed_fast_paths.hpp"
+#include "rosbag2_cpp/types/introspection_message.hpp"
+#include "rosbag2_cpp/typesupport_helpers.hpp"
+
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+using rosidl_typesupport_introspection_cpp::MessageMembers;
+
+struct ResolvedField
+{
+  size_t offset = 0;
+  uint8_t type_id = 0;
+  size_t size = 0;
+};
+
+ResolvedField resolve_field(
+  const std::string & type, const MessageMembers * members, const std::string & field_path)
+{
+  ResolvedField field;
+  const auto names = rcpputils::split(field_path, '.');
+  if (names.empty()) {
+    throw std::invalid_argument("Empty field path for type " + type);
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    const rosidl_typesupport_introspection_cpp::MessageMember * member = nullptr;
+    for (uint32_t j = 0; j < members->member_count_; ++j) {
+      if (names[i] == members->members_[j].name_) {
+        member = &members->members_[j];
+        break;
+      }
+    }
+    if (!member) {
+      throw std::invalid_argument(
+              "Type " + type + " has no field '" + field_path + "': no member '" + names[i] + "'");
+    }
+    if (member->is_array_) {
+      throw std::invalid_argument(
+              "Field '" + field_path + "' of type " + type +
+              " is an array, which is not supported");
+    }
+    field.offset += member->offset_;
+    const bool last = i + 1 == names.size();
+    if (member->type_id_ == rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE) {
+      if (last) {
+        throw std::invalid_argument(
+                "Field '" + field_path + "' of type " + type + " is a message, not a primitive");
+      }
+      members = static_cast<const MessageMembers *>(member->members_->data);
+      continue;
+    }
+    if (!last) {
+      throw std::invalid_argument(
+              "Type " + type + " has no field '" + field_path + "': '" + names[i] +
+              "' is not a message");
+    }
+    field.type_id = member->type_id_;
+    field.size = FieldExtractor::field_type_size(field.type_id);
+    if (field.size == 0) {
+      throw std::invalid_argument(
+              "Field '" + field_path + "' of type " + type +
+              " is not of a supported primitive type");
+    }
+  }
+  return field;
+}
+
+void collect_primitive_field_paths(
+  const MessageMembers * members, const std::string & prefix, std::vector<std::string> & paths)
+{
+  for (uint32_t i = 0; i < members->member_count_; ++i) {
+    const auto & member = members->members_[i];
+    if (member.is_array_) {
+      continue;
+    }
+    const std::string path = prefix + member.name_;
+    if (member.type_id_ == rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE) {
+      collect_primitive_field_paths(
+        static_cast<const MessageMembers *>(member.members_->data), path + ".", paths);
+    } else if (FieldExtractor::field_type_size(member.type_id_) > 0) {
+      paths.push_back(path);
+    }
+  }
+}
+}  // namespace
+
+class FieldExtractorImpl
+{
+public:
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory;
+  std::unique_ptr<converter_interfaces::SerializationFormatDeserializer> deserializer;
+  std::shared_ptr<rcpputils::SharedLibrary> introspection_library;
+  const rosidl_message_type_support_t * introspection_ts = nullptr;
+  std::shared_ptr<rosbag2_introspection_message_t> message;
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> serialized_message;
+  // Operations registered in TypedFastPathRegistry, used instead of the deserializer
+  std::unique_ptr<TypedMessageOperations> typed_operations;
+  std::vector<std::string> field_paths;
+  std::vector<uint8_t> field_types;
+  std::vector<ResolvedField> fields;
+
+  ~FieldExtractorImpl()
+  {
+    message.reset();
+    typed_operations.reset();
+    deserializer.reset();
+    converter_factory.reset();  // needs to be destroyed only after the deserializer
+  }
+};
+
+FieldExtractor::FieldExtractor(
+  const std::string & type,
+  const std::vector<std::string> & field_paths,
+  const std::string & serialization_format,
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory)
+: impl_(std::make_unique<FieldExtractorImpl>())
+{
+  impl_->converter_factory = converter_factory;
+  if (serialization_format == rmw_get_serialization_format()) {
+    impl_->typed_operations = TypedFastPathRegistry::instance().make_operations(type);
+  }
+  if (!impl_->typed_operations) {
+    impl_->deserializer = converter_factory->load_deserializer(serialization_format);
+    if (!impl_->deserializer) {
+      throw std::runtime_error("Could not find converter for format " + serialization_format);
+    }
+  }
+  impl_->introspection_library = get_typesupport_library(
+    type, "rosidl_typesupport_introspection_cpp");
+  impl_->introspection_ts = get_typesupport_handle(
+    type, "rosidl_typesupport_introspection_cpp", impl_->introspection_library);
+
+  const auto members = static_cast<const MessageMembers *>(impl_->introspection_ts->data);
+  impl_->field_paths = field_paths;
+  for (const auto & field_path : field_paths) {
+    impl_->fields.push_back(resolve_field(type, members, field_path));
+    impl_->field_types.push_back(impl_->fields.back().type_id);
+  }
+
+  if (impl_->typed_operations) {
+    return;
+  }
+  auto allocator = rcutils_get_default_allocator();
+  impl_->message = allocate_introspection_message(impl_->introspection_ts, &allocator);
+  impl_->serialized_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+}
+
+FieldExtractor::~FieldExtractor() = default;
+
+const std::vector<std::string> & FieldExtractor::field_paths() const
+{
+  return impl_->field_paths;
+}
+
+const std::vector<uint8_t> & FieldExtractor::field_types() const
+{
+  return impl_->field_types;
+}
+
+size_t FieldExtractor::field_type_size(uint8_t type_id)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  switch (type_id) {
+    case ts::ROS_TYPE_FLOAT:
+      return sizeof(float);
+    case ts::ROS_TYPE_DOUBLE:
+      return sizeof(double);
+    case ts::ROS_TYPE_CHAR:
+    case ts::ROS_TYPE_OCTET:
+    case ts::ROS_TYPE_UINT8:
+    case ts::ROS_TYPE_INT8:
+      return 1;
+    case ts::ROS_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case ts::ROS_TYPE_WCHAR:
+    case ts::ROS_TYPE_UINT16:
+    case ts::ROS_TYPE_INT16:
+      return 2;
+    case ts::ROS_TYPE_UINT32:
+    case ts::ROS_TYPE_INT32:
+      return 4;
+    case ts::ROS_TYPE_UINT64:
+    case ts::ROS_TYPE_INT64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+std::vector<std::string> FieldExtractor::primitive_field_paths(const std::string & type)
+{
+  auto library = get_typesupport_library(type, "rosidl_typesupport_introspection_cpp");
+  const auto introspection_ts = get_typesupport_handle(
+    type, "rosidl_typesupport_introspection_cpp", library);
+  std::vector<std::string> paths;
+  collect_primitive_field_paths(
+    static_cast<const MessageMembers *>(introspection_ts->data), "", paths);
+  return paths;
+}
+
+void FieldExtractor::extract(
+  const rcutils_uint8_array_t & serialized_data,
+  const std::vector<void *> & columns,
+  size_t row)
+{
+  if (columns.size() != impl_->fields.size()) {
+    throw std::invalid_argument(
+            "Expected " + std::to_string(impl_->fields.size()) + " columns, got " +
+            std::to_string(columns.size()));
+  }
+  const uint8_t * message = nullptr;
+  if (impl_->typed_operations) {
+    // The C++ message is laid out as described by the introspection type support
+    impl_->typed_operations->deserialize(serialized_data);
+    message = static_cast<const uint8_t *>(impl_->typed_operations->message());
+  } else {
+    // Refer to the data without copying it; it is only used during deserialization
+    impl_->serialized_message->serialized_data = std::shared_ptr<rcutils_uint8_array_t>(
+      std::shared_ptr<rcutils_uint8_array_t>{},
+      const_cast<rcutils_uint8_array_t *>(&serialized_data));
+    // Deserializing overwrites all members of the previous message,
+    // but keeps the capacity of its sequences and strings
+    impl_->deserializer->deserialize(
+      impl_->serialized_message, impl_->introspection_ts, impl_->message);
+    impl_->serialized_message->serialized_data.reset();
+    message = static_cast<const uint8_t *>(impl_->message->message);
+  }
+  for (size_t i = 0; i < impl_->fields.size(); ++i) {
+    const auto & field = impl_->fields[i];
+    std::memcpy(
+      static_cast<uint8_t *>(columns[i]) + row * field.size, message + field.offset, field.size);
+  }
+}
+
+}  // namespace rosbag2_cpp
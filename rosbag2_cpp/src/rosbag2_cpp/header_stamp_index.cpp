@@ -0,0 +1,189 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/header_stamp_index.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/field_extractor.hpp"
+#include "rosbag2_cpp/logging.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+constexpr size_t kBuildBatchSize = 1000;
+}  // namespace
+
+void HeaderStampIndex::add_message(
+  const std::string & topic_name,
+  rcutils_time_point_value_t received_time_stamp,
+  rcutils_time_point_value_t header_time_stamp)
+{
+  auto & entries = topics_[topic_name];
+  if (!entries.empty() && received_time_stamp < entries.back().received_time_stamp) {
+    throw std::runtime_error(
+            "Messages of topic " + topic_name + " are not indexed in order of received time");
+  }
+  entries.push_back({received_time_stamp, header_time_stamp});
+  ++size_;
+}
+
+const std::map<std::string, std::vector<HeaderStampIndex::Entry>> &
+HeaderStampIndex::topics() const
+{
+  return topics_;
+}
+
+size_t HeaderStampIndex::size() const
+{
+  return size_;
+}
+
+HeaderStampIndex HeaderStampIndex::build(
+  reader_interfaces::BaseReaderInterface & reader,
+  const std::string & stamp_field,
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory)
+{
+  if (!reader.set_read_order(rosbag2_storage::ReadOrder())) {
+    throw std::runtime_error("The bag can not be read in order of received time stamps");
+  }
+  reader.reset_filter();
+  reader.seek(0);
+
+  // Topics without an extractor are indexed with their received time stamps
+  std::map<std::string, std::unique_ptr<FieldExtractor>> extractors;
+  for (const auto & topic : reader.get_all_topics_and_types()) {
+    try {
+      extractors[topic.name] = std::make_unique<FieldExtractor>(
+        topic.type, std::vector<std::string>{stamp_field + ".sec", stamp_field + ".nanosec"},
+        topic.serialization_format, converter_factory);
+    } catch (const std::invalid_argument &) {
+      extractors[topic.name] = nullptr;
+    } catch (const std::runtime_error & e) {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Indexing topic " << topic.name << " by received time stamps: " << e.what());
+      extractors[topic.name] = nullptr;
+    }
+  }
+
+  HeaderStampIndex index;
+  int32_t sec = 0;
+  uint32_t nanosec = 0;
+  const std::vector<void *> columns{&sec, &nanosec};
+  for (auto batch = reader.read_next_batch(kBuildBatchSize); !batch.empty();
+    batch = reader.read_next_batch(kBuildBatchSize))
+  {
+    for (const auto & message : batch) {
+      auto extractor = extractors.find(message->topic_name);
+      rcutils_time_point_value_t header_time_stamp = message->time_stamp;
+      if (extractor != extractors.end() && extractor->second && message->serialized_data) {
+        extractor->second->extract(*message->serialized_data, columns, 0);
+        header_time_stamp = RCUTILS_S_TO_NS(static_cast<rcutils_time_point_value_t>(sec)) +
+          static_cast<rcutils_time_point_value_t>(nanosec);
+      }
+      index.add_message(message->topic_name, message->time_stamp, header_time_stamp);
+    }
+  }
+  return index;
+}
+
+bool HeaderStampIndex::exists(const std::string & bag_directory)
+{
+  std::error_code error;
+  return std::filesystem::is_regular_file(
+    std::filesystem::path(bag_directory) / kFileName, error);
+}
+
+void HeaderStampIndex::write(const std::string & bag_directory) const
+{
+  // Written to a file of its own first, so that readers never read it incomplete
+  const auto path = (std::filesystem::path(bag_directory) / kFileName).string();
+  const std::string temporary_path = path + "." + std::to_string(
+    std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+  std::error_code error;
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    file << serialize();
+    if (!file.good()) {
+      file.close();
+      std::filesystem::remove(temporary_path, error);
+      throw std::runtime_error("Failed to write header stamp index " + path);
+    }
+  }
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    throw std::runtime_error("Failed to write header stamp index " + path);
+  }
+}
+
+HeaderStampIndex HeaderStampIndex::read(const std::string & bag_directory)
+{
+  const auto path = (std::filesystem::path(bag_directory) / kFileName).string();
+  std::ifstream file{path, std::ios::binary};
+  if (!file.good()) {
+    throw std::runtime_error("No header stamp index " + path);
+  }
+  return deserialize(std::string(std::istreambuf_iterator<char>(file), {}));
+}
+
+std::string HeaderStampIndex::serialize() const
+{
+  std::stringstream out;
+  for (const auto & [topic_name, entries] : topics_) {
+    out << "topic " << topic_name << " " << entries.size() << "\n";
+    for (const auto & entry : entries) {
+      out << entry.received_time_stamp << " " << entry.header_time_stamp << "\n";
+    }
+  }
+  return out.str();
+}
+
+HeaderStampIndex HeaderStampIndex::deserialize(const std::string & serialized_index)
+{
+  HeaderStampIndex index;
+  std::istringstream in(serialized_index);
+  std::string keyword;
+  while (in >> keyword) {
+    std::string topic_name;
+    size_t count = 0;
+    if (keyword != "topic" || !(in >> topic_name >> count)) {
+      throw std::runtime_error("Malformed header stamp index");
+    }
+    for (size_t i = 0; i < count; ++i) {
+      Entry entry{};
+      if (!(in >> entry.received_time_stamp >> entry.header_time_stamp)) {
+        throw std::runtime_error("Malformed header stamp index");
+      }
+      index.add_message(topic_name, entry.received_time_stamp, entry.header_time_stamp);
+    }
+  }
+  return index;
+}
+
+}  // namespace rosbag2_cpp
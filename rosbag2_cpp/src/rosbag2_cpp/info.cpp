@@ -14,21 +14,82 @@
 
 #include "rosbag2_cpp/info.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
+#include "rosbag2_cpp/reindexer.hpp"
 #include "rosbag2_storage/logging.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_factory_interface.hpp"
+#include "rosbag2_storage/storage_options.hpp"
 
 namespace rosbag2_cpp
 {
 
-rosbag2_storage::BagMetadata Info::read_metadata(
-  const std::string & uri, const std::string & storage_id)
+namespace
+{
+// Time range and size of a bag file
+struct FileExtent
+{
+  std::string path;
+  rcutils_time_point_value_t start;
+  rcutils_time_point_value_t end;
+  double bytes;
+};
+
+// Bytes of the messages up to and including time, assuming they are spread evenly over the time
+// range of their file
+double bytes_until(const std::vector<FileExtent> & files, rcutils_time_point_value_t time)
+{
+  double bytes = 0.0;
+  for (const auto & file : files) {
+    if (time >= file.end) {
+      bytes += file.bytes;
+    } else if (time >= file.start) {
+      bytes += file.bytes * static_cast<double>(time - file.start + 1) /
+        static_cast<double>(file.end - file.start + 1);
+    }
+  }
+  return bytes;
+}
+
+// Storage factory handing out the storages of a factory owned elsewhere, to share its plugin
+// loaders with the Reindexer
+class SharedStorageFactory : public rosbag2_storage::StorageFactoryInterface
+{
+public:
+  explicit SharedStorageFactory(rosbag2_storage::StorageFactoryInterface & factory)
+  : factory_(factory)
+  {}
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface>
+  open_read_only(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    return factory_.open_read_only(storage_options);
+  }
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+  open_read_write(const rosbag2_storage::StorageOptions & storage_options) override
+  {
+    return factory_.open_read_write(storage_options);
+  }
+
+private:
+  rosbag2_storage::StorageFactoryInterface & factory_;
+};
+
+rosbag2_storage::BagMetadata read_bag_metadata(
+  const std::string & uri, const std::string & storage_id,
+  rosbag2_storage::StorageFactoryInterface & factory)
 {
   const rcpputils::fs::path bag_path{uri};
   if (!bag_path.exists()) {
@@ -40,16 +101,164 @@ rosbag2_storage::BagMetadata Info::read_metadata(
     return metadata_io.read_metadata(uri);
   }
 
+  // Only the metadata stored in the bag files is read, bag files are not scanned message by
+  // message if their storage plugin could not store their metadata
+  rosbag2_storage::StorageOptions storage_options{uri, storage_id};
+  storage_options.metadata_only = true;
+
   if (bag_path.is_directory()) {
-    throw std::runtime_error("Could not find metadata in bag directory " + uri);
+    try {
+      return Reindexer(std::make_unique<SharedStorageFactory>(factory))
+             .reconstruct_metadata(storage_options);
+    } catch (const std::exception & e) {
+      throw std::runtime_error(
+              "Could not find metadata in bag directory " + uri +
+              " and could not reconstruct it from the bag files: " + e.what());
+    }
   }
 
-  rosbag2_storage::StorageFactory factory;
-  auto storage = factory.open_read_only({uri, storage_id});
+  auto storage = factory.open_read_only(storage_options);
   if (!storage) {
     throw std::runtime_error("No plugin detected that could open file " + uri);
   }
   return storage->get_metadata();
 }
+}  // namespace
+
+rosbag2_storage::BagMetadata Info::read_metadata(
+  const std::string & uri, const std::string & storage_id)
+{
+  rosbag2_storage::StorageFactory factory;
+  return read_bag_metadata(uri, storage_id, factory);
+}
+
+std::vector<rosbag2_storage::BagMetadata> Info::read_metadata_many(
+  const std::vector<std::string> & uris, size_t threads, const std::string & storage_id)
+{
+  rosbag2_storage::StorageFactory factory;
+  std::vector<rosbag2_storage::BagMetadata> metadata(uris.size());
+  std::vector<std::exception_ptr> errors(uris.size());
+  std::atomic_size_t next_bag{0};
+  auto worker = [&]() {
+      for (size_t i = next_bag++; i < uris.size(); i = next_bag++) {
+        try {
+          metadata[i] = read_bag_metadata(uris[i], storage_id, factory);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    };
+
+  const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t thread_count = std::min(threads > 0 ? threads : hardware_threads, uris.size());
+  std::vector<std::thread> thread_pool;
+  for (size_t i = 1; i < thread_count; i++) {
+    thread_pool.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : thread_pool) {
+    thread.join();
+  }
+
+  for (const auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return metadata;
+}
+
+std::vector<TimeShard> Info::split_into_time_shards(
+  const std::string & uri, size_t shard_count, const std::string & storage_id)
+{
+  if (shard_count == 0) {
+    throw std::invalid_argument("A bag can not be split into 0 shards");
+  }
+  const auto metadata = read_metadata(uri, storage_id);
+  if (metadata.message_count == 0) {
+    return {};
+  }
+
+  const rcpputils::fs::path bag_path{uri};
+  const auto file_bytes = [&bag_path](const std::string & path) {
+      auto file_path = bag_path;
+      if (bag_path.is_directory()) {
+        file_path = bag_path / rcpputils::fs::path(path).filename();
+      }
+      return file_path.exists() ? static_cast<double>(file_path.file_size()) : 0.0;
+    };
+  std::vector<FileExtent> files;
+  for (const auto & file : metadata.files) {
+    const auto start = file.starting_time.time_since_epoch().count();
+    files.push_back({file.path, start, start + file.duration.count(), file_bytes(file.path)});
+  }
+  if (files.empty()) {
+    // Metadata without the time ranges of the files, every file is assumed to cover the bag
+    const auto start = metadata.starting_time.time_since_epoch().count();
+    for (const auto & path : metadata.relative_file_paths) {
+      files.push_back({path, start, start + metadata.duration.count(), file_bytes(path)});
+    }
+  }
+  if (files.empty()) {
+    return {};
+  }
+  rcutils_time_point_value_t bag_start = files.front().start;
+  rcutils_time_point_value_t bag_end = files.front().end;
+  for (const auto & file : files) {
+    bag_start = std::min(bag_start, file.start);
+    bag_end = std::max(bag_end, file.end);
+  }
+  const double total_bytes = bytes_until(files, bag_end);
+  if (total_bytes <= 0.0) {
+    // Without file sizes there is nothing to balance, the bag is read as a whole
+    shard_count = 1;
+  }
+
+  // Shard i starts at boundaries[i] and ends before boundaries[i + 1]
+  std::vector<rcutils_time_point_value_t> boundaries{bag_start};
+  for (size_t i = 1; i < shard_count; ++i) {
+    const double target = total_bytes * static_cast<double>(i) / static_cast<double>(shard_count);
+    // First time after which target bytes are reached
+    rcutils_time_point_value_t low = boundaries.back();
+    rcutils_time_point_value_t high = bag_end + 1;
+    while (low < high) {
+      const auto middle = low + (high - low) / 2;
+      if (bytes_until(files, middle) >= target) {
+        high = middle;
+      } else {
+        low = middle + 1;
+      }
+    }
+    if (low + 1 <= bag_end && low + 1 > boundaries.back()) {
+      boundaries.push_back(low + 1);
+    }
+  }
+  boundaries.push_back(bag_end + 1);
+
+  std::vector<TimeShard> shards;
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    TimeShard shard;
+    shard.start_time_ns = boundaries[i];
+    shard.end_time_ns = boundaries[i + 1] - 1;
+    shard.estimated_bytes = static_cast<uint64_t>(
+      bytes_until(files, shard.end_time_ns) - bytes_until(files, shard.start_time_ns - 1));
+    for (const auto & file : files) {
+      if (file.start <= shard.end_time_ns && file.end >= shard.start_time_ns) {
+        shard.files.push_back(file.path);
+      }
+    }
+    shards.push_back(std::move(shard));
+  }
+  return shards;
+}
+
+std::vector<rosbag2_storage::TopicStatistics> Info::read_topic_statistics(const std::string & uri)
+{
+  const rcpputils::fs::path bag_path{uri};
+  if (!bag_path.is_directory()) {
+    return {};
+  }
+  return rosbag2_storage::MetadataIo().read_topic_statistics(uri);
+}
 
 }  // namespace rosbag2_cpp
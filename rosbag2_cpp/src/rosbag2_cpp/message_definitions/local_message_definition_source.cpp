@@ -14,8 +14,13 @@
 
 #include "rosbag2_cpp/message_definitions/local_message_definition_source.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <regex>
 #include <set>
@@ -57,6 +62,9 @@ static const std::regex MSG_FIELD_TYPE_REGEX{R"((?:^|\n)\s*([a-zA-Z0-9_/]+)(?:\[
 static const std::regex IDL_FIELD_TYPE_REGEX{
   R"((?:^|\n)#include\s+(?:"|<)([a-zA-Z0-9_/]+)\.idl(?:"|>))"};
 
+// Match type description hashes which can be part of a file name ("RIHS01_<hex>")
+static const std::regex TYPE_DESCRIPTION_HASH_REGEX{R"(^[a-zA-Z0-9_]+$)"};
+
 static const std::unordered_set<std::string> PRIMITIVE_TYPES{
   "bool", "byte", "char", "float32", "float64", "int8", "uint8",
   "int16", "uint16", "int32", "uint32", "int64", "uint64", "string"};
@@ -151,13 +159,37 @@ LocalMessageDefinitionSource::MessageSpec::MessageSpec(
 {
 }
 
+LocalMessageDefinitionSource::LocalMessageDefinitionSource(
+  std::string cache_directory, size_t number_of_threads)
+: cache_directory_(std::move(cache_directory))
+{
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    threads_.emplace_back(&LocalMessageDefinitionSource::resolve_prefetched_types, this);
+  }
+}
+
+LocalMessageDefinitionSource::~LocalMessageDefinitionSource()
+{
+  {
+    std::lock_guard<std::mutex> lock(resolutions_mutex_);
+    should_exit_ = true;
+  }
+  prefetched_resolution_available_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
 const LocalMessageDefinitionSource::MessageSpec & LocalMessageDefinitionSource::load_message_spec(
   const DefinitionIdentifier & definition_identifier)
 {
-  if (auto it = msg_specs_by_definition_identifier_.find(definition_identifier);
-    it != msg_specs_by_definition_identifier_.end())
   {
-    return it->second;
+    std::lock_guard<std::mutex> lock(msg_specs_mutex_);
+    if (auto it = msg_specs_by_definition_identifier_.find(definition_identifier);
+      it != msg_specs_by_definition_identifier_.end())
+    {
+      return it->second;
+    }
   }
   std::smatch match;
   const auto topic_type = definition_identifier.topic_type();
@@ -173,9 +205,11 @@ const LocalMessageDefinitionSource::MessageSpec & LocalMessageDefinitionSource::
   }
 
   std::string contents{std::istreambuf_iterator(file), {}};
+  MessageSpec loaded_spec(definition_identifier.format(), std::move(contents), package);
+  // Another thread may have loaded the same file meanwhile, the first spec is kept
+  std::lock_guard<std::mutex> lock(msg_specs_mutex_);
   const MessageSpec & spec = msg_specs_by_definition_identifier_.emplace(
-    definition_identifier,
-    MessageSpec(definition_identifier.format(), std::move(contents), package)).first->second;
+    definition_identifier, std::move(loaded_spec)).first->second;
 
   // "References and pointers to data stored in the container are only invalidated by erasing that
   // element, even when the corresponding iterator is invalidated."
@@ -183,6 +217,142 @@ const LocalMessageDefinitionSource::MessageSpec & LocalMessageDefinitionSource::
 }
 
 rosbag2_storage::MessageDefinition LocalMessageDefinitionSource::get_full_text(
+  const std::string & root_topic_type, const std::string & type_description_hash)
+{
+  auto resolution = get_resolution(root_topic_type, type_description_hash).first;
+  // Waits for a thread which is resolving it already
+  std::call_once(resolution->once, [&resolution]() {resolution->task();});
+  return resolution->full_text.get();
+}
+
+void LocalMessageDefinitionSource::prefetch(
+  const std::string & root_topic_type, const std::string & type_description_hash)
+{
+  if (threads_.empty()) {
+    return;
+  }
+  auto [resolution, added] = get_resolution(root_topic_type, type_description_hash);
+  if (added) {
+    {
+      std::lock_guard<std::mutex> lock(resolutions_mutex_);
+      prefetched_resolutions_.push_back(std::move(resolution));
+    }
+    prefetched_resolution_available_.notify_one();
+  }
+}
+
+std::pair<std::shared_ptr<LocalMessageDefinitionSource::Resolution>, bool>
+LocalMessageDefinitionSource::get_resolution(
+  const std::string & root_topic_type, const std::string & type_description_hash)
+{
+  std::lock_guard<std::mutex> lock(resolutions_mutex_);
+  auto & resolution = resolutions_by_topic_type_[root_topic_type];
+  if (resolution) {
+    return {resolution, false};
+  }
+  resolution = std::make_shared<Resolution>();
+  resolution->task = std::packaged_task<rosbag2_storage::MessageDefinition()>(
+    [this, root_topic_type, type_description_hash]() {
+      return resolve_full_text(root_topic_type, type_description_hash);
+    });
+  resolution->full_text = resolution->task.get_future().share();
+  return {resolution, true};
+}
+
+void LocalMessageDefinitionSource::resolve_prefetched_types()
+{
+  std::unique_lock<std::mutex> lock(resolutions_mutex_);
+  while (true) {
+    prefetched_resolution_available_.wait(
+      lock, [this]() {return should_exit_ || !prefetched_resolutions_.empty();});
+    if (should_exit_) {
+      return;
+    }
+    auto resolution = std::move(prefetched_resolutions_.front());
+    prefetched_resolutions_.pop_front();
+    lock.unlock();
+    std::call_once(resolution->once, [&resolution]() {resolution->task();});
+    lock.lock();
+  }
+}
+
+rosbag2_storage::MessageDefinition LocalMessageDefinitionSource::resolve_full_text(
+  const std::string & root_topic_type, const std::string & type_description_hash)
+{
+  const std::string path = cache_file_path(root_topic_type, type_description_hash);
+  if (!path.empty()) {
+    if (auto cached_full_text = read_cache_file(root_topic_type, path)) {
+      return *cached_full_text;
+    }
+  }
+  auto full_text = concatenate_definitions(root_topic_type);
+  if (!path.empty() && full_text.encoding != "unknown") {
+    write_cache_file(full_text, path);
+  }
+  return full_text;
+}
+
+std::string LocalMessageDefinitionSource::cache_file_path(
+  const std::string & root_topic_type, const std::string & type_description_hash) const
+{
+  // Without the hash a cached definition could be outdated by a rebuilt package
+  if (cache_directory_.empty() ||
+    !std::regex_match(type_description_hash, TYPE_DESCRIPTION_HASH_REGEX) ||
+    !std::regex_match(root_topic_type, PACKAGE_TYPENAME_REGEX))
+  {
+    return "";
+  }
+  std::string file_name = root_topic_type;
+  std::replace(file_name.begin(), file_name.end(), '/', '.');
+  file_name += "." + type_description_hash + ".def";
+  return (std::filesystem::path(cache_directory_) / file_name).string();
+}
+
+std::optional<rosbag2_storage::MessageDefinition> LocalMessageDefinitionSource::read_cache_file(
+  const std::string & root_topic_type, const std::string & path) const
+{
+  std::ifstream file{path, std::ios::binary};
+  if (!file.good()) {
+    return std::nullopt;
+  }
+  // The encoding is on the first line, followed by the full text
+  rosbag2_storage::MessageDefinition full_text;
+  if (!std::getline(file, full_text.encoding) ||
+    (full_text.encoding != "ros2msg" && full_text.encoding != "ros2idl"))
+  {
+    ROSBAG2_CPP_LOG_WARN("Ignoring invalid cached message definition %s", path.c_str());
+    return std::nullopt;
+  }
+  full_text.encoded_message_definition.assign(std::istreambuf_iterator<char>(file), {});
+  full_text.topic_type = root_topic_type;
+  return full_text;
+}
+
+void LocalMessageDefinitionSource::write_cache_file(
+  const rosbag2_storage::MessageDefinition & full_text, const std::string & path) const
+{
+  // Written to a file of its own first, so that other recorders never read it incomplete
+  std::error_code error;
+  std::filesystem::create_directories(cache_directory_, error);
+  const std::string temporary_path = path + "." + std::to_string(
+    std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    file << full_text.encoding << "\n" << full_text.encoded_message_definition;
+    if (!file.good()) {
+      ROSBAG2_CPP_LOG_WARN("Failed to cache message definition in %s", path.c_str());
+      file.close();
+      std::filesystem::remove(temporary_path, error);
+      return;
+    }
+  }
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+  }
+}
+
+rosbag2_storage::MessageDefinition LocalMessageDefinitionSource::concatenate_definitions(
   const std::string & root_topic_type)
 {
   std::unordered_set<DefinitionIdentifier, DefinitionIdentifierHash> seen_deps;
@@ -0,0 +1,125 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/parallel_converter.hpp"
+
+namespace rosbag2_cpp
+{
+
+ParallelConverter::ParallelConverter(
+  const ConverterOptions & converter_options,
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory,
+  size_t number_of_threads)
+{
+  number_of_threads = std::max<size_t>(number_of_threads, 1);
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    converters_.push_back(std::make_unique<Converter>(converter_options, converter_factory));
+  }
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    threads_.emplace_back(&ParallelConverter::convert_messages_of_batches, this, i);
+  }
+}
+
+ParallelConverter::~ParallelConverter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_exit_ = true;
+  }
+  messages_available_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+void ParallelConverter::add_topic(const std::string & topic, const std::string & type)
+{
+  std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+  for (auto & converter : converters_) {
+    converter->add_topic(topic, type);
+  }
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> ParallelConverter::convert(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> converted(messages.size());
+  if (messages.empty()) {
+    return converted;
+  }
+  std::lock_guard<std::mutex> batch_lock(batch_mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_ = &messages;
+  converted_batch_ = &converted;
+  next_message_ = 0;
+  messages_to_convert_ = messages.size();
+  error_ = nullptr;
+  messages_available_.notify_all();
+  batch_converted_.wait(lock, [this]() {return messages_to_convert_ == 0;});
+  batch_ = nullptr;
+  converted_batch_ = nullptr;
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+  return converted;
+}
+
+size_t ParallelConverter::get_number_of_threads() const
+{
+  return threads_.size();
+}
+
+void ParallelConverter::convert_messages_of_batches(size_t thread_index)
+{
+  auto & converter = *converters_[thread_index];
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    messages_available_.wait(
+      lock, [this]() {
+        return should_exit_ || (batch_ != nullptr && next_message_ < batch_->size());
+      });
+    if (should_exit_) {
+      return;
+    }
+    const size_t index = next_message_++;
+    const auto & message = (*batch_)[index];
+    lock.unlock();
+
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> converted_message;
+    std::exception_ptr error;
+    try {
+      converted_message = converter.convert(message);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    (*converted_batch_)[index] = std::move(converted_message);
+    if (error && !error_) {
+      error_ = error;
+    }
+    if (--messages_to_convert_ == 0) {
+      batch_converted_.notify_one();
+    }
+  }
+}
+
+}  // namespace rosbag2_cpp
@@ -0,0 +1,244 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "rosbag2_cpp/payload_deduplication.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+// Starts every reference payload, followed by the hash, time stamp and size in little endian
+constexpr uint8_t kReferenceMarker[8] = {0xFF, 'r', 'b', '2', 'r', 'e', 'f', 0xFF};
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+
+uint64_t rotate_left(uint64_t value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t load_word(const uint8_t * data)
+{
+  uint64_t word = 0;
+  for (int i = 7; i >= 0; --i) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+void store_word(uint8_t * data, uint64_t word)
+{
+  for (int i = 0; i < 8; ++i) {
+    data[i] = static_cast<uint8_t>(word >> (8 * i));
+  }
+}
+
+uint64_t mix_lane(uint64_t lane, uint64_t word)
+{
+  return rotate_left(lane + word * kPrime2, 31) * kPrime1;
+}
+}  // namespace
+
+uint64_t hash_payload(const uint8_t * data, size_t size)
+{
+  // Four independent lanes over 32 byte stripes keep the multipliers busy
+  uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+  size_t position = 0;
+  for (; position + 32 <= size; position += 32) {
+    for (size_t lane = 0; lane < 4; ++lane) {
+      lanes[lane] = mix_lane(lanes[lane], load_word(data + position + 8 * lane));
+    }
+  }
+  uint64_t hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+    rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+  hash ^= static_cast<uint64_t>(size) * kPrime3;
+  for (; position + 8 <= size; position += 8) {
+    hash = rotate_left(hash ^ mix_lane(0, load_word(data + position)), 27) * kPrime1 + kPrime3;
+  }
+  for (; position < size; ++position) {
+    hash = rotate_left(hash ^ (data[position] * kPrime3), 11) * kPrime1;
+  }
+  // Avalanche the remaining bits
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+std::shared_ptr<rcutils_uint8_array_t> make_reference_payload(const PayloadReference & reference)
+{
+  auto payload = rosbag2_storage::make_empty_serialized_message(kPayloadReferenceSize);
+  std::memcpy(payload->buffer, kReferenceMarker, sizeof(kReferenceMarker));
+  store_word(payload->buffer + 8, reference.hash);
+  store_word(payload->buffer + 16, static_cast<uint64_t>(reference.time_stamp));
+  store_word(payload->buffer + 24, reference.size);
+  payload->buffer_length = kPayloadReferenceSize;
+  return payload;
+}
+
+std::optional<PayloadReference> parse_reference_payload(const rcutils_uint8_array_t & payload)
+{
+  if (payload.buffer_length != kPayloadReferenceSize ||
+    std::memcmp(payload.buffer, kReferenceMarker, sizeof(kReferenceMarker)) != 0)
+  {
+    return std::nullopt;
+  }
+  PayloadReference reference;
+  reference.hash = load_word(payload.buffer + 8);
+  reference.time_stamp = static_cast<rcutils_time_point_value_t>(load_word(payload.buffer + 16));
+  reference.size = load_word(payload.buffer + 24);
+  return reference;
+}
+
+RememberedPayloads::RememberedPayloads(uint64_t max_bytes)
+: max_bytes_(max_bytes)
+{}
+
+const RememberedPayloads::Entry * RememberedPayloads::find(
+  const std::string & topic, uint64_t hash, uint64_t size) const
+{
+  const auto it = entries_.find(make_key(topic, hash, size));
+  return it == entries_.end() ? nullptr : &it->second;
+}
+
+void RememberedPayloads::insert(const std::string & topic, uint64_t hash, Entry entry)
+{
+  const uint64_t size = entry.payload->buffer_length;
+  if (size > max_bytes_) {
+    return;
+  }
+  auto key = make_key(topic, hash, size);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    it->second = std::move(entry);
+    return;
+  }
+  while (bytes_ + size > max_bytes_ && !order_.empty()) {
+    const auto oldest = entries_.find(order_.front());
+    bytes_ -= oldest->second.payload->buffer_length;
+    entries_.erase(oldest);
+    order_.pop_front();
+  }
+  bytes_ += size;
+  order_.push_back(key);
+  entries_.emplace(std::move(key), std::move(entry));
+}
+
+void RememberedPayloads::clear()
+{
+  entries_.clear();
+  order_.clear();
+  bytes_ = 0;
+}
+
+uint64_t RememberedPayloads::get_bytes() const
+{
+  return bytes_;
+}
+
+std::string RememberedPayloads::make_key(const std::string & topic, uint64_t hash, uint64_t size)
+{
+  std::string key(16, '\0');
+  store_word(reinterpret_cast<uint8_t *>(&key[0]), hash);
+  store_word(reinterpret_cast<uint8_t *>(&key[8]), size);
+  return key + topic;
+}
+
+PayloadDeduplicator::PayloadDeduplicator(uint64_t min_payload_size, uint64_t max_remembered_bytes)
+: min_payload_size_(min_payload_size), payloads_(max_remembered_bytes)
+{}
+
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> PayloadDeduplicator::deduplicate(
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (!message->serialized_data) {
+    return message;
+  }
+  const auto & payload = *message->serialized_data;
+  if (payload.buffer_length < min_payload_size_ || payload.buffer_length <= kPayloadReferenceSize) {
+    return message;
+  }
+  const uint64_t hash = hash_payload(payload.buffer, payload.buffer_length);
+  const auto * remembered = payloads_.find(message->topic_name, hash, payload.buffer_length);
+  // A match of the hash alone is not trusted
+  if (remembered &&
+    std::memcmp(remembered->payload->buffer, payload.buffer, payload.buffer_length) == 0)
+  {
+    auto reference_message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*message);
+    reference_message->serialized_data =
+      make_reference_payload({hash, remembered->time_stamp, payload.buffer_length});
+    ++deduplicated_count_;
+    return reference_message;
+  }
+  payloads_.insert(message->topic_name, hash, {message->serialized_data, message->time_stamp});
+  return message;
+}
+
+void PayloadDeduplicator::reset()
+{
+  payloads_.clear();
+}
+
+uint64_t PayloadDeduplicator::get_deduplicated_count() const
+{
+  return deduplicated_count_;
+}
+
+PayloadResolver::PayloadResolver(uint64_t max_cached_bytes)
+: payloads_(max_cached_bytes)
+{}
+
+bool PayloadResolver::resolve(
+  rosbag2_storage::SerializedBagMessage & message, const LookUp & look_up)
+{
+  if (!message.serialized_data) {
+    return false;
+  }
+  const auto reference = parse_reference_payload(*message.serialized_data);
+  if (!reference) {
+    return false;
+  }
+  // Identical payloads of a topic have the same key in every file of the bag
+  if (const auto * cached = payloads_.find(message.topic_name, reference->hash, reference->size)) {
+    message.serialized_data = cached->payload;
+    return true;
+  }
+  auto payload = look_up(message.topic_name, *reference);
+  if (!payload) {
+    throw std::runtime_error(
+            "Could not find the payload of the message on topic '" + message.topic_name +
+            "' at time stamp " + std::to_string(message.time_stamp) +
+            ", which refers to the message at time stamp " +
+            std::to_string(reference->time_stamp));
+  }
+  payloads_.insert(message.topic_name, reference->hash, {payload, reference->time_stamp});
+  message.serialized_data = std::move(payload);
+  return true;
+}
+
+}  // namespace rosbag2_cpp
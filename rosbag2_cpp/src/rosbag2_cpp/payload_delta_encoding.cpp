@@ -0,0 +1,297 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/payload_delta_encoding.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+// Starts every delta payload, followed by the hash, time stamp and size of the keyframe in
+// little endian and the runs of the delta
+constexpr uint8_t kDeltaMarker[8] = {0xFF, 'r', 'b', '2', 'd', 'l', 't', 0xFF};
+constexpr size_t kDeltaHeaderSize = 32;
+
+// Bytes equal to the keyframe between changed bytes are only stored as a run of their own if
+// there are at least this many, shorter runs would not make the delta smaller
+constexpr size_t kMinUnchangedRun = 4;
+
+uint64_t load_word(const uint8_t * data)
+{
+  uint64_t word = 0;
+  for (int i = 7; i >= 0; --i) {
+    word = (word << 8) | data[i];
+  }
+  return word;
+}
+
+void store_word(uint8_t * data, uint64_t word)
+{
+  for (int i = 0; i < 8; ++i) {
+    data[i] = static_cast<uint8_t>(word >> (8 * i));
+  }
+}
+
+void append_varint(std::vector<uint8_t> & out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+bool read_varint(const uint8_t * & data, const uint8_t * end, uint64_t & value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64 && data < end; shift += 7) {
+    const uint8_t byte = *data++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t count_equal(const uint8_t * a, const uint8_t * b, size_t size)
+{
+  size_t count = 0;
+  // Compare a word at a time while there are no differences
+  while (count + 8 <= size && std::memcmp(a + count, b + count, 8) == 0) {
+    count += 8;
+  }
+  while (count < size && a[count] == b[count]) {
+    ++count;
+  }
+  return count;
+}
+}  // namespace
+
+std::shared_ptr<rcutils_uint8_array_t> make_delta_payload(
+  const PayloadReference & keyframe_reference, const rcutils_uint8_array_t & keyframe,
+  const rcutils_uint8_array_t & payload)
+{
+  const size_t size = payload.buffer_length;
+  if (keyframe.buffer_length != size || size <= kDeltaHeaderSize) {
+    return nullptr;
+  }
+  std::vector<uint8_t> delta(kDeltaHeaderSize);
+  std::memcpy(delta.data(), kDeltaMarker, sizeof(kDeltaMarker));
+  store_word(delta.data() + 8, keyframe_reference.hash);
+  store_word(delta.data() + 16, static_cast<uint64_t>(keyframe_reference.time_stamp));
+  store_word(delta.data() + 24, keyframe_reference.size);
+
+  size_t position = 0;
+  while (position < size) {
+    const size_t unchanged =
+      count_equal(keyframe.buffer + position, payload.buffer + position, size - position);
+    // Changed bytes up to the next run of unchanged bytes long enough to be worth a run
+    size_t changed_end = position + unchanged;
+    while (changed_end < size) {
+      const size_t equal = count_equal(
+        keyframe.buffer + changed_end, payload.buffer + changed_end, size - changed_end);
+      if (equal >= kMinUnchangedRun || changed_end + equal == size) {
+        break;
+      }
+      changed_end += std::max<size_t>(equal, 1);
+    }
+    const size_t changed = changed_end - position - unchanged;
+    append_varint(delta, unchanged);
+    append_varint(delta, changed);
+    delta.insert(
+      delta.end(), payload.buffer + position + unchanged, payload.buffer + changed_end);
+    if (delta.size() >= size) {
+      return nullptr;
+    }
+    position = changed_end;
+  }
+
+  auto delta_payload = rosbag2_storage::make_empty_serialized_message(delta.size());
+  std::memcpy(delta_payload->buffer, delta.data(), delta.size());
+  delta_payload->buffer_length = delta.size();
+  return delta_payload;
+}
+
+std::optional<PayloadReference> parse_delta_payload(const rcutils_uint8_array_t & payload)
+{
+  if (payload.buffer_length < kDeltaHeaderSize ||
+    std::memcmp(payload.buffer, kDeltaMarker, sizeof(kDeltaMarker)) != 0)
+  {
+    return std::nullopt;
+  }
+  PayloadReference keyframe;
+  keyframe.hash = load_word(payload.buffer + 8);
+  keyframe.time_stamp = static_cast<rcutils_time_point_value_t>(load_word(payload.buffer + 16));
+  keyframe.size = load_word(payload.buffer + 24);
+  return keyframe;
+}
+
+std::shared_ptr<rcutils_uint8_array_t> apply_delta_payload(
+  const rcutils_uint8_array_t & delta, const rcutils_uint8_array_t & keyframe)
+{
+  const auto reference = parse_delta_payload(delta);
+  if (!reference || reference->size != keyframe.buffer_length) {
+    throw std::runtime_error("Delta payload does not refer to a keyframe of its size");
+  }
+  const size_t size = keyframe.buffer_length;
+  auto payload = rosbag2_storage::make_empty_serialized_message(size);
+  std::memcpy(payload->buffer, keyframe.buffer, size);
+  payload->buffer_length = size;
+
+  const uint8_t * data = delta.buffer + kDeltaHeaderSize;
+  const uint8_t * end = delta.buffer + delta.buffer_length;
+  size_t position = 0;
+  while (data < end) {
+    uint64_t unchanged = 0;
+    uint64_t changed = 0;
+    if (!read_varint(data, end, unchanged) || !read_varint(data, end, changed) ||
+      unchanged > size - position || changed > size - position - unchanged ||
+      changed > static_cast<uint64_t>(end - data))
+    {
+      throw std::runtime_error("Malformed delta payload");
+    }
+    position += unchanged;
+    std::memcpy(payload->buffer + position, data, changed);
+    position += changed;
+    data += changed;
+  }
+  return payload;
+}
+
+std::string join_delta_encoded_topics(const std::vector<std::string> & topics)
+{
+  std::string joined;
+  for (const auto & topic : topics) {
+    if (!joined.empty()) {
+      joined += ',';
+    }
+    joined += topic;
+  }
+  return joined;
+}
+
+std::vector<std::string> split_delta_encoded_topics(const std::string & joined_topics)
+{
+  std::vector<std::string> topics;
+  std::stringstream stream(joined_topics);
+  std::string topic;
+  while (std::getline(stream, topic, ',')) {
+    if (!topic.empty()) {
+      topics.push_back(topic);
+    }
+  }
+  return topics;
+}
+
+PayloadDeltaEncoder::PayloadDeltaEncoder(
+  const std::vector<std::string> & topics, uint64_t keyframe_interval)
+: topics_(topics.begin(), topics.end()),
+  keyframe_interval_(std::max<uint64_t>(keyframe_interval, 1))
+{}
+
+bool PayloadDeltaEncoder::is_encoded_topic(const std::string & topic) const
+{
+  return topics_.count(topic) > 0;
+}
+
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> PayloadDeltaEncoder::encode(
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (!message->serialized_data || !is_encoded_topic(message->topic_name)) {
+    return message;
+  }
+  const auto & payload = *message->serialized_data;
+  auto & keyframe = keyframes_[message->topic_name];
+  if (keyframe.payload && keyframe.messages_since + 1 < keyframe_interval_) {
+    auto delta = make_delta_payload(keyframe.reference, *keyframe.payload, payload);
+    if (delta) {
+      auto delta_message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*message);
+      delta_message->serialized_data = std::move(delta);
+      ++keyframe.messages_since;
+      ++delta_count_;
+      return delta_message;
+    }
+  }
+  // The payload is shared with the message, not copied
+  keyframe.payload = message->serialized_data;
+  keyframe.reference = {
+    hash_payload(payload.buffer, payload.buffer_length), message->time_stamp,
+    payload.buffer_length};
+  keyframe.messages_since = 0;
+  return message;
+}
+
+void PayloadDeltaEncoder::reset()
+{
+  keyframes_.clear();
+}
+
+uint64_t PayloadDeltaEncoder::get_delta_count() const
+{
+  return delta_count_;
+}
+
+PayloadDeltaDecoder::PayloadDeltaDecoder(const std::vector<std::string> & topics)
+: topics_(topics.begin(), topics.end())
+{}
+
+bool PayloadDeltaDecoder::decode(
+  rosbag2_storage::SerializedBagMessage & message, const PayloadResolver::LookUp & look_up)
+{
+  if (!message.serialized_data || topics_.count(message.topic_name) == 0) {
+    return false;
+  }
+  const auto reference = parse_delta_payload(*message.serialized_data);
+  auto & keyframe = keyframes_[message.topic_name];
+  if (!reference) {
+    // Every complete payload of the topic may be the keyframe of the deltas which follow it
+    keyframe = {message.serialized_data, message.time_stamp, std::nullopt};
+    return false;
+  }
+  bool is_kept = keyframe.payload && keyframe.time_stamp == reference->time_stamp &&
+    keyframe.payload->buffer_length == reference->size;
+  if (is_kept && !keyframe.hash) {
+    keyframe.hash = hash_payload(keyframe.payload->buffer, keyframe.payload->buffer_length);
+  }
+  is_kept = is_kept && *keyframe.hash == reference->hash;
+  if (!is_kept) {
+    auto payload = look_up(message.topic_name, *reference);
+    if (!payload) {
+      throw std::runtime_error(
+              "Could not find the keyframe of the message on topic '" + message.topic_name +
+              "' at time stamp " + std::to_string(message.time_stamp) +
+              ", which refers to the message at time stamp " +
+              std::to_string(reference->time_stamp));
+    }
+    keyframe = {std::move(payload), reference->time_stamp, reference->hash};
+  }
+  message.serialized_data = apply_delta_payload(*message.serialized_data, *keyframe.payload);
+  return true;
+}
+
+}  // namespace rosbag2_cpp
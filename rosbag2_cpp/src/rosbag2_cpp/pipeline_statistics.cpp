@@ -0,0 +1,276 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/pipeline_statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace rosbag2_cpp
+{
+
+namespace
+{
+void update_max(std::atomic<uint64_t> & max, uint64_t value)
+{
+  uint64_t current = max.load(std::memory_order_relaxed);
+  while (value > current &&
+    !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+size_t highest_bit(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return 63u - static_cast<size_t>(__builtin_clzll(value));
+#else
+  size_t bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+std::string format_latency(std::chrono::nanoseconds latency)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(1) <<
+    std::chrono::duration<double, std::micro>(latency).count() << "us";
+  return stream.str();
+}
+}  // namespace
+
+std::string pipeline_stage_to_string(PipelineStage stage)
+{
+  switch (stage) {
+    case PipelineStage::SUBSCRIPTION_CALLBACK:
+      return "subscription_callback";
+    case PipelineStage::WRITER_WRITE:
+      return "writer_write";
+    case PipelineStage::CACHE_PUSH:
+      return "cache_push";
+    case PipelineStage::CONSUMER_BATCH:
+      return "consumer_batch";
+    case PipelineStage::STORAGE_WRITE:
+      return "storage_write";
+    case PipelineStage::COMPRESSION:
+      return "compression";
+    default:
+      return "unknown";
+  }
+}
+
+std::string pipeline_queue_to_string(PipelineQueue queue)
+{
+  switch (queue) {
+    case PipelineQueue::CACHE_BATCH_MESSAGES:
+      return "cache_batch_messages";
+    case PipelineQueue::CACHE_BATCH_BYTES:
+      return "cache_batch_bytes";
+    case PipelineQueue::COMPRESSION_QUEUE_MESSAGES:
+      return "compression_queue_messages";
+    default:
+      return "unknown";
+  }
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+  for (auto & bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < kSubBucketCount) {
+    return static_cast<size_t>(value);
+  }
+  const size_t exponent = highest_bit(value);
+  if (exponent >= kMaxExponent) {
+    return kBucketCount - 1;
+  }
+  const size_t sub_bucket =
+    static_cast<size_t>(value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+  return kSubBucketCount + (exponent - kSubBucketBits) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+  if (index < kSubBucketCount) {
+    return index;
+  }
+  const size_t shift = (index - kSubBucketCount) / kSubBucketCount;
+  const uint64_t sub_bucket = (index - kSubBucketCount) % kSubBucketCount;
+  const uint64_t lower_bound = (kSubBucketCount + sub_bucket) << shift;
+  return lower_bound + (uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+  const uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0u;
+  buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  update_max(max_, value);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+  return count_.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const
+{
+  return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const
+{
+  const uint64_t count = count_.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::nanoseconds(sum_.load(std::memory_order_relaxed) / count);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double percentile) const
+{
+  // Count from the buckets themselves, count_ may be ahead of them while recording
+  uint64_t total = 0;
+  for (const auto & bucket : buckets_) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+  const uint64_t rank = std::max<uint64_t>(
+    1u, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::chrono::nanoseconds(
+        std::min(bucket_upper_bound(i), max_.load(std::memory_order_relaxed)));
+    }
+  }
+  return max();
+}
+
+void LatencyHistogram::reset()
+{
+  for (auto & bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+PipelineStatistics::PipelineStatistics()
+{
+  reset();
+}
+
+void PipelineStatistics::record(PipelineStage stage, std::chrono::nanoseconds latency)
+{
+  histograms_[static_cast<size_t>(stage)].record(latency);
+}
+
+const LatencyHistogram & PipelineStatistics::histogram(PipelineStage stage) const
+{
+  return histograms_[static_cast<size_t>(stage)];
+}
+
+void PipelineStatistics::set_queue_depth(PipelineQueue queue, uint64_t depth)
+{
+  queue_depths_[static_cast<size_t>(queue)].store(depth, std::memory_order_relaxed);
+  update_max(max_queue_depths_[static_cast<size_t>(queue)], depth);
+}
+
+uint64_t PipelineStatistics::queue_depth(PipelineQueue queue) const
+{
+  return queue_depths_[static_cast<size_t>(queue)].load(std::memory_order_relaxed);
+}
+
+uint64_t PipelineStatistics::max_queue_depth(PipelineQueue queue) const
+{
+  return max_queue_depths_[static_cast<size_t>(queue)].load(std::memory_order_relaxed);
+}
+
+void PipelineStatistics::set_cache_dropped_messages(
+  std::map<uint32_t, uint64_t> dropped_per_priority)
+{
+  std::lock_guard<std::mutex> lock(cache_dropped_messages_mutex_);
+  cache_dropped_messages_ = std::move(dropped_per_priority);
+}
+
+std::map<uint32_t, uint64_t> PipelineStatistics::cache_dropped_messages() const
+{
+  std::lock_guard<std::mutex> lock(cache_dropped_messages_mutex_);
+  return cache_dropped_messages_;
+}
+
+void PipelineStatistics::reset()
+{
+  for (auto & histogram : histograms_) {
+    histogram.reset();
+  }
+  for (size_t i = 0; i < queue_depths_.size(); ++i) {
+    queue_depths_[i] = 0;
+    max_queue_depths_[i] = 0;
+  }
+}
+
+std::string PipelineStatistics::summary() const
+{
+  std::ostringstream stream;
+  for (size_t i = 0; i < histograms_.size(); ++i) {
+    const auto & histogram = histograms_[i];
+    if (histogram.count() == 0) {
+      continue;
+    }
+    stream << "\n  " << pipeline_stage_to_string(static_cast<PipelineStage>(i)) <<
+      ": count " << histogram.count() <<
+      ", mean " << format_latency(histogram.mean()) <<
+      ", p50 " << format_latency(histogram.percentile(50.0)) <<
+      ", p90 " << format_latency(histogram.percentile(90.0)) <<
+      ", p99 " << format_latency(histogram.percentile(99.0)) <<
+      ", max " << format_latency(histogram.max());
+  }
+  for (size_t i = 0; i < queue_depths_.size(); ++i) {
+    if (max_queue_depths_[i] == 0) {
+      continue;
+    }
+    stream << "\n  " << pipeline_queue_to_string(static_cast<PipelineQueue>(i)) <<
+      ": last " << queue_depths_[i] << ", max " << max_queue_depths_[i];
+  }
+  for (const auto & [priority, dropped] : cache_dropped_messages()) {
+    if (dropped > 0) {
+      stream << "\n  cache drops of priority " << priority << ": " << dropped;
+    }
+  }
+  return stream.str();
+}
+
+}  // namespace rosbag2_cpp
@@ -71,6 +71,20 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> Reader::read_next()
   return reader_impl_->read_next();
 }
 
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> Reader::read_next_batch(
+  size_t max_messages, size_t max_bytes)
+{
+  return reader_impl_->read_next_batch(max_messages, max_bytes);
+}
+
+void Reader::for_each(
+  const rosbag2_storage::StorageFilter & storage_filter,
+  const rosbag2_storage::MessageViewCallback & callback)
+{
+  reader_impl_->set_filter(storage_filter);
+  reader_impl_->for_each(callback);
+}
+
 const rosbag2_storage::BagMetadata & Reader::get_metadata() const
 {
   return reader_impl_->get_metadata();
@@ -97,6 +111,12 @@ void Reader::reset_filter()
   reader_impl_->reset_filter();
 }
 
+rosbag2_storage::ReadEstimate Reader::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  return reader_impl_->estimate(storage_filter);
+}
+
 void Reader::seek(const rcutils_time_point_value_t & timestamp)
 {
   reader_impl_->seek(timestamp);
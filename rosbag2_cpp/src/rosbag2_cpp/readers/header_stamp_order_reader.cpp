@@ -0,0 +1,343 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/readers/header_stamp_order_reader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_storage/topic_filter.hpp"
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+namespace
+{
+// Messages read from the wrapped reader at once while waiting for the next one in order
+constexpr size_t kReadBatchSize = 64;
+
+size_t first_entry_received_at(
+  const std::vector<HeaderStampIndex::Entry> & entries,
+  rcutils_time_point_value_t received_time_stamp)
+{
+  return static_cast<size_t>(
+    std::lower_bound(
+      entries.begin(), entries.end(), received_time_stamp,
+      [](const HeaderStampIndex::Entry & entry, rcutils_time_point_value_t time_stamp) {
+        return entry.received_time_stamp < time_stamp;
+      }) - entries.begin());
+}
+}  // namespace
+
+HeaderStampOrderReader::HeaderStampOrderReader(
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl)
+: reader_impl_(std::move(reader_impl))
+{}
+
+HeaderStampOrderReader::HeaderStampOrderReader(
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl,
+  HeaderStampIndex index)
+: reader_impl_(std::move(reader_impl))
+{
+  use_index(std::move(index));
+}
+
+void HeaderStampOrderReader::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  clear_buffer();
+  in_header_order_ = false;
+  seek_header_time_stamp_.reset();
+  storage_filter_ = rosbag2_storage::StorageFilter();
+  if (index_read_from_bag_) {
+    cursors_.clear();
+    index_.reset();
+    index_read_from_bag_ = false;
+  } else {
+    apply_filter_to_cursors();
+    position_cursors(0);
+  }
+  reader_impl_->open(storage_options, converter_options);
+  std::error_code error;
+  bag_directory_ = std::filesystem::is_directory(storage_options.uri, error) ?
+    storage_options.uri : std::filesystem::path(storage_options.uri).parent_path().string();
+}
+
+void HeaderStampOrderReader::close()
+{
+  clear_buffer();
+  in_header_order_ = false;
+  reader_impl_->close();
+}
+
+bool HeaderStampOrderReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  clear_buffer();
+  if (order.sort_by != rosbag2_storage::ReadOrder::HeaderTimestamp) {
+    in_header_order_ = false;
+    return reader_impl_->set_read_order(order);
+  }
+  if (order.reverse) {
+    ROSBAG2_CPP_LOG_WARN("Reading in reverse order of header time stamps is not supported");
+    return false;
+  }
+  if (!index_) {
+    if (bag_directory_.empty() || !HeaderStampIndex::exists(bag_directory_)) {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Bag " << bag_directory_ << " has no header stamp index to read in order of header " <<
+          "time stamps. Build it with 'ros2 bag reindex --header-stamps'.");
+      return false;
+    }
+    use_index(HeaderStampIndex::read(bag_directory_));
+    index_read_from_bag_ = true;
+  }
+  if (!reader_impl_->set_read_order(rosbag2_storage::ReadOrder())) {
+    return false;
+  }
+  has_unindexed_topics_ = false;
+  for (const auto & topic : reader_impl_->get_all_topics_and_types()) {
+    if (cursors_.find(topic.name) == cursors_.end()) {
+      has_unindexed_topics_ = true;
+    }
+  }
+  last_received_time_stamp_ = std::numeric_limits<rcutils_time_point_value_t>::min();
+  seek_header_time_stamp_.reset();
+  in_header_order_ = true;
+  return true;
+}
+
+bool HeaderStampOrderReader::has_next()
+{
+  if (!in_header_order_) {
+    return reader_impl_->has_next();
+  }
+  while (buffer_.empty() || buffer_.top().header_time_stamp > min_unread_header_time_stamp()) {
+    auto messages = reader_impl_->read_next_batch(kReadBatchSize);
+    if (messages.empty()) {
+      // All messages are read, the buffered ones are in order
+      return !buffer_.empty();
+    }
+    for (auto & message : messages) {
+      buffer(std::move(message));
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> HeaderStampOrderReader::read_next()
+{
+  if (!in_header_order_) {
+    return reader_impl_->read_next();
+  }
+  if (!has_next()) {
+    throw std::runtime_error("Bag is at end. No next message.");
+  }
+  auto message = buffer_.top().message;
+  buffer_.pop();
+  return message;
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+HeaderStampOrderReader::read_next_batch(size_t max_messages, size_t max_bytes)
+{
+  if (!in_header_order_) {
+    return reader_impl_->read_next_batch(max_messages, max_bytes);
+  }
+  return BaseReaderInterface::read_next_batch(max_messages, max_bytes);
+}
+
+const rosbag2_storage::BagMetadata & HeaderStampOrderReader::get_metadata() const
+{
+  return reader_impl_->get_metadata();
+}
+
+std::vector<rosbag2_storage::TopicMetadata>
+HeaderStampOrderReader::get_all_topics_and_types() const
+{
+  return reader_impl_->get_all_topics_and_types();
+}
+
+void HeaderStampOrderReader::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  reader_impl_->get_all_message_definitions(definitions);
+}
+
+void HeaderStampOrderReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  reader_impl_->set_filter(storage_filter);
+  storage_filter_ = storage_filter;
+  apply_filter_to_cursors();
+  // Like the storage, the filter applies to the messages which are not returned yet
+  rosbag2_storage::TopicFilter topic_filter(storage_filter_);
+  std::vector<BufferedMessage> kept;
+  while (!buffer_.empty()) {
+    if (topic_filter.matches(buffer_.top().message->topic_name)) {
+      kept.push_back(buffer_.top());
+    }
+    buffer_.pop();
+  }
+  for (auto & buffered : kept) {
+    buffer_.push(std::move(buffered));
+  }
+}
+
+void HeaderStampOrderReader::reset_filter()
+{
+  set_filter(rosbag2_storage::StorageFilter());
+}
+
+rosbag2_storage::ReadEstimate HeaderStampOrderReader::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  return reader_impl_->estimate(storage_filter);
+}
+
+void HeaderStampOrderReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  clear_buffer();
+  if (!in_header_order_) {
+    reader_impl_->seek(timestamp);
+    return;
+  }
+  // The first message with a header time stamp at or after timestamp may be received earlier.
+  // Topics which are not indexed have header time stamps equal to their received ones.
+  rcutils_time_point_value_t received_time_stamp = timestamp;
+  for (const auto & [topic_name, cursor] : cursors_) {
+    if (!cursor.selected) {
+      continue;
+    }
+    const auto first = std::lower_bound(
+      cursor.max_header_time_stamps.begin(), cursor.max_header_time_stamps.end(), timestamp);
+    if (first != cursor.max_header_time_stamps.end()) {
+      const auto & entry = (*cursor.entries)[first - cursor.max_header_time_stamps.begin()];
+      received_time_stamp = std::min(received_time_stamp, entry.received_time_stamp);
+    }
+  }
+  reader_impl_->seek(received_time_stamp);
+  position_cursors(received_time_stamp);
+  last_received_time_stamp_ = std::numeric_limits<rcutils_time_point_value_t>::min();
+  seek_header_time_stamp_ = timestamp;
+}
+
+void HeaderStampOrderReader::add_event_callbacks(
+  const bag_events::ReaderEventCallbacks & callbacks)
+{
+  reader_impl_->add_event_callbacks(callbacks);
+}
+
+size_t HeaderStampOrderReader::get_buffered_messages() const
+{
+  return buffer_.size();
+}
+
+void HeaderStampOrderReader::use_index(HeaderStampIndex index)
+{
+  index_ = std::move(index);
+  cursors_.clear();
+  for (const auto & [topic_name, entries] : index_->topics()) {
+    TopicCursor & cursor = cursors_[topic_name];
+    cursor.entries = &entries;
+    cursor.min_header_time_stamps.resize(entries.size());
+    cursor.max_header_time_stamps.resize(entries.size());
+    auto min_header_time_stamp = std::numeric_limits<rcutils_time_point_value_t>::max();
+    for (size_t i = entries.size(); i-- > 0; ) {
+      min_header_time_stamp = std::min(min_header_time_stamp, entries[i].header_time_stamp);
+      cursor.min_header_time_stamps[i] = min_header_time_stamp;
+    }
+    auto max_header_time_stamp = std::numeric_limits<rcutils_time_point_value_t>::min();
+    for (size_t i = 0; i < entries.size(); ++i) {
+      max_header_time_stamp = std::max(max_header_time_stamp, entries[i].header_time_stamp);
+      cursor.max_header_time_stamps[i] = max_header_time_stamp;
+    }
+  }
+  apply_filter_to_cursors();
+}
+
+void HeaderStampOrderReader::apply_filter_to_cursors()
+{
+  rosbag2_storage::TopicFilter topic_filter(storage_filter_);
+  for (auto & [topic_name, cursor] : cursors_) {
+    cursor.selected = topic_filter.matches(topic_name);
+    if (storage_filter_.start_time_ns >= 0) {
+      cursor.next = std::max(
+        cursor.next, first_entry_received_at(*cursor.entries, storage_filter_.start_time_ns));
+    }
+  }
+}
+
+void HeaderStampOrderReader::position_cursors(rcutils_time_point_value_t received_time_stamp)
+{
+  received_time_stamp = std::max<rcutils_time_point_value_t>(
+    received_time_stamp, storage_filter_.start_time_ns);
+  for (auto & [topic_name, cursor] : cursors_) {
+    cursor.next = first_entry_received_at(*cursor.entries, received_time_stamp);
+  }
+}
+
+void HeaderStampOrderReader::clear_buffer()
+{
+  buffer_ = decltype(buffer_)();
+}
+
+void HeaderStampOrderReader::buffer(std::shared_ptr<rosbag2_storage::SerializedBagMessage> message)
+{
+  rcutils_time_point_value_t header_time_stamp = message->time_stamp;
+  last_received_time_stamp_ = message->time_stamp;
+  auto cursor = cursors_.find(message->topic_name);
+  if (cursor != cursors_.end()) {
+    const auto & entries = *cursor->second.entries;
+    auto & next = cursor->second.next;
+    // Entries of messages which were not read, e.g. outside of the time window, are skipped
+    while (next < entries.size() && entries[next].received_time_stamp < message->time_stamp) {
+      ++next;
+    }
+    if (next < entries.size() && entries[next].received_time_stamp == message->time_stamp) {
+      header_time_stamp = entries[next++].header_time_stamp;
+    }
+  }
+  if (seek_header_time_stamp_ && header_time_stamp < *seek_header_time_stamp_) {
+    return;
+  }
+  buffer_.push({header_time_stamp, next_sequence_++, std::move(message)});
+}
+
+rcutils_time_point_value_t HeaderStampOrderReader::min_unread_header_time_stamp() const
+{
+  // Messages of topics which are not indexed may follow with any received time stamp from the
+  // last one read on
+  auto min_header_time_stamp = has_unindexed_topics_ ?
+    last_received_time_stamp_ : std::numeric_limits<rcutils_time_point_value_t>::max();
+  for (const auto & [topic_name, cursor] : cursors_) {
+    if (cursor.selected && cursor.next < cursor.entries->size()) {
+      min_header_time_stamp =
+        std::min(min_header_time_stamp, cursor.min_header_time_stamps[cursor.next]);
+    }
+  }
+  return min_header_time_stamp;
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
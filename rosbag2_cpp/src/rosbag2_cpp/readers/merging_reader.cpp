@@ -0,0 +1,400 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/asserts.hpp"
+
+#include "rosbag2_cpp/readers/merging_reader.hpp"
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+namespace details
+{
+// Defined in sequential_reader.cpp
+std::vector<std::string> resolve_relative_paths(
+  const std::string & base_folder, std::vector<std::string> relative_files, const int version);
+}  // namespace details
+
+MergingReader::MergingReader(
+  size_t max_open_files,
+  size_t max_prefetched_bytes_per_file,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io,
+  FileReaderFactory file_reader_factory)
+: max_open_files_(max_open_files),
+  metadata_io_(std::move(metadata_io)),
+  file_reader_factory_(std::move(file_reader_factory))
+{
+  rcpputils::require_true(max_open_files_ > 0, "MergingReader needs to open at least one file.");
+  if (!file_reader_factory_) {
+    file_reader_factory_ = [max_prefetched_bytes_per_file]()
+      -> std::unique_ptr<reader_interfaces::BaseReaderInterface> {
+        if (max_prefetched_bytes_per_file == 0) {
+          return std::make_unique<SequentialReader>();
+        }
+        return std::make_unique<PrefetchingReader>(
+          std::make_unique<SequentialReader>(), max_prefetched_bytes_per_file);
+      };
+  }
+}
+
+MergingReader::~MergingReader()
+{
+  close();
+}
+
+void MergingReader::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  close();
+  storage_options_ = storage_options;
+  converter_options_ = converter_options;
+
+  constexpr auto kUnknownStartingTime = std::numeric_limits<rcutils_time_point_value_t>::min();
+  constexpr auto kUnknownEndingTime = std::numeric_limits<rcutils_time_point_value_t>::max();
+  if (metadata_io_->metadata_file_exists(storage_options.uri)) {
+    metadata_ = metadata_io_->read_metadata(storage_options.uri);
+    if (!metadata_.compression_format.empty()) {
+      throw std::runtime_error(
+              "MergingReader does not support compressed bags: " + storage_options.uri);
+    }
+    if (storage_options_.storage_id.empty()) {
+      storage_options_.storage_id = metadata_.storage_identifier;
+    }
+    const auto file_paths = details::resolve_relative_paths(
+      storage_options.uri, metadata_.relative_file_paths, metadata_.version);
+    const bool has_time_ranges = metadata_.files.size() == file_paths.size();
+    for (size_t i = 0; i < file_paths.size(); ++i) {
+      File file{file_paths[i], kUnknownStartingTime, kUnknownEndingTime};
+      if (has_time_ranges) {
+        const auto & file_information = metadata_.files[i];
+        file.starting_time = file_information.starting_time.time_since_epoch().count();
+        file.ending_time =
+          (file_information.starting_time + file_information.duration).time_since_epoch().count();
+      }
+      files_.push_back(std::move(file));
+    }
+  } else {
+    // A single storage file, which holds the metadata
+    files_.push_back({storage_options.uri, kUnknownStartingTime, kUnknownEndingTime});
+    auto reader = open_file(files_.front());
+    metadata_ = reader->get_metadata();
+    reader->close();
+  }
+  is_open_ = true;
+  restart(std::nullopt);
+}
+
+void MergingReader::close()
+{
+  restart(std::nullopt);
+  is_open_ = false;
+  files_.clear();
+  files_opening_order_.clear();
+  last_closed_file_.clear();
+  read_head_.reset();
+  topics_read_at_read_head_.clear();
+  skip_time_stamp_.reset();
+  topics_to_skip_.clear();
+}
+
+bool MergingReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  if (!is_open_) {
+    throw std::runtime_error("read order can only be set after open()");
+  }
+  read_order_ = order;
+  read_order_supported_ = true;
+  restart_at_read_head();
+  open_due_files();
+  return read_order_supported_;
+}
+
+bool MergingReader::has_next()
+{
+  check_open();
+  open_due_files();
+  return !next_messages_.empty();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> MergingReader::read_next()
+{
+  if (!has_next()) {
+    throw std::runtime_error("Bag is at end. No next message.");
+  }
+  std::pop_heap(
+    next_messages_.begin(), next_messages_.end(),
+    [this](const NextMessage & lhs, const NextMessage & rhs) {return is_after(lhs, rhs);});
+  auto next = std::move(next_messages_.back());
+  next_messages_.pop_back();
+  read_ahead(next.rank);
+
+  const auto time_stamp = next.message->time_stamp;
+  if (read_head_ != time_stamp) {
+    read_head_ = time_stamp;
+    topics_read_at_read_head_.clear();
+  }
+  topics_read_at_read_head_.push_back(next.message->topic_name);
+  if (skip_time_stamp_ != time_stamp) {
+    skip_time_stamp_.reset();
+    topics_to_skip_.clear();
+  }
+  return next.message;
+}
+
+const rosbag2_storage::BagMetadata & MergingReader::get_metadata() const
+{
+  return metadata_;
+}
+
+std::vector<rosbag2_storage::TopicMetadata> MergingReader::get_all_topics_and_types() const
+{
+  check_open();
+  std::vector<rosbag2_storage::TopicMetadata> topics;
+  topics.reserve(metadata_.topics_with_message_count.size());
+  for (const auto & topic_information : metadata_.topics_with_message_count) {
+    topics.push_back(topic_information.topic_metadata);
+  }
+  return topics;
+}
+
+void MergingReader::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  check_open();
+  if (!open_readers_.empty()) {
+    open_readers_.begin()->second->get_all_message_definitions(definitions);
+  } else if (!files_.empty()) {
+    auto reader = open_file(files_.front());
+    reader->get_all_message_definitions(definitions);
+    reader->close();
+  }
+}
+
+void MergingReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!is_open_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before setting filter.");
+  }
+  storage_filter_ = storage_filter;
+  restart_at_read_head();
+}
+
+void MergingReader::reset_filter()
+{
+  set_filter(rosbag2_storage::StorageFilter());
+}
+
+void MergingReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  if (!is_open_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before seeking time.");
+  }
+  restart(timestamp);
+  read_head_ = timestamp;
+  topics_read_at_read_head_.clear();
+  skip_time_stamp_.reset();
+  topics_to_skip_.clear();
+}
+
+void MergingReader::add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks)
+{
+  if (callbacks.read_split_callback) {
+    callback_manager_.add_event_callback(
+      callbacks.read_split_callback,
+      bag_events::BagEvent::READ_SPLIT);
+  }
+}
+
+size_t MergingReader::get_open_files_count() const
+{
+  return open_readers_.size();
+}
+
+bool MergingReader::files_overlap(const rosbag2_storage::BagMetadata & metadata)
+{
+  std::vector<const rosbag2_storage::FileInformation *> files;
+  for (const auto & file_information : metadata.files) {
+    if (file_information.message_count > 0) {
+      files.push_back(&file_information);
+    }
+  }
+  std::sort(
+    files.begin(), files.end(),
+    [](const rosbag2_storage::FileInformation * lhs, const rosbag2_storage::FileInformation * rhs) {
+      return lhs->starting_time < rhs->starting_time;
+    });
+  for (size_t i = 1; i < files.size(); ++i) {
+    const auto & previous = *files[i - 1];
+    if (files[i]->starting_time < previous.starting_time + previous.duration) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MergingReader::check_open() const
+{
+  if (!is_open_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+}
+
+std::unique_ptr<reader_interfaces::BaseReaderInterface> MergingReader::open_file(
+  const File & file)
+{
+  auto reader = file_reader_factory_();
+  auto storage_options = storage_options_;
+  storage_options.uri = file.path;
+  reader->open(storage_options, converter_options_);
+  if (!reader->set_read_order(read_order_)) {
+    read_order_supported_ = false;
+  }
+  reader->set_filter(storage_filter_);
+  if (seek_time_) {
+    reader->seek(*seek_time_);
+  }
+  return reader;
+}
+
+void MergingReader::restart(const std::optional<rcutils_time_point_value_t> & time_stamp)
+{
+  for (auto & open_reader : open_readers_) {
+    open_reader.second->close();
+  }
+  open_readers_.clear();
+  next_messages_.clear();
+  next_file_to_open_ = 0;
+  seek_time_ = time_stamp;
+
+  files_opening_order_.resize(files_.size());
+  for (size_t i = 0; i < files_.size(); ++i) {
+    files_opening_order_[i] = i;
+  }
+  std::stable_sort(
+    files_opening_order_.begin(), files_opening_order_.end(),
+    [this](size_t lhs, size_t rhs) {
+      return read_order_.reverse ?
+      files_[lhs].ending_time > files_[rhs].ending_time :
+      files_[lhs].starting_time < files_[rhs].starting_time;
+    });
+}
+
+void MergingReader::restart_at_read_head()
+{
+  skip_time_stamp_ = read_head_;
+  topics_to_skip_ = topics_read_at_read_head_;
+  restart(read_head_ ? read_head_ : seek_time_);
+}
+
+void MergingReader::open_due_files()
+{
+  while (next_file_to_open_ < files_opening_order_.size()) {
+    const size_t rank = next_file_to_open_;
+    const File & file = files_[files_opening_order_[rank]];
+    if (is_skipped(file)) {
+      ++next_file_to_open_;
+      continue;
+    }
+    if (!is_due(file) && open_readers_.size() >= max_open_files_) {
+      return;
+    }
+    ++next_file_to_open_;
+    open_readers_[rank] = open_file(file);
+
+    auto info = std::make_shared<bag_events::BagSplitInfo>();
+    info->closed_file = last_closed_file_;
+    info->opened_file = file.path;
+    callback_manager_.execute_callbacks(bag_events::BagEvent::READ_SPLIT, info);
+    read_ahead(rank);
+  }
+}
+
+bool MergingReader::is_due(const File & file) const
+{
+  // The file may hold messages before the next one of the open files
+  if (next_messages_.empty()) {
+    return true;
+  }
+  const auto next_time_stamp = next_messages_.front().message->time_stamp;
+  return read_order_.reverse ?
+         next_time_stamp <= file.ending_time :
+         next_time_stamp >= file.starting_time;
+}
+
+bool MergingReader::is_skipped(const File & file) const
+{
+  if ((storage_filter_.start_time_ns >= 0 && file.ending_time < storage_filter_.start_time_ns) ||
+    (storage_filter_.end_time_ns >= 0 && file.starting_time > storage_filter_.end_time_ns))
+  {
+    return true;
+  }
+  if (!seek_time_) {
+    return false;
+  }
+  return read_order_.reverse ? file.starting_time > *seek_time_ : file.ending_time < *seek_time_;
+}
+
+void MergingReader::read_ahead(size_t rank)
+{
+  auto & reader = open_readers_.at(rank);
+  while (reader->has_next()) {
+    auto message = reader->read_next();
+    if (skip_time_stamp_ && message->time_stamp == *skip_time_stamp_) {
+      // Drop the messages which were returned before the last restart
+      auto topic_to_skip = std::find(
+        topics_to_skip_.begin(), topics_to_skip_.end(), message->topic_name);
+      if (topic_to_skip != topics_to_skip_.end()) {
+        topics_to_skip_.erase(topic_to_skip);
+        continue;
+      }
+    }
+    next_messages_.push_back({std::move(message), rank});
+    std::push_heap(
+      next_messages_.begin(), next_messages_.end(),
+      [this](const NextMessage & lhs, const NextMessage & rhs) {return is_after(lhs, rhs);});
+    return;
+  }
+  reader->close();
+  open_readers_.erase(rank);
+  last_closed_file_ = files_[files_opening_order_[rank]].path;
+}
+
+bool MergingReader::is_after(const NextMessage & lhs, const NextMessage & rhs) const
+{
+  const auto lhs_time_stamp = lhs.message->time_stamp;
+  const auto rhs_time_stamp = rhs.message->time_stamp;
+  if (lhs_time_stamp != rhs_time_stamp) {
+    return read_order_.reverse ? lhs_time_stamp < rhs_time_stamp : lhs_time_stamp > rhs_time_stamp;
+  }
+  return lhs.rank > rhs.rank;
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
@@ -0,0 +1,348 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/readers/multi_bag_reader.hpp"
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+MultiBagReader::MultiBagReader(std::vector<Bag> bags)
+: bags_(std::move(bags))
+{
+  if (bags_.empty()) {
+    throw std::invalid_argument("MultiBagReader needs at least one bag.");
+  }
+  for (auto & bag : bags_) {
+    if (!bag.reader) {
+      bag.reader = std::make_unique<PrefetchingReader>();
+    }
+  }
+}
+
+MultiBagReader::~MultiBagReader()
+{
+  close();
+}
+
+void MultiBagReader::open(
+  const rosbag2_storage::StorageOptions & /* storage_options */,
+  const ConverterOptions & converter_options)
+{
+  close();
+  for (auto & bag : bags_) {
+    bag.reader->open(bag.storage_options, converter_options);
+  }
+  merge_metadata();
+  is_open_ = true;
+  for (size_t rank = 0; rank < bags_.size(); ++rank) {
+    bags_to_read_ahead_.push_back(rank);
+  }
+}
+
+void MultiBagReader::close()
+{
+  if (is_open_) {
+    for (auto & bag : bags_) {
+      bag.reader->close();
+    }
+  }
+  is_open_ = false;
+  metadata_ = rosbag2_storage::BagMetadata();
+  topics_.clear();
+  next_messages_.clear();
+  bags_to_read_ahead_.clear();
+  read_order_ = rosbag2_storage::ReadOrder();
+  read_head_.reset();
+  topics_read_at_read_head_.clear();
+  skip_time_stamp_.reset();
+  topics_to_skip_.clear();
+}
+
+bool MultiBagReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  if (!is_open_) {
+    throw std::runtime_error("read order can only be set after open()");
+  }
+  read_order_ = order;
+  bool read_order_supported = true;
+  for (auto & bag : bags_) {
+    if (!bag.reader->set_read_order(order)) {
+      read_order_supported = false;
+    }
+  }
+  restart_at_read_head();
+  return read_order_supported;
+}
+
+bool MultiBagReader::has_next()
+{
+  check_open();
+  read_ahead();
+  return !next_messages_.empty();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> MultiBagReader::read_next()
+{
+  if (!has_next()) {
+    throw std::runtime_error("Bag is at end. No next message.");
+  }
+  std::pop_heap(
+    next_messages_.begin(), next_messages_.end(),
+    [this](const NextMessage & lhs, const NextMessage & rhs) {return is_after(lhs, rhs);});
+  auto next = std::move(next_messages_.back());
+  next_messages_.pop_back();
+  bags_to_read_ahead_.push_back(next.rank);
+
+  const auto time_stamp = next.message->time_stamp;
+  if (read_head_ != time_stamp) {
+    read_head_ = time_stamp;
+    topics_read_at_read_head_.clear();
+  }
+  topics_read_at_read_head_.push_back(next.message->topic_name);
+  if (skip_time_stamp_ != time_stamp) {
+    skip_time_stamp_.reset();
+    topics_to_skip_.clear();
+  }
+  return next.message;
+}
+
+const rosbag2_storage::BagMetadata & MultiBagReader::get_metadata() const
+{
+  return metadata_;
+}
+
+std::vector<rosbag2_storage::TopicMetadata> MultiBagReader::get_all_topics_and_types() const
+{
+  check_open();
+  return topics_;
+}
+
+void MultiBagReader::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  check_open();
+  for (auto & bag : bags_) {
+    std::vector<rosbag2_storage::MessageDefinition> bag_definitions;
+    bag.reader->get_all_message_definitions(bag_definitions);
+    for (auto & definition : bag_definitions) {
+      const bool is_known = std::any_of(
+        definitions.begin(), definitions.end(),
+        [&definition](const rosbag2_storage::MessageDefinition & known) {
+          return known.topic_type == definition.topic_type;
+        });
+      if (!is_known) {
+        definitions.push_back(std::move(definition));
+      }
+    }
+  }
+}
+
+void MultiBagReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!is_open_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before setting filter.");
+  }
+  for (auto & bag : bags_) {
+    bag.reader->set_filter(storage_filter);
+  }
+  restart_at_read_head();
+}
+
+void MultiBagReader::reset_filter()
+{
+  set_filter(rosbag2_storage::StorageFilter());
+}
+
+rosbag2_storage::ReadEstimate MultiBagReader::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!is_open_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before estimating.");
+  }
+  rosbag2_storage::ReadEstimate estimate;
+  estimate.exact = true;
+  for (auto & bag : bags_) {
+    estimate += bag.reader->estimate(storage_filter);
+  }
+  return estimate;
+}
+
+void MultiBagReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  if (!is_open_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before seeking time.");
+  }
+  next_messages_.clear();
+  bags_to_read_ahead_.clear();
+  for (size_t rank = 0; rank < bags_.size(); ++rank) {
+    bags_[rank].reader->seek(timestamp);
+    bags_to_read_ahead_.push_back(rank);
+  }
+  read_head_ = timestamp;
+  topics_read_at_read_head_.clear();
+  skip_time_stamp_.reset();
+  topics_to_skip_.clear();
+}
+
+void MultiBagReader::add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks)
+{
+  for (auto & bag : bags_) {
+    bag.reader->add_event_callbacks(callbacks);
+  }
+}
+
+void MultiBagReader::check_open() const
+{
+  if (!is_open_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+}
+
+void MultiBagReader::merge_metadata()
+{
+  std::unordered_map<std::string, size_t> topic_indices;
+  std::optional<rcutils_time_point_value_t> starting_time;
+  std::optional<rcutils_time_point_value_t> ending_time;
+  metadata_ = bags_.front().reader->get_metadata();
+  metadata_.bag_size = 0;
+  metadata_.relative_file_paths.clear();
+  metadata_.files.clear();
+  metadata_.message_count = 0;
+  metadata_.topics_with_message_count.clear();
+
+  for (const auto & bag : bags_) {
+    const auto & bag_metadata = bag.reader->get_metadata();
+    metadata_.bag_size += bag_metadata.bag_size;
+    metadata_.relative_file_paths.insert(
+      metadata_.relative_file_paths.end(),
+      bag_metadata.relative_file_paths.begin(), bag_metadata.relative_file_paths.end());
+    metadata_.files.insert(
+      metadata_.files.end(), bag_metadata.files.begin(), bag_metadata.files.end());
+    metadata_.message_count += bag_metadata.message_count;
+    if (bag_metadata.message_count > 0) {
+      const auto bag_starting_time = bag_metadata.starting_time.time_since_epoch().count();
+      const auto bag_ending_time = bag_starting_time + bag_metadata.duration.count();
+      starting_time = std::min(starting_time.value_or(bag_starting_time), bag_starting_time);
+      ending_time = std::max(ending_time.value_or(bag_ending_time), bag_ending_time);
+    }
+    for (const auto & topic_information : bag_metadata.topics_with_message_count) {
+      const auto & name = topic_information.topic_metadata.name;
+      auto topic_index = topic_indices.find(name);
+      if (topic_index == topic_indices.end()) {
+        topic_indices.emplace(name, metadata_.topics_with_message_count.size());
+        metadata_.topics_with_message_count.push_back(topic_information);
+      } else {
+        metadata_.topics_with_message_count[topic_index->second].message_count +=
+          topic_information.message_count;
+      }
+    }
+  }
+  if (starting_time) {
+    metadata_.starting_time = decltype(metadata_.starting_time)(
+      std::chrono::nanoseconds(*starting_time));
+    metadata_.duration = std::chrono::nanoseconds(*ending_time - *starting_time);
+  }
+
+  topic_indices.clear();
+  for (size_t rank = 0; rank < bags_.size(); ++rank) {
+    for (auto & topic : bags_[rank].reader->get_all_topics_and_types()) {
+      auto topic_index = topic_indices.find(topic.name);
+      if (topic_index == topic_indices.end()) {
+        topic_indices.emplace(topic.name, topics_.size());
+        topics_.push_back(std::move(topic));
+      } else if (topics_[topic_index->second].type != topic.type) {
+        throw std::runtime_error(
+                "Topic '" + topic.name + "' has type '" + topics_[topic_index->second].type +
+                "' in one bag and type '" + topic.type + "' in bag '" +
+                bags_[rank].storage_options.uri + "'.");
+      }
+    }
+  }
+}
+
+void MultiBagReader::restart_at_read_head()
+{
+  const bool has_read_ahead = !next_messages_.empty() ||
+    bags_to_read_ahead_.size() != bags_.size();
+  if (!read_head_ && !has_read_ahead) {
+    // No messages were read from the bags since open()
+    return;
+  }
+  auto time_stamp = read_head_;
+  if (!time_stamp) {
+    const auto starting_time = metadata_.starting_time.time_since_epoch().count();
+    time_stamp = read_order_.reverse ? starting_time + metadata_.duration.count() : starting_time;
+  }
+  const auto read_head = read_head_;
+  const auto topics_read_at_read_head = topics_read_at_read_head_;
+  seek(*time_stamp);
+  read_head_ = read_head;
+  topics_read_at_read_head_ = topics_read_at_read_head;
+  skip_time_stamp_ = read_head_;
+  topics_to_skip_ = topics_read_at_read_head_;
+}
+
+void MultiBagReader::read_ahead()
+{
+  for (const auto rank : bags_to_read_ahead_) {
+    auto & reader = bags_[rank].reader;
+    while (reader->has_next()) {
+      auto message = reader->read_next();
+      if (skip_time_stamp_ && message->time_stamp == *skip_time_stamp_) {
+        // Drop the messages which were returned before the last restart
+        auto topic_to_skip = std::find(
+          topics_to_skip_.begin(), topics_to_skip_.end(), message->topic_name);
+        if (topic_to_skip != topics_to_skip_.end()) {
+          topics_to_skip_.erase(topic_to_skip);
+          continue;
+        }
+      }
+      next_messages_.push_back({std::move(message), rank});
+      std::push_heap(
+        next_messages_.begin(), next_messages_.end(),
+        [this](const NextMessage & lhs, const NextMessage & rhs) {return is_after(lhs, rhs);});
+      break;
+    }
+  }
+  bags_to_read_ahead_.clear();
+}
+
+bool MultiBagReader::is_after(const NextMessage & lhs, const NextMessage & rhs) const
+{
+  const auto lhs_time_stamp = lhs.message->time_stamp;
+  const auto rhs_time_stamp = rhs.message->time_stamp;
+  if (lhs_time_stamp != rhs_time_stamp) {
+    return read_order_.reverse ? lhs_time_stamp < rhs_time_stamp : lhs_time_stamp > rhs_time_stamp;
+  }
+  return lhs.rank > rhs.rank;
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
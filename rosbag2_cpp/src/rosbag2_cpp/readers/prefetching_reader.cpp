@@ -0,0 +1,312 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/asserts.hpp"
+
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+namespace
+{
+size_t serialized_size(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return message.serialized_data ? message.serialized_data->buffer_length : 0;
+}
+}  // namespace
+
+PrefetchingReader::PrefetchingReader(
+  std::unique_ptr<reader_interfaces::BaseReaderInterface> reader_impl,
+  size_t max_prefetched_bytes)
+: reader_impl_(std::move(reader_impl)),
+  max_prefetched_bytes_(max_prefetched_bytes)
+{
+  rcpputils::require_true(reader_impl_ != nullptr, "PrefetchingReader needs a reader to wrap.");
+}
+
+PrefetchingReader::~PrefetchingReader()
+{
+  close();
+}
+
+void PrefetchingReader::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  stop_prefetching();
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  discard_prefetched_messages();
+  reset_read_head(std::nullopt);
+  reader_impl_->open(storage_options, converter_options);
+  start_prefetching();
+}
+
+void PrefetchingReader::close()
+{
+  stop_prefetching();
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  discard_prefetched_messages();
+  reset_read_head(std::nullopt);
+  reader_impl_->close();
+}
+
+bool PrefetchingReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  const auto rewind_time_stamp = discard_prefetched_messages();
+  const bool read_order_set = reader_impl_->set_read_order(order);
+  rewind(rewind_time_stamp);
+  return read_order_set;
+}
+
+bool PrefetchingReader::has_next()
+{
+  if (!prefetch_thread_.joinable()) {
+    return reader_impl_->has_next();
+  }
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  return wait_for_prefetched_message(queue_lock);
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> PrefetchingReader::read_next()
+{
+  if (!prefetch_thread_.joinable()) {
+    return reader_impl_->read_next();
+  }
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+  {
+    std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+    if (!wait_for_prefetched_message(queue_lock)) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    message = std::move(prefetched_messages_.front());
+    prefetched_messages_.pop_front();
+    prefetched_bytes_ -= serialized_size(*message);
+    if (read_head_ != message->time_stamp) {
+      read_head_ = message->time_stamp;
+      topics_read_at_read_head_.clear();
+    }
+    topics_read_at_read_head_.push_back(message->topic_name);
+  }
+  message_taken_condition_var_.notify_all();
+  return message;
+}
+
+const rosbag2_storage::BagMetadata & PrefetchingReader::get_metadata() const
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  return reader_impl_->get_metadata();
+}
+
+std::vector<rosbag2_storage::TopicMetadata> PrefetchingReader::get_all_topics_and_types() const
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  return reader_impl_->get_all_topics_and_types();
+}
+
+void PrefetchingReader::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  reader_impl_->get_all_message_definitions(definitions);
+}
+
+void PrefetchingReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  const auto rewind_time_stamp = discard_prefetched_messages();
+  reader_impl_->set_filter(storage_filter);
+  rewind(rewind_time_stamp);
+}
+
+void PrefetchingReader::reset_filter()
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  const auto rewind_time_stamp = discard_prefetched_messages();
+  reader_impl_->reset_filter();
+  rewind(rewind_time_stamp);
+}
+
+rosbag2_storage::ReadEstimate PrefetchingReader::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  return reader_impl_->estimate(storage_filter);
+}
+
+void PrefetchingReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  discard_prefetched_messages();
+  reader_impl_->seek(timestamp);
+  reset_read_head(timestamp);
+}
+
+void PrefetchingReader::add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks)
+{
+  std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+  reader_impl_->add_event_callbacks(callbacks);
+}
+
+size_t PrefetchingReader::get_prefetched_bytes() const
+{
+  std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+  return prefetched_bytes_;
+}
+
+void PrefetchingReader::start_prefetching()
+{
+  {
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    stop_prefetching_ = false;
+  }
+  prefetch_thread_ = std::thread(&PrefetchingReader::prefetch_messages, this);
+}
+
+void PrefetchingReader::stop_prefetching()
+{
+  if (!prefetch_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    stop_prefetching_ = true;
+  }
+  message_taken_condition_var_.notify_all();
+  prefetch_thread_.join();
+}
+
+std::optional<rcutils_time_point_value_t> PrefetchingReader::discard_prefetched_messages()
+{
+  std::optional<rcutils_time_point_value_t> rewind_time_stamp;
+  {
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    if (!prefetched_messages_.empty()) {
+      rewind_time_stamp = read_head_ ? *read_head_ : prefetched_messages_.front()->time_stamp;
+    }
+    prefetched_messages_.clear();
+    prefetched_bytes_ = 0;
+    reader_at_end_ = false;
+    prefetch_error_ = nullptr;
+  }
+  // Reading ahead continues once reader_mutex_ is released
+  message_taken_condition_var_.notify_all();
+  return rewind_time_stamp;
+}
+
+void PrefetchingReader::rewind(const std::optional<rcutils_time_point_value_t> & time_stamp)
+{
+  if (!time_stamp) {
+    return;
+  }
+  reader_impl_->seek(*time_stamp);
+  std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+  skip_time_stamp_ = time_stamp;
+  topics_to_skip_.clear();
+  if (read_head_ == time_stamp) {
+    topics_to_skip_ = topics_read_at_read_head_;
+  }
+}
+
+void PrefetchingReader::reset_read_head(
+  const std::optional<rcutils_time_point_value_t> & time_stamp)
+{
+  std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+  read_head_ = time_stamp;
+  topics_read_at_read_head_.clear();
+  skip_time_stamp_.reset();
+  topics_to_skip_.clear();
+}
+
+bool PrefetchingReader::wait_for_prefetched_message(std::unique_lock<std::mutex> & queue_lock)
+{
+  message_read_condition_var_.wait(
+    queue_lock, [this] {return !prefetched_messages_.empty() || reader_at_end_;});
+  if (prefetched_messages_.empty() && prefetch_error_) {
+    // Let the next call read again, as it would without prefetching
+    auto error = prefetch_error_;
+    prefetch_error_ = nullptr;
+    reader_at_end_ = false;
+    message_taken_condition_var_.notify_all();
+    std::rethrow_exception(error);
+  }
+  return !prefetched_messages_.empty();
+}
+
+void PrefetchingReader::prefetch_messages()
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+      message_taken_condition_var_.wait(
+        queue_lock, [this] {
+          return stop_prefetching_ || (!reader_at_end_ &&
+          (prefetched_messages_.empty() || prefetched_bytes_ < max_prefetched_bytes_));
+        });
+      if (stop_prefetching_) {
+        return;
+      }
+    }
+
+    std::lock_guard<std::recursive_mutex> reader_lock(reader_mutex_);
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    std::exception_ptr error;
+    try {
+      if (reader_impl_->has_next()) {
+        message = reader_impl_->read_next();
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+      if (message && skip_time_stamp_) {
+        // Drop the messages which were returned before the last rewind
+        auto topic_to_skip = std::find(
+          topics_to_skip_.begin(), topics_to_skip_.end(), message->topic_name);
+        if (message->time_stamp != *skip_time_stamp_ || topic_to_skip == topics_to_skip_.end()) {
+          skip_time_stamp_.reset();
+          topics_to_skip_.clear();
+        } else {
+          topics_to_skip_.erase(topic_to_skip);
+          message.reset();
+          continue;
+        }
+      }
+      if (message) {
+        prefetched_bytes_ += serialized_size(*message);
+        prefetched_messages_.push_back(std::move(message));
+      } else {
+        reader_at_end_ = true;
+        prefetch_error_ = error;
+      }
+    }
+    message_read_condition_var_.notify_all();
+  }
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
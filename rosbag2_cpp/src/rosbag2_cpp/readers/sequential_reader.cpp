@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -24,6 +26,8 @@
 #include "rosbag2_cpp/logging.hpp"
 #include "rosbag2_cpp/readers/sequential_reader.hpp"
 
+#include "rosbag2_storage/ros_helper.hpp"
+
 
 namespace rosbag2_cpp
 {
@@ -77,17 +81,29 @@ SequentialReader::~SequentialReader()
 
 void SequentialReader::close()
 {
+  reset_standby_storage();
   if (storage_) {
     storage_.reset();
   }
+  payload_storage_.reset();
+  payload_storage_file_.clear();
+  file_start_times_.clear();
+  file_end_times_.clear();
+  uninstall_read_buffer_pool();
 }
 
 void SequentialReader::open(
   const rosbag2_storage::StorageOptions & storage_options,
   const ConverterOptions & converter_options)
 {
+  reset_standby_storage();
   storage_options_ = storage_options;
   base_folder_ = storage_options.uri;
+  conversion_threads_ = converter_options.conversion_threads;
+  parallel_converter_.reset();
+  file_start_times_.clear();
+  file_end_times_.clear();
+  install_read_buffer_pool();
 
   // If there is a metadata.yaml file present, load it.
   // If not, assume a single storage file, attempt to load, and ask storage for metadata.
@@ -102,6 +118,7 @@ void SequentialReader::open(
     }
     file_paths_ = details::resolve_relative_paths(
       storage_options.uri, metadata_.relative_file_paths, metadata_.version);
+    build_file_time_index();
     current_file_iterator_ = file_paths_.begin();
     load_current_file();
   } else {
@@ -124,6 +141,19 @@ void SequentialReader::open(
     file_paths_ = metadata_.relative_file_paths;
     current_file_iterator_ = file_paths_.begin();
   }
+  payload_resolver_.reset();
+  payload_delta_decoder_.reset();
+  payload_storage_.reset();
+  payload_storage_file_.clear();
+  if (metadata_.custom_data.count(kDeduplicatedPayloadsKey) > 0) {
+    payload_resolver_ =
+      std::make_unique<PayloadResolver>(storage_options_.deduplication_cache_size);
+  }
+  const auto delta_encoded_topics = metadata_.custom_data.find(kDeltaEncodedTopicsKey);
+  if (delta_encoded_topics != metadata_.custom_data.end()) {
+    payload_delta_decoder_ = std::make_unique<PayloadDeltaDecoder>(
+      split_delta_encoded_topics(delta_encoded_topics->second));
+  }
   auto topics = metadata_.topics_with_message_count;
   if (topics.empty()) {
     ROSBAG2_CPP_LOG_WARN("No topics were listed in metadata.");
@@ -138,13 +168,40 @@ void SequentialReader::open(
     topics[0].topic_metadata.serialization_format);
 }
 
+void SequentialReader::install_read_buffer_pool()
+{
+  uninstall_read_buffer_pool();
+  if (storage_options_.read_buffer_pool_size == 0 ||
+    rosbag2_storage::get_serialized_message_buffer_pool())
+  {
+    return;
+  }
+  read_buffer_pool_ =
+    std::make_shared<rosbag2_storage::BufferPool>(storage_options_.read_buffer_pool_size);
+  rosbag2_storage::set_serialized_message_buffer_pool(read_buffer_pool_);
+}
+
+void SequentialReader::uninstall_read_buffer_pool()
+{
+  if (!read_buffer_pool_) {
+    return;
+  }
+  // Messages still referring to the pool keep it alive
+  if (rosbag2_storage::get_serialized_message_buffer_pool() == read_buffer_pool_) {
+    rosbag2_storage::set_serialized_message_buffer_pool(nullptr);
+  }
+  read_buffer_pool_.reset();
+}
+
 bool SequentialReader::set_read_order(const rosbag2_storage::ReadOrder & order)
 {
   if (!storage_) {
     throw std::runtime_error("read order can only be set after open()");
   }
   read_order_ = order;
-  return storage_->set_read_order(read_order_);
+  const bool read_order_set = storage_->set_read_order(read_order_);
+  reset_standby_storage();
+  return read_order_set;
 }
 
 bool SequentialReader::has_next()
@@ -154,12 +211,10 @@ bool SequentialReader::has_next()
     // to read from there. Otherwise, check if there's another message.
     bool current_storage_has_next = storage_->has_next();
     if (!current_storage_has_next) {
-      if (!read_order_.reverse && has_next_file()) {
-        load_next_file();
-        return has_next();
-      }
-      if (read_order_.reverse && has_prev_file()) {
-        load_prev_file();
+      // Files without messages in the time window of the filter are not opened
+      const auto next_file = next_file_in_time_filter();
+      if (next_file != file_paths_.end()) {
+        load_file(next_file);
         return has_next();
       }
     }
@@ -176,7 +231,7 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialReader::read_ne
   if (storage_) {
     // performs rollover if necessary
     if (has_next()) {
-      auto message = storage_->read_next();
+      auto message = read_next_from_storage();
       return converter_ ? converter_->convert(message) : message;
     }
     throw std::runtime_error("Bag is at end. No next message.");
@@ -184,6 +239,66 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialReader::read_ne
   throw std::runtime_error("Bag is not open. Call open() before reading.");
 }
 
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+SequentialReader::read_next_batch(size_t max_messages, size_t max_bytes)
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  const bool convert_in_parallel = parallel_converter_ != nullptr;
+  size_t bytes = 0;
+  // has_next() performs the rollover to the next file between the batches of the storages
+  while ((max_messages == 0 || messages.size() < max_messages) &&
+    (max_bytes == 0 || bytes < max_bytes) && has_next())
+  {
+    auto batch = read_next_batch_from_storage(
+      max_messages == 0 ? 0 : max_messages - messages.size(),
+      max_bytes == 0 ? 0 : max_bytes - bytes);
+    if (batch.empty()) {
+      break;
+    }
+    for (auto & message : batch) {
+      if (message->serialized_data) {
+        bytes += message->serialized_data->buffer_length;
+      }
+      if (convert_in_parallel || !converter_) {
+        messages.push_back(std::move(message));
+      } else {
+        messages.push_back(converter_->convert(message));
+      }
+    }
+  }
+  if (convert_in_parallel) {
+    messages = parallel_converter_->convert(
+      std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>(
+        messages.begin(), messages.end()));
+  }
+  return messages;
+}
+
+void SequentialReader::for_each(const rosbag2_storage::MessageViewCallback & callback)
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  if (converter_ || parallel_converter_ || payload_resolver_ || payload_delta_decoder_) {
+    BaseReaderInterface::for_each(callback);
+    return;
+  }
+  bool stopped = false;
+  const auto visit =
+    [this, &callback, &stopped](const rosbag2_storage::SerializedBagMessageView & message) {
+      check_standby_storage_open_time(message.time_stamp);
+      stopped = !callback(message);
+      return !stopped;
+    };
+  // has_next() performs the rollover to the next file once the storage is read
+  while (!stopped && has_next()) {
+    storage_->for_each(visit);
+  }
+}
+
 const rosbag2_storage::BagMetadata & SequentialReader::get_metadata() const
 {
   rcpputils::check_true(storage_ != nullptr, "Bag is not open. Call open() before reading.");
@@ -208,7 +323,10 @@ void SequentialReader::set_filter(
 {
   topics_filter_ = storage_filter;
   if (storage_) {
-    storage_->set_filter(topics_filter_);
+    storage_->set_filter(
+      get_file_storage_filter(
+        static_cast<size_t>(current_file_iterator_ - file_paths_.begin()), get_storage_filter()));
+    reset_standby_storage();
     return;
   }
   throw std::runtime_error(
@@ -220,13 +338,56 @@ void SequentialReader::reset_filter()
   set_filter(rosbag2_storage::StorageFilter());
 }
 
+rosbag2_storage::ReadEstimate SequentialReader::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!storage_) {
+    throw std::runtime_error(
+            "Bag is not open. Call open() before estimating.");
+  }
+  const bool has_file_times = file_start_times_.size() == file_paths_.size();
+  rosbag2_storage::ReadEstimate estimate;
+  estimate.exact = true;
+  try {
+    for (size_t i = 0; i < file_paths_.size(); i++) {
+      if (has_file_times &&
+        ((storage_filter.start_time_ns >= 0 && file_end_times_[i] < storage_filter.start_time_ns) ||
+        (storage_filter.end_time_ns >= 0 && file_start_times_[i] > storage_filter.end_time_ns)))
+      {
+        continue;
+      }
+      const auto file_filter = get_file_storage_filter(i, storage_filter);
+      if (file_paths_.begin() + i == current_file_iterator_) {
+        estimate += storage_->estimate(file_filter);
+        continue;
+      }
+      auto storage_options = storage_options_;
+      storage_options.uri = file_paths_[i];
+      storage_options.readable_file = nullptr;
+      auto storage = storage_factory_->open_read_only(storage_options);
+      if (!storage) {
+        return rosbag2_storage::estimate_from_metadata(metadata_, storage_filter);
+      }
+      estimate += storage->estimate(file_filter);
+    }
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_DEBUG_STREAM("Estimating from the metadata of the bag: " << e.what());
+    return rosbag2_storage::estimate_from_metadata(metadata_, storage_filter);
+  }
+  return estimate;
+}
+
 void SequentialReader::seek(const rcutils_time_point_value_t & timestamp)
 {
   seek_time_ = timestamp;
+  reset_standby_storage();
   if (!storage_) {
     throw std::runtime_error(
             "Bag is not open. Call open() before seeking time.");
   }
+  if (seek_file(timestamp)) {
+    return;
+  }
 
   auto metadata = storage_->get_metadata();
   auto start_time = metadata.starting_time.time_since_epoch().count();
@@ -247,6 +408,104 @@ void SequentialReader::seek(const rcutils_time_point_value_t & timestamp)
   return;
 }
 
+void SequentialReader::build_file_time_index()
+{
+  if (metadata_.files.size() != file_paths_.size()) {
+    return;
+  }
+  std::vector<rcutils_time_point_value_t> start_times;
+  std::vector<rcutils_time_point_value_t> end_times;
+  start_times.reserve(metadata_.files.size());
+  end_times.reserve(metadata_.files.size());
+  for (const auto & file : metadata_.files) {
+    auto start_time = file.starting_time.time_since_epoch().count();
+    auto end_time = (file.starting_time + file.duration).time_since_epoch().count();
+    // Only the time window of a file referenced by a manifest belongs to the bag
+    if (file.window_start_time_ns >= 0) {
+      start_time = std::max<rcutils_time_point_value_t>(start_time, file.window_start_time_ns);
+    }
+    if (file.window_end_time_ns >= 0) {
+      end_time = std::min<rcutils_time_point_value_t>(end_time, file.window_end_time_ns);
+    }
+    // Binary search needs files ordered by time, as split bags are.
+    if (!start_times.empty() && (start_time < start_times.back() || end_time < end_times.back())) {
+      return;
+    }
+    start_times.push_back(start_time);
+    end_times.push_back(end_time);
+  }
+  file_start_times_ = std::move(start_times);
+  file_end_times_ = std::move(end_times);
+}
+
+bool SequentialReader::seek_file(const rcutils_time_point_value_t & timestamp)
+{
+  if (file_start_times_.empty() || file_start_times_.size() != file_paths_.size()) {
+    return false;
+  }
+  // Same files as stepping file by file from the current one: back to the last file starting at
+  // or before the time stamp, or forward to the first file ending at or after it.
+  const auto current = static_cast<size_t>(current_file_iterator_ - file_paths_.begin());
+  size_t target = current;
+  if (timestamp < file_start_times_[current]) {
+    const auto file = std::upper_bound(
+      file_start_times_.begin(), file_start_times_.begin() + current, timestamp);
+    target = file == file_start_times_.begin() ? 0 : file - file_start_times_.begin() - 1;
+  } else if (timestamp > file_end_times_[current]) {
+    const auto file = std::lower_bound(
+      file_end_times_.begin() + current + 1, file_end_times_.end(), timestamp);
+    target = std::min<size_t>(file - file_end_times_.begin(), file_paths_.size() - 1);
+  }
+
+  if (target == current) {
+    storage_->seek(timestamp);
+  } else {
+    load_file(file_paths_.begin() + target);
+  }
+  return true;
+}
+
+bool SequentialReader::is_outside_time_filter(size_t file_index) const
+{
+  if (file_start_times_.size() != file_paths_.size()) {
+    return false;
+  }
+  const auto filter = get_storage_filter();
+  return (filter.start_time_ns >= 0 && file_end_times_[file_index] < filter.start_time_ns) ||
+         (filter.end_time_ns >= 0 && file_start_times_[file_index] > filter.end_time_ns);
+}
+
+std::vector<std::string>::iterator SequentialReader::next_file_in_time_filter()
+{
+  auto file = current_file_iterator_;
+  while (read_order_.reverse ? file != file_paths_.begin() : file + 1 != file_paths_.end()) {
+    read_order_.reverse ? --file : ++file;
+    if (!is_outside_time_filter(static_cast<size_t>(file - file_paths_.begin()))) {
+      return file;
+    }
+  }
+  return file_paths_.end();
+}
+
+rosbag2_storage::StorageFilter SequentialReader::get_file_storage_filter(
+  size_t file_index, rosbag2_storage::StorageFilter storage_filter) const
+{
+  if (metadata_.files.size() != file_paths_.size() || file_index >= metadata_.files.size()) {
+    return storage_filter;
+  }
+  const auto & file = metadata_.files[file_index];
+  if (file.window_start_time_ns >= 0) {
+    storage_filter.start_time_ns = std::max<rcutils_time_point_value_t>(
+      storage_filter.start_time_ns, file.window_start_time_ns);
+  }
+  if (file.window_end_time_ns >= 0) {
+    storage_filter.end_time_ns = storage_filter.end_time_ns >= 0 ?
+      std::min<rcutils_time_point_value_t>(storage_filter.end_time_ns, file.window_end_time_ns) :
+      file.window_end_time_ns;
+  }
+  return storage_filter;
+}
+
 bool SequentialReader::has_next_file() const
 {
   return (current_file_iterator_ + 1) != file_paths_.end();
@@ -267,7 +526,9 @@ void SequentialReader::load_current_file()
   }
   // open and check storage exists
   storage_options_.uri = get_current_file();
+  storage_options_.readable_file = open_current_readable_file();
   storage_ = storage_factory_->open_read_only(storage_options_);
+  storage_options_.readable_file = nullptr;
   if (!storage_) {
     throw std::runtime_error{"No storage could be initialized. Abort"};
   }
@@ -277,28 +538,198 @@ void SequentialReader::load_current_file()
   set_filter(topics_filter_);
 }
 
+rosbag2_storage::StorageFilter SequentialReader::get_storage_filter() const
+{
+  return topics_filter_;
+}
+
 void SequentialReader::load_next_file()
 {
   assert(current_file_iterator_ != file_paths_.end());
-  auto info = std::make_shared<bag_events::BagSplitInfo>();
-  info->closed_file = get_current_file();
-  current_file_iterator_++;
-  info->opened_file = get_current_file();
-  load_current_file();
-  callback_manager_.execute_callbacks(bag_events::BagEvent::READ_SPLIT, info);
+  load_file(current_file_iterator_ + 1);
 }
 
 void SequentialReader::load_prev_file()
 {
   assert(current_file_iterator_ != file_paths_.begin());
+  load_file(current_file_iterator_ - 1);
+}
+
+void SequentialReader::load_file(std::vector<std::string>::iterator file)
+{
   auto info = std::make_shared<bag_events::BagSplitInfo>();
   info->closed_file = get_current_file();
-  current_file_iterator_--;
+  current_file_iterator_ = file;
   info->opened_file = get_current_file();
-  load_current_file();
+  if (load_standby_storage()) {
+    reset_standby_storage();
+  } else {
+    load_current_file();
+  }
   callback_manager_.execute_callbacks(bag_events::BagEvent::READ_SPLIT, info);
 }
 
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> SequentialReader::read_next_from_storage()
+{
+  auto message = storage_->read_next();
+  check_standby_storage_open_time(message->time_stamp);
+  if (payload_resolver_ || payload_delta_decoder_) {
+    resolve_payload(*message);
+  }
+  return message;
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+SequentialReader::read_next_batch_from_storage(size_t max_messages, size_t max_bytes)
+{
+  auto messages = storage_->read_next_batch(max_messages, max_bytes);
+  if (!messages.empty()) {
+    check_standby_storage_open_time(messages.back()->time_stamp);
+  }
+  if (payload_resolver_ || payload_delta_decoder_) {
+    for (auto & message : messages) {
+      resolve_payload(*message);
+    }
+  }
+  return messages;
+}
+
+void SequentialReader::resolve_payload(rosbag2_storage::SerializedBagMessage & message)
+{
+  const auto look_up = [this](const std::string & topic, const PayloadReference & reference) {
+      return look_up_payload(topic, reference);
+    };
+  if (payload_resolver_) {
+    payload_resolver_->resolve(message, look_up);
+  }
+  if (payload_delta_decoder_) {
+    payload_delta_decoder_->decode(message, look_up);
+  }
+}
+
+std::shared_ptr<rcutils_uint8_array_t> SequentialReader::look_up_payload(
+  const std::string & topic, const PayloadReference & reference)
+{
+  if (!payload_storage_ || payload_storage_file_ != get_current_file()) {
+    auto storage_options = storage_options_;
+    storage_options.uri = get_current_file();
+    storage_options.readable_file = open_current_readable_file();
+    payload_storage_ = storage_factory_->open_read_only(storage_options);
+    payload_storage_file_ = get_current_file();
+    if (!payload_storage_) {
+      return nullptr;
+    }
+  }
+  // The referenced message is on the same topic at the time stamp of the reference
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {topic};
+  filter.start_time_ns = reference.time_stamp;
+  filter.end_time_ns = reference.time_stamp;
+  payload_storage_->set_filter(filter);
+  payload_storage_->seek(reference.time_stamp);
+  while (payload_storage_->has_next()) {
+    auto message = payload_storage_->read_next();
+    const auto & payload = message->serialized_data;
+    if (payload && payload->buffer_length == reference.size &&
+      hash_payload(payload->buffer, payload->buffer_length) == reference.hash)
+    {
+      return payload;
+    }
+  }
+  return nullptr;
+}
+
+void SequentialReader::check_standby_storage_open_time(rcutils_time_point_value_t time_stamp)
+{
+  if (standby_storage_open_time_ &&
+    (read_order_.reverse ? time_stamp <= *standby_storage_open_time_ :
+    time_stamp >= *standby_storage_open_time_))
+  {
+    open_standby_storage();
+  }
+}
+
+void SequentialReader::reset_standby_storage()
+{
+  if (standby_storage_.valid()) {
+    try {
+      standby_storage_.get();
+    } catch (const std::exception &) {
+      // The file is opened again when it is read
+    }
+  }
+  standby_file_.clear();
+  standby_storage_open_time_.reset();
+
+  const double fraction = storage_options_.next_file_open_fraction;
+  if (fraction <= 0.0 || !storage_ || file_paths_.empty() || !can_open_next_file_ahead() ||
+    metadata_.files.size() != file_paths_.size() ||
+    next_file_in_time_filter() == file_paths_.end())
+  {
+    return;
+  }
+  // The time range of the file is known from the metadata without asking the storage
+  const auto & file = metadata_.files[current_file_iterator_ - file_paths_.begin()];
+  const auto start_time = file.starting_time.time_since_epoch().count();
+  const auto duration = file.duration.count();
+  const auto offset = static_cast<rcutils_duration_value_t>(std::min(fraction, 1.0) * duration);
+  standby_storage_open_time_ =
+    read_order_.reverse ? start_time + duration - offset : start_time + offset;
+}
+
+void SequentialReader::open_standby_storage()
+{
+  standby_storage_open_time_.reset();
+  const auto next_file = next_file_in_time_filter();
+  if (next_file == file_paths_.end()) {
+    return;
+  }
+  standby_file_ = *next_file;
+  auto storage_options = storage_options_;
+  storage_options.uri = standby_file_;
+  storage_options.readable_file = nullptr;
+  // Storage is opened like in load_current_file(). The storage factory is not used by this
+  // thread until the standby storage is loaded or reset.
+  standby_storage_ = std::async(
+    std::launch::async,
+    [storage_factory = storage_factory_.get(), storage_options, read_order = read_order_,
+    seek_time = seek_time_,
+    topics_filter = get_file_storage_filter(
+      static_cast<size_t>(next_file - file_paths_.begin()), get_storage_filter())]() {
+      auto storage = storage_factory->open_read_only(storage_options);
+      if (!storage) {
+        throw std::runtime_error{"No storage could be initialized. Abort"};
+      }
+      storage->set_read_order(read_order);
+      storage->seek(seek_time);
+      storage->set_filter(topics_filter);
+      return storage;
+    });
+}
+
+bool SequentialReader::load_standby_storage()
+{
+  if (!standby_storage_.valid()) {
+    return false;
+  }
+  if (standby_file_ != get_current_file()) {
+    reset_standby_storage();
+    return false;
+  }
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage;
+  try {
+    storage = standby_storage_.get();
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Failed to open " << standby_file_ << " ahead of reading it, opening it again: " <<
+        e.what());
+    return false;
+  }
+  storage_ = std::move(storage);
+  storage_options_.uri = get_current_file();
+  return true;
+}
+
 std::string SequentialReader::get_current_file() const
 {
   return *current_file_iterator_;
@@ -339,6 +770,16 @@ void SequentialReader::check_converter_serialization_format(
     for (const auto & topic_with_type : topics) {
       converter_->add_topic(topic_with_type.name, topic_with_type.type);
     }
+    if (conversion_threads_ > 1) {
+      ConverterOptions converter_options;
+      converter_options.input_serialization_format = storage_serialization_format;
+      converter_options.output_serialization_format = converter_serialization_format;
+      parallel_converter_ = std::make_unique<ParallelConverter>(
+        converter_options, converter_factory_, conversion_threads_);
+      for (const auto & topic_with_type : topics) {
+        parallel_converter_->add_topic(topic_with_type.name, topic_with_type.type);
+      }
+    }
   }
 }
 
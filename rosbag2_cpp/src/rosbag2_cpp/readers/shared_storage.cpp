@@ -0,0 +1,252 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/readers/shared_storage.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+SharedStorage::SharedStorage(
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> storage)
+: storage_(std::move(storage))
+{
+  if (!storage_) {
+    throw std::invalid_argument("SharedStorage needs an opened storage");
+  }
+  metadata_ = storage_->get_metadata();
+  topics_ = storage_->get_all_topics_and_types();
+  storage_->get_all_message_definitions(message_definitions_);
+}
+
+std::shared_ptr<SharedStorage> SharedStorage::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  rosbag2_storage::StorageFactoryInterface & storage_factory)
+{
+  auto storage = storage_factory.open_read_only(storage_options);
+  if (!storage) {
+    throw std::runtime_error{"No storage could be initialized from the inputs."};
+  }
+  return std::make_shared<SharedStorage>(std::move(storage));
+}
+
+std::shared_ptr<SharedStorage> SharedStorage::open(
+  const rosbag2_storage::StorageOptions & storage_options)
+{
+  rosbag2_storage::StorageFactory storage_factory;
+  return open(storage_options, storage_factory);
+}
+
+const rosbag2_storage::BagMetadata & SharedStorage::get_metadata() const
+{
+  return metadata_;
+}
+
+const std::vector<rosbag2_storage::TopicMetadata> & SharedStorage::get_all_topics_and_types() const
+{
+  return topics_;
+}
+
+const std::vector<rosbag2_storage::MessageDefinition> &
+SharedStorage::get_all_message_definitions() const
+{
+  return message_definitions_;
+}
+
+StorageCursor::StorageCursor(std::shared_ptr<SharedStorage> shared_storage, size_t batch_size)
+: shared_storage_(std::move(shared_storage)),
+  batch_size_(std::max<size_t>(batch_size, 1))
+{
+  if (!shared_storage_) {
+    throw std::invalid_argument("StorageCursor needs a shared storage");
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared_storage_->storage_mutex_);
+    id_ = shared_storage_->next_cursor_id_++;
+  }
+}
+
+void StorageCursor::open(const rosbag2_storage::StorageOptions &, const ConverterOptions &)
+{
+  throw std::runtime_error("A StorageCursor is opened by creating it on a SharedStorage");
+}
+
+void StorageCursor::close()
+{
+  messages_.clear();
+  shared_storage_.reset();
+}
+
+bool StorageCursor::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  if (order.sort_by != rosbag2_storage::ReadOrder::ReceivedTimestamp) {
+    return false;
+  }
+  discard_read_messages();
+  read_order_ = order;
+  return true;
+}
+
+bool StorageCursor::has_next()
+{
+  if (!shared_storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  if (messages_.empty() && !at_end_) {
+    read_batch();
+  }
+  return !messages_.empty();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> StorageCursor::read_next()
+{
+  if (!has_next()) {
+    throw std::runtime_error("No next message is available.");
+  }
+  auto message = std::move(messages_.front());
+  messages_.pop_front();
+  if (message->time_stamp != returned_time_stamp_) {
+    returned_time_stamp_ = message->time_stamp;
+    topics_returned_at_returned_time_stamp_.clear();
+  }
+  topics_returned_at_returned_time_stamp_.push_back(message->topic_name);
+  return message;
+}
+
+const rosbag2_storage::BagMetadata & StorageCursor::get_metadata() const
+{
+  return shared_storage().get_metadata();
+}
+
+std::vector<rosbag2_storage::TopicMetadata> StorageCursor::get_all_topics_and_types() const
+{
+  return shared_storage().get_all_topics_and_types();
+}
+
+void StorageCursor::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  definitions = shared_storage().get_all_message_definitions();
+}
+
+void StorageCursor::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  discard_read_messages();
+  storage_filter_ = storage_filter;
+}
+
+void StorageCursor::reset_filter()
+{
+  discard_read_messages();
+  storage_filter_ = rosbag2_storage::StorageFilter();
+}
+
+rosbag2_storage::ReadEstimate StorageCursor::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  shared_storage();
+  std::lock_guard<std::mutex> lock(shared_storage_->storage_mutex_);
+  return shared_storage_->storage_->estimate(storage_filter);
+}
+
+void StorageCursor::seek(const rcutils_time_point_value_t & timestamp)
+{
+  messages_.clear();
+  at_end_ = false;
+  storage_in_sync_ = false;
+  read_time_stamp_ = timestamp;
+  topics_read_at_read_time_stamp_.clear();
+  returned_time_stamp_ = timestamp;
+  topics_returned_at_returned_time_stamp_.clear();
+}
+
+void StorageCursor::add_event_callbacks(const bag_events::ReaderEventCallbacks &)
+{
+}
+
+const SharedStorage & StorageCursor::shared_storage() const
+{
+  if (!shared_storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  return *shared_storage_;
+}
+
+void StorageCursor::read_batch()
+{
+  std::lock_guard<std::mutex> lock(shared_storage_->storage_mutex_);
+  auto & storage = *shared_storage_->storage_;
+  auto topics_to_skip = topics_read_at_read_time_stamp_;
+  if (!storage_in_sync_ || shared_storage_->last_cursor_id_ != id_) {
+    if (!storage.set_read_order(read_order_)) {
+      throw std::runtime_error("The storage does not support the read order of the cursor");
+    }
+    storage.set_filter(storage_filter_);
+    // Storages may skip the messages at the seek time stamp which they returned last, possibly
+    // to another cursor. Seeking to another time stamp first makes them forget these.
+    storage.seek(read_time_stamp_ == 0 ? 1 : read_time_stamp_ - 1);
+    storage.seek(read_time_stamp_);
+    shared_storage_->last_cursor_id_ = id_;
+    storage_in_sync_ = true;
+  } else {
+    // The storage continues after the messages read last
+    topics_to_skip.clear();
+  }
+
+  while (messages_.empty()) {
+    auto batch = storage.read_next_batch(batch_size_);
+    if (batch.empty()) {
+      at_end_ = true;
+      return;
+    }
+    for (auto & message : batch) {
+      if (!topics_to_skip.empty()) {
+        // Drop the messages which this cursor has read before
+        auto topic_to_skip = std::find(
+          topics_to_skip.begin(), topics_to_skip.end(), message->topic_name);
+        if (message->time_stamp == read_time_stamp_ && topic_to_skip != topics_to_skip.end()) {
+          topics_to_skip.erase(topic_to_skip);
+          continue;
+        }
+        topics_to_skip.clear();
+      }
+      if (message->time_stamp != read_time_stamp_) {
+        read_time_stamp_ = message->time_stamp;
+        topics_read_at_read_time_stamp_.clear();
+      }
+      topics_read_at_read_time_stamp_.push_back(message->topic_name);
+      messages_.push_back(std::move(message));
+    }
+  }
+}
+
+void StorageCursor::discard_read_messages()
+{
+  messages_.clear();
+  at_end_ = false;
+  storage_in_sync_ = false;
+  read_time_stamp_ = returned_time_stamp_;
+  topics_read_at_read_time_stamp_ = topics_returned_at_returned_time_stamp_;
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
@@ -0,0 +1,312 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/readers/tailing_reader.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/logging.hpp"
+
+namespace rosbag2_cpp
+{
+namespace readers
+{
+
+TailingReader::TailingReader(
+  std::chrono::milliseconds poll_interval,
+  std::chrono::milliseconds idle_timeout,
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+  std::shared_ptr<SerializationFormatConverterFactoryInterface> converter_factory,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: poll_interval_(poll_interval),
+  idle_timeout_(idle_timeout),
+  storage_factory_(std::move(storage_factory)),
+  converter_factory_(std::move(converter_factory)),
+  metadata_io_(std::move(metadata_io))
+{}
+
+TailingReader::~TailingReader()
+{
+  close();
+}
+
+void TailingReader::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  close();
+  stopped_ = false;
+  storage_options_ = storage_options;
+  converter_options_ = converter_options;
+  base_folder_ = storage_options.uri;
+
+  const auto deadline = std::chrono::steady_clock::now() + idle_timeout_;
+  auto path = find_file(0);
+  while (path.empty()) {
+    if ((idle_timeout_.count() > 0 && std::chrono::steady_clock::now() >= deadline) ||
+      !wait_for(poll_interval_))
+    {
+      throw std::runtime_error("No file of the bag '" + base_folder_ + "' was created.");
+    }
+    path = find_file(0);
+  }
+  file_extension_ = rcpputils::fs::path(path).extension().string();
+  open_file(path);
+}
+
+void TailingReader::close()
+{
+  storage_.reset();
+  converter_.reset();
+  storage_serialization_format_.clear();
+  converter_topics_.clear();
+  metadata_ = rosbag2_storage::BagMetadata();
+  file_paths_.clear();
+  file_index_ = 0;
+  file_extension_.clear();
+  refresh_unsupported_ = false;
+}
+
+bool TailingReader::set_read_order(const rosbag2_storage::ReadOrder & order)
+{
+  return order.sort_by == rosbag2_storage::ReadOrder::File && !order.reverse;
+}
+
+bool TailingReader::has_next()
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  auto last_message_time = std::chrono::steady_clock::now();
+  // When the next file was found while the file being read gave no messages
+  std::optional<std::chrono::steady_clock::time_point> next_file_found_time;
+  while (true) {
+    if (storage_->has_next()) {
+      return true;
+    }
+    // Looked for before the refresh, so that the file being read was closed already if the
+    // refresh gives no messages
+    const bool finished = metadata_io_->metadata_file_exists(base_folder_);
+    const auto next_file = find_file(file_index_ + 1);
+    if (!refresh_unsupported_ && !storage_->refresh()) {
+      refresh_unsupported_ = true;
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "The storage of '" << get_current_file() << "' can not follow the messages appended to "
+          "it, it is only read up to where it was when it was opened.");
+    }
+    if (storage_->has_next()) {
+      return true;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (finished || !next_file.empty()) {
+      // A recorder splitting asynchronously may still commit the last messages of a file after
+      // it created the next one
+      if (finished || (next_file_found_time && now - *next_file_found_time >= poll_interval_)) {
+        if (next_file.empty()) {
+          return false;
+        }
+        auto info = std::make_shared<bag_events::BagSplitInfo>();
+        info->closed_file = get_current_file();
+        ++file_index_;
+        open_file(next_file);
+        info->opened_file = get_current_file();
+        callback_manager_.execute_callbacks(bag_events::BagEvent::READ_SPLIT, info);
+        next_file_found_time.reset();
+        last_message_time = now;
+        continue;
+      }
+      if (!next_file_found_time) {
+        next_file_found_time = now;
+      }
+    }
+    if (idle_timeout_.count() > 0 && now - last_message_time >= idle_timeout_) {
+      return false;
+    }
+    if (!wait_for(poll_interval_)) {
+      return false;
+    }
+  }
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> TailingReader::read_next()
+{
+  if (!has_next()) {
+    throw std::runtime_error("Bag is at end. No next message.");
+  }
+  auto message = storage_->read_next();
+  if (!converter_options_.output_serialization_format.empty() &&
+    converter_topics_.count(message->topic_name) == 0)
+  {
+    add_new_topics_to_converter();
+  }
+  return converter_ ? converter_->convert(message) : message;
+}
+
+const rosbag2_storage::BagMetadata & TailingReader::get_metadata() const
+{
+  return metadata_;
+}
+
+std::vector<rosbag2_storage::TopicMetadata> TailingReader::get_all_topics_and_types() const
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  return storage_->get_all_topics_and_types();
+}
+
+void TailingReader::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & definitions)
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  storage_->get_all_message_definitions(definitions);
+}
+
+void TailingReader::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
+{
+  storage_filter_ = storage_filter;
+  if (storage_) {
+    storage_->set_filter(storage_filter_);
+  }
+}
+
+void TailingReader::reset_filter()
+{
+  storage_filter_ = rosbag2_storage::StorageFilter();
+  if (storage_) {
+    storage_->reset_filter();
+  }
+}
+
+void TailingReader::seek(const rcutils_time_point_value_t & timestamp)
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before reading.");
+  }
+  storage_->seek(timestamp);
+}
+
+void TailingReader::add_event_callbacks(const bag_events::ReaderEventCallbacks & callbacks)
+{
+  if (callbacks.read_split_callback) {
+    callback_manager_.add_event_callback(
+      callbacks.read_split_callback,
+      bag_events::BagEvent::READ_SPLIT);
+  }
+}
+
+void TailingReader::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    stopped_ = true;
+  }
+  stop_condition_.notify_all();
+}
+
+std::string TailingReader::get_current_file() const
+{
+  return file_paths_.empty() ? std::string() : file_paths_.back();
+}
+
+std::string TailingReader::find_file(size_t index) const
+{
+  // Named like the files of SequentialWriter
+  const auto stem = rcpputils::fs::path(base_folder_).filename().string() + "_" +
+    std::to_string(index);
+  if (!file_extension_.empty()) {
+    const auto path = rcpputils::fs::path(base_folder_) / (stem + file_extension_);
+    return path.exists() ? path.string() : std::string();
+  }
+  // Files next to the file of the storage, like the write-ahead log of SQLite in
+  // <bag>_0.db3-wal, have longer names than the file itself
+  std::string path;
+  std::error_code ec;
+  for (const auto & entry : std::filesystem::directory_iterator(base_folder_, ec)) {
+    if (entry.path().stem().string() != stem || !entry.is_regular_file(ec)) {
+      continue;
+    }
+    if (path.empty() || entry.path().string().size() < path.size()) {
+      path = entry.path().string();
+    }
+  }
+  return path;
+}
+
+void TailingReader::open_file(const std::string & path)
+{
+  auto storage_options = storage_options_;
+  storage_options.uri = path;
+  auto storage = storage_factory_->open_read_only(storage_options);
+  if (!storage) {
+    throw std::runtime_error("No storage could be initialized for '" + path + "'.");
+  }
+  if (!storage->set_read_order(
+      rosbag2_storage::ReadOrder(rosbag2_storage::ReadOrder::File, false)))
+  {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Could not set file order to read '" << path << "', messages may be missed.");
+  }
+  storage->set_filter(storage_filter_);
+  storage_ = std::move(storage);
+  file_paths_.push_back(path);
+  refresh_unsupported_ = false;
+  metadata_ = storage_->get_metadata();
+  metadata_.relative_file_paths = file_paths_;
+}
+
+void TailingReader::add_new_topics_to_converter()
+{
+  const auto & output_format = converter_options_.output_serialization_format;
+  for (const auto & topic : storage_->get_all_topics_and_types()) {
+    if (!converter_topics_.insert(topic.name).second) {
+      continue;
+    }
+    if (storage_serialization_format_.empty()) {
+      storage_serialization_format_ = topic.serialization_format;
+    } else if (topic.serialization_format != storage_serialization_format_) {
+      throw std::runtime_error(
+              "Topics with different rmw serialization format have been found. "
+              "All topics must have the same serialization format.");
+    }
+    if (!converter_ && storage_serialization_format_ != output_format) {
+      converter_ = std::make_unique<Converter>(
+        storage_serialization_format_, output_format, converter_factory_);
+    }
+    if (converter_) {
+      converter_->add_topic(topic.name, topic.type);
+    }
+  }
+}
+
+bool TailingReader::wait_for(std::chrono::milliseconds duration)
+{
+  std::unique_lock<std::mutex> lock(stop_mutex_);
+  return !stop_condition_.wait_for(lock, duration, [this]() {return stopped_.load();});
+}
+
+}  // namespace readers
+}  // namespace rosbag2_cpp
@@ -21,12 +21,19 @@
 // This notice must appear in all copies of this file and its derivatives.
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -50,46 +57,7 @@ Reindexer::Reindexer(
   metadata_io_(std::move(metadata_io))
 {
   regex_bag_pattern_ = R"(.+_(\d+)\.([a-zA-Z0-9])+)";
-}
-
-/// Determine which path should be placed first in a vector ordered by file number.
-/**
- * Used to re-order discovered bag files, since the filesystem discovery functions
- * don't guarantee a preserved order
- */
-bool Reindexer::compare_relative_file(
-  const rcpputils::fs::path & first_path,
-  const rcpputils::fs::path & second_path)
-{
-  std::regex regex_rule(regex_bag_pattern_, std::regex_constants::ECMAScript);
-
-  std::smatch first_match;
-  std::smatch second_match;
-
-  auto first_path_string = first_path.string();
-  auto second_path_string = second_path.string();
-
-  auto first_regex_good = std::regex_match(first_path_string, first_match, regex_rule);
-  auto second_regex_good = std::regex_match(second_path_string, second_match, regex_rule);
-
-  if (!first_regex_good) {
-    std::stringstream ss;
-    ss << "Path " << first_path.string() <<
-      "didn't meet expected naming convention: " << regex_bag_pattern_;
-    std::string error_text = ss.str();
-    throw std::runtime_error(error_text.c_str());
-  } else if (!second_regex_good) {
-    std::stringstream ss;
-    ss << "Path " << second_path.string() <<
-      "didn't meet expected naming convention: " << regex_bag_pattern_;
-    std::string error_text = ss.str();
-    throw std::runtime_error(error_text.c_str());
-  }
-
-  auto first_file_num = std::stoul(first_match.str(1), nullptr, 10);
-  auto second_file_num = std::stoul(second_match.str(1), nullptr, 10);
-
-  return first_file_num < second_file_num;
+  regex_bag_rule_ = std::regex(regex_bag_pattern_, std::regex_constants::ECMAScript);
 }
 
 /// Retrieve bag storage files from the bag directory.
@@ -102,7 +70,6 @@ void Reindexer::get_bag_files(
   const rcpputils::fs::path & base_folder,
   std::vector<rcpputils::fs::path> & output)
 {
-  std::regex regex_rule(regex_bag_pattern_, std::regex_constants::ECMAScript);
   auto allocator = rcutils_get_default_allocator();
   auto dir_iter = rcutils_dir_iter_start(base_folder.string().c_str(), allocator);
 
@@ -111,23 +78,28 @@ void Reindexer::get_bag_files(
     throw std::runtime_error("Empty directory.");
   }
 
-  // Get all file names in directory
+  // Get all file names in directory, along with their file number.
+  // The filesystem discovery functions don't guarantee a preserved order.
+  std::vector<std::pair<uint64_t, rcpputils::fs::path>> numbered_files;
   do {
     auto found_file = rcpputils::fs::path(dir_iter->entry_name);
     ROSBAG2_CPP_LOG_DEBUG_STREAM("Found file: " << found_file.string());
 
-    if (std::regex_match(found_file.string(), regex_rule)) {
-      auto full_path = base_folder / found_file;
-      output.emplace_back(full_path);
+    const auto file_name = found_file.string();
+    std::smatch match;
+    if (std::regex_match(file_name, match, regex_bag_rule_)) {
+      numbered_files.emplace_back(std::stoull(match.str(1), nullptr, 10), base_folder / found_file);
     }
   } while (rcutils_dir_iter_next(dir_iter));
+  rcutils_dir_iter_end(dir_iter);
 
   // Sort relative file path by number
-  std::sort(
-    output.begin(), output.end(),
-    [&, this](rcpputils::fs::path a, rcpputils::fs::path b) {
-      return compare_relative_file(a, b);
-    });
+  std::stable_sort(
+    numbered_files.begin(), numbered_files.end(),
+    [](const auto & a, const auto & b) {return a.first < b.first;});
+  for (auto & numbered_file : numbered_files) {
+    output.emplace_back(std::move(numbered_file.second));
+  }
 }
 
 /// Prepare a fresh BagMetadata object for reindexing.
@@ -152,16 +124,111 @@ void Reindexer::init_metadata(
   }
 }
 
+/// Open a bag file read-only and get its metadata from the storage plugin
+rosbag2_storage::BagMetadata Reindexer::read_metadata_of_file(
+  const rcpputils::fs::path & file,
+  const rosbag2_storage::StorageOptions & storage_options)
+{
+  ROSBAG2_CPP_LOG_DEBUG_STREAM("Extracting from file: " + file.string());
+  rosbag2_storage::StorageOptions temp_so = {
+    file.string(),
+    storage_options.storage_id,
+    storage_options.max_bagfile_size,
+    storage_options.max_bagfile_duration,
+    storage_options.max_cache_size,
+    storage_options.storage_config_uri
+  };
+  temp_so.metadata_only = storage_options.metadata_only;
+  auto storage = storage_factory_->open_read_only(temp_so);
+  if (!storage) {
+    throw std::runtime_error{"No storage could be initialized for file " + file.string()};
+  }
+  return storage->get_metadata();
+}
+
+/// Open the bag files on a pool of threads and pass the metadata of every file on
+/**
+ * Opening a file makes its storage plugin read or reconstruct the metadata of the file, which
+ * takes the bulk of the reindexing time. Files are independent of each other, so they are
+ * opened concurrently on up to one thread per hardware thread.
+ * The metadata of a file is handed to on_file_metadata as soon as the metadata of all previous
+ * files was handed on, so that it does not have to be kept until all files are read.
+ * on_file_metadata is called in the order of files, and never concurrently.
+ * Files with an entry in the metadata journal of the bag are not opened.
+ * @param: files The list of bag files to reindex
+ * @param: storage_options Used to open the bag files
+ * @param: journaled_metadata Metadata of files from the journal, by file name
+ * @param: on_file_metadata Called with the index and the metadata of every file
+ */
+void Reindexer::read_file_metadata(
+  const std::vector<rcpputils::fs::path> & files,
+  const rosbag2_storage::StorageOptions & storage_options,
+  const std::unordered_map<std::string, rosbag2_storage::BagMetadata> & journaled_metadata,
+  const std::function<void(size_t, const rosbag2_storage::BagMetadata &)> & on_file_metadata)
+{
+  std::atomic_size_t next_file{0};
+  std::mutex mutex;
+  // Metadata of files which were read before all of their previous files
+  std::vector<std::optional<rosbag2_storage::BagMetadata>> read_metadata(files.size());
+  size_t next_file_to_hand_on = 0;
+  std::exception_ptr error;
+
+  auto worker = [&]() {
+      for (size_t i = next_file++; i < files.size(); i = next_file++) {
+        try {
+          rosbag2_storage::BagMetadata metadata;
+          auto journaled = journaled_metadata.find(files[i].filename().string());
+          if (journaled != journaled_metadata.end()) {
+            metadata = journaled->second;
+          } else {
+            metadata = read_metadata_of_file(files[i], storage_options);
+          }
+
+          std::lock_guard<std::mutex> lock(mutex);
+          if (error) {
+            return;
+          }
+          read_metadata[i] = std::move(metadata);
+          while (next_file_to_hand_on < files.size() && read_metadata[next_file_to_hand_on]) {
+            on_file_metadata(next_file_to_hand_on, *read_metadata[next_file_to_hand_on]);
+            read_metadata[next_file_to_hand_on].reset();
+            next_file_to_hand_on++;
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+          // Let the other workers run out of files
+          next_file = files.size();
+        }
+      }
+    };
+
+  const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t thread_count = std::min(hardware_threads, files.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 /// Iterate through the bag files to collect various metadata parameters
 /**
  * Collects the topic metadata, `starting_time`, and `duration` portions of the `BagMetadata`
  * being constructed
  * @param: files The list of bag files to reindex
- * @param: storage_options Used to construct the `Reader` needed to parse the bag files
+ * @param: storage_options Used to open the bag files
  */
 void Reindexer::aggregate_metadata(
   const std::vector<rcpputils::fs::path> & files,
-  const std::unique_ptr<rosbag2_cpp::readers::SequentialReader> & bag_reader,
   const rosbag2_storage::StorageOptions & storage_options)
 {
   std::map<std::string, rosbag2_storage::TopicInformation> temp_topic_info;
@@ -170,60 +237,56 @@ void Reindexer::aggregate_metadata(
   // visit each of the contained relative files files in the bag,
   // open them, read the info, and write it into an aggregated metadata object.
   ROSBAG2_CPP_LOG_DEBUG_STREAM("Extracting metadata from bag file(s)");
-  for (const auto & f_ : files) {
-    ROSBAG2_CPP_LOG_DEBUG_STREAM("Extracting from file: " + f_.string());
-
-    metadata_.bag_size += f_.file_size();
-
-    // Set up reader
-    rosbag2_storage::StorageOptions temp_so = {
-      f_.string(),
-      storage_options.storage_id,
-      storage_options.max_bagfile_size,
-      storage_options.max_bagfile_duration,
-      storage_options.max_cache_size,
-      storage_options.storage_config_uri
-    };
-
-    // We aren't actually interested in reading messages, so use a blank converter option
-    rosbag2_cpp::ConverterOptions blank_converter_options {};
-    bag_reader->open(temp_so, blank_converter_options);
-    auto temp_metadata = bag_reader->get_metadata();
-    metadata_.storage_identifier = temp_metadata.storage_identifier;
-
-    if (temp_metadata.starting_time < metadata_.starting_time) {
-      metadata_.starting_time = temp_metadata.starting_time;
+  // Files which were closed while the bag was recorded are in the metadata journal
+  std::unordered_map<std::string, rosbag2_storage::BagMetadata> journaled_metadata;
+  for (auto & entry : metadata_io_->read_metadata_journal(base_folder_.string())) {
+    if (entry.relative_file_paths.size() == 1) {
+      const auto file_name = rcpputils::fs::path(entry.relative_file_paths.front()).filename();
+      journaled_metadata[file_name.string()] = std::move(entry);
     }
-    metadata_.duration += temp_metadata.duration;
-    ROSBAG2_CPP_LOG_DEBUG_STREAM("New duration: " + std::to_string(metadata_.duration.count()));
-    metadata_.message_count += temp_metadata.message_count;
+  }
+  if (!journaled_metadata.empty()) {
+    ROSBAG2_CPP_LOG_INFO_STREAM(
+      "Taking the metadata of " << journaled_metadata.size() << " file(s) from the journal");
+  }
+  read_file_metadata(
+    files, storage_options, journaled_metadata,
+    [&](size_t i, const rosbag2_storage::BagMetadata & temp_metadata) {
+      metadata_.bag_size += files[i].file_size();
 
-    // Add the topic metadata
-    for (const auto & topic : temp_metadata.topics_with_message_count) {
-      auto found_topic = temp_topic_info.find(topic.topic_metadata.name);
-      if (found_topic == temp_topic_info.end()) {
-        // It's a new topic. Add it.
-        temp_topic_info[topic.topic_metadata.name] = topic;
-      } else {
-        ROSBAG2_CPP_LOG_DEBUG_STREAM("Found topic!");
-        // Merge in the new information
-        found_topic->second.message_count += topic.message_count;
-        if (!topic.topic_metadata.offered_qos_profiles.empty()) {
-          found_topic->second.topic_metadata.offered_qos_profiles =
-            topic.topic_metadata.offered_qos_profiles;
-        }
-        if (topic.topic_metadata.serialization_format != "") {
-          found_topic->second.topic_metadata.serialization_format =
-            topic.topic_metadata.serialization_format;
-        }
-        if (topic.topic_metadata.type != "") {
-          found_topic->second.topic_metadata.type = topic.topic_metadata.type;
+      metadata_.storage_identifier = temp_metadata.storage_identifier;
+
+      if (temp_metadata.starting_time < metadata_.starting_time) {
+        metadata_.starting_time = temp_metadata.starting_time;
+      }
+      metadata_.duration += temp_metadata.duration;
+      ROSBAG2_CPP_LOG_DEBUG_STREAM("New duration: " + std::to_string(metadata_.duration.count()));
+      metadata_.message_count += temp_metadata.message_count;
+
+      // Add the topic metadata
+      for (const auto & topic : temp_metadata.topics_with_message_count) {
+        auto found_topic = temp_topic_info.find(topic.topic_metadata.name);
+        if (found_topic == temp_topic_info.end()) {
+          // It's a new topic. Add it.
+          temp_topic_info[topic.topic_metadata.name] = topic;
+        } else {
+          ROSBAG2_CPP_LOG_DEBUG_STREAM("Found topic!");
+          // Merge in the new information
+          found_topic->second.message_count += topic.message_count;
+          if (!topic.topic_metadata.offered_qos_profiles.empty()) {
+            found_topic->second.topic_metadata.offered_qos_profiles =
+              topic.topic_metadata.offered_qos_profiles;
+          }
+          if (topic.topic_metadata.serialization_format != "") {
+            found_topic->second.topic_metadata.serialization_format =
+              topic.topic_metadata.serialization_format;
+          }
+          if (topic.topic_metadata.type != "") {
+            found_topic->second.topic_metadata.type = topic.topic_metadata.type;
+          }
         }
       }
-    }
-
-    bag_reader->close();
-  }
+    });
 
   // Convert the topic map into topic metadata
   for (auto & topic : temp_topic_info) {
@@ -231,36 +294,48 @@ void Reindexer::aggregate_metadata(
   }
 }
 
-/// Reconstruct a bag's `metadata.yaml` file from the enclosed bag files.
+/// Reconstruct a bag's metadata from the enclosed bag files.
 /**
- * The reindexer opens the files within the bag directory and uses the metadata of the files to
- * reconstruct the metadata file. Currently does not support compressed bags.
+ * The reindexer opens the files within the bag directory and aggregates the metadata of the files.
+ * Files which have an entry in the metadata journal written while recording are not opened.
+ * Currently does not support compressed bags.
  * @param: storage_options The best-guess original storage options for the bag
+ * @return: The reconstructed metadata
  */
-void Reindexer::reindex(const rosbag2_storage::StorageOptions & storage_options)
+rosbag2_storage::BagMetadata Reindexer::reconstruct_metadata(
+  const rosbag2_storage::StorageOptions & storage_options)
 {
   base_folder_ = storage_options.uri;
-  ROSBAG2_CPP_LOG_INFO_STREAM("Beginning reindexing bag in directory: " << base_folder_);
-
-  auto metadata_io_default = std::make_unique<rosbag2_storage::MetadataIo>();
-  auto bag_reader = std::make_unique<rosbag2_cpp::readers::SequentialReader>(
-    std::move(storage_factory_), converter_factory_, std::move(metadata_io_default));
 
   // Identify all bag files
   std::vector<rcpputils::fs::path> files;
   get_bag_files(base_folder_, files);
   if (files.empty()) {
-    throw std::runtime_error("No storage files found for reindexing. Abort");
+    throw std::runtime_error("No storage files found in bag directory " + base_folder_.string());
   }
 
   init_metadata(files, storage_options);
   ROSBAG2_CPP_LOG_DEBUG_STREAM("Completed init_metadata");
 
   // Collect all metadata from files
-  aggregate_metadata(files, bag_reader, storage_options);
+  aggregate_metadata(files, storage_options);
   ROSBAG2_CPP_LOG_DEBUG_STREAM("Completed aggregate_metadata");
+  return metadata_;
+}
+
+/// Reconstruct a bag's `metadata.yaml` file from the enclosed bag files.
+/**
+ * The reindexer opens the files within the bag directory and uses the metadata of the files to
+ * reconstruct the metadata file. Currently does not support compressed bags.
+ * @param: storage_options The best-guess original storage options for the bag
+ */
+void Reindexer::reindex(const rosbag2_storage::StorageOptions & storage_options)
+{
+  ROSBAG2_CPP_LOG_INFO_STREAM("Beginning reindexing bag in directory: " << storage_options.uri);
+  reconstruct_metadata(storage_options);
 
   metadata_io_->write_metadata(base_folder_.string(), metadata_);
+  metadata_io_->remove_metadata_journal(base_folder_.string());
   ROSBAG2_CPP_LOG_INFO("Reindexing complete.");
 }
 }  // namespace rosbag2_cpp
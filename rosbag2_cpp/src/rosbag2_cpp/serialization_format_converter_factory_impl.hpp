@@ -18,6 +18,7 @@
 #include "rosbag2_cpp/serialization_format_converter_factory_interface.hpp"
 
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "rosbag2_cpp/converter_interfaces/serialization_format_converter.hpp"
 #include "rosbag2_cpp/logging.hpp"
 #include "rosbag2_cpp/visibility_control.hpp"
+#include "rosbag2_storage/class_loader_cache.hpp"
 
 #include "./rmw_implemented_serialization_format_converter.hpp"
 
@@ -40,20 +42,19 @@ class SerializationFormatConverterFactoryImpl
 public:
   SerializationFormatConverterFactoryImpl()
   {
+    // The class loaders are shared by all converter factories of the process, every access goes
+    // through rosbag2_storage::get_class_loader_mutex()
     try {
-      converter_class_loader_ =
-        std::make_unique<pluginlib::ClassLoader<
-            converter_interfaces::SerializationFormatConverter>>(
+      converter_class_loader_ = rosbag2_storage::get_cached_class_loader<
+        converter_interfaces::SerializationFormatConverter>(
         "rosbag2_cpp",
         converter_interfaces::SerializationFormatConverter::get_base_class_name());
-      serializer_class_loader_ =
-        std::make_shared<pluginlib::ClassLoader<
-            converter_interfaces::SerializationFormatSerializer>>(
+      serializer_class_loader_ = rosbag2_storage::get_cached_class_loader<
+        converter_interfaces::SerializationFormatSerializer>(
         "rosbag2_cpp",
         converter_interfaces::SerializationFormatSerializer::get_base_class_name());
-      deserializer_class_loader_ =
-        std::make_shared<pluginlib::ClassLoader<
-            converter_interfaces::SerializationFormatDeserializer>>(
+      deserializer_class_loader_ = rosbag2_storage::get_cached_class_loader<
+        converter_interfaces::SerializationFormatDeserializer>(
         "rosbag2_cpp",
         converter_interfaces::SerializationFormatDeserializer::get_base_class_name());
     } catch (const std::exception & e) {
@@ -78,6 +79,7 @@ public:
 
   std::vector<std::string> get_declared_serialization_plugins() const
   {
+    std::lock_guard<std::recursive_mutex> lock(rosbag2_storage::get_class_loader_mutex());
     return serializer_class_loader_->getDeclaredClasses();
   }
 
@@ -105,6 +107,7 @@ private:
     std::shared_ptr<pluginlib::ClassLoader<SerializationFormatIface>> class_loader)
   {
     const auto converter_id = format + converter_suffix;
+    std::unique_lock<std::recursive_mutex> lock(rosbag2_storage::get_class_loader_mutex());
     if (is_plugin_registered(
         converter_id,
         converter_class_loader_->getDeclaredClasses(),
@@ -127,6 +130,7 @@ private:
             ex.what() << ". Falling back to RMW implementation search.");
       }
     }
+    lock.unlock();
 
     ROSBAG2_CPP_LOG_INFO_STREAM(
       "No plugin found providing serialization format '" << format << "'. " <<
@@ -139,7 +143,7 @@ private:
     return nullptr;
   }
 
-  std::unique_ptr<
+  std::shared_ptr<
     pluginlib::ClassLoader<converter_interfaces::SerializationFormatConverter>>
   converter_class_loader_;
   std::shared_ptr<
@@ -0,0 +1,109 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/thread_scheduling.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/logging.hpp"
+
+namespace rosbag2_cpp
+{
+
+void apply_thread_scheduling(const std::string & thread_name, const ThreadScheduling & scheduling)
+{
+  if (scheduling.is_default()) {
+    return;
+  }
+#ifdef __linux__
+  if (scheduling.priority > 0) {
+    int policy = SCHED_FIFO;
+    if (scheduling.policy == "rr") {
+      policy = SCHED_RR;
+    } else if (scheduling.policy != "fifo") {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Unknown scheduling policy '" << scheduling.policy << "' of the " << thread_name <<
+          " thread. Using \"fifo\".");
+    }
+    sched_param param{};
+    param.sched_priority = scheduling.priority;
+    const int ret = pthread_setschedparam(pthread_self(), policy, &param);
+    if (ret != 0) {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Failed to set " << scheduling.policy << " priority " << scheduling.priority <<
+          " of the " << thread_name << " thread: " << std::strerror(ret));
+    }
+  }
+  if (!scheduling.cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto cpu : scheduling.cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpu_set);
+      }
+    }
+    const int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (ret != 0) {
+      ROSBAG2_CPP_LOG_WARN_STREAM(
+        "Failed to pin the " << thread_name << " thread to CPUs: " << std::strerror(ret));
+    }
+  }
+#else
+  ROSBAG2_CPP_LOG_WARN_STREAM(
+    "Priority and CPUs of the " << thread_name << " thread can only be set on Linux. "
+      "Ignoring them.");
+#endif
+}
+
+std::vector<size_t> get_numa_node_cpus(int numa_node)
+{
+  std::vector<size_t> cpus;
+  if (numa_node < 0) {
+    return cpus;
+  }
+  // A list of CPUs and ranges of CPUs like "0-7,16-23"
+  std::ifstream cpu_list_file(
+    "/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+  std::string cpu_list;
+  if (!std::getline(cpu_list_file, cpu_list)) {
+    return cpus;
+  }
+  std::istringstream ranges(cpu_list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    try {
+      const auto dash = range.find('-');
+      const size_t first = std::stoul(range.substr(0, dash));
+      const size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (size_t cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception &) {
+      return {};
+    }
+  }
+  return cpus;
+}
+
+}  // namespace rosbag2_cpp
@@ -0,0 +1,64 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Only built with ROSBAG2_ENABLE_TRACING
+
+#include "rosbag2_cpp/tracing.hpp"
+
+#define TRACEPOINT_CREATE_PROBES
+#define TRACEPOINT_DEFINE
+#include "rosbag2_cpp/tracing_provider.h"
+
+namespace rosbag2_cpp
+{
+namespace tracing
+{
+
+void stage_begin(uint8_t stage)
+{
+  tracepoint(ros2_rosbag2, stage_begin, stage);
+}
+
+void stage_end(uint8_t stage)
+{
+  tracepoint(ros2_rosbag2, stage_end, stage);
+}
+
+void cache_swap_buffers(size_t messages)
+{
+  tracepoint(ros2_rosbag2, cache_swap_buffers, static_cast<uint64_t>(messages));
+}
+
+void player_read(const char * topic_name, int64_t time_stamp)
+{
+  tracepoint(ros2_rosbag2, player_read, topic_name, time_stamp);
+}
+
+void player_enqueue(const char * topic_name, int64_t time_stamp)
+{
+  tracepoint(ros2_rosbag2, player_enqueue, topic_name, time_stamp);
+}
+
+void player_wake(int64_t time_stamp, bool due)
+{
+  tracepoint(ros2_rosbag2, player_wake, time_stamp, static_cast<uint8_t>(due));
+}
+
+void player_publish(const char * topic_name, int64_t time_stamp)
+{
+  tracepoint(ros2_rosbag2, player_publish, topic_name, time_stamp);
+}
+
+}  // namespace tracing
+}  // namespace rosbag2_cpp
@@ -0,0 +1,90 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// LTTng-UST tracepoint provider of rosbag2, only built with ROSBAG2_ENABLE_TRACING.
+// This header is read several times by LTTng, hence the unusual include guard.
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER ros2_rosbag2
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "rosbag2_cpp/tracing_provider.h"
+
+#if !defined(ROSBAG2_CPP__TRACING_PROVIDER_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define ROSBAG2_CPP__TRACING_PROVIDER_H_
+
+#include <lttng/tracepoint.h>
+
+#include <stdint.h>
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  stage_begin,
+  TP_ARGS(uint8_t, stage_arg),
+  TP_FIELDS(ctf_integer(uint8_t, stage, stage_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  stage_end,
+  TP_ARGS(uint8_t, stage_arg),
+  TP_FIELDS(ctf_integer(uint8_t, stage, stage_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  cache_swap_buffers,
+  TP_ARGS(uint64_t, messages_arg),
+  TP_FIELDS(ctf_integer(uint64_t, messages, messages_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  player_read,
+  TP_ARGS(const char *, topic_name_arg, int64_t, time_stamp_arg),
+  TP_FIELDS(
+    ctf_string(topic_name, topic_name_arg)
+    ctf_integer(int64_t, time_stamp, time_stamp_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  player_enqueue,
+  TP_ARGS(const char *, topic_name_arg, int64_t, time_stamp_arg),
+  TP_FIELDS(
+    ctf_string(topic_name, topic_name_arg)
+    ctf_integer(int64_t, time_stamp, time_stamp_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  player_wake,
+  TP_ARGS(int64_t, time_stamp_arg, uint8_t, due_arg),
+  TP_FIELDS(
+    ctf_integer(int64_t, time_stamp, time_stamp_arg)
+    ctf_integer(uint8_t, due, due_arg))
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  player_publish,
+  TP_ARGS(const char *, topic_name_arg, int64_t, time_stamp_arg),
+  TP_FIELDS(
+    ctf_string(topic_name, topic_name_arg)
+    ctf_integer(int64_t, time_stamp, time_stamp_arg))
+)
+
+#endif  // ROSBAG2_CPP__TRACING_PROVIDER_H_
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,58 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/typed_fast_paths.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace rosbag2_cpp
+{
+
+TypedFastPathRegistry & TypedFastPathRegistry::instance()
+{
+  static TypedFastPathRegistry registry;
+  return registry;
+}
+
+void TypedFastPathRegistry::add(const std::string & type, Factory factory)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  factories_[type] = std::move(factory);
+}
+
+bool TypedFastPathRegistry::remove(const std::string & type)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return factories_.erase(type) > 0;
+}
+
+std::unique_ptr<TypedMessageOperations> TypedFastPathRegistry::make_operations(
+  const std::string & type) const
+{
+  Factory factory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = factories_.find(type);
+    if (it == factories_.end()) {
+      return nullptr;
+    }
+    factory = it->second;
+  }
+  return factory();
+}
+
+}  // namespace rosbag2_cpp
@@ -14,6 +14,10 @@
 
 #include "rosbag2_cpp/types/introspection_message.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,6 +34,111 @@
 namespace rosbag2_cpp
 {
 
+namespace
+{
+// Every allocation from the arena is preceded by its size, padded to keep the alignment
+constexpr size_t kArenaAlignment = alignof(std::max_align_t);
+constexpr size_t kArenaHeaderSize = kArenaAlignment;
+
+size_t align_to_arena(size_t size)
+{
+  return (size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+void * arena_allocate(size_t size, void * state)
+{
+  return static_cast<IntrospectionMessageArena *>(state)->allocate(size);
+}
+
+void arena_deallocate(void *, void *)
+{
+  // Released at once by reset() or the destruction of the arena
+}
+
+void * arena_reallocate(void * pointer, size_t size, void * state)
+{
+  return static_cast<IntrospectionMessageArena *>(state)->reallocate(pointer, size);
+}
+
+void * arena_zero_allocate(size_t number_of_elements, size_t size_of_element, void * state)
+{
+  if (size_of_element != 0 &&
+    number_of_elements > std::numeric_limits<size_t>::max() / size_of_element)
+  {
+    return nullptr;
+  }
+  const size_t size = number_of_elements * size_of_element;
+  void * pointer = static_cast<IntrospectionMessageArena *>(state)->allocate(size);
+  std::memset(pointer, 0, size);
+  return pointer;
+}
+}  // namespace
+
+IntrospectionMessageArena::IntrospectionMessageArena(size_t block_size)
+: block_size_(block_size)
+{}
+
+void * IntrospectionMessageArena::allocate(size_t size)
+{
+  const size_t required_bytes = kArenaHeaderSize + align_to_arena(size);
+  while (current_block_ < blocks_.size() &&
+    block_offset_ + required_bytes > blocks_[current_block_].size)
+  {
+    current_block_++;
+    block_offset_ = 0;
+  }
+  if (current_block_ == blocks_.size()) {
+    // Allocations larger than a block get a block of their own
+    const size_t block_size = std::max(block_size_, required_bytes);
+    blocks_.push_back({std::make_unique<char[]>(block_size), block_size});
+    block_offset_ = 0;
+  }
+  // Memory of new[] is aligned for any type, and so are all offsets into it
+  char * header = blocks_[current_block_].data.get() + block_offset_;
+  std::memcpy(header, &size, sizeof(size));
+  block_offset_ += required_bytes;
+  used_bytes_ += required_bytes;
+  return header + kArenaHeaderSize;
+}
+
+void * IntrospectionMessageArena::reallocate(void * pointer, size_t size)
+{
+  if (!pointer) {
+    return allocate(size);
+  }
+  size_t previous_size = 0;
+  std::memcpy(&previous_size, static_cast<char *>(pointer) - kArenaHeaderSize, sizeof(size));
+  if (size <= previous_size) {
+    return pointer;
+  }
+  void * resized = allocate(size);
+  std::memcpy(resized, pointer, previous_size);
+  return resized;
+}
+
+void IntrospectionMessageArena::reset()
+{
+  current_block_ = 0;
+  block_offset_ = 0;
+  used_bytes_ = 0;
+}
+
+rcutils_allocator_t IntrospectionMessageArena::get_allocator()
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = arena_allocate;
+  allocator.deallocate = arena_deallocate;
+  allocator.reallocate = arena_reallocate;
+  allocator.zero_allocate = arena_zero_allocate;
+  allocator.state = this;
+  return allocator;
+}
+
+size_t IntrospectionMessageArena::get_used_bytes() const
+{
+  return used_bytes_;
+}
+
 std::shared_ptr<rosbag2_introspection_message_t>
 allocate_introspection_message(
   const rosidl_message_type_support_t * introspection_ts, const rcutils_allocator_t * allocator)
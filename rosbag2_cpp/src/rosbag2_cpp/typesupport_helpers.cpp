@@ -14,7 +14,9 @@
 
 #include "rosbag2_cpp/typesupport_helpers.hpp"
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -31,6 +33,26 @@
 namespace rosbag2_cpp
 {
 
+namespace
+{
+
+// Libraries loaded by get_typesupport_library(), by package name and typesupport identifier.
+// A library is unloaded when the last of its users releases it.
+struct TypesupportLibraryCache
+{
+  std::mutex mutex;
+  std::map<std::pair<std::string, std::string>, std::weak_ptr<rcpputils::SharedLibrary>>
+  libraries;
+};
+
+TypesupportLibraryCache & get_typesupport_library_cache()
+{
+  static TypesupportLibraryCache cache;
+  return cache;
+}
+
+}  // namespace
+
 std::string get_typesupport_library_path(
   const std::string & package_name, const std::string & typesupport_identifier)
 {
@@ -102,8 +124,17 @@ std::shared_ptr<rcpputils::SharedLibrary>
 get_typesupport_library(const std::string & type, const std::string & typesupport_identifier)
 {
   auto package_name = std::get<0>(extract_type_identifier(type));
-  auto library_path = get_typesupport_library_path(package_name, typesupport_identifier);
-  return std::make_shared<rcpputils::SharedLibrary>(library_path);
+  auto & cache = get_typesupport_library_cache();
+  // The library is loaded with the lock held, so that it is only loaded once
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto & cached_library = cache.libraries[{package_name, typesupport_identifier}];
+  auto library = cached_library.lock();
+  if (!library) {
+    auto library_path = get_typesupport_library_path(package_name, typesupport_identifier);
+    library = std::make_shared<rcpputils::SharedLibrary>(library_path);
+    cached_library = library;
+  }
+  return library;
 }
 
 const rosidl_message_type_support_t *
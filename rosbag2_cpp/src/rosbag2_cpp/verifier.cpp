@@ -0,0 +1,148 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/verifier.hpp"
+
+namespace rosbag2_cpp
+{
+
+bool BagVerification::ok() const
+{
+  auto file_ok = [](const File & file) {
+      return file.error.empty() && file.verification.problems.empty();
+    };
+  return metadata_mismatches.empty() && std::all_of(files.begin(), files.end(), file_ok);
+}
+
+Verifier::Verifier(
+  std::unique_ptr<rosbag2_storage::StorageFactoryInterface> storage_factory,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: storage_factory_(std::move(storage_factory)),
+  metadata_io_(std::move(metadata_io))
+{}
+
+BagVerification Verifier::verify(
+  const rosbag2_storage::StorageOptions & storage_options, size_t threads)
+{
+  if (!metadata_io_->metadata_file_exists(storage_options.uri)) {
+    throw std::runtime_error(
+            "No metadata found in " + storage_options.uri +
+            ", reindex the bag with 'ros2 bag reindex' first.");
+  }
+  const auto metadata = metadata_io_->read_metadata(storage_options.uri);
+  if (metadata.compression_mode == "FILE") {
+    throw std::runtime_error(
+            "The files of " + storage_options.uri + " are compressed, decompress them first.");
+  }
+  // Bags before version 4 list their files relative to the parent of the bag directory
+  auto base_path = std::filesystem::path(storage_options.uri);
+  if (metadata.version < 4) {
+    base_path = base_path.parent_path();
+  }
+
+  BagVerification result;
+  result.files.resize(metadata.relative_file_paths.size());
+  std::atomic_size_t next_file{0};
+  auto worker = [&]() {
+      for (size_t i = next_file++; i < result.files.size(); i = next_file++) {
+        auto & file = result.files[i];
+        file.path = metadata.relative_file_paths[i];
+        // Errors are reported per file, so that one unreadable file does not hide the others
+        try {
+          auto file_options = storage_options;
+          file_options.uri = (base_path / file.path).string();
+          if (file_options.storage_id.empty()) {
+            file_options.storage_id = metadata.storage_identifier;
+          }
+          if (!std::filesystem::exists(file_options.uri)) {
+            file.error = "File does not exist";
+            continue;
+          }
+          auto storage = storage_factory_->open_read_only(file_options);
+          if (!storage) {
+            file.error = "No storage plugin could open the file";
+            continue;
+          }
+          file.verification = storage->verify();
+        } catch (const std::exception & e) {
+          file.error = e.what();
+        }
+      }
+    };
+
+  const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t thread_count =
+    std::min(threads > 0 ? threads : hardware_threads, result.files.size());
+  std::vector<std::thread> thread_pool;
+  for (size_t i = 1; i < thread_count; i++) {
+    thread_pool.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : thread_pool) {
+    thread.join();
+  }
+
+  // Compare the intact messages with the metadata, per file where the metadata lists files
+  std::map<std::string, uint64_t> topic_message_counts;
+  for (const auto & file : result.files) {
+    for (const auto & [topic_name, count] : file.verification.topic_message_counts) {
+      topic_message_counts[topic_name] += count;
+    }
+    const auto file_information = std::find_if(
+      metadata.files.begin(), metadata.files.end(), [&file](const auto & information) {
+        return information.path == file.path;
+      });
+    const auto found = file.verification.message_count();
+    if (file.error.empty() && file_information != metadata.files.end() &&
+      file_information->message_count != found)
+    {
+      result.metadata_mismatches.push_back(
+        file.path + ": the metadata lists " + std::to_string(file_information->message_count) +
+        " messages, " + std::to_string(found) + " are intact");
+    }
+  }
+  for (const auto & topic : metadata.topics_with_message_count) {
+    const auto & topic_name = topic.topic_metadata.name;
+    const auto found = topic_message_counts[topic_name];
+    if (topic.message_count != found) {
+      result.metadata_mismatches.push_back(
+        topic_name + ": the metadata lists " + std::to_string(topic.message_count) +
+        " messages, " + std::to_string(found) + " are intact");
+    }
+    topic_message_counts.erase(topic_name);
+  }
+  for (const auto & [topic_name, count] : topic_message_counts) {
+    if (count > 0) {
+      result.metadata_mismatches.push_back(
+        topic_name + ": " + std::to_string(count) +
+        " messages are intact, the topic is missing in the metadata");
+    }
+  }
+  return result;
+}
+
+}  // namespace rosbag2_cpp
@@ -27,6 +27,7 @@
 #include "rclcpp/time.hpp"
 
 #include "rosbag2_cpp/info.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
 #include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
 
 #include "rosbag2_storage/serialized_bag_message.hpp"
@@ -39,6 +40,27 @@
 namespace rosbag2_cpp
 {
 
+namespace
+{
+/// Non-owning view on the payload of a SerializedMessage which keeps the message alive.
+struct SerializedDataView
+{
+  std::shared_ptr<const rclcpp::SerializedMessage> message;
+  rcutils_uint8_array_t data;
+};
+
+/// Wrap the payload of message without copying it.
+/// The view and the reference to the original message share a single allocation. The returned
+/// array is never finalized, the buffer is released together with the last reference to message.
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_data_view(std::shared_ptr<const rclcpp::SerializedMessage> message)
+{
+  auto view = std::make_shared<SerializedDataView>();
+  view->data = message->get_rcl_serialized_message();
+  view->message = std::move(message);
+  return std::shared_ptr<rcutils_uint8_array_t>(view, &view->data);
+}
+}  // namespace
 
 Writer::Writer(std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> writer_impl)
 : writer_impl_(std::move(writer_impl))
@@ -63,6 +85,8 @@ void Writer::open(
   const ConverterOptions & converter_options)
 {
   writer_impl_->open(storage_options, converter_options);
+  start_time_ns_.store(storage_options.start_time_ns, std::memory_order_relaxed);
+  end_time_ns_.store(storage_options.end_time_ns, std::memory_order_relaxed);
 }
 
 void Writer::close()
@@ -84,6 +108,20 @@ void Writer::create_topic(
   writer_impl_->create_topic(topic_with_type, message_definition);
 }
 
+void Writer::prefetch_message_definitions(
+  const std::vector<rosbag2_storage::TopicMetadata> & topics)
+{
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  writer_impl_->prefetch_message_definitions(topics);
+}
+
+bool Writer::copy_bag_file(
+  const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter)
+{
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  return writer_impl_->copy_bag_file(uri, storage_filter);
+}
+
 void Writer::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
   std::lock_guard<std::mutex> writer_lock(writer_mutex_);
@@ -101,8 +139,20 @@ void Writer::split_bagfile()
   return writer_impl_->split_bagfile();
 }
 
+bool Writer::is_within_time_window(rcutils_time_point_value_t time_stamp) const
+{
+  const auto start_time_ns = start_time_ns_.load(std::memory_order_relaxed);
+  const auto end_time_ns = end_time_ns_.load(std::memory_order_relaxed);
+  return (start_time_ns < 0 || time_stamp >= start_time_ns) &&
+         (end_time_ns < 0 || time_stamp <= end_time_ns);
+}
+
 void Writer::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
+  if (!is_within_time_window(message->time_stamp)) {
+    return;
+  }
+  StageTimer timer(pipeline_statistics_.get(), PipelineStage::WRITER_WRITE);
   std::lock_guard<std::mutex> writer_lock(writer_mutex_);
   writer_impl_->write(message);
 }
@@ -133,6 +183,10 @@ void Writer::write(
   const std::string & type_name,
   const rclcpp::Time & time)
 {
+  // Discarded before the payload is duplicated
+  if (!is_within_time_window(time.nanoseconds())) {
+    return;
+  }
   auto serialized_bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
   serialized_bag_message->topic_name = topic_name;
   serialized_bag_message->time_stamp = time.nanoseconds();
@@ -155,9 +209,10 @@ void Writer::write(
 
   rcutils_allocator_t allocator = rcutils_get_default_allocator();
 
+  // Only the used part of the buffer is duplicated, the spare capacity is never read.
   rcutils_ret_t ret = rcutils_uint8_array_init(
     serialized_bag_message->serialized_data.get(),
-    message.get_rcl_serialized_message().buffer_capacity,
+    message.get_rcl_serialized_message().buffer_length,
     &allocator);
   if (ret != RCUTILS_RET_OK) {
     auto err = std::string("Failed to call rcutils_uint8_array_init(): return ");
@@ -173,8 +228,7 @@ void Writer::write(
   serialized_bag_message->serialized_data->buffer_length =
     message.get_rcl_serialized_message().buffer_length;
 
-  return write(
-    serialized_bag_message, topic_name, type_name, rmw_get_serialization_format());
+  write_tagged(serialized_bag_message, type_name, rmw_get_serialization_format());
 }
 
 void Writer::write(
@@ -183,21 +237,55 @@ void Writer::write(
   const std::string & type_name,
   const rclcpp::Time & time)
 {
+  if (!is_within_time_window(time.nanoseconds())) {
+    return;
+  }
   auto serialized_bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
   serialized_bag_message->topic_name = topic_name;
   serialized_bag_message->time_stamp = time.nanoseconds();
-  // point to actual data and keep reference to original message to avoid premature releasing
-  serialized_bag_message->serialized_data = std::shared_ptr<rcutils_uint8_array_t>(
-    new rcutils_uint8_array_t(message->get_rcl_serialized_message()),
-    [message](rcutils_uint8_array_t * data) {
-      (void)message;
-      if (data != nullptr) {
-        data->buffer = nullptr;
-        delete data;
-      }
-    });
+  serialized_bag_message->serialized_data = make_serialized_data_view(std::move(message));
+
+  write_tagged(serialized_bag_message, type_name, rmw_get_serialization_format());
+}
+
+void Writer::write(
+  std::shared_ptr<const rclcpp::SerializedMessage> message,
+  const std::string & topic_name,
+  const std::string & type_name,
+  const rclcpp::Time & time,
+  rcutils_time_point_value_t send_timestamp,
+  uint64_t sequence_number)
+{
+  if (!is_within_time_window(time.nanoseconds())) {
+    return;
+  }
+  auto serialized_bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  serialized_bag_message->topic_name = topic_name;
+  serialized_bag_message->time_stamp = time.nanoseconds();
+  serialized_bag_message->send_timestamp = send_timestamp;
+  serialized_bag_message->sequence_number = sequence_number;
+  serialized_bag_message->serialized_data = make_serialized_data_view(std::move(message));
 
-  return write(serialized_bag_message, topic_name, type_name, rmw_get_serialization_format());
+  write_tagged(serialized_bag_message, type_name, rmw_get_serialization_format());
+}
+
+void Writer::write_tagged(
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> message,
+  const std::string & type_name,
+  const std::string & serialization_format)
+{
+  StageTimer timer(pipeline_statistics_.get(), PipelineStage::WRITER_WRITE);
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  message->topic_id = writer_impl_->get_topic_id(message->topic_name);
+  if (message->topic_id == rosbag2_storage::UNASSIGNED_TOPIC_ID) {
+    rosbag2_storage::TopicMetadata tm;
+    tm.name = message->topic_name;
+    tm.type = type_name;
+    tm.serialization_format = serialization_format;
+    writer_impl_->create_topic(tm);
+    message->topic_id = writer_impl_->get_topic_id(message->topic_name);
+  }
+  writer_impl_->write(message);
 }
 
 void Writer::add_event_callbacks(bag_events::WriterEventCallbacks & callbacks)
@@ -205,4 +293,16 @@ void Writer::add_event_callbacks(bag_events::WriterEventCallbacks & callbacks)
   writer_impl_->add_event_callbacks(callbacks);
 }
 
+void Writer::set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics)
+{
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  pipeline_statistics_ = statistics;
+  writer_impl_->set_pipeline_statistics(std::move(statistics));
+}
+
+std::shared_ptr<PipelineStatistics> Writer::get_pipeline_statistics() const
+{
+  return pipeline_statistics_;
+}
+
 }  // namespace rosbag2_cpp
@@ -0,0 +1,258 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/writers/routing_writer.hpp"
+
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <regex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_cpp/writers/sequential_writer.hpp"
+
+#include "sub_bag_metadata.hpp"
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+RoutingWriter::RoutingWriter(
+  std::vector<Route> routes,
+  SubBagWriterFactory sub_bag_writer_factory,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: routes_(std::move(routes)),
+  sub_bag_writer_factory_(std::move(sub_bag_writer_factory)),
+  metadata_io_(std::move(metadata_io))
+{
+  if (routes_.empty()) {
+    throw std::invalid_argument("RoutingWriter needs at least one route.");
+  }
+  std::set<std::string> names;
+  for (const auto & route : routes_) {
+    if (route.name.empty() || route.name == "." || route.name == ".." ||
+      route.name.find_first_of("/\\") != std::string::npos)
+    {
+      throw std::invalid_argument("Invalid name of route '" + route.name + "'.");
+    }
+    if (route.name == kDefaultRouteName || !names.insert(route.name).second) {
+      throw std::invalid_argument("Duplicate name of route '" + route.name + "'.");
+    }
+    try {
+      route_regexes_.emplace_back(route.topics_regex);
+    } catch (const std::regex_error & e) {
+      throw std::invalid_argument(
+              "Invalid topics regex of route '" + route.name + "': " + e.what());
+    }
+  }
+  if (!sub_bag_writer_factory_) {
+    sub_bag_writer_factory_ = [](const std::string &)
+      -> std::unique_ptr<writer_interfaces::BaseWriterInterface> {
+        return std::make_unique<SequentialWriter>();
+      };
+  }
+}
+
+RoutingWriter::~RoutingWriter()
+{
+  try {
+    close();
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_ERROR_STREAM(
+      "Failed to write the metadata of routed bag " << base_folder_ << ": " << e.what());
+  }
+}
+
+void RoutingWriter::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  close();
+  base_folder_ = storage_options.uri;
+  const std::filesystem::path bag_path(base_folder_);
+  if (std::filesystem::is_directory(bag_path)) {
+    throw std::runtime_error(
+            "Bag directory already exists (" + bag_path.string() +
+            "), can't overwrite existing bag");
+  }
+  std::filesystem::create_directories(bag_path);
+
+  topic_routes_.clear();
+  auto open_sub_bag = [&](const std::string & name, const Route * route) {
+      auto sub_bag_options = storage_options;
+      sub_bag_options.uri = (bag_path / name).string();
+      if (route) {
+        sub_bag_options.max_bagfile_size =
+          route->max_bagfile_size.value_or(storage_options.max_bagfile_size);
+        sub_bag_options.max_bagfile_duration =
+          route->max_bagfile_duration.value_or(storage_options.max_bagfile_duration);
+        sub_bag_options.max_cache_size =
+          route->max_cache_size.value_or(storage_options.max_cache_size);
+      }
+      auto sub_bag = sub_bag_writer_factory_(name);
+      if (pipeline_statistics_) {
+        sub_bag->set_pipeline_statistics(pipeline_statistics_);
+      }
+      sub_bag->open(sub_bag_options, converter_options);
+      sub_bag_uris_.push_back(sub_bag_options.uri);
+      sub_bags_.push_back(std::move(sub_bag));
+    };
+  for (const auto & route : routes_) {
+    open_sub_bag(route.name, &route);
+  }
+  open_sub_bag(kDefaultRouteName, nullptr);
+}
+
+void RoutingWriter::close()
+{
+  if (sub_bags_.empty()) {
+    return;
+  }
+  auto sub_bags = std::move(sub_bags_);
+  sub_bags_.clear();
+  std::exception_ptr error;
+  for (auto & sub_bag : sub_bags) {
+    try {
+      sub_bag->close();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  sub_bags.clear();
+  auto sub_bag_uris = std::move(sub_bag_uris_);
+  sub_bag_uris_.clear();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  auto metadata = details::merge_sub_bag_metadata(base_folder_, sub_bag_uris, *metadata_io_);
+  std::string sub_bags_list;
+  for (const auto & sub_bag_uri : sub_bag_uris) {
+    sub_bags_list += (sub_bags_list.empty() ? "" : ",") +
+      std::filesystem::path(sub_bag_uri).filename().string();
+  }
+  metadata.custom_data[kSubBagsKey] = sub_bags_list;
+  metadata_io_->write_metadata(base_folder_, metadata);
+}
+
+void RoutingWriter::create_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  if (!sub_bags_.empty()) {
+    sub_bags_[route_of(topic_with_type.name)]->create_topic(topic_with_type);
+  }
+}
+
+void RoutingWriter::create_topic(
+  const rosbag2_storage::TopicMetadata & topic_with_type,
+  const rosbag2_storage::MessageDefinition & message_definition)
+{
+  if (!sub_bags_.empty()) {
+    sub_bags_[route_of(topic_with_type.name)]->create_topic(topic_with_type, message_definition);
+  }
+}
+
+void RoutingWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  if (!sub_bags_.empty()) {
+    sub_bags_[route_of(topic_with_type.name)]->remove_topic(topic_with_type);
+  }
+}
+
+void RoutingWriter::prefetch_message_definitions(
+  const std::vector<rosbag2_storage::TopicMetadata> & topics)
+{
+  std::map<size_t, std::vector<rosbag2_storage::TopicMetadata>> topics_of_sub_bags;
+  for (const auto & topic : topics) {
+    if (!sub_bags_.empty()) {
+      topics_of_sub_bags[route_of(topic.name)].push_back(topic);
+    }
+  }
+  for (const auto & [sub_bag_index, sub_bag_topics] : topics_of_sub_bags) {
+    sub_bags_[sub_bag_index]->prefetch_message_definitions(sub_bag_topics);
+  }
+}
+
+void RoutingWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (sub_bags_.empty()) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  sub_bags_[route_of(message->topic_name)]->write(std::move(message));
+}
+
+bool RoutingWriter::take_snapshot()
+{
+  bool all_taken = !sub_bags_.empty();
+  for (auto & sub_bag : sub_bags_) {
+    all_taken = sub_bag->take_snapshot() && all_taken;
+  }
+  return all_taken;
+}
+
+void RoutingWriter::split_bagfile()
+{
+  for (auto & sub_bag : sub_bags_) {
+    sub_bag->split_bagfile();
+  }
+}
+
+void RoutingWriter::add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks)
+{
+  for (auto & sub_bag : sub_bags_) {
+    sub_bag->add_event_callbacks(callbacks);
+  }
+}
+
+void RoutingWriter::set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics)
+{
+  pipeline_statistics_ = std::move(statistics);
+}
+
+std::string RoutingWriter::get_route_name(const std::string & topic_name) const
+{
+  const size_t route_index = match_route(topic_name);
+  return route_index < routes_.size() ? routes_[route_index].name : kDefaultRouteName;
+}
+
+size_t RoutingWriter::match_route(const std::string & topic_name) const
+{
+  size_t route_index = 0;
+  while (route_index < routes_.size() &&
+    !std::regex_match(topic_name, route_regexes_[route_index]))
+  {
+    ++route_index;
+  }
+  return route_index;
+}
+
+size_t RoutingWriter::route_of(const std::string & topic_name)
+{
+  auto it = topic_routes_.find(topic_name);
+  if (it == topic_routes_.end()) {
+    it = topic_routes_.emplace(topic_name, match_route(topic_name)).first;
+  }
+  return it->second;
+}
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
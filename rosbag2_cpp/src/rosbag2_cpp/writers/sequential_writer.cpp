@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -29,6 +30,7 @@
 
 #include "rosbag2_cpp/info.hpp"
 #include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_cpp/thread_scheduling.hpp"
 
 #include "rosbag2_storage/default_storage_id.hpp"
 #include "rosbag2_storage/storage_options.hpp"
@@ -44,6 +46,20 @@ std::string strip_parent_path(const std::string & relative_path)
 {
   return rcpputils::fs::path(relative_path).filename().string();
 }
+
+using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+
+// Extend the time range given by starting_time and duration, which is empty if starting_time is
+// the maximum time point, to include [first, last]
+void extend_time_range(
+  TimePoint & starting_time, std::chrono::nanoseconds & duration,
+  const TimePoint & first, const TimePoint & last)
+{
+  const bool is_empty = starting_time == TimePoint(std::chrono::nanoseconds::max());
+  const auto end = is_empty ? last : std::max(starting_time + duration, last);
+  starting_time = is_empty ? first : std::min(starting_time, first);
+  duration = end - starting_time;
+}
 }  // namespace
 
 SequentialWriter::SequentialWriter(
@@ -56,7 +72,7 @@ SequentialWriter::SequentialWriter(
   metadata_io_(std::move(metadata_io)),
   converter_(nullptr),
   topics_names_to_info_(),
-  message_definitions_(),
+  message_definitions_(nullptr),
   metadata_()
 {}
 
@@ -65,7 +81,11 @@ SequentialWriter::~SequentialWriter()
   // Deleting all callbacks before calling close(). Calling callbacks from destructor is not safe.
   // Callbacks likely was created after SequentialWriter object and may point to the already
   // destructed objects.
-  callback_manager_.delete_all_callbacks();
+  {
+    // Storages still closing in the background must not call the callbacks either
+    std::lock_guard<std::mutex> lock(callback_manager_mutex_);
+    callback_manager_.delete_all_callbacks();
+  }
   close();
 }
 
@@ -82,7 +102,25 @@ void SequentialWriter::init_metadata()
     std::chrono::nanoseconds::max());
   file_info.message_count = 0;
   metadata_.custom_data = storage_options_.custom_data;
+  if (payload_deduplicator_) {
+    // Tells readers to resolve references
+    metadata_.custom_data[kDeduplicatedPayloadsKey] = "true";
+  }
+  if (payload_delta_encoder_) {
+    // Tells readers which topics to reconstruct
+    metadata_.custom_data[kDeltaEncodedTopicsKey] =
+      join_delta_encoded_topics(storage_options_.delta_encoded_topics);
+  }
   metadata_.files = {file_info};
+  file_start_topic_message_counts_.clear();
+  file_write_latencies_.reset();
+  file_start_dropped_message_count_ = 0;
+  file_uncompressed_bytes_ = 0;
+  file_compressed_bytes_ = 0;
+  retained_files_.clear();
+  retained_bytes_ = 0;
+  deleted_topic_message_counts_.clear();
+  deleted_file_count_ = 0;
   metadata_.ros_distro = rcpputils::get_env_var("ROS_DISTRO");
   if (metadata_.ros_distro.empty()) {
     ROSBAG2_CPP_LOG_WARN(
@@ -106,6 +144,10 @@ void SequentialWriter::open(
     converter_ = std::make_unique<Converter>(converter_options, converter_factory_);
   }
 
+  message_definitions_ = std::make_unique<LocalMessageDefinitionSource>(
+    storage_options.message_definition_cache_directory,
+    storage_options.message_definition_threads);
+
   rcpputils::fs::path storage_path(storage_options.uri);
   if (storage_path.is_directory()) {
     std::stringstream error;
@@ -142,45 +184,185 @@ void SequentialWriter::open(
     throw std::runtime_error(
             "Max cache size must be greater than 0 when snapshot mode is enabled");
   }
+  payload_deduplicator_.reset();
+  if (storage_options.deduplication_min_payload_size > 0) {
+    payload_deduplicator_ = std::make_unique<PayloadDeduplicator>(
+      storage_options.deduplication_min_payload_size, storage_options.deduplication_cache_size);
+  }
+  payload_delta_encoder_.reset();
+  if (!storage_options.delta_encoded_topics.empty()) {
+    payload_delta_encoder_ = std::make_unique<PayloadDeltaEncoder>(
+      storage_options.delta_encoded_topics, storage_options.delta_keyframe_interval);
+  }
+  preview_.reset();
+  if (storage_options.preview_bucket_duration_ms > 0) {
+    preview_ = std::make_unique<BagPreview>(
+      RCUTILS_MS_TO_NS(static_cast<rcutils_duration_value_t>(
+        storage_options.preview_bucket_duration_ms)),
+      storage_options.preview_sample_topics,
+      std::max<uint64_t>(storage_options.preview_sample_interval, 1u));
+  }
+  if (converter_ && use_cache_ && converter_options.conversion_threads > 1) {
+    parallel_converter_ = std::make_unique<ParallelConverter>(
+      converter_options, converter_factory_, converter_options.conversion_threads);
+  }
+
+  const auto cache_overflow_policy =
+    rosbag2_cpp::cache::cache_overflow_policy_from_string(storage_options.cache_overflow_policy);
+  const bool uses_sharded_cache = !storage_options.snapshot_mode &&
+    (storage_options.shard_cache_per_topic || !storage_options.cache_topic_groups.empty());
+  const bool uses_default_cache = !storage_options.snapshot_mode && !uses_sharded_cache &&
+    !storage_options.lock_free_cache;
+  if (use_cache_ && uses_sharded_cache &&
+    cache_overflow_policy == rosbag2_cpp::cache::CacheOverflowPolicy::SPILL_TO_DISK)
+  {
+    throw std::runtime_error(
+            "Cache overflow policy '" + storage_options.cache_overflow_policy +
+            "' is not supported by the sharded message cache");
+  }
+  if (use_cache_ && !uses_default_cache && !uses_sharded_cache &&
+    cache_overflow_policy != rosbag2_cpp::cache::CacheOverflowPolicy::DROP_NEWEST)
+  {
+    throw std::runtime_error(
+            "Cache overflow policy '" + storage_options.cache_overflow_policy +
+            "' is only supported by the default and the sharded message cache");
+  }
+  std::unordered_map<std::string, rosbag2_cpp::cache::CacheOverflowPolicy> cache_shard_policies;
+  for (const auto & [shard_name, policy] : storage_options.cache_shard_policies) {
+    const auto shard_policy = rosbag2_cpp::cache::cache_overflow_policy_from_string(policy);
+    if (shard_policy == rosbag2_cpp::cache::CacheOverflowPolicy::SPILL_TO_DISK) {
+      throw std::runtime_error(
+              "Cache overflow policy '" + policy + "' of cache shard '" + shard_name +
+              "' is not supported by the sharded message cache");
+    }
+    cache_shard_policies.emplace(shard_name, shard_policy);
+  }
+  if (use_cache_ && !uses_sharded_cache && !cache_shard_policies.empty()) {
+    throw std::runtime_error(
+            "Cache shard policies are only supported by the sharded message cache");
+  }
+  if (use_cache_ && !uses_default_cache && !storage_options.cache_topic_priorities.empty()) {
+    throw std::runtime_error(
+            "Cache topic priorities are only supported by the default message cache");
+  }
 
   if (use_cache_) {
+    rosbag2_cpp::cache::CacheConsumer::consume_callback_function_t consume_callback =
+      std::bind(&SequentialWriter::write_messages, this, std::placeholders::_1);
     if (storage_options.snapshot_mode) {
-      message_cache_ = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+      auto snapshot_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+        storage_options.max_cache_size,
+        std::chrono::milliseconds(storage_options.snapshot_duration_ms),
+        std::chrono::milliseconds(storage_options.snapshot_post_trigger_duration_ms),
+        storage_options.snapshot_contiguous_buffer);
+      // The cache outlives its consumer
+      consume_callback = [this, cache = snapshot_cache.get()](const auto & messages) {
+          write_snapshot(messages, cache->consumer_buffer_continues_snapshot());
+        };
+      message_cache_ = snapshot_cache;
+    } else if (storage_options.shard_cache_per_topic ||
+      !storage_options.cache_topic_groups.empty())
+    {
+      message_cache_ = std::make_shared<rosbag2_cpp::cache::ShardedMessageCache>(
+        storage_options.max_cache_size, storage_options.shard_cache_per_topic,
+        storage_options.cache_topic_groups, storage_options.cache_shard_sizes,
+        cache_shard_policies, cache_overflow_policy,
+        std::chrono::milliseconds(storage_options.cache_block_timeout_ms));
+    } else if (storage_options.lock_free_cache) {
+      message_cache_ = std::make_shared<rosbag2_cpp::cache::LockFreeMessageCache>(
         storage_options.max_cache_size);
     } else {
+      std::shared_ptr<rosbag2_cpp::cache::SpillFile> spill_file;
+      if (cache_overflow_policy == rosbag2_cpp::cache::CacheOverflowPolicy::SPILL_TO_DISK) {
+        spill_file = std::make_shared<rosbag2_cpp::cache::SpillFile>(
+          storage_options.cache_spill_directory, storage_options.cache_spill_size);
+      }
       message_cache_ = std::make_shared<rosbag2_cpp::cache::MessageCache>(
-        storage_options.max_cache_size);
+        storage_options.max_cache_size, cache_overflow_policy,
+        std::chrono::milliseconds(storage_options.cache_block_timeout_ms), spill_file,
+        storage_options.cache_topic_priorities);
+    }
+    rosbag2_cpp::cache::WriteBatchingOptions batching_options;
+    // A snapshot is written all at once, there is nothing to batch
+    if (!storage_options.snapshot_mode) {
+      batching_options.min_batch_bytes = storage_options.cache_min_batch_size;
+      batching_options.max_batch_bytes = storage_options.cache_max_batch_size;
+      batching_options.max_batch_latency =
+        std::chrono::milliseconds(storage_options.cache_max_batch_latency_ms);
+      batching_options.adaptive = storage_options.cache_adaptive_batching;
+    }
+    rosbag2_cpp::ThreadScheduling consumer_thread_scheduling;
+    consumer_thread_scheduling.policy = storage_options.cache_consumer_thread_policy;
+    consumer_thread_scheduling.priority = storage_options.cache_consumer_thread_priority;
+    consumer_thread_scheduling.cpus.assign(
+      storage_options.cache_consumer_thread_cpus.begin(),
+      storage_options.cache_consumer_thread_cpus.end());
+    // The durability interval of the storage also elapses while no messages arrive
+    rosbag2_cpp::cache::CacheConsumer::periodic_callback_function_t commit_callback;
+    if (storage_options.durability_interval_ms > 0 && !storage_options.snapshot_mode) {
+      commit_callback = [this]() {
+          if (storage_) {
+            storage_->commit_if_due();
+          }
+        };
     }
     cache_consumer_ = std::make_unique<rosbag2_cpp::cache::CacheConsumer>(
-      message_cache_,
-      std::bind(&SequentialWriter::write_messages, this, std::placeholders::_1));
+      message_cache_, consume_callback, batching_options, consumer_thread_scheduling,
+      commit_callback, std::chrono::milliseconds(storage_options.durability_interval_ms));
   }
 
   init_metadata();
   storage_->update_metadata(metadata_);
+  prepare_standby_storage();
 }
 
 void SequentialWriter::close()
 {
+  discard_standby_storage();
   if (use_cache_) {
     // destructor will flush message cache
     cache_consumer_.reset();
+  }
+  if (storage_) {
+    // Topics created after the last message was written
+    register_pending_topics();
+  }
+  auto info = std::make_shared<bag_events::BagSplitInfo>();
+  if (storage_) {
+    collect_file_statistics(info->closed_file_statistics);
+  }
+  if (use_cache_) {
     message_cache_.reset();
   }
+  parallel_converter_.reset();
 
+  // Bag size is only final once all files are closed
+  wait_for_closing_storages();
+  wait_for_retention_deletions();
+
+  const auto close_start = std::chrono::steady_clock::now();
   if (!base_folder_.empty()) {
     finalize_metadata();
     if (storage_) {
       storage_->update_metadata(metadata_);
     }
     metadata_io_->write_metadata(base_folder_, metadata_);
+    // The metadata file makes the journal of the split files obsolete
+    metadata_io_->remove_metadata_journal(base_folder_);
+    write_topic_statistics();
+    write_preview();
   }
 
   if (storage_) {
-    auto info = std::make_shared<bag_events::BagSplitInfo>();
     info->closed_file = storage_->get_relative_file_path();
     storage_.reset();  // Destroy storage before calling WRITE_SPLIT callback to make sure that
     // bag file was closed before callback call.
+    info->closed_file_statistics.close_duration =
+      std::chrono::steady_clock::now() - close_start;
+    const rcpputils::fs::path closed_file(info->closed_file);
+    if (closed_file.exists()) {
+      info->closed_file_statistics.size = closed_file.file_size();
+    }
     callback_manager_.execute_callbacks(bag_events::BagEvent::WRITE_SPLIT, info);
   }
   storage_factory_.reset();
@@ -194,10 +376,14 @@ void SequentialWriter::create_topic(const rosbag2_storage::TopicMetadata & topic
     // nothing to do, topic already created
     return;
   }
+  if (!message_definitions_) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
   rosbag2_storage::MessageDefinition definition;
   const std::string & topic_type = topic_with_type.type;
   try {
-    definition = message_definitions_.get_full_text(topic_type);
+    definition = message_definitions_->get_full_text(
+      topic_type, topic_with_type.type_description_hash);
   } catch (DefinitionNotFoundError &) {
     definition = rosbag2_storage::MessageDefinition::empty_message_definition_for(topic_type);
   }
@@ -219,6 +405,12 @@ void SequentialWriter::create_topic(
     throw std::runtime_error("Bag is not open. Call open() before writing.");
   }
 
+  // Without the cache consumer, the storage is written to by the calling threads
+  const bool register_on_cache_consumer = registers_topics_on_cache_consumer();
+  std::unique_lock<std::mutex> storage_lock(snapshot_storage_mutex_, std::defer_lock);
+  if (!register_on_cache_consumer) {
+    storage_lock.lock();
+  }
   rosbag2_storage::TopicInformation info{};
   info.topic_metadata = topic_with_type;
 
@@ -228,6 +420,14 @@ void SequentialWriter::create_topic(
     const auto insert_res = topics_names_to_info_.insert(
       std::make_pair(topic_with_type.name, info));
     insert_succeeded = insert_res.second;
+    if (insert_succeeded) {
+      assign_topic_id(topic_with_type.name);
+      topic_names_to_message_definitions_.insert(
+        std::make_pair(topic_with_type.name, message_definition));
+      if (register_on_cache_consumer) {
+        pending_topic_registrations_.push_back({topic_with_type, message_definition, false});
+      }
+    }
   }
 
   if (!insert_succeeded) {
@@ -237,31 +437,61 @@ void SequentialWriter::create_topic(
     throw std::runtime_error(errmsg.str());
   }
 
-  topic_names_to_message_definitions_.insert(
-    std::make_pair(topic_with_type.name, message_definition));
-
-  storage_->create_topic(topic_with_type, message_definition);
+  if (!register_on_cache_consumer) {
+    storage_->create_topic(topic_with_type, message_definition);
+  }
 
-  if (converter_) {
+  if (parallel_converter_) {
+    parallel_converter_->add_topic(topic_with_type.name, topic_with_type.type);
+  } else if (converter_) {
     converter_->add_topic(topic_with_type.name, topic_with_type.type);
   }
 }
 
+void SequentialWriter::prefetch_message_definitions(
+  const std::vector<rosbag2_storage::TopicMetadata> & topics)
+{
+  if (!message_definitions_) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  for (const auto & topic : topics) {
+    message_definitions_->prefetch(topic.type, topic.type_description_hash);
+  }
+}
+
 void SequentialWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
 {
   if (!storage_) {
     throw std::runtime_error("Bag is not open. Call open() before removing.");
   }
 
+  const bool register_on_cache_consumer = registers_topics_on_cache_consumer();
+  std::unique_lock<std::mutex> storage_lock(snapshot_storage_mutex_, std::defer_lock);
+  if (!register_on_cache_consumer) {
+    storage_lock.lock();
+  }
   bool erased = false;
   {
     std::lock_guard<std::mutex> lock(topics_info_mutex_);
     erased = topics_names_to_info_.erase(topic_with_type.name) > 0;
     erased = erased && (topic_names_to_message_definitions_.erase(topic_with_type.name) > 0);
+    auto topic_ids = std::atomic_load(&topic_ids_);
+    auto topic_id = topic_ids->names_to_ids.find(topic_with_type.name);
+    if (topic_id != topic_ids->names_to_ids.end()) {
+      auto updated_topic_ids = std::make_shared<TopicIds>(*topic_ids);
+      updated_topic_ids->ids_to_names[topic_id->second].clear();
+      updated_topic_ids->names_to_ids.erase(topic_with_type.name);
+      std::atomic_store(&topic_ids_, std::shared_ptr<const TopicIds>(std::move(updated_topic_ids)));
+    }
+    if (erased && register_on_cache_consumer) {
+      pending_topic_registrations_.push_back({topic_with_type, {}, true});
+    }
   }
 
   if (erased) {
-    storage_->remove_topic(topic_with_type);
+    if (!register_on_cache_consumer) {
+      storage_->remove_topic(topic_with_type);
+    }
   } else {
     std::stringstream errmsg;
     errmsg << "Failed to remove the non-existing topic \"" <<
@@ -271,6 +501,94 @@ void SequentialWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic
   }
 }
 
+bool SequentialWriter::registers_topics_on_cache_consumer() const
+{
+  // In snapshot mode, the cache consumer switches storages under snapshot_storage_mutex_ itself
+  return use_cache_ && !storage_options_.snapshot_mode;
+}
+
+uint32_t SequentialWriter::assign_topic_id(const std::string & topic_name)
+{
+  auto topic_ids = std::make_shared<TopicIds>(*std::atomic_load(&topic_ids_));
+  if (topic_ids->ids_to_names.empty()) {
+    topic_ids->ids_to_names.emplace_back();  // rosbag2_storage::UNASSIGNED_TOPIC_ID
+  }
+  const auto topic_id = static_cast<uint32_t>(topic_ids->ids_to_names.size());
+  topic_ids->names_to_ids[topic_name] = topic_id;
+  topic_ids->ids_to_names.push_back(topic_name);
+  std::atomic_store(&topic_ids_, std::shared_ptr<const TopicIds>(std::move(topic_ids)));
+  return topic_id;
+}
+
+void SequentialWriter::register_pending_topics()
+{
+  std::vector<TopicRegistration> registrations;
+  {
+    std::lock_guard<std::mutex> lock(topics_info_mutex_);
+    registrations.swap(pending_topic_registrations_);
+  }
+  for (const auto & registration : registrations) {
+    if (registration.remove) {
+      storage_->remove_topic(registration.topic_metadata);
+    } else {
+      storage_->create_topic(registration.topic_metadata, registration.message_definition);
+    }
+  }
+}
+
+uint32_t SequentialWriter::get_topic_id(const std::string & topic_name) const
+{
+  const auto topic_ids = std::atomic_load(&topic_ids_);
+  auto topic_id = topic_ids->names_to_ids.find(topic_name);
+  return topic_id != topic_ids->names_to_ids.end() ?
+         topic_id->second : rosbag2_storage::UNASSIGNED_TOPIC_ID;
+}
+
+uint32_t SequentialWriter::resolve_topic_id(
+  const rosbag2_storage::SerializedBagMessage & message) const
+{
+  if (message.topic_id != rosbag2_storage::UNASSIGNED_TOPIC_ID) {
+    // Verifying the id costs a string comparison, but no hashing
+    const auto topic_ids = std::atomic_load(&topic_ids_);
+    if (message.topic_id >= topic_ids->ids_to_names.size() ||
+      topic_ids->ids_to_names[message.topic_id] != message.topic_name)
+    {
+      std::stringstream errmsg;
+      errmsg << "Failed to write on topic '" << message.topic_name << "'. Topic id " <<
+        message.topic_id << " was not assigned to this topic.";
+      throw std::runtime_error(errmsg.str());
+    }
+    return message.topic_id;
+  }
+  const uint32_t topic_id = get_topic_id(message.topic_name);
+  if (topic_id == rosbag2_storage::UNASSIGNED_TOPIC_ID) {
+    std::stringstream errmsg;
+    errmsg << "Failed to write on topic '" << message.topic_name <<
+      "'. Call create_topic() before first write.";
+    throw std::runtime_error(errmsg.str());
+  }
+  return topic_id;
+}
+
+void SequentialWriter::count_written_message(
+  uint32_t topic_id, const rosbag2_storage::SerializedBagMessage & message)
+{
+  if (topic_id >= topic_message_counts_.size()) {
+    topic_message_counts_.resize(topic_id + 1, 0u);
+  }
+  ++topic_message_counts_[topic_id];
+
+  if (topic_id >= topic_statistics_.size()) {
+    topic_statistics_.resize(topic_id + 1);
+  }
+  const uint64_t size = message.serialized_data ? message.serialized_data->buffer_length : 0u;
+  topic_statistics_[topic_id].add_message(message.time_stamp, size);
+
+  if (preview_) {
+    preview_->add_message(message);
+  }
+}
+
 std::string SequentialWriter::format_storage_uri(
   const std::string & base_folder, uint64_t storage_count)
 {
@@ -283,45 +601,352 @@ std::string SequentialWriter::format_storage_uri(
   return (rcpputils::fs::path(base_folder) / storage_file_name.str()).string();
 }
 
-void SequentialWriter::switch_to_next_storage()
+std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface>
+SequentialWriter::switch_to_next_storage(bag_events::BagFileStatistics & closed_file_statistics)
 {
-  // consume remaining message cache
-  if (use_cache_) {
+  // consume remaining message cache. In snapshot mode, the cache consumer switches to the next
+  // storage for every snapshot itself.
+  const bool restart_cache_consumer = use_cache_ && !storage_options_.snapshot_mode;
+  if (restart_cache_consumer) {
     cache_consumer_->stop();
     message_cache_->log_dropped();
   }
-
-  storage_->update_metadata(metadata_);
+  collect_file_statistics(closed_file_statistics);
+  closed_file_statistics.size = storage_->get_bagfile_size();
+
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> previous_storage;
+  if (!storage_options_.async_split) {
+    // The previous file is closed before the next one is opened, to measure how long it takes
+    const auto close_start = std::chrono::steady_clock::now();
+    storage_->update_metadata(metadata_);
+    storage_.reset();
+    closed_file_statistics.close_duration = std::chrono::steady_clock::now() - close_start;
+  }
   storage_options_.uri = format_storage_uri(
     base_folder_,
-    metadata_.relative_file_paths.size());
-  storage_ = storage_factory_->open_read_write(storage_options_);
-  storage_->update_metadata(metadata_);
+    metadata_.relative_file_paths.size() + deleted_file_count_);
+  if (storage_options_.async_split) {
+    // Keep the previous storage open, it is closed in the background by the caller
+    previous_storage = std::move(storage_);
+    if (standby_storage_.valid() && standby_storage_uri_ == storage_options_.uri) {
+      storage_ = standby_storage_.get();
+    } else {
+      discard_standby_storage();
+      storage_ = storage_factory_->open_read_write(storage_options_);
+    }
+  } else {
+    storage_ = storage_factory_->open_read_write(storage_options_);
+  }
 
-  if (!storage_) {
+  if (payload_deduplicator_) {
+    // References must not refer to messages of other files
+    payload_deduplicator_->reset();
+  }
+  if (payload_delta_encoder_) {
+    // Deltas must not refer to keyframes of other files
+    payload_delta_encoder_->reset();
+  }
+  if (storage_) {
+    storage_->update_metadata(metadata_);
+  } else {
     std::stringstream errmsg;
     errmsg << "Failed to rollover bagfile to new file: \"" << storage_options_.uri << "\"!";
 
     throw std::runtime_error(errmsg.str());
   }
-  // Re-register all topics since we rolled-over to a new bagfile.
-  for (const auto & topic : topics_names_to_info_) {
-    auto const & md = topic_names_to_message_definitions_[topic.first];
-    storage_->create_topic(topic.second.topic_metadata, md);
+  // Re-register all topics since we rolled-over to a new bagfile, including the ones whose
+  // registration is still pending.
+  std::vector<TopicRegistration> topics;
+  {
+    std::lock_guard<std::mutex> lock(topics_info_mutex_);
+    pending_topic_registrations_.clear();
+    for (const auto & topic : topics_names_to_info_) {
+      topics.push_back(
+        {topic.second.topic_metadata, topic_names_to_message_definitions_[topic.first], false});
+    }
+  }
+  for (const auto & topic : topics) {
+    storage_->create_topic(topic.topic_metadata, topic.message_definition);
   }
 
-  if (use_cache_) {
+  if (restart_cache_consumer) {
     // restart consumer thread for cache
     cache_consumer_->start();
   }
+  return previous_storage;
+}
+
+void SequentialWriter::collect_file_statistics(bag_events::BagFileStatistics & statistics)
+{
+  statistics.message_count = metadata_.files.back().message_count;
+  statistics.write_latency_p50 = file_write_latencies_.percentile(50.0);
+  statistics.write_latency_p90 = file_write_latencies_.percentile(90.0);
+  statistics.write_latency_p99 = file_write_latencies_.percentile(99.0);
+  statistics.write_latency_max = file_write_latencies_.max();
+  file_write_latencies_.reset();
+
+  const uint64_t dropped_message_count =
+    message_cache_ ? message_cache_->get_dropped_message_count() : 0u;
+  statistics.dropped_message_count = dropped_message_count - file_start_dropped_message_count_;
+  file_start_dropped_message_count_ = dropped_message_count;
+
+  const uint64_t uncompressed_bytes = file_uncompressed_bytes_.exchange(0);
+  const uint64_t compressed_bytes = file_compressed_bytes_.exchange(0);
+  statistics.compression_ratio = compressed_bytes > 0 ?
+    static_cast<double>(uncompressed_bytes) / static_cast<double>(compressed_bytes) : 0.0;
+}
+
+void SequentialWriter::count_compressed_bytes(uint64_t uncompressed_size, uint64_t compressed_size)
+{
+  file_uncompressed_bytes_ += uncompressed_size;
+  file_compressed_bytes_ += compressed_size;
+}
+
+void SequentialWriter::prepare_standby_storage()
+{
+  const bool splitting_enabled =
+    storage_options_.max_bagfile_size !=
+    rosbag2_storage::storage_interfaces::MAX_BAGFILE_SIZE_NO_SPLIT ||
+    storage_options_.max_bagfile_duration !=
+    rosbag2_storage::storage_interfaces::MAX_BAGFILE_DURATION_NO_SPLIT;
+  if (!storage_options_.async_split || !splitting_enabled || standby_storage_.valid()) {
+    return;
+  }
+  auto standby_storage_options = storage_options_;
+  standby_storage_options.uri = format_storage_uri(
+    base_folder_, metadata_.relative_file_paths.size() + deleted_file_count_);
+  standby_storage_uri_ = standby_storage_options.uri;
+  standby_storage_ = std::async(
+    std::launch::async, [this, standby_storage_options]() {
+      return storage_factory_->open_read_write(standby_storage_options);
+    });
+}
+
+void SequentialWriter::discard_standby_storage()
+{
+  if (!standby_storage_.valid()) {
+    return;
+  }
+  try {
+    auto standby_storage = standby_storage_.get();
+    if (standby_storage) {
+      const auto standby_file = standby_storage->get_relative_file_path();
+      standby_storage.reset();
+      rcpputils::fs::remove(rcpputils::fs::path(standby_file));
+    }
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Failed to open standby storage '" << standby_storage_uri_ << "': " << e.what());
+  }
+}
+
+void SequentialWriter::close_storage_async(
+  std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage,
+  const rosbag2_storage::BagMetadata & metadata,
+  std::shared_ptr<bag_events::BagSplitInfo> split_info)
+{
+  closing_storage_ = std::async(
+    std::launch::async,
+    [this, previous = std::move(closing_storage_), storage = std::move(storage), metadata,
+    split_info]() mutable {
+      if (previous.valid()) {
+        previous.wait();
+      }
+      const auto close_start = std::chrono::steady_clock::now();
+      try {
+        storage->update_metadata(metadata);
+        storage.reset();
+      } catch (const std::exception & e) {
+        ROSBAG2_CPP_LOG_ERROR_STREAM(
+          "Failed to close bag file '" << split_info->closed_file << "': " << e.what());
+      }
+      split_info->closed_file_statistics.close_duration =
+        std::chrono::steady_clock::now() - close_start;
+      std::lock_guard<std::mutex> lock(callback_manager_mutex_);
+      callback_manager_.execute_callbacks(bag_events::BagEvent::WRITE_SPLIT, split_info);
+    });
+}
+
+void SequentialWriter::wait_for_closing_storages()
+{
+  if (closing_storage_.valid()) {
+    closing_storage_.get();
+  }
+}
+
+void SequentialWriter::apply_retention_budgets(
+  uint64_t closed_file_size, std::vector<size_t> closed_file_topic_message_counts)
+{
+  retained_bytes_ += closed_file_size;
+  retained_files_.push_back({closed_file_size, std::move(closed_file_topic_message_counts)});
+
+  const auto bag_end = metadata_.starting_time + metadata_.duration;
+  const auto max_age = std::chrono::seconds(storage_options_.max_bag_retention_duration);
+  std::vector<rcpputils::fs::path> deleted_files;
+  // metadata_.files holds the retained files followed by the current one
+  while (retained_files_.size() > 1) {
+    const auto & oldest = metadata_.files.front();
+    const bool exceeds_size = storage_options_.max_bag_retention_size != 0 &&
+      retained_bytes_ > storage_options_.max_bag_retention_size;
+    const bool exceeds_duration = storage_options_.max_bag_retention_duration != 0 &&
+      (oldest.message_count == 0 || oldest.starting_time + oldest.duration + max_age < bag_end);
+    if (!exceeds_size && !exceeds_duration) {
+      break;
+    }
+
+    const auto & topic_message_counts = retained_files_.front().topic_message_counts;
+    if (deleted_topic_message_counts_.size() < topic_message_counts.size()) {
+      deleted_topic_message_counts_.resize(topic_message_counts.size(), 0u);
+    }
+    for (size_t i = 0; i < topic_message_counts.size(); ++i) {
+      deleted_topic_message_counts_[i] += topic_message_counts[i];
+    }
+    retained_bytes_ -= retained_files_.front().size;
+    retained_files_.pop_front();
+    deleted_files.push_back(
+      rcpputils::fs::path(base_folder_) / metadata_.relative_file_paths.front());
+    metadata_.relative_file_paths.erase(metadata_.relative_file_paths.begin());
+    metadata_.files.erase(metadata_.files.begin());
+    ++deleted_file_count_;
+  }
+  if (deleted_files.empty()) {
+    return;
+  }
+
+  // The bag now starts with the first message of the oldest file kept
+  auto starting_time = TimePoint(std::chrono::nanoseconds::max());
+  for (const auto & file : metadata_.files) {
+    if (file.message_count > 0) {
+      starting_time = std::min(starting_time, file.starting_time);
+    }
+  }
+  if (starting_time != TimePoint(std::chrono::nanoseconds::max())) {
+    metadata_.starting_time = starting_time;
+    metadata_.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      bag_end - starting_time);
+  }
+
+  ROSBAG2_CPP_LOG_DEBUG_STREAM(
+    "Deleting " << deleted_files.size() << " bag file(s) beyond the retention budget");
+  retention_deletion_ = std::async(
+    std::launch::async,
+    [previous = std::move(retention_deletion_), files = std::move(deleted_files)]() mutable {
+      if (previous.valid()) {
+        previous.wait();
+      }
+      for (const auto & file : files) {
+        if (!rcpputils::fs::remove(file)) {
+          ROSBAG2_CPP_LOG_WARN_STREAM(
+            "Failed to delete bag file '" << file.string() << "' beyond the retention budget");
+        }
+      }
+    });
+}
+
+void SequentialWriter::wait_for_retention_deletions()
+{
+  if (retention_deletion_.valid()) {
+    retention_deletion_.get();
+  }
+}
+
+void SequentialWriter::append_current_file_to_metadata_journal()
+{
+  const auto & file_info = metadata_.files.back();
+  rosbag2_storage::BagMetadata file_metadata;
+  file_metadata.storage_identifier = metadata_.storage_identifier;
+  file_metadata.relative_file_paths = {file_info.path};
+  file_metadata.files = {file_info};
+  file_metadata.starting_time = file_info.starting_time;
+  file_metadata.duration = file_info.duration;
+  file_metadata.message_count = file_info.message_count;
+  file_metadata.ros_distro = metadata_.ros_distro;
+  file_metadata.custom_data = metadata_.custom_data;
+  {
+    std::lock_guard<std::mutex> lock(topics_info_mutex_);
+    const auto topic_ids = std::atomic_load(&topic_ids_);
+    for (uint32_t topic_id = 0; topic_id < topic_ids->ids_to_names.size(); ++topic_id) {
+      auto topic = topics_names_to_info_.find(topic_ids->ids_to_names[topic_id]);
+      if (topic == topics_names_to_info_.end()) {
+        continue;
+      }
+      rosbag2_storage::TopicInformation topic_info = topic->second;
+      const size_t count =
+        topic_id < topic_message_counts_.size() ? topic_message_counts_[topic_id] : 0u;
+      const size_t start_count = topic_id < file_start_topic_message_counts_.size() ?
+        file_start_topic_message_counts_[topic_id] : 0u;
+      topic_info.message_count = count - start_count;
+      file_metadata.topics_with_message_count.push_back(std::move(topic_info));
+    }
+  }
+  file_start_topic_message_counts_ = topic_message_counts_;
+
+  try {
+    metadata_io_->append_to_metadata_journal(base_folder_, file_metadata);
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_WARN_STREAM(
+      "Failed to journal the metadata of bag file '" << file_info.path << "': " << e.what());
+  }
+}
+
+void SequentialWriter::write_topic_statistics()
+{
+  std::vector<rosbag2_storage::TopicStatistics> statistics;
+  {
+    const auto topic_ids = std::atomic_load(&topic_ids_);
+    for (uint32_t topic_id = 0; topic_id < topic_ids->ids_to_names.size(); ++topic_id) {
+      if (topic_ids->ids_to_names[topic_id].empty()) {
+        continue;
+      }
+      statistics.push_back(
+        topic_id < topic_statistics_.size() ?
+        topic_statistics_[topic_id] : rosbag2_storage::TopicStatistics{});
+      statistics.back().topic_name = topic_ids->ids_to_names[topic_id];
+    }
+  }
+
+  try {
+    metadata_io_->write_topic_statistics(base_folder_, statistics);
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Failed to write topic statistics: " << e.what());
+  }
+}
+
+void SequentialWriter::write_preview()
+{
+  if (!preview_) {
+    return;
+  }
+  try {
+    preview_->write(base_folder_);
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_WARN_STREAM("Failed to write bag preview: " << e.what());
+  }
+  preview_.reset();
 }
 
 void SequentialWriter::split_bagfile()
 {
+  std::lock_guard<std::mutex> storage_lock(snapshot_storage_mutex_);
+  snapshot_in_current_file_ = false;
   auto info = std::make_shared<bag_events::BagSplitInfo>();
   info->closed_file = storage_->get_relative_file_path();
-  switch_to_next_storage();
+  const bool retention_enabled = storage_options_.max_bag_retention_size != 0 ||
+    storage_options_.max_bag_retention_duration != 0;
+  auto previous_storage = switch_to_next_storage(info->closed_file_statistics);
+  const uint64_t closed_file_size = info->closed_file_statistics.size;
   info->opened_file = storage_->get_relative_file_path();
+  if (previous_storage) {
+    close_storage_async(std::move(previous_storage), metadata_, info);
+  }
+  std::vector<size_t> closed_file_topic_message_counts;
+  if (retention_enabled) {
+    closed_file_topic_message_counts = topic_message_counts_;
+    for (size_t i = 0; i < file_start_topic_message_counts_.size(); ++i) {
+      closed_file_topic_message_counts[i] -= file_start_topic_message_counts_[i];
+    }
+  }
+  append_current_file_to_metadata_journal();
 
   metadata_.relative_file_paths.push_back(strip_parent_path(storage_->get_relative_file_path()));
 
@@ -330,8 +955,16 @@ void SequentialWriter::split_bagfile()
     std::chrono::nanoseconds::max());
   file_info.path = strip_parent_path(storage_->get_relative_file_path());
   metadata_.files.push_back(file_info);
+  if (retention_enabled) {
+    apply_retention_budgets(closed_file_size, std::move(closed_file_topic_message_counts));
+  }
 
-  callback_manager_.execute_callbacks(bag_events::BagEvent::WRITE_SPLIT, info);
+  if (storage_options_.async_split) {
+    // WRITE_SPLIT callbacks are called once the previous file is closed
+    prepare_standby_storage();
+  } else {
+    callback_manager_.execute_callbacks(bag_events::BagEvent::WRITE_SPLIT, info);
+  }
 }
 
 void SequentialWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
@@ -344,15 +977,15 @@ void SequentialWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBa
     return;
   }
 
-  // Get TopicInformation handler for counting messages.
-  rosbag2_storage::TopicInformation * topic_information {nullptr};
-  try {
-    topic_information = &topics_names_to_info_.at(message->topic_name);
-  } catch (const std::out_of_range & /* oor */) {
-    std::stringstream errmsg;
-    errmsg << "Failed to write on topic '" << message->topic_name <<
-      "'. Call create_topic() before first write.";
-    throw std::runtime_error(errmsg.str());
+  // Resolve the topic id for counting messages.
+  const uint32_t topic_id = resolve_topic_id(*message);
+
+  if (storage_options_.snapshot_mode) {
+    // The metadata is updated when a snapshot is written, every snapshot goes to a file of its own
+    auto writeable_message = get_writeable_message(message);
+    StageTimer timer(pipeline_statistics_.get(), PipelineStage::CACHE_PUSH);
+    message_cache_->push(std::move(writeable_message));
+    return;
   }
 
   const auto message_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>(
@@ -385,14 +1018,78 @@ void SequentialWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBa
   metadata_.files.back().message_count++;
   if (storage_options_.max_cache_size == 0u) {
     // If cache size is set to zero, we write to storage directly
-    storage_->write(converted_msg);
-    ++topic_information->message_count;
+    {
+      StageTimer timer(
+        pipeline_statistics_.get(), PipelineStage::STORAGE_WRITE, &file_write_latencies_);
+      storage_->write(encode_payload(converted_msg));
+    }
+    count_written_message(topic_id, *converted_msg);
   } else {
     // Otherwise, use cache buffer
+    StageTimer timer(pipeline_statistics_.get(), PipelineStage::CACHE_PUSH);
     message_cache_->push(converted_msg);
   }
 }
 
+bool SequentialWriter::copy_bag_file(
+  const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!storage_) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  const bool splitting_enabled =
+    storage_options_.max_bagfile_size !=
+    rosbag2_storage::storage_interfaces::MAX_BAGFILE_SIZE_NO_SPLIT ||
+    storage_options_.max_bagfile_duration !=
+    rosbag2_storage::storage_interfaces::MAX_BAGFILE_DURATION_NO_SPLIT;
+  if (converter_ || splitting_enabled || storage_options_.snapshot_mode ||
+    !topics_names_to_info_.empty())
+  {
+    return false;
+  }
+
+  auto filter = storage_filter;
+  if (storage_options_.start_time_ns >= 0) {
+    filter.start_time_ns = std::max(filter.start_time_ns, storage_options_.start_time_ns);
+  }
+  if (storage_options_.end_time_ns >= 0) {
+    filter.end_time_ns = filter.end_time_ns >= 0 ?
+      std::min(filter.end_time_ns, storage_options_.end_time_ns) : storage_options_.end_time_ns;
+  }
+
+  std::lock_guard<std::mutex> storage_lock(snapshot_storage_mutex_);
+  const auto copied = storage_->copy_file(uri, filter);
+  if (!copied) {
+    return false;
+  }
+
+  for (const auto & topic : copied->topics_with_message_count) {
+    const auto & topic_metadata = topic.topic_metadata;
+    uint32_t topic_id = 0;
+    {
+      std::lock_guard<std::mutex> lock(topics_info_mutex_);
+      topics_names_to_info_.emplace(topic_metadata.name, rosbag2_storage::TopicInformation{
+          topic_metadata, 0});
+      topic_id = assign_topic_id(topic_metadata.name);
+    }
+    if (topic_id >= topic_message_counts_.size()) {
+      topic_message_counts_.resize(topic_id + 1, 0u);
+    }
+    topic_message_counts_[topic_id] += topic.message_count;
+  }
+
+  if (copied->message_count > 0) {
+    const auto first = copied->starting_time;
+    const auto last = copied->starting_time + copied->duration;
+    auto & file_info = metadata_.files.back();
+    extend_time_range(file_info.starting_time, file_info.duration, first, last);
+    extend_time_range(metadata_.starting_time, metadata_.duration, first, last);
+    file_info.message_count += copied->message_count;
+    is_first_message_ = false;
+  }
+  return true;
+}
+
 bool SequentialWriter::take_snapshot()
 {
   if (!storage_options_.snapshot_mode) {
@@ -407,7 +1104,11 @@ std::shared_ptr<const rosbag2_storage::SerializedBagMessage>
 SequentialWriter::get_writeable_message(
   std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
-  return converter_ ? converter_->convert(message) : message;
+  // The cache consumer converts the messages in batches on the threads of parallel_converter_
+  if (parallel_converter_ || !converter_) {
+    return message;
+  }
+  return converter_->convert(message);
 }
 
 bool SequentialWriter::should_split_bagfile(
@@ -470,6 +1171,19 @@ void SequentialWriter::finalize_metadata()
   metadata_.topics_with_message_count.reserve(topics_names_to_info_.size());
   metadata_.message_count = 0;
 
+  const auto topic_ids = std::atomic_load(&topic_ids_);
+  for (uint32_t topic_id = 0; topic_id < topic_ids->ids_to_names.size(); ++topic_id) {
+    auto topic = topics_names_to_info_.find(topic_ids->ids_to_names[topic_id]);
+    if (topic != topics_names_to_info_.end()) {
+      topic->second.message_count =
+        topic_id < topic_message_counts_.size() ? topic_message_counts_[topic_id] : 0u;
+      // Messages of the files deleted for the retention budgets are not in the bag anymore
+      if (topic_id < deleted_topic_message_counts_.size()) {
+        topic->second.message_count -= deleted_topic_message_counts_[topic_id];
+      }
+    }
+  }
+
   for (const auto & topic : topics_names_to_info_) {
     metadata_.topics_with_message_count.push_back(topic.second);
     metadata_.message_count += topic.second.message_count;
@@ -479,21 +1193,111 @@ void SequentialWriter::finalize_metadata()
 void SequentialWriter::write_messages(
   const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
 {
+  // Topics are created before their first message is cached, so they are registered before the
+  // batch with their first message is written
+  register_pending_topics();
   if (messages.empty()) {
     return;
   }
-  storage_->write(messages);
-  std::lock_guard<std::mutex> lock(topics_info_mutex_);
+  StageTimer timer(pipeline_statistics_.get(), PipelineStage::CONSUMER_BATCH);
+  if (pipeline_statistics_) {
+    size_t batch_bytes = 0;
+    for (const auto & msg : messages) {
+      batch_bytes += msg->serialized_data ? msg->serialized_data->buffer_length : 0u;
+    }
+    pipeline_statistics_->set_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES, messages.size());
+    pipeline_statistics_->set_queue_depth(PipelineQueue::CACHE_BATCH_BYTES, batch_bytes);
+    pipeline_statistics_->set_cache_dropped_messages(
+      message_cache_->get_dropped_message_counts_per_priority());
+  }
+  if (parallel_converter_) {
+    const auto converted = parallel_converter_->convert(messages);
+    write_batch_to_storage(
+      std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>(
+        converted.begin(), converted.end()));
+  } else {
+    write_batch_to_storage(messages);
+  }
   for (const auto & msg : messages) {
-    if (topics_names_to_info_.find(msg->topic_name) != topics_names_to_info_.end()) {
-      topics_names_to_info_[msg->topic_name].message_count++;
+    if (msg->topic_id != rosbag2_storage::UNASSIGNED_TOPIC_ID) {
+      count_written_message(msg->topic_id, *msg);
+      continue;
     }
+    // Untagged message, e.g. written through a custom writer implementation
+    const uint32_t topic_id = get_topic_id(msg->topic_name);
+    if (topic_id != rosbag2_storage::UNASSIGNED_TOPIC_ID) {
+      count_written_message(topic_id, *msg);
+    }
+  }
+}
+
+void SequentialWriter::write_snapshot(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages,
+  bool continues_snapshot)
+{
+  if (messages.empty()) {
+    return;
+  }
+  bool needs_next_file = false;
+  {
+    std::lock_guard<std::mutex> storage_lock(snapshot_storage_mutex_);
+    needs_next_file = snapshot_in_current_file_ && !continues_snapshot;
+  }
+  if (needs_next_file) {
+    split_bagfile();
   }
+
+  const auto minmax_time_stamp = std::minmax_element(
+    messages.begin(), messages.end(),
+    [](const auto & lhs, const auto & rhs) {return lhs->time_stamp < rhs->time_stamp;});
+  const TimePoint first(std::chrono::nanoseconds((*minmax_time_stamp.first)->time_stamp));
+  const TimePoint last(std::chrono::nanoseconds((*minmax_time_stamp.second)->time_stamp));
+
+  std::lock_guard<std::mutex> storage_lock(snapshot_storage_mutex_);
+  auto & file_info = metadata_.files.back();
+  extend_time_range(file_info.starting_time, file_info.duration, first, last);
+  extend_time_range(metadata_.starting_time, metadata_.duration, first, last);
+  file_info.message_count += messages.size();
+  write_messages(messages);
+  snapshot_in_current_file_ = true;
+}
+
+void SequentialWriter::write_batch_to_storage(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  StageTimer timer(
+    pipeline_statistics_.get(), PipelineStage::STORAGE_WRITE, &file_write_latencies_);
+  if (!payload_deduplicator_ && !payload_delta_encoder_) {
+    storage_->write(messages);
+    return;
+  }
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> encoded;
+  encoded.reserve(messages.size());
+  for (const auto & message : messages) {
+    encoded.push_back(encode_payload(message));
+  }
+  storage_->write(encoded);
+}
+
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> SequentialWriter::encode_payload(
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (payload_delta_encoder_ && payload_delta_encoder_->is_encoded_topic(message->topic_name)) {
+    // Keyframes are not deduplicated, deltas are looked up by the keyframe's complete payload
+    return payload_delta_encoder_->encode(std::move(message));
+  }
+  return payload_deduplicator_ ? payload_deduplicator_->deduplicate(std::move(message)) : message;
+}
+
+void SequentialWriter::set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics)
+{
+  pipeline_statistics_ = std::move(statistics);
 }
 
 void SequentialWriter::add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks)
 {
   if (callbacks.write_split_callback) {
+    std::lock_guard<std::mutex> lock(callback_manager_mutex_);
     callback_manager_.add_event_callback(
       callbacks.write_split_callback,
       bag_events::BagEvent::WRITE_SPLIT);
@@ -0,0 +1,223 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_cpp/writers/striped_writer.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/logging.hpp"
+#include "rosbag2_cpp/writers/sequential_writer.hpp"
+
+#include "sub_bag_metadata.hpp"
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+
+StripedWriter::StripedWriter(
+  std::vector<std::string> stripe_directories,
+  StripeWriterFactory stripe_writer_factory,
+  StripeBy stripe_by,
+  size_t batch_bytes,
+  std::unique_ptr<rosbag2_storage::MetadataIo> metadata_io)
+: stripe_directories_(std::move(stripe_directories)),
+  stripe_writer_factory_(std::move(stripe_writer_factory)),
+  stripe_by_(stripe_by),
+  batch_bytes_(std::max<size_t>(batch_bytes, 1)),
+  metadata_io_(std::move(metadata_io))
+{
+  if (stripe_directories_.empty()) {
+    throw std::invalid_argument("StripedWriter needs at least one stripe directory.");
+  }
+  if (!stripe_writer_factory_) {
+    stripe_writer_factory_ = []() -> std::unique_ptr<writer_interfaces::BaseWriterInterface> {
+        return std::make_unique<SequentialWriter>();
+      };
+  }
+}
+
+StripedWriter::~StripedWriter()
+{
+  try {
+    close();
+  } catch (const std::exception & e) {
+    ROSBAG2_CPP_LOG_ERROR_STREAM(
+      "Failed to write the metadata of striped bag " << base_folder_ << ": " << e.what());
+  }
+}
+
+std::string StripedWriter::get_stripe_uri(
+  const std::string & stripe_directory, const std::string & storage_uri, size_t stripe_index)
+{
+  const std::string bag_name = std::filesystem::path(storage_uri).filename().string();
+  return (std::filesystem::path(stripe_directory) /
+         (bag_name + "_stripe_" + std::to_string(stripe_index))).string();
+}
+
+void StripedWriter::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const ConverterOptions & converter_options)
+{
+  close();
+  base_folder_ = storage_options.uri;
+  const std::filesystem::path bag_path(base_folder_);
+  if (std::filesystem::is_directory(bag_path)) {
+    throw std::runtime_error(
+            "Bag directory already exists (" + bag_path.string() +
+            "), can't overwrite existing bag");
+  }
+  std::filesystem::create_directories(bag_path);
+
+  batch_stripe_ = 0;
+  bytes_in_batch_ = 0;
+  for (size_t i = 0; i < stripe_directories_.size(); ++i) {
+    // An empty stripe directory is the bag directory itself
+    const std::string & stripe_directory =
+      stripe_directories_[i].empty() ? base_folder_ : stripe_directories_[i];
+    std::filesystem::create_directories(stripe_directory);
+    auto stripe_options = storage_options;
+    stripe_options.uri = get_stripe_uri(stripe_directory, base_folder_, i);
+    auto stripe = stripe_writer_factory_();
+    if (pipeline_statistics_) {
+      stripe->set_pipeline_statistics(pipeline_statistics_);
+    }
+    stripe->open(stripe_options, converter_options);
+    stripe_uris_.push_back(stripe_options.uri);
+    stripes_.push_back(std::move(stripe));
+  }
+}
+
+void StripedWriter::close()
+{
+  if (stripes_.empty()) {
+    return;
+  }
+  auto stripes = std::move(stripes_);
+  stripes_.clear();
+  std::exception_ptr error;
+  for (auto & stripe : stripes) {
+    try {
+      stripe->close();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  stripes.clear();
+  if (error) {
+    stripe_uris_.clear();
+    std::rethrow_exception(error);
+  }
+  write_metadata();
+  stripe_uris_.clear();
+}
+
+void StripedWriter::create_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  for (auto & stripe : stripes_) {
+    stripe->create_topic(topic_with_type);
+  }
+}
+
+void StripedWriter::create_topic(
+  const rosbag2_storage::TopicMetadata & topic_with_type,
+  const rosbag2_storage::MessageDefinition & message_definition)
+{
+  for (auto & stripe : stripes_) {
+    stripe->create_topic(topic_with_type, message_definition);
+  }
+}
+
+void StripedWriter::remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type)
+{
+  for (auto & stripe : stripes_) {
+    stripe->remove_topic(topic_with_type);
+  }
+}
+
+void StripedWriter::prefetch_message_definitions(
+  const std::vector<rosbag2_storage::TopicMetadata> & topics)
+{
+  for (auto & stripe : stripes_) {
+    stripe->prefetch_message_definitions(topics);
+  }
+}
+
+void StripedWriter::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  if (stripes_.empty()) {
+    throw std::runtime_error("Bag is not open. Call open() before writing.");
+  }
+  stripes_[assign_stripe(*message)]->write(std::move(message));
+}
+
+bool StripedWriter::take_snapshot()
+{
+  bool all_taken = !stripes_.empty();
+  for (auto & stripe : stripes_) {
+    all_taken = stripe->take_snapshot() && all_taken;
+  }
+  return all_taken;
+}
+
+void StripedWriter::split_bagfile()
+{
+  for (auto & stripe : stripes_) {
+    stripe->split_bagfile();
+  }
+}
+
+void StripedWriter::add_event_callbacks(const bag_events::WriterEventCallbacks & callbacks)
+{
+  for (auto & stripe : stripes_) {
+    stripe->add_event_callbacks(callbacks);
+  }
+}
+
+void StripedWriter::set_pipeline_statistics(std::shared_ptr<PipelineStatistics> statistics)
+{
+  pipeline_statistics_ = std::move(statistics);
+}
+
+size_t StripedWriter::assign_stripe(const rosbag2_storage::SerializedBagMessage & message)
+{
+  if (stripe_by_ == StripeBy::TOPIC) {
+    return std::hash<std::string>{}(message.topic_name) % stripes_.size();
+  }
+  if (bytes_in_batch_ >= batch_bytes_) {
+    batch_stripe_ = (batch_stripe_ + 1) % stripes_.size();
+    bytes_in_batch_ = 0;
+  }
+  bytes_in_batch_ += message.serialized_data ? message.serialized_data->buffer_length : 0;
+  return batch_stripe_;
+}
+
+void StripedWriter::write_metadata()
+{
+  metadata_io_->write_metadata(
+    base_folder_, details::merge_sub_bag_metadata(base_folder_, stripe_uris_, *metadata_io_));
+}
+
+}  // namespace writers
+}  // namespace rosbag2_cpp
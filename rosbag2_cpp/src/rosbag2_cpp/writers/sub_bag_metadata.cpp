@@ -0,0 +1,115 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sub_bag_metadata.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+namespace details
+{
+
+rosbag2_storage::BagMetadata merge_sub_bag_metadata(
+  const std::string & base_folder,
+  const std::vector<std::string> & sub_bag_uris,
+  rosbag2_storage::MetadataIo & metadata_io)
+{
+  const std::filesystem::path bag_path(base_folder);
+  std::vector<rosbag2_storage::BagMetadata> sub_bags_metadata;
+  for (const auto & sub_bag_uri : sub_bag_uris) {
+    sub_bags_metadata.push_back(metadata_io.read_metadata(sub_bag_uri));
+  }
+
+  // Files of the sub-bags, with their paths relative to the bag directory if they are within it
+  std::vector<rosbag2_storage::FileInformation> files;
+  std::vector<rosbag2_storage::FileInformation> empty_files;
+  for (size_t i = 0; i < sub_bags_metadata.size(); ++i) {
+    std::filesystem::path sub_bag_path(sub_bag_uris[i]);
+    const auto relative_sub_bag_path = sub_bag_path.lexically_relative(bag_path);
+    const bool inside_bag = !relative_sub_bag_path.empty() &&
+      *relative_sub_bag_path.begin() != "..";
+    sub_bag_path =
+      inside_bag ? relative_sub_bag_path : std::filesystem::absolute(sub_bag_path);
+    for (auto file_info : sub_bags_metadata[i].files) {
+      file_info.path = (sub_bag_path / std::filesystem::path(file_info.path).filename()).string();
+      (file_info.message_count > 0 ? files : empty_files).push_back(std::move(file_info));
+    }
+  }
+  if (files.empty() && !empty_files.empty()) {
+    // A bag without messages still has a file
+    files.push_back(empty_files.front());
+  }
+  std::stable_sort(
+    files.begin(), files.end(),
+    [](const rosbag2_storage::FileInformation & left,
+    const rosbag2_storage::FileInformation & right) {
+      return left.starting_time < right.starting_time;
+    });
+
+  rosbag2_storage::BagMetadata metadata = sub_bags_metadata.front();
+  metadata.relative_file_paths.clear();
+  metadata.files.clear();
+  metadata.topics_with_message_count.clear();
+  metadata.message_count = 0;
+  metadata.bag_size = 0;
+  std::unordered_map<std::string, size_t> topic_indices;
+  for (const auto & sub_bag_metadata : sub_bags_metadata) {
+    metadata.bag_size += sub_bag_metadata.bag_size;
+    if (sub_bag_metadata.compression_format != metadata.compression_format ||
+      sub_bag_metadata.compression_mode != metadata.compression_mode)
+    {
+      metadata.compression_format.clear();
+      metadata.compression_mode.clear();
+    }
+    for (const auto & topic_info : sub_bag_metadata.topics_with_message_count) {
+      auto [topic_index, inserted] = topic_indices.emplace(
+        topic_info.topic_metadata.name, metadata.topics_with_message_count.size());
+      if (inserted) {
+        metadata.topics_with_message_count.push_back(topic_info);
+      } else {
+        metadata.topics_with_message_count[topic_index->second].message_count +=
+          topic_info.message_count;
+      }
+    }
+  }
+
+  auto end_time = metadata.starting_time;
+  for (size_t i = 0; i < files.size(); ++i) {
+    const auto & file_info = files[i];
+    if (i == 0) {
+      metadata.starting_time = file_info.starting_time;
+      end_time = file_info.starting_time;
+    }
+    end_time = std::max(end_time, file_info.starting_time + file_info.duration);
+    metadata.message_count += file_info.message_count;
+    metadata.relative_file_paths.push_back(file_info.path);
+    metadata.files.push_back(file_info);
+  }
+  metadata.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    end_time - metadata.starting_time);
+  return metadata;
+}
+
+}  // namespace details
+}  // namespace writers
+}  // namespace rosbag2_cpp
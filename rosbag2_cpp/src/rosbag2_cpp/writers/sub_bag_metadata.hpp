@@ -0,0 +1,49 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_CPP__WRITERS__SUB_BAG_METADATA_HPP_
+#define ROSBAG2_CPP__WRITERS__SUB_BAG_METADATA_HPP_
+
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+
+namespace rosbag2_cpp
+{
+namespace writers
+{
+namespace details
+{
+
+/**
+ * Merge the metadata of bags written into one bag by several writers into the metadata of that
+ * bag.
+ *
+ * The merged metadata lists the files of all sub-bags sorted by their starting time, with their
+ * paths relative to base_folder if the sub-bag is within it and absolute otherwise. Files
+ * without messages are left out, unless no file has messages. The compression of the bag is the
+ * one of the sub-bags if they all agree, or none otherwise.
+ */
+rosbag2_storage::BagMetadata merge_sub_bag_metadata(
+  const std::string & base_folder,
+  const std::vector<std::string> & sub_bag_uris,
+  rosbag2_storage::MetadataIo & metadata_io);
+
+}  // namespace details
+}  // namespace writers
+}  // namespace rosbag2_cpp
+
+#endif  // ROSBAG2_CPP__WRITERS__SUB_BAG_METADATA_HPP_
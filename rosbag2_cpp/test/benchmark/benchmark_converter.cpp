@@ -0,0 +1,44 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_test_common/memory_management.hpp"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+// Converts messages with range(0) bytes of doubles from little to big endian CDR, which swaps
+// the bytes of every element.
+static void BM_converter_convert(benchmark::State & state)
+{
+  rosbag2_cpp::Converter converter("cdr", "cdr_be");
+  converter.add_topic("/benchmark", "test_msgs/msg/UnboundedSequences");
+
+  rosbag2_test_common::MemoryManagement memory_management;
+  auto sequences = std::make_shared<test_msgs::msg::UnboundedSequences>();
+  sequences->float64_values.resize(static_cast<size_t>(state.range(0)) / sizeof(double), 1.5);
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "/benchmark";
+  message->serialized_data = memory_management.serialize_message(sequences);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.convert(message));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_converter_convert)->RangeMultiplier(16)->Range(64, 4 * 1024 * 1024);
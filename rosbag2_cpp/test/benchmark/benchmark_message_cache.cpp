@@ -0,0 +1,65 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "rosbag2_cpp/cache/cache_consumer.hpp"
+#include "rosbag2_cpp/cache/message_cache.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+namespace
+{
+std::shared_ptr<const rosbag2_storage::SerializedBagMessage> make_message(size_t size)
+{
+  const std::vector<uint8_t> data(size, 42);
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "/benchmark";
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+
+std::shared_ptr<rosbag2_cpp::cache::MessageCache> cache;
+std::unique_ptr<rosbag2_cpp::cache::CacheConsumer> consumer;
+}  // namespace
+
+// Threads push messages of range(0) bytes, as subscriptions of the recorder do, while a consumer
+// drains the cache without writing. Pushes block while the cache is full, so that no message is
+// dropped and the rate is bounded by swapping the buffers.
+static void BM_message_cache_push(benchmark::State & state)
+{
+  const auto message = make_message(static_cast<size_t>(state.range(0)));
+  if (state.thread_index() == 0) {
+    cache = std::make_shared<rosbag2_cpp::cache::MessageCache>(
+      64 * 1024 * 1024, rosbag2_cpp::cache::CacheOverflowPolicy::BLOCK);
+    consumer = std::make_unique<rosbag2_cpp::cache::CacheConsumer>(
+      cache, [](const auto &) {});
+  }
+  for (auto _ : state) {
+    cache->push(message);
+  }
+  if (state.thread_index() == 0) {
+    consumer.reset();
+    cache.reset();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_message_cache_push)
+->RangeMultiplier(16)->Range(64, 4 * 1024 * 1024)
+->ThreadRange(1, 8)
+->UseRealTime();
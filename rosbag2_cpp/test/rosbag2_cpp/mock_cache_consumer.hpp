@@ -28,6 +28,12 @@ public:
     std::shared_ptr<MockMessageCache> message_cache,
     rosbag2_cpp::cache::CacheConsumer::consume_callback_function_t consume_callback)
   : rosbag2_cpp::cache::CacheConsumer(message_cache, consume_callback) {}
+
+  MockCacheConsumer(
+    std::shared_ptr<MockMessageCache> message_cache,
+    rosbag2_cpp::cache::CacheConsumer::consume_callback_function_t consume_callback,
+    const rosbag2_cpp::cache::WriteBatchingOptions & batching_options)
+  : rosbag2_cpp::cache::CacheConsumer(message_cache, consume_callback, batching_options) {}
 };
 
 #endif  // ROSBAG2_CPP__MOCK_CACHE_CONSUMER_HPP_
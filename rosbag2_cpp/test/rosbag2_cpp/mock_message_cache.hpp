@@ -17,6 +17,7 @@
 
 #include <gmock/gmock.h>
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -30,6 +31,15 @@ public:
   explicit MockMessageCache(uint64_t max_buffer_size)
   : rosbag2_cpp::cache::MessageCache(max_buffer_size) {}
 
+  MockMessageCache(
+    uint64_t max_buffer_size,
+    rosbag2_cpp::cache::CacheOverflowPolicy overflow_policy,
+    std::chrono::milliseconds block_timeout = std::chrono::milliseconds(0),
+    std::shared_ptr<rosbag2_cpp::cache::SpillFile> spill_file = nullptr,
+    const std::unordered_map<std::string, uint32_t> & topic_priorities = {})
+  : rosbag2_cpp::cache::MessageCache(
+      max_buffer_size, overflow_policy, block_timeout, spill_file, topic_priorities) {}
+
   std::unordered_map<std::string, uint32_t> messages_dropped() const
   {
     return messages_dropped_per_topic_;
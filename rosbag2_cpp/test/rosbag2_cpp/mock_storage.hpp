@@ -56,6 +56,9 @@ public:
   MOCK_METHOD0(reset_filter, void());
   MOCK_METHOD1(set_filter, void(const rosbag2_storage::StorageFilter &));
   MOCK_METHOD1(seek, void(const rcutils_time_point_value_t &));
+  MOCK_METHOD1(estimate, rosbag2_storage::ReadEstimate(const rosbag2_storage::StorageFilter &));
+  MOCK_METHOD0(refresh, bool());
+  MOCK_METHOD0(verify, rosbag2_storage::FileVerification());
   MOCK_CONST_METHOD0(get_bagfile_size, uint64_t());
   MOCK_CONST_METHOD0(get_relative_file_path, std::string());
   MOCK_CONST_METHOD0(get_storage_identifier, std::string());
@@ -0,0 +1,160 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/bag_catalog.hpp"
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+class BagCatalogTest : public TemporaryDirectoryFixture
+{
+public:
+  // Metadata of a file with 10 messages of each topic, from start to start + 100
+  static rosbag2_storage::BagMetadata file_metadata(
+    const std::string & file_name, rcutils_time_point_value_t start,
+    const std::vector<std::string> & topics)
+  {
+    rosbag2_storage::BagMetadata metadata;
+    metadata.storage_identifier = "mcap";
+    rosbag2_storage::FileInformation file;
+    file.path = file_name;
+    file.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+      std::chrono::nanoseconds(start));
+    file.duration = std::chrono::nanoseconds(100);
+    file.message_count = 10 * topics.size();
+    metadata.relative_file_paths.push_back(file.path);
+    metadata.files.push_back(file);
+    metadata.starting_time = file.starting_time;
+    metadata.duration = file.duration;
+    for (const auto & topic : topics) {
+      rosbag2_storage::TopicInformation topic_information;
+      topic_information.topic_metadata.name = topic;
+      topic_information.topic_metadata.type = "std_msgs/msg/String";
+      topic_information.message_count = 10;
+      metadata.topics_with_message_count.push_back(topic_information);
+    }
+    metadata.message_count = file.message_count;
+    return metadata;
+  }
+
+  std::string bag_path(const std::string & name) const
+  {
+    const auto path = std::filesystem::path(temporary_dir_path_) / "bags" / name;
+    std::filesystem::create_directories(path);
+    return path.string();
+  }
+
+  std::string bags_root() const
+  {
+    return (std::filesystem::path(temporary_dir_path_) / "bags").string();
+  }
+
+  std::string catalog_file() const
+  {
+    return (std::filesystem::path(temporary_dir_path_) / "catalog.yaml").string();
+  }
+
+  rosbag2_storage::MetadataIo metadata_io_;
+};
+
+TEST_F(BagCatalogTest, answers_topic_time_and_size_queries_from_the_summaries) {
+  metadata_io_.write_metadata(bag_path("camera"), file_metadata("camera_0.mcap", 0, {"/image"}));
+  rosbag2_storage::TopicStatistics image_statistics;
+  image_statistics.topic_name = "/image";
+  image_statistics.total_bytes = 4096;
+  metadata_io_.write_topic_statistics(bag_path("camera"), {image_statistics});
+  metadata_io_.write_metadata(
+    bag_path("site/2024/lidar"), file_metadata("lidar_0.mcap", 1000, {"/points", "/tf"}));
+
+  rosbag2_cpp::BagCatalog catalog;
+  EXPECT_EQ(catalog.update({bags_root()}), 2u);
+
+  rosbag2_cpp::BagCatalog::Query query;
+  EXPECT_THAT(catalog.find(query), SizeIs(2));
+  query.topic_name = "/tf";
+  const auto tf_bags = catalog.find(query);
+  ASSERT_THAT(tf_bags, SizeIs(1));
+  EXPECT_EQ(tf_bags[0].uri, bag_path("site/2024/lidar"));
+  EXPECT_EQ(tf_bags[0].start_time_ns, 1000);
+  EXPECT_EQ(tf_bags[0].end_time_ns, 1100);
+  EXPECT_EQ(tf_bags[0].message_count, 20u);
+  EXPECT_TRUE(tf_bags[0].closed);
+
+  query = {};
+  query.start_time_ns = 50;
+  query.end_time_ns = 999;
+  const auto bags_in_range = catalog.find(query);
+  ASSERT_THAT(bags_in_range, SizeIs(1));
+  EXPECT_EQ(bags_in_range[0].uri, bag_path("camera"));
+  ASSERT_THAT(bags_in_range[0].topics, SizeIs(1));
+  EXPECT_EQ(bags_in_range[0].topics[0].total_bytes, 4096u);
+
+  query = {};
+  query.min_bag_size = std::numeric_limits<uint64_t>::max();
+  EXPECT_THAT(catalog.find(query), IsEmpty());
+
+  EXPECT_TRUE(catalog.lookup(bag_path("camera") + "/").has_value());
+  EXPECT_FALSE(catalog.lookup(bags_root()).has_value());
+}
+
+TEST_F(BagCatalogTest, reads_only_new_and_changed_bags_again) {
+  metadata_io_.write_metadata(bag_path("done"), file_metadata("done_0.mcap", 0, {"/a"}));
+  // A recording which closed its first split
+  metadata_io_.append_to_metadata_journal(
+    bag_path("recording"), file_metadata("recording_0.mcap", 0, {"/a"}));
+
+  rosbag2_cpp::BagCatalog catalog(catalog_file());
+  EXPECT_EQ(catalog.update({bags_root()}), 2u);
+  EXPECT_EQ(catalog.update({bags_root()}), 0u);
+  auto recording = catalog.lookup(bag_path("recording"));
+  ASSERT_TRUE(recording.has_value());
+  EXPECT_FALSE(recording->closed);
+  EXPECT_EQ(recording->file_count, 1u);
+
+  metadata_io_.append_to_metadata_journal(
+    bag_path("recording"), file_metadata("recording_1.mcap", 100, {"/a", "/b"}));
+  EXPECT_EQ(catalog.update({bags_root()}), 1u);
+  recording = catalog.lookup(bag_path("recording"));
+  ASSERT_TRUE(recording.has_value());
+  EXPECT_EQ(recording->file_count, 2u);
+  EXPECT_EQ(recording->message_count, 30u);
+  EXPECT_EQ(recording->end_time_ns, 200);
+  EXPECT_THAT(recording->topics, SizeIs(2));
+
+  std::filesystem::remove_all(bag_path("done"));
+  EXPECT_EQ(catalog.update({bags_root()}), 0u);
+  EXPECT_FALSE(catalog.lookup(bag_path("done")).has_value());
+
+  // A new catalog starts from the saved summaries
+  rosbag2_cpp::BagCatalog loaded_catalog(catalog_file());
+  const auto loaded_recording = loaded_catalog.lookup(bag_path("recording"));
+  ASSERT_TRUE(loaded_recording.has_value());
+  EXPECT_EQ(loaded_recording->message_count, 30u);
+  EXPECT_THAT(loaded_recording->topics, SizeIs(2));
+  EXPECT_EQ(loaded_catalog.update({bags_root()}), 0u);
+}
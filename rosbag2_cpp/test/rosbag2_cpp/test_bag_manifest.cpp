@@ -0,0 +1,147 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/bag_manifest.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_metadata_io.hpp"
+#include "mock_storage.hpp"
+#include "mock_storage_factory.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+class BagManifestTest : public TemporaryDirectoryFixture
+{
+public:
+  BagManifestTest()
+  : storage_factory_(std::make_unique<NiceMock<MockStorageFactory>>()),
+    metadata_io_(std::make_unique<NiceMock<MockMetadataIo>>())
+  {
+    ON_CALL(*metadata_io_, metadata_file_exists(_)).WillByDefault(Return(true));
+    ON_CALL(*metadata_io_, read_metadata(_)).WillByDefault(
+      [this](const std::string & uri) {
+        return bags_.at(uri);
+      });
+  }
+
+  // Adds a bag of two files, with 10 messages of /a and /b each, from start to start + 100
+  void add_bag(const std::string & name, rcutils_time_point_value_t start)
+  {
+    rosbag2_storage::BagMetadata metadata;
+    metadata.storage_identifier = "mock";
+    for (size_t i = 0; i < 2; ++i) {
+      rosbag2_storage::FileInformation file;
+      file.path = name + "_" + std::to_string(i) + ".mock";
+      file.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+        std::chrono::nanoseconds(start + 50 * static_cast<int64_t>(i)));
+      file.duration = std::chrono::nanoseconds(50);
+      file.message_count = 10;
+      metadata.relative_file_paths.push_back(file.path);
+      metadata.files.push_back(file);
+    }
+    for (const auto & topic : {"/a", "/b"}) {
+      rosbag2_storage::TopicInformation topic_information;
+      topic_information.topic_metadata.name = topic;
+      topic_information.message_count = 10;
+      metadata.topics_with_message_count.push_back(topic_information);
+    }
+    metadata.message_count = 20;
+    bags_[bag_path(name)] = metadata;
+  }
+
+  std::string bag_path(const std::string & name) const
+  {
+    return (rcpputils::fs::path(temporary_dir_path_) / name).string();
+  }
+
+  std::unique_ptr<NiceMock<MockStorageFactory>> storage_factory_;
+  std::unique_ptr<NiceMock<MockMetadataIo>> metadata_io_;
+  std::map<std::string, rosbag2_storage::BagMetadata> bags_;
+};
+
+TEST_F(BagManifestTest, references_all_files_of_bags_without_window) {
+  add_bag("bag1", 0);
+  add_bag("bag2", 1000);
+  EXPECT_CALL(*storage_factory_, open_read_only(_)).Times(0);
+
+  rosbag2_cpp::BagManifest bag_manifest(std::move(storage_factory_), std::move(metadata_io_));
+  const auto manifest = bag_manifest.create(
+    bag_path("manifest"), {{bag_path("bag1")}, {bag_path("bag2")}});
+
+  EXPECT_THAT(
+    manifest.relative_file_paths, ElementsAre(
+      "../bag1/bag1_0.mock", "../bag1/bag1_1.mock", "../bag2/bag2_0.mock", "../bag2/bag2_1.mock"));
+  EXPECT_EQ(manifest.storage_identifier, "mock");
+  EXPECT_EQ(manifest.message_count, 40u);
+  EXPECT_EQ(manifest.starting_time.time_since_epoch().count(), 0);
+  EXPECT_EQ(manifest.duration.count(), 1100);
+  ASSERT_EQ(manifest.topics_with_message_count.size(), 2u);
+  EXPECT_EQ(manifest.topics_with_message_count[0].message_count, 20u);
+  EXPECT_EQ(manifest.files[3].window_start_time_ns, -1);
+  EXPECT_EQ(manifest.files[3].window_end_time_ns, -1);
+}
+
+TEST_F(BagManifestTest, leaves_out_files_outside_of_the_window_and_counts_cut_files) {
+  add_bag("bag1", 0);
+  auto storage = std::make_shared<NiceMock<MockStorage>>();
+  rosbag2_storage::ReadEstimate estimate;
+  estimate.message_count = 3;
+  ON_CALL(*storage, estimate(_)).WillByDefault(Return(estimate));
+  EXPECT_CALL(
+    *storage_factory_, open_read_only(Field(&rosbag2_storage::StorageOptions::uri,
+    EndsWith("bag1_0.mock")))).WillOnce(Return(storage));
+
+  rosbag2_cpp::BagManifest bag_manifest(std::move(storage_factory_), std::move(metadata_io_));
+  const auto manifest = bag_manifest.create(bag_path("manifest"), {{bag_path("bag1"), 20, 40}});
+
+  EXPECT_THAT(manifest.relative_file_paths, ElementsAre("../bag1/bag1_0.mock"));
+  ASSERT_EQ(manifest.files.size(), 1u);
+  EXPECT_EQ(manifest.files[0].window_start_time_ns, 20);
+  EXPECT_EQ(manifest.files[0].window_end_time_ns, 40);
+  EXPECT_EQ(manifest.files[0].message_count, 6u);
+  EXPECT_EQ(manifest.message_count, 6u);
+  EXPECT_EQ(manifest.starting_time.time_since_epoch().count(), 20);
+  EXPECT_EQ(manifest.duration.count(), 20);
+  ASSERT_EQ(manifest.topics_with_message_count.size(), 2u);
+  EXPECT_EQ(manifest.topics_with_message_count[1].message_count, 3u);
+}
+
+TEST_F(BagManifestTest, throws_for_compressed_files_or_different_storages) {
+  add_bag("bag1", 0);
+  add_bag("bag2", 1000);
+  bags_[bag_path("bag2")].storage_identifier = "other";
+  add_bag("compressed", 0);
+  bags_[bag_path("compressed")].compression_mode = "FILE";
+
+  rosbag2_cpp::BagManifest bag_manifest(std::move(storage_factory_), std::move(metadata_io_));
+  EXPECT_THROW(
+    bag_manifest.create(bag_path("manifest"), {{bag_path("bag1")}, {bag_path("bag2")}}),
+    std::runtime_error);
+  EXPECT_THROW(
+    bag_manifest.create(bag_path("manifest"), {{bag_path("compressed")}}), std::runtime_error);
+}
@@ -0,0 +1,141 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/bag_preview.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::BagPreview;
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+namespace
+{
+rosbag2_storage::SerializedBagMessage make_message(
+  const std::string & topic, rcutils_time_point_value_t time_stamp, const std::string & data)
+{
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = topic;
+  message.time_stamp = time_stamp;
+  message.serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+
+std::string data_of(const BagPreview::Sample & sample)
+{
+  return std::string(sample.serialized_data.begin(), sample.serialized_data.end());
+}
+}  // namespace
+
+class BagPreviewTest : public TemporaryDirectoryFixture
+{
+};
+
+TEST_F(BagPreviewTest, counts_messages_and_bytes_per_bucket) {
+  BagPreview preview(100);
+  preview.add_message(make_message("/a", 10, "xx"));
+  preview.add_message(make_message("/a", 99, "xxx"));
+  preview.add_message(make_message("/a", 250, "x"));
+  preview.add_message(make_message("/b", -1, "xxxx"));
+
+  const auto & topics = preview.topics();
+  ASSERT_EQ(topics.size(), 2u);
+  const auto & a_buckets = topics.at("/a").buckets;
+  ASSERT_EQ(a_buckets.size(), 2u);
+  EXPECT_EQ(a_buckets.at(0).message_count, 2u);
+  EXPECT_EQ(a_buckets.at(0).size, 5u);
+  EXPECT_EQ(a_buckets.at(200).message_count, 1u);
+  EXPECT_EQ(a_buckets.at(200).size, 1u);
+  EXPECT_EQ(topics.at("/a").message_count, 3u);
+  EXPECT_EQ(topics.at("/b").buckets.count(-100), 1u);
+}
+
+TEST_F(BagPreviewTest, keeps_every_nth_message_of_sample_topics) {
+  BagPreview preview(100, {"/camera"}, 3);
+  for (int i = 0; i < 7; ++i) {
+    preview.add_message(make_message("/camera", i, "frame" + std::to_string(i)));
+    preview.add_message(make_message("/other", i, "data"));
+  }
+
+  const auto & samples = preview.topics().at("/camera").samples;
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[0].time_stamp, 0);
+  EXPECT_EQ(data_of(samples[0]), "frame0");
+  EXPECT_EQ(data_of(samples[1]), "frame3");
+  EXPECT_EQ(data_of(samples[2]), "frame6");
+  EXPECT_TRUE(preview.topics().at("/other").samples.empty());
+}
+
+TEST_F(BagPreviewTest, merges_buckets_to_coarser_resolution) {
+  BagPreview preview(100);
+  for (rcutils_time_point_value_t time_stamp : {0, 150, 320, 480, 1010}) {
+    preview.add_message(make_message("/a", time_stamp, "xx"));
+  }
+
+  // Rounded up to 500
+  const auto merged = preview.get_buckets("/a", 450);
+  ASSERT_EQ(merged.size(), 2u);
+  EXPECT_EQ(merged.at(0).message_count, 4u);
+  EXPECT_EQ(merged.at(0).size, 8u);
+  EXPECT_EQ(merged.at(1000).message_count, 1u);
+  EXPECT_EQ(preview.get_buckets("/a", 10).size(), 5u);
+  EXPECT_TRUE(preview.get_buckets("/unknown", 500).empty());
+}
+
+TEST_F(BagPreviewTest, write_and_read_round_trip) {
+  BagPreview preview(1000, {"/camera"}, 2);
+  preview.add_message(make_message("/camera", 5, std::string("a\nb\0c", 5)));
+  preview.add_message(make_message("/camera", 1500, "skipped"));
+  preview.add_message(make_message("/camera", 2500, ""));
+  preview.add_message(make_message("/imu", 2600, "imu"));
+
+  EXPECT_FALSE(BagPreview::exists(temporary_dir_path_));
+  preview.write(temporary_dir_path_);
+  ASSERT_TRUE(BagPreview::exists(temporary_dir_path_));
+  const auto read = BagPreview::read(temporary_dir_path_);
+
+  EXPECT_EQ(read.bucket_duration(), 1000);
+  ASSERT_EQ(read.topics().size(), 2u);
+  const auto & camera = read.topics().at("/camera");
+  EXPECT_EQ(camera.message_count, 3u);
+  ASSERT_EQ(camera.buckets.size(), 3u);
+  EXPECT_EQ(camera.buckets.at(1000).size, 7u);
+  ASSERT_EQ(camera.samples.size(), 2u);
+  EXPECT_EQ(camera.samples[0].time_stamp, 5);
+  EXPECT_EQ(data_of(camera.samples[0]), std::string("a\nb\0c", 5));
+  EXPECT_EQ(camera.samples[1].time_stamp, 2500);
+  EXPECT_TRUE(camera.samples[1].serialized_data.empty());
+  EXPECT_EQ(read.topics().at("/imu").buckets.at(2000).message_count, 1u);
+}
+
+TEST_F(BagPreviewTest, read_throws_for_missing_or_malformed_preview) {
+  EXPECT_THROW(BagPreview::read(temporary_dir_path_), std::runtime_error);
+  EXPECT_THROW(BagPreview::deserialize("topic /a 1 1 0\n0 1 1\n"), std::runtime_error);
+  EXPECT_THROW(
+    BagPreview::deserialize("bucket_duration 100\ntopic /a 1 0 1\n0 10\nshort"),
+    std::runtime_error);
+}
+
+TEST_F(BagPreviewTest, constructor_rejects_non_positive_durations_and_intervals) {
+  EXPECT_THROW(BagPreview(0), std::invalid_argument);
+  EXPECT_THROW(BagPreview(100, {}, 0), std::invalid_argument);
+}
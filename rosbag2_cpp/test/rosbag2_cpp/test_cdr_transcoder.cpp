@@ -0,0 +1,138 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rcpputils/shared_library.hpp"
+
+#include "rosbag2_cpp/cdr_transcoder.hpp"
+#include "rosbag2_cpp/converter.hpp"
+#include "rosbag2_cpp/typesupport_helpers.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/memory_management.hpp"
+
+#include "test_msgs/message_fixtures.hpp"
+
+using namespace ::testing;  // NOLINT
+
+using rosbag2_cpp::CdrTranscoder;
+
+namespace
+{
+std::vector<uint8_t> bytes_of(const rcutils_uint8_array_t & array)
+{
+  return {array.buffer, array.buffer + array.buffer_length};
+}
+
+std::shared_ptr<rcutils_uint8_array_t> array_of(const std::vector<uint8_t> & bytes)
+{
+  return rosbag2_storage::make_serialized_message(bytes.data(), bytes.size());
+}
+}  // namespace
+
+class CdrTranscoderTest : public Test
+{
+public:
+  CdrTranscoder make_transcoder(const std::string & type)
+  {
+    libraries_.push_back(
+      rosbag2_cpp::get_typesupport_library(type, "rosidl_typesupport_introspection_cpp"));
+    return CdrTranscoder(
+      rosbag2_cpp::get_typesupport_handle(
+        type, "rosidl_typesupport_introspection_cpp", libraries_.back()));
+  }
+
+  std::vector<uint8_t> transcode(
+    const CdrTranscoder & transcoder, const rcutils_uint8_array_t & input,
+    const std::string & format)
+  {
+    auto output = rosbag2_storage::make_empty_serialized_message(0);
+    transcoder.transcode(input, *CdrTranscoder::encapsulation_of_format(format), *output);
+    return bytes_of(*output);
+  }
+
+  std::vector<std::shared_ptr<rcpputils::SharedLibrary>> libraries_;
+  rosbag2_test_common::MemoryManagement memory_management_;
+};
+
+TEST_F(CdrTranscoderTest, swaps_byte_order_and_writes_encapsulation_header) {
+  const auto transcoder = make_transcoder("test_msgs/msg/Builtins");
+  // Duration {sec 1, nanosec 2}, Time {sec 3, nanosec 4} in little endian XCDR1
+  const auto input = array_of({0, 1, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0});
+
+  EXPECT_THAT(
+    transcode(transcoder, *input, "cdr_be"),
+    ElementsAre(0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4));
+  EXPECT_THAT(
+    transcode(transcoder, *input, "xcdr2_le"),
+    ElementsAre(0, 7, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0));
+  EXPECT_EQ(transcode(transcoder, *input, "cdr_le"), bytes_of(*input));
+}
+
+TEST_F(CdrTranscoderTest, transcoding_between_encodings_keeps_the_messages) {
+  const auto transcoder = make_transcoder("test_msgs/msg/Arrays");
+  for (const auto & message : get_messages_arrays()) {
+    const auto serialized = memory_management_.serialize_message(message);
+    const auto little_endian = array_of(transcode(transcoder, *serialized, "cdr_le"));
+
+    // Through XCDR2, which aligns doubles to 4 bytes and delimits arrays of strings and messages
+    auto transcoded = array_of(transcode(transcoder, *little_endian, "xcdr2_be"));
+    transcoded = array_of(transcode(transcoder, *transcoded, "cdr_be"));
+    EXPECT_EQ(transcode(transcoder, *transcoded, "cdr_le"), bytes_of(*little_endian));
+  }
+
+  const auto sequences_transcoder = make_transcoder("test_msgs/msg/UnboundedSequences");
+  for (const auto & message : get_messages_unbounded_sequences()) {
+    const auto serialized = memory_management_.serialize_message(message);
+    const auto big_endian = array_of(transcode(sequences_transcoder, *serialized, "cdr_be"));
+    auto read_message = memory_management_.deserialize_message<test_msgs::msg::UnboundedSequences>(
+      big_endian);
+    EXPECT_EQ(*read_message, *message);
+  }
+}
+
+TEST_F(CdrTranscoderTest, rejects_unsupported_types_and_malformed_messages) {
+  EXPECT_THROW(make_transcoder("test_msgs/msg/WStrings"), std::invalid_argument);
+
+  const auto transcoder = make_transcoder("test_msgs/msg/Builtins");
+  EXPECT_THROW(transcode(transcoder, *array_of({0, 1, 0, 0, 1, 0}), "cdr_be"), std::runtime_error);
+  // Parameter list encapsulation of mutable types
+  EXPECT_THROW(
+    transcode(transcoder, *array_of({0, 3, 0, 0, 1, 0, 0, 0}), "cdr_be"), std::runtime_error);
+  EXPECT_FALSE(CdrTranscoder::encapsulation_of_format("json"));
+}
+
+TEST_F(CdrTranscoderTest, converter_transcodes_between_cdr_formats) {
+  rosbag2_cpp::Converter converter("cdr", "cdr_be");
+  converter.add_topic("/builtins", "test_msgs/msg/Builtins");
+
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "/builtins";
+  message->time_stamp = 42;
+  message->serialized_data =
+    array_of({0, 1, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0});
+  const auto converted = converter.convert(message);
+  EXPECT_EQ(converted->time_stamp, 42);
+  EXPECT_THAT(
+    bytes_of(*converted->serialized_data),
+    ElementsAre(0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4));
+}
@@ -14,16 +14,19 @@
 
 #include <gmock/gmock.h>
 
+#include <chrono>
 #include <cmath>
 #include <list>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 #include "rosbag2_cpp/cache/circular_message_cache.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
 
 using namespace testing;  // NOLINT
 
@@ -66,7 +69,7 @@ public:
 
   virtual ~CircularMessageCacheTest() = default;
 
-  const size_t cache_size_ {1 * 500};  // 500B cache
+  const size_t cache_size_ {10 * 1000};  // ~10 Kb cache
 };
 
 TEST_F(CircularMessageCacheTest, circular_message_cache_overwrites_old) {
@@ -96,11 +99,12 @@ TEST_F(CircularMessageCacheTest, circular_message_cache_overwrites_old) {
   size_t message_data_size = 0;
 
   for (auto & msg : message_vector) {
-    message_data_size += msg->serialized_data->buffer_length;
+    message_data_size += rosbag2_cpp::cache::get_message_memory_bytes(*msg);
   }
 
   size_t cache_size_diff = abs_diff(cache_size_, message_data_size);
-  size_t allowed_diff{10};
+  // At most one message does not fit anymore
+  size_t allowed_diff = rosbag2_cpp::cache::get_message_memory_bytes(*message_vector.back());
 
   // Actual stored data size should be roughly the desired cache size
   EXPECT_THAT(cache_size_diff, Lt(allowed_diff));
@@ -122,14 +126,156 @@ TEST_F(CircularMessageCacheTest, circular_message_cache_ensure_empty) {
   EXPECT_THAT(circular_message_cache->get_consumer_buffer()->size(), Ne(0u));
   circular_message_cache->release_consumer_buffer();
 
-  // Swap back to primary (expected to empty buffer)
+  // Swap without another snapshot (expected to empty buffer)
+  circular_message_cache->swap_buffers();
+  EXPECT_THAT(circular_message_cache->get_consumer_buffer()->size(), Eq(0u));
+  circular_message_cache->release_consumer_buffer();
+  EXPECT_FALSE(circular_message_cache->has_pending_data());
+}
+
+TEST_F(CircularMessageCacheTest, circular_message_cache_drops_messages_older_than_duration) {
+  auto circular_message_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+    cache_size_, std::chrono::nanoseconds(10));
+
+  for (rcutils_time_point_value_t time_stamp = 0; time_stamp <= 30; time_stamp += 5) {
+    auto msg = make_test_msg();
+    msg->time_stamp = time_stamp;
+    circular_message_cache->push(msg);
+  }
   circular_message_cache->notify_data_ready();
   circular_message_cache->swap_buffers();
 
-  // Swap back to secondary without adding messages
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  for (const auto & msg : circular_message_cache->get_consumer_buffer()->data()) {
+    time_stamps.push_back(msg->time_stamp);
+  }
+  circular_message_cache->release_consumer_buffer();
+  EXPECT_THAT(time_stamps, ElementsAre(20, 25, 30));
+}
+
+TEST_F(CircularMessageCacheTest, circular_message_cache_queues_overlapping_snapshots) {
+  auto circular_message_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+    cache_size_);
+
+  auto first_msg = make_test_msg();
+  circular_message_cache->push(first_msg);
   circular_message_cache->notify_data_ready();
+  auto second_msg = make_test_msg();
+  circular_message_cache->push(second_msg);
+  circular_message_cache->notify_data_ready();
+  EXPECT_TRUE(circular_message_cache->has_pending_data());
+
   circular_message_cache->swap_buffers();
-  // Cache should have been emptied
-  EXPECT_THAT(circular_message_cache->get_consumer_buffer()->size(), Eq(0u));
+  EXPECT_THAT(circular_message_cache->get_consumer_buffer()->data(), ElementsAre(first_msg));
+  circular_message_cache->release_consumer_buffer();
+
+  circular_message_cache->swap_buffers();
+  EXPECT_THAT(
+    circular_message_cache->get_consumer_buffer()->data(), ElementsAre(first_msg, second_msg));
+  circular_message_cache->release_consumer_buffer();
+  EXPECT_FALSE(circular_message_cache->has_pending_data());
+}
+
+TEST_F(CircularMessageCacheTest, circular_message_cache_streams_messages_after_snapshot) {
+  auto circular_message_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+    cache_size_, std::chrono::nanoseconds(0), std::chrono::nanoseconds(10));
+
+  auto make_msg_at = [](rcutils_time_point_value_t time_stamp) {
+      auto msg = make_test_msg();
+      msg->time_stamp = time_stamp;
+      return std::shared_ptr<const rosbag2_storage::SerializedBagMessage>(msg);
+    };
+  auto pre_trigger_msg = make_msg_at(5);
+  circular_message_cache->push(pre_trigger_msg);
+  circular_message_cache->notify_data_ready();
+  auto post_trigger_msg = make_msg_at(15);
+  circular_message_cache->push(post_trigger_msg);
+
+  circular_message_cache->swap_buffers();
+  EXPECT_THAT(
+    circular_message_cache->get_consumer_buffer()->data(), ElementsAre(pre_trigger_msg));
+  EXPECT_FALSE(circular_message_cache->consumer_buffer_continues_snapshot());
+  circular_message_cache->release_consumer_buffer();
+
+  circular_message_cache->swap_buffers();
+  EXPECT_THAT(
+    circular_message_cache->get_consumer_buffer()->data(), ElementsAre(post_trigger_msg));
+  EXPECT_TRUE(circular_message_cache->consumer_buffer_continues_snapshot());
+  circular_message_cache->release_consumer_buffer();
+
+  // Streaming ends after the post-trigger duration
+  circular_message_cache->push(make_msg_at(16));
+  EXPECT_FALSE(circular_message_cache->has_pending_data());
+
+  // The streamed messages are kept for the next snapshot
+  circular_message_cache->notify_data_ready();
+  circular_message_cache->swap_buffers();
+  EXPECT_THAT(circular_message_cache->get_consumer_buffer()->size(), Eq(3u));
+  EXPECT_FALSE(circular_message_cache->consumer_buffer_continues_snapshot());
+  circular_message_cache->release_consumer_buffer();
+}
+
+TEST_F(CircularMessageCacheTest, circular_message_cache_copies_payloads_contiguously) {
+  auto circular_message_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+    cache_size_, std::chrono::nanoseconds(0), std::chrono::nanoseconds(0), true);
+
+  for (rcutils_time_point_value_t time_stamp = 0; time_stamp < 10; ++time_stamp) {
+    auto msg = make_test_msg();
+    msg->time_stamp = time_stamp;
+    msg->topic_name = time_stamp % 2 == 0 ? "even_topic" : "odd_topic";
+    msg->sequence_number = static_cast<uint64_t>(time_stamp);
+    circular_message_cache->push(msg);
+  }
+  circular_message_cache->notify_data_ready();
+  circular_message_cache->swap_buffers();
+  const auto snapshot = circular_message_cache->get_consumer_buffer()->data();
   circular_message_cache->release_consumer_buffer();
+
+  ASSERT_THAT(snapshot, SizeIs(10u));
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    EXPECT_EQ(snapshot[i]->time_stamp, static_cast<rcutils_time_point_value_t>(i));
+    EXPECT_EQ(snapshot[i]->sequence_number, i);
+    EXPECT_EQ(snapshot[i]->topic_name, i % 2 == 0 ? "even_topic" : "odd_topic");
+    EXPECT_THAT(deserialize_message(snapshot[i]->serialized_data), StartsWith("Hello"));
+    if (i > 0) {
+      // Payloads follow each other in the same block
+      const auto & previous = *snapshot[i - 1]->serialized_data;
+      EXPECT_EQ(snapshot[i]->serialized_data->buffer, previous.buffer + previous.buffer_length);
+    }
+  }
+}
+
+TEST_F(CircularMessageCacheTest, circular_message_cache_keeps_contiguous_snapshot_payloads) {
+  auto circular_message_cache = std::make_shared<rosbag2_cpp::cache::CircularMessageCache>(
+    cache_size_, std::chrono::nanoseconds(0), std::chrono::nanoseconds(0), true);
+
+  std::vector<std::string> pushed_payloads;
+  auto push_messages = [&](size_t count) {
+      for (size_t i = 0; i < count; ++i) {
+        auto msg = make_test_msg();
+        pushed_payloads.push_back(deserialize_message(msg->serialized_data));
+        circular_message_cache->push(msg);
+      }
+    };
+  push_messages(1000);
+  circular_message_cache->notify_data_ready();
+  // Overwrite the whole ring before the snapshot is consumed
+  push_messages(1000);
+  circular_message_cache->swap_buffers();
+  const auto snapshot = circular_message_cache->get_consumer_buffer()->data();
+  circular_message_cache->release_consumer_buffer();
+
+  ASSERT_THAT(snapshot, Not(IsEmpty()));
+  // More messages fit than if they were kept with the memory they hold
+  EXPECT_THAT(
+    snapshot.size(),
+    Gt(cache_size_ / rosbag2_cpp::cache::get_message_memory_bytes(*make_test_msg())));
+  const auto newest_payload = pushed_payloads.begin() + 1000;
+  const std::vector<std::string> expected_payloads(
+    newest_payload - snapshot.size(), newest_payload);
+  std::vector<std::string> payloads;
+  for (const auto & msg : snapshot) {
+    payloads.push_back(deserialize_message(msg->serialized_data));
+  }
+  EXPECT_EQ(payloads, expected_payloads);
 }
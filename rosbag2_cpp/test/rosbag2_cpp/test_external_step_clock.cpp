@@ -0,0 +1,117 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_cpp/clocks/external_step_clock.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::ExternalStepClock;
+
+class ExternalStepClockTest : public Test
+{
+public:
+  ExternalStepClockTest()
+  : clock(ros_start_time, std::chrono::milliseconds{1})
+  {
+    clock.set_step_completed_callback(
+      [this](rcutils_time_point_value_t time_point) {
+        completed.push_back(time_point);
+      });
+  }
+
+  rcutils_time_point_value_t ros_start_time = 100;
+  ExternalStepClock clock;
+  std::vector<rcutils_time_point_value_t> completed;
+};
+
+TEST_F(ExternalStepClockTest, time_only_advances_with_steps)
+{
+  EXPECT_EQ(clock.now(), ros_start_time);
+  EXPECT_TRUE(clock.sleep_until(ros_start_time));
+  EXPECT_FALSE(clock.sleep_until(ros_start_time + 1));
+  EXPECT_EQ(clock.now(), ros_start_time);
+
+  clock.step(200);
+  EXPECT_EQ(clock.now(), 200);
+  EXPECT_TRUE(clock.sleep_until(150));
+  EXPECT_TRUE(clock.sleep_until(200));
+  EXPECT_FALSE(clock.sleep_until(201));
+}
+
+TEST_F(ExternalStepClockTest, step_is_completed_once_when_waiting_past_it)
+{
+  clock.step(200);
+  EXPECT_TRUE(clock.sleep_until(200));
+  EXPECT_THAT(completed, IsEmpty());
+
+  EXPECT_FALSE(clock.sleep_until(300));
+  EXPECT_FALSE(clock.sleep_until(300));
+  EXPECT_THAT(completed, ElementsAre(200));
+
+  clock.step(300);
+  EXPECT_TRUE(clock.sleep_until(300));
+  EXPECT_TRUE(clock.complete_step());
+  EXPECT_FALSE(clock.complete_step());
+  EXPECT_THAT(completed, ElementsAre(200, 300));
+}
+
+TEST_F(ExternalStepClockTest, step_back_in_time_is_completed_without_moving_time)
+{
+  clock.step(200);
+  clock.step(150);
+  EXPECT_EQ(clock.now(), 200);
+  EXPECT_FALSE(clock.sleep_until(300));
+  EXPECT_THAT(completed, ElementsAre(200));
+}
+
+TEST_F(ExternalStepClockTest, waiting_sleep_wakes_up_on_step)
+{
+  ExternalStepClock slow_clock(ros_start_time, std::chrono::seconds{10});
+  std::thread stepper([&slow_clock]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      slow_clock.step(200);
+    });
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(slow_clock.sleep_until(200));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{5});
+  stepper.join();
+}
+
+TEST_F(ExternalStepClockTest, paused_clock_does_not_play_steps)
+{
+  clock.pause();
+  EXPECT_TRUE(clock.is_paused());
+  clock.step(200);
+  EXPECT_FALSE(clock.sleep_until(150));
+  EXPECT_THAT(completed, IsEmpty());
+
+  clock.resume();
+  EXPECT_TRUE(clock.sleep_until(150));
+}
+
+TEST_F(ExternalStepClockTest, jump_sets_time_and_rate_is_kept)
+{
+  clock.jump(50);
+  EXPECT_EQ(clock.now(), 50);
+  EXPECT_TRUE(clock.set_rate(2.0));
+  EXPECT_EQ(clock.get_rate(), 2.0);
+  EXPECT_FALSE(clock.set_rate(0.0));
+  EXPECT_FALSE(clock.set_rate(-1.0));
+  EXPECT_EQ(clock.get_rate(), 2.0);
+}
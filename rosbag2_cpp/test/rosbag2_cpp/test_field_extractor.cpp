@@ -0,0 +1,79 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "rosbag2_cpp/field_extractor.hpp"
+
+#include "rosbag2_test_common/memory_management.hpp"
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "test_msgs/msg/nested.hpp"
+
+using namespace ::testing;  // NOLINT
+
+TEST(FieldExtractorTest, extracts_nested_fields_of_serialized_messages) {
+  rosbag2_cpp::FieldExtractor extractor(
+    "test_msgs/msg/Nested", {"basic_types_value.float64_value", "basic_types_value.int32_value"});
+  EXPECT_THAT(
+    extractor.field_types(), ElementsAre(
+      rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE,
+      rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32));
+
+  rosbag2_test_common::MemoryManagement memory_management;
+  std::vector<double> doubles(3);
+  std::vector<int32_t> ints(3);
+  for (size_t i = 0; i < 3; ++i) {
+    auto message = std::make_shared<test_msgs::msg::Nested>();
+    message->basic_types_value.float64_value = 1.5 * i;
+    message->basic_types_value.int32_value = -7 * static_cast<int32_t>(i);
+    auto serialized = memory_management.serialize_message(message);
+    extractor.extract(*serialized, {doubles.data(), ints.data()}, i);
+  }
+
+  EXPECT_THAT(doubles, ElementsAre(0.0, 1.5, 3.0));
+  EXPECT_THAT(ints, ElementsAre(0, -7, -14));
+}
+
+TEST(FieldExtractorTest, rejects_fields_which_are_not_primitives) {
+  EXPECT_THROW(
+    rosbag2_cpp::FieldExtractor("test_msgs/msg/Nested", {"basic_types_value"}),
+    std::invalid_argument);
+  EXPECT_THROW(
+    rosbag2_cpp::FieldExtractor("test_msgs/msg/Nested", {"basic_types_value.no_such_field"}),
+    std::invalid_argument);
+  EXPECT_THROW(
+    rosbag2_cpp::FieldExtractor("test_msgs/msg/Strings", {"string_value"}),
+    std::invalid_argument);
+}
+
+TEST(FieldExtractorTest, lists_primitive_fields_of_nested_messages) {
+  const auto paths = rosbag2_cpp::FieldExtractor::primitive_field_paths("test_msgs/msg/Nested");
+  EXPECT_THAT(
+    paths, ElementsAre(
+      "basic_types_value.bool_value", "basic_types_value.byte_value",
+      "basic_types_value.char_value", "basic_types_value.float32_value",
+      "basic_types_value.float64_value", "basic_types_value.int8_value",
+      "basic_types_value.uint8_value", "basic_types_value.int16_value",
+      "basic_types_value.uint16_value", "basic_types_value.int32_value",
+      "basic_types_value.uint32_value", "basic_types_value.int64_value",
+      "basic_types_value.uint64_value"));
+  EXPECT_NO_THROW(rosbag2_cpp::FieldExtractor("test_msgs/msg/Nested", paths));
+}
@@ -0,0 +1,275 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/header_stamp_index.hpp"
+#include "rosbag2_cpp/readers/header_stamp_order_reader.hpp"
+
+#include "rosbag2_storage/topic_filter.hpp"
+
+#include "rosbag2_test_common/memory_management.hpp"
+
+#include "test_msgs/msg/basic_types.hpp"
+#include "test_msgs/msg/builtins.hpp"
+
+using namespace testing;  // NOLINT
+
+using rosbag2_cpp::HeaderStampIndex;
+using rosbag2_cpp::readers::HeaderStampOrderReader;
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp,
+  std::shared_ptr<rcutils_uint8_array_t> serialized_data = nullptr)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->serialized_data = std::move(serialized_data);
+  return message;
+}
+
+// Reader of messages in memory, in order of received time stamps
+class FakeReader : public rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  FakeReader(
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages,
+    std::vector<rosbag2_storage::TopicMetadata> topics)
+  : messages_(std::move(messages)), topics_(std::move(topics))
+  {}
+
+  void open(const rosbag2_storage::StorageOptions &, const rosbag2_cpp::ConverterOptions &) override
+  {}
+
+  void close() override {}
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override
+  {
+    read_order_ = order;
+    return order.sort_by == rosbag2_storage::ReadOrder::ReceivedTimestamp;
+  }
+
+  bool has_next() override
+  {
+    rosbag2_storage::TopicFilter topic_filter(filter_);
+    while (position_ < messages_.size() &&
+      !topic_filter.matches(messages_[position_]->topic_name))
+    {
+      ++position_;
+    }
+    return position_ < messages_.size();
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override
+  {
+    if (!has_next()) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    return messages_[position_++];
+  }
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override
+  {
+    return metadata_;
+  }
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override
+  {
+    return topics_;
+  }
+
+  void get_all_message_definitions(std::vector<rosbag2_storage::MessageDefinition> &) override {}
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override
+  {
+    filter_ = storage_filter;
+  }
+
+  void reset_filter() override
+  {
+    filter_ = rosbag2_storage::StorageFilter();
+  }
+
+  void seek(const rcutils_time_point_value_t & timestamp) override
+  {
+    position_ = 0;
+    while (position_ < messages_.size() && messages_[position_]->time_stamp < timestamp) {
+      ++position_;
+    }
+  }
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::ReaderEventCallbacks &) override {}
+
+  rosbag2_storage::ReadOrder read_order_;
+
+private:
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages_;
+  std::vector<rosbag2_storage::TopicMetadata> topics_;
+  rosbag2_storage::BagMetadata metadata_;
+  rosbag2_storage::StorageFilter filter_;
+  size_t position_ = 0;
+};
+}  // namespace
+
+class HeaderStampOrderReaderTest : public Test
+{
+public:
+  // /imu is stamped 5 ns before it is received, /lidar 32 ns, /tf is not indexed
+  HeaderStampOrderReaderTest()
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    for (rcutils_time_point_value_t received = 10; received <= 100; received += 10) {
+      messages.push_back(make_message("/imu", received));
+      index_.add_message("/imu", received, received - 5);
+      if (received == 30) {
+        messages.push_back(make_message("/tf", 33));
+      }
+      if (received == 30 || received == 70) {
+        messages.push_back(make_message("/lidar", received + 5));
+        index_.add_message("/lidar", received + 5, received - 27);
+      }
+    }
+    auto fake_reader = std::make_unique<FakeReader>(
+      messages, std::vector<rosbag2_storage::TopicMetadata>{
+        {"/imu", "type", "cdr", {}, ""}, {"/lidar", "type", "cdr", {}, ""},
+        {"/tf", "type", "cdr", {}, ""}});
+    fake_reader_ = fake_reader.get();
+    reader_ = std::make_unique<HeaderStampOrderReader>(std::move(fake_reader), index_);
+    reader_->open(rosbag2_storage::StorageOptions(), rosbag2_cpp::ConverterOptions());
+  }
+
+  std::vector<rcutils_time_point_value_t> read_all()
+  {
+    std::vector<rcutils_time_point_value_t> time_stamps;
+    while (reader_->has_next()) {
+      max_buffered_messages_ = std::max(max_buffered_messages_, reader_->get_buffered_messages());
+      time_stamps.push_back(reader_->read_next()->time_stamp);
+    }
+    return time_stamps;
+  }
+
+  HeaderStampIndex index_;
+  FakeReader * fake_reader_;
+  std::unique_ptr<HeaderStampOrderReader> reader_;
+  size_t max_buffered_messages_ = 0;
+};
+
+TEST_F(HeaderStampOrderReaderTest, reads_in_order_of_header_time_stamps) {
+  ASSERT_TRUE(reader_->set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, false}));
+  EXPECT_EQ(fake_reader_->read_order_.sort_by, rosbag2_storage::ReadOrder::ReceivedTimestamp);
+
+  // Received time stamps of the messages, stamped at 3, 5, 15, 25, 33, 35, 43, 45, ...
+  EXPECT_THAT(read_all(), ElementsAre(35, 10, 20, 30, 33, 40, 75, 50, 60, 70, 80, 90, 100));
+  EXPECT_LE(max_buffered_messages_, 13u);
+}
+
+TEST_F(HeaderStampOrderReaderTest, seek_goes_to_first_message_stamped_at_or_after_time_stamp) {
+  ASSERT_TRUE(reader_->set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, false}));
+  reader_->seek(40);
+  EXPECT_THAT(read_all(), ElementsAre(75, 50, 60, 70, 80, 90, 100));
+
+  reader_->seek(0);
+  EXPECT_THAT(read_all(), ElementsAre(35, 10, 20, 30, 33, 40, 75, 50, 60, 70, 80, 90, 100));
+}
+
+TEST_F(HeaderStampOrderReaderTest, filtered_topics_are_not_waited_for) {
+  ASSERT_TRUE(reader_->set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, false}));
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {"/imu"};
+  reader_->set_filter(storage_filter);
+
+  ASSERT_TRUE(reader_->has_next());
+  EXPECT_EQ(reader_->read_next()->time_stamp, 10);
+  EXPECT_THAT(read_all(), ElementsAre(20, 30, 40, 50, 60, 70, 80, 90, 100));
+}
+
+TEST_F(HeaderStampOrderReaderTest, other_read_orders_are_passed_on) {
+  ASSERT_TRUE(reader_->set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, false}));
+  ASSERT_TRUE(reader_->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, false}));
+  reader_->seek(0);
+  EXPECT_THAT(read_all(), ElementsAre(10, 20, 30, 33, 35, 40, 50, 60, 70, 75, 80, 90, 100));
+
+  EXPECT_FALSE(reader_->set_read_order({rosbag2_storage::ReadOrder::File, false}));
+  EXPECT_FALSE(reader_->set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, true}));
+}
+
+TEST(HeaderStampOrderReaderWithoutIndexTest, header_time_stamp_order_needs_an_index) {
+  HeaderStampOrderReader reader(
+    std::make_unique<FakeReader>(
+      std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>{},
+      std::vector<rosbag2_storage::TopicMetadata>{}));
+  reader.open(rosbag2_storage::StorageOptions(), rosbag2_cpp::ConverterOptions());
+  EXPECT_FALSE(reader.set_read_order({rosbag2_storage::ReadOrder::HeaderTimestamp, false}));
+  EXPECT_TRUE(reader.set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, false}));
+}
+
+TEST(HeaderStampIndexTest, serialized_index_is_read_back) {
+  HeaderStampIndex index;
+  index.add_message("/a", 10, 7);
+  index.add_message("/b", 10, 10);
+  index.add_message("/a", 20, 16);
+
+  const auto read_index = HeaderStampIndex::deserialize(index.serialize());
+  EXPECT_EQ(read_index.size(), 3u);
+  ASSERT_EQ(read_index.topics().count("/a"), 1u);
+  const auto & entries = read_index.topics().at("/a");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[1].received_time_stamp, 20);
+  EXPECT_EQ(entries[1].header_time_stamp, 16);
+
+  EXPECT_THROW(HeaderStampIndex::deserialize("topic /a 2\n10 7\n"), std::runtime_error);
+  EXPECT_THROW(index.add_message("/a", 15, 15), std::runtime_error);
+}
+
+TEST(HeaderStampIndexTest, build_extracts_stamps_of_messages_which_have_one) {
+  rosbag2_test_common::MemoryManagement memory_management;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int32_t i = 1; i <= 2; ++i) {
+    auto builtins = std::make_shared<test_msgs::msg::Builtins>();
+    builtins->time_value.sec = i;
+    builtins->time_value.nanosec = 500;
+    messages.push_back(
+      make_message(
+        "/builtins", RCUTILS_S_TO_NS(i) + 1000, memory_management.serialize_message(builtins)));
+    messages.push_back(
+      make_message(
+        "/basic", RCUTILS_S_TO_NS(i) + 2000,
+        memory_management.serialize_message(std::make_shared<test_msgs::msg::BasicTypes>())));
+  }
+  FakeReader reader(
+    messages, {{"/builtins", "test_msgs/msg/Builtins", "cdr", {}, ""},
+      {"/basic", "test_msgs/msg/BasicTypes", "cdr", {}, ""}});
+
+  const auto index = HeaderStampIndex::build(reader, "time_value");
+  EXPECT_EQ(index.size(), 4u);
+  const auto & builtins = index.topics().at("/builtins");
+  ASSERT_EQ(builtins.size(), 2u);
+  EXPECT_EQ(builtins[0].received_time_stamp, RCUTILS_S_TO_NS(1) + 1000);
+  EXPECT_EQ(builtins[0].header_time_stamp, RCUTILS_S_TO_NS(1) + 500);
+  EXPECT_EQ(builtins[1].header_time_stamp, RCUTILS_S_TO_NS(2) + 500);
+  // Types without the stamp are indexed by received time stamps
+  const auto & basic = index.topics().at("/basic");
+  ASSERT_EQ(basic.size(), 2u);
+  EXPECT_EQ(basic[1].header_time_stamp, RCUTILS_S_TO_NS(2) + 2000);
+}
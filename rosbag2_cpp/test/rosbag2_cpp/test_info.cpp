@@ -16,7 +16,9 @@
 
 #include <fstream>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
@@ -319,6 +321,109 @@ TEST_P(ParametrizedTemporaryDirectoryFixture, info_for_standalone_bagfile) {
   EXPECT_THAT(metadata.topics_with_message_count, SizeIs(1));
 }
 
+TEST_P(
+  ParametrizedTemporaryDirectoryFixture,
+  info_reads_metadata_of_bag_files_if_metadata_file_is_missing) {
+  const auto storage_id = GetParam();
+  const auto bag_path = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  {
+    rosbag2_cpp::Writer writer;
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.storage_id = storage_id;
+    storage_options.uri = bag_path.string();
+    writer.open(storage_options);
+    test_msgs::msg::BasicTypes msg;
+    writer.write(msg, "testtopic", rclcpp::Time{1});
+    writer.write(msg, "testtopic", rclcpp::Time{2});
+    writer.split_bagfile();
+    writer.write(msg, "testtopic", rclcpp::Time{3});
+  }
+  ASSERT_TRUE(
+    rcpputils::fs::remove(bag_path / rosbag2_storage::MetadataIo::metadata_filename));
+
+  rosbag2_cpp::Info info;
+  rosbag2_storage::BagMetadata metadata;
+  EXPECT_NO_THROW(
+    metadata = info.read_metadata(bag_path.string())
+  );
+  EXPECT_EQ(metadata.storage_identifier, storage_id);
+  EXPECT_THAT(metadata.relative_file_paths, SizeIs(2));
+  EXPECT_EQ(metadata.message_count, 3u);
+  ASSERT_THAT(metadata.topics_with_message_count, SizeIs(1));
+  EXPECT_EQ(metadata.topics_with_message_count[0].message_count, 3u);
+}
+
+TEST_P(ParametrizedTemporaryDirectoryFixture, splits_bag_into_time_shards_by_file_sizes) {
+  const auto storage_id = GetParam();
+  rosbag2_storage::BagMetadata metadata{};
+  metadata.storage_identifier = storage_id;
+  metadata.relative_file_paths = {"bag_0", "bag_1"};
+  metadata.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>{};
+  metadata.duration = std::chrono::nanoseconds{199};
+  metadata.message_count = 20;
+  const auto file_time = [](int64_t ns) {
+      return std::chrono::time_point<std::chrono::high_resolution_clock>(
+        std::chrono::nanoseconds{ns});
+    };
+  metadata.files = {
+    {"bag_0", file_time(0), std::chrono::nanoseconds{99}, 10},
+    {"bag_1", file_time(100), std::chrono::nanoseconds{99}, 10}};
+  rosbag2_storage::MetadataIo().write_metadata(temporary_dir_path_, metadata);
+  // The second file holds three times the data of the first one
+  for (const auto & [name, size] : {std::make_pair("bag_0", 1000), std::make_pair("bag_1", 3000)}) {
+    std::ofstream file((rcpputils::fs::path(temporary_dir_path_) / name).string());
+    file << std::string(size, 'x');
+  }
+
+  rosbag2_cpp::Info info;
+  const auto shards = info.split_into_time_shards(temporary_dir_path_, 2);
+  ASSERT_THAT(shards, SizeIs(2));
+  EXPECT_EQ(shards[0].start_time_ns, 0);
+  EXPECT_EQ(shards[0].end_time_ns, 133);
+  EXPECT_THAT(shards[0].files, ElementsAre("bag_0", "bag_1"));
+  EXPECT_EQ(shards[0].estimated_bytes, 2020u);
+  EXPECT_EQ(shards[1].start_time_ns, 134);
+  EXPECT_EQ(shards[1].end_time_ns, 199);
+  EXPECT_THAT(shards[1].files, ElementsAre("bag_1"));
+  EXPECT_EQ(shards[1].estimated_bytes, 1980u);
+
+  EXPECT_THAT(info.split_into_time_shards(temporary_dir_path_, 1), SizeIs(1));
+  EXPECT_THROW(info.split_into_time_shards(temporary_dir_path_, 0), std::invalid_argument);
+}
+
+TEST_P(ParametrizedTemporaryDirectoryFixture, reads_metadata_of_many_bags_concurrently) {
+  const auto storage_id = GetParam();
+  std::vector<std::string> uris;
+  for (int bag = 0; bag < 5; bag++) {
+    const auto bag_path = rcpputils::fs::path(temporary_dir_path_) / ("bag_" + std::to_string(bag));
+    rosbag2_cpp::Writer writer;
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.storage_id = storage_id;
+    storage_options.uri = bag_path.string();
+    writer.open(storage_options);
+    test_msgs::msg::BasicTypes msg;
+    for (int message = 0; message <= bag; message++) {
+      writer.write(msg, "testtopic", rclcpp::Time{message});
+    }
+    uris.push_back(bag_path.string());
+  }
+  // The metadata of the last bag is reconstructed from its file
+  ASSERT_TRUE(
+    rcpputils::fs::remove(
+      rcpputils::fs::path(uris.back()) / rosbag2_storage::MetadataIo::metadata_filename));
+
+  rosbag2_cpp::Info info;
+  const auto metadata = info.read_metadata_many(uris, 3);
+  ASSERT_THAT(metadata, SizeIs(uris.size()));
+  for (size_t bag = 0; bag < metadata.size(); bag++) {
+    EXPECT_EQ(metadata[bag].storage_identifier, storage_id);
+    EXPECT_EQ(metadata[bag].message_count, bag + 1);
+  }
+
+  uris.push_back((rcpputils::fs::path(temporary_dir_path_) / "missing").string());
+  EXPECT_THROW(info.read_metadata_many(uris), std::runtime_error);
+}
+
 INSTANTIATE_TEST_SUITE_P(
   RosbagInfoTests,
   ParametrizedTemporaryDirectoryFixture,
@@ -12,14 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <filesystem>
+#include <fstream>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "rosbag2_cpp/message_definitions/local_message_definition_source.hpp"
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
 
 using rosbag2_cpp::LocalMessageDefinitionSource;
 using rosbag2_cpp::parse_definition_dependencies;
+using ::testing::ElementsAre;
 using ::testing::UnorderedElementsAre;
 
 TEST(test_local_message_definition_source, can_find_idl_includes)
@@ -136,3 +141,60 @@ TEST(test_local_message_definition_source, no_crash_on_bad_name)
   });
   ASSERT_EQ(result.encoding, "unknown");
 }
+
+class LocalMessageDefinitionSourceCacheTest
+  : public rosbag2_test_common::TemporaryDirectoryFixture {};
+
+TEST_F(LocalMessageDefinitionSourceCacheTest, reads_full_text_from_cache_directory_by_type_hash)
+{
+  const std::string hash = "RIHS01_0123456789abcdef";
+  {
+    LocalMessageDefinitionSource source(temporary_dir_path_);
+    EXPECT_EQ(
+      source.get_full_text("rosbag2_test_msgdefs/ComplexMsg", hash).encoded_message_definition,
+      "rosbag2_test_msgdefs/BasicMsg b\n"
+      "\n"
+      "================================================================================\n"
+      "MSG: rosbag2_test_msgdefs/BasicMsg\n"
+      "float32 c\n");
+    // Not cached without a hash
+    source.get_full_text("rosbag2_test_msgdefs/BasicMsg");
+  }
+  std::vector<std::string> cache_files;
+  for (const auto & entry : std::filesystem::directory_iterator(temporary_dir_path_)) {
+    cache_files.push_back(entry.path().filename().string());
+  }
+  ASSERT_THAT(cache_files, ElementsAre("rosbag2_test_msgdefs.ComplexMsg." + hash + ".def"));
+
+  // A cached full text is not read from the definition files again
+  {
+    std::ofstream file(std::filesystem::path(temporary_dir_path_) / cache_files[0]);
+    file << "ros2msg\ncached definition";
+  }
+  LocalMessageDefinitionSource source(temporary_dir_path_);
+  auto result = source.get_full_text("rosbag2_test_msgdefs/ComplexMsg", hash);
+  EXPECT_EQ(result.encoding, "ros2msg");
+  EXPECT_EQ(result.encoded_message_definition, "cached definition");
+  EXPECT_EQ(result.topic_type, "rosbag2_test_msgdefs/ComplexMsg");
+  EXPECT_EQ(
+    source.get_full_text("rosbag2_test_msgdefs/ComplexMsg", "RIHS01_other").
+    encoded_message_definition, "cached definition");
+}
+
+TEST(test_local_message_definition_source, resolves_prefetched_types_on_threads)
+{
+  const std::vector<std::string> types{
+    "rosbag2_test_msgdefs/ComplexMsg", "rosbag2_test_msgdefs/BasicMsg",
+    "rosbag2_test_msgdefs/msg/ComplexIdl", "not_a_type"};
+  LocalMessageDefinitionSource source("", 2);
+  for (const auto & type : types) {
+    source.prefetch(type);
+  }
+  LocalMessageDefinitionSource inline_source;
+  for (const auto & type : types) {
+    auto expected = inline_source.get_full_text(type);
+    auto result = source.get_full_text(type);
+    EXPECT_EQ(result.encoding, expected.encoding);
+    EXPECT_EQ(result.encoded_message_definition, expected.encoded_message_definition);
+  }
+}
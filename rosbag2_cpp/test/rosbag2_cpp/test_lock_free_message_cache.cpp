@@ -0,0 +1,145 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/cache/cache_consumer.hpp"
+#include "rosbag2_cpp/cache/lock_free_message_cache.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg(
+  const std::string & topic_name = "test_topic")
+{
+  static std::atomic<uint32_t> counter{0};
+  std::string msg_content = "Hello" + std::to_string(counter++ % 10);
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->serialized_data = rosbag2_storage::make_serialized_message(
+    msg_content.c_str(), msg_content.length());
+  return message;
+}
+
+class TestLockFreeMessageCache : public rosbag2_cpp::cache::LockFreeMessageCache
+{
+public:
+  using rosbag2_cpp::cache::LockFreeMessageCache::LockFreeMessageCache;
+
+  uint32_t total_dropped() const
+  {
+    return std::accumulate(
+      messages_dropped_per_topic_.begin(), messages_dropped_per_topic_.end(), 0u,
+      [](uint32_t previous, const auto & element) {return previous + element.second;});
+  }
+};
+}  // namespace
+
+TEST(LockFreeMessageCacheTest, drops_messages_over_byte_budget) {
+  // Every test message holds the same memory
+  const size_t cache_size = 10 * rosbag2_cpp::cache::get_message_memory_bytes(*make_test_msg());
+  auto cache = std::make_shared<TestLockFreeMessageCache>(cache_size);
+
+  for (uint32_t i = 0; i < 20; ++i) {
+    cache->push(make_test_msg());
+  }
+  EXPECT_EQ(cache->size(), 10u);
+  EXPECT_EQ(cache->total_dropped(), 10u);
+
+  cache->swap_buffers();
+  auto consumer_buffer = cache->get_consumer_buffer();
+  EXPECT_EQ(consumer_buffer->size(), 10u);
+  consumer_buffer->clear();
+  cache->release_consumer_buffer();
+
+  // Consuming frees the byte budget again
+  cache->push(make_test_msg());
+  EXPECT_EQ(cache->size(), 1u);
+  EXPECT_EQ(cache->get_memory_bytes(), cache_size / 10);
+  EXPECT_EQ(cache->get_peak_memory_bytes(), cache_size);
+}
+
+TEST(LockFreeMessageCacheTest, drops_messages_when_ring_is_full) {
+  auto cache = std::make_shared<TestLockFreeMessageCache>(1024 * 1024, 4);
+  for (uint32_t i = 0; i < 6; ++i) {
+    cache->push(make_test_msg());
+  }
+  EXPECT_EQ(cache->size(), 4u);
+  EXPECT_EQ(cache->total_dropped(), 2u);
+}
+
+TEST(LockFreeMessageCacheTest, keeps_order_of_single_producer) {
+  auto cache = std::make_shared<TestLockFreeMessageCache>(1024 * 1024, 8);
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> pushed;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 5; ++i) {
+      pushed.push_back(make_test_msg());
+      cache->push(pushed.back());
+    }
+    cache->swap_buffers();
+  }
+  auto consumer_buffer = cache->get_consumer_buffer();
+  const auto & data = consumer_buffer->data();
+  ASSERT_EQ(data.size(), pushed.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(data[i], pushed[i]);
+  }
+  cache->release_consumer_buffer();
+}
+
+TEST(LockFreeMessageCacheTest, consumes_all_messages_of_concurrent_producers) {
+  const size_t producers = 4;
+  const size_t messages_per_producer = 2000;
+  auto cache = std::make_shared<TestLockFreeMessageCache>(
+    std::numeric_limits<size_t>::max() / 2, producers * messages_per_producer);
+
+  std::atomic<size_t> consumed_message_count {0};
+  auto cache_consumer = std::make_unique<rosbag2_cpp::cache::CacheConsumer>(
+    cache,
+    [&consumed_message_count](
+      const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_message_count += msgs.size();
+    });
+
+  std::vector<std::thread> producer_threads;
+  for (size_t p = 0; p < producers; ++p) {
+    producer_threads.emplace_back(
+      [&cache, p]() {
+        for (size_t i = 0; i < messages_per_producer; ++i) {
+          cache->push(make_test_msg("topic_" + std::to_string(p)));
+        }
+      });
+  }
+  for (auto & thread : producer_threads) {
+    thread.join();
+  }
+
+  cache_consumer->stop();
+  EXPECT_EQ(cache->total_dropped(), 0u);
+  EXPECT_EQ(consumed_message_count, producers * messages_per_producer);
+}
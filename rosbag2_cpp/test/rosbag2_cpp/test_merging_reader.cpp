@@ -0,0 +1,314 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/readers/merging_reader.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "mock_metadata_io.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+using Messages = std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>;
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, int32_t time_stamp)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(&time_stamp, 4);
+  return message;
+}
+
+// Reader of the messages of one file in memory
+class FakeFileReader : public rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  FakeFileReader(const std::map<std::string, Messages> & files, std::vector<std::string> & opened)
+  : files_(files), opened_(opened)
+  {}
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const rosbag2_cpp::ConverterOptions &) override
+  {
+    messages_ = files_.at(storage_options.uri);
+    opened_.push_back(rcpputils::fs::path(storage_options.uri).filename().string());
+    position_ = 0;
+  }
+
+  void close() override {}
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override
+  {
+    reverse_ = order.reverse;
+    return true;
+  }
+
+  bool has_next() override
+  {
+    while (position_ < messages_.size() && !filter_.topics.empty() &&
+      std::find(
+        filter_.topics.begin(), filter_.topics.end(),
+        message_at(position_)->topic_name) == filter_.topics.end())
+    {
+      ++position_;
+    }
+    return position_ < messages_.size();
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override
+  {
+    if (!has_next()) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    return message_at(position_++);
+  }
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override
+  {
+    return metadata_;
+  }
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override
+  {
+    return {};
+  }
+
+  void get_all_message_definitions(std::vector<rosbag2_storage::MessageDefinition> &) override {}
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override
+  {
+    filter_ = storage_filter;
+  }
+
+  void reset_filter() override
+  {
+    filter_ = rosbag2_storage::StorageFilter();
+  }
+
+  void seek(const rcutils_time_point_value_t & timestamp) override
+  {
+    position_ = 0;
+    while (position_ < messages_.size() &&
+      (reverse_ ? message_at(position_)->time_stamp > timestamp :
+      message_at(position_)->time_stamp < timestamp))
+    {
+      ++position_;
+    }
+  }
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::ReaderEventCallbacks &) override {}
+
+private:
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> message_at(size_t position) const
+  {
+    return messages_[reverse_ ? messages_.size() - 1 - position : position];
+  }
+
+  const std::map<std::string, Messages> & files_;
+  std::vector<std::string> & opened_;
+  Messages messages_;
+  rosbag2_storage::BagMetadata metadata_;
+  rosbag2_storage::StorageFilter filter_;
+  size_t position_ = 0;
+  bool reverse_ = false;
+};
+}  // namespace
+
+class MergingReaderTest : public Test
+{
+public:
+  MergingReaderTest()
+  : storage_options_({rcpputils::fs::temp_directory_path().string(), "mock_storage"})
+  {
+    metadata_.version = 5;
+    metadata_.storage_identifier = "mock_storage";
+  }
+
+  // Add a file with a message on topic "a" at each time stamp and on topic "b" at the first one
+  void add_file(const std::vector<int32_t> & time_stamps)
+  {
+    const auto name = "bag_file" + std::to_string(metadata_.relative_file_paths.size() + 1);
+    Messages messages;
+    for (const auto time_stamp : time_stamps) {
+      messages.push_back(make_message("a", time_stamp));
+      if (messages.size() == 1) {
+        messages.push_back(make_message("b", time_stamp));
+      }
+    }
+    metadata_.relative_file_paths.push_back(name);
+    rosbag2_storage::FileInformation file_information;
+    file_information.path = name;
+    file_information.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+      std::chrono::nanoseconds(time_stamps.front()));
+    file_information.duration =
+      std::chrono::nanoseconds(time_stamps.back() - time_stamps.front());
+    file_information.message_count = messages.size();
+    metadata_.files.push_back(file_information);
+    files_[(rcpputils::fs::path(storage_options_.uri) / name).string()] = std::move(messages);
+  }
+
+  void open_reader(size_t max_open_files)
+  {
+    auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+    ON_CALL(*metadata_io, read_metadata(_)).WillByDefault(Return(metadata_));
+    ON_CALL(*metadata_io, metadata_file_exists(_)).WillByDefault(Return(true));
+    reader_ = std::make_unique<rosbag2_cpp::readers::MergingReader>(
+      max_open_files, 0, std::move(metadata_io),
+      [this]() {return std::make_unique<FakeFileReader>(files_, opened_files_);});
+    reader_->open(storage_options_, {"", ""});
+  }
+
+  std::vector<std::pair<std::string, int64_t>> read_all()
+  {
+    std::vector<std::pair<std::string, int64_t>> messages;
+    while (reader_->has_next()) {
+      auto message = reader_->read_next();
+      messages.emplace_back(message->topic_name, message->time_stamp);
+    }
+    return messages;
+  }
+
+  std::vector<int64_t> read_all_time_stamps()
+  {
+    std::vector<int64_t> time_stamps;
+    for (const auto & message : read_all()) {
+      time_stamps.push_back(message.second);
+    }
+    return time_stamps;
+  }
+
+  rosbag2_storage::StorageOptions storage_options_;
+  rosbag2_storage::BagMetadata metadata_;
+  std::map<std::string, Messages> files_;
+  std::vector<std::string> opened_files_;
+  std::unique_ptr<rosbag2_cpp::readers::MergingReader> reader_;
+};
+
+TEST_F(MergingReaderTest, merges_overlapping_files_by_time_stamp) {
+  add_file({0, 30, 60});
+  add_file({10, 40, 70});
+  add_file({20, 50});
+  open_reader(1);
+
+  EXPECT_THAT(read_all_time_stamps(), ElementsAre(0, 0, 10, 10, 20, 20, 30, 40, 50, 60, 70));
+  EXPECT_THAT(opened_files_, ElementsAre("bag_file1", "bag_file2", "bag_file3"));
+}
+
+TEST_F(MergingReaderTest, returns_messages_with_equal_time_stamps_in_file_order) {
+  add_file({0, 10});
+  add_file({10, 20});
+  open_reader(2);
+
+  EXPECT_THAT(
+    read_all(), ElementsAre(
+      Pair("a", 0), Pair("b", 0), Pair("a", 10), Pair("a", 10), Pair("b", 10), Pair("a", 20)));
+}
+
+TEST_F(MergingReaderTest, opens_files_up_to_max_open_files_ahead) {
+  add_file({0, 10});
+  add_file({100, 110});
+  add_file({200, 210});
+  add_file({300, 310});
+  open_reader(2);
+
+  ASSERT_TRUE(reader_->has_next());
+  EXPECT_EQ(reader_->get_open_files_count(), 2u);
+  EXPECT_THAT(opened_files_, ElementsAre("bag_file1", "bag_file2"));
+  EXPECT_THAT(
+    read_all_time_stamps(), ElementsAre(0, 0, 10, 100, 100, 110, 200, 200, 210, 300, 300, 310));
+  EXPECT_EQ(reader_->get_open_files_count(), 0u);
+}
+
+TEST_F(MergingReaderTest, seek_skips_files_ending_before_time_stamp) {
+  add_file({0, 10});
+  add_file({100, 110});
+  add_file({200, 210});
+  add_file({300, 310});
+  open_reader(1);
+
+  reader_->seek(205);
+  EXPECT_THAT(read_all_time_stamps(), ElementsAre(210, 300, 300, 310));
+  EXPECT_THAT(opened_files_, ElementsAre("bag_file3", "bag_file4"));
+}
+
+TEST_F(MergingReaderTest, skips_files_outside_time_window_of_filter) {
+  add_file({0, 10});
+  add_file({100, 110});
+  add_file({200, 210});
+  add_file({300, 310});
+  open_reader(1);
+
+  rosbag2_storage::StorageFilter filter;
+  filter.start_time_ns = 105;
+  filter.end_time_ns = 205;
+  reader_->set_filter(filter);
+  // The fake readers do not filter messages by time themselves
+  EXPECT_THAT(read_all_time_stamps(), ElementsAre(100, 100, 110, 200, 200, 210));
+  EXPECT_THAT(opened_files_, ElementsAre("bag_file2", "bag_file3"));
+}
+
+TEST_F(MergingReaderTest, reads_overlapping_files_in_reverse_order) {
+  add_file({0, 30, 60});
+  add_file({10, 40, 70});
+  open_reader(1);
+
+  ASSERT_TRUE(reader_->set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::SortBy::ReceivedTimestamp, true)));
+  EXPECT_THAT(read_all_time_stamps(), ElementsAre(70, 60, 40, 30, 10, 10, 0, 0));
+}
+
+TEST_F(MergingReaderTest, set_filter_continues_after_the_last_message_read) {
+  add_file({0, 30, 60});
+  add_file({0, 40, 70});
+  open_reader(2);
+
+  ASSERT_TRUE(reader_->has_next());
+  EXPECT_EQ(reader_->read_next()->topic_name, "a");
+  EXPECT_EQ(reader_->read_next()->topic_name, "b");
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"b"};
+  reader_->set_filter(filter);
+  EXPECT_THAT(read_all(), ElementsAre(Pair("b", 0)));
+
+  reader_->seek(0);
+  reader_->reset_filter();
+  EXPECT_EQ(read_all().size(), 8u);
+}
+
+TEST_F(MergingReaderTest, throws_if_not_open) {
+  add_file({0});
+  rosbag2_cpp::readers::MergingReader reader;
+  EXPECT_THROW(reader.has_next(), std::runtime_error);
+  EXPECT_THROW(reader.seek(0), std::runtime_error);
+  EXPECT_THROW(reader.set_filter({}), std::runtime_error);
+}
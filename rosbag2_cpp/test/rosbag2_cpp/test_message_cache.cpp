@@ -14,15 +14,19 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <chrono>
 #include <numeric>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include <thread>
 
+#include "rosbag2_cpp/cache/message_memory.hpp"
+
 #include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
@@ -45,6 +49,16 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg()
   return message;
 }
 
+size_t batch_bytes(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs)
+{
+  size_t bytes = 0;
+  for (const auto & msg : msgs) {
+    bytes += msg->serialized_data->buffer_length;
+  }
+  return bytes;
+}
+
 uint32_t sum_up(const std::unordered_map<std::string, uint32_t> & map)
 {
   return std::accumulate(
@@ -79,12 +93,13 @@ TEST_F(MessageCacheTest, message_cache_writes_full_producer_buffer) {
 
   for (uint32_t i = 0; i < message_count; ++i) {
     auto msg = make_test_msg();
-    size_t serialized_data_size = msg->serialized_data->buffer_length;
+    size_t message_memory_size = rosbag2_cpp::cache::get_message_memory_bytes(*msg);
     mock_message_cache->push(msg);
-    if (cache_size_ < size_bytes_so_far) {
+    if (cache_size_ <= size_bytes_so_far) {
       should_be_dropped_count++;
+    } else {
+      size_bytes_so_far += message_memory_size;
     }
-    size_bytes_so_far += serialized_data_size;
   }
 
   auto total_actually_dropped = sum_up(mock_message_cache->messages_dropped());
@@ -105,3 +120,369 @@ TEST_F(MessageCacheTest, message_cache_writes_full_producer_buffer) {
   mock_cache_consumer->stop();
   EXPECT_EQ(consumed_message_count, message_count - should_be_dropped_count);
 }
+
+TEST_F(MessageCacheTest, accounts_capacity_and_overhead_of_messages) {
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(cache_size_);
+
+  // Only a small part of the allocated buffer is used, as by a growing serialized message
+  auto msg = make_test_msg();
+  msg->serialized_data = rosbag2_storage::make_empty_serialized_message(cache_size_ * 2 / 5);
+  msg->serialized_data->buffer_length = 1;
+  const size_t msg_bytes = rosbag2_cpp::cache::get_message_memory_bytes(*msg);
+  ASSERT_GT(msg_bytes, cache_size_ * 2 / 5);
+  ASSERT_LT(msg_bytes, cache_size_);
+
+  mock_message_cache->push(msg);
+  EXPECT_EQ(mock_message_cache->get_memory_bytes(), msg_bytes);
+  mock_message_cache->push(msg);
+  EXPECT_EQ(mock_message_cache->get_memory_bytes(), 2 * msg_bytes);
+  // The budget is exhausted by the capacities, even though only two bytes are used
+  mock_message_cache->push(msg);
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 1u);
+
+  mock_message_cache->swap_buffers();
+  auto small_msg = make_test_msg();
+  mock_message_cache->push(small_msg);
+  const size_t small_msg_bytes = rosbag2_cpp::cache::get_message_memory_bytes(*small_msg);
+  EXPECT_EQ(mock_message_cache->get_memory_bytes(), 2 * msg_bytes + small_msg_bytes);
+
+  auto consumer_buffer = mock_message_cache->get_consumer_buffer();
+  EXPECT_EQ(consumer_buffer->get_bytes_size(), 2 * msg_bytes);
+  consumer_buffer->clear();
+  mock_message_cache->release_consumer_buffer();
+
+  EXPECT_EQ(mock_message_cache->get_memory_bytes(), small_msg_bytes);
+  EXPECT_EQ(mock_message_cache->get_peak_memory_bytes(), 2 * msg_bytes + small_msg_bytes);
+}
+
+TEST_F(MessageCacheTest, drop_oldest_policy_keeps_latest_messages) {
+  const uint32_t message_count = 300;
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(
+    cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::DROP_OLDEST);
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> last_msg;
+  for (uint32_t i = 0; i < message_count; ++i) {
+    last_msg = make_test_msg();
+    mock_message_cache->push(last_msg);
+  }
+  auto total_dropped = sum_up(mock_message_cache->messages_dropped());
+  EXPECT_GT(total_dropped, 0u);
+
+  mock_message_cache->swap_buffers();
+  auto consumer_buffer = mock_message_cache->get_consumer_buffer();
+  const auto & data = consumer_buffer->data();
+  EXPECT_EQ(data.size() + total_dropped, message_count);
+  ASSERT_FALSE(data.empty());
+  EXPECT_EQ(data.back(), last_msg);
+  consumer_buffer->clear();
+  mock_message_cache->release_consumer_buffer();
+}
+
+TEST_F(MessageCacheTest, block_policy_drops_message_after_timeout) {
+  using namespace std::chrono_literals;
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(
+    cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::BLOCK, 10ms);
+
+  // Fill the producer buffer, no consumer is running to free it
+  uint64_t size_bytes_so_far = 0;
+  while (size_bytes_so_far < cache_size_) {
+    auto msg = make_test_msg();
+    size_bytes_so_far += rosbag2_cpp::cache::get_message_memory_bytes(*msg);
+    mock_message_cache->push(msg);
+  }
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 0u);
+  EXPECT_EQ(mock_message_cache->get_blocked_push_count(), 0u);
+
+  mock_message_cache->push(make_test_msg());
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 1u);
+  EXPECT_EQ(mock_message_cache->get_blocked_push_count(), 1u);
+  EXPECT_GE(mock_message_cache->get_time_blocked(), 10ms);
+}
+
+TEST_F(MessageCacheTest, block_policy_does_not_lose_messages) {
+  const uint32_t message_count = 10000;
+  size_t consumed_message_count {0};
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(
+    cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::BLOCK);
+
+  auto cb = [&consumed_message_count](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_message_count += msgs.size();
+    };
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache,
+    cb);
+
+  for (uint32_t i = 0; i < message_count; ++i) {
+    mock_message_cache->push(make_test_msg());
+  }
+  mock_cache_consumer->stop();
+
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 0u);
+  EXPECT_EQ(consumed_message_count, message_count);
+}
+
+TEST_F(MessageCacheTest, spill_to_disk_policy_keeps_all_messages_in_order) {
+  using namespace std::chrono_literals;
+  const uint32_t message_count = 2000;
+  std::vector<rcutils_time_point_value_t> consumed_time_stamps;
+
+  auto spill_file = std::make_shared<rosbag2_cpp::cache::SpillFile>("", 1024 * 1024);
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(
+    cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::SPILL_TO_DISK, 0ms, spill_file);
+
+  // A slow consumer makes the producer buffer overflow
+  auto cb = [&consumed_time_stamps](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      for (const auto & msg : msgs) {
+        consumed_time_stamps.push_back(msg->time_stamp);
+      }
+      std::this_thread::sleep_for(1ms);
+    };
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache,
+    cb);
+
+  for (uint32_t i = 0; i < message_count; ++i) {
+    auto msg = make_test_msg();
+    msg->time_stamp = i;
+    mock_message_cache->push(msg);
+  }
+  mock_cache_consumer->stop();
+
+  EXPECT_GT(mock_message_cache->get_spilled_message_count(), 0u);
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 0u);
+  ASSERT_EQ(consumed_time_stamps.size(), message_count);
+  for (uint32_t i = 0; i < message_count; ++i) {
+    ASSERT_EQ(consumed_time_stamps[i], static_cast<rcutils_time_point_value_t>(i));
+  }
+  EXPECT_TRUE(spill_file->empty());
+}
+
+TEST_F(MessageCacheTest, spill_to_disk_policy_requires_spill_file) {
+  EXPECT_THROW(
+    rosbag2_cpp::cache::MessageCache(
+      cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::SPILL_TO_DISK),
+    std::invalid_argument);
+}
+
+TEST_F(MessageCacheTest, topic_priorities_drop_low_priority_messages_first) {
+  using namespace std::chrono_literals;
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(
+    cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::DROP_NEWEST, 0ms, nullptr,
+    std::unordered_map<std::string, uint32_t>{{"/control", 10}});
+
+  // Fill the producer buffer with messages of the default priority
+  uint64_t size_bytes_so_far = 0;
+  uint32_t pushed_count = 0;
+  while (size_bytes_so_far < cache_size_) {
+    auto msg = make_test_msg();
+    msg->topic_name = "/debug";
+    size_bytes_so_far += rosbag2_cpp::cache::get_message_memory_bytes(*msg);
+    mock_message_cache->push(msg);
+    ++pushed_count;
+  }
+  EXPECT_EQ(sum_up(mock_message_cache->messages_dropped()), 0u);
+
+  // Messages of higher priority evict them, messages of the same priority are dropped
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> control_msgs;
+  for (int i = 0; i < 3; ++i) {
+    auto msg = make_test_msg();
+    msg->topic_name = "/control";
+    control_msgs.push_back(msg);
+    mock_message_cache->push(msg);
+  }
+  auto debug_msg = make_test_msg();
+  debug_msg->topic_name = "/debug";
+  mock_message_cache->push(debug_msg);
+  pushed_count += 4;
+
+  const auto dropped = mock_message_cache->messages_dropped();
+  EXPECT_EQ(dropped.count("/control"), 0u);
+  EXPECT_GE(dropped.at("/debug"), 4u);
+  EXPECT_THAT(
+    mock_message_cache->get_dropped_message_counts_per_priority(),
+    ElementsAre(Pair(0u, dropped.at("/debug")), Pair(10u, 0u)));
+
+  mock_message_cache->swap_buffers();
+  auto consumer_buffer = mock_message_cache->get_consumer_buffer();
+  const auto & data = consumer_buffer->data();
+  // Messages are handed to the consumer in the order they were pushed
+  ASSERT_GE(data.size(), control_msgs.size());
+  EXPECT_THAT(
+    std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>(
+      data.end() - control_msgs.size(), data.end()),
+    ElementsAreArray(control_msgs));
+  EXPECT_EQ(data.size() + dropped.at("/debug"), pushed_count);
+  consumer_buffer->clear();
+  mock_message_cache->release_consumer_buffer();
+}
+
+TEST_F(MessageCacheTest, topic_priorities_require_drop_newest_policy) {
+  EXPECT_THROW(
+    rosbag2_cpp::cache::MessageCache(
+      cache_size_, rosbag2_cpp::cache::CacheOverflowPolicy::DROP_OLDEST,
+      std::chrono::milliseconds(0), nullptr, {{"/control", 10}}),
+    std::invalid_argument);
+}
+
+TEST_F(MessageCacheTest, consumer_batches_messages_up_to_min_batch_size) {
+  using namespace std::chrono_literals;
+  const uint32_t message_count = 1000;
+  const size_t min_batch_bytes = 500;
+  std::vector<size_t> consumed_batch_bytes;
+  size_t consumed_message_count {0};
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(1024 * 1024);
+  auto cb = [&](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_batch_bytes.push_back(batch_bytes(msgs));
+      consumed_message_count += msgs.size();
+    };
+  rosbag2_cpp::cache::WriteBatchingOptions batching_options;
+  batching_options.min_batch_bytes = min_batch_bytes;
+  batching_options.max_batch_latency = 1h;
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache, cb, batching_options);
+
+  for (uint32_t i = 0; i < message_count; ++i) {
+    mock_message_cache->push(make_test_msg());
+  }
+  mock_cache_consumer->stop();
+
+  EXPECT_EQ(consumed_message_count, message_count);
+  ASSERT_FALSE(consumed_batch_bytes.empty());
+  // Only the batch written on flush may be smaller
+  for (size_t i = 0; i + 1 < consumed_batch_bytes.size(); ++i) {
+    EXPECT_GE(consumed_batch_bytes[i], min_batch_bytes);
+  }
+}
+
+TEST_F(MessageCacheTest, consumer_splits_batches_larger_than_max_batch_size) {
+  using namespace std::chrono_literals;
+  const uint32_t message_count = 1000;
+  const size_t max_batch_bytes = 64;
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> consumed;
+  std::vector<size_t> consumed_batch_bytes;
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(1024 * 1024);
+  auto cb = [&](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_batch_bytes.push_back(batch_bytes(msgs));
+      consumed.insert(consumed.end(), msgs.begin(), msgs.end());
+    };
+  rosbag2_cpp::cache::WriteBatchingOptions batching_options;
+  batching_options.min_batch_bytes = 1024;
+  batching_options.max_batch_bytes = max_batch_bytes;
+  batching_options.max_batch_latency = 1h;
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache, cb, batching_options);
+
+  for (uint32_t i = 0; i < message_count; ++i) {
+    auto msg = make_test_msg();
+    msg->time_stamp = i;
+    mock_message_cache->push(msg);
+  }
+  mock_cache_consumer->stop();
+
+  ASSERT_EQ(consumed.size(), message_count);
+  for (uint32_t i = 0; i < message_count; ++i) {
+    ASSERT_EQ(consumed[i]->time_stamp, static_cast<rcutils_time_point_value_t>(i));
+  }
+  for (const auto bytes : consumed_batch_bytes) {
+    EXPECT_LE(bytes, max_batch_bytes);
+  }
+}
+
+TEST_F(MessageCacheTest, consumer_writes_incomplete_batch_after_max_latency) {
+  using namespace std::chrono_literals;
+  std::atomic<size_t> consumed_message_count {0};
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(1024 * 1024);
+  auto cb = [&consumed_message_count](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_message_count += msgs.size();
+    };
+  rosbag2_cpp::cache::WriteBatchingOptions batching_options;
+  batching_options.min_batch_bytes = 1024 * 1024;
+  batching_options.max_batch_latency = 10ms;
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache, cb, batching_options);
+
+  mock_message_cache->push(make_test_msg());
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (consumed_message_count == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(consumed_message_count, 1u);
+  mock_cache_consumer->stop();
+}
+
+TEST_F(MessageCacheTest, consumer_calls_periodic_callback_while_no_messages_arrive) {
+  using namespace std::chrono_literals;
+  std::atomic<size_t> periodic_call_count {0};
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(1024 * 1024);
+  rosbag2_cpp::cache::CacheConsumer::consume_callback_function_t cb = [](const auto &) {};
+  auto cache_consumer = std::make_unique<rosbag2_cpp::cache::CacheConsumer>(
+    mock_message_cache, cb, rosbag2_cpp::cache::WriteBatchingOptions{},
+    rosbag2_cpp::ThreadScheduling{}, [&periodic_call_count]() {++periodic_call_count;}, 5ms);
+
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (periodic_call_count < 3 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_GE(periodic_call_count, 3u);
+  cache_consumer->stop();
+}
+
+TEST_F(MessageCacheTest, adaptive_batching_follows_consume_throughput) {
+  using namespace std::chrono_literals;
+  const uint32_t message_count = 200;
+  const size_t min_batch_bytes = 8;
+  const size_t max_batch_bytes = 100 * 1000;
+  size_t consumed_message_count {0};
+
+  auto mock_message_cache = std::make_shared<NiceMock<MockMessageCache>>(1024 * 1024);
+  // Consuming takes at least 1ms per batch
+  auto cb = [&consumed_message_count](
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      consumed_message_count += msgs.size();
+      std::this_thread::sleep_for(1ms);
+    };
+  rosbag2_cpp::cache::WriteBatchingOptions batching_options;
+  batching_options.min_batch_bytes = min_batch_bytes;
+  batching_options.max_batch_bytes = max_batch_bytes;
+  batching_options.max_batch_latency = 100ms;
+  batching_options.adaptive = true;
+  auto mock_cache_consumer = std::make_unique<NiceMock<MockCacheConsumer>>(
+    mock_message_cache, cb, batching_options);
+  EXPECT_EQ(mock_cache_consumer->get_target_batch_bytes(), min_batch_bytes);
+
+  for (uint32_t i = 0; i < message_count; ++i) {
+    mock_message_cache->push(make_test_msg());
+    std::this_thread::sleep_for(100us);
+  }
+  mock_cache_consumer->stop();
+
+  EXPECT_EQ(consumed_message_count, message_count);
+  // Consuming is far faster than min_batch_bytes per half latency, the target has to grow
+  EXPECT_GT(mock_cache_consumer->get_target_batch_bytes(), min_batch_bytes);
+  EXPECT_LE(mock_cache_consumer->get_target_batch_bytes(), max_batch_bytes);
+}
+
+TEST(CacheOverflowPolicyTest, converts_from_and_to_string) {
+  using rosbag2_cpp::cache::CacheOverflowPolicy;
+  using rosbag2_cpp::cache::cache_overflow_policy_from_string;
+  using rosbag2_cpp::cache::cache_overflow_policy_to_string;
+
+  EXPECT_EQ(cache_overflow_policy_from_string(""), CacheOverflowPolicy::DROP_NEWEST);
+  EXPECT_EQ(cache_overflow_policy_from_string("DROP_OLDEST"), CacheOverflowPolicy::DROP_OLDEST);
+  for (auto policy : {CacheOverflowPolicy::DROP_NEWEST, CacheOverflowPolicy::DROP_OLDEST,
+      CacheOverflowPolicy::BLOCK, CacheOverflowPolicy::SPILL_TO_DISK})
+  {
+    EXPECT_EQ(cache_overflow_policy_from_string(cache_overflow_policy_to_string(policy)), policy);
+  }
+  EXPECT_THROW(cache_overflow_policy_from_string("drop_random"), std::invalid_argument);
+}
@@ -0,0 +1,291 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/readers/multi_bag_reader.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+using Messages = std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>;
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, int32_t time_stamp)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(&time_stamp, 4);
+  return message;
+}
+
+// Reader of the messages of one bag in memory
+class FakeBagReader : public rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  FakeBagReader(Messages messages, const std::string & topic_type)
+  : messages_(std::move(messages))
+  {
+    for (const auto & message : messages_) {
+      auto topic = std::find_if(
+        topics_.begin(), topics_.end(),
+        [&message](const rosbag2_storage::TopicMetadata & topic) {
+          return topic.name == message->topic_name;
+        });
+      if (topic == topics_.end()) {
+        topics_.push_back({message->topic_name, topic_type, "cdr", {}, ""});
+        metadata_.topics_with_message_count.push_back({topics_.back(), 0});
+      }
+      auto & topic_information = *std::find_if(
+        metadata_.topics_with_message_count.begin(), metadata_.topics_with_message_count.end(),
+        [&message](const rosbag2_storage::TopicInformation & topic_information) {
+          return topic_information.topic_metadata.name == message->topic_name;
+        });
+      ++topic_information.message_count;
+    }
+    metadata_.message_count = messages_.size();
+    if (!messages_.empty()) {
+      metadata_.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+        std::chrono::nanoseconds(messages_.front()->time_stamp));
+      metadata_.duration = std::chrono::nanoseconds(
+        messages_.back()->time_stamp - messages_.front()->time_stamp);
+    }
+  }
+
+  void open(
+    const rosbag2_storage::StorageOptions &,
+    const rosbag2_cpp::ConverterOptions &) override
+  {
+    position_ = 0;
+  }
+
+  void close() override {}
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override
+  {
+    reverse_ = order.reverse;
+    return true;
+  }
+
+  bool has_next() override
+  {
+    while (position_ < messages_.size() && !filter_.topics.empty() &&
+      std::find(
+        filter_.topics.begin(), filter_.topics.end(),
+        message_at(position_)->topic_name) == filter_.topics.end())
+    {
+      ++position_;
+    }
+    return position_ < messages_.size();
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override
+  {
+    if (!has_next()) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    return message_at(position_++);
+  }
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override
+  {
+    return metadata_;
+  }
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override
+  {
+    return topics_;
+  }
+
+  void get_all_message_definitions(std::vector<rosbag2_storage::MessageDefinition> &) override {}
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override
+  {
+    filter_ = storage_filter;
+  }
+
+  void reset_filter() override
+  {
+    filter_ = rosbag2_storage::StorageFilter();
+  }
+
+  void seek(const rcutils_time_point_value_t & timestamp) override
+  {
+    position_ = 0;
+    while (position_ < messages_.size() &&
+      (reverse_ ? message_at(position_)->time_stamp > timestamp :
+      message_at(position_)->time_stamp < timestamp))
+    {
+      ++position_;
+    }
+  }
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::ReaderEventCallbacks &) override {}
+
+private:
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> message_at(size_t position) const
+  {
+    return messages_[reverse_ ? messages_.size() - 1 - position : position];
+  }
+
+  Messages messages_;
+  std::vector<rosbag2_storage::TopicMetadata> topics_;
+  rosbag2_storage::BagMetadata metadata_;
+  rosbag2_storage::StorageFilter filter_;
+  size_t position_ = 0;
+  bool reverse_ = false;
+};
+}  // namespace
+
+class MultiBagReaderTest : public Test
+{
+public:
+  void add_bag(const Messages & messages, const std::string & topic_type = "test_msgs/msg/Type")
+  {
+    rosbag2_cpp::readers::MultiBagReader::Bag bag;
+    bag.storage_options.uri = "bag" + std::to_string(bags_.size() + 1);
+    bag.reader = std::make_unique<FakeBagReader>(messages, topic_type);
+    bags_.push_back(std::move(bag));
+  }
+
+  void open_reader()
+  {
+    reader_ = std::make_unique<rosbag2_cpp::readers::MultiBagReader>(std::move(bags_));
+    reader_->open({}, {"", ""});
+  }
+
+  std::vector<std::pair<std::string, int64_t>> read_all()
+  {
+    std::vector<std::pair<std::string, int64_t>> messages;
+    while (reader_->has_next()) {
+      auto message = reader_->read_next();
+      messages.emplace_back(message->topic_name, message->time_stamp);
+    }
+    return messages;
+  }
+
+  std::vector<rosbag2_cpp::readers::MultiBagReader::Bag> bags_;
+  std::unique_ptr<rosbag2_cpp::readers::MultiBagReader> reader_;
+};
+
+TEST_F(MultiBagReaderTest, merges_messages_of_all_bags_by_time)
+{
+  add_bag({make_message("sensor", 10), make_message("sensor", 20), make_message("sensor", 40)});
+  add_bag({make_message("truth", 5), make_message("truth", 20), make_message("truth", 30)});
+  open_reader();
+
+  EXPECT_THAT(
+    read_all(), ElementsAre(
+      Pair("truth", 5), Pair("sensor", 10), Pair("sensor", 20), Pair("truth", 20),
+      Pair("truth", 30), Pair("sensor", 40)));
+  EXPECT_THROW(reader_->read_next(), std::runtime_error);
+}
+
+TEST_F(MultiBagReaderTest, merges_metadata_and_topics_of_all_bags)
+{
+  add_bag({make_message("sensor", 10), make_message("shared", 40)});
+  add_bag({make_message("shared", 5), make_message("truth", 20)});
+  open_reader();
+
+  const auto & metadata = reader_->get_metadata();
+  EXPECT_EQ(metadata.starting_time.time_since_epoch().count(), 5);
+  EXPECT_EQ(metadata.duration.count(), 35);
+  EXPECT_EQ(metadata.message_count, 4u);
+  ASSERT_EQ(metadata.topics_with_message_count.size(), 3u);
+  EXPECT_EQ(metadata.topics_with_message_count[1].topic_metadata.name, "shared");
+  EXPECT_EQ(metadata.topics_with_message_count[1].message_count, 2u);
+
+  std::vector<std::string> topic_names;
+  for (const auto & topic : reader_->get_all_topics_and_types()) {
+    topic_names.push_back(topic.name);
+  }
+  EXPECT_THAT(topic_names, ElementsAre("sensor", "shared", "truth"));
+}
+
+TEST_F(MultiBagReaderTest, open_throws_on_topic_type_mismatch)
+{
+  add_bag({make_message("shared", 10)}, "test_msgs/msg/Type");
+  add_bag({make_message("shared", 20)}, "test_msgs/msg/OtherType");
+  EXPECT_THROW(open_reader(), std::runtime_error);
+}
+
+TEST_F(MultiBagReaderTest, seek_applies_to_all_bags)
+{
+  add_bag({make_message("sensor", 10), make_message("sensor", 20), make_message("sensor", 40)});
+  add_bag({make_message("truth", 5), make_message("truth", 20), make_message("truth", 30)});
+  open_reader();
+  read_all();
+
+  reader_->seek(20);
+  EXPECT_THAT(
+    read_all(), ElementsAre(
+      Pair("sensor", 20), Pair("truth", 20), Pair("truth", 30), Pair("sensor", 40)));
+}
+
+TEST_F(MultiBagReaderTest, set_filter_continues_at_read_head_of_all_bags)
+{
+  add_bag({make_message("sensor", 10), make_message("sensor", 20), make_message("sensor", 40)});
+  add_bag({make_message("truth", 5), make_message("truth", 20), make_message("truth", 30)});
+  open_reader();
+  ASSERT_EQ(reader_->read_next()->time_stamp, 5);
+  ASSERT_EQ(reader_->read_next()->time_stamp, 10);
+  ASSERT_EQ(reader_->read_next()->topic_name, "sensor");
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"truth"};
+  reader_->set_filter(filter);
+  EXPECT_THAT(read_all(), ElementsAre(Pair("truth", 20), Pair("truth", 30)));
+}
+
+TEST_F(MultiBagReaderTest, set_filter_before_reading_keeps_first_messages)
+{
+  add_bag({make_message("sensor", 10), make_message("sensor", 20)});
+  add_bag({make_message("truth", 5), make_message("truth", 30)});
+  open_reader();
+  ASSERT_TRUE(reader_->has_next());
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"sensor"};
+  reader_->set_filter(filter);
+  EXPECT_THAT(read_all(), ElementsAre(Pair("sensor", 10), Pair("sensor", 20)));
+}
+
+TEST_F(MultiBagReaderTest, reads_all_bags_in_reverse_order)
+{
+  add_bag({make_message("sensor", 10), make_message("sensor", 20)});
+  add_bag({make_message("truth", 5), make_message("truth", 30)});
+  open_reader();
+  ASSERT_EQ(reader_->read_next()->time_stamp, 5);
+
+  EXPECT_TRUE(reader_->set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+  EXPECT_THAT(read_all(), IsEmpty());
+
+  reader_->seek(30);
+  EXPECT_THAT(
+    read_all(), ElementsAre(
+      Pair("truth", 30), Pair("sensor", 20), Pair("sensor", 10), Pair("truth", 5)));
+}
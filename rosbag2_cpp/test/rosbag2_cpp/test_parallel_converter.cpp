@@ -0,0 +1,126 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/parallel_converter.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "mock_converter.hpp"
+#include "mock_converter_factory.hpp"
+
+using namespace testing;  // NOLINT
+
+class ParallelConverterTest : public Test
+{
+public:
+  static constexpr size_t kNumberOfThreads = 4;
+
+  ParallelConverterTest()
+  : converter_factory_(std::make_shared<StrictMock<MockConverterFactory>>())
+  {
+    EXPECT_CALL(*converter_factory_, load_deserializer("input_format"))
+    .Times(kNumberOfThreads).WillRepeatedly(
+      [](const std::string &) {
+        auto converter = std::make_unique<NiceMock<MockConverter>>();
+        ON_CALL(*converter, deserialize(_, _, _)).WillByDefault(
+          [](
+            std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message,
+            const rosidl_message_type_support_t *,
+            std::shared_ptr<rosbag2_cpp::rosbag2_introspection_message_t>) {
+            if (message->time_stamp == kFailingTimeStamp) {
+              throw std::runtime_error("Failed to deserialize");
+            }
+          });
+        return converter;
+      });
+    EXPECT_CALL(*converter_factory_, load_serializer("output_format"))
+    .Times(kNumberOfThreads).WillRepeatedly(
+      [](const std::string &) {
+        auto converter = std::make_unique<NiceMock<MockConverter>>();
+        ON_CALL(*converter, serialize(_, _, _)).WillByDefault(
+          [](
+            std::shared_ptr<const rosbag2_cpp::rosbag2_introspection_message_t>,
+            const rosidl_message_type_support_t *,
+            std::shared_ptr<rosbag2_storage::SerializedBagMessage> serialized_message) {
+            serialized_message->serialized_data =
+            rosbag2_storage::make_serialized_message("Hello", 5);
+          });
+        return converter;
+      });
+  }
+
+  std::unique_ptr<rosbag2_cpp::ParallelConverter> make_converter()
+  {
+    auto converter = std::make_unique<rosbag2_cpp::ParallelConverter>(
+      rosbag2_cpp::ConverterOptions{"input_format", "output_format"}, converter_factory_,
+      kNumberOfThreads);
+    converter->add_topic("test_topic", "test_msgs/BasicTypes");
+    return converter;
+  }
+
+  static std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>
+  make_messages(size_t number_of_messages)
+  {
+    std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+    for (size_t i = 0; i < number_of_messages; ++i) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "test_topic";
+      message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      message->serialized_data = rosbag2_storage::make_serialized_message("Hi", 2);
+      messages.push_back(message);
+    }
+    return messages;
+  }
+
+  static constexpr rcutils_time_point_value_t kFailingTimeStamp = 1000;
+
+  std::shared_ptr<StrictMock<MockConverterFactory>> converter_factory_;
+};
+
+TEST_F(ParallelConverterTest, converts_messages_of_a_batch_in_order) {
+  auto converter = make_converter();
+  EXPECT_EQ(converter->get_number_of_threads(), kNumberOfThreads);
+
+  for (size_t batch = 0; batch < 3; ++batch) {
+    const auto converted = converter->convert(make_messages(100));
+    ASSERT_THAT(converted, SizeIs(100));
+    for (size_t i = 0; i < converted.size(); ++i) {
+      EXPECT_EQ(converted[i]->time_stamp, static_cast<rcutils_time_point_value_t>(i));
+      EXPECT_EQ(converted[i]->serialized_data->buffer_length, 5u);
+    }
+  }
+}
+
+TEST_F(ParallelConverterTest, converts_empty_batch) {
+  auto converter = make_converter();
+  EXPECT_THAT(converter->convert({}), IsEmpty());
+}
+
+TEST_F(ParallelConverterTest, rethrows_error_of_a_message_and_converts_next_batch) {
+  auto converter = make_converter();
+  auto messages = make_messages(10);
+  auto failing_message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*messages[5]);
+  failing_message->time_stamp = kFailingTimeStamp;
+  messages[5] = failing_message;
+
+  EXPECT_THROW(converter->convert(messages), std::runtime_error);
+  EXPECT_THAT(converter->convert(make_messages(10)), SizeIs(10));
+}
@@ -0,0 +1,153 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "rosbag2_cpp/payload_deduplication.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::PayloadDeduplicator;
+using rosbag2_cpp::PayloadReference;
+using rosbag2_cpp::PayloadResolver;
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic, rcutils_time_point_value_t time_stamp, const std::string & data)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+
+std::string payload_of(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+}  // namespace
+
+TEST(PayloadDeduplicationTest, hash_depends_on_every_byte_and_the_size) {
+  const std::string data(100, 'x');
+  const auto * bytes = reinterpret_cast<const uint8_t *>(data.data());
+  const uint64_t hash = rosbag2_cpp::hash_payload(bytes, data.size());
+  EXPECT_EQ(hash, rosbag2_cpp::hash_payload(bytes, data.size()));
+  EXPECT_NE(hash, rosbag2_cpp::hash_payload(bytes, data.size() - 1));
+  for (size_t position : {0u, 31u, 64u, 99u}) {
+    auto changed = data;
+    changed[position] = 'y';
+    EXPECT_NE(
+      hash, rosbag2_cpp::hash_payload(
+        reinterpret_cast<const uint8_t *>(changed.data()), changed.size()));
+  }
+}
+
+TEST(PayloadDeduplicationTest, reference_payload_round_trip) {
+  const auto payload = rosbag2_cpp::make_reference_payload({0x0123456789abcdefULL, -5, 4096});
+  ASSERT_EQ(payload->buffer_length, rosbag2_cpp::kPayloadReferenceSize);
+  const auto reference = rosbag2_cpp::parse_reference_payload(*payload);
+  ASSERT_TRUE(reference.has_value());
+  EXPECT_EQ(reference->hash, 0x0123456789abcdefULL);
+  EXPECT_EQ(reference->time_stamp, -5);
+  EXPECT_EQ(reference->size, 4096u);
+
+  const auto message = make_message("topic", 0, std::string(32, 'r'));
+  EXPECT_FALSE(rosbag2_cpp::parse_reference_payload(*message->serialized_data).has_value());
+}
+
+TEST(PayloadDeduplicationTest, repeats_of_large_payloads_of_a_topic_become_references) {
+  PayloadDeduplicator deduplicator(64, 1024);
+  const std::string map(100, 'm');
+
+  auto first = make_message("/map", 1, map);
+  EXPECT_EQ(deduplicator.deduplicate(first), first);
+  const auto repeat = deduplicator.deduplicate(make_message("/map", 2, map));
+  EXPECT_EQ(repeat->time_stamp, 2);
+  const auto reference = rosbag2_cpp::parse_reference_payload(*repeat->serialized_data);
+  ASSERT_TRUE(reference.has_value());
+  EXPECT_EQ(reference->time_stamp, 1);
+  EXPECT_EQ(reference->size, map.size());
+
+  // Other topics, other payloads and small payloads are stored as they are
+  auto other_topic = make_message("/other", 3, map);
+  EXPECT_EQ(deduplicator.deduplicate(other_topic), other_topic);
+  auto other_payload = make_message("/map", 4, std::string(100, 'n'));
+  EXPECT_EQ(deduplicator.deduplicate(other_payload), other_payload);
+  auto small = make_message("/map", 5, "small");
+  EXPECT_EQ(deduplicator.deduplicate(small), small);
+  EXPECT_EQ(deduplicator.deduplicate(small), small);
+  EXPECT_EQ(deduplicator.get_deduplicated_count(), 1u);
+
+  deduplicator.reset();
+  auto after_reset = make_message("/map", 6, map);
+  EXPECT_EQ(deduplicator.deduplicate(after_reset), after_reset);
+}
+
+TEST(PayloadDeduplicationTest, oldest_payloads_are_forgotten_beyond_the_budget) {
+  PayloadDeduplicator deduplicator(64, 250);
+  for (char c : {'a', 'b', 'c'}) {
+    deduplicator.deduplicate(make_message("/map", 1, std::string(100, c)));
+  }
+  auto forgotten = make_message("/map", 2, std::string(100, 'a'));
+  EXPECT_EQ(deduplicator.deduplicate(forgotten), forgotten);
+  const auto remembered = deduplicator.deduplicate(make_message("/map", 3, std::string(100, 'c')));
+  EXPECT_TRUE(rosbag2_cpp::parse_reference_payload(*remembered->serialized_data).has_value());
+  EXPECT_EQ(deduplicator.get_deduplicated_count(), 1u);
+}
+
+TEST(PayloadDeduplicationTest, resolver_looks_up_payloads_once_while_they_are_cached) {
+  PayloadDeduplicator deduplicator(64, 1024);
+  const std::string map(100, 'm');
+  auto original = make_message("/map", 1, map);
+  deduplicator.deduplicate(original);
+  auto repeat = std::make_shared<rosbag2_storage::SerializedBagMessage>(
+    *deduplicator.deduplicate(make_message("/map", 2, map)));
+
+  size_t look_ups = 0;
+  const auto look_up = [&](const std::string & topic, const PayloadReference & reference) {
+      ++look_ups;
+      EXPECT_EQ(topic, "/map");
+      EXPECT_EQ(reference.time_stamp, 1);
+      return original->serialized_data;
+    };
+  PayloadResolver resolver(1024);
+  auto not_a_reference = make_message("/map", 3, map);
+  EXPECT_FALSE(resolver.resolve(*not_a_reference, look_up));
+
+  auto second_repeat = std::make_shared<rosbag2_storage::SerializedBagMessage>(*repeat);
+  EXPECT_TRUE(resolver.resolve(*repeat, look_up));
+  EXPECT_TRUE(resolver.resolve(*second_repeat, look_up));
+  EXPECT_EQ(look_ups, 1u);
+  EXPECT_EQ(payload_of(*repeat), map);
+  EXPECT_EQ(payload_of(*second_repeat), map);
+}
+
+TEST(PayloadDeduplicationTest, resolver_throws_if_payload_is_not_found) {
+  PayloadResolver resolver(1024);
+  auto message = make_message("/map", 2, "");
+  message->serialized_data = rosbag2_cpp::make_reference_payload({1, 1, 100});
+  EXPECT_THROW(
+    resolver.resolve(
+      *message, [](const std::string &, const PayloadReference &) {return nullptr;}),
+    std::runtime_error);
+}
@@ -0,0 +1,190 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/payload_delta_encoding.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::PayloadDeltaDecoder;
+using rosbag2_cpp::PayloadDeltaEncoder;
+using rosbag2_cpp::PayloadReference;
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic, rcutils_time_point_value_t time_stamp, const std::string & data)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+
+std::string payload_of(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+
+// Occupancy grid of which a few cells change
+std::string make_grid(size_t changed_cell)
+{
+  std::string grid(1000, '\0');
+  for (size_t cell = 0; cell < grid.size(); cell += 7) {
+    grid[cell] = static_cast<char>(cell % 100);
+  }
+  grid[changed_cell] = 'c';
+  grid[changed_cell + 2] = 'c';
+  return grid;
+}
+}  // namespace
+
+TEST(PayloadDeltaEncodingTest, delta_payload_round_trip) {
+  const auto keyframe = make_message("map", 1, make_grid(10));
+  const auto payload = make_message("map", 2, make_grid(500));
+  const PayloadReference reference{42, 1, 1000};
+
+  const auto delta = rosbag2_cpp::make_delta_payload(
+    reference, *keyframe->serialized_data, *payload->serialized_data);
+  ASSERT_NE(delta, nullptr);
+  EXPECT_LT(delta->buffer_length, 64u);
+  const auto parsed = rosbag2_cpp::parse_delta_payload(*delta);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->hash, 42u);
+  EXPECT_EQ(parsed->time_stamp, 1);
+  EXPECT_EQ(parsed->size, 1000u);
+  EXPECT_FALSE(rosbag2_cpp::parse_delta_payload(*payload->serialized_data).has_value());
+
+  const auto reconstructed = rosbag2_cpp::apply_delta_payload(*delta, *keyframe->serialized_data);
+  EXPECT_EQ(
+    std::string(
+      reinterpret_cast<const char *>(reconstructed->buffer), reconstructed->buffer_length),
+    payload_of(*payload));
+}
+
+TEST(PayloadDeltaEncodingTest, no_delta_unless_it_is_smaller_than_the_payload) {
+  const auto keyframe = make_message("map", 1, std::string(100, 'a'));
+  const auto different = make_message("map", 2, std::string(100, 'b'));
+  const auto resized = make_message("map", 2, std::string(101, 'a'));
+  const PayloadReference reference{42, 1, 100};
+
+  EXPECT_EQ(
+    rosbag2_cpp::make_delta_payload(
+      reference, *keyframe->serialized_data, *different->serialized_data), nullptr);
+  EXPECT_EQ(
+    rosbag2_cpp::make_delta_payload(
+      reference, *keyframe->serialized_data, *resized->serialized_data), nullptr);
+}
+
+TEST(PayloadDeltaEncodingTest, topics_are_joined_and_split) {
+  const std::vector<std::string> topics{"/map", "/global_costmap/costmap"};
+  const auto joined = rosbag2_cpp::join_delta_encoded_topics(topics);
+  EXPECT_EQ(joined, "/map,/global_costmap/costmap");
+  EXPECT_EQ(rosbag2_cpp::split_delta_encoded_topics(joined), topics);
+  EXPECT_THAT(rosbag2_cpp::split_delta_encoded_topics(""), IsEmpty());
+}
+
+TEST(PayloadDeltaEncodingTest, messages_between_keyframes_of_a_topic_become_deltas) {
+  PayloadDeltaEncoder encoder({"map"}, 3);
+
+  std::vector<bool> is_delta;
+  for (size_t i = 0; i < 7; ++i) {
+    auto message = make_message("map", static_cast<rcutils_time_point_value_t>(i), make_grid(i));
+    const auto encoded = encoder.encode(message);
+    is_delta.push_back(encoded != message);
+    if (encoded != message) {
+      EXPECT_TRUE(rosbag2_cpp::parse_delta_payload(*encoded->serialized_data).has_value());
+      EXPECT_EQ(encoded->time_stamp, message->time_stamp);
+      // The written message keeps its payload
+      EXPECT_EQ(payload_of(*message), make_grid(i));
+    }
+  }
+  EXPECT_THAT(is_delta, ElementsAre(false, true, true, false, true, true, false));
+  EXPECT_EQ(encoder.get_delta_count(), 4u);
+
+  auto other = make_message("scan", 7, make_grid(0));
+  EXPECT_EQ(encoder.encode(other), other);
+  auto resized = make_message("map", 8, std::string(20, 'r'));
+  EXPECT_EQ(encoder.encode(resized), resized);
+
+  // A new file starts with a keyframe
+  encoder.reset();
+  auto first_in_file = make_message("map", 9, std::string(20, 'r'));
+  EXPECT_EQ(encoder.encode(first_in_file), first_in_file);
+}
+
+TEST(PayloadDeltaEncodingTest, decoder_reconstructs_deltas_from_their_keyframes) {
+  PayloadDeltaEncoder encoder({"map"}, 4);
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> written;
+  for (size_t i = 0; i < 8; ++i) {
+    const auto encoded = encoder.encode(
+      make_message("map", static_cast<rcutils_time_point_value_t>(i), make_grid(i * 3)));
+    written.push_back(std::make_shared<rosbag2_storage::SerializedBagMessage>(*encoded));
+  }
+
+  size_t look_ups = 0;
+  const auto look_up =
+    [&written, &look_ups](const std::string & topic, const PayloadReference & reference) {
+      ++look_ups;
+      for (const auto & message : written) {
+        if (message->topic_name == topic && message->time_stamp == reference.time_stamp) {
+          return message->serialized_data;
+        }
+      }
+      return std::shared_ptr<rcutils_uint8_array_t>();
+    };
+
+  PayloadDeltaDecoder decoder({"map"});
+  for (size_t i = 0; i < written.size(); ++i) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*written[i]);
+    EXPECT_EQ(decoder.decode(*message, look_up), i % 4 != 0);
+    EXPECT_EQ(payload_of(*message), make_grid(i * 3));
+  }
+  // Keyframes read before their deltas are not looked up
+  EXPECT_EQ(look_ups, 0u);
+
+  // After a seek, the keyframe of the first delta is looked up once
+  PayloadDeltaDecoder seeking_decoder({"map"});
+  for (size_t i = 5; i < written.size(); ++i) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*written[i]);
+    EXPECT_TRUE(seeking_decoder.decode(*message, look_up));
+    EXPECT_EQ(payload_of(*message), make_grid(i * 3));
+  }
+  EXPECT_EQ(look_ups, 1u);
+}
+
+TEST(PayloadDeltaEncodingTest, decode_throws_if_the_keyframe_is_not_found) {
+  PayloadDeltaEncoder encoder({"map"}, 4);
+  encoder.encode(make_message("map", 0, make_grid(0)));
+  const auto delta = encoder.encode(make_message("map", 1, make_grid(1)));
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>(*delta);
+
+  PayloadDeltaDecoder decoder({"map"});
+  EXPECT_THROW(
+    decoder.decode(
+      *message, [](const std::string &, const PayloadReference &) {
+        return std::shared_ptr<rcutils_uint8_array_t>();
+      }),
+    std::runtime_error);
+}
@@ -0,0 +1,109 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_cpp/pipeline_statistics.hpp"
+
+using namespace testing;  // NOLINT
+using namespace std::chrono_literals;  // NOLINT
+
+using rosbag2_cpp::LatencyHistogram;
+using rosbag2_cpp::PipelineQueue;
+using rosbag2_cpp::PipelineStage;
+using rosbag2_cpp::PipelineStatistics;
+
+TEST(LatencyHistogramTest, buckets_contain_their_values) {
+  for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull}) {
+    const size_t index = LatencyHistogram::bucket_index(value);
+    EXPECT_GE(LatencyHistogram::bucket_upper_bound(index), value);
+    if (index > 0) {
+      EXPECT_LT(LatencyHistogram::bucket_upper_bound(index - 1), value);
+    }
+  }
+  EXPECT_EQ(
+    LatencyHistogram::bucket_index(UINT64_MAX), LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogramTest, percentiles_are_within_relative_precision) {
+  LatencyHistogram histogram;
+  for (int64_t i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::nanoseconds(i * 1000));
+  }
+  EXPECT_EQ(histogram.count(), 1000u);
+  EXPECT_EQ(histogram.max(), 1000000ns);
+  EXPECT_EQ(histogram.mean(), 500500ns);
+  const double precision = 1.0 / LatencyHistogram::kSubBucketCount;
+  EXPECT_NEAR(histogram.percentile(50.0).count(), 500000.0, 500000.0 * precision);
+  EXPECT_NEAR(histogram.percentile(99.0).count(), 990000.0, 990000.0 * precision);
+  EXPECT_EQ(histogram.percentile(100.0), 1000000ns);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.percentile(50.0), 0ns);
+}
+
+TEST(LatencyHistogramTest, records_from_several_threads) {
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back(
+      [&histogram]() {
+        for (int i = 0; i < 10000; ++i) {
+          histogram.record(std::chrono::nanoseconds(i));
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(histogram.count(), 40000u);
+  EXPECT_EQ(histogram.max(), 9999ns);
+}
+
+TEST(PipelineStatisticsTest, records_stages_and_queue_depths) {
+  PipelineStatistics statistics;
+  {
+    rosbag2_cpp::StageTimer timer(&statistics, PipelineStage::CACHE_PUSH);
+  }
+  statistics.record(PipelineStage::STORAGE_WRITE, 2ms);
+  statistics.set_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES, 10);
+  statistics.set_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES, 4);
+
+  EXPECT_EQ(statistics.histogram(PipelineStage::CACHE_PUSH).count(), 1u);
+  EXPECT_EQ(statistics.histogram(PipelineStage::STORAGE_WRITE).max(), 2ms);
+  EXPECT_EQ(statistics.histogram(PipelineStage::COMPRESSION).count(), 0u);
+  EXPECT_EQ(statistics.queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES), 4u);
+  EXPECT_EQ(statistics.max_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES), 10u);
+
+  const std::string summary = statistics.summary();
+  EXPECT_THAT(summary, HasSubstr("cache_push: count 1"));
+  EXPECT_THAT(summary, HasSubstr("storage_write: count 1"));
+  EXPECT_THAT(summary, HasSubstr("cache_batch_messages: last 4, max 10"));
+  EXPECT_THAT(summary, Not(HasSubstr("compression")));
+
+  statistics.reset();
+  EXPECT_EQ(statistics.histogram(PipelineStage::STORAGE_WRITE).count(), 0u);
+  EXPECT_EQ(statistics.max_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES), 0u);
+}
+
+TEST(PipelineStatisticsTest, stage_timer_without_statistics_does_nothing) {
+  rosbag2_cpp::StageTimer timer(nullptr, PipelineStage::CACHE_PUSH);
+}
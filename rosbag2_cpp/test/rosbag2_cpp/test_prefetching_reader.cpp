@@ -0,0 +1,300 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+constexpr size_t kMessageSize = 4;
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, int32_t time_stamp)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(&time_stamp, kMessageSize);
+  return message;
+}
+
+// Reader of messages in memory, which counts the messages read from it
+class FakeReader : public rosbag2_cpp::reader_interfaces::BaseReaderInterface
+{
+public:
+  explicit FakeReader(std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages)
+  : messages_(std::move(messages))
+  {}
+
+  void open(
+    const rosbag2_storage::StorageOptions &, const rosbag2_cpp::ConverterOptions &) override
+  {
+    is_open_ = true;
+  }
+
+  void close() override
+  {
+    is_open_ = false;
+  }
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & order) override
+  {
+    reverse_ = order.reverse;
+    return true;
+  }
+
+  bool has_next() override
+  {
+    if (!is_open_) {
+      throw std::runtime_error("Bag is not open. Call open() before reading.");
+    }
+    if (fail_reads_) {
+      throw std::runtime_error("Storage failure");
+    }
+    skip_filtered_messages();
+    return position_ < messages_.size();
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override
+  {
+    if (!has_next()) {
+      throw std::runtime_error("Bag is at end. No next message.");
+    }
+    ++read_count_;
+    return message_at(position_++);
+  }
+
+  const rosbag2_storage::BagMetadata & get_metadata() const override
+  {
+    return metadata_;
+  }
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() const override
+  {
+    return {};
+  }
+
+  void get_all_message_definitions(std::vector<rosbag2_storage::MessageDefinition> &) override {}
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override
+  {
+    filter_ = storage_filter;
+  }
+
+  void reset_filter() override
+  {
+    filter_ = rosbag2_storage::StorageFilter();
+  }
+
+  void seek(const rcutils_time_point_value_t & timestamp) override
+  {
+    position_ = 0;
+    while (position_ < messages_.size() &&
+      (reverse_ ? message_at(position_)->time_stamp > timestamp :
+      message_at(position_)->time_stamp < timestamp))
+    {
+      ++position_;
+    }
+  }
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::ReaderEventCallbacks &) override {}
+
+  std::atomic<size_t> read_count_{0};
+  std::atomic<bool> fail_reads_{false};
+
+private:
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> message_at(size_t position) const
+  {
+    return messages_[reverse_ ? messages_.size() - 1 - position : position];
+  }
+
+  void skip_filtered_messages()
+  {
+    while (position_ < messages_.size() && !filter_.topics.empty() &&
+      std::find(
+        filter_.topics.begin(), filter_.topics.end(),
+        message_at(position_)->topic_name) == filter_.topics.end())
+    {
+      ++position_;
+    }
+  }
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages_;
+  rosbag2_storage::BagMetadata metadata_;
+  rosbag2_storage::StorageFilter filter_;
+  size_t position_ = 0;
+  bool reverse_ = false;
+  bool is_open_ = false;
+};
+}  // namespace
+
+class PrefetchingReaderTest : public Test
+{
+public:
+  PrefetchingReaderTest()
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    for (int32_t i = 0; i < 10; ++i) {
+      messages.push_back(make_message(i % 2 == 0 ? "even" : "odd", i));
+    }
+    open_reader(messages);
+  }
+
+  void open_reader(std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages)
+  {
+    auto fake_reader = std::make_unique<FakeReader>(messages);
+    fake_reader_ = fake_reader.get();
+    reader_ = std::make_unique<rosbag2_cpp::readers::PrefetchingReader>(
+      std::move(fake_reader), 3 * kMessageSize);
+    reader_->open(rosbag2_storage::StorageOptions(), rosbag2_cpp::ConverterOptions());
+  }
+
+  std::vector<rcutils_time_point_value_t> read_all()
+  {
+    std::vector<rcutils_time_point_value_t> time_stamps;
+    while (reader_->has_next()) {
+      time_stamps.push_back(reader_->read_next()->time_stamp);
+    }
+    return time_stamps;
+  }
+
+  void wait_for_prefetched_bytes(size_t bytes)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (reader_->get_prefetched_bytes() < bytes &&
+      std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  FakeReader * fake_reader_;
+  std::unique_ptr<rosbag2_cpp::readers::PrefetchingReader> reader_;
+};
+
+TEST_F(PrefetchingReaderTest, reads_all_messages_in_order) {
+  EXPECT_THAT(read_all(), ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+  EXPECT_FALSE(reader_->has_next());
+  EXPECT_THROW(reader_->read_next(), std::runtime_error);
+}
+
+TEST_F(PrefetchingReaderTest, prefetches_no_more_than_max_prefetched_bytes) {
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  // Give the background thread time to read more if it would
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(reader_->get_prefetched_bytes(), 3 * kMessageSize);
+  EXPECT_EQ(fake_reader_->read_count_, 3u);
+
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  EXPECT_EQ(fake_reader_->read_count_, 4u);
+}
+
+TEST_F(PrefetchingReaderTest, seek_discards_prefetched_messages) {
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  reader_->seek(7);
+  EXPECT_THAT(read_all(), ElementsAre(7, 8, 9));
+
+  reader_->seek(2);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 2);
+}
+
+TEST_F(PrefetchingReaderTest, set_filter_continues_after_the_last_read_message) {
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"even"};
+  reader_->set_filter(filter);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 2);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 4);
+
+  wait_for_prefetched_bytes(2 * kMessageSize);
+  reader_->reset_filter();
+  EXPECT_THAT(read_all(), ElementsAre(5, 6, 7, 8, 9));
+}
+
+TEST_F(PrefetchingReaderTest, set_filter_before_reading_keeps_all_messages) {
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"odd"};
+  reader_->set_filter(filter);
+  EXPECT_THAT(read_all(), ElementsAre(1, 3, 5, 7, 9));
+}
+
+TEST_F(PrefetchingReaderTest, set_read_order_continues_from_the_last_read_message) {
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 1);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 2);
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  EXPECT_TRUE(reader_->set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+  EXPECT_THAT(read_all(), ElementsAre(1, 0));
+
+  reader_->seek(6);
+  EXPECT_THAT(read_all(), ElementsAre(6, 5, 4, 3, 2, 1, 0));
+}
+
+TEST_F(PrefetchingReaderTest, rewind_skips_messages_read_at_the_same_time_stamp) {
+  open_reader({
+      make_message("a", 0), make_message("a", 1), make_message("b", 1), make_message("a", 1),
+      make_message("b", 2), make_message("a", 3)});
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  EXPECT_EQ(reader_->read_next()->topic_name, "a");
+  EXPECT_EQ(reader_->read_next()->topic_name, "b");
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  reader_->reset_filter();
+  EXPECT_THAT(read_all(), ElementsAre(1, 2, 3));
+}
+
+TEST_F(PrefetchingReaderTest, seek_resets_the_read_head) {
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  reader_->seek(4);
+  wait_for_prefetched_bytes(3 * kMessageSize);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"even"};
+  reader_->set_filter(filter);
+  EXPECT_THAT(read_all(), ElementsAre(4, 6, 8));
+}
+
+TEST_F(PrefetchingReaderTest, rethrows_errors_of_the_wrapped_reader) {
+  fake_reader_->fail_reads_ = true;
+  reader_->seek(0);
+  EXPECT_THROW(reader_->has_next(), std::runtime_error);
+
+  fake_reader_->fail_reads_ = false;
+  reader_->seek(0);
+  EXPECT_THAT(read_all(), ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+TEST_F(PrefetchingReaderTest, reads_from_the_wrapped_reader_when_closed) {
+  reader_->close();
+  EXPECT_THROW(reader_->has_next(), std::runtime_error);
+}
@@ -0,0 +1,226 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/writers/routing_writer.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_metadata_io.hpp"
+
+using namespace testing;  // NOLINT
+using namespace std::chrono_literals;  // NOLINT
+
+using rosbag2_cpp::writers::RoutingWriter;
+
+namespace
+{
+
+struct FakeSubBag
+{
+  rosbag2_storage::StorageOptions storage_options;
+  std::vector<std::string> created_topics;
+  std::vector<std::string> written_topics;
+};
+
+class FakeSubBagWriter : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  explicit FakeSubBagWriter(FakeSubBag * sub_bag)
+  : sub_bag_(sub_bag) {}
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const rosbag2_cpp::ConverterOptions &) override
+  {
+    sub_bag_->storage_options = storage_options;
+  }
+
+  void close() override {}
+
+  void create_topic(const rosbag2_storage::TopicMetadata & topic) override
+  {
+    sub_bag_->created_topics.push_back(topic.name);
+  }
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata & topic,
+    const rosbag2_storage::MessageDefinition &) override
+  {
+    sub_bag_->created_topics.push_back(topic.name);
+  }
+
+  void remove_topic(const rosbag2_storage::TopicMetadata &) override {}
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override
+  {
+    sub_bag_->written_topics.push_back(message->topic_name);
+  }
+
+  bool take_snapshot() override {return false;}
+
+  void split_bagfile() override {}
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::WriterEventCallbacks &) override {}
+
+private:
+  FakeSubBag * sub_bag_;
+};
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(const std::string & topic_name)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->serialized_data = rosbag2_storage::make_empty_serialized_message(4);
+  return message;
+}
+
+rosbag2_storage::FileInformation make_file(
+  const std::string & path, std::chrono::nanoseconds start, std::chrono::nanoseconds duration,
+  size_t message_count)
+{
+  rosbag2_storage::FileInformation file_info;
+  file_info.path = path;
+  file_info.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(start);
+  file_info.duration = duration;
+  file_info.message_count = message_count;
+  return file_info;
+}
+
+}  // namespace
+
+class RoutingWriterTest : public rosbag2_test_common::TemporaryDirectoryFixture
+{
+public:
+  RoutingWriterTest()
+  : bag_uri_((std::filesystem::path(temporary_dir_path_) / "bag").string())
+  {
+    ON_CALL(*metadata_io_, read_metadata(_)).WillByDefault(
+      [this](const std::string & uri) {
+        rosbag2_storage::BagMetadata metadata;
+        metadata.storage_identifier = "fake_storage";
+        rosbag2_storage::TopicInformation topic_info;
+        if (uri == (std::filesystem::path(bag_uri_) / "camera").string()) {
+          metadata.files.push_back(make_file("camera_0.fake.zstd", 10s, 10s, 3));
+          metadata.compression_format = "zstd";
+          metadata.compression_mode = "FILE";
+          topic_info.topic_metadata.name = "/camera/image";
+          topic_info.message_count = 3;
+        } else {
+          metadata.files.push_back(make_file("default_0.fake", 5s, 10s, 2));
+          topic_info.topic_metadata.name = "/odom";
+          topic_info.message_count = 2;
+        }
+        metadata.topics_with_message_count.push_back(topic_info);
+        return metadata;
+      });
+  }
+
+  std::unique_ptr<RoutingWriter> make_writer(std::vector<RoutingWriter::Route> routes)
+  {
+    return std::make_unique<RoutingWriter>(
+      std::move(routes),
+      [this](const std::string & route_name) {
+        return std::make_unique<FakeSubBagWriter>(&sub_bags_[route_name]);
+      },
+      std::move(metadata_io_owner_));
+  }
+
+  void open(RoutingWriter & writer)
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = bag_uri_;
+    storage_options.max_bagfile_size = 1000;
+    storage_options.max_cache_size = 100;
+    writer.open(storage_options, {"", ""});
+  }
+
+  std::string bag_uri_;
+  std::map<std::string, FakeSubBag> sub_bags_;
+  std::unique_ptr<NiceMock<MockMetadataIo>> metadata_io_owner_ =
+    std::make_unique<NiceMock<MockMetadataIo>>();
+  NiceMock<MockMetadataIo> * metadata_io_ = metadata_io_owner_.get();
+};
+
+TEST_F(RoutingWriterTest, routes_topics_to_the_first_matching_sub_bag) {
+  auto writer = make_writer(
+    {{"camera", "/camera/.*", {}, {}, {}}, {"all_images", ".*image.*", {}, {}, {}}});
+  open(*writer);
+  for (const auto & topic : {"/camera/image", "/odom", "/lidar/image", "/camera/info"}) {
+    writer->create_topic({topic, "type", "cdr", {}, ""});
+    writer->write(make_message(topic));
+  }
+  EXPECT_EQ(writer->get_route_name("/lidar/image"), "all_images");
+  EXPECT_EQ(writer->get_route_name("/odom"), RoutingWriter::kDefaultRouteName);
+  writer->close();
+
+  EXPECT_THAT(sub_bags_["camera"].written_topics, ElementsAre("/camera/image", "/camera/info"));
+  EXPECT_THAT(sub_bags_["camera"].created_topics, ElementsAre("/camera/image", "/camera/info"));
+  EXPECT_THAT(sub_bags_["all_images"].written_topics, ElementsAre("/lidar/image"));
+  EXPECT_THAT(sub_bags_[RoutingWriter::kDefaultRouteName].written_topics, ElementsAre("/odom"));
+}
+
+TEST_F(RoutingWriterTest, opens_sub_bags_with_the_split_policy_of_their_route) {
+  auto writer = make_writer({{"camera", "/camera/.*", 5000u, 60u, 0u}});
+  open(*writer);
+
+  const auto & camera_options = sub_bags_["camera"].storage_options;
+  EXPECT_EQ(camera_options.uri, (std::filesystem::path(bag_uri_) / "camera").string());
+  EXPECT_EQ(camera_options.max_bagfile_size, 5000u);
+  EXPECT_EQ(camera_options.max_bagfile_duration, 60u);
+  EXPECT_EQ(camera_options.max_cache_size, 0u);
+  const auto & default_options = sub_bags_[RoutingWriter::kDefaultRouteName].storage_options;
+  EXPECT_EQ(default_options.max_bagfile_size, 1000u);
+  EXPECT_EQ(default_options.max_cache_size, 100u);
+}
+
+TEST_F(RoutingWriterTest, merges_metadata_of_sub_bags_on_close) {
+  rosbag2_storage::BagMetadata written_metadata;
+  EXPECT_CALL(*metadata_io_, write_metadata(bag_uri_, _)).WillOnce(SaveArg<1>(&written_metadata));
+  auto writer = make_writer({{"camera", "/camera/.*", {}, {}, {}}});
+  open(*writer);
+  writer->close();
+
+  EXPECT_THAT(
+    written_metadata.relative_file_paths, ElementsAre(
+      (std::filesystem::path("default") / "default_0.fake").string(),
+      (std::filesystem::path("camera") / "camera_0.fake.zstd").string()));
+  EXPECT_EQ(written_metadata.message_count, 5u);
+  EXPECT_THAT(written_metadata.topics_with_message_count, SizeIs(2));
+  EXPECT_EQ(written_metadata.duration, 15s);
+  // The sub-bags are compressed differently
+  EXPECT_EQ(written_metadata.compression_format, "");
+  EXPECT_EQ(written_metadata.custom_data[RoutingWriter::kSubBagsKey], "camera,default");
+}
+
+TEST_F(RoutingWriterTest, rejects_invalid_routes) {
+  EXPECT_THROW(make_writer({}), std::invalid_argument);
+  EXPECT_THROW(make_writer({{"../camera", ".*", {}, {}, {}}}), std::invalid_argument);
+  EXPECT_THROW(make_writer({{"default", ".*", {}, {}, {}}}), std::invalid_argument);
+  EXPECT_THROW(
+    make_writer({{"camera", ".*", {}, {}, {}}, {"camera", "/a", {}, {}, {}}}),
+    std::invalid_argument);
+  EXPECT_THROW(make_writer({{"camera", "/camera/(", {}, {}, {}}}), std::invalid_argument);
+}
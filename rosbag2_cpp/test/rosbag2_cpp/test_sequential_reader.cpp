@@ -14,20 +14,29 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
 
+#include "rosbag2_cpp/payload_deduplication.hpp"
+#include "rosbag2_cpp/payload_delta_encoding.hpp"
 #include "rosbag2_cpp/readers/sequential_reader.hpp"
 #include "rosbag2_cpp/reader.hpp"
 #include "rosbag2_cpp/writer.hpp"
+#include "rosbag2_cpp/writers/sequential_writer.hpp"
 
 #include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
 
 #include "rosbag2_test_common/tested_storage_ids.hpp"
@@ -169,6 +178,44 @@ TEST_F(
   reader_->read_next();
 }
 
+TEST_F(SequentialReaderTest, read_buffer_pool_provides_the_payloads_of_read_messages) {
+  // Like the storage plugins, create the payload of every message read
+  const std::vector<uint8_t> payload(1000, 42);
+  EXPECT_CALL(*storage_, read_next()).WillRepeatedly(
+    [&payload]() {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "topic";
+      message->serialized_data =
+      rosbag2_storage::make_serialized_message(payload.data(), payload.size());
+      return message;
+    });
+  auto storage_options = default_storage_options_;
+  storage_options.read_buffer_pool_size = 1024 * 1024;
+
+  reader_->open(storage_options, {"", storage_serialization_format_});
+  auto pool = rosbag2_storage::get_serialized_message_buffer_pool();
+  ASSERT_NE(pool, nullptr);
+
+  auto message = reader_->read_next();
+  EXPECT_EQ(message->serialized_data->allocator.state, pool.get());
+  const auto * buffer = message->serialized_data->buffer;
+  EXPECT_EQ(pool->get_cached_bytes(), 0u);
+  message.reset();
+  EXPECT_GT(pool->get_cached_bytes(), 0u);
+  // The released buffer is handed out again for the next message
+  message = reader_->read_next();
+  EXPECT_EQ(message->serialized_data->buffer, buffer);
+  EXPECT_EQ(pool->get_cached_bytes(), 0u);
+
+  reader_->close();
+  EXPECT_EQ(rosbag2_storage::get_serialized_message_buffer_pool(), nullptr);
+}
+
+TEST_F(SequentialReaderTest, read_buffer_pool_is_not_installed_by_default) {
+  reader_->open(default_storage_options_, {"", storage_serialization_format_});
+  EXPECT_EQ(rosbag2_storage::get_serialized_message_buffer_pool(), nullptr);
+}
+
 TEST_F(SequentialReaderTest, set_filter_calls_storage) {
   // Prior to opening the file, setting filter should throw exception
   rosbag2_storage::StorageFilter storage_filter;
@@ -222,6 +269,268 @@ TEST_F(SequentialReaderTest, next_file_calls_callback) {
   EXPECT_EQ(opened_file, bag_file_2_path_.string());
 }
 
+class SplitBagReaderTest : public Test
+{
+public:
+  explicit SplitBagReaderTest(int file_count = 2)
+  : storage_uri_(rcpputils::fs::temp_directory_path().string()),
+    storage_options_({storage_uri_, "mock_storage"})
+  {
+    rosbag2_storage::TopicMetadata topic_with_type;
+    topic_with_type.name = "topic";
+    topic_with_type.type = "test_msgs/BasicTypes";
+    topic_with_type.serialization_format = "rmw1_format";
+    metadata_.version = 5;
+    metadata_.storage_identifier = "mock_storage";
+    metadata_.topics_with_message_count.push_back({topic_with_type, 6});
+    // Each file spans 100 ns and holds a message every 25 ns
+    for (int file = 0; file < file_count; ++file) {
+      metadata_.relative_file_paths.push_back("bag_file" + std::to_string(file + 1));
+      rosbag2_storage::FileInformation file_info;
+      file_info.path = metadata_.relative_file_paths[file];
+      file_info.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+        std::chrono::nanoseconds(file * 100));
+      file_info.duration = std::chrono::nanoseconds(75);
+      file_info.message_count = 4;
+      metadata_.files.push_back(file_info);
+      add_storage(
+        (rcpputils::fs::path(storage_uri_) / file_info.path).string(),
+        {file * 100, file * 100 + 25, file * 100 + 50, file * 100 + 75});
+    }
+
+    auto storage_factory = std::make_unique<NiceMock<MockStorageFactory>>();
+    ON_CALL(*storage_factory, open_read_only).WillByDefault(
+      [this](const rosbag2_storage::StorageOptions & storage_options) {
+        std::lock_guard<std::mutex> lock(opened_files_mutex_);
+        opened_on_thread_[storage_options.uri] = std::this_thread::get_id();
+        ++open_count_;
+        return storages_.at(storage_options.uri);
+      });
+    auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+    // Tests may change the metadata until the reader is opened
+    ON_CALL(*metadata_io, read_metadata(_)).WillByDefault(
+      [this](const std::string &) {return metadata_;});
+    ON_CALL(*metadata_io, metadata_file_exists(_)).WillByDefault(Return(true));
+    reader_ = std::make_unique<rosbag2_cpp::readers::SequentialReader>(
+      std::move(storage_factory), std::make_shared<NiceMock<MockConverterFactory>>(),
+      std::move(metadata_io));
+  }
+
+  void add_storage(const std::string & uri, std::vector<rcutils_time_point_value_t> time_stamps)
+  {
+    auto storage = std::make_shared<NiceMock<MockStorage>>();
+    auto position = std::make_shared<size_t>(0);
+    ON_CALL(*storage, set_read_order).WillByDefault(Return(true));
+    ON_CALL(*storage, has_next).WillByDefault(
+      [position, time_stamps]() {return *position < time_stamps.size();});
+    ON_CALL(*storage, read_next).WillByDefault(
+      [position, time_stamps]() {
+        auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        message->topic_name = "topic";
+        message->time_stamp = time_stamps.at((*position)++);
+        return message;
+      });
+    ON_CALL(*storage, seek).WillByDefault(
+      [position, time_stamps](const rcutils_time_point_value_t & timestamp) {
+        *position = std::lower_bound(
+          time_stamps.begin(), time_stamps.end(), timestamp) - time_stamps.begin();
+      });
+    storages_[uri] = storage;
+  }
+
+  std::vector<rcutils_time_point_value_t> read_all()
+  {
+    std::vector<rcutils_time_point_value_t> time_stamps;
+    while (reader_->has_next()) {
+      time_stamps.push_back(reader_->read_next()->time_stamp);
+    }
+    return time_stamps;
+  }
+
+  std::thread::id opened_on_thread(const std::string & file)
+  {
+    std::lock_guard<std::mutex> lock(opened_files_mutex_);
+    return opened_on_thread_[(rcpputils::fs::path(storage_uri_) / file).string()];
+  }
+
+  std::string storage_uri_;
+  rosbag2_storage::StorageOptions storage_options_;
+  rosbag2_storage::BagMetadata metadata_;
+  std::unordered_map<std::string, std::shared_ptr<NiceMock<MockStorage>>> storages_;
+  std::mutex opened_files_mutex_;
+  std::unordered_map<std::string, std::thread::id> opened_on_thread_;
+  size_t open_count_ = 0;
+  std::unique_ptr<rosbag2_cpp::readers::SequentialReader> reader_;
+};
+
+using NextFileOpenAheadTest = SplitBagReaderTest;
+
+TEST_F(NextFileOpenAheadTest, next_file_is_opened_on_the_reading_thread_by_default) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  EXPECT_THAT(read_all(), ElementsAre(0, 25, 50, 75, 100, 125, 150, 175));
+  EXPECT_EQ(opened_on_thread("bag_file2"), std::this_thread::get_id());
+}
+
+TEST_F(NextFileOpenAheadTest, next_file_is_opened_ahead_after_fraction_of_current_file) {
+  storage_options_.next_file_open_fraction = 0.5;
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 25);
+  EXPECT_EQ(opened_on_thread("bag_file2"), std::thread::id());
+
+  EXPECT_CALL(*storages_.at((rcpputils::fs::path(storage_uri_) / "bag_file2").string()), seek(0));
+  EXPECT_THAT(read_all(), ElementsAre(50, 75, 100, 125, 150, 175));
+  const auto opened_on = opened_on_thread("bag_file2");
+  EXPECT_NE(opened_on, std::thread::id());
+  EXPECT_NE(opened_on, std::this_thread::get_id());
+}
+
+TEST_F(NextFileOpenAheadTest, next_file_opened_ahead_is_discarded_on_seek) {
+  storage_options_.next_file_open_fraction = 0.5;
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 25);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 50);
+  // Seeking past the current file opens the next one again, on the reading thread
+  reader_->seek(150);
+  EXPECT_EQ(opened_on_thread("bag_file2"), std::this_thread::get_id());
+}
+
+TEST_F(SplitBagReaderTest, read_next_batch_continues_in_next_file) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  auto time_stamps = [](const auto & messages) {
+      std::vector<rcutils_time_point_value_t> time_stamps;
+      for (const auto & message : messages) {
+        time_stamps.push_back(message->time_stamp);
+      }
+      return time_stamps;
+    };
+
+  EXPECT_THAT(time_stamps(reader_->read_next_batch(3)), ElementsAre(0, 25, 50));
+  EXPECT_THAT(time_stamps(reader_->read_next_batch(3)), ElementsAre(75, 100, 125));
+  EXPECT_THAT(time_stamps(reader_->read_next_batch(0)), ElementsAre(150, 175));
+  EXPECT_THAT(reader_->read_next_batch(3), IsEmpty());
+}
+
+TEST_F(SplitBagReaderTest, for_each_continues_in_next_file_until_callback_stops) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  const auto collect_until = [&time_stamps](rcutils_time_point_value_t last) {
+      return [&time_stamps, last](const rosbag2_storage::SerializedBagMessageView & message) {
+               EXPECT_EQ(message.topic_name, "topic");
+               time_stamps.push_back(message.time_stamp);
+               return message.time_stamp < last;
+             };
+    };
+
+  reader_->for_each(collect_until(100));
+  EXPECT_THAT(time_stamps, ElementsAre(0, 25, 50, 75, 100));
+  // Reading continues after the message the callback stopped at
+  time_stamps.clear();
+  reader_->for_each(collect_until(1000));
+  EXPECT_THAT(time_stamps, ElementsAre(125, 150, 175));
+  EXPECT_FALSE(reader_->has_next());
+}
+
+TEST_F(SplitBagReaderTest, time_windows_of_files_narrow_the_filter_of_their_storage) {
+  metadata_.files[0].window_start_time_ns = 25;
+  metadata_.files[0].window_end_time_ns = 50;
+  const auto file_1 = (rcpputils::fs::path(storage_uri_) / "bag_file1").string();
+  const auto file_2 = (rcpputils::fs::path(storage_uri_) / "bag_file2").string();
+  std::unordered_map<std::string, rosbag2_storage::StorageFilter> filters;
+  for (const auto & file : {file_1, file_2}) {
+    ON_CALL(*storages_.at(file), set_filter).WillByDefault(
+      [&filters, file](const rosbag2_storage::StorageFilter & storage_filter) {
+        filters[file] = storage_filter;
+      });
+  }
+
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  EXPECT_EQ(filters[file_1].start_time_ns, 25);
+  EXPECT_EQ(filters[file_1].end_time_ns, 50);
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.end_time_ns = 140;
+  reader_->set_filter(storage_filter);
+  EXPECT_EQ(filters[file_1].end_time_ns, 50);
+
+  // The window moves the end of the first file, so seeking past it goes to the second file
+  reader_->seek(20);
+  EXPECT_EQ(reader_->get_current_file(), file_1);
+  reader_->seek(60);
+  EXPECT_EQ(reader_->get_current_file(), file_2);
+  EXPECT_EQ(filters[file_2].start_time_ns, -1);
+  EXPECT_EQ(filters[file_2].end_time_ns, 140);
+}
+
+class SeekSplitBagTest : public SplitBagReaderTest
+{
+public:
+  SeekSplitBagTest()
+  : SplitBagReaderTest(50) {}
+};
+
+TEST_F(SeekSplitBagTest, seek_opens_only_the_file_holding_the_time_stamp) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  EXPECT_EQ(open_count_, 1u);
+  reader_->seek(4125);
+  EXPECT_EQ(open_count_, 2u);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 4125);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 4150);
+
+  reader_->seek(1060);
+  EXPECT_EQ(open_count_, 3u);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 1075);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 1100);
+}
+
+TEST_F(SeekSplitBagTest, seek_between_files_goes_to_the_next_file) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  reader_->seek(4190);
+  EXPECT_EQ(open_count_, 2u);
+  EXPECT_EQ(reader_->read_next()->time_stamp, 4200);
+
+  reader_->seek(100000);
+  EXPECT_EQ(open_count_, 3u);
+  EXPECT_FALSE(reader_->has_next());
+}
+
+TEST_F(SeekSplitBagTest, files_outside_time_window_of_filter_are_not_opened) {
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.start_time_ns = 2000;
+  storage_filter.end_time_ns = 2200;
+  reader_->set_filter(storage_filter);
+
+  // The mock storage does not filter messages by time itself
+  EXPECT_THAT(
+    read_all(), ElementsAre(
+      0, 25, 50, 75, 2000, 2025, 2050, 2075, 2100, 2125, 2150, 2175, 2200, 2225, 2250, 2275));
+  EXPECT_EQ(open_count_, 4u);
+  EXPECT_EQ(
+    reader_->get_current_file(), (rcpputils::fs::path(storage_uri_) / "bag_file23").string());
+}
+
+TEST_F(SeekSplitBagTest, estimate_sums_files_in_time_window_of_filter) {
+  for (auto & storage : storages_) {
+    ON_CALL(*storage.second, estimate).WillByDefault(
+      Return(rosbag2_storage::ReadEstimate{4, 40, true}));
+  }
+  reader_->open(storage_options_, {"", "rmw1_format"});
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.start_time_ns = 2000;
+  storage_filter.end_time_ns = 2200;
+
+  const auto estimate = reader_->estimate(storage_filter);
+  EXPECT_EQ(estimate.message_count, 12u);
+  EXPECT_EQ(estimate.bytes, 120u);
+  EXPECT_TRUE(estimate.exact);
+  EXPECT_EQ(open_count_, 4u);
+  // The reader stays at its file and position
+  EXPECT_EQ(
+    reader_->get_current_file(), (rcpputils::fs::path(storage_uri_) / "bag_file1").string());
+  EXPECT_EQ(reader_->read_next()->time_stamp, 0);
+}
+
 TEST_P(ParametrizedTemporaryDirectoryFixture, reader_accepts_bare_file) {
   const auto bag_path = rcpputils::fs::path(temporary_dir_path_) / "bag";
   const auto storage_id = GetParam();
@@ -369,6 +678,22 @@ TEST_P(ReadOrderTest, reverse_received_timestamp_order) {
   }
 }
 
+TEST_P(ReadOrderTest, next_file_opened_ahead_keeps_order) {
+  storage_options.next_file_open_fraction = 0.5;
+  for (bool reverse : {false, true}) {
+    rosbag2_storage::ReadOrder order(rosbag2_storage::ReadOrder::ReceivedTimestamp, reverse);
+    sort_expected(order);
+    reader.open(storage_options, rosbag2_cpp::ConverterOptions{});
+    EXPECT_TRUE(reader.set_read_order(order));
+    if (reverse) {
+      auto metadata = reader.get_metadata();
+      reader.seek((metadata.starting_time + metadata.duration).time_since_epoch().count());
+    }
+    check_against_sorted(false);
+    reader.close();
+  }
+}
+
 TEST_P(ReadOrderTest, reverse_file_order) {
   reader.open(storage_options, rosbag2_cpp::ConverterOptions{});
   EXPECT_FALSE(
@@ -387,3 +712,231 @@ INSTANTIATE_TEST_SUITE_P(
   ReadOrderTest,
   ValuesIn(rosbag2_test_common::kTestedStorageIDs)
 );
+
+class DeduplicationTest : public ParametrizedTemporaryDirectoryFixture
+{
+public:
+  DeduplicationTest()
+  {
+    storage_options.uri = (rcpputils::fs::path(temporary_dir_path_) / "deduplicated").string();
+    storage_options.storage_id = GetParam();
+    storage_options.deduplication_min_payload_size = 64;
+
+    rosbag2_cpp::writers::SequentialWriter writer{};
+    writer.open(storage_options, rosbag2_cpp::ConverterOptions{});
+    writer.create_topic({"topic", "test_msgs/msg/ByteMultiArray", "cdr", {}, ""});
+    for (size_t i = 0; i < messages.size(); ++i) {
+      if (i == 4) {
+        writer.split_bagfile();
+      }
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->serialized_data = rosbag2_storage::make_serialized_message(
+        messages[i].second.data(), messages[i].second.size());
+      message->time_stamp = messages[i].first;
+      message->topic_name = "topic";
+      writer.write(message);
+    }
+    writer.close();
+  }
+
+  std::vector<std::string> read_payloads(
+    const rosbag2_storage::StorageOptions & options, bool reverse = false)
+  {
+    rosbag2_cpp::readers::SequentialReader reader{};
+    reader.open(options, rosbag2_cpp::ConverterOptions{});
+    if (reverse) {
+      EXPECT_TRUE(
+        reader.set_read_order(
+          rosbag2_storage::ReadOrder(rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+      const auto metadata = reader.get_metadata();
+      reader.seek((metadata.starting_time + metadata.duration).time_since_epoch().count());
+    }
+    std::vector<std::string> payloads;
+    while (reader.has_next()) {
+      const auto message = reader.read_next();
+      payloads.emplace_back(
+        reinterpret_cast<const char *>(message->serialized_data->buffer),
+        message->serialized_data->buffer_length);
+    }
+    return payloads;
+  }
+
+  std::vector<std::string> expected_payloads(bool reverse = false) const
+  {
+    std::vector<std::string> payloads;
+    for (const auto & message : messages) {
+      payloads.push_back(message.second);
+    }
+    if (reverse) {
+      std::reverse(payloads.begin(), payloads.end());
+    }
+    return payloads;
+  }
+
+  const std::string map_a = std::string(1000, 'a');
+  const std::string map_b = std::string(1000, 'b');
+  // The second file starts at time stamp 500
+  const std::vector<std::pair<rcutils_time_point_value_t, std::string>> messages {
+    {100, map_a},
+    {200, map_a},
+    {300, "small"},
+    {400, map_b},
+    {500, map_a},
+    {600, map_b},
+    {700, map_a},
+    {800, map_a}
+  };
+
+  rosbag2_storage::StorageOptions storage_options{};
+};
+
+TEST_P(DeduplicationTest, repeated_payloads_are_stored_as_references_within_each_file) {
+  rosbag2_storage::MetadataIo metadata_io;
+  const auto metadata = metadata_io.read_metadata(storage_options.uri);
+  EXPECT_EQ(metadata.custom_data.count(rosbag2_cpp::kDeduplicatedPayloadsKey), 1u);
+  ASSERT_EQ(metadata.relative_file_paths.size(), 2u);
+
+  rosbag2_storage::StorageFactory factory;
+  std::vector<size_t> stored_sizes;
+  for (const auto & file : metadata.relative_file_paths) {
+    auto options = storage_options;
+    options.uri = (rcpputils::fs::path(storage_options.uri) / file).string();
+    auto storage = factory.open_read_only(options);
+    ASSERT_NE(storage, nullptr);
+    while (storage->has_next()) {
+      stored_sizes.push_back(storage->read_next()->serialized_data->buffer_length);
+    }
+  }
+  const size_t reference = rosbag2_cpp::kPayloadReferenceSize;
+  EXPECT_THAT(
+    stored_sizes,
+    ElementsAre(1000u, reference, 5u, 1000u, 1000u, 1000u, reference, reference));
+}
+
+TEST_P(DeduplicationTest, reader_resolves_references) {
+  EXPECT_EQ(read_payloads(storage_options), expected_payloads());
+}
+
+TEST_P(DeduplicationTest, reader_looks_up_references_without_cache) {
+  auto options = storage_options;
+  options.deduplication_cache_size = 0;
+  EXPECT_EQ(read_payloads(options), expected_payloads());
+  EXPECT_EQ(read_payloads(options, true), expected_payloads(true));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ThisDeduplicationTest,
+  DeduplicationTest,
+  ValuesIn(rosbag2_test_common::kTestedStorageIDs)
+);
+
+class DeltaEncodingTest : public ParametrizedTemporaryDirectoryFixture
+{
+public:
+  DeltaEncodingTest()
+  {
+    storage_options.uri = (rcpputils::fs::path(temporary_dir_path_) / "delta_encoded").string();
+    storage_options.storage_id = GetParam();
+    storage_options.delta_encoded_topics = {"map"};
+    storage_options.delta_keyframe_interval = 3;
+
+    for (size_t i = 0; i < 8; ++i) {
+      std::string map(1000, 'm');
+      map[10 * i] = 'x';
+      map[500 + i] = 'y';
+      messages.emplace_back(static_cast<rcutils_time_point_value_t>(100 * (i + 1)), map);
+    }
+
+    rosbag2_cpp::writers::SequentialWriter writer{};
+    writer.open(storage_options, rosbag2_cpp::ConverterOptions{});
+    writer.create_topic({"map", "test_msgs/msg/ByteMultiArray", "cdr", {}, ""});
+    for (size_t i = 0; i < messages.size(); ++i) {
+      if (i == 4) {
+        writer.split_bagfile();
+      }
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->serialized_data = rosbag2_storage::make_serialized_message(
+        messages[i].second.data(), messages[i].second.size());
+      message->time_stamp = messages[i].first;
+      message->topic_name = "map";
+      writer.write(message);
+    }
+    writer.close();
+  }
+
+  std::vector<std::string> read_payloads(
+    std::optional<rcutils_time_point_value_t> seek_time = std::nullopt, bool reverse = false)
+  {
+    rosbag2_cpp::readers::SequentialReader reader{};
+    reader.open(storage_options, rosbag2_cpp::ConverterOptions{});
+    if (reverse) {
+      EXPECT_TRUE(
+        reader.set_read_order(
+          rosbag2_storage::ReadOrder(rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+    }
+    if (seek_time) {
+      reader.seek(*seek_time);
+    }
+    std::vector<std::string> payloads;
+    while (reader.has_next()) {
+      const auto message = reader.read_next();
+      payloads.emplace_back(
+        reinterpret_cast<const char *>(message->serialized_data->buffer),
+        message->serialized_data->buffer_length);
+    }
+    return payloads;
+  }
+
+  std::vector<std::string> expected_payloads(size_t first = 0) const
+  {
+    std::vector<std::string> payloads;
+    for (size_t i = first; i < messages.size(); ++i) {
+      payloads.push_back(messages[i].second);
+    }
+    return payloads;
+  }
+
+  // The second file starts at time stamp 500
+  std::vector<std::pair<rcutils_time_point_value_t, std::string>> messages;
+
+  rosbag2_storage::StorageOptions storage_options{};
+};
+
+TEST_P(DeltaEncodingTest, messages_between_keyframes_are_stored_as_deltas_within_each_file) {
+  rosbag2_storage::MetadataIo metadata_io;
+  const auto metadata = metadata_io.read_metadata(storage_options.uri);
+  ASSERT_EQ(metadata.custom_data.count(rosbag2_cpp::kDeltaEncodedTopicsKey), 1u);
+  EXPECT_EQ(metadata.custom_data.at(rosbag2_cpp::kDeltaEncodedTopicsKey), "map");
+  ASSERT_EQ(metadata.relative_file_paths.size(), 2u);
+
+  rosbag2_storage::StorageFactory factory;
+  std::vector<bool> is_keyframe;
+  for (const auto & file : metadata.relative_file_paths) {
+    auto options = storage_options;
+    options.uri = (rcpputils::fs::path(storage_options.uri) / file).string();
+    auto storage = factory.open_read_only(options);
+    ASSERT_NE(storage, nullptr);
+    while (storage->has_next()) {
+      is_keyframe.push_back(storage->read_next()->serialized_data->buffer_length == 1000u);
+    }
+  }
+  EXPECT_THAT(is_keyframe, ElementsAre(true, false, false, true, true, false, false, true));
+}
+
+TEST_P(DeltaEncodingTest, reader_reconstructs_deltas) {
+  EXPECT_EQ(read_payloads(), expected_payloads());
+}
+
+TEST_P(DeltaEncodingTest, reader_reconstructs_deltas_after_seek_and_in_reverse_order) {
+  // The message at time stamp 600 is a delta to the keyframe at time stamp 500
+  EXPECT_EQ(read_payloads(600), expected_payloads(5));
+  auto reversed = expected_payloads();
+  std::reverse(reversed.begin(), reversed.end());
+  EXPECT_EQ(read_payloads(800, true), reversed);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ThisDeltaEncodingTest,
+  DeltaEncodingTest,
+  ValuesIn(rosbag2_test_common::kTestedStorageIDs)
+);
@@ -14,14 +14,24 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "rcpputils/filesystem_helper.hpp"
 
+#include "rclcpp/serialized_message.hpp"
+#include "rclcpp/time.hpp"
+
+#include "rosbag2_cpp/bag_preview.hpp"
 #include "rosbag2_cpp/writers/sequential_writer.hpp"
 #include "rosbag2_cpp/writer.hpp"
 
@@ -134,6 +144,153 @@ TEST_F(
   writer_->write(message);
 }
 
+TEST_F(SequentialWriterTest, write_converts_messages_of_a_topic_into_the_same_ros_message) {
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string storage_serialization_format = "rmw1_format";
+  std::string input_format = "rmw2_format";
+
+  std::vector<rosbag2_cpp::rosbag2_introspection_message_t *> ros_messages;
+  std::vector<size_t> output_buffer_capacities;
+  auto format1_converter = std::make_unique<StrictMock<MockConverter>>();
+  auto format2_converter = std::make_unique<StrictMock<MockConverter>>();
+  EXPECT_CALL(*format1_converter, serialize(_, _, _)).Times(2).WillRepeatedly(
+    [&output_buffer_capacities](
+      std::shared_ptr<const rosbag2_cpp::rosbag2_introspection_message_t>,
+      const rosidl_message_type_support_t *,
+      std::shared_ptr<rosbag2_storage::SerializedBagMessage> serialized_message) {
+      output_buffer_capacities.push_back(serialized_message->serialized_data->buffer_capacity);
+      serialized_message->serialized_data = rosbag2_storage::make_serialized_message("Hello", 5);
+    });
+  EXPECT_CALL(*format2_converter, deserialize(_, _, _)).Times(2).WillRepeatedly(
+    [&ros_messages](
+      std::shared_ptr<const rosbag2_storage::SerializedBagMessage>,
+      const rosidl_message_type_support_t *,
+      std::shared_ptr<rosbag2_cpp::rosbag2_introspection_message_t> ros_message) {
+      ros_messages.push_back(ros_message.get());
+    });
+
+  EXPECT_CALL(*converter_factory_, load_serializer(storage_serialization_format))
+  .WillOnce(Return(ByMove(std::move(format1_converter))));
+  EXPECT_CALL(*converter_factory_, load_deserializer(input_format))
+  .WillOnce(Return(ByMove(std::move(format2_converter))));
+
+  writer_->open(storage_options_, {input_format, storage_serialization_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+  writer_->write(make_test_msg());
+  writer_->write(make_test_msg());
+
+  ASSERT_THAT(ros_messages, SizeIs(2));
+  EXPECT_EQ(ros_messages[0], ros_messages[1]);
+  EXPECT_THAT(output_buffer_capacities, ElementsAre(0u, 5u));
+}
+
+TEST_F(SequentialWriterTest, cache_consumer_converts_batches_on_conversion_threads) {
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string storage_serialization_format = "rmw1_format";
+  std::string input_format = "rmw2_format";
+  const size_t conversion_threads = 2;
+
+  std::mutex converted_mutex;
+  std::vector<size_t> written_buffer_lengths;
+  // The writer keeps a converter for writing without the cache besides those of the threads
+  EXPECT_CALL(*converter_factory_, load_serializer(storage_serialization_format))
+  .Times(conversion_threads + 1).WillRepeatedly(
+    [](const std::string &) {
+      auto converter = std::make_unique<NiceMock<MockConverter>>();
+      ON_CALL(*converter, serialize(_, _, _)).WillByDefault(
+        [](
+          std::shared_ptr<const rosbag2_cpp::rosbag2_introspection_message_t>,
+          const rosidl_message_type_support_t *,
+          std::shared_ptr<rosbag2_storage::SerializedBagMessage> serialized_message) {
+          serialized_message->serialized_data =
+          rosbag2_storage::make_serialized_message("Converted", 9);
+        });
+      return converter;
+    });
+  EXPECT_CALL(*converter_factory_, load_deserializer(input_format))
+  .Times(conversion_threads + 1).WillRepeatedly(
+    [](const std::string &) {return std::make_unique<NiceMock<MockConverter>>();});
+  ON_CALL(
+    *storage_,
+    write(An<const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>()))
+  .WillByDefault(
+    [&](const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      std::lock_guard<std::mutex> lock(converted_mutex);
+      for (const auto & msg : msgs) {
+        written_buffer_lengths.push_back(msg->serialized_data->buffer_length);
+      }
+    });
+
+  storage_options_.max_cache_size = 4000u;
+  rosbag2_cpp::ConverterOptions converter_options{input_format, storage_serialization_format};
+  converter_options.conversion_threads = conversion_threads;
+  writer_->open(storage_options_, converter_options);
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+  for (int i = 0; i < 10; ++i) {
+    writer_->write(make_test_msg());
+  }
+  writer_.reset();
+
+  EXPECT_THAT(written_buffer_lengths, SizeIs(10));
+  EXPECT_THAT(written_buffer_lengths, Each(9u));
+}
+
+TEST_F(SequentialWriterTest, cache_consumer_registers_topics_before_writing_their_messages) {
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::mutex calls_mutex;
+  std::vector<std::string> storage_calls;
+  std::atomic<bool> created_on_calling_thread{false};
+  const auto calling_thread = std::this_thread::get_id();
+  ON_CALL(*storage_, create_topic(_, _)).WillByDefault(
+    [&](const rosbag2_storage::TopicMetadata & topic, const rosbag2_storage::MessageDefinition &) {
+      if (std::this_thread::get_id() == calling_thread) {
+        created_on_calling_thread = true;
+      }
+      std::lock_guard<std::mutex> lock(calls_mutex);
+      storage_calls.push_back("create " + topic.name);
+    });
+  ON_CALL(
+    *storage_,
+    write(An<const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>()))
+  .WillByDefault(
+    [&](const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      std::lock_guard<std::mutex> lock(calls_mutex);
+      for (const auto & msg : msgs) {
+        storage_calls.push_back("write " + msg->topic_name);
+      }
+    });
+
+  storage_options_.max_cache_size = 4000u;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "rmw_format", {}, ""});
+  writer_->write(make_test_msg());
+  writer_->create_topic({"late_topic", "test_msgs/BasicTypes", "rmw_format", {}, ""});
+  auto message = make_test_msg();
+  message->topic_name = "late_topic";
+  writer_->write(message);
+  writer_.reset();
+
+  EXPECT_FALSE(created_on_calling_thread);
+  // Both messages may be written in one batch, after both topics were registered
+  ASSERT_THAT(
+    storage_calls, UnorderedElementsAre(
+      "create test_topic", "write test_topic", "create late_topic", "write late_topic"));
+  const auto position = [&storage_calls](const std::string & call) {
+      return std::find(storage_calls.begin(), storage_calls.end(), call) - storage_calls.begin();
+    };
+  EXPECT_LT(position("create test_topic"), position("write test_topic"));
+  EXPECT_LT(position("create late_topic"), position("write late_topic"));
+}
+
 TEST_F(SequentialWriterTest, write_does_not_use_converters_if_input_and_output_format_are_equal) {
   auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
     std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
@@ -498,10 +655,167 @@ TEST_F(SequentialWriterTest, do_not_use_cache_if_cache_size_is_zero) {
   }
 }
 
+TEST_F(SequentialWriterTest, write_serialized_message_does_not_copy_payload) {
+  std::shared_ptr<const rosbag2_storage::SerializedBagMessage> written_message;
+  EXPECT_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillOnce(
+    [&written_message](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) {
+      written_message = msg;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 0;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+
+  std::string msg_content = "Hello";
+  auto serialized_msg = std::make_shared<rclcpp::SerializedMessage>(msg_content.length());
+  auto & rcl_serialized_msg = serialized_msg->get_rcl_serialized_message();
+  std::memcpy(rcl_serialized_msg.buffer, msg_content.c_str(), msg_content.length());
+  rcl_serialized_msg.buffer_length = msg_content.length();
+  const uint8_t * original_buffer = rcl_serialized_msg.buffer;
+
+  writer_->write(serialized_msg, "test_topic", "test_msgs/BasicTypes", rclcpp::Time(1));
+  ASSERT_NE(written_message, nullptr);
+  EXPECT_EQ(written_message->serialized_data->buffer, original_buffer);
+  EXPECT_EQ(written_message->serialized_data->buffer_length, msg_content.length());
+
+  // The bag message keeps the original payload alive.
+  std::weak_ptr<rclcpp::SerializedMessage> weak_serialized_msg = serialized_msg;
+  serialized_msg.reset();
+  EXPECT_FALSE(weak_serialized_msg.expired());
+  written_message.reset();
+  EXPECT_TRUE(weak_serialized_msg.expired());
+}
+
+TEST_F(SequentialWriterTest, write_serialized_message_with_publish_info) {
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> written_messages;
+  EXPECT_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillRepeatedly(
+    [&written_messages](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) {
+      written_messages.push_back(msg);
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 0;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+
+  auto serialized_msg = std::make_shared<rclcpp::SerializedMessage>(1);
+  serialized_msg->get_rcl_serialized_message().buffer_length = 1;
+  writer_->write(serialized_msg, "test_topic", "test_msgs/BasicTypes", rclcpp::Time(20), 10, 5);
+  writer_->write(serialized_msg, "test_topic", "test_msgs/BasicTypes", rclcpp::Time(30));
+
+  ASSERT_EQ(written_messages.size(), 2u);
+  EXPECT_EQ(written_messages[0]->time_stamp, 20);
+  EXPECT_EQ(written_messages[0]->send_timestamp, 10);
+  EXPECT_EQ(written_messages[0]->sequence_number, 5u);
+  EXPECT_EQ(written_messages[1]->time_stamp, 30);
+  EXPECT_EQ(written_messages[1]->send_timestamp, 0);
+  EXPECT_EQ(written_messages[1]->sequence_number, 0u);
+}
+
+TEST_F(SequentialWriterTest, messages_outside_time_window_are_discarded_before_writing) {
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> written_messages;
+  EXPECT_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillRepeatedly(
+    [&written_messages](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) {
+      written_messages.push_back(msg);
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 0;
+  storage_options_.start_time_ns = 20;
+  storage_options_.end_time_ns = 30;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  EXPECT_FALSE(writer_->is_within_time_window(19));
+  EXPECT_TRUE(writer_->is_within_time_window(20));
+  EXPECT_TRUE(writer_->is_within_time_window(30));
+  EXPECT_FALSE(writer_->is_within_time_window(31));
+
+  auto serialized_msg = std::make_shared<rclcpp::SerializedMessage>(1);
+  serialized_msg->get_rcl_serialized_message().buffer_length = 1;
+  for (int64_t time_stamp : {10, 20, 30, 40}) {
+    writer_->write(serialized_msg, "test_topic", "test_msgs/BasicTypes", rclcpp::Time(time_stamp));
+  }
+
+  ASSERT_EQ(written_messages.size(), 2u);
+  EXPECT_EQ(written_messages[0]->time_stamp, 20);
+  EXPECT_EQ(written_messages[1]->time_stamp, 30);
+}
+
+TEST_F(SequentialWriterTest, serialized_messages_are_tagged_with_topic_id) {
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> written_messages;
+  EXPECT_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillRepeatedly(
+    [&written_messages](std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) {
+      written_messages.push_back(msg);
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  auto & sequential_writer_handle = *sequential_writer;
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  storage_options_.max_cache_size = 0;
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  EXPECT_EQ(
+    sequential_writer_handle.get_topic_id("topic_a"), rosbag2_storage::UNASSIGNED_TOPIC_ID);
+
+  const size_t kNumMessagesToWrite = 3;
+  for (size_t i = 0; i < kNumMessagesToWrite; ++i) {
+    for (const std::string topic : {"topic_a", "topic_b"}) {
+      auto serialized_msg = std::make_shared<rclcpp::SerializedMessage>(1);
+      serialized_msg->get_rcl_serialized_message().buffer_length = 1;
+      writer_->write(serialized_msg, topic, "test_msgs/BasicTypes", rclcpp::Time(1));
+    }
+  }
+
+  const auto topic_a_id = sequential_writer_handle.get_topic_id("topic_a");
+  const auto topic_b_id = sequential_writer_handle.get_topic_id("topic_b");
+  EXPECT_NE(topic_a_id, rosbag2_storage::UNASSIGNED_TOPIC_ID);
+  EXPECT_NE(topic_b_id, rosbag2_storage::UNASSIGNED_TOPIC_ID);
+  EXPECT_NE(topic_a_id, topic_b_id);
+  ASSERT_EQ(written_messages.size(), 2 * kNumMessagesToWrite);
+  for (const auto & msg : written_messages) {
+    EXPECT_EQ(msg->topic_id, msg->topic_name == "topic_a" ? topic_a_id : topic_b_id);
+  }
+
+  // An id which was not assigned to the topic of the message is rejected
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "topic_a";
+  message->topic_id = topic_b_id;
+  EXPECT_THROW(writer_->write(message), std::runtime_error);
+
+  writer_.reset();
+  ASSERT_FALSE(v_intercepted_update_metadata_.empty());
+  const auto & metadata = v_intercepted_update_metadata_.back();
+  EXPECT_EQ(metadata.message_count, 2 * kNumMessagesToWrite);
+  ASSERT_EQ(metadata.topics_with_message_count.size(), 2u);
+  for (const auto & topic : metadata.topics_with_message_count) {
+    EXPECT_EQ(topic.message_count, kNumMessagesToWrite);
+  }
+}
+
 TEST_F(SequentialWriterTest, snapshot_mode_write_on_trigger)
 {
   storage_options_.max_bagfile_size = 0;
-  storage_options_.max_cache_size = 200;
+  storage_options_.max_cache_size = 4000;
   storage_options_.snapshot_mode = true;
 
   // Expect a single write call when the snapshot is triggered
@@ -536,7 +850,7 @@ TEST_F(SequentialWriterTest, snapshot_mode_write_on_trigger)
 TEST_F(SequentialWriterTest, snapshot_mode_not_triggered_no_storage_write)
 {
   storage_options_.max_bagfile_size = 0;
-  storage_options_.max_cache_size = 200;
+  storage_options_.max_cache_size = 4000;
   storage_options_.snapshot_mode = true;
 
   // Storage should never be written to when snapshot mode is enabled
@@ -568,6 +882,98 @@ TEST_F(SequentialWriterTest, snapshot_mode_not_triggered_no_storage_write)
   }
 }
 
+TEST_F(SequentialWriterTest, snapshot_mode_writes_every_snapshot_to_its_own_file)
+{
+  storage_options_.max_bagfile_size = 0;
+  storage_options_.max_cache_size = 4000;
+  storage_options_.snapshot_mode = true;
+
+  std::vector<size_t> written_snapshot_sizes;
+  std::mutex written_snapshot_sizes_mutex;
+  ON_CALL(
+    *storage_, write(
+      An
+      <const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &>()))
+  .WillByDefault(
+    [&](const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & msgs) {
+      std::lock_guard<std::mutex> lock(written_snapshot_sizes_mutex);
+      written_snapshot_sizes.push_back(msgs.size());
+    });
+  rosbag2_storage::BagMetadata metadata;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&metadata](const std::string &, const rosbag2_storage::BagMetadata & written_metadata) {
+      metadata = written_metadata;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+
+  for (int64_t time_stamp = 1; time_stamp <= 3; ++time_stamp) {
+    auto message = make_test_msg();
+    message->time_stamp = time_stamp;
+    writer_->write(message);
+    // Snapshots are taken again before the previous ones are written, and overlap
+    writer_->take_snapshot();
+  }
+  writer_.reset();
+
+  EXPECT_THAT(written_snapshot_sizes, ElementsAre(1u, 2u, 3u));
+  ASSERT_THAT(metadata.files, SizeIs(3u));
+  EXPECT_EQ(metadata.files[1].message_count, 2u);
+  EXPECT_EQ(metadata.files[1].starting_time.time_since_epoch().count(), 1);
+  EXPECT_EQ(metadata.files[1].duration.count(), 1);
+  EXPECT_EQ(metadata.starting_time.time_since_epoch().count(), 1);
+  EXPECT_EQ(metadata.duration.count(), 2);
+  EXPECT_EQ(metadata.message_count, 6u);
+}
+
+TEST_F(SequentialWriterTest, snapshot_mode_writes_post_trigger_messages_to_snapshot_file)
+{
+  storage_options_.max_bagfile_size = 0;
+  storage_options_.max_cache_size = 4000;
+  storage_options_.snapshot_mode = true;
+  storage_options_.snapshot_post_trigger_duration_ms = 1;
+
+  rosbag2_storage::BagMetadata metadata;
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [&metadata](const std::string &, const rosbag2_storage::BagMetadata & written_metadata) {
+      metadata = written_metadata;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  writer_->open(storage_options_, {rmw_format, rmw_format});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+
+  const int64_t post_trigger_duration_ns = 1000000;
+  auto write_at = [this](int64_t time_stamp) {
+      auto message = make_test_msg();
+      message->time_stamp = time_stamp;
+      writer_->write(message);
+    };
+  write_at(1);
+  writer_->take_snapshot();
+  write_at(2);
+  write_at(1 + post_trigger_duration_ns);
+  // Only written to the next snapshot
+  write_at(2 + post_trigger_duration_ns);
+  writer_.reset();
+
+  ASSERT_THAT(metadata.files, SizeIs(1u));
+  EXPECT_EQ(metadata.files[0].message_count, 3u);
+  EXPECT_EQ(metadata.files[0].starting_time.time_since_epoch().count(), 1);
+  EXPECT_EQ(metadata.files[0].duration.count(), post_trigger_duration_ns);
+  EXPECT_EQ(metadata.message_count, 3u);
+}
+
 TEST_F(SequentialWriterTest, snapshot_mode_zero_cache_size_throws_exception)
 {
   storage_options_.max_bagfile_size = 0;
@@ -582,6 +988,19 @@ TEST_F(SequentialWriterTest, snapshot_mode_zero_cache_size_throws_exception)
   EXPECT_THROW(writer_->open(storage_options_, {rmw_format, rmw_format}), std::runtime_error);
 }
 
+TEST_F(SequentialWriterTest, cache_shard_policies_without_sharded_cache_throws_exception)
+{
+  storage_options_.max_cache_size = 100;
+  storage_options_.cache_shard_policies = {{"camera", "drop_oldest"}};
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::string rmw_format = "rmw_format";
+  EXPECT_THROW(writer_->open(storage_options_, {rmw_format, rmw_format}), std::runtime_error);
+}
+
 TEST_F(SequentialWriterTest, split_event_calls_callback)
 {
   const int message_count = 7;
@@ -642,6 +1061,199 @@ TEST_F(SequentialWriterTest, split_event_calls_callback)
   EXPECT_EQ(opened_file, fake_storage_uri_);
 }
 
+TEST_F(SequentialWriterTest, split_event_reports_statistics_of_closed_file)
+{
+  const int message_count = 7;
+  const int max_bagfile_size = 5;
+
+  ON_CALL(
+    *storage_,
+    write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+    [this](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {
+      fake_storage_size_ += 1;
+    });
+  ON_CALL(*storage_, get_bagfile_size).WillByDefault(
+    [this]() {
+      return fake_storage_size_.load();
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  storage_options_.max_bagfile_size = max_bagfile_size;
+
+  std::vector<rosbag2_cpp::bag_events::BagFileStatistics> closed_file_statistics;
+  rosbag2_cpp::bag_events::WriterEventCallbacks callbacks;
+  callbacks.write_split_callback =
+    [&closed_file_statistics](rosbag2_cpp::bag_events::BagSplitInfo & info) {
+      closed_file_statistics.push_back(info.closed_file_statistics);
+    };
+  writer_->add_event_callbacks(callbacks);
+
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+
+  for (auto i = 0; i < message_count; ++i) {
+    writer_->write(make_test_msg());
+  }
+  writer_->close();
+
+  // The second file is closed by close()
+  ASSERT_EQ(closed_file_statistics.size(), 2u);
+  const auto & statistics = closed_file_statistics[0];
+  EXPECT_EQ(statistics.size, static_cast<uint64_t>(max_bagfile_size));
+  EXPECT_EQ(statistics.message_count, static_cast<uint64_t>(max_bagfile_size));
+  EXPECT_LE(statistics.write_latency_p50, statistics.write_latency_p99);
+  EXPECT_LE(statistics.write_latency_p99, statistics.write_latency_max);
+  EXPECT_EQ(statistics.dropped_message_count, 0u);
+  EXPECT_EQ(statistics.compression_ratio, 0.0);
+  EXPECT_EQ(
+    closed_file_statistics[1].message_count,
+    static_cast<uint64_t>(message_count - max_bagfile_size));
+}
+
+TEST_F(SequentialWriterTest, async_split_opens_next_file_ahead_and_closes_previous_in_background)
+{
+  const int message_count = 15;
+  const int max_bagfile_size = 5;
+
+  // Every bag file gets a storage of its own, which tracks its size and whether it was closed
+  std::mutex mutex;
+  std::vector<std::string> opened_uris;
+  std::vector<std::string> closed_uris;
+  ON_CALL(*storage_factory_, open_read_write(_)).WillByDefault(
+    [&](const rosbag2_storage::StorageOptions & storage_options) {
+      auto storage = std::shared_ptr<NiceMock<MockStorage>>(
+        new NiceMock<MockStorage>(),
+        [&mutex, &closed_uris, uri = storage_options.uri](MockStorage * storage) {
+          std::lock_guard<std::mutex> lock(mutex);
+          closed_uris.push_back(uri);
+          delete storage;
+        });
+      auto size = std::make_shared<std::atomic<uint64_t>>(0);
+      ON_CALL(
+        *storage,
+        write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+        [size](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {(*size)++;});
+      ON_CALL(*storage, get_bagfile_size).WillByDefault([size]() {return size->load();});
+      ON_CALL(*storage, get_relative_file_path).WillByDefault(Return(storage_options.uri));
+      std::lock_guard<std::mutex> lock(mutex);
+      opened_uris.push_back(storage_options.uri);
+      return storage;
+    });
+
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [this](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      fake_metadata_ = metadata;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  std::vector<std::pair<std::string, std::string>> split_files;
+  rosbag2_cpp::bag_events::WriterEventCallbacks callbacks;
+  callbacks.write_split_callback =
+    [&](rosbag2_cpp::bag_events::BagSplitInfo & info) {
+      std::lock_guard<std::mutex> lock(mutex);
+      // The previous file is closed before the event
+      EXPECT_NE(
+        std::find(closed_uris.begin(), closed_uris.end(), info.closed_file), closed_uris.end());
+      split_files.emplace_back(info.closed_file, info.opened_file);
+    };
+  writer_->add_event_callbacks(callbacks);
+
+  storage_options_.max_bagfile_size = max_bagfile_size;
+  storage_options_.async_split = true;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  for (auto i = 0; i < message_count; ++i) {
+    writer_->write(message);
+  }
+  writer_->close();
+  writer_.reset();
+
+  const auto bag_file = [this](int index) {
+      return (rcpputils::fs::path(storage_options_.uri) /
+             (storage_options_.uri + "_" + std::to_string(index))).string();
+    };
+  EXPECT_EQ(fake_metadata_.relative_file_paths.size(), 3u);
+  EXPECT_EQ(fake_metadata_.message_count, static_cast<uint64_t>(message_count));
+  // The standby storage for a fourth file was opened ahead of time, but never used
+  EXPECT_EQ(opened_uris, std::vector<std::string>({bag_file(0), bag_file(1), bag_file(2),
+      bag_file(3)}));
+  EXPECT_EQ(closed_uris.size(), opened_uris.size());
+  ASSERT_EQ(split_files.size(), 3u);
+  EXPECT_EQ(split_files[0], std::make_pair(bag_file(0), bag_file(1)));
+  EXPECT_EQ(split_files[1], std::make_pair(bag_file(1), bag_file(2)));
+  EXPECT_EQ(split_files[2].first, bag_file(2));
+}
+
+TEST_F(SequentialWriterTest, retention_budget_deletes_oldest_closed_files_and_their_metadata)
+{
+  const int message_count = 20;
+  const int max_bagfile_size = 5;
+
+  // Every bag file gets a storage of its own, which creates the file and tracks its size
+  ON_CALL(*storage_factory_, open_read_write(_)).WillByDefault(
+    [](const rosbag2_storage::StorageOptions & storage_options) {
+      std::ofstream(storage_options.uri).put('x');
+      auto storage = std::make_shared<NiceMock<MockStorage>>();
+      auto size = std::make_shared<uint64_t>(0);
+      ON_CALL(
+        *storage,
+        write(An<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>())).WillByDefault(
+        [size](std::shared_ptr<const rosbag2_storage::SerializedBagMessage>) {(*size)++;});
+      ON_CALL(*storage, get_bagfile_size).WillByDefault([size]() {return *size;});
+      ON_CALL(*storage, get_relative_file_path).WillByDefault(Return(storage_options.uri));
+      return storage;
+    });
+  ON_CALL(*metadata_io_, write_metadata).WillByDefault(
+    [this](const std::string &, const rosbag2_storage::BagMetadata & metadata) {
+      fake_metadata_ = metadata;
+    });
+
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  storage_options_.max_bagfile_size = max_bagfile_size;
+  // Two closed files fit into the budget
+  storage_options_.max_bag_retention_size = 2 * max_bagfile_size;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = "test_topic";
+  for (auto i = 0; i < message_count; ++i) {
+    writer_->write(message);
+  }
+  writer_->close();
+
+  const auto bag_file = [this](int index) {
+      return storage_options_.uri + "_" + std::to_string(index);
+    };
+  EXPECT_THAT(
+    fake_metadata_.relative_file_paths, ElementsAre(bag_file(1), bag_file(2), bag_file(3)));
+  ASSERT_THAT(fake_metadata_.files, SizeIs(3));
+  EXPECT_EQ(fake_metadata_.files.front().path, bag_file(1));
+  EXPECT_EQ(fake_metadata_.message_count, static_cast<uint64_t>(message_count - max_bagfile_size));
+  ASSERT_THAT(fake_metadata_.topics_with_message_count, SizeIs(1));
+  EXPECT_EQ(
+    fake_metadata_.topics_with_message_count[0].message_count,
+    static_cast<size_t>(message_count - max_bagfile_size));
+
+  const rcpputils::fs::path bag_directory(storage_options_.uri);
+  EXPECT_FALSE((bag_directory / bag_file(0)).exists());
+  for (int index = 1; index <= 3; ++index) {
+    EXPECT_TRUE((bag_directory / bag_file(index)).exists());
+  }
+}
+
 TEST_F(SequentialWriterTest, split_event_calls_on_writer_close)
 {
   const int message_count = 7;
@@ -702,6 +1314,37 @@ TEST_F(SequentialWriterTest, split_event_calls_on_writer_close)
   EXPECT_TRUE(opened_file.empty());
 }
 
+TEST_F(SequentialWriterTest, writes_preview_of_the_bag_on_close_if_enabled)
+{
+  auto sequential_writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>(
+    std::move(storage_factory_), converter_factory_, std::move(metadata_io_));
+  writer_ = std::make_unique<rosbag2_cpp::Writer>(std::move(sequential_writer));
+
+  storage_options_.preview_bucket_duration_ms = 1;
+  storage_options_.preview_sample_topics = {"test_topic"};
+  storage_options_.preview_sample_interval = 2;
+  writer_->open(storage_options_, {"rmw_format", "rmw_format"});
+  writer_->create_topic({"test_topic", "test_msgs/BasicTypes", "", {}, ""});
+  for (rcutils_time_point_value_t time_stamp : {0, 500000, 1500000}) {
+    auto message = make_test_msg();
+    message->time_stamp = time_stamp;
+    writer_->write(message);
+  }
+  EXPECT_FALSE(rosbag2_cpp::BagPreview::exists(storage_options_.uri));
+  writer_->close();
+
+  ASSERT_TRUE(rosbag2_cpp::BagPreview::exists(storage_options_.uri));
+  const auto preview = rosbag2_cpp::BagPreview::read(storage_options_.uri);
+  EXPECT_EQ(preview.bucket_duration(), RCUTILS_MS_TO_NS(1));
+  const auto & topic = preview.topics().at("test_topic");
+  EXPECT_EQ(topic.message_count, 3u);
+  ASSERT_EQ(topic.buckets.size(), 2u);
+  EXPECT_EQ(topic.buckets.at(0).message_count, 2u);
+  EXPECT_EQ(topic.buckets.at(RCUTILS_MS_TO_NS(1)).message_count, 1u);
+  ASSERT_EQ(topic.samples.size(), 2u);
+  EXPECT_EQ(topic.samples[1].time_stamp, 1500000);
+}
+
 TEST_P(ParametrizedTemporaryDirectoryFixture, split_bag_metadata_has_full_duration) {
   const std::vector<std::pair<rcutils_time_point_value_t, uint32_t>> fake_messages {
     {100, 1},
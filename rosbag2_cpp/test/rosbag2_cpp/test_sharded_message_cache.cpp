@@ -0,0 +1,253 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_cpp/cache/cache_consumer.hpp"
+#include "rosbag2_cpp/cache/message_memory.hpp"
+#include "rosbag2_cpp/cache/sharded_message_cache.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_cpp::cache::CacheOverflowPolicy;
+
+namespace
+{
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_test_msg(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp = 0)
+{
+  // Every test message holds the same memory, topic names are short enough to not allocate
+  std::string msg_content = "Hello0";
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  message->serialized_data = rosbag2_storage::make_serialized_message(
+    msg_content.c_str(), msg_content.length());
+  return message;
+}
+
+size_t message_bytes()
+{
+  return rosbag2_cpp::cache::get_message_memory_bytes(*make_test_msg("/topic"));
+}
+
+class TestShardedMessageCache : public rosbag2_cpp::cache::ShardedMessageCache
+{
+public:
+  using rosbag2_cpp::cache::ShardedMessageCache::ShardedMessageCache;
+
+  uint32_t dropped(const std::string & topic_name) const
+  {
+    auto dropped_per_topic = get_messages_dropped_per_topic();
+    auto it = dropped_per_topic.find(topic_name);
+    return it == dropped_per_topic.end() ? 0u : it->second;
+  }
+};
+
+std::vector<std::string> consume_topic_names(rosbag2_cpp::cache::ShardedMessageCache & cache)
+{
+  std::vector<std::string> topic_names;
+  cache.swap_buffers();
+  auto consumer_buffer = cache.get_consumer_buffer();
+  for (const auto & msg : consumer_buffer->data()) {
+    topic_names.push_back(msg->topic_name);
+  }
+  consumer_buffer->clear();
+  cache.release_consumer_buffer();
+  return topic_names;
+}
+}  // namespace
+
+TEST(ShardedMessageCacheTest, full_shard_does_not_drop_messages_of_other_topics) {
+  TestShardedMessageCache cache(10 * message_bytes(), true);
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    cache.push(make_test_msg("/points"));
+  }
+  for (uint32_t i = 0; i < 5; ++i) {
+    cache.push(make_test_msg("/tf"));
+  }
+
+  EXPECT_EQ(cache.get_shard_count(), 2u);
+  EXPECT_EQ(cache.dropped("/points"), 90u);
+  EXPECT_EQ(cache.dropped("/tf"), 0u);
+
+  auto topic_names = consume_topic_names(cache);
+  EXPECT_EQ(topic_names.size(), 15u);
+  EXPECT_EQ(std::count(topic_names.begin(), topic_names.end(), "/tf"), 5);
+}
+
+TEST(ShardedMessageCacheTest, topic_groups_share_a_shard_with_its_own_budget) {
+  std::unordered_map<std::string, std::vector<std::string>> topic_groups{
+    {"low_rate", {"/tf", "/diagnostics"}}
+  };
+  std::unordered_map<std::string, uint64_t> shard_sizes{{"low_rate", 2 * message_bytes()}};
+  TestShardedMessageCache cache(100 * message_bytes(), false, topic_groups, shard_sizes);
+
+  EXPECT_EQ(cache.get_shard_name("/tf"), "low_rate");
+  EXPECT_EQ(cache.get_shard_name("/diagnostics"), "low_rate");
+  EXPECT_EQ(
+    cache.get_shard_name("/points"),
+    rosbag2_cpp::cache::ShardedMessageCache::kDefaultShardName);
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    cache.push(make_test_msg("/tf"));
+    cache.push(make_test_msg("/diagnostics"));
+    cache.push(make_test_msg("/points"));
+    cache.push(make_test_msg("/imu"));
+  }
+
+  EXPECT_EQ(cache.get_shard_count(), 2u);
+  EXPECT_EQ(cache.dropped("/tf") + cache.dropped("/diagnostics"), 4u);
+  EXPECT_EQ(cache.dropped("/points"), 0u);
+  EXPECT_EQ(cache.dropped("/imu"), 0u);
+  EXPECT_EQ(consume_topic_names(cache).size(), 8u);
+}
+
+TEST(ShardedMessageCacheTest, swap_buffers_merges_shards_by_time_stamp) {
+  TestShardedMessageCache cache(100 * message_bytes(), true);
+
+  cache.push(make_test_msg("/a", 1));
+  cache.push(make_test_msg("/a", 4));
+  cache.push(make_test_msg("/b", 2));
+  cache.push(make_test_msg("/b", 3));
+  cache.push(make_test_msg("/c", 0));
+
+  auto topic_names = consume_topic_names(cache);
+  EXPECT_THAT(topic_names, ElementsAre("/c", "/a", "/b", "/b", "/a"));
+}
+
+TEST(ShardedMessageCacheTest, consumer_writes_all_shards) {
+  const uint32_t messages_per_topic = 200;
+  const std::vector<std::string> topics{"/a", "/b", "/c", "/d"};
+  auto cache = std::make_shared<rosbag2_cpp::cache::ShardedMessageCache>(1024 * 1024, true);
+
+  std::atomic<size_t> consumed{0};
+  auto consumer = std::make_unique<rosbag2_cpp::cache::CacheConsumer>(
+    cache,
+    [&consumed](const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> &
+    msgs) {
+      consumed += msgs.size();
+    });
+
+  std::vector<std::thread> producers;
+  for (const auto & topic : topics) {
+    producers.emplace_back(
+      [&cache, topic, messages_per_topic]() {
+        for (uint32_t i = 0; i < messages_per_topic; ++i) {
+          cache->push(make_test_msg(topic, i));
+        }
+      });
+  }
+  for (auto & producer : producers) {
+    producer.join();
+  }
+  consumer.reset();
+
+  EXPECT_EQ(consumed.load(), messages_per_topic * topics.size());
+}
+
+TEST(ShardedMessageCacheTest, drop_oldest_shard_keeps_the_newest_messages) {
+  std::unordered_map<std::string, CacheOverflowPolicy> shard_policies{
+    {"/points", CacheOverflowPolicy::DROP_OLDEST}
+  };
+  TestShardedMessageCache cache(10 * message_bytes(), true, {}, {}, shard_policies);
+  EXPECT_EQ(cache.get_shard_policy("/points"), CacheOverflowPolicy::DROP_OLDEST);
+  EXPECT_EQ(cache.get_shard_policy("/tf"), CacheOverflowPolicy::DROP_NEWEST);
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    cache.push(make_test_msg("/points", i));
+    cache.push(make_test_msg("/tf", i));
+  }
+  EXPECT_EQ(cache.dropped("/points"), 90u);
+  EXPECT_EQ(cache.dropped("/tf"), 90u);
+
+  cache.swap_buffers();
+  auto consumer_buffer = cache.get_consumer_buffer();
+  std::vector<rcutils_time_point_value_t> points_time_stamps;
+  std::vector<rcutils_time_point_value_t> tf_time_stamps;
+  for (const auto & msg : consumer_buffer->data()) {
+    auto & time_stamps = msg->topic_name == "/points" ? points_time_stamps : tf_time_stamps;
+    time_stamps.push_back(msg->time_stamp);
+  }
+  consumer_buffer->clear();
+  cache.release_consumer_buffer();
+  EXPECT_THAT(points_time_stamps, ElementsAre(90, 91, 92, 93, 94, 95, 96, 97, 98, 99));
+  EXPECT_THAT(tf_time_stamps, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+TEST(ShardedMessageCacheTest, block_shard_waits_for_the_consumer) {
+  const uint32_t num_messages = 50;
+  std::unordered_map<std::string, CacheOverflowPolicy> shard_policies{
+    {"/points", CacheOverflowPolicy::BLOCK}
+  };
+  TestShardedMessageCache cache(2 * message_bytes(), true, {}, {}, shard_policies);
+
+  std::thread producer(
+    [&cache, num_messages]() {
+      for (uint32_t i = 0; i < num_messages; ++i) {
+        cache.push(make_test_msg("/points", i));
+      }
+    });
+  size_t consumed = 0;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (consumed < num_messages && std::chrono::steady_clock::now() < deadline) {
+    cache.wait_for_data_until(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    consumed += consume_topic_names(cache).size();
+  }
+  producer.join();
+
+  EXPECT_EQ(consumed, num_messages);
+  EXPECT_EQ(cache.dropped("/points"), 0u);
+  EXPECT_GT(cache.get_time_blocked().count(), 0);
+}
+
+TEST(ShardedMessageCacheTest, block_shard_drops_after_timeout) {
+  std::unordered_map<std::string, CacheOverflowPolicy> shard_policies{
+    {"/points", CacheOverflowPolicy::BLOCK}
+  };
+  TestShardedMessageCache cache(
+    2 * message_bytes(), true, {}, {}, shard_policies, CacheOverflowPolicy::DROP_NEWEST,
+    std::chrono::milliseconds(10));
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    cache.push(make_test_msg("/points", i));
+  }
+  EXPECT_EQ(cache.dropped("/points"), 1u);
+  EXPECT_EQ(consume_topic_names(cache).size(), 2u);
+}
+
+TEST(ShardedMessageCacheTest, spill_to_disk_is_rejected) {
+  EXPECT_THROW(
+    TestShardedMessageCache(
+      1024, true, {}, {}, {}, CacheOverflowPolicy::SPILL_TO_DISK),
+    std::invalid_argument);
+  std::unordered_map<std::string, CacheOverflowPolicy> shard_policies{
+    {"/points", CacheOverflowPolicy::SPILL_TO_DISK}
+  };
+  EXPECT_THROW(
+    TestShardedMessageCache(1024, true, {}, {}, shard_policies), std::invalid_argument);
+}
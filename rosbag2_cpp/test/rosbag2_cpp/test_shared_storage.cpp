@@ -0,0 +1,267 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/readers/shared_storage.hpp"
+
+using namespace testing;  // NOLINT
+
+using rosbag2_cpp::readers::SharedStorage;
+using rosbag2_cpp::readers::StorageCursor;
+
+namespace
+{
+// Storage of messages in memory, sorted by time stamp, which counts how often it is read
+class FakeStorage : public rosbag2_storage::storage_interfaces::ReadOnlyInterface
+{
+public:
+  explicit FakeStorage(std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages)
+  : messages_(std::move(messages))
+  {}
+
+  void open(const rosbag2_storage::StorageOptions &, rosbag2_storage::storage_interfaces::IOFlag)
+  override {}
+
+  rosbag2_storage::BagMetadata get_metadata() override
+  {
+    rosbag2_storage::BagMetadata metadata;
+    metadata.message_count = messages_.size();
+    ++metadata_reads;
+    return metadata;
+  }
+
+  std::string get_relative_file_path() const override {return "fake";}
+  uint64_t get_bagfile_size() const override {return 0;}
+  std::string get_storage_identifier() const override {return "fake";}
+
+  bool set_read_order(const rosbag2_storage::ReadOrder & read_order) override
+  {
+    reverse_ = read_order.reverse;
+    return true;
+  }
+
+  bool has_next() override
+  {
+    return next_index() < messages_.size();
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override
+  {
+    auto message = messages_[next_index()];
+    time_stamp_ = message->time_stamp;
+    ++read_in_time_stamp_;
+    ++message_reads;
+    return message;
+  }
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override
+  {
+    return {{"/a", "type", "cdr", {}, ""}, {"/b", "type", "cdr", {}, ""}};
+  }
+
+  void get_all_message_definitions(std::vector<rosbag2_storage::MessageDefinition> &) override {}
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override
+  {
+    topics_ = storage_filter.topics;
+  }
+
+  void reset_filter() override
+  {
+    topics_.clear();
+  }
+
+  void seek(const rcutils_time_point_value_t & timestamp) override
+  {
+    time_stamp_ = timestamp;
+    read_in_time_stamp_ = 0;
+    ++seeks;
+  }
+
+  size_t metadata_reads = 0;
+  size_t message_reads = 0;
+  size_t seeks = 0;
+
+private:
+  // Index of the next message in read order which matches the filter
+  size_t next_index() const
+  {
+    size_t skipped = 0;
+    for (size_t i = 0; i < messages_.size(); ++i) {
+      const size_t index = reverse_ ? messages_.size() - 1 - i : i;
+      const auto & message = *messages_[index];
+      if (!topics_.empty() &&
+        std::find(topics_.begin(), topics_.end(), message.topic_name) == topics_.end())
+      {
+        continue;
+      }
+      if (reverse_ ? message.time_stamp > time_stamp_ : message.time_stamp < time_stamp_) {
+        continue;
+      }
+      if (message.time_stamp == time_stamp_ && skipped++ < read_in_time_stamp_) {
+        continue;
+      }
+      return index;
+    }
+    return messages_.size();
+  }
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages_;
+  std::vector<std::string> topics_;
+  bool reverse_ = false;
+  rcutils_time_point_value_t time_stamp_ = 0;
+  // Messages read at time_stamp_ since the last seek
+  size_t read_in_time_stamp_ = 0;
+};
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->time_stamp = time_stamp;
+  return message;
+}
+
+std::vector<rcutils_time_point_value_t> read_time_stamps(StorageCursor & cursor, size_t count)
+{
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  while (time_stamps.size() < count && cursor.has_next()) {
+    time_stamps.push_back(cursor.read_next()->time_stamp);
+  }
+  return time_stamps;
+}
+}  // namespace
+
+class SharedStorageTest : public Test
+{
+public:
+  SharedStorageTest()
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    for (rcutils_time_point_value_t time_stamp = 1; time_stamp <= 10; ++time_stamp) {
+      messages.push_back(make_message(time_stamp % 2 == 0 ? "/a" : "/b", time_stamp));
+    }
+    storage_ = std::make_shared<FakeStorage>(std::move(messages));
+    shared_storage_ = std::make_shared<SharedStorage>(storage_);
+  }
+
+  std::shared_ptr<FakeStorage> storage_;
+  std::shared_ptr<SharedStorage> shared_storage_;
+};
+
+TEST_F(SharedStorageTest, cursors_read_independently_from_the_same_storage) {
+  StorageCursor first(shared_storage_, 3);
+  StorageCursor second(shared_storage_, 3);
+
+  EXPECT_THAT(read_time_stamps(first, 4), ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(read_time_stamps(second, 2), ElementsAre(1, 2));
+  EXPECT_THAT(read_time_stamps(first, 10), ElementsAre(5, 6, 7, 8, 9, 10));
+  EXPECT_THAT(read_time_stamps(second, 10), ElementsAre(3, 4, 5, 6, 7, 8, 9, 10));
+  EXPECT_FALSE(first.has_next());
+}
+
+TEST_F(SharedStorageTest, metadata_is_read_once_for_all_cursors) {
+  StorageCursor first(shared_storage_);
+  StorageCursor second(shared_storage_);
+
+  EXPECT_EQ(first.get_metadata().message_count, 10u);
+  EXPECT_EQ(second.get_metadata().message_count, 10u);
+  EXPECT_THAT(second.get_all_topics_and_types(), SizeIs(2u));
+  EXPECT_EQ(storage_->metadata_reads, 1u);
+}
+
+TEST_F(SharedStorageTest, a_cursor_reading_alone_does_not_seek_again) {
+  StorageCursor cursor(shared_storage_, 2);
+
+  EXPECT_THAT(read_time_stamps(cursor, 10), SizeIs(10u));
+  EXPECT_EQ(storage_->message_reads, 10u);
+  EXPECT_EQ(storage_->seeks, 2u);
+}
+
+TEST_F(SharedStorageTest, cursors_keep_their_own_filter_seek_and_order) {
+  StorageCursor filtered(shared_storage_, 2);
+  StorageCursor reverse(shared_storage_, 2);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"/a"};
+  filtered.set_filter(filter);
+  filtered.seek(5);
+  ASSERT_TRUE(reverse.set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::ReceivedTimestamp, true)));
+  reverse.seek(7);
+
+  EXPECT_THAT(read_time_stamps(filtered, 1), ElementsAre(6));
+  EXPECT_THAT(read_time_stamps(reverse, 2), ElementsAre(7, 6));
+  EXPECT_THAT(read_time_stamps(filtered, 10), ElementsAre(8, 10));
+  EXPECT_THAT(read_time_stamps(reverse, 10), ElementsAre(5, 4, 3, 2, 1));
+  EXPECT_FALSE(reverse.set_read_order(rosbag2_storage::ReadOrder(
+      rosbag2_storage::ReadOrder::File, false)));
+}
+
+TEST_F(SharedStorageTest, messages_at_the_same_time_stamp_are_read_once) {
+  auto storage = std::make_shared<FakeStorage>(
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>{
+    make_message("/a", 1), make_message("/b", 1), make_message("/a", 1), make_message("/a", 2)});
+  auto shared_storage = std::make_shared<SharedStorage>(storage);
+  StorageCursor first(shared_storage, 2);
+  StorageCursor second(shared_storage, 1);
+
+  EXPECT_THAT(read_time_stamps(first, 1), ElementsAre(1));
+  EXPECT_THAT(read_time_stamps(second, 1), ElementsAre(1));
+  EXPECT_THAT(read_time_stamps(first, 10), ElementsAre(1, 1, 2));
+  EXPECT_THAT(read_time_stamps(second, 10), ElementsAre(1, 1, 2));
+}
+
+TEST_F(SharedStorageTest, changing_the_filter_continues_after_the_last_returned_message) {
+  StorageCursor cursor(shared_storage_, 5);
+  EXPECT_THAT(read_time_stamps(cursor, 2), ElementsAre(1, 2));
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {"/b"};
+  cursor.set_filter(filter);
+  EXPECT_THAT(read_time_stamps(cursor, 10), ElementsAre(3, 5, 7, 9));
+}
+
+TEST_F(SharedStorageTest, cursors_may_be_used_from_different_threads) {
+  std::vector<std::vector<rcutils_time_point_value_t>> read(4);
+  std::vector<std::thread> threads;
+  for (auto & time_stamps : read) {
+    threads.emplace_back(
+      [this, &time_stamps]() {
+        StorageCursor cursor(shared_storage_, 1);
+        time_stamps = read_time_stamps(cursor, 100);
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (const auto & time_stamps : read) {
+    EXPECT_THAT(time_stamps, ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+  }
+}
+
+TEST_F(SharedStorageTest, closed_cursor_throws) {
+  StorageCursor cursor(shared_storage_);
+  cursor.close();
+  EXPECT_THROW(cursor.has_next(), std::runtime_error);
+  EXPECT_THROW(cursor.open({}, {}), std::runtime_error);
+}
@@ -0,0 +1,183 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/cache/spill_file.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+using namespace testing;  // NOLINT
+
+namespace
+{
+rosbag2_storage::SerializedBagMessage make_test_msg(
+  const std::string & topic_name, const std::string & content, int64_t time_stamp)
+{
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = topic_name;
+  message.time_stamp = time_stamp;
+  message.serialized_data = rosbag2_storage::make_serialized_message(
+    content.c_str(), content.length());
+  return message;
+}
+
+std::string content_of(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+}  // namespace
+
+TEST(SpillFileTest, reads_messages_back_in_order) {
+  rosbag2_cpp::cache::SpillFile spill_file("", 4096);
+  EXPECT_TRUE(spill_file.empty());
+
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", "first", 1)));
+  ASSERT_TRUE(spill_file.append(make_test_msg("/bb", "second message", 2)));
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", "", 3)));
+  EXPECT_EQ(spill_file.size(), 3u);
+  EXPECT_GT(spill_file.get_used_bytes(), 0u);
+
+  auto messages = spill_file.read(1024);
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[0]->topic_name, "/a");
+  EXPECT_EQ(messages[0]->time_stamp, 1);
+  EXPECT_EQ(content_of(*messages[0]), "first");
+  EXPECT_EQ(messages[1]->topic_name, "/bb");
+  EXPECT_EQ(content_of(*messages[1]), "second message");
+  EXPECT_EQ(messages[2]->serialized_data->buffer_length, 0u);
+  EXPECT_TRUE(spill_file.empty());
+  EXPECT_EQ(spill_file.get_used_bytes(), 0u);
+}
+
+TEST(SpillFileTest, keeps_publish_info_of_messages) {
+  rosbag2_cpp::cache::SpillFile spill_file("", 4096);
+  auto message = make_test_msg("/a", "payload", 10);
+  message.topic_id = 2;
+  message.send_timestamp = 7;
+  message.sequence_number = 42;
+  ASSERT_TRUE(spill_file.append(message));
+
+  auto messages = spill_file.read(1024);
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages[0]->time_stamp, 10);
+  EXPECT_EQ(messages[0]->topic_id, 2u);
+  EXPECT_EQ(messages[0]->send_timestamp, 7);
+  EXPECT_EQ(messages[0]->sequence_number, 42u);
+  EXPECT_EQ(content_of(*messages[0]), "payload");
+}
+
+TEST(SpillFileTest, read_stops_after_max_bytes) {
+  rosbag2_cpp::cache::SpillFile spill_file("", 4096);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(spill_file.append(make_test_msg("/a", "0123456789", i)));
+  }
+
+  auto messages = spill_file.read(25);
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages.front()->time_stamp, 0);
+  EXPECT_EQ(spill_file.size(), 7u);
+
+  messages = spill_file.read(1000);
+  ASSERT_EQ(messages.size(), 7u);
+  EXPECT_EQ(messages.front()->time_stamp, 3);
+}
+
+TEST(SpillFileTest, rejects_messages_when_full_and_rewinds_when_drained) {
+  rosbag2_cpp::cache::SpillFile spill_file("", 320);
+  const std::string content(100, 'x');
+
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", content, 0)));
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", content, 1)));
+  EXPECT_FALSE(spill_file.append(make_test_msg("/a", content, 2)));
+  EXPECT_EQ(spill_file.size(), 2u);
+
+  EXPECT_EQ(spill_file.read(1000).size(), 2u);
+  EXPECT_TRUE(spill_file.append(make_test_msg("/a", content, 3)));
+  EXPECT_TRUE(spill_file.append(make_test_msg("/a", content, 4)));
+}
+
+TEST(SpillFileTest, reuses_the_space_of_read_messages_before_it_ran_empty) {
+  rosbag2_cpp::cache::SpillFile spill_file("", 320);
+  const std::string content(100, 'x');
+
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", content, 0)));
+  ASSERT_TRUE(spill_file.append(make_test_msg("/a", content, 1)));
+  ASSERT_EQ(spill_file.read(1).size(), 1u);
+  // Only the space at the end of the file and of the first message is free, the message wraps
+  ASSERT_TRUE(spill_file.append(make_test_msg("/bb", "straddling " + content, 2)));
+  EXPECT_EQ(spill_file.size(), 2u);
+
+  auto messages = spill_file.read(1000);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0]->time_stamp, 1);
+  EXPECT_EQ(content_of(*messages[0]), content);
+  EXPECT_EQ(messages[1]->time_stamp, 2);
+  EXPECT_EQ(messages[1]->topic_name, "/bb");
+  EXPECT_EQ(content_of(*messages[1]), "straddling " + content);
+}
+
+TEST(SpillFileTest, sustained_traffic_through_a_partially_full_file_is_not_dropped) {
+  const size_t capacity = 1000;
+  rosbag2_cpp::cache::SpillFile spill_file("", capacity);
+  auto content = [](int64_t index) {
+      // Varying lengths make records wrap at varying positions, also within their headers
+      return std::string(static_cast<size_t>(index % 37), static_cast<char>('a' + index % 26));
+    };
+
+  int64_t appended = 0;
+  int64_t read = 0;
+  size_t traffic_bytes = 0;
+  while (traffic_bytes < 20 * capacity) {
+    // Fill the file up to about half of its capacity, then read a few messages
+    while (spill_file.get_used_bytes() < capacity / 2) {
+      auto message = make_test_msg(
+        "/topic" + std::to_string(appended % 3), content(appended), appended);
+      ASSERT_TRUE(spill_file.append(message)) << "message " << appended << " was dropped";
+      traffic_bytes += message.serialized_data->buffer_length + message.topic_name.size();
+      ++appended;
+    }
+    ASSERT_FALSE(spill_file.empty());
+    for (const auto & message : spill_file.read(capacity / 8)) {
+      EXPECT_EQ(message->time_stamp, read);
+      EXPECT_EQ(message->topic_name, "/topic" + std::to_string(read % 3));
+      EXPECT_EQ(content_of(*message), content(read));
+      ++read;
+    }
+  }
+  EXPECT_EQ(static_cast<int64_t>(spill_file.size()), appended - read);
+
+  for (const auto & message : spill_file.read(capacity)) {
+    EXPECT_EQ(message->time_stamp, read);
+    EXPECT_EQ(content_of(*message), content(read));
+    ++read;
+  }
+  EXPECT_EQ(read, appended);
+  EXPECT_TRUE(spill_file.empty());
+  EXPECT_EQ(spill_file.get_used_bytes(), 0u);
+}
+
+TEST(SpillFileTest, throws_for_invalid_directory) {
+  EXPECT_THROW(
+    rosbag2_cpp::cache::SpillFile("/this/directory/does/not/exist", 4096), std::runtime_error);
+}
@@ -0,0 +1,249 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/readers/merging_reader.hpp"
+#include "rosbag2_cpp/writers/striped_writer.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_metadata_io.hpp"
+
+using namespace testing;  // NOLINT
+using namespace std::chrono_literals;  // NOLINT
+
+using rosbag2_cpp::writers::StripedWriter;
+
+namespace
+{
+
+class FakeStripeWriter : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  explicit FakeStripeWriter(std::vector<std::string> * written_topics)
+  : written_topics_(written_topics) {}
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const rosbag2_cpp::ConverterOptions &) override
+  {
+    uri = storage_options.uri;
+  }
+
+  void close() override {}
+
+  void create_topic(const rosbag2_storage::TopicMetadata &) override {}
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata &, const rosbag2_storage::MessageDefinition &) override {}
+
+  void remove_topic(const rosbag2_storage::TopicMetadata &) override {}
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override
+  {
+    written_topics_->push_back(message->topic_name);
+  }
+
+  bool take_snapshot() override {return false;}
+
+  void split_bagfile() override {}
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::WriterEventCallbacks &) override {}
+
+  std::string uri;
+
+private:
+  std::vector<std::string> * written_topics_;
+};
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+  const std::string & topic_name, size_t size)
+{
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topic_name;
+  message->serialized_data = rosbag2_storage::make_empty_serialized_message(size);
+  message->serialized_data->buffer_length = size;
+  return message;
+}
+
+rosbag2_storage::FileInformation make_file(
+  const std::string & path, std::chrono::nanoseconds start, std::chrono::nanoseconds duration,
+  size_t message_count)
+{
+  rosbag2_storage::FileInformation file_info;
+  file_info.path = path;
+  file_info.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(start);
+  file_info.duration = duration;
+  file_info.message_count = message_count;
+  return file_info;
+}
+
+}  // namespace
+
+class StripedWriterTest : public rosbag2_test_common::TemporaryDirectoryFixture
+{
+public:
+  StripedWriterTest()
+  : bag_uri_((std::filesystem::path(temporary_dir_path_) / "bag").string()),
+    outside_directory_((std::filesystem::path(temporary_dir_path_) / "other_disk").string()),
+    written_topics_(2)
+  {
+    ON_CALL(*metadata_io_, read_metadata(_)).WillByDefault(
+      [this](const std::string & uri) {
+        rosbag2_storage::BagMetadata metadata;
+        metadata.storage_identifier = "fake_storage";
+        rosbag2_storage::TopicInformation topic_info;
+        topic_info.topic_metadata.name = "/shared";
+        if (uri == StripedWriter::get_stripe_uri(bag_uri_, bag_uri_, 0)) {
+          metadata.files.push_back(make_file("bag_stripe_0_0.fake", 10s, 10s, 3));
+          metadata.files.push_back(make_file("bag_stripe_0_1.fake", 20s, 0s, 0));
+          metadata.bag_size = 100;
+          topic_info.message_count = 3;
+        } else {
+          metadata.files.push_back(make_file("bag_stripe_1_0.fake", 5s, 10s, 2));
+          metadata.bag_size = 50;
+          topic_info.message_count = 2;
+        }
+        metadata.topics_with_message_count.push_back(topic_info);
+        return metadata;
+      });
+  }
+
+  std::unique_ptr<StripedWriter> make_writer(
+    StripedWriter::StripeBy stripe_by = StripedWriter::StripeBy::TOPIC, size_t batch_bytes = 1)
+  {
+    auto next_stripe = std::make_shared<size_t>(0);
+    return std::make_unique<StripedWriter>(
+      std::vector<std::string>{bag_uri_, outside_directory_},
+      [this, next_stripe]() {
+        return std::make_unique<FakeStripeWriter>(&written_topics_[(*next_stripe)++]);
+      },
+      stripe_by, batch_bytes, std::move(metadata_io_owner_));
+  }
+
+  void open(StripedWriter & writer)
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = bag_uri_;
+    writer.open(storage_options, {"", ""});
+  }
+
+  std::string bag_uri_;
+  std::string outside_directory_;
+  std::vector<std::vector<std::string>> written_topics_;
+  std::unique_ptr<NiceMock<MockMetadataIo>> metadata_io_owner_ =
+    std::make_unique<NiceMock<MockMetadataIo>>();
+  NiceMock<MockMetadataIo> * metadata_io_ = metadata_io_owner_.get();
+};
+
+TEST_F(StripedWriterTest, writes_all_messages_of_a_topic_to_one_stripe) {
+  auto writer = make_writer();
+  open(*writer);
+  const std::vector<std::string> topics{"/a", "/b", "/c", "/d", "/e", "/f"};
+  for (int round = 0; round < 3; ++round) {
+    for (const auto & topic : topics) {
+      writer->write(make_message(topic, 4));
+    }
+  }
+  writer->close();
+
+  EXPECT_EQ(written_topics_[0].size() + written_topics_[1].size(), 18u);
+  for (const auto & topic : topics) {
+    const auto in_first = std::count(written_topics_[0].begin(), written_topics_[0].end(), topic);
+    const auto in_second = std::count(written_topics_[1].begin(), written_topics_[1].end(), topic);
+    EXPECT_TRUE((in_first == 3 && in_second == 0) || (in_first == 0 && in_second == 3)) << topic;
+  }
+}
+
+TEST_F(StripedWriterTest, writes_batches_to_stripes_in_turns) {
+  auto writer = make_writer(StripedWriter::StripeBy::BATCH, 8);
+  open(*writer);
+  for (int i = 0; i < 8; ++i) {
+    writer->write(make_message("/topic_" + std::to_string(i), 4));
+  }
+  writer->close();
+
+  EXPECT_THAT(written_topics_[0], ElementsAre("/topic_0", "/topic_1", "/topic_4", "/topic_5"));
+  EXPECT_THAT(written_topics_[1], ElementsAre("/topic_2", "/topic_3", "/topic_6", "/topic_7"));
+}
+
+TEST_F(StripedWriterTest, merges_metadata_of_stripes_on_close) {
+  rosbag2_storage::BagMetadata written_metadata;
+  EXPECT_CALL(*metadata_io_, write_metadata(bag_uri_, _)).WillOnce(SaveArg<1>(&written_metadata));
+  auto writer = make_writer();
+  open(*writer);
+  EXPECT_TRUE(std::filesystem::is_directory(bag_uri_));
+  writer->close();
+
+  const auto outside_stripe = std::filesystem::absolute(
+    StripedWriter::get_stripe_uri(outside_directory_, bag_uri_, 1));
+  ASSERT_THAT(written_metadata.files, SizeIs(2));
+  EXPECT_EQ(written_metadata.files[0].path, (outside_stripe / "bag_stripe_1_0.fake").string());
+  EXPECT_EQ(
+    written_metadata.files[1].path,
+    (std::filesystem::path("bag_stripe_0") / "bag_stripe_0_0.fake").string());
+  EXPECT_THAT(
+    written_metadata.relative_file_paths,
+    ElementsAre(written_metadata.files[0].path, written_metadata.files[1].path));
+  EXPECT_EQ(written_metadata.message_count, 5u);
+  EXPECT_EQ(written_metadata.bag_size, 150u);
+  ASSERT_THAT(written_metadata.topics_with_message_count, SizeIs(1));
+  EXPECT_EQ(written_metadata.topics_with_message_count[0].message_count, 5u);
+  EXPECT_EQ(written_metadata.starting_time.time_since_epoch(), 5s);
+  EXPECT_EQ(written_metadata.duration, 15s);
+  EXPECT_TRUE(rosbag2_cpp::readers::MergingReader::files_overlap(written_metadata));
+}
+
+TEST_F(StripedWriterTest, writes_stripes_of_empty_directories_into_the_bag_directory) {
+  std::vector<FakeStripeWriter *> shards;
+  StripedWriter writer(
+    std::vector<std::string>(3, ""),
+    [this, &shards]() {
+      auto shard = std::make_unique<FakeStripeWriter>(&written_topics_[0]);
+      shards.push_back(shard.get());
+      return shard;
+    },
+    StripedWriter::StripeBy::BATCH, 1, std::move(metadata_io_owner_));
+  open(writer);
+
+  ASSERT_THAT(shards, SizeIs(3));
+  for (size_t i = 0; i < shards.size(); ++i) {
+    EXPECT_EQ(shards[i]->uri, StripedWriter::get_stripe_uri(bag_uri_, bag_uri_, i));
+  }
+}
+
+TEST_F(StripedWriterTest, does_not_overwrite_existing_bag) {
+  std::filesystem::create_directories(bag_uri_);
+  auto writer = make_writer();
+  EXPECT_THROW(open(*writer), std::runtime_error);
+}
+
+TEST(MergingReaderFilesOverlapTest, split_bag_files_do_not_overlap) {
+  rosbag2_storage::BagMetadata metadata;
+  metadata.files.push_back(make_file("bag_0.db3", 0s, 10s, 4));
+  metadata.files.push_back(make_file("bag_1.db3", 10s, 10s, 4));
+  metadata.files.push_back(make_file("bag_2.db3", 3s, 0s, 0));
+  EXPECT_FALSE(rosbag2_cpp::readers::MergingReader::files_overlap(metadata));
+}
@@ -0,0 +1,250 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/readers/tailing_reader.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_metadata_io.hpp"
+#include "mock_storage.hpp"
+#include "mock_storage_factory.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+namespace
+{
+// Messages of a file being recorded, which become readable on the next refresh
+class RecordedFile
+{
+public:
+  RecordedFile()
+  : storage_(std::make_shared<NiceMock<MockStorage>>())
+  {
+    ON_CALL(*storage_, set_read_order(_)).WillByDefault(Return(true));
+    ON_CALL(*storage_, has_next()).WillByDefault(
+      [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !readable_.empty();
+      });
+    ON_CALL(*storage_, read_next()).WillByDefault(
+      [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto message = readable_.front();
+        readable_.pop_front();
+        return message;
+      });
+    ON_CALL(*storage_, refresh()).WillByDefault(
+      [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readable_.insert(readable_.end(), written_.begin(), written_.end());
+        written_.clear();
+        ++refresh_count_;
+        return true;
+      });
+  }
+
+  void write(const std::string & topic_name)
+  {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic_name;
+    std::lock_guard<std::mutex> lock(mutex_);
+    written_.push_back(message);
+  }
+
+  size_t refresh_count()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return refresh_count_;
+  }
+
+  std::shared_ptr<NiceMock<MockStorage>> storage_;
+
+private:
+  std::mutex mutex_;
+  std::deque<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> written_;
+  std::deque<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> readable_;
+  size_t refresh_count_ = 0;
+};
+}  // namespace
+
+class TailingReaderTest : public TemporaryDirectoryFixture
+{
+public:
+  TailingReaderTest()
+  : bag_path_(rcpputils::fs::path(temporary_dir_path_) / "bag")
+  {
+    rcpputils::fs::create_directories(bag_path_);
+  }
+
+  std::string file_path(size_t index) const
+  {
+    return (bag_path_ / ("bag_" + std::to_string(index) + ".mock")).string();
+  }
+
+  std::string create_file(size_t index)
+  {
+    const auto path = file_path(index);
+    std::ofstream(path).put('\0');
+    return path;
+  }
+
+  std::unique_ptr<rosbag2_cpp::readers::TailingReader> make_reader(
+    std::vector<RecordedFile *> files,
+    std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0))
+  {
+    auto storage_factory = std::make_unique<NiceMock<MockStorageFactory>>();
+    ON_CALL(*storage_factory, open_read_only(_)).WillByDefault(
+      [this, files](const rosbag2_storage::StorageOptions & storage_options)
+      -> std::shared_ptr<rosbag2_storage::storage_interfaces::ReadOnlyInterface> {
+        for (size_t i = 0; i < files.size(); ++i) {
+          if (storage_options.uri == file_path(i)) {
+            return files[i]->storage_;
+          }
+        }
+        return nullptr;
+      });
+    auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+    ON_CALL(*metadata_io, metadata_file_exists(_)).WillByDefault(
+      [this](const std::string &) {return recording_finished_.load();});
+    return std::make_unique<rosbag2_cpp::readers::TailingReader>(
+      std::chrono::milliseconds(5), idle_timeout, std::move(storage_factory),
+      std::make_shared<rosbag2_cpp::SerializationFormatConverterFactory>(),
+      std::move(metadata_io));
+  }
+
+  rosbag2_storage::StorageOptions storage_options() const
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = bag_path_.string();
+    storage_options.storage_id = "mock_storage";
+    return storage_options;
+  }
+
+  rcpputils::fs::path bag_path_;
+  std::atomic_bool recording_finished_{false};
+};
+
+TEST_F(TailingReaderTest, has_next_waits_for_messages_written_after_open) {
+  RecordedFile file;
+  create_file(0);
+  auto reader = make_reader({&file});
+  reader->open(storage_options(), {"", ""});
+
+  std::thread recorder([&file, this]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      file.write("topic");
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      file.write("other_topic");
+      recording_finished_ = true;
+    });
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->topic_name, "topic");
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->topic_name, "other_topic");
+  EXPECT_FALSE(reader->has_next());
+  recorder.join();
+  EXPECT_GT(file.refresh_count(), 2u);
+}
+
+TEST_F(TailingReaderTest, follows_the_recorder_to_the_next_file) {
+  RecordedFile first_file;
+  RecordedFile second_file;
+  create_file(0);
+  auto reader = make_reader({&first_file, &second_file});
+  std::string closed_file;
+  std::string opened_file;
+  rosbag2_cpp::bag_events::ReaderEventCallbacks callbacks;
+  callbacks.read_split_callback = [&closed_file, &opened_file](
+    rosbag2_cpp::bag_events::BagSplitInfo & info) {
+      closed_file = info.closed_file;
+      opened_file = info.opened_file;
+    };
+  reader->add_event_callbacks(callbacks);
+  reader->open(storage_options(), {"", ""});
+
+  first_file.write("first");
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->topic_name, "first");
+
+  // The last message of the first file is committed after the next file was created
+  const auto second_path = create_file(1);
+  first_file.write("last_of_first");
+  second_file.write("second");
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->topic_name, "last_of_first");
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->topic_name, "second");
+  EXPECT_EQ(closed_file, file_path(0));
+  EXPECT_EQ(opened_file, second_path);
+  EXPECT_EQ(reader->get_current_file(), second_path);
+  EXPECT_EQ(reader->get_metadata().relative_file_paths.size(), 2u);
+
+  recording_finished_ = true;
+  EXPECT_FALSE(reader->has_next());
+}
+
+TEST_F(TailingReaderTest, has_next_returns_false_after_idle_timeout) {
+  RecordedFile file;
+  create_file(0);
+  auto reader = make_reader({&file}, std::chrono::milliseconds(30));
+  reader->open(storage_options(), {"", ""});
+  EXPECT_FALSE(reader->has_next());
+
+  file.write("topic");
+  EXPECT_TRUE(reader->has_next());
+}
+
+TEST_F(TailingReaderTest, stop_ends_waiting_for_messages) {
+  RecordedFile file;
+  create_file(0);
+  auto reader = make_reader({&file});
+  reader->open(storage_options(), {"", ""});
+
+  std::thread stopper([&reader]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      reader->stop();
+    });
+  EXPECT_FALSE(reader->has_next());
+  stopper.join();
+}
+
+TEST_F(TailingReaderTest, open_throws_if_no_file_is_created_within_idle_timeout) {
+  RecordedFile file;
+  auto reader = make_reader({&file}, std::chrono::milliseconds(20));
+  EXPECT_THROW(reader->open(storage_options(), {"", ""}), std::runtime_error);
+}
+
+TEST_F(TailingReaderTest, only_file_order_is_supported) {
+  auto reader = make_reader({});
+  EXPECT_TRUE(reader->set_read_order({rosbag2_storage::ReadOrder::File, false}));
+  EXPECT_FALSE(reader->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, false}));
+  EXPECT_FALSE(reader->set_read_order({rosbag2_storage::ReadOrder::File, true}));
+}
@@ -15,6 +15,7 @@
 #include <gmock/gmock.h>
 
 #include <atomic>
+#include <cmath>
 #include <thread>
 #include <rclcpp/utilities.hpp>
 #include "rosbag2_cpp/clocks/time_controller_clock.hpp"
@@ -130,8 +131,27 @@ TEST_F(TimeControllerClockTest, slow_rate)
 TEST_F(TimeControllerClockTest, invalid_rate)
 {
   rosbag2_cpp::TimeControllerClock clock(ros_start_time, now_fn);
-  EXPECT_FALSE(clock.set_rate(-5));
   EXPECT_FALSE(clock.set_rate(0));
+  EXPECT_FALSE(clock.set_rate(std::nan("")));
+  EXPECT_EQ(clock.get_rate(), 1.0);
+}
+
+TEST_F(TimeControllerClockTest, negative_rate_runs_backwards)
+{
+  const double playback_rate = -2.0;
+  ros_start_time = RCUTILS_S_TO_NS(100);
+  rosbag2_cpp::TimeControllerClock clock(ros_start_time, now_fn);
+  return_time = SteadyTimePoint(std::chrono::seconds(0));
+  EXPECT_TRUE(clock.set_rate(playback_rate));
+
+  return_time = SteadyTimePoint(std::chrono::seconds(3));
+  EXPECT_EQ(clock.now(), ros_start_time - RCUTILS_S_TO_NS(6));
+  EXPECT_EQ(
+    clock.ros_to_steady(ros_start_time - RCUTILS_S_TO_NS(10)),
+    SteadyTimePoint(std::chrono::seconds(5)));
+  // Time stamps after the current time are due, the time has yet to fall to earlier ones
+  EXPECT_TRUE(clock.sleep_until(ros_start_time));
+  EXPECT_FALSE(clock.sleep_until(ros_start_time - RCUTILS_S_TO_NS(7)));
 }
 
 TEST_F(TimeControllerClockTest, is_paused)
@@ -177,6 +197,43 @@ TEST_F(TimeControllerClockTest, unpaused_sleep_returns_true)
   }
 }
 
+TEST_F(TimeControllerClockTest, sleep_with_spin_duration_returns_true_at_time)
+{
+  const std::chrono::nanoseconds test_timeout{RCUTILS_S_TO_NS(2)};
+  const std::chrono::nanoseconds sleep_duration{RCUTILS_MS_TO_NS(20)};
+  rosbag2_cpp::TimeControllerClock clock(
+    ros_start_time, std::chrono::steady_clock::now, std::chrono::milliseconds{100}, false,
+    std::chrono::milliseconds{5});
+
+  const auto ros_start = clock.now();
+  const auto sleep_until_timestamp = ros_start + sleep_duration.count();
+  const auto steady_start = std::chrono::steady_clock::now();
+  bool sleep_result = false;
+  while (!sleep_result && (std::chrono::steady_clock::now() - steady_start) < test_timeout) {
+    sleep_result = clock.sleep_until(sleep_until_timestamp);
+  }
+  EXPECT_TRUE(sleep_result);
+  EXPECT_GE(clock.now(), sleep_until_timestamp);
+  EXPECT_GE(std::chrono::steady_clock::now() - steady_start, sleep_duration);
+}
+
+TEST_F(TimeControllerClockTest, pause_interrupts_spinning_sleep)
+{
+  rosbag2_cpp::TimeControllerClock clock(
+    ros_start_time, std::chrono::steady_clock::now, std::chrono::milliseconds{100}, false,
+    std::chrono::seconds{10});
+  std::atomic_bool thread_sleep_result{true};
+  auto sleep_long_thread = std::thread(
+    [&clock, &thread_sleep_result]() {
+      bool sleep_result = clock.sleep_until(clock.now() + RCUTILS_S_TO_NS(10));
+      thread_sleep_result.store(sleep_result);
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  clock.pause();  // Interrupts the spinning, causing the sleep to return false
+  sleep_long_thread.join();
+  EXPECT_FALSE(thread_sleep_result);
+}
+
 TEST_F(TimeControllerClockTest, paused_sleep_returns_false_quickly)
 {
   rosbag2_cpp::TimeControllerClock clock(ros_start_time);
@@ -0,0 +1,123 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_cpp/field_extractor.hpp"
+#include "rosbag2_cpp/typed_fast_paths.hpp"
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+#include "rosbag2_test_common/memory_management.hpp"
+
+#include "test_msgs/msg/nested.hpp"
+#include "test_msgs/msg/strings.hpp"
+
+using namespace ::testing;  // NOLINT
+
+namespace rosbag2_cpp
+{
+template<>
+struct TypedMessageTraits<test_msgs::msg::Strings>
+{
+  static std::string validate(const test_msgs::msg::Strings & message)
+  {
+    return message.string_value.empty() ? "string_value is empty" : "";
+  }
+};
+}  // namespace rosbag2_cpp
+
+class TypedFastPathsTest : public Test
+{
+public:
+  ~TypedFastPathsTest() override
+  {
+    auto & registry = rosbag2_cpp::TypedFastPathRegistry::instance();
+    registry.remove("test_msgs/msg/Nested");
+    registry.remove("test_msgs/msg/Strings");
+  }
+
+  rosbag2_test_common::MemoryManagement memory_management_;
+};
+
+TEST_F(TypedFastPathsTest, registry_makes_operations_of_registered_types) {
+  auto & registry = rosbag2_cpp::TypedFastPathRegistry::instance();
+  EXPECT_EQ(registry.make_operations("test_msgs/msg/Nested"), nullptr);
+
+  registry.add<test_msgs::msg::Nested>();
+  auto operations = registry.make_operations("test_msgs/msg/Nested");
+  ASSERT_NE(operations, nullptr);
+
+  auto nested = std::make_shared<test_msgs::msg::Nested>();
+  nested->basic_types_value.int32_value = 42;
+  operations->deserialize(*memory_management_.serialize_message(nested));
+  EXPECT_EQ(
+    static_cast<test_msgs::msg::Nested *>(operations->message())->basic_types_value.int32_value,
+    42);
+
+  auto serialized = rosbag2_storage::make_empty_serialized_message(0);
+  operations->serialize(*serialized);
+  EXPECT_EQ(
+    memory_management_.deserialize_message<test_msgs::msg::Nested>(serialized)->basic_types_value,
+    nested->basic_types_value);
+
+  EXPECT_TRUE(registry.remove("test_msgs/msg/Nested"));
+  EXPECT_EQ(registry.make_operations("test_msgs/msg/Nested"), nullptr);
+}
+
+TEST_F(TypedFastPathsTest, validate_applies_checks_of_the_type) {
+  auto & registry = rosbag2_cpp::TypedFastPathRegistry::instance();
+  registry.add<test_msgs::msg::Strings>();
+  auto operations = registry.make_operations("test_msgs/msg/Strings");
+  ASSERT_NE(operations, nullptr);
+
+  auto strings = std::make_shared<test_msgs::msg::Strings>();
+  strings->string_value = "value";
+  EXPECT_EQ(operations->validate(*memory_management_.serialize_message(strings)), "");
+  strings->string_value = "";
+  EXPECT_EQ(
+    operations->validate(*memory_management_.serialize_message(strings)),
+    "string_value is empty");
+
+  auto truncated = memory_management_.serialize_message(strings);
+  truncated->buffer_length = 2;
+  EXPECT_NE(operations->validate(*truncated), "");
+}
+
+TEST_F(TypedFastPathsTest, field_extractor_uses_registered_operations) {
+  size_t made_operations = 0;
+  rosbag2_cpp::TypedFastPathRegistry::instance().add(
+    "test_msgs/msg/Nested", [&made_operations]() {
+      ++made_operations;
+      return std::make_unique<rosbag2_cpp::TypedMessageOperationsImpl<test_msgs::msg::Nested>>();
+    });
+  rosbag2_cpp::FieldExtractor extractor(
+    "test_msgs/msg/Nested", {"basic_types_value.float64_value", "basic_types_value.int32_value"});
+  EXPECT_EQ(made_operations, 1u);
+
+  auto nested = std::make_shared<test_msgs::msg::Nested>();
+  nested->basic_types_value.float64_value = 1.5;
+  nested->basic_types_value.int32_value = -7;
+  std::vector<double> doubles(1);
+  std::vector<int32_t> ints(1);
+  extractor.extract(
+    *memory_management_.serialize_message(nested), {doubles.data(), ints.data()}, 0);
+  EXPECT_EQ(doubles[0], 1.5);
+  EXPECT_EQ(ints[0], -7);
+}
@@ -103,3 +103,26 @@ TEST(TypesupportHelpersTest, returns_c_type_info_for_valid_library) {
     FAIL() << e.what();
   }
 }
+
+TEST(TypesupportHelpersTest, shares_library_of_a_package_until_it_is_released) {
+  try {
+    auto library = rosbag2_cpp::get_typesupport_library(
+      "test_msgs/msg/BasicTypes", "rosidl_typesupport_cpp");
+    EXPECT_EQ(
+      rosbag2_cpp::get_typesupport_library("test_msgs/msg/Strings", "rosidl_typesupport_cpp"),
+      library);
+    EXPECT_NE(
+      rosbag2_cpp::get_typesupport_library(
+        "test_msgs/msg/BasicTypes", "rosidl_typesupport_introspection_cpp"),
+      library);
+
+    std::weak_ptr<rcpputils::SharedLibrary> released_library = library;
+    library.reset();
+    EXPECT_TRUE(released_library.expired());
+    library = rosbag2_cpp::get_typesupport_library(
+      "test_msgs/msg/BasicTypes", "rosidl_typesupport_cpp");
+    EXPECT_NE(library, nullptr);
+  } catch (const std::runtime_error & e) {
+    FAIL() << e.what();
+  }
+}
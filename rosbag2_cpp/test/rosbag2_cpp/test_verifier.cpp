@@ -0,0 +1,183 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/filesystem_helper.hpp"
+
+#include "rosbag2_cpp/verifier.hpp"
+
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+#include "mock_metadata_io.hpp"
+#include "mock_storage.hpp"
+#include "mock_storage_factory.hpp"
+
+using namespace testing;  // NOLINT
+using rosbag2_test_common::TemporaryDirectoryFixture;
+
+class VerifierTest : public TemporaryDirectoryFixture
+{
+public:
+  VerifierTest()
+  : storage_factory_(std::make_unique<StrictMock<MockStorageFactory>>()),
+    metadata_io_(std::make_unique<NiceMock<MockMetadataIo>>())
+  {
+    ON_CALL(*metadata_io_, metadata_file_exists(_)).WillByDefault(Return(true));
+    ON_CALL(*metadata_io_, read_metadata(_)).WillByDefault(
+      [this](const std::string &) {
+        return metadata_;
+      });
+  }
+
+  // Adds a file to the metadata, and creates it unless it is listed as missing
+  void add_file(
+    const std::string & name, size_t listed_message_count, bool exists = true)
+  {
+    metadata_.relative_file_paths.push_back(name);
+    rosbag2_storage::FileInformation file_information{};
+    file_information.path = name;
+    file_information.message_count = listed_message_count;
+    metadata_.files.push_back(file_information);
+    if (exists) {
+      std::ofstream(file_path(name)).close();
+    }
+  }
+
+  void add_topic(const std::string & name, size_t listed_message_count)
+  {
+    rosbag2_storage::TopicInformation topic_information{};
+    topic_information.topic_metadata.name = name;
+    topic_information.message_count = listed_message_count;
+    metadata_.topics_with_message_count.push_back(topic_information);
+  }
+
+  // The storage of a file verifies with the given intact messages per topic and problems
+  void expect_verification(
+    const std::string & name, std::map<std::string, uint64_t> topic_message_counts,
+    std::vector<rosbag2_storage::IntegrityProblem> problems = {})
+  {
+    rosbag2_storage::FileVerification verification;
+    verification.topic_message_counts.insert(
+      topic_message_counts.begin(), topic_message_counts.end());
+    verification.problems = std::move(problems);
+    verification.checked = true;
+    auto storage = std::make_shared<NiceMock<MockStorage>>();
+    ON_CALL(*storage, verify()).WillByDefault(Return(verification));
+    EXPECT_CALL(
+      *storage_factory_, open_read_only(Field(&rosbag2_storage::StorageOptions::uri,
+      file_path(name)))).WillOnce(Return(storage));
+  }
+
+  std::string file_path(const std::string & name) const
+  {
+    return (rcpputils::fs::path(temporary_dir_path_) / name).string();
+  }
+
+  rosbag2_cpp::BagVerification verify(size_t threads = 0)
+  {
+    rosbag2_cpp::Verifier verifier(std::move(storage_factory_), std::move(metadata_io_));
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = temporary_dir_path_;
+    return verifier.verify(storage_options, threads);
+  }
+
+  std::unique_ptr<StrictMock<MockStorageFactory>> storage_factory_;
+  std::unique_ptr<NiceMock<MockMetadataIo>> metadata_io_;
+  rosbag2_storage::BagMetadata metadata_{};
+};
+
+TEST_F(VerifierTest, verifies_every_file_and_matches_the_metadata) {
+  for (size_t i = 0; i < 6; ++i) {
+    const auto name = "bag_" + std::to_string(i) + ".mock";
+    add_file(name, 3);
+    expect_verification(name, {{"/a", 2}, {"/b", 1}});
+  }
+  add_topic("/a", 12);
+  add_topic("/b", 6);
+
+  const auto result = verify(3);
+  ASSERT_EQ(result.files.size(), 6u);
+  EXPECT_EQ(result.files[4].path, "bag_4.mock");
+  EXPECT_EQ(result.files[4].verification.message_count(), 3u);
+  EXPECT_TRUE(result.metadata_mismatches.empty());
+  EXPECT_TRUE(result.ok());
+}
+
+TEST_F(VerifierTest, reports_problems_of_files_and_missing_files) {
+  rosbag2_storage::IntegrityProblem problem;
+  problem.description = "chunk does not match its CRC";
+  problem.start_offset = 100;
+  problem.end_offset = 200;
+  add_file("bag_0.mock", 3);
+  expect_verification("bag_0.mock", {{"/a", 1}}, {problem});
+  add_file("bag_1.mock", 3, false);
+  add_topic("/a", 6);
+
+  const auto result = verify();
+  EXPECT_FALSE(result.ok());
+  ASSERT_EQ(result.files.size(), 2u);
+  ASSERT_EQ(result.files[0].verification.problems.size(), 1u);
+  EXPECT_EQ(result.files[0].verification.problems[0].end_offset, 200u);
+  EXPECT_THAT(result.files[1].error, HasSubstr("does not exist"));
+  EXPECT_THAT(
+    result.metadata_mismatches, ElementsAre(
+      HasSubstr("bag_0.mock: the metadata lists 3 messages, 1 are intact"),
+      HasSubstr("/a: the metadata lists 6 messages, 1 are intact")));
+}
+
+TEST_F(VerifierTest, reports_topics_missing_in_the_metadata) {
+  add_file("bag_0.mock", 2);
+  expect_verification("bag_0.mock", {{"/a", 1}, {"/unlisted", 1}});
+  add_topic("/a", 1);
+
+  const auto result = verify();
+  EXPECT_THAT(
+    result.metadata_mismatches, ElementsAre(HasSubstr("/unlisted: 1 messages are intact")));
+}
+
+TEST_F(VerifierTest, reports_files_which_can_not_be_opened) {
+  add_file("bag_0.mock", 0);
+  EXPECT_CALL(*storage_factory_, open_read_only(_))
+  .WillOnce(Throw(std::runtime_error("unknown storage")));
+
+  const auto result = verify();
+  ASSERT_EQ(result.files.size(), 1u);
+  EXPECT_EQ(result.files[0].error, "unknown storage");
+  EXPECT_FALSE(result.ok());
+}
+
+TEST_F(VerifierTest, throws_without_metadata_or_for_compressed_files) {
+  ON_CALL(*metadata_io_, metadata_file_exists(_)).WillByDefault(Return(false));
+  rosbag2_cpp::Verifier verifier(std::make_unique<MockStorageFactory>(), std::move(metadata_io_));
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = temporary_dir_path_;
+  EXPECT_THROW(verifier.verify(storage_options), std::runtime_error);
+
+  auto metadata_io = std::make_unique<NiceMock<MockMetadataIo>>();
+  ON_CALL(*metadata_io, metadata_file_exists(_)).WillByDefault(Return(true));
+  metadata_.compression_mode = "FILE";
+  ON_CALL(*metadata_io, read_metadata(_)).WillByDefault(Return(metadata_));
+  rosbag2_cpp::Verifier compressed_verifier(
+    std::make_unique<MockStorageFactory>(), std::move(metadata_io));
+  EXPECT_THROW(compressed_verifier.verify(storage_options), std::runtime_error);
+}
@@ -14,6 +14,9 @@
 
 #include <gmock/gmock.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -183,3 +186,46 @@ TEST_F(Ros2MessageTest, duplicate_set_topic_does_not_leak) {
 
   EXPECT_THAT(message->topic_name, StrEq("Topic name"));
 }
+
+TEST_F(Ros2MessageTest, arena_reuses_its_memory_for_the_messages_after_reset) {
+  rosbag2_cpp::IntrospectionMessageArena arena(1024);
+  allocator_ = arena.get_allocator();
+
+  void * first_message_memory = nullptr;
+  {
+    auto message = get_allocated_message("test_msgs/Strings");
+    rosbag2_cpp::introspection_message_set_topic_name(message.get(), "/strings");
+    static_cast<test_msgs::msg::Strings *>(message->message)->string_value = "message 1";
+    first_message_memory = message->message;
+  }
+  const auto used_bytes = arena.get_used_bytes();
+  EXPECT_GE(used_bytes, sizeof(test_msgs::msg::Strings));
+
+  arena.reset();
+  EXPECT_EQ(arena.get_used_bytes(), 0u);
+  auto message = get_allocated_message("test_msgs/Strings");
+  rosbag2_cpp::introspection_message_set_topic_name(message.get(), "/strings");
+  EXPECT_EQ(message->message, first_message_memory);
+  EXPECT_EQ(arena.get_used_bytes(), used_bytes);
+  EXPECT_THAT(message->topic_name, StrEq("/strings"));
+  EXPECT_THAT(static_cast<test_msgs::msg::Strings *>(message->message)->string_value, IsEmpty());
+}
+
+TEST_F(Ros2MessageTest, arena_allocations_are_aligned_and_keep_their_content) {
+  rosbag2_cpp::IntrospectionMessageArena arena(64);
+  auto allocator = arena.get_allocator();
+
+  auto small = static_cast<char *>(allocator.allocate(3, allocator.state));
+  std::memcpy(small, "ab", 3);
+  // Larger than a block
+  auto large = static_cast<char *>(allocator.zero_allocate(100, 1, allocator.state));
+  for (auto pointer : {small, large}) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(pointer) % alignof(std::max_align_t), 0u);
+  }
+  EXPECT_EQ(large[99], 0);
+
+  EXPECT_EQ(allocator.reallocate(small, 2, allocator.state), small);
+  auto grown = static_cast<char *>(allocator.reallocate(small, 200, allocator.state));
+  EXPECT_STREQ(grown, "ab");
+  allocator.deallocate(grown, allocator.state);
+}
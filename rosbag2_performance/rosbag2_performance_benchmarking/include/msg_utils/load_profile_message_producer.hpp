@@ -0,0 +1,69 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MSG_UTILS__LOAD_PROFILE_MESSAGE_PRODUCER_HPP_
+#define MSG_UTILS__LOAD_PROFILE_MESSAGE_PRODUCER_HPP_
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "message_producer.hpp"
+#include "rosbag2_performance_benchmarking/load_profile.hpp"
+
+namespace msg_utils
+{
+/// Publishes the messages of a topic of a load profile, each one with its recorded size.
+/// The data of all messages is a prefix of random data of the largest size.
+class LoadProfileMessageProducer : public ProducerBase
+{
+public:
+  LoadProfileMessageProducer(
+    rclcpp::Node & node, std::string topic, const LoadProfileTopic & profile_topic)
+  : sizes_(profile_topic.sizes),
+    publisher_(
+      node.create_publisher<rosbag2_performance_benchmarking_msgs::msg::ByteArray>(
+        topic, profile_topic.qos))
+  {
+    if (!sizes_.empty()) {
+      helpers::generate_data(data_, *std::max_element(sizes_.begin(), sizes_.end()));
+    }
+  }
+
+  void produce() override
+  {
+    if (!rclcpp::ok() || next_ == sizes_.size()) {
+      return;
+    }
+    message_.data.assign(data_.data.begin(), data_.data.begin() + sizes_[next_++]);
+    publisher_->publish(message_);
+  }
+
+  void wait_for_matched() override
+  {
+    wait_for_subscription(*publisher_);
+  }
+
+private:
+  const std::vector<size_t> sizes_;
+  size_t next_ = 0;
+  rosbag2_performance_benchmarking_msgs::msg::ByteArray data_;
+  rosbag2_performance_benchmarking_msgs::msg::ByteArray message_;
+  std::shared_ptr<rclcpp::Publisher<rosbag2_performance_benchmarking_msgs::msg::ByteArray>>
+  publisher_;
+};
+}  // namespace msg_utils
+
+#endif  // MSG_UTILS__LOAD_PROFILE_MESSAGE_PRODUCER_HPP_
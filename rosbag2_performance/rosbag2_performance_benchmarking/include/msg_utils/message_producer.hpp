@@ -59,12 +59,12 @@ MessageProducer<T>::MessageProducer(
   }
 }
 
-template<typename T>
-void MessageProducer<T>::wait_for_matched()
+/// Wait until a subscription matched the publisher, throw after 5 seconds
+inline void wait_for_subscription(const rclcpp::PublisherBase & publisher)
 {
   const double max_subscription_wait_time = 5.0;
   auto start_time = std::chrono::high_resolution_clock::now();
-  while (publisher_->get_subscription_count() == 0U) {
+  while (publisher.get_subscription_count() == 0U) {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
     auto current_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = current_time - start_time;
@@ -74,6 +74,12 @@ void MessageProducer<T>::wait_for_matched()
   }
 }
 
+template<typename T>
+void MessageProducer<T>::wait_for_matched()
+{
+  wait_for_subscription(*publisher_);
+}
+
 template<typename T>
 void MessageProducer<T>::produce()
 {
@@ -0,0 +1,45 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__BAG_UTILS_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__BAG_UTILS_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+#include "rosbag2_performance_benchmarking/bag_config.hpp"
+#include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+
+namespace bag_utils
+{
+
+/// Write a bag with the messages described by the publisher groups, as if they were recorded at
+/// the rates of their producers with the QoS of their groups.
+/// The data of every message of at least 8 bytes starts with the bag time stamp of the message.
+/// \return the names of the written topics
+std::vector<std::string> write_synthetic_bag(
+  const std::vector<PublisherGroupConfig> & publisher_groups_config,
+  const BagConfig & bag_config);
+
+/// Bag time stamp of a message of a bag written by write_synthetic_bag,
+/// or nullopt if the message is too short to hold it
+std::optional<rcutils_time_point_value_t> get_synthetic_time_stamp(
+  const std::vector<uint8_t> & data);
+
+}  // namespace bag_utils
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__BAG_UTILS_HPP_
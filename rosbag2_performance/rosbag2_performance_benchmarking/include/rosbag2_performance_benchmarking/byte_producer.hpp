@@ -25,6 +25,7 @@
 #include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
 
 #include "rosbag2_performance_benchmarking/producer_config.hpp"
+#include "rosbag2_performance_benchmarking/rate_pacer.hpp"
 
 class ByteProducer
 {
@@ -39,12 +40,13 @@ public:
     const ProducerConfig & config,
     producer_initialize_function_t producer_initialize,
     producer_callback_function_t producer_callback,
-    producer_finalize_function_t producer_finalize)
+    producer_finalize_function_t producer_finalize,
+    std::chrono::nanoseconds spin_wait = std::chrono::nanoseconds(0))
   : configuration_(config),
     producer_initialize_(producer_initialize),
     producer_callback_(producer_callback),
     producer_finalize_(producer_finalize),
-    sleep_time_(configuration_.frequency == 0 ? 1 : 1000 / configuration_.frequency),
+    spin_wait_(spin_wait),
     message_(std::make_shared<rosbag2_performance_benchmarking_msgs::msg::ByteArray>())
   {
     msg_utils::helpers::generate_data(*message_, configuration_.message_size);
@@ -53,12 +55,15 @@ public:
   void run()
   {
     producer_initialize_();
-    for (auto i = 0u; i < configuration_.max_count; ++i) {
+    RatePacer pacer(configuration_.frequency, spin_wait_);
+    for (auto i = 0u; i < configuration_.max_count; ) {
+      pacer.wait();
       if (!rclcpp::ok()) {
         break;
       }
-      producer_callback_(message_);
-      std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time_));
+      for (size_t j = 0; j < pacer.batch_size() && i < configuration_.max_count; ++j, ++i) {
+        producer_callback_(message_);
+      }
     }
     producer_finalize_();
   }
@@ -68,7 +73,7 @@ private:
   producer_initialize_function_t producer_initialize_;
   producer_callback_function_t producer_callback_;
   producer_finalize_function_t producer_finalize_;
-  unsigned int sleep_time_;  // in milliseconds
+  std::chrono::nanoseconds spin_wait_;
   // for simplification, this pointer will be reused
   std::shared_ptr<rosbag2_performance_benchmarking_msgs::msg::ByteArray> message_;
 };
@@ -0,0 +1,80 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_BENCHMARK_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_BENCHMARK_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rosbag2_compression/compression_factory.hpp"
+#include "rosbag2_compression/compression_options.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+
+#include "rosbag2_performance_benchmarking/compression_results.hpp"
+
+/// Compresses the messages of every topic of an existing bag with every combination of the
+/// compression formats, levels, modes and thread counts, and measures the compression ratio,
+/// the throughput and the latencies of compressing and decompressing them.
+class CompressionBenchmark : public rclcpp::Node
+{
+public:
+  explicit CompressionBenchmark(const std::string & name);
+  void start_benchmark();
+
+private:
+  using Messages = std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>;
+
+  struct Settings
+  {
+    std::string compression_format;
+    std::optional<int32_t> compression_level;
+    rosbag2_compression::CompressionMode compression_mode;
+    size_t threads = 1;
+  };
+
+  void read_messages();
+  CompressionResults measure(const Settings & settings, const std::string & topic);
+  /// Compress the messages or batches independently, spread across the threads
+  void measure_items(
+    const Settings & settings, const Messages & items, bool unpack,
+    CompressionResults & results);
+  /// Compress a file of the concatenated messages
+  void measure_file(
+    const Settings & settings, const std::string & topic, const Messages & messages,
+    CompressionResults & results);
+  std::shared_ptr<rosbag2_compression::BaseCompressorInterface> create_compressor(
+    const Settings & settings);
+
+  std::string bag_uri_;
+  std::string storage_id_;
+  std::string results_file_;
+  std::string temporary_directory_;
+  std::vector<std::string> compression_formats_;
+  std::vector<int64_t> compression_levels_;
+  std::vector<rosbag2_compression::CompressionMode> compression_modes_;
+  std::vector<int64_t> threads_;
+  size_t max_messages_per_topic_ = 0;
+
+  rosbag2_compression::CompressionFactory compression_factory_;
+  std::map<std::string, Messages> topic_messages_;
+  std::vector<CompressionResults> results_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_BENCHMARK_HPP_
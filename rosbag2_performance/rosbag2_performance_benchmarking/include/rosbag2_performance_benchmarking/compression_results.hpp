@@ -0,0 +1,47 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_RESULTS_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_RESULTS_HPP_
+
+#include <cstddef>
+#include <string>
+
+/// Results of compressing the messages of one topic with one combination of settings
+struct CompressionResults
+{
+  std::string topic;
+  std::string compression_format;
+  // "default" if the level of the compressor was left as it is
+  std::string compression_level;
+  std::string compression_mode;
+  size_t threads = 1;
+  size_t message_count = 0;
+  // Size of the serialized messages, the same for all modes so that the ratios compare
+  size_t uncompressed_bytes = 0;
+  size_t compressed_bytes = 0;
+  double compression_ratio = 0;
+  // Throughput in uncompressed bytes over the time to compress or decompress all of them
+  double compress_mb_per_s = 0;
+  double decompress_mb_per_s = 0;
+  // Latency of compressing or decompressing a message, a batch or the file, by mode
+  double compress_latency_p50_us = 0;
+  double compress_latency_p90_us = 0;
+  double compress_latency_p99_us = 0;
+  double decompress_latency_p50_us = 0;
+  double decompress_latency_p90_us = 0;
+  double decompress_latency_p99_us = 0;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__COMPRESSION_RESULTS_HPP_
@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__CONFIG_UTILS_HPP_
 #define ROSBAG2_PERFORMANCE_BENCHMARKING__CONFIG_UTILS_HPP_
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -40,6 +41,9 @@ bool wait_for_subscriptions_from_node_parameters(rclcpp::Node & node);
 /// Gets the number of threads used for the thread pool
 size_t get_number_of_threads_from_node_parameters(rclcpp::Node & node);
 
+/// Gets the time producers spin before each deadline instead of sleeping, 0 if not set
+std::chrono::nanoseconds get_spin_wait_from_node_parameters(rclcpp::Node & node);
+
 /// Acquires publisher parameters from the node
 std::vector<PublisherGroupConfig> publisher_groups_from_node_parameters(
   rclcpp::Node & node);
@@ -0,0 +1,43 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "rclcpp/qos.hpp"
+
+/// Arrival times and sizes of the messages of a topic of a recorded bag
+struct LoadProfileTopic
+{
+  LoadProfileTopic()
+  : qos(10) {}
+  std::string name;
+  rclcpp::QoS qos;
+  // Time of every message since the first message of the bag, divided by the replay rate
+  std::vector<std::chrono::nanoseconds> offsets;
+  // Serialized size of every message, multiplied by the size scale
+  std::vector<size_t> sizes;
+};
+
+/// Traffic of a recorded bag, replayed by the benchmarks instead of the publisher groups
+struct LoadProfile
+{
+  std::vector<LoadProfileTopic> topics;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_HPP_
@@ -0,0 +1,84 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_PRODUCER_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_PRODUCER_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "rclcpp/utilities.hpp"
+#include "msg_utils/helpers.hpp"
+#include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
+
+#include "rosbag2_performance_benchmarking/load_profile.hpp"
+#include "rosbag2_performance_benchmarking/rate_pacer.hpp"
+
+/// Counterpart of ByteProducer which produces the messages of a topic of a load profile
+/// at their recorded times since the start and with their recorded sizes.
+class LoadProfileProducer
+{
+public:
+  using producer_callback_function_t = std::function<void (
+        std::shared_ptr<rosbag2_performance_benchmarking_msgs::msg::ByteArray>)>;
+
+  using producer_finalize_function_t = std::function<void ()>;
+
+  LoadProfileProducer(
+    const LoadProfileTopic & topic,
+    std::chrono::steady_clock::time_point start_time,
+    std::chrono::nanoseconds spin_wait,
+    producer_callback_function_t producer_callback,
+    producer_finalize_function_t producer_finalize)
+  : topic_(topic),
+    start_time_(start_time),
+    spin_wait_(spin_wait),
+    producer_callback_(std::move(producer_callback)),
+    producer_finalize_(std::move(producer_finalize))
+  {
+    if (!topic_.sizes.empty()) {
+      msg_utils::helpers::generate_data(
+        data_, *std::max_element(topic_.sizes.begin(), topic_.sizes.end()));
+    }
+  }
+
+  void run()
+  {
+    for (size_t i = 0; i < topic_.offsets.size(); ++i) {
+      sleep_until_precisely(start_time_ + topic_.offsets[i], spin_wait_);
+      if (!rclcpp::ok()) {
+        break;
+      }
+      // Messages differ in size, so each one is a new message unlike in ByteProducer
+      auto message = std::make_shared<rosbag2_performance_benchmarking_msgs::msg::ByteArray>();
+      message->data.assign(data_.data.begin(), data_.data.begin() + topic_.sizes[i]);
+      producer_callback_(message);
+    }
+    producer_finalize_();
+  }
+
+private:
+  LoadProfileTopic topic_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::chrono::nanoseconds spin_wait_;
+  producer_callback_function_t producer_callback_;
+  producer_finalize_function_t producer_finalize_;
+  rosbag2_performance_benchmarking_msgs::msg::ByteArray data_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_PRODUCER_HPP_
@@ -0,0 +1,45 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_UTILS_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_UTILS_HPP_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rclcpp/node.hpp"
+#include "rosbag2_performance_benchmarking/load_profile.hpp"
+#include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+
+namespace load_profile_utils
+{
+
+/// Read the arrival times and sizes of all messages of a bag.
+/// \param rate divides the time between messages, e.g. 2.0 replays the bag twice as fast.
+/// \param size_scale multiplies the size of messages.
+LoadProfile read_load_profile(const std::string & uri, double rate, double size_scale);
+
+/// Read the load profile of the bag of the load_profile.bag_uri parameter,
+/// nullopt if the parameter is not set
+std::optional<LoadProfile> load_profile_from_node_parameters(rclcpp::Node & node);
+
+/// One publisher group of one publisher per topic of the load profile, in the order of its
+/// topics, with the average rate and message size of the topic.
+/// The topic root is the topic name without leading slash.
+std::vector<PublisherGroupConfig> publisher_groups_from_load_profile(const LoadProfile & profile);
+
+}  // namespace load_profile_utils
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__LOAD_PROFILE_UTILS_HPP_
@@ -0,0 +1,48 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_BENCHMARK_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_BENCHMARK_HPP_
+
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "rosbag2_performance_benchmarking/bag_config.hpp"
+#include "rosbag2_performance_benchmarking/player_results.hpp"
+#include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+
+/// Writes a bag with the messages described by the publisher groups, as if they were recorded,
+/// then plays it back and measures the played messages with subscriptions of another node.
+class PlayerBenchmark : public rclcpp::Node
+{
+public:
+  explicit PlayerBenchmark(const std::string & name);
+  void start_benchmark();
+
+private:
+  void measure_playback();
+
+  std::vector<PublisherGroupConfig> configurations_;
+  BagConfig bag_config_;
+  std::string results_file_;
+  size_t read_ahead_queue_size_ = 1000;
+  double rate_ = 1.0;
+  double receive_timeout_s_ = 1.0;
+
+  PlayerResults results_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_BENCHMARK_HPP_
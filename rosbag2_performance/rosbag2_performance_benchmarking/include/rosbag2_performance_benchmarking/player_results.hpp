@@ -0,0 +1,40 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_RESULTS_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_RESULTS_HPP_
+
+#include <cstddef>
+
+struct PlayerResults
+{
+  size_t total_messages = 0;
+  size_t received_messages = 0;
+  size_t received_bytes = 0;
+  // Message rate and bandwidth received between the first and the last received message
+  double received_messages_per_s = 0;
+  double received_mb_per_s = 0;
+  // Absolute difference between the receive time of messages and their bag time stamps scaled by
+  // the play rate, relative to the first received message
+  double jitter_p50_us = 0;
+  double jitter_p99_us = 0;
+  double jitter_max_us = 0;
+  // CPU time of the benchmark process, which includes the subscriptions, during the playback,
+  // in percent of one core
+  double cpu_usage = 0;
+  // Largest increase of the resident memory of the benchmark process during the playback
+  double peak_memory_mb = 0;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__PLAYER_RESULTS_HPP_
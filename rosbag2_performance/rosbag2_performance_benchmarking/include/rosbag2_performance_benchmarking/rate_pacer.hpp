@@ -0,0 +1,85 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__RATE_PACER_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__RATE_PACER_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+/// Sleep until shortly before the deadline and spin for the rest, as sleeping alone wakes up
+/// late by the timer slack and scheduling latency of the system
+inline void sleep_until_precisely(
+  std::chrono::steady_clock::time_point deadline, std::chrono::nanoseconds spin_wait)
+{
+  if (spin_wait.count() > 0) {
+    std::this_thread::sleep_until(deadline - spin_wait);
+    while (std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+  } else {
+    std::this_thread::sleep_until(deadline);
+  }
+}
+
+/// Paces a producer at a fixed rate with absolute deadlines, so that late wake ups do not add
+/// up to a lower rate. Rates with periods shorter than min_interval are produced in batches of
+/// messages per deadline, since threads can't be woken up reliably at shorter intervals.
+class RatePacer
+{
+public:
+  static constexpr std::chrono::microseconds min_interval{100};
+
+  /// \param frequency messages per second, 0 is treated as 1000 as in earlier producers
+  /// \param spin_wait time to spin before each deadline instead of sleeping, 0 to only sleep
+  RatePacer(
+    unsigned int frequency,
+    std::chrono::nanoseconds spin_wait,
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+  : period_(std::chrono::nanoseconds(std::chrono::seconds(1)) / (frequency ? frequency : 1000)),
+    batch_size_(
+      std::max<size_t>(
+        1, static_cast<size_t>((min_interval + period_ - std::chrono::nanoseconds(1)) / period_))),
+    spin_wait_(spin_wait),
+    next_deadline_(start)
+  {}
+
+  /// Number of messages to produce at every deadline
+  size_t batch_size() const
+  {
+    return batch_size_;
+  }
+
+  std::chrono::steady_clock::time_point next_deadline() const
+  {
+    return next_deadline_;
+  }
+
+  /// Wait for the next deadline, after which batch_size messages are due
+  void wait()
+  {
+    sleep_until_precisely(next_deadline_, spin_wait_);
+    next_deadline_ += period_ * batch_size_;
+  }
+
+private:
+  std::chrono::nanoseconds period_;
+  size_t batch_size_;
+  std::chrono::nanoseconds spin_wait_;
+  std::chrono::steady_clock::time_point next_deadline_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__RATE_PACER_HPP_
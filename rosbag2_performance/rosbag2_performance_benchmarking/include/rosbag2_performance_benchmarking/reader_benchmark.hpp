@@ -0,0 +1,55 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__READER_BENCHMARK_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__READER_BENCHMARK_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rosbag2_cpp/reader.hpp"
+
+#include "rosbag2_performance_benchmarking/bag_config.hpp"
+#include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+#include "rosbag2_performance_benchmarking/reader_results.hpp"
+
+/// Writes a bag with the messages described by the publisher groups, as if they were recorded,
+/// then measures reading and playing it back.
+class ReaderBenchmark : public rclcpp::Node
+{
+public:
+  explicit ReaderBenchmark(const std::string & name);
+  void start_benchmark();
+
+private:
+  std::unique_ptr<rosbag2_cpp::Reader> open_reader() const;
+  void measure_sequential_read();
+  void measure_seeks();
+  void measure_filtered_reads();
+  void measure_play_timing();
+
+  std::vector<PublisherGroupConfig> configurations_;
+  BagConfig bag_config_;
+  std::string results_file_;
+  size_t seek_count_ = 0;
+  std::vector<double> filter_selectivities_;
+  bool measure_play_timing_ = true;
+
+  std::vector<std::string> topics_;
+  ReaderResults results_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__READER_BENCHMARK_HPP_
@@ -0,0 +1,41 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__READER_RESULTS_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__READER_RESULTS_HPP_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+struct ReaderResults
+{
+  size_t total_messages = 0;
+  size_t total_bytes = 0;
+  // Throughput of reading the whole bag sequentially
+  double read_mb_per_s = 0;
+  // Latency of a seek to a random time stamp followed by reading the next message
+  double seek_latency_p50_us = 0;
+  double seek_latency_p90_us = 0;
+  double seek_latency_p99_us = 0;
+  // Throughput of reads filtered to a share of the topics, as pairs of share and throughput
+  std::vector<std::pair<double, double>> filtered_read_mb_per_s;
+  // Absolute difference between the publish time of played messages and their bag time stamps,
+  // relative to the first played message
+  double play_error_p50_us = 0;
+  double play_error_p99_us = 0;
+  double play_error_max_us = 0;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__READER_RESULTS_HPP_
@@ -0,0 +1,79 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLER_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLER_HPP_
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_performance_benchmarking/resource_samples.hpp"
+
+/// Samples CPU time per thread, resident memory, disk I/O and context switches of a process
+/// from /proc on a thread of its own. The own process is sampled with getrusage where it can,
+/// which includes threads that already exited.
+class ResourceSampler
+{
+public:
+  /// \param fsync_probe_dir directory in which the latency of fsync of a small file is measured
+  /// with every sample, not measured if empty. It should be on the file system of the bag.
+  ResourceSampler(pid_t pid, std::chrono::milliseconds period, std::string fsync_probe_dir);
+  ~ResourceSampler();
+
+  void start();
+  void stop();
+
+  /// Samples taken until stop, to be read after stopping
+  const std::vector<ResourceSample> & samples() const;
+  const std::vector<ThreadSample> & thread_samples() const;
+
+private:
+  struct Counters
+  {
+    double cpu_time_s = 0;
+    double read_bytes = 0;
+    double write_bytes = 0;
+    double context_switches = 0;
+  };
+
+  void run();
+  Counters read_counters() const;
+  std::map<int, std::pair<std::string, double>> read_thread_cpu_times() const;
+  double read_rss_mb() const;
+  double probe_fsync_ms();
+
+  const pid_t pid_;
+  const std::string proc_dir_;
+  const std::chrono::milliseconds period_;
+  const std::string fsync_probe_path_;
+  int fsync_probe_fd_ = -1;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_condition_;
+  bool stopped_ = false;
+
+  std::vector<ResourceSample> samples_;
+  std::vector<ThreadSample> thread_samples_;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLER_HPP_
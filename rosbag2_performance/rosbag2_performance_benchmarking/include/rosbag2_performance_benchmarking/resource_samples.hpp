@@ -0,0 +1,60 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLES_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLES_HPP_
+
+#include <string>
+
+/// Resources used by the sampled process since the previous sample
+struct ResourceSample
+{
+  // Time since the start of sampling
+  double time_s = 0;
+  // CPU time of all threads, in percent of one core
+  double cpu_usage = 0;
+  double rss_mb = 0;
+  // Bytes read from and written to the storage device, excluding the page cache
+  double read_mb_per_s = 0;
+  double write_mb_per_s = 0;
+  double context_switches_per_s = 0;
+  // Latency of fsync of a small probe file next to the bag, negative if not probed
+  double fsync_ms = -1;
+};
+
+/// CPU usage of a single thread of the sampled process since the previous sample
+struct ThreadSample
+{
+  double time_s = 0;
+  int tid = 0;
+  std::string name;
+  double cpu_usage = 0;
+};
+
+/// Summary of the resource samples of a run, all zero if the run was not sampled
+struct ResourceSummary
+{
+  double peak_rss_mb = 0;
+  double average_rss_mb = 0;
+  double write_mb_per_s = 0;
+  double read_mb_per_s = 0;
+  double context_switches_per_s = 0;
+  double fsync_p50_ms = 0;
+  double fsync_p99_ms = 0;
+  double fsync_max_ms = 0;
+  // Average CPU usage of the busiest thread, the one likely to saturate first
+  double busiest_thread_cpu_usage = 0;
+};
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__RESOURCE_SAMPLES_HPP_
@@ -20,11 +20,18 @@
 
 #include "rclcpp/node.hpp"
 #include "rosbag2_performance_benchmarking/bag_config.hpp"
+#include "rosbag2_performance_benchmarking/compression_results.hpp"
+#include "rosbag2_performance_benchmarking/player_results.hpp"
 #include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+#include "rosbag2_performance_benchmarking/reader_results.hpp"
+#include "rosbag2_performance_benchmarking/resource_samples.hpp"
 
 namespace result_utils
 {
 
+/// Nearest-rank percentile of samples, which are sorted in place
+double percentile(std::vector<double> & samples, double share);
+
 /// Read total count of recorded messages from metadata.yaml file
 int get_message_count_from_metadata(const std::string & uri);
 
@@ -35,11 +42,41 @@ void write_benchmark_results(
   const std::string & results_file,
   float producer_cpu_usage = 0,
   float recorder_cpu_usage = 0,
-  const std::vector<double> & cpu_usage_per_core = {});
+  const std::vector<double> & cpu_usage_per_core = {},
+  const ResourceSummary & resources = {});
 
 /// this version works with a standalone node using node parameters
 void write_benchmark_results(rclcpp::Node & node);
 
+/// Write the resource samples of a run next to its bag, to <uri>_resources.csv and the samples
+/// of its threads to <uri>_threads.csv
+void write_resource_samples(
+  const std::vector<ResourceSample> & samples,
+  const std::vector<ThreadSample> & thread_samples,
+  const std::string & uri);
+
+/// Summarize the resource samples written next to the bag, all zero if there are none
+ResourceSummary read_resource_summary(const std::string & uri);
+
+/// Write results of a completed reader benchmark
+void write_reader_benchmark_results(
+  const BagConfig & bag_config,
+  const ReaderResults & results,
+  const std::string & results_file);
+
+/// Write results of a completed player benchmark
+void write_player_benchmark_results(
+  const BagConfig & bag_config,
+  size_t read_ahead_queue_size,
+  double rate,
+  const PlayerResults & results,
+  const std::string & results_file);
+
+/// Write results of a completed compression benchmark
+void write_compression_benchmark_results(
+  const std::vector<CompressionResults> & results,
+  const std::string & results_file);
+
 }  // namespace result_utils
 
 #endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__RESULT_UTILS_HPP_
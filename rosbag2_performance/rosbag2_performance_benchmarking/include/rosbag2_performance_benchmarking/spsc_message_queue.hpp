@@ -0,0 +1,106 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__SPSC_MESSAGE_QUEUE_HPP_
+#define ROSBAG2_PERFORMANCE_BENCHMARKING__SPSC_MESSAGE_QUEUE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
+
+/// Lock-free counterpart of MessageQueue for exactly one producer thread and one consumer
+/// thread, so that contention on the queue does not limit the measured write throughput.
+/// Like MessageQueue, it holds up to max_size + 1 elements and counts pushes to a full queue
+/// as missed.
+template<typename T>
+class SpscMessageQueue
+{
+public:
+  SpscMessageQueue(int max_size, std::string topic_name)
+  : capacity_(static_cast<size_t>(max_size) + 1),
+    slots_(capacity_),
+    topic_name_(std::move(topic_name))
+  {}
+
+  /// Called from the producer thread only
+  void push(std::shared_ptr<T> elem)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == capacity_) {
+      // We skip the element and consider it "lost"
+      unsuccessful_insert_count_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    slots_[tail % capacity_] = std::move(elem);
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  bool is_complete() const
+  {
+    return complete_.load(std::memory_order_acquire);
+  }
+
+  /// Called from the producer thread after its last push
+  void set_complete()
+  {
+    complete_.store(true, std::memory_order_release);
+  }
+
+  bool is_empty() const
+  {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+  }
+
+  /// Called from the consumer thread only
+  std::shared_ptr<T> pop_and_return()
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      throw std::out_of_range("Queue is empty, cannot pop. Check if empty first");
+    }
+    auto elem = std::move(slots_[head % capacity_]);
+    head_.store(head + 1, std::memory_order_release);
+    return elem;
+  }
+
+  unsigned int get_missed_elements_count() const
+  {
+    return unsuccessful_insert_count_.load(std::memory_order_relaxed);
+  }
+
+  std::string topic_name() const
+  {
+    return topic_name_;
+  }
+
+private:
+  const size_t capacity_;
+  std::vector<std::shared_ptr<T>> slots_;
+  std::string topic_name_;
+  std::atomic<bool> complete_{false};
+  std::atomic<unsigned int> unsuccessful_insert_count_{0};
+  // Written by different threads, kept on separate cache lines to avoid false sharing
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+typedef SpscMessageQueue<rosbag2_performance_benchmarking_msgs::msg::ByteArray>
+  ByteSpscMessageQueue;
+
+#endif  // ROSBAG2_PERFORMANCE_BENCHMARKING__SPSC_MESSAGE_QUEUE_HPP_
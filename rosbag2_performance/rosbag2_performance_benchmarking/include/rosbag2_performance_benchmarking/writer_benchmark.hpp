@@ -15,7 +15,9 @@
 #ifndef ROSBAG2_PERFORMANCE_BENCHMARKING__WRITER_BENCHMARK_HPP_
 #define ROSBAG2_PERFORMANCE_BENCHMARKING__WRITER_BENCHMARK_HPP_
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
@@ -25,7 +27,9 @@
 #include "rosbag2_cpp/writers/sequential_writer.hpp"
 
 #include "rosbag2_performance_benchmarking/byte_producer.hpp"
-#include "rosbag2_performance_benchmarking/message_queue.hpp"
+#include "rosbag2_performance_benchmarking/load_profile.hpp"
+#include "rosbag2_performance_benchmarking/load_profile_producer.hpp"
+#include "rosbag2_performance_benchmarking/spsc_message_queue.hpp"
 #include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
 #include "rosbag2_performance_benchmarking/bag_config.hpp"
 
@@ -42,10 +46,13 @@ private:
 
   std::vector<PublisherGroupConfig> configurations_;
   BagConfig bag_config_;
+  std::optional<LoadProfile> load_profile_;
+  std::chrono::nanoseconds spin_wait_{0};
 
   std::vector<std::thread> producer_threads_;
   std::vector<std::unique_ptr<ByteProducer>> producers_;
-  std::vector<std::shared_ptr<ByteMessageQueue>> queues_;
+  std::vector<std::unique_ptr<LoadProfileProducer>> load_profile_producers_;
+  std::vector<std::shared_ptr<ByteSpscMessageQueue>> queues_;
   std::shared_ptr<rosbag2_cpp::writers::SequentialWriter> writer_;
 };
 
@@ -71,6 +71,7 @@ _rosbag_pid = None
 _producer_pid = None
 _rosbag_process = None
 _producer_process = None
+_sampler_process = None
 
 _parameters = []
 
@@ -150,6 +151,29 @@ def _rosbag_proc_started(event, context):
     if len(_recorder_cpu_affinity) > 0:
         _rosbag_process.cpu_affinity(_recorder_cpu_affinity)
 
+    # Sample resources of the recorder until the producer exits
+    sampler = launch_ros.actions.Node(
+        package='rosbag2_performance_benchmarking',
+        executable='resource_sampler',
+        name='rosbag2_performance_benchmarking_node',
+        parameters=_parameters[_producer_idx] + [{'pid': _rosbag_pid}]
+    )
+    return [
+        launch.actions.RegisterEventHandler(
+            launch.event_handlers.OnProcessStart(
+                target_action=sampler,
+                on_start=_sampler_proc_started
+            )
+        ),
+        sampler
+    ]
+
+
+def _sampler_proc_started(event, context):
+    """Register current resource sampler process so we can stop it when producer exits."""
+    global _sampler_process
+    _sampler_process = psutil.Process(event.pid)
+
 
 def _rosbag_ready_check(event):
     """
@@ -248,7 +272,7 @@ def _producer_node_exited(event, context):
     Handles clearing of bags.
     """
     global _producer_idx, _producer_nodes, _rosbag_pid, _recorder_cpu_usage, _rosbag_process
-    global _producer_cpu_usage, _cpu_usage_per_core
+    global _producer_cpu_usage, _cpu_usage_per_core, _sampler_process
     parameters = _parameters[_producer_idx]
     node_params = _producer_nodes[_producer_idx]['parameters']
     transport = node_params['transport']
@@ -270,6 +294,11 @@ def _producer_node_exited(event, context):
         # Wait for rosbag2 process to exit for 10 seconds
         rosbag_return_code = _rosbag_process.wait(10)
         _rosbag_pid = None
+        # The sampler writes its samples when interrupted, before results are written
+        if _sampler_process is not None:
+            _sampler_process.send_signal(signal.SIGINT)
+            _sampler_process.wait(10)
+            _sampler_process = None
         if rosbag_return_code is not None and rosbag_return_code != 0:
             return [
                 launch.actions.LogInfo(msg='Rosbag2 record error. Shutting down benchmark. '
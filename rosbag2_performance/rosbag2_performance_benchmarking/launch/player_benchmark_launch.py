@@ -0,0 +1,183 @@
+# Copyright 2024 Open Source Robotics Foundation, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Launchfile for benchmarking playing back rosbag2 bags.
+
+This launchfile can only be launched with 'ros2 launch' command.
+
+Two launch arguments are required:
+* benchmark - path to player benchmark description in yaml format ('benchmark:=<PATH>'),
+* producers - path to producers description in yaml format ('producers:=<PATH>').
+
+For every cross section of the parameters of the benchmark description, a 'player_benchmark'
+node writes a bag with the messages of the producers, plays it back to subscriptions measuring
+the played messages and appends its results to the summary result file. The nodes are launched
+one after another.
+"""
+
+import datetime
+import pathlib
+import shutil
+import sys
+
+import launch
+import launch_ros
+
+import yaml
+
+_player_nodes = []
+_player_idx = 0
+
+
+def _parse_arguments(args=sys.argv[4:]):
+    """Parse benchmark and producers config file paths."""
+    bench_cfg_path = None
+    producers_cfg_path = None
+    err_str = 'Missing or invalid arguments detected. ' \
+        'Launchfile requires "benchmark:=" and "producers:=" arguments ' \
+        'with coresponding config files.'
+
+    if len(args) != 2:
+        raise RuntimeError(err_str)
+
+    for arg in args:
+        if 'benchmark:=' in arg:
+            bench_cfg_path = pathlib.Path(arg.replace('benchmark:=', ''))
+            if not bench_cfg_path.is_file():
+                raise RuntimeError(
+                    'Batch config file {} does not exist.'.format(bench_cfg_path)
+                )
+        elif 'producers:=' in arg:
+            producers_cfg_path = pathlib.Path(arg.replace('producers:=', ''))
+            if not producers_cfg_path.is_file():
+                raise RuntimeError(
+                    'Producers config file {} does not exist.'.format(producers_cfg_path)
+                )
+        else:
+            raise RuntimeError(err_str)
+    return bench_cfg_path, producers_cfg_path
+
+
+def _launch_next_player():
+    """Launch the next player node, or finish the benchmark after the last one."""
+    if _player_idx == len(_player_nodes):
+        return [launch.actions.LogInfo(msg='Benchmark finished!')]
+    return [
+        launch.actions.LogInfo(
+            msg='-----------{}/{}-----------'.format(_player_idx + 1, len(_player_nodes))
+        ),
+        _player_nodes[_player_idx]['node'],
+    ]
+
+
+def _player_node_exited(event, context):
+    """Remove the bag of the finished node unless preserved, and launch the next node."""
+    global _player_idx
+    player = _player_nodes[_player_idx]
+    if event.returncode != 0:
+        return [
+            launch.actions.LogInfo(msg='Player benchmark error. Shutting down benchmark. '
+                                       'Return code = ' + str(event.returncode)),
+            launch.actions.EmitEvent(
+                event=launch.events.Shutdown(reason='Player benchmark error')
+            )
+        ]
+    if not player['preserve_bag']:
+        shutil.rmtree(player['bag_folder'], ignore_errors=True)
+    _player_idx += 1
+    return _launch_next_player()
+
+
+def generate_launch_description():
+    """Generate launch description for ros2 launch system."""
+    bench_cfg_path, producers_cfg_path = _parse_arguments()
+
+    with open(bench_cfg_path, 'r') as config_file:
+        bench_cfg_yaml = yaml.load(config_file, Loader=yaml.FullLoader)
+        bench_cfg = (bench_cfg_yaml['rosbag2_performance_benchmarking']
+                                   ['benchmark_node']
+                                   ['ros__parameters'])
+    benchmark_params = bench_cfg['benchmark']
+    repeat_each = benchmark_params.get('repeat_each', 1)
+    bag_root_folder = benchmark_params.get('bag_root_folder')
+    summary_result_file = benchmark_params.get('summary_result_file')
+    preserve_bags = benchmark_params.get('preserve_bags', False)
+    player_params = benchmark_params['parameters']
+
+    benchmark_dir_name = '{}_{}_{}'.format(
+        pathlib.Path(bench_cfg_path).stem,
+        pathlib.Path(producers_cfg_path).stem,
+        datetime.datetime.now().strftime('%Y-%m-%d_%H-%M-%S'))
+    benchmark_dir = pathlib.Path(bag_root_folder).joinpath(benchmark_dir_name)
+    result_file = benchmark_dir.joinpath(summary_result_file)
+
+    ld = launch.LaunchDescription()
+    ld.add_action(launch.actions.LogInfo(msg='Launching player benchmark!'))
+
+    for i in range(repeat_each):
+        for storage in player_params.get('storage_id', ['']):
+            for compression in player_params.get('compression', ['']):
+                for read_ahead in player_params.get('read_ahead_queue_size', [1000]):
+                    for rate in player_params.get('rate', [1.0]):
+                        bag_folder = benchmark_dir.joinpath(
+                            'run_{}_{}_{}_{}_{}'.format(
+                                i, storage,
+                                compression if compression else 'default_compression',
+                                read_ahead, rate))
+                        parameters = [
+                            str(producers_cfg_path),
+                            {'bag_folder': str(bag_folder)},
+                            {'results_file': str(result_file)},
+                            {'read_ahead_queue_size': read_ahead},
+                            {'rate': float(rate)},
+                            {'receive_timeout':
+                                float(benchmark_params.get('receive_timeout', 1.0))},
+                        ]
+                        if storage:
+                            parameters.append({'storage_id': storage})
+                        if compression:
+                            parameters.append({'compression_format': compression})
+
+                        node = launch_ros.actions.Node(
+                            package='rosbag2_performance_benchmarking',
+                            executable='player_benchmark',
+                            name='rosbag2_performance_benchmarking_node',
+                            parameters=parameters
+                        )
+                        _player_nodes.append({
+                            'node': node,
+                            'bag_folder': str(bag_folder),
+                            'preserve_bag': preserve_bags,
+                        })
+                        ld.add_action(
+                            launch.actions.RegisterEventHandler(
+                                launch.event_handlers.OnProcessExit(
+                                    target_action=node,
+                                    on_exit=_player_node_exited
+                                )
+                            )
+                        )
+
+    benchmark_dir.mkdir(parents=True, exist_ok=True)
+    shutil.copy(str(bench_cfg_path), str(benchmark_dir.joinpath('benchmark.yaml')))
+    shutil.copy(str(producers_cfg_path), str(benchmark_dir.joinpath('producers.yaml')))
+
+    for action in _launch_next_player():
+        ld.add_action(action)
+    return ld
+
+
+if __name__ == '__main__':
+    raise RuntimeError('Benchmark launchfile does not support standalone execution.')
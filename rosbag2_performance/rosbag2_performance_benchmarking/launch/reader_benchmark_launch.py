@@ -0,0 +1,195 @@
+# Copyright 2024 Open Source Robotics Foundation, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Launchfile for benchmarking reading and playing back rosbag2 bags.
+
+This launchfile can only be launched with 'ros2 launch' command.
+
+Two launch arguments are required:
+* benchmark - path to reader benchmark description in yaml format ('benchmark:=<PATH>'),
+* producers - path to producers description in yaml format ('producers:=<PATH>').
+
+For every cross section of the parameters of the benchmark description, a 'reader_benchmark'
+node writes a bag with the messages of the producers, measures reading and playing it back and
+appends its results to the summary result file. The nodes are launched one after another.
+"""
+
+import datetime
+import pathlib
+import shutil
+import sys
+
+from ament_index_python import get_package_share_directory
+import launch
+import launch_ros
+
+import yaml
+
+_reader_nodes = []
+_reader_idx = 0
+
+
+def _parse_arguments(args=sys.argv[4:]):
+    """Parse benchmark and producers config file paths."""
+    bench_cfg_path = None
+    producers_cfg_path = None
+    err_str = 'Missing or invalid arguments detected. ' \
+        'Launchfile requires "benchmark:=" and "producers:=" arguments ' \
+        'with coresponding config files.'
+
+    if len(args) != 2:
+        raise RuntimeError(err_str)
+
+    for arg in args:
+        if 'benchmark:=' in arg:
+            bench_cfg_path = pathlib.Path(arg.replace('benchmark:=', ''))
+            if not bench_cfg_path.is_file():
+                raise RuntimeError(
+                    'Batch config file {} does not exist.'.format(bench_cfg_path)
+                )
+        elif 'producers:=' in arg:
+            producers_cfg_path = pathlib.Path(arg.replace('producers:=', ''))
+            if not producers_cfg_path.is_file():
+                raise RuntimeError(
+                    'Producers config file {} does not exist.'.format(producers_cfg_path)
+                )
+        else:
+            raise RuntimeError(err_str)
+    return bench_cfg_path, producers_cfg_path
+
+
+def _launch_next_reader():
+    """Launch the next reader node, or finish the benchmark after the last one."""
+    if _reader_idx == len(_reader_nodes):
+        return [launch.actions.LogInfo(msg='Benchmark finished!')]
+    return [
+        launch.actions.LogInfo(
+            msg='-----------{}/{}-----------'.format(_reader_idx + 1, len(_reader_nodes))
+        ),
+        _reader_nodes[_reader_idx]['node'],
+    ]
+
+
+def _reader_node_exited(event, context):
+    """Remove the bag of the finished node unless preserved, and launch the next node."""
+    global _reader_idx
+    reader = _reader_nodes[_reader_idx]
+    if event.returncode != 0:
+        return [
+            launch.actions.LogInfo(msg='Reader benchmark error. Shutting down benchmark. '
+                                       'Return code = ' + str(event.returncode)),
+            launch.actions.EmitEvent(
+                event=launch.events.Shutdown(reason='Reader benchmark error')
+            )
+        ]
+    if not reader['preserve_bag']:
+        shutil.rmtree(reader['bag_folder'], ignore_errors=True)
+    _reader_idx += 1
+    return _launch_next_reader()
+
+
+def generate_launch_description():
+    """Generate launch description for ros2 launch system."""
+    bench_cfg_path, producers_cfg_path = _parse_arguments()
+
+    with open(bench_cfg_path, 'r') as config_file:
+        bench_cfg_yaml = yaml.load(config_file, Loader=yaml.FullLoader)
+        bench_cfg = (bench_cfg_yaml['rosbag2_performance_benchmarking']
+                                   ['benchmark_node']
+                                   ['ros__parameters'])
+    benchmark_params = bench_cfg['benchmark']
+    repeat_each = benchmark_params.get('repeat_each', 1)
+    bag_root_folder = benchmark_params.get('bag_root_folder')
+    summary_result_file = benchmark_params.get('summary_result_file')
+    preserve_bags = benchmark_params.get('preserve_bags', False)
+    reader_params = benchmark_params['parameters']
+
+    benchmark_dir_name = '{}_{}_{}'.format(
+        pathlib.Path(bench_cfg_path).stem,
+        pathlib.Path(producers_cfg_path).stem,
+        datetime.datetime.now().strftime('%Y-%m-%d_%H-%M-%S'))
+    benchmark_dir = pathlib.Path(bag_root_folder).joinpath(benchmark_dir_name)
+    result_file = benchmark_dir.joinpath(summary_result_file)
+
+    ld = launch.LaunchDescription()
+    ld.add_action(launch.actions.LogInfo(msg='Launching reader benchmark!'))
+
+    for i in range(repeat_each):
+        for storage in reader_params.get('storage_id', ['']):
+            for compression in reader_params.get('compression', ['']):
+                for storage_config in reader_params.get('storage_config_file', ['']):
+                    for max_bag_size in reader_params.get('max_bag_size', [0]):
+                        bag_folder = benchmark_dir.joinpath(
+                            'run_{}_{}_{}_{}_{}'.format(
+                                i, storage,
+                                compression if compression else 'default_compression',
+                                pathlib.Path(storage_config).stem
+                                if storage_config else 'default_config',
+                                max_bag_size))
+                        parameters = [
+                            str(producers_cfg_path),
+                            {'bag_folder': str(bag_folder)},
+                            {'results_file': str(result_file)},
+                            {'max_bag_size': max_bag_size},
+                            {'seek_count': benchmark_params.get('seek_count', 100)},
+                            {'filter_selectivities':
+                                benchmark_params.get('filter_selectivities', [0.01, 0.1, 0.5])},
+                            {'measure_play_timing':
+                                benchmark_params.get('measure_play_timing', True)},
+                        ]
+                        if storage:
+                            parameters.append({'storage_id': storage})
+                        if compression:
+                            parameters.append({'compression_format': compression})
+                        if storage_config:
+                            storage_conf_path = pathlib.Path(
+                                get_package_share_directory('rosbag2_performance_benchmarking')
+                            ).joinpath('config', 'storage', storage_config)
+                            if not storage_conf_path.exists():
+                                raise RuntimeError(
+                                    'Config {} does not exist.'.format(storage_config))
+                            parameters.append({'storage_config_file': str(storage_conf_path)})
+
+                        node = launch_ros.actions.Node(
+                            package='rosbag2_performance_benchmarking',
+                            executable='reader_benchmark',
+                            name='rosbag2_performance_benchmarking_node',
+                            parameters=parameters
+                        )
+                        _reader_nodes.append({
+                            'node': node,
+                            'bag_folder': str(bag_folder),
+                            'preserve_bag': preserve_bags,
+                        })
+                        ld.add_action(
+                            launch.actions.RegisterEventHandler(
+                                launch.event_handlers.OnProcessExit(
+                                    target_action=node,
+                                    on_exit=_reader_node_exited
+                                )
+                            )
+                        )
+
+    benchmark_dir.mkdir(parents=True, exist_ok=True)
+    shutil.copy(str(bench_cfg_path), str(benchmark_dir.joinpath('benchmark.yaml')))
+    shutil.copy(str(producers_cfg_path), str(benchmark_dir.joinpath('producers.yaml')))
+
+    for action in _launch_next_reader():
+        ld.add_action(action)
+    return ld
+
+
+if __name__ == '__main__':
+    raise RuntimeError('Benchmark launchfile does not support standalone execution.')
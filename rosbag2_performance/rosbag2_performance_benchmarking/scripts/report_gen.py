@@ -18,8 +18,11 @@
 
 import argparse
 import csv
+import json
+import math
 import pathlib
 import statistics
+import sys
 
 import yaml
 
@@ -158,6 +161,69 @@ class PostprocessStorageConfig(Postprocess):
         ]
 
 
+class PostprocessResources(Postprocess):
+    """
+    Postprocess.
+
+    Summarize resources used by the recorder in every benchmark run, from the summaries in the
+    results file and from the time series of resource samples next to the bags of the runs.
+    """
+
+    _SUMMARY_COLUMNS = [
+        'peak_rss_mb', 'average_rss_mb', 'write_mb_per_s', 'read_mb_per_s',
+        'context_switches_per_s', 'fsync_p50_ms', 'fsync_p99_ms', 'fsync_max_ms',
+        'busiest_thread_cpu_usage'
+    ]
+
+    def __init__(self, benchmark_dir):
+        self.__benchmark_dir = pathlib.Path(benchmark_dir)
+
+    def process(self, grouped_data, benchmark_config, producers_config):
+        """
+        Print averages of resource summaries and the busiest threads of every run.
+
+        :param: grouped data List of grouped results, as for PostprocessStorageConfig.
+        :param: benchmark_config Benchmark description from yaml config.
+        :param: producers_config Producers description from yaml config.
+        """
+        # Results written before resources were sampled have no summary columns
+        runs = [pub_groups[0] for pub_groups in grouped_data
+                if self._SUMMARY_COLUMNS[0] in pub_groups[0]]
+        if runs:
+            print('Recorder resources, average over {} runs:'.format(len(runs)))
+            for column in self._SUMMARY_COLUMNS:
+                values = [float(run[column]) for run in runs]
+                print('\t{}: average {:.2f}, min {:.2f}, max {:.2f}'.format(
+                    column, statistics.mean(values), min(values), max(values)))
+
+        for resources_path in sorted(self.__benchmark_dir.glob('*_resources.csv')):
+            run_title = resources_path.name[:-len('_resources.csv')]
+            with open(resources_path, mode='r') as fp:
+                samples = list(csv.DictReader(fp, delimiter=' '))
+            if not samples:
+                continue
+            print('\t{}: {} samples, peak rss {:.2f} MB, peak write {:.2f} MB/s'.format(
+                run_title,
+                len(samples),
+                max(float(sample['rss_mb']) for sample in samples),
+                max(float(sample['write_mb_per_s']) for sample in samples)))
+
+            threads_path = resources_path.with_name(run_title + '_threads.csv')
+            if not threads_path.is_file():
+                continue
+            thread_usage = {}
+            with open(threads_path, mode='r') as fp:
+                for sample in csv.DictReader(fp, delimiter=' '):
+                    key = (sample['tid'], sample['name'])
+                    thread_usage.setdefault(key, []).append(float(sample['cpu_usage']))
+            busiest = sorted(
+                thread_usage.items(), key=lambda item: statistics.mean(item[1]), reverse=True)
+            for (tid, name), usage in busiest[:3]:
+                print('\t\tthread {} ({}) - average cpu: {:.2f}%, max cpu: {:.2f}%'.format(
+                    name, tid, statistics.mean(usage), max(usage)))
+        print('======================== end of resources ========================')
+
+
 class Report:
     """Report generator main class."""
 
@@ -175,6 +241,12 @@ class Report:
             self.__benchmark_config,
             self.__producers_config
         )
+        resources = PostprocessResources(self.__benchmark_dir)
+        resources.process(
+            self.__results_data,
+            self.__benchmark_config,
+            self.__producers_config
+        )
 
     def __load_configs(self):
         producers_config_path = pathlib.Path(self.__benchmark_dir).joinpath('producers.yaml')
@@ -215,14 +287,226 @@ class Report:
             self.__results_data = results_grouped
 
 
+def _continued_fraction_beta(a, b, x):
+    """Continued fraction of the regularized incomplete beta function (Lentz's method)."""
+    tiny = 1e-30
+    c = 1.0
+    d = 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 200):
+        for numerator in (m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m)),
+                          -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def _incomplete_beta(a, b, x):
+    """Regularized incomplete beta function I_x(a, b)."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+                     a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * _continued_fraction_beta(a, b, x) / a
+    return 1.0 - front * _continued_fraction_beta(b, a, 1.0 - x) / b
+
+
+def welch_t_test(baseline, current):
+    """
+    Two-sided p-value of Welch's t-test that both samples have the same mean.
+
+    :return: p-value, or None if either sample has less than two values.
+    """
+    if len(baseline) < 2 or len(current) < 2:
+        return None
+    standard_error_2 = (statistics.variance(baseline) / len(baseline) +
+                        statistics.variance(current) / len(current))
+    difference = statistics.mean(current) - statistics.mean(baseline)
+    if standard_error_2 == 0:
+        return 1.0 if difference == 0 else 0.0
+    t = difference / math.sqrt(standard_error_2)
+    degrees_of_freedom = standard_error_2 ** 2 / (
+        (statistics.variance(baseline) / len(baseline)) ** 2 / (len(baseline) - 1) +
+        (statistics.variance(current) / len(current)) ** 2 / (len(current) - 1))
+    return _incomplete_beta(
+        degrees_of_freedom / 2, 0.5, degrees_of_freedom / (degrees_of_freedom + t * t))
+
+
+class ResultSet:
+    """
+    Machine readable results of a benchmark, for storing and comparing them across runs.
+
+    Results are samples of metrics, one per repetition, for every configuration. A configuration
+    is a combination of benchmark parameters and a publisher group.
+    """
+
+    FORMAT_VERSION = 1
+
+    # Columns of the results file which identify a configuration
+    KEY_COLUMNS = [
+        'storage_id', 'instances', 'frequency', 'message_size', 'total_messages_sent',
+        'cache_size', 'max_bagfile_size', 'storage_config', 'compression', 'compression_queue',
+        'compression_threads'
+    ]
+
+    # Metrics and whether higher values are better
+    METRICS = {
+        'recorded_ratio': True,
+        'producer_cpu_usage': False,
+        'recorder_cpu_usage': False,
+        'peak_rss_mb': False,
+        'fsync_p99_ms': False,
+        'busiest_thread_cpu_usage': False,
+    }
+
+    def __init__(self, name, configurations):
+        self.name = name
+        # Configuration key tuple -> metric name -> list of samples
+        self.configurations = configurations
+
+    @classmethod
+    def load(cls, path):
+        """Load results from a benchmark result directory or an exported json file."""
+        path = pathlib.Path(path)
+        if path.is_dir():
+            return cls.__load_results_file(path)
+        with open(path, 'r') as fp:
+            exported = json.load(fp)
+        if exported.get('format_version') != cls.FORMAT_VERSION:
+            raise RuntimeError('Unsupported results format version in {}'.format(path))
+        configurations = {
+            tuple(configuration['key'][column] for column in cls.KEY_COLUMNS):
+                configuration['metrics']
+            for configuration in exported['configurations']
+        }
+        return cls(exported['name'], configurations)
+
+    @classmethod
+    def __load_results_file(cls, benchmark_dir):
+        configurations = {}
+        with open(benchmark_dir.joinpath('results.csv'), mode='r') as fp:
+            for row in csv.DictReader(fp, delimiter=' '):
+                # Storage configs are files in the install space, only their name is comparable
+                row['storage_config'] = pathlib.Path(row['storage_config']).name
+                key = tuple(row.get(column, '') for column in cls.KEY_COLUMNS)
+                metrics = configurations.setdefault(key, {})
+                metrics.setdefault('recorded_ratio', []).append(
+                    int(row['total_recorded_count']) / max(int(row['total_produced']), 1))
+                for metric in cls.METRICS:
+                    if metric in row:
+                        metrics.setdefault(metric, []).append(float(row[metric]))
+        return cls(benchmark_dir.name, configurations)
+
+    def export(self, path):
+        """Write results to a json file, to be used as a baseline later."""
+        exported = {
+            'format_version': self.FORMAT_VERSION,
+            'name': self.name,
+            'configurations': [
+                {'key': dict(zip(self.KEY_COLUMNS, key)), 'metrics': metrics}
+                for key, metrics in sorted(self.configurations.items())
+            ]
+        }
+        with open(path, 'w') as fp:
+            json.dump(exported, fp, indent=2)
+
+
+class Comparison:
+    """Compare results against a baseline and flag significant regressions."""
+
+    def __init__(self, baseline, current, threshold, alpha):
+        """
+        Initialize comparison.
+
+        :param: threshold Relative change of the mean of a metric for the worse, beyond which
+            it is a regression.
+        :param: alpha Significance level of the change over repetitions. Changes of metrics with
+            less than two repetitions on either side are flagged on the threshold alone.
+        """
+        self.__baseline = baseline
+        self.__current = current
+        self.__threshold = threshold
+        self.__alpha = alpha
+
+    def compare(self):
+        """Print changes of all metrics per configuration, return the number of regressions."""
+        regressions = 0
+        print('Comparing {} against baseline {}'.format(
+            self.__current.name, self.__baseline.name))
+        for key, current_metrics in sorted(self.__current.configurations.items()):
+            baseline_metrics = self.__baseline.configurations.get(key)
+            description = ', '.join(
+                '{}={}'.format(column, value)
+                for column, value in zip(ResultSet.KEY_COLUMNS, key) if value != '')
+            if baseline_metrics is None:
+                print('\t{}: not in baseline'.format(description))
+                continue
+            print('\t{}:'.format(description))
+            for metric, higher_is_better in ResultSet.METRICS.items():
+                if metric not in current_metrics or metric not in baseline_metrics:
+                    continue
+                regressions += self.__compare_metric(
+                    metric, higher_is_better, baseline_metrics[metric], current_metrics[metric])
+        missing = set(self.__baseline.configurations) - set(self.__current.configurations)
+        for key in sorted(missing):
+            print('\tmissing configuration of baseline: {}'.format(
+                dict(zip(ResultSet.KEY_COLUMNS, key))))
+        print('{} regressions found'.format(regressions))
+        return regressions
+
+    def __compare_metric(self, metric, higher_is_better, baseline, current):
+        baseline_mean = statistics.mean(baseline)
+        current_mean = statistics.mean(current)
+        if baseline_mean != 0:
+            change = (current_mean - baseline_mean) / abs(baseline_mean)
+        else:
+            change = 0.0 if current_mean == 0 else math.copysign(math.inf, current_mean)
+        worse = -change if higher_is_better else change
+        p_value = welch_t_test(baseline, current)
+        significant = p_value is None or p_value < self.__alpha
+        regression = worse > self.__threshold and significant
+        print('\t\t{}: {:.4g} -> {:.4g} ({:+.2%}, p={}){}'.format(
+            metric, baseline_mean, current_mean, change,
+            'n/a' if p_value is None else '{:.3f}'.format(p_value),
+            ' REGRESSION' if regression else ''))
+        return 1 if regression else 0
+
+
 if __name__ == '__main__':
     parser = argparse.ArgumentParser()
     parser.add_argument('-i', '--input', help='Benchmark results folder.')
+    parser.add_argument('-e', '--export',
+                        help='Write machine readable results of the input to this json file.')
+    parser.add_argument('-b', '--baseline',
+                        help='Compare the input against this benchmark results folder or '
+                             'exported json file, exits with 1 if there are regressions.')
+    parser.add_argument('-t', '--threshold', type=float, default=5.0,
+                        help='Change for the worse in percent beyond which a metric regressed.')
+    parser.add_argument('-a', '--alpha', type=float, default=0.05,
+                        help='Significance level of regressions over repeated runs.')
     args = parser.parse_args()
     benchmark_dir = args.input
 
     if benchmark_dir:
-        raport = Report(benchmark_dir)
-        raport.generate()
+        if args.export or args.baseline:
+            results = ResultSet.load(benchmark_dir)
+            if args.export:
+                results.export(args.export)
+            if args.baseline:
+                comparison = Comparison(
+                    ResultSet.load(args.baseline), results, args.threshold / 100, args.alpha)
+                sys.exit(1 if comparison.compare() > 0 else 0)
+        else:
+            raport = Report(benchmark_dir)
+            raport.generate()
     else:
         parser.print_help()
@@ -0,0 +1,131 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_performance_benchmarking/bag_utils.hpp"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/serialization.hpp"
+#include "rmw/rmw.h"
+#include "rosbag2_compression/sequential_compression_writer.hpp"
+#include "rosbag2_cpp/writers/sequential_writer.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
+
+namespace bag_utils
+{
+
+std::vector<std::string> write_synthetic_bag(
+  const std::vector<PublisherGroupConfig> & publisher_groups_config,
+  const BagConfig & bag_config)
+{
+  std::unique_ptr<rosbag2_cpp::writers::SequentialWriter> writer;
+  if (!bag_config.compression_format.empty()) {
+    rosbag2_compression::CompressionOptions compression_options{
+      bag_config.compression_format, rosbag2_compression::CompressionMode::MESSAGE,
+      bag_config.compression_queue_size, bag_config.compression_threads, std::nullopt};
+    writer = std::make_unique<rosbag2_compression::SequentialCompressionWriter>(
+      compression_options);
+  } else {
+    writer = std::make_unique<rosbag2_cpp::writers::SequentialWriter>();
+  }
+  const std::string serialization_format = rmw_get_serialization_format();
+  writer->open(bag_config.storage_options, {serialization_format, serialization_format});
+
+  // Messages of a topic are written as if they were received at the rate of the topic
+  struct TopicState
+  {
+    std::string name;
+    rosbag2_performance_benchmarking_msgs::msg::ByteArray message;
+    rcutils_time_point_value_t period;
+    unsigned int remaining;
+  };
+  std::vector<TopicState> topics;
+  std::vector<std::string> topic_names;
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+  for (const auto & c : publisher_groups_config) {
+    for (unsigned int i = 0; i < c.count; ++i) {
+      TopicState topic{
+        c.topic_root + "_" + std::to_string(i + 1), {},
+        static_cast<rcutils_time_point_value_t>(1e9 / c.producer_config.frequency),
+        c.producer_config.max_count};
+      topic.message.data.resize(c.producer_config.message_size);
+      for (auto & byte : topic.message.data) {
+        byte = static_cast<uint8_t>(byte_distribution(generator));
+      }
+      rosbag2_storage::TopicMetadata metadata;
+      metadata.name = topic.name;
+      metadata.type = "rosbag2_performance_benchmarking_msgs/msg/ByteArray";
+      metadata.serialization_format = serialization_format;
+      metadata.offered_qos_profiles = {c.qos};
+      writer->create_topic(metadata);
+      topic_names.push_back(topic.name);
+      topics.push_back(std::move(topic));
+    }
+  }
+
+  using NextMessage = std::pair<rcutils_time_point_value_t, size_t>;
+  std::priority_queue<NextMessage, std::vector<NextMessage>, std::greater<NextMessage>> next;
+  const rcutils_time_point_value_t start_time = 1'000'000'000;
+  for (size_t i = 0; i < topics.size(); ++i) {
+    if (topics[i].remaining > 0) {
+      next.push({start_time, i});
+    }
+  }
+  rclcpp::Serialization<rosbag2_performance_benchmarking_msgs::msg::ByteArray> serialization;
+  rclcpp::SerializedMessage payload;
+  while (!next.empty()) {
+    const auto [time_stamp, index] = next.top();
+    next.pop();
+    auto & topic = topics[index];
+    if (topic.message.data.size() >= sizeof(time_stamp)) {
+      std::memcpy(topic.message.data.data(), &time_stamp, sizeof(time_stamp));
+    }
+    serialization.serialize_message(&topic.message, &payload);
+    const auto & serialized = payload.get_rcl_serialized_message();
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic.name;
+    message->time_stamp = time_stamp;
+    message->serialized_data =
+      rosbag2_storage::make_serialized_message(serialized.buffer, serialized.buffer_length);
+    writer->write(message);
+    if (--topic.remaining > 0) {
+      next.push({time_stamp + topic.period, index});
+    }
+  }
+  writer->close();
+  return topic_names;
+}
+
+std::optional<rcutils_time_point_value_t> get_synthetic_time_stamp(
+  const std::vector<uint8_t> & data)
+{
+  rcutils_time_point_value_t time_stamp;
+  if (data.size() < sizeof(time_stamp)) {
+    return std::nullopt;
+  }
+  std::memcpy(&time_stamp, data.data(), sizeof(time_stamp));
+  return time_stamp;
+}
+
+}  // namespace bag_utils
@@ -12,16 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
 #include <exception>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "rosbag2_performance_benchmarking/byte_producer.hpp"
 #include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/load_profile_utils.hpp"
 #include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
+#include "rosbag2_performance_benchmarking/rate_pacer.hpp"
 #include "rosbag2_performance_benchmarking/thread_pool.hpp"
 
+#include "msg_utils/load_profile_message_producer.hpp"
 #include "msg_utils/message_producer_factory.hpp"
 
 #include "rclcpp/executors/single_threaded_executor.hpp"
@@ -59,7 +64,10 @@ private:
   {
     std::shared_ptr<msg_utils::ProducerBase> msg_producer;
     std::promise<void> promise_finished;
-    std::chrono::milliseconds period{0};
+    std::optional<RatePacer> pacer;
+    // Times of messages since the start when replaying a load profile, the pacer is not used then
+    std::chrono::steady_clock::time_point start_time;
+    std::vector<std::chrono::nanoseconds> offsets;
     size_t produced_messages = 0;
     size_t max_messages = 0;
 
@@ -81,24 +89,40 @@ private:
 
   void create_benchmark_producers()
   {
-    const auto configurations = config_utils::publisher_groups_from_node_parameters(*this);
+    const auto load_profile = load_profile_utils::load_profile_from_node_parameters(*this);
+    const auto configurations = load_profile ?
+      load_profile_utils::publisher_groups_from_load_profile(*load_profile) :
+      config_utils::publisher_groups_from_node_parameters(*this);
 
     if (configurations.empty()) {
       RCLCPP_ERROR(get_logger(), "No publishers/producers found in node parameters");
       return;
     }
 
+    spin_wait_ = config_utils::get_spin_wait_from_node_parameters(*this);
     const std::string node_name(get_fully_qualified_name());
-    const auto when_to_start = std::chrono::high_resolution_clock::now() + std::chrono::seconds(1);
+    const auto when_to_start = std::chrono::steady_clock::now() + std::chrono::seconds(1);
 
     size_t total_producers_number = 0U;
-    for (auto & config : configurations) {
-      for (unsigned int i = 0; i < config.count; ++i) {
-        const std::string topic = node_name + "/" + config.topic_root + "_" + std::to_string(i + 1);
-        auto producer = create_benchmark_producer(topic, config, when_to_start);
+    if (load_profile) {
+      // One publisher per topic of the profile, each with its own times and sizes of messages
+      for (size_t i = 0; i < configurations.size(); ++i) {
+        const std::string topic = node_name + "/" + configurations[i].topic_root + "_1";
+        auto producer = create_load_profile_producer(
+          topic, configurations[i], load_profile->topics[i], when_to_start);
         producers_.push_back(producer);
         total_producers_number++;
       }
+    } else {
+      for (auto & config : configurations) {
+        for (unsigned int i = 0; i < config.count; ++i) {
+          const std::string topic =
+            node_name + "/" + config.topic_root + "_" + std::to_string(i + 1);
+          auto producer = create_benchmark_producer(topic, config, when_to_start);
+          producers_.push_back(producer);
+          total_producers_number++;
+        }
+      }
     }
 
     number_of_threads_ = config_utils::get_number_of_threads_from_node_parameters(*this);
@@ -111,42 +135,73 @@ private:
   std::shared_ptr<BenchmarkProducer> create_benchmark_producer(
     std::string topic,
     const PublisherGroupConfig & config,
-    std::chrono::time_point<std::chrono::high_resolution_clock> initial_time)
+    std::chrono::steady_clock::time_point initial_time)
   {
     const auto & producer_config = config.producer_config;
     auto producer = std::make_shared<BenchmarkProducer>();
 
     producer->msg_producer = msg_utils::create(producer_config.message_type, *this, topic, config);
     producer->max_messages = producer_config.max_count;
-    producer->period = std::chrono::milliseconds(
-      producer_config.frequency ? 1000 / producer_config.frequency : 1);
+    producer->pacer.emplace(producer_config.frequency, spin_wait_, initial_time);
+
+    if (producer->max_messages > 0) {
+      thread_pool_.queue(
+        [this, producer] {
+          producer_job(producer);
+        });
+    }
+
+    return producer;
+  }
+
+  std::shared_ptr<BenchmarkProducer> create_load_profile_producer(
+    std::string topic,
+    const PublisherGroupConfig & config,
+    const LoadProfileTopic & profile_topic,
+    std::chrono::steady_clock::time_point initial_time)
+  {
+    auto producer = std::make_shared<BenchmarkProducer>();
+
+    producer->msg_producer =
+      std::make_shared<msg_utils::LoadProfileMessageProducer>(*this, topic, profile_topic);
+    producer->max_messages = config.producer_config.max_count;
+    producer->start_time = initial_time;
+    producer->offsets = profile_topic.offsets;
 
     if (producer->max_messages > 0) {
       thread_pool_.queue(
-        [this, initial_time, producer] {
-          producer_job(initial_time, producer);
+        [this, producer] {
+          producer_job(producer);
         });
     }
 
     return producer;
   }
 
-  void producer_job(
-    std::chrono::time_point<std::chrono::high_resolution_clock> when,
-    std::shared_ptr<BenchmarkProducer> producer)
+  void producer_job(std::shared_ptr<BenchmarkProducer> producer)
   {
-    std::this_thread::sleep_until(when);
+    size_t batch_size = 1;
+    if (producer->offsets.empty()) {
+      producer->pacer->wait();
+      batch_size = producer->pacer->batch_size();
+    } else {
+      sleep_until_precisely(
+        producer->start_time + producer->offsets[producer->produced_messages], spin_wait_);
+    }
     if (!rclcpp::ok()) {
       producer->promise_finished.set_value();
       return;
     }
-    producer->produce();
+    for (size_t i = 0; i < batch_size && producer->produced_messages < producer->max_messages;
+      ++i)
+    {
+      producer->produce();
+    }
 
     if (producer->produced_messages < producer->max_messages) {
       thread_pool_.queue(
-        [this, next_timestamp = when + producer->period,
-        producer] {
-          producer_job(next_timestamp, producer);
+        [this, producer] {
+          producer_job(producer);
         });
     } else {
       producer->promise_finished.set_value();
@@ -155,6 +210,7 @@ private:
 
   ThreadPool thread_pool_;
   size_t number_of_threads_;
+  std::chrono::nanoseconds spin_wait_{0};
   std::vector<std::shared_ptr<BenchmarkProducer>> producers_;
 };
 
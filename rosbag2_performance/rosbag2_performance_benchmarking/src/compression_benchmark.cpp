@@ -0,0 +1,429 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_compression/message_batch.hpp"
+#include "rosbag2_compression/sequential_compression_reader.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+#include "rosbag2_performance_benchmarking/compression_benchmark.hpp"
+#include "rosbag2_performance_benchmarking/result_utils.hpp"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double to_us(Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+double to_mb_per_s(size_t bytes, Clock::duration duration)
+{
+  const double seconds = std::chrono::duration<double>(duration).count();
+  return seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0;
+}
+
+size_t payload_size(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return message.serialized_data ? message.serialized_data->buffer_length : 0;
+}
+
+bool same_payload(
+  const rosbag2_storage::SerializedBagMessage & lhs,
+  const rosbag2_storage::SerializedBagMessage & rhs)
+{
+  const auto size = payload_size(lhs);
+  return size == payload_size(rhs) &&
+         (size == 0 ||
+         std::memcmp(lhs.serialized_data->buffer, rhs.serialized_data->buffer, size) == 0);
+}
+
+/// Message without payload, with the topic and time stamps of the message
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> copy_header(
+  const rosbag2_storage::SerializedBagMessage & message)
+{
+  auto copy = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  copy->time_stamp = message.time_stamp;
+  copy->send_timestamp = message.send_timestamp;
+  copy->topic_name = message.topic_name;
+  copy->sequence_number = message.sequence_number;
+  return copy;
+}
+
+/// Run the worker with the indices 0 to thread_count - 1 at once, the calling thread runs the
+/// first one. Rethrows the first exception of a worker.
+template<typename Worker>
+Clock::duration run_workers(size_t thread_count, const Worker & worker)
+{
+  std::vector<std::exception_ptr> errors(thread_count);
+  auto run = [&worker, &errors](size_t index) {
+      try {
+        worker(index);
+      } catch (...) {
+        errors[index] = std::current_exception();
+      }
+    };
+  const auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(run, i);
+  }
+  run(0);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  const auto duration = Clock::now() - start;
+  for (const auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return duration;
+}
+
+void set_latencies(
+  std::vector<double> & compress_latencies, std::vector<double> & decompress_latencies,
+  CompressionResults & results)
+{
+  results.compress_latency_p50_us = result_utils::percentile(compress_latencies, 0.5);
+  results.compress_latency_p90_us = result_utils::percentile(compress_latencies, 0.9);
+  results.compress_latency_p99_us = result_utils::percentile(compress_latencies, 0.99);
+  results.decompress_latency_p50_us = result_utils::percentile(decompress_latencies, 0.5);
+  results.decompress_latency_p90_us = result_utils::percentile(decompress_latencies, 0.9);
+  results.decompress_latency_p99_us = result_utils::percentile(decompress_latencies, 0.99);
+}
+}  // namespace
+
+CompressionBenchmark::CompressionBenchmark(const std::string & name)
+: rclcpp::Node(name)
+{
+  declare_parameter("bag_uri", "");
+  get_parameter("bag_uri", bag_uri_);
+  declare_parameter("storage_id", "");
+  get_parameter("storage_id", storage_id_);
+  declare_parameter("results_file", bag_uri_ + "/compression_results.csv");
+  get_parameter("results_file", results_file_);
+  declare_parameter(
+    "temporary_directory",
+    (std::filesystem::temp_directory_path() / "rosbag2_compression_benchmark").string());
+  get_parameter("temporary_directory", temporary_directory_);
+
+  // All declared compressor plugins if empty
+  declare_parameter("compression_formats", std::vector<std::string>{});
+  compression_formats_ = get_parameter("compression_formats").as_string_array();
+  if (compression_formats_.empty()) {
+    compression_formats_ = compression_factory_.get_declared_compressor_plugins();
+  }
+  // The default level of each compressor if empty
+  declare_parameter("compression_levels", std::vector<int64_t>{});
+  compression_levels_ = get_parameter("compression_levels").as_integer_array();
+  declare_parameter(
+    "compression_modes", std::vector<std::string>{"message", "batch", "file"});
+  for (const auto & mode : get_parameter("compression_modes").as_string_array()) {
+    const auto compression_mode = rosbag2_compression::compression_mode_from_string(mode);
+    if (compression_mode == rosbag2_compression::CompressionMode::NONE) {
+      throw std::invalid_argument("Unknown compression mode: " + mode);
+    }
+    compression_modes_.push_back(compression_mode);
+  }
+  declare_parameter("threads", std::vector<int64_t>{1});
+  threads_ = get_parameter("threads").as_integer_array();
+  // All messages of the topics if 0
+  declare_parameter("max_messages_per_topic", 1000);
+  max_messages_per_topic_ =
+    static_cast<size_t>(get_parameter("max_messages_per_topic").as_int());
+
+  RCLCPP_INFO(get_logger(), "configuration parameters processed");
+}
+
+void CompressionBenchmark::start_benchmark()
+{
+  if (bag_uri_.empty()) {
+    RCLCPP_ERROR(get_logger(), "No bag to benchmark, set the bag_uri parameter");
+    return;
+  }
+  if (compression_formats_.empty()) {
+    RCLCPP_ERROR(get_logger(), "No compressor plugins found");
+    return;
+  }
+  RCLCPP_INFO(get_logger(), "Starting the CompressionBenchmark");
+  read_messages();
+  std::filesystem::create_directories(temporary_directory_);
+
+  std::vector<std::optional<int32_t>> levels;
+  for (const auto level : compression_levels_) {
+    levels.emplace_back(static_cast<int32_t>(level));
+  }
+  if (levels.empty()) {
+    levels.emplace_back(std::nullopt);
+  }
+  for (const auto & format : compression_formats_) {
+    for (const auto & level : levels) {
+      for (const auto mode : compression_modes_) {
+        for (const auto threads : threads_) {
+          Settings settings;
+          settings.compression_format = format;
+          settings.compression_level = level;
+          settings.compression_mode = mode;
+          settings.threads = static_cast<size_t>(std::max<int64_t>(threads, 1));
+          for (const auto & topic : topic_messages_) {
+            try {
+              results_.push_back(measure(settings, topic.first));
+            } catch (const std::exception & e) {
+              RCLCPP_ERROR_STREAM(
+                get_logger(), "Compressing " << topic.first << " with " << format << " failed: " <<
+                  e.what());
+            }
+          }
+        }
+      }
+    }
+  }
+  result_utils::write_compression_benchmark_results(results_, results_file_);
+}
+
+void CompressionBenchmark::read_messages()
+{
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_uri_;
+  storage_options.storage_id = storage_id_;
+  const auto metadata = rosbag2_storage::MetadataIo().read_metadata(bag_uri_);
+  std::unique_ptr<rosbag2_cpp::Reader> reader;
+  if (!metadata.compression_format.empty()) {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_compression::SequentialCompressionReader>());
+  } else {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_cpp::readers::SequentialReader>());
+  }
+  reader->open(storage_options);
+
+  // Stop reading once every topic has its messages
+  size_t full_topics = 0;
+  while (reader->has_next() &&
+    (max_messages_per_topic_ == 0 || full_topics < metadata.topics_with_message_count.size()))
+  {
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message = reader->read_next();
+    auto & messages = topic_messages_[message->topic_name];
+    if (max_messages_per_topic_ != 0 && messages.size() >= max_messages_per_topic_) {
+      continue;
+    }
+    messages.push_back(std::move(message));
+    if (messages.size() == max_messages_per_topic_) {
+      ++full_topics;
+    }
+  }
+  RCLCPP_INFO_STREAM(get_logger(), "Read the messages of " << topic_messages_.size() << " topics");
+}
+
+std::shared_ptr<rosbag2_compression::BaseCompressorInterface>
+CompressionBenchmark::create_compressor(const Settings & settings)
+{
+  auto compressor = compression_factory_.create_compressor(settings.compression_format);
+  if (settings.compression_level) {
+    compressor->set_compression_level(*settings.compression_level);
+  }
+  return compressor;
+}
+
+CompressionResults CompressionBenchmark::measure(
+  const Settings & settings, const std::string & topic)
+{
+  const auto & messages = topic_messages_.at(topic);
+  CompressionResults results;
+  results.topic = topic;
+  results.compression_format = settings.compression_format;
+  results.compression_level = settings.compression_level ?
+    std::to_string(*settings.compression_level) : "default";
+  results.compression_mode = rosbag2_compression::compression_mode_to_string(
+    settings.compression_mode);
+  results.threads = settings.threads;
+  results.message_count = messages.size();
+  for (const auto & message : messages) {
+    results.uncompressed_bytes += payload_size(*message);
+  }
+
+  switch (settings.compression_mode) {
+    case rosbag2_compression::CompressionMode::MESSAGE:
+      measure_items(settings, messages, false, results);
+      break;
+    case rosbag2_compression::CompressionMode::BATCH:
+      {
+        const auto batches = rosbag2_compression::pack_message_batches(messages);
+        measure_items(settings, Messages(batches.begin(), batches.end()), true, results);
+        break;
+      }
+    default:
+      measure_file(settings, topic, messages, results);
+      break;
+  }
+  results.compression_ratio = results.compressed_bytes > 0 ?
+    static_cast<double>(results.uncompressed_bytes) /
+    static_cast<double>(results.compressed_bytes) : 0;
+
+  RCLCPP_INFO_STREAM(
+    get_logger(), topic << " " << results.compression_format << " level " <<
+      results.compression_level << " " << results.compression_mode << " " << results.threads <<
+      " threads: ratio " << results.compression_ratio << ", compress " <<
+      results.compress_mb_per_s << " MB/s p99 " << results.compress_latency_p99_us <<
+      " us, decompress " << results.decompress_mb_per_s << " MB/s p99 " <<
+      results.decompress_latency_p99_us << " us");
+  return results;
+}
+
+void CompressionBenchmark::measure_items(
+  const Settings & settings, const Messages & items, bool unpack, CompressionResults & results)
+{
+  if (items.empty()) {
+    return;
+  }
+  const size_t thread_count = std::min(settings.threads, items.size());
+  // Every thread has its own compressor and decompressor, as the compression threads of the
+  // writer do. They are created before the clock starts.
+  std::vector<std::shared_ptr<rosbag2_compression::BaseCompressorInterface>> compressors;
+  std::vector<std::shared_ptr<rosbag2_compression::BaseDecompressorInterface>> decompressors;
+  for (size_t i = 0; i < thread_count; ++i) {
+    compressors.push_back(create_compressor(settings));
+    decompressors.push_back(
+      compression_factory_.create_decompressor(settings.compression_format));
+  }
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> compressed(items.size());
+  std::vector<double> compress_latencies(items.size());
+  std::atomic_size_t next_item{0};
+  const auto compress_duration = run_workers(
+    thread_count, [&](size_t thread_index) {
+      auto & compressor = *compressors[thread_index];
+      for (size_t i = next_item++; i < items.size(); i = next_item++) {
+        auto compressed_item = copy_header(*items[i]);
+        const auto start = Clock::now();
+        compressor.compress_serialized_bag_message(items[i].get(), compressed_item.get());
+        compress_latencies[i] = to_us(Clock::now() - start);
+        compressed[i] = std::move(compressed_item);
+      }
+    });
+  for (const auto & item : compressed) {
+    results.compressed_bytes += payload_size(*item);
+  }
+
+  // Decompressed in place, into copies which share the compressed payloads
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> decompressed(items.size());
+  std::vector<double> decompress_latencies(items.size());
+  next_item = 0;
+  const auto decompress_duration = run_workers(
+    thread_count, [&](size_t thread_index) {
+      auto & decompressor = *decompressors[thread_index];
+      for (size_t i = next_item++; i < items.size(); i = next_item++) {
+        auto item = std::make_shared<rosbag2_storage::SerializedBagMessage>(*compressed[i]);
+        const auto start = Clock::now();
+        decompressor.decompress_serialized_bag_message(item.get());
+        if (unpack) {
+          // Reading a batch includes unpacking its messages
+          rosbag2_compression::unpack_message_batch(*item);
+        }
+        decompress_latencies[i] = to_us(Clock::now() - start);
+        decompressed[i] = std::move(item);
+      }
+    });
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (!same_payload(*items[i], *decompressed[i])) {
+      throw std::runtime_error("Decompressed data differs from the original data");
+    }
+  }
+  results.compress_mb_per_s = to_mb_per_s(results.uncompressed_bytes, compress_duration);
+  results.decompress_mb_per_s = to_mb_per_s(results.uncompressed_bytes, decompress_duration);
+  set_latencies(compress_latencies, decompress_latencies, results);
+}
+
+void CompressionBenchmark::measure_file(
+  const Settings & settings, const std::string & topic, const Messages & messages,
+  CompressionResults & results)
+{
+  auto file_name = topic;
+  std::replace(file_name.begin(), file_name.end(), '/', '_');
+  const auto uri = (std::filesystem::path(temporary_directory_) / (file_name + ".bin")).string();
+  {
+    std::ofstream file(uri, std::ios::out | std::ios::binary);
+    for (const auto & message : messages) {
+      if (payload_size(*message) > 0) {
+        file.write(
+          reinterpret_cast<const char *>(message->serialized_data->buffer),
+          static_cast<std::streamsize>(payload_size(*message)));
+      }
+    }
+    if (!file) {
+      throw std::runtime_error("Could not write file: " + uri);
+    }
+  }
+
+  // Files are compressed by one call, spread across the file compression workers
+  auto compressor = create_compressor(settings);
+  compressor->set_file_compression_workers(settings.threads - 1);
+  auto decompressor = compression_factory_.create_decompressor(settings.compression_format);
+
+  auto start = Clock::now();
+  const auto compressed_uri = compressor->compress_uri(uri);
+  const auto compress_duration = Clock::now() - start;
+  results.compressed_bytes = std::filesystem::file_size(compressed_uri);
+  std::filesystem::remove(uri);
+
+  start = Clock::now();
+  const auto decompressed_uri = decompressor->decompress_uri(compressed_uri);
+  const auto decompress_duration = Clock::now() - start;
+  const auto decompressed_bytes = std::filesystem::file_size(decompressed_uri);
+  std::filesystem::remove(compressed_uri);
+  std::filesystem::remove(decompressed_uri);
+  if (decompressed_bytes != results.uncompressed_bytes) {
+    throw std::runtime_error("Decompressed file differs in size from the original file");
+  }
+
+  results.compress_mb_per_s = to_mb_per_s(results.uncompressed_bytes, compress_duration);
+  results.decompress_mb_per_s = to_mb_per_s(results.uncompressed_bytes, decompress_duration);
+  std::vector<double> compress_latencies{to_us(compress_duration)};
+  std::vector<double> decompress_latencies{to_us(decompress_duration)};
+  set_latencies(compress_latencies, decompress_latencies, results);
+}
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  auto bench = std::make_shared<CompressionBenchmark>("rosbag2_performance_benchmarking_node");
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(bench);
+
+  // The benchmark has its own control loop but uses spinning for parameters
+  std::thread spin_thread([&executor]() {executor.spin();});
+  bench->start_benchmark();
+  RCLCPP_INFO(bench->get_logger(), "Benchmark terminated");
+  rclcpp::shutdown();
+  spin_thread.join();
+  return 0;
+}
@@ -14,6 +14,8 @@
 
 #include "rosbag2_performance_benchmarking/config_utils.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -67,6 +69,15 @@ size_t get_number_of_threads_from_node_parameters(rclcpp::Node & node)
   return number_of_threads;
 }
 
+std::chrono::nanoseconds get_spin_wait_from_node_parameters(rclcpp::Node & node)
+{
+  const std::string parameters_ns = "publishers";
+  node.declare_parameter<int>(parameters_ns + ".spin_wait_us", 0);
+  int spin_wait_us;
+  node.get_parameter(parameters_ns + ".spin_wait_us", spin_wait_us);
+  return std::chrono::microseconds(std::max(spin_wait_us, 0));
+}
+
 std::vector<PublisherGroupConfig> publisher_groups_from_node_parameters(
   rclcpp::Node & node)
 {
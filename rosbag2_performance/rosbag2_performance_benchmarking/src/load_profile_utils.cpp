@@ -0,0 +1,145 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_performance_benchmarking/load_profile_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_compression/sequential_compression_reader.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+#include "rosbag2_performance_benchmarking/config_utils.hpp"
+
+namespace load_profile_utils
+{
+
+LoadProfile read_load_profile(const std::string & uri, double rate, double size_scale)
+{
+  if (rate <= 0 || size_scale <= 0) {
+    throw std::invalid_argument("Rate and size scale of a load profile must be positive");
+  }
+  const auto metadata = rosbag2_storage::MetadataIo().read_metadata(uri);
+  std::unique_ptr<rosbag2_cpp::Reader> reader;
+  if (!metadata.compression_format.empty()) {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_compression::SequentialCompressionReader>());
+  } else {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_cpp::readers::SequentialReader>());
+  }
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = uri;
+  reader->open(storage_options);
+
+  LoadProfile profile;
+  std::unordered_map<std::string, size_t> topic_indices;
+  for (const auto & topic_info : metadata.topics_with_message_count) {
+    const auto & topic_metadata = topic_info.topic_metadata;
+    topic_indices[topic_metadata.name] = profile.topics.size();
+    LoadProfileTopic topic;
+    topic.name = topic_metadata.name;
+    if (!topic_metadata.offered_qos_profiles.empty()) {
+      topic.qos = topic_metadata.offered_qos_profiles.front();
+    }
+    topic.offsets.reserve(topic_info.message_count);
+    topic.sizes.reserve(topic_info.message_count);
+    profile.topics.push_back(std::move(topic));
+  }
+
+  const auto start_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    metadata.starting_time.time_since_epoch()).count();
+  while (reader->has_next()) {
+    const auto message = reader->read_next();
+    const auto topic_index = topic_indices.find(message->topic_name);
+    if (topic_index == topic_indices.end()) {
+      continue;
+    }
+    auto & topic = profile.topics[topic_index->second];
+    const auto offset = static_cast<double>(std::max<int64_t>(message->time_stamp - start_time, 0));
+    topic.offsets.emplace_back(static_cast<int64_t>(offset / rate));
+    topic.sizes.push_back(
+      static_cast<size_t>(
+        std::llround(static_cast<double>(message->serialized_data->buffer_length) * size_scale)));
+  }
+
+  profile.topics.erase(
+    std::remove_if(
+      profile.topics.begin(), profile.topics.end(),
+      [](const auto & topic) {return topic.offsets.empty();}),
+    profile.topics.end());
+  return profile;
+}
+
+std::optional<LoadProfile> load_profile_from_node_parameters(rclcpp::Node & node)
+{
+  const std::string parameters_ns = "load_profile";
+  node.declare_parameter<std::string>(parameters_ns + ".bag_uri", "");
+  node.declare_parameter<double>(parameters_ns + ".rate", 1.0);
+  node.declare_parameter<double>(parameters_ns + ".size_scale", 1.0);
+
+  std::string bag_uri;
+  double rate;
+  double size_scale;
+  node.get_parameter(parameters_ns + ".bag_uri", bag_uri);
+  node.get_parameter(parameters_ns + ".rate", rate);
+  node.get_parameter(parameters_ns + ".size_scale", size_scale);
+  if (bag_uri.empty()) {
+    return std::nullopt;
+  }
+  RCLCPP_INFO_STREAM(node.get_logger(), "Reading load profile from bag " << bag_uri);
+  return read_load_profile(bag_uri, rate, size_scale);
+}
+
+std::vector<PublisherGroupConfig> publisher_groups_from_load_profile(const LoadProfile & profile)
+{
+  std::vector<PublisherGroupConfig> configurations;
+  for (const auto & topic : profile.topics) {
+    PublisherGroupConfig group_config;
+    group_config.count = 1;
+    group_config.topic_root = topic.name.substr(topic.name.find_first_not_of('/'));
+    group_config.qos = topic.qos;
+    group_config.producer_config.max_count = static_cast<unsigned int>(topic.offsets.size());
+    group_config.producer_config.message_type =
+      std::string(config_utils::DEFAULT_MESSAGE_TYPE);
+
+    size_t total_size = 0;
+    for (const auto size : topic.sizes) {
+      total_size += size;
+    }
+    group_config.producer_config.message_size =
+      static_cast<unsigned int>(total_size / topic.sizes.size());
+    const double duration_s =
+      std::chrono::duration<double>(topic.offsets.back() - topic.offsets.front()).count();
+    const double rate_hz =
+      duration_s > 0 ? static_cast<double>(topic.offsets.size() - 1) / duration_s : 0;
+    group_config.producer_config.frequency =
+      std::max(1u, static_cast<unsigned int>(std::lround(rate_hz)));
+    configurations.push_back(group_config);
+  }
+  return configurations;
+}
+
+}  // namespace load_profile_utils
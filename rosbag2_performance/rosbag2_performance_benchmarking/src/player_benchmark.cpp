@@ -0,0 +1,252 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_transport/play_options.hpp"
+#include "rosbag2_transport/player.hpp"
+#include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
+
+#include "rosbag2_performance_benchmarking/bag_utils.hpp"
+#include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/player_benchmark.hpp"
+#include "rosbag2_performance_benchmarking/result_utils.hpp"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+using ByteArray = rosbag2_performance_benchmarking_msgs::msg::ByteArray;
+
+double to_us(Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+/// User and system CPU time of the process
+double get_cpu_time_s()
+{
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/// Resident memory of the process, or 0 where /proc is not available
+size_t get_resident_memory_bytes()
+{
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages)) {
+    return 0;
+  }
+  return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+}  // namespace
+
+PlayerBenchmark::PlayerBenchmark(const std::string & name)
+: rclcpp::Node(name)
+{
+  RCLCPP_INFO(get_logger(), "PlayerBenchmark parsing configurations");
+  configurations_ = config_utils::publisher_groups_from_node_parameters(*this);
+  if (configurations_.empty()) {
+    RCLCPP_ERROR(get_logger(), "No publishers/producers found in node parameters");
+    return;
+  }
+
+  bag_config_ = config_utils::bag_config_from_node_parameters(*this);
+
+  declare_parameter("results_file", bag_config_.storage_options.uri + "/player_results.csv");
+  get_parameter("results_file", results_file_);
+  declare_parameter("read_ahead_queue_size", 1000);
+  read_ahead_queue_size_ = static_cast<size_t>(get_parameter("read_ahead_queue_size").as_int());
+  declare_parameter("rate", 1.0);
+  get_parameter("rate", rate_);
+  declare_parameter("receive_timeout", 1.0);
+  get_parameter("receive_timeout", receive_timeout_s_);
+
+  RCLCPP_INFO(get_logger(), "configuration parameters processed");
+}
+
+void PlayerBenchmark::start_benchmark()
+{
+  if (configurations_.empty()) {
+    return;
+  }
+  RCLCPP_INFO(get_logger(), "Starting the PlayerBenchmark");
+  for (const auto & c : configurations_) {
+    results_.total_messages += static_cast<size_t>(c.count) * c.producer_config.max_count;
+  }
+  bag_utils::write_synthetic_bag(configurations_, bag_config_);
+  RCLCPP_INFO(get_logger(), "Bag written");
+  measure_playback();
+  result_utils::write_player_benchmark_results(
+    bag_config_, read_ahead_queue_size_, rate_, results_, results_file_);
+}
+
+void PlayerBenchmark::measure_playback()
+{
+  // Played messages are received by another node spun on its own thread, so that the player
+  // publishes through the middleware as it does to any other subscriber
+  auto subscriber_node = std::make_shared<rclcpp::Node>("player_benchmark_subscriber");
+  std::mutex mutex;
+  std::atomic<size_t> received_messages{0};
+  size_t received_bytes = 0;
+  bool first = true;
+  Clock::time_point first_receive_time;
+  Clock::time_point last_receive_time;
+  rcutils_time_point_value_t first_time_stamp = 0;
+  std::vector<double> jitters;
+  jitters.reserve(results_.total_messages);
+  auto on_message = [&](ByteArray::ConstSharedPtr message) {
+      const auto now = Clock::now();
+      std::lock_guard<std::mutex> lock(mutex);
+      const auto time_stamp = bag_utils::get_synthetic_time_stamp(message->data);
+      if (first) {
+        first = false;
+        first_receive_time = now;
+        first_time_stamp = time_stamp.value_or(0);
+      }
+      last_receive_time = now;
+      received_bytes += message->data.size();
+      if (time_stamp) {
+        const double bag_elapsed_us =
+          static_cast<double>(*time_stamp - first_time_stamp) / 1e3 / rate_;
+        jitters.push_back(std::abs(to_us(now - first_receive_time) - bag_elapsed_us));
+      }
+      ++received_messages;
+    };
+  std::vector<rclcpp::Subscription<ByteArray>::SharedPtr> subscriptions;
+  for (const auto & c : configurations_) {
+    for (unsigned int i = 0; i < c.count; ++i) {
+      subscriptions.push_back(
+        subscriber_node->create_subscription<ByteArray>(
+          c.topic_root + "_" + std::to_string(i + 1), c.qos, on_message));
+    }
+  }
+  rclcpp::executors::SingleThreadedExecutor subscriber_executor;
+  subscriber_executor.add_node(subscriber_node);
+  std::thread subscriber_thread([&subscriber_executor]() {subscriber_executor.spin();});
+
+  rosbag2_transport::PlayOptions play_options;
+  play_options.disable_keyboard_controls = true;
+  play_options.read_ahead_queue_size = read_ahead_queue_size_;
+  play_options.rate = static_cast<float>(rate_);
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    bag_config_.storage_options, play_options, "rosbag2_performance_benchmarking_player");
+
+  // Messages published before the subscriptions are matched would be lost
+  const auto discovery_deadline = Clock::now() + std::chrono::seconds(10);
+  while (!std::all_of(
+      subscriptions.begin(), subscriptions.end(),
+      [](const auto & subscription) {return subscription->get_publisher_count() > 0;}))
+  {
+    if (Clock::now() > discovery_deadline) {
+      RCLCPP_WARN(get_logger(), "Not all subscriptions matched the publishers of the player");
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // Sample the resident memory while the player reads ahead
+  const size_t start_memory = get_resident_memory_bytes();
+  std::atomic<bool> playing{true};
+  size_t peak_memory = start_memory;
+  std::thread memory_thread([&]() {
+      while (playing) {
+        peak_memory = std::max(peak_memory, get_resident_memory_bytes());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    });
+
+  const double start_cpu_time = get_cpu_time_s();
+  const auto start = Clock::now();
+  player->play();
+  player->wait_for_playback_to_finish();
+  const double play_duration_s = std::chrono::duration<double>(Clock::now() - start).count();
+  const double cpu_time = get_cpu_time_s() - start_cpu_time;
+  playing = false;
+  memory_thread.join();
+
+  // Wait for the messages still in flight, until none arrived for the receive timeout
+  const auto receive_timeout = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(receive_timeout_s_));
+  size_t last_received = received_messages;
+  auto last_progress = Clock::now();
+  while (received_messages < results_.total_messages &&
+    Clock::now() - last_progress < receive_timeout)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (received_messages != last_received) {
+      last_received = received_messages;
+      last_progress = Clock::now();
+    }
+  }
+  subscriber_executor.cancel();
+  subscriber_thread.join();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  results_.received_messages = received_messages;
+  results_.received_bytes = received_bytes;
+  const double receive_duration_s =
+    std::chrono::duration<double>(last_receive_time - first_receive_time).count();
+  if (receive_duration_s > 0) {
+    results_.received_messages_per_s =
+      static_cast<double>(results_.received_messages) / receive_duration_s;
+    results_.received_mb_per_s = static_cast<double>(received_bytes) / 1e6 / receive_duration_s;
+  }
+  results_.jitter_p50_us = result_utils::percentile(jitters, 0.5);
+  results_.jitter_p99_us = result_utils::percentile(jitters, 0.99);
+  results_.jitter_max_us = jitters.empty() ? 0 : jitters.back();
+  results_.cpu_usage = play_duration_s > 0 ? cpu_time / play_duration_s * 100 : 0;
+  results_.peak_memory_mb = static_cast<double>(peak_memory - start_memory) / 1e6;
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Received " << results_.received_messages << "/" << results_.total_messages <<
+      " messages, " << results_.received_messages_per_s << " msgs/s, " <<
+      results_.received_mb_per_s << " MB/s");
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Jitter: p50 " << results_.jitter_p50_us << " us, p99 " <<
+      results_.jitter_p99_us << " us, max " << results_.jitter_max_us << " us");
+  RCLCPP_INFO_STREAM(
+    get_logger(), "CPU usage " << results_.cpu_usage << " %, peak memory " <<
+      results_.peak_memory_mb << " MB");
+}
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  auto bench = std::make_shared<PlayerBenchmark>("rosbag2_performance_benchmarking_node");
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(bench);
+
+  // The benchmark has its own control loop but uses spinning for parameters
+  std::thread spin_thread([&executor]() {executor.spin();});
+  bench->start_benchmark();
+  RCLCPP_INFO(bench->get_logger(), "Benchmark terminated");
+  rclcpp::shutdown();
+  spin_thread.join();
+  return 0;
+}
@@ -0,0 +1,231 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_compression/sequential_compression_reader.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_transport/play_options.hpp"
+#include "rosbag2_transport/player.hpp"
+
+#include "rosbag2_performance_benchmarking/bag_utils.hpp"
+#include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/reader_benchmark.hpp"
+#include "rosbag2_performance_benchmarking/result_utils.hpp"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double to_us(Clock::duration duration)
+{
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+double to_mb_per_s(size_t bytes, Clock::duration duration)
+{
+  const double seconds = std::chrono::duration<double>(duration).count();
+  return seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0;
+}
+}  // namespace
+
+ReaderBenchmark::ReaderBenchmark(const std::string & name)
+: rclcpp::Node(name)
+{
+  RCLCPP_INFO(get_logger(), "ReaderBenchmark parsing configurations");
+  configurations_ = config_utils::publisher_groups_from_node_parameters(*this);
+  if (configurations_.empty()) {
+    RCLCPP_ERROR(get_logger(), "No publishers/producers found in node parameters");
+    return;
+  }
+
+  bag_config_ = config_utils::bag_config_from_node_parameters(*this);
+
+  declare_parameter("results_file", bag_config_.storage_options.uri + "/reader_results.csv");
+  get_parameter("results_file", results_file_);
+  declare_parameter("seek_count", 100);
+  seek_count_ = static_cast<size_t>(get_parameter("seek_count").as_int());
+  declare_parameter("filter_selectivities", std::vector<double>{0.01, 0.1, 0.5});
+  filter_selectivities_ = get_parameter("filter_selectivities").as_double_array();
+  declare_parameter("measure_play_timing", true);
+  get_parameter("measure_play_timing", measure_play_timing_);
+
+  RCLCPP_INFO(get_logger(), "configuration parameters processed");
+}
+
+void ReaderBenchmark::start_benchmark()
+{
+  if (configurations_.empty()) {
+    return;
+  }
+  RCLCPP_INFO(get_logger(), "Starting the ReaderBenchmark");
+  topics_ = bag_utils::write_synthetic_bag(configurations_, bag_config_);
+  RCLCPP_INFO(get_logger(), "Bag written");
+  measure_sequential_read();
+  measure_seeks();
+  measure_filtered_reads();
+  if (measure_play_timing_) {
+    measure_play_timing();
+  }
+  result_utils::write_reader_benchmark_results(bag_config_, results_, results_file_);
+}
+
+std::unique_ptr<rosbag2_cpp::Reader> ReaderBenchmark::open_reader() const
+{
+  std::unique_ptr<rosbag2_cpp::Reader> reader;
+  if (!bag_config_.compression_format.empty()) {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_compression::SequentialCompressionReader>());
+  } else {
+    reader = std::make_unique<rosbag2_cpp::Reader>(
+      std::make_unique<rosbag2_cpp::readers::SequentialReader>());
+  }
+  reader->open(bag_config_.storage_options);
+  return reader;
+}
+
+void ReaderBenchmark::measure_sequential_read()
+{
+  const auto start = Clock::now();
+  auto reader = open_reader();
+  while (reader->has_next()) {
+    const auto message = reader->read_next();
+    ++results_.total_messages;
+    results_.total_bytes += message->serialized_data->buffer_length;
+  }
+  const auto duration = Clock::now() - start;
+  results_.read_mb_per_s = to_mb_per_s(results_.total_bytes, duration);
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Sequential read: " << results_.total_messages << " messages, " <<
+      results_.read_mb_per_s << " MB/s");
+}
+
+void ReaderBenchmark::measure_seeks()
+{
+  auto reader = open_reader();
+  const auto metadata = reader->get_metadata();
+  const auto begin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    metadata.starting_time.time_since_epoch()).count();
+  const auto end = begin + metadata.duration.count();
+  std::mt19937_64 generator(0);
+  std::uniform_int_distribution<int64_t> time_distribution(begin, std::max(begin, end));
+
+  std::vector<double> latencies;
+  for (size_t i = 0; i < seek_count_; ++i) {
+    const auto time_stamp = time_distribution(generator);
+    const auto start = Clock::now();
+    reader->seek(time_stamp);
+    if (reader->has_next()) {
+      reader->read_next();
+    }
+    latencies.push_back(to_us(Clock::now() - start));
+  }
+  results_.seek_latency_p50_us = result_utils::percentile(latencies, 0.5);
+  results_.seek_latency_p90_us = result_utils::percentile(latencies, 0.9);
+  results_.seek_latency_p99_us = result_utils::percentile(latencies, 0.99);
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Seek latency: p50 " << results_.seek_latency_p50_us << " us, p99 " <<
+      results_.seek_latency_p99_us << " us");
+}
+
+void ReaderBenchmark::measure_filtered_reads()
+{
+  for (const auto selectivity : filter_selectivities_) {
+    // Every n-th topic, so that all publisher groups are represented
+    rosbag2_storage::StorageFilter filter;
+    const auto wanted = std::max<size_t>(
+      1, static_cast<size_t>(std::llround(selectivity * static_cast<double>(topics_.size()))));
+    const double step = static_cast<double>(topics_.size()) / static_cast<double>(wanted);
+    for (size_t i = 0; i < wanted; ++i) {
+      filter.topics.push_back(topics_[static_cast<size_t>(static_cast<double>(i) * step)]);
+    }
+
+    const auto start = Clock::now();
+    auto reader = open_reader();
+    reader->set_filter(filter);
+    size_t bytes = 0;
+    while (reader->has_next()) {
+      bytes += reader->read_next()->serialized_data->buffer_length;
+    }
+    const auto throughput = to_mb_per_s(bytes, Clock::now() - start);
+    results_.filtered_read_mb_per_s.push_back({selectivity, throughput});
+    RCLCPP_INFO_STREAM(
+      get_logger(), "Filtered read of " << wanted << " topics: " << throughput << " MB/s");
+  }
+}
+
+void ReaderBenchmark::measure_play_timing()
+{
+  rosbag2_transport::PlayOptions play_options;
+  play_options.disable_keyboard_controls = true;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    bag_config_.storage_options, play_options, "rosbag2_performance_benchmarking_player");
+
+  // Compare the time elapsed since the first published message with the time elapsed in the bag
+  std::mutex mutex;
+  bool first = true;
+  Clock::time_point first_publish_time;
+  rcutils_time_point_value_t first_time_stamp = 0;
+  std::vector<double> errors;
+  errors.reserve(results_.total_messages);
+  player->add_on_play_message_post_callback(
+    [&](std::shared_ptr<rosbag2_storage::SerializedBagMessage> message) {
+      const auto now = Clock::now();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (first) {
+        first = false;
+        first_publish_time = now;
+        first_time_stamp = message->time_stamp;
+      }
+      const double bag_elapsed_us =
+        static_cast<double>(message->time_stamp - first_time_stamp) / 1e3;
+      errors.push_back(std::abs(to_us(now - first_publish_time) - bag_elapsed_us));
+    });
+
+  player->play();
+  player->wait_for_playback_to_finish();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  results_.play_error_p50_us = result_utils::percentile(errors, 0.5);
+  results_.play_error_p99_us = result_utils::percentile(errors, 0.99);
+  results_.play_error_max_us = errors.empty() ? 0 : errors.back();
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Play timing error: p50 " << results_.play_error_p50_us << " us, p99 " <<
+      results_.play_error_p99_us << " us, max " << results_.play_error_max_us << " us");
+}
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  auto bench = std::make_shared<ReaderBenchmark>("rosbag2_performance_benchmarking_node");
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(bench);
+
+  // The benchmark has its own control loop but uses spinning for parameters
+  std::thread spin_thread([&executor]() {executor.spin();});
+  bench->start_benchmark();
+  RCLCPP_INFO(bench->get_logger(), "Benchmark terminated");
+  rclcpp::shutdown();
+  spin_thread.join();
+  return 0;
+}
@@ -0,0 +1,264 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_performance_benchmarking/resource_sampler.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kFsyncProbeSize = 4096;
+
+double seconds(const timeval & time)
+{
+  return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+}
+
+/// Name and user plus system CPU time in clock ticks from a /proc/<pid>/stat file,
+/// whose name field may contain spaces and parentheses
+bool read_stat(const std::string & path, std::string & name, double & cpu_ticks)
+{
+  std::ifstream stat_file(path);
+  std::string line;
+  if (!std::getline(stat_file, line)) {
+    return false;
+  }
+  const auto name_begin = line.find('(');
+  const auto name_end = line.rfind(')');
+  if (name_begin == std::string::npos || name_end == std::string::npos) {
+    return false;
+  }
+  name = line.substr(name_begin + 1, name_end - name_begin - 1);
+  std::replace(name.begin(), name.end(), ' ', '_');
+  // Fields after the name start with the state, utime and stime are the 12th and 13th of them
+  std::istringstream fields(line.substr(name_end + 2));
+  std::string field;
+  double utime = 0;
+  double stime = 0;
+  for (int skipped = 0; skipped < 11; ++skipped) {
+    fields >> field;
+  }
+  if (!(fields >> utime >> stime)) {
+    return false;
+  }
+  cpu_ticks = utime + stime;
+  return true;
+}
+
+/// Value of a "key: value" line of a /proc file, 0 if not present
+double read_proc_value(const std::string & path, const std::string & key)
+{
+  std::ifstream proc_file(path);
+  std::string line;
+  while (std::getline(proc_file, line)) {
+    if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() &&
+      line[key.size()] == ':')
+    {
+      return std::stod(line.substr(key.size() + 1));
+    }
+  }
+  return 0;
+}
+
+std::vector<int> list_threads(const std::string & proc_dir)
+{
+  std::vector<int> tids;
+  DIR * task_dir = opendir((proc_dir + "/task").c_str());
+  if (task_dir == nullptr) {
+    return tids;
+  }
+  while (const dirent * entry = readdir(task_dir)) {
+    if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+      tids.push_back(std::stoi(entry->d_name));
+    }
+  }
+  closedir(task_dir);
+  return tids;
+}
+}  // namespace
+
+ResourceSampler::ResourceSampler(
+  pid_t pid, std::chrono::milliseconds period, std::string fsync_probe_dir)
+: pid_(pid),
+  proc_dir_("/proc/" + std::to_string(pid)),
+  period_(period),
+  fsync_probe_path_(
+    fsync_probe_dir.empty() ? "" : fsync_probe_dir + "/.fsync_probe_" + std::to_string(pid))
+{}
+
+ResourceSampler::~ResourceSampler()
+{
+  stop();
+}
+
+void ResourceSampler::start()
+{
+  stopped_ = false;
+  thread_ = std::thread(&ResourceSampler::run, this);
+}
+
+void ResourceSampler::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  stop_condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (fsync_probe_fd_ >= 0) {
+    close(fsync_probe_fd_);
+    fsync_probe_fd_ = -1;
+    unlink(fsync_probe_path_.c_str());
+  }
+}
+
+const std::vector<ResourceSample> & ResourceSampler::samples() const
+{
+  return samples_;
+}
+
+const std::vector<ThreadSample> & ResourceSampler::thread_samples() const
+{
+  return thread_samples_;
+}
+
+void ResourceSampler::run()
+{
+  const auto start_time = Clock::now();
+  auto previous_time = start_time;
+  auto previous_counters = read_counters();
+  auto previous_thread_times = read_thread_cpu_times();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_condition_.wait_for(lock, period_, [this] {return stopped_;})) {
+    const auto now = Clock::now();
+    const auto counters = read_counters();
+    const auto thread_times = read_thread_cpu_times();
+    const double elapsed_s = std::chrono::duration<double>(now - previous_time).count();
+    const double time_s = std::chrono::duration<double>(now - start_time).count();
+
+    ResourceSample sample;
+    sample.time_s = time_s;
+    sample.cpu_usage = 100 * (counters.cpu_time_s - previous_counters.cpu_time_s) / elapsed_s;
+    sample.rss_mb = read_rss_mb();
+    sample.read_mb_per_s = (counters.read_bytes - previous_counters.read_bytes) / 1e6 / elapsed_s;
+    sample.write_mb_per_s =
+      (counters.write_bytes - previous_counters.write_bytes) / 1e6 / elapsed_s;
+    sample.context_switches_per_s =
+      (counters.context_switches - previous_counters.context_switches) / elapsed_s;
+    sample.fsync_ms = probe_fsync_ms();
+    samples_.push_back(sample);
+
+    for (const auto & [tid, name_and_time] : thread_times) {
+      const auto previous = previous_thread_times.find(tid);
+      const double previous_time_s =
+        previous == previous_thread_times.end() ? 0 : previous->second.second;
+      thread_samples_.push_back(
+        {time_s, tid, name_and_time.first,
+          100 * (name_and_time.second - previous_time_s) / elapsed_s});
+    }
+
+    previous_time = now;
+    previous_counters = counters;
+    previous_thread_times = thread_times;
+  }
+}
+
+ResourceSampler::Counters ResourceSampler::read_counters() const
+{
+  Counters counters;
+  if (pid_ == getpid()) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    counters.cpu_time_s = seconds(usage.ru_utime) + seconds(usage.ru_stime);
+    counters.context_switches = static_cast<double>(usage.ru_nvcsw + usage.ru_nivcsw);
+  } else {
+    std::string name;
+    double cpu_ticks = 0;
+    if (read_stat(proc_dir_ + "/stat", name, cpu_ticks)) {
+      counters.cpu_time_s = cpu_ticks / static_cast<double>(sysconf(_SC_CLK_TCK));
+    }
+    // Context switches are only reported per thread, those of exited threads are lost
+    for (const auto tid : list_threads(proc_dir_)) {
+      const auto status_path = proc_dir_ + "/task/" + std::to_string(tid) + "/status";
+      counters.context_switches += read_proc_value(status_path, "voluntary_ctxt_switches") +
+        read_proc_value(status_path, "nonvoluntary_ctxt_switches");
+    }
+  }
+  // The writes of the fsync probe count too when the own process is sampled, which is
+  // negligible at kFsyncProbeSize bytes per sample
+  counters.read_bytes = read_proc_value(proc_dir_ + "/io", "read_bytes");
+  counters.write_bytes = read_proc_value(proc_dir_ + "/io", "write_bytes");
+  return counters;
+}
+
+std::map<int, std::pair<std::string, double>> ResourceSampler::read_thread_cpu_times() const
+{
+  std::map<int, std::pair<std::string, double>> thread_times;
+  const auto ticks_per_s = static_cast<double>(sysconf(_SC_CLK_TCK));
+  for (const auto tid : list_threads(proc_dir_)) {
+    std::string name;
+    double cpu_ticks = 0;
+    if (read_stat(proc_dir_ + "/task/" + std::to_string(tid) + "/stat", name, cpu_ticks)) {
+      thread_times[tid] = {name, cpu_ticks / ticks_per_s};
+    }
+  }
+  return thread_times;
+}
+
+double ResourceSampler::read_rss_mb() const
+{
+  std::ifstream statm(proc_dir_ + "/statm");
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages)) {
+    return 0;
+  }
+  return static_cast<double>(resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE))) / 1e6;
+}
+
+double ResourceSampler::probe_fsync_ms()
+{
+  if (fsync_probe_path_.empty()) {
+    return -1;
+  }
+  // Opened lazily, as the directory of the bag may be created after sampling started
+  if (fsync_probe_fd_ < 0) {
+    fsync_probe_fd_ = open(fsync_probe_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fsync_probe_fd_ < 0) {
+      return -1;
+    }
+  }
+  const std::vector<char> data(kFsyncProbeSize, 'x');
+  const auto start = Clock::now();
+  if (pwrite(fsync_probe_fd_, data.data(), data.size(), 0) < 0 || fsync(fsync_probe_fd_) != 0) {
+    return -1;
+  }
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
@@ -0,0 +1,59 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "rclcpp/executors/single_threaded_executor.hpp"
+#include "rclcpp/node.hpp"
+
+#include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/resource_sampler.hpp"
+#include "rosbag2_performance_benchmarking/result_utils.hpp"
+
+// Samples the resources of another process, the recorder of an end to end benchmark, until
+// interrupted and writes the samples next to the bag of the run
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  auto sampler_node = std::make_shared<rclcpp::Node>("rosbag2_performance_benchmarking_node");
+
+  const auto pid = sampler_node->declare_parameter<int>("pid", 0);
+  const auto period_ms = sampler_node->declare_parameter<int>("sampling_period_ms", 100);
+  const auto bag_config = config_utils::bag_config_from_node_parameters(*sampler_node);
+  if (pid <= 0) {
+    RCLCPP_ERROR(sampler_node->get_logger(), "The pid of the process to sample is not set");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  const auto & uri = bag_config.storage_options.uri;
+  const auto bag_parent = std::filesystem::path(uri).parent_path();
+  ResourceSampler sampler(
+    static_cast<pid_t>(pid), std::chrono::milliseconds(period_ms),
+    bag_parent.empty() ? "." : bag_parent.string());
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(sampler_node);
+  sampler.start();
+  // Spins until interrupted by the launch file when the producers finished
+  executor.spin();
+  sampler.stop();
+
+  result_utils::write_resource_samples(sampler.samples(), sampler.thread_samples(), uri);
+  RCLCPP_INFO(sampler_node->get_logger(), "Resource samples written");
+  return 0;
+}
@@ -14,11 +14,16 @@
 
 #include "rosbag2_performance_benchmarking/result_utils.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iomanip>   // std::setprecision, std::setw
+#include <map>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "rosbag2_storage/storage_options.hpp"
@@ -28,10 +33,23 @@
 #include "rosbag2_performance_benchmarking/bag_config.hpp"
 #include "rosbag2_performance_benchmarking/publisher_group_config.hpp"
 #include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/resource_samples.hpp"
+#include "rosbag2_performance_benchmarking/load_profile_utils.hpp"
 
 namespace result_utils
 {
 
+/// Nearest-rank percentile of samples, which are sorted in place
+double percentile(std::vector<double> & samples, double share)
+{
+  if (samples.empty()) {
+    return 0;
+  }
+  std::sort(samples.begin(), samples.end());
+  const auto rank = static_cast<size_t>(std::ceil(share * static_cast<double>(samples.size())));
+  return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
 /// Read total count of recorded messages from metadata.yaml file
 int get_message_count_from_metadata(const std::string & uri)
 {
@@ -82,7 +100,8 @@ void write_benchmark_results(
   const std::string & results_file,
   float producer_cpu_usage,
   float recorder_cpu_usage,
-  const std::vector<double> & cpu_usage_per_core)
+  const std::vector<double> & cpu_usage_per_core,
+  const ResourceSummary & resources)
 {
   bool new_file = false;
   { // test if file exists - we want to write a csv header after creation if not
@@ -105,7 +124,10 @@ void write_benchmark_results(
     output_file << "max_bagfile_size storage_config ";
     output_file << "compression compression_queue compression_threads ";
     output_file << "total_produced total_recorded_count ";
-    output_file << "producer_cpu_usage recorder_cpu_usage";
+    output_file << "producer_cpu_usage recorder_cpu_usage ";
+    output_file << "peak_rss_mb average_rss_mb write_mb_per_s read_mb_per_s ";
+    output_file << "context_switches_per_s fsync_p50_ms fsync_p99_ms fsync_max_ms ";
+    output_file << "busiest_thread_cpu_usage";
     for (size_t i = 0; i < cpu_usage_per_core.size(); i++) {
       output_file << " core_" << i;
     }
@@ -135,7 +157,16 @@ void write_benchmark_results(
     output_file << std::fixed;               // Fix the number of decimal digits
     output_file << std::setprecision(2);  // to 2
     output_file << std::setw(4) << producer_cpu_usage << " ";
-    output_file << std::setw(4) << recorder_cpu_usage;
+    output_file << std::setw(4) << recorder_cpu_usage << " ";
+    output_file << resources.peak_rss_mb << " ";
+    output_file << resources.average_rss_mb << " ";
+    output_file << resources.write_mb_per_s << " ";
+    output_file << resources.read_mb_per_s << " ";
+    output_file << resources.context_switches_per_s << " ";
+    output_file << resources.fsync_p50_ms << " ";
+    output_file << resources.fsync_p99_ms << " ";
+    output_file << resources.fsync_max_ms << " ";
+    output_file << std::setw(4) << resources.busiest_thread_cpu_usage;
     for (auto cpu_core_usage : cpu_usage_per_core) {
       output_file << " " << std::setw(4) << cpu_core_usage;
     }
@@ -146,7 +177,11 @@ void write_benchmark_results(
 /// this version works with a standalone node using node parameters
 void write_benchmark_results(rclcpp::Node & node)
 {
-  auto configurations = config_utils::publisher_groups_from_node_parameters(node);
+  // Topics replayed from a load profile are reported as publisher groups of one publisher
+  const auto load_profile = load_profile_utils::load_profile_from_node_parameters(node);
+  auto configurations = load_profile ?
+    load_profile_utils::publisher_groups_from_load_profile(*load_profile) :
+    config_utils::publisher_groups_from_node_parameters(node);
   auto bag_config = config_utils::bag_config_from_node_parameters(node);
 
   std::string results_file;
@@ -166,7 +201,262 @@ void write_benchmark_results(rclcpp::Node & node)
 
   write_benchmark_results(
     configurations, bag_config, results_file,
-    producer_cpu_usage, recorder_cpu_usage, cpu_usage_per_core);
+    producer_cpu_usage, recorder_cpu_usage, cpu_usage_per_core,
+    read_resource_summary(bag_config.storage_options.uri));
+}
+
+void write_resource_samples(
+  const std::vector<ResourceSample> & samples,
+  const std::vector<ThreadSample> & thread_samples,
+  const std::string & uri)
+{
+  const std::string resources_file = uri + "_resources.csv";
+  std::ofstream resources_output(resources_file);
+  if (!resources_output.is_open()) {
+    throw std::runtime_error(std::string("Could not open file: ") + resources_file);
+  }
+  resources_output << "time_s cpu_usage rss_mb read_mb_per_s write_mb_per_s ";
+  resources_output << "context_switches_per_s fsync_ms" << std::endl;
+  resources_output << std::fixed << std::setprecision(3);
+  for (const auto & sample : samples) {
+    resources_output << sample.time_s << " ";
+    resources_output << sample.cpu_usage << " ";
+    resources_output << sample.rss_mb << " ";
+    resources_output << sample.read_mb_per_s << " ";
+    resources_output << sample.write_mb_per_s << " ";
+    resources_output << sample.context_switches_per_s << " ";
+    resources_output << sample.fsync_ms << std::endl;
+  }
+
+  const std::string threads_file = uri + "_threads.csv";
+  std::ofstream threads_output(threads_file);
+  if (!threads_output.is_open()) {
+    throw std::runtime_error(std::string("Could not open file: ") + threads_file);
+  }
+  threads_output << "time_s tid name cpu_usage" << std::endl;
+  threads_output << std::fixed << std::setprecision(3);
+  for (const auto & sample : thread_samples) {
+    threads_output << sample.time_s << " ";
+    threads_output << sample.tid << " ";
+    threads_output << sample.name << " ";
+    threads_output << sample.cpu_usage << std::endl;
+  }
+}
+
+ResourceSummary read_resource_summary(const std::string & uri)
+{
+  ResourceSummary summary;
+  std::ifstream resources_input(uri + "_resources.csv");
+  std::string line;
+  if (!std::getline(resources_input, line)) {
+    return summary;
+  }
+  size_t count = 0;
+  std::vector<double> fsync_samples;
+  while (std::getline(resources_input, line)) {
+    std::istringstream fields(line);
+    ResourceSample sample;
+    if (!(fields >> sample.time_s >> sample.cpu_usage >> sample.rss_mb >> sample.read_mb_per_s >>
+      sample.write_mb_per_s >> sample.context_switches_per_s >> sample.fsync_ms))
+    {
+      continue;
+    }
+    ++count;
+    summary.peak_rss_mb = std::max(summary.peak_rss_mb, sample.rss_mb);
+    summary.average_rss_mb += sample.rss_mb;
+    summary.read_mb_per_s += sample.read_mb_per_s;
+    summary.write_mb_per_s += sample.write_mb_per_s;
+    summary.context_switches_per_s += sample.context_switches_per_s;
+    if (sample.fsync_ms >= 0) {
+      fsync_samples.push_back(sample.fsync_ms);
+    }
+  }
+  if (count > 0) {
+    summary.average_rss_mb /= static_cast<double>(count);
+    summary.read_mb_per_s /= static_cast<double>(count);
+    summary.write_mb_per_s /= static_cast<double>(count);
+    summary.context_switches_per_s /= static_cast<double>(count);
+  }
+  summary.fsync_p50_ms = percentile(fsync_samples, 0.5);
+  summary.fsync_p99_ms = percentile(fsync_samples, 0.99);
+  summary.fsync_max_ms = fsync_samples.empty() ? 0 : fsync_samples.back();
+
+  // Sum and count of the CPU usage samples of every thread
+  std::map<int, std::pair<double, size_t>> thread_cpu_usage;
+  std::ifstream threads_input(uri + "_threads.csv");
+  std::getline(threads_input, line);
+  while (std::getline(threads_input, line)) {
+    std::istringstream fields(line);
+    ThreadSample sample;
+    if (fields >> sample.time_s >> sample.tid >> sample.name >> sample.cpu_usage) {
+      thread_cpu_usage[sample.tid].first += sample.cpu_usage;
+      ++thread_cpu_usage[sample.tid].second;
+    }
+  }
+  for (const auto & [tid, usage] : thread_cpu_usage) {
+    summary.busiest_thread_cpu_usage = std::max(
+      summary.busiest_thread_cpu_usage, usage.first / static_cast<double>(usage.second));
+  }
+  return summary;
+}
+
+/// Write results of a completed reader benchmark
+void write_reader_benchmark_results(
+  const BagConfig & bag_config,
+  const ReaderResults & results,
+  const std::string & results_file)
+{
+  bool new_file = false;
+  { // test if file exists - we want to write a csv header after creation if not
+    std::ifstream test_existence(results_file);
+    if (!test_existence) {
+      new_file = true;
+    }
+  }
+
+  // append, we want to accumulate results from multiple runs
+  std::ofstream output_file(results_file, std::ios_base::app);
+  if (!output_file.is_open()) {
+    throw std::runtime_error(std::string("Could not open file: ") + results_file);
+  }
+
+  if (new_file) {
+    output_file << "storage_id ";
+    output_file << "max_bagfile_size storage_config compression ";
+    output_file << "total_messages total_bytes read_mb_per_s ";
+    output_file << "seek_p50_us seek_p90_us seek_p99_us";
+    for (const auto & filtered : results.filtered_read_mb_per_s) {
+      output_file << " filtered_" << filtered.first << "_mb_per_s";
+    }
+    output_file << " play_error_p50_us play_error_p99_us play_error_max_us";
+    output_file << std::endl;
+  }
+
+  output_file << bag_config.storage_options.storage_id << " ";
+  output_file << bag_config.storage_options.max_bagfile_size << " ";
+  output_file << bag_config.storage_options.storage_config_uri << " ";
+  output_file << bag_config.compression_format << " ";
+  output_file << results.total_messages << " ";
+  output_file << results.total_bytes << " ";
+  output_file << std::fixed;               // Fix the number of decimal digits
+  output_file << std::setprecision(2);  // to 2
+  output_file << results.read_mb_per_s << " ";
+  output_file << results.seek_latency_p50_us << " ";
+  output_file << results.seek_latency_p90_us << " ";
+  output_file << results.seek_latency_p99_us;
+  for (const auto & filtered : results.filtered_read_mb_per_s) {
+    output_file << " " << filtered.second;
+  }
+  output_file << " " << results.play_error_p50_us;
+  output_file << " " << results.play_error_p99_us;
+  output_file << " " << results.play_error_max_us;
+  output_file << std::endl;
+}
+
+/// Write results of a completed player benchmark
+void write_player_benchmark_results(
+  const BagConfig & bag_config,
+  size_t read_ahead_queue_size,
+  double rate,
+  const PlayerResults & results,
+  const std::string & results_file)
+{
+  bool new_file = false;
+  { // test if file exists - we want to write a csv header after creation if not
+    std::ifstream test_existence(results_file);
+    if (!test_existence) {
+      new_file = true;
+    }
+  }
+
+  // append, we want to accumulate results from multiple runs
+  std::ofstream output_file(results_file, std::ios_base::app);
+  if (!output_file.is_open()) {
+    throw std::runtime_error(std::string("Could not open file: ") + results_file);
+  }
+
+  if (new_file) {
+    output_file << "storage_id ";
+    output_file << "max_bagfile_size storage_config compression read_ahead_queue_size rate ";
+    output_file << "total_messages received_messages received_bytes ";
+    output_file << "received_msgs_per_s received_mb_per_s ";
+    output_file << "jitter_p50_us jitter_p99_us jitter_max_us ";
+    output_file << "cpu_usage peak_memory_mb";
+    output_file << std::endl;
+  }
+
+  output_file << bag_config.storage_options.storage_id << " ";
+  output_file << bag_config.storage_options.max_bagfile_size << " ";
+  output_file << bag_config.storage_options.storage_config_uri << " ";
+  output_file << bag_config.compression_format << " ";
+  output_file << read_ahead_queue_size << " ";
+  output_file << rate << " ";
+  output_file << results.total_messages << " ";
+  output_file << results.received_messages << " ";
+  output_file << results.received_bytes << " ";
+  output_file << std::fixed;               // Fix the number of decimal digits
+  output_file << std::setprecision(2);  // to 2
+  output_file << results.received_messages_per_s << " ";
+  output_file << results.received_mb_per_s << " ";
+  output_file << results.jitter_p50_us << " ";
+  output_file << results.jitter_p99_us << " ";
+  output_file << results.jitter_max_us << " ";
+  output_file << std::setw(4) << results.cpu_usage << " ";
+  output_file << results.peak_memory_mb;
+  output_file << std::endl;
+}
+
+
+/// Write results of a completed compression benchmark, a row for each topic and settings
+void write_compression_benchmark_results(
+  const std::vector<CompressionResults> & results,
+  const std::string & results_file)
+{
+  bool new_file = false;
+  { // test if file exists - we want to write a csv header after creation if not
+    std::ifstream test_existence(results_file);
+    if (!test_existence) {
+      new_file = true;
+    }
+  }
+
+  // append, we want to accumulate results from multiple runs
+  std::ofstream output_file(results_file, std::ios_base::app);
+  if (!output_file.is_open()) {
+    throw std::runtime_error(std::string("Could not open file: ") + results_file);
+  }
+
+  if (new_file) {
+    output_file << "topic compression_format compression_level compression_mode threads ";
+    output_file << "message_count uncompressed_bytes compressed_bytes compression_ratio ";
+    output_file << "compress_mb_per_s decompress_mb_per_s ";
+    output_file << "compress_p50_us compress_p90_us compress_p99_us ";
+    output_file << "decompress_p50_us decompress_p90_us decompress_p99_us";
+    output_file << std::endl;
+  }
+
+  output_file << std::fixed;               // Fix the number of decimal digits
+  output_file << std::setprecision(2);  // to 2
+  for (const auto & result : results) {
+    output_file << result.topic << " ";
+    output_file << result.compression_format << " ";
+    output_file << result.compression_level << " ";
+    output_file << result.compression_mode << " ";
+    output_file << result.threads << " ";
+    output_file << result.message_count << " ";
+    output_file << result.uncompressed_bytes << " ";
+    output_file << result.compressed_bytes << " ";
+    output_file << result.compression_ratio << " ";
+    output_file << result.compress_mb_per_s << " ";
+    output_file << result.decompress_mb_per_s << " ";
+    output_file << result.compress_latency_p50_us << " ";
+    output_file << result.compress_latency_p90_us << " ";
+    output_file << result.compress_latency_p99_us << " ";
+    output_file << result.decompress_latency_p50_us << " ";
+    output_file << result.decompress_latency_p90_us << " ";
+    output_file << result.decompress_latency_p99_us;
+    output_file << std::endl;
+  }
 }
 
 }  // namespace result_utils
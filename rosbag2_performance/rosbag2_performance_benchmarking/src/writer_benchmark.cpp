@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
 #include <chrono>
+#include <filesystem>
 #include <memory>
 #include <string>
 
@@ -23,6 +26,8 @@
 #include "rosbag2_performance_benchmarking_msgs/msg/byte_array.hpp"
 
 #include "rosbag2_performance_benchmarking/config_utils.hpp"
+#include "rosbag2_performance_benchmarking/load_profile_utils.hpp"
+#include "rosbag2_performance_benchmarking/resource_sampler.hpp"
 #include "rosbag2_performance_benchmarking/result_utils.hpp"
 #include "rosbag2_performance_benchmarking/writer_benchmark.hpp"
 
@@ -34,7 +39,10 @@ WriterBenchmark::WriterBenchmark(const std::string & name)
 : rclcpp::Node(name)
 {
   RCLCPP_INFO(get_logger(), "WriterBenchmark parsing configurations");
-  configurations_ = config_utils::publisher_groups_from_node_parameters(*this);
+  load_profile_ = load_profile_utils::load_profile_from_node_parameters(*this);
+  configurations_ = load_profile_ ?
+    load_profile_utils::publisher_groups_from_load_profile(*load_profile_) :
+    config_utils::publisher_groups_from_node_parameters(*this);
   if (configurations_.empty()) {
     RCLCPP_ERROR(get_logger(), "No publishers/producers found in node parameters");
     return;
@@ -46,6 +54,7 @@ WriterBenchmark::WriterBenchmark(const std::string & name)
   if (number_of_threads != 0) {
     RCLCPP_WARN(get_logger(), "number_of_threads parameter is not used in writer_benchmark");
   }
+  spin_wait_ = config_utils::get_spin_wait_from_node_parameters(*this);
 
   RCLCPP_INFO(get_logger(), "configuration parameters processed");
 
@@ -56,6 +65,11 @@ WriterBenchmark::WriterBenchmark(const std::string & name)
 void WriterBenchmark::start_benchmark()
 {
   RCLCPP_INFO(get_logger(), "Starting the WriterBenchmark");
+  // The writer runs in this process, which stands in for the recorder
+  const auto & uri = bag_config_.storage_options.uri;
+  const auto bag_parent = std::filesystem::path(uri).parent_path();
+  ResourceSampler sampler(getpid(), 100ms, bag_parent.empty() ? "." : bag_parent.string());
+  sampler.start();
   start_producers();
   while (rclcpp::ok()) {
     int count = 0;
@@ -128,7 +142,10 @@ void WriterBenchmark::start_benchmark()
       break;
     }
 
-    std::this_thread::sleep_for(1ms);
+    // Back off only while idle, sleeping in every round would cap the rate of each queue
+    if (count == 0) {
+      std::this_thread::sleep_for(100us);
+    }
   }
 
   for (auto & prod_thread : producer_threads_) {
@@ -141,11 +158,37 @@ void WriterBenchmark::start_benchmark()
   std::this_thread::sleep_for(std::chrono::seconds(1));
 
   writer_->close();
+  sampler.stop();
+  result_utils::write_resource_samples(sampler.samples(), sampler.thread_samples(), uri);
 }
 
 void WriterBenchmark::create_producers()
 {
   RCLCPP_INFO_STREAM(get_logger(), "creating producers");
+  const unsigned int queue_max_size = 10;
+  if (load_profile_) {
+    // Leave time to create the writer before the first message of the profile
+    const auto start_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (size_t i = 0; i < configurations_.size(); ++i) {
+      RCLCPP_INFO_STREAM(
+        get_logger(), "\nWriterBenchmark: creating load profile producer for topic " <<
+          load_profile_->topics[i].name << " with " <<
+          configurations_[i].producer_config.max_count << " messages");
+      std::string topic = configurations_[i].topic_root + "_1";
+      auto queue = std::make_shared<ByteSpscMessageQueue>(queue_max_size, topic);
+      queues_.push_back(queue);
+      load_profile_producers_.push_back(
+        std::make_unique<LoadProfileProducer>(
+          load_profile_->topics[i], start_time, spin_wait_,
+          [queue](std::shared_ptr<rosbag2_performance_benchmarking_msgs::msg::ByteArray> msg) {
+            queue->push(msg);
+          },
+          [queue] {
+            queue->set_complete();
+          }));
+    }
+    return;
+  }
   for (const auto & c : configurations_) {
     RCLCPP_INFO_STREAM(
       get_logger(), "\nWriterBenchmark: creating " << c.count <<
@@ -154,10 +197,9 @@ void WriterBenchmark::create_producers()
         " for topic root of " << c.topic_root <<
         ". Each will send " << c.producer_config.max_count <<
         " messages before terminating");
-    const unsigned int queue_max_size = 10;
     for (unsigned int i = 0; i < c.count; ++i) {
       std::string topic = c.topic_root + "_" + std::to_string(i + 1);
-      auto queue = std::make_shared<ByteMessageQueue>(queue_max_size, topic);
+      auto queue = std::make_shared<ByteSpscMessageQueue>(queue_max_size, topic);
       queues_.push_back(queue);
       producers_.push_back(
         std::make_unique<ByteProducer>(
@@ -168,7 +210,8 @@ void WriterBenchmark::create_producers()
           },
           [queue] {
             queue->set_complete();
-          }));
+          },
+          spin_wait_));
     }
   }
 }
@@ -205,6 +248,9 @@ void WriterBenchmark::start_producers()
   for (auto & producer : producers_) {
     producer_threads_.push_back(std::thread(&ByteProducer::run, producer.get()));
   }
+  for (auto & producer : load_profile_producers_) {
+    producer_threads_.push_back(std::thread(&LoadProfileProducer::run, producer.get()));
+  }
 }
 
 int main(int argc, char * argv[])
@@ -25,8 +25,12 @@ with add_dll_directories_from_env('PATH'):
         compression_mode_to_string
     )
     from rosbag2_py._reader import (
+        FieldExtractor,
+        MessageColumns,
+        PrefetchingReader,
         SequentialCompressionReader,
         SequentialReader,
+        SerializedDataBuffer,
         get_registered_readers,
     )
     from rosbag2_py._storage import (
@@ -35,12 +39,14 @@ with add_dll_directories_from_env('PATH'):
         FileInformation,
         MessageDefinition,
         MetadataIo,
+        ReadEstimate,
         ReadOrder,
         ReadOrderSortBy,
         StorageFilter,
         StorageOptions,
         TopicMetadata,
         TopicInformation,
+        TopicStatistics,
         get_default_storage_id,
     )
     from rosbag2_py._writer import (
@@ -51,32 +57,57 @@ with add_dll_directories_from_env('PATH'):
         get_registered_serializers,
     )
     from rosbag2_py._info import (
+        BagCatalog,
+        BagSummary,
         Info,
+        TimeShard,
+        TopicSummary,
     )
     from rosbag2_py._transport import (
+        ExportOptions,
         Player,
         PlayOptions,
         Recorder,
         RecordOptions,
+        TopicDecimation,
+        TopicPublishPolicy,
+        TopicRoute,
+        bag_export,
         bag_rewrite,
     )
     from rosbag2_py._reindexer import (
         Reindexer
     )
+    from rosbag2_py._verifier import (
+        BagVerification,
+        FileVerification,
+        FileVerificationResult,
+        IntegrityProblem,
+        Verifier,
+    )
 
 __all__ = [
+    'bag_export',
     'bag_rewrite',
     'CompressionMode',
     'CompressionOptions',
     'compression_mode_from_string',
     'compression_mode_to_string',
     'ConverterOptions',
+    'ExportOptions',
+    'FieldExtractor',
     'FileInformation',
+    'FileVerification',
+    'FileVerificationResult',
     'get_default_storage_id',
     'get_registered_readers',
     'get_registered_writers',
     'get_registered_compressors',
     'get_registered_serializers',
+    'IntegrityProblem',
+    'MessageColumns',
+    'PrefetchingReader',
+    'ReadEstimate',
     'ReadOrder',
     'ReadOrderSortBy',
     'Reindexer',
@@ -84,16 +115,27 @@ __all__ = [
     'SequentialCompressionWriter',
     'SequentialReader',
     'SequentialWriter',
+    'SerializedDataBuffer',
     'StorageFilter',
     'StorageOptions',
     'TopicMetadata',
     'TopicInformation',
+    'TopicStatistics',
     'BagMetadata',
+    'BagVerification',
     'MessageDefinition',
     'MetadataIo',
+    'BagCatalog',
+    'BagSummary',
     'Info',
+    'TimeShard',
+    'TopicSummary',
     'Player',
     'PlayOptions',
     'Recorder',
     'RecordOptions',
+    'TopicDecimation',
+    'TopicPublishPolicy',
+    'TopicRoute',
+    'Verifier',
 ]
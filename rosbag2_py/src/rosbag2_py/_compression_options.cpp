@@ -20,6 +20,7 @@
 #include "./pybind11.hpp"
 
 using CompressionMode = rosbag2_compression::CompressionMode;
+using CompressionPolicy = rosbag2_compression::CompressionPolicy;
 using CompressionOptions = rosbag2_compression::CompressionOptions;
 
 PYBIND11_MODULE(_compression_options, m) {
@@ -29,6 +30,13 @@ PYBIND11_MODULE(_compression_options, m) {
   .value("NONE", CompressionMode::NONE)
   .value("FILE", CompressionMode::FILE)
   .value("MESSAGE", CompressionMode::MESSAGE)
+  .value("BATCH", CompressionMode::BATCH)
+  .export_values();
+
+  pybind11::enum_<CompressionPolicy>(m, "CompressionPolicy")
+  .value("ALWAYS", CompressionPolicy::ALWAYS)
+  .value("NEVER", CompressionPolicy::NEVER)
+  .value("AUTO", CompressionPolicy::AUTO)
   .export_values();
 
   pybind11::class_<CompressionOptions>(m, "CompressionOptions")
@@ -41,7 +49,29 @@ PYBIND11_MODULE(_compression_options, m) {
   .def_readwrite("compression_format", &CompressionOptions::compression_format)
   .def_readwrite("compression_mode", &CompressionOptions::compression_mode)
   .def_readwrite("compression_queue_size", &CompressionOptions::compression_queue_size)
-  .def_readwrite("compression_threads", &CompressionOptions::compression_threads);
+  .def_readwrite("compression_threads", &CompressionOptions::compression_threads)
+  .def_readwrite(
+    "dictionary_training_messages", &CompressionOptions::dictionary_training_messages)
+  .def_readwrite("dictionary_path", &CompressionOptions::dictionary_path)
+  .def_readwrite(
+    "adaptive_compression_level", &CompressionOptions::adaptive_compression_level)
+  .def_readwrite("min_compression_level", &CompressionOptions::min_compression_level)
+  .def_readwrite("max_compression_level", &CompressionOptions::max_compression_level)
+  .def_readwrite("compression_policy", &CompressionOptions::compression_policy)
+  .def_readwrite(
+    "topic_compression_policies", &CompressionOptions::topic_compression_policies)
+  .def_readwrite(
+    "compression_probe_messages", &CompressionOptions::compression_probe_messages)
+  .def_readwrite("compression_skip_ratio", &CompressionOptions::compression_skip_ratio)
+  .def_readwrite("file_compression_workers", &CompressionOptions::file_compression_workers)
+  .def_readwrite("file_compression_idle_io", &CompressionOptions::file_compression_idle_io)
+  .def_readwrite(
+    "max_concurrent_file_compressions", &CompressionOptions::max_concurrent_file_compressions)
+  .def_readwrite(
+    "file_compression_read_bandwidth", &CompressionOptions::file_compression_read_bandwidth)
+  .def_readwrite(
+    "file_compression_throttle_cache_fill",
+    &CompressionOptions::file_compression_throttle_cache_fill);
 
   m.def(
     "compression_mode_from_string",
@@ -52,4 +82,14 @@ PYBIND11_MODULE(_compression_options, m) {
     "compression_mode_to_string",
     &rosbag2_compression::compression_mode_to_string,
     "Converts a rosbag2_compression::CompressionMode enum into a string");
+
+  m.def(
+    "compression_policy_from_string",
+    &rosbag2_compression::compression_policy_from_string,
+    "Converts a string into a rosbag2_compression::CompressionPolicy enum.");
+
+  m.def(
+    "compression_policy_to_string",
+    &rosbag2_compression::compression_policy_to_string,
+    "Converts a rosbag2_compression::CompressionPolicy enum into a string");
 }
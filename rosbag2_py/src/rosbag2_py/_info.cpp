@@ -12,11 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "rosbag2_cpp/bag_catalog.hpp"
 #include "rosbag2_cpp/info.hpp"
 #include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 
 #include "./pybind11.hpp"
 
@@ -38,6 +42,23 @@ public:
     return info_->read_metadata(uri, storage_id);
   }
 
+  std::vector<rosbag2_storage::BagMetadata> read_metadata_many(
+    const std::vector<std::string> & uris, size_t threads, const std::string & storage_id)
+  {
+    return info_->read_metadata_many(uris, threads, storage_id);
+  }
+
+  std::vector<rosbag2_storage::TopicStatistics> read_topic_statistics(const std::string & uri)
+  {
+    return info_->read_topic_statistics(uri);
+  }
+
+  std::vector<rosbag2_cpp::TimeShard> split_into_time_shards(
+    const std::string & uri, size_t shard_count, const std::string & storage_id)
+  {
+    return info_->split_into_time_shards(uri, shard_count, storage_id);
+  }
+
 protected:
   std::unique_ptr<rosbag2_cpp::Info> info_;
 };
@@ -47,7 +68,99 @@ protected:
 PYBIND11_MODULE(_info, m) {
   m.doc() = "Python wrapper of the rosbag2_cpp info API";
 
+  pybind11::class_<rosbag2_cpp::TimeShard>(m, "TimeShard")
+  .def(
+    pybind11::init(
+      [](
+        std::vector<std::string> files, rcutils_time_point_value_t start_time_ns,
+        rcutils_time_point_value_t end_time_ns, uint64_t estimated_bytes)
+      {
+        return rosbag2_cpp::TimeShard{files, start_time_ns, end_time_ns, estimated_bytes};
+      }),
+    pybind11::arg("files"),
+    pybind11::arg("start_time_ns"),
+    pybind11::arg("end_time_ns"),
+    pybind11::arg("estimated_bytes"))
+  .def_readwrite("files", &rosbag2_cpp::TimeShard::files)
+  .def_readwrite("start_time_ns", &rosbag2_cpp::TimeShard::start_time_ns)
+  .def_readwrite("end_time_ns", &rosbag2_cpp::TimeShard::end_time_ns)
+  .def_readwrite("estimated_bytes", &rosbag2_cpp::TimeShard::estimated_bytes)
+  .def(
+    pybind11::pickle(
+      [](const rosbag2_cpp::TimeShard & shard) {
+        // Shards are handed to worker processes
+        return pybind11::make_tuple(
+          shard.files, shard.start_time_ns, shard.end_time_ns, shard.estimated_bytes);
+      },
+      [](const pybind11::tuple & state) {
+        return rosbag2_cpp::TimeShard{
+          state[0].cast<std::vector<std::string>>(),
+          state[1].cast<rcutils_time_point_value_t>(),
+          state[2].cast<rcutils_time_point_value_t>(),
+          state[3].cast<uint64_t>()};
+      }));
+
   pybind11::class_<rosbag2_py::Info>(m, "Info")
   .def(pybind11::init())
-  .def("read_metadata", &rosbag2_py::Info::read_metadata);
+  .def("read_metadata", &rosbag2_py::Info::read_metadata)
+  .def(
+    "read_metadata_many", &rosbag2_py::Info::read_metadata_many,
+    pybind11::arg("uris"), pybind11::arg("threads") = 0, pybind11::arg("storage_id") = "",
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Read the metadata of several bags concurrently, one bag per CPU core if threads is 0. "
+    "Returns the metadata in the order of the uris.")
+  .def("read_topic_statistics", &rosbag2_py::Info::read_topic_statistics)
+  .def(
+    "split_into_time_shards", &rosbag2_py::Info::split_into_time_shards,
+    pybind11::arg("uri"), pybind11::arg("shard_count"), pybind11::arg("storage_id") = "",
+    "Split a bag into time ranges with about the same amount of data. A shard is read by "
+    "setting a StorageFilter with the start_time_ns and end_time_ns of the shard and seeking "
+    "to its start_time_ns.");
+
+  using BagCatalog = rosbag2_cpp::BagCatalog;
+
+  pybind11::class_<BagCatalog::TopicSummary>(m, "TopicSummary")
+  .def_readonly("name", &BagCatalog::TopicSummary::name)
+  .def_readonly("type", &BagCatalog::TopicSummary::type)
+  .def_readonly("message_count", &BagCatalog::TopicSummary::message_count)
+  .def_readonly("total_bytes", &BagCatalog::TopicSummary::total_bytes);
+
+  pybind11::class_<BagCatalog::BagSummary>(m, "BagSummary")
+  .def_readonly("uri", &BagCatalog::BagSummary::uri)
+  .def_readonly("storage_identifier", &BagCatalog::BagSummary::storage_identifier)
+  .def_readonly("start_time_ns", &BagCatalog::BagSummary::start_time_ns)
+  .def_readonly("end_time_ns", &BagCatalog::BagSummary::end_time_ns)
+  .def_readonly("message_count", &BagCatalog::BagSummary::message_count)
+  .def_readonly("file_count", &BagCatalog::BagSummary::file_count)
+  .def_readonly("bag_size", &BagCatalog::BagSummary::bag_size)
+  .def_readonly("closed", &BagCatalog::BagSummary::closed)
+  .def_readonly("topics", &BagCatalog::BagSummary::topics);
+
+  pybind11::class_<BagCatalog>(m, "BagCatalog")
+  .def(pybind11::init<std::string>(), pybind11::arg("catalog_file") = "")
+  .def(
+    "update", &BagCatalog::update, pybind11::arg("root_directories"),
+    pybind11::call_guard<pybind11::gil_scoped_release>())
+  .def(
+    "find",
+    [](
+      const BagCatalog & catalog, const std::string & topic_name,
+      rcutils_time_point_value_t start_time_ns, rcutils_time_point_value_t end_time_ns,
+      uint64_t min_bag_size, uint64_t max_bag_size)
+    {
+      BagCatalog::Query query;
+      query.topic_name = topic_name;
+      query.start_time_ns = start_time_ns;
+      query.end_time_ns = end_time_ns;
+      query.min_bag_size = min_bag_size;
+      query.max_bag_size = max_bag_size;
+      return catalog.find(query);
+    },
+    pybind11::arg("topic_name") = "",
+    pybind11::arg("start_time_ns") = -1,
+    pybind11::arg("end_time_ns") = -1,
+    pybind11::arg("min_bag_size") = 0,
+    pybind11::arg("max_bag_size") = std::numeric_limits<uint64_t>::max())
+  .def("lookup", &BagCatalog::lookup, pybind11::arg("uri"))
+  .def("save", &BagCatalog::save);
 }
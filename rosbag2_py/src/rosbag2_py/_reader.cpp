@@ -13,14 +13,20 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
+#include "rosbag2_cpp/field_extractor.hpp"
 #include "rosbag2_cpp/plugins/plugin_utils.hpp"
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
 #include "rosbag2_cpp/readers/sequential_reader.hpp"
 #include "rosbag2_cpp/reader.hpp"
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
@@ -29,11 +35,34 @@
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
 
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
 #include "./pybind11.hpp"
+#include <pybind11/numpy.h>
 
 namespace rosbag2_py
 {
 
+/// Serialized data of a message, exposed through the Python buffer protocol without copying.
+/// Keeps the data read from the bag alive as long as any view on it exists.
+struct SerializedDataBuffer
+{
+  std::shared_ptr<rcutils_uint8_array_t> data;
+};
+
+/// Messages read at once, stored by column instead of as a tuple per message
+struct MessageColumns
+{
+  // Topic names, indexed by the topic ids of the messages
+  std::vector<std::string> topics;
+  pybind11::array_t<uint32_t> topic_ids;
+  pybind11::array_t<int64_t> timestamps;
+  // Serialized data of all messages, one after another
+  pybind11::array_t<uint8_t> data;
+  pybind11::array_t<uint64_t> offsets;
+  pybind11::array_t<uint64_t> lengths;
+};
+
 template<typename T>
 class Reader : public rosbag2_cpp::Reader
 {
@@ -43,16 +72,107 @@ public:
   {
   }
 
+  explicit Reader(std::unique_ptr<T> reader_impl)
+  : rosbag2_cpp::Reader(std::move(reader_impl))
+  {
+  }
+
   /// Return a tuple containing the topic name, the serialized ROS message, and
   /// the timestamp.
   pybind11::tuple read_next()
   {
-    const auto next = rosbag2_cpp::Reader::read_next();
-    rcutils_uint8_array_t rcutils_data = *next->serialized_data.get();
+    return to_tuple(*rosbag2_cpp::Reader::read_next());
+  }
+
+  /// Like read_next(), but return the serialized message as SerializedDataBuffer instead of
+  /// a copy in bytes
+  pybind11::tuple read_next_buffer()
+  {
+    const auto message = rosbag2_cpp::Reader::read_next();
+    return pybind11::make_tuple(
+      message->topic_name, SerializedDataBuffer{message->serialized_data}, message->time_stamp);
+  }
+
+  /// Return a list of up to max_messages tuples like read_next(), or of messages up to
+  /// max_bytes of serialized data. The list is empty at the end of the bag.
+  pybind11::list read_next_batch(size_t max_messages, size_t max_bytes)
+  {
+    const auto messages = rosbag2_cpp::Reader::read_next_batch(max_messages, max_bytes);
+    pybind11::list batch;
+    for (const auto & message : messages) {
+      batch.append(to_tuple(*message));
+    }
+    return batch;
+  }
+
+  /// Read like read_next_batch(), but return the messages by column. The bag is read without
+  /// holding the GIL and no Python object is created per message.
+  MessageColumns read_next_columns(size_t max_messages, size_t max_bytes)
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    size_t total_size = 0;
+    {
+      pybind11::gil_scoped_release release;
+      messages = rosbag2_cpp::Reader::read_next_batch(max_messages, max_bytes);
+      for (const auto & message : messages) {
+        total_size += message->serialized_data->buffer_length;
+      }
+    }
+
+    const auto count = static_cast<pybind11::ssize_t>(messages.size());
+    MessageColumns columns;
+    columns.topic_ids = pybind11::array_t<uint32_t>(count);
+    columns.timestamps = pybind11::array_t<int64_t>(count);
+    columns.data = pybind11::array_t<uint8_t>(static_cast<pybind11::ssize_t>(total_size));
+    columns.offsets = pybind11::array_t<uint64_t>(count);
+    columns.lengths = pybind11::array_t<uint64_t>(count);
+    auto * topic_ids = columns.topic_ids.mutable_data();
+    auto * timestamps = columns.timestamps.mutable_data();
+    auto * data = columns.data.mutable_data();
+    auto * offsets = columns.offsets.mutable_data();
+    auto * lengths = columns.lengths.mutable_data();
+    {
+      pybind11::gil_scoped_release release;
+      uint64_t offset = 0;
+      for (size_t i = 0; i < messages.size(); ++i) {
+        const auto & message = *messages[i];
+        const auto length = message.serialized_data->buffer_length;
+        topic_ids[i] = get_topic_id(message.topic_name);
+        timestamps[i] = message.time_stamp;
+        offsets[i] = offset;
+        lengths[i] = length;
+        if (length > 0) {
+          std::memcpy(data + offset, message.serialized_data->buffer, length);
+        }
+        offset += length;
+      }
+    }
+    columns.topics = topic_names_;
+    return columns;
+  }
+
+private:
+  // Ids are assigned in the order topics are first read, and kept for the lifetime of the reader
+  uint32_t get_topic_id(const std::string & topic_name)
+  {
+    auto [it, inserted] = topic_ids_.emplace(
+      topic_name, static_cast<uint32_t>(topic_names_.size()));
+    if (inserted) {
+      topic_names_.push_back(topic_name);
+    }
+    return it->second;
+  }
+
+  std::unordered_map<std::string, uint32_t> topic_ids_;
+  std::vector<std::string> topic_names_;
+
+  static pybind11::tuple to_tuple(const rosbag2_storage::SerializedBagMessage & message)
+  {
+    rcutils_uint8_array_t rcutils_data = *message.serialized_data.get();
     std::string serialized_data(rcutils_data.buffer,
       rcutils_data.buffer + rcutils_data.buffer_length);
     return pybind11::make_tuple(
-      next->topic_name, pybind11::bytes(serialized_data), next->time_stamp);
+      message.topic_name, pybind11::bytes(serialized_data), message.time_stamp);
   }
 };
 
@@ -70,15 +190,271 @@ std::unordered_set<std::string> get_registered_readers()
   return combined_plugins;
 }
 
+/// Iterates over a reader by batches of columns, until the end of the bag
+template<typename T>
+class ColumnsIterator
+{
+public:
+  ColumnsIterator(Reader<T> & reader, size_t max_messages, size_t max_bytes)
+  : reader_(reader), max_messages_(max_messages), max_bytes_(max_bytes)
+  {}
+
+  MessageColumns next()
+  {
+    auto columns = reader_.read_next_columns(max_messages_, max_bytes_);
+    if (columns.timestamps.size() == 0) {
+      throw pybind11::stop_iteration();
+    }
+    return columns;
+  }
+
+private:
+  Reader<T> & reader_;
+  size_t max_messages_;
+  size_t max_bytes_;
+};
+
+// Default number of messages of the batches returned when iterating over a reader
+constexpr size_t kDefaultColumnsBatchSize = 10000;
+
+/// Bind read_next_columns(), iter_columns() and iteration over batches of columns to a reader
+template<typename T>
+void def_columns_api(pybind11::class_<Reader<T>> & reader_class, const char * iterator_name)
+{
+  pybind11::class_<ColumnsIterator<T>>(reader_class, iterator_name)
+  .def("__iter__", [](ColumnsIterator<T> & it) -> ColumnsIterator<T> & {return it;})
+  .def("__next__", &ColumnsIterator<T>::next);
+
+  reader_class
+  .def(
+    "read_next_columns", &Reader<T>::read_next_columns,
+    pybind11::arg("max_messages"), pybind11::arg("max_bytes") = 0)
+  .def(
+    "iter_columns",
+    [](Reader<T> & reader, size_t max_messages, size_t max_bytes) {
+      return ColumnsIterator<T>(reader, max_messages, max_bytes);
+    },
+    pybind11::arg("max_messages") = kDefaultColumnsBatchSize, pybind11::arg("max_bytes") = 0,
+    pybind11::keep_alive<0, 1>())
+  .def(
+    "__iter__",
+    [](Reader<T> & reader) {
+      return ColumnsIterator<T>(reader, kDefaultColumnsBatchSize, 0);
+    },
+    pybind11::keep_alive<0, 1>());
+}
+
+/// Extracts fields of serialized messages of one type into NumPy arrays, one per field.
+/// Messages are deserialized in C++ without holding the GIL and no Python message is created.
+class FieldExtractor
+{
+public:
+  FieldExtractor(
+    const std::string & type,
+    const std::vector<std::string> & field_paths,
+    const std::string & serialization_format)
+  : extractor_(type, field_paths, serialization_format)
+  {}
+
+  /// Extract the fields of the messages of a topic in a batch of columns. If no topic is given,
+  /// all messages of the batch must be of the type of the extractor.
+  pybind11::dict extract_columns(
+    const MessageColumns & columns, const std::optional<std::string> & topic)
+  {
+    const auto count = static_cast<size_t>(columns.timestamps.size());
+    const auto * topic_ids = columns.topic_ids.data();
+    std::vector<size_t> rows;
+    if (topic) {
+      const auto it = std::find(columns.topics.begin(), columns.topics.end(), *topic);
+      const auto topic_id = static_cast<uint32_t>(it - columns.topics.begin());
+      for (size_t i = 0; i < count; ++i) {
+        if (topic_ids[i] == topic_id) {
+          rows.push_back(i);
+        }
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        rows.push_back(i);
+      }
+    }
+
+    auto arrays = make_arrays(rows.size());
+    auto pointers = data_pointers(arrays);
+    const auto * data = columns.data.data();
+    const auto * offsets = columns.offsets.data();
+    const auto * lengths = columns.lengths.data();
+    {
+      pybind11::gil_scoped_release release;
+      rcutils_uint8_array_t message = rcutils_get_zero_initialized_uint8_array();
+      for (size_t row = 0; row < rows.size(); ++row) {
+        message.buffer = const_cast<uint8_t *>(data + offsets[rows[row]]);
+        message.buffer_length = lengths[rows[row]];
+        message.buffer_capacity = message.buffer_length;
+        extractor_.extract(message, pointers, row);
+      }
+    }
+    return to_dict(arrays);
+  }
+
+  /// Extract the fields of a sequence of serialized messages, given as bytes-like objects.
+  pybind11::dict extract_messages(const std::vector<pybind11::buffer> & messages)
+  {
+    std::vector<pybind11::buffer_info> buffers;
+    buffers.reserve(messages.size());
+    for (const auto & message : messages) {
+      buffers.push_back(message.request());
+    }
+
+    auto arrays = make_arrays(buffers.size());
+    auto pointers = data_pointers(arrays);
+    {
+      pybind11::gil_scoped_release release;
+      rcutils_uint8_array_t message = rcutils_get_zero_initialized_uint8_array();
+      for (size_t row = 0; row < buffers.size(); ++row) {
+        message.buffer = static_cast<uint8_t *>(buffers[row].ptr);
+        message.buffer_length = static_cast<size_t>(buffers[row].size * buffers[row].itemsize);
+        message.buffer_capacity = message.buffer_length;
+        extractor_.extract(message, pointers, row);
+      }
+    }
+    return to_dict(arrays);
+  }
+
+  const std::vector<std::string> & field_paths() const
+  {
+    return extractor_.field_paths();
+  }
+
+private:
+  static pybind11::dtype to_dtype(uint8_t type_id)
+  {
+    namespace ts = rosidl_typesupport_introspection_cpp;
+    switch (type_id) {
+      case ts::ROS_TYPE_FLOAT:
+        return pybind11::dtype::of<float>();
+      case ts::ROS_TYPE_DOUBLE:
+        return pybind11::dtype::of<double>();
+      case ts::ROS_TYPE_BOOLEAN:
+        return pybind11::dtype::of<bool>();
+      case ts::ROS_TYPE_INT8:
+        return pybind11::dtype::of<int8_t>();
+      case ts::ROS_TYPE_CHAR:
+      case ts::ROS_TYPE_OCTET:
+      case ts::ROS_TYPE_UINT8:
+        return pybind11::dtype::of<uint8_t>();
+      case ts::ROS_TYPE_INT16:
+        return pybind11::dtype::of<int16_t>();
+      case ts::ROS_TYPE_WCHAR:
+      case ts::ROS_TYPE_UINT16:
+        return pybind11::dtype::of<uint16_t>();
+      case ts::ROS_TYPE_INT32:
+        return pybind11::dtype::of<int32_t>();
+      case ts::ROS_TYPE_UINT32:
+        return pybind11::dtype::of<uint32_t>();
+      case ts::ROS_TYPE_INT64:
+        return pybind11::dtype::of<int64_t>();
+      default:
+        return pybind11::dtype::of<uint64_t>();
+    }
+  }
+
+  std::vector<pybind11::array> make_arrays(size_t count) const
+  {
+    std::vector<pybind11::array> arrays;
+    for (const auto type_id : extractor_.field_types()) {
+      arrays.emplace_back(to_dtype(type_id), std::vector<pybind11::ssize_t>{
+          static_cast<pybind11::ssize_t>(count)});
+    }
+    return arrays;
+  }
+
+  static std::vector<void *> data_pointers(std::vector<pybind11::array> & arrays)
+  {
+    std::vector<void *> pointers;
+    for (auto & array : arrays) {
+      pointers.push_back(array.mutable_data());
+    }
+    return pointers;
+  }
+
+  pybind11::dict to_dict(const std::vector<pybind11::array> & arrays) const
+  {
+    pybind11::dict result;
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      result[pybind11::str(extractor_.field_paths()[i])] = arrays[i];
+    }
+    return result;
+  }
+
+  rosbag2_cpp::FieldExtractor extractor_;
+};
+
+template<typename T>
+std::unique_ptr<Reader<rosbag2_cpp::readers::PrefetchingReader>> make_prefetching_reader(
+  size_t max_prefetched_bytes)
+{
+  return std::make_unique<Reader<rosbag2_cpp::readers::PrefetchingReader>>(
+    std::make_unique<rosbag2_cpp::readers::PrefetchingReader>(
+      std::make_unique<T>(), max_prefetched_bytes));
+}
+
 }  // namespace rosbag2_py
 
 using PyReader = rosbag2_py::Reader<rosbag2_cpp::readers::SequentialReader>;
 using PyCompressionReader = rosbag2_py::Reader<rosbag2_compression::SequentialCompressionReader>;
+using PyPrefetchingReader = rosbag2_py::Reader<rosbag2_cpp::readers::PrefetchingReader>;
 
 PYBIND11_MODULE(_reader, m) {
   m.doc() = "Python wrapper of the rosbag2_cpp reader API";
 
-  pybind11::class_<PyReader>(m, "SequentialReader")
+  pybind11::class_<rosbag2_py::SerializedDataBuffer>(
+    m, "SerializedDataBuffer", pybind11::buffer_protocol())
+  .def_buffer(
+    [](rosbag2_py::SerializedDataBuffer & buffer) {
+      return pybind11::buffer_info(
+        buffer.data->buffer, sizeof(uint8_t), pybind11::format_descriptor<uint8_t>::format(), 1,
+        {static_cast<pybind11::ssize_t>(buffer.data->buffer_length)}, {sizeof(uint8_t)}, true);
+    })
+  .def(
+    "__len__", [](const rosbag2_py::SerializedDataBuffer & buffer) {
+      return buffer.data->buffer_length;
+    })
+  .def(
+    "__bytes__", [](const rosbag2_py::SerializedDataBuffer & buffer) {
+      return pybind11::bytes(
+        reinterpret_cast<const char *>(buffer.data->buffer), buffer.data->buffer_length);
+    });
+
+  pybind11::class_<rosbag2_py::MessageColumns>(m, "MessageColumns")
+  .def_readonly("topics", &rosbag2_py::MessageColumns::topics)
+  .def_readonly("topic_ids", &rosbag2_py::MessageColumns::topic_ids)
+  .def_readonly("timestamps", &rosbag2_py::MessageColumns::timestamps)
+  .def_property_readonly(
+    "data", [](const rosbag2_py::MessageColumns & columns) {
+      return pybind11::memoryview(columns.data);
+    })
+  .def_readonly("offsets", &rosbag2_py::MessageColumns::offsets)
+  .def_readonly("lengths", &rosbag2_py::MessageColumns::lengths)
+  .def(
+    "__len__", [](const rosbag2_py::MessageColumns & columns) {
+      return columns.timestamps.size();
+    });
+
+  pybind11::class_<rosbag2_py::FieldExtractor>(m, "FieldExtractor")
+  .def(
+    pybind11::init<const std::string &, const std::vector<std::string> &, const std::string &>(),
+    pybind11::arg("type"), pybind11::arg("field_paths"),
+    pybind11::arg("serialization_format") = "cdr")
+  .def_property_readonly("field_paths", &rosbag2_py::FieldExtractor::field_paths)
+  .def(
+    "extract", &rosbag2_py::FieldExtractor::extract_columns,
+    pybind11::arg("columns"), pybind11::arg("topic") = std::nullopt)
+  .def(
+    "extract", &rosbag2_py::FieldExtractor::extract_messages,
+    pybind11::arg("messages"));
+
+  pybind11::class_<PyReader> reader_class(m, "SequentialReader");
+  reader_class
   .def(pybind11::init())
   .def("open_uri", pybind11::overload_cast<const std::string &>(&PyReader::open))
   .def(
@@ -88,6 +464,10 @@ PYBIND11_MODULE(_reader, m) {
     >(&PyReader::open))
   .def("set_read_order", &PyReader::set_read_order)
   .def("read_next", &PyReader::read_next)
+  .def("read_next_buffer", &PyReader::read_next_buffer)
+  .def(
+    "read_next_batch", &PyReader::read_next_batch,
+    pybind11::arg("max_messages"), pybind11::arg("max_bytes") = 0)
   .def("has_next", &PyReader::has_next)
   .def("get_metadata", &PyReader::get_metadata)
   .def("get_all_topics_and_types", &PyReader::get_all_topics_and_types)
@@ -99,9 +479,12 @@ PYBIND11_MODULE(_reader, m) {
     })
   .def("set_filter", &PyReader::set_filter)
   .def("reset_filter", &PyReader::reset_filter)
+  .def("estimate", &PyReader::estimate)
   .def("seek", &PyReader::seek);
+  rosbag2_py::def_columns_api(reader_class, "ColumnsIterator");
 
-  pybind11::class_<PyCompressionReader>(m, "SequentialCompressionReader")
+  pybind11::class_<PyCompressionReader> compression_reader_class(m, "SequentialCompressionReader");
+  compression_reader_class
   .def(pybind11::init())
   .def("open_uri", pybind11::overload_cast<const std::string &>(&PyCompressionReader::open))
   .def(
@@ -111,6 +494,10 @@ PYBIND11_MODULE(_reader, m) {
     >(&PyCompressionReader::open))
   .def("set_read_order", &PyCompressionReader::set_read_order)
   .def("read_next", &PyCompressionReader::read_next)
+  .def("read_next_buffer", &PyCompressionReader::read_next_buffer)
+  .def(
+    "read_next_batch", &PyCompressionReader::read_next_batch,
+    pybind11::arg("max_messages"), pybind11::arg("max_bytes") = 0)
   .def("has_next", &PyCompressionReader::has_next)
   .def("get_metadata", &PyCompressionReader::get_metadata)
   .def("get_all_topics_and_types", &PyCompressionReader::get_all_topics_and_types)
@@ -122,7 +509,53 @@ PYBIND11_MODULE(_reader, m) {
     })
   .def("set_filter", &PyCompressionReader::set_filter)
   .def("reset_filter", &PyCompressionReader::reset_filter)
+  .def("estimate", &PyCompressionReader::estimate)
   .def("seek", &PyCompressionReader::seek);
+  rosbag2_py::def_columns_api(compression_reader_class, "ColumnsIterator");
+
+  pybind11::class_<PyPrefetchingReader> prefetching_reader_class(m, "PrefetchingReader");
+  prefetching_reader_class
+  .def(
+    pybind11::init(
+      [](size_t max_prefetched_bytes, bool compressed) {
+        return compressed ?
+        rosbag2_py::make_prefetching_reader<rosbag2_compression::SequentialCompressionReader>(
+          max_prefetched_bytes) :
+        rosbag2_py::make_prefetching_reader<rosbag2_cpp::readers::SequentialReader>(
+          max_prefetched_bytes);
+      }),
+    pybind11::arg("max_prefetched_bytes") =
+    rosbag2_cpp::readers::PrefetchingReader::kDefaultMaxPrefetchedBytes,
+    pybind11::arg("compressed") = false,
+    "Reader which reads messages ahead of time on a background thread, until their serialized "
+    "data reaches max_prefetched_bytes. Wraps a SequentialCompressionReader if compressed is "
+    "set, a SequentialReader otherwise.")
+  .def("open_uri", pybind11::overload_cast<const std::string &>(&PyPrefetchingReader::open))
+  .def(
+    "open",
+    pybind11::overload_cast<
+      const rosbag2_storage::StorageOptions &, const rosbag2_cpp::ConverterOptions &
+    >(&PyPrefetchingReader::open))
+  .def("set_read_order", &PyPrefetchingReader::set_read_order)
+  .def("read_next", &PyPrefetchingReader::read_next)
+  .def("read_next_buffer", &PyPrefetchingReader::read_next_buffer)
+  .def(
+    "read_next_batch", &PyPrefetchingReader::read_next_batch,
+    pybind11::arg("max_messages"), pybind11::arg("max_bytes") = 0)
+  .def("has_next", &PyPrefetchingReader::has_next)
+  .def("get_metadata", &PyPrefetchingReader::get_metadata)
+  .def("get_all_topics_and_types", &PyPrefetchingReader::get_all_topics_and_types)
+  .def(
+    "get_all_message_definitions", [](PyPrefetchingReader & reader) {
+      std::vector<rosbag2_storage::MessageDefinition> definitions;
+      reader.get_all_message_definitions(definitions);
+      return definitions;
+    })
+  .def("set_filter", &PyPrefetchingReader::set_filter)
+  .def("reset_filter", &PyPrefetchingReader::reset_filter)
+  .def("estimate", &PyPrefetchingReader::estimate)
+  .def("seek", &PyPrefetchingReader::seek);
+  rosbag2_py::def_columns_api(prefetching_reader_class, "ColumnsIterator");
   m.def(
     "get_registered_readers",
     &rosbag2_py::get_registered_readers,
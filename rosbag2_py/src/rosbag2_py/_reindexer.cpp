@@ -24,7 +24,11 @@
 #include <string>
 #include <vector>
 
+#include "rosbag2_compression/sequential_compression_reader.hpp"
+#include "rosbag2_cpp/header_stamp_index.hpp"
+#include "rosbag2_cpp/readers/sequential_reader.hpp"
 #include "rosbag2_cpp/reindexer.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 
 #include "./pybind11.hpp"
@@ -45,6 +49,24 @@ public:
     reindexer_->reindex(storage_options);
   }
 
+  size_t index_header_stamps(const rosbag2_storage::StorageOptions & storage_options)
+  {
+    std::unique_ptr<rosbag2_cpp::readers::SequentialReader> reader;
+    rosbag2_storage::MetadataIo metadata_io;
+    if (metadata_io.metadata_file_exists(storage_options.uri) &&
+      !metadata_io.read_metadata(storage_options.uri).compression_format.empty())
+    {
+      reader = std::make_unique<rosbag2_compression::SequentialCompressionReader>();
+    } else {
+      reader = std::make_unique<rosbag2_cpp::readers::SequentialReader>();
+    }
+    reader->open(storage_options, {});
+    const auto index = rosbag2_cpp::HeaderStampIndex::build(*reader);
+    reader->close();
+    index.write(storage_options.uri);
+    return index.size();
+  }
+
 protected:
   std::unique_ptr<rosbag2_cpp::Reindexer> reindexer_;
 };
@@ -56,5 +78,6 @@ PYBIND11_MODULE(_reindexer, m) {
   pybind11::class_<rosbag2_py::Reindexer>(
     m, "Reindexer")
   .def(pybind11::init())
-  .def("reindex", &rosbag2_py::Reindexer::reindex);
+  .def("reindex", &rosbag2_py::Reindexer::reindex)
+  .def("index_header_stamps", &rosbag2_py::Reindexer::index_header_stamps);
 }
@@ -19,10 +19,12 @@
 #include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage/default_storage_id.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/read_estimate.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_interfaces/base_read_interface.hpp"
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 #include "rosbag2_storage/qos.hpp"
 
 #include "./format_bag_metadata.hpp"
@@ -78,14 +80,25 @@ PYBIND11_MODULE(_storage, m) {
     &rosbag2_cpp::ConverterOptions::input_serialization_format)
   .def_readwrite(
     "output_serialization_format",
-    &rosbag2_cpp::ConverterOptions::output_serialization_format);
+    &rosbag2_cpp::ConverterOptions::output_serialization_format)
+  .def_readwrite(
+    "conversion_threads",
+    &rosbag2_cpp::ConverterOptions::conversion_threads);
 
   using KEY_VALUE_MAP = std::unordered_map<std::string, std::string>;
+  using TOPIC_GROUPS_MAP = std::unordered_map<std::string, std::vector<std::string>>;
+  using SHARD_SIZES_MAP = std::unordered_map<std::string, uint64_t>;
+  using TOPIC_PRIORITIES_MAP = std::unordered_map<std::string, uint32_t>;
   pybind11::class_<rosbag2_storage::StorageOptions>(m, "StorageOptions")
   .def(
     pybind11::init<
       std::string, std::string, uint64_t, uint64_t, uint64_t, std::string, std::string, bool,
-      int64_t, int64_t, KEY_VALUE_MAP>(),
+      int64_t, int64_t, KEY_VALUE_MAP, bool, bool, TOPIC_GROUPS_MAP, SHARD_SIZES_MAP,
+      std::string, uint64_t, std::string, uint64_t, uint64_t, uint64_t, uint64_t, bool,
+      bool, uint64_t, uint64_t, bool, bool, uint64_t, uint64_t, uint64_t, double, uint64_t,
+      uint64_t, std::string, uint64_t, std::string, int32_t, std::vector<uint64_t>, uint64_t,
+      uint64_t, std::vector<std::string>, uint64_t, uint64_t, std::vector<std::string>,
+      uint64_t, TOPIC_PRIORITIES_MAP, uint64_t, uint64_t, bool, uint64_t, KEY_VALUE_MAP>(),
     pybind11::arg("uri"),
     pybind11::arg("storage_id") = "",
     pybind11::arg("max_bagfile_size") = 0,
@@ -96,7 +109,48 @@ PYBIND11_MODULE(_storage, m) {
     pybind11::arg("snapshot_mode") = false,
     pybind11::arg("start_time_ns") = -1,
     pybind11::arg("end_time_ns") = -1,
-    pybind11::arg("custom_data") = KEY_VALUE_MAP{})
+    pybind11::arg("custom_data") = KEY_VALUE_MAP{},
+    pybind11::arg("lock_free_cache") = false,
+    pybind11::arg("shard_cache_per_topic") = false,
+    pybind11::arg("cache_topic_groups") = TOPIC_GROUPS_MAP{},
+    pybind11::arg("cache_shard_sizes") = SHARD_SIZES_MAP{},
+    pybind11::arg("cache_overflow_policy") = "drop_newest",
+    pybind11::arg("cache_block_timeout_ms") = 0,
+    pybind11::arg("cache_spill_directory") = "",
+    pybind11::arg("cache_spill_size") = 1024 * 1024 * 1024,
+    pybind11::arg("cache_min_batch_size") = 0,
+    pybind11::arg("cache_max_batch_size") = 0,
+    pybind11::arg("cache_max_batch_latency_ms") = 100,
+    pybind11::arg("cache_adaptive_batching") = false,
+    pybind11::arg("async_split") = false,
+    pybind11::arg("max_bag_retention_size") = 0,
+    pybind11::arg("max_bag_retention_duration") = 0,
+    pybind11::arg("preallocate_bagfiles") = false,
+    pybind11::arg("metadata_only") = false,
+    pybind11::arg("decompression_look_ahead_files") = 0,
+    pybind11::arg("decompression_disk_budget") = 0,
+    pybind11::arg("decompression_threads") = 0,
+    pybind11::arg("next_file_open_fraction") = 0.0,
+    pybind11::arg("snapshot_duration_ms") = 0,
+    pybind11::arg("snapshot_post_trigger_duration_ms") = 0,
+    pybind11::arg("message_definition_cache_directory") = "",
+    pybind11::arg("message_definition_threads") = 0,
+    pybind11::arg("cache_consumer_thread_policy") = "fifo",
+    pybind11::arg("cache_consumer_thread_priority") = 0,
+    pybind11::arg("cache_consumer_thread_cpus") = std::vector<uint64_t>{},
+    pybind11::arg("deduplication_min_payload_size") = 0,
+    pybind11::arg("deduplication_cache_size") = 64 * 1024 * 1024,
+    pybind11::arg("delta_encoded_topics") = std::vector<std::string>{},
+    pybind11::arg("delta_keyframe_interval") = 10,
+    pybind11::arg("preview_bucket_duration_ms") = 0,
+    pybind11::arg("preview_sample_topics") = std::vector<std::string>{},
+    pybind11::arg("preview_sample_interval") = 100,
+    pybind11::arg("cache_topic_priorities") = TOPIC_PRIORITIES_MAP{},
+    pybind11::arg("durability_interval_ms") = 0,
+    pybind11::arg("durability_bytes") = 0,
+    pybind11::arg("snapshot_contiguous_buffer") = false,
+    pybind11::arg("read_buffer_pool_size") = 0,
+    pybind11::arg("cache_shard_policies") = KEY_VALUE_MAP{})
   .def_readwrite("uri", &rosbag2_storage::StorageOptions::uri)
   .def_readwrite("storage_id", &rosbag2_storage::StorageOptions::storage_id)
   .def_readwrite(
@@ -125,19 +179,157 @@ PYBIND11_MODULE(_storage, m) {
     &rosbag2_storage::StorageOptions::end_time_ns)
   .def_readwrite(
     "custom_data",
-    &rosbag2_storage::StorageOptions::custom_data);
+    &rosbag2_storage::StorageOptions::custom_data)
+  .def_readwrite(
+    "lock_free_cache",
+    &rosbag2_storage::StorageOptions::lock_free_cache)
+  .def_readwrite(
+    "shard_cache_per_topic",
+    &rosbag2_storage::StorageOptions::shard_cache_per_topic)
+  .def_readwrite(
+    "cache_topic_groups",
+    &rosbag2_storage::StorageOptions::cache_topic_groups)
+  .def_readwrite(
+    "cache_shard_sizes",
+    &rosbag2_storage::StorageOptions::cache_shard_sizes)
+  .def_readwrite(
+    "cache_shard_policies",
+    &rosbag2_storage::StorageOptions::cache_shard_policies)
+  .def_readwrite(
+    "cache_overflow_policy",
+    &rosbag2_storage::StorageOptions::cache_overflow_policy)
+  .def_readwrite(
+    "cache_block_timeout_ms",
+    &rosbag2_storage::StorageOptions::cache_block_timeout_ms)
+  .def_readwrite(
+    "cache_spill_directory",
+    &rosbag2_storage::StorageOptions::cache_spill_directory)
+  .def_readwrite(
+    "cache_spill_size",
+    &rosbag2_storage::StorageOptions::cache_spill_size)
+  .def_readwrite(
+    "cache_min_batch_size",
+    &rosbag2_storage::StorageOptions::cache_min_batch_size)
+  .def_readwrite(
+    "cache_max_batch_size",
+    &rosbag2_storage::StorageOptions::cache_max_batch_size)
+  .def_readwrite(
+    "cache_max_batch_latency_ms",
+    &rosbag2_storage::StorageOptions::cache_max_batch_latency_ms)
+  .def_readwrite(
+    "cache_adaptive_batching",
+    &rosbag2_storage::StorageOptions::cache_adaptive_batching)
+  .def_readwrite(
+    "async_split",
+    &rosbag2_storage::StorageOptions::async_split)
+  .def_readwrite(
+    "max_bag_retention_size",
+    &rosbag2_storage::StorageOptions::max_bag_retention_size)
+  .def_readwrite(
+    "max_bag_retention_duration",
+    &rosbag2_storage::StorageOptions::max_bag_retention_duration)
+  .def_readwrite(
+    "preallocate_bagfiles",
+    &rosbag2_storage::StorageOptions::preallocate_bagfiles)
+  .def_readwrite(
+    "metadata_only",
+    &rosbag2_storage::StorageOptions::metadata_only)
+  .def_readwrite(
+    "decompression_look_ahead_files",
+    &rosbag2_storage::StorageOptions::decompression_look_ahead_files)
+  .def_readwrite(
+    "decompression_disk_budget",
+    &rosbag2_storage::StorageOptions::decompression_disk_budget)
+  .def_readwrite(
+    "decompression_threads",
+    &rosbag2_storage::StorageOptions::decompression_threads)
+  .def_readwrite(
+    "next_file_open_fraction",
+    &rosbag2_storage::StorageOptions::next_file_open_fraction)
+  .def_readwrite(
+    "snapshot_duration_ms",
+    &rosbag2_storage::StorageOptions::snapshot_duration_ms)
+  .def_readwrite(
+    "snapshot_post_trigger_duration_ms",
+    &rosbag2_storage::StorageOptions::snapshot_post_trigger_duration_ms)
+  .def_readwrite(
+    "message_definition_cache_directory",
+    &rosbag2_storage::StorageOptions::message_definition_cache_directory)
+  .def_readwrite(
+    "message_definition_threads",
+    &rosbag2_storage::StorageOptions::message_definition_threads)
+  .def_readwrite(
+    "cache_consumer_thread_policy",
+    &rosbag2_storage::StorageOptions::cache_consumer_thread_policy)
+  .def_readwrite(
+    "cache_consumer_thread_priority",
+    &rosbag2_storage::StorageOptions::cache_consumer_thread_priority)
+  .def_readwrite(
+    "cache_consumer_thread_cpus",
+    &rosbag2_storage::StorageOptions::cache_consumer_thread_cpus)
+  .def_readwrite(
+    "deduplication_min_payload_size",
+    &rosbag2_storage::StorageOptions::deduplication_min_payload_size)
+  .def_readwrite(
+    "deduplication_cache_size",
+    &rosbag2_storage::StorageOptions::deduplication_cache_size)
+  .def_readwrite(
+    "delta_encoded_topics",
+    &rosbag2_storage::StorageOptions::delta_encoded_topics)
+  .def_readwrite(
+    "delta_keyframe_interval",
+    &rosbag2_storage::StorageOptions::delta_keyframe_interval)
+  .def_readwrite(
+    "preview_bucket_duration_ms",
+    &rosbag2_storage::StorageOptions::preview_bucket_duration_ms)
+  .def_readwrite(
+    "preview_sample_topics",
+    &rosbag2_storage::StorageOptions::preview_sample_topics)
+  .def_readwrite(
+    "preview_sample_interval",
+    &rosbag2_storage::StorageOptions::preview_sample_interval)
+  .def_readwrite(
+    "cache_topic_priorities",
+    &rosbag2_storage::StorageOptions::cache_topic_priorities)
+  .def_readwrite(
+    "durability_interval_ms",
+    &rosbag2_storage::StorageOptions::durability_interval_ms)
+  .def_readwrite(
+    "durability_bytes",
+    &rosbag2_storage::StorageOptions::durability_bytes)
+  .def_readwrite(
+    "snapshot_contiguous_buffer",
+    &rosbag2_storage::StorageOptions::snapshot_contiguous_buffer)
+  .def_readwrite(
+    "read_buffer_pool_size",
+    &rosbag2_storage::StorageOptions::read_buffer_pool_size);
 
   pybind11::class_<rosbag2_storage::StorageFilter>(m, "StorageFilter")
   .def(
-    pybind11::init<std::vector<std::string>, std::string, std::string>(),
+    pybind11::init<
+      std::vector<std::string>, std::string, std::string, int64_t, int64_t, int64_t, uint64_t>(),
     pybind11::arg("topics") = std::vector<std::string>(),
     pybind11::arg("topics_regex") = "",
-    pybind11::arg("topics_regex_to_exclude") = "")
+    pybind11::arg("topics_regex_to_exclude") = "",
+    pybind11::arg("start_time_ns") = -1,
+    pybind11::arg("end_time_ns") = -1,
+    pybind11::arg("sample_interval_ns") = 0,
+    pybind11::arg("sample_stride") = 0)
   .def_readwrite("topics", &rosbag2_storage::StorageFilter::topics)
   .def_readwrite("topics_regex", &rosbag2_storage::StorageFilter::topics_regex)
   .def_readwrite(
     "topics_regex_to_exclude",
-    &rosbag2_storage::StorageFilter::topics_regex_to_exclude);
+    &rosbag2_storage::StorageFilter::topics_regex_to_exclude)
+  .def_readwrite("start_time_ns", &rosbag2_storage::StorageFilter::start_time_ns)
+  .def_readwrite("end_time_ns", &rosbag2_storage::StorageFilter::end_time_ns)
+  .def_readwrite("sample_interval_ns", &rosbag2_storage::StorageFilter::sample_interval_ns)
+  .def_readwrite("sample_stride", &rosbag2_storage::StorageFilter::sample_stride);
+
+  pybind11::class_<rosbag2_storage::ReadEstimate>(m, "ReadEstimate")
+  .def(pybind11::init())
+  .def_readwrite("message_count", &rosbag2_storage::ReadEstimate::message_count)
+  .def_readwrite("bytes", &rosbag2_storage::ReadEstimate::bytes)
+  .def_readwrite("exact", &rosbag2_storage::ReadEstimate::exact);
 
   pybind11::class_<rosbag2_storage::MessageDefinition>(m, "MessageDefinition")
   .def(
@@ -238,6 +430,18 @@ PYBIND11_MODULE(_storage, m) {
   .def_readwrite("topic_metadata", &rosbag2_storage::TopicInformation::topic_metadata)
   .def_readwrite("message_count", &rosbag2_storage::TopicInformation::message_count);
 
+  pybind11::class_<rosbag2_storage::TopicStatistics>(m, "TopicStatistics")
+  .def(pybind11::init())
+  .def_readwrite("topic_name", &rosbag2_storage::TopicStatistics::topic_name)
+  .def_readwrite("message_count", &rosbag2_storage::TopicStatistics::message_count)
+  .def_readwrite("min_timestamp", &rosbag2_storage::TopicStatistics::min_timestamp)
+  .def_readwrite("max_timestamp", &rosbag2_storage::TopicStatistics::max_timestamp)
+  .def_readwrite("total_bytes", &rosbag2_storage::TopicStatistics::total_bytes)
+  .def_readwrite("min_message_size", &rosbag2_storage::TopicStatistics::min_message_size)
+  .def_readwrite("max_message_size", &rosbag2_storage::TopicStatistics::max_message_size)
+  .def_readwrite("interval_histogram", &rosbag2_storage::TopicStatistics::interval_histogram)
+  .def_readwrite("gap_count", &rosbag2_storage::TopicStatistics::gap_count);
+
   pybind11::class_<rosbag2_storage::FileInformation>(m, "FileInformation")
   .def(
     pybind11::init(
@@ -245,19 +449,25 @@ PYBIND11_MODULE(_storage, m) {
         std::string path,
         pybind11::object starting_time,
         pybind11::object duration,
-        size_t message_count)
+        size_t message_count,
+        int64_t window_start_time_ns,
+        int64_t window_end_time_ns)
       {
-        return rosbag2_storage::FileInformation{
-          path,
-          from_rclpy_time(starting_time),
-          from_rclpy_duration(duration),
-          message_count
-        };
+        rosbag2_storage::FileInformation file_information;
+        file_information.path = path;
+        file_information.starting_time = from_rclpy_time(starting_time);
+        file_information.duration = from_rclpy_duration(duration);
+        file_information.message_count = message_count;
+        file_information.window_start_time_ns = window_start_time_ns;
+        file_information.window_end_time_ns = window_end_time_ns;
+        return file_information;
       }),
     pybind11::arg("path"),
     pybind11::arg("starting_time"),
     pybind11::arg("duration"),
-    pybind11::arg("message_count")
+    pybind11::arg("message_count"),
+    pybind11::arg("window_start_time_ns") = -1,
+    pybind11::arg("window_end_time_ns") = -1
   )
   .def_readwrite("path", &rosbag2_storage::FileInformation::path)
   .def_property(
@@ -277,7 +487,10 @@ PYBIND11_MODULE(_storage, m) {
       self.duration = from_rclpy_duration(value);
     })
   .def_readwrite("duration", &rosbag2_storage::FileInformation::duration)
-  .def_readwrite("message_count", &rosbag2_storage::FileInformation::message_count);
+  .def_readwrite("message_count", &rosbag2_storage::FileInformation::message_count)
+  .def_readwrite(
+    "window_start_time_ns", &rosbag2_storage::FileInformation::window_start_time_ns)
+  .def_readwrite("window_end_time_ns", &rosbag2_storage::FileInformation::window_end_time_ns);
 
   pybind11::class_<rosbag2_storage::BagMetadata>(m, "BagMetadata")
   .def(
@@ -364,7 +577,8 @@ PYBIND11_MODULE(_storage, m) {
   pybind11::enum_<rosbag2_storage::ReadOrder::SortBy>(m, "ReadOrderSortBy")
   .value("ReceivedTimestamp", rosbag2_storage::ReadOrder::ReceivedTimestamp)
   .value("PublishedTimestamp", rosbag2_storage::ReadOrder::PublishedTimestamp)
-  .value("File", rosbag2_storage::ReadOrder::File);
+  .value("File", rosbag2_storage::ReadOrder::File)
+  .value("HeaderTimestamp", rosbag2_storage::ReadOrder::HeaderTimestamp);
 
   pybind11::class_<rosbag2_storage::ReadOrder>(m, "ReadOrder")
   .def(
@@ -383,6 +597,8 @@ PYBIND11_MODULE(_storage, m) {
   .def(pybind11::init<>())
   .def("write_metadata", &rosbag2_storage::MetadataIo::write_metadata)
   .def("read_metadata", &rosbag2_storage::MetadataIo::read_metadata)
+  .def("write_topic_statistics", &rosbag2_storage::MetadataIo::write_topic_statistics)
+  .def("read_topic_statistics", &rosbag2_storage::MetadataIo::read_topic_statistics)
   .def("metadata_file_exists", &rosbag2_storage::MetadataIo::metadata_file_exists)
   .def("serialize_metadata", &rosbag2_storage::MetadataIo::serialize_metadata)
   .def("deserialize_metadata", &rosbag2_storage::MetadataIo::deserialize_metadata)
@@ -15,6 +15,8 @@
 #include <csignal>
 #include <chrono>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -22,6 +24,7 @@
 
 #include "rosbag2_storage/storage_options.hpp"
 #include "rosbag2_storage/yaml.hpp"
+#include "rosbag2_transport/bag_export.hpp"
 #include "rosbag2_transport/bag_rewrite.hpp"
 #include "rosbag2_transport/play_options.hpp"
 #include "rosbag2_transport/player.hpp"
@@ -144,7 +147,32 @@ public:
     const rosbag2_storage::StorageOptions & storage_options,
     PlayOptions & play_options)
   {
-    auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(storage_options);
+    play_impl(
+      rosbag2_transport::ReaderWriterFactory::make_reader(
+        storage_options, play_options.prefetch_queue_bytes),
+      storage_options, play_options);
+  }
+
+  void play_bags(
+    const std::vector<rosbag2_storage::StorageOptions> & storage_options,
+    PlayOptions & play_options)
+  {
+    if (storage_options.empty()) {
+      throw std::invalid_argument("At least one bag is needed to play.");
+    }
+    play_impl(
+      rosbag2_transport::ReaderWriterFactory::make_reader(
+        storage_options, play_options.prefetch_queue_bytes),
+      storage_options.front(), play_options);
+  }
+
+  void burst(
+    const rosbag2_storage::StorageOptions & storage_options,
+    PlayOptions & play_options,
+    size_t num_messages)
+  {
+    auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(
+      storage_options, play_options.prefetch_queue_bytes);
     auto player = std::make_shared<rosbag2_transport::Player>(
       std::move(reader), storage_options, play_options);
 
@@ -155,18 +183,18 @@ public:
         exec.spin();
       });
     player->play();
-    player->wait_for_playback_to_finish();
+    player->burst(num_messages);
 
     exec.cancel();
     spin_thread.join();
   }
 
-  void burst(
+protected:
+  void play_impl(
+    std::unique_ptr<rosbag2_cpp::Reader> reader,
     const rosbag2_storage::StorageOptions & storage_options,
-    PlayOptions & play_options,
-    size_t num_messages)
+    PlayOptions & play_options)
   {
-    auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(storage_options);
     auto player = std::make_shared<rosbag2_transport::Player>(
       std::move(reader), storage_options, play_options);
 
@@ -177,7 +205,7 @@ public:
         exec.spin();
       });
     player->play();
-    player->burst(num_messages);
+    player->wait_for_playback_to_finish();
 
     exec.cancel();
     spin_thread.join();
@@ -214,7 +242,13 @@ public:
     std::string & node_name)
   {
     exit_ = false;
-    auto exec = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+    std::unique_ptr<rclcpp::Executor> exec;
+    if (record_options.executor_threads > 1) {
+      exec = std::make_unique<rclcpp::executors::MultiThreadedExecutor>(
+        rclcpp::ExecutorOptions(), record_options.executor_threads);
+    } else {
+      exec = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+    }
     if (record_options.rmw_serialization_format.empty()) {
       record_options.rmw_serialization_format = std::string(rmw_get_serialization_format());
     }
@@ -323,6 +357,8 @@ PYBIND11_MODULE(_transport, m) {
     &PlayOptions::setTopicQoSProfileOverrides)
   .def_readwrite("loop", &PlayOptions::loop)
   .def_readwrite("topic_remapping_options", &PlayOptions::topic_remapping_options)
+  .def_readwrite("topic_decimation", &PlayOptions::topic_decimation)
+  .def_readwrite("topic_publish_policies", &PlayOptions::topic_publish_policies)
   .def_readwrite("clock_publish_frequency", &PlayOptions::clock_publish_frequency)
   .def_readwrite("clock_publish_on_topic_publish", &PlayOptions::clock_publish_on_topic_publish)
   .def_readwrite("clock_topics", &PlayOptions::clock_trigger_topics)
@@ -346,6 +382,69 @@ PYBIND11_MODULE(_transport, m) {
     &PlayOptions::setPlaybackUntilTimestamp)
   .def_readwrite("wait_acked_timeout", &PlayOptions::wait_acked_timeout)
   .def_readwrite("disable_loan_message", &PlayOptions::disable_loan_message)
+  .def_readwrite("prefetch_queue_bytes", &PlayOptions::prefetch_queue_bytes)
+  .def_readwrite("read_ahead_queue_bytes", &PlayOptions::read_ahead_queue_bytes)
+  .def_readwrite("publishing_threads", &PlayOptions::publishing_threads)
+  .def_readwrite(
+    "precise_timing_spin_duration", &PlayOptions::precise_timing_spin_duration)
+  .def_readwrite("playback_thread_priority", &PlayOptions::playback_thread_priority)
+  .def_readwrite("playback_thread_policy", &PlayOptions::playback_thread_policy)
+  .def_readwrite("playback_thread_cpus", &PlayOptions::playback_thread_cpus)
+  .def_readwrite(
+    "storage_loading_thread_priority", &PlayOptions::storage_loading_thread_priority)
+  .def_readwrite("storage_loading_thread_policy", &PlayOptions::storage_loading_thread_policy)
+  .def_readwrite("storage_loading_thread_cpus", &PlayOptions::storage_loading_thread_cpus)
+  .def_readwrite("release_window", &PlayOptions::release_window)
+  .def_readwrite("as_fast_as_possible", &PlayOptions::as_fast_as_possible)
+  .def_readwrite("seek_history_duration", &PlayOptions::seek_history_duration)
+  .def_readwrite("publisher_creation_threads", &PlayOptions::publisher_creation_threads)
+  .def_readwrite("loop_cache_bytes", &PlayOptions::loop_cache_bytes)
+  .def_readwrite("preload", &PlayOptions::preload)
+  .def_readwrite("preload_max_bytes", &PlayOptions::preload_max_bytes)
+  .def_readwrite("step_clock_topic", &PlayOptions::step_clock_topic)
+  .def_readwrite("intra_process_playback", &PlayOptions::intra_process_playback)
+  .def_readwrite("clock_publish_thread", &PlayOptions::clock_publish_thread)
+  .def_readwrite("clock_publish_thread_priority", &PlayOptions::clock_publish_thread_priority)
+  .def_readwrite("statistics_publish_interval", &PlayOptions::statistics_publish_interval)
+  ;
+
+  py::class_<rosbag2_transport::TopicDecimation>(m, "TopicDecimation")
+  .def(
+    py::init<uint64_t, double>(),
+    py::arg("keep_every_n") = 1,
+    py::arg("max_frequency") = 0.0)
+  .def_readwrite("keep_every_n", &rosbag2_transport::TopicDecimation::keep_every_n)
+  .def_readwrite("max_frequency", &rosbag2_transport::TopicDecimation::max_frequency)
+  ;
+
+  py::class_<rosbag2_transport::TopicPublishPolicy>(m, "TopicPublishPolicy")
+  .def(
+    py::init<int64_t, std::string>(),
+    py::arg("deadline") = 0,
+    py::arg("overflow") = "block")
+  .def_readwrite("deadline", &rosbag2_transport::TopicPublishPolicy::deadline)
+  .def_readwrite("overflow", &rosbag2_transport::TopicPublishPolicy::overflow)
+  ;
+
+  py::class_<rosbag2_transport::TopicRoute>(m, "TopicRoute")
+  .def(
+    py::init<
+      std::string, std::string, std::string, std::string, std::optional<uint64_t>,
+      std::optional<uint64_t>, std::optional<uint64_t>>(),
+    py::arg("name"),
+    py::arg("topics_regex"),
+    py::arg("compression_format") = "",
+    py::arg("compression_mode") = "",
+    py::arg("max_bagfile_size") = std::nullopt,
+    py::arg("max_bagfile_duration") = std::nullopt,
+    py::arg("max_cache_size") = std::nullopt)
+  .def_readwrite("name", &rosbag2_transport::TopicRoute::name)
+  .def_readwrite("topics_regex", &rosbag2_transport::TopicRoute::topics_regex)
+  .def_readwrite("compression_format", &rosbag2_transport::TopicRoute::compression_format)
+  .def_readwrite("compression_mode", &rosbag2_transport::TopicRoute::compression_mode)
+  .def_readwrite("max_bagfile_size", &rosbag2_transport::TopicRoute::max_bagfile_size)
+  .def_readwrite("max_bagfile_duration", &rosbag2_transport::TopicRoute::max_bagfile_duration)
+  .def_readwrite("max_cache_size", &rosbag2_transport::TopicRoute::max_cache_size)
   ;
 
   py::class_<RecordOptions>(m, "RecordOptions")
@@ -362,6 +461,25 @@ PYBIND11_MODULE(_transport, m) {
   .def_readwrite("compression_format", &RecordOptions::compression_format)
   .def_readwrite("compression_queue_size", &RecordOptions::compression_queue_size)
   .def_readwrite("compression_threads", &RecordOptions::compression_threads)
+  .def_readwrite(
+    "compression_dictionary_training_messages",
+    &RecordOptions::compression_dictionary_training_messages)
+  .def_readwrite("compression_dictionary", &RecordOptions::compression_dictionary)
+  .def_readwrite("compression_adaptive_level", &RecordOptions::compression_adaptive_level)
+  .def_readwrite("compression_min_level", &RecordOptions::compression_min_level)
+  .def_readwrite("compression_max_level", &RecordOptions::compression_max_level)
+  .def_readwrite("compression_policy", &RecordOptions::compression_policy)
+  .def_readwrite("compression_topic_policies", &RecordOptions::compression_topic_policies)
+  .def_readwrite("compression_probe_messages", &RecordOptions::compression_probe_messages)
+  .def_readwrite("compression_skip_ratio", &RecordOptions::compression_skip_ratio)
+  .def_readwrite("compression_file_workers", &RecordOptions::compression_file_workers)
+  .def_readwrite("compression_file_idle_io", &RecordOptions::compression_file_idle_io)
+  .def_readwrite(
+    "compression_file_max_concurrent", &RecordOptions::compression_file_max_concurrent)
+  .def_readwrite(
+    "compression_file_read_bandwidth", &RecordOptions::compression_file_read_bandwidth)
+  .def_readwrite(
+    "compression_file_throttle_cache_fill", &RecordOptions::compression_file_throttle_cache_fill)
   .def_property(
     "topic_qos_profile_overrides",
     &RecordOptions::getTopicQoSProfileOverrides,
@@ -370,12 +488,47 @@ PYBIND11_MODULE(_transport, m) {
   .def_readwrite("include_unpublished_topics", &RecordOptions::include_unpublished_topics)
   .def_readwrite("start_paused", &RecordOptions::start_paused)
   .def_readwrite("ignore_leaf_topics", &RecordOptions::ignore_leaf_topics)
+  .def_readwrite("record_publish_info", &RecordOptions::record_publish_info)
+  .def_readwrite("use_receive_timestamp", &RecordOptions::use_receive_timestamp)
+  .def_readwrite("message_buffer_pool_size", &RecordOptions::message_buffer_pool_size)
+  .def_readwrite("message_buffer_arena_size", &RecordOptions::message_buffer_arena_size)
+  .def_readwrite("message_buffer_numa_node", &RecordOptions::message_buffer_numa_node)
   .def_readwrite("use_sim_time", &RecordOptions::use_sim_time)
+  .def_readwrite("executor_threads", &RecordOptions::executor_threads)
+  .def_readwrite("callback_groups", &RecordOptions::callback_groups)
+  .def_readwrite("topics_per_callback_group", &RecordOptions::topics_per_callback_group)
+  .def_readwrite(
+    "subscription_creation_threads", &RecordOptions::subscription_creation_threads)
+  .def_readwrite("split_writers", &RecordOptions::split_writers)
+  .def_readwrite("time_slices", &RecordOptions::time_slices)
+  .def_readwrite(
+    "pipeline_statistics_interval", &RecordOptions::pipeline_statistics_interval)
+  .def_readwrite("stripe_directories", &RecordOptions::stripe_directories)
+  .def_readwrite("stripe_by", &RecordOptions::stripe_by)
+  .def_readwrite("stripe_batch_size", &RecordOptions::stripe_batch_size)
+  .def_readwrite("writer_shards", &RecordOptions::writer_shards)
+  .def_readwrite("upload_command", &RecordOptions::upload_command)
+  .def_readwrite("upload_max_bandwidth", &RecordOptions::upload_max_bandwidth)
+  .def_readwrite("upload_journal", &RecordOptions::upload_journal)
+  .def_readwrite("topic_decimation", &RecordOptions::topic_decimation)
+  .def_readwrite("intra_process_capture", &RecordOptions::intra_process_capture)
+  .def_readwrite("topic_routes", &RecordOptions::topic_routes)
+  ;
+
+  py::class_<rosbag2_transport::ExportOptions>(m, "ExportOptions")
+  .def(py::init<>())
+  .def_readwrite("output_directory", &rosbag2_transport::ExportOptions::output_directory)
+  .def_readwrite("topics", &rosbag2_transport::ExportOptions::topics)
+  .def_readwrite("row_group_size", &rosbag2_transport::ExportOptions::row_group_size)
+  .def_readwrite("compression", &rosbag2_transport::ExportOptions::compression)
   ;
 
   py::class_<rosbag2_py::Player>(m, "Player")
   .def(py::init())
   .def("play", &rosbag2_py::Player::play, py::arg("storage_options"), py::arg("play_options"))
+  .def(
+    "play_bags", &rosbag2_py::Player::play_bags, py::arg("storage_options"),
+    py::arg("play_options"))
   .def("burst", &rosbag2_py::Player::burst)
   ;
 
@@ -391,4 +544,10 @@ PYBIND11_MODULE(_transport, m) {
     "bag_rewrite",
     &rosbag2_py::bag_rewrite,
     "Given one or more input bags, output one or more bags with new settings.");
+  m.def(
+    "bag_export",
+    &rosbag2_transport::bag_export,
+    py::arg("input_options"), py::arg("export_options"),
+    py::call_guard<py::gil_scoped_release>(),
+    "Export the messages of a bag into a Parquet file per topic.");
 }
@@ -0,0 +1,78 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "rosbag2_cpp/verifier.hpp"
+#include "rosbag2_storage/file_verification.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+#include "./pybind11.hpp"
+
+namespace rosbag2_py
+{
+
+class Verifier
+{
+public:
+  Verifier()
+  : verifier_(std::make_unique<rosbag2_cpp::Verifier>())
+  {
+  }
+
+  rosbag2_cpp::BagVerification verify(
+    const rosbag2_storage::StorageOptions & storage_options, size_t threads)
+  {
+    // Files are verified on threads of their own, which do not need the interpreter
+    pybind11::gil_scoped_release release;
+    return verifier_->verify(storage_options, threads);
+  }
+
+protected:
+  std::unique_ptr<rosbag2_cpp::Verifier> verifier_;
+};
+}  // namespace rosbag2_py
+
+PYBIND11_MODULE(_verifier, m) {
+  m.doc() = "Python wrapper of the rosbag2_cpp verifier API";
+
+  pybind11::class_<rosbag2_storage::IntegrityProblem>(m, "IntegrityProblem")
+  .def_readonly("description", &rosbag2_storage::IntegrityProblem::description)
+  .def_readonly("start_offset", &rosbag2_storage::IntegrityProblem::start_offset)
+  .def_readonly("end_offset", &rosbag2_storage::IntegrityProblem::end_offset)
+  .def_readonly("start_time", &rosbag2_storage::IntegrityProblem::start_time)
+  .def_readonly("end_time", &rosbag2_storage::IntegrityProblem::end_time);
+
+  pybind11::class_<rosbag2_storage::FileVerification>(m, "FileVerification")
+  .def_readonly("topic_message_counts", &rosbag2_storage::FileVerification::topic_message_counts)
+  .def_readonly("problems", &rosbag2_storage::FileVerification::problems)
+  .def_readonly("checked", &rosbag2_storage::FileVerification::checked)
+  .def_property_readonly("message_count", &rosbag2_storage::FileVerification::message_count);
+
+  pybind11::class_<rosbag2_cpp::BagVerification::File>(m, "FileVerificationResult")
+  .def_readonly("path", &rosbag2_cpp::BagVerification::File::path)
+  .def_readonly("verification", &rosbag2_cpp::BagVerification::File::verification)
+  .def_readonly("error", &rosbag2_cpp::BagVerification::File::error);
+
+  pybind11::class_<rosbag2_cpp::BagVerification>(m, "BagVerification")
+  .def_readonly("files", &rosbag2_cpp::BagVerification::files)
+  .def_readonly("metadata_mismatches", &rosbag2_cpp::BagVerification::metadata_mismatches)
+  .def("ok", &rosbag2_cpp::BagVerification::ok);
+
+  pybind11::class_<rosbag2_py::Verifier>(m, "Verifier")
+  .def(pybind11::init())
+  .def(
+    "verify", &rosbag2_py::Verifier::verify,
+    pybind11::arg("storage_options"), pybind11::arg("threads") = 0);
+}
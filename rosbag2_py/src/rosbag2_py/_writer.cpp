@@ -14,8 +14,10 @@
 
 #include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "rosbag2_compression/sequential_compression_writer.hpp"
 #include "rosbag2_cpp/converter_options.hpp"
@@ -58,6 +60,35 @@ public:
 
     rosbag2_cpp::Writer::write(bag_message);
   }
+
+  /// Write serialized messages to a bag file, the i-th message on topic_names[i] at time_stamps[i].
+  /// Messages can be any objects supporting the buffer protocol, e.g. bytes or NumPy arrays,
+  /// which must not be modified during the call. They are copied and handed to the writer
+  /// without holding the GIL, into the message cache if the writer has one.
+  void write_batch(
+    const std::vector<std::string> & topic_names, const pybind11::sequence & messages,
+    const std::vector<rcutils_time_point_value_t> & time_stamps)
+  {
+    if (topic_names.size() != messages.size() || time_stamps.size() != messages.size()) {
+      throw std::invalid_argument(
+              "write_batch needs as many topic names and time stamps as messages");
+    }
+    std::vector<pybind11::buffer_info> buffers;
+    buffers.reserve(messages.size());
+    for (const auto & message : messages) {
+      buffers.push_back(pybind11::reinterpret_borrow<pybind11::buffer>(message).request());
+    }
+
+    pybind11::gil_scoped_release release;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->topic_name = topic_names[i];
+      bag_message->serialized_data = rosbag2_storage::make_serialized_message(
+        buffers[i].ptr, static_cast<size_t>(buffers[i].size * buffers[i].itemsize));
+      bag_message->time_stamp = time_stamps[i];
+      rosbag2_cpp::Writer::write(bag_message);
+    }
+  }
 };
 
 std::unordered_set<std::string> get_registered_writers()
@@ -98,6 +129,9 @@ PYBIND11_MODULE(_writer, m) {
       const rosbag2_storage::StorageOptions &, const rosbag2_cpp::ConverterOptions &
     >(&PyWriter::open))
   .def("write", &PyWriter::write)
+  .def(
+    "write_batch", &PyWriter::write_batch,
+    pybind11::arg("topic_names"), pybind11::arg("messages"), pybind11::arg("time_stamps"))
   .def("close", &PyWriter::close)
   .def("remove_topic", &PyWriter::remove_topic)
   .def(
@@ -115,6 +149,9 @@ PYBIND11_MODULE(_writer, m) {
       const rosbag2_storage::StorageOptions &, const rosbag2_cpp::ConverterOptions &
     >(&PyCompressionWriter::open))
   .def("write", &PyCompressionWriter::write)
+  .def(
+    "write_batch", &PyCompressionWriter::write_batch,
+    pybind11::arg("topic_names"), pybind11::arg("messages"), pybind11::arg("time_stamps"))
   .def("remove_topic", &PyCompressionWriter::remove_topic)
   .def(
     "create_topic",
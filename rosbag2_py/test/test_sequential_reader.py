@@ -105,11 +105,13 @@ def test_get_message_definitions(storage_id):
 
 
 @pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
-def test_sequential_reader_seek(storage_id):
+@pytest.mark.parametrize(
+    'reader_class', [rosbag2_py.SequentialReader, rosbag2_py.PrefetchingReader])
+def test_sequential_reader_seek(storage_id, reader_class):
     bag_path = str(RESOURCES_PATH / storage_id / 'talker')
     storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
 
-    reader = rosbag2_py.SequentialReader()
+    reader = reader_class()
     reader.open(storage_options, converter_options)
 
     topic_types = reader.get_all_topics_and_types()
@@ -118,7 +120,7 @@ def test_sequential_reader_seek(storage_id):
     type_map = {topic_types[i].name: topic_types[i].type for i in range(len(topic_types))}
 
     # Seek No Filter
-    reader = rosbag2_py.SequentialReader()
+    reader = reader_class()
     reader.open(storage_options, converter_options)
     reader.seek(1585866237113147888)
 
@@ -167,6 +169,128 @@ def test_sequential_reader_seek(storage_id):
     assert msg.data == f'Hello, world! {msg_counter}'
 
 
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+@pytest.mark.parametrize(
+    'reader_class', [rosbag2_py.SequentialReader, rosbag2_py.PrefetchingReader])
+def test_sequential_reader_read_next_batch(storage_id, reader_class):
+    bag_path = str(RESOURCES_PATH / storage_id / 'talker')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+
+    reader = reader_class()
+    reader.open(storage_options, converter_options)
+    expected_messages = []
+    while reader.has_next():
+        expected_messages.append(reader.read_next())
+
+    reader = reader_class()
+    reader.open(storage_options, converter_options)
+    batch = reader.read_next_batch(3)
+    assert batch == expected_messages[:3]
+
+    # A batch holds at least one message, even if it exceeds max_bytes
+    batch = reader.read_next_batch(0, max_bytes=1)
+    assert batch == expected_messages[3:4]
+
+    batch = reader.read_next_batch(0)
+    assert batch == expected_messages[4:]
+    assert reader.read_next_batch(10) == []
+
+
+
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+@pytest.mark.parametrize(
+    'reader_class', [rosbag2_py.SequentialReader, rosbag2_py.PrefetchingReader])
+def test_sequential_reader_read_next_columns(storage_id, reader_class):
+    bag_path = str(RESOURCES_PATH / storage_id / 'talker')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+
+    reader = reader_class()
+    reader.open(storage_options, converter_options)
+    expected_messages = []
+    while reader.has_next():
+        expected_messages.append(reader.read_next())
+
+    def to_tuples(columns):
+        data = columns.data
+        return [
+            (columns.topics[topic_id], bytes(data[offset:offset + length]), timestamp)
+            for topic_id, timestamp, offset, length in zip(
+                columns.topic_ids, columns.timestamps, columns.offsets, columns.lengths)
+        ]
+
+    reader = reader_class()
+    reader.open(storage_options, converter_options)
+    columns = reader.read_next_columns(3)
+    assert len(columns) == 3
+    assert to_tuples(columns) == expected_messages[:3]
+
+    messages = []
+    for columns in reader.iter_columns(max_messages=2):
+        assert 0 < len(columns) <= 2
+        messages += to_tuples(columns)
+    assert messages == expected_messages[3:]
+    assert len(reader.read_next_columns(10)) == 0
+
+
+
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+def test_sequential_reader_read_next_buffer(storage_id):
+    bag_path = str(RESOURCES_PATH / storage_id / 'talker')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    expected_topic, expected_data, expected_timestamp = reader.read_next()
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    topic, buffer, timestamp = reader.read_next_buffer()
+    assert (topic, timestamp) == (expected_topic, expected_timestamp)
+    view = memoryview(buffer)
+    assert view.readonly
+    assert len(buffer) == len(expected_data)
+    assert view.tobytes() == expected_data
+    assert bytes(buffer) == expected_data
+
+
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+def test_field_extractor(storage_id):
+    bag_path = str(RESOURCES_PATH / storage_id / 'talker')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    expected_logs = []
+    while reader.has_next():
+        topic, data, _ = reader.read_next()
+        if topic == '/rosout':
+            expected_logs.append(deserialize_message(data, Log))
+    assert expected_logs
+
+    extractor = rosbag2_py.FieldExtractor('rcl_interfaces/msg/Log', ['stamp.sec', 'level', 'line'])
+    assert extractor.field_paths == ['stamp.sec', 'level', 'line']
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    fields = extractor.extract(reader.read_next_columns(100), topic='/rosout')
+    assert fields['stamp.sec'].dtype == 'int32'
+    assert fields['level'].dtype == 'uint8'
+    assert fields['line'].dtype == 'uint32'
+    assert list(fields['stamp.sec']) == [log.stamp.sec for log in expected_logs]
+    assert list(fields['level']) == [log.level for log in expected_logs]
+    assert list(fields['line']) == [log.line for log in expected_logs]
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    reader.set_filter(rosbag2_py.StorageFilter(topics=['/rosout']))
+    messages = [data for _, data, _ in reader.read_next_batch(100)]
+    fields = extractor.extract(messages)
+    assert list(fields['line']) == [log.line for log in expected_logs]
+
+    with pytest.raises(ValueError):
+        rosbag2_py.FieldExtractor('rcl_interfaces/msg/Log', ['msg'])
+
+
 def test_plugin_list():
     reader_plugins = rosbag2_py.get_registered_readers()
     assert 'my_read_only_test_plugin' in reader_plugins
@@ -13,6 +13,7 @@
 # limitations under the License.
 
 import os
+import pickle
 from pathlib import Path
 
 from common import get_rosbag_options
@@ -139,3 +140,38 @@ def test_seek_backward(storage_id):
 
     assert topic == 'BBB'
     assert t == 1413
+
+
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+def test_read_time_shards(storage_id):
+    bag_path = str(RESOURCES_PATH / storage_id / 'wbag')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id=storage_id)
+
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    expected_messages = []
+    while reader.has_next():
+        expected_messages.append(reader.read_next())
+
+    shards = rosbag2_py.Info().split_into_time_shards(bag_path, 3, storage_id)
+    assert 1 <= len(shards) <= 3
+    for previous, shard in zip(shards, shards[1:]):
+        assert shard.start_time_ns == previous.end_time_ns + 1
+    # Shards can be handed to other processes
+    restored = pickle.loads(pickle.dumps(shards[0]))
+    assert (restored.files, restored.start_time_ns, restored.end_time_ns) == \
+        (shards[0].files, shards[0].start_time_ns, shards[0].end_time_ns)
+
+    messages = []
+    for shard in shards:
+        assert shard.files
+        reader = rosbag2_py.SequentialReader()
+        reader.open(storage_options, converter_options)
+        reader.set_filter(rosbag2_py.StorageFilter(
+            start_time_ns=shard.start_time_ns, end_time_ns=shard.end_time_ns))
+        reader.seek(shard.start_time_ns)
+        while reader.has_next():
+            message = reader.read_next()
+            assert shard.start_time_ns <= message[2] <= shard.end_time_ns
+            messages.append(message)
+    assert sorted(messages) == sorted(expected_messages)
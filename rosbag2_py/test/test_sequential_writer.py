@@ -90,6 +90,42 @@ def test_sequential_writer(tmp_path, storage_id):
         msg_counter += 1
 
 
+
+@pytest.mark.parametrize('storage_id', TESTED_STORAGE_IDS)
+def test_sequential_writer_write_batch(tmp_path, storage_id):
+    bag_path = str(tmp_path / 'tmp_write_batch_test')
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+
+    writer = rosbag2_py.SequentialWriter()
+    writer.open(storage_options, converter_options)
+    topic_name = '/chatter'
+    create_topic(writer, topic_name, 'std_msgs/msg/String')
+
+    messages = []
+    for i in range(10):
+        msg = String()
+        msg.data = f'Hello, world! {str(i)}'
+        messages.append(serialize_message(msg))
+    # Any object supporting the buffer protocol is accepted
+    messages[0] = bytearray(messages[0])
+    writer.write_batch([topic_name] * 10, messages, [i * 100 for i in range(10)])
+    with pytest.raises(ValueError):
+        writer.write_batch([topic_name], messages, [0])
+    del writer
+
+    storage_options, converter_options = get_rosbag_options(bag_path, storage_id)
+    reader = rosbag2_py.SequentialReader()
+    reader.open(storage_options, converter_options)
+    msg_counter = 0
+    while reader.has_next():
+        topic, data, t = reader.read_next()
+        assert topic == topic_name
+        assert data == bytes(messages[msg_counter])
+        assert t == msg_counter * 100
+        msg_counter += 1
+    assert msg_counter == 10
+
+
 def test_plugin_list():
     writer_plugins = rosbag2_py.get_registered_writers()
     assert 'my_test_plugin' in writer_plugins
@@ -16,6 +16,7 @@
 #define ROSBAG2_STORAGE__BAG_METADATA_HPP_
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <utility>
@@ -38,6 +39,10 @@ struct FileInformation
   std::chrono::time_point<std::chrono::high_resolution_clock> starting_time;
   std::chrono::nanoseconds duration;
   size_t message_count;
+  // Inclusive time window of the messages of the file which belong to the bag, for manifests
+  // which reference parts of the files of other bags. -1 if unbounded.
+  int64_t window_start_time_ns = -1;
+  int64_t window_end_time_ns = -1;
 };
 
 struct BagMetadata
@@ -0,0 +1,137 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__BUFFER_POOL_HPP_
+#define ROSBAG2_STORAGE__BUFFER_POOL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "rcutils/allocator.h"
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_storage
+{
+
+/**
+* Recycling allocator for serialized message payloads.
+*
+* Requested sizes are rounded up to a power of two size class between
+* kMinSizeClassBytes and kMaxSizeClassBytes. Released buffers are kept in a free list per
+* size class and handed out again for the next request of the same class, which avoids
+* malloc/free churn and page faults for steady-state recording and playback.
+* The total amount of memory kept in the free lists is bounded by max_cached_bytes, buffers
+* released beyond that budget and requests larger than kMaxSizeClassBytes go straight to the
+* system allocator.
+*
+* Optionally, buffers are carved from an arena reserved up front, e.g. huge pages bound to the
+* NUMA node of the thread consuming the buffers, before falling back to the system allocator.
+* Buffers of the arena are always kept in the free lists when released.
+*
+* The pool is thread-safe. It can be used through an rcutils_allocator_t, see get_allocator().
+* The pool must outlive every buffer allocated from it.
+*/
+class ROSBAG2_STORAGE_PUBLIC BufferPool
+{
+public:
+  static constexpr size_t kMinSizeClassBytes = 256;
+  static constexpr size_t kMaxSizeClassBytes = 64 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxCachedBytes = 256 * 1024 * 1024;
+
+  struct ArenaOptions
+  {
+    /// Bytes reserved for the arena, 0 for no arena.
+    size_t size = 0;
+    /// Back the arena with huge pages, explicit ones if available and transparent ones otherwise.
+    /// Only supported on Linux.
+    bool huge_pages = true;
+    /// NUMA node the memory of the arena is bound to, -1 for the memory policy of the process.
+    /// Only supported on Linux.
+    int numa_node = -1;
+  };
+
+  explicit BufferPool(size_t max_cached_bytes = kDefaultMaxCachedBytes);
+
+  /// 	hrows std::runtime_error if the arena can not be reserved.
+  BufferPool(size_t max_cached_bytes, const ArenaOptions & arena_options);
+
+  ~BufferPool();
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool & operator=(const BufferPool &) = delete;
+
+  /// Get a buffer with at least size usable bytes.
+  /// \return pointer to the buffer or nullptr if the system allocator failed.
+  void * allocate(size_t size);
+
+  /// Return a buffer previously obtained from allocate() or reallocate() to the pool.
+  void deallocate(void * pointer);
+
+  /// Resize a buffer, keeping its content. Buffers which already provide enough capacity in their
+  /// size class are returned unchanged.
+  void * reallocate(void * pointer, size_t size);
+
+  /// \return an rcutils allocator which allocates from this pool.
+  rcutils_allocator_t get_allocator();
+
+  /// \return number of bytes of buffers from the system allocator currently held in the free
+  /// lists.
+  size_t get_cached_bytes() const;
+
+  /// \return number of bytes of the arena handed out to buffers so far.
+  size_t get_arena_used_bytes() const;
+
+  /// Release all cached buffers from the system allocator. Buffers of the arena stay cached.
+  void release_cached_buffers();
+
+  /// \return capacity of the size class used for a request of size bytes.
+  static size_t get_size_class_capacity(size_t size);
+
+private:
+  static constexpr size_t kNumSizeClasses = 19;  // 2^8 ... 2^26
+
+  static size_t get_size_class_index(size_t capacity);
+
+  bool is_in_arena(const void * pointer) const;
+  // Carve a buffer of a size class from the arena. The caller holds mutex_.
+  void * allocate_from_arena(size_t capacity);
+
+  const size_t max_cached_bytes_;
+  mutable std::mutex mutex_;
+  std::array<std::vector<void *>, kNumSizeClasses> free_lists_;
+  size_t cached_bytes_ {0};
+
+  char * arena_ {nullptr};
+  size_t arena_size_ {0};
+  size_t arena_used_bytes_ {0};
+};
+
+}  // namespace rosbag2_storage
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_STORAGE__BUFFER_POOL_HPP_
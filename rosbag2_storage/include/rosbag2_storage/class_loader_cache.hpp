@@ -0,0 +1,60 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__CLASS_LOADER_CACHE_HPP_
+#define ROSBAG2_STORAGE__CLASS_LOADER_CACHE_HPP_
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "pluginlib/class_loader.hpp"
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/// Guards every use of the class loaders returned by get_cached_class_loader(), since
+/// pluginlib::ClassLoader is not thread-safe.
+/**
+ * The mutex is recursive, so that plugins may use a factory while they are created.
+ */
+ROSBAG2_STORAGE_PUBLIC std::recursive_mutex & get_class_loader_mutex();
+
+/// Class loader for the plugins of InterfaceT, shared by all factories of the process.
+/**
+ * Creating a class loader crawls the ament index for plugin descriptions and parses them, so
+ * the class loader is only created on first use and then kept. It is intentionally never
+ * destroyed, since instances created by it may outlive static destruction.
+ *
+ * \param package_name Package of the base class, only used on first use
+ * \param base_class Fully qualified name of InterfaceT, only used on first use
+ * \throws pluginlib::ClassLoaderException if the class loader could not be created
+ */
+template<typename InterfaceT>
+std::shared_ptr<pluginlib::ClassLoader<InterfaceT>>
+get_cached_class_loader(const std::string & package_name, const std::string & base_class)
+{
+  std::lock_guard<std::recursive_mutex> lock(get_class_loader_mutex());
+  static auto * class_loader = new std::shared_ptr<pluginlib::ClassLoader<InterfaceT>>();
+  if (!*class_loader) {
+    *class_loader = std::make_shared<pluginlib::ClassLoader<InterfaceT>>(package_name, base_class);
+  }
+  return *class_loader;
+}
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__CLASS_LOADER_CACHE_HPP_
@@ -0,0 +1,65 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__DURABILITY_POLICY_HPP_
+#define ROSBAG2_STORAGE__DURABILITY_POLICY_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+#include "rosbag2_storage/storage_options.hpp"
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/**
+* Decides when a storage plugin makes the data written so far durable.
+*
+* Writes accumulate as pending until the first of the two limits is reached: interval_ms
+* since the oldest pending write, or bytes written since the last commit. A limit of 0 is
+* disabled. With both disabled the policy is never due and durability is left to the storage
+* configuration.
+*/
+class ROSBAG2_STORAGE_PUBLIC DurabilityPolicy
+{
+public:
+  using clock = std::chrono::steady_clock;
+
+  DurabilityPolicy(uint64_t interval_ms, uint64_t bytes);
+
+  explicit DurabilityPolicy(const StorageOptions & storage_options);
+
+  bool enabled() const;
+
+  /// Account for bytes written, which are pending until the next commit.
+  void add_written_bytes(uint64_t bytes, clock::time_point now = clock::now());
+
+  /// \return whether pending writes should be committed now.
+  bool is_due(clock::time_point now = clock::now()) const;
+
+  /// Record that all pending writes were committed.
+  void committed();
+
+private:
+  std::chrono::milliseconds interval_;
+  uint64_t bytes_;
+  bool pending_ = false;
+  uint64_t pending_bytes_ = 0;
+  clock::time_point first_pending_time_;
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__DURABILITY_POLICY_HPP_
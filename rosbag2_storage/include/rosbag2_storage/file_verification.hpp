@@ -0,0 +1,62 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__FILE_VERIFICATION_HPP_
+#define ROSBAG2_STORAGE__FILE_VERIFICATION_HPP_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rcutils/time.h"
+
+namespace rosbag2_storage
+{
+
+/// Damage found while verifying a storage file.
+struct IntegrityProblem
+{
+  std::string description;
+  // Range [start_offset, end_offset) of the file which is damaged, both 0 if unknown
+  uint64_t start_offset = 0;
+  uint64_t end_offset = 0;
+  // Receive time stamps of the first and last message which may be lost, both 0 if unknown
+  rcutils_time_point_value_t start_time = 0;
+  rcutils_time_point_value_t end_time = 0;
+};
+
+/// Result of verifying the integrity of a storage file, see ReadOnlyInterface::verify().
+struct FileVerification
+{
+  // Intact messages per topic name
+  std::unordered_map<std::string, uint64_t> topic_message_counts;
+  std::vector<IntegrityProblem> problems;
+  // True if the storage checked its data against checksums or its own consistency checks. False
+  // if the messages were only read, which finds less damage
+  bool checked = false;
+
+  uint64_t message_count() const
+  {
+    uint64_t count = 0;
+    for (const auto & topic_message_count : topic_message_counts) {
+      count += topic_message_count.second;
+    }
+    return count;
+  }
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__FILE_VERIFICATION_HPP_
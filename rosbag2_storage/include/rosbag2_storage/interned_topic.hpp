@@ -0,0 +1,47 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__INTERNED_TOPIC_HPP_
+#define ROSBAG2_STORAGE__INTERNED_TOPIC_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/**
+* Topic name shared by all messages of the topic, instead of a copy of the name per message.
+*
+* There is one record per topic name in the process. Records are never freed, so a pointer to
+* one stays valid and two messages are on the same topic exactly if they point to the same
+* record, or if the ids of their records are equal.
+*/
+struct InternedTopic
+{
+  const std::string name;
+  // Dense, starting at 0 in the order the topic names were first interned. Readers may index
+  // tables of their topics with it.
+  const uint32_t id;
+};
+
+/// \return the record of topic_name, created on first use. Thread-safe.
+ROSBAG2_STORAGE_PUBLIC
+const InternedTopic & intern_topic(const std::string & topic_name);
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__INTERNED_TOPIC_HPP_
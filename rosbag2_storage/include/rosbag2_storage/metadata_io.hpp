@@ -16,8 +16,10 @@
 #define ROSBAG2_STORAGE__METADATA_IO_HPP_
 
 #include <string>
+#include <vector>
 
 #include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
 
 namespace rosbag2_storage
@@ -27,12 +29,25 @@ class MetadataIo
 {
 public:
   static constexpr const char * const metadata_filename = "metadata.yaml";
+  static constexpr const char * const binary_metadata_filename = "metadata.bin";
+  static constexpr const char * const metadata_journal_filename = "metadata_journal.yaml";
+  static constexpr const char * const topic_statistics_filename = "topic_statistics.yaml";
 
   virtual ~MetadataIo() = default;
 
+  /// Write the metadata file of a bag.
+  /**
+   * Metadata of the current version is also written in a compact binary encoding next to it,
+   * which read_metadata() decodes instead of parsing the YAML of long bags with many files.
+   */
   ROSBAG2_STORAGE_PUBLIC
   virtual void write_metadata(const std::string & uri, const BagMetadata & metadata);
 
+  /// Read the metadata file of a bag.
+  /**
+   * The binary encoding is only used if it was written together with the metadata file as it
+   * is, so that edits of the metadata file take effect.
+   */
   ROSBAG2_STORAGE_PUBLIC
   virtual BagMetadata read_metadata(const std::string & uri);
 
@@ -45,8 +60,54 @@ public:
   ROSBAG2_STORAGE_PUBLIC
   virtual BagMetadata deserialize_metadata(const std::string & serialized_metadata);
 
+  /// Append the metadata of a single closed bag file to the metadata journal of a bag.
+  /**
+   * The journal is written while a bag is recorded, so that the metadata of a bag which was
+   * not closed can be reconstructed without reading the files it covers.
+   * Every entry is a YAML document of its own, terminated by an end marker.
+   * \param uri Directory of the bag
+   * \param file_metadata Metadata with the file, topics and message counts of one bag file
+   */
+  ROSBAG2_STORAGE_PUBLIC
+  virtual void append_to_metadata_journal(
+    const std::string & uri, const BagMetadata & file_metadata);
+
+  /// Read the entries of the metadata journal of a bag which were written completely.
+  /**
+   * \return The entries in the order they were appended, none if the bag has no journal.
+   *   Reading stops at the first entry which can not be parsed.
+   */
+  ROSBAG2_STORAGE_PUBLIC
+  virtual std::vector<BagMetadata> read_metadata_journal(const std::string & uri);
+
+  /// Remove the metadata journal of a bag, once its metadata file is written.
+  ROSBAG2_STORAGE_PUBLIC
+  virtual void remove_metadata_journal(const std::string & uri);
+
+  /// Write the statistics of the topics of a bag to a file next to its metadata.
+  /**
+   * The statistics are stored by column, one sequence per statistic with an entry per topic,
+   * so that a single statistic of all topics can be looked up without parsing the others.
+   * \param uri Directory of the bag
+   * \param statistics Statistics of every topic of the bag
+   */
+  ROSBAG2_STORAGE_PUBLIC
+  virtual void write_topic_statistics(
+    const std::string & uri, const std::vector<TopicStatistics> & statistics);
+
+  /// Read the statistics of the topics of a bag.
+  /**
+   * \return The statistics of every topic, none if the bag has no statistics file.
+   * \throws std::runtime_error if the statistics file can not be parsed
+   */
+  ROSBAG2_STORAGE_PUBLIC
+  virtual std::vector<TopicStatistics> read_topic_statistics(const std::string & uri);
+
 private:
   std::string get_metadata_file_name(const std::string & uri);
+  std::string get_binary_metadata_file_name(const std::string & uri);
+  std::string get_metadata_journal_file_name(const std::string & uri);
+  std::string get_topic_statistics_file_name(const std::string & uri);
 };
 
 }  // namespace rosbag2_storage
@@ -0,0 +1,60 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__READ_ESTIMATE_HPP_
+#define ROSBAG2_STORAGE__READ_ESTIMATE_HPP_
+
+#include <cstdint>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/// Amount of data which reading a bag with a StorageFilter touches, determined without reading
+/// the messages.
+struct ReadEstimate
+{
+  // Number of messages passing the filter
+  uint64_t message_count = 0;
+  // Size of the serialized data of these messages in bytes
+  uint64_t bytes = 0;
+  // True if message_count is counted from the indexes of the storage. False if the numbers are
+  // extrapolated from the metadata of the bag, assuming messages spread evenly over its duration
+  bool exact = false;
+};
+
+inline ReadEstimate & operator+=(ReadEstimate & estimate, const ReadEstimate & other)
+{
+  estimate.message_count += other.message_count;
+  estimate.bytes += other.bytes;
+  estimate.exact = estimate.exact && other.exact;
+  return estimate;
+}
+
+/**
+ * Extrapolate the estimate from the message counts per topic and the duration in the metadata.
+ *
+ * The messages of the selected topics are assumed to spread evenly over the duration of the bag,
+ * and to be of the average size of bag_size / message_count.
+ */
+ROSBAG2_STORAGE_PUBLIC
+ReadEstimate estimate_from_metadata(
+  const BagMetadata & metadata, const StorageFilter & storage_filter);
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__READ_ESTIMATE_HPP_
@@ -0,0 +1,53 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__READABLE_FILE_HPP_
+#define ROSBAG2_STORAGE__READABLE_FILE_HPP_
+
+#include <cstdint>
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/**
+ * Random access to the content of a bag file which is not read from disk as it is, e.g.
+ * because it is decompressed while it is read.
+ *
+ * Storage plugins read it instead of the file at the uri if it is set in the StorageOptions.
+ */
+class ROSBAG2_STORAGE_PUBLIC ReadableFile
+{
+public:
+  virtual ~ReadableFile() = default;
+
+  /// \return size of the content in bytes.
+  virtual uint64_t size() const = 0;
+
+  /**
+   * Copy a range of the content. May be called from multiple threads at once.
+   *
+   * \param data Buffer for at least size bytes.
+   * \param offset Offset of the range in the content.
+   * \param size Size of the range.
+   * \return the number of bytes copied, which is less than size only at the end of the content.
+   * \throws std::runtime_error if the content can't be read.
+   */
+  virtual uint64_t read(uint8_t * data, uint64_t offset, uint64_t size) = 0;
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__READABLE_FILE_HPP_
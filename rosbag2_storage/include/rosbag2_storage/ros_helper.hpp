@@ -17,8 +17,10 @@
 
 #include <memory>
 
+#include "rcutils/allocator.h"
 #include "rcutils/types/uint8_array.h"
 
+#include "rosbag2_storage/buffer_pool.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
 
 namespace rosbag2_storage
@@ -32,6 +34,36 @@ ROSBAG2_STORAGE_PUBLIC
 std::shared_ptr<rcutils_uint8_array_t>
 make_empty_serialized_message(size_t size);
 
+/// Same as make_serialized_message(data, size), but allocates the payload with allocator.
+/// The allocator must stay valid until the returned message has been destroyed.
+ROSBAG2_STORAGE_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_message(const void * data, size_t size, rcutils_allocator_t allocator);
+
+/// Same as make_empty_serialized_message(size), but allocates the payload with allocator.
+/// The allocator must stay valid until the returned message has been destroyed.
+ROSBAG2_STORAGE_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t>
+make_empty_serialized_message(size_t size, rcutils_allocator_t allocator);
+
+/// Wrap size bytes at data in a serialized message without copying them.
+/// The message keeps a reference to owner, which has to keep data valid. The payload may be
+/// read-only memory, it must not be modified, resized or finalized with rcutils.
+ROSBAG2_STORAGE_PUBLIC
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_message_view(const void * data, size_t size, std::shared_ptr<const void> owner);
+
+/// Let make_serialized_message() and make_empty_serialized_message() allocate payloads from pool.
+/// This affects every component creating messages through these helpers, e.g. the storage
+/// plugins on read and the player read-ahead queue. Every message keeps a reference to the pool
+/// it was allocated from. Pass nullptr to revert to the default rcutils allocator.
+ROSBAG2_STORAGE_PUBLIC
+void set_serialized_message_buffer_pool(std::shared_ptr<BufferPool> pool);
+
+/// \return the pool installed with set_serialized_message_buffer_pool() or nullptr.
+ROSBAG2_STORAGE_PUBLIC
+std::shared_ptr<BufferPool> get_serialized_message_buffer_pool();
+
 }  // namespace rosbag2_storage
 
 #endif  // ROSBAG2_STORAGE__ROS_HELPER_HPP_
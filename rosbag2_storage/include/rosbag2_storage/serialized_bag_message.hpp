@@ -15,20 +15,51 @@
 #ifndef ROSBAG2_STORAGE__SERIALIZED_BAG_MESSAGE_HPP_
 #define ROSBAG2_STORAGE__SERIALIZED_BAG_MESSAGE_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include "rcutils/types/uint8_array.h"
 #include "rcutils/time.h"
 
+#include "rosbag2_storage/interned_topic.hpp"
+
 namespace rosbag2_storage
 {
 
+/// Value of SerializedBagMessage::topic_id for messages not tagged by the writer.
+constexpr uint32_t UNASSIGNED_TOPIC_ID = 0;
+
 struct SerializedBagMessage
 {
   std::shared_ptr<rcutils_uint8_array_t> serialized_data;
   rcutils_time_point_value_t time_stamp;
   std::string topic_name;
+  // Id the writer assigned to topic_name on create_topic(). Lets the writer account the message
+  // without looking up topic_name. Messages which are not tagged are looked up by name.
+  uint32_t topic_id = UNASSIGNED_TOPIC_ID;
+  // Time the message was published and the sequence number the publisher assigned to it, as
+  // reported by the middleware. 0 if unknown, e.g. if the recorder did not capture them.
+  rcutils_time_point_value_t send_timestamp = 0;
+  uint64_t sequence_number = 0;
+  // Shared record of topic_name, set by storages which read messages, nullptr otherwise. Readers
+  // of many messages compare or index by interned_topic->id instead of hashing topic_name, which
+  // stays filled as well.
+  const InternedTopic * interned_topic = nullptr;
+};
+
+/// Message handed to a callback without copying it, valid for the duration of the call only.
+struct SerializedBagMessageView
+{
+  const uint8_t * data = nullptr;
+  size_t size = 0;
+  rcutils_time_point_value_t time_stamp = 0;
+  // Refers to the name of the topic kept by the storage
+  std::string_view topic_name;
+  rcutils_time_point_value_t send_timestamp = 0;
+  uint64_t sequence_number = 0;
 };
 
 typedef std::shared_ptr<SerializedBagMessage> SerializedBagMessageSharedPtr;
@@ -42,6 +42,7 @@ class ReadWriteInterface;
 class StorageFactoryImpl;
 
 /// Factory to create instances of various storage interfaces
+/// open_read_only() and open_read_write() may be called concurrently from multiple threads.
 class ROSBAG2_STORAGE_PUBLIC StorageFactory : public StorageFactoryInterface
 {
 public:
@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_FILTER_HPP_
 #define ROSBAG2_STORAGE__STORAGE_FILTER_HPP_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,27 @@ struct StorageFilter
   // Only messages not matching these specified topics will be played.
   // If list is empty, the filter is ignored and all messages are played.
   std::string topics_regex_to_exclude = "";
+
+  // Receive timestamp in nanoseconds of the first messages to read. Messages received earlier are
+  // skipped by the storage plugins, readers of split bags don't open files which end before it.
+  // If negative, the filter is ignored and messages are read from the beginning of the bag.
+  int64_t start_time_ns = -1;
+
+  // Receive timestamp in nanoseconds of the last messages to read. Reading stops at messages
+  // received later, storage plugins may then skip the rest of the bag without reading it.
+  // If negative, the filter is ignored and messages are read until the end of the bag.
+  int64_t end_time_ns = -1;
+
+  // Minimum receive time in nanoseconds between the messages read of each topic, e.g. for
+  // previews. Of the messages of a topic in every interval, aligned to multiples of it, only the
+  // first one is read. Storage plugins skip the other messages without reading their data.
+  // If zero or negative, the filter is ignored.
+  int64_t sample_interval_ns = 0;
+
+  // Read only every n-th message of each topic in the time range of every bag file, starting with
+  // the first one, after sample_interval_ns is applied. Samples do not change when seeking.
+  // If zero or one, the filter is ignored.
+  uint64_t sample_stride = 0;
 };
 
 }  // namespace rosbag2_storage
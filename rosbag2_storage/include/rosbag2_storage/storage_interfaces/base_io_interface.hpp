@@ -59,6 +59,16 @@ public:
   virtual void open(
     const StorageOptions & storage_options,
     IOFlag io_flag) = 0;
+
+  /**
+   * Cheaply checks whether the file at uri may be in the format of this storage, e.g. by its
+   * magic bytes, without opening it.
+   * When no storage id is given, a file is only opened with the storages accepting it.
+   * The default implementation accepts every file, for storages without such a check.
+   * \param uri is the exact relative path to the bagfile, as for opening it read only.
+   * \return false only if the file can not be in the format of this storage.
+   */
+  virtual bool probe(const std::string & uri) const;
 };
 
 }  // namespace storage_interfaces
@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_INTERFACES__BASE_READ_INTERFACE_HPP_
 #define ROSBAG2_STORAGE__STORAGE_INTERFACES__BASE_READ_INTERFACE_HPP_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -32,8 +33,11 @@ struct ReadOrder
   enum SortBy
   {
     ReceivedTimestamp,
-    PublishedTimestamp,  // NOTE: not implemented in ROS 2 core
-    File
+    PublishedTimestamp,  // Supported by sqlite3 bags recorded with schema version 5 or newer
+    File,
+    // Order of header.stamp, read through rosbag2_cpp::readers::HeaderStampOrderReader with the
+    // header stamp index of the bag. Not supported by storage plugins themselves.
+    HeaderTimestamp
   };
 
   // Sorting criterion for reading out messages, ascending by default
@@ -51,6 +55,9 @@ inline bool operator==(const ReadOrder & a, const ReadOrder & b)
   return a.sort_by == b.sort_by && a.reverse == b.reverse;
 }
 
+/// Callback of for_each(), returns false to stop reading.
+using MessageViewCallback = std::function<bool (const SerializedBagMessageView &)>;
+
 namespace storage_interfaces
 {
 
@@ -72,6 +79,22 @@ public:
 
   virtual std::shared_ptr<SerializedBagMessage> read_next() = 0;
 
+  /// @brief Read the next messages at once, as if read_next() was called while has_next().
+  ///   The default implementation does exactly that, storages may read batches natively.
+  /// @param max_messages Maximum number of messages to return, 0 for no limit.
+  /// @param max_bytes Stop once the serialized data of the returned messages reaches this size,
+  ///   0 for no limit. A batch holds at least one message, however large it is.
+  /// @return The messages in read order, empty at the end of the storage.
+  virtual std::vector<std::shared_ptr<SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0);
+
+  /// @brief Read the next messages as views handed to a callback, as if read_next() was called
+  ///   while has_next(), until the end of the storage or until the callback returns false.
+  ///   The default implementation reads the messages with read_next(), storages may hand out
+  ///   their messages without allocating anything per message.
+  /// @param callback Called in read order, the view is only valid during the call.
+  virtual void for_each(const MessageViewCallback & callback);
+
   virtual std::vector<TopicMetadata> get_all_topics_and_types() = 0;
 
   virtual void get_all_message_definitions(std::vector<MessageDefinition> & definitions) = 0;
@@ -46,6 +46,11 @@ public:
     const rosbag2_storage::MessageDefinition & message_definition) = 0;
 
   virtual void remove_topic(const TopicMetadata & topic) = 0;
+
+  /// Commit or fsync the data written so far if the durability limits of the storage options
+  /// are reached. Called by the writer between batches and while no messages arrive, so that
+  /// the time limit holds in quiet periods too. The default does nothing.
+  virtual void commit_if_due() {}
 };
 
 }  // namespace storage_interfaces
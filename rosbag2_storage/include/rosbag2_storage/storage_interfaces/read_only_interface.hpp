@@ -19,11 +19,14 @@
 
 #include "rcutils/types.h"
 
+#include "rosbag2_storage/file_verification.hpp"
+#include "rosbag2_storage/read_estimate.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_interfaces/base_info_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/base_io_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/base_read_interface.hpp"
 #include "rosbag2_storage/storage_traits.hpp"
+#include "rosbag2_storage/time_index.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
 
 namespace rosbag2_storage
@@ -85,6 +88,40 @@ public:
   will return false.
   */
   virtual void seek(const rcutils_time_point_value_t & timestamp) = 0;
+
+  /**
+  Returns the sparse time index stored with the file when it was written, which seek(t) uses to
+  position the read head without reading the messages before t.
+  The default implementation returns an empty index, for storages which have no such index or
+  position by timestamp natively.
+  */
+  virtual TimeIndex get_time_index();
+
+  /**
+  Estimate the number of messages and bytes reading with the given filter would return, without
+  reading the messages. The filter and read head of the storage are not changed.
+  The default implementation extrapolates from the metadata, for storages which have no index to
+  count from.
+  */
+  virtual ReadEstimate estimate(const StorageFilter & storage_filter);
+
+  /**
+  Makes the messages which were appended to the file since it was opened, or since the last
+  refresh, available to has_next() and read_next(), so that a file can be read while it is still
+  being recorded. Reading continues after the last read message, the filter is kept.
+  Returns false if the storage can not follow appended messages, which the default
+  implementation does.
+  */
+  virtual bool refresh();
+
+  /**
+  Checks the integrity of the whole file and counts its intact messages per topic, for a storage
+  which was just opened. Damage is reported in the result, not thrown, and as precisely located
+  as the storage format allows. The filter and read head of the storage are undefined afterwards.
+  The default implementation reads all messages and reports where reading fails, for storages
+  which have no checksums or consistency checks.
+  */
+  virtual FileVerification verify();
 };
 
 }  // namespace storage_interfaces
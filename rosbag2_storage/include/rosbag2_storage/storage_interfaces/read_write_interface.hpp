@@ -15,8 +15,10 @@
 #ifndef ROSBAG2_STORAGE__STORAGE_INTERFACES__READ_WRITE_INTERFACE_HPP_
 #define ROSBAG2_STORAGE__STORAGE_INTERFACES__READ_WRITE_INTERFACE_HPP_
 
+#include <optional>
 #include <string>
 
+#include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/base_write_interface.hpp"
@@ -44,6 +46,18 @@ public:
 
   virtual uint64_t get_minimum_split_file_size() const = 0;
 
+  /// @brief Copy the messages of a bag file written by the same storage implementation,
+  ///   without decoding and re-encoding them where the file format allows.
+  ///   Has to be called before any topic was created or message was written. The topics of the
+  ///   copied messages are created by the copy. The default implementation copies nothing.
+  /// @param uri Path of the bag file to copy from.
+  /// @param storage_filter Topics and time range of the messages to copy.
+  /// @return Starting time, duration, message count and topics with message counts of the
+  ///   copied messages, or std::nullopt if the file can not be copied like this. Nothing was
+  ///   written to the storage then.
+  virtual std::optional<BagMetadata> copy_file(
+    const std::string & uri, const StorageFilter & storage_filter);
+
   void set_filter(const StorageFilter & storage_filter) override = 0;
 
   void reset_filter() override = 0;
@@ -16,9 +16,12 @@
 #define ROSBAG2_STORAGE__STORAGE_OPTIONS_HPP_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "rosbag2_storage/readable_file.hpp"
 #include "rosbag2_storage/visibility_control.hpp"
 #include "rosbag2_storage/yaml.hpp"
 
@@ -40,7 +43,8 @@ public:
   uint64_t max_bagfile_duration = 0;
 
   // The cache size indiciates how many messages can maximally be hold in cache
-  // before these being written to disk.
+  // before these being written to disk. Messages count with the memory they hold,
+  // including the unused capacity of their serialized data and per message overhead.
   // A value of 0 disables caching and every write happens directly to disk.
   uint64_t max_cache_size = 0;
 
@@ -62,6 +66,198 @@ public:
 
   // Stores the custom data
   std::unordered_map<std::string, std::string> custom_data{};
+
+  // Use a lock-free multi-producer ring as message cache instead of the double buffered cache.
+  // Producers never block each other, which helps when recording with many executor threads.
+  // Has no effect in snapshot mode or if max_cache_size is 0.
+  bool lock_free_cache = false;
+
+  // Split the message cache into shards with independent byte budgets, so that a
+  // high-bandwidth topic can only cause drops on its own shard.
+  // With shard_cache_per_topic every topic which is not part of a cache topic group gets a
+  // shard of its own. Otherwise ungrouped topics share one default shard.
+  // Has no effect in snapshot mode or if max_cache_size is 0.
+  bool shard_cache_per_topic = false;
+
+  // Topics which share one cache shard, keyed by the group name. Enables cache sharding.
+  std::unordered_map<std::string, std::vector<std::string>> cache_topic_groups{};
+
+  // Byte budget of individual cache shards, keyed by group name or, for per topic shards,
+  // by topic name. Shards which are not listed use max_cache_size.
+  std::unordered_map<std::string, uint64_t> cache_shard_sizes{};
+
+  // Overflow policy of individual cache shards, keyed like cache_shard_sizes. Shards which are
+  // not listed use cache_overflow_policy. "spill_to_disk" is not supported for shards.
+  std::unordered_map<std::string, std::string> cache_shard_policies{};
+
+  // What happens to messages written while the cache is full: "drop_newest" drops the new
+  // message, "drop_oldest" drops the oldest cached messages which were not handed to storage
+  // yet, "block" makes the writer wait until the cache has space again and "spill_to_disk"
+  // appends messages to a spill file until storage caught up.
+  // With cache sharding, this is the policy of every shard not listed in cache_shard_policies
+  // and "spill_to_disk" is not supported. The other message caches only support "drop_newest".
+  std::string cache_overflow_policy = "drop_newest";
+
+  // Maximum time in milliseconds a write waits for cache space with the "block" overflow
+  // policy before the message is dropped. A value of 0 waits without limit.
+  uint64_t cache_block_timeout_ms = 0;
+
+  // Directory of the spill file for the "spill_to_disk" overflow policy, ideally on a
+  // different device than the bag. Defaults to the temporary directory of the system.
+  std::string cache_spill_directory = "";
+
+  // Size in bytes of the spill file, which is allocated when the writer is opened.
+  uint64_t cache_spill_size = 1024 * 1024 * 1024;
+
+  // Minimum number of bytes the cache consumer collects before writing them to storage in
+  // one batch. A value of 0 writes every swapped cache buffer right away.
+  uint64_t cache_min_batch_size = 0;
+
+  // Maximum number of bytes written to storage in one batch. Larger batches are split.
+  // A value of 0 does not limit the batch size.
+  uint64_t cache_max_batch_size = 0;
+
+  // Maximum time in milliseconds a message waits in an incomplete batch before the batch is
+  // written anyway.
+  uint64_t cache_max_batch_latency_ms = 100;
+
+  // Derive the batch size from the observed write throughput of the storage, bounded by
+  // cache_min_batch_size and cache_max_batch_size.
+  bool cache_adaptive_batching = false;
+
+  // Split bag files without blocking the writer on file creation and closing: the next bag
+  // file is opened ahead of time and the previous one is closed in the background.
+  // WRITE_SPLIT events are emitted once the previous file is closed.
+  bool async_split = false;
+
+  // Rolling retention for always-on recording: after each split, the oldest bag files are
+  // deleted in the background while the closed bag files exceed this many bytes together, and
+  // removed from the metadata. The file being written comes on top of the budget, and the most
+  // recently closed file is always kept. A value of 0 keeps all files.
+  uint64_t max_bag_retention_size = 0;
+
+  // Like max_bag_retention_size, but deletes the closed bag files whose messages are all older
+  // than this many seconds before the newest message of the bag. A value of 0 keeps all files.
+  uint64_t max_bag_retention_duration = 0;
+
+  // Reserve max_bagfile_size bytes on disk for every new bag file, so that the file system
+  // does not have to grow the file while recording. The file is truncated to the size of the
+  // recorded data when it is closed. Ignored if max_bagfile_size is not set.
+  bool preallocate_bagfiles = false;
+
+  // Open storage read-only just to get the metadata of the bag file. Storage plugins may skip
+  // preparing to read messages, and fail instead of scanning the whole file when its metadata
+  // is not stored in a summary.
+  bool metadata_only = false;
+
+  // Number of split files after the one being read which are decompressed in the background
+  // when reading a bag compressed by file, so that reading does not stall at split boundaries.
+  // A value of 0 decompresses each file when it is opened.
+  uint64_t decompression_look_ahead_files = 0;
+
+  // Maximum size in bytes of the decompressed files a reader keeps on disk. Decompressed files
+  // before the one being read are removed to stay within the budget, and are decompressed
+  // again if they are read again. A value of 0 keeps all decompressed files.
+  uint64_t decompression_disk_budget = 0;
+
+  // Number of threads which decompress the messages of a bag compressed by message, ahead of
+  // them being read. A value of 0 decompresses each message when it is read.
+  uint64_t decompression_threads = 0;
+
+  // Fraction of the time range of the file being read after which a reader opens the next file
+  // in read order in the background, so that switching to it does not wait for the storage.
+  // A value of 0 opens each file when the previous one is exhausted.
+  double next_file_open_fraction = 0.0;
+
+  // Maximum time in milliseconds between the oldest and the newest message kept for a snapshot
+  // in snapshot mode, in addition to the max_cache_size bound.
+  // A value of 0 only bounds the snapshot by max_cache_size.
+  uint64_t snapshot_duration_ms = 0;
+
+  // Time in milliseconds after a snapshot in snapshot mode during which the recorded messages
+  // are written to the bag file of the snapshot as well.
+  // A value of 0 only writes the messages from before the snapshot.
+  uint64_t snapshot_post_trigger_duration_ms = 0;
+
+  // Directory in which the concatenated message definitions of recorded types are kept across
+  // recordings, keyed by type and type description hash. An empty directory disables the cache.
+  std::string message_definition_cache_directory = "";
+
+  // Number of threads which resolve the message definitions of discovered topics in the
+  // background. A value of 0 resolves each definition when its topic is created.
+  uint64_t message_definition_threads = 0;
+
+  // Real-time scheduling policy of the thread writing the message cache to storage, "fifo" or
+  // "rr", used if cache_consumer_thread_priority is set. Only supported on Linux.
+  std::string cache_consumer_thread_policy = "fifo";
+
+  // Real-time priority from 1 to 99 of the thread writing the message cache to storage.
+  // A value of 0 keeps the default scheduling policy.
+  int32_t cache_consumer_thread_priority = 0;
+
+  // CPUs the thread writing the message cache to storage is pinned to, e.g. to keep it off the
+  // cores of real-time processes. Empty lets it run on any CPU.
+  std::vector<uint64_t> cache_consumer_thread_cpus;
+
+  // Minimum size in bytes of message payloads the writer deduplicates: a payload which repeats
+  // an earlier payload of the same topic in the same bag file is stored as a reference to it,
+  // which readers resolve transparently. A value of 0 disables deduplication.
+  uint64_t deduplication_min_payload_size = 0;
+
+  // Maximum number of bytes of payloads the writer keeps to detect repeats, and readers keep
+  // to resolve references without looking them up in the bag file.
+  uint64_t deduplication_cache_size = 64 * 1024 * 1024;
+
+  // Topics whose messages the writer stores as the bytes which differ from the last keyframe
+  // of the topic, e.g. occupancy grids or costmaps of which only small regions change. Readers
+  // reconstruct the messages transparently.
+  std::vector<std::string> delta_encoded_topics;
+
+  // Store every n-th message of delta_encoded_topics completely as a keyframe, starting with
+  // the first message of every bag file.
+  uint64_t delta_keyframe_interval = 10;
+
+  // Duration in milliseconds of the time buckets of the preview the writer stores in the bag
+  // directory when it is closed, with the message count and bytes of every topic per bucket.
+  // A value of 0 disables the preview.
+  uint64_t preview_bucket_duration_ms = 0;
+
+  // Topics of which the preview keeps every preview_sample_interval-th message, e.g. to show
+  // thumbnails of camera topics.
+  std::vector<std::string> preview_sample_topics;
+
+  // Keep every n-th message of preview_sample_topics in the preview, starting with the first.
+  uint64_t preview_sample_interval = 100;
+
+  // Priority of topics in the message cache: when the cache is full, the oldest messages of
+  // topics with lower priority are dropped to make room for messages of higher priority, e.g.
+  // debug images for control or localization. Topics which are not listed have priority 0.
+  // Only supported by the default message cache with the "drop_newest" overflow policy.
+  std::unordered_map<std::string, uint32_t> cache_topic_priorities{};
+
+  // Make the written data durable, by a commit or fsync of the storage plugin, at the latest
+  // durability_interval_ms after the first write which is not durable yet or once
+  // durability_bytes were written since the last commit, whichever comes first. Commits group
+  // all batches written in between. A value of 0 disables the limit; with both 0 durability is
+  // left to the storage configuration.
+  uint64_t durability_interval_ms = 0;
+  uint64_t durability_bytes = 0;
+
+  // Copy the payloads of the messages kept in snapshot mode into contiguous blocks allocated up
+  // front, indexed by their time stamps and topics, instead of keeping the messages. Saves an
+  // allocation per message and the overhead of the messages, so that more small messages fit
+  // into max_cache_size.
+  bool snapshot_contiguous_buffer = false;
+
+  // Bytes of released payload buffers of read messages kept for reuse, so that reading a bag,
+  // e.g. for playback, does not allocate a buffer for every message. Opening a reader installs
+  // a BufferPool for the messages created by the storage plugins, unless a pool is installed
+  // already. 0 allocates every payload.
+  uint64_t read_buffer_pool_size = 0;
+
+  // Content of the file at uri to read instead of the file itself, e.g. while it is
+  // decompressed. Only used for reading, by storage plugins which support it.
+  std::shared_ptr<ReadableFile> readable_file = nullptr;
 };
 
 }  // namespace rosbag2_storage
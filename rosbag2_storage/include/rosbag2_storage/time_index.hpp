@@ -0,0 +1,83 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__TIME_INDEX_HPP_
+#define ROSBAG2_STORAGE__TIME_INDEX_HPP_
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+struct TimeIndexEntry
+{
+  // No message stored before position has a timestamp at or after this one
+  rcutils_time_point_value_t timestamp;
+  // Storage specific position of a message, e.g. a file offset or a row id
+  uint64_t position;
+};
+
+/// Sparse index from timestamps to positions in a bag file, built while the file is written.
+/**
+ * An entry is recorded at most every interval of message time. Reading for messages at or after
+ * a timestamp can start at the position of the last entry with a timestamp not after it, since
+ * all messages stored before that position are older, even if messages were not written in order
+ * of their timestamps.
+ */
+class ROSBAG2_STORAGE_PUBLIC TimeIndex
+{
+public:
+  static constexpr rcutils_duration_value_t default_interval = RCUTILS_S_TO_NS(1);
+
+  explicit TimeIndex(rcutils_duration_value_t interval = default_interval);
+
+  /// Account a message, in the order the messages are stored.
+  /// \param timestamp Timestamp of the message
+  /// \param position Position the message is stored at, positions have to increase
+  void add_message(rcutils_time_point_value_t timestamp, uint64_t position);
+
+  /// Position to start reading at for messages at or after timestamp.
+  /// \return The position, or nothing if reading has to start at the beginning of the file
+  std::optional<uint64_t> find_start_position(rcutils_time_point_value_t timestamp) const;
+
+  const std::vector<TimeIndexEntry> & entries() const;
+
+  bool empty() const;
+
+  /// Serialize the entries as text, to be stored along with the bag file.
+  std::string serialize() const;
+
+  /// \throws std::runtime_error if serialized_index is malformed
+  static TimeIndex deserialize(const std::string & serialized_index);
+
+private:
+  rcutils_duration_value_t interval_;
+  std::vector<TimeIndexEntry> entries_;
+  // Latest timestamp of the messages added so far
+  rcutils_time_point_value_t max_timestamp_ =
+    std::numeric_limits<rcutils_time_point_value_t>::min();
+  bool has_messages_ = false;
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__TIME_INDEX_HPP_
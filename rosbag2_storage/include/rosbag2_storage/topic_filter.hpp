@@ -0,0 +1,85 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__TOPIC_FILTER_HPP_
+#define ROSBAG2_STORAGE__TOPIC_FILTER_HPP_
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_storage
+{
+
+/**
+* Topic selection of a StorageFilter, prepared for repeated evaluation.
+*
+* The topic list is kept in a hash set and the regular expressions are compiled once, when the
+* filter is constructed. A topic is selected if it is in the topic list, matches topics_regex
+* and does not match topics_regex_to_exclude, each check applying only if it is set.
+* The result is remembered per topic name, so storage plugins can evaluate the filter for every
+* message without matching the regular expressions again.
+*
+* Not thread-safe.
+*/
+class ROSBAG2_STORAGE_PUBLIC TopicFilter
+{
+public:
+  /// Selects all topics.
+  TopicFilter() = default;
+
+  /// \param syntax Grammar of the regular expressions in storage_filter.
+  /// \throws std::regex_error if a regular expression of storage_filter is invalid.
+  explicit TopicFilter(
+    const StorageFilter & storage_filter,
+    std::regex::flag_type syntax = std::regex::ECMAScript);
+
+  /// \return true if the filter selects every topic.
+  bool selects_all() const;
+
+  /// \return true if the topic is selected by the filter.
+  bool matches(std::string_view topic_name) const;
+
+private:
+  bool evaluate(const std::string & topic_name) const;
+
+  std::unordered_set<std::string> topics_;
+  std::optional<std::regex> topics_regex_;
+  std::optional<std::regex> topics_regex_to_exclude_;
+  // std::less<> allows lookups by string_view without copying the topic name
+  mutable std::map<std::string, bool, std::less<>> results_;
+};
+
+}  // namespace rosbag2_storage
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_STORAGE__TOPIC_FILTER_HPP_
@@ -0,0 +1,64 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__TOPIC_STATISTICS_HPP_
+#define ROSBAG2_STORAGE__TOPIC_STATISTICS_HPP_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "rcutils/time.h"
+
+#include "rosbag2_storage/visibility_control.hpp"
+
+namespace rosbag2_storage
+{
+
+/// Statistics of the messages of one topic, collected while a bag is written.
+struct ROSBAG2_STORAGE_PUBLIC TopicStatistics
+{
+  /// Number of buckets of interval_histogram.
+  /**
+   * Bucket 0 counts intervals shorter than 1 ms, bucket i intervals of [2^(i-1), 2^i) ms and the
+   * last bucket all longer intervals.
+   */
+  static constexpr size_t interval_histogram_size = 16;
+  /// An interval is counted as gap if it is longer than this many times the mean interval of
+  /// the messages before it.
+  static constexpr int64_t gap_factor = 4;
+
+  std::string topic_name;
+  size_t message_count = 0;
+  rcutils_time_point_value_t min_timestamp = std::numeric_limits<rcutils_time_point_value_t>::max();
+  rcutils_time_point_value_t max_timestamp = std::numeric_limits<rcutils_time_point_value_t>::min();
+  uint64_t total_bytes = 0;
+  uint64_t min_message_size = std::numeric_limits<uint64_t>::max();
+  uint64_t max_message_size = 0;
+  // Intervals between the timestamps of consecutive messages, in the order they were written
+  std::vector<uint64_t> interval_histogram = std::vector<uint64_t>(interval_histogram_size, 0u);
+  uint64_t gap_count = 0;
+  rcutils_time_point_value_t last_timestamp = 0;  // Will not be serialized
+
+  /// Account a message, messages have to be added in the order they are written.
+  void add_message(rcutils_time_point_value_t timestamp, uint64_t size);
+
+  /// Index of the bucket of interval_histogram for an interval.
+  static size_t interval_histogram_bucket(rcutils_duration_value_t interval);
+};
+
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__TOPIC_STATISTICS_HPP_
@@ -15,6 +15,7 @@
 #define ROSBAG2_STORAGE__YAML_HPP_
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -67,6 +68,49 @@ struct convert<std::unordered_map<std::string, std::string>>
   }
 };
 
+template<>
+struct convert<std::unordered_map<std::string, std::vector<std::string>>>
+{
+  static Node encode(const std::unordered_map<std::string, std::vector<std::string>> & lists)
+  {
+    Node node;
+    for (const auto & it : lists) {
+      node[it.first] = it.second;
+    }
+    return node;
+  }
+
+  static bool decode(
+    const Node & node, std::unordered_map<std::string, std::vector<std::string>> & lists)
+  {
+    for (YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+      lists.emplace(it->first.as<std::string>(), it->second.as<std::vector<std::string>>());
+    }
+    return true;
+  }
+};
+
+template<>
+struct convert<std::unordered_map<std::string, uint64_t>>
+{
+  static Node encode(const std::unordered_map<std::string, uint64_t> & values)
+  {
+    Node node;
+    for (const auto & it : values) {
+      node[it.first] = it.second;
+    }
+    return node;
+  }
+
+  static bool decode(const Node & node, std::unordered_map<std::string, uint64_t> & values)
+  {
+    for (YAML::const_iterator it = node.begin(); it != node.end(); ++it) {
+      values.emplace(it->first.as<std::string>(), it->second.as<uint64_t>());
+    }
+    return true;
+  }
+};
+
 template<>
 struct convert<rclcpp::Duration>
 {
@@ -201,6 +245,13 @@ struct convert<rosbag2_storage::FileInformation>
     node["starting_time"] = metadata.starting_time;
     node["duration"] = metadata.duration;
     node["message_count"] = metadata.message_count;
+    // Only manifests have time windows, the files of other bags are written as before
+    if (metadata.window_start_time_ns >= 0) {
+      node["window_start_time_ns"] = metadata.window_start_time_ns;
+    }
+    if (metadata.window_end_time_ns >= 0) {
+      node["window_end_time_ns"] = metadata.window_end_time_ns;
+    }
     return node;
   }
 
@@ -211,6 +262,10 @@ struct convert<rosbag2_storage::FileInformation>
       node["starting_time"].as<std::chrono::time_point<std::chrono::high_resolution_clock>>();
     metadata.duration = node["duration"].as<std::chrono::nanoseconds>();
     metadata.message_count = node["message_count"].as<uint64_t>();
+    metadata.window_start_time_ns = node["window_start_time_ns"] ?
+      node["window_start_time_ns"].as<int64_t>() : -1;
+    metadata.window_end_time_ns = node["window_end_time_ns"] ?
+      node["window_end_time_ns"].as<int64_t>() : -1;
     return true;
   }
 };
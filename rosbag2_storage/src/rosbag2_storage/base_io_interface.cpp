@@ -14,11 +14,18 @@
 
 #include "rosbag2_storage/storage_interfaces/base_io_interface.hpp"
 
+#include <string>
+
 namespace rosbag2_storage
 {
 namespace storage_interfaces
 {
 const uint64_t MAX_BAGFILE_SIZE_NO_SPLIT = 0;
 const uint64_t MAX_BAGFILE_DURATION_NO_SPLIT = 0;
+
+bool BaseIOInterface::probe(const std::string & /* uri */) const
+{
+  return true;
+}
 }
 }
@@ -0,0 +1,62 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <memory>
+#include <vector>
+
+#include "rosbag2_storage/storage_interfaces/base_read_interface.hpp"
+
+namespace rosbag2_storage
+{
+namespace storage_interfaces
+{
+
+std::vector<std::shared_ptr<SerializedBagMessage>> BaseReadInterface::read_next_batch(
+  size_t max_messages, size_t max_bytes)
+{
+  std::vector<std::shared_ptr<SerializedBagMessage>> messages;
+  size_t bytes = 0;
+  while ((max_messages == 0 || messages.size() < max_messages) &&
+    (max_bytes == 0 || bytes < max_bytes) && has_next())
+  {
+    messages.push_back(read_next());
+    if (messages.back()->serialized_data) {
+      bytes += messages.back()->serialized_data->buffer_length;
+    }
+  }
+  return messages;
+}
+
+void BaseReadInterface::for_each(const MessageViewCallback & callback)
+{
+  while (has_next()) {
+    const auto message = read_next();
+    SerializedBagMessageView view;
+    if (message->serialized_data) {
+      view.data = message->serialized_data->buffer;
+      view.size = message->serialized_data->buffer_length;
+    }
+    view.time_stamp = message->time_stamp;
+    view.topic_name = message->topic_name;
+    view.send_timestamp = message->send_timestamp;
+    view.sequence_number = message->sequence_number;
+    if (!callback(view)) {
+      return;
+    }
+  }
+}
+
+}  // namespace storage_interfaces
+}  // namespace rosbag2_storage
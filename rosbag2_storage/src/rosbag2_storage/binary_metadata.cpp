@@ -0,0 +1,279 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_metadata.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_storage/qos.hpp"
+
+namespace rosbag2_storage
+{
+namespace binary_metadata
+{
+
+namespace
+{
+constexpr const char kMagic[] = "ROSBAG2M";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+// Version of the layout, independent of the version of the metadata
+constexpr uint64_t kFormatVersion = 1;
+
+using TimePoint = std::chrono::time_point<std::chrono::high_resolution_clock>;
+
+class Writer
+{
+public:
+  void u64(uint64_t value)
+  {
+    for (int shift = 0; shift < 64; shift += 8) {
+      data.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+  }
+
+  void i64(int64_t value)
+  {
+    u64(static_cast<uint64_t>(value));
+  }
+
+  void string(const std::string & value)
+  {
+    u64(value.size());
+    data += value;
+  }
+
+  std::string data;
+};
+
+class Reader
+{
+public:
+  Reader(const std::string & data, size_t position)
+  : data_(data), position_(position) {}
+
+  bool u64(uint64_t & value)
+  {
+    if (data_.size() - position_ < 8) {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[position_ + i])) << (8 * i);
+    }
+    position_ += 8;
+    return true;
+  }
+
+  template<typename T>
+  bool integer(T & value)
+  {
+    uint64_t raw = 0;
+    if (!u64(raw)) {
+      return false;
+    }
+    value = static_cast<T>(raw);
+    return true;
+  }
+
+  bool string(std::string & value)
+  {
+    uint64_t size = 0;
+    if (!u64(size) || data_.size() - position_ < size) {
+      return false;
+    }
+    value.assign(data_, position_, size);
+    position_ += size;
+    return true;
+  }
+
+  /// Read the number of elements of a sequence, each of which takes at least min_element_size
+  bool count(size_t & value, size_t min_element_size)
+  {
+    uint64_t raw = 0;
+    if (!u64(raw) || raw > (data_.size() - position_) / min_element_size) {
+      return false;
+    }
+    value = static_cast<size_t>(raw);
+    return true;
+  }
+
+  bool at_end() const
+  {
+    return position_ == data_.size();
+  }
+
+private:
+  const std::string & data_;
+  size_t position_;
+};
+}  // namespace
+
+uint64_t hash(const std::string & data)
+{
+  // FNV-1a, which is fast enough to check metadata files of several MB on every open
+  uint64_t value = 14695981039346656037ull;
+  for (const char byte : data) {
+    value ^= static_cast<unsigned char>(byte);
+    value *= 1099511628211ull;
+  }
+  return value;
+}
+
+std::string encode(const BagMetadata & metadata, uint64_t source_hash)
+{
+  Writer writer;
+  writer.data.append(kMagic, kMagicSize);
+  writer.u64(kFormatVersion);
+  writer.u64(source_hash);
+
+  writer.i64(metadata.version);
+  writer.string(metadata.storage_identifier);
+  writer.i64(metadata.duration.count());
+  writer.i64(metadata.starting_time.time_since_epoch().count());
+  writer.u64(metadata.message_count);
+  writer.u64(metadata.topics_with_message_count.size());
+  for (const auto & topic_info : metadata.topics_with_message_count) {
+    const auto & topic = topic_info.topic_metadata;
+    writer.string(topic.name);
+    writer.string(topic.type);
+    writer.string(topic.serialization_format);
+    writer.string(serialize_rclcpp_qos_vector(topic.offered_qos_profiles, metadata.version));
+    writer.string(topic.type_description_hash);
+    writer.u64(topic_info.message_count);
+  }
+  writer.string(metadata.compression_format);
+  writer.string(metadata.compression_mode);
+  writer.u64(metadata.relative_file_paths.size());
+  for (const auto & path : metadata.relative_file_paths) {
+    writer.string(path);
+  }
+  writer.u64(metadata.files.size());
+  for (const auto & file : metadata.files) {
+    writer.string(file.path);
+    writer.i64(file.starting_time.time_since_epoch().count());
+    writer.i64(file.duration.count());
+    writer.u64(file.message_count);
+    writer.i64(file.window_start_time_ns);
+    writer.i64(file.window_end_time_ns);
+  }
+  writer.u64(metadata.custom_data.size());
+  for (const auto & [key, value] : metadata.custom_data) {
+    writer.string(key);
+    writer.string(value);
+  }
+  writer.string(metadata.ros_distro);
+  return std::move(writer.data);
+}
+
+std::optional<BagMetadata> decode(const std::string & data, uint64_t source_hash)
+{
+  if (data.size() < kMagicSize || data.compare(0, kMagicSize, kMagic) != 0) {
+    return std::nullopt;
+  }
+  Reader reader(data, kMagicSize);
+  uint64_t format_version = 0;
+  uint64_t encoded_source_hash = 0;
+  if (!reader.u64(format_version) ||
+    format_version != kFormatVersion || !reader.u64(encoded_source_hash) ||
+    encoded_source_hash != source_hash)
+  {
+    return std::nullopt;
+  }
+
+  BagMetadata metadata;
+  int64_t duration = 0;
+  int64_t starting_time = 0;
+  size_t count = 0;
+  if (!reader.integer(metadata.version) || !reader.string(metadata.storage_identifier) ||
+    !reader.integer(duration) || !reader.integer(starting_time) ||
+    !reader.integer(metadata.message_count) || !reader.count(count, 6 * 8))
+  {
+    return std::nullopt;
+  }
+  metadata.duration = std::chrono::nanoseconds(duration);
+  metadata.starting_time = TimePoint(std::chrono::nanoseconds(starting_time));
+
+  // Topics mostly share a few QoS profiles, which are parsed once each
+  std::unordered_map<std::string, std::vector<rclcpp::QoS>> qos_profiles;
+  metadata.topics_with_message_count.resize(count);
+  for (auto & topic_info : metadata.topics_with_message_count) {
+    auto & topic = topic_info.topic_metadata;
+    std::string serialized_qos;
+    if (!reader.string(topic.name) || !reader.string(topic.type) ||
+      !reader.string(topic.serialization_format) || !reader.string(serialized_qos) ||
+      !reader.string(topic.type_description_hash) || !reader.integer(topic_info.message_count))
+    {
+      return std::nullopt;
+    }
+    auto profiles = qos_profiles.find(serialized_qos);
+    if (profiles == qos_profiles.end()) {
+      profiles = qos_profiles.emplace(
+        serialized_qos, to_rclcpp_qos_vector(serialized_qos, metadata.version)).first;
+    }
+    topic.offered_qos_profiles = profiles->second;
+  }
+
+  if (!reader.string(metadata.compression_format) ||
+    !reader.string(metadata.compression_mode) || !reader.count(count, 8))
+  {
+    return std::nullopt;
+  }
+  metadata.relative_file_paths.resize(count);
+  for (auto & path : metadata.relative_file_paths) {
+    if (!reader.string(path)) {
+      return std::nullopt;
+    }
+  }
+
+  if (!reader.count(count, 6 * 8)) {
+    return std::nullopt;
+  }
+  metadata.files.resize(count);
+  for (auto & file : metadata.files) {
+    int64_t file_starting_time = 0;
+    int64_t file_duration = 0;
+    if (!reader.string(file.path) || !reader.integer(file_starting_time) ||
+      !reader.integer(file_duration) || !reader.integer(file.message_count) ||
+      !reader.integer(file.window_start_time_ns) || !reader.integer(file.window_end_time_ns))
+    {
+      return std::nullopt;
+    }
+    file.starting_time = TimePoint(std::chrono::nanoseconds(file_starting_time));
+    file.duration = std::chrono::nanoseconds(file_duration);
+  }
+
+  if (!reader.count(count, 2 * 8)) {
+    return std::nullopt;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    std::string key;
+    std::string value;
+    if (!reader.string(key) || !reader.string(value)) {
+      return std::nullopt;
+    }
+    metadata.custom_data.emplace(std::move(key), std::move(value));
+  }
+  if (!reader.string(metadata.ros_distro) || !reader.at_end()) {
+    return std::nullopt;
+  }
+  return metadata;
+}
+
+}  // namespace binary_metadata
+}  // namespace rosbag2_storage
@@ -0,0 +1,49 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE__BINARY_METADATA_HPP_
+#define ROSBAG2_STORAGE__BINARY_METADATA_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "rosbag2_storage/bag_metadata.hpp"
+
+namespace rosbag2_storage
+{
+namespace binary_metadata
+{
+
+/// Hash of the metadata file a binary encoding was made from, to detect stale encodings.
+uint64_t hash(const std::string & data);
+
+/// Encode metadata compactly, with little endian integers and length prefixed strings.
+/**
+ * \param metadata Metadata of the current version, older versions are only read from YAML.
+ * \param source_hash Hash of the metadata file which has the same content.
+ */
+std::string encode(const BagMetadata & metadata, uint64_t source_hash);
+
+/// Decode metadata encoded with encode().
+/**
+ * \return The metadata, none if data is not a complete encoding of the supported format or
+ *   was not made from the metadata file with source_hash.
+ */
+std::optional<BagMetadata> decode(const std::string & data, uint64_t source_hash);
+
+}  // namespace binary_metadata
+}  // namespace rosbag2_storage
+
+#endif  // ROSBAG2_STORAGE__BINARY_METADATA_HPP_
@@ -0,0 +1,325 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/buffer_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "rosbag2_storage/logging.hpp"
+
+namespace rosbag2_storage
+{
+
+namespace
+{
+/// Every buffer is prefixed with its capacity, so that deallocate() which has no size argument
+/// in the rcutils allocator API can find the right size class.
+struct alignas(std::max_align_t) BufferHeader
+{
+  size_t capacity;
+};
+
+BufferHeader * header_of(void * pointer)
+{
+  return reinterpret_cast<BufferHeader *>(static_cast<char *>(pointer) - sizeof(BufferHeader));
+}
+
+void * payload_of(BufferHeader * header)
+{
+  return reinterpret_cast<char *>(header) + sizeof(BufferHeader);
+}
+
+void * pool_allocate(size_t size, void * state)
+{
+  return static_cast<BufferPool *>(state)->allocate(size);
+}
+
+void pool_deallocate(void * pointer, void * state)
+{
+  static_cast<BufferPool *>(state)->deallocate(pointer);
+}
+
+void * pool_reallocate(void * pointer, size_t size, void * state)
+{
+  return static_cast<BufferPool *>(state)->reallocate(pointer, size);
+}
+
+void * pool_zero_allocate(size_t number_of_elements, size_t size_of_element, void * state)
+{
+  if (size_of_element != 0 &&
+    number_of_elements > std::numeric_limits<size_t>::max() / size_of_element)
+  {
+    return nullptr;
+  }
+  const size_t size = number_of_elements * size_of_element;
+  void * pointer = static_cast<BufferPool *>(state)->allocate(size);
+  if (pointer != nullptr) {
+    std::memset(pointer, 0, size);
+  }
+  return pointer;
+}
+
+#ifdef __linux__
+constexpr size_t kHugePageBytes = 2 * 1024 * 1024;
+
+// Map the arena on explicit huge pages if enough of them are reserved, or else on pages which
+// may be merged into transparent huge pages
+void * map_arena(size_t size, bool huge_pages)
+{
+  if (huge_pages) {
+    void * arena = mmap(
+      nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (arena != MAP_FAILED) {
+      return arena;
+    }
+  }
+  void * arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED) {
+    return nullptr;
+  }
+  if (huge_pages && madvise(arena, size, MADV_HUGEPAGE) != 0) {
+    ROSBAG2_STORAGE_LOG_WARN_STREAM(
+      "Huge pages are not available for the buffer arena: " << std::strerror(errno));
+  }
+  return arena;
+}
+
+// Bind the pages of the arena to a NUMA node, before they are touched for the first time
+void bind_to_numa_node(void * arena, size_t size, int numa_node)
+{
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT(runtime/int)
+  std::vector<unsigned long> node_mask(numa_node / kBitsPerWord + 1, 0);  // NOLINT(runtime/int)
+  node_mask[numa_node / kBitsPerWord] |= 1UL << (numa_node % kBitsPerWord);
+  if (syscall(
+      SYS_mbind, arena, size, MPOL_BIND, node_mask.data(), node_mask.size() * kBitsPerWord + 1,
+      0) != 0)
+  {
+    ROSBAG2_STORAGE_LOG_WARN_STREAM(
+      "Failed to bind the buffer arena to NUMA node " << numa_node << ": " <<
+        std::strerror(errno));
+  }
+}
+#endif
+}  // namespace
+
+BufferPool::BufferPool(size_t max_cached_bytes)
+: max_cached_bytes_(max_cached_bytes)
+{}
+
+BufferPool::BufferPool(size_t max_cached_bytes, const ArenaOptions & arena_options)
+: BufferPool(max_cached_bytes)
+{
+  if (arena_options.size == 0) {
+    return;
+  }
+#ifdef __linux__
+  arena_size_ = (arena_options.size + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+  arena_ = static_cast<char *>(map_arena(arena_size_, arena_options.huge_pages));
+  if (arena_ != nullptr && arena_options.numa_node >= 0) {
+    bind_to_numa_node(arena_, arena_size_, arena_options.numa_node);
+  }
+#else
+  arena_size_ = arena_options.size;
+  arena_ = static_cast<char *>(std::malloc(arena_size_));
+#endif
+  if (arena_ == nullptr) {
+    arena_size_ = 0;
+    throw std::runtime_error(
+            "Failed to reserve " + std::to_string(arena_options.size) +
+            " bytes for the buffer arena.");
+  }
+}
+
+BufferPool::~BufferPool()
+{
+  release_cached_buffers();
+  if (arena_ != nullptr) {
+#ifdef __linux__
+    munmap(arena_, arena_size_);
+#else
+    std::free(arena_);
+#endif
+  }
+}
+
+size_t BufferPool::get_size_class_capacity(size_t size)
+{
+  if (size > kMaxSizeClassBytes) {
+    return size;
+  }
+  size_t capacity = kMinSizeClassBytes;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+size_t BufferPool::get_size_class_index(size_t capacity)
+{
+  size_t index = 0;
+  for (size_t class_capacity = kMinSizeClassBytes; class_capacity < capacity;
+    class_capacity <<= 1)
+  {
+    ++index;
+  }
+  return index;
+}
+
+void * BufferPool::allocate(size_t size)
+{
+  const size_t capacity = get_size_class_capacity(size);
+  if (capacity <= kMaxSizeClassBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto & free_list = free_lists_[get_size_class_index(capacity)];
+    if (!free_list.empty()) {
+      void * pointer = free_list.back();
+      free_list.pop_back();
+      if (!is_in_arena(pointer)) {
+        cached_bytes_ -= capacity;
+      }
+      return pointer;
+    }
+    if (arena_ != nullptr) {
+      void * pointer = allocate_from_arena(capacity);
+      if (pointer != nullptr) {
+        return pointer;
+      }
+    }
+  }
+
+  if (capacity > std::numeric_limits<size_t>::max() - sizeof(BufferHeader)) {
+    return nullptr;
+  }
+  auto header = static_cast<BufferHeader *>(std::malloc(sizeof(BufferHeader) + capacity));
+  if (header == nullptr) {
+    return nullptr;
+  }
+  header->capacity = capacity;
+  return payload_of(header);
+}
+
+void BufferPool::deallocate(void * pointer)
+{
+  if (pointer == nullptr) {
+    return;
+  }
+  BufferHeader * header = header_of(pointer);
+  const size_t capacity = header->capacity;
+  if (capacity <= kMaxSizeClassBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_in_arena(pointer)) {
+      free_lists_[get_size_class_index(capacity)].push_back(pointer);
+      return;
+    }
+    if (cached_bytes_ + capacity <= max_cached_bytes_) {
+      free_lists_[get_size_class_index(capacity)].push_back(pointer);
+      cached_bytes_ += capacity;
+      return;
+    }
+  }
+  std::free(header);
+}
+
+void * BufferPool::reallocate(void * pointer, size_t size)
+{
+  if (pointer == nullptr) {
+    return allocate(size);
+  }
+  const size_t old_capacity = header_of(pointer)->capacity;
+  if (size <= old_capacity) {
+    return pointer;
+  }
+  void * new_pointer = allocate(size);
+  if (new_pointer == nullptr) {
+    // Same as realloc: the original buffer is left untouched on failure.
+    return nullptr;
+  }
+  std::memcpy(new_pointer, pointer, old_capacity);
+  deallocate(pointer);
+  return new_pointer;
+}
+
+rcutils_allocator_t BufferPool::get_allocator()
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = pool_allocate;
+  allocator.deallocate = pool_deallocate;
+  allocator.reallocate = pool_reallocate;
+  allocator.zero_allocate = pool_zero_allocate;
+  allocator.state = this;
+  return allocator;
+}
+
+size_t BufferPool::get_cached_bytes() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+size_t BufferPool::get_arena_used_bytes() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return arena_used_bytes_;
+}
+
+void BufferPool::release_cached_buffers()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto & free_list : free_lists_) {
+    auto system_buffers = std::partition(
+      free_list.begin(), free_list.end(),
+      [this](void * pointer) {return is_in_arena(pointer);});
+    for (auto it = system_buffers; it != free_list.end(); ++it) {
+      std::free(header_of(*it));
+    }
+    free_list.erase(system_buffers, free_list.end());
+  }
+  cached_bytes_ = 0;
+}
+
+bool BufferPool::is_in_arena(const void * pointer) const
+{
+  const char * address = static_cast<const char *>(pointer);
+  return arena_ != nullptr && address >= arena_ && address < arena_ + arena_size_;
+}
+
+void * BufferPool::allocate_from_arena(size_t capacity)
+{
+  // Capacities are powers of two of at least kMinSizeClassBytes, so buffers stay aligned
+  const size_t bytes = sizeof(BufferHeader) + capacity;
+  if (arena_size_ - arena_used_bytes_ < bytes) {
+    return nullptr;
+  }
+  auto header = reinterpret_cast<BufferHeader *>(arena_ + arena_used_bytes_);
+  arena_used_bytes_ += bytes;
+  header->capacity = capacity;
+  return payload_of(header);
+}
+
+}  // namespace rosbag2_storage
@@ -0,0 +1,29 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/class_loader_cache.hpp"
+
+#include <mutex>
+
+namespace rosbag2_storage
+{
+
+std::recursive_mutex & get_class_loader_mutex()
+{
+  // Defined in one library, so that all libraries of the process share it
+  static std::recursive_mutex class_loader_mutex;
+  return class_loader_mutex;
+}
+
+}  // namespace rosbag2_storage
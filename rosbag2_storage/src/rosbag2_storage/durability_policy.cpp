@@ -0,0 +1,59 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/durability_policy.hpp"
+
+namespace rosbag2_storage
+{
+
+DurabilityPolicy::DurabilityPolicy(uint64_t interval_ms, uint64_t bytes)
+: interval_(interval_ms), bytes_(bytes)
+{
+}
+
+DurabilityPolicy::DurabilityPolicy(const StorageOptions & storage_options)
+: DurabilityPolicy(storage_options.durability_interval_ms, storage_options.durability_bytes)
+{
+}
+
+bool DurabilityPolicy::enabled() const
+{
+  return interval_.count() > 0 || bytes_ > 0;
+}
+
+void DurabilityPolicy::add_written_bytes(uint64_t bytes, clock::time_point now)
+{
+  if (!pending_) {
+    pending_ = true;
+    first_pending_time_ = now;
+  }
+  pending_bytes_ += bytes;
+}
+
+bool DurabilityPolicy::is_due(clock::time_point now) const
+{
+  if (!pending_) {
+    return false;
+  }
+  return (bytes_ > 0 && pending_bytes_ >= bytes_) ||
+         (interval_.count() > 0 && now - first_pending_time_ >= interval_);
+}
+
+void DurabilityPolicy::committed()
+{
+  pending_ = false;
+  pending_bytes_ = 0;
+}
+
+}  // namespace rosbag2_storage
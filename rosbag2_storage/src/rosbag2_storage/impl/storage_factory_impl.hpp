@@ -18,13 +18,16 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "pluginlib/class_loader.hpp"
 
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 
+#include "rosbag2_storage/class_loader_cache.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
 #include "rosbag2_storage/storage_traits.hpp"
 #include "rosbag2_storage/logging.hpp"
@@ -35,20 +38,33 @@ namespace rosbag2_storage
 using storage_interfaces::ReadOnlyInterface;
 using storage_interfaces::ReadWriteInterface;
 
+// pluginlib::ClassLoader is not thread-safe, every access goes through class_loader_mutex.
+// Opening the storage happens outside of the lock, so storages can be opened concurrently.
 template<typename InterfaceT>
 std::shared_ptr<pluginlib::ClassLoader<InterfaceT>>
 get_class_loader()
 {
-  const char * lookup_name = StorageTraits<InterfaceT>::name;
-  return std::make_shared<pluginlib::ClassLoader<InterfaceT>>("rosbag2_storage", lookup_name);
+  return get_cached_class_loader<InterfaceT>("rosbag2_storage", StorageTraits<InterfaceT>::name);
+}
+
+template<typename InterfaceT>
+std::vector<std::string>
+get_declared_classes(
+  std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
+  std::recursive_mutex & class_loader_mutex)
+{
+  std::lock_guard<std::recursive_mutex> lock(class_loader_mutex);
+  return class_loader->getDeclaredClasses();
 }
 
 template<typename InterfaceT>
 std::shared_ptr<InterfaceT>
 try_load_plugin(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
+  std::recursive_mutex & class_loader_mutex,
   const std::string & plugin_name)
 {
+  std::lock_guard<std::recursive_mutex> lock(class_loader_mutex);
   std::shared_ptr<InterfaceT> instance;
   try {
     auto unmanaged_instance = class_loader->createUnmanagedInstance(plugin_name);
@@ -68,6 +84,7 @@ template<
 std::shared_ptr<InterfaceT>
 try_detect_and_open_storage(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
+  std::recursive_mutex & class_loader_mutex,
   const StorageOptions & storage_options)
 {
   bool creating_file = flag != storage_interfaces::IOFlag::READ_ONLY;
@@ -76,12 +93,18 @@ try_detect_and_open_storage(
     return nullptr;
   }
 
-  const auto & registered_classes = class_loader->getDeclaredClasses();
+  const auto registered_classes = get_declared_classes(class_loader, class_loader_mutex);
   for (const auto & registered_class : registered_classes) {
-    std::shared_ptr<InterfaceT> instance = try_load_plugin(class_loader, registered_class);
+    std::shared_ptr<InterfaceT> instance =
+      try_load_plugin(class_loader, class_loader_mutex, registered_class);
     if (instance == nullptr) {
       continue;
     }
+    if (!instance->probe(storage_options.uri)) {
+      ROSBAG2_STORAGE_LOG_DEBUG_STREAM(
+        "Storage implementation '" << registered_class << "' does not recognize the file.");
+      continue;
+    }
     ROSBAG2_STORAGE_LOG_DEBUG_STREAM(
       "Trying storage implementation '" << registered_class << "'.");
     try {
@@ -105,13 +128,15 @@ template<
 std::shared_ptr<InterfaceT>
 get_interface_instance(
   std::shared_ptr<pluginlib::ClassLoader<InterfaceT>> class_loader,
+  std::recursive_mutex & class_loader_mutex,
   const StorageOptions & storage_options)
 {
   if (storage_options.storage_id.empty()) {
-    return try_detect_and_open_storage<InterfaceT, flag>(class_loader, storage_options);
+    return try_detect_and_open_storage<InterfaceT, flag>(
+      class_loader, class_loader_mutex, storage_options);
   }
 
-  const auto & registered_classes = class_loader->getDeclaredClasses();
+  const auto registered_classes = get_declared_classes(class_loader, class_loader_mutex);
   auto class_exists = std::find(
     registered_classes.begin(),
     registered_classes.end(), storage_options.storage_id);
@@ -122,7 +147,8 @@ get_interface_instance(
     return nullptr;
   }
 
-  std::shared_ptr<InterfaceT> instance = try_load_plugin(class_loader, storage_options.storage_id);
+  std::shared_ptr<InterfaceT> instance =
+    try_load_plugin(class_loader, class_loader_mutex, storage_options.storage_id);
   if (instance == nullptr) {
     return nullptr;
   }
@@ -163,7 +189,7 @@ public:
   std::shared_ptr<ReadWriteInterface> open_read_write(const StorageOptions & storage_options)
   {
     auto instance =
-      get_interface_instance(read_write_class_loader_, storage_options);
+      get_interface_instance(read_write_class_loader_, class_loader_mutex_, storage_options);
 
     if (instance == nullptr) {
       if (storage_options.storage_id.empty()) {
@@ -182,12 +208,12 @@ public:
   {
     // try all registered ReadOnly plugins first
     auto instance = get_interface_instance(
-      read_only_class_loader_, storage_options);
+      read_only_class_loader_, class_loader_mutex_, storage_options);
 
     // try ReadWrite plugins if no ReadOnly plugin was found
     if (instance == nullptr) {
       instance = get_interface_instance<ReadWriteInterface, storage_interfaces::IOFlag::READ_ONLY>(
-        read_write_class_loader_, storage_options);
+        read_write_class_loader_, class_loader_mutex_, storage_options);
     }
 
     if (instance == nullptr) {
@@ -206,6 +232,7 @@ public:
 private:
   std::shared_ptr<pluginlib::ClassLoader<ReadWriteInterface>> read_write_class_loader_;
   std::shared_ptr<pluginlib::ClassLoader<ReadOnlyInterface>> read_only_class_loader_;
+  std::recursive_mutex & class_loader_mutex_ = get_class_loader_mutex();
 };
 
 }  // namespace rosbag2_storage
@@ -0,0 +1,39 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rosbag2_storage/interned_topic.hpp"
+
+namespace rosbag2_storage
+{
+
+const InternedTopic & intern_topic(const std::string & topic_name)
+{
+  static std::mutex mutex;
+  // Intentionally leaked, so that records stay valid during static destruction
+  static auto & topics = *new std::unordered_map<std::string, std::unique_ptr<InternedTopic>>();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto & topic = topics[topic_name];
+  if (!topic) {
+    topic.reset(new InternedTopic{topic_name, static_cast<uint32_t>(topics.size() - 1)});
+  }
+  return *topic;
+}
+
+}  // namespace rosbag2_storage
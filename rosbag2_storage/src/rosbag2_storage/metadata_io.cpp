@@ -15,6 +15,10 @@
 #include "rosbag2_storage/metadata_io.hpp"
 
 #include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -25,22 +29,99 @@
 #include "rosbag2_storage/topic_metadata.hpp"
 #include "rosbag2_storage/yaml.hpp"
 
+#include "binary_metadata.hpp"
+
 namespace rosbag2_storage
 {
 
+namespace
+{
+// Ends every entry of the metadata journal. An entry which is not followed by it was not written
+// completely.
+constexpr const char kJournalEntryEnd[] = "...";
+
+// Version of the layout of the topic statistics file
+constexpr int kTopicStatisticsVersion = 1;
+
+std::optional<std::string> read_file(const std::string & file_name)
+{
+  std::ifstream fin(file_name, std::ios::binary);
+  if (!fin) {
+    return std::nullopt;
+  }
+  return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+template<typename T, typename Member>
+YAML::Node statistics_column(const std::vector<TopicStatistics> & statistics, Member member)
+{
+  YAML::Node column(YAML::NodeType::Sequence);
+  column.SetStyle(YAML::EmitterStyle::Flow);
+  for (const auto & topic : statistics) {
+    column.push_back(static_cast<T>(topic.*member));
+  }
+  return column;
+}
+
+template<typename T, typename Member>
+void read_statistics_column(
+  const YAML::Node & node, const char * name, std::vector<TopicStatistics> & statistics,
+  Member member)
+{
+  const auto column = node[name];
+  if (!column || column.size() != statistics.size()) {
+    throw std::runtime_error(
+            std::string("Topic statistics column ") + name + " does not match the topics");
+  }
+  for (size_t i = 0; i < statistics.size(); ++i) {
+    statistics[i].*member = column[i].as<T>();
+  }
+}
+}  // namespace
+
 void MetadataIo::write_metadata(const std::string & uri, const BagMetadata & metadata)
 {
   YAML::Node metadata_node;
   metadata_node["rosbag2_bagfile_information"] = metadata;
-  std::ofstream fout(get_metadata_file_name(uri));
-  fout << metadata_node;
+  std::stringstream yaml;
+  yaml << metadata_node;
+  const std::string yaml_data = yaml.str();
+  {
+    std::ofstream fout(get_metadata_file_name(uri));
+    fout << yaml_data;
+  }
+
+  const auto binary_file_name = get_binary_metadata_file_name(uri);
+  if (metadata.version != BagMetadata{}.version) {
+    // Older versions leave out fields when read from YAML, which the binary encoding keeps
+    rcpputils::fs::remove(rcpputils::fs::path(binary_file_name));
+    return;
+  }
+  // Written after the metadata file, an interrupted write leaves an encoding which does not
+  // match the metadata file and is not used
+  std::ofstream binary_out(binary_file_name, std::ios::binary | std::ios::trunc);
+  binary_out << binary_metadata::encode(metadata, binary_metadata::hash(yaml_data));
 }
 
 BagMetadata MetadataIo::read_metadata(const std::string & uri)
 {
   try {
-    YAML::Node yaml_file = YAML::LoadFile(get_metadata_file_name(uri));
-    auto metadata = yaml_file["rosbag2_bagfile_information"].as<rosbag2_storage::BagMetadata>();
+    std::optional<BagMetadata> decoded;
+    YAML::Node yaml_file;
+    const auto yaml_data = read_file(get_metadata_file_name(uri));
+    if (yaml_data) {
+      if (const auto binary_data = read_file(get_binary_metadata_file_name(uri))) {
+        decoded = binary_metadata::decode(*binary_data, binary_metadata::hash(*yaml_data));
+      }
+      if (!decoded) {
+        yaml_file = YAML::Load(*yaml_data);
+      }
+    } else {
+      // Throws the same error for a missing file as before
+      yaml_file = YAML::LoadFile(get_metadata_file_name(uri));
+    }
+    auto metadata = decoded ? std::move(*decoded) :
+      yaml_file["rosbag2_bagfile_information"].as<rosbag2_storage::BagMetadata>();
     rcutils_allocator_t allocator = rcutils_get_default_allocator();
     if (RCUTILS_RET_OK !=
       rcutils_calculate_directory_size(uri.c_str(), &metadata.bag_size, allocator))
@@ -61,6 +142,11 @@ std::string MetadataIo::get_metadata_file_name(const std::string & uri)
   return metadata_file;
 }
 
+std::string MetadataIo::get_binary_metadata_file_name(const std::string & uri)
+{
+  return (rcpputils::fs::path(uri) / binary_metadata_filename).string();
+}
+
 bool MetadataIo::metadata_file_exists(const std::string & uri)
 {
   return rcpputils::fs::exists(rcpputils::fs::path(get_metadata_file_name(uri)));
@@ -80,4 +166,126 @@ BagMetadata MetadataIo::deserialize_metadata(const std::string & serialized_meta
   return yaml.as<BagMetadata>();
 }
 
+std::string MetadataIo::get_metadata_journal_file_name(const std::string & uri)
+{
+  return (rcpputils::fs::path(uri) / metadata_journal_filename).string();
+}
+
+void MetadataIo::append_to_metadata_journal(
+  const std::string & uri, const BagMetadata & file_metadata)
+{
+  std::ofstream fout(get_metadata_journal_file_name(uri), std::ios::app);
+  if (!fout) {
+    throw std::runtime_error("Failed to open metadata journal of bag " + uri);
+  }
+  // Serialized before writing, so that a failure does not leave a partial entry behind
+  const std::string entry = "---\n" + serialize_metadata(file_metadata) + "\n" +
+    kJournalEntryEnd + "\n";
+  fout << entry;
+  fout.flush();
+  if (!fout) {
+    throw std::runtime_error("Failed to append to metadata journal of bag " + uri);
+  }
+}
+
+std::vector<BagMetadata> MetadataIo::read_metadata_journal(const std::string & uri)
+{
+  std::vector<BagMetadata> entries;
+  std::ifstream fin(get_metadata_journal_file_name(uri));
+  std::string line;
+  std::string entry;
+  while (std::getline(fin, line)) {
+    if (line != kJournalEntryEnd) {
+      entry += line + "\n";
+      continue;
+    }
+    try {
+      entries.push_back(deserialize_metadata(entry));
+    } catch (const YAML::Exception &) {
+      break;
+    }
+    entry.clear();
+  }
+  return entries;
+}
+
+std::string MetadataIo::get_topic_statistics_file_name(const std::string & uri)
+{
+  return (rcpputils::fs::path(uri) / topic_statistics_filename).string();
+}
+
+void MetadataIo::write_topic_statistics(
+  const std::string & uri, const std::vector<TopicStatistics> & statistics)
+{
+  YAML::Node node;
+  node["version"] = kTopicStatisticsVersion;
+  node["topic_name"] = statistics_column<std::string>(statistics, &TopicStatistics::topic_name);
+  node["message_count"] = statistics_column<uint64_t>(
+    statistics, &TopicStatistics::message_count);
+  node["min_timestamp"] = statistics_column<int64_t>(
+    statistics, &TopicStatistics::min_timestamp);
+  node["max_timestamp"] = statistics_column<int64_t>(
+    statistics, &TopicStatistics::max_timestamp);
+  node["total_bytes"] = statistics_column<uint64_t>(statistics, &TopicStatistics::total_bytes);
+  node["min_message_size"] = statistics_column<uint64_t>(
+    statistics, &TopicStatistics::min_message_size);
+  node["max_message_size"] = statistics_column<uint64_t>(
+    statistics, &TopicStatistics::max_message_size);
+  node["gap_count"] = statistics_column<uint64_t>(statistics, &TopicStatistics::gap_count);
+  YAML::Node histograms(YAML::NodeType::Sequence);
+  for (const auto & topic : statistics) {
+    YAML::Node histogram(topic.interval_histogram);
+    histogram.SetStyle(YAML::EmitterStyle::Flow);
+    histograms.push_back(histogram);
+  }
+  node["interval_histogram"] = histograms;
+
+  std::ofstream fout(get_topic_statistics_file_name(uri));
+  fout << node;
+  if (!fout) {
+    throw std::runtime_error("Failed to write topic statistics of bag " + uri);
+  }
+}
+
+std::vector<TopicStatistics> MetadataIo::read_topic_statistics(const std::string & uri)
+{
+  const auto file_name = get_topic_statistics_file_name(uri);
+  if (!rcpputils::fs::exists(rcpputils::fs::path(file_name))) {
+    return {};
+  }
+  try {
+    YAML::Node node = YAML::LoadFile(file_name);
+    if (node["version"].as<int>() > kTopicStatisticsVersion) {
+      throw std::runtime_error("Unsupported version of topic statistics file " + file_name);
+    }
+    std::vector<TopicStatistics> statistics(node["topic_name"].size());
+    read_statistics_column<std::string>(
+      node, "topic_name", statistics, &TopicStatistics::topic_name);
+    read_statistics_column<uint64_t>(
+      node, "message_count", statistics, &TopicStatistics::message_count);
+    read_statistics_column<int64_t>(
+      node, "min_timestamp", statistics, &TopicStatistics::min_timestamp);
+    read_statistics_column<int64_t>(
+      node, "max_timestamp", statistics, &TopicStatistics::max_timestamp);
+    read_statistics_column<uint64_t>(
+      node, "total_bytes", statistics, &TopicStatistics::total_bytes);
+    read_statistics_column<uint64_t>(
+      node, "min_message_size", statistics, &TopicStatistics::min_message_size);
+    read_statistics_column<uint64_t>(
+      node, "max_message_size", statistics, &TopicStatistics::max_message_size);
+    read_statistics_column<uint64_t>(
+      node, "gap_count", statistics, &TopicStatistics::gap_count);
+    read_statistics_column<std::vector<uint64_t>>(
+      node, "interval_histogram", statistics, &TopicStatistics::interval_histogram);
+    return statistics;
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error(std::string("Exception on parsing topic statistics: ") + ex.what());
+  }
+}
+
+void MetadataIo::remove_metadata_journal(const std::string & uri)
+{
+  rcpputils::fs::remove(rcpputils::fs::path(get_metadata_journal_file_name(uri)));
+}
+
 }  // namespace rosbag2_storage
@@ -0,0 +1,61 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/read_estimate.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rosbag2_storage/topic_filter.hpp"
+
+namespace rosbag2_storage
+{
+
+ReadEstimate estimate_from_metadata(
+  const BagMetadata & metadata, const StorageFilter & storage_filter)
+{
+  TopicFilter topic_filter(storage_filter);
+  uint64_t selected_messages = 0;
+  for (const auto & topic : metadata.topics_with_message_count) {
+    if (topic_filter.matches(topic.topic_metadata.name)) {
+      selected_messages += topic.message_count;
+    }
+  }
+
+  // Fraction of the duration of the bag in the time range of the filter
+  const int64_t bag_start = metadata.starting_time.time_since_epoch().count();
+  const int64_t bag_end = bag_start + metadata.duration.count();
+  const int64_t start = storage_filter.start_time_ns >= 0 ?
+    std::max(storage_filter.start_time_ns, bag_start) : bag_start;
+  const int64_t end = storage_filter.end_time_ns >= 0 ?
+    std::min(storage_filter.end_time_ns, bag_end) : bag_end;
+  double fraction = 0.0;
+  if (end >= start) {
+    fraction = bag_end > bag_start ?
+      static_cast<double>(end - start) / static_cast<double>(bag_end - bag_start) : 1.0;
+  }
+
+  ReadEstimate estimate;
+  estimate.message_count =
+    static_cast<uint64_t>(std::llround(static_cast<double>(selected_messages) * fraction));
+  if (metadata.message_count > 0) {
+    estimate.bytes = static_cast<uint64_t>(
+      static_cast<double>(metadata.bag_size) * static_cast<double>(estimate.message_count) /
+      static_cast<double>(metadata.message_count));
+  }
+  estimate.exact = false;
+  return estimate;
+}
+
+}  // namespace rosbag2_storage
@@ -0,0 +1,77 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+
+#include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
+
+namespace rosbag2_storage
+{
+namespace storage_interfaces
+{
+
+TimeIndex ReadOnlyInterface::get_time_index()
+{
+  return TimeIndex();
+}
+
+ReadEstimate ReadOnlyInterface::estimate(const StorageFilter & storage_filter)
+{
+  auto metadata = get_metadata();
+  if (metadata.bag_size == 0) {
+    metadata.bag_size = get_bagfile_size();
+  }
+  return estimate_from_metadata(metadata, storage_filter);
+}
+
+bool ReadOnlyInterface::refresh()
+{
+  return false;
+}
+
+FileVerification ReadOnlyInterface::verify()
+{
+  FileVerification verification;
+  rcutils_time_point_value_t last_time_stamp = 0;
+  try {
+    reset_filter();
+    while (has_next()) {
+      auto message = read_next();
+      ++verification.topic_message_counts[message->topic_name];
+      last_time_stamp = message->time_stamp;
+    }
+  } catch (const std::exception & e) {
+    // The messages after the last one read are lost
+    IntegrityProblem problem;
+    problem.description = std::string("Reading failed: ") + e.what();
+    problem.start_time = last_time_stamp;
+    problem.end_time = last_time_stamp;
+    try {
+      const auto metadata = get_metadata();
+      problem.end_time = std::max(
+        last_time_stamp,
+        metadata.starting_time.time_since_epoch().count() + metadata.duration.count());
+    } catch (const std::exception &) {
+      // Without metadata the end of the lost messages is unknown
+    }
+    verification.problems.push_back(std::move(problem));
+  }
+  return verification;
+}
+
+}  // namespace storage_interfaces
+}  // namespace rosbag2_storage
@@ -0,0 +1,32 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <optional>
+#include <string>
+
+#include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+
+namespace rosbag2_storage
+{
+namespace storage_interfaces
+{
+
+std::optional<BagMetadata> ReadWriteInterface::copy_file(
+  const std::string & /* uri */, const StorageFilter & /* storage_filter */)
+{
+  return std::nullopt;
+}
+
+}  // namespace storage_interfaces
+}  // namespace rosbag2_storage
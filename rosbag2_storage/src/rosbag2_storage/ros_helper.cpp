@@ -14,8 +14,11 @@
 
 #include "rosbag2_storage/ros_helper.hpp"
 
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "rcutils/types.h"
 #include "rosbag2_storage/logging.hpp"
@@ -23,33 +26,29 @@
 namespace rosbag2_storage
 {
 
-static rcutils_allocator_t allocator = rcutils_get_default_allocator();
-
-std::shared_ptr<rcutils_uint8_array_t>
-make_serialized_message(const void * data, size_t size)
+namespace
 {
-  auto serialized_message = make_empty_serialized_message(size);
-  memcpy(serialized_message->buffer, data, size);
-  serialized_message->buffer_length = size;
-
-  return serialized_message;
-}
+rcutils_allocator_t default_allocator = rcutils_get_default_allocator();
+std::shared_ptr<BufferPool> global_buffer_pool;
 
 std::shared_ptr<rcutils_uint8_array_t>
-make_empty_serialized_message(size_t size)
+make_empty_serialized_message_impl(
+  size_t size, rcutils_allocator_t allocator, std::shared_ptr<BufferPool> pool)
 {
   auto msg = new rcutils_uint8_array_t;
   *msg = rcutils_get_zero_initialized_uint8_array();
   auto ret = rcutils_uint8_array_init(msg, size, &allocator);
   if (ret != RCUTILS_RET_OK) {
+    delete msg;
     throw std::runtime_error(
             "Error allocating resources for serialized message: " +
             std::string(rcutils_get_error_string().str));
   }
 
+  // Capturing the pool keeps it alive as long as it still owns the buffer of this message.
   auto serialized_message = std::shared_ptr<rcutils_uint8_array_t>(
     msg,
-    [](rcutils_uint8_array_t * msg) {
+    [pool = std::move(pool)](rcutils_uint8_array_t * msg) {
       int error = rcutils_uint8_array_fini(msg);
       delete msg;
       if (error != RCUTILS_RET_OK) {
@@ -60,5 +59,70 @@ make_empty_serialized_message(size_t size)
 
   return serialized_message;
 }
+}  // namespace
+
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_message(const void * data, size_t size)
+{
+  auto serialized_message = make_empty_serialized_message(size);
+  memcpy(serialized_message->buffer, data, size);
+  serialized_message->buffer_length = size;
+
+  return serialized_message;
+}
+
+std::shared_ptr<rcutils_uint8_array_t>
+make_empty_serialized_message(size_t size)
+{
+  auto pool = std::atomic_load(&global_buffer_pool);
+  if (pool) {
+    auto allocator = pool->get_allocator();
+    return make_empty_serialized_message_impl(size, allocator, std::move(pool));
+  }
+  return make_empty_serialized_message_impl(size, default_allocator, nullptr);
+}
+
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_message(const void * data, size_t size, rcutils_allocator_t allocator)
+{
+  auto serialized_message = make_empty_serialized_message(size, allocator);
+  memcpy(serialized_message->buffer, data, size);
+  serialized_message->buffer_length = size;
+
+  return serialized_message;
+}
+
+std::shared_ptr<rcutils_uint8_array_t>
+make_empty_serialized_message(size_t size, rcutils_allocator_t allocator)
+{
+  return make_empty_serialized_message_impl(size, allocator, nullptr);
+}
+
+std::shared_ptr<rcutils_uint8_array_t>
+make_serialized_message_view(const void * data, size_t size, std::shared_ptr<const void> owner)
+{
+  auto msg = new rcutils_uint8_array_t;
+  *msg = rcutils_get_zero_initialized_uint8_array();
+  msg->buffer = static_cast<uint8_t *>(const_cast<void *>(data));
+  msg->buffer_length = size;
+  msg->buffer_capacity = size;
+  // Copies of the message are allocated with this allocator, the payload itself is never freed
+  msg->allocator = default_allocator;
+  return std::shared_ptr<rcutils_uint8_array_t>(
+    msg,
+    [owner = std::move(owner)](rcutils_uint8_array_t * msg) {
+      delete msg;
+    });
+}
+
+void set_serialized_message_buffer_pool(std::shared_ptr<BufferPool> pool)
+{
+  std::atomic_store(&global_buffer_pool, std::move(pool));
+}
+
+std::shared_ptr<BufferPool> get_serialized_message_buffer_pool()
+{
+  return std::atomic_load(&global_buffer_pool);
+}
 
 }  // namespace rosbag2_storage
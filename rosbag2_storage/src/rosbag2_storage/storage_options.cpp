@@ -14,6 +14,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rosbag2_storage/storage_options.hpp"
 
@@ -35,6 +36,48 @@ Node convert<rosbag2_storage::StorageOptions>::encode(
   node["start_time_ns"] = storage_options.start_time_ns;
   node["end_time_ns"] = storage_options.end_time_ns;
   node["custom_data"] = storage_options.custom_data;
+  node["lock_free_cache"] = storage_options.lock_free_cache;
+  node["shard_cache_per_topic"] = storage_options.shard_cache_per_topic;
+  node["cache_topic_groups"] = storage_options.cache_topic_groups;
+  node["cache_shard_sizes"] = storage_options.cache_shard_sizes;
+  node["cache_shard_policies"] = storage_options.cache_shard_policies;
+  node["cache_topic_priorities"] = storage_options.cache_topic_priorities;
+  node["durability_interval_ms"] = storage_options.durability_interval_ms;
+  node["durability_bytes"] = storage_options.durability_bytes;
+  node["cache_overflow_policy"] = storage_options.cache_overflow_policy;
+  node["cache_block_timeout_ms"] = storage_options.cache_block_timeout_ms;
+  node["cache_spill_directory"] = storage_options.cache_spill_directory;
+  node["cache_spill_size"] = storage_options.cache_spill_size;
+  node["cache_min_batch_size"] = storage_options.cache_min_batch_size;
+  node["cache_max_batch_size"] = storage_options.cache_max_batch_size;
+  node["cache_max_batch_latency_ms"] = storage_options.cache_max_batch_latency_ms;
+  node["cache_adaptive_batching"] = storage_options.cache_adaptive_batching;
+  node["async_split"] = storage_options.async_split;
+  node["max_bag_retention_size"] = storage_options.max_bag_retention_size;
+  node["max_bag_retention_duration"] = storage_options.max_bag_retention_duration;
+  node["preallocate_bagfiles"] = storage_options.preallocate_bagfiles;
+  node["metadata_only"] = storage_options.metadata_only;
+  node["decompression_look_ahead_files"] = storage_options.decompression_look_ahead_files;
+  node["decompression_disk_budget"] = storage_options.decompression_disk_budget;
+  node["decompression_threads"] = storage_options.decompression_threads;
+  node["next_file_open_fraction"] = storage_options.next_file_open_fraction;
+  node["snapshot_duration_ms"] = storage_options.snapshot_duration_ms;
+  node["snapshot_post_trigger_duration_ms"] = storage_options.snapshot_post_trigger_duration_ms;
+  node["snapshot_contiguous_buffer"] = storage_options.snapshot_contiguous_buffer;
+  node["read_buffer_pool_size"] = storage_options.read_buffer_pool_size;
+  node["message_definition_cache_directory"] =
+    storage_options.message_definition_cache_directory;
+  node["message_definition_threads"] = storage_options.message_definition_threads;
+  node["cache_consumer_thread_policy"] = storage_options.cache_consumer_thread_policy;
+  node["cache_consumer_thread_priority"] = storage_options.cache_consumer_thread_priority;
+  node["cache_consumer_thread_cpus"] = storage_options.cache_consumer_thread_cpus;
+  node["deduplication_min_payload_size"] = storage_options.deduplication_min_payload_size;
+  node["deduplication_cache_size"] = storage_options.deduplication_cache_size;
+  node["delta_encoded_topics"] = storage_options.delta_encoded_topics;
+  node["delta_keyframe_interval"] = storage_options.delta_keyframe_interval;
+  node["preview_bucket_duration_ms"] = storage_options.preview_bucket_duration_ms;
+  node["preview_sample_topics"] = storage_options.preview_sample_topics;
+  node["preview_sample_interval"] = storage_options.preview_sample_interval;
   return node;
 }
 
@@ -54,6 +97,79 @@ bool convert<rosbag2_storage::StorageOptions>::decode(
   optional_assign<int64_t>(node, "end_time_ns", storage_options.end_time_ns);
   using KEY_VALUE_MAP = std::unordered_map<std::string, std::string>;
   optional_assign<KEY_VALUE_MAP>(node, "custom_data", storage_options.custom_data);
+  optional_assign<bool>(node, "lock_free_cache", storage_options.lock_free_cache);
+  optional_assign<bool>(node, "shard_cache_per_topic", storage_options.shard_cache_per_topic);
+  using TOPIC_GROUPS_MAP = std::unordered_map<std::string, std::vector<std::string>>;
+  optional_assign<TOPIC_GROUPS_MAP>(
+    node, "cache_topic_groups", storage_options.cache_topic_groups);
+  using SHARD_SIZES_MAP = std::unordered_map<std::string, uint64_t>;
+  optional_assign<SHARD_SIZES_MAP>(node, "cache_shard_sizes", storage_options.cache_shard_sizes);
+  optional_assign<KEY_VALUE_MAP>(
+    node, "cache_shard_policies", storage_options.cache_shard_policies);
+  using TOPIC_PRIORITIES_MAP = std::unordered_map<std::string, uint32_t>;
+  optional_assign<TOPIC_PRIORITIES_MAP>(
+    node, "cache_topic_priorities", storage_options.cache_topic_priorities);
+  optional_assign<uint64_t>(
+    node, "durability_interval_ms", storage_options.durability_interval_ms);
+  optional_assign<uint64_t>(node, "durability_bytes", storage_options.durability_bytes);
+  optional_assign<std::string>(
+    node, "cache_overflow_policy", storage_options.cache_overflow_policy);
+  optional_assign<uint64_t>(
+    node, "cache_block_timeout_ms", storage_options.cache_block_timeout_ms);
+  optional_assign<std::string>(
+    node, "cache_spill_directory", storage_options.cache_spill_directory);
+  optional_assign<uint64_t>(node, "cache_spill_size", storage_options.cache_spill_size);
+  optional_assign<uint64_t>(node, "cache_min_batch_size", storage_options.cache_min_batch_size);
+  optional_assign<uint64_t>(node, "cache_max_batch_size", storage_options.cache_max_batch_size);
+  optional_assign<uint64_t>(
+    node, "cache_max_batch_latency_ms", storage_options.cache_max_batch_latency_ms);
+  optional_assign<bool>(
+    node, "cache_adaptive_batching", storage_options.cache_adaptive_batching);
+  optional_assign<bool>(node, "async_split", storage_options.async_split);
+  optional_assign<uint64_t>(
+    node, "max_bag_retention_size", storage_options.max_bag_retention_size);
+  optional_assign<uint64_t>(
+    node, "max_bag_retention_duration", storage_options.max_bag_retention_duration);
+  optional_assign<bool>(node, "preallocate_bagfiles", storage_options.preallocate_bagfiles);
+  optional_assign<bool>(node, "metadata_only", storage_options.metadata_only);
+  optional_assign<uint64_t>(
+    node, "decompression_look_ahead_files", storage_options.decompression_look_ahead_files);
+  optional_assign<uint64_t>(
+    node, "decompression_disk_budget", storage_options.decompression_disk_budget);
+  optional_assign<uint64_t>(node, "decompression_threads", storage_options.decompression_threads);
+  optional_assign<double>(
+    node, "next_file_open_fraction", storage_options.next_file_open_fraction);
+  optional_assign<uint64_t>(node, "snapshot_duration_ms", storage_options.snapshot_duration_ms);
+  optional_assign<uint64_t>(
+    node, "snapshot_post_trigger_duration_ms", storage_options.snapshot_post_trigger_duration_ms);
+  optional_assign<bool>(
+    node, "snapshot_contiguous_buffer", storage_options.snapshot_contiguous_buffer);
+  optional_assign<uint64_t>(node, "read_buffer_pool_size", storage_options.read_buffer_pool_size);
+  optional_assign<std::string>(
+    node, "message_definition_cache_directory",
+    storage_options.message_definition_cache_directory);
+  optional_assign<uint64_t>(
+    node, "message_definition_threads", storage_options.message_definition_threads);
+  optional_assign<std::string>(
+    node, "cache_consumer_thread_policy", storage_options.cache_consumer_thread_policy);
+  optional_assign<int32_t>(
+    node, "cache_consumer_thread_priority", storage_options.cache_consumer_thread_priority);
+  optional_assign<std::vector<uint64_t>>(
+    node, "cache_consumer_thread_cpus", storage_options.cache_consumer_thread_cpus);
+  optional_assign<uint64_t>(
+    node, "deduplication_min_payload_size", storage_options.deduplication_min_payload_size);
+  optional_assign<uint64_t>(
+    node, "deduplication_cache_size", storage_options.deduplication_cache_size);
+  optional_assign<std::vector<std::string>>(
+    node, "delta_encoded_topics", storage_options.delta_encoded_topics);
+  optional_assign<uint64_t>(
+    node, "delta_keyframe_interval", storage_options.delta_keyframe_interval);
+  optional_assign<uint64_t>(
+    node, "preview_bucket_duration_ms", storage_options.preview_bucket_duration_ms);
+  optional_assign<std::vector<std::string>>(
+    node, "preview_sample_topics", storage_options.preview_sample_topics);
+  optional_assign<uint64_t>(
+    node, "preview_sample_interval", storage_options.preview_sample_interval);
   return true;
 }
 
@@ -0,0 +1,95 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/time_index.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rosbag2_storage
+{
+
+TimeIndex::TimeIndex(rcutils_duration_value_t interval)
+: interval_(interval)
+{}
+
+void TimeIndex::add_message(rcutils_time_point_value_t timestamp, uint64_t position)
+{
+  if (has_messages_ && max_timestamp_ < std::numeric_limits<rcutils_time_point_value_t>::max() &&
+    (entries_.empty() || max_timestamp_ - entries_.back().timestamp >= interval_))
+  {
+    // All messages before this one are older than the entry
+    entries_.push_back({max_timestamp_ + 1, position});
+  }
+  max_timestamp_ = std::max(max_timestamp_, timestamp);
+  has_messages_ = true;
+}
+
+std::optional<uint64_t> TimeIndex::find_start_position(
+  rcutils_time_point_value_t timestamp) const
+{
+  auto entry = std::upper_bound(
+    entries_.begin(), entries_.end(), timestamp,
+    [](rcutils_time_point_value_t t, const TimeIndexEntry & e) {return t < e.timestamp;});
+  if (entry == entries_.begin()) {
+    return std::nullopt;
+  }
+  return std::prev(entry)->position;
+}
+
+const std::vector<TimeIndexEntry> & TimeIndex::entries() const
+{
+  return entries_;
+}
+
+bool TimeIndex::empty() const
+{
+  return entries_.empty();
+}
+
+std::string TimeIndex::serialize() const
+{
+  std::stringstream out;
+  for (const auto & entry : entries_) {
+    out << entry.timestamp << " " << entry.position << "\n";
+  }
+  return out.str();
+}
+
+TimeIndex TimeIndex::deserialize(const std::string & serialized_index)
+{
+  TimeIndex index;
+  std::istringstream in(serialized_index);
+  TimeIndexEntry entry{};
+  while (in >> entry.timestamp >> entry.position) {
+    if (!index.entries_.empty() &&
+      (entry.timestamp <= index.entries_.back().timestamp ||
+      entry.position < index.entries_.back().position))
+    {
+      throw std::runtime_error("Entries of time index are not in order");
+    }
+    index.entries_.push_back(entry);
+  }
+  if (!in.eof()) {
+    throw std::runtime_error("Malformed time index");
+  }
+  return index;
+}
+
+}  // namespace rosbag2_storage
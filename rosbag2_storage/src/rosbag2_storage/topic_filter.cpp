@@ -0,0 +1,70 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/topic_filter.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace rosbag2_storage
+{
+
+TopicFilter::TopicFilter(const StorageFilter & storage_filter, std::regex::flag_type syntax)
+: topics_(storage_filter.topics.begin(), storage_filter.topics.end())
+{
+  if (!storage_filter.topics_regex.empty()) {
+    topics_regex_.emplace(storage_filter.topics_regex, syntax | std::regex::nosubs);
+  }
+  if (!storage_filter.topics_regex_to_exclude.empty()) {
+    topics_regex_to_exclude_.emplace(
+      storage_filter.topics_regex_to_exclude, syntax | std::regex::nosubs);
+  }
+}
+
+bool TopicFilter::selects_all() const
+{
+  return topics_.empty() && !topics_regex_ && !topics_regex_to_exclude_;
+}
+
+bool TopicFilter::matches(std::string_view topic_name) const
+{
+  if (selects_all()) {
+    return true;
+  }
+  const auto result_it = results_.find(topic_name);
+  if (result_it != results_.end()) {
+    return result_it->second;
+  }
+  std::string name(topic_name);
+  const bool result = evaluate(name);
+  results_.emplace(std::move(name), result);
+  return result;
+}
+
+bool TopicFilter::evaluate(const std::string & topic_name) const
+{
+  if (!topics_.empty() && topics_.count(topic_name) == 0) {
+    return false;
+  }
+  if (topics_regex_ && !std::regex_match(topic_name, *topics_regex_)) {
+    return false;
+  }
+  if (topics_regex_to_exclude_ && std::regex_match(topic_name, *topics_regex_to_exclude_)) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace rosbag2_storage
@@ -0,0 +1,57 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage/topic_statistics.hpp"
+
+#include <algorithm>
+
+namespace rosbag2_storage
+{
+
+void TopicStatistics::add_message(rcutils_time_point_value_t timestamp, uint64_t size)
+{
+  if (message_count > 0 && timestamp >= last_timestamp) {
+    const auto interval = timestamp - last_timestamp;
+    ++interval_histogram[interval_histogram_bucket(interval)];
+    // Mean interval of the messages so far, only defined once there are two of them
+    if (message_count > 1 && max_timestamp > min_timestamp) {
+      const auto mean_interval =
+        (max_timestamp - min_timestamp) / static_cast<int64_t>(message_count - 1);
+      if (interval > gap_factor * mean_interval) {
+        ++gap_count;
+      }
+    }
+  }
+  ++message_count;
+  last_timestamp = timestamp;
+  min_timestamp = std::min(min_timestamp, timestamp);
+  max_timestamp = std::max(max_timestamp, timestamp);
+  total_bytes += size;
+  min_message_size = std::min(min_message_size, size);
+  max_message_size = std::max(max_message_size, size);
+}
+
+size_t TopicStatistics::interval_histogram_bucket(rcutils_duration_value_t interval)
+{
+  constexpr rcutils_duration_value_t ns_per_ms = 1000 * 1000;
+  size_t bucket = 0;
+  for (auto bound = ns_per_ms; interval >= bound && bucket + 1 < interval_histogram_size;
+    bound *= 2)
+  {
+    ++bucket;
+  }
+  return bucket;
+}
+
+}  // namespace rosbag2_storage
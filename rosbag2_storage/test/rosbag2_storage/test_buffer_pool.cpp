@@ -0,0 +1,127 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "rosbag2_storage/buffer_pool.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage::BufferPool;
+
+TEST(buffer_pool, sizes_are_rounded_up_to_size_classes) {
+  EXPECT_EQ(BufferPool::get_size_class_capacity(0), BufferPool::kMinSizeClassBytes);
+  EXPECT_EQ(BufferPool::get_size_class_capacity(1), BufferPool::kMinSizeClassBytes);
+  EXPECT_EQ(BufferPool::get_size_class_capacity(257), 512u);
+  EXPECT_EQ(BufferPool::get_size_class_capacity(4096), 4096u);
+  const size_t oversized = BufferPool::kMaxSizeClassBytes + 1;
+  EXPECT_EQ(BufferPool::get_size_class_capacity(oversized), oversized);
+}
+
+TEST(buffer_pool, released_buffers_are_reused) {
+  BufferPool pool;
+  void * first = pool.allocate(1000);
+  ASSERT_NE(first, nullptr);
+  pool.deallocate(first);
+  EXPECT_EQ(pool.get_cached_bytes(), 1024u);
+
+  void * second = pool.allocate(900);
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(pool.get_cached_bytes(), 0u);
+  pool.deallocate(second);
+}
+
+TEST(buffer_pool, cached_bytes_are_bounded) {
+  BufferPool pool(1024);
+  void * first = pool.allocate(1024);
+  void * second = pool.allocate(1024);
+  pool.deallocate(first);
+  pool.deallocate(second);
+  EXPECT_EQ(pool.get_cached_bytes(), 1024u);
+
+  pool.release_cached_buffers();
+  EXPECT_EQ(pool.get_cached_bytes(), 0u);
+}
+
+TEST(buffer_pool, reallocate_keeps_content) {
+  BufferPool pool;
+  auto data = static_cast<char *>(pool.allocate(16));
+  std::strcpy(data, "rosbag2");  // NOLINT
+  // Growing within the size class keeps the buffer
+  EXPECT_EQ(pool.reallocate(data, 200), data);
+
+  auto grown = static_cast<char *>(pool.reallocate(data, 10000));
+  ASSERT_NE(grown, nullptr);
+  EXPECT_STREQ(grown, "rosbag2");
+  pool.deallocate(grown);
+}
+
+TEST(buffer_pool, serialized_messages_can_be_allocated_from_pool) {
+  auto pool = std::make_shared<BufferPool>();
+  rosbag2_storage::set_serialized_message_buffer_pool(pool);
+
+  std::string content = "Hello";
+  auto message = rosbag2_storage::make_serialized_message(content.c_str(), content.length());
+  ASSERT_THAT(message->buffer_length, Eq(content.length()));
+  EXPECT_EQ(
+    std::string(reinterpret_cast<char *>(message->buffer), message->buffer_length), content);
+  EXPECT_EQ(message->allocator.state, pool.get());
+
+  const uint8_t * buffer = message->buffer;
+  message.reset();
+  EXPECT_GT(pool->get_cached_bytes(), 0u);
+
+  auto reused = rosbag2_storage::make_empty_serialized_message(content.length());
+  EXPECT_EQ(reused->buffer, buffer);
+
+  rosbag2_storage::set_serialized_message_buffer_pool(nullptr);
+  // Messages keep their pool alive after it was uninstalled
+  pool.reset();
+  reused.reset();
+}
+
+TEST(buffer_pool, buffers_are_carved_from_the_arena_first) {
+  BufferPool::ArenaOptions arena_options;
+  arena_options.size = 4096;
+  BufferPool pool(0, arena_options);
+  void * in_arena = pool.allocate(1000);
+  ASSERT_NE(in_arena, nullptr);
+  std::memset(in_arena, 1, 1000);
+  EXPECT_GE(pool.get_arena_used_bytes(), 1024u);
+
+  // Buffers of the arena are kept regardless of max_cached_bytes and release_cached_buffers()
+  pool.deallocate(in_arena);
+  pool.release_cached_buffers();
+  EXPECT_EQ(pool.get_cached_bytes(), 0u);
+  EXPECT_EQ(pool.allocate(900), in_arena);
+  pool.deallocate(in_arena);
+}
+
+TEST(buffer_pool, falls_back_to_the_system_allocator_when_the_arena_is_used_up) {
+  BufferPool::ArenaOptions arena_options;
+  arena_options.size = 1;
+  arena_options.huge_pages = false;
+  BufferPool pool(BufferPool::kDefaultMaxCachedBytes, arena_options);
+  // Larger than the arena, even rounded up to a huge page
+  const size_t size = 4 * 1024 * 1024;
+  void * buffer = pool.allocate(size);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(pool.get_arena_used_bytes(), 0u);
+  pool.deallocate(buffer);
+  EXPECT_EQ(pool.get_cached_bytes(), size);
+}
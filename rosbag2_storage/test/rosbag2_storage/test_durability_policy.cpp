@@ -0,0 +1,57 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+
+#include "rosbag2_storage/durability_policy.hpp"
+
+using namespace ::testing;  // NOLINT
+using namespace std::chrono_literals;  // NOLINT
+using rosbag2_storage::DurabilityPolicy;
+
+TEST(durability_policy, disabled_policy_is_never_due) {
+  DurabilityPolicy policy(0, 0);
+  EXPECT_FALSE(policy.enabled());
+  const auto start = DurabilityPolicy::clock::time_point{};
+  policy.add_written_bytes(1u << 30, start);
+  EXPECT_FALSE(policy.is_due(start + 1h));
+}
+
+TEST(durability_policy, due_after_bytes_limit) {
+  DurabilityPolicy policy(0, 100);
+  EXPECT_TRUE(policy.enabled());
+  const auto start = DurabilityPolicy::clock::time_point{};
+  policy.add_written_bytes(60, start);
+  EXPECT_FALSE(policy.is_due(start));
+  policy.add_written_bytes(40, start);
+  EXPECT_TRUE(policy.is_due(start));
+  policy.committed();
+  EXPECT_FALSE(policy.is_due(start));
+}
+
+TEST(durability_policy, interval_counts_from_first_pending_write) {
+  DurabilityPolicy policy(50, 0);
+  const auto start = DurabilityPolicy::clock::time_point{} + 1h;
+  EXPECT_FALSE(policy.is_due(start + 1s));
+  policy.add_written_bytes(1, start);
+  policy.add_written_bytes(1, start + 40ms);
+  EXPECT_FALSE(policy.is_due(start + 49ms));
+  EXPECT_TRUE(policy.is_due(start + 50ms));
+  policy.committed();
+  policy.add_written_bytes(1, start + 60ms);
+  EXPECT_FALSE(policy.is_due(start + 100ms));
+  EXPECT_TRUE(policy.is_due(start + 110ms));
+}
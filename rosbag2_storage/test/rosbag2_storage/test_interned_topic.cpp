@@ -0,0 +1,52 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_storage/interned_topic.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage::intern_topic;
+using rosbag2_storage::InternedTopic;
+
+TEST(interned_topic, same_name_returns_same_record) {
+  const InternedTopic & first = intern_topic("/interned_topic/a");
+  const InternedTopic & second = intern_topic(std::string("/interned_topic/") + "a");
+  EXPECT_EQ(&first, &second);
+  EXPECT_EQ(first.name, "/interned_topic/a");
+}
+
+TEST(interned_topic, different_names_get_consecutive_ids) {
+  const InternedTopic & first = intern_topic("/interned_topic/first");
+  const InternedTopic & second = intern_topic("/interned_topic/second");
+  EXPECT_NE(&first, &second);
+  EXPECT_EQ(second.id, first.id + 1);
+  EXPECT_EQ(second.name, "/interned_topic/second");
+}
+
+TEST(interned_topic, concurrent_interning_returns_one_record_per_name) {
+  std::vector<const InternedTopic *> records(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < records.size(); ++i) {
+    threads.emplace_back([&records, i]() {records[i] = &intern_topic("/interned_topic/shared");});
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_THAT(records, Each(Eq(records.front())));
+}
@@ -17,6 +17,7 @@
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -25,9 +26,12 @@
 # include <Windows.h>
 #endif
 
+#include "rcpputils/filesystem_helper.hpp"
+
 #include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage/default_storage_id.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/topic_statistics.hpp"
 #include "rosbag2_test_common/temporary_directory_fixture.hpp"
 
 using namespace ::testing;  // NOLINT
@@ -167,3 +171,121 @@ TEST_F(MetadataFixture, metadata_reads_v7_topic_type_hash)
   auto actual_first_topic = read_metadata.topics_with_message_count[0];
   EXPECT_THAT(actual_first_topic.topic_metadata.type_description_hash, Eq(type_description_hash));
 }
+
+TEST_F(MetadataFixture, binary_metadata_is_read_only_while_it_matches_the_metadata_file)
+{
+  BagMetadata metadata{};
+  metadata.storage_identifier = get_default_storage_id();
+  metadata.duration = std::chrono::nanoseconds(100);
+  metadata.message_count = 3;
+  metadata.topics_with_message_count.push_back({{"topic1", "type1", "rmw1", {}, "hash1"}, 3});
+  for (int i = 0; i < 3; ++i) {
+    const std::string path = "bag_" + std::to_string(i) + ".db3";
+    metadata.relative_file_paths.push_back(path);
+    metadata.files.push_back(
+      {path, std::chrono::time_point<std::chrono::high_resolution_clock>(
+          std::chrono::nanoseconds(i * 10)), std::chrono::nanoseconds(10), 1});
+  }
+  metadata.custom_data["key"] = "value";
+  const auto binary_file =
+    rcpputils::fs::path(temporary_dir_path_) / MetadataIo::binary_metadata_filename;
+
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  ASSERT_TRUE(rcpputils::fs::exists(binary_file));
+  auto read_metadata = metadata_io_->read_metadata(temporary_dir_path_);
+  EXPECT_THAT(read_metadata.relative_file_paths, Eq(metadata.relative_file_paths));
+  ASSERT_THAT(read_metadata.files, SizeIs(3));
+  EXPECT_THAT(read_metadata.files[2].starting_time, Eq(metadata.files[2].starting_time));
+  EXPECT_THAT(read_metadata.files[2].window_start_time_ns, Eq(-1));
+  ASSERT_THAT(read_metadata.topics_with_message_count, SizeIs(1));
+  EXPECT_THAT(
+    read_metadata.topics_with_message_count[0].topic_metadata.type_description_hash,
+    Eq("hash1"));
+  EXPECT_THAT(read_metadata.custom_data, Eq(metadata.custom_data));
+
+  // An edited metadata file takes precedence over the binary metadata written before
+  metadata.message_count = 2;
+  const auto yaml = metadata_io_->serialize_metadata(metadata);
+  {
+    std::ofstream fout(
+      (rcpputils::fs::path(temporary_dir_path_) / MetadataIo::metadata_filename).string());
+    fout << "rosbag2_bagfile_information:\n";
+    std::istringstream lines(yaml);
+    for (std::string line; std::getline(lines, line); ) {
+      fout << "  " << line << "\n";
+    }
+  }
+  EXPECT_THAT(metadata_io_->read_metadata(temporary_dir_path_).message_count, Eq(2u));
+
+  // Older versions are read from the metadata file only
+  metadata.version = 6;
+  metadata_io_->write_metadata(temporary_dir_path_, metadata);
+  EXPECT_FALSE(rcpputils::fs::exists(binary_file));
+}
+
+TEST_F(MetadataFixture, metadata_journal_returns_completely_written_entries)
+{
+  EXPECT_THAT(metadata_io_->read_metadata_journal(temporary_dir_path_), IsEmpty());
+
+  for (size_t i = 0; i < 2; ++i) {
+    BagMetadata file_metadata{};
+    file_metadata.storage_identifier = get_default_storage_id();
+    file_metadata.relative_file_paths = {"bag_" + std::to_string(i) + ".db3"};
+    file_metadata.message_count = 10 + i;
+    file_metadata.topics_with_message_count.push_back(
+      {{"topic1", "type1", "rmw1", {}, ""}, 10 + i});
+    metadata_io_->append_to_metadata_journal(temporary_dir_path_, file_metadata);
+  }
+  {
+    // Entry of a recording which crashed while it was written
+    std::ofstream journal(
+      (rcpputils::fs::path(temporary_dir_path_) / MetadataIo::metadata_journal_filename).string(),
+      std::ios::app);
+    journal << "---\nversion: 9\nstorage_identifier: sqli";
+  }
+
+  const auto entries = metadata_io_->read_metadata_journal(temporary_dir_path_);
+  ASSERT_THAT(entries, SizeIs(2));
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_THAT(entries[i].relative_file_paths, ElementsAre("bag_" + std::to_string(i) + ".db3"));
+    EXPECT_THAT(entries[i].message_count, Eq(10 + i));
+    ASSERT_THAT(entries[i].topics_with_message_count, SizeIs(1));
+    EXPECT_THAT(entries[i].topics_with_message_count[0].message_count, Eq(10 + i));
+  }
+
+  metadata_io_->remove_metadata_journal(temporary_dir_path_);
+  EXPECT_THAT(metadata_io_->read_metadata_journal(temporary_dir_path_), IsEmpty());
+}
+
+TEST_F(MetadataFixture, topic_statistics_round_trip_by_column)
+{
+  EXPECT_THAT(metadata_io_->read_topic_statistics(temporary_dir_path_), IsEmpty());
+
+  TopicStatistics regular{};
+  regular.topic_name = "regular";
+  // 10 ms apart, the last interval is a gap
+  for (int64_t timestamp : {0, 10'000'000, 20'000'000, 30'000'000, 100'000'000}) {
+    regular.add_message(timestamp, 100 + timestamp / 10'000'000);
+  }
+  TopicStatistics empty{};
+  empty.topic_name = "empty";
+  metadata_io_->write_topic_statistics(temporary_dir_path_, {regular, empty});
+
+  const auto statistics = metadata_io_->read_topic_statistics(temporary_dir_path_);
+  ASSERT_THAT(statistics, SizeIs(2));
+  EXPECT_THAT(statistics[0].topic_name, Eq("regular"));
+  EXPECT_THAT(statistics[0].message_count, Eq(5u));
+  EXPECT_THAT(statistics[0].min_timestamp, Eq(0));
+  EXPECT_THAT(statistics[0].max_timestamp, Eq(100'000'000));
+  EXPECT_THAT(statistics[0].total_bytes, Eq(516u));
+  EXPECT_THAT(statistics[0].min_message_size, Eq(100u));
+  EXPECT_THAT(statistics[0].max_message_size, Eq(110u));
+  EXPECT_THAT(statistics[0].gap_count, Eq(1u));
+  ASSERT_THAT(
+    statistics[0].interval_histogram, SizeIs(TopicStatistics::interval_histogram_size));
+  // [8, 16) ms and [64, 128) ms
+  EXPECT_THAT(statistics[0].interval_histogram[4], Eq(3u));
+  EXPECT_THAT(statistics[0].interval_histogram[7], Eq(1u));
+  EXPECT_THAT(statistics[1].topic_name, Eq("empty"));
+  EXPECT_THAT(statistics[1].message_count, Eq(0u));
+}
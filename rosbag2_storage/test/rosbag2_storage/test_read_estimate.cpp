@@ -0,0 +1,84 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+
+#include "rosbag2_storage/read_estimate.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage::estimate_from_metadata;
+
+namespace
+{
+// 300 messages of 10 bytes over 100 ns, starting at 1000 ns
+rosbag2_storage::BagMetadata make_metadata()
+{
+  rosbag2_storage::BagMetadata metadata;
+  metadata.starting_time = std::chrono::time_point<std::chrono::high_resolution_clock>(
+    std::chrono::nanoseconds(1000));
+  metadata.duration = std::chrono::nanoseconds(100);
+  metadata.message_count = 300;
+  metadata.bag_size = 3000;
+  metadata.topics_with_message_count = {
+    {{"/a", "type", "cdr", {}, ""}, 100},
+    {{"/b", "type", "cdr", {}, ""}, 200},
+  };
+  return metadata;
+}
+}  // namespace
+
+TEST(read_estimate, selects_the_topics_of_the_filter) {
+  rosbag2_storage::StorageFilter filter;
+  auto estimate = estimate_from_metadata(make_metadata(), filter);
+  EXPECT_EQ(estimate.message_count, 300u);
+  EXPECT_EQ(estimate.bytes, 3000u);
+  EXPECT_FALSE(estimate.exact);
+
+  filter.topics = {"/b"};
+  estimate = estimate_from_metadata(make_metadata(), filter);
+  EXPECT_EQ(estimate.message_count, 200u);
+  EXPECT_EQ(estimate.bytes, 2000u);
+
+  filter.topics.clear();
+  filter.topics_regex_to_exclude = "/b";
+  EXPECT_EQ(estimate_from_metadata(make_metadata(), filter).message_count, 100u);
+}
+
+TEST(read_estimate, scales_with_the_time_range_of_the_filter) {
+  rosbag2_storage::StorageFilter filter;
+  filter.start_time_ns = 1050;
+  EXPECT_EQ(estimate_from_metadata(make_metadata(), filter).message_count, 150u);
+
+  filter.start_time_ns = 0;
+  filter.end_time_ns = 1025;
+  EXPECT_EQ(estimate_from_metadata(make_metadata(), filter).message_count, 75u);
+
+  filter.start_time_ns = 2000;
+  filter.end_time_ns = -1;
+  const auto estimate = estimate_from_metadata(make_metadata(), filter);
+  EXPECT_EQ(estimate.message_count, 0u);
+  EXPECT_EQ(estimate.bytes, 0u);
+}
+
+TEST(read_estimate, estimates_are_summed) {
+  rosbag2_storage::ReadEstimate estimate{10, 100, true};
+  estimate += rosbag2_storage::ReadEstimate{5, 50, true};
+  EXPECT_EQ(estimate.message_count, 15u);
+  EXPECT_EQ(estimate.bytes, 150u);
+  EXPECT_TRUE(estimate.exact);
+  estimate += rosbag2_storage::ReadEstimate{1, 1, false};
+  EXPECT_FALSE(estimate.exact);
+}
@@ -14,6 +14,7 @@
 
 #include <gmock/gmock.h>
 #include <memory>
+#include <vector>
 
 #include "rosbag2_storage/ros_helper.hpp"
 
@@ -41,3 +42,20 @@ TEST(ros_helper, make_empty_serialized_message_is_correctly_built) {
   ASSERT_THAT(empty_serialized_message->buffer_length, Eq(0u));
   ASSERT_THAT(empty_serialized_message->buffer_capacity, Eq(size));
 }
+
+TEST(ros_helper, make_serialized_message_view_refers_to_data_and_keeps_owner) {
+  auto owner = std::make_shared<std::vector<uint8_t>>(16, uint8_t{42});
+  std::weak_ptr<std::vector<uint8_t>> weak_owner = owner;
+
+  auto serialized_message = rosbag2_storage::make_serialized_message_view(
+    owner->data(), owner->size(), owner);
+  const uint8_t * data = owner->data();
+  owner.reset();
+
+  EXPECT_FALSE(weak_owner.expired());
+  EXPECT_EQ(serialized_message->buffer, data);
+  EXPECT_EQ(serialized_message->buffer_length, 16u);
+  EXPECT_EQ(serialized_message->buffer[15], 42);
+  serialized_message.reset();
+  EXPECT_TRUE(weak_owner.expired());
+}
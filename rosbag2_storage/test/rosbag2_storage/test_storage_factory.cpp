@@ -20,7 +20,9 @@
 #include "rosbag2_storage/storage_interfaces/read_only_interface.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 
+#include "rosbag2_storage/class_loader_cache.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_traits.hpp"
 
 #include "test_constants.hpp"
 
@@ -98,3 +100,20 @@ TEST_F(StorageFactoryTest, load_unavailable_plugin) {
     {bag_file_path, test_unavailable_plugin_id});
   EXPECT_EQ(nullptr, instance_ro);
 }
+
+TEST_F(StorageFactoryTest, factories_share_one_class_loader_per_interface) {
+  const auto class_loader = rosbag2_storage::get_cached_class_loader<ReadWriteInterface>(
+    "rosbag2_storage", rosbag2_storage::StorageTraits<ReadWriteInterface>::name);
+  ASSERT_NE(nullptr, class_loader);
+  EXPECT_EQ(
+    class_loader,
+    rosbag2_storage::get_cached_class_loader<ReadWriteInterface>(
+      "rosbag2_storage", rosbag2_storage::StorageTraits<ReadWriteInterface>::name));
+
+  // Factories created later load plugins through the cached class loader
+  rosbag2_storage::StorageFactory other_factory;
+  auto read_write_storage = other_factory.open_read_write(
+    {bag_file_path, test_constants::READ_WRITE_PLUGIN_IDENTIFIER});
+  ASSERT_NE(nullptr, read_write_storage);
+  EXPECT_TRUE(class_loader->isClassLoaded(test_constants::READ_WRITE_PLUGIN_IDENTIFIER));
+}
@@ -33,6 +33,50 @@ TEST(storage_options, test_yaml_serialization)
   original.end_time_ns = 23456000;
   original.custom_data["key1"] = "value1";
   original.custom_data["key2"] = "value2";
+  original.lock_free_cache = true;
+  original.shard_cache_per_topic = true;
+  original.cache_topic_groups["low_rate"] = {"/tf", "/diagnostics"};
+  original.cache_shard_sizes["/points"] = 400 * 1024 * 1024;
+  original.cache_shard_sizes["low_rate"] = 1024 * 1024;
+  original.cache_shard_policies["/points"] = "drop_oldest";
+  original.cache_shard_policies["low_rate"] = "block";
+  original.cache_topic_priorities["/cmd_vel"] = 10;
+  original.cache_topic_priorities["/debug/image"] = 0;
+  original.durability_interval_ms = 200;
+  original.durability_bytes = 16 * 1024 * 1024;
+  original.cache_overflow_policy = "block";
+  original.cache_block_timeout_ms = 250;
+  original.cache_spill_directory = "/mnt/scratch";
+  original.cache_spill_size = 4096;
+  original.cache_min_batch_size = 64 * 1024;
+  original.cache_max_batch_size = 8 * 1024 * 1024;
+  original.cache_max_batch_latency_ms = 50;
+  original.cache_adaptive_batching = true;
+  original.async_split = true;
+  original.max_bag_retention_size = 1024;
+  original.max_bag_retention_duration = 60;
+  original.preallocate_bagfiles = true;
+  original.metadata_only = true;
+  original.decompression_look_ahead_files = 2;
+  original.decompression_disk_budget = 4ull * 1024 * 1024 * 1024;
+  original.decompression_threads = 4;
+  original.next_file_open_fraction = 0.75;
+  original.snapshot_duration_ms = 30000;
+  original.snapshot_post_trigger_duration_ms = 5000;
+  original.snapshot_contiguous_buffer = true;
+  original.read_buffer_pool_size = 16 * 1024 * 1024;
+  original.message_definition_cache_directory = "/var/cache/rosbag2";
+  original.message_definition_threads = 4;
+  original.cache_consumer_thread_policy = "rr";
+  original.cache_consumer_thread_priority = 20;
+  original.cache_consumer_thread_cpus = {2, 3};
+  original.deduplication_min_payload_size = 4096;
+  original.deduplication_cache_size = 1024;
+  original.delta_encoded_topics = {"/map"};
+  original.delta_keyframe_interval = 5;
+  original.preview_bucket_duration_ms = 500;
+  original.preview_sample_topics = {"/camera/image_raw"};
+  original.preview_sample_interval = 30;
 
   auto node = YAML::convert<rosbag2_storage::StorageOptions>().encode(original);
 
@@ -53,4 +97,51 @@ TEST(storage_options, test_yaml_serialization)
   ASSERT_EQ(original.start_time_ns, reconstructed.start_time_ns);
   ASSERT_EQ(original.end_time_ns, reconstructed.end_time_ns);
   ASSERT_EQ(original.custom_data, reconstructed.custom_data);
+  ASSERT_EQ(original.lock_free_cache, reconstructed.lock_free_cache);
+  ASSERT_EQ(original.shard_cache_per_topic, reconstructed.shard_cache_per_topic);
+  ASSERT_EQ(original.cache_topic_groups, reconstructed.cache_topic_groups);
+  ASSERT_EQ(original.cache_shard_sizes, reconstructed.cache_shard_sizes);
+  ASSERT_EQ(original.cache_shard_policies, reconstructed.cache_shard_policies);
+  ASSERT_EQ(original.cache_topic_priorities, reconstructed.cache_topic_priorities);
+  ASSERT_EQ(original.durability_interval_ms, reconstructed.durability_interval_ms);
+  ASSERT_EQ(original.durability_bytes, reconstructed.durability_bytes);
+  ASSERT_EQ(original.cache_overflow_policy, reconstructed.cache_overflow_policy);
+  ASSERT_EQ(original.cache_block_timeout_ms, reconstructed.cache_block_timeout_ms);
+  ASSERT_EQ(original.cache_spill_directory, reconstructed.cache_spill_directory);
+  ASSERT_EQ(original.cache_spill_size, reconstructed.cache_spill_size);
+  ASSERT_EQ(original.cache_min_batch_size, reconstructed.cache_min_batch_size);
+  ASSERT_EQ(original.cache_max_batch_size, reconstructed.cache_max_batch_size);
+  ASSERT_EQ(original.cache_max_batch_latency_ms, reconstructed.cache_max_batch_latency_ms);
+  ASSERT_EQ(original.cache_adaptive_batching, reconstructed.cache_adaptive_batching);
+  ASSERT_EQ(original.async_split, reconstructed.async_split);
+  ASSERT_EQ(original.max_bag_retention_size, reconstructed.max_bag_retention_size);
+  ASSERT_EQ(original.max_bag_retention_duration, reconstructed.max_bag_retention_duration);
+  ASSERT_EQ(original.preallocate_bagfiles, reconstructed.preallocate_bagfiles);
+  ASSERT_EQ(original.metadata_only, reconstructed.metadata_only);
+  ASSERT_EQ(
+    original.decompression_look_ahead_files, reconstructed.decompression_look_ahead_files);
+  ASSERT_EQ(original.decompression_disk_budget, reconstructed.decompression_disk_budget);
+  ASSERT_EQ(original.decompression_threads, reconstructed.decompression_threads);
+  ASSERT_EQ(original.next_file_open_fraction, reconstructed.next_file_open_fraction);
+  ASSERT_EQ(original.snapshot_duration_ms, reconstructed.snapshot_duration_ms);
+  ASSERT_EQ(
+    original.snapshot_post_trigger_duration_ms, reconstructed.snapshot_post_trigger_duration_ms);
+  ASSERT_EQ(original.snapshot_contiguous_buffer, reconstructed.snapshot_contiguous_buffer);
+  ASSERT_EQ(original.read_buffer_pool_size, reconstructed.read_buffer_pool_size);
+  ASSERT_EQ(
+    original.message_definition_cache_directory,
+    reconstructed.message_definition_cache_directory);
+  ASSERT_EQ(original.message_definition_threads, reconstructed.message_definition_threads);
+  ASSERT_EQ(original.cache_consumer_thread_policy, reconstructed.cache_consumer_thread_policy);
+  ASSERT_EQ(
+    original.cache_consumer_thread_priority, reconstructed.cache_consumer_thread_priority);
+  ASSERT_EQ(original.cache_consumer_thread_cpus, reconstructed.cache_consumer_thread_cpus);
+  ASSERT_EQ(
+    original.deduplication_min_payload_size, reconstructed.deduplication_min_payload_size);
+  ASSERT_EQ(original.deduplication_cache_size, reconstructed.deduplication_cache_size);
+  ASSERT_EQ(original.delta_encoded_topics, reconstructed.delta_encoded_topics);
+  ASSERT_EQ(original.delta_keyframe_interval, reconstructed.delta_keyframe_interval);
+  ASSERT_EQ(original.preview_bucket_duration_ms, reconstructed.preview_bucket_duration_ms);
+  ASSERT_EQ(original.preview_sample_topics, reconstructed.preview_sample_topics);
+  ASSERT_EQ(original.preview_sample_interval, reconstructed.preview_sample_interval);
 }
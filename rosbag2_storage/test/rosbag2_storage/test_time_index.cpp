@@ -0,0 +1,69 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+#include "rosbag2_storage/time_index.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage::TimeIndex;
+
+TEST(time_index, records_an_entry_per_interval) {
+  TimeIndex index(10);
+  for (uint64_t i = 0; i < 10; ++i) {
+    // Messages 5 apart, stored 100 bytes apart
+    index.add_message(static_cast<rcutils_time_point_value_t>(5 * i), 100 * i);
+  }
+  ASSERT_THAT(index.entries(), SizeIs(3));
+  EXPECT_THAT(index.entries()[0].timestamp, Eq(1));
+  EXPECT_THAT(index.entries()[0].position, Eq(100u));
+  EXPECT_THAT(index.entries()[1].timestamp, Eq(16));
+  EXPECT_THAT(index.entries()[1].position, Eq(400u));
+  EXPECT_THAT(index.entries()[2].timestamp, Eq(31));
+  EXPECT_THAT(index.entries()[2].position, Eq(700u));
+
+  EXPECT_THAT(index.find_start_position(0), Eq(std::nullopt));
+  EXPECT_THAT(index.find_start_position(15), Eq(100u));
+  EXPECT_THAT(index.find_start_position(16), Eq(400u));
+  EXPECT_THAT(index.find_start_position(1000), Eq(700u));
+}
+
+TEST(time_index, does_not_skip_older_messages_written_late) {
+  TimeIndex index(10);
+  index.add_message(0, 0);
+  index.add_message(20, 100);
+  index.add_message(5, 200);
+  index.add_message(30, 300);
+  // The message at 5 is stored after the first entry, which covers timestamps from 1
+  ASSERT_THAT(index.entries(), Not(IsEmpty()));
+  EXPECT_THAT(index.find_start_position(5), Eq(100u));
+  EXPECT_THAT(index.find_start_position(21), Eq(200u));
+}
+
+TEST(time_index, round_trips_through_serialization) {
+  TimeIndex index(10);
+  for (uint64_t i = 0; i < 10; ++i) {
+    index.add_message(static_cast<rcutils_time_point_value_t>(5 * i), 100 * i);
+  }
+  const auto restored = TimeIndex::deserialize(index.serialize());
+  ASSERT_THAT(restored.entries(), SizeIs(index.entries().size()));
+  for (size_t i = 0; i < index.entries().size(); ++i) {
+    EXPECT_THAT(restored.entries()[i].timestamp, Eq(index.entries()[i].timestamp));
+    EXPECT_THAT(restored.entries()[i].position, Eq(index.entries()[i].position));
+  }
+  EXPECT_THROW(TimeIndex::deserialize("1 100\nnot an entry\n"), std::runtime_error);
+  EXPECT_THROW(TimeIndex::deserialize("10 100\n1 200\n"), std::runtime_error);
+}
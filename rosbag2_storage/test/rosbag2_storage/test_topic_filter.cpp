@@ -0,0 +1,82 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <regex>
+
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/topic_filter.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage::StorageFilter;
+using rosbag2_storage::TopicFilter;
+
+TEST(topic_filter, empty_filter_selects_all_topics) {
+  TopicFilter filter{StorageFilter{}};
+  EXPECT_TRUE(filter.selects_all());
+  EXPECT_TRUE(filter.matches("/any_topic"));
+  EXPECT_TRUE(TopicFilter{}.matches("/any_topic"));
+}
+
+TEST(topic_filter, selects_listed_topics) {
+  StorageFilter storage_filter;
+  storage_filter.topics = {"/a", "/b"};
+  TopicFilter filter(storage_filter);
+  EXPECT_FALSE(filter.selects_all());
+  EXPECT_TRUE(filter.matches("/a"));
+  EXPECT_TRUE(filter.matches("/b"));
+  EXPECT_FALSE(filter.matches("/c"));
+  EXPECT_FALSE(filter.matches("/a/b"));
+}
+
+TEST(topic_filter, regex_has_to_match_whole_topic_name) {
+  StorageFilter storage_filter;
+  storage_filter.topics_regex = "/camera/.*";
+  TopicFilter filter(storage_filter);
+  EXPECT_TRUE(filter.matches("/camera/image"));
+  EXPECT_FALSE(filter.matches("/front/camera/image"));
+}
+
+TEST(topic_filter, all_conditions_have_to_hold) {
+  StorageFilter storage_filter;
+  storage_filter.topics = {"/camera/image", "/camera/info", "/lidar"};
+  storage_filter.topics_regex = "/camera/.*";
+  storage_filter.topics_regex_to_exclude = ".*info";
+  TopicFilter filter(storage_filter);
+  EXPECT_TRUE(filter.matches("/camera/image"));
+  EXPECT_FALSE(filter.matches("/camera/info"));
+  EXPECT_FALSE(filter.matches("/lidar"));
+  EXPECT_FALSE(filter.matches("/camera/depth"));
+  // Results are remembered, evaluating again gives the same answers
+  EXPECT_TRUE(filter.matches("/camera/image"));
+  EXPECT_FALSE(filter.matches("/camera/info"));
+}
+
+TEST(topic_filter, excludes_topics_matching_exclude_regex) {
+  StorageFilter storage_filter;
+  storage_filter.topics_regex_to_exclude = "/tf.*";
+  TopicFilter filter(storage_filter);
+  EXPECT_FALSE(filter.matches("/tf"));
+  EXPECT_FALSE(filter.matches("/tf_static"));
+  EXPECT_TRUE(filter.matches("/odom"));
+}
+
+TEST(topic_filter, uses_requested_regex_grammar) {
+  StorageFilter storage_filter;
+  storage_filter.topics_regex = "/[[:alpha:]]+";
+  EXPECT_TRUE(TopicFilter(storage_filter, std::regex::extended).matches("/odom"));
+  storage_filter.topics_regex = "/(";
+  EXPECT_THROW(TopicFilter{storage_filter}, std::regex_error);
+}
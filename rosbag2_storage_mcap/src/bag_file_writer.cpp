@@ -0,0 +1,403 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bag_file_writer.hpp"
+
+#include "rcutils/logging_macros.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_LIBURING
+  #include <liburing.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+constexpr char LOG_NAME[] = "rosbag2_storage_mcap";
+
+// Direct I/O requires the buffer, the file offset and the length of every write to be aligned
+// to the logical block size of the device. 4 KiB covers the block size of common devices.
+constexpr size_t kAlignment = 4096;
+// Direct I/O bypasses the page cache, large writes keep the device busy
+constexpr size_t kDirectIOBufferSize = 4 * 1024 * 1024;
+// Buffered writes go through the page cache like those of mcap::FileWriter, whose stdio
+// buffer has this size
+constexpr size_t kBufferedBufferSize = BUFSIZ;
+
+std::byte * allocate_buffer(size_t size, bool aligned)
+{
+  return static_cast<std::byte *>(aligned ? std::aligned_alloc(kAlignment, size)
+                                          : std::malloc(size));
+}
+}  // namespace
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_LIBURING
+struct BagFileWriter::AsyncWrites
+{
+  // A full buffer submitted to the ring, until its write completed
+  struct Request
+  {
+    std::unique_ptr<std::byte, AlignedDeleter> buffer;
+    uint64_t offset = 0;
+    size_t length = 0;
+  };
+
+  io_uring ring{};
+  std::vector<std::unique_ptr<std::byte, AlignedDeleter>> free_buffers;
+  size_t in_flight = 0;
+  // File offset of the next submitted buffer
+  uint64_t offset = 0;
+};
+#else
+struct BagFileWriter::AsyncWrites
+{
+};
+#endif
+
+void BagFileWriter::AlignedDeleter::operator()(std::byte * buffer) const
+{
+  std::free(buffer);
+}
+
+// Defined here, where AsyncWrites is complete, like the destructor
+BagFileWriter::BagFileWriter() = default;
+
+BagFileWriter::~BagFileWriter()
+{
+  end();
+}
+
+void BagFileWriter::open(const std::string & path, uint64_t preallocate_size, bool direct_io,
+                         size_t async_buffers)
+{
+  end();
+  path_ = path;
+  size_ = 0;
+  written_ = 0;
+  buffer_used_ = 0;
+
+  fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Failed to open " + path_ + ": " + std::strerror(errno));
+  }
+
+  if (preallocate_size > 0) {
+#ifdef __linux__
+    // Keep the file size at the written data, so the file stays readable if recording is
+    // interrupted before end() is called.
+    if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocate_size)) != 0) {
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Failed to pre-allocate %lu bytes for %s: %s",
+                             static_cast<unsigned long>(preallocate_size), path_.c_str(),
+                             std::strerror(errno));
+    }
+#else
+    RCUTILS_LOG_WARN_NAMED(LOG_NAME,
+                           "Pre-allocation of bag files is not supported on this platform");
+#endif
+  }
+
+  direct_io_ = false;
+  if (direct_io) {
+    direct_io_ = set_direct_io(true);
+    if (!direct_io_) {
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Direct I/O is not available for %s, using buffered writes",
+                             path_.c_str());
+    }
+  }
+  // Only direct I/O needs the large, block aligned buffer
+  const size_t buffer_size = direct_io_ ? kDirectIOBufferSize : kBufferedBufferSize;
+  if (!buffer_ || buffer_size != buffer_size_) {
+    buffer_.reset(allocate_buffer(buffer_size, direct_io_));
+    buffer_size_ = buffer_size;
+    if (!buffer_) {
+      end();
+      throw std::runtime_error("Failed to allocate the write buffer for " + path_);
+    }
+  }
+  if (async_buffers > 0) {
+    open_async(async_buffers);
+  }
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_LIBURING
+void BagFileWriter::open_async(size_t async_buffers)
+{
+  auto async = std::make_unique<AsyncWrites>();
+  const int result = io_uring_queue_init(static_cast<unsigned>(async_buffers), &async->ring, 0);
+  if (result < 0) {
+    RCUTILS_LOG_WARN_NAMED(LOG_NAME,
+                           "io_uring is not available for %s, using synchronous writes: %s",
+                           path_.c_str(), std::strerror(-result));
+    return;
+  }
+  for (size_t i = 0; i < async_buffers; ++i) {
+    async->free_buffers.emplace_back(allocate_buffer(buffer_size_, direct_io_));
+    if (!async->free_buffers.back()) {
+      io_uring_queue_exit(&async->ring);
+      throw std::runtime_error("Failed to allocate the write buffers for " + path_);
+    }
+  }
+  async_ = std::move(async);
+}
+
+void BagFileWriter::submit_buffer()
+{
+  auto & async = *async_;
+  // At most as many buffers as the ring has entries are in flight, so there is always an entry
+  io_uring_sqe * sqe = io_uring_get_sqe(&async.ring);
+  auto request = std::make_unique<AsyncWrites::Request>();
+  request->buffer = std::move(buffer_);
+  request->offset = async.offset;
+  request->length = buffer_size_;
+  io_uring_prep_write(sqe, fd_, request->buffer.get(), static_cast<unsigned>(request->length),
+                      request->offset);
+  io_uring_sqe_set_data(sqe, request.get());
+  const int result = io_uring_submit(&async.ring);
+  if (result < 0) {
+    buffer_ = std::move(request->buffer);
+    throw std::runtime_error("Failed to submit a write to " + path_ + ": " +
+                             std::strerror(-result));
+  }
+  request.release();
+  ++async.in_flight;
+  async.offset += buffer_size_;
+
+  // Buffers are recycled as their writes complete
+  while (async.free_buffers.empty()) {
+    complete_write();
+  }
+  buffer_ = std::move(async.free_buffers.back());
+  async.free_buffers.pop_back();
+}
+
+void BagFileWriter::complete_write()
+{
+  auto & async = *async_;
+  io_uring_cqe * cqe = nullptr;
+  int result = 0;
+  do {
+    result = io_uring_wait_cqe(&async.ring, &cqe);
+  } while (result == -EINTR);
+  if (result < 0) {
+    throw std::runtime_error("Failed to wait for a write to " + path_ + ": " +
+                             std::strerror(-result));
+  }
+  std::unique_ptr<AsyncWrites::Request> request(
+    static_cast<AsyncWrites::Request *>(io_uring_cqe_get_data(cqe)));
+  result = cqe->res;
+  io_uring_cqe_seen(&async.ring, cqe);
+  --async.in_flight;
+  if (result < 0) {
+    throw std::runtime_error("Failed to write to " + path_ + ": " + std::strerror(-result));
+  }
+  // Short writes are completed synchronously
+  for (size_t done = static_cast<size_t>(result); done < request->length;) {
+    const ssize_t written =
+      ::pwrite(fd_, request->buffer.get() + done, request->length - done,
+               static_cast<off_t>(request->offset + done));
+    if (written < 0 && errno != EINTR) {
+      throw std::runtime_error("Failed to write to " + path_ + ": " + std::strerror(errno));
+    }
+    done += written > 0 ? static_cast<size_t>(written) : 0u;
+  }
+  written_ += request->length;
+  async.free_buffers.push_back(std::move(request->buffer));
+}
+
+void BagFileWriter::drain_async()
+{
+  while (async_ && async_->in_flight > 0) {
+    complete_write();
+  }
+}
+
+void BagFileWriter::close_async()
+{
+  if (!async_) {
+    return;
+  }
+  while (async_->in_flight > 0) {
+    const size_t in_flight = async_->in_flight;
+    try {
+      complete_write();
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_ERROR_NAMED(LOG_NAME, "%s", e.what());
+      // The buffers of writes which can not be waited for are leaked, the kernel may still use them
+      if (async_->in_flight == in_flight) {
+        break;
+      }
+    }
+  }
+  io_uring_queue_exit(&async_->ring);
+  async_.reset();
+}
+#else
+void BagFileWriter::open_async(size_t /* async_buffers */)
+{
+  RCUTILS_LOG_WARN_NAMED(LOG_NAME,
+                         "Asynchronous writes are not supported on this platform, using "
+                         "synchronous writes for %s",
+                         path_.c_str());
+}
+
+void BagFileWriter::submit_buffer() {}
+
+void BagFileWriter::complete_write() {}
+
+void BagFileWriter::drain_async() {}
+
+void BagFileWriter::close_async() {}
+#endif
+
+bool BagFileWriter::set_direct_io(bool enable)
+{
+#ifdef O_DIRECT
+  const int flags = fcntl(fd_, F_GETFL);
+  if (flags < 0) {
+    return false;
+  }
+  return fcntl(fd_, F_SETFL, enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT)) == 0;
+#else
+  (void)enable;
+  return false;
+#endif
+}
+
+void BagFileWriter::handleWrite(const std::byte * data, uint64_t size)
+{
+  if (fd_ < 0) {
+    throw std::runtime_error("Bag file writer is not open");
+  }
+  while (size > 0) {
+    const size_t length =
+      static_cast<size_t>(std::min<uint64_t>(size, buffer_size_ - buffer_used_));
+    std::memcpy(buffer_.get() + buffer_used_, data, length);
+    buffer_used_ += length;
+    size_ += length;
+    data += length;
+    size -= length;
+    // Only full buffers are written while recording, which keeps every write block aligned
+    if (buffer_used_ == buffer_size_) {
+      if (async_) {
+        submit_buffer();
+      } else {
+        write_to_file(buffer_.get(), buffer_size_);
+      }
+      buffer_used_ = 0;
+    }
+  }
+}
+
+void BagFileWriter::write_to_file(const std::byte * data, size_t length)
+{
+  while (length > 0) {
+    // Written at the end of the completed writes, asynchronous writes do not move the file offset
+    const ssize_t written = ::pwrite(fd_, data, length, static_cast<off_t>(written_));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to write to " + path_ + ": " + std::strerror(errno));
+    }
+    data += written;
+    length -= static_cast<size_t>(written);
+    written_ += static_cast<uint64_t>(written);
+  }
+}
+
+void BagFileWriter::end()
+{
+  if (fd_ < 0) {
+    return;
+  }
+  close_async();
+  try {
+    if (buffer_used_ > 0) {
+      // The tail is not a multiple of the block size and has to go through the page cache
+      if (direct_io_ && !set_direct_io(false)) {
+        throw std::runtime_error("Failed to disable direct I/O for " + path_);
+      }
+      write_to_file(buffer_.get(), buffer_used_);
+      buffer_used_ = 0;
+    }
+  } catch (const std::runtime_error & e) {
+    RCUTILS_LOG_ERROR_NAMED(LOG_NAME, "%s", e.what());
+  }
+  // Truncating to the written size releases the reserved blocks beyond the end of the file
+  if (ftruncate(fd_, static_cast<off_t>(written_)) != 0) {
+    RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Failed to truncate %s: %s", path_.c_str(),
+                           std::strerror(errno));
+  }
+  ::close(fd_);
+  fd_ = -1;
+  direct_io_ = false;
+}
+
+void BagFileWriter::sync()
+{
+  if (fd_ < 0) {
+    throw std::runtime_error("Bag file writer is not open");
+  }
+  drain_async();
+  if (buffer_used_ > 0) {
+    // Like in end(), the tail has to go through the page cache. written_ stays at the end of the
+    // full buffers, so the tail is written again with the rest of its buffer.
+    if (direct_io_ && !set_direct_io(false)) {
+      throw std::runtime_error("Failed to disable direct I/O for " + path_);
+    }
+    const uint64_t written = written_;
+    write_to_file(buffer_.get(), buffer_used_);
+    written_ = written;
+    if (direct_io_ && !set_direct_io(true)) {
+      throw std::runtime_error("Failed to enable direct I/O for " + path_);
+    }
+  }
+#ifdef __linux__
+  const int result = fdatasync(fd_);
+#else
+  const int result = fsync(fd_);
+#endif
+  if (result != 0) {
+    throw std::runtime_error("Failed to sync " + path_ + ": " + std::strerror(errno));
+  }
+}
+
+uint64_t BagFileWriter::size() const
+{
+  return size_;
+}
+
+bool BagFileWriter::is_direct_io() const
+{
+  return direct_io_;
+}
+
+bool BagFileWriter::is_async() const
+{
+  return static_cast<bool>(async_);
+}
+
+}  // namespace rosbag2_storage_plugins
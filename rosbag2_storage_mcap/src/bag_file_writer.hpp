@@ -0,0 +1,112 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__BAG_FILE_WRITER_HPP_
+#define ROSBAG2_STORAGE_MCAP__BAG_FILE_WRITER_HPP_
+
+#include <mcap/writer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * mcap::IWritable which writes MCAP files through a buffer.
+ *
+ * The file can be pre-allocated to its expected size, so the file system does not have to grow
+ * it while recording. The reserved space beyond the written data is released on end().
+ * With direct I/O, the buffer is large and block aligned, and full buffers are written with
+ * O_DIRECT and bypass the page cache. Otherwise writes go through the page cache in buffers of
+ * the size mcap::FileWriter uses.
+ * With asynchronous writes, full buffers are submitted to io_uring and the next buffer is
+ * filled while they are written, so a stalling device does not block the caller until all
+ * buffers are in flight.
+ *
+ * Only available on POSIX systems, pre-allocation and direct I/O are only supported on Linux.
+ * Asynchronous writes require Linux and liburing at build time.
+ */
+class BagFileWriter final : public mcap::IWritable
+{
+public:
+  BagFileWriter();
+  ~BagFileWriter() override;
+
+  BagFileWriter(const BagFileWriter &) = delete;
+  BagFileWriter & operator=(const BagFileWriter &) = delete;
+
+  /// Create the file at path, truncating an existing file.
+  /// \param preallocate_size Bytes to reserve on disk for the file. 0 grows the file on demand.
+  /// \param direct_io Write with O_DIRECT. Buffered writes are used if the file system does not
+  /// support direct I/O.
+  /// \param async_buffers Buffers which are written asynchronously at the same time. With 0, or
+  /// if io_uring is not available, full buffers are written before handleWrite() returns.
+  /// \throws std::runtime_error if the file can not be created.
+  void open(const std::string & path, uint64_t preallocate_size, bool direct_io,
+            size_t async_buffers = 0);
+
+  /// \throws std::runtime_error if writing to the file failed.
+  void handleWrite(const std::byte * data, uint64_t size) override;
+
+  /// Write the remaining buffer, release unused reserved space and close the file.
+  void end() override;
+
+  /// Write everything passed to handleWrite() through to the disk. The buffer keeps its data,
+  /// whose blocks are written again once it is full.
+  /// \throws std::runtime_error if writing to or syncing the file failed.
+  void sync();
+
+  uint64_t size() const override;
+
+  /// \return true if the file is written with direct I/O.
+  bool is_direct_io() const;
+
+  /// \return true if full buffers are written asynchronously.
+  bool is_async() const;
+
+private:
+  struct AlignedDeleter
+  {
+    void operator()(std::byte * buffer) const;
+  };
+
+  // io_uring and the buffers submitted to it, defined if liburing is available
+  struct AsyncWrites;
+
+  void write_to_file(const std::byte * data, size_t length);
+  bool set_direct_io(bool enable);
+  void open_async(size_t async_buffers);
+  void submit_buffer();
+  void complete_write();
+  void drain_async();
+  void close_async();
+
+  std::string path_;
+  int fd_ = -1;
+  bool direct_io_ = false;
+  std::unique_ptr<std::byte, AlignedDeleter> buffer_;
+  size_t buffer_size_ = 0;
+  size_t buffer_used_ = 0;
+  // Bytes passed to handleWrite() and bytes of those which were written to the file
+  uint64_t size_ = 0;
+  uint64_t written_ = 0;
+  std::unique_ptr<AsyncWrites> async_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__BAG_FILE_WRITER_HPP_
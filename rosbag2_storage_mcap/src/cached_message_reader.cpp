@@ -0,0 +1,298 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cached_message_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+const ChunkCache::Message & CachedMessageReader::Cursor::current() const
+{
+  return chunk->messages[messages[position]];
+}
+
+CachedMessageReader::CachedMessageReader(mcap::McapReader & reader, mcap::IReadable & data_source,
+                                         std::shared_ptr<const void> mapping, ChunkCache & cache,
+                                         ChunkDecoder & decoder, size_t read_ahead,
+                                         const mcap::ReadMessageOptions & options,
+                                         std::shared_ptr<const SampledMessages> samples,
+                                         const mcap::ProblemCallback & on_problem)
+    : reader_(reader)
+    , data_source_(data_source)
+    , mapping_(std::move(mapping))
+    , cache_(cache)
+    , decoder_(decoder)
+    , read_ahead_(read_ahead)
+    , options_(options)
+    , samples_(std::move(samples))
+    , on_problem_(on_problem)
+    , cancelled_(std::make_shared<std::atomic<bool>>(false))
+{
+  for (const auto & chunk_index : reader_.chunkIndexes()) {
+    if (chunk_index.messageEndTime >= options_.startTime &&
+        chunk_index.messageStartTime < options_.endTime && has_selected_messages(chunk_index)) {
+      chunks_.push_back(&chunk_index);
+    }
+  }
+  using ReadOrder = mcap::ReadMessageOptions::ReadOrder;
+  std::sort(chunks_.begin(), chunks_.end(),
+            [order = options_.readOrder](const mcap::ChunkIndex * lhs,
+                                         const mcap::ChunkIndex * rhs) {
+              switch (order) {
+                case ReadOrder::LogTimeOrder:
+                  return std::tie(lhs->messageStartTime, lhs->chunkStartOffset) <
+                         std::tie(rhs->messageStartTime, rhs->chunkStartOffset);
+                case ReadOrder::ReverseLogTimeOrder:
+                  return std::tie(lhs->messageEndTime, lhs->chunkStartOffset) >
+                         std::tie(rhs->messageEndTime, rhs->chunkStartOffset);
+                case ReadOrder::FileOrder:
+                default:
+                  return lhs->chunkStartOffset < rhs->chunkStartOffset;
+              }
+            });
+}
+
+CachedMessageReader::~CachedMessageReader()
+{
+  *cancelled_ = true;
+}
+
+std::optional<CachedMessageReader::Entry> CachedMessageReader::next()
+{
+  const auto heap_order = [this](const Cursor & lhs, const Cursor & rhs) {
+    return after(lhs, rhs);
+  };
+  // Chunks overlap in time, a chunk is opened before its first message could be the next one
+  while (next_chunk_ < chunks_.size() &&
+         (cursors_.empty() || must_open(*chunks_[next_chunk_]))) {
+    if (open(next_chunk_++)) {
+      std::push_heap(cursors_.begin(), cursors_.end(), heap_order);
+    }
+  }
+  if (cursors_.empty()) {
+    current_chunk_.reset();
+    return std::nullopt;
+  }
+
+  std::pop_heap(cursors_.begin(), cursors_.end(), heap_order);
+  auto & cursor = cursors_.back();
+  const auto & message = cursor.current();
+  current_chunk_ = cursor.chunk;
+  Entry entry{&message.message, channels_.at(message.message.channelId), message.offset};
+  if (++cursor.position < cursor.messages.size()) {
+    std::push_heap(cursors_.begin(), cursors_.end(), heap_order);
+  } else {
+    cursors_.pop_back();
+  }
+  return entry;
+}
+
+bool CachedMessageReader::has_selected_messages(const mcap::ChunkIndex & chunk_index)
+{
+  // Without message indexes, the messages in a chunk are only known once it is decoded
+  if (chunk_index.messageIndexOffsets.empty()) {
+    return true;
+  }
+  if (samples_) {
+    return samples_->contains_chunk(chunk_index.chunkStartOffset);
+  }
+  const bool within_time_range = chunk_index.messageStartTime >= options_.startTime &&
+                                 chunk_index.messageEndTime < options_.endTime;
+  for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+    // Unknown channels are reported once their messages are read
+    if (reader_.channel(channel_id) && !selected_channel(channel_id)) {
+      continue;
+    }
+    if (within_time_range) {
+      return true;
+    }
+    // The chunk extends beyond the time range, the message index of the channel tells whether
+    // any of its messages fall into the time range
+    mcap::Record record{};
+    mcap::MessageIndex message_index{};
+    auto status = mcap::McapReader::ReadRecord(data_source_, message_index_offset, &record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseMessageIndex(record, &message_index);
+    }
+    if (!status.ok()) {
+      // The chunk is decoded instead
+      return true;
+    }
+    for (const auto & [log_time, offset] : message_index.records) {
+      if (log_time >= options_.startTime && log_time < options_.endTime) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool CachedMessageReader::must_open(const mcap::ChunkIndex & chunk_index) const
+{
+  const auto next_log_time = cursors_.front().current().message.logTime;
+  switch (options_.readOrder) {
+    case mcap::ReadMessageOptions::ReadOrder::LogTimeOrder:
+      return chunk_index.messageStartTime <= next_log_time;
+    case mcap::ReadMessageOptions::ReadOrder::ReverseLogTimeOrder:
+      return chunk_index.messageEndTime >= next_log_time;
+    case mcap::ReadMessageOptions::ReadOrder::FileOrder:
+    default:
+      return false;
+  }
+}
+
+bool CachedMessageReader::open(size_t chunk)
+{
+  // Keep the decoder busy with the chunks following the one opened
+  const size_t read_ahead_end = std::min(chunks_.size(), chunk + 1 + read_ahead_);
+  for (size_t ahead = chunk + 1; ahead < read_ahead_end; ++ahead) {
+    request(ahead);
+  }
+  const auto decoded = load(chunk);
+  if (!decoded) {
+    return false;
+  }
+
+  Cursor cursor;
+  const auto select = [this, &decoded, &cursor](uint32_t index) {
+    const auto & message = decoded->messages[index].message;
+    if (message.logTime >= options_.startTime && message.logTime < options_.endTime &&
+        selected_channel(message.channelId) &&
+        (!samples_ || samples_->contains(decoded->messages[index].offset))) {
+      cursor.messages.push_back(index);
+    }
+  };
+  switch (options_.readOrder) {
+    case mcap::ReadMessageOptions::ReadOrder::LogTimeOrder:
+      std::for_each(decoded->log_time_order.begin(), decoded->log_time_order.end(), select);
+      break;
+    case mcap::ReadMessageOptions::ReadOrder::ReverseLogTimeOrder:
+      std::for_each(decoded->log_time_order.rbegin(), decoded->log_time_order.rend(), select);
+      break;
+    case mcap::ReadMessageOptions::ReadOrder::FileOrder:
+    default:
+      for (uint32_t index = 0; index < decoded->messages.size(); ++index) {
+        select(index);
+      }
+      break;
+  }
+  if (cursor.messages.empty()) {
+    return false;
+  }
+  cursor.chunk = decoded;
+  cursors_.push_back(std::move(cursor));
+  return true;
+}
+
+std::shared_ptr<const ChunkCache::Chunk> CachedMessageReader::load(size_t chunk)
+{
+  const uint64_t chunk_offset = chunks_[chunk]->chunkStartOffset;
+  auto it = requested_.find(chunk);
+  if (it == requested_.end()) {
+    if (auto cached = cache_.find(chunk_offset)) {
+      return cached;
+    }
+    request(chunk);
+    it = requested_.find(chunk);
+  }
+  // Blocks until the chunk requested ahead is decoded
+  const ChunkDecoder::Result result = it->second.get();
+  requested_.erase(it);
+  for (const auto & problem : result.problems) {
+    on_problem_(problem);
+  }
+  if (result.chunk) {
+    cache_.insert(chunk_offset, result.chunk);
+  }
+  return result.chunk;
+}
+
+void CachedMessageReader::request(size_t chunk)
+{
+  const uint64_t chunk_offset = chunks_[chunk]->chunkStartOffset;
+  if (requested_.count(chunk) > 0 || cache_.find(chunk_offset)) {
+    return;
+  }
+  mcap::Record record{};
+  mcap::Chunk mcap_chunk{};
+  auto status = mcap::McapReader::ReadRecord(data_source_, chunk_offset, &record);
+  if (status.ok()) {
+    status = mcap::McapReader::ParseChunk(record, &mcap_chunk);
+  }
+  if (!status.ok()) {
+    // Reported once the chunk is loaded
+    std::promise<ChunkDecoder::Result> failed;
+    failed.set_value({nullptr, {status}});
+    requested_.emplace(chunk, failed.get_future().share());
+    return;
+  }
+  std::shared_ptr<const void> records = mapping_;
+  if (!records && decoder_.threads() > 0) {
+    // The record buffer of the data source is reused by the next read
+    auto copy = std::make_shared<std::vector<std::byte>>(
+      mcap_chunk.records, mcap_chunk.records + mcap_chunk.compressedSize);
+    mcap_chunk.records = copy->data();
+    records = std::move(copy);
+  }
+  requested_.emplace(chunk, decoder_.decode(mcap_chunk, chunk_offset, std::move(records),
+                                            cancelled_));
+}
+
+mcap::ChannelPtr CachedMessageReader::selected_channel(mcap::ChannelId channel_id)
+{
+  const auto it = channels_.find(channel_id);
+  if (it != channels_.end()) {
+    return it->second;
+  }
+  auto channel = reader_.channel(channel_id);
+  if (!channel) {
+    on_problem_(mcap::Status{mcap::StatusCode::InvalidChannelId,
+                             "message refers to unknown channel " + std::to_string(channel_id)});
+  } else if (options_.topicFilter && !options_.topicFilter(channel->topic)) {
+    channel = nullptr;
+  }
+  channels_.emplace(channel_id, channel);
+  return channel;
+}
+
+bool CachedMessageReader::after(const Cursor & lhs, const Cursor & rhs) const
+{
+  const auto & l = lhs.current();
+  const auto & r = rhs.current();
+  const auto l_key = std::make_tuple(l.message.logTime, *l.offset.chunkOffset, l.offset.offset);
+  const auto r_key = std::make_tuple(r.message.logTime, *r.offset.chunkOffset, r.offset.offset);
+  switch (options_.readOrder) {
+    case mcap::ReadMessageOptions::ReadOrder::LogTimeOrder:
+      return l_key > r_key;
+    case mcap::ReadMessageOptions::ReadOrder::ReverseLogTimeOrder:
+      return l_key < r_key;
+    case mcap::ReadMessageOptions::ReadOrder::FileOrder:
+    default:
+      return std::tie(*l.offset.chunkOffset, l.offset.offset) >
+             std::tie(*r.offset.chunkOffset, r.offset.offset);
+  }
+}
+
+}  // namespace rosbag2_storage_plugins
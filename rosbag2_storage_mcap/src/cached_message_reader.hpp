@@ -0,0 +1,127 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__CACHED_MESSAGE_READER_HPP_
+#define ROSBAG2_STORAGE_MCAP__CACHED_MESSAGE_READER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include "chunk_cache.hpp"
+#include "chunk_decoder.hpp"
+#include "message_sampler.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Reads the messages of the chunks listed in the chunk index, in the same order as
+ * mcap::LinearMessageView does, but decodes the chunks through a ChunkCache.
+ *
+ * With a ChunkDecoder running threads, the chunks following the ones being read are decoded
+ * ahead, while messages are merged in read order on the calling thread. Messages outside of
+ * chunks are not read, the reader is meant for files with a chunk index. Chunks without messages
+ * of selected channels in the time range are skipped based on the chunk and message indexes.
+ * With samples, only the sampled messages are read and chunks without any are skipped as well.
+ * The MCAP reader, the data source, the cache and the decoder have to outlive the reader.
+ */
+class CachedMessageReader
+{
+public:
+  struct Entry
+  {
+    // Valid until the next call to next()
+    const mcap::Message * message;
+    mcap::ChannelPtr channel;
+    mcap::RecordOffset offset;
+  };
+
+  /// \param mapping Set if data_source reads a memory-mapped file, uncompressed chunks are then
+  /// decoded in place. The reference keeps the mapping valid for cached chunks.
+  /// \param read_ahead Number of chunks requested from the decoder ahead of the chunks being
+  /// read. Only useful if the decoder runs threads.
+  /// \param samples Set to read only the sampled messages selected by options.
+  CachedMessageReader(mcap::McapReader & reader, mcap::IReadable & data_source,
+                      std::shared_ptr<const void> mapping, ChunkCache & cache,
+                      ChunkDecoder & decoder, size_t read_ahead,
+                      const mcap::ReadMessageOptions & options,
+                      std::shared_ptr<const SampledMessages> samples,
+                      const mcap::ProblemCallback & on_problem);
+
+  /// Cancels the chunks requested ahead which were not decoded yet.
+  ~CachedMessageReader();
+
+  CachedMessageReader(const CachedMessageReader &) = delete;
+  CachedMessageReader & operator=(const CachedMessageReader &) = delete;
+
+  /// \return the next message, or nullopt after the last one. Chunks which can not be read are
+  /// reported to the problem callback and skipped.
+  std::optional<Entry> next();
+
+private:
+  // Position in the selected messages of a chunk
+  struct Cursor
+  {
+    std::shared_ptr<const ChunkCache::Chunk> chunk;
+    std::vector<uint32_t> messages;
+    size_t position = 0;
+
+    const ChunkCache::Message & current() const;
+  };
+
+  bool has_selected_messages(const mcap::ChunkIndex & chunk_index);
+  bool must_open(const mcap::ChunkIndex & chunk_index) const;
+  // \return true if a cursor was added for the chunk
+  bool open(size_t chunk);
+  std::shared_ptr<const ChunkCache::Chunk> load(size_t chunk);
+  void request(size_t chunk);
+  mcap::ChannelPtr selected_channel(mcap::ChannelId channel_id);
+  // Heap order, the cursor returned first is the greatest
+  bool after(const Cursor & lhs, const Cursor & rhs) const;
+
+  mcap::McapReader & reader_;
+  mcap::IReadable & data_source_;
+  const std::shared_ptr<const void> mapping_;
+  ChunkCache & cache_;
+  ChunkDecoder & decoder_;
+  const size_t read_ahead_;
+  const mcap::ReadMessageOptions options_;
+  const std::shared_ptr<const SampledMessages> samples_;
+  const mcap::ProblemCallback on_problem_;
+
+  // Chunks with selected messages in the time range, in the order they are opened
+  std::vector<const mcap::ChunkIndex *> chunks_;
+  size_t next_chunk_ = 0;
+  // Chunks requested from the decoder, by position in chunks_
+  std::map<size_t, std::shared_future<ChunkDecoder::Result>> requested_;
+  const std::shared_ptr<std::atomic<bool>> cancelled_;
+  std::vector<Cursor> cursors_;
+  // Keeps the message returned last valid
+  std::shared_ptr<const ChunkCache::Chunk> current_chunk_;
+  // Selected channels, unselected ones map to nullptr
+  std::unordered_map<mcap::ChannelId, mcap::ChannelPtr> channels_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__CACHED_MESSAGE_READER_HPP_
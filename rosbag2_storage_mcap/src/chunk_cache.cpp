@@ -0,0 +1,65 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "chunk_cache.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace rosbag2_storage_plugins
+{
+
+ChunkCache::ChunkCache(uint64_t max_bytes)
+    : max_bytes_(max_bytes)
+{
+}
+
+std::shared_ptr<const ChunkCache::Chunk> ChunkCache::find(uint64_t chunk_offset)
+{
+  const auto it = index_.find(chunk_offset);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void ChunkCache::insert(uint64_t chunk_offset, std::shared_ptr<const Chunk> chunk)
+{
+  if (chunk->size > max_bytes_) {
+    return;
+  }
+  const auto it = index_.find(chunk_offset);
+  if (it != index_.end()) {
+    size_ -= it->second->second->size;
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  size_ += chunk->size;
+  entries_.emplace_front(chunk_offset, std::move(chunk));
+  index_[chunk_offset] = entries_.begin();
+  while (size_ > max_bytes_) {
+    size_ -= entries_.back().second->size;
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+uint64_t ChunkCache::size() const
+{
+  return size_;
+}
+
+}  // namespace rosbag2_storage_plugins
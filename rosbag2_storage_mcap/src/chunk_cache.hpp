@@ -0,0 +1,84 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__CHUNK_CACHE_HPP_
+#define ROSBAG2_STORAGE_MCAP__CHUNK_CACHE_HPP_
+
+#include <mcap/reader.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Byte-bounded LRU cache of decoded chunks, keyed by the offset of the chunk record in the file.
+ *
+ * Seeking and reading in reverse order visit the same chunks over and over, the cache saves
+ * decompressing them again. Chunks stay valid as long as they are referenced, also after they
+ * were evicted.
+ */
+class ChunkCache
+{
+public:
+  struct Message
+  {
+    // data points into the records of the chunk
+    mcap::Message message;
+    mcap::RecordOffset offset;
+  };
+
+  struct Chunk
+  {
+    // Keeps the records valid, which are a decompressed copy or part of a mapped file
+    std::shared_ptr<const void> records;
+    // In file order
+    std::vector<Message> messages;
+    // Indexes into messages in log time order, messages with the same log time in file order
+    std::vector<uint32_t> log_time_order;
+    // Bytes counted against the budget of the cache
+    uint64_t size = 0;
+  };
+
+  /// \param max_bytes Budget for decoded chunks. Chunks larger than the budget are not cached.
+  explicit ChunkCache(uint64_t max_bytes);
+
+  /// \return the chunk at chunk_offset, or nullptr if it is not cached.
+  std::shared_ptr<const Chunk> find(uint64_t chunk_offset);
+
+  /// Insert chunk as the most recently used one and evict chunks beyond the budget.
+  void insert(uint64_t chunk_offset, std::shared_ptr<const Chunk> chunk);
+
+  /// Bytes held by the cached chunks.
+  uint64_t size() const;
+
+private:
+  using Entry = std::pair<uint64_t, std::shared_ptr<const Chunk>>;
+
+  const uint64_t max_bytes_;
+  uint64_t size_ = 0;
+  // Most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__CHUNK_CACHE_HPP_
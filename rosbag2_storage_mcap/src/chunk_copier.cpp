@@ -0,0 +1,145 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "chunk_copier.hpp"
+
+#include "chunk_decoder.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+void count_message(mcap::Statistics & statistics, mcap::ChannelId channel_id,
+                   mcap::Timestamp log_time)
+{
+  if (statistics.messageCount == 0) {
+    statistics.messageStartTime = log_time;
+    statistics.messageEndTime = log_time;
+  } else {
+    statistics.messageStartTime = std::min(statistics.messageStartTime, log_time);
+    statistics.messageEndTime = std::max(statistics.messageEndTime, log_time);
+  }
+  ++statistics.messageCount;
+  ++statistics.channelMessageCounts[channel_id];
+}
+}  // namespace
+
+ChunkCopier::ChunkCopier(mcap::McapReader & reader, mcap::IReadable & data_source,
+                         std::shared_ptr<const void> mapping,
+                         mcap::ProblemCallback on_problem)
+    : reader_(reader)
+    , data_source_(data_source)
+    , mapping_(std::move(mapping))
+    , on_problem_(std::move(on_problem))
+{
+}
+
+ChunkCopier::Result ChunkCopier::copy(const std::unordered_set<mcap::ChannelId> & channels,
+                                      mcap::Timestamp start_time, mcap::Timestamp end_time,
+                                      PipelinedMcapWriter & writer)
+{
+  Result result;
+  ChunkDecoder decoder(0);
+  for (const auto & chunk_index : reader_.chunkIndexes()) {
+    if (chunk_index.messageEndTime < start_time || chunk_index.messageStartTime >= end_time) {
+      continue;
+    }
+    // Without message indexes, the channels of a chunk are only known once it is decoded
+    bool any_selected = chunk_index.messageIndexOffsets.empty();
+    bool all_selected = !chunk_index.messageIndexOffsets.empty();
+    for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+      const bool selected = channels.count(channel_id) > 0;
+      any_selected = any_selected || selected;
+      all_selected = all_selected && selected;
+    }
+    if (!any_selected) {
+      continue;
+    }
+    const bool within_time_range =
+      chunk_index.messageStartTime >= start_time && chunk_index.messageEndTime < end_time;
+
+    // Read before the chunk, a data source without mapping reuses its buffer for every read
+    std::vector<mcap::MessageIndex> message_indexes;
+    const bool copy_as_is =
+      all_selected && within_time_range && read_message_indexes(chunk_index, message_indexes);
+
+    mcap::Record record{};
+    mcap::Chunk chunk{};
+    auto status = mcap::McapReader::ReadRecord(data_source_, chunk_index.chunkStartOffset, &record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseChunk(record, &chunk);
+    }
+    if (!status.ok()) {
+      on_problem_(status);
+      continue;
+    }
+
+    if (copy_as_is) {
+      for (const auto & message_index : message_indexes) {
+        for (const auto & [log_time, offset] : message_index.records) {
+          count_message(result.statistics, message_index.channelId, log_time);
+        }
+      }
+      writer.write(chunk, std::move(message_indexes), mapping_);
+      ++result.copied_chunks;
+      continue;
+    }
+
+    const auto decoded = decoder.decode(chunk, chunk_index.chunkStartOffset, mapping_).get();
+    for (const auto & problem : decoded.problems) {
+      on_problem_(problem);
+    }
+    if (!decoded.chunk) {
+      continue;
+    }
+    for (const auto & message : decoded.chunk->messages) {
+      const auto & mcap_message = message.message;
+      if (channels.count(mcap_message.channelId) > 0 && mcap_message.logTime >= start_time &&
+          mcap_message.logTime < end_time) {
+        writer.write(mcap_message);
+        count_message(result.statistics, mcap_message.channelId, mcap_message.logTime);
+      }
+    }
+    ++result.decoded_chunks;
+  }
+  return result;
+}
+
+bool ChunkCopier::read_message_indexes(const mcap::ChunkIndex & chunk_index,
+                                       std::vector<mcap::MessageIndex> & message_indexes)
+{
+  message_indexes.reserve(chunk_index.messageIndexOffsets.size());
+  for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+    mcap::Record record{};
+    mcap::MessageIndex message_index{};
+    auto status = mcap::McapReader::ReadRecord(data_source_, message_index_offset, &record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseMessageIndex(record, &message_index);
+    }
+    if (!status.ok() || message_index.channelId != channel_id) {
+      // The chunk is decoded instead
+      return false;
+    }
+    message_indexes.push_back(std::move(message_index));
+  }
+  return true;
+}
+
+}  // namespace rosbag2_storage_plugins
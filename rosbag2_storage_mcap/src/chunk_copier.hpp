@@ -0,0 +1,74 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__CHUNK_COPIER_HPP_
+#define ROSBAG2_STORAGE_MCAP__CHUNK_COPIER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include "pipelined_mcap_writer.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Copies the messages of selected channels from the chunks of an indexed MCAP file.
+ *
+ * Chunks whose message indexes only list selected channels and which lie within the time range
+ * are written as they are, without decompressing them. The selected messages of the other chunks
+ * are decoded and written to new chunks. Chunks without selected messages in the time range are
+ * skipped. Messages outside of chunks are not copied.
+ *
+ * The writer has to know the selected channels and their schemas by their ids in the input file.
+ */
+class ChunkCopier
+{
+public:
+  struct Result
+  {
+    // Of the copied messages only
+    mcap::Statistics statistics{};
+    size_t copied_chunks = 0;
+    size_t decoded_chunks = 0;
+  };
+
+  /// \param reader Reader of the input file, whose summary was read.
+  /// \param mapping Set if data_source reads a memory-mapped file, chunks are then written from
+  /// the mapping instead of being copied to memory.
+  ChunkCopier(mcap::McapReader & reader, mcap::IReadable & data_source,
+              std::shared_ptr<const void> mapping, mcap::ProblemCallback on_problem);
+
+  /// Copy the messages of channels with log times in [start_time, end_time).
+  /// \throws std::runtime_error if the writer failed.
+  Result copy(const std::unordered_set<mcap::ChannelId> & channels, mcap::Timestamp start_time,
+              mcap::Timestamp end_time, PipelinedMcapWriter & writer);
+
+private:
+  bool read_message_indexes(const mcap::ChunkIndex & chunk_index,
+                            std::vector<mcap::MessageIndex> & message_indexes);
+
+  mcap::McapReader & reader_;
+  mcap::IReadable & data_source_;
+  std::shared_ptr<const void> mapping_;
+  mcap::ProblemCallback on_problem_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__CHUNK_COPIER_HPP_
@@ -0,0 +1,219 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "chunk_decoder.hpp"
+
+#include "crc32.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+constexpr uint64_t kRecordHeaderSize = 1 + 8;  // opcode, record length
+
+uint64_t read_uint64(const std::byte * data)
+{
+  // MCAP is little-endian
+  uint64_t value = 0;
+  for (size_t i = 8; i > 0; --i) {
+    value = (value << 8) | std::to_integer<uint64_t>(data[i - 1]);
+  }
+  return value;
+}
+
+mcap::Status chunk_problem(mcap::StatusCode code, uint64_t chunk_offset,
+                           const std::string & problem)
+{
+  return mcap::Status{code, "chunk at offset " + std::to_string(chunk_offset) + " " + problem};
+}
+}  // namespace
+
+ChunkDecoder::ChunkDecoder(size_t threads, bool validate_crc)
+    : validate_crc_(validate_crc)
+{
+  threads_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back(&ChunkDecoder::run, this);
+  }
+}
+
+ChunkDecoder::~ChunkDecoder()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  tasks_changed_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t ChunkDecoder::threads() const
+{
+  return threads_.size();
+}
+
+std::shared_future<ChunkDecoder::Result> ChunkDecoder::decode(
+  const mcap::Chunk & chunk, uint64_t chunk_offset, std::shared_ptr<const void> records,
+  std::shared_ptr<const std::atomic<bool>> cancelled)
+{
+  Task task{chunk, chunk_offset, std::move(records), std::move(cancelled), {}};
+  std::shared_future<Result> result = task.result.get_future().share();
+  if (threads_.empty()) {
+    task.result.set_value(decode_chunk(task, decompressors_));
+    return result;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  tasks_changed_.notify_one();
+  return result;
+}
+
+void ChunkDecoder::run()
+{
+  Decompressors decompressors;
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      tasks_changed_.wait(lock, [this] {
+        return stop_ || !tasks_.empty();
+      });
+      if (stop_) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    if (task.cancelled && *task.cancelled) {
+      task.result.set_value({});
+      continue;
+    }
+    task.result.set_value(decode_chunk(task, decompressors));
+  }
+}
+
+ChunkDecoder::Result ChunkDecoder::decode_chunk(const Task & task,
+                                                Decompressors & decompressors) const
+{
+  const mcap::Chunk & mcap_chunk = task.chunk;
+  Result result;
+  if (mcap_chunk.compression.empty() && mcap_chunk.compressedSize != mcap_chunk.uncompressedSize) {
+    result.problems.push_back(chunk_problem(mcap::StatusCode::DecompressionSizeMismatch,
+                                            task.chunk_offset, "has an inconsistent size"));
+    return result;
+  }
+
+  auto chunk = std::make_shared<ChunkCache::Chunk>();
+  const std::byte * records = mcap_chunk.records;
+  if (mcap_chunk.compression.empty() && task.records) {
+    // The records of uncompressed chunks are read in place
+    chunk->records = task.records;
+  } else {
+    if (!mcap_chunk.compression.empty()) {
+      mcap::ICompressedReader * decompressor = nullptr;
+#ifndef MCAP_COMPRESSION_NO_LZ4
+      if (mcap_chunk.compression == "lz4") {
+        decompressor = &decompressors.lz4;
+      }
+#endif
+#ifndef MCAP_COMPRESSION_NO_ZSTD
+      if (mcap_chunk.compression == "zstd") {
+        decompressor = &decompressors.zstd;
+      }
+#endif
+      std::byte * data = nullptr;
+      if (decompressor) {
+        decompressor->reset(mcap_chunk.records, mcap_chunk.compressedSize,
+                            mcap_chunk.uncompressedSize);
+      }
+      if (!decompressor || !decompressor->status().ok() ||
+          decompressor->read(&data, 0, mcap_chunk.uncompressedSize) !=
+            mcap_chunk.uncompressedSize) {
+        result.problems.push_back(chunk_problem(mcap::StatusCode::DecompressionFailed,
+                                                task.chunk_offset, "could not be decompressed"));
+        return result;
+      }
+      records = data;
+    }
+    // The record buffer of the data source and the decompressor are reused for the next chunk
+    auto copy =
+      std::make_shared<std::vector<std::byte>>(records, records + mcap_chunk.uncompressedSize);
+    records = copy->data();
+    chunk->size += copy->size();
+    chunk->records = std::move(copy);
+  }
+
+  const uint64_t records_size = mcap_chunk.uncompressedSize;
+  // A CRC of 0 means that the writer did not compute one
+  if (validate_crc_ && mcap_chunk.uncompressedCrc != 0 &&
+      crc32(records, records_size) != mcap_chunk.uncompressedCrc) {
+    result.problems.push_back(chunk_problem(mcap::StatusCode::InvalidRecord, task.chunk_offset,
+                                            "does not match its CRC, its messages are skipped"));
+    return result;
+  }
+  uint64_t position = 0;
+  while (position < records_size) {
+    const std::byte * header = records + position;
+    if (records_size - position < kRecordHeaderSize ||
+        read_uint64(header + 1) > records_size - position - kRecordHeaderSize) {
+      result.problems.push_back(chunk_problem(mcap::StatusCode::InvalidRecord, task.chunk_offset,
+                                              "contains a truncated record"));
+      break;
+    }
+    // The records are only read, ParseMessage() takes a mutable record nonetheless
+    mcap::Record message_record{};
+    message_record.opcode = static_cast<mcap::OpCode>(std::to_integer<uint8_t>(header[0]));
+    message_record.dataSize = read_uint64(header + 1);
+    message_record.data = const_cast<std::byte *>(header + kRecordHeaderSize);
+    if (message_record.opcode == mcap::OpCode::Message) {
+      ChunkCache::Message message{};
+      const auto status = mcap::McapReader::ParseMessage(message_record, &message.message);
+      if (status.ok()) {
+        message.offset = mcap::RecordOffset{position, task.chunk_offset};
+        chunk->messages.push_back(std::move(message));
+      } else {
+        result.problems.push_back(status);
+      }
+    }
+    position += kRecordHeaderSize + message_record.dataSize;
+  }
+
+  chunk->messages.shrink_to_fit();
+  chunk->log_time_order.resize(chunk->messages.size());
+  for (uint32_t index = 0; index < chunk->log_time_order.size(); ++index) {
+    chunk->log_time_order[index] = index;
+  }
+  std::stable_sort(chunk->log_time_order.begin(), chunk->log_time_order.end(),
+                   [&messages = chunk->messages](uint32_t lhs, uint32_t rhs) {
+                     return messages[lhs].message.logTime < messages[rhs].message.logTime;
+                   });
+  chunk->size += chunk->messages.size() * sizeof(ChunkCache::Message) +
+                 chunk->log_time_order.size() * sizeof(uint32_t);
+  result.chunk = std::move(chunk);
+  return result;
+}
+
+}  // namespace rosbag2_storage_plugins
@@ -0,0 +1,112 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__CHUNK_DECODER_HPP_
+#define ROSBAG2_STORAGE_MCAP__CHUNK_DECODER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include "chunk_cache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Decompresses chunks and indexes their messages, optionally on a pool of threads.
+ *
+ * With threads, chunks are decoded in the order they were requested, so a reader can request
+ * the chunks it is about to read and keep reading the current one meanwhile.
+ */
+class ChunkDecoder
+{
+public:
+  struct Result
+  {
+    // nullptr if the chunk could not be decoded or the decoding was cancelled
+    std::shared_ptr<const ChunkCache::Chunk> chunk;
+    // Problems found while decoding, to be reported by the reader
+    std::vector<mcap::Status> problems;
+  };
+
+  /// \param threads Number of threads decoding chunks. With 0, chunks are decoded by decode().
+  /// \param validate_crc Whether chunks whose records do not match their CRC are reported as
+  /// problems instead of decoded. Chunks without a CRC are not validated.
+  explicit ChunkDecoder(size_t threads, bool validate_crc = false);
+
+  /// Stops the threads, chunks which were not decoded yet are abandoned.
+  ~ChunkDecoder();
+
+  ChunkDecoder(const ChunkDecoder &) = delete;
+  ChunkDecoder & operator=(const ChunkDecoder &) = delete;
+
+  size_t threads() const;
+
+  /// Decode a chunk, as parsed from the chunk record at chunk_offset.
+  /// \param records Keeps chunk.records valid until the chunk is decoded. If set, the records of an
+  /// uncompressed chunk are referred to in place, otherwise they are copied.
+  /// \param cancelled Set to skip the decoding if it did not start yet.
+  std::shared_future<Result> decode(const mcap::Chunk & chunk, uint64_t chunk_offset,
+                                    std::shared_ptr<const void> records,
+                                    std::shared_ptr<const std::atomic<bool>> cancelled = nullptr);
+
+private:
+  struct Task
+  {
+    mcap::Chunk chunk;
+    uint64_t chunk_offset = 0;
+    std::shared_ptr<const void> records;
+    std::shared_ptr<const std::atomic<bool>> cancelled;
+    std::promise<Result> result;
+  };
+
+  // Decompressors hold buffers and contexts, every thread keeps its own
+  struct Decompressors
+  {
+#ifndef MCAP_COMPRESSION_NO_LZ4
+    mcap::LZ4Reader lz4;
+#endif
+#ifndef MCAP_COMPRESSION_NO_ZSTD
+    mcap::ZStdReader zstd;
+#endif
+  };
+
+  Result decode_chunk(const Task & task, Decompressors & decompressors) const;
+  void run();
+
+  const bool validate_crc_;
+
+  // Used by decode() without threads
+  Decompressors decompressors_;
+
+  std::mutex mutex_;
+  std::condition_variable tasks_changed_;
+  std::deque<Task> tasks_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__CHUNK_DECODER_HPP_
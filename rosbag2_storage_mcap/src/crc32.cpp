@@ -0,0 +1,149 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "crc32.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  #if defined(__ARM_FEATURE_CRC32)
+    #define ROSBAG2_STORAGE_MCAP_ARM_CRC32
+    #define ROSBAG2_STORAGE_MCAP_ARM_CRC32_ALWAYS
+  #elif defined(__linux__)
+    // CRC32 instructions are optional before ARMv8.1, they are used if the CPU has them
+    #define ROSBAG2_STORAGE_MCAP_ARM_CRC32
+    #include <asm/hwcap.h>
+    #include <sys/auxv.h>
+  #endif
+#endif
+#ifdef ROSBAG2_STORAGE_MCAP_ARM_CRC32
+  #include <arm_acle.h>
+  #if defined(ROSBAG2_STORAGE_MCAP_ARM_CRC32_ALWAYS)
+    #define ROSBAG2_STORAGE_MCAP_CRC_TARGET
+  #elif defined(__clang__)
+    #define ROSBAG2_STORAGE_MCAP_CRC_TARGET __attribute__((target("crc")))
+  #else
+    #define ROSBAG2_STORAGE_MCAP_CRC_TARGET __attribute__((target("+crc")))
+  #endif
+#endif
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+constexpr uint32_t kPolynomial = 0xEDB88320u;  // Reversed polynomial of CRC-32/ISO-HDLC
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// tables[k][b] is the CRC of byte b followed by k zero bytes
+constexpr Tables make_tables()
+{
+  Tables tables{};
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1u) ? kPolynomial : 0u);
+    }
+    tables[0][byte] = crc;
+  }
+  for (size_t k = 1; k < tables.size(); ++k) {
+    for (size_t byte = 0; byte < 256; ++byte) {
+      const uint32_t previous = tables[k - 1][byte];
+      tables[k][byte] = (previous >> 8) ^ tables[0][previous & 0xFFu];
+    }
+  }
+  return tables;
+}
+
+constexpr Tables kTables = make_tables();
+
+uint32_t load_uint32(const std::byte * data)
+{
+  // Assembled byte by byte, so that the tables work on CPUs of either byte order
+  return std::to_integer<uint32_t>(data[0]) | (std::to_integer<uint32_t>(data[1]) << 8) |
+         (std::to_integer<uint32_t>(data[2]) << 16) | (std::to_integer<uint32_t>(data[3]) << 24);
+}
+
+// Slicing-by-8, on the inverted CRC
+uint32_t crc32_tables(const std::byte * data, size_t size, uint32_t crc)
+{
+  while (size >= 8) {
+    const uint32_t low = crc ^ load_uint32(data);
+    const uint32_t high = load_uint32(data + 4);
+    crc = kTables[7][low & 0xFFu] ^ kTables[6][(low >> 8) & 0xFFu] ^
+          kTables[5][(low >> 16) & 0xFFu] ^ kTables[4][low >> 24] ^ kTables[3][high & 0xFFu] ^
+          kTables[2][(high >> 8) & 0xFFu] ^ kTables[1][(high >> 16) & 0xFFu] ^
+          kTables[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  for (; size > 0; --size, ++data) {
+    crc = (crc >> 8) ^ kTables[0][(crc ^ std::to_integer<uint32_t>(*data)) & 0xFFu];
+  }
+  return crc;
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_ARM_CRC32
+// On the inverted CRC, like the tables. AArch64 Linux runs little-endian only.
+ROSBAG2_STORAGE_MCAP_CRC_TARGET uint32_t crc32_arm(const std::byte * data, size_t size,
+                                                   uint32_t crc)
+{
+  while (size >= 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, data, sizeof(word));
+    crc = __crc32d(crc, word);
+    data += 8;
+    size -= 8;
+  }
+  for (; size > 0; --size, ++data) {
+    crc = __crc32b(crc, std::to_integer<uint8_t>(*data));
+  }
+  return crc;
+}
+
+bool cpu_has_crc32()
+{
+  #ifdef ROSBAG2_STORAGE_MCAP_ARM_CRC32_ALWAYS
+  return true;
+  #else
+  static const bool has_crc32 = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+  return has_crc32;
+  #endif
+}
+#endif
+}  // namespace
+
+uint32_t crc32(const std::byte * data, size_t size, uint32_t crc)
+{
+#ifdef ROSBAG2_STORAGE_MCAP_ARM_CRC32
+  if (cpu_has_crc32()) {
+    return ~crc32_arm(data, size, ~crc);
+  }
+#endif
+  return ~crc32_tables(data, size, ~crc);
+}
+
+bool crc32_is_hardware_accelerated()
+{
+#ifdef ROSBAG2_STORAGE_MCAP_ARM_CRC32
+  return cpu_has_crc32();
+#else
+  return false;
+#endif
+}
+
+}  // namespace rosbag2_storage_plugins
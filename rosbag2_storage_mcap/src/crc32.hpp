@@ -0,0 +1,38 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__CRC32_HPP_
+#define ROSBAG2_STORAGE_MCAP__CRC32_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * CRC-32 of data as stored in MCAP records, the same as zlib's crc32().
+ *
+ * Uses the CRC32 instructions of ARMv8 CPUs which have them, and processes 8 bytes per step with
+ * lookup tables otherwise.
+ * \param crc CRC of the data preceding data, to compute the CRC of data in pieces. 0 at the start.
+ */
+uint32_t crc32(const std::byte * data, size_t size, uint32_t crc = 0);
+
+/// Whether crc32() uses CRC32 instructions of the CPU.
+bool crc32_is_hardware_accelerated();
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__CRC32_HPP_
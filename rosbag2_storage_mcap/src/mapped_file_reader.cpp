@@ -0,0 +1,209 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mapped_file_reader.hpp"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+// Record layout of the MCAP specification, see https://mcap.dev/spec
+constexpr uint64_t kRecordHeaderSize = 1 + 8;  // opcode, record length
+constexpr std::byte kChunkOpCode{0x06};
+constexpr std::byte kMessageOpCode{0x05};
+// message_start_time, message_end_time, uncompressed_size, uncompressed_crc
+constexpr uint64_t kChunkCompressionOffset = kRecordHeaderSize + 8 + 8 + 8 + 4;
+// channel_id, sequence, log_time, publish_time
+constexpr uint64_t kMessageFieldsSize = 2 + 4 + 8 + 8;
+
+uint64_t read_uint(const std::byte * data, size_t width)
+{
+  // MCAP is little-endian
+  uint64_t value = 0;
+  for (size_t i = width; i > 0; --i) {
+    value = (value << 8) | std::to_integer<uint64_t>(data[i - 1]);
+  }
+  return value;
+}
+}  // namespace
+
+struct MappedFileReader::Mapping
+{
+  const std::byte * data = nullptr;
+  uint64_t size = 0;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE mapping = nullptr;
+#endif
+
+  ~Mapping()
+  {
+#ifdef _WIN32
+    if (data != nullptr) {
+      UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+      CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+    }
+#else
+    if (data != nullptr) {
+      munmap(const_cast<std::byte *>(data), static_cast<size_t>(size));
+    }
+#endif
+  }
+};
+
+#ifdef _WIN32
+MappedFileReader::MappedFileReader(const std::string & path)
+    : mapping_(std::make_shared<Mapping>())
+{
+  mapping_->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mapping_->file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(mapping_->file, &file_size) || file_size.QuadPart <= 0) {
+    throw std::runtime_error("Failed to map " + path + ": file is empty");
+  }
+  mapping_->mapping = CreateFileMappingA(mapping_->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_->mapping == nullptr) {
+    throw std::runtime_error("Failed to map " + path);
+  }
+  mapping_->data =
+    static_cast<const std::byte *>(MapViewOfFile(mapping_->mapping, FILE_MAP_READ, 0, 0, 0));
+  if (mapping_->data == nullptr) {
+    throw std::runtime_error("Failed to map " + path);
+  }
+  mapping_->size = static_cast<uint64_t>(file_size.QuadPart);
+  data_ = mapping_->data;
+  size_ = mapping_->size;
+}
+#else
+MappedFileReader::MappedFileReader(const std::string & path)
+    : mapping_(std::make_shared<Mapping>())
+{
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0 ||
+      static_cast<uint64_t>(file_stat.st_size) > std::numeric_limits<size_t>::max()) {
+    ::close(fd);
+    throw std::runtime_error("Failed to map " + path + ": file is empty or too large");
+  }
+  const auto size = static_cast<size_t>(file_stat.st_size);
+  void * data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  const int map_errno = errno;
+  // The mapping keeps the file referenced
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("Failed to map " + path + ": " + std::strerror(map_errno));
+  }
+  mapping_->data = static_cast<const std::byte *>(data);
+  mapping_->size = size;
+  data_ = mapping_->data;
+  size_ = mapping_->size;
+}
+#endif
+
+MappedFileReader::~MappedFileReader() = default;
+
+uint64_t MappedFileReader::size() const
+{
+  return size_;
+}
+
+uint64_t MappedFileReader::read(std::byte ** output, uint64_t offset, uint64_t size)
+{
+  if (offset >= size_) {
+    return 0;
+  }
+  // The MCAP readers only read through the pointer, it is non-const to allow buffered readers
+  *output = const_cast<std::byte *>(data_ + offset);
+  return std::min(size, size_ - offset);
+}
+
+const std::byte * MappedFileReader::find_message_data(const std::byte * data, uint64_t data_size,
+                                                      const mcap::RecordOffset & offset) const
+{
+  // Messages outside of chunks and messages of chunks read in place point into the mapping
+  if (contains(data, data_size)) {
+    return data;
+  }
+  if (!offset.chunkOffset.has_value()) {
+    return nullptr;
+  }
+  // Chunk readers may stage uncompressed chunks in a buffer of their own. The payload is then
+  // found in the chunk record, the layout is checked before it is used.
+  const uint64_t chunk_start = *offset.chunkOffset;
+  if (!in_range(chunk_start, kChunkCompressionOffset + 4) || data_[chunk_start] != kChunkOpCode) {
+    return nullptr;
+  }
+  // Only chunks without compression store the records as they are
+  if (read_uint(data_ + chunk_start + kChunkCompressionOffset, 4) != 0) {
+    return nullptr;
+  }
+  const uint64_t records_start = chunk_start + kChunkCompressionOffset + 4 + 8;
+  if (!in_range(records_start, offset.offset)) {
+    return nullptr;
+  }
+  const uint64_t message_start = records_start + offset.offset;
+  if (!in_range(message_start, kRecordHeaderSize + kMessageFieldsSize + data_size) ||
+      data_[message_start] != kMessageOpCode ||
+      read_uint(data_ + message_start + 1, 8) != kMessageFieldsSize + data_size) {
+    return nullptr;
+  }
+  return data_ + message_start + kRecordHeaderSize + kMessageFieldsSize;
+}
+
+std::shared_ptr<const void> MappedFileReader::mapping() const
+{
+  return mapping_;
+}
+
+bool MappedFileReader::contains(const std::byte * data, uint64_t size) const
+{
+  const auto begin = reinterpret_cast<uintptr_t>(data_);
+  const auto address = reinterpret_cast<uintptr_t>(data);
+  return address >= begin && in_range(address - begin, size);
+}
+
+bool MappedFileReader::in_range(uint64_t offset, uint64_t size) const
+{
+  return offset <= size_ && size <= size_ - offset;
+}
+
+}  // namespace rosbag2_storage_plugins
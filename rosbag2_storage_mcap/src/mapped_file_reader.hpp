@@ -0,0 +1,73 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__MAPPED_FILE_READER_HPP_
+#define ROSBAG2_STORAGE_MCAP__MAPPED_FILE_READER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * mcap::IReadable which reads a memory-mapped MCAP file.
+ *
+ * read() returns pointers into the mapping instead of copying into a buffer, and payloads of
+ * messages in uncompressed chunks can be located in the mapping, so they can be handed out without
+ * copying. The mapping stays valid as long as the reader or a reference from mapping() exists.
+ * The file must not be truncated while it is mapped.
+ */
+class MappedFileReader final : public mcap::IReadable
+{
+public:
+  /// \throws std::runtime_error if the file can not be opened or mapped.
+  explicit MappedFileReader(const std::string & path);
+  ~MappedFileReader() override;
+
+  MappedFileReader(const MappedFileReader &) = delete;
+  MappedFileReader & operator=(const MappedFileReader &) = delete;
+
+  uint64_t size() const override;
+  uint64_t read(std::byte ** output, uint64_t offset, uint64_t size) override;
+
+  /// Find the payload of a message in the mapping.
+  /// \param data Payload as returned by the MCAP reader, which may be a decompressed copy.
+  /// \param offset Offset of the message record as returned by the MCAP reader.
+  /// \return pointer to the payload in the mapping, or nullptr if the message is stored in a
+  /// compressed chunk.
+  const std::byte * find_message_data(const std::byte * data, uint64_t data_size,
+                                      const mcap::RecordOffset & offset) const;
+
+  /// \return reference which keeps the mapping valid.
+  std::shared_ptr<const void> mapping() const;
+
+private:
+  struct Mapping;
+
+  bool contains(const std::byte * data, uint64_t size) const;
+  bool in_range(uint64_t offset, uint64_t size) const;
+
+  std::shared_ptr<Mapping> mapping_;
+  const std::byte * data_ = nullptr;
+  uint64_t size_ = 0;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__MAPPED_FILE_READER_HPP_
@@ -0,0 +1,597 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mcap_recovery.hpp"
+
+#include <mcap/writer.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+// Record layout of the MCAP specification, see https://mcap.dev/spec
+constexpr uint64_t kRecordHeaderSize = 1 + 8;  // opcode, record length
+// summary_start, summary_offset_start, summary_crc
+constexpr uint64_t kFooterFieldsSize = 8 + 8 + 4;
+// message_start_time, message_end_time, uncompressed_size, uncompressed_crc, compression length
+constexpr uint64_t kChunkFieldsSize = 8 + 8 + 8 + 4 + 4;
+// channel_id, length of the records
+constexpr uint64_t kMessageIndexFieldsSize = 2 + 4;
+// log_time, offset
+constexpr uint64_t kMessageIndexEntrySize = 8 + 8;
+// channel_id, sequence, log_time, publish_time
+constexpr uint64_t kMessageFieldsSize = 2 + 4 + 8 + 8;
+
+uint64_t read_uint(const std::byte * data, size_t width)
+{
+  // MCAP is little-endian
+  uint64_t value = 0;
+  for (size_t i = width; i > 0; --i) {
+    value = (value << 8) | std::to_integer<uint64_t>(data[i - 1]);
+  }
+  return value;
+}
+
+mcap::Status record_problem(uint64_t offset, const std::string & problem)
+{
+  return mcap::Status{mcap::StatusCode::InvalidRecord,
+                      "record at offset " + std::to_string(offset) + " " + problem};
+}
+
+std::runtime_error recovery_error(const std::string & path, const std::string & problem)
+{
+  return std::runtime_error("Could not recover the MCAP file " + path + ": " + problem);
+}
+
+/// Collects the summary of the data section of a file from the headers of its records.
+class SummaryBuilder
+{
+public:
+  SummaryBuilder(mcap::IReadable & file, const mcap::ProblemCallback & on_problem)
+      : file_(file)
+      , on_problem_(on_problem)
+  {
+    statistics_.messageStartTime = std::numeric_limits<mcap::Timestamp>::max();
+  }
+
+  /// Reads the records following the header and returns where the last complete record ends.
+  uint64_t scan(uint64_t data_start)
+  {
+    const uint64_t file_size = file_.size();
+    uint64_t offset = data_start;
+    uint64_t data_end = data_start;
+    bool data_end_found = false;
+    while (file_size - offset >= kRecordHeaderSize) {
+      const std::byte * header = read(offset, kRecordHeaderSize);
+      if (!header) {
+        break;
+      }
+      const auto opcode = static_cast<mcap::OpCode>(std::to_integer<uint8_t>(header[0]));
+      const uint64_t length = read_uint(header + 1, 8);
+      // Preallocated files continue with zeros after the last record written
+      if (std::to_integer<uint8_t>(header[0]) == 0 ||
+          length > file_size - offset - kRecordHeaderSize) {
+        break;
+      }
+      if (opcode == mcap::OpCode::DataEnd || opcode == mcap::OpCode::Footer) {
+        data_end_found = true;
+        break;
+      }
+      if (opcode != mcap::OpCode::MessageIndex && chunk_) {
+        if (!finish_chunk()) {
+          data_end = chunk_->chunkStartOffset;
+          chunk_.reset();
+          return data_end;
+        }
+      }
+      if (!add_record(opcode, offset, length)) {
+        break;
+      }
+      offset += kRecordHeaderSize + length;
+      data_end = offset;
+    }
+
+    if (chunk_) {
+      if (!data_end_found) {
+        // The message indexes of the last chunk may be incomplete, its messages are counted instead
+        data_end = chunk_->chunkStartOffset + chunk_->chunkLength;
+        chunk_->messageIndexOffsets.clear();
+        chunk_->messageIndexLength = 0;
+      }
+      if (!finish_chunk()) {
+        data_end = chunk_->chunkStartOffset;
+      }
+      chunk_.reset();
+    }
+    return data_end;
+  }
+
+  /// Writes the summary section and the footer of a data section ending at data_end.
+  void write_summary(mcap::IWritable & output, uint64_t data_end)
+  {
+    // Same layout as written by PipelinedMcapWriter::write_summary()
+    mcap::McapWriter::write(output, mcap::DataEnd{0});
+    output.crcEnabled = true;
+    output.resetCrc();
+    const auto position = [&output, data_end]() {
+        return data_end + output.size();
+      };
+
+    const uint64_t summary_start = position();
+    const uint64_t schema_start = position();
+    for (const auto & [id, schema] : schemas_) {
+      mcap::McapWriter::write(output, schema);
+    }
+    const uint64_t channel_start = position();
+    for (const auto & [id, channel] : channels_) {
+      mcap::McapWriter::write(output, channel);
+    }
+    const uint64_t statistics_start = position();
+    statistics_.schemaCount = static_cast<uint16_t>(schemas_.size());
+    statistics_.channelCount = static_cast<uint32_t>(channels_.size());
+    if (statistics_.messageCount == 0) {
+      statistics_.messageStartTime = 0;
+    }
+    mcap::McapWriter::write(output, statistics_);
+    const uint64_t chunk_index_start = position();
+    for (const auto & chunk_index : chunk_indexes_) {
+      mcap::McapWriter::write(output, chunk_index);
+    }
+    const uint64_t attachment_index_start = position();
+    for (const auto & attachment_index : attachment_indexes_) {
+      mcap::McapWriter::write(output, attachment_index);
+    }
+    const uint64_t metadata_index_start = position();
+    for (const auto & metadata_index : metadata_indexes_) {
+      mcap::McapWriter::write(output, metadata_index);
+    }
+
+    const uint64_t summary_offset_start = position();
+    const auto write_summary_offset = [&output](mcap::OpCode op_code, uint64_t start,
+                                                uint64_t end) {
+      if (end > start) {
+        mcap::McapWriter::write(output, mcap::SummaryOffset{op_code, start, end - start});
+      }
+    };
+    write_summary_offset(mcap::OpCode::Schema, schema_start, channel_start);
+    write_summary_offset(mcap::OpCode::Channel, channel_start, statistics_start);
+    write_summary_offset(mcap::OpCode::Statistics, statistics_start, chunk_index_start);
+    write_summary_offset(mcap::OpCode::ChunkIndex, chunk_index_start, attachment_index_start);
+    write_summary_offset(mcap::OpCode::AttachmentIndex, attachment_index_start,
+                         metadata_index_start);
+    write_summary_offset(mcap::OpCode::MetadataIndex, metadata_index_start,
+                         summary_offset_start);
+
+    mcap::Footer footer;
+    footer.summaryStart = summary_start;
+    footer.summaryOffsetStart = summary_offset_start;
+    footer.summaryCrc = 0;
+    mcap::McapWriter::write(output, footer, true);
+    mcap::McapWriter::writeMagic(output);
+  }
+
+  McapRecovery result;
+
+private:
+  /// Returns nullptr if the file is shorter. The bytes are valid until the next read.
+  const std::byte * read(uint64_t offset, uint64_t size)
+  {
+    std::byte * data = nullptr;
+    return file_.read(&data, offset, size) == size ? data : nullptr;
+  }
+
+  /// Returns false if the record is malformed, the data section is considered to end before it.
+  bool add_record(mcap::OpCode opcode, uint64_t offset, uint64_t length)
+  {
+    switch (opcode) {
+      case mcap::OpCode::Schema:
+      case mcap::OpCode::Channel:
+      case mcap::OpCode::Metadata:
+        return add_small_record(offset);
+      case mcap::OpCode::Chunk:
+        return add_chunk(offset, length);
+      case mcap::OpCode::MessageIndex:
+        return add_message_index(offset, length);
+      case mcap::OpCode::Message:
+        return add_message(offset, length);
+      case mcap::OpCode::Attachment:
+        return add_attachment(offset, length);
+      default:
+        // Summary records do not belong to the data section, other records are not indexed
+        return true;
+    }
+  }
+
+  bool add_small_record(uint64_t offset)
+  {
+    mcap::Record record{};
+    auto status = mcap::McapReader::ReadRecord(file_, offset, &record);
+    if (status.ok()) {
+      status = add_definition(record, offset);
+    }
+    if (!status.ok()) {
+      on_problem_(status);
+      return false;
+    }
+    return true;
+  }
+
+  /// Adds a schema, channel or metadata record, within a chunk or not.
+  mcap::Status add_definition(const mcap::Record & record, uint64_t offset)
+  {
+    mcap::Status status;
+    if (record.opcode == mcap::OpCode::Schema) {
+      mcap::Schema schema;
+      status = mcap::McapReader::ParseSchema(record, &schema);
+      if (status.ok()) {
+        schemas_.emplace(schema.id, std::move(schema));
+      }
+    } else if (record.opcode == mcap::OpCode::Channel) {
+      mcap::Channel channel;
+      status = mcap::McapReader::ParseChannel(record, &channel);
+      if (status.ok()) {
+        channels_.emplace(channel.id, std::move(channel));
+      }
+    } else if (record.opcode == mcap::OpCode::Metadata) {
+      mcap::Metadata metadata;
+      status = mcap::McapReader::ParseMetadata(record, &metadata);
+      if (status.ok()) {
+        mcap::MetadataIndex metadata_index;
+        metadata_index.offset = offset;
+        metadata_index.length = record.recordSize();
+        metadata_index.name = metadata.name;
+        metadata_indexes_.push_back(std::move(metadata_index));
+        ++statistics_.metadataCount;
+      }
+    }
+    return status;
+  }
+
+  bool add_chunk(uint64_t offset, uint64_t length)
+  {
+    const std::byte * fields = length >= kChunkFieldsSize ?
+                               read(offset + kRecordHeaderSize, kChunkFieldsSize) : nullptr;
+    const uint64_t compression_size = fields ? read_uint(fields + 28, 4) : 0;
+    if (!fields || length - kChunkFieldsSize < compression_size + 8) {
+      on_problem_(record_problem(offset, "is a truncated chunk"));
+      return false;
+    }
+    mcap::ChunkIndex chunk_index;
+    chunk_index.messageStartTime = read_uint(fields, 8);
+    chunk_index.messageEndTime = read_uint(fields + 8, 8);
+    chunk_index.uncompressedSize = read_uint(fields + 16, 8);
+    chunk_index.chunkStartOffset = offset;
+    chunk_index.chunkLength = kRecordHeaderSize + length;
+
+    const std::byte * compression =
+      read(offset + kRecordHeaderSize + kChunkFieldsSize, compression_size + 8);
+    if (!compression) {
+      on_problem_(record_problem(offset, "is a truncated chunk"));
+      return false;
+    }
+    chunk_index.compression.assign(reinterpret_cast<const char *>(compression), compression_size);
+    chunk_index.compressedSize = read_uint(compression + compression_size, 8);
+    if (chunk_index.compressedSize != length - kChunkFieldsSize - compression_size - 8) {
+      on_problem_(record_problem(offset, "is a chunk with an inconsistent size"));
+      return false;
+    }
+    chunk_ = std::move(chunk_index);
+    return true;
+  }
+
+  bool add_message_index(uint64_t offset, uint64_t length)
+  {
+    if (!chunk_) {
+      // Not preceded by its chunk, as the index can not be used without it
+      return true;
+    }
+    const std::byte * fields =
+      length >= kMessageIndexFieldsSize ? read(offset + kRecordHeaderSize,
+                                              kMessageIndexFieldsSize) : nullptr;
+    const uint64_t records_size = fields ? read_uint(fields + 2, 4) : 0;
+    if (!fields || records_size != length - kMessageIndexFieldsSize ||
+        records_size % kMessageIndexEntrySize != 0) {
+      on_problem_(record_problem(offset, "is a malformed message index"));
+      return false;
+    }
+    const auto channel_id = static_cast<mcap::ChannelId>(read_uint(fields, 2));
+    chunk_->messageIndexOffsets[channel_id] = offset;
+    chunk_->messageIndexLength += kRecordHeaderSize + length;
+    chunk_message_counts_[channel_id] += records_size / kMessageIndexEntrySize;
+    return true;
+  }
+
+  bool add_message(uint64_t offset, uint64_t length)
+  {
+    const std::byte * fields =
+      length >= kMessageFieldsSize ? read(offset + kRecordHeaderSize, kMessageFieldsSize) : nullptr;
+    if (!fields) {
+      on_problem_(record_problem(offset, "is a truncated message"));
+      return false;
+    }
+    const mcap::Timestamp log_time = read_uint(fields + 6, 8);
+    count_messages(static_cast<mcap::ChannelId>(read_uint(fields, 2)), 1, log_time, log_time);
+    return true;
+  }
+
+  bool add_attachment(uint64_t offset, uint64_t length)
+  {
+    const uint64_t record_end = kRecordHeaderSize + length;
+    uint64_t position = kRecordHeaderSize;
+    // Reads a string prefixed with its length at position
+    const auto read_string = [&](std::string & value) {
+        const std::byte * size_field =
+          record_end - position >= 4 ? read(offset + position, 4) : nullptr;
+        if (!size_field) {
+          return false;
+        }
+        const uint64_t size = read_uint(size_field, 4);
+        position += 4;
+        if (record_end - position < size) {
+          return false;
+        }
+        const std::byte * data = size > 0 ? read(offset + position, size) : nullptr;
+        if (size > 0 && !data) {
+          return false;
+        }
+        value.assign(reinterpret_cast<const char *>(data), size);
+        position += size;
+        return true;
+      };
+
+    mcap::AttachmentIndex attachment_index;
+    attachment_index.offset = offset;
+    attachment_index.length = record_end;
+    const std::byte * times = length >= 8 + 8 ? read(offset + position, 8 + 8) : nullptr;
+    if (times) {
+      attachment_index.logTime = read_uint(times, 8);
+      attachment_index.createTime = read_uint(times + 8, 8);
+      position += 8 + 8;
+    }
+    const std::byte * data_size = nullptr;
+    if (times && read_string(attachment_index.name) &&
+        read_string(attachment_index.mediaType) && record_end - position >= 8) {
+      data_size = read(offset + position, 8);
+    }
+    if (!data_size) {
+      on_problem_(record_problem(offset, "is a truncated attachment"));
+      return false;
+    }
+    attachment_index.dataSize = read_uint(data_size, 8);
+    attachment_indexes_.push_back(std::move(attachment_index));
+    ++statistics_.attachmentCount;
+    return true;
+  }
+
+  /// Adds the pending chunk, decompressing it if its channels or its message count are unknown.
+  /// Returns false if the chunk could not be decompressed.
+  bool finish_chunk()
+  {
+    auto & chunk_index = *chunk_;
+    const bool count_messages_of_chunk = chunk_index.messageIndexOffsets.empty();
+    bool decode = count_messages_of_chunk;
+    for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+      decode = decode || channels_.count(channel_id) == 0;
+    }
+    if (count_messages_of_chunk) {
+      chunk_message_counts_.clear();
+    }
+    if (decode && !decode_chunk(chunk_index, count_messages_of_chunk)) {
+      chunk_message_counts_.clear();
+      return false;
+    }
+
+    for (const auto & [channel_id, count] : chunk_message_counts_) {
+      count_messages(channel_id, count, chunk_index.messageStartTime, chunk_index.messageEndTime);
+    }
+    chunk_message_counts_.clear();
+    chunk_indexes_.push_back(std::move(chunk_index));
+    ++statistics_.chunkCount;
+    ++result.chunk_count;
+    return true;
+  }
+
+  bool decode_chunk(const mcap::ChunkIndex & chunk_index, bool count_messages_of_chunk)
+  {
+    const uint64_t offset = chunk_index.chunkStartOffset;
+    mcap::Record record{};
+    mcap::Chunk chunk{};
+    auto status = mcap::McapReader::ReadRecord(file_, offset, &record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseChunk(record, &chunk);
+    }
+    if (!status.ok()) {
+      on_problem_(status);
+      return false;
+    }
+
+    const std::byte * records = chunk.records;
+    if (!chunk.compression.empty()) {
+      mcap::ICompressedReader * decompressor = nullptr;
+#ifndef MCAP_COMPRESSION_NO_LZ4
+      if (chunk.compression == "lz4") {
+        decompressor = &lz4_;
+      }
+#endif
+#ifndef MCAP_COMPRESSION_NO_ZSTD
+      if (chunk.compression == "zstd") {
+        decompressor = &zstd_;
+      }
+#endif
+      std::byte * data = nullptr;
+      if (decompressor) {
+        decompressor->reset(chunk.records, chunk.compressedSize, chunk.uncompressedSize);
+      }
+      if (!decompressor || !decompressor->status().ok() ||
+          decompressor->read(&data, 0, chunk.uncompressedSize) != chunk.uncompressedSize) {
+        on_problem_(record_problem(offset, "is a chunk which could not be decompressed"));
+        return false;
+      }
+      records = data;
+    }
+
+    uint64_t position = 0;
+    while (position < chunk.uncompressedSize) {
+      const std::byte * header = records + position;
+      if (chunk.uncompressedSize - position < kRecordHeaderSize ||
+          read_uint(header + 1, 8) > chunk.uncompressedSize - position - kRecordHeaderSize) {
+        on_problem_(record_problem(offset, "is a chunk with a truncated record"));
+        return false;
+      }
+      // The records are only read, the parsers take a mutable record nonetheless
+      mcap::Record chunk_record{};
+      chunk_record.opcode = static_cast<mcap::OpCode>(std::to_integer<uint8_t>(header[0]));
+      chunk_record.dataSize = read_uint(header + 1, 8);
+      chunk_record.data = const_cast<std::byte *>(header + kRecordHeaderSize);
+      if (chunk_record.opcode == mcap::OpCode::Message) {
+        if (count_messages_of_chunk && chunk_record.dataSize >= kMessageFieldsSize) {
+          ++chunk_message_counts_[static_cast<mcap::ChannelId>(
+            read_uint(chunk_record.data, 2))];
+        }
+      } else if (chunk_record.opcode == mcap::OpCode::Schema ||
+                 chunk_record.opcode == mcap::OpCode::Channel) {
+        status = add_definition(chunk_record, offset);
+        if (!status.ok()) {
+          on_problem_(status);
+        }
+      }
+      position += kRecordHeaderSize + chunk_record.dataSize;
+    }
+    ++result.decoded_chunk_count;
+    return true;
+  }
+
+  void count_messages(mcap::ChannelId channel_id, uint64_t count, mcap::Timestamp start_time,
+                      mcap::Timestamp end_time)
+  {
+    if (count == 0) {
+      return;
+    }
+    statistics_.messageCount += count;
+    statistics_.channelMessageCounts[channel_id] += count;
+    statistics_.messageStartTime = std::min(statistics_.messageStartTime, start_time);
+    statistics_.messageEndTime = std::max(statistics_.messageEndTime, end_time);
+    result.message_count += count;
+  }
+
+  mcap::IReadable & file_;
+  const mcap::ProblemCallback & on_problem_;
+
+  std::map<mcap::SchemaId, mcap::Schema> schemas_;
+  std::map<mcap::ChannelId, mcap::Channel> channels_;
+  mcap::Statistics statistics_{};
+  std::vector<mcap::ChunkIndex> chunk_indexes_;
+  std::vector<mcap::AttachmentIndex> attachment_indexes_;
+  std::vector<mcap::MetadataIndex> metadata_indexes_;
+
+  // Chunk whose message indexes are being read
+  std::optional<mcap::ChunkIndex> chunk_;
+  std::map<mcap::ChannelId, uint64_t> chunk_message_counts_;
+
+#ifndef MCAP_COMPRESSION_NO_LZ4
+  mcap::LZ4Reader lz4_;
+#endif
+#ifndef MCAP_COMPRESSION_NO_ZSTD
+  mcap::ZStdReader zstd_;
+#endif
+};
+
+bool ends_with_footer(mcap::IReadable & file)
+{
+  const uint64_t size = file.size();
+  const uint64_t footer_size = kRecordHeaderSize + kFooterFieldsSize + sizeof(mcap::Magic);
+  if (size < sizeof(mcap::Magic) + footer_size) {
+    return false;
+  }
+  std::byte * footer = nullptr;
+  if (file.read(&footer, size - footer_size, footer_size) != footer_size) {
+    return false;
+  }
+  return static_cast<mcap::OpCode>(std::to_integer<uint8_t>(footer[0])) ==
+           mcap::OpCode::Footer &&
+         read_uint(footer + 1, 8) == kFooterFieldsSize &&
+         std::memcmp(footer + kRecordHeaderSize + kFooterFieldsSize, mcap::Magic,
+                     sizeof(mcap::Magic)) == 0;
+}
+}  // namespace
+
+std::optional<McapRecovery> recover_mcap_summary(const std::string & path,
+                                                 const mcap::ProblemCallback & on_problem)
+{
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"),
+                                                        &std::fclose);
+  if (!file) {
+    throw recovery_error(path, "it could not be opened");
+  }
+  mcap::FileReader reader(file.get());
+  if (ends_with_footer(reader)) {
+    return std::nullopt;
+  }
+
+  // The data section starts after the magic and the header record
+  const uint64_t header_size = sizeof(mcap::Magic) + kRecordHeaderSize;
+  std::byte * start = nullptr;
+  if (reader.read(&start, 0, header_size) != header_size ||
+      std::memcmp(start, mcap::Magic, sizeof(mcap::Magic)) != 0 ||
+      static_cast<mcap::OpCode>(std::to_integer<uint8_t>(start[sizeof(mcap::Magic)])) !=
+        mcap::OpCode::Header) {
+    throw recovery_error(path, "it does not start with an MCAP header");
+  }
+  const uint64_t data_start = header_size + read_uint(start + sizeof(mcap::Magic) + 1, 8);
+  if (data_start > reader.size()) {
+    throw recovery_error(path, "its header is incomplete");
+  }
+
+  SummaryBuilder builder(reader, on_problem);
+  const uint64_t data_end = builder.scan(data_start);
+  const uint64_t file_size = reader.size();
+  file.reset();
+
+  mcap::BufferWriter summary;
+  builder.write_summary(summary, data_end);
+  summary.end();
+
+  std::error_code error;
+  std::filesystem::resize_file(path, data_end, error);
+  if (error) {
+    throw recovery_error(path, error.message());
+  }
+  std::fstream output(path, std::ios::in | std::ios::out | std::ios::binary);
+  output.seekp(static_cast<std::streamoff>(data_end));
+  output.write(reinterpret_cast<const char *>(summary.data()),
+               static_cast<std::streamsize>(summary.size()));
+  output.flush();
+  if (!output) {
+    throw recovery_error(path, "the summary could not be written");
+  }
+
+  McapRecovery result = builder.result;
+  result.data_end = data_end;
+  result.truncated_size = file_size - data_end;
+  return result;
+}
+
+}  // namespace rosbag2_storage_plugins
@@ -0,0 +1,61 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__MCAP_RECOVERY_HPP_
+#define ROSBAG2_STORAGE_MCAP__MCAP_RECOVERY_HPP_
+
+#include <mcap/reader.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace rosbag2_storage_plugins
+{
+
+struct McapRecovery
+{
+  // Size of the data section which was kept, the summary follows it
+  uint64_t data_end = 0;
+  // Bytes of incomplete records which were cut off
+  uint64_t truncated_size = 0;
+  uint64_t chunk_count = 0;
+  // Chunks which were decompressed to find their channels or count their messages
+  uint64_t decoded_chunk_count = 0;
+  uint64_t message_count = 0;
+};
+
+/**
+ * Rebuilds the summary section of an MCAP file whose recording was interrupted, in place.
+ *
+ * Only the headers of the records of the data section are read. Chunks are accounted for by their
+ * fields and by the message indexes following them, without reading their messages. A chunk is
+ * only decompressed if it is the first one with a channel, to read the channel and its schema, or
+ * if it has no message indexes, to count its messages. Messages outside of chunks are counted by
+ * their headers.
+ *
+ * The file is cut after its last complete record, and a summary section with schemas, channels,
+ * statistics, chunk indexes, metadata indexes and attachment indexes is appended, followed by the
+ * footer. The file must not be written while it is recovered.
+ *
+ * \param on_problem Called for records which are skipped.
+ * \return Nothing if the file ends with a footer already, it is not changed then.
+ * \throws std::runtime_error if the file is not an MCAP file or could not be read or written.
+ */
+std::optional<McapRecovery> recover_mcap_summary(const std::string & path,
+                                                 const mcap::ProblemCallback & on_problem);
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__MCAP_RECOVERY_HPP_
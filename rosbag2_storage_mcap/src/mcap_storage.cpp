@@ -13,9 +13,15 @@
 // limitations under the License.
 
 #include "rcutils/logging_macros.h"
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  #include "rosbag2_storage/durability_policy.hpp"
+#endif
+#include "rosbag2_storage/interned_topic.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 #include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+#include "rosbag2_storage/time_index.hpp"
+#include "rosbag2_storage/topic_filter.hpp"
 #include "rosbag2_storage_mcap/visibility_control.hpp"
 
 #ifdef ROSBAG2_STORAGE_MCAP_HAS_YAML_HPP
@@ -38,17 +44,34 @@
 
 #include <mcap/mcap.hpp>
 
+#include "cached_message_reader.hpp"
+#include "chunk_cache.hpp"
+#include "chunk_copier.hpp"
+#include "chunk_decoder.hpp"
+#include "mapped_file_reader.hpp"
+#include "mcap_recovery.hpp"
+#include "message_sampler.hpp"
+#include "pipelined_mcap_writer.hpp"
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_READABLE_FILE
+  #include "readable_file_reader.hpp"
+#endif
+#ifndef _WIN32
+  #include "bag_file_writer.hpp"
+#endif
+
 #include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <system_error>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
-#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_FILTER_TOPIC_REGEX
-  #include <regex>
-#endif
 
 // This is necessary because of using stl types here. It is completely safe, because
 // a) the member is not accessible from the outside
@@ -89,13 +112,47 @@
 
 namespace
 {
-// Simple wrapper with default constructor for use by YAML
+// Simple wrapper with default constructor for use by YAML, which also holds the options of
+// the file the MCAP writer writes to.
 struct McapWriterOptions : mcap::McapWriterOptions
 {
   McapWriterOptions()
       : mcap::McapWriterOptions("ros2")
   {
   }
+
+  // Write the file with direct I/O, bypassing the page cache
+  bool directIO = false;
+  // Write this many buffers of the file asynchronously with io_uring
+  size_t asyncWriteBuffers = 0;
+  // Compress chunks on this many threads instead of the thread writing messages
+  size_t compressionThreads = 0;
+  // Topics written to chunks of their own, with their chunk size or 0 for chunkSize
+  std::map<std::string, uint64_t> topicChunkSizes;
+  // Topics writing more bytes per second of log time are moved to chunks of their own
+  uint64_t separateChunkBitrate = 0;
+  // Close chunks whose messages span this many milliseconds of log time, even if not full
+  uint64_t maxChunkDuration = 0;
+
+  bool groups_chunks() const
+  {
+    return !noChunking && (!topicChunkSizes.empty() || separateChunkBitrate > 0);
+  }
+};
+
+// Options of the MCAP reader, read from the same storage config file as the writer options
+struct McapReaderOptions
+{
+  // Budget in bytes for decompressed chunks kept for seeking and reverse reads, 0 disables caching
+  uint64_t chunkCacheSize = 0;
+  // Decompress chunks on this many threads instead of the thread reading messages
+  size_t decompressionThreads = 0;
+  // Chunks decompressed ahead of the ones being read, 0 for twice the decompression threads
+  size_t readAheadChunks = 0;
+  // Skip chunks whose records do not match their CRC, if they have one
+  bool validateChunkCRC = false;
+  // Rebuild the summary section of a file without footer in place before reading it
+  bool recoverSummary = false;
 };
 }  // namespace
 
@@ -148,6 +205,27 @@ struct convert<McapWriterOptions>
     optional_assign<bool>(node, "noChunkIndex", o.noChunkIndex);
     optional_assign<bool>(node, "noStatistics", o.noStatistics);
     optional_assign<bool>(node, "noSummaryOffsets", o.noSummaryOffsets);
+    optional_assign<bool>(node, "directIO", o.directIO);
+    optional_assign<size_t>(node, "asyncWriteBuffers", o.asyncWriteBuffers);
+    optional_assign<size_t>(node, "compressionThreads", o.compressionThreads);
+    optional_assign<std::map<std::string, uint64_t>>(node, "topicChunkSizes", o.topicChunkSizes);
+    optional_assign<uint64_t>(node, "separateChunkBitrate", o.separateChunkBitrate);
+    optional_assign<uint64_t>(node, "maxChunkDuration", o.maxChunkDuration);
+    return true;
+  }
+};
+
+template <>
+struct convert<McapReaderOptions>
+{
+  // NOTE: when updating this struct, also update documentation in README.md
+  static bool decode(const Node & node, McapReaderOptions & o)
+  {
+    optional_assign<uint64_t>(node, "chunkCacheSize", o.chunkCacheSize);
+    optional_assign<size_t>(node, "decompressionThreads", o.decompressionThreads);
+    optional_assign<size_t>(node, "readAheadChunks", o.readAheadChunks);
+    optional_assign<bool>(node, "validateChunkCRC", o.validateChunkCRC);
+    optional_assign<bool>(node, "recoverSummary", o.recoverSummary);
     return true;
   }
 };
@@ -159,12 +237,76 @@ using mcap::ByteOffset;
 using time_point = std::chrono::time_point<std::chrono::high_resolution_clock>;
 static const char FILE_EXTENSION[] = ".mcap";
 static const char LOG_NAME[] = "rosbag2_storage_mcap";
+// Name of the metadata record holding the time index of files with unchunked messages
+static const char TIME_INDEX_METADATA_NAME[] = "rosbag2_time_index";
 
 static void OnProblem(const mcap::Status & status)
 {
   RCUTILS_LOG_ERROR_NAMED(LOG_NAME, "%s", status.message.c_str());
 }
 
+// Used while following a file which is still recorded, whose last record may be incomplete
+static void OnProblemAtTail(const mcap::Status & status)
+{
+  RCUTILS_LOG_DEBUG_NAMED(LOG_NAME, "%s", status.message.c_str());
+}
+
+/**
+ * mcap::IReadable of a file the storage opened itself, memory-mapped if possible.
+ *
+ * The file can be opened again to read the bytes appended to it while it is recorded, without
+ * opening the McapReader again, which keeps the channels and schemas it read so far.
+ */
+class FileSource final : public mcap::IReadable
+{
+public:
+  explicit FileSource(std::string path)
+      : path_(std::move(path))
+  {
+    reopen();
+  }
+
+  void reopen()
+  {
+    mapped_file_ = nullptr;
+    try {
+      auto mapped_file = std::make_unique<MappedFileReader>(path_);
+      mapped_file_ = mapped_file.get();
+      source_ = std::move(mapped_file);
+      input_.reset();
+      return;
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_DEBUG_NAMED(LOG_NAME, "Reading %s without memory mapping: %s", path_.c_str(),
+                              e.what());
+    }
+    auto input = std::make_unique<std::ifstream>(path_, std::ios::binary);
+    source_ = std::make_unique<mcap::FileStreamReader>(*input);
+    input_ = std::move(input);
+  }
+
+  uint64_t size() const override
+  {
+    return source_->size();
+  }
+
+  uint64_t read(std::byte ** output, uint64_t offset, uint64_t size) override
+  {
+    return source_->read(output, offset, size);
+  }
+
+  /// \return the memory-mapped file, nullptr if the file is read with a stream.
+  const MappedFileReader * mapped_file() const
+  {
+    return mapped_file_;
+  }
+
+private:
+  std::string path_;
+  std::unique_ptr<std::ifstream> input_;
+  std::unique_ptr<mcap::IReadable> source_;
+  const MappedFileReader * mapped_file_ = nullptr;
+};
+
 /**
  * A storage implementation for the MCAP file format.
  */
@@ -187,6 +329,7 @@ public:
             rosbag2_storage::storage_interfaces::IOFlag io_flag =
               rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE) override;
 #endif
+  bool probe(const std::string & uri) const override;
 
   /** BaseInfoInterface **/
   rosbag2_storage::BagMetadata get_metadata() override;
@@ -200,6 +343,9 @@ public:
 #endif
   bool has_next() override;
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0) override;
+  void for_each(const rosbag2_storage::MessageViewCallback & callback) override;
   std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override;
   void get_all_message_definitions(
     std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
@@ -212,9 +358,20 @@ public:
 #else
   void seek(const rcutils_time_point_value_t & timestamp);
 #endif
+  rosbag2_storage::TimeIndex get_time_index() override;
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+  /// Parse the records appended since the last read, starting at the chunk or record of the last
+  /// read message. Only supported in file order, for files the storage opened itself.
+  bool refresh() override;
+  /// Decode every chunk listed in the summary, or found by scanning the file if it has none, and
+  /// check its CRC. Damage is located to the byte and time range of its chunk.
+  rosbag2_storage::FileVerification verify() override;
 
   /** ReadWriteInterface **/
   uint64_t get_minimum_split_file_size() const override;
+  std::optional<rosbag2_storage::BagMetadata> copy_file(
+    const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter) override;
 
   /** BaseWriteInterface **/
   void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg) override;
@@ -226,18 +383,40 @@ public:
 #ifdef ROSBAG2_STORAGE_MCAP_HAS_UPDATE_METADATA
   void update_metadata(const rosbag2_storage::BagMetadata &) override;
 #endif
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  void commit_if_due() override;
+#endif
 
 private:
+  struct ChannelState
+  {
+    mcap::ChannelId id;
+    // Sequence number of the next message of the channel which has none of its own
+    uint32_t next_sequence = 1;
+    // Whether the messages are written to chunks of their own
+    bool separate_chunks = false;
+    // Bytes written since the first message, to compare against separateChunkBitrate
+    uint64_t written_bytes = 0;
+    mcap::Timestamp first_log_time = 0;
+  };
+
   void read_metadata();
   void open_impl(const std::string & uri, const std::string & preset_profile,
                  rosbag2_storage::storage_interfaces::IOFlag io_flag,
-                 const std::string & storage_config_uri);
+                 const std::string & storage_config_uri, uint64_t preallocate_size,
+                 bool metadata_only, std::unique_ptr<mcap::IReadable> readable_file);
+  void open_writer(bool pipelined);
 
   void reset_iterator();
   bool read_and_enqueue_message();
+  void enqueue_message(const mcap::Message & message, const mcap::Channel & channel,
+                       const mcap::RecordOffset & offset);
   bool enqueued_message_is_already_read();
   bool message_indexes_present();
+  void recover_summary();
   void ensure_summary_read();
+  void write_time_index();
+  void update_chunk_grouping(ChannelState & channel, const mcap::Message & message);
 
   std::optional<rosbag2_storage::storage_interfaces::IOFlag> opened_as_;
   std::string relative_path_;
@@ -247,19 +426,55 @@ private:
   rosbag2_storage::BagMetadata metadata_{};
   std::unordered_map<std::string, rosbag2_storage::TopicInformation> topics_;
   std::unordered_map<std::string, mcap::SchemaId> schema_ids_;    // datatype -> schema_id
-  std::unordered_map<std::string, mcap::ChannelId> channel_ids_;  // topic -> channel_id
-  rosbag2_storage::StorageFilter storage_filter_{};
+  std::unordered_map<std::string, ChannelState> channels_;  // topic -> channel
+  rosbag2_storage::TopicFilter topic_filter_;
+  // Inclusive start and exclusive end of the time range selected by the filter
+  mcap::Timestamp start_time_ = 0;
+  mcap::Timestamp end_time_ = mcap::MaxTime;
+  // Messages selected by the sampling of the filter, unset if all messages are read
+  std::shared_ptr<const SampledMessages> samples_;
+  // Shared topic records of the channels read from, looked up once per channel
+  std::unordered_map<mcap::ChannelId, const rosbag2_storage::InternedTopic *> interned_topics_;
   mcap::ReadMessageOptions::ReadOrder read_order_ = mcap::ReadMessageOptions::ReadOrder::FileOrder;
 
-  std::unique_ptr<std::ifstream> input_;
-  std::unique_ptr<mcap::FileStreamReader> data_source_;
+  std::unique_ptr<mcap::IReadable> data_source_;
+  // Set if data_source_ is the file opened by the storage, which refresh() opens again
+  FileSource * file_source_ = nullptr;
+  // Set if data_source_ reads a memory-mapped file
+  const MappedFileReader * mapped_file_ = nullptr;
   std::unique_ptr<mcap::McapReader> mcap_reader_;
   std::unique_ptr<mcap::LinearMessageView> linear_view_;
   std::unique_ptr<mcap::LinearMessageView::Iterator> linear_iterator_;
-
+  // Used instead of linear_view_ for indexed files if decompressed chunks are cached, chunks
+  // are decompressed on multiple threads or messages are sampled
+  std::unique_ptr<ChunkCache> chunk_cache_;
+  std::unique_ptr<ChunkDecoder> chunk_decoder_;
+  size_t read_ahead_chunks_ = 0;
+  std::unique_ptr<CachedMessageReader> cached_reader_;
+
+#ifndef _WIN32
+  // Used instead of the file writer of mcap_writer_ for pre-allocation and direct I/O
+  std::unique_ptr<BagFileWriter> file_writer_;
+#endif
   std::unique_ptr<mcap::McapWriter> mcap_writer_;
+  // Used instead of mcap_writer_ if chunks are compressed on multiple threads or copied
+  std::unique_ptr<PipelinedMcapWriter> pipelined_writer_;
+  McapWriterOptions writer_options_;
+  uint64_t preallocate_size_ = 0;
+  // Log time of the first message written by mcap_writer_ since it closed a chunk on age
+  std::optional<mcap::Timestamp> chunk_start_time_;
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  // When due, the open chunks are written and the file is synced
+  rosbag2_storage::DurabilityPolicy durability_policy_{0, 0};
+#endif
 
   bool has_read_summary_ = false;
+  // Built while unchunked messages are written, read from the file on first use when reading.
+  // Chunked files are positioned by their chunk indexes instead.
+  rosbag2_storage::TimeIndex time_index_;
+  bool has_read_time_index_ = false;
+  // Opened to read the metadata only, which has to be found in the summary section
+  bool metadata_only_ = false;
   rcutils_time_point_value_t last_read_time_point_ = 0;
   std::optional<mcap::RecordOffset> last_read_message_offset_;
   std::optional<mcap::RecordOffset> last_enqueued_message_offset_;
@@ -276,12 +491,13 @@ MCAPStorage::~MCAPStorage()
   if (mcap_reader_) {
     mcap_reader_->close();
   }
-  if (input_) {
-    input_->close();
-  }
   if (mcap_writer_) {
+    write_time_index();
     mcap_writer_->close();
   }
+  if (pipelined_writer_) {
+    pipelined_writer_->close();
+  }
 }
 
 /** BaseIOInterface **/
@@ -289,14 +505,39 @@ MCAPStorage::~MCAPStorage()
 void MCAPStorage::open(const rosbag2_storage::StorageOptions & storage_options,
                        rosbag2_storage::storage_interfaces::IOFlag io_flag)
 {
+  const uint64_t preallocate_size =
+    storage_options.preallocate_bagfiles ? storage_options.max_bagfile_size : 0;
+  std::unique_ptr<mcap::IReadable> readable_file;
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_READABLE_FILE
+  if (storage_options.readable_file) {
+    readable_file = std::make_unique<ReadableFileReader>(storage_options.readable_file);
+  }
+#endif
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  durability_policy_ = rosbag2_storage::DurabilityPolicy(storage_options);
+#endif
   open_impl(storage_options.uri, storage_options.storage_preset_profile, io_flag,
-            storage_options.storage_config_uri);
+            storage_options.storage_config_uri, preallocate_size, storage_options.metadata_only,
+            std::move(readable_file));
 }
 #endif
 
 void MCAPStorage::open(const std::string & uri, rosbag2_storage::storage_interfaces::IOFlag io_flag)
 {
-  open_impl(uri, "", io_flag, "");
+  open_impl(uri, "", io_flag, "", 0, false, nullptr);
+}
+
+bool MCAPStorage::probe(const std::string & uri) const
+{
+  std::ifstream file(uri, std::ios::binary);
+  if (!file) {
+    // Leave it to open() to report why the file can not be read, or it is a readable_file
+    return true;
+  }
+  char magic[sizeof(mcap::Magic)] = {};
+  file.read(magic, sizeof(magic));
+  return file.gcount() == static_cast<std::streamsize>(sizeof(magic)) &&
+         std::memcmp(magic, mcap::Magic, sizeof(magic)) == 0;
 }
 
 static void SetOptionsForPreset(const std::string & preset_profile, McapWriterOptions & options)
@@ -322,20 +563,60 @@ static void SetOptionsForPreset(const std::string & preset_profile, McapWriterOp
 
 void MCAPStorage::open_impl(const std::string & uri, const std::string & preset_profile,
                             rosbag2_storage::storage_interfaces::IOFlag io_flag,
-                            const std::string & storage_config_uri)
+                            const std::string & storage_config_uri,
+                            uint64_t preallocate_size, bool metadata_only,
+                            std::unique_ptr<mcap::IReadable> readable_file)
 {
   switch (io_flag) {
     case rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY: {
       relative_path_ = uri;
-      input_ = std::make_unique<std::ifstream>(relative_path_, std::ios::binary);
-      data_source_ = std::make_unique<mcap::FileStreamReader>(*input_);
+      metadata_only_ = metadata_only;
+      mapped_file_ = nullptr;
+      file_source_ = nullptr;
+      McapReaderOptions options;
+      if (!storage_config_uri.empty()) {
+        YAML::Node yaml_node = YAML::LoadFile(storage_config_uri);
+        YAML::convert<McapReaderOptions>::decode(yaml_node, options);
+      }
+      if (options.recoverSummary && !readable_file) {
+        recover_summary();
+      }
+      if (readable_file) {
+        data_source_ = std::move(readable_file);
+      } else {
+        auto file_source = std::make_unique<FileSource>(relative_path_);
+        file_source_ = file_source.get();
+        mapped_file_ = file_source->mapped_file();
+        data_source_ = std::move(file_source);
+      }
       mcap_reader_ = std::make_unique<mcap::McapReader>();
       auto status = mcap_reader_->open(*data_source_);
       if (!status.ok()) {
         throw std::runtime_error(status.message);
       }
+      cached_reader_.reset();
+      samples_.reset();
+      interned_topics_.clear();
+      chunk_cache_.reset();
+      chunk_decoder_.reset();
+      if (options.chunkCacheSize > 0 || options.decompressionThreads > 0 ||
+          options.validateChunkCRC) {
+        // Without a budget, the cache keeps no chunks
+        chunk_cache_ = std::make_unique<ChunkCache>(options.chunkCacheSize);
+        chunk_decoder_ =
+          std::make_unique<ChunkDecoder>(options.decompressionThreads, options.validateChunkCRC);
+        read_ahead_chunks_ = 0;
+        if (options.decompressionThreads > 0) {
+          read_ahead_chunks_ = options.readAheadChunks > 0 ? options.readAheadChunks
+                                                           : 2 * options.decompressionThreads;
+        }
+      }
       last_read_time_point_ = 0;
-      reset_iterator();
+      time_index_ = rosbag2_storage::TimeIndex();
+      has_read_time_index_ = false;
+      if (!metadata_only_) {
+        reset_iterator();
+      }
       break;
     }
     case rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE:
@@ -344,7 +625,6 @@ void MCAPStorage::open_impl(const std::string & uri, const std::string & preset_
       io_flag = rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE;
       relative_path_ = uri + FILE_EXTENSION;
 
-      mcap_writer_ = std::make_unique<mcap::McapWriter>();
       McapWriterOptions options;
       // Set defaults for the rosbag2 storage plugin specifically.
       options.noChunkCRC = true;
@@ -360,10 +640,24 @@ void MCAPStorage::open_impl(const std::string & uri, const std::string & preset_
         YAML::convert<McapWriterOptions>::decode(yaml_node, options);
       }
 
-      auto status = mcap_writer_->open(relative_path_, options);
-      if (!status.ok()) {
-        throw std::runtime_error(status.message);
+      // Only the pipelined writer keeps several chunks open at once. It also computes chunk CRCs
+      // off the recording thread.
+      const bool pipelined = (options.compressionThreads > 0 && !options.noChunking &&
+                              options.compression != mcap::Compression::None) ||
+                             (!options.noChunking && !options.noChunkCRC) ||
+                             options.groups_chunks();
+      if (!pipelined && options.compressionThreads > 0) {
+        RCUTILS_LOG_WARN_NAMED(LOG_NAME, "compressionThreads is ignored without chunk compression");
       }
+      if (options.noChunking &&
+          (!options.topicChunkSizes.empty() || options.separateChunkBitrate > 0)) {
+        RCUTILS_LOG_WARN_NAMED(LOG_NAME,
+                               "topicChunkSizes and separateChunkBitrate are ignored without "
+                               "chunking");
+      }
+      writer_options_ = options;
+      preallocate_size_ = preallocate_size;
+      open_writer(pipelined);
       break;
     }
   }
@@ -371,6 +665,55 @@ void MCAPStorage::open_impl(const std::string & uri, const std::string & preset_
   metadata_.relative_file_paths = {get_relative_file_path()};
 }
 
+void MCAPStorage::open_writer(bool pipelined)
+{
+  const McapWriterOptions & options = writer_options_;
+  if (pipelined) {
+    pipelined_writer_ = std::make_unique<PipelinedMcapWriter>();
+    pipelined_writer_->setMaxChunkDuration(options.maxChunkDuration * 1000000);
+  } else {
+    mcap_writer_ = std::make_unique<mcap::McapWriter>();
+  }
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  // Only BagFileWriter syncs the file
+  const bool sync_writes = durability_policy_.enabled();
+#else
+  const bool sync_writes = false;
+#endif
+  // The pipelined writer writes from its own thread, the buffer of BagFileWriter keeps the
+  // writes to the file large
+  if (pipelined || sync_writes || preallocate_size_ > 0 || options.directIO ||
+      options.asyncWriteBuffers > 0) {
+#ifndef _WIN32
+    file_writer_ = std::make_unique<BagFileWriter>();
+    file_writer_->open(relative_path_, preallocate_size_, options.directIO,
+                       options.asyncWriteBuffers);
+    if (pipelined_writer_) {
+      pipelined_writer_->open(*file_writer_, options, options.compressionThreads);
+    } else {
+      mcap_writer_->open(*file_writer_, options);
+    }
+    return;
+#else
+    if (preallocate_size_ > 0 || options.directIO || options.asyncWriteBuffers > 0) {
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Pre-allocation, direct I/O and asynchronous writes are "
+                                       "not supported on Windows");
+    }
+    if (sync_writes) {
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Syncing the bag file is not supported on Windows, the "
+                                       "durability policy only writes the open chunks");
+    }
+#endif
+  }
+  auto status = pipelined_writer_ ?
+                  pipelined_writer_->open(relative_path_, options, options.compressionThreads) :
+                  mcap_writer_->open(relative_path_, options);
+  if (!status.ok()) {
+    throw std::runtime_error(status.message);
+  }
+}
+
 void MCAPStorage::read_metadata()
 {
   ensure_summary_read();
@@ -480,6 +823,9 @@ uint64_t MCAPStorage::get_bagfile_size() const
   if (opened_as_ == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY) {
     return data_source_ ? data_source_->size() : 0;
   } else {
+    if (pipelined_writer_) {
+      return pipelined_writer_->size();
+    }
     if (!mcap_writer_) {
       return 0;
     }
@@ -496,6 +842,16 @@ std::string MCAPStorage::get_storage_identifier() const
 /** BaseReadInterface **/
 bool MCAPStorage::read_and_enqueue_message()
 {
+  if (cached_reader_) {
+    const auto entry = cached_reader_->next();
+    if (!entry) {
+      next_ = nullptr;
+      return false;
+    }
+    enqueue_message(*entry->message, *entry->channel, entry->offset);
+    return true;
+  }
+
   // The recording has not been opened.
   if (!linear_iterator_) {
     return false;
@@ -509,19 +865,47 @@ bool MCAPStorage::read_and_enqueue_message()
     return false;
   }
 
+  // Files without message indexes are read linearly, only the sampled messages are enqueued
+  while (samples_ && !samples_->contains(it->messageOffset)) {
+    if (++it == linear_view_->end()) {
+      next_ = nullptr;
+      return false;
+    }
+  }
   const auto & messageView = *it;
+  enqueue_message(messageView.message, *messageView.channel, messageView.messageOffset);
+  ++it;
+  return true;
+}
+
+void MCAPStorage::enqueue_message(const mcap::Message & message, const mcap::Channel & channel,
+                                  const mcap::RecordOffset & offset)
+{
   auto msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
-  last_enqueued_message_offset_ = messageView.messageOffset;
-  msg->time_stamp = rcutils_time_point_value_t(messageView.message.logTime);
-  msg->topic_name = messageView.channel->topic;
-  msg->serialized_data = rosbag2_storage::make_serialized_message(messageView.message.data,
-                                                                  messageView.message.dataSize);
+  last_enqueued_message_offset_ = offset;
+  msg->time_stamp = rcutils_time_point_value_t(message.logTime);
+  msg->send_timestamp = rcutils_time_point_value_t(message.publishTime);
+  msg->sequence_number = message.sequence;
+  auto & interned_topic = interned_topics_[channel.id];
+  if (!interned_topic) {
+    interned_topic = &rosbag2_storage::intern_topic(channel.topic);
+  }
+  msg->interned_topic = interned_topic;
+  msg->topic_name = interned_topic->name;
+  const std::byte * mapped_data =
+    mapped_file_ ? mapped_file_->find_message_data(message.data, message.dataSize, offset) :
+                   nullptr;
+  if (mapped_data) {
+    // Payloads of uncompressed chunks are handed out from the mapping, without a copy
+    msg->serialized_data = rosbag2_storage::make_serialized_message_view(
+      mapped_data, message.dataSize, mapped_file_->mapping());
+  } else {
+    // Decompressed payloads are copied, so that messages do not keep cached chunks alive
+    msg->serialized_data = rosbag2_storage::make_serialized_message(message.data, message.dataSize);
+  }
 
   // enqueue this message to be used
   next_ = msg;
-
-  ++it;
-  return true;
 }
 
 void MCAPStorage::reset_iterator()
@@ -529,39 +913,49 @@ void MCAPStorage::reset_iterator()
   ensure_summary_read();
   mcap::ReadMessageOptions options;
   if (read_order_ == mcap::ReadMessageOptions::ReadOrder::ReverseLogTimeOrder) {
-    options.startTime = 0;
+    options.startTime = start_time_;
     // endTime is an exclusive range endpoint, but we want to start from `last_read_time_point_`.
     // therefore, the time range we pass to the MCAP library is one nanosecond later than the
     // seek point specified.
-    options.endTime = mcap::Timestamp(last_read_time_point_ + 1);
+    options.endTime = std::min(mcap::Timestamp(last_read_time_point_ + 1), end_time_);
   } else {
-    options.startTime = mcap::Timestamp(last_read_time_point_);
-    options.endTime = mcap::MaxTime;
+    options.startTime = std::max(mcap::Timestamp(last_read_time_point_), start_time_);
+    options.endTime = end_time_;
   }
   options.readOrder = read_order_;
-  if (!storage_filter_.topics.empty()) {
+  if (!topic_filter_.selects_all()) {
+    // The filter remembers its result per topic, regular expressions are not matched again for
+    // every message or every seek
     options.topicFilter = [this](std::string_view topic) {
-      for (const auto & match_topic : storage_filter_.topics) {
-        if (match_topic == topic) {
-          return true;
-        }
-      }
-      return false;
+      return topic_filter_.matches(topic);
     };
   }
-#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_FILTER_TOPIC_REGEX
-  if (!storage_filter_.topics_regex.empty()) {
-    options.topicFilter = [this](std::string_view topic) {
-      std::smatch m;
-      std::string topic_string(topic);
-      std::regex re(storage_filter_.topics_regex);
-      return std::regex_match(topic_string, m, re);
-    };
+  if (chunk_cache_ && !mcap_reader_->chunkIndexes().empty()) {
+    // Chunks decompressed before the seek are taken from the cache. Chunks the previous reader
+    // requested ahead are cancelled first, the decoder then starts with the new ones.
+    cached_reader_.reset();
+    cached_reader_ = std::make_unique<CachedMessageReader>(
+      *mcap_reader_, *data_source_, mapped_file_ ? mapped_file_->mapping() : nullptr,
+      *chunk_cache_, *chunk_decoder_, read_ahead_chunks_, options, samples_, OnProblem);
+  } else {
+    std::optional<uint64_t> start_offset;
+    if (read_order_ == mcap::ReadMessageOptions::ReadOrder::FileOrder &&
+        mcap_reader_->chunkIndexes().empty()) {
+      start_offset = get_time_index().find_start_position(
+        static_cast<rcutils_time_point_value_t>(options.startTime));
+    }
+    if (start_offset) {
+      // The messages stored before the offset are all older than the start time
+      const auto [data_start, data_end] = mcap_reader_->byteRange(0);
+      linear_view_ = std::make_unique<mcap::LinearMessageView>(
+        *mcap_reader_, options, std::max<ByteOffset>(data_start, *start_offset), data_end,
+        OnProblem);
+    } else {
+      linear_view_ =
+        std::make_unique<mcap::LinearMessageView>(mcap_reader_->readMessages(OnProblem, options));
+    }
+    linear_iterator_ = std::make_unique<mcap::LinearMessageView::Iterator>(linear_view_->begin());
   }
-#endif
-  linear_view_ =
-    std::make_unique<mcap::LinearMessageView>(mcap_reader_->readMessages(OnProblem, options));
-  linear_iterator_ = std::make_unique<mcap::LinearMessageView::Iterator>(linear_view_->begin());
   if (!read_and_enqueue_message()) {
     return;
   }
@@ -592,10 +986,37 @@ bool MCAPStorage::enqueued_message_is_already_read()
   return (*last_enqueued_message_offset_ <= *last_read_message_offset_);
 }
 
+void MCAPStorage::recover_summary()
+{
+  const auto recovery = recover_mcap_summary(relative_path_, OnProblem);
+  if (recovery) {
+    RCUTILS_LOG_INFO_NAMED(
+      LOG_NAME,
+      "Recovered the summary of %s from %zu chunks, %zu of which were decompressed, with %zu "
+      "messages. %zu bytes of incomplete records were cut off.",
+      relative_path_.c_str(), static_cast<size_t>(recovery->chunk_count),
+      static_cast<size_t>(recovery->decoded_chunk_count),
+      static_cast<size_t>(recovery->message_count),
+      static_cast<size_t>(recovery->truncated_size));
+  }
+}
+
 void MCAPStorage::ensure_summary_read()
 {
   if (!has_read_summary_) {
-    const auto status = mcap_reader_->readSummary(mcap::ReadSummaryMethod::AllowFallbackScan);
+    // Without a summary section the statistics can only be reconstructed by reading every
+    // record, which is not done if only the metadata is wanted
+    const auto method = metadata_only_ ? mcap::ReadSummaryMethod::NoFallbackScan
+                                       : mcap::ReadSummaryMethod::AllowFallbackScan;
+    const auto status = mcap_reader_->readSummary(method);
+    if (metadata_only_ && (!status.ok() || !mcap_reader_->statistics())) {
+      throw std::runtime_error(
+        "Could not read the metadata of " + relative_path_ +
+        " from its summary section without scanning the whole file" +
+        (status.ok() ? std::string{} : ": " + status.message) +
+        ". Recover the file by reading it with the storage option 'recoverSummary: true', for "
+        "example with 'ros2 bag reindex --storage-config-file', or with 'mcap recover'.");
+    }
 
     if (!status.ok()) {
       throw std::runtime_error(status.message);
@@ -646,6 +1067,10 @@ bool MCAPStorage::set_read_order(const rosbag2_storage::ReadOrder & read_order)
       RCUTILS_LOG_WARN_NAMED(LOG_NAME, "publish timestamp order reading not implemented");
       return false;
       break;
+    case rosbag2_storage::ReadOrder::HeaderTimestamp:
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "header timestamp order requires the header stamp index");
+      return false;
+      break;
   }
   reset_iterator();
   return true;
@@ -654,7 +1079,7 @@ bool MCAPStorage::set_read_order(const rosbag2_storage::ReadOrder & read_order)
 
 bool MCAPStorage::has_next()
 {
-  if (!linear_iterator_) {
+  if (!linear_iterator_ && !cached_reader_) {
     return false;
   }
   // Have already verified next message and enqueued it for use.
@@ -676,6 +1101,82 @@ std::shared_ptr<rosbag2_storage::SerializedBagMessage> MCAPStorage::read_next()
   return std::move(next_);
 }
 
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> MCAPStorage::read_next_batch(
+  size_t max_messages, size_t max_bytes)
+{
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  if (max_messages > 0) {
+    messages.reserve(max_messages);
+  }
+  size_t bytes = 0;
+  while ((max_messages == 0 || messages.size() < max_messages) &&
+         (max_bytes == 0 || bytes < max_bytes) && has_next()) {
+    last_read_time_point_ = next_->time_stamp;
+    last_read_message_offset_ = last_enqueued_message_offset_;
+    bytes += next_->serialized_data->buffer_length;
+    messages.push_back(std::move(next_));
+  }
+  return messages;
+}
+
+void MCAPStorage::for_each(const rosbag2_storage::MessageViewCallback & callback)
+{
+  // The message enqueued by has_next() or a seek is handed out first
+  if (next_) {
+    const auto message = read_next();
+    rosbag2_storage::SerializedBagMessageView view;
+    view.data = message->serialized_data->buffer;
+    view.size = message->serialized_data->buffer_length;
+    view.time_stamp = message->time_stamp;
+    view.topic_name = message->topic_name;
+    view.send_timestamp = message->send_timestamp;
+    view.sequence_number = message->sequence_number;
+    if (!callback(view)) {
+      return;
+    }
+  }
+  // The other messages are handed out from the decoded chunks or the record buffer of the data
+  // source, without copying their data or topic names
+  rosbag2_storage::SerializedBagMessageView view;
+  const auto visit = [this, &callback, &view](const mcap::Message & message,
+                                              const mcap::Channel & channel,
+                                              const mcap::RecordOffset & offset) {
+    last_read_time_point_ = rcutils_time_point_value_t(message.logTime);
+    last_read_message_offset_ = offset;
+    last_enqueued_message_offset_ = offset;
+    view.data = reinterpret_cast<const uint8_t *>(message.data);
+    view.size = message.dataSize;
+    view.time_stamp = rcutils_time_point_value_t(message.logTime);
+    view.topic_name = channel.topic;
+    view.send_timestamp = rcutils_time_point_value_t(message.publishTime);
+    view.sequence_number = message.sequence;
+    return callback(view);
+  };
+  if (cached_reader_) {
+    while (const auto entry = cached_reader_->next()) {
+      if (!visit(*entry->message, *entry->channel, entry->offset)) {
+        return;
+      }
+    }
+    return;
+  }
+  if (!linear_iterator_) {
+    return;
+  }
+  auto & it = *linear_iterator_;
+  while (it != linear_view_->end()) {
+    const auto & message_view = *it;
+    const bool proceed = (samples_ && !samples_->contains(message_view.messageOffset)) ||
+                         visit(message_view.message, *message_view.channel,
+                               message_view.messageOffset);
+    // The message is only valid until the iterator advances
+    ++it;
+    if (!proceed) {
+      return;
+    }
+  }
+}
+
 std::vector<rosbag2_storage::TopicMetadata> MCAPStorage::get_all_topics_and_types()
 {
   auto metadata = get_metadata();
@@ -708,7 +1209,32 @@ void MCAPStorage::get_all_message_definitions(
 /** ReadOnlyInterface **/
 void MCAPStorage::set_filter(const rosbag2_storage::StorageFilter & storage_filter)
 {
-  storage_filter_ = storage_filter;
+  topic_filter_ = rosbag2_storage::TopicFilter(storage_filter);
+  // Chunks outside of the time range are not read at all
+  start_time_ = storage_filter.start_time_ns >= 0 ? mcap::Timestamp(storage_filter.start_time_ns)
+                                                  : 0;
+  end_time_ = storage_filter.end_time_ns >= 0 ? mcap::Timestamp(storage_filter.end_time_ns) + 1
+                                              : mcap::MaxTime;
+  samples_.reset();
+  if (storage_filter.sample_interval_ns > 0 || storage_filter.sample_stride > 1) {
+    ensure_summary_read();
+    mcap::ReadMessageOptions options;
+    options.startTime = start_time_;
+    options.endTime = end_time_;
+    if (!topic_filter_.selects_all()) {
+      options.topicFilter = [this](std::string_view topic) {
+        return topic_filter_.matches(topic);
+      };
+    }
+    samples_ = sample_messages(*mcap_reader_, *data_source_, options, storage_filter.sample_stride,
+                               storage_filter.sample_interval_ns, OnProblem);
+    if (!chunk_cache_) {
+      // Indexed files are read through the chunk indexes, so that chunks without samples are not
+      // decompressed. The cache keeps no chunks without a budget.
+      chunk_cache_ = std::make_unique<ChunkCache>(0);
+      chunk_decoder_ = std::make_unique<ChunkDecoder>(0);
+    }
+  }
   reset_iterator();
 }
 
@@ -726,12 +1252,402 @@ void MCAPStorage::seek(const rcutils_time_point_value_t & time_stamp)
   reset_iterator();
 }
 
+bool MCAPStorage::refresh()
+{
+  // Messages appended since the filter was set are not sampled
+  if (opened_as_ != rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY || !file_source_ ||
+      metadata_only_ || samples_ ||
+      read_order_ != mcap::ReadMessageOptions::ReadOrder::FileOrder) {
+    return false;
+  }
+  std::error_code ec;
+  const auto file_size = std::filesystem::file_size(relative_path_, ec);
+  if (ec || file_size <= data_source_->size()) {
+    return true;
+  }
+  ensure_summary_read();
+  cached_reader_.reset();
+  linear_iterator_.reset();
+  linear_view_.reset();
+  next_ = nullptr;
+  // The McapReader keeps reading from the file source, so the channels and schemas of the records
+  // before the resume offset stay known
+  file_source_->reopen();
+  mapped_file_ = file_source_->mapped_file();
+
+  // Parsing resumes at the chunk of the last read message, or at its record if it is not in a
+  // chunk. The messages appended since may have earlier time stamps than the last read one.
+  ByteOffset resume_offset = mcap_reader_->byteRange(0).first;
+  if (last_read_message_offset_) {
+    resume_offset = last_read_message_offset_->chunkOffset ? *last_read_message_offset_->chunkOffset
+                                                           : last_read_message_offset_->offset;
+  }
+  mcap::ReadMessageOptions options;
+  options.startTime = start_time_;
+  options.endTime = end_time_;
+  options.readOrder = read_order_;
+  if (!topic_filter_.selects_all()) {
+    options.topicFilter = [this](std::string_view topic) {
+      return topic_filter_.matches(topic);
+    };
+  }
+  linear_view_ = std::make_unique<mcap::LinearMessageView>(
+    *mcap_reader_, options, resume_offset, data_source_->size(), OnProblemAtTail);
+  linear_iterator_ = std::make_unique<mcap::LinearMessageView::Iterator>(linear_view_->begin());
+  // In file order, all messages before the last read one were returned already
+  bool enqueued = read_and_enqueue_message();
+  while (enqueued && last_read_message_offset_ &&
+         *last_enqueued_message_offset_ <= *last_read_message_offset_) {
+    enqueued = read_and_enqueue_message();
+  }
+  return true;
+}
+
+rosbag2_storage::TimeIndex MCAPStorage::get_time_index()
+{
+  if (!mcap_reader_ || has_read_time_index_) {
+    return time_index_;
+  }
+  has_read_time_index_ = true;
+  ensure_summary_read();
+  const auto range = mcap_reader_->metadataIndexes().equal_range(TIME_INDEX_METADATA_NAME);
+  for (auto i = range.first; i != range.second; ++i) {
+    mcap::Record mcap_record{};
+    mcap::Metadata mcap_metadata{};
+    auto status = mcap::McapReader::ReadRecord(*data_source_, i->second.offset, &mcap_record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseMetadata(mcap_record, &mcap_metadata);
+    }
+    if (!status.ok()) {
+      OnProblem(status);
+      continue;
+    }
+    try {
+      time_index_ = rosbag2_storage::TimeIndex::deserialize(mcap_metadata.metadata.at("entries"));
+    } catch (const std::exception & e) {
+      RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Ignoring time index of %s: %s", relative_path_.c_str(),
+                             e.what());
+    }
+  }
+  return time_index_;
+}
+
+rosbag2_storage::ReadEstimate MCAPStorage::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (!mcap_reader_ || !message_indexes_present()) {
+    return ReadOnlyInterface::estimate(storage_filter);
+  }
+  // Opcode, record length, channel id, sequence number, log time and publish time
+  constexpr uint64_t kMessageRecordOverhead = 1 + 8 + 2 + 4 + 8 + 8;
+
+  rosbag2_storage::TopicFilter topic_filter(storage_filter);
+  std::unordered_set<mcap::ChannelId> channel_ids;
+  for (const auto & [channel_id, channel] : mcap_reader_->channels()) {
+    if (topic_filter.matches(channel->topic)) {
+      channel_ids.insert(channel_id);
+    }
+  }
+  const mcap::Timestamp start_time =
+    storage_filter.start_time_ns >= 0 ? mcap::Timestamp(storage_filter.start_time_ns) : 0;
+  const mcap::Timestamp end_time = storage_filter.end_time_ns >= 0 ?
+                                     mcap::Timestamp(storage_filter.end_time_ns) + 1 :
+                                     mcap::MaxTime;
+  std::shared_ptr<const SampledMessages> samples;
+  if (storage_filter.sample_interval_ns > 0 || storage_filter.sample_stride > 1) {
+    mcap::ReadMessageOptions options;
+    options.startTime = start_time;
+    options.endTime = end_time;
+    options.topicFilter = [&topic_filter](std::string_view topic) {
+      return topic_filter.matches(topic);
+    };
+    samples = sample_messages(*mcap_reader_, *data_source_, options, storage_filter.sample_stride,
+                              storage_filter.sample_interval_ns, OnProblem);
+  }
+
+  // Messages are counted from the message indexes of the chunks, without reading the chunks.
+  // The size of a message is the distance of its record to the next record in the chunk.
+  rosbag2_storage::ReadEstimate estimate;
+  estimate.exact = true;
+  std::vector<std::pair<mcap::ByteOffset, bool>> message_offsets;
+  for (const auto & chunk_index : mcap_reader_->chunkIndexes()) {
+    if (chunk_index.messageEndTime < start_time || chunk_index.messageStartTime >= end_time ||
+        std::none_of(chunk_index.messageIndexOffsets.begin(),
+                     chunk_index.messageIndexOffsets.end(), [&channel_ids](const auto & entry) {
+                       return channel_ids.count(entry.first) > 0;
+                     })) {
+      continue;
+    }
+    message_offsets.clear();
+    for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+      mcap::Record record{};
+      mcap::MessageIndex message_index{};
+      auto status = mcap::McapReader::ReadRecord(*data_source_, message_index_offset, &record);
+      if (status.ok()) {
+        status = mcap::McapReader::ParseMessageIndex(record, &message_index);
+      }
+      if (!status.ok()) {
+        OnProblem(status);
+        return ReadOnlyInterface::estimate(storage_filter);
+      }
+      const bool selected_channel = channel_ids.count(channel_id) > 0;
+      for (const auto & [log_time, message_offset] : message_index.records) {
+        message_offsets.emplace_back(
+          message_offset,
+          selected_channel && log_time >= start_time && log_time < end_time &&
+            (!samples ||
+             samples->contains(mcap::RecordOffset{message_offset, chunk_index.chunkStartOffset})));
+      }
+    }
+    std::sort(message_offsets.begin(), message_offsets.end());
+    for (size_t i = 0; i < message_offsets.size(); ++i) {
+      if (!message_offsets[i].second) {
+        continue;
+      }
+      const mcap::ByteOffset record_end = i + 1 < message_offsets.size() ?
+                                            message_offsets[i + 1].first :
+                                            chunk_index.uncompressedSize;
+      const uint64_t record_size = record_end - message_offsets[i].first;
+      ++estimate.message_count;
+      estimate.bytes += record_size > kMessageRecordOverhead ? record_size - kMessageRecordOverhead
+                                                             : 0;
+    }
+  }
+  return estimate;
+}
+
+rosbag2_storage::FileVerification MCAPStorage::verify()
+{
+  if (!mcap_reader_) {
+    return ReadOnlyInterface::verify();
+  }
+  rosbag2_storage::FileVerification verification;
+  try {
+    ensure_summary_read();
+  } catch (const std::exception & e) {
+    rosbag2_storage::IntegrityProblem problem;
+    problem.description = e.what();
+    verification.problems.push_back(std::move(problem));
+    return verification;
+  }
+  if (mcap_reader_->chunkIndexes().empty()) {
+    // Messages outside of chunks have no CRC of their own
+    return ReadOnlyInterface::verify();
+  }
+
+  std::unordered_map<mcap::ChannelId, uint64_t> channel_message_counts;
+  ChunkDecoder decoder(0, true);
+  verification.checked = true;
+  for (const auto & chunk_index : mcap_reader_->chunkIndexes()) {
+    rosbag2_storage::IntegrityProblem chunk_problem;
+    chunk_problem.start_offset = chunk_index.chunkStartOffset;
+    chunk_problem.end_offset = chunk_index.chunkStartOffset + chunk_index.chunkLength;
+    chunk_problem.start_time = static_cast<rcutils_time_point_value_t>(
+      chunk_index.messageStartTime);
+    chunk_problem.end_time = static_cast<rcutils_time_point_value_t>(chunk_index.messageEndTime);
+
+    mcap::Record record{};
+    mcap::Chunk chunk{};
+    auto status = mcap::McapReader::ReadRecord(*data_source_, chunk_index.chunkStartOffset,
+                                               &record);
+    if (status.ok()) {
+      status = mcap::McapReader::ParseChunk(record, &chunk);
+    }
+    if (!status.ok()) {
+      chunk_problem.description = status.message;
+      verification.problems.push_back(std::move(chunk_problem));
+      continue;
+    }
+    // Chunks written without a CRC can only be checked for being decodable
+    verification.checked = verification.checked && chunk.uncompressedCrc != 0;
+    const auto result = decoder.decode(chunk, chunk_index.chunkStartOffset, nullptr).get();
+    for (const auto & problem : result.problems) {
+      chunk_problem.description = problem.message;
+      verification.problems.push_back(chunk_problem);
+    }
+    if (result.chunk) {
+      for (const auto & message : result.chunk->messages) {
+        ++channel_message_counts[message.message.channelId];
+      }
+    }
+  }
+
+  const auto & channels = mcap_reader_->channels();
+  for (const auto & [channel_id, count] : channel_message_counts) {
+    const auto channel = channels.find(channel_id);
+    if (channel == channels.end()) {
+      rosbag2_storage::IntegrityProblem problem;
+      problem.description = std::to_string(count) + " messages reference the unknown channel " +
+                            std::to_string(channel_id);
+      verification.problems.push_back(std::move(problem));
+      continue;
+    }
+    verification.topic_message_counts[channel->second->topic] += count;
+  }
+  // Damaged chunks already explain counts below the statistics
+  const auto & statistics = mcap_reader_->statistics();
+  if (verification.problems.empty() && statistics) {
+    for (const auto & [channel_id, count] : statistics->channelMessageCounts) {
+      const uint64_t found = channel_message_counts[channel_id];
+      if (found != count) {
+        rosbag2_storage::IntegrityProblem problem;
+        problem.description = "The summary counts " + std::to_string(count) +
+                              " messages of channel " + std::to_string(channel_id) + ", " +
+                              std::to_string(found) + " were found in the chunks";
+        verification.problems.push_back(std::move(problem));
+      }
+    }
+  }
+  return verification;
+}
+
+void MCAPStorage::update_chunk_grouping(ChannelState & channel, const mcap::Message & message)
+{
+  // The data rate is averaged over at least a second of log time, so that bursts at the start
+  // of a topic do not move it
+  constexpr mcap::Timestamp kMinMeasuredDuration = 1000000000;
+  if (channel.written_bytes == 0) {
+    channel.first_log_time = message.logTime;
+  }
+  channel.written_bytes += message.dataSize;
+  const mcap::Timestamp duration =
+    message.logTime > channel.first_log_time ? message.logTime - channel.first_log_time : 0;
+  if (duration < kMinMeasuredDuration) {
+    return;
+  }
+  const double bytes_per_second = static_cast<double>(channel.written_bytes) * 1e9 /
+                                  static_cast<double>(duration);
+  if (bytes_per_second > static_cast<double>(writer_options_.separateChunkBitrate)) {
+    pipelined_writer_->setChannelChunkSize(channel.id, writer_options_.chunkSize);
+    channel.separate_chunks = true;
+  }
+}
+
+void MCAPStorage::write_time_index()
+{
+  if (time_index_.empty()) {
+    return;
+  }
+  mcap::Metadata metadata;
+  metadata.name = TIME_INDEX_METADATA_NAME;
+  metadata.metadata = {{"entries", time_index_.serialize()}};
+  const auto status = mcap_writer_->write(metadata);
+  if (!status.ok()) {
+    OnProblem(status);
+  }
+}
+
 /** ReadWriteInterface **/
 uint64_t MCAPStorage::get_minimum_split_file_size() const
 {
   return 1024;
 }
 
+std::optional<rosbag2_storage::BagMetadata> MCAPStorage::copy_file(
+  const std::string & uri, const rosbag2_storage::StorageFilter & storage_filter)
+{
+  if (opened_as_ != rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE || !topics_.empty() ||
+      metadata_.message_count > 0 || writer_options_.noChunking) {
+    return std::nullopt;
+  }
+  MCAPStorage input;
+  rosbag2_storage::BagMetadata input_metadata;
+  try {
+    input.open_impl(uri, "", rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY, "", 0, true,
+                    nullptr);
+    input_metadata = input.get_metadata();
+  } catch (const std::exception & e) {
+    RCUTILS_LOG_DEBUG_NAMED(LOG_NAME, "Not copying chunks of %s: %s", uri.c_str(), e.what());
+    return std::nullopt;
+  }
+  auto & reader = *input.mcap_reader_;
+  if (reader.chunkIndexes().empty()) {
+    return std::nullopt;
+  }
+
+  rosbag2_storage::TopicFilter topic_filter(storage_filter);
+  std::unordered_map<std::string, rosbag2_storage::TopicInformation> topics;
+  for (const auto & topic : input_metadata.topics_with_message_count) {
+    if (topic_filter.matches(topic.topic_metadata.name)) {
+      topics.emplace(topic.topic_metadata.name, rosbag2_storage::TopicInformation{
+                                                  topic.topic_metadata, 0});
+    }
+  }
+  std::vector<mcap::SchemaPtr> schemas;
+  std::vector<mcap::ChannelPtr> channels;
+  for (const auto & [channel_id, channel] : reader.channels()) {
+    if (topics.count(channel->topic) == 0) {
+      continue;
+    }
+    const auto schema = reader.schema(channel->schemaId);
+    if (channel_id == 0 || !schema) {
+      return std::nullopt;
+    }
+    channels.push_back(channel);
+    if (std::none_of(schemas.begin(), schemas.end(), [&schema](const mcap::SchemaPtr & s) {
+          return s->id == schema->id;
+        })) {
+      schemas.push_back(schema);
+    }
+  }
+
+  if (mcap_writer_) {
+    // Only the pipelined writer writes chunks as they are. The file has no more than its header
+    // yet, so it is started over.
+    mcap_writer_->terminate();
+    mcap_writer_.reset();
+#ifndef _WIN32
+    file_writer_.reset();
+#endif
+    open_writer(true);
+  }
+
+  // Schemas and channels keep their ids, the records of the copied chunks refer to them
+  std::unordered_set<mcap::ChannelId> channel_ids;
+  std::unordered_map<mcap::ChannelId, std::string> topics_by_channel;
+  for (const auto & schema : schemas) {
+    pipelined_writer_->addSchemaWithId(*schema);
+    schema_ids_.emplace(schema->name, schema->id);
+  }
+  for (const auto & channel : channels) {
+    pipelined_writer_->addChannelWithId(*channel);
+    channels_.emplace(channel->topic, ChannelState{channel->id});
+    channel_ids.insert(channel->id);
+    topics_by_channel.emplace(channel->id, channel->topic);
+  }
+
+  const mcap::Timestamp start_time =
+    storage_filter.start_time_ns >= 0 ? mcap::Timestamp(storage_filter.start_time_ns) : 0;
+  const mcap::Timestamp end_time = storage_filter.end_time_ns >= 0 ?
+                                     mcap::Timestamp(storage_filter.end_time_ns) + 1 :
+                                     mcap::MaxTime;
+  ChunkCopier copier(reader, *input.data_source_,
+                     input.mapped_file_ ? input.mapped_file_->mapping() : nullptr, OnProblem);
+  const auto result = copier.copy(channel_ids, start_time, end_time, *pipelined_writer_);
+  RCUTILS_LOG_DEBUG_NAMED(LOG_NAME, "Copied %zu chunks of %s as they are and decoded %zu",
+                          result.copied_chunks, uri.c_str(), result.decoded_chunks);
+
+  const auto & statistics = result.statistics;
+  for (const auto & [channel_id, message_count] : statistics.channelMessageCounts) {
+    topics.at(topics_by_channel.at(channel_id)).message_count += message_count;
+  }
+  rosbag2_storage::BagMetadata copied;
+  copied.message_count = statistics.messageCount;
+  copied.starting_time = time_point(std::chrono::nanoseconds(statistics.messageStartTime));
+  copied.duration =
+    std::chrono::nanoseconds(statistics.messageEndTime - statistics.messageStartTime);
+  for (const auto & [topic_name, topic] : topics) {
+    topics_.emplace(topic_name, topic);
+    copied.topics_with_message_count.push_back(topic);
+  }
+  metadata_.message_count += copied.message_count;
+  if (copied.message_count > 0) {
+    metadata_.starting_time = copied.starting_time;
+    metadata_.duration = copied.duration;
+  }
+  return copied;
+}
+
 /** BaseWriteInterface **/
 void MCAPStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> msg)
 {
@@ -741,27 +1657,57 @@ void MCAPStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMess
   }
 
   // Get Channel reference
-  const auto channel_it = channel_ids_.find(msg->topic_name);
-  if (channel_it == channel_ids_.end()) {
+  const auto channel_it = channels_.find(msg->topic_name);
+  if (channel_it == channels_.end()) {
     // This should never happen since we adding channel on topic creation
     throw std::runtime_error{"Channel reference not found for topic: \"" + msg->topic_name + "\""};
   }
 
   mcap::Message mcap_msg;
-  mcap_msg.channelId = channel_it->second;
-  mcap_msg.sequence = 0;
+  auto & channel = channel_it->second;
+  mcap_msg.channelId = channel.id;
+  // Prefer the sequence number of the publisher, so that dropped messages show up as gaps. MCAP
+  // sequence numbers are 32 bit, publisher sequence numbers wrap around in the MCAP file.
+  mcap_msg.sequence = msg->sequence_number != 0 ? static_cast<uint32_t>(msg->sequence_number) :
+                                                  channel.next_sequence++;
   if (msg->time_stamp < 0) {
     RCUTILS_LOG_WARN_NAMED(LOG_NAME, "Invalid message timestamp %ld", msg->time_stamp);
   }
   mcap_msg.logTime = mcap::Timestamp(msg->time_stamp);
-  mcap_msg.publishTime = mcap_msg.logTime;
+  mcap_msg.publishTime =
+    msg->send_timestamp > 0 ? mcap::Timestamp(msg->send_timestamp) : mcap_msg.logTime;
   mcap_msg.dataSize = msg->serialized_data->buffer_length;
   mcap_msg.data = reinterpret_cast<const std::byte *>(msg->serialized_data->buffer);
-  const auto status = mcap_writer_->write(mcap_msg);
-  if (!status.ok()) {
-    throw std::runtime_error{std::string{"Failed to write "} +
-                             std::to_string(msg->serialized_data->buffer_length) +
-                             " byte message to MCAP file: " + status.message};
+  if (pipelined_writer_) {
+    if (writer_options_.separateChunkBitrate > 0 && !channel.separate_chunks) {
+      update_chunk_grouping(channel, mcap_msg);
+    }
+    pipelined_writer_->write(mcap_msg);
+  } else {
+    if (writer_options_.noChunking) {
+      // Messages are written as records of their own, at the current end of the file
+      const auto * data_sink = mcap_writer_->dataSink();
+      if (data_sink) {
+        time_index_.add_message(msg->time_stamp, data_sink->size());
+      }
+    }
+    const auto status = mcap_writer_->write(mcap_msg);
+    if (!status.ok()) {
+      throw std::runtime_error{std::string{"Failed to write "} +
+                               std::to_string(msg->serialized_data->buffer_length) +
+                               " byte message to MCAP file: " + status.message};
+    }
+    if (writer_options_.maxChunkDuration > 0 && !writer_options_.noChunking) {
+      // The writer does not report chunks it closed on size, so the age may count from a
+      // message in an earlier chunk, which closes the chunk early rather than late
+      if (!chunk_start_time_) {
+        chunk_start_time_ = mcap_msg.logTime;
+      } else if (mcap_msg.logTime >=
+                 *chunk_start_time_ + writer_options_.maxChunkDuration * 1000000) {
+        mcap_writer_->closeLastChunk();
+        chunk_start_time_.reset();
+      }
+    }
   }
 
   /// Update metadata
@@ -772,6 +1718,13 @@ void MCAPStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMess
   // Determine recording duration
   const auto message_time = time_point(std::chrono::nanoseconds(msg->time_stamp));
   metadata_.duration = std::max(metadata_.duration, message_time - metadata_.starting_time);
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+  if (durability_policy_.enabled()) {
+    durability_policy_.add_written_bytes(msg->serialized_data->buffer_length);
+    commit_if_due();
+  }
+#endif
 }
 
 void MCAPStorage::write(
@@ -806,7 +1759,11 @@ void MCAPStorage::create_topic(const rosbag2_storage::TopicMetadata & topic,
     schema.data.assign(reinterpret_cast<const std::byte *>(full_text.data()),
                        reinterpret_cast<const std::byte *>(full_text.data() + full_text.size()));
     // TODO(jrms): save message_definition.type_hash in mcap schema
-    mcap_writer_->addSchema(schema);
+    if (pipelined_writer_) {
+      pipelined_writer_->addSchema(schema);
+    } else {
+      mcap_writer_->addSchema(schema);
+    }
     schema_ids_.emplace(datatype, schema.id);
     schema_id = schema.id;
   } else {
@@ -814,8 +1771,8 @@ void MCAPStorage::create_topic(const rosbag2_storage::TopicMetadata & topic,
   }
 
   // Create Channel for topic if it doesn't exist yet
-  const auto channel_it = channel_ids_.find(topic.name);
-  if (channel_it == channel_ids_.end()) {
+  const auto channel_it = channels_.find(topic.name);
+  if (channel_it == channels_.end()) {
     mcap::Channel channel;
     channel.topic = topic.name;
     channel.messageEncoding = topic_info.topic_metadata.serialization_format;
@@ -824,8 +1781,20 @@ void MCAPStorage::create_topic(const rosbag2_storage::TopicMetadata & topic,
       "offered_qos_profiles",
       rosbag2_storage::serialize_rclcpp_qos_vector(topic_info.topic_metadata.offered_qos_profiles));
     channel.metadata.emplace("topic_type_hash", topic_info.topic_metadata.type_description_hash);
-    mcap_writer_->addChannel(channel);
-    channel_ids_.emplace(topic.name, channel.id);
+    ChannelState channel_state{channel.id};
+    if (pipelined_writer_) {
+      pipelined_writer_->addChannel(channel);
+      const auto chunk_size_it = writer_options_.topicChunkSizes.find(topic.name);
+      if (chunk_size_it != writer_options_.topicChunkSizes.end()) {
+        const uint64_t chunk_size =
+          chunk_size_it->second > 0 ? chunk_size_it->second : writer_options_.chunkSize;
+        pipelined_writer_->setChannelChunkSize(channel.id, chunk_size);
+        channel_state.separate_chunks = true;
+      }
+    } else {
+      mcap_writer_->addChannel(channel);
+    }
+    channels_.emplace(topic.name, channel_state);
   }
 }
 
@@ -853,6 +1822,10 @@ void MCAPStorage::update_metadata(const rosbag2_storage::BagMetadata & bag_metad
   YAML::Node metadata_node = YAML::convert<rosbag2_storage::BagMetadata>::encode(bag_metadata);
   std::string serialized_metadata = YAML::Dump(metadata_node);
   metadata.metadata = {{"serialized_metadata", serialized_metadata}};
+  if (pipelined_writer_) {
+    pipelined_writer_->write(metadata);
+    return;
+  }
   mcap::Status status = mcap_writer_->write(metadata);
   if (!status.ok()) {
     OnProblem(status);
@@ -860,6 +1833,27 @@ void MCAPStorage::update_metadata(const rosbag2_storage::BagMetadata & bag_metad
 }
 #endif
 
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+void MCAPStorage::commit_if_due()
+{
+  if (!durability_policy_.is_due()) {
+    return;
+  }
+  // Messages in the open chunks are not in the file yet, so the chunks are closed early
+  if (pipelined_writer_) {
+    pipelined_writer_->flush();
+  } else {
+    mcap_writer_->closeLastChunk();
+  }
+#ifndef _WIN32
+  if (file_writer_) {
+    file_writer_->sync();
+  }
+#endif
+  durability_policy_.committed();
+}
+#endif
+
 }  // namespace rosbag2_storage_plugins
 
 #include "pluginlib/class_list_macros.hpp"  // NOLINT
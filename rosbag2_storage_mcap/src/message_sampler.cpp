@@ -0,0 +1,174 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "message_sampler.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+namespace
+{
+// Chunk offset of messages outside of chunks
+constexpr mcap::ByteOffset kNoChunk = std::numeric_limits<mcap::ByteOffset>::max();
+
+struct Candidate
+{
+  mcap::Timestamp log_time;
+  mcap::RecordOffset offset;
+};
+
+using CandidatesByTopic = std::unordered_map<std::string, std::vector<Candidate>>;
+
+// \return false if a chunk in the time range can not be sampled from its message indexes
+bool collect_from_message_indexes(mcap::McapReader & reader, mcap::IReadable & data_source,
+                                  const mcap::ReadMessageOptions & options,
+                                  CandidatesByTopic & candidates)
+{
+  if (reader.chunkIndexes().empty()) {
+    return false;
+  }
+  std::unordered_map<mcap::ChannelId, const std::string *> topics;
+  for (const auto & [channel_id, channel] : reader.channels()) {
+    if (!options.topicFilter || options.topicFilter(channel->topic)) {
+      topics.emplace(channel_id, &channel->topic);
+    }
+  }
+  for (const auto & chunk_index : reader.chunkIndexes()) {
+    if (chunk_index.messageEndTime < options.startTime ||
+        chunk_index.messageStartTime >= options.endTime) {
+      continue;
+    }
+    if (chunk_index.messageIndexOffsets.empty()) {
+      return false;
+    }
+    for (const auto & [channel_id, message_index_offset] : chunk_index.messageIndexOffsets) {
+      const auto topic = topics.find(channel_id);
+      if (topic == topics.end()) {
+        continue;
+      }
+      mcap::Record record{};
+      mcap::MessageIndex message_index{};
+      auto status = mcap::McapReader::ReadRecord(data_source, message_index_offset, &record);
+      if (status.ok()) {
+        status = mcap::McapReader::ParseMessageIndex(record, &message_index);
+      }
+      if (!status.ok()) {
+        return false;
+      }
+      auto & topic_candidates = candidates[*topic->second];
+      for (const auto & [log_time, offset] : message_index.records) {
+        if (log_time >= options.startTime && log_time < options.endTime) {
+          topic_candidates.push_back(
+            {log_time, mcap::RecordOffset{offset, chunk_index.chunkStartOffset}});
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void collect_from_messages(mcap::McapReader & reader, const mcap::ReadMessageOptions & options,
+                           const mcap::ProblemCallback & on_problem,
+                           CandidatesByTopic & candidates)
+{
+  mcap::ReadMessageOptions file_order_options = options;
+  file_order_options.readOrder = mcap::ReadMessageOptions::ReadOrder::FileOrder;
+  for (const auto & view : reader.readMessages(on_problem, file_order_options)) {
+    candidates[view.channel->topic].push_back({view.message.logTime, view.messageOffset});
+  }
+}
+}  // namespace
+
+SampledMessages::SampledMessages(std::vector<mcap::RecordOffset> offsets)
+{
+  keys_.reserve(offsets.size());
+  for (const auto & offset : offsets) {
+    keys_.push_back(make_key(offset));
+  }
+  std::sort(keys_.begin(), keys_.end());
+}
+
+bool SampledMessages::contains(const mcap::RecordOffset & offset) const
+{
+  return std::binary_search(keys_.begin(), keys_.end(), make_key(offset));
+}
+
+bool SampledMessages::contains_chunk(mcap::ByteOffset chunk_offset) const
+{
+  const auto it = std::lower_bound(keys_.begin(), keys_.end(), Key{chunk_offset, 0});
+  return it != keys_.end() && it->first == chunk_offset;
+}
+
+size_t SampledMessages::size() const
+{
+  return keys_.size();
+}
+
+SampledMessages::Key SampledMessages::make_key(const mcap::RecordOffset & offset)
+{
+  return {offset.chunkOffset.value_or(kNoChunk), offset.offset};
+}
+
+std::shared_ptr<const SampledMessages> sample_messages(mcap::McapReader & reader,
+                                                       mcap::IReadable & data_source,
+                                                       const mcap::ReadMessageOptions & options,
+                                                       uint64_t stride, int64_t interval_ns,
+                                                       const mcap::ProblemCallback & on_problem)
+{
+  CandidatesByTopic candidates;
+  if (!collect_from_message_indexes(reader, data_source, options, candidates)) {
+    candidates.clear();
+    collect_from_messages(reader, options, on_problem, candidates);
+  }
+
+  std::vector<mcap::RecordOffset> sampled;
+  for (auto & [topic, topic_candidates] : candidates) {
+    // Same order as messages of equal log time are read in
+    std::sort(topic_candidates.begin(), topic_candidates.end(),
+              [](const Candidate & lhs, const Candidate & rhs) {
+                return std::make_tuple(lhs.log_time, lhs.offset.chunkOffset.value_or(kNoChunk),
+                                       lhs.offset.offset) <
+                       std::make_tuple(rhs.log_time, rhs.offset.chunkOffset.value_or(kNoChunk),
+                                       rhs.offset.offset);
+              });
+    std::optional<mcap::Timestamp> last_interval;
+    uint64_t position = 0;
+    for (const auto & candidate : topic_candidates) {
+      if (interval_ns > 0) {
+        const mcap::Timestamp interval = candidate.log_time / mcap::Timestamp(interval_ns);
+        if (last_interval == interval) {
+          continue;
+        }
+        last_interval = interval;
+      }
+      if (stride <= 1 || position++ % stride == 0) {
+        sampled.push_back(candidate.offset);
+      }
+    }
+  }
+  return std::make_shared<const SampledMessages>(std::move(sampled));
+}
+
+}  // namespace rosbag2_storage_plugins
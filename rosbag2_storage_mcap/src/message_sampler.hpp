@@ -0,0 +1,72 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__MESSAGE_SAMPLER_HPP_
+#define ROSBAG2_STORAGE_MCAP__MESSAGE_SAMPLER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/// Record offsets of the messages of a file selected by the sampling of a StorageFilter.
+class SampledMessages
+{
+public:
+  explicit SampledMessages(std::vector<mcap::RecordOffset> offsets);
+
+  bool contains(const mcap::RecordOffset & offset) const;
+
+  /// \return whether any message of the chunk at chunk_offset is selected.
+  bool contains_chunk(mcap::ByteOffset chunk_offset) const;
+
+  size_t size() const;
+
+private:
+  using Key = std::pair<mcap::ByteOffset, mcap::ByteOffset>;
+  static Key make_key(const mcap::RecordOffset & offset);
+
+  // Sorted by chunk offset, messages outside of chunks last
+  std::vector<Key> keys_;
+};
+
+/**
+ * Select the sampled messages of a file.
+ *
+ * Messages of each topic are taken in log time order: of the messages in every interval of
+ * interval_ns nanoseconds, aligned to multiples of it, only the first one is kept, and of those
+ * every stride-th one, starting with the first.
+ *
+ * If every chunk in the time range has message indexes, the messages are selected from the
+ * message indexes alone, without decompressing any chunk. Otherwise all messages in the time
+ * range are read once.
+ *
+ * \param options Time range and topic filter of the messages to sample, the read order is ignored.
+ * \param stride Values of 0 and 1 keep every message not dropped by interval_ns.
+ * \param interval_ns Values of 0 and less keep every message of the stride.
+ */
+std::shared_ptr<const SampledMessages> sample_messages(mcap::McapReader & reader,
+                                                       mcap::IReadable & data_source,
+                                                       const mcap::ReadMessageOptions & options,
+                                                       uint64_t stride, int64_t interval_ns,
+                                                       const mcap::ProblemCallback & on_problem);
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__MESSAGE_SAMPLER_HPP_
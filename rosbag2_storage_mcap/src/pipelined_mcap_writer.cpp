@@ -0,0 +1,641 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pipelined_mcap_writer.hpp"
+
+#include "crc32.hpp"
+#include "rcutils/logging_macros.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+namespace
+{
+constexpr char LOG_NAME[] = "rosbag2_storage_mcap";
+
+std::unique_ptr<mcap::IChunkWriter> make_chunk_writer(const mcap::McapWriterOptions & options)
+{
+  switch (options.compression) {
+    case mcap::Compression::Lz4:
+      return std::make_unique<mcap::LZ4Writer>(options.compressionLevel, options.chunkSize);
+    case mcap::Compression::Zstd:
+      return std::make_unique<mcap::ZStdWriter>(options.compressionLevel, options.chunkSize);
+    default:
+      return std::make_unique<mcap::BufferWriter>();
+  }
+}
+
+std::string compression_name(mcap::Compression compression)
+{
+  switch (compression) {
+    case mcap::Compression::Lz4:
+      return "lz4";
+    case mcap::Compression::Zstd:
+      return "zstd";
+    default:
+      return "";
+  }
+}
+}  // namespace
+
+PipelinedMcapWriter::~PipelinedMcapWriter()
+{
+  close();
+}
+
+mcap::Status PipelinedMcapWriter::open(std::string_view filename,
+                                       const mcap::McapWriterOptions & options,
+                                       size_t compression_threads)
+{
+  auto file_output = std::make_unique<mcap::FileWriter>();
+  const auto status = file_output->open(filename);
+  if (!status.ok()) {
+    return status;
+  }
+  open(*file_output, options, compression_threads);
+  file_output_ = std::move(file_output);
+  return status;
+}
+
+void PipelinedMcapWriter::open(mcap::IWritable & output, const mcap::McapWriterOptions & options,
+                               size_t compression_threads)
+{
+  if (options.noChunking) {
+    throw std::invalid_argument("Pipelined MCAP writer requires chunking");
+  }
+  close();
+  options_ = options;
+  output_ = &output;
+  schemas_.clear();
+  channels_.clear();
+  statistics_ = mcap::Statistics{};
+  chunk_indexes_.clear();
+  metadata_indexes_.clear();
+  free_chunk_writers_.clear();
+  chunk_writer_count_ = 0;
+  shared_stream_ = ChunkStream{};
+  shared_stream_.chunk_size = options_.chunkSize;
+  channel_streams_.clear();
+  stop_ = false;
+  error_ = nullptr;
+
+  // The data section CRC covers everything up to the DataEnd record, starting with the magic.
+  // The I/O thread is the only one writing to the output until close().
+  output_->crcEnabled = options_.enableDataCRC;
+  output_->resetCrc();
+  mcap::McapWriter::writeMagic(*output_);
+  mcap::McapWriter::write(*output_, mcap::Header{options_.profile, options_.library});
+  written_size_.store(output_->size());
+
+  compression_threads = std::max<size_t>(compression_threads, 1);
+  // One chunk per thread in compression, another one waiting for each, plus the open shared
+  // chunk. Every channel written to chunks of its own adds another open chunk.
+  max_chunk_writers_ = 2 * compression_threads + 1;
+  for (size_t i = 0; i < compression_threads; ++i) {
+    compression_threads_.emplace_back(&PipelinedMcapWriter::compress_chunks, this);
+  }
+  io_thread_ = std::thread(&PipelinedMcapWriter::write_records, this);
+}
+
+void PipelinedMcapWriter::addSchema(mcap::Schema & schema)
+{
+  schema.id = static_cast<mcap::SchemaId>(schemas_.size() + 1);
+  schemas_.push_back(schema);
+}
+
+void PipelinedMcapWriter::addChannel(mcap::Channel & channel)
+{
+  channel.id = static_cast<mcap::ChannelId>(channels_.size() + 1);
+  channels_.push_back(channel);
+}
+
+void PipelinedMcapWriter::addSchemaWithId(const mcap::Schema & schema)
+{
+  if (schema.id == 0 || (schema.id <= schemas_.size() && schemas_[schema.id - 1].id != 0)) {
+    throw std::invalid_argument("Schema id " + std::to_string(schema.id) + " can not be assigned");
+  }
+  if (schema.id > schemas_.size()) {
+    schemas_.resize(schema.id);
+  }
+  schemas_[schema.id - 1] = schema;
+}
+
+void PipelinedMcapWriter::addChannelWithId(const mcap::Channel & channel)
+{
+  if (channel.id == 0 || known_channel(channel.id)) {
+    throw std::invalid_argument("Channel id " + std::to_string(channel.id) +
+                                " can not be assigned");
+  }
+  if (channel.id > channels_.size()) {
+    channels_.resize(channel.id);
+  }
+  channels_[channel.id - 1] = channel;
+}
+
+void PipelinedMcapWriter::setChannelChunkSize(mcap::ChannelId channel_id, uint64_t chunk_size)
+{
+  if (!known_channel(channel_id)) {
+    throw std::runtime_error("Unknown channel id " + std::to_string(channel_id));
+  }
+  const auto stream_it = channel_streams_.find(channel_id);
+  if (chunk_size == 0) {
+    if (stream_it != channel_streams_.end()) {
+      if (stream_it->second.open_chunk) {
+        seal_chunk(stream_it->second);
+      }
+      channel_streams_.erase(stream_it);
+    }
+    return;
+  }
+  if (stream_it != channel_streams_.end()) {
+    stream_it->second.chunk_size = chunk_size;
+    return;
+  }
+  channel_streams_[channel_id].chunk_size = chunk_size;
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++max_chunk_writers_;
+}
+
+void PipelinedMcapWriter::setMaxChunkDuration(mcap::Timestamp max_chunk_duration)
+{
+  max_chunk_duration_ = max_chunk_duration;
+}
+
+void PipelinedMcapWriter::write(const mcap::Message & message)
+{
+  if (!output_) {
+    throw std::runtime_error("Pipelined MCAP writer is not open");
+  }
+  if (!known_channel(message.channelId)) {
+    throw std::runtime_error("Unknown channel id " + std::to_string(message.channelId));
+  }
+  const auto stream_it = channel_streams_.find(message.channelId);
+  auto & stream = stream_it != channel_streams_.end() ? stream_it->second : shared_stream_;
+  if (!stream.open_chunk) {
+    stream.open_chunk = acquire_chunk();
+  }
+  auto & chunk = *stream.open_chunk;
+  auto & records = *chunk.records;
+
+  // Every chunk carries the schemas and channels of its messages
+  if (stream.channels_in_chunk.insert(message.channelId).second) {
+    const auto & channel = channels_[message.channelId - 1];
+    if (channel.schemaId != 0 && channel.schemaId <= schemas_.size() &&
+        schemas_[channel.schemaId - 1].id != 0 &&
+        stream.schemas_in_chunk.insert(channel.schemaId).second) {
+      mcap::McapWriter::write(records, schemas_[channel.schemaId - 1]);
+    }
+    mcap::McapWriter::write(records, channel);
+  }
+
+  auto & message_index = chunk.message_indexes[message.channelId];
+  message_index.channelId = message.channelId;
+  message_index.records.emplace_back(message.logTime, records.size());
+  mcap::McapWriter::write(records, message);
+
+  if (message_index.records.size() == 1 && chunk.message_indexes.size() == 1) {
+    chunk.message_start_time = message.logTime;
+    chunk.message_end_time = message.logTime;
+  } else {
+    chunk.message_start_time = std::min(chunk.message_start_time, message.logTime);
+    chunk.message_end_time = std::max(chunk.message_end_time, message.logTime);
+  }
+  count_message(message.channelId, message.logTime);
+
+  if (records.size() >= stream.chunk_size ||
+      (max_chunk_duration_ > 0 &&
+       chunk.message_end_time - chunk.message_start_time >= max_chunk_duration_)) {
+    seal_chunk(stream);
+  }
+}
+
+void PipelinedMcapWriter::write(const mcap::Chunk & chunk,
+                                std::vector<mcap::MessageIndex> message_indexes,
+                                std::shared_ptr<const void> records)
+{
+  if (!output_) {
+    throw std::runtime_error("Pipelined MCAP writer is not open");
+  }
+  for (const auto & message_index : message_indexes) {
+    if (!known_channel(message_index.channelId)) {
+      throw std::runtime_error("Unknown channel id " + std::to_string(message_index.channelId));
+    }
+  }
+  // Messages written before stay in front of the copied ones
+  seal_chunks();
+  {
+    // A copied chunk takes the place of a chunk writer in flight, which bounds its memory
+    std::unique_lock<std::mutex> lock(mutex_);
+    state_changed_.wait(lock, [this] {
+      return error_ || pending_.size() < max_chunk_writers_;
+    });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  auto record = std::make_shared<PendingRecord>();
+  record->copied_chunk = chunk;
+  if (!records) {
+    auto copy = std::make_shared<std::vector<std::byte>>(chunk.records,
+                                                         chunk.records + chunk.compressedSize);
+    record->copied_chunk.records = copy->data();
+    records = std::move(copy);
+  }
+  record->copied_records = std::move(records);
+  record->message_start_time = chunk.messageStartTime;
+  record->message_end_time = chunk.messageEndTime;
+  for (auto & message_index : message_indexes) {
+    for (const auto & [log_time, offset] : message_index.records) {
+      count_message(message_index.channelId, log_time);
+    }
+    const mcap::ChannelId channel_id = message_index.channelId;
+    record->message_indexes.emplace(channel_id, std::move(message_index));
+  }
+  record->compressed = true;
+  ++statistics_.chunkCount;
+  enqueue(record, false);
+}
+
+void PipelinedMcapWriter::write(const mcap::Metadata & metadata)
+{
+  if (!output_) {
+    throw std::runtime_error("Pipelined MCAP writer is not open");
+  }
+  rethrow_error();
+  auto record = std::make_shared<PendingRecord>();
+  record->records = std::make_unique<mcap::BufferWriter>();
+  mcap::McapWriter::write(*record->records, metadata);
+  record->is_metadata = true;
+  record->metadata_name = metadata.name;
+  record->compressed = true;
+  ++statistics_.metadataCount;
+  enqueue(record, false);
+}
+
+void PipelinedMcapWriter::flush()
+{
+  if (!output_) {
+    throw std::runtime_error("Pipelined MCAP writer is not open");
+  }
+  seal_chunks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  state_changed_.wait(lock, [this] {
+    return error_ || (pending_.empty() && !writing_record_);
+  });
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void PipelinedMcapWriter::close()
+{
+  if (!output_) {
+    return;
+  }
+  seal_chunks();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  state_changed_.notify_all();
+  for (auto & thread : compression_threads_) {
+    thread.join();
+  }
+  compression_threads_.clear();
+  io_thread_.join();
+
+  try {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    write_summary();
+  } catch (const std::exception & e) {
+    RCUTILS_LOG_ERROR_NAMED(LOG_NAME, "Failed to write MCAP file: %s", e.what());
+  }
+  output_->end();
+  written_size_.store(output_->size());
+  output_ = nullptr;
+  file_output_.reset();
+  free_chunk_writers_.clear();
+}
+
+uint64_t PipelinedMcapWriter::size() const
+{
+  return written_size_.load();
+}
+
+std::shared_ptr<PipelinedMcapWriter::PendingRecord> PipelinedMcapWriter::acquire_chunk()
+{
+  auto chunk = std::make_shared<PendingRecord>();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    state_changed_.wait(lock, [this] {
+      return error_ || !free_chunk_writers_.empty() || chunk_writer_count_ < max_chunk_writers_;
+    });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    if (!free_chunk_writers_.empty()) {
+      chunk->records = std::move(free_chunk_writers_.back());
+      free_chunk_writers_.pop_back();
+    } else {
+      ++chunk_writer_count_;
+    }
+  }
+  if (!chunk->records) {
+    chunk->records = make_chunk_writer(options_);
+  }
+  // The CRC is computed by the compression threads instead of with every message written
+  chunk->records->crcEnabled = false;
+  chunk->uncompressed_crc = 0;
+  return chunk;
+}
+
+void PipelinedMcapWriter::seal_chunk(ChunkStream & stream)
+{
+  auto chunk = std::move(stream.open_chunk);
+  stream.schemas_in_chunk.clear();
+  stream.channels_in_chunk.clear();
+  ++statistics_.chunkCount;
+  enqueue(chunk, true);
+}
+
+void PipelinedMcapWriter::seal_chunks()
+{
+  if (shared_stream_.open_chunk) {
+    seal_chunk(shared_stream_);
+  }
+  for (auto & [channel_id, stream] : channel_streams_) {
+    if (stream.open_chunk) {
+      seal_chunk(stream);
+    }
+  }
+}
+
+void PipelinedMcapWriter::enqueue(const std::shared_ptr<PendingRecord> & record, bool compress)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(record);
+    if (compress) {
+      compress_queue_.push_back(record);
+    }
+  }
+  state_changed_.notify_all();
+}
+
+void PipelinedMcapWriter::rethrow_error()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+bool PipelinedMcapWriter::known_channel(mcap::ChannelId channel_id) const
+{
+  return channel_id != 0 && channel_id <= channels_.size() && channels_[channel_id - 1].id != 0;
+}
+
+void PipelinedMcapWriter::count_message(mcap::ChannelId channel_id, mcap::Timestamp log_time)
+{
+  if (statistics_.messageCount == 0) {
+    statistics_.messageStartTime = log_time;
+    statistics_.messageEndTime = log_time;
+  } else {
+    statistics_.messageStartTime = std::min(statistics_.messageStartTime, log_time);
+    statistics_.messageEndTime = std::max(statistics_.messageEndTime, log_time);
+  }
+  ++statistics_.messageCount;
+  ++statistics_.channelMessageCounts[channel_id];
+}
+
+void PipelinedMcapWriter::compress_chunks()
+{
+  while (true) {
+    std::shared_ptr<PendingRecord> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      state_changed_.wait(lock, [this] {
+        return stop_ || !compress_queue_.empty();
+      });
+      if (compress_queue_.empty()) {
+        return;
+      }
+      chunk = std::move(compress_queue_.front());
+      compress_queue_.pop_front();
+    }
+    std::exception_ptr error;
+    try {
+      chunk->records->end();
+      if (!options_.noChunkCRC) {
+        chunk->uncompressed_crc = crc32(chunk->records->data(), chunk->records->size());
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      chunk->compressed = true;
+      if (error && !error_) {
+        error_ = error;
+      }
+    }
+    state_changed_.notify_all();
+  }
+}
+
+void PipelinedMcapWriter::write_records()
+{
+  while (true) {
+    std::shared_ptr<PendingRecord> record;
+    bool failed = false;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      state_changed_.wait(lock, [this] {
+        return (!pending_.empty() && pending_.front()->compressed) || (stop_ && pending_.empty());
+      });
+      if (pending_.empty()) {
+        return;
+      }
+      record = std::move(pending_.front());
+      pending_.pop_front();
+      writing_record_ = true;
+      failed = static_cast<bool>(error_);
+    }
+    std::exception_ptr error;
+    if (!failed) {
+      try {
+        if (record->is_metadata) {
+          write_metadata(*record);
+        } else {
+          write_chunk(*record);
+        }
+        written_size_.store(output_->size());
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing_record_ = false;
+      if (record->records && !record->is_metadata) {
+        record->records->clear();
+        free_chunk_writers_.push_back(std::move(record->records));
+      }
+      if (error && !error_) {
+        error_ = error;
+      }
+    }
+    state_changed_.notify_all();
+  }
+}
+
+void PipelinedMcapWriter::write_chunk(PendingRecord & chunk)
+{
+  mcap::Chunk chunk_record;
+  if (chunk.copied_records) {
+    chunk_record = chunk.copied_chunk;
+  } else {
+    auto & records = *chunk.records;
+    const uint64_t uncompressed_size = records.size();
+    // Same as mcap::McapWriter, chunks which do not get smaller are stored uncompressed
+    const bool use_compressed =
+      options_.compression != mcap::Compression::None &&
+      (options_.forceCompression || records.compressedSize() < uncompressed_size);
+
+    chunk_record.messageStartTime = chunk.message_start_time;
+    chunk_record.messageEndTime = chunk.message_end_time;
+    chunk_record.uncompressedSize = uncompressed_size;
+    chunk_record.uncompressedCrc = chunk.uncompressed_crc;
+    chunk_record.compression = use_compressed ? compression_name(options_.compression) : "";
+    chunk_record.compressedSize = use_compressed ? records.compressedSize() : uncompressed_size;
+    chunk_record.records = use_compressed ? records.compressedData() : records.data();
+  }
+
+  mcap::ChunkIndex chunk_index{};
+  chunk_index.messageStartTime = chunk.message_start_time;
+  chunk_index.messageEndTime = chunk.message_end_time;
+  chunk_index.chunkStartOffset = output_->size();
+  chunk_index.chunkLength = mcap::McapWriter::write(*output_, chunk_record);
+  chunk_index.compression = chunk_record.compression;
+  chunk_index.compressedSize = chunk_record.compressedSize;
+  chunk_index.uncompressedSize = chunk_record.uncompressedSize;
+
+  if (!options_.noMessageIndex) {
+    const uint64_t message_index_start = output_->size();
+    for (const auto & [channel_id, message_index] : chunk.message_indexes) {
+      chunk_index.messageIndexOffsets.emplace(channel_id, output_->size());
+      mcap::McapWriter::write(*output_, message_index);
+    }
+    chunk_index.messageIndexLength = output_->size() - message_index_start;
+  }
+  if (!options_.noChunkIndex) {
+    chunk_indexes_.push_back(std::move(chunk_index));
+  }
+}
+
+void PipelinedMcapWriter::write_metadata(const PendingRecord & metadata)
+{
+  mcap::MetadataIndex metadata_index;
+  metadata_index.offset = output_->size();
+  metadata_index.length = metadata.records->size();
+  metadata_index.name = metadata.metadata_name;
+  output_->write(metadata.records->data(), metadata.records->size());
+  if (!options_.noMetadataIndex) {
+    metadata_indexes_.push_back(std::move(metadata_index));
+  }
+}
+
+void PipelinedMcapWriter::write_summary()
+{
+  // Same layout as written by mcap::McapWriter::close()
+  const uint32_t data_section_crc = options_.enableDataCRC ? output_->crc() : 0;
+  mcap::McapWriter::write(*output_, mcap::DataEnd{data_section_crc});
+
+  output_->crcEnabled = !options_.noSummaryCRC;
+  output_->resetCrc();
+  uint64_t summary_start = 0;
+  uint64_t summary_offset_start = 0;
+  if (!options_.noSummary) {
+    summary_start = output_->size();
+    const uint64_t schema_start = output_->size();
+    if (!options_.noRepeatedSchemas) {
+      for (const auto & schema : schemas_) {
+        if (schema.id != 0) {
+          mcap::McapWriter::write(*output_, schema);
+        }
+      }
+    }
+    const uint64_t channel_start = output_->size();
+    if (!options_.noRepeatedChannels) {
+      for (const auto & channel : channels_) {
+        if (channel.id != 0) {
+          mcap::McapWriter::write(*output_, channel);
+        }
+      }
+    }
+    const uint64_t statistics_start = output_->size();
+    if (!options_.noStatistics) {
+      statistics_.schemaCount = static_cast<uint16_t>(std::count_if(
+        schemas_.begin(), schemas_.end(), [](const mcap::Schema & schema) {
+          return schema.id != 0;
+        }));
+      statistics_.channelCount = static_cast<uint32_t>(std::count_if(
+        channels_.begin(), channels_.end(), [](const mcap::Channel & channel) {
+          return channel.id != 0;
+        }));
+      mcap::McapWriter::write(*output_, statistics_);
+    }
+    const uint64_t chunk_index_start = output_->size();
+    for (const auto & chunk_index : chunk_indexes_) {
+      mcap::McapWriter::write(*output_, chunk_index);
+    }
+    const uint64_t metadata_index_start = output_->size();
+    for (const auto & metadata_index : metadata_indexes_) {
+      mcap::McapWriter::write(*output_, metadata_index);
+    }
+
+    summary_offset_start = output_->size();
+    if (!options_.noSummaryOffsets) {
+      const auto write_summary_offset = [this](mcap::OpCode op_code, uint64_t start,
+                                               uint64_t end) {
+        if (end > start) {
+          mcap::McapWriter::write(*output_, mcap::SummaryOffset{op_code, start, end - start});
+        }
+      };
+      write_summary_offset(mcap::OpCode::Schema, schema_start, channel_start);
+      write_summary_offset(mcap::OpCode::Channel, channel_start, statistics_start);
+      write_summary_offset(mcap::OpCode::Statistics, statistics_start, chunk_index_start);
+      write_summary_offset(mcap::OpCode::ChunkIndex, chunk_index_start, metadata_index_start);
+      write_summary_offset(mcap::OpCode::MetadataIndex, metadata_index_start,
+                           summary_offset_start);
+    }
+  }
+
+  mcap::Footer footer;
+  footer.summaryStart = summary_start;
+  footer.summaryOffsetStart = summary_offset_start;
+  footer.summaryCrc = 0;
+  mcap::McapWriter::write(*output_, footer, !options_.noSummaryCRC);
+  mcap::McapWriter::writeMagic(*output_);
+}
+
+}  // namespace rosbag2_storage_plugins
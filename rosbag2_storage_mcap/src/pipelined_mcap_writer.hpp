@@ -0,0 +1,214 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_MCAP__PIPELINED_MCAP_WRITER_HPP_
+#define ROSBAG2_STORAGE_MCAP__PIPELINED_MCAP_WRITER_HPP_
+
+#include <mcap/writer.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * MCAP writer which compresses chunks on a pool of threads.
+ *
+ * Messages are added to the open chunk on the calling thread. Full chunks are compressed by the
+ * worker threads, which also compute their CRCs, and written in order by a dedicated I/O thread,
+ * so the recording throughput is not bound to the compression speed of a single core. The
+ * records written are the same as with mcap::McapWriter, except that every chunk carries the
+ * schemas and channels it refers to.
+ * Chunks of another MCAP file can be written as they are, see write(const mcap::Chunk &).
+ * Channels can be written to chunks of their own, see setChannelChunkSize().
+ *
+ * Only chunked output is supported. Without compression, chunks are written uncompressed by the
+ * I/O thread. Attachments are not supported.
+ * All methods have to be called from the same thread, except for size().
+ */
+class PipelinedMcapWriter
+{
+public:
+  PipelinedMcapWriter() = default;
+  ~PipelinedMcapWriter();
+
+  PipelinedMcapWriter(const PipelinedMcapWriter &) = delete;
+  PipelinedMcapWriter & operator=(const PipelinedMcapWriter &) = delete;
+
+  /// Create the file at filename and write the header.
+  /// \param compression_threads Number of threads compressing chunks, at least 1.
+  mcap::Status open(std::string_view filename, const mcap::McapWriterOptions & options,
+                    size_t compression_threads);
+
+  /// Write the header to output, which has to outlive the writer or the next close().
+  void open(mcap::IWritable & output, const mcap::McapWriterOptions & options,
+            size_t compression_threads);
+
+  /// Assigns schema.id, same as mcap::McapWriter::addSchema().
+  void addSchema(mcap::Schema & schema);
+
+  /// Assigns channel.id, same as mcap::McapWriter::addChannel().
+  void addChannel(mcap::Channel & channel);
+
+  /// Add a schema with the id it has in another file, so chunks of that file can be copied.
+  /// \throws std::invalid_argument if the id is 0 or already assigned.
+  void addSchemaWithId(const mcap::Schema & schema);
+
+  /// Add a channel with the id it has in another file, so chunks of that file can be copied.
+  /// \throws std::invalid_argument if the id is 0 or already assigned.
+  void addChannelWithId(const mcap::Channel & channel);
+
+  /**
+   * Write the messages of a channel from now on into chunks which hold no other channel.
+   *
+   * Readers of other channels skip these chunks by their chunk index, without decompressing
+   * them. Messages of the channel in the open shared chunk stay there.
+   * \param chunk_size Target uncompressed size of the chunks of the channel. With 0, messages
+   * of the channel are written into the shared chunks again.
+   * \throws std::runtime_error if the channel is unknown.
+   */
+  void setChannelChunkSize(mcap::ChannelId channel_id, uint64_t chunk_size);
+
+  /// Seal chunks whose messages span this many nanoseconds of log time, even if they are not
+  /// full yet. Checked whenever a message is added to a chunk. 0, the default, disables it.
+  void setMaxChunkDuration(mcap::Timestamp max_chunk_duration);
+
+  /// \throws std::runtime_error if the channel is unknown or a previous chunk could not be
+  /// compressed or written.
+  void write(const mcap::Message & message);
+
+  /**
+   * Write a chunk of another MCAP file as it is, after the messages written so far.
+   *
+   * Waits while as many records are pending as chunks can be in flight.
+   * \param chunk Chunk record, whose messages only refer to channels added with their ids.
+   * \param message_indexes Message indexes of the chunk, one per channel of its messages.
+   * \param records Keeps chunk.records valid until the chunk is written. If not set, the
+   * records are copied.
+   * \throws std::runtime_error if a channel is unknown or a previous chunk could not be
+   * compressed or written.
+   */
+  void write(const mcap::Chunk & chunk, std::vector<mcap::MessageIndex> message_indexes,
+             std::shared_ptr<const void> records = nullptr);
+
+  /// Queue a metadata record, which is written after the chunks completed so far.
+  /// \throws std::runtime_error if a previous chunk could not be compressed or written.
+  void write(const mcap::Metadata & metadata);
+
+  /// Seal the open chunks and wait until all records queued so far were written to the output.
+  /// \throws std::runtime_error if a chunk could not be compressed or written.
+  void flush();
+
+  /// Write the open chunk, wait for all chunks to be written, then write the summary and end the
+  /// output. Errors are logged.
+  void close();
+
+  /// Bytes written to the output. Chunks which are still being compressed are not included.
+  /// May be called from any thread.
+  uint64_t size() const;
+
+private:
+  // A chunk, or a metadata record which has to be written between chunks
+  struct PendingRecord
+  {
+    std::unique_ptr<mcap::IChunkWriter> records;
+    mcap::Timestamp message_start_time = 0;
+    mcap::Timestamp message_end_time = 0;
+    // Ordered by channel id, so that message indexes are written in a deterministic order
+    std::map<mcap::ChannelId, mcap::MessageIndex> message_indexes;
+    bool is_metadata = false;
+    std::string metadata_name;
+    bool compressed = false;
+    // Computed along with the compression, unless noChunkCRC is set
+    uint32_t uncompressed_crc = 0;
+    // Set for chunks copied from another file, instead of records
+    std::shared_ptr<const void> copied_records;
+    mcap::Chunk copied_chunk{};
+  };
+
+  // Chunks being filled with the messages of one or more channels
+  struct ChunkStream
+  {
+    uint64_t chunk_size = 0;
+    std::shared_ptr<PendingRecord> open_chunk;
+    std::unordered_set<mcap::SchemaId> schemas_in_chunk;
+    std::unordered_set<mcap::ChannelId> channels_in_chunk;
+  };
+
+  std::shared_ptr<PendingRecord> acquire_chunk();
+  void seal_chunk(ChunkStream & stream);
+  void seal_chunks();
+  void enqueue(const std::shared_ptr<PendingRecord> & record, bool compress);
+  void rethrow_error();
+  bool known_channel(mcap::ChannelId channel_id) const;
+  void count_message(mcap::ChannelId channel_id, mcap::Timestamp log_time);
+
+  void compress_chunks();
+  void write_records();
+  void write_chunk(PendingRecord & chunk);
+  void write_metadata(const PendingRecord & metadata);
+  void write_summary();
+
+  mcap::McapWriterOptions options_{""};
+  std::unique_ptr<mcap::FileWriter> file_output_;
+  mcap::IWritable * output_ = nullptr;
+  std::atomic<uint64_t> written_size_{0};
+
+  // Accessed from the calling thread only. Indexed by id - 1, unassigned ids have id 0.
+  std::vector<mcap::Schema> schemas_;
+  std::vector<mcap::Channel> channels_;
+  mcap::Statistics statistics_{};
+  ChunkStream shared_stream_;
+  mcap::Timestamp max_chunk_duration_ = 0;
+  // Channels written to chunks of their own, ordered so that close() seals them deterministically
+  std::map<mcap::ChannelId, ChunkStream> channel_streams_;
+
+  // Accessed from the I/O thread only while it runs
+  std::vector<mcap::ChunkIndex> chunk_indexes_;
+  std::vector<mcap::MetadataIndex> metadata_indexes_;
+
+  std::mutex mutex_;
+  std::condition_variable state_changed_;
+  // Records in file order, until they were written
+  std::deque<std::shared_ptr<PendingRecord>> pending_;
+  // Set while the I/O thread writes a record taken from pending_
+  bool writing_record_ = false;
+  std::deque<std::shared_ptr<PendingRecord>> compress_queue_;
+  // Chunk writers are reused, which bounds the memory held by chunks in flight and open chunks
+  std::vector<std::unique_ptr<mcap::IChunkWriter>> free_chunk_writers_;
+  size_t chunk_writer_count_ = 0;
+  size_t max_chunk_writers_ = 0;
+  bool stop_ = false;
+  std::exception_ptr error_;
+
+  std::vector<std::thread> compression_threads_;
+  std::thread io_thread_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__PIPELINED_MCAP_WRITER_HPP_
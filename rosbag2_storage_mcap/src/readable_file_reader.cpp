@@ -0,0 +1,46 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "readable_file_reader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace rosbag2_storage_plugins
+{
+
+ReadableFileReader::ReadableFileReader(std::shared_ptr<rosbag2_storage::ReadableFile> file)
+    : file_(std::move(file))
+{
+}
+
+uint64_t ReadableFileReader::size() const
+{
+  return file_->size();
+}
+
+uint64_t ReadableFileReader::read(std::byte ** output, uint64_t offset, uint64_t size)
+{
+  if (offset >= file_->size()) {
+    return 0;
+  }
+  buffer_.resize(size);
+  const auto count = file_->read(reinterpret_cast<uint8_t *>(buffer_.data()), offset, size);
+  *output = buffer_.data();
+  return count;
+}
+
+}  // namespace rosbag2_storage_plugins
@@ -0,0 +1,52 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ROSBAG2_STORAGE_MCAP__READABLE_FILE_READER_HPP_
+#define ROSBAG2_STORAGE_MCAP__READABLE_FILE_READER_HPP_
+
+#include <mcap/reader.hpp>
+
+#include "rosbag2_storage/readable_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * mcap::IReadable which reads a rosbag2_storage::ReadableFile, e.g. an MCAP file which is
+ * decompressed while it is read.
+ *
+ * read() copies into a buffer of the reader, which is valid until the next call.
+ */
+class ReadableFileReader final : public mcap::IReadable
+{
+public:
+  explicit ReadableFileReader(std::shared_ptr<rosbag2_storage::ReadableFile> file);
+
+  uint64_t size() const override;
+  uint64_t read(std::byte ** output, uint64_t offset, uint64_t size) override;
+
+private:
+  std::shared_ptr<rosbag2_storage::ReadableFile> file_;
+  std::vector<std::byte> buffer_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_MCAP__READABLE_FILE_READER_HPP_
@@ -0,0 +1,70 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rcpputils/filesystem_helper.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_options.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Writes batches of range(1) messages of range(0) bytes through the storage factory, as the
+// writer does. Batches of one message are written with the single message overload.
+static void BM_mcap_storage_write(benchmark::State & state)
+{
+  const auto message_size = static_cast<size_t>(state.range(0));
+  const auto batch_size = static_cast<size_t>(state.range(1));
+  const auto temporary_dir = rcpputils::fs::create_temp_directory("benchmark_mcap_");
+  {
+    rosbag2_storage::StorageFactory factory;
+    rosbag2_storage::StorageOptions options;
+    options.uri = (temporary_dir / "bag").string();
+    options.storage_id = "mcap";
+    auto storage = factory.open_read_write(options);
+    if (!storage) {
+      state.SkipWithError("Failed to open the mcap storage");
+      return;
+    }
+    storage->create_topic({"/benchmark", "std_msgs/msg/ByteMultiArray", "cdr", {}, ""}, {});
+
+    const std::vector<uint8_t> data(message_size, 42);
+    std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> batch;
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = "/benchmark";
+      message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+      batch.push_back(message);
+    }
+
+    for (auto _ : state) {
+      if (batch_size == 1) {
+        storage->write(batch.front());
+      } else {
+        storage->write(batch);
+      }
+    }
+  }
+  rcpputils::fs::remove_all(temporary_dir);
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_mcap_storage_write)
+  ->ArgNames({"message_size", "batch_size"})
+  ->ArgsProduct({{64, 4 * 1024, 256 * 1024}, {1, 16, 256}})
+  ->UseRealTime();
@@ -16,6 +16,7 @@
 #include "rclcpp/serialized_message.hpp"
 #include "rcpputils/filesystem_helper.hpp"
 #include "rcutils/logging_macros.h"
+#include "rosbag2_storage/interned_topic.hpp"
 #include "rosbag2_storage/storage_factory.hpp"
 #ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
   #include "rosbag2_storage/storage_options.hpp"
@@ -23,10 +24,21 @@
 #include "rosbag2_test_common/temporary_directory_fixture.hpp"
 #include "std_msgs/msg/string.hpp"
 
+#include <mcap/reader.hpp>
+
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 using namespace ::testing;  // NOLINT
 using TemporaryDirectoryFixture = rosbag2_test_common::TemporaryDirectoryFixture;
@@ -319,4 +331,1402 @@ TEST_F(TemporaryDirectoryFixture, can_write_mcap_with_zstd_configured_from_yaml)
     EXPECT_THAT(definitions, ElementsAreArray({definition}));
   }
 }
+
+TEST_F(TemporaryDirectoryFixture, can_write_preallocated_mcap_with_direct_io)
+{
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const uint64_t max_bagfile_size = 64 * 1024 * 1024;
+  const std::string topic_name = "test_topic";
+  const std::string storage_id = "mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 5000;
+  rclcpp::Serialization<std_msgs::msg::String> serialization;
+
+  std_msgs::msg::String msg;
+  msg.data = std::string(1024, 'x');
+  auto serialized_msg = std::make_shared<rclcpp::SerializedMessage>();
+  serialization.serialize_message(&msg, serialized_msg.get());
+
+  uint64_t bagfile_size = 0;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = storage_id;
+    options.max_bagfile_size = max_bagfile_size;
+    options.preallocate_bagfiles = true;
+    options.storage_config_uri = config_path + "/mcap_writer_options_direct_io.yaml";
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = topic_name;
+    topic_metadata.type = "std_msgs/msg/String";
+
+    rosbag2_storage::StorageFactory factory;
+    auto writer = factory.open_read_write(options);
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+
+    auto serialized_bag_msg = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    serialized_bag_msg->serialized_data = std::shared_ptr<rcutils_uint8_array_t>(
+      const_cast<rcutils_uint8_array_t *>(&serialized_msg->get_rcl_serialized_message()),
+      [](rcutils_uint8_array_t * /* data */) {});
+    serialized_bag_msg->topic_name = topic_name;
+    for (size_t i = 0; i < message_count; ++i) {
+      serialized_bag_msg->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      writer->write(serialized_bag_msg);
+    }
+    // Reserved space must not count as recorded data
+    bagfile_size = writer->get_bagfile_size();
+    EXPECT_GT(bagfile_size, 0u);
+    EXPECT_LT(bagfile_size, max_bagfile_size);
+  }
+  // The reserved space beyond the recorded data is released on close
+  EXPECT_LT(expected_bag.file_size(), max_bagfile_size);
+  EXPECT_GE(expected_bag.file_size(), bagfile_size);
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = storage_id;
+
+    rosbag2_storage::StorageFactory factory;
+    auto reader = factory.open_read_only(options);
+    size_t read_count = 0;
+    while (reader->has_next()) {
+      auto serialized_bag_msg = reader->read_next();
+      rclcpp::SerializedMessage extracted_serialized_msg(*serialized_bag_msg->serialized_data);
+      std_msgs::msg::String read_msg;
+      serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+      EXPECT_EQ(read_msg.data, msg.data);
+      ++read_count;
+    }
+    EXPECT_EQ(read_count, message_count);
+  }
+}
+
+TEST_F(McapStorageTestFixture, can_write_mcap_with_asynchronous_writes)
+{
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string topic_name = "test_topic";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  // More data than all write buffers hold, so buffers are recycled
+  const size_t message_count = 25000;
+  rclcpp::Serialization<std_msgs::msg::String> serialization;
+
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = config_path + "/mcap_writer_options_async_writes.yaml";
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = topic_name;
+    topic_metadata.type = "std_msgs/msg/String";
+
+    rosbag2_storage::StorageFactory factory;
+    auto writer = factory.open_read_write(options);
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data =
+        make_serialized_message(std::to_string(i) + std::string(1024, 'x'));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      bag_message->topic_name = topic_name;
+      writer->write(bag_message);
+    }
+  }
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+
+    rosbag2_storage::StorageFactory factory;
+    auto reader = factory.open_read_only(options);
+    size_t read_count = 0;
+    while (reader->has_next()) {
+      auto bag_message = reader->read_next();
+      rclcpp::SerializedMessage extracted_serialized_msg(*bag_message->serialized_data);
+      std_msgs::msg::String read_msg;
+      serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+      ASSERT_EQ(read_msg.data, std::to_string(read_count) + std::string(1024, 'x'));
+      ++read_count;
+    }
+    EXPECT_EQ(read_count, message_count);
+  }
+}
+
+TEST_F(McapStorageTestFixture, can_write_mcap_with_chunks_compressed_on_multiple_threads)
+{
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string storage_id = "mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 5000;
+  const std::vector<std::string> topic_names = {"topic_a", "topic_b"};
+  rclcpp::Serialization<std_msgs::msg::String> serialization;
+
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = storage_id;
+    options.storage_config_uri = config_path + "/mcap_writer_options_compression_threads.yaml";
+
+    rosbag2_storage::StorageFactory factory;
+    auto writer = factory.open_read_write(options);
+    for (const auto & topic_name : topic_names) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data =
+        make_serialized_message("message " + std::to_string(i) + std::string(256, 'x'));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      bag_message->topic_name = topic_names[i % topic_names.size()];
+      writer->write(bag_message);
+    }
+    auto metadata = writer->get_metadata();
+    metadata.custom_data["key"] = "value";
+    writer->update_metadata(metadata);
+  }
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = storage_id;
+
+    rosbag2_storage::StorageFactory factory;
+    auto reader = factory.open_read_only(options);
+    // Message counts are taken from the summary
+    const auto metadata = reader->get_metadata();
+    EXPECT_EQ(metadata.message_count, message_count);
+    EXPECT_EQ(metadata.custom_data.at("key"), "value");
+    ASSERT_EQ(metadata.topics_with_message_count.size(), topic_names.size());
+    for (const auto & topic_info : metadata.topics_with_message_count) {
+      EXPECT_EQ(topic_info.message_count, message_count / topic_names.size());
+    }
+
+    size_t read_count = 0;
+    while (reader->has_next()) {
+      auto bag_message = reader->read_next();
+      ASSERT_EQ(bag_message->time_stamp, static_cast<rcutils_time_point_value_t>(read_count));
+      EXPECT_EQ(bag_message->topic_name, topic_names[read_count % topic_names.size()]);
+      ASSERT_NE(bag_message->interned_topic, nullptr);
+      EXPECT_EQ(bag_message->interned_topic,
+                &rosbag2_storage::intern_topic(topic_names[read_count % topic_names.size()]));
+      rclcpp::SerializedMessage extracted_serialized_msg(*bag_message->serialized_data);
+      std_msgs::msg::String read_msg;
+      serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+      EXPECT_EQ(read_msg.data, "message " + std::to_string(read_count) + std::string(256, 'x'));
+      ++read_count;
+    }
+    EXPECT_EQ(read_count, message_count);
+  }
+}
+#endif  // #ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+
+TEST_F(McapStorageTestFixture, writes_publish_time_and_sequence_numbers)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const rosbag2_storage::MessageDefinition definition = {"std_msgs/msg/String", "ros2msg",
+                                                         "string data", ""};
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    for (const std::string topic_name : {"topic_a", "topic_b"}) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, definition);
+    }
+    // Messages with publish information, followed by messages without
+    for (int64_t i = 0; i < 2; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("with publish info");
+      bag_message->time_stamp = 100 + i;
+      bag_message->topic_name = "topic_a";
+      bag_message->send_timestamp = 50 + i;
+      bag_message->sequence_number = 10 + static_cast<uint64_t>(i);
+      writer->write(bag_message);
+    }
+    for (int64_t i = 0; i < 4; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("without publish info");
+      bag_message->time_stamp = 200 + i;
+      bag_message->topic_name = i % 2 == 0 ? "topic_a" : "topic_b";
+      writer->write(bag_message);
+    }
+  }
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+#else
+  auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  while (reader->has_next()) {
+    messages.push_back(reader->read_next());
+  }
+  ASSERT_EQ(messages.size(), 6u);
+  EXPECT_EQ(messages[0]->send_timestamp, 50);
+  EXPECT_EQ(messages[0]->sequence_number, 10u);
+  EXPECT_EQ(messages[1]->send_timestamp, 51);
+  EXPECT_EQ(messages[1]->sequence_number, 11u);
+  // Without publish information the publish time is the receive time and messages are numbered
+  // per channel
+  for (size_t i = 2; i < messages.size(); ++i) {
+    EXPECT_EQ(messages[i]->send_timestamp, messages[i]->time_stamp);
+  }
+  EXPECT_EQ(messages[2]->sequence_number, 1u);
+  EXPECT_EQ(messages[3]->sequence_number, 1u);
+  EXPECT_EQ(messages[4]->sequence_number, 2u);
+  EXPECT_EQ(messages[5]->sequence_number, 2u);
+}
+
+TEST_F(McapStorageTestFixture, reads_messages_of_topics_selected_by_filter)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::vector<std::string> topic_names = {"/camera/image", "/camera/info", "/lidar"};
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    for (const auto & topic_name : topic_names) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (int64_t i = 0; i < 9; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message");
+      bag_message->time_stamp = i;
+      bag_message->topic_name = topic_names[static_cast<size_t>(i) % topic_names.size()];
+      writer->write(bag_message);
+    }
+  }
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+#else
+  auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+  const auto read_topics = [&reader]() {
+    std::vector<std::string> topics;
+    while (reader->has_next()) {
+      topics.push_back(reader->read_next()->topic_name);
+    }
+    return topics;
+  };
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics_regex = "/camera/.*";
+  storage_filter.topics_regex_to_exclude = ".*info";
+  reader->set_filter(storage_filter);
+  EXPECT_THAT(read_topics(), ElementsAre("/camera/image", "/camera/image", "/camera/image"));
+
+  // Filters are re-evaluated after seeking
+  reader->seek(4);
+  EXPECT_THAT(read_topics(), ElementsAre("/camera/image"));
+
+  // The topic list and the regular expressions all have to select a topic
+  storage_filter.topics = {"/camera/info", "/lidar"};
+  storage_filter.topics_regex_to_exclude = "";
+  reader->set_filter(storage_filter);
+  reader->seek(0);
+  EXPECT_THAT(read_topics(), ElementsAre("/camera/info", "/camera/info", "/camera/info"));
+
+  // Reading stops after the end time
+  storage_filter.end_time_ns = 5;
+  reader->set_filter(storage_filter);
+  reader->seek(0);
+  EXPECT_THAT(read_topics(), ElementsAre("/camera/info", "/camera/info"));
+
+  // Reading starts at the start time, also after seeking before it
+  storage_filter.start_time_ns = 2;
+  reader->set_filter(storage_filter);
+  reader->seek(0);
+  EXPECT_THAT(read_topics(), ElementsAre("/camera/info"));
+}
+
+TEST_F(McapStorageTestFixture, reads_batches_of_up_to_max_messages_or_bytes)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "/topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (int64_t i = 1; i <= 6; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = i;
+      bag_message->topic_name = topic_metadata.name;
+      writer->write(bag_message);
+    }
+  }
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+#else
+  auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+  const auto batch_time_stamps = [&reader](size_t max_messages, size_t max_bytes) {
+    std::vector<int64_t> time_stamps;
+    for (const auto & message : reader->read_next_batch(max_messages, max_bytes)) {
+      time_stamps.push_back(message->time_stamp);
+    }
+    return time_stamps;
+  };
+
+  EXPECT_THAT(batch_time_stamps(2, 0), ElementsAre(1, 2));
+  EXPECT_EQ(reader->read_next()->time_stamp, 3);
+  // A batch holds at least one message, even if it exceeds max_bytes
+  EXPECT_THAT(batch_time_stamps(0, 1), ElementsAre(4));
+  EXPECT_THAT(batch_time_stamps(0, 0), ElementsAre(5, 6));
+  EXPECT_THAT(batch_time_stamps(10, 0), IsEmpty());
+
+  // Seeking continues after the last message of a batch
+  reader->seek(2);
+  EXPECT_THAT(batch_time_stamps(1, 0), ElementsAre(2));
+  reader->set_filter({});
+  EXPECT_THAT(batch_time_stamps(1, 0), ElementsAre(3));
+}
+
+TEST_F(McapStorageTestFixture, for_each_hands_out_messages_until_callback_stops)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "/topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (int64_t i = 1; i <= 6; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = i;
+      bag_message->topic_name = topic_metadata.name;
+      writer->write(bag_message);
+    }
+  }
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+#else
+  auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+  const auto expected_size = make_serialized_message("message 1")->buffer_length;
+  std::vector<int64_t> time_stamps;
+  const auto collect_until = [&](int64_t last) {
+    return [&, last](const rosbag2_storage::SerializedBagMessageView & message) {
+      EXPECT_EQ(message.topic_name, "/topic");
+      EXPECT_EQ(message.size, expected_size);
+      time_stamps.push_back(message.time_stamp);
+      return message.time_stamp < last;
+    };
+  };
+
+  reader->for_each(collect_until(3));
+  EXPECT_THAT(time_stamps, ElementsAre(1, 2, 3));
+  // Reading continues after the message the callback stopped at
+  EXPECT_EQ(reader->read_next()->time_stamp, 4);
+  time_stamps.clear();
+  reader->for_each(collect_until(100));
+  EXPECT_THAT(time_stamps, ElementsAre(5, 6));
+  EXPECT_FALSE(reader->has_next());
+
+  reader->seek(2);
+  time_stamps.clear();
+  reader->for_each(collect_until(100));
+  EXPECT_THAT(time_stamps, ElementsAre(2, 3, 4, 5, 6));
+}
+
+TEST_F(McapStorageTestFixture, estimates_messages_and_bytes_of_filter_from_message_indexes)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::vector<std::string> topic_names = {"/camera/image", "/camera/info", "/lidar"};
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    for (const auto & topic_name : topic_names) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (int64_t i = 0; i < 9; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = i;
+      bag_message->topic_name = topic_names[static_cast<size_t>(i) % topic_names.size()];
+      writer->write(bag_message);
+    }
+  }
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+#else
+  auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+  // Reads the messages of the filter to compare the estimate to
+  const auto read_totals = [&reader](const rosbag2_storage::StorageFilter & storage_filter) {
+    rosbag2_storage::ReadEstimate read;
+    reader->set_filter(storage_filter);
+    reader->seek(0);
+    while (reader->has_next()) {
+      ++read.message_count;
+      read.bytes += reader->read_next()->serialized_data->buffer_length;
+    }
+    return read;
+  };
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics_regex = "/camera/.*";
+  storage_filter.start_time_ns = 1;
+  storage_filter.end_time_ns = 6;
+  auto estimate = reader->estimate(storage_filter);
+  EXPECT_TRUE(estimate.exact);
+  EXPECT_EQ(estimate.message_count, 4u);
+  auto read = read_totals(storage_filter);
+  EXPECT_EQ(estimate.message_count, read.message_count);
+  EXPECT_EQ(estimate.bytes, read.bytes);
+
+  // The estimate does not change the filter or the read head of the reader
+  reader->set_filter({});
+  reader->seek(3);
+  EXPECT_EQ(reader->estimate({}).message_count, 9u);
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->time_stamp, 3);
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+TEST_F(McapStorageTestFixture, seeks_in_unchunked_file_with_time_index)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const int64_t second = 1000 * 1000 * 1000;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_preset_profile = "fastwrite";
+    auto writer = factory.open_read_write(options);
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "/topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (int64_t i = 0; i < 10; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = i * second;
+      bag_message->topic_name = topic_metadata.name;
+      writer->write(bag_message);
+    }
+  }
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+
+  EXPECT_THAT(reader->get_time_index().entries(), Not(IsEmpty()));
+
+  reader->seek(7 * second);
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->time_stamp, 7 * second);
+  reader->seek(2 * second + 1);
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->time_stamp, 3 * second);
+  reader->seek(0);
+  ASSERT_TRUE(reader->has_next());
+  EXPECT_EQ(reader->read_next()->time_stamp, 0);
+}
+
+TEST_F(McapStorageTestFixture, reads_sampled_messages_of_each_topic)
+{
+  rosbag2_storage::StorageFactory factory;
+  const std::vector<std::string> topic_names = {"topic_a", "topic_b"};
+  // Chunked files are sampled from their message indexes, unchunked ones by reading them
+  for (const std::string preset : {"", "fastwrite"}) {
+    SCOPED_TRACE(preset);
+    auto uri = rcpputils::fs::path(temporary_dir_path_) / ("bag" + preset);
+    auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / ("bag" + preset + ".mcap");
+    {
+      rosbag2_storage::StorageOptions options;
+      options.uri = uri.string();
+      options.storage_id = "mcap";
+      options.storage_preset_profile = preset;
+      auto writer = factory.open_read_write(options);
+      for (const auto & topic_name : topic_names) {
+        rosbag2_storage::TopicMetadata topic_metadata;
+        topic_metadata.name = topic_name;
+        topic_metadata.type = "std_msgs/msg/String";
+        topic_metadata.serialization_format = "cdr";
+        writer->create_topic(
+          topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+      }
+      for (int64_t i = 0; i < 20; ++i) {
+        auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+        bag_message->time_stamp = i * 10;
+        bag_message->topic_name = topic_names[static_cast<size_t>(i) % topic_names.size()];
+        writer->write(bag_message);
+      }
+    }
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+    auto reader = factory.open_read_only(options);
+    const auto read_time_stamps = [&reader]() {
+      std::vector<rcutils_time_point_value_t> time_stamps;
+      while (reader->has_next()) {
+        time_stamps.push_back(reader->read_next()->time_stamp);
+      }
+      return time_stamps;
+    };
+
+    // topic_a is written at 0, 20, ..., 180 and topic_b at 10, 30, ..., 190
+    rosbag2_storage::StorageFilter storage_filter;
+    storage_filter.sample_stride = 3;
+    reader->set_filter(storage_filter);
+    EXPECT_THAT(read_time_stamps(), ElementsAre(0, 10, 60, 70, 120, 130, 180, 190));
+    if (preset.empty()) {
+      // Estimates of files without message indexes are taken from the metadata
+      EXPECT_EQ(reader->estimate(storage_filter).message_count, 8u);
+    }
+
+    // The samples do not change after seeking
+    reader->seek(100);
+    EXPECT_THAT(read_time_stamps(), ElementsAre(120, 130, 180, 190));
+
+    // The first message of each topic in every interval of 45 ns
+    storage_filter.sample_stride = 0;
+    storage_filter.sample_interval_ns = 45;
+    reader->set_filter(storage_filter);
+    reader->seek(0);
+    EXPECT_THAT(read_time_stamps(), ElementsAre(0, 10, 50, 60, 90, 100, 140, 150, 180, 190));
+
+    // Both are combined with the topic filter
+    storage_filter.topics = {"topic_b"};
+    storage_filter.sample_stride = 2;
+    reader->set_filter(storage_filter);
+    reader->seek(0);
+    EXPECT_THAT(read_time_stamps(), ElementsAre(10, 90, 190));
+  }
+}
+
+TEST_F(McapStorageTestFixture, reads_same_messages_with_decompressed_chunks_cached)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const std::vector<std::string> topic_names = {"topic_a", "topic_b"};
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = config_path + "/mcap_writer_options_compression_threads.yaml";
+    auto writer = factory.open_read_write(options);
+    for (const auto & topic_name : topic_names) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    // Log times are out of order, so that neighbouring chunks overlap and some messages share a
+    // log time
+    for (size_t i = 0; i < 2000; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data =
+        make_serialized_message("message " + std::to_string(i) + std::string(256, 'x'));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i + 100 * (i % 3));
+      bag_message->topic_name = topic_names[i % topic_names.size()];
+      writer->write(bag_message);
+    }
+  }
+
+  // Scrubs back and forth through the bag, like a player seeking repeatedly
+  const auto scrub = [&](const std::string & storage_config_uri) {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = storage_config_uri;
+    auto reader = factory.open_read_only(options);
+    rclcpp::Serialization<std_msgs::msg::String> serialization;
+    std::vector<std::tuple<std::string, rcutils_time_point_value_t, std::string>> messages;
+    const auto read_some = [&]() {
+      for (size_t i = 0; i < 150 && reader->has_next(); ++i) {
+        auto bag_message = reader->read_next();
+        rclcpp::SerializedMessage extracted_serialized_msg(*bag_message->serialized_data);
+        std_msgs::msg::String read_msg;
+        serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+        messages.emplace_back(bag_message->topic_name, bag_message->time_stamp, read_msg.data);
+      }
+    };
+    for (const rcutils_time_point_value_t time_stamp : {1500, 200, 1500, 900, 0, 2150}) {
+      reader->seek(time_stamp);
+      read_some();
+    }
+    read_some();
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_SET_READ_ORDER
+    EXPECT_TRUE(reader->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, false}));
+    reader->seek(300);
+    read_some();
+    EXPECT_TRUE(reader->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true}));
+    reader->seek(1200);
+    read_some();
+    reader->seek(1700);
+    read_some();
+#endif
+    rosbag2_storage::StorageFilter storage_filter;
+    storage_filter.topics = {"topic_b"};
+    reader->set_filter(storage_filter);
+    reader->seek(600);
+    read_some();
+    // Chunks after the end time and chunks without messages of topic_b in the time range are
+    // skipped
+    storage_filter.end_time_ns = 1100;
+    reader->set_filter(storage_filter);
+    reader->seek(1000);
+    read_some();
+    return messages;
+  };
+
+  const auto expected_messages = scrub("");
+  ASSERT_GT(expected_messages.size(), 1000u);
+  EXPECT_EQ(scrub(config_path + "/mcap_reader_options_chunk_cache.yaml"), expected_messages);
+  // Chunks decompressed ahead on other threads are merged in the same order
+  EXPECT_EQ(scrub(config_path + "/mcap_reader_options_decompression_threads.yaml"),
+            expected_messages);
+}
+#endif  // #ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+
+TEST_F(McapStorageTestFixture, reads_messages_of_uncompressed_chunks_without_copying)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const size_t message_count = 100;
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+#else
+    auto writer = factory.open_read_write(uri.string(), "mcap");
+#endif
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      bag_message->topic_name = "topic";
+      writer->write(bag_message);
+    }
+  }
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  {
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+    auto reader = factory.open_read_only(options);
+#else
+    auto reader = factory.open_read_only(expected_bag.string(), "mcap");
+#endif
+    while (reader->has_next()) {
+      messages.push_back(reader->read_next());
+    }
+  }
+
+  // The messages refer to the mapped file, which stays mapped after the reader was closed.
+  // The payloads are then laid out as in the chunk, separated by the fields of the next message
+  // record: opcode, record length, channel id, sequence, log time and publish time.
+  ASSERT_EQ(messages.size(), message_count);
+  const size_t message_record_overhead = 1 + 8 + 2 + 4 + 8 + 8;
+  rclcpp::Serialization<std_msgs::msg::String> serialization;
+  for (size_t i = 0; i < message_count; ++i) {
+    if (i > 0) {
+      const auto & previous = *messages[i - 1]->serialized_data;
+      EXPECT_EQ(previous.buffer + previous.buffer_length + message_record_overhead,
+                messages[i]->serialized_data->buffer);
+    }
+    rclcpp::SerializedMessage extracted_serialized_msg(*messages[i]->serialized_data);
+    std_msgs::msg::String read_msg;
+    serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+    EXPECT_EQ(read_msg.data, "message " + std::to_string(i));
+  }
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+TEST_F(McapStorageTestFixture, reads_metadata_only_from_summary_section)
+{
+  rosbag2_storage::StorageFactory factory;
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 10;
+  auto write_bag = [&](const std::string & name, const std::string & storage_config_uri) {
+      rosbag2_storage::StorageOptions options;
+      options.uri = (rcpputils::fs::path(temporary_dir_path_) / name).string();
+      options.storage_id = "mcap";
+      options.storage_config_uri = storage_config_uri;
+      auto writer = factory.open_read_write(options);
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = "topic";
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+      for (size_t i = 0; i < message_count; ++i) {
+        auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+        bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(100 + i);
+        bag_message->topic_name = "topic";
+        writer->write(bag_message);
+      }
+    };
+  write_bag("with_summary", "");
+  write_bag("without_summary", config_path + "/mcap_writer_options_no_summary.yaml");
+
+  auto open_reader = [&](const std::string & name, bool metadata_only) {
+      rosbag2_storage::StorageOptions options;
+      options.uri = (rcpputils::fs::path(temporary_dir_path_) / (name + ".mcap")).string();
+      options.storage_id = "mcap";
+      options.metadata_only = metadata_only;
+      return factory.open_read_only(options);
+    };
+
+  {
+    auto reader = open_reader("with_summary", true);
+    const auto metadata = reader->get_metadata();
+    EXPECT_EQ(metadata.message_count, message_count);
+    EXPECT_EQ(metadata.starting_time.time_since_epoch(), std::chrono::nanoseconds(100));
+    EXPECT_EQ(metadata.duration, std::chrono::nanoseconds(message_count - 1));
+    ASSERT_EQ(metadata.topics_with_message_count.size(), 1u);
+    EXPECT_EQ(metadata.topics_with_message_count[0].message_count, message_count);
+    // Reading messages was not prepared
+    EXPECT_FALSE(reader->has_next());
+  }
+  {
+    // The statistics of a file without summary can only be reconstructed by a full scan
+    auto reader = open_reader("without_summary", true);
+    EXPECT_THROW(reader->get_metadata(), std::runtime_error);
+  }
+  {
+    auto reader = open_reader("without_summary", false);
+    EXPECT_EQ(reader->get_metadata().message_count, message_count);
+  }
+}
+#endif
+
+TEST_F(McapStorageTestFixture, copies_chunks_of_selected_topics_and_time_range)
+{
+  rosbag2_storage::StorageFactory factory;
+  const size_t message_count = 20;
+  const std::vector<std::string> topic_names = {"topic_a", "topic_b"};
+  auto make_options = [&](const std::string & name) {
+      rosbag2_storage::StorageOptions options;
+      options.uri = (rcpputils::fs::path(temporary_dir_path_) / name).string();
+      options.storage_id = "mcap";
+      return options;
+    };
+  {
+    auto writer = factory.open_read_write(make_options("input"));
+    for (const auto & topic_name : topic_names) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(100 + i);
+      bag_message->topic_name = topic_names[i % topic_names.size()];
+      writer->write(bag_message);
+    }
+  }
+  const std::string input_uri = make_options("input").uri + ".mcap";
+
+  auto read_timestamps = [&](const std::string & name) {
+      auto options = make_options(name);
+      options.uri += ".mcap";
+      auto reader = factory.open_read_only(options);
+      std::vector<std::pair<std::string, rcutils_time_point_value_t>> messages;
+      while (reader->has_next()) {
+        auto bag_message = reader->read_next();
+        messages.emplace_back(bag_message->topic_name, bag_message->time_stamp);
+      }
+      return messages;
+    };
+
+  {
+    // All channels of the chunk are selected, so it is copied as stored
+    auto writer = factory.open_read_write(make_options("all_topics"));
+    const auto metadata = writer->copy_file(input_uri, {});
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->message_count, message_count);
+    EXPECT_EQ(metadata->starting_time.time_since_epoch(), std::chrono::nanoseconds(100));
+    EXPECT_EQ(metadata->topics_with_message_count.size(), topic_names.size());
+    // Nothing can be copied into a file which already has topics
+    EXPECT_FALSE(writer->copy_file(input_uri, {}).has_value());
+  }
+  EXPECT_THAT(read_timestamps("all_topics"), SizeIs(message_count));
+
+  {
+    rosbag2_storage::StorageFilter storage_filter;
+    storage_filter.topics = {"topic_a"};
+    storage_filter.start_time_ns = 110;
+    auto writer = factory.open_read_write(make_options("topic_a"));
+    const auto metadata = writer->copy_file(input_uri, storage_filter);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->message_count, 5u);
+    ASSERT_EQ(metadata->topics_with_message_count.size(), 1u);
+    EXPECT_EQ(metadata->topics_with_message_count[0].topic_metadata.name, "topic_a");
+  }
+  std::vector<std::pair<std::string, rcutils_time_point_value_t>> expected_messages;
+  for (rcutils_time_point_value_t time_stamp = 110; time_stamp < 120; time_stamp += 2) {
+    expected_messages.emplace_back("topic_a", time_stamp);
+  }
+  EXPECT_EQ(read_timestamps("topic_a"), expected_messages);
+
+  EXPECT_FALSE(factory.open_read_write(make_options("missing"))
+                 ->copy_file(make_options("does_not_exist").uri, {})
+                 .has_value());
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+TEST_F(McapStorageTestFixture, closes_chunks_after_max_chunk_duration)
+{
+  rosbag2_storage::StorageFactory factory;
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const int64_t period = 10000000;  // 10 ms
+  const size_t message_count = 50;
+  // Without chunk CRCs the plain writer is used, with compression threads the pipelined one
+  for (const std::string config : {"max_chunk_duration", "max_chunk_duration_threads"}) {
+    SCOPED_TRACE(config);
+    auto uri = rcpputils::fs::path(temporary_dir_path_) / config;
+    auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / (config + ".mcap");
+    {
+      rosbag2_storage::StorageOptions options;
+      options.uri = uri.string();
+      options.storage_id = "mcap";
+      options.storage_config_uri = config_path + "/mcap_writer_options_" + config + ".yaml";
+      auto writer = factory.open_read_write(options);
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = "/tf";
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+      for (size_t i = 0; i < message_count; ++i) {
+        auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        bag_message->serialized_data = make_serialized_message("hello");
+        bag_message->time_stamp = static_cast<int64_t>(i) * period;
+        bag_message->topic_name = topic_metadata.name;
+        writer->write(bag_message);
+      }
+    }
+
+    mcap::McapReader mcap_reader;
+    ASSERT_TRUE(mcap_reader.open(expected_bag.string()).ok());
+    ASSERT_TRUE(mcap_reader.readSummary(mcap::ReadSummaryMethod::NoFallbackScan).ok());
+    // 500 ms of messages in chunks of 100 ms, far below chunkSize
+    EXPECT_EQ(mcap_reader.chunkIndexes().size(), 5u);
+    for (const auto & chunk_index : mcap_reader.chunkIndexes()) {
+      EXPECT_LE(chunk_index.messageEndTime - chunk_index.messageStartTime, 100000000u);
+    }
+    mcap_reader.close();
+  }
+}
+
+TEST_F(McapStorageTestFixture, writes_heavy_topics_to_chunks_of_their_own)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  // /points is configured, /camera exceeds separateChunkBitrate, /tf stays in shared chunks
+  const std::vector<std::pair<std::string, size_t>> topics = {
+    {"/points", 2000}, {"/camera", 2000}, {"/tf", 20}};
+  const int64_t period = 10000000;  // 10 ms
+  const size_t rounds = 300;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = config_path + "/mcap_writer_options_topic_chunks.yaml";
+    auto writer = factory.open_read_write(options);
+    for (const auto & [topic_name, size] : topics) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic_name;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (size_t i = 0; i < rounds; ++i) {
+      for (const auto & [topic_name, size] : topics) {
+        auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        bag_message->serialized_data = make_serialized_message(std::string(size, 'x'));
+        bag_message->time_stamp = static_cast<int64_t>(i) * period;
+        bag_message->topic_name = topic_name;
+        writer->write(bag_message);
+      }
+    }
+  }
+
+  mcap::McapReader mcap_reader;
+  ASSERT_TRUE(mcap_reader.open(expected_bag.string()).ok());
+  ASSERT_TRUE(mcap_reader.readSummary(mcap::ReadSummaryMethod::NoFallbackScan).ok());
+  std::map<mcap::ChannelId, std::string> channel_topics;
+  for (const auto & [channel_id, channel] : mcap_reader.channels()) {
+    channel_topics[channel_id] = channel->topic;
+  }
+  size_t points_chunks = 0;
+  std::vector<std::vector<std::string>> chunk_topics;
+  for (const auto & chunk_index : mcap_reader.chunkIndexes()) {
+    std::vector<std::string> topics_of_chunk;
+    for (const auto & [channel_id, offset] : chunk_index.messageIndexOffsets) {
+      topics_of_chunk.push_back(channel_topics[channel_id]);
+    }
+    if (std::find(topics_of_chunk.begin(), topics_of_chunk.end(), "/points") !=
+        topics_of_chunk.end()) {
+      EXPECT_THAT(topics_of_chunk, ElementsAre("/points"));
+      ++points_chunks;
+    }
+    chunk_topics.push_back(topics_of_chunk);
+  }
+  // 600 KB of /points in chunks of 64 KiB
+  EXPECT_GE(points_chunks, 9u);
+  EXPECT_LE(points_chunks, 10u);
+  // /camera is moved out of the shared chunks after a second of recording
+  ASSERT_FALSE(chunk_topics.empty());
+  EXPECT_TRUE(std::any_of(chunk_topics.begin(), chunk_topics.end(), [](const auto & topics) {
+    return topics.size() == 1 && topics[0] == "/camera";
+  }));
+  EXPECT_TRUE(std::any_of(chunk_topics.begin(), chunk_topics.end(), [](const auto & topics) {
+    return topics.size() == 1 && topics[0] == "/tf";
+  }));
+  mcap_reader.close();
+
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {"/tf"};
+  reader->set_filter(storage_filter);
+  size_t read_count = 0;
+  while (reader->has_next()) {
+    auto bag_message = reader->read_next();
+    EXPECT_EQ(bag_message->topic_name, "/tf");
+    EXPECT_EQ(bag_message->time_stamp, static_cast<int64_t>(read_count) * period);
+    ++read_count;
+  }
+  EXPECT_EQ(read_count, rounds);
+}
+#endif  // #ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_READABLE_FILE
+namespace
+{
+class MemoryReadableFile : public rosbag2_storage::ReadableFile
+{
+public:
+  explicit MemoryReadableFile(std::vector<uint8_t> data)
+      : data_(std::move(data))
+  {
+  }
+
+  uint64_t size() const override
+  {
+    return data_.size();
+  }
+
+  uint64_t read(uint8_t * data, uint64_t offset, uint64_t size) override
+  {
+    const uint64_t count = offset < data_.size() ? std::min(size, data_.size() - offset) : 0;
+    std::copy_n(data_.begin() + offset, count, data);
+    return count;
+  }
+
+private:
+  std::vector<uint8_t> data_;
+};
+}  // namespace
+
+TEST_F(McapStorageTestFixture, reads_messages_from_readable_file_instead_of_uri)
+{
+  std::vector<std::tuple<std::string, int64_t, rosbag2_storage::TopicMetadata,
+                         rosbag2_storage::MessageDefinition>>
+    messages;
+  rosbag2_storage::TopicMetadata topic_metadata{"topic", "std_msgs/msg/String", "cdr", {}, ""};
+  for (int64_t i = 0; i < 10; ++i) {
+    messages.emplace_back("message " + std::to_string(i), i, topic_metadata,
+                          rosbag2_storage::MessageDefinition{"std_msgs/msg/String", "ros2msg",
+                                                             "string data", ""});
+  }
+  write_messages_to_mcap(messages).reset();
+
+  const auto bag_path = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  std::vector<uint8_t> data(bag_path.file_size());
+  {
+    std::ifstream input(bag_path.string(), std::ios::binary);
+    input.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  }
+  ASSERT_TRUE(rcpputils::fs::remove(bag_path));
+
+  rosbag2_storage::StorageFactory factory;
+  rosbag2_storage::StorageOptions options;
+  options.uri = bag_path.string();
+  options.storage_id = "mcap";
+  options.readable_file = std::make_shared<MemoryReadableFile>(std::move(data));
+  auto reader = factory.open_read_only(options);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->get_bagfile_size(), options.readable_file->size());
+
+  rclcpp::Serialization<std_msgs::msg::String> serialization;
+  size_t count = 0;
+  while (reader->has_next()) {
+    auto message = reader->read_next();
+    rclcpp::SerializedMessage extracted_serialized_msg(*message->serialized_data);
+    std_msgs::msg::String read_msg;
+    serialization.deserialize_message(&extracted_serialized_msg, &read_msg);
+    EXPECT_EQ(read_msg.data, "message " + std::to_string(count));
+    ++count;
+  }
+  EXPECT_EQ(count, messages.size());
+}
+#endif  // #ifdef ROSBAG2_STORAGE_MCAP_HAS_READABLE_FILE
+
+TEST_F(McapStorageTestFixture, detects_mcap_files_by_magic_bytes)
+{
+  std::vector<std::tuple<std::string, int64_t, rosbag2_storage::TopicMetadata,
+                         rosbag2_storage::MessageDefinition>>
+    messages;
+  rosbag2_storage::TopicMetadata topic_metadata{"topic", "std_msgs/msg/String", "cdr", {}, ""};
+  messages.emplace_back("message", 1, topic_metadata,
+                        rosbag2_storage::MessageDefinition{"std_msgs/msg/String", "ros2msg",
+                                                           "string data", ""});
+  write_messages_to_mcap(messages).reset();
+  const auto bag_path = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const auto other_path = rcpputils::fs::path(temporary_dir_path_) / "other.mcap";
+  {
+    std::ofstream other(other_path.string(), std::ios::binary);
+    other << "not an mcap file";
+  }
+
+  // Without a storage id, the storage is chosen by probing the file
+  rosbag2_storage::StorageFactory factory;
+  rosbag2_storage::StorageOptions options;
+  options.uri = bag_path.string();
+  auto reader = factory.open_read_only(options);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->get_storage_identifier(), "mcap");
+  EXPECT_TRUE(reader->probe(bag_path.string()));
+  EXPECT_FALSE(reader->probe(other_path.string()));
+}
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
+TEST_F(McapStorageTestFixture, recovers_summary_of_interrupted_recording_if_configured)
+{
+  rosbag2_storage::StorageFactory factory;
+  const auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  const auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 1000;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    auto writer = factory.open_read_write(options);
+    for (const std::string topic : {"topic", "other_topic"}) {
+      rosbag2_storage::TopicMetadata topic_metadata;
+      topic_metadata.name = topic;
+      topic_metadata.type = "std_msgs/msg/String";
+      topic_metadata.serialization_format = "cdr";
+      writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    }
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(100 + i);
+      bag_message->topic_name = i % 4 == 0 ? "other_topic" : "topic";
+      writer->write(bag_message);
+    }
+  }
+
+  // Cut off the footer and a part of the summary, and pad the file with zeros like a
+  // preallocated file
+  const auto file_size = std::filesystem::file_size(expected_bag.string());
+  std::filesystem::resize_file(expected_bag.string(), file_size - 64);
+  std::filesystem::resize_file(expected_bag.string(), file_size + 4096);
+
+  auto open_reader = [&](const std::string & storage_config_uri) {
+      rosbag2_storage::StorageOptions options;
+      options.uri = expected_bag.string();
+      options.storage_id = "mcap";
+      options.storage_config_uri = storage_config_uri;
+      options.metadata_only = true;
+      return factory.open_read_only(options);
+    };
+  EXPECT_THROW(open_reader("")->get_metadata(), std::runtime_error);
+
+  const auto check_metadata = [&](const rosbag2_storage::BagMetadata & metadata) {
+      EXPECT_EQ(metadata.message_count, message_count);
+      EXPECT_EQ(metadata.starting_time.time_since_epoch(), std::chrono::nanoseconds(100));
+      EXPECT_EQ(metadata.duration, std::chrono::nanoseconds(message_count - 1));
+      std::map<std::string, size_t> topic_message_counts;
+      for (const auto & topic : metadata.topics_with_message_count) {
+        topic_message_counts[topic.topic_metadata.name] = topic.message_count;
+      }
+      EXPECT_EQ(topic_message_counts["topic"], message_count * 3 / 4);
+      EXPECT_EQ(topic_message_counts["other_topic"], message_count / 4);
+    };
+  check_metadata(
+    open_reader(config_path + "/mcap_reader_options_recover_summary.yaml")->get_metadata());
+  // The file was repaired in place, its summary is read without recovering it again
+  EXPECT_LT(std::filesystem::file_size(expected_bag.string()), file_size + 4096);
+  check_metadata(open_reader("")->get_metadata());
+
+  rosbag2_storage::StorageOptions options;
+  options.uri = expected_bag.string();
+  options.storage_id = "mcap";
+  auto reader = factory.open_read_only(options);
+  size_t count = 0;
+  for (; reader->has_next(); reader->read_next()) {
+    ++count;
+  }
+  EXPECT_EQ(count, message_count);
+}
+#endif
+
+#ifdef ROSBAG2_STORAGE_MCAP_HAS_DURABILITY_POLICY
+TEST_F(McapStorageTestFixture, durability_policy_writes_chunks_of_open_recording_to_file)
+{
+  rosbag2_storage::StorageFactory factory;
+  const auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  const auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const auto snapshot_bag = rcpputils::fs::path(temporary_dir_path_) / "snapshot.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 1000;
+  const uint64_t durability_bytes = 4096;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.durability_bytes = durability_bytes;
+    auto writer = factory.open_read_write(options);
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    uint64_t last_message_size = 0;
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(100 + i);
+      bag_message->topic_name = "topic";
+      writer->write(bag_message);
+      last_message_size = bag_message->serialized_data->buffer_length;
+    }
+    // The file as it would be found after a power cut, before the recording is closed
+    std::filesystem::copy_file(expected_bag.string(), snapshot_bag.string());
+
+    rosbag2_storage::StorageOptions read_options;
+    read_options.uri = snapshot_bag.string();
+    read_options.storage_id = "mcap";
+    read_options.storage_config_uri = config_path + "/mcap_reader_options_recover_summary.yaml";
+    read_options.metadata_only = true;
+    const auto metadata = factory.open_read_only(read_options)->get_metadata();
+    // Only the messages written since the last commit are missing
+    EXPECT_LE(metadata.message_count, message_count);
+    EXPECT_GE(metadata.message_count, message_count - durability_bytes / last_message_size);
+  }
+}
+#endif
+
+TEST_F(McapStorageTestFixture, skips_chunks_not_matching_their_crc_if_configured)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 1000;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = config_path + "/mcap_writer_options_chunk_crc.yaml";
+    auto writer = factory.open_read_write(options);
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      bag_message->topic_name = "topic";
+      writer->write(bag_message);
+    }
+  }
+
+  const auto count_messages = [&](const std::string & storage_config_uri) {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = storage_config_uri;
+    auto reader = factory.open_read_only(options);
+    size_t count = 0;
+    for (; reader->has_next(); reader->read_next()) {
+      ++count;
+    }
+    return count;
+  };
+  const std::string validate_config = config_path + "/mcap_reader_options_validate_crc.yaml";
+  EXPECT_EQ(count_messages(validate_config), message_count);
+
+  // Corrupt the payload of a message in the uncompressed chunks
+  {
+    std::fstream file(expected_bag.string(), std::ios::in | std::ios::out | std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    const auto position = content.find("message 500");
+    ASSERT_NE(position, std::string::npos);
+    file.seekp(static_cast<std::streamoff>(position));
+    file.put('M');
+  }
+  EXPECT_EQ(count_messages(""), message_count);
+  const size_t validated_count = count_messages(validate_config);
+  EXPECT_LT(validated_count, message_count);
+  EXPECT_GT(validated_count, 0u);
+}
+
+TEST_F(McapStorageTestFixture, verify_locates_chunks_not_matching_their_crc)
+{
+  rosbag2_storage::StorageFactory factory;
+  auto uri = rcpputils::fs::path(temporary_dir_path_) / "bag";
+  auto expected_bag = rcpputils::fs::path(temporary_dir_path_) / "bag.mcap";
+  const std::string config_path = _TEST_RESOURCES_DIR_PATH;
+  const size_t message_count = 1000;
+  {
+    rosbag2_storage::StorageOptions options;
+    options.uri = uri.string();
+    options.storage_id = "mcap";
+    options.storage_config_uri = config_path + "/mcap_writer_options_chunk_crc.yaml";
+    auto writer = factory.open_read_write(options);
+    rosbag2_storage::TopicMetadata topic_metadata;
+    topic_metadata.name = "topic";
+    topic_metadata.type = "std_msgs/msg/String";
+    topic_metadata.serialization_format = "cdr";
+    writer->create_topic(topic_metadata, {"std_msgs/msg/String", "ros2msg", "string data", ""});
+    for (size_t i = 0; i < message_count; ++i) {
+      auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      bag_message->serialized_data = make_serialized_message("message " + std::to_string(i));
+      bag_message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      bag_message->topic_name = "topic";
+      writer->write(bag_message);
+    }
+  }
+
+  const auto verify = [&]() {
+    rosbag2_storage::StorageOptions options;
+    options.uri = expected_bag.string();
+    options.storage_id = "mcap";
+    return factory.open_read_only(options)->verify();
+  };
+  const auto intact = verify();
+  EXPECT_TRUE(intact.checked);
+  EXPECT_TRUE(intact.problems.empty());
+  EXPECT_EQ(intact.topic_message_counts.at("topic"), message_count);
+
+  uint64_t corrupted_offset = 0;
+  {
+    std::fstream file(expected_bag.string(), std::ios::in | std::ios::out | std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    const auto position = content.find("message 500");
+    ASSERT_NE(position, std::string::npos);
+    corrupted_offset = position;
+    file.seekp(static_cast<std::streamoff>(position));
+    file.put('M');
+  }
+  const auto corrupted = verify();
+  ASSERT_EQ(corrupted.problems.size(), 1u);
+  const auto & problem = corrupted.problems[0];
+  EXPECT_THAT(problem.description, HasSubstr("CRC"));
+  EXPECT_LE(problem.start_offset, corrupted_offset);
+  EXPECT_GT(problem.end_offset, corrupted_offset);
+  EXPECT_LE(problem.start_time, 500);
+  EXPECT_GE(problem.end_time, 500);
+  EXPECT_LT(corrupted.topic_message_counts.at("topic"), message_count);
+}
 #endif  // #ifdef ROSBAG2_STORAGE_MCAP_HAS_STORAGE_OPTIONS
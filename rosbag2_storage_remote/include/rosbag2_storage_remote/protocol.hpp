@@ -0,0 +1,134 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_REMOTE__PROTOCOL_HPP_
+#define ROSBAG2_STORAGE_REMOTE__PROTOCOL_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/message_definition.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_storage/topic_metadata.hpp"
+#include "rosbag2_storage_remote/visibility_control.hpp"
+
+/**
+ * Protocol between the remote storage plugin, which streams the messages of a bag file, and the
+ * sink, which writes them with a storage plugin of its own.
+ *
+ * Every frame starts with a header of kFrameHeaderSize bytes: the magic number, the frame type,
+ * flags, the sequence number and the size of the payload, all little endian. Every frame of a
+ * file sent by the plugin has a sequence number one greater than the one before. The sink
+ * acknowledges every frame once it is written, so that the plugin can resend frames which were
+ * not written after a reconnection, and the sink can drop those it already wrote.
+ */
+namespace rosbag2_storage_remote
+{
+
+constexpr uint32_t kFrameMagic = 0x52324252;  // "RB2R"
+constexpr uint32_t kProtocolVersion = 1;
+constexpr uint16_t kDefaultPort = 7447;
+constexpr size_t kFrameHeaderSize = 24;
+constexpr uint64_t kMaxPayloadSize = 1ull << 32;
+
+enum class FrameType : uint8_t
+{
+  /// Plugin to sink: start or resume a bag file.
+  OPEN = 1,
+  /// Sink to plugin: the file is open, with the sequence number of the last frame written.
+  OPENED = 2,
+  CREATE_TOPIC = 3,
+  REMOVE_TOPIC = 4,
+  /// A batch of messages.
+  MESSAGES = 5,
+  /// Plugin to sink: the file is complete.
+  CLOSE = 6,
+  /// Sink to plugin: the frame with the sequence number and all before it are written.
+  ACK = 7,
+  /// Sink to plugin: the file can not be written, with the reason.
+  FAILURE = 8,
+};
+
+/// The payload of a MESSAGES frame is a zstd frame.
+constexpr uint8_t kFlagZstdCompressed = 1;
+
+struct Frame
+{
+  FrameType type;
+  uint8_t flags = 0;
+  uint64_t sequence = 0;
+  std::vector<uint8_t> payload;
+};
+
+struct OpenRequest
+{
+  uint32_t protocol_version = kProtocolVersion;
+  /// Name of the directory of the bag on the sink.
+  std::string bag_name;
+  /// Name of the file in the bag directory, without the extension of the storage.
+  std::string file_name;
+  /// Storage the sink writes the file with. Empty for the default of the sink.
+  std::string storage_id;
+};
+
+/// Header and payload of a frame, as sent or spilled.
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::vector<uint8_t> encode_frame(const Frame & frame);
+
+/// Parse a frame header.
+/// \returns the size of the payload following it.
+/// \throws std::runtime_error if the header is not valid.
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+uint64_t decode_frame_header(const uint8_t * header, Frame & frame);
+
+/// Read a frame written by encode_frame from a stream.
+/// \returns false at the end of the stream, or if the last frame is truncated.
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+bool read_frame(std::istream & stream, Frame & frame);
+
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::vector<uint8_t> encode_open(const OpenRequest & request);
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+OpenRequest decode_open(const Frame & frame);
+
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::vector<uint8_t> encode_topic(
+  const rosbag2_storage::TopicMetadata & topic,
+  const rosbag2_storage::MessageDefinition & message_definition);
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+void decode_topic(
+  const Frame & frame, rosbag2_storage::TopicMetadata & topic,
+  rosbag2_storage::MessageDefinition & message_definition);
+
+/// Payload of a MESSAGES frame.
+/// \param compression_level zstd level to compress the payload with, 0 does not compress it.
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+Frame encode_messages(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages,
+  int compression_level);
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> decode_messages(
+  const Frame & frame);
+
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::vector<uint8_t> encode_string(const std::string & value);
+ROSBAG2_STORAGE_REMOTE_PUBLIC
+std::string decode_string(const Frame & frame);
+
+}  // namespace rosbag2_storage_remote
+
+#endif  // ROSBAG2_STORAGE_REMOTE__PROTOCOL_HPP_
@@ -0,0 +1,82 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_REMOTE__REMOTE_SINK_HPP_
+#define ROSBAG2_STORAGE_REMOTE__REMOTE_SINK_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "rosbag2_storage_remote/protocol.hpp"
+#include "rosbag2_storage_remote/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_storage_remote
+{
+
+class RemoteSinkImpl;
+
+/**
+ * Service which receives bag files streamed by the remote storage plugin and writes them with
+ * a storage plugin into bags in an output directory, named like the bags they are recorded to.
+ *
+ * Every connection is served by a thread of its own. A file which lost its connection stays
+ * open until the plugin reconnects and resumes it, or until the sink is stopped. The metadata
+ * of a bag is updated each time one of its files is closed.
+ */
+class ROSBAG2_STORAGE_REMOTE_PUBLIC RemoteSink
+{
+public:
+  struct Options
+  {
+    std::string output_directory;
+    std::string host = "0.0.0.0";
+    /// Port to listen on, 0 for a free port.
+    uint16_t port = kDefaultPort;
+    /// Storage to write with if the plugin does not request one, empty for the default.
+    std::string storage_id;
+    std::string storage_config_uri;
+  };
+
+  /// Start listening for connections.
+  /// \throws std::runtime_error if the port can not be listened on.
+  explicit RemoteSink(const Options & options);
+
+  /// Stop the sink, closing all files.
+  ~RemoteSink();
+
+  uint16_t port() const;
+
+  /// Close all connections and files. Called by the destructor.
+  void stop();
+
+private:
+  std::unique_ptr<RemoteSinkImpl> impl_;
+};
+
+}  // namespace rosbag2_storage_remote
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_STORAGE_REMOTE__REMOTE_SINK_HPP_
@@ -0,0 +1,195 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_REMOTE__REMOTE_STORAGE_HPP_
+#define ROSBAG2_STORAGE_REMOTE__REMOTE_STORAGE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+#include "rosbag2_storage_remote/protocol.hpp"
+#include "rosbag2_storage_remote/tcp_socket.hpp"
+#include "rosbag2_storage_remote/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_storage_remote
+{
+
+/**
+ * Write only storage which streams the messages of a bag file to a remote sink, which writes
+ * them with a storage plugin of its own. Nothing is written to the local disk while the sink
+ * is reachable.
+ *
+ * Every batch of messages written at once, e.g. by the message cache, is sent as one frame,
+ * optionally compressed with zstd. At most max_unacknowledged_bytes are sent before the sink
+ * acknowledged writing them, write() blocks beyond that. A sink or network slower than the
+ * recording so fills the message cache, whose overflow policy then decides whether to drop,
+ * block or spill messages.
+ *
+ * If the sink can not be reached, frames are appended to a spill file at the path of the bag
+ * file instead, and the connection is retried every reconnect_interval. Once reconnected, the
+ * frames the sink did not write and the spilled frames are sent before any new ones. Spilled
+ * frames which are still not sent when the storage is closed stay in the spill file.
+ */
+class ROSBAG2_STORAGE_REMOTE_PUBLIC RemoteStorage
+  : public rosbag2_storage::storage_interfaces::ReadWriteInterface
+{
+public:
+  static constexpr const char * kFileExtension = ".remote";
+
+  struct Options
+  {
+    std::string host = "localhost";
+    uint16_t port = kDefaultPort;
+    /// Storage the sink writes the bag with, empty for the default of the sink.
+    std::string sink_storage_id;
+    /// zstd level to compress batches of messages with, 0 does not compress.
+    int compression_level = 0;
+    uint64_t max_unacknowledged_bytes = 16 * 1024 * 1024;
+    std::chrono::milliseconds connect_timeout{2000};
+    std::chrono::milliseconds reconnect_interval{1000};
+    /// Time to wait for acknowledgements before the connection is considered failed.
+    std::chrono::milliseconds ack_timeout{10000};
+  };
+
+  /// Parse the options from a storage configuration file.
+  /// \throws std::runtime_error if the file can not be parsed.
+  static Options parse_options(const std::string & storage_config_uri);
+
+  RemoteStorage();
+
+  ~RemoteStorage() override;
+
+  /// \throws std::runtime_error if opened for reading, which is not supported.
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    rosbag2_storage::storage_interfaces::IOFlag io_flag =
+    rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE) override;
+
+  bool probe(const std::string & uri) const override;
+
+  /// The sink writes the metadata of the bag itself.
+  void update_metadata(const rosbag2_storage::BagMetadata & metadata) override;
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic) override;
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata & topic,
+    const rosbag2_storage::MessageDefinition & message_definition) override;
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override;
+
+  void write(
+    const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+  override;
+
+  bool set_read_order(const rosbag2_storage::ReadOrder &) override;
+
+  bool has_next() override;
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
+
+  std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override;
+
+  void get_all_message_definitions(
+    std::vector<rosbag2_storage::MessageDefinition> & definitions) override;
+
+  rosbag2_storage::BagMetadata get_metadata() override;
+
+  std::string get_relative_file_path() const override;
+
+  /// Bytes of serialized messages written.
+  uint64_t get_bagfile_size() const override;
+
+  std::string get_storage_identifier() const override;
+
+  uint64_t get_minimum_split_file_size() const override;
+
+  void set_filter(const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  void reset_filter() override;
+
+  void seek(const rcutils_time_point_value_t & timestamp) override;
+
+  /// Whether the storage is connected to the sink.
+  bool is_connected() const;
+
+  /// Number of frames in the spill file.
+  size_t get_spilled_frame_count() const;
+
+private:
+  void open_for_writing(const rosbag2_storage::StorageOptions & storage_options);
+  void close();
+  void throw_read_not_supported() const;
+
+  // Send a new frame, or spill it if the sink is not reachable
+  void send_frame(Frame frame);
+  bool send_to_sink(std::vector<uint8_t> encoded, uint64_t sequence);
+  void spill(const std::vector<uint8_t> & encoded);
+  // Connect, then resend unacknowledged and spilled frames. Rate limited unless forced.
+  bool reconnect(bool force);
+  bool resend_pending_frames(uint64_t last_written_sequence);
+  // Receive acknowledgements, waiting up to timeout for the first one
+  bool receive_acks(std::chrono::milliseconds timeout);
+  bool wait_for_window();
+  void disconnect();
+  void keep_unsent_frames();
+
+  struct SentFrame
+  {
+    uint64_t sequence;
+    std::vector<uint8_t> encoded;
+  };
+
+  Options options_;
+  std::string relative_path_;
+  OpenRequest open_request_;
+  rosbag2_storage::BagMetadata metadata_;
+  std::unordered_map<std::string, size_t> topic_indices_;
+  uint64_t bagfile_size_ = 0;
+  bool is_open_ = false;
+
+  std::unique_ptr<TcpSocket> socket_;
+  std::chrono::steady_clock::time_point next_reconnect_;
+  uint64_t next_sequence_ = 1;
+  // Frames sent but not acknowledged yet, in order
+  std::deque<SentFrame> unacknowledged_;
+  uint64_t unacknowledged_bytes_ = 0;
+
+  std::string spill_path_;
+  std::ofstream spill_;
+  size_t spilled_frames_ = 0;
+};
+
+}  // namespace rosbag2_storage_remote
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_STORAGE_REMOTE__REMOTE_STORAGE_HPP_
@@ -0,0 +1,90 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_REMOTE__TCP_SOCKET_HPP_
+#define ROSBAG2_STORAGE_REMOTE__TCP_SOCKET_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage_remote/protocol.hpp"
+#include "rosbag2_storage_remote/visibility_control.hpp"
+
+namespace rosbag2_storage_remote
+{
+
+/// Connected TCP socket which sends and receives frames of the remote storage protocol.
+class ROSBAG2_STORAGE_REMOTE_PUBLIC TcpSocket
+{
+public:
+  explicit TcpSocket(int fd);
+  ~TcpSocket();
+
+  TcpSocket(const TcpSocket &) = delete;
+  TcpSocket & operator=(const TcpSocket &) = delete;
+
+  /// Connect to host and port within timeout.
+  /// \returns nullptr if the connection failed.
+  static std::unique_ptr<TcpSocket> connect(
+    const std::string & host, uint16_t port, std::chrono::milliseconds timeout);
+
+  /// \returns false if the connection failed.
+  bool send(const std::vector<uint8_t> & data);
+
+  /// Wait up to timeout for a frame and receive it.
+  /// \returns false if no frame arrived within timeout or the connection failed, see is_open().
+  bool receive(Frame & frame, std::chrono::milliseconds timeout);
+
+  /// Whether the connection did not fail.
+  bool is_open() const;
+
+  /// Stop sending and receiving, e.g. to wake up a thread blocked in receive().
+  void shutdown();
+
+private:
+  bool receive_all(uint8_t * data, size_t size);
+
+  int fd_;
+  bool open_ = true;
+};
+
+/// Listening TCP socket.
+class ROSBAG2_STORAGE_REMOTE_PUBLIC TcpListener
+{
+public:
+  /// Listen on host and port. Port 0 listens on a free port, see port().
+  /// \throws std::runtime_error if the socket can not be bound.
+  TcpListener(const std::string & host, uint16_t port);
+  ~TcpListener();
+
+  TcpListener(const TcpListener &) = delete;
+  TcpListener & operator=(const TcpListener &) = delete;
+
+  /// Wait up to timeout for a connection.
+  /// \returns nullptr if no connection arrived within timeout.
+  std::unique_ptr<TcpSocket> accept(std::chrono::milliseconds timeout);
+
+  uint16_t port() const;
+
+private:
+  int fd_;
+  uint16_t port_;
+};
+
+}  // namespace rosbag2_storage_remote
+
+#endif  // ROSBAG2_STORAGE_REMOTE__TCP_SOCKET_HPP_
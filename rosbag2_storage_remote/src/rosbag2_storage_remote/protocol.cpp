@@ -0,0 +1,319 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage_remote/protocol.hpp"
+
+#include <zstd.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/qos.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_storage_remote
+{
+
+namespace
+{
+// Version of the serialized offered QoS profiles of a topic
+constexpr int kQosVersion = 9;
+
+class PayloadWriter
+{
+public:
+  void u8(uint8_t value)
+  {
+    data.push_back(value);
+  }
+
+  void u32(uint32_t value)
+  {
+    for (int i = 0; i < 4; ++i) {
+      data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+
+  void u64(uint64_t value)
+  {
+    for (int i = 0; i < 8; ++i) {
+      data.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+
+  void bytes(const uint8_t * buffer, size_t size)
+  {
+    u64(size);
+    data.insert(data.end(), buffer, buffer + size);
+  }
+
+  void string(const std::string & value)
+  {
+    bytes(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+  }
+
+  std::vector<uint8_t> data;
+};
+
+class PayloadReader
+{
+public:
+  PayloadReader(const uint8_t * data, size_t size)
+  : data_(data), size_(size) {}
+
+  uint32_t u32()
+  {
+    check(4);
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<uint32_t>(data_[position_++]) << (8 * i);
+    }
+    return value;
+  }
+
+  uint64_t u64()
+  {
+    check(8);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(data_[position_++]) << (8 * i);
+    }
+    return value;
+  }
+
+  const uint8_t * bytes(size_t & size)
+  {
+    size = static_cast<size_t>(u64());
+    check(size);
+    const uint8_t * bytes = data_ + position_;
+    position_ += size;
+    return bytes;
+  }
+
+  std::string string()
+  {
+    size_t size = 0;
+    const uint8_t * data = bytes(size);
+    return std::string(reinterpret_cast<const char *>(data), size);
+  }
+
+private:
+  void check(size_t size) const
+  {
+    if (size > size_ - position_) {
+      throw std::runtime_error("Truncated payload of remote storage frame.");
+    }
+  }
+
+  const uint8_t * data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+}  // namespace
+
+std::vector<uint8_t> encode_frame(const Frame & frame)
+{
+  PayloadWriter writer;
+  writer.data.reserve(kFrameHeaderSize + frame.payload.size());
+  writer.u32(kFrameMagic);
+  writer.u8(static_cast<uint8_t>(frame.type));
+  writer.u8(frame.flags);
+  writer.u8(0);
+  writer.u8(0);
+  writer.u64(frame.sequence);
+  writer.u64(frame.payload.size());
+  writer.data.insert(writer.data.end(), frame.payload.begin(), frame.payload.end());
+  return writer.data;
+}
+
+uint64_t decode_frame_header(const uint8_t * header, Frame & frame)
+{
+  PayloadReader reader(header, kFrameHeaderSize);
+  if (reader.u32() != kFrameMagic) {
+    throw std::runtime_error("Not a remote storage frame.");
+  }
+  const uint32_t type_and_flags = reader.u32();
+  frame.type = static_cast<FrameType>(type_and_flags & 0xff);
+  frame.flags = static_cast<uint8_t>((type_and_flags >> 8) & 0xff);
+  frame.sequence = reader.u64();
+  const uint64_t payload_size = reader.u64();
+  if (payload_size > kMaxPayloadSize) {
+    throw std::runtime_error(
+            "Remote storage frame payload of " + std::to_string(payload_size) +
+            " bytes exceeds the maximum size.");
+  }
+  return payload_size;
+}
+
+bool read_frame(std::istream & stream, Frame & frame)
+{
+  uint8_t header[kFrameHeaderSize];
+  if (!stream.read(reinterpret_cast<char *>(header), kFrameHeaderSize)) {
+    return false;
+  }
+  const uint64_t payload_size = decode_frame_header(header, frame);
+  frame.payload.resize(static_cast<size_t>(payload_size));
+  return static_cast<bool>(
+    stream.read(
+      reinterpret_cast<char *>(frame.payload.data()),
+      static_cast<std::streamsize>(payload_size)));
+}
+
+std::vector<uint8_t> encode_open(const OpenRequest & request)
+{
+  PayloadWriter writer;
+  writer.u32(request.protocol_version);
+  writer.string(request.bag_name);
+  writer.string(request.file_name);
+  writer.string(request.storage_id);
+  return writer.data;
+}
+
+OpenRequest decode_open(const Frame & frame)
+{
+  PayloadReader reader(frame.payload.data(), frame.payload.size());
+  OpenRequest request;
+  request.protocol_version = reader.u32();
+  request.bag_name = reader.string();
+  request.file_name = reader.string();
+  request.storage_id = reader.string();
+  return request;
+}
+
+std::vector<uint8_t> encode_topic(
+  const rosbag2_storage::TopicMetadata & topic,
+  const rosbag2_storage::MessageDefinition & message_definition)
+{
+  PayloadWriter writer;
+  writer.string(topic.name);
+  writer.string(topic.type);
+  writer.string(topic.serialization_format);
+  writer.string(
+    rosbag2_storage::serialize_rclcpp_qos_vector(topic.offered_qos_profiles, kQosVersion));
+  writer.string(topic.type_description_hash);
+  writer.string(message_definition.topic_type);
+  writer.string(message_definition.encoding);
+  writer.string(message_definition.encoded_message_definition);
+  writer.string(message_definition.type_hash);
+  return writer.data;
+}
+
+void decode_topic(
+  const Frame & frame, rosbag2_storage::TopicMetadata & topic,
+  rosbag2_storage::MessageDefinition & message_definition)
+{
+  PayloadReader reader(frame.payload.data(), frame.payload.size());
+  topic.name = reader.string();
+  topic.type = reader.string();
+  topic.serialization_format = reader.string();
+  topic.offered_qos_profiles =
+    rosbag2_storage::to_rclcpp_qos_vector(reader.string(), kQosVersion);
+  topic.type_description_hash = reader.string();
+  message_definition.topic_type = reader.string();
+  message_definition.encoding = reader.string();
+  message_definition.encoded_message_definition = reader.string();
+  message_definition.type_hash = reader.string();
+}
+
+Frame encode_messages(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages,
+  int compression_level)
+{
+  PayloadWriter writer;
+  writer.u32(static_cast<uint32_t>(messages.size()));
+  for (const auto & message : messages) {
+    writer.string(message->topic_name);
+    writer.u64(static_cast<uint64_t>(message->time_stamp));
+    writer.u64(static_cast<uint64_t>(message->send_timestamp));
+    writer.u64(message->sequence_number);
+    writer.bytes(message->serialized_data->buffer, message->serialized_data->buffer_length);
+  }
+
+  Frame frame{FrameType::MESSAGES, 0, 0, {}};
+  if (compression_level == 0) {
+    frame.payload = std::move(writer.data);
+    return frame;
+  }
+  frame.flags = kFlagZstdCompressed;
+  frame.payload.resize(ZSTD_compressBound(writer.data.size()));
+  const size_t compressed_size = ZSTD_compress(
+    frame.payload.data(), frame.payload.size(), writer.data.data(), writer.data.size(),
+    compression_level);
+  if (ZSTD_isError(compressed_size)) {
+    throw std::runtime_error(
+            std::string("Failed to compress remote storage messages: ") +
+            ZSTD_getErrorName(compressed_size));
+  }
+  frame.payload.resize(compressed_size);
+  return frame;
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> decode_messages(
+  const Frame & frame)
+{
+  const std::vector<uint8_t> * payload = &frame.payload;
+  std::vector<uint8_t> decompressed;
+  if (frame.flags & kFlagZstdCompressed) {
+    const auto size = ZSTD_getFrameContentSize(frame.payload.data(), frame.payload.size());
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN ||
+      size > kMaxPayloadSize)
+    {
+      throw std::runtime_error("Invalid compressed payload of remote storage frame.");
+    }
+    decompressed.resize(static_cast<size_t>(size));
+    const size_t result = ZSTD_decompress(
+      decompressed.data(), decompressed.size(), frame.payload.data(), frame.payload.size());
+    if (ZSTD_isError(result) || result != decompressed.size()) {
+      throw std::runtime_error("Failed to decompress payload of remote storage frame.");
+    }
+    payload = &decompressed;
+  }
+
+  PayloadReader reader(payload->data(), payload->size());
+  const uint32_t count = reader.u32();
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  messages.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = reader.string();
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(reader.u64());
+    message->send_timestamp = static_cast<rcutils_time_point_value_t>(reader.u64());
+    message->sequence_number = reader.u64();
+    size_t size = 0;
+    const uint8_t * data = reader.bytes(size);
+    message->serialized_data = rosbag2_storage::make_empty_serialized_message(size);
+    std::memcpy(message->serialized_data->buffer, data, size);
+    message->serialized_data->buffer_length = size;
+    messages.push_back(std::move(message));
+  }
+  return messages;
+}
+
+std::vector<uint8_t> encode_string(const std::string & value)
+{
+  PayloadWriter writer;
+  writer.string(value);
+  return writer.data;
+}
+
+std::string decode_string(const Frame & frame)
+{
+  PayloadReader reader(frame.payload.data(), frame.payload.size());
+  return reader.string();
+}
+
+}  // namespace rosbag2_storage_remote
@@ -0,0 +1,371 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage_remote/remote_sink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rcpputils/env.hpp"
+
+#include "rosbag2_storage/default_storage_id.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
+#include "rosbag2_storage_remote/tcp_socket.hpp"
+
+#include "logging.hpp"
+
+namespace rosbag2_storage_remote
+{
+
+namespace
+{
+// How often blocked threads check whether the sink is stopped
+constexpr std::chrono::milliseconds kPollInterval{200};
+
+// Names sent by the plugin must not escape the output directory
+bool is_valid_name(const std::string & name)
+{
+  return !name.empty() && name != "." && name != ".." &&
+         name.find_first_of("/\\") == std::string::npos;
+}
+
+void merge_file_metadata(
+  rosbag2_storage::BagMetadata & bag, const rosbag2_storage::BagMetadata & file,
+  const std::string & relative_path)
+{
+  if (bag.relative_file_paths.empty()) {
+    bag.starting_time = file.starting_time;
+    bag.duration = std::chrono::nanoseconds(0);
+    bag.message_count = 0;
+  }
+  bag.relative_file_paths.push_back(relative_path);
+  bag.files.push_back({relative_path, file.starting_time, file.duration, file.message_count});
+  if (file.message_count > 0) {
+    const auto end = std::max(bag.starting_time + bag.duration, file.starting_time + file.duration);
+    bag.starting_time = std::min(bag.starting_time, file.starting_time);
+    bag.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - bag.starting_time);
+  }
+  bag.message_count += file.message_count;
+  for (const auto & topic : file.topics_with_message_count) {
+    auto it = std::find_if(
+      bag.topics_with_message_count.begin(), bag.topics_with_message_count.end(),
+      [&topic](const auto & bag_topic) {
+        return bag_topic.topic_metadata.name == topic.topic_metadata.name;
+      });
+    if (it == bag.topics_with_message_count.end()) {
+      bag.topics_with_message_count.push_back(topic);
+    } else {
+      it->message_count += topic.message_count;
+    }
+  }
+}
+}  // namespace
+
+class RemoteSinkImpl
+{
+public:
+  explicit RemoteSinkImpl(const RemoteSink::Options & options)
+  : options_(options), listener_(options.host, options.port)
+  {
+    if (options_.storage_id.empty()) {
+      options_.storage_id = rosbag2_storage::get_default_storage_id();
+    }
+    accept_thread_ = std::thread([this]() {accept_connections();});
+  }
+
+  ~RemoteSinkImpl()
+  {
+    stop();
+  }
+
+  uint16_t port() const
+  {
+    return listener_.port();
+  }
+
+  void stop()
+  {
+    if (stopping_.exchange(true)) {
+      return;
+    }
+    if (accept_thread_.joinable()) {
+      accept_thread_.join();
+    }
+    for (auto & connection : connections_) {
+      connection->socket->shutdown();
+      connection->thread.join();
+    }
+    connections_.clear();
+
+    // Files whose connection was lost are closed as they are
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    for (auto & [key, session] : sessions_) {
+      std::lock_guard<std::mutex> session_lock(session->mutex);
+      if (session->storage) {
+        ROSBAG2_STORAGE_REMOTE_LOG_WARN_STREAM(
+          "Closing " << key << " which was not completely received");
+        close_session(*session);
+      }
+    }
+    sessions_.clear();
+  }
+
+private:
+  struct Session
+  {
+    std::mutex mutex;
+    std::string bag_directory;
+    std::shared_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> storage;
+    uint64_t last_sequence = 0;
+  };
+
+  struct Connection
+  {
+    std::shared_ptr<TcpSocket> socket;
+    std::thread thread;
+    std::atomic<bool> done{false};
+  };
+
+  void accept_connections()
+  {
+    while (!stopping_) {
+      // Join the threads of connections which ended
+      connections_.remove_if(
+        [](const auto & connection) {
+          if (!connection->done) {
+            return false;
+          }
+          connection->thread.join();
+          return true;
+        });
+
+      std::shared_ptr<TcpSocket> socket = listener_.accept(kPollInterval);
+      if (!socket) {
+        continue;
+      }
+      auto connection = std::make_unique<Connection>();
+      connection->socket = socket;
+      Connection * raw_connection = connection.get();
+      connection->thread = std::thread(
+        [this, raw_connection]() {
+          try {
+            serve(*raw_connection->socket);
+          } catch (const std::exception & e) {
+            ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM("Remote sink connection failed: " << e.what());
+          }
+          raw_connection->done = true;
+        });
+      connections_.push_back(std::move(connection));
+    }
+  }
+
+  bool receive(TcpSocket & socket, Frame & frame)
+  {
+    while (!stopping_ && socket.is_open()) {
+      if (socket.receive(frame, kPollInterval)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void send_failure(TcpSocket & socket, const std::string & reason)
+  {
+    ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM("Remote sink: " << reason);
+    socket.send(encode_frame(Frame{FrameType::FAILURE, 0, 0, encode_string(reason)}));
+  }
+
+  void serve(TcpSocket & socket)
+  {
+    Frame frame;
+    if (!receive(socket, frame)) {
+      return;
+    }
+    if (frame.type != FrameType::OPEN) {
+      send_failure(socket, "Expected a request to open a file.");
+      return;
+    }
+    const OpenRequest request = decode_open(frame);
+    if (request.protocol_version != kProtocolVersion) {
+      send_failure(
+        socket, "Unsupported protocol version " + std::to_string(request.protocol_version));
+      return;
+    }
+
+    std::shared_ptr<Session> session;
+    try {
+      session = open_session(request);
+    } catch (const std::exception & e) {
+      send_failure(
+        socket, "Failed to open " + request.bag_name + "/" + request.file_name + ": " + e.what());
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(session->mutex);
+      socket.send(encode_frame(Frame{FrameType::OPENED, 0, session->last_sequence, {}}));
+    }
+
+    while (receive(socket, frame)) {
+      std::lock_guard<std::mutex> lock(session->mutex);
+      // Frames resent after a reconnection may be written already
+      if (frame.sequence > session->last_sequence) {
+        try {
+          handle_frame(*session, frame);
+        } catch (const std::exception & e) {
+          send_failure(
+            socket,
+            "Failed to write " + request.bag_name + "/" + request.file_name + ": " + e.what());
+          return;
+        }
+        session->last_sequence = frame.sequence;
+      }
+      if (!socket.send(encode_frame(Frame{FrameType::ACK, 0, frame.sequence, {}}))) {
+        return;
+      }
+    }
+  }
+
+  std::shared_ptr<Session> open_session(const OpenRequest & request)
+  {
+    if (!is_valid_name(request.bag_name) || !is_valid_name(request.file_name)) {
+      throw std::runtime_error("Invalid bag or file name.");
+    }
+    const std::string key = request.bag_name + "/" + request.file_name;
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+      ROSBAG2_STORAGE_REMOTE_LOG_INFO_STREAM("Resuming " << key);
+      return it->second;
+    }
+
+    const auto bag_directory = std::filesystem::path(options_.output_directory) / request.bag_name;
+    std::filesystem::create_directories(bag_directory);
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = (bag_directory / request.file_name).string();
+    storage_options.storage_id =
+      request.storage_id.empty() ? options_.storage_id : request.storage_id;
+    storage_options.storage_config_uri = options_.storage_config_uri;
+
+    auto session = std::make_shared<Session>();
+    session->bag_directory = bag_directory.string();
+    session->storage = storage_factory_.open_read_write(storage_options);
+    if (!session->storage) {
+      throw std::runtime_error("No storage could be initialized for " + storage_options.uri);
+    }
+    ROSBAG2_STORAGE_REMOTE_LOG_INFO_STREAM("Receiving " << key);
+    sessions_[key] = session;
+    return session;
+  }
+
+  void handle_frame(Session & session, const Frame & frame)
+  {
+    if (!session.storage) {
+      return;
+    }
+    switch (frame.type) {
+      case FrameType::CREATE_TOPIC: {
+          rosbag2_storage::TopicMetadata topic;
+          rosbag2_storage::MessageDefinition message_definition;
+          decode_topic(frame, topic, message_definition);
+          session.storage->create_topic(topic, message_definition);
+          break;
+        }
+      case FrameType::REMOVE_TOPIC: {
+          rosbag2_storage::TopicMetadata topic;
+          topic.name = decode_string(frame);
+          session.storage->remove_topic(topic);
+          break;
+        }
+      case FrameType::MESSAGES: {
+          const auto messages = decode_messages(frame);
+          session.storage->write(
+            std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>(
+              messages.begin(), messages.end()));
+          break;
+        }
+      case FrameType::CLOSE:
+        close_session(session);
+        break;
+      default:
+        throw std::runtime_error("Unexpected frame type.");
+    }
+  }
+
+  // Close the file and add it to the metadata of its bag. The session stays known, so that a
+  // plugin which did not receive the acknowledgement of the CLOSE frame can resume it.
+  void close_session(Session & session)
+  {
+    const auto file_metadata = session.storage->get_metadata();
+    const auto relative_path =
+      std::filesystem::path(session.storage->get_relative_file_path()).filename().string();
+    const auto storage_identifier = session.storage->get_storage_identifier();
+    session.storage.reset();
+
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    rosbag2_storage::BagMetadata bag_metadata;
+    if (metadata_io_.metadata_file_exists(session.bag_directory)) {
+      bag_metadata = metadata_io_.read_metadata(session.bag_directory);
+    } else {
+      bag_metadata.storage_identifier = storage_identifier;
+      bag_metadata.ros_distro = rcpputils::get_env_var("ROS_DISTRO");
+    }
+    merge_file_metadata(bag_metadata, file_metadata, relative_path);
+    metadata_io_.write_metadata(session.bag_directory, bag_metadata);
+  }
+
+  RemoteSink::Options options_;
+  TcpListener listener_;
+  std::atomic<bool> stopping_{false};
+  std::thread accept_thread_;
+  std::list<std::unique_ptr<Connection>> connections_;
+
+  std::mutex sessions_mutex_;
+  std::map<std::string, std::shared_ptr<Session>> sessions_;
+  rosbag2_storage::StorageFactory storage_factory_;
+
+  std::mutex metadata_mutex_;
+  rosbag2_storage::MetadataIo metadata_io_;
+};
+
+RemoteSink::RemoteSink(const Options & options)
+: impl_(std::make_unique<RemoteSinkImpl>(options))
+{}
+
+RemoteSink::~RemoteSink() = default;
+
+uint16_t RemoteSink::port() const
+{
+  return impl_->port();
+}
+
+void RemoteSink::stop()
+{
+  impl_->stop();
+}
+
+}  // namespace rosbag2_storage_remote
@@ -0,0 +1,90 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "rosbag2_storage_remote/remote_sink.hpp"
+
+// Runs a remote sink writing the bags it receives into an output directory, until interrupted.
+// Usage: remote_sink [--host HOST] [--port PORT] [--output-dir DIR] [--storage-id ID]
+//                    [--storage-config-file FILE]
+
+namespace
+{
+volatile std::sig_atomic_t interrupted = 0;
+
+void handle_signal(int)
+{
+  interrupted = 1;
+}
+
+void print_usage()
+{
+  std::cerr << "Usage: remote_sink [--host HOST] [--port PORT] [--output-dir DIR] " <<
+    "[--storage-id ID] [--storage-config-file FILE]" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rosbag2_storage_remote::RemoteSink::Options options;
+  options.output_directory = ".";
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument = argv[i];
+    if (argument == "--help" || argument == "-h") {
+      print_usage();
+      return EXIT_SUCCESS;
+    }
+    if (i + 1 >= argc) {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+    const std::string value = argv[++i];
+    if (argument == "--host") {
+      options.host = value;
+    } else if (argument == "--port") {
+      options.port = static_cast<uint16_t>(std::stoi(value));
+    } else if (argument == "--output-dir") {
+      options.output_directory = value;
+    } else if (argument == "--storage-id") {
+      options.storage_id = value;
+    } else if (argument == "--storage-config-file") {
+      options.storage_config_uri = value;
+    } else {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  try {
+    rosbag2_storage_remote::RemoteSink sink(options);
+    std::cout << "Writing bags received on port " << sink.port() << " to " <<
+      options.output_directory << std::endl;
+    while (!interrupted) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  } catch (const std::exception & e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,527 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage_remote/remote_storage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pluginlib/class_list_macros.hpp"
+#include "yaml-cpp/yaml.h"
+
+#include "logging.hpp"
+
+namespace rosbag2_storage_remote
+{
+
+RemoteStorage::Options RemoteStorage::parse_options(const std::string & storage_config_uri)
+{
+  Options options;
+  if (storage_config_uri.empty()) {
+    return options;
+  }
+  try {
+    const YAML::Node config = YAML::LoadFile(storage_config_uri);
+    if (config["host"]) {
+      options.host = config["host"].as<std::string>();
+    }
+    if (config["port"]) {
+      options.port = config["port"].as<uint16_t>();
+    }
+    if (config["sink_storage_id"]) {
+      options.sink_storage_id = config["sink_storage_id"].as<std::string>();
+    }
+    if (config["compression"]) {
+      const auto compression = config["compression"].as<std::string>();
+      if (compression == "zstd") {
+        options.compression_level = 1;
+      } else if (compression != "none") {
+        throw std::runtime_error("Unknown compression '" + compression + "'.");
+      }
+    }
+    if (config["compression_level"] && options.compression_level != 0) {
+      options.compression_level = config["compression_level"].as<int>();
+    }
+    if (config["max_unacknowledged_bytes"]) {
+      options.max_unacknowledged_bytes = config["max_unacknowledged_bytes"].as<uint64_t>();
+    }
+    if (config["connect_timeout_ms"]) {
+      options.connect_timeout =
+        std::chrono::milliseconds(config["connect_timeout_ms"].as<int64_t>());
+    }
+    if (config["reconnect_interval_ms"]) {
+      options.reconnect_interval =
+        std::chrono::milliseconds(config["reconnect_interval_ms"].as<int64_t>());
+    }
+    if (config["ack_timeout_ms"]) {
+      options.ack_timeout = std::chrono::milliseconds(config["ack_timeout_ms"].as<int64_t>());
+    }
+  } catch (const std::exception & e) {
+    throw std::runtime_error(
+            "Failed to parse remote storage config '" + storage_config_uri + "': " + e.what());
+  }
+  return options;
+}
+
+RemoteStorage::RemoteStorage()
+{
+  metadata_.storage_identifier = get_storage_identifier();
+  metadata_.message_count = 0;
+}
+
+RemoteStorage::~RemoteStorage()
+{
+  try {
+    close();
+  } catch (const std::exception & e) {
+    ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM(
+      "Failed to close remote bag file " << relative_path_ << ": " << e.what());
+  }
+}
+
+void RemoteStorage::open(
+  const rosbag2_storage::StorageOptions & storage_options,
+  rosbag2_storage::storage_interfaces::IOFlag io_flag)
+{
+  if (io_flag != rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE) {
+    throw std::runtime_error(
+            "The remote storage can only write bags, read them from the storage of the sink.");
+  }
+  open_for_writing(storage_options);
+}
+
+void RemoteStorage::open_for_writing(const rosbag2_storage::StorageOptions & storage_options)
+{
+  options_ = parse_options(storage_options.storage_config_uri);
+  relative_path_ = storage_options.uri + kFileExtension;
+  spill_path_ = relative_path_;
+
+  const std::filesystem::path uri(storage_options.uri);
+  open_request_.bag_name = uri.parent_path().filename().string();
+  open_request_.file_name = uri.filename().string();
+  open_request_.storage_id = options_.sink_storage_id;
+  if (open_request_.bag_name.empty()) {
+    open_request_.bag_name = open_request_.file_name;
+  }
+  metadata_.relative_file_paths = {relative_path_};
+  is_open_ = true;
+
+  if (!reconnect(true)) {
+    ROSBAG2_STORAGE_REMOTE_LOG_WARN_STREAM(
+      "Remote sink " << options_.host << ":" << options_.port << " is not reachable, spilling " <<
+        "to " << spill_path_ << " until it is.");
+  }
+}
+
+bool RemoteStorage::probe(const std::string & /* uri */) const
+{
+  return false;
+}
+
+void RemoteStorage::update_metadata(const rosbag2_storage::BagMetadata & /* metadata */)
+{
+}
+
+void RemoteStorage::remove_topic(const rosbag2_storage::TopicMetadata & topic)
+{
+  auto & topics = metadata_.topics_with_message_count;
+  const auto it = std::find_if(
+    topics.begin(), topics.end(),
+    [&topic](const auto & topic_info) {return topic_info.topic_metadata.name == topic.name;});
+  if (it == topics.end()) {
+    return;
+  }
+  topics.erase(it);
+  topic_indices_.clear();
+  for (size_t i = 0; i < topics.size(); ++i) {
+    topic_indices_[topics[i].topic_metadata.name] = i;
+  }
+  send_frame(Frame{FrameType::REMOVE_TOPIC, 0, 0, encode_string(topic.name)});
+}
+
+void RemoteStorage::create_topic(
+  const rosbag2_storage::TopicMetadata & topic,
+  const rosbag2_storage::MessageDefinition & message_definition)
+{
+  if (topic_indices_.count(topic.name) > 0) {
+    return;
+  }
+  topic_indices_[topic.name] = metadata_.topics_with_message_count.size();
+  metadata_.topics_with_message_count.push_back({topic, 0});
+  send_frame(Frame{FrameType::CREATE_TOPIC, 0, 0, encode_topic(topic, message_definition)});
+}
+
+void RemoteStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+{
+  write(std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>{message});
+}
+
+void RemoteStorage::write(
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
+{
+  if (!is_open_) {
+    throw std::runtime_error("Remote storage is not open.");
+  }
+  if (messages.empty()) {
+    return;
+  }
+  for (const auto & message : messages) {
+    const auto topic_it = topic_indices_.find(message->topic_name);
+    if (topic_it != topic_indices_.end()) {
+      metadata_.topics_with_message_count[topic_it->second].message_count++;
+    }
+    const auto message_time =
+      std::chrono::time_point<std::chrono::high_resolution_clock>(
+      std::chrono::nanoseconds(message->time_stamp));
+    if (metadata_.message_count == 0) {
+      metadata_.starting_time = message_time;
+    } else if (message_time < metadata_.starting_time) {
+      metadata_.duration += metadata_.starting_time - message_time;
+      metadata_.starting_time = message_time;
+    }
+    metadata_.duration = std::max(metadata_.duration, message_time - metadata_.starting_time);
+    metadata_.message_count++;
+    bagfile_size_ += message->serialized_data->buffer_length;
+  }
+  send_frame(encode_messages(messages, options_.compression_level));
+}
+
+bool RemoteStorage::set_read_order(const rosbag2_storage::ReadOrder &)
+{
+  return false;
+}
+
+bool RemoteStorage::has_next()
+{
+  throw_read_not_supported();
+  return false;
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> RemoteStorage::read_next()
+{
+  throw_read_not_supported();
+  return nullptr;
+}
+
+std::vector<rosbag2_storage::TopicMetadata> RemoteStorage::get_all_topics_and_types()
+{
+  std::vector<rosbag2_storage::TopicMetadata> topics;
+  for (const auto & topic_info : metadata_.topics_with_message_count) {
+    topics.push_back(topic_info.topic_metadata);
+  }
+  return topics;
+}
+
+void RemoteStorage::get_all_message_definitions(
+  std::vector<rosbag2_storage::MessageDefinition> & /* definitions */)
+{
+  throw_read_not_supported();
+}
+
+rosbag2_storage::BagMetadata RemoteStorage::get_metadata()
+{
+  metadata_.bag_size = bagfile_size_;
+  return metadata_;
+}
+
+std::string RemoteStorage::get_relative_file_path() const
+{
+  return relative_path_;
+}
+
+uint64_t RemoteStorage::get_bagfile_size() const
+{
+  return bagfile_size_;
+}
+
+std::string RemoteStorage::get_storage_identifier() const
+{
+  return "remote";
+}
+
+uint64_t RemoteStorage::get_minimum_split_file_size() const
+{
+  return 1;
+}
+
+void RemoteStorage::set_filter(const rosbag2_storage::StorageFilter & /* storage_filter */)
+{
+  throw_read_not_supported();
+}
+
+void RemoteStorage::reset_filter()
+{
+  throw_read_not_supported();
+}
+
+void RemoteStorage::seek(const rcutils_time_point_value_t & /* timestamp */)
+{
+  throw_read_not_supported();
+}
+
+bool RemoteStorage::is_connected() const
+{
+  return socket_ != nullptr;
+}
+
+size_t RemoteStorage::get_spilled_frame_count() const
+{
+  return spilled_frames_;
+}
+
+void RemoteStorage::close()
+{
+  if (!is_open_) {
+    return;
+  }
+  is_open_ = false;
+  send_frame(Frame{FrameType::CLOSE, 0, 0, {}});
+  if (!socket_) {
+    reconnect(true);
+  }
+  // Wait until the sink wrote everything, so that the file is complete on the sink
+  while (socket_ && !unacknowledged_.empty()) {
+    if (!receive_acks(options_.ack_timeout)) {
+      disconnect();
+    }
+  }
+  if (!unacknowledged_.empty() || spilled_frames_ > 0) {
+    keep_unsent_frames();
+  }
+  socket_.reset();
+}
+
+void RemoteStorage::throw_read_not_supported() const
+{
+  throw std::runtime_error(
+          "The remote storage can only write bags, read them from the storage of the sink.");
+}
+
+void RemoteStorage::send_frame(Frame frame)
+{
+  frame.sequence = next_sequence_++;
+  auto encoded = encode_frame(frame);
+  if (!socket_) {
+    reconnect(false);
+  }
+  if (socket_) {
+    // Kept until acknowledged, also if sending it fails
+    send_to_sink(std::move(encoded), frame.sequence);
+    return;
+  }
+  spill(encoded);
+}
+
+bool RemoteStorage::send_to_sink(std::vector<uint8_t> encoded, uint64_t sequence)
+{
+  unacknowledged_bytes_ += encoded.size();
+  unacknowledged_.push_back({sequence, std::move(encoded)});
+  if (!wait_for_window()) {
+    return false;
+  }
+  if (!socket_->send(unacknowledged_.back().encoded)) {
+    disconnect();
+    return false;
+  }
+  receive_acks(std::chrono::milliseconds(0));
+  return socket_ != nullptr;
+}
+
+void RemoteStorage::spill(const std::vector<uint8_t> & encoded)
+{
+  if (!spill_.is_open()) {
+    spill_.open(spill_path_, std::ios::binary | std::ios::app);
+  }
+  spill_.write(
+    reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+  spill_.flush();
+  if (!spill_) {
+    spill_.close();
+    throw std::runtime_error("Failed to write to spill file '" + spill_path_ + "'.");
+  }
+  spilled_frames_++;
+}
+
+bool RemoteStorage::reconnect(bool force)
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && now < next_reconnect_) {
+    return false;
+  }
+  next_reconnect_ = now + options_.reconnect_interval;
+
+  auto socket = TcpSocket::connect(options_.host, options_.port, options_.connect_timeout);
+  if (!socket) {
+    return false;
+  }
+  Frame reply;
+  if (!socket->send(encode_frame(Frame{FrameType::OPEN, 0, 0, encode_open(open_request_)})) ||
+    !socket->receive(reply, options_.ack_timeout))
+  {
+    return false;
+  }
+  if (reply.type == FrameType::FAILURE) {
+    ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM(
+      "Remote sink refused " << relative_path_ << ": " << decode_string(reply));
+    return false;
+  }
+  if (reply.type != FrameType::OPENED) {
+    return false;
+  }
+  socket_ = std::move(socket);
+  ROSBAG2_STORAGE_REMOTE_LOG_INFO_STREAM(
+    "Streaming " << relative_path_ << " to remote sink " << options_.host << ":" <<
+      options_.port);
+  return resend_pending_frames(reply.sequence);
+}
+
+bool RemoteStorage::resend_pending_frames(uint64_t last_written_sequence)
+{
+  while (!unacknowledged_.empty() && unacknowledged_.front().sequence <= last_written_sequence) {
+    unacknowledged_bytes_ -= unacknowledged_.front().encoded.size();
+    unacknowledged_.pop_front();
+  }
+  for (const auto & frame : unacknowledged_) {
+    if (!socket_->send(frame.encoded)) {
+      disconnect();
+      return false;
+    }
+  }
+  if (spilled_frames_ == 0) {
+    return true;
+  }
+
+  // Frames sent before a failed replay are in the spill file as well as in unacknowledged_
+  const uint64_t sent_sequence = unacknowledged_.empty() ?
+    last_written_sequence :
+    std::max(last_written_sequence, unacknowledged_.back().sequence);
+  spill_.close();
+  {
+    std::ifstream spill(spill_path_, std::ios::binary);
+    Frame frame;
+    while (read_frame(spill, frame)) {
+      if (frame.sequence <= sent_sequence) {
+        continue;
+      }
+      if (!send_to_sink(encode_frame(frame), frame.sequence)) {
+        return false;
+      }
+    }
+  }
+  std::error_code error;
+  std::filesystem::remove(spill_path_, error);
+  ROSBAG2_STORAGE_REMOTE_LOG_INFO_STREAM(
+    "Sent " << spilled_frames_ << " spilled frames of " << relative_path_ << " to remote sink");
+  spilled_frames_ = 0;
+  return true;
+}
+
+bool RemoteStorage::receive_acks(std::chrono::milliseconds timeout)
+{
+  bool received = false;
+  Frame frame;
+  while (socket_ && socket_->receive(frame, received ? std::chrono::milliseconds(0) : timeout)) {
+    received = true;
+    if (frame.type == FrameType::ACK) {
+      while (!unacknowledged_.empty() && unacknowledged_.front().sequence <= frame.sequence) {
+        unacknowledged_bytes_ -= unacknowledged_.front().encoded.size();
+        unacknowledged_.pop_front();
+      }
+    } else if (frame.type == FrameType::FAILURE) {
+      ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM(
+        "Remote sink failed to write " << relative_path_ << ": " << decode_string(frame));
+      disconnect();
+    }
+  }
+  if (socket_ && !socket_->is_open()) {
+    disconnect();
+  }
+  return received;
+}
+
+bool RemoteStorage::wait_for_window()
+{
+  // A single frame larger than the window is sent on its own
+  while (socket_ && unacknowledged_.size() > 1 &&
+    unacknowledged_bytes_ > options_.max_unacknowledged_bytes)
+  {
+    if (!receive_acks(options_.ack_timeout)) {
+      ROSBAG2_STORAGE_REMOTE_LOG_WARN_STREAM(
+        "Remote sink did not acknowledge " << relative_path_ << " within " <<
+          options_.ack_timeout.count() << " ms, reconnecting.");
+      disconnect();
+    }
+  }
+  return socket_ != nullptr;
+}
+
+void RemoteStorage::disconnect()
+{
+  if (socket_) {
+    ROSBAG2_STORAGE_REMOTE_LOG_WARN_STREAM(
+      "Lost connection to remote sink " << options_.host << ":" << options_.port <<
+        ", spilling " << relative_path_ << " until reconnected.");
+  }
+  socket_.reset();
+  next_reconnect_ = std::chrono::steady_clock::now() + options_.reconnect_interval;
+}
+
+void RemoteStorage::keep_unsent_frames()
+{
+  // The unacknowledged frames come before the spilled ones
+  spill_.close();
+  const std::string temporary_path = spill_path_ + ".tmp";
+  size_t frame_count = 0;
+  {
+    std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+    for (const auto & frame : unacknowledged_) {
+      output.write(
+        reinterpret_cast<const char *>(frame.encoded.data()),
+        static_cast<std::streamsize>(frame.encoded.size()));
+      frame_count++;
+    }
+    const uint64_t kept_sequence = unacknowledged_.empty() ? 0 : unacknowledged_.back().sequence;
+    std::ifstream spill(spill_path_, std::ios::binary);
+    Frame frame;
+    while (read_frame(spill, frame)) {
+      if (frame.sequence > kept_sequence) {
+        const auto encoded = encode_frame(frame);
+        output.write(
+          reinterpret_cast<const char *>(encoded.data()),
+          static_cast<std::streamsize>(encoded.size()));
+        frame_count++;
+      }
+    }
+  }
+  std::filesystem::rename(temporary_path, spill_path_);
+  unacknowledged_.clear();
+  unacknowledged_bytes_ = 0;
+  spilled_frames_ = frame_count;
+  ROSBAG2_STORAGE_REMOTE_LOG_ERROR_STREAM(
+    frame_count << " frames of " << relative_path_ << " were not written by the remote sink, " <<
+      "they are kept in " << spill_path_);
+}
+
+}  // namespace rosbag2_storage_remote
+
+PLUGINLIB_EXPORT_CLASS(
+  rosbag2_storage_remote::RemoteStorage,
+  rosbag2_storage::storage_interfaces::ReadWriteInterface)
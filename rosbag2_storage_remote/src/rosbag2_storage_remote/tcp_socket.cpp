@@ -0,0 +1,241 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_storage_remote/tcp_socket.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rosbag2_storage_remote
+{
+
+namespace
+{
+// Bounds a single send or receive, so that a peer which stopped reading or stopped in the middle
+// of a frame is detected as a failed connection
+constexpr int kIoTimeoutSeconds = 30;
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+void configure_connected_socket(int fd)
+{
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+  timeval timeout{};
+  timeout.tv_sec = kIoTimeoutSeconds;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool wait_for(int fd, int16_t events, std::chrono::milliseconds timeout)
+{
+  pollfd poll_fd{fd, events, 0};
+  int result = 0;
+  do {
+    result = poll(&poll_fd, 1, static_cast<int>(timeout.count()));
+  } while (result < 0 && errno == EINTR);
+  return result > 0;
+}
+}  // namespace
+
+TcpSocket::TcpSocket(int fd)
+: fd_(fd)
+{
+  configure_connected_socket(fd_);
+}
+
+TcpSocket::~TcpSocket()
+{
+  close(fd_);
+}
+
+std::unique_ptr<TcpSocket> TcpSocket::connect(
+  const std::string & host, uint16_t port, std::chrono::milliseconds timeout)
+{
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo * addresses = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+    return nullptr;
+  }
+  std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> address_list(addresses, &freeaddrinfo);
+
+  for (addrinfo * address = addresses; address != nullptr; address = address->ai_next) {
+    const int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    // Connect without blocking, to bound the time to wait for an unreachable sink
+    const int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    bool connected = ::connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+    if (!connected && errno == EINPROGRESS && wait_for(fd, POLLOUT, timeout)) {
+      int error = 0;
+      socklen_t length = sizeof(error);
+      connected = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+    }
+    if (connected) {
+      fcntl(fd, F_SETFL, flags);
+      return std::make_unique<TcpSocket>(fd);
+    }
+    close(fd);
+  }
+  return nullptr;
+}
+
+bool TcpSocket::send(const std::vector<uint8_t> & data)
+{
+  size_t sent = 0;
+  while (open_ && sent < data.size()) {
+    const ssize_t result = ::send(fd_, data.data() + sent, data.size() - sent, kSendFlags);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      open_ = false;
+      break;
+    }
+    sent += static_cast<size_t>(result);
+  }
+  return open_;
+}
+
+bool TcpSocket::receive(Frame & frame, std::chrono::milliseconds timeout)
+{
+  if (!open_ || !wait_for(fd_, POLLIN, timeout)) {
+    return false;
+  }
+  uint8_t header[kFrameHeaderSize];
+  if (!receive_all(header, kFrameHeaderSize)) {
+    return false;
+  }
+  try {
+    frame.payload.resize(static_cast<size_t>(decode_frame_header(header, frame)));
+  } catch (const std::runtime_error &) {
+    open_ = false;
+    return false;
+  }
+  return receive_all(frame.payload.data(), frame.payload.size());
+}
+
+bool TcpSocket::is_open() const
+{
+  return open_;
+}
+
+void TcpSocket::shutdown()
+{
+  ::shutdown(fd_, SHUT_RDWR);
+}
+
+bool TcpSocket::receive_all(uint8_t * data, size_t size)
+{
+  size_t received = 0;
+  while (open_ && received < size) {
+    const ssize_t result = recv(fd_, data + received, size - received, 0);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      open_ = false;
+      break;
+    }
+    received += static_cast<size_t>(result);
+  }
+  return open_;
+}
+
+TcpListener::TcpListener(const std::string & host, uint16_t port)
+{
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  addrinfo * addresses = nullptr;
+  const int result = getaddrinfo(
+    host.empty() ? nullptr : host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+  if (result != 0) {
+    throw std::runtime_error(
+            "Failed to resolve '" + host + "' to listen on: " + gai_strerror(result));
+  }
+  std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> address_list(addresses, &freeaddrinfo);
+
+  fd_ = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+  if (fd_ < 0) {
+    throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+  }
+  int enable = 1;
+  setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  if (bind(fd_, addresses->ai_addr, addresses->ai_addrlen) != 0 || listen(fd_, 16) != 0) {
+    const std::string error = std::strerror(errno);
+    close(fd_);
+    throw std::runtime_error(
+            "Failed to listen on " + host + ":" + std::to_string(port) + ": " + error);
+  }
+
+  sockaddr_storage bound_address{};
+  socklen_t length = sizeof(bound_address);
+  getsockname(fd_, reinterpret_cast<sockaddr *>(&bound_address), &length);
+  if (bound_address.ss_family == AF_INET6) {
+    port_ = ntohs(reinterpret_cast<sockaddr_in6 *>(&bound_address)->sin6_port);
+  } else {
+    port_ = ntohs(reinterpret_cast<sockaddr_in *>(&bound_address)->sin_port);
+  }
+}
+
+TcpListener::~TcpListener()
+{
+  close(fd_);
+}
+
+std::unique_ptr<TcpSocket> TcpListener::accept(std::chrono::milliseconds timeout)
+{
+  if (!wait_for(fd_, POLLIN, timeout)) {
+    return nullptr;
+  }
+  const int fd = ::accept(fd_, nullptr, nullptr);
+  if (fd < 0) {
+    return nullptr;
+  }
+  return std::make_unique<TcpSocket>(fd);
+}
+
+uint16_t TcpListener::port() const
+{
+  return port_;
+}
+
+}  // namespace rosbag2_storage_remote
@@ -0,0 +1,207 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage/storage_factory.hpp"
+#include "rosbag2_storage_remote/protocol.hpp"
+#include "rosbag2_storage_remote/remote_sink.hpp"
+#include "rosbag2_storage_remote/remote_storage.hpp"
+#include "rosbag2_test_common/temporary_directory_fixture.hpp"
+
+using namespace ::testing;  // NOLINT
+using rosbag2_storage_remote::RemoteSink;
+using rosbag2_storage_remote::RemoteStorage;
+
+class RemoteStorageTest : public rosbag2_test_common::TemporaryDirectoryFixture
+{
+public:
+  RemoteStorageTest()
+  {
+    topic_.name = "/topic";
+    topic_.type = "std_msgs/msg/String";
+    topic_.serialization_format = "cdr";
+    sink_options_.output_directory = (root() / "sink").string();
+    sink_options_.host = "127.0.0.1";
+    sink_options_.port = 0;
+    sink_options_.storage_id = "sqlite3";
+  }
+
+  std::filesystem::path root() const
+  {
+    return std::filesystem::path(temporary_dir_path_);
+  }
+
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> make_message(
+    const std::string & data, int64_t time_stamp)
+  {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->topic_name = topic_.name;
+    message->time_stamp = time_stamp;
+    message->serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+    return message;
+  }
+
+  rosbag2_storage::StorageOptions storage_options(uint16_t port, const std::string & compression)
+  {
+    const auto config_path = root() / "remote.yaml";
+    std::ofstream config(config_path);
+    config << "host: 127.0.0.1\n" <<
+      "port: " << port << "\n" <<
+      "compression: " << compression << "\n" <<
+      "reconnect_interval_ms: 0\n" <<
+      "ack_timeout_ms: 2000\n";
+    // Created by the writer of the bag
+    std::filesystem::create_directories(root() / "bag");
+    rosbag2_storage::StorageOptions options;
+    options.uri = (root() / "bag" / "bag_0").string();
+    options.storage_id = "remote";
+    options.storage_config_uri = config_path.string();
+    return options;
+  }
+
+  std::vector<std::string> read_sink_bag()
+  {
+    rosbag2_storage::StorageFactory factory;
+    rosbag2_storage::StorageOptions options;
+    options.uri = (root() / "sink" / "bag" / "bag_0.db3").string();
+    options.storage_id = "sqlite3";
+    auto reader = factory.open_read_only(options);
+    std::vector<std::string> messages;
+    while (reader->has_next()) {
+      const auto message = reader->read_next();
+      messages.emplace_back(
+        reinterpret_cast<const char *>(message->serialized_data->buffer),
+        message->serialized_data->buffer_length);
+    }
+    return messages;
+  }
+
+  rosbag2_storage::TopicMetadata topic_;
+  RemoteSink::Options sink_options_;
+};
+
+TEST_F(RemoteStorageTest, messages_round_trip_through_compressed_frames) {
+  const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages{
+    make_message("first", 1), make_message(std::string(1000, 'x'), 2)};
+
+  const auto frame = rosbag2_storage_remote::encode_messages(messages, 3);
+  EXPECT_EQ(frame.flags, rosbag2_storage_remote::kFlagZstdCompressed);
+  EXPECT_LT(frame.payload.size(), 1000u);
+
+  std::stringstream stream;
+  const auto encoded = rosbag2_storage_remote::encode_frame(frame);
+  stream.write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+  rosbag2_storage_remote::Frame read;
+  ASSERT_TRUE(rosbag2_storage_remote::read_frame(stream, read));
+
+  const auto decoded = rosbag2_storage_remote::decode_messages(read);
+  ASSERT_THAT(decoded, SizeIs(2));
+  EXPECT_EQ(decoded[1]->topic_name, "/topic");
+  EXPECT_EQ(decoded[1]->time_stamp, 2);
+  ASSERT_EQ(decoded[1]->serialized_data->buffer_length, 1000u);
+  EXPECT_EQ(decoded[1]->serialized_data->buffer[999], 'x');
+}
+
+TEST_F(RemoteStorageTest, sink_writes_streamed_bag_file_and_metadata) {
+  RemoteSink sink(sink_options_);
+  {
+    RemoteStorage storage;
+    storage.open(storage_options(sink.port(), "zstd"));
+    ASSERT_TRUE(storage.is_connected());
+    storage.create_topic(topic_, {});
+    storage.write(make_message("hello", 1));
+    storage.write({make_message("remote", 2), make_message("world", 3)});
+    EXPECT_EQ(storage.get_metadata().message_count, 3u);
+  }
+  EXPECT_FALSE(std::filesystem::exists(root() / "bag" / "bag_0.remote"));
+
+  EXPECT_THAT(read_sink_bag(), ElementsAre("hello", "remote", "world"));
+  rosbag2_storage::MetadataIo metadata_io;
+  const auto metadata = metadata_io.read_metadata((root() / "sink" / "bag").string());
+  EXPECT_EQ(metadata.message_count, 3u);
+  EXPECT_THAT(metadata.relative_file_paths, ElementsAre("bag_0.db3"));
+  ASSERT_THAT(metadata.topics_with_message_count, SizeIs(1));
+  EXPECT_EQ(metadata.topics_with_message_count[0].message_count, 3u);
+}
+
+TEST_F(RemoteStorageTest, spills_while_sink_is_unreachable_and_sends_spill_once_reconnected) {
+  uint16_t port = 0;
+  {
+    RemoteSink probe_sink(sink_options_);
+    port = probe_sink.port();
+  }
+
+  auto storage = std::make_unique<RemoteStorage>();
+  storage->open(storage_options(port, "none"));
+  EXPECT_FALSE(storage->is_connected());
+  storage->create_topic(topic_, {});
+  storage->write(make_message("spilled", 1));
+  EXPECT_EQ(storage->get_spilled_frame_count(), 2u);
+  EXPECT_TRUE(std::filesystem::exists(root() / "bag" / "bag_0.remote"));
+
+  sink_options_.port = port;
+  RemoteSink sink(sink_options_);
+  storage->write(make_message("streamed", 2));
+  EXPECT_TRUE(storage->is_connected());
+  EXPECT_EQ(storage->get_spilled_frame_count(), 0u);
+  EXPECT_FALSE(std::filesystem::exists(root() / "bag" / "bag_0.remote"));
+
+  storage.reset();
+  EXPECT_THAT(read_sink_bag(), ElementsAre("spilled", "streamed"));
+}
+
+TEST_F(RemoteStorageTest, keeps_spill_file_if_sink_never_becomes_reachable) {
+  uint16_t port = 0;
+  {
+    RemoteSink probe_sink(sink_options_);
+    port = probe_sink.port();
+  }
+  {
+    RemoteStorage storage;
+    storage.open(storage_options(port, "none"));
+    storage.create_topic(topic_, {});
+    storage.write(make_message("spilled", 1));
+  }
+
+  std::ifstream spill(root() / "bag" / "bag_0.remote", std::ios::binary);
+  std::vector<rosbag2_storage_remote::FrameType> types;
+  rosbag2_storage_remote::Frame frame;
+  while (rosbag2_storage_remote::read_frame(spill, frame)) {
+    types.push_back(frame.type);
+  }
+  EXPECT_THAT(
+    types, ElementsAre(
+      rosbag2_storage_remote::FrameType::CREATE_TOPIC,
+      rosbag2_storage_remote::FrameType::MESSAGES,
+      rosbag2_storage_remote::FrameType::CLOSE));
+}
+
+TEST_F(RemoteStorageTest, cannot_be_opened_for_reading) {
+  RemoteStorage storage;
+  auto options = storage_options(0, "none");
+  EXPECT_THROW(
+    storage.open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY),
+    std::runtime_error);
+}
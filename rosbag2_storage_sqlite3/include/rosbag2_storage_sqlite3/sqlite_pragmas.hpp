@@ -46,6 +46,17 @@ public:
     return p;
   }
 
+  // every commit is synced to disk, for the group commits of a durability policy. Takes
+  // precedence over the preset profile, but not over the configuration file
+  static pragmas_map_t durable_writing_pragmas()
+  {
+    static pragmas_map_t p = {
+      {"journal_mode", "PRAGMA journal_mode=WAL;"},
+      {"synchronous", "PRAGMA synchronous=FULL;"}
+    };
+    return p;
+  }
+
   static pragmas_map_t optimized_writing_pragmas()
   {
     static pragmas_map_t p = {
@@ -54,6 +65,33 @@ public:
     };
     return p;
   }
+
+  // larger pages and caches for sustained write throughput. The WAL is checkpointed less often,
+  // every 4096 pages (256 MiB), so checkpoints do not stall writing as frequently
+  static pragmas_map_t high_throughput_writing_pragmas()
+  {
+    static pragmas_map_t p = {
+      {"page_size", "PRAGMA page_size=65536;"},
+      {"cache_size", "PRAGMA cache_size=-65536;"},
+      {"mmap_size", "PRAGMA mmap_size=268435456;"},
+      {"temp_store", "PRAGMA temp_store=MEMORY;"},
+      {"journal_mode", "PRAGMA journal_mode=WAL;"},
+      {"synchronous", "PRAGMA synchronous=OFF;"},
+      {"wal_autocheckpoint", "PRAGMA wal_autocheckpoint=4096;"}
+    };
+    return p;
+  }
+
+  // memory mapped reads and a larger page cache for playback of big bags
+  static pragmas_map_t fast_reading_pragmas()
+  {
+    static pragmas_map_t p = {
+      {"cache_size", "PRAGMA cache_size=-65536;"},
+      {"mmap_size", "PRAGMA mmap_size=1073741824;"},
+      {"temp_store", "PRAGMA temp_store=MEMORY;"}
+    };
+    return p;
+  }
 };
 
 }  // namespace rosbag2_storage_plugins
@@ -197,6 +197,11 @@ private:
 
   std::shared_ptr<SqliteStatementWrapper> reset();
 
+  // Columns of the row the statement is on, e.g. the row a QueryResult::Iterator was advanced to,
+  // read without copying them. A blob is valid until the statement steps or is reset.
+  rcutils_time_point_value_t get_column_int64(size_t index) const;
+  const uint8_t * get_column_blob(size_t index, size_t & size) const;
+
 private:
   bool step();
   bool is_query_ok(int return_code);
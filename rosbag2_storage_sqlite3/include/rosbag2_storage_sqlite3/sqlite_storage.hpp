@@ -23,9 +23,12 @@
 #include <vector>
 
 #include "rcpputils/thread_safety_annotations.hpp"
+#include "rosbag2_storage/durability_policy.hpp"
+#include "rosbag2_storage/interned_topic.hpp"
 #include "rosbag2_storage/storage_interfaces/read_write_interface.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_storage/topic_filter.hpp"
 #include "rosbag2_storage/topic_metadata.hpp"
 #include "rosbag2_storage/bag_metadata.hpp"
 #include "rosbag2_storage_sqlite3/sqlite_wrapper.hpp"
@@ -41,12 +44,15 @@
 
 namespace rosbag2_storage_plugins
 {
+class ExternalBlobStore;
+class MessagePrefetcher;
+class PartitionedMessageReader;
 
 class ROSBAG2_STORAGE_DEFAULT_PLUGINS_PUBLIC SqliteStorage
   : public rosbag2_storage::storage_interfaces::ReadWriteInterface
 {
 public:
-  SqliteStorage() = default;
+  SqliteStorage();
 
   ~SqliteStorage() override;
 
@@ -55,6 +61,8 @@ public:
     rosbag2_storage::storage_interfaces::IOFlag io_flag =
     rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE) override;
 
+  bool probe(const std::string & uri) const override;
+
   void update_metadata(const rosbag2_storage::BagMetadata & metadata) override;
 
   void remove_topic(const rosbag2_storage::TopicMetadata & topic) override;
@@ -69,12 +77,20 @@ public:
     const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
   override;
 
+  /// Commit the transaction kept open across writes by the durability policy, if it is due.
+  void commit_if_due() override;
+
   bool set_read_order(const rosbag2_storage::ReadOrder &) override;
 
   bool has_next() override;
 
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next() override;
 
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> read_next_batch(
+    size_t max_messages, size_t max_bytes = 0) override;
+
+  void for_each(const rosbag2_storage::MessageViewCallback & callback) override;
+
   std::vector<rosbag2_storage::TopicMetadata> get_all_topics_and_types() override;
 
   void get_all_message_definitions(
@@ -96,6 +112,19 @@ public:
 
   void seek(const rcutils_time_point_value_t & timestamp) override;
 
+  /// Count the messages and sum the length of their data with an aggregate query on the
+  /// messages table, which does not read the data itself.
+  rosbag2_storage::ReadEstimate estimate(
+    const rosbag2_storage::StorageFilter & storage_filter) override;
+
+  /// Query the messages committed by the recorder since the last read again. Nothing is queried
+  /// if the data version of the database shows no commit of another connection since.
+  bool refresh() override;
+
+  /// Run PRAGMA quick_check on the database, which locates damaged pages, and check that every
+  /// message references a topic and the data of large messages lies within the blob file.
+  rosbag2_storage::FileVerification verify() override;
+
   std::string get_storage_setting(const std::string & key);
 
   /// Return the sqlite database wrapper.
@@ -110,6 +139,8 @@ public:
   {
     Resilient,
     WriteOptimized,
+    HighThroughput,
+    FastRead,
   };
   static PresetProfile parse_preset_profile(const std::string & profile_string);
 
@@ -118,16 +149,45 @@ private:
   void read_metadata();
   void prepare_for_writing();
   void prepare_for_reading();
+  /// Split the messages selected by filtered_query into a partition per scan connection.
+  void prepare_for_partitioned_reading(
+    const std::string & filtered_query, const std::string & order_by);
+  bool has_next_message();
+  // Must be called after prepare_for_reading() if has_next_message()
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> read_next_message();
+  void resolve_filtered_topics();
+  void create_topic_timestamp_index();
   void fill_topics_and_types();
   void activate_transaction();
   void commit_transaction();
   void write_locked(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
   RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
+  void commit_if_due_locked()
+  RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
+
+  struct MessageRow
+  {
+    const rosbag2_storage::SerializedBagMessage * message;
+    int topic_id;
+  };
+  /// Insert rows with multi-row INSERT statements.
+  void write_rows_locked(const std::vector<MessageRow> & rows)
+  RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
+  bool is_external_blob(const rosbag2_storage::SerializedBagMessage & message) const;
+  /// Insert the row of a message and append its data to the blob file.
+  void write_external_blob_locked(
+    const rosbag2_storage::SerializedBagMessage & message, int topic_id)
+  RCPPUTILS_TSA_REQUIRES(database_write_mutex_);
   int get_last_rowid();
   int read_db_schema_version();
+  /// Count bytes written to the database file and read its size again from time to time.
+  void account_written_bytes(uint64_t bytes);
+  uint64_t get_bagfile_size_on_disk() const;
 
+  // data (NULL for large blobs), timestamp, topic_id, id, length(data), send_timestamp
   using ReadQueryResult = SqliteStatementWrapper::QueryResult<
-    std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, std::string, int>;
+    std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, int, int, int,
+    rcutils_time_point_value_t>;
 
   std::shared_ptr<SqliteWrapper> database_ RCPPUTILS_TSA_GUARDED_BY(database_write_mutex_);
   SqliteStatement write_statement_ {};
@@ -139,22 +199,59 @@ private:
   std::unordered_map<std::string, int> msg_definitions_ RCPPUTILS_TSA_GUARDED_BY(
     database_write_mutex_);
   std::vector<rosbag2_storage::TopicMetadata> all_topics_and_types_;
+  // Interned names of the topics passing topic_filter_ by topic id and the ids as SQL list.
+  // Resolved on the next read after the filter or the topics changed.
+  std::unordered_map<int, const rosbag2_storage::InternedTopic *> filtered_topics_;
+  std::string filtered_topic_ids_;
+  std::atomic_bool filtered_topics_resolved_ {false};
   std::string relative_path_;
   std::atomic_bool active_transaction_ {false};
-
+  // Writes are grouped into one transaction until the policy is due, if it is enabled
+  rosbag2_storage::DurabilityPolicy durability_policy_ {0, 0};
+  // Size of the database file when it was read last and the estimated bytes written since,
+  // which are read by get_bagfile_size() from the thread deciding on splits.
+  std::atomic<uint64_t> synced_bagfile_size_ {0};
+  std::atomic<uint64_t> bytes_written_since_size_sync_ {0};
+
+  // PRAGMA data_version when the messages were queried last, which changes with every commit of
+  // another connection to the database
+  std::string data_version_;
+
+  // Position of the next read, seek_time_ is a publish time when reading in publish time order
   rcutils_time_point_value_t seek_time_ = 0;
   int seek_row_id_ = 0;
   rosbag2_storage::ReadOrder read_order_{};
-  rosbag2_storage::StorageFilter storage_filter_ {};
+  rosbag2_storage::TopicFilter topic_filter_ {};
+  // Receive time of the first messages to read, negative to read from the beginning of the bag
+  int64_t start_time_ns_ = -1;
+  // Receive time of the last messages to read, negative to read until the end of the bag
+  int64_t end_time_ns_ = -1;
+  // Sampling of the filter, see rosbag2_storage::StorageFilter
+  int64_t sample_interval_ns_ = 0;
+  uint64_t sample_stride_ = 0;
   rosbag2_storage::storage_interfaces::IOFlag storage_mode_{
     rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE};
+  // Connection and thread reading ahead, if a prefetch_size was configured for reading
+  size_t prefetch_size_ = 0;
+  std::shared_ptr<SqliteWrapper> prefetch_database_;
+  std::unique_ptr<MessagePrefetcher> prefetcher_;
+  // Connections scanning partitions of the messages in parallel, if parallel_scan_connections
+  // were configured for reading, and the reader of these partitions
+  std::vector<std::shared_ptr<SqliteWrapper>> scan_databases_;
+  std::unique_ptr<PartitionedMessageReader> partitioned_reader_;
+  // Space was reserved for the database file in open(), which is released on destruction
+  bool preallocated_ = false;
+  // Blob file for the data of messages larger than external_blob_threshold_, if configured for
+  // writing or the bag has one
+  std::shared_ptr<ExternalBlobStore> external_blob_store_;
+  size_t external_blob_threshold_ = 0;
 
   // This mutex is necessary to protect:
   // a) database access (this could also be done with FULLMUTEX), but see b)
   // b) topics_ collection - since we could be writing and reading it at the same time
   std::mutex database_write_mutex_;
 
-  const int kDBSchemaVersion_ = 4;
+  const int kDBSchemaVersion_ = 5;
   int db_schema_version_ = -1;  //  Valid version number starting from 1
   rosbag2_storage::BagMetadata metadata_{};
 };
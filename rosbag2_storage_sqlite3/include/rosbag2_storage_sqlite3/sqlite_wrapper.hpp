@@ -17,6 +17,7 @@
 
 #include <sqlite3.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -48,7 +49,15 @@ public:
   bool table_exists(const std::string & table_name);
   bool field_exists(const std::string & table_name, const std::string & field_name);
   SqliteStatement prepare_statement(const std::string & query);
+  /// Prepare query on first use and return the same statement for this query afterwards.
+  /// The statement is reset when it is returned, but has to be reset by the caller on errors.
+  SqliteStatement prepare_cached_statement(const std::string & query);
   std::string query_pragma_value(const std::string & key);
+  /// Read a blob with incremental blob I/O, straight into the buffer of a new message.
+  /// This avoids the copy SQLite makes when a blob spanning many pages is read as column value.
+  /// \throws SqliteException if the blob can not be opened or read.
+  std::shared_ptr<rcutils_uint8_array_t> read_blob(
+    const std::string & table, const std::string & column, int64_t row_id, size_t size);
 
   size_t get_last_insert_id();
 
@@ -64,6 +73,8 @@ private:
   void initialize_application_functions();
 
   sqlite3 * db_ptr;
+  // Statements have to be finalized before the database can be closed
+  std::unordered_map<std::string, SqliteStatement> cached_statements_;
 };
 
 
@@ -17,4 +17,6 @@ def get_preset_profiles():
     return [
         ('none', 'Default profile, optimized for performance.'),
         ('resilient', 'Avoid data corruption in case of crashes at the cost of performance.'),
+        ('high_throughput', 'Larger pages and caches for sustained write throughput.'),
+        ('fast_read', 'Memory mapped reads, applied to read-only bags by default.'),
     ]
@@ -0,0 +1,156 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "external_blob_store.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_storage_sqlite3/sqlite_exception.hpp"
+
+namespace rosbag2_storage_plugins
+{
+
+ExternalBlobStore::ExternalBlobStore(std::string path, bool writable)
+: path_(std::move(path))
+{
+  if (writable) {
+    // Create the file if it does not exist, without truncating it when appending to a bag
+    {
+      std::ofstream create_file(path_, std::ios::binary | std::ios::app);
+    }
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
+  } else {
+    file_.open(path_, std::ios::in | std::ios::binary);
+  }
+  if (!file_) {
+    throw std::runtime_error("Failed to open blob file '" + path_ + "'.");
+  }
+  file_.seekg(0, std::ios::end);
+  size_ = static_cast<uint64_t>(file_.tellg());
+}
+
+void ExternalBlobStore::create_table(SqliteWrapper & database)
+{
+  database.prepare_statement(
+    "CREATE TABLE IF NOT EXISTS external_blobs("
+    "message_id INTEGER PRIMARY KEY,"
+    "offset INTEGER NOT NULL,"
+    "length INTEGER NOT NULL);")->execute_and_reset();
+}
+
+bool ExternalBlobStore::has_table(SqliteWrapper & database)
+{
+  return database.table_exists("external_blobs");
+}
+
+void ExternalBlobStore::write_message(SqliteWrapper & database, const rcutils_uint8_array_t & data)
+{
+  uint64_t offset = 0;
+  {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    offset = size_;
+    file_.seekp(0, std::ios::end);
+    file_.write(
+      reinterpret_cast<const char *>(data.buffer),
+      static_cast<std::streamsize>(data.buffer_length));
+    file_.flush();
+    if (!file_) {
+      file_.clear();
+      throw std::runtime_error("Failed to write to blob file '" + path_ + "'.");
+    }
+    size_ += data.buffer_length;
+  }
+
+  auto statement = database.prepare_cached_statement(
+    "INSERT INTO external_blobs (message_id, offset, length) VALUES (?, ?, ?);");
+  statement->bind(
+    static_cast<rcutils_time_point_value_t>(database.get_last_insert_id()),
+    static_cast<rcutils_time_point_value_t>(offset),
+    static_cast<rcutils_time_point_value_t>(data.buffer_length));
+  statement->execute_and_reset();
+}
+
+std::shared_ptr<rcutils_uint8_array_t> ExternalBlobStore::read_message(
+  SqliteWrapper & database, int message_id)
+{
+  auto statement = database.prepare_cached_statement(
+    "SELECT offset, length FROM external_blobs WHERE message_id = ?;");
+  rcutils_time_point_value_t offset = 0;
+  rcutils_time_point_value_t length = -1;
+  statement->bind(message_id);
+  {
+    auto result = statement->execute_query<
+      rcutils_time_point_value_t, rcutils_time_point_value_t>();
+    for (auto row : result) {
+      offset = std::get<0>(row);
+      length = std::get<1>(row);
+    }
+  }
+  statement->reset();
+  if (length < 0) {
+    return nullptr;
+  }
+
+  auto data = rosbag2_storage::make_empty_serialized_message(static_cast<size_t>(length));
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  file_.seekg(offset);
+  file_.read(reinterpret_cast<char *>(data->buffer), static_cast<std::streamsize>(length));
+  if (!file_) {
+    file_.clear();
+    throw SqliteException(
+            "Failed to read " + std::to_string(length) + " bytes of message " +
+            std::to_string(message_id) + " at offset " + std::to_string(offset) +
+            " from blob file '" + path_ + "'.");
+  }
+  data->buffer_length = static_cast<size_t>(length);
+  return data;
+}
+
+void ExternalBlobStore::sync()
+{
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  file_.flush();
+#ifndef _WIN32
+  // The stream has no descriptor to sync, a second one syncs the same file
+  const int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0 || fsync(fd) != 0) {
+    const int error = errno;
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw std::runtime_error(
+            "Failed to sync blob file '" + path_ + "': " + std::strerror(error));
+  }
+  close(fd);
+#endif
+}
+
+uint64_t ExternalBlobStore::size() const
+{
+  return size_.load();
+}
+
+}  // namespace rosbag2_storage_plugins
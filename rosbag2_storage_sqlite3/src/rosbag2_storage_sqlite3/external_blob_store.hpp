@@ -0,0 +1,82 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_SQLITE3__EXTERNAL_BLOB_STORE_HPP_
+#define ROSBAG2_STORAGE_SQLITE3__EXTERNAL_BLOB_STORE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rcutils/types.h"
+#include "rosbag2_storage_sqlite3/sqlite_wrapper.hpp"
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Append-only file next to the database holding the data of messages too large for the
+ * messages table.
+ *
+ * The row of such a message keeps an empty blob, its data is referenced by offset and length
+ * from the external_blobs table by message id. Scans of the messages table then never page
+ * through the large data, which is only read for the messages actually returned.
+ */
+class ExternalBlobStore
+{
+public:
+  static constexpr const char * kFileExtension = ".blobs";
+
+  /// \param path Path of the blob file, which is created if writable and it does not exist.
+  /// \throws std::runtime_error if the file can not be opened.
+  ExternalBlobStore(std::string path, bool writable);
+
+  ExternalBlobStore(const ExternalBlobStore &) = delete;
+  ExternalBlobStore & operator=(const ExternalBlobStore &) = delete;
+
+  /// Create the external_blobs table in a new database.
+  static void create_table(SqliteWrapper & database);
+
+  /// Whether the database references data in a blob file.
+  static bool has_table(SqliteWrapper & database);
+
+  /// Append the data of a message, whose row was inserted last on database, and reference it.
+  /// The data is flushed first, so a committed reference never points beyond the file.
+  void write_message(SqliteWrapper & database, const rcutils_uint8_array_t & data);
+
+  /// Read the data of a message from the blob file.
+  /// \return nullptr if the data of the message is stored in the messages table.
+  std::shared_ptr<rcutils_uint8_array_t> read_message(SqliteWrapper & database, int message_id);
+
+  /// Write the data appended so far through to the disk, before references to it are committed
+  /// durably.
+  /// \throws std::runtime_error if the data can not be synced.
+  void sync();
+
+  /// Size of the blob file in bytes.
+  uint64_t size() const;
+
+private:
+  const std::string path_;
+  std::mutex file_mutex_;
+  std::fstream file_;
+  std::atomic<uint64_t> size_{0};
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_SQLITE3__EXTERNAL_BLOB_STORE_HPP_
@@ -0,0 +1,129 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "message_prefetcher.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "rcutils/types.h"
+
+namespace rosbag2_storage_plugins
+{
+
+MessagePrefetcher::MessagePrefetcher(
+  std::shared_ptr<SqliteWrapper> database,
+  std::string query,
+  std::unordered_map<int, const rosbag2_storage::InternedTopic *> topics,
+  size_t max_bytes,
+  std::shared_ptr<ExternalBlobStore> external_blob_store)
+: database_(std::move(database)),
+  query_(std::move(query)),
+  topics_(std::move(topics)),
+  max_bytes_(max_bytes),
+  external_blob_store_(std::move(external_blob_store))
+{
+  thread_ = std::thread(&MessagePrefetcher::run, this);
+}
+
+MessagePrefetcher::~MessagePrefetcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_changed_.notify_all();
+  thread_.join();
+}
+
+bool MessagePrefetcher::has_next()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_changed_.wait(lock, [this] {return !queue_.empty() || done_;});
+  if (queue_.empty() && error_) {
+    std::rethrow_exception(error_);
+  }
+  return !queue_.empty();
+}
+
+MessagePrefetcher::Entry MessagePrefetcher::pop()
+{
+  if (!has_next()) {
+    throw std::runtime_error("No more messages to read");
+  }
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry = std::move(queue_.front());
+    queue_.pop_front();
+    queued_bytes_ -= entry.message->serialized_data->buffer_length;
+  }
+  queue_changed_.notify_all();
+  return entry;
+}
+
+void MessagePrefetcher::run()
+{
+  try {
+    // Statement and result have to be released on this thread, before the connection may close
+    auto statement = database_->prepare_statement(query_);
+    auto result = statement->execute_query<
+      std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, int, int, int,
+      rcutils_time_point_value_t>();
+    for (auto row : result) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->serialized_data = std::get<0>(row);
+      if (!message->serialized_data) {
+        message->serialized_data = database_->read_blob(
+          "messages", "data", std::get<3>(row), static_cast<size_t>(std::get<4>(row)));
+      }
+      if (external_blob_store_ && message->serialized_data->buffer_length == 0) {
+        if (auto data = external_blob_store_->read_message(*database_, std::get<3>(row))) {
+          message->serialized_data = std::move(data);
+        }
+      }
+      message->time_stamp = std::get<1>(row);
+      message->send_timestamp = std::get<5>(row);
+      message->interned_topic = topics_.at(std::get<2>(row));
+      message->topic_name = message->interned_topic->name;
+      const size_t size = message->serialized_data->buffer_length;
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_changed_.wait(
+        lock, [this, size] {
+          return stop_ || queue_.empty() || queued_bytes_ + size <= max_bytes_;
+        });
+      if (stop_) {
+        return;
+      }
+      queue_.push_back({std::move(message), std::get<3>(row)});
+      queued_bytes_ += size;
+      lock.unlock();
+      queue_changed_.notify_all();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  queue_changed_.notify_all();
+}
+
+}  // namespace rosbag2_storage_plugins
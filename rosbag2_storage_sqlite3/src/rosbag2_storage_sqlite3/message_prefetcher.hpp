@@ -0,0 +1,102 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_SQLITE3__MESSAGE_PREFETCHER_HPP_
+#define ROSBAG2_STORAGE_SQLITE3__MESSAGE_PREFETCHER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "rosbag2_storage/interned_topic.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_storage_sqlite3/sqlite_wrapper.hpp"
+
+#include "external_blob_store.hpp"
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Steps a read query on a thread of its own and queues the messages, up to a byte budget.
+ *
+ * The query is executed on a separate connection, so the storage can keep using its own
+ * connection while messages are prefetched. A prefetcher serves a single query, the storage
+ * replaces it whenever the read position, the filter or the read order changes.
+ */
+class MessagePrefetcher
+{
+public:
+  struct Entry
+  {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    int row_id;
+  };
+
+  /// \param database Connection the query is executed on. Must not be used by anyone else while
+  /// the prefetcher exists.
+  /// \param query Read query with the columns of SqliteStorage::ReadQueryResult.
+  /// \param topics Interned names of the topics selected by query, by topic id.
+  /// \param max_bytes Budget for serialized data in the queue. A message larger than the budget
+  /// is still queued when the queue is empty.
+  /// \param external_blob_store Blob file of the bag, nullptr if it has none.
+  MessagePrefetcher(
+    std::shared_ptr<SqliteWrapper> database,
+    std::string query,
+    std::unordered_map<int, const rosbag2_storage::InternedTopic *> topics,
+    size_t max_bytes,
+    std::shared_ptr<ExternalBlobStore> external_blob_store = nullptr);
+
+  /// Stops prefetching and waits for the thread to finish.
+  ~MessagePrefetcher();
+
+  MessagePrefetcher(const MessagePrefetcher &) = delete;
+  MessagePrefetcher & operator=(const MessagePrefetcher &) = delete;
+
+  /// Blocks until a message was fetched or the query is exhausted.
+  /// \throws SqliteException if the query failed.
+  bool has_next();
+
+  /// \throws std::runtime_error if there are no more messages.
+  Entry pop();
+
+private:
+  void run();
+
+  const std::shared_ptr<SqliteWrapper> database_;
+  const std::string query_;
+  const std::unordered_map<int, const rosbag2_storage::InternedTopic *> topics_;
+  const size_t max_bytes_;
+  const std::shared_ptr<ExternalBlobStore> external_blob_store_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::deque<Entry> queue_;
+  size_t queued_bytes_ = 0;
+  bool stop_ = false;
+  bool done_ = false;
+  std::exception_ptr error_;
+
+  std::thread thread_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_SQLITE3__MESSAGE_PREFETCHER_HPP_
@@ -0,0 +1,78 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "partitioned_message_reader.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_storage_plugins
+{
+
+PartitionedMessageReader::PartitionedMessageReader(
+  std::vector<std::unique_ptr<MessagePrefetcher>> partitions,
+  ReadBefore read_before)
+: partitions_(std::move(partitions)),
+  read_before_(std::move(read_before)),
+  heads_(partitions_.size())
+{}
+
+bool PartitionedMessageReader::has_next()
+{
+  if (!read_before_) {
+    while (current_partition_ < partitions_.size() &&
+      !partitions_[current_partition_]->has_next())
+    {
+      // Close the exhausted partition, its thread has finished already
+      partitions_[current_partition_].reset();
+      ++current_partition_;
+    }
+    return current_partition_ < partitions_.size();
+  }
+
+  bool has_head = false;
+  for (size_t i = 0; i < partitions_.size(); ++i) {
+    if (!heads_[i] && partitions_[i] && partitions_[i]->has_next()) {
+      heads_[i] = partitions_[i]->pop();
+    } else if (!heads_[i]) {
+      partitions_[i].reset();
+    }
+    has_head = has_head || heads_[i].has_value();
+  }
+  return has_head;
+}
+
+PartitionedMessageReader::Entry PartitionedMessageReader::pop()
+{
+  if (!has_next()) {
+    throw std::runtime_error("No more messages to read");
+  }
+  if (!read_before_) {
+    return partitions_[current_partition_]->pop();
+  }
+
+  std::optional<Entry> * first = nullptr;
+  for (auto & head : heads_) {
+    if (head && (!first || read_before_(*head, **first))) {
+      first = &head;
+    }
+  }
+  Entry entry = std::move(**first);
+  first->reset();
+  return entry;
+}
+
+}  // namespace rosbag2_storage_plugins
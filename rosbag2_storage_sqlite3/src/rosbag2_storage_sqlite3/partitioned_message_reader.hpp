@@ -0,0 +1,68 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_STORAGE_SQLITE3__PARTITIONED_MESSAGE_READER_HPP_
+#define ROSBAG2_STORAGE_SQLITE3__PARTITIONED_MESSAGE_READER_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "message_prefetcher.hpp"
+
+namespace rosbag2_storage_plugins
+{
+
+/**
+ * Reads the messages of disjoint partitions of a query, each stepped by a MessagePrefetcher on
+ * a connection of its own, and returns them as a single sequence.
+ *
+ * Partitions which follow each other in read order are concatenated, the first one is read
+ * while the others are fetched ahead. Partitions which overlap in read order are merged, the
+ * next message then is the first one of all partitions.
+ */
+class PartitionedMessageReader
+{
+public:
+  using Entry = MessagePrefetcher::Entry;
+  /// Whether the first message is read before the second one.
+  using ReadBefore = std::function<bool (const Entry &, const Entry &)>;
+
+  /// \param partitions Prefetchers of the partitions, in read order if they are concatenated.
+  /// \param read_before Order to merge the partitions in, nullptr to concatenate them.
+  PartitionedMessageReader(
+    std::vector<std::unique_ptr<MessagePrefetcher>> partitions,
+    ReadBefore read_before = nullptr);
+
+  /// Blocks until a message was fetched or all partitions are exhausted.
+  /// \throws SqliteException if the query of a partition failed.
+  bool has_next();
+
+  /// \throws std::runtime_error if there are no more messages.
+  Entry pop();
+
+private:
+  std::vector<std::unique_ptr<MessagePrefetcher>> partitions_;
+  const ReadBefore read_before_;
+  // Partition read from when concatenating
+  size_t current_partition_ = 0;
+  // First unread message of each partition when merging
+  std::vector<std::optional<Entry>> heads_;
+};
+
+}  // namespace rosbag2_storage_plugins
+
+#endif  // ROSBAG2_STORAGE_SQLITE3__PARTITIONED_MESSAGE_READER_HPP_
@@ -175,11 +175,27 @@ void SqliteStatementWrapper::obtain_column_value(size_t index, std::string & val
 void SqliteStatementWrapper::obtain_column_value(
   size_t index, std::shared_ptr<rcutils_uint8_array_t> & value) const
 {
+  if (sqlite3_column_type(statement_, static_cast<int>(index)) == SQLITE_NULL) {
+    value = nullptr;
+    return;
+  }
   auto data = sqlite3_column_blob(statement_, static_cast<int>(index));
   auto size = static_cast<size_t>(sqlite3_column_bytes(statement_, static_cast<int>(index)));
   value = rosbag2_storage::make_serialized_message(data, size);
 }
 
+rcutils_time_point_value_t SqliteStatementWrapper::get_column_int64(size_t index) const
+{
+  return sqlite3_column_int64(statement_, static_cast<int>(index));
+}
+
+const uint8_t * SqliteStatementWrapper::get_column_blob(size_t index, size_t & size) const
+{
+  const auto data = sqlite3_column_blob(statement_, static_cast<int>(index));
+  size = static_cast<size_t>(sqlite3_column_bytes(statement_, static_cast<int>(index)));
+  return static_cast<const uint8_t *>(data);
+}
+
 void SqliteStatementWrapper::check_and_report_bind_error(int return_code)
 {
   if (return_code != SQLITE_OK) {
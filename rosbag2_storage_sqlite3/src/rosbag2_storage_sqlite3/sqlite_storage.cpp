@@ -15,13 +15,20 @@
 #include "rosbag2_storage_sqlite3/sqlite_storage.hpp"
 
 #include <sys/stat.h>
+#ifdef __linux__
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <regex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -31,13 +38,17 @@
 #include "rcpputils/filesystem_helper.hpp"
 
 #include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 #include "rosbag2_storage/yaml.hpp"
 #include "rosbag2_storage_sqlite3/sqlite_exception.hpp"
 #include "rosbag2_storage_sqlite3/sqlite_pragmas.hpp"
 #include "rosbag2_storage_sqlite3/sqlite_statement_wrapper.hpp"
 
+#include "external_blob_store.hpp"
 #include "logging.hpp"
+#include "message_prefetcher.hpp"
+#include "partitioned_message_reader.hpp"
 
 namespace
 {
@@ -74,7 +85,10 @@ inline std::unordered_map<std::string, std::string> parse_pragmas(
     auto key =
       io_flag == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY ? "read" : "write";
     YAML::Node yaml_file = YAML::LoadFile(storage_config_uri);
-    pragma_entries = yaml_file[key]["pragmas"].as<std::vector<std::string>>();
+    // A section may also only configure prefetching or external blobs
+    if (!yaml_file[key] || yaml_file[key]["pragmas"]) {
+      pragma_entries = yaml_file[key]["pragmas"].as<std::vector<std::string>>();
+    }
   } catch (const YAML::Exception & ex) {
     throw std::runtime_error(
             std::string("Exception on parsing sqlite3 config file: ") +
@@ -132,10 +146,63 @@ inline std::unordered_map<std::string, std::string> parse_pragmas(
   return pragmas;
 }
 
-void apply_resilient_storage_settings(std::unordered_map<std::string, std::string> & pragmas)
+// Return the prefetch budget in bytes from the read section of the config file, 0 if not set
+size_t parse_prefetch_size(const std::string & storage_config_uri)
+{
+  if (storage_config_uri.empty()) {
+    return 0;
+  }
+  try {
+    YAML::Node read_config = YAML::LoadFile(storage_config_uri)["read"];
+    return read_config["prefetch_size"] ? read_config["prefetch_size"].as<size_t>() : 0;
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error(
+            std::string("Exception on parsing sqlite3 config file: ") +
+            ex.what());
+  }
+}
+
+// Return the number of connections scanning partitions of the messages in parallel from the read
+// section of the config file, 0 if not set
+size_t parse_parallel_scan_connections(const std::string & storage_config_uri)
+{
+  if (storage_config_uri.empty()) {
+    return 0;
+  }
+  try {
+    YAML::Node read_config = YAML::LoadFile(storage_config_uri)["read"];
+    return read_config["parallel_scan_connections"] ?
+           read_config["parallel_scan_connections"].as<size_t>() : 0;
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error(
+            std::string("Exception on parsing sqlite3 config file: ") +
+            ex.what());
+  }
+}
+
+// Return the size in bytes from which messages are stored in a blob file next to the database,
+// from the write section of the config file, 0 if not set
+size_t parse_external_blob_threshold(const std::string & storage_config_uri)
+{
+  if (storage_config_uri.empty()) {
+    return 0;
+  }
+  try {
+    YAML::Node write_config = YAML::LoadFile(storage_config_uri)["write"];
+    return write_config["external_blob_threshold"] ?
+           write_config["external_blob_threshold"].as<size_t>() : 0;
+  } catch (const YAML::Exception & ex) {
+    throw std::runtime_error(
+            std::string("Exception on parsing sqlite3 config file: ") +
+            ex.what());
+  }
+}
+
+void apply_preset_storage_settings(
+  std::unordered_map<std::string, std::string> & pragmas,
+  const rosbag2_storage_plugins::SqlitePragmas::pragmas_map_t & preset_pragmas)
 {
-  auto robust_pragmas = rosbag2_storage_plugins::SqlitePragmas::robust_writing_pragmas();
-  for (const auto & kv : robust_pragmas) {
+  for (const auto & kv : preset_pragmas) {
     // do not override settings from configuration file, otherwise apply
     if (pragmas.count(kv.first) == 0) {
       pragmas[kv.first] = kv.second;
@@ -145,23 +212,185 @@ void apply_resilient_storage_settings(std::unordered_map<std::string, std::strin
 
 constexpr const auto FILE_EXTENSION = ".db3";
 
+// Every sqlite3 database file starts with this string, including its terminating null byte
+constexpr const char kSqliteHeader[] = "SQLite format 3";
+
+// Message count and time range per topic, joined with the topics. The aggregation only needs
+// topic_id and timestamp, so it is answered from topic_timestamp_idx when the bag has it.
+const std::string kMessagesPerTopicQuery =
+  "topics JOIN (SELECT topic_id, COUNT(*) AS message_count, MIN(timestamp) AS min_timestamp, "
+  "MAX(timestamp) AS max_timestamp FROM messages GROUP BY topic_id) AS messages_per_topic "
+  "ON topics.id = messages_per_topic.topic_id;";
+
+// Messages larger than this are read with incremental blob I/O instead of as column value
+constexpr size_t kIncrementalBlobReadSize = 256 * 1024;
+
+// Bytes each partition of a parallel scan reads ahead, if no prefetch_size was configured
+constexpr size_t kDefaultPartitionPrefetchSize = 4 * 1024 * 1024;
+
+// Batches are inserted with statements of power of two rows, up to this many rows. With four
+// parameters per row, this stays below the host parameter limit of older SQLite versions (999).
+constexpr size_t kMaxRowsPerInsert = 128;
+
+std::vector<std::string> make_insert_messages_queries(
+  const std::string & columns, const std::string & row)
+{
+  std::vector<std::string> queries;
+  std::string values = row;
+  for (size_t rows = 1; rows <= kMaxRowsPerInsert; rows <<= 1) {
+    queries.push_back("INSERT INTO messages (" + columns + ") VALUES " + values + ";");
+    values += ", " + values;
+  }
+  return queries;
+}
+
+// Return the INSERT statement for row_count messages, row_count must be a power of two.
+// Bags before schema version 5, which are opened for appending, have no send_timestamp column.
+const std::string & insert_messages_query(size_t row_count, bool with_send_timestamp)
+{
+  static const auto queries = make_insert_messages_queries(
+    "timestamp, send_timestamp, topic_id, data", "(?, ?, ?, ?)");
+  static const auto queries_without_send_timestamp = make_insert_messages_queries(
+    "timestamp, topic_id, data", "(?, ?, ?)");
+  size_t index = 0;
+  while ((size_t{1} << index) < row_count) {
+    ++index;
+  }
+  return with_send_timestamp ? queries[index] : queries_without_send_timestamp[index];
+}
+
+// Publish time written for message, the receive time if the publish time is unknown
+rcutils_time_point_value_t stored_send_timestamp(
+  const rosbag2_storage::SerializedBagMessage & message)
+{
+  return message.send_timestamp > 0 ? message.send_timestamp : message.time_stamp;
+}
+
+// Create an empty database file with size bytes reserved on disk. The file size stays 0, so
+// SQLite initializes the file as a new database.
+void preallocate_database_file(const std::string & path, uint64_t size)
+{
+#ifdef __linux__
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+      "Failed to create '" << path << "' for pre-allocation: " << std::strerror(errno));
+    return;
+  }
+  if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) != 0) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+      "Failed to pre-allocate " << size << " bytes for '" << path << "': " <<
+        std::strerror(errno));
+  }
+  close(fd);
+#else
+  (void)size;
+  ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+    "Pre-allocation of bag files is not supported on this platform, '" << path <<
+      "' grows on demand.");
+#endif
+}
+
+// Release the blocks which were reserved beyond the end of the database file.
+void release_preallocated_space(const std::string & path)
+{
+#ifdef __linux__
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0 || truncate(path.c_str(), file_stat.st_size) != 0) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+      "Failed to release pre-allocated space of '" << path << "': " << std::strerror(errno));
+  }
+#else
+  (void)path;
+#endif
+}
+
 // Minimum size of a sqlite3 database file in bytes (84 kiB).
 constexpr const uint64_t MIN_SPLIT_FILE_SIZE = 86016;
+
+// Estimated bytes a message adds to the database besides its data: the record header, rowid,
+// timestamps and topic id of its row and its entry in the timestamp index.
+constexpr const uint64_t ESTIMATED_MESSAGE_OVERHEAD = 48;
+
+// The size of the database file is read again once the bytes written since it was read last
+// exceed this or a sixteenth of the file size, whichever is larger.
+constexpr const uint64_t MIN_BAGFILE_SIZE_SYNC_BYTES = 64 * 1024;
+
+// Condition selecting the messages sampled by sample_interval_ns and sample_stride of a
+// StorageFilter, or an empty string if all messages are read. The samples are numbered with
+// window functions over topic_timestamp_idx, which holds the row id as well, so the data of
+// messages which are not sampled is never read.
+std::string sample_condition(
+  const std::string & topic_ids, int64_t start_time_ns, int64_t end_time_ns,
+  int64_t sample_interval_ns, uint64_t sample_stride)
+{
+  if (sample_interval_ns <= 0 && sample_stride <= 1) {
+    return "";
+  }
+  std::string candidates = "SELECT id, topic_id, timestamp";
+  if (sample_interval_ns > 0) {
+    candidates += ", ROW_NUMBER() OVER (PARTITION BY topic_id, timestamp / " +
+      std::to_string(sample_interval_ns) + " ORDER BY timestamp, id) AS interval_rank";
+  }
+  candidates += " FROM messages WHERE (topic_id IN (" + topic_ids + "))";
+  if (start_time_ns >= 0) {
+    candidates += " AND (timestamp >= " + std::to_string(start_time_ns) + ")";
+  }
+  if (end_time_ns >= 0) {
+    candidates += " AND (timestamp <= " + std::to_string(end_time_ns) + ")";
+  }
+  if (sample_interval_ns > 0) {
+    candidates = "SELECT id, topic_id, timestamp FROM (" + candidates +
+      ") WHERE interval_rank = 1";
+  }
+  if (sample_stride > 1) {
+    candidates = "SELECT id FROM (SELECT id, ROW_NUMBER() OVER "
+      "(PARTITION BY topic_id ORDER BY timestamp, id) AS position FROM (" + candidates +
+      ")) WHERE (position - 1) % " + std::to_string(sample_stride) + " = 0";
+  } else {
+    candidates = "SELECT id FROM (" + candidates + ")";
+  }
+  return "AND (id IN (" + candidates + ")) ";
+}
 }  // namespace
 
 namespace rosbag2_storage_plugins
 {
+SqliteStorage::SqliteStorage() = default;
+
 SqliteStorage::~SqliteStorage()
 {
+  prefetcher_.reset();
+  partitioned_reader_.reset();
   if (active_transaction_) {
     commit_transaction();
   }
+  if (database_ && storage_mode_ != rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY) {
+    create_topic_timestamp_index();
+  }
+  if (preallocated_) {
+    // The database has to be closed before it can be truncated, which requires all statements
+    // of the database to be finalized first.
+    current_message_row_ = {nullptr, SqliteStatementWrapper::QueryResult<>::Iterator::POSITION_END};
+    message_result_ = ReadQueryResult{nullptr};
+    read_statement_.reset();
+    write_statement_.reset();
+    {
+      std::lock_guard<std::mutex> db_lock(database_write_mutex_);
+      database_.reset();
+    }
+    release_preallocated_space(relative_path_);
+  }
 }
 
 SqliteStorage::PresetProfile SqliteStorage::parse_preset_profile(const std::string & profile_string)
 {
   if (profile_string == "resilient") {
     return SqliteStorage::PresetProfile::Resilient;
+  } else if (profile_string == "high_throughput") {
+    return SqliteStorage::PresetProfile::HighThroughput;
+  } else if (profile_string == "fast_read") {
+    return SqliteStorage::PresetProfile::FastRead;
   } else if (profile_string == "none" || profile_string == "") {
     return SqliteStorage::PresetProfile::WriteOptimized;
   } else {
@@ -172,7 +401,11 @@ SqliteStorage::PresetProfile SqliteStorage::parse_preset_profile(const std::stri
             "messages.\n"
             "'resilient': indicate preference for avoiding data corruption in case of crashes, "
             "at the cost of performance. Setting this flag disables optimization settings for "
-            "storage."
+            "storage.\n"
+            "'high_throughput': larger pages, caches and WAL checkpoints for sustained write "
+            "throughput, at the cost of memory.\n"
+            "'fast_read': memory mapped reads and a larger page cache. Applied to read-only bags "
+            "by default."
     );
   }
 }
@@ -184,8 +417,19 @@ void SqliteStorage::open(
   storage_mode_ = io_flag;
   const auto preset = parse_preset_profile(storage_options.storage_preset_profile);
   auto pragmas = parse_pragmas(storage_options.storage_config_uri, io_flag);
-  if (preset == PresetProfile::Resilient && is_read_write(io_flag)) {
-    apply_resilient_storage_settings(pragmas);
+  durability_policy_ = rosbag2_storage::DurabilityPolicy(storage_options);
+  if (is_read_write(io_flag)) {
+    if (durability_policy_.enabled()) {
+      apply_preset_storage_settings(pragmas, SqlitePragmas::durable_writing_pragmas());
+    }
+    if (preset == PresetProfile::Resilient) {
+      apply_preset_storage_settings(pragmas, SqlitePragmas::robust_writing_pragmas());
+    } else if (preset == PresetProfile::HighThroughput) {
+      apply_preset_storage_settings(pragmas, SqlitePragmas::high_throughput_writing_pragmas());
+    }
+  } else if (io_flag == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY) {
+    // Reading does not depend on the profile the bag was recorded with
+    apply_preset_storage_settings(pragmas, SqlitePragmas::fast_reading_pragmas());
   }
 
   if (is_read_write(io_flag)) {
@@ -196,6 +440,14 @@ void SqliteStorage::open(
       throw std::runtime_error(
               "Failed to create bag: File '" + relative_path_ + "' already exists!");
     }
+
+    if (storage_options.preallocate_bagfiles &&
+      storage_options.max_bagfile_size !=
+      rosbag2_storage::storage_interfaces::MAX_BAGFILE_SIZE_NO_SPLIT)
+    {
+      preallocate_database_file(relative_path_, storage_options.max_bagfile_size);
+      preallocated_ = true;
+    }
   } else {  // APPEND and READ_ONLY
     relative_path_ = storage_options.uri;
 
@@ -206,12 +458,54 @@ void SqliteStorage::open(
     }
   }
 
+  prefetcher_.reset();
+  prefetch_database_.reset();
+  partitioned_reader_.reset();
+  scan_databases_.clear();
+  external_blob_store_.reset();
+  prefetch_size_ = io_flag == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY ?
+    parse_prefetch_size(storage_options.storage_config_uri) : 0;
+  const size_t parallel_scan_connections =
+    io_flag == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY ?
+    parse_parallel_scan_connections(storage_options.storage_config_uri) : 0;
   try {
+    if (parallel_scan_connections > 1) {
+      // Each partition of a parallel scan is stepped on a connection of its own, which replaces
+      // the connection of the prefetcher
+      for (size_t i = 0; i < parallel_scan_connections; ++i) {
+        auto scan_pragmas = pragmas;
+        scan_databases_.push_back(
+          std::make_shared<SqliteWrapper>(relative_path_, io_flag, std::move(scan_pragmas)));
+      }
+    } else if (prefetch_size_ > 0) {
+      // Prefetching steps the read query on a connection of its own
+      auto prefetch_pragmas = pragmas;
+      prefetch_database_ = std::make_shared<SqliteWrapper>(
+        relative_path_, io_flag, std::move(prefetch_pragmas));
+    }
     database_ = std::make_unique<SqliteWrapper>(relative_path_, io_flag, std::move(pragmas));
   } catch (const SqliteException & e) {
     throw std::runtime_error("Failed to setup storage. Error: " + std::string(e.what()));
   }
 
+  // Messages above the threshold are stored in a blob file, as well as messages too large for
+  // SQLite once a bag has a blob file
+  const size_t external_blob_threshold = io_flag ==
+    rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY ?
+    0 : parse_external_blob_threshold(storage_options.storage_config_uri);
+  const bool has_external_blobs = ExternalBlobStore::has_table(*database_);
+  if (external_blob_threshold > 0 || has_external_blobs) {
+    if (io_flag != rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY) {
+      ExternalBlobStore::create_table(*database_);
+    }
+    const size_t sqlite_limit = sqlite3_limit(database_->get_database(), SQLITE_LIMIT_LENGTH, -1);
+    external_blob_threshold_ = external_blob_threshold > 0 ?
+      std::min(external_blob_threshold, sqlite_limit) : sqlite_limit;
+    external_blob_store_ = std::make_shared<ExternalBlobStore>(
+      relative_path_ + ExternalBlobStore::kFileExtension,
+      io_flag != rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  }
+
   // initialize only for READ_WRITE since the DB is already initialized if in APPEND.
   if (is_read_write(io_flag)) {
     db_schema_version_ = kDBSchemaVersion_;
@@ -225,11 +519,27 @@ void SqliteStorage::open(
   // These will be reinitialized lazily on the first read or write.
   read_statement_ = nullptr;
   write_statement_ = nullptr;
+  filtered_topics_resolved_ = false;
+  bytes_written_since_size_sync_ = 0;
+  synced_bagfile_size_ = get_bagfile_size_on_disk();
 
   ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_INFO_STREAM(
     "Opened database '" << relative_path_ << "' for " << to_string(io_flag) << ".");
 }
 
+bool SqliteStorage::probe(const std::string & uri) const
+{
+  std::ifstream file(uri, std::ios::binary);
+  if (!file) {
+    // Leave it to open() to report why the file can not be read
+    return true;
+  }
+  char header[sizeof(kSqliteHeader)] = {};
+  file.read(header, sizeof(header));
+  return file.gcount() == static_cast<std::streamsize>(sizeof(header)) &&
+         std::memcmp(header, kSqliteHeader, sizeof(header)) == 0;
+}
+
 void SqliteStorage::update_metadata(const rosbag2_storage::BagMetadata & metadata)
 {
   metadata_ = metadata;
@@ -271,7 +581,15 @@ void SqliteStorage::commit_transaction()
 void SqliteStorage::write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
 {
   std::lock_guard<std::mutex> db_lock(database_write_mutex_);
+  if (!durability_policy_.enabled()) {
+    write_locked(message);
+    return;
+  }
+  // Group the message with the writes before it instead of committing it on its own
+  activate_transaction();
   write_locked(message);
+  durability_policy_.add_written_bytes(message->serialized_data->buffer_length);
+  commit_if_due_locked();
 }
 
 void SqliteStorage::write_locked(
@@ -287,8 +605,26 @@ void SqliteStorage::write_locked(
             "' has not been created yet! Call 'create_topic' first.");
   }
 
+  if (is_external_blob(*message)) {
+    // The row and the reference to its data are committed together
+    const bool own_transaction = !active_transaction_;
+    activate_transaction();
+    write_external_blob_locked(*message, topic_entry->second);
+    if (own_transaction) {
+      commit_transaction();
+    }
+    account_written_bytes(message->serialized_data->buffer_length + ESTIMATED_MESSAGE_OVERHEAD);
+    return;
+  }
+
   try {
-    write_statement_->bind(message->time_stamp, topic_entry->second, message->serialized_data);
+    if (db_schema_version_ >= 5) {
+      write_statement_->bind(
+        message->time_stamp, stored_send_timestamp(*message), topic_entry->second,
+        message->serialized_data);
+    } else {
+      write_statement_->bind(message->time_stamp, topic_entry->second, message->serialized_data);
+    }
   } catch (const SqliteException & exc) {
     if (SQLITE_TOOBIG == exc.get_sqlite_return_code()) {
       // Get the sqlite string/blob limit.
@@ -302,6 +638,8 @@ void SqliteStorage::write_locked(
           "' bytes failed to write because it exceeds the maximum size sqlite can store ('" <<
           sqlite_limit << "' bytes): " <<
           exc.what());
+      // Drop the parameters bound so far, the statement is reused for the next message
+      write_statement_->reset();
       return;
     } else {
       // Rethrow.
@@ -309,64 +647,306 @@ void SqliteStorage::write_locked(
     }
   }
   write_statement_->execute_and_reset();
+  account_written_bytes(message->serialized_data->buffer_length + ESTIMATED_MESSAGE_OVERHEAD);
 }
 
 void SqliteStorage::write(
   const std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> & messages)
 {
   std::lock_guard<std::mutex> db_lock(database_write_mutex_);
-  if (!write_statement_) {
-    prepare_for_writing();
-  }
-
   activate_transaction();
 
-  for (auto & message : messages) {
-    write_locked(message);
+  const size_t sqlite_limit = sqlite3_limit(database_->get_database(), SQLITE_LIMIT_LENGTH, -1);
+  std::vector<MessageRow> rows;
+  rows.reserve(messages.size());
+  uint64_t written_bytes = 0;
+  for (const auto & message : messages) {
+    auto topic_entry = topics_.find(message->topic_name);
+    if (topic_entry == end(topics_)) {
+      // Keep the messages in front of the failing one, as writing them one by one would
+      write_rows_locked(rows);
+      throw SqliteException(
+              "Topic '" + message->topic_name +
+              "' has not been created yet! Call 'create_topic' first.");
+    }
+    const uint64_t message_bytes =
+      message->serialized_data->buffer_length + ESTIMATED_MESSAGE_OVERHEAD;
+    if (is_external_blob(*message)) {
+      // Insert the rows in front first, so that the rows stay in the order of the messages
+      write_rows_locked(rows);
+      rows.clear();
+      write_external_blob_locked(*message, topic_entry->second);
+      written_bytes += message_bytes;
+      continue;
+    }
+    if (message->serialized_data->buffer_length > sqlite_limit) {
+      ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+        "Message on topic '" << message->topic_name << "' of size '" <<
+          message->serialized_data->buffer_length <<
+          "' bytes failed to write because it exceeds the maximum size sqlite can store ('" <<
+          sqlite_limit << "' bytes)");
+      continue;
+    }
+    rows.push_back({message.get(), topic_entry->second});
+    written_bytes += message_bytes;
+  }
+  write_rows_locked(rows);
+
+  if (durability_policy_.enabled()) {
+    // Group commit, the transaction stays open for the next batches until the policy is due
+    durability_policy_.add_written_bytes(written_bytes);
+    commit_if_due_locked();
+  } else {
+    commit_transaction();
   }
+  account_written_bytes(written_bytes);
+}
 
+void SqliteStorage::commit_if_due()
+{
+  std::lock_guard<std::mutex> db_lock(database_write_mutex_);
+  commit_if_due_locked();
+}
+
+void SqliteStorage::commit_if_due_locked()
+{
+  if (!durability_policy_.is_due()) {
+    return;
+  }
+  if (external_blob_store_) {
+    // Committed references must not point to data lost with the page cache
+    external_blob_store_->sync();
+  }
   commit_transaction();
+  durability_policy_.committed();
+}
+
+bool SqliteStorage::is_external_blob(const rosbag2_storage::SerializedBagMessage & message) const
+{
+  return external_blob_store_ &&
+         message.serialized_data->buffer_length > external_blob_threshold_;
+}
+
+void SqliteStorage::write_external_blob_locked(
+  const rosbag2_storage::SerializedBagMessage & message, int topic_id)
+{
+  // The row keeps an empty blob, a zero length buffer which is not bound as NULL
+  auto empty_data = rosbag2_storage::make_empty_serialized_message(1);
+  auto statement = database_->prepare_cached_statement(
+    insert_messages_query(1, db_schema_version_ >= 5));
+  try {
+    if (db_schema_version_ >= 5) {
+      statement->bind(
+        message.time_stamp, stored_send_timestamp(message), topic_id, empty_data);
+    } else {
+      statement->bind(message.time_stamp, topic_id, empty_data);
+    }
+    statement->execute_and_reset();
+  } catch (...) {
+    statement->reset();
+    throw;
+  }
+  external_blob_store_->write_message(*database_, *message.serialized_data);
+}
+
+void SqliteStorage::account_written_bytes(uint64_t bytes)
+{
+  const uint64_t since_sync = bytes_written_since_size_sync_.fetch_add(bytes) + bytes;
+  const uint64_t synced_size = synced_bagfile_size_.load();
+  if (since_sync >= std::max(MIN_BAGFILE_SIZE_SYNC_BYTES, synced_size / 16)) {
+    // Pages still in the cache or the WAL are not in the file yet, so the file size only
+    // corrects an estimate which fell behind it. Reset the written bytes before the size, so
+    // that a concurrent get_bagfile_size() may briefly under- but never overestimate it.
+    bytes_written_since_size_sync_.fetch_sub(since_sync);
+    synced_bagfile_size_ = std::max(get_bagfile_size_on_disk(), synced_size + since_sync);
+  }
+}
+
+void SqliteStorage::write_rows_locked(const std::vector<MessageRow> & rows)
+{
+  size_t first_row = 0;
+  while (first_row < rows.size()) {
+    // Split the batch into power of two sized chunks, so a few cached multi-row statements
+    // cover every batch size.
+    size_t row_count = kMaxRowsPerInsert;
+    while (row_count > rows.size() - first_row) {
+      row_count >>= 1;
+    }
+    auto statement = database_->prepare_cached_statement(
+      insert_messages_query(row_count, db_schema_version_ >= 5));
+    try {
+      // Blobs are bound without copying them and the statement keeps them alive until reset
+      for (size_t i = first_row; i < first_row + row_count; ++i) {
+        if (db_schema_version_ >= 5) {
+          statement->bind(
+            rows[i].message->time_stamp, stored_send_timestamp(*rows[i].message),
+            rows[i].topic_id, rows[i].message->serialized_data);
+        } else {
+          statement->bind(
+            rows[i].message->time_stamp, rows[i].topic_id, rows[i].message->serialized_data);
+        }
+      }
+      statement->execute_and_reset();
+    } catch (...) {
+      // The statement is reused by the next batch
+      statement->reset();
+      throw;
+    }
+    first_row += row_count;
+  }
 }
 
 bool SqliteStorage::set_read_order(const rosbag2_storage::ReadOrder & read_order)
 {
-  if (read_order.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp) {
-    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_DEBUG("ReadOrder::PublishedTimestamp not implemented");
+  if (read_order.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp &&
+    db_schema_version_ < 5)
+  {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN(
+      "ReadOrder::PublishedTimestamp requires a bag with schema version 5 or newer");
     return false;
   }
-  if (read_order.sort_by == rosbag2_storage::ReadOrder::File) {
-    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_DEBUG("ReadOrder::File not implemented");
+  if (read_order.sort_by == rosbag2_storage::ReadOrder::HeaderTimestamp) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN(
+      "ReadOrder::HeaderTimestamp requires the header stamp index of the bag");
     return false;
   }
-
   read_order_ = read_order;
   read_statement_ = nullptr;
+  prefetcher_.reset();
+  partitioned_reader_.reset();
   return true;
 }
 
 bool SqliteStorage::has_next()
 {
-  if (!read_statement_) {
+  if (!read_statement_ && !prefetcher_ && !partitioned_reader_) {
     prepare_for_reading();
   }
-
-  return current_message_row_ != message_result_.end();
+  return has_next_message();
 }
 
 std::shared_ptr<rosbag2_storage::SerializedBagMessage> SqliteStorage::read_next()
 {
-  if (!read_statement_) {
+  if (!read_statement_ && !prefetcher_ && !partitioned_reader_) {
     prepare_for_reading();
   }
+  return read_next_message();
+}
+
+std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>>
+SqliteStorage::read_next_batch(size_t max_messages, size_t max_bytes)
+{
+  if (!read_statement_ && !prefetcher_ && !partitioned_reader_) {
+    prepare_for_reading();
+  }
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  if (max_messages > 0) {
+    messages.reserve(max_messages);
+  }
+  size_t bytes = 0;
+  while ((max_messages == 0 || messages.size() < max_messages) &&
+    (max_bytes == 0 || bytes < max_bytes) && has_next_message())
+  {
+    messages.push_back(read_next_message());
+    bytes += messages.back()->serialized_data->buffer_length;
+  }
+  return messages;
+}
+
+void SqliteStorage::for_each(const rosbag2_storage::MessageViewCallback & callback)
+{
+  if (!read_statement_ && !prefetcher_ && !partitioned_reader_) {
+    prepare_for_reading();
+  }
+  if (prefetcher_ || partitioned_reader_ || external_blob_store_) {
+    // Messages read on other connections or from external blobs are complete messages already
+    ReadOnlyInterface::for_each(callback);
+    return;
+  }
+  const bool by_send_timestamp =
+    read_order_.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp;
+  const bool in_file_order = read_order_.sort_by == rosbag2_storage::ReadOrder::File;
+  // The columns are read from the statement in place, the rows are not copied like by
+  // read_next_message()
+  rosbag2_storage::SerializedBagMessageView view;
+  while (current_message_row_ != message_result_.end()) {
+    const int row_id = static_cast<int>(read_statement_->get_column_int64(3));
+    const auto length = static_cast<size_t>(read_statement_->get_column_int64(4));
+    std::shared_ptr<rcutils_uint8_array_t> large_data;
+    if (length > kIncrementalBlobReadSize) {
+      large_data = database_->read_blob("messages", "data", row_id, length);
+      view.data = large_data->buffer;
+      view.size = large_data->buffer_length;
+    } else {
+      view.data = read_statement_->get_column_blob(0, view.size);
+    }
+    view.time_stamp = read_statement_->get_column_int64(1);
+    view.send_timestamp = read_statement_->get_column_int64(5);
+    view.topic_name =
+      filtered_topics_.at(static_cast<int>(read_statement_->get_column_int64(2)))->name;
+    if (!in_file_order) {
+      seek_time_ = by_send_timestamp ? view.send_timestamp : view.time_stamp;
+    }
+    seek_row_id_ = row_id + (read_order_.reverse ? -1 : 1);
+
+    const bool proceed = callback(view);
+    ++current_message_row_;
+    if (!proceed) {
+      return;
+    }
+  }
+}
+
+bool SqliteStorage::has_next_message()
+{
+  if (prefetcher_) {
+    return prefetcher_->has_next();
+  }
+  if (partitioned_reader_) {
+    return partitioned_reader_->has_next();
+  }
+  return current_message_row_ != message_result_.end();
+}
+
+std::shared_ptr<rosbag2_storage::SerializedBagMessage> SqliteStorage::read_next_message()
+{
+  const bool by_send_timestamp =
+    read_order_.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp;
+  // In file order, reading continues by row id alone and seek_time_ keeps the time of seek()
+  const bool in_file_order = read_order_.sort_by == rosbag2_storage::ReadOrder::File;
+  if (prefetcher_ || partitioned_reader_) {
+    auto entry = prefetcher_ ? prefetcher_->pop() : partitioned_reader_->pop();
+    if (!in_file_order) {
+      seek_time_ = by_send_timestamp ? entry.message->send_timestamp : entry.message->time_stamp;
+    }
+    seek_row_id_ = entry.row_id + (read_order_.reverse ? -1 : 1);
+    return entry.message;
+  }
 
   auto bag_message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
   bag_message->serialized_data = std::get<0>(*current_message_row_);
+  if (!bag_message->serialized_data) {
+    bag_message->serialized_data = database_->read_blob(
+      "messages", "data", std::get<3>(*current_message_row_),
+      static_cast<size_t>(std::get<4>(*current_message_row_)));
+  }
+  if (external_blob_store_ && bag_message->serialized_data->buffer_length == 0) {
+    if (auto data = external_blob_store_->read_message(
+        *database_, std::get<3>(*current_message_row_)))
+    {
+      bag_message->serialized_data = std::move(data);
+    }
+  }
   bag_message->time_stamp = std::get<1>(*current_message_row_);
-  bag_message->topic_name = std::get<2>(*current_message_row_);
+  bag_message->send_timestamp = std::get<5>(*current_message_row_);
+  bag_message->interned_topic = filtered_topics_.at(std::get<2>(*current_message_row_));
+  bag_message->topic_name = bag_message->interned_topic->name;
 
   // set start time to current time
   // and set seek_row_id to the new row id up
-  seek_time_ = bag_message->time_stamp;
+  if (!in_file_order) {
+    seek_time_ = by_send_timestamp ? bag_message->send_timestamp : bag_message->time_stamp;
+  }
   seek_row_id_ = std::get<3>(*current_message_row_) + (read_order_.reverse ? -1 : 1);
 
   ++current_message_row_;
@@ -400,10 +980,20 @@ void SqliteStorage::get_all_message_definitions(
 }
 
 uint64_t SqliteStorage::get_bagfile_size() const
+{
+  if (storage_mode_ == rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY) {
+    return get_bagfile_size_on_disk();
+  }
+  // Called for every message written to decide on splitting, so avoid reading the file size
+  return synced_bagfile_size_.load() + bytes_written_since_size_sync_.load();
+}
+
+uint64_t SqliteStorage::get_bagfile_size_on_disk() const
 {
   const auto bag_path = rcpputils::fs::path{get_relative_file_path()};
+  const uint64_t external_blobs_size = external_blob_store_ ? external_blob_store_->size() : 0u;
 
-  return bag_path.exists() ? bag_path.file_size() : 0u;
+  return (bag_path.exists() ? bag_path.file_size() : 0u) + external_blobs_size;
 }
 
 void SqliteStorage::initialize()
@@ -440,6 +1030,7 @@ void SqliteStorage::initialize()
     "id INTEGER PRIMARY KEY," \
     "topic_id INTEGER NOT NULL," \
     "timestamp INTEGER NOT NULL, " \
+    "send_timestamp INTEGER NOT NULL, " \
     "data BLOB NOT NULL);";
   database_->prepare_statement(create_stmt)->execute_and_reset();
 
@@ -473,6 +1064,7 @@ void SqliteStorage::create_topic(
       topic.type_description_hash);
     insert_topic->execute_and_reset();
     topics_.emplace(topic.name, static_cast<int>(database_->get_last_insert_id()));
+    filtered_topics_resolved_ = false;
   }
   // TODO(morlov): Add topic.type_description_hash when it will be really calculated or getting
   //  from service. Currently dummy hashes causing tests failure
@@ -506,80 +1098,205 @@ void SqliteStorage::remove_topic(const rosbag2_storage::TopicMetadata & topic)
     delete_topic->bind(topic.name, topic.type, topic.serialization_format);
     delete_topic->execute_and_reset();
     topics_.erase(topic.name);
+    filtered_topics_resolved_ = false;
   }
 }
 
 void SqliteStorage::prepare_for_writing()
 {
   write_statement_ = database_->prepare_statement(
-    "INSERT INTO messages (timestamp, topic_id, data) VALUES (?, ?, ?);");
+    insert_messages_query(1, db_schema_version_ >= 5));
 }
 
-void SqliteStorage::prepare_for_reading()
+void SqliteStorage::create_topic_timestamp_index()
 {
-  std::string statement_str = "SELECT data, timestamp, topics.name, messages.id "
-    "FROM messages JOIN topics ON messages.topic_id = topics.id WHERE ";
-  std::vector<std::string> where_conditions;
-
-  // add topic filter
-  if (!storage_filter_.topics.empty()) {
-    // Construct string for selected topics
-    std::string topic_list{""};
-    for (auto & topic : storage_filter_.topics) {
-      topic_list += "'" + topic + "'";
-      if (&topic != &storage_filter_.topics.back()) {
-        topic_list += ",";
-      }
-    }
-    where_conditions.push_back("(topics.name IN (" + topic_list + "))");
+  // Created when closing the bag, so that recording does not have to maintain a second index
+  try {
+    database_->prepare_statement(
+      "CREATE INDEX IF NOT EXISTS topic_timestamp_idx ON messages (topic_id, timestamp, id);")
+    ->execute_and_reset();
+  } catch (const SqliteException & e) {
+    ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_WARN_STREAM(
+      "Failed to create topic index for '" << relative_path_ << "': " << e.what());
   }
-  // add topic filter based on regular expression
-  if (!storage_filter_.topics_regex.empty()) {
-    // Construct string for selected topics
-    where_conditions.push_back("(topics.name REGEXP '" + storage_filter_.topics_regex + "')");
+}
+
+void SqliteStorage::resolve_filtered_topics()
+{
+  filtered_topics_.clear();
+  filtered_topic_ids_.clear();
+  auto statement = database_->prepare_statement("SELECT id, name FROM topics;");
+  auto query_results = statement->execute_query<int, std::string>();
+  for (auto result : query_results) {
+    if (!topic_filter_.matches(std::get<1>(result))) {
+      continue;
+    }
+    filtered_topics_.emplace(
+      std::get<0>(result), &rosbag2_storage::intern_topic(std::get<1>(result)));
+    if (!filtered_topic_ids_.empty()) {
+      filtered_topic_ids_ += ",";
+    }
+    filtered_topic_ids_ += std::to_string(std::get<0>(result));
   }
-  // exclude topics based on regular expressions
-  if (!storage_filter_.topics_regex_to_exclude.empty()) {
-    // Construct string for selected topics
-    where_conditions.push_back(
-      "(topics.name NOT IN "
-      "(SELECT topics.name FROM topics WHERE topics.name REGEXP '" +
-      storage_filter_.topics_regex_to_exclude + "'))");
+  filtered_topics_resolved_ = true;
+}
+
+void SqliteStorage::prepare_for_reading()
+{
+  // The filter is evaluated once per topic instead of once per message, and only again after
+  // the filter or the topics changed. Messages are then selected by topic id, which can be
+  // served from topic_timestamp_idx.
+  if (!filtered_topics_resolved_) {
+    resolve_filtered_topics();
   }
 
   const std::string direction_op = read_order_.reverse ? "<" : ">";
   const std::string order_direction = read_order_.reverse ? "DESC" : "ASC";
+  // Bags before schema version 5 have no publish time, which is the receive time for them
+  const std::string send_timestamp_column = db_schema_version_ >= 5 ?
+    "send_timestamp" : "timestamp";
+  // Publish time order is not covered by topic_timestamp_idx and sorted by SQLite
+  const std::string order_column =
+    read_order_.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp ?
+    "send_timestamp" : "timestamp";
+
+  // File order is the order of insertion. It is read with a plain scan of the rowid, which
+  // needs no sorting, so the unary + keeps SQLite from choosing topic_timestamp_idx instead.
+  const bool in_file_order = read_order_.sort_by == rosbag2_storage::ReadOrder::File;
+  const std::string column_prefix = in_file_order ? "+" : "";
 
   // add seek head filter
   // When doing timestamp ordering, we need a secondary ordering on message_id
   // Timestamp is not required to be unique, but message_id is, so for messages with the same
   // timestamp we order by the id to have a consistent and deterministic order.
-  where_conditions.push_back(
-    "(((timestamp = " + std::to_string(seek_time_) + ") "
-    "AND (messages.id " + direction_op + "= " + std::to_string(seek_row_id_) + ")) "
-    "OR (timestamp " + direction_op + " " + std::to_string(seek_time_) + ")) ");
-
-  for (
-    std::vector<std::string>::const_iterator it = where_conditions.begin();
-    it != where_conditions.end(); ++it)
-  {
-    statement_str += *it;
-    if (it != where_conditions.end() - 1) {
-      statement_str += " AND ";
-    }
+  // Large blobs are not selected, they are read with incremental blob I/O in read_next()
+  std::string statement_str = "SELECT CASE WHEN length(data) > " +
+    std::to_string(kIncrementalBlobReadSize) + " THEN NULL ELSE data END, "
+    "timestamp, topic_id, id, length(data), " + send_timestamp_column + " FROM messages "
+    "WHERE (" + column_prefix + "topic_id IN (" + filtered_topic_ids_ + ")) ";
+  if (in_file_order) {
+    statement_str +=
+      "AND (id " + direction_op + "= " + std::to_string(seek_row_id_) + ") "
+      "AND (+timestamp " + direction_op + "= " + std::to_string(seek_time_) + ") ";
+  } else {
+    statement_str +=
+      "AND ((" + order_column + ", id) " + direction_op + "= (" + std::to_string(seek_time_) +
+      ", " + std::to_string(seek_row_id_) + ")) ";
+  }
+  if (start_time_ns_ >= 0) {
+    statement_str += "AND (" + column_prefix + "timestamp >= " +
+      std::to_string(start_time_ns_) + ") ";
+  }
+  if (end_time_ns_ >= 0) {
+    statement_str += "AND (" + column_prefix + "timestamp <= " +
+      std::to_string(end_time_ns_) + ") ";
+  }
+  statement_str += sample_condition(
+    filtered_topic_ids_, start_time_ns_, end_time_ns_, sample_interval_ns_, sample_stride_);
+
+  // add order by time then id, or by id alone in file order
+  std::string order_by_str = "ORDER BY ";
+  if (!in_file_order) {
+    order_by_str += order_column + " " + order_direction + ", ";
+  }
+  order_by_str += "id " + order_direction + ";";
+
+  if (!scan_databases_.empty()) {
+    prepare_for_partitioned_reading(statement_str, order_by_str);
+    return;
   }
+  statement_str += order_by_str;
 
-  // add order by time then id
-  statement_str += "ORDER BY messages.timestamp " + order_direction;
-  statement_str += ", messages.id " + order_direction;
-  statement_str += ";";
+  if (prefetch_database_) {
+    prefetcher_ = std::make_unique<MessagePrefetcher>(
+      prefetch_database_, statement_str, filtered_topics_, prefetch_size_,
+      external_blob_store_);
+    return;
+  }
 
   read_statement_ = database_->prepare_statement(statement_str);
   message_result_ = read_statement_->execute_query<
-    std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, std::string, int>();
+    std::shared_ptr<rcutils_uint8_array_t>, rcutils_time_point_value_t, int, int, int,
+    rcutils_time_point_value_t>();
   current_message_row_ = message_result_.begin();
 }
 
+void SqliteStorage::prepare_for_partitioned_reading(
+  const std::string & filtered_query, const std::string & order_by)
+{
+  // Receive time order is partitioned by receive time and file order by row id, so that the
+  // partitions follow each other in read order. The publish time is not indexed, so publish time
+  // order is partitioned by row id as well and the partitions are merged.
+  const bool by_timestamp = read_order_.sort_by == rosbag2_storage::ReadOrder::ReceivedTimestamp;
+  const bool by_send_timestamp =
+    read_order_.sort_by == rosbag2_storage::ReadOrder::PublishedTimestamp;
+  const std::string partition_column = by_timestamp ? "timestamp" : "id";
+
+  // Answered from timestamp_idx or the rowid without a scan
+  auto bounds_statement = database_->prepare_statement(
+    "SELECT IFNULL(MIN(" + partition_column + "), 0), IFNULL(MAX(" + partition_column +
+    "), -1) FROM messages;");
+  auto bounds = *bounds_statement->execute_query<int64_t, int64_t>().begin();
+  int64_t first = std::get<0>(bounds);
+  int64_t last = std::get<1>(bounds);
+  if (!by_send_timestamp) {
+    const int64_t seek_position = by_timestamp ? seek_time_ : seek_row_id_;
+    if (read_order_.reverse) {
+      last = std::min(last, seek_position);
+    } else {
+      first = std::max(first, seek_position);
+    }
+  }
+  if (by_timestamp && start_time_ns_ >= 0) {
+    first = std::max(first, start_time_ns_);
+  }
+  if (by_timestamp && end_time_ns_ >= 0) {
+    last = std::min(last, end_time_ns_);
+  }
+
+  const size_t partition_prefetch_size = prefetch_size_ > 0 ?
+    std::max<size_t>(prefetch_size_ / scan_databases_.size(), 1) : kDefaultPartitionPrefetchSize;
+  std::vector<std::unique_ptr<MessagePrefetcher>> partitions;
+  if (first <= last) {
+    // Ranges of equal width, computed unsigned as the range may exceed the signed limit
+    const uint64_t range = static_cast<uint64_t>(last) - static_cast<uint64_t>(first);
+    const uint64_t width = range / scan_databases_.size() + 1;
+    uint64_t offset = 0;
+    for (const auto & scan_database : scan_databases_) {
+      const auto partition_first = static_cast<int64_t>(static_cast<uint64_t>(first) + offset);
+      const auto partition_last = range - offset < width ?
+        last : static_cast<int64_t>(static_cast<uint64_t>(first) + offset + width - 1);
+      partitions.push_back(
+        std::make_unique<MessagePrefetcher>(
+          scan_database,
+          filtered_query + "AND (" + partition_column + " BETWEEN " +
+          std::to_string(partition_first) + " AND " + std::to_string(partition_last) + ") " +
+          order_by,
+          filtered_topics_, partition_prefetch_size, external_blob_store_));
+      if (partition_last == last) {
+        break;
+      }
+      offset += width;
+    }
+  }
+
+  if (!by_send_timestamp) {
+    if (read_order_.reverse) {
+      std::reverse(partitions.begin(), partitions.end());
+    }
+    partitioned_reader_ = std::make_unique<PartitionedMessageReader>(std::move(partitions));
+    return;
+  }
+  const bool reverse = read_order_.reverse;
+  partitioned_reader_ = std::make_unique<PartitionedMessageReader>(
+    std::move(partitions),
+    [reverse](const MessagePrefetcher::Entry & a, const MessagePrefetcher::Entry & b) {
+      const auto a_key = std::make_pair(a.message->send_timestamp, a.row_id);
+      const auto b_key = std::make_pair(b.message->send_timestamp, b.row_id);
+      return reverse ? b_key < a_key : a_key < b_key;
+    });
+}
+
 void SqliteStorage::fill_topics_and_types()
 {
   if (database_->field_exists("topics", "offered_qos_profiles")) {
@@ -679,10 +1396,9 @@ void SqliteStorage::read_metadata()
   if (database_->field_exists("topics", "offered_qos_profiles")) {
     if (database_->field_exists("topics", "type_description_hash")) {
       std::string query =
-        "SELECT name, type, serialization_format, COUNT(messages.id), MIN(messages.timestamp), "
-        "MAX(messages.timestamp), offered_qos_profiles, type_description_hash "
-        "FROM messages JOIN topics on topics.id = messages.topic_id "
-        "GROUP BY topics.name;";
+        "SELECT name, type, serialization_format, message_count, min_timestamp, "
+        "max_timestamp, offered_qos_profiles, type_description_hash "
+        "FROM " + kMessagesPerTopicQuery;
 
       auto statement = database_->prepare_statement(query);
       auto query_results = statement->execute_query<
@@ -707,10 +1423,9 @@ void SqliteStorage::read_metadata()
       }
     } else {
       std::string query =
-        "SELECT name, type, serialization_format, COUNT(messages.id), MIN(messages.timestamp), "
-        "MAX(messages.timestamp), offered_qos_profiles "
-        "FROM messages JOIN topics on topics.id = messages.topic_id "
-        "GROUP BY topics.name;";
+        "SELECT name, type, serialization_format, message_count, min_timestamp, "
+        "max_timestamp, offered_qos_profiles "
+        "FROM " + kMessagesPerTopicQuery;
 
       auto statement = database_->prepare_statement(query);
       auto query_results = statement->execute_query<
@@ -736,10 +1451,8 @@ void SqliteStorage::read_metadata()
     }
   } else {
     std::string query =
-      "SELECT name, type, serialization_format, COUNT(messages.id), MIN(messages.timestamp), "
-      "MAX(messages.timestamp) "
-      "FROM messages JOIN topics on topics.id = messages.topic_id "
-      "GROUP BY topics.name;";
+      "SELECT name, type, serialization_format, message_count, min_timestamp, max_timestamp "
+      "FROM " + kMessagesPerTopicQuery;
     auto statement = database_->prepare_statement(query);
     auto query_results = statement->execute_query<
       std::string, std::string, std::string, int, rcutils_time_point_value_t,
@@ -767,7 +1480,7 @@ void SqliteStorage::read_metadata()
   metadata_.starting_time =
     std::chrono::time_point<std::chrono::high_resolution_clock>(std::chrono::nanoseconds(min_time));
   metadata_.duration = std::chrono::nanoseconds(max_time) - std::chrono::nanoseconds(min_time);
-  metadata_.bag_size = get_bagfile_size();
+  metadata_.bag_size = get_bagfile_size_on_disk();
 
   if (db_schema_version_ >= 3 && database_->table_exists("schema")) {
     // Read schema version
@@ -790,8 +1503,17 @@ void SqliteStorage::set_filter(
 {
   // keep current start time and start row_id
   // set topic filter and reset read statement for re-read
-  storage_filter_ = storage_filter;
+  // The regular expressions use the same grammar as the REGEXP function of the database
+  topic_filter_ = rosbag2_storage::TopicFilter(
+    storage_filter, std::regex::extended | std::regex::nosubs);
+  filtered_topics_resolved_ = false;
+  start_time_ns_ = storage_filter.start_time_ns;
+  end_time_ns_ = storage_filter.end_time_ns;
+  sample_interval_ns_ = storage_filter.sample_interval_ns;
+  sample_stride_ = storage_filter.sample_stride;
   read_statement_ = nullptr;
+  prefetcher_.reset();
+  partitioned_reader_.reset();
 }
 
 void SqliteStorage::reset_filter()
@@ -806,6 +1528,144 @@ void SqliteStorage::seek(const rcutils_time_point_value_t & timestamp)
   seek_row_id_ = read_order_.reverse ? get_last_rowid() : 0;
   seek_time_ = timestamp;
   read_statement_ = nullptr;
+  prefetcher_.reset();
+  partitioned_reader_.reset();
+}
+
+bool SqliteStorage::refresh()
+{
+  auto data_version = database_->query_pragma_value("data_version");
+  if (data_version == data_version_) {
+    return true;
+  }
+  data_version_ = std::move(data_version);
+  // The query continues from the row after the last read message, which in file order also
+  // returns the rows inserted since. Topics created since are resolved again.
+  all_topics_and_types_.clear();
+  filtered_topics_resolved_ = false;
+  read_statement_ = nullptr;
+  prefetcher_.reset();
+  partitioned_reader_.reset();
+  return true;
+}
+
+rosbag2_storage::ReadEstimate SqliteStorage::estimate(
+  const rosbag2_storage::StorageFilter & storage_filter)
+{
+  rosbag2_storage::TopicFilter topic_filter(
+    storage_filter, std::regex::extended | std::regex::nosubs);
+  std::string topic_ids;
+  auto topics_statement = database_->prepare_statement("SELECT id, name FROM topics;");
+  for (auto result : topics_statement->execute_query<int, std::string>()) {
+    if (topic_filter.matches(std::get<1>(result))) {
+      if (!topic_ids.empty()) {
+        topic_ids += ",";
+      }
+      topic_ids += std::to_string(std::get<0>(result));
+    }
+  }
+
+  // length() of a blob is taken from the record header, the data is not read. The messages
+  // are selected like in prepare_for_reading(), which topic_timestamp_idx serves.
+  std::string condition = "WHERE (topic_id IN (" + topic_ids + ")) ";
+  if (storage_filter.start_time_ns >= 0) {
+    condition += "AND (timestamp >= " + std::to_string(storage_filter.start_time_ns) + ") ";
+  }
+  if (storage_filter.end_time_ns >= 0) {
+    condition += "AND (timestamp <= " + std::to_string(storage_filter.end_time_ns) + ") ";
+  }
+  condition += sample_condition(
+    topic_ids, storage_filter.start_time_ns, storage_filter.end_time_ns,
+    storage_filter.sample_interval_ns, storage_filter.sample_stride);
+  auto statement = database_->prepare_statement(
+    "SELECT COUNT(*), COALESCE(SUM(length(data)), 0) FROM messages " + condition + ";");
+  auto row = *statement->execute_query<
+    rcutils_time_point_value_t, rcutils_time_point_value_t>().begin();
+
+  rosbag2_storage::ReadEstimate estimate;
+  estimate.message_count = static_cast<uint64_t>(std::get<0>(row));
+  estimate.bytes = static_cast<uint64_t>(std::get<1>(row));
+  estimate.exact = true;
+  if (external_blob_store_) {
+    // The rows of large messages keep an empty blob, their length is in external_blobs
+    auto blobs_statement = database_->prepare_statement(
+      "SELECT COALESCE(SUM(length), 0) FROM external_blobs WHERE message_id IN "
+      "(SELECT id FROM messages " + condition + ");");
+    estimate.bytes += static_cast<uint64_t>(
+      std::get<0>(*blobs_statement->execute_query<rcutils_time_point_value_t>().begin()));
+  }
+  return estimate;
+}
+
+rosbag2_storage::FileVerification SqliteStorage::verify()
+{
+  rosbag2_storage::FileVerification verification;
+  verification.checked = true;
+  try {
+    // quick_check verifies the structure of every page, but not that indexes match their
+    // tables, which integrity_check would at the cost of a sort per index. Problems naming a
+    // page are located to its bytes.
+    const auto page_size = std::stoull(database_->query_pragma_value("page_size"));
+    const std::regex page_pattern("[Pp]age ([0-9]+)");
+    auto check_statement = database_->prepare_statement("PRAGMA quick_check;");
+    for (auto row : check_statement->execute_query<std::string>()) {
+      const auto & result = std::get<0>(row);
+      if (result == "ok") {
+        continue;
+      }
+      rosbag2_storage::IntegrityProblem problem;
+      problem.description = result;
+      std::smatch match;
+      if (std::regex_search(result, match, page_pattern)) {
+        const auto page = std::stoull(match[1].str());
+        problem.start_offset = (page - 1) * page_size;
+        problem.end_offset = page * page_size;
+      }
+      verification.problems.push_back(std::move(problem));
+    }
+
+    auto count_statement = database_->prepare_statement(
+      "SELECT topics.name, COUNT(*) FROM messages JOIN topics ON messages.topic_id = topics.id "
+      "GROUP BY topics.name;");
+    for (auto row : count_statement->execute_query<std::string, rcutils_time_point_value_t>()) {
+      verification.topic_message_counts[std::get<0>(row)] =
+        static_cast<uint64_t>(std::get<1>(row));
+    }
+
+    // Checks select the count and time range of the affected messages
+    auto check_rows = [this, &verification](
+      const std::string & query, const std::string & description) {
+        auto statement = database_->prepare_statement(query);
+        auto row = *statement->execute_query<
+          rcutils_time_point_value_t, rcutils_time_point_value_t, rcutils_time_point_value_t>()
+          .begin();
+        if (std::get<0>(row) > 0) {
+          rosbag2_storage::IntegrityProblem problem;
+          problem.description = std::to_string(std::get<0>(row)) + " " + description;
+          problem.start_time = std::get<1>(row);
+          problem.end_time = std::get<2>(row);
+          verification.problems.push_back(std::move(problem));
+        }
+      };
+    check_rows(
+      "SELECT COUNT(*), MIN(timestamp), MAX(timestamp) FROM messages "
+      "WHERE topic_id NOT IN (SELECT id FROM topics);",
+      "messages reference no topic");
+    if (external_blob_store_) {
+      check_rows(
+        "SELECT COUNT(*), MIN(messages.timestamp), MAX(messages.timestamp) "
+        "FROM external_blobs JOIN messages ON external_blobs.message_id = messages.id "
+        "WHERE external_blobs.offset + external_blobs.length > " +
+        std::to_string(external_blob_store_->size()) + ";",
+        "messages reference data beyond the end of the blob file");
+    }
+  } catch (const SqliteException & e) {
+    // A database damaged in its header or schema fails the queries themselves
+    rosbag2_storage::IntegrityProblem problem;
+    problem.description = e.what();
+    verification.problems.push_back(std::move(problem));
+  }
+  return verification;
 }
 
 std::string SqliteStorage::get_storage_setting(const std::string & key)
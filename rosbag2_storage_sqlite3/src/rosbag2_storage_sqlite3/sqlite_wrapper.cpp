@@ -24,6 +24,7 @@
 #include <utility>
 
 #include "rcutils/types.h"
+#include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/serialized_bag_message.hpp"
 
 #include "rosbag2_storage_sqlite3/sqlite_exception.hpp"
@@ -96,6 +97,7 @@ SqliteWrapper::SqliteWrapper()
 
 SqliteWrapper::~SqliteWrapper()
 {
+  cached_statements_.clear();
   const int rc = sqlite3_close(db_ptr);
   if (rc != SQLITE_OK) {
     ROSBAG2_STORAGE_DEFAULT_PLUGINS_LOG_ERROR_STREAM(
@@ -125,15 +127,30 @@ void SqliteWrapper::apply_pragma_settings(
     }
   }
 
-  for (auto & kv : pragmas) {
-    // Apply the setting. Note that statements that assign value do not reliably return value
-    auto pragma_name = kv.first;
-    auto pragma_statement = kv.second;
-    prepare_statement(pragma_statement)->execute_and_reset();
-
-    // Check if the value is set, reading the pragma
-    auto statement_for_check = "PRAGMA " + pragma_name + ";";
-    prepare_statement(statement_for_check)->execute_and_reset(true);
+  auto apply_pragma = [this](const std::string & pragma_name, const std::string & statement) {
+      // Apply the setting. Note that statements that assign value do not reliably return value
+      prepare_statement(statement)->execute_and_reset();
+
+      // Check if the value is set, reading the pragma
+      auto statement_for_check = "PRAGMA " + pragma_name + ";";
+      prepare_statement(statement_for_check)->execute_and_reset(true);
+    };
+
+  // The page size of a new database can not be changed anymore once it was switched to WAL mode
+  auto is_page_size = [](const std::string & pragma_name) {
+      // Also matches schema qualified names such as "main.page_size"
+      const auto dot = pragma_name.rfind('.');
+      return pragma_name.substr(dot == std::string::npos ? 0 : dot + 1) == "page_size";
+    };
+  for (const auto & kv : pragmas) {
+    if (is_page_size(kv.first)) {
+      apply_pragma(kv.first, kv.second);
+    }
+  }
+  for (const auto & kv : pragmas) {
+    if (!is_page_size(kv.first)) {
+      apply_pragma(kv.first, kv.second);
+    }
   }
 }
 
@@ -172,6 +189,42 @@ SqliteStatement SqliteWrapper::prepare_statement(const std::string & query)
   return std::make_shared<SqliteStatementWrapper>(db_ptr, query);
 }
 
+SqliteStatement SqliteWrapper::prepare_cached_statement(const std::string & query)
+{
+  auto cached = cached_statements_.find(query);
+  if (cached == cached_statements_.end()) {
+    cached = cached_statements_.emplace(query, prepare_statement(query)).first;
+  }
+  return cached->second;
+}
+
+std::shared_ptr<rcutils_uint8_array_t> SqliteWrapper::read_blob(
+  const std::string & table, const std::string & column, int64_t row_id, size_t size)
+{
+  sqlite3_blob * blob = nullptr;
+  int rc = sqlite3_blob_open(
+    db_ptr, "main", table.c_str(), column.c_str(), row_id, 0, &blob);
+  if (rc != SQLITE_OK) {
+    sqlite3_blob_close(blob);
+    std::stringstream errmsg;
+    errmsg << "Could not open blob of row " << row_id << " in " << table << "." << column <<
+      ". SQLite error (" << rc << "): " << sqlite3_errstr(rc);
+    throw SqliteException{errmsg.str(), rc};
+  }
+
+  auto message = rosbag2_storage::make_empty_serialized_message(size);
+  rc = sqlite3_blob_read(blob, message->buffer, static_cast<int>(size), 0);
+  sqlite3_blob_close(blob);
+  if (rc != SQLITE_OK) {
+    std::stringstream errmsg;
+    errmsg << "Could not read blob of row " << row_id << " in " << table << "." << column <<
+      ". SQLite error (" << rc << "): " << sqlite3_errstr(rc);
+    throw SqliteException{errmsg.str(), rc};
+  }
+  message->buffer_length = size;
+  return message;
+}
+
 size_t SqliteWrapper::get_last_insert_id()
 {
   return sqlite3_last_insert_rowid(db_ptr);
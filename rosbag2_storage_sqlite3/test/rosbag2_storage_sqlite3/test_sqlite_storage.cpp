@@ -14,9 +14,13 @@
 
 #include <gmock/gmock.h>
 
+#include <sys/stat.h>
+
 #include <algorithm>
+#include <fstream>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -28,6 +32,7 @@
 
 #include "rcutils/snprintf.h"
 
+#include "rosbag2_storage/ros_helper.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 
 #include "storage_test_fixture.hpp"
@@ -77,6 +82,24 @@ TEST_F(StorageTestFixture, string_messages_are_written_and_read_to_and_from_sqli
   }
 }
 
+TEST_F(StorageTestFixture, large_messages_are_read_with_incremental_blob_io) {
+  const std::string large_message(4 * 1024 * 1024, 'l');
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages =
+  {std::make_tuple("small message", 1, "topic1", "type1", "rmw1"),
+    std::make_tuple(large_message, 2, "topic1", "type1", "rmw1"),
+    std::make_tuple("another small message", 3, "topic1", "type1", "rmw1")};
+
+  write_messages_to_sqlite(messages);
+  auto read_messages = read_all_messages_from_sqlite();
+
+  ASSERT_THAT(read_messages, SizeIs(3));
+  EXPECT_THAT(deserialize_message(read_messages[0]->serialized_data), Eq("small message"));
+  EXPECT_THAT(deserialize_message(read_messages[1]->serialized_data), Eq(large_message));
+  EXPECT_THAT(
+    deserialize_message(read_messages[2]->serialized_data), Eq("another small message"));
+  EXPECT_THAT(read_messages[1]->time_stamp, Eq(2));
+}
+
 TEST_F(StorageTestFixture, has_next_return_false_if_there_are_no_more_messages) {
   std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
   string_messages =
@@ -160,12 +183,447 @@ TEST_F(StorageTestFixture, read_next_returns_filtered_messages) {
   EXPECT_TRUE(readable_storage2->has_next());
   auto fourth_message = readable_storage2->read_next();
   EXPECT_THAT(fourth_message->topic_name, Eq("topic2"));
+  // Messages of the same topic share its interned name, also across storages
+  EXPECT_THAT(fourth_message->interned_topic, NotNull());
+  EXPECT_THAT(fourth_message->interned_topic, Eq(first_message->interned_topic));
   EXPECT_TRUE(readable_storage2->has_next());
   auto fifth_message = readable_storage2->read_next();
   EXPECT_THAT(fifth_message->topic_name, Eq("topic3"));
   EXPECT_FALSE(readable_storage2->has_next());
 }
 
+TEST_F(StorageTestFixture, read_next_stops_at_end_time_of_filter) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages =
+  {std::make_tuple("topic1 message 1", 1, "topic1", "", ""),
+    std::make_tuple("topic2 message 1", 2, "topic2", "", ""),
+    std::make_tuple("topic1 message 2", 3, "topic1", "", ""),
+    std::make_tuple("topic1 message 3", 4, "topic1", "", ""),
+    std::make_tuple("topic2 message 2", 5, "topic2", "", "")};
+
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics.push_back("topic1");
+  storage_filter.end_time_ns = 3;
+  readable_storage->set_filter(storage_filter);
+
+  std::vector<int64_t> timestamps;
+  while (readable_storage->has_next()) {
+    timestamps.push_back(readable_storage->read_next()->time_stamp);
+  }
+  EXPECT_THAT(timestamps, ElementsAre(1, 3));
+
+  // The end time is kept when seeking, and applies to reverse reads as well
+  readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true});
+  readable_storage->seek(5);
+  timestamps.clear();
+  while (readable_storage->has_next()) {
+    timestamps.push_back(readable_storage->read_next()->time_stamp);
+  }
+  EXPECT_THAT(timestamps, ElementsAre(3, 1));
+}
+
+TEST_F(StorageTestFixture, read_next_returns_messages_in_time_window_of_filter) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 6; i++) {
+    string_messages.push_back(
+      std::make_tuple("message " + std::to_string(i), i, "topic1", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.start_time_ns = 2;
+  storage_filter.end_time_ns = 4;
+  readable_storage->set_filter(storage_filter);
+  auto read_time_stamps = [&readable_storage]() {
+      std::vector<int64_t> time_stamps;
+      while (readable_storage->has_next()) {
+        time_stamps.push_back(readable_storage->read_next()->time_stamp);
+      }
+      return time_stamps;
+    };
+  EXPECT_THAT(read_time_stamps(), ElementsAre(2, 3, 4));
+
+  // Seeking within the window keeps both bounds
+  readable_storage->seek(3);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(3, 4));
+  readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true});
+  readable_storage->seek(6);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(4, 3, 2));
+}
+
+TEST_F(StorageTestFixture, read_next_returns_sampled_messages_of_each_topic) {
+  // topic1 is written at 0, 20, ..., 180 and topic2 at 10, 30, ..., 190
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 0; i < 20; i++) {
+    string_messages.push_back(
+      std::make_tuple(
+        "message " + std::to_string(i), i * 10, i % 2 == 0 ? "topic1" : "topic2", "type",
+        "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  auto read_time_stamps = [&readable_storage]() {
+      std::vector<int64_t> time_stamps;
+      while (readable_storage->has_next()) {
+        time_stamps.push_back(readable_storage->read_next()->time_stamp);
+      }
+      return time_stamps;
+    };
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.sample_stride = 3;
+  readable_storage->set_filter(storage_filter);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(0, 10, 60, 70, 120, 130, 180, 190));
+  EXPECT_EQ(readable_storage->estimate(storage_filter).message_count, 8u);
+
+  // The samples do not change after seeking or in reverse order
+  readable_storage->seek(100);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(120, 130, 180, 190));
+  readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true});
+  readable_storage->seek(100);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(70, 60, 10, 0));
+  readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, false});
+
+  // The first message of each topic in every interval of 45 ns
+  storage_filter.sample_stride = 0;
+  storage_filter.sample_interval_ns = 45;
+  readable_storage->set_filter(storage_filter);
+  readable_storage->seek(0);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(0, 10, 50, 60, 90, 100, 140, 150, 180, 190));
+
+  // Both are combined with the topic filter and the time range
+  storage_filter.topics = {"topic2"};
+  storage_filter.sample_stride = 2;
+  storage_filter.start_time_ns = 40;
+  readable_storage->set_filter(storage_filter);
+  readable_storage->seek(0);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(50, 150));
+}
+
+TEST_F(StorageTestFixture, estimate_counts_messages_and_bytes_of_filter) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 6; i++) {
+    string_messages.push_back(
+      std::make_tuple(
+        "message " + std::to_string(i), i, i % 2 == 0 ? "topic2" : "topic1", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {"topic2"};
+  storage_filter.start_time_ns = 3;
+  const auto estimate = readable_storage->estimate(storage_filter);
+  EXPECT_TRUE(estimate.exact);
+  EXPECT_EQ(estimate.message_count, 2u);
+
+  uint64_t bytes = 0;
+  readable_storage->set_filter(storage_filter);
+  while (readable_storage->has_next()) {
+    bytes += readable_storage->read_next()->serialized_data->buffer_length;
+  }
+  EXPECT_EQ(estimate.bytes, bytes);
+  EXPECT_EQ(readable_storage->estimate({}).message_count, 6u);
+}
+
+TEST_F(StorageTestFixture, verify_counts_messages_and_reports_messages_without_topic) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 5; i++) {
+    string_messages.push_back(
+      std::make_tuple(
+        "message " + std::to_string(i), i, i % 2 == 0 ? "topic2" : "topic1", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  {
+    const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+    readable_storage->open(
+      {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+    const auto verification = readable_storage->verify();
+    EXPECT_TRUE(verification.checked);
+    EXPECT_TRUE(verification.problems.empty());
+    EXPECT_EQ(verification.topic_message_counts.at("topic1"), 3u);
+    EXPECT_EQ(verification.topic_message_counts.at("topic2"), 2u);
+  }
+
+  {
+    rosbag2_storage_plugins::SqliteWrapper db(
+      db_filename, rosbag2_storage::storage_interfaces::IOFlag::APPEND);
+    db.prepare_statement(
+      "INSERT INTO messages (timestamp, send_timestamp, topic_id, data) VALUES (7, 7, 42, x'00');")
+    ->execute_and_reset();
+  }
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  const auto verification = readable_storage->verify();
+  ASSERT_EQ(verification.problems.size(), 1u);
+  EXPECT_THAT(verification.problems[0].description, HasSubstr("reference no topic"));
+  EXPECT_EQ(verification.problems[0].start_time, 7);
+  EXPECT_EQ(verification.problems[0].end_time, 7);
+  EXPECT_EQ(verification.message_count(), 5u);
+}
+
+TEST_F(StorageTestFixture, read_next_batch_returns_up_to_max_messages_or_bytes) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 6; i++) {
+    string_messages.push_back(
+      std::make_tuple("message " + std::to_string(i), i, "topic1", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  auto batch_time_stamps = [&readable_storage](size_t max_messages, size_t max_bytes) {
+      std::vector<int64_t> time_stamps;
+      for (const auto & message : readable_storage->read_next_batch(max_messages, max_bytes)) {
+        time_stamps.push_back(message->time_stamp);
+      }
+      return time_stamps;
+    };
+
+  EXPECT_THAT(batch_time_stamps(2, 0), ElementsAre(1, 2));
+  EXPECT_EQ(readable_storage->read_next()->time_stamp, 3);
+  // A batch holds at least one message, even if it exceeds max_bytes
+  EXPECT_THAT(batch_time_stamps(0, 1), ElementsAre(4));
+  EXPECT_THAT(batch_time_stamps(0, 0), ElementsAre(5, 6));
+  EXPECT_THAT(batch_time_stamps(10, 0), IsEmpty());
+
+  readable_storage->seek(2);
+  const auto messages = readable_storage->read_next_batch(1);
+  ASSERT_THAT(messages, SizeIs(1));
+  EXPECT_THAT(deserialize_message(messages[0]->serialized_data), Eq("message 2"));
+  EXPECT_EQ(messages[0]->topic_name, "topic1");
+}
+
+TEST_F(StorageTestFixture, for_each_hands_out_messages_until_callback_stops) {
+  const std::string large_message(4 * 1024 * 1024, 'l');
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages =
+  {std::make_tuple("message 1", 1, "topic1", "type1", "rmw1"),
+    std::make_tuple(large_message, 2, "topic1", "type1", "rmw1"),
+    std::make_tuple("message 3", 3, "topic2", "type2", "rmw2"),
+    std::make_tuple("message 4", 4, "topic1", "type1", "rmw1")};
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  std::vector<std::tuple<int64_t, std::string, std::string>> messages;
+  const auto collect_until = [this, &messages](int64_t last) {
+      return [this, &messages, last](const rosbag2_storage::SerializedBagMessageView & message) {
+               messages.emplace_back(
+                 message.time_stamp, std::string(message.topic_name),
+                 deserialize_message(
+                   rosbag2_storage::make_serialized_message(message.data, message.size)));
+               return message.time_stamp < last;
+             };
+    };
+
+  readable_storage->for_each(collect_until(2));
+  EXPECT_THAT(
+    messages, ElementsAre(
+      std::make_tuple(1, "topic1", "message 1"), std::make_tuple(2, "topic1", large_message)));
+  // Reading continues after the message the callback stopped at
+  EXPECT_EQ(readable_storage->read_next()->time_stamp, 3);
+  messages.clear();
+  readable_storage->for_each(collect_until(100));
+  EXPECT_THAT(messages, ElementsAre(std::make_tuple(4, "topic1", "message 4")));
+  EXPECT_FALSE(readable_storage->has_next());
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {"topic2"};
+  readable_storage->set_filter(storage_filter);
+  readable_storage->seek(0);
+  messages.clear();
+  readable_storage->for_each(collect_until(100));
+  EXPECT_THAT(messages, ElementsAre(std::make_tuple(3, "topic2", "message 3")));
+}
+
+TEST_F(StorageTestFixture, topic_index_is_created_on_close_and_used_for_filtered_seek) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages =
+  {std::make_tuple("topic1 message 1", 1, "topic1", "", ""),
+    std::make_tuple("topic2 message 1", 2, "topic2", "", ""),
+    std::make_tuple("topic1 message 2", 3, "topic1", "", ""),
+    std::make_tuple("topic2 message 2", 4, "topic2", "", "")};
+
+  write_messages_to_sqlite(string_messages);
+  auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  auto & db = readable_storage->get_sqlite_database_wrapper();
+  auto index_count = db.prepare_statement(
+    "SELECT count(*) FROM sqlite_master WHERE type='index' AND name='topic_timestamp_idx';")
+    ->execute_query<int>().get_single_line();
+  EXPECT_EQ(std::get<0>(index_count), 1);
+
+  auto query_plan = db.prepare_statement(
+    "EXPLAIN QUERY PLAN SELECT data, timestamp, topic_id, id FROM messages "
+    "WHERE (topic_id IN (1)) AND ((timestamp, id) >= (2, 0)) ORDER BY timestamp, id;")
+    ->execute_query<int, int, int, std::string>();
+  std::string plan;
+  for (auto row : query_plan) {
+    plan += std::get<3>(row) + "\n";
+  }
+  EXPECT_THAT(plan, HasSubstr("topic_timestamp_idx"));
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics_regex_to_exclude = "topic2";
+  readable_storage->set_filter(storage_filter);
+  readable_storage->seek(2);
+
+  ASSERT_TRUE(readable_storage->has_next());
+  auto message = readable_storage->read_next();
+  EXPECT_THAT(message->topic_name, Eq("topic1"));
+  EXPECT_THAT(message->time_stamp, Eq(3));
+  EXPECT_THAT(deserialize_message(message->serialized_data), Eq("topic1 message 2"));
+  EXPECT_FALSE(readable_storage->has_next());
+}
+
+TEST_F(StorageTestFixture, filter_includes_topics_created_after_set_filter) {
+  const auto storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto storage_uri = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  storage->open({storage_uri, kPluginID});
+  write_messages_to_sqlite({std::make_tuple("topic1 message", 1, "topic1", "", "")}, storage);
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics_regex = "topic.*";
+  storage->set_filter(storage_filter);
+  ASSERT_TRUE(storage->has_next());
+  EXPECT_THAT(storage->read_next()->topic_name, Eq("topic1"));
+  EXPECT_FALSE(storage->has_next());
+
+  write_messages_to_sqlite({std::make_tuple("topic2 message", 2, "topic2", "", "")}, storage);
+  storage->seek(0);
+  ASSERT_TRUE(storage->has_next());
+  EXPECT_THAT(storage->read_next()->topic_name, Eq("topic1"));
+  ASSERT_TRUE(storage->has_next());
+  EXPECT_THAT(storage->read_next()->topic_name, Eq("topic2"));
+  EXPECT_FALSE(storage->has_next());
+}
+
+TEST_F(StorageTestFixture, prefetched_reads_restart_on_seek_filter_and_read_order) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 20; i++) {
+    string_messages.push_back(
+      std::make_tuple(
+        "message " + std::to_string(i), i, i % 2 ? "odd" : "even", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+
+  // The budget only fits a few messages, so the prefetch thread has to wait for the reader
+  auto options = make_storage_options_with_config("read:\n  prefetch_size: 64\n", kPluginID);
+  options.uri = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  auto read_time_stamps = [&readable_storage](size_t count) {
+      std::vector<int64_t> time_stamps;
+      while (time_stamps.size() < count && readable_storage->has_next()) {
+        time_stamps.push_back(readable_storage->read_next()->time_stamp);
+      }
+      return time_stamps;
+    };
+
+  EXPECT_THAT(read_time_stamps(3), ElementsAre(1, 2, 3));
+
+  readable_storage->seek(15);
+  EXPECT_THAT(read_time_stamps(100), ElementsAre(15, 16, 17, 18, 19, 20));
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics.push_back("even");
+  readable_storage->set_filter(storage_filter);
+  readable_storage->seek(0);
+  EXPECT_THAT(read_time_stamps(3), ElementsAre(2, 4, 6));
+
+  ASSERT_TRUE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true}));
+  readable_storage->seek(11);
+  EXPECT_THAT(read_time_stamps(100), ElementsAre(10, 8, 6, 4, 2));
+  EXPECT_FALSE(readable_storage->has_next());
+  EXPECT_THROW(readable_storage->read_next(), std::runtime_error);
+}
+
+TEST_F(StorageTestFixture, parallel_scan_reads_partitions_in_read_order) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages;
+  for (int64_t i = 1; i <= 20; i++) {
+    string_messages.push_back(
+      std::make_tuple(
+        "message " + std::to_string(i), i, i % 2 ? "odd" : "even", "type", "rmw"));
+  }
+  write_messages_to_sqlite(string_messages);
+
+  auto options = make_storage_options_with_config(
+    "read:\n  parallel_scan_connections: 3\n  prefetch_size: 64\n", kPluginID);
+  options.uri = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+
+  auto read_time_stamps = [&readable_storage]() {
+      std::vector<int64_t> time_stamps;
+      for (const auto & message : readable_storage->read_next_batch(0)) {
+        time_stamps.push_back(message->time_stamp);
+      }
+      return time_stamps;
+    };
+
+  std::vector<int64_t> all_time_stamps(20);
+  std::iota(all_time_stamps.begin(), all_time_stamps.end(), 1);
+  EXPECT_THAT(read_time_stamps(), ElementsAreArray(all_time_stamps));
+  EXPECT_FALSE(readable_storage->has_next());
+
+  readable_storage->seek(15);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(15, 16, 17, 18, 19, 20));
+
+  // Publish time order merges the partitions
+  ASSERT_TRUE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::PublishedTimestamp, false}));
+  readable_storage->seek(0);
+  EXPECT_THAT(read_time_stamps(), ElementsAreArray(all_time_stamps));
+
+  ASSERT_TRUE(readable_storage->set_read_order({rosbag2_storage::ReadOrder::File, false}));
+  readable_storage->seek(0);
+  EXPECT_THAT(read_time_stamps(), ElementsAreArray(all_time_stamps));
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics.push_back("even");
+  readable_storage->set_filter(storage_filter);
+  ASSERT_TRUE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::ReceivedTimestamp, true}));
+  readable_storage->seek(11);
+  EXPECT_THAT(read_time_stamps(), ElementsAre(10, 8, 6, 4, 2));
+  EXPECT_FALSE(readable_storage->has_next());
+}
+
 TEST_F(StorageTestFixture, get_all_topics_and_types_returns_the_correct_vector) {
   std::unique_ptr<rosbag2_storage::storage_interfaces::ReadWriteInterface> writable_storage =
     std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
@@ -336,6 +794,7 @@ TEST_F(StorageTestFixture, messages_readable_for_prefoxy_db_schema) {
   for (size_t i = 0; i < 3; i++) {
     EXPECT_THAT(deserialize_message(read_messages[i]->serialized_data), Eq(string_messages[i]));
     EXPECT_THAT(read_messages[i]->time_stamp, Eq(std::get<1>(messages[i])));
+    EXPECT_THAT(read_messages[i]->send_timestamp, Eq(std::get<1>(messages[i])));
     EXPECT_THAT(read_messages[i]->topic_name, Eq(topics[i]));
   }
 }
@@ -373,6 +832,9 @@ TEST_F(StorageTestFixture, check_backward_compatibility_with_schema_version_2) {
 
   EXPECT_EQ(readable_storage->get_db_schema_version(), 2);
   EXPECT_TRUE(readable_storage->get_metadata().ros_distro.empty());
+  // Publish times are not stored before schema version 5
+  EXPECT_FALSE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::PublishedTimestamp, false}));
 }
 
 TEST_F(StorageTestFixture, get_metadata_returns_correct_struct_if_no_messages) {
@@ -457,6 +919,89 @@ TEST_F(StorageTestFixture, get_relative_file_path_returns_db_name_with_ext) {
   EXPECT_EQ(append_storage->get_relative_file_path(), storage_filename);
 }
 
+TEST_F(StorageTestFixture, preallocated_bag_file_is_truncated_to_recorded_size_on_close) {
+  const uint64_t max_bagfile_size = 64 * 1024 * 1024;
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  storage_options.storage_id = kPluginID;
+  storage_options.max_bagfile_size = max_bagfile_size;
+  storage_options.preallocate_bagfiles = true;
+  const auto db_filename = storage_options.uri + ".db3";
+
+  std::vector<std::string> string_messages = {"first message", "second message", "third message"};
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>> messages;
+  for (size_t i = 0; i < string_messages.size(); ++i) {
+    messages.emplace_back(
+      string_messages[i], static_cast<int64_t>(i + 1), "topic", "type", "rmw_format");
+  }
+  {
+    auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+    writable_storage->open(storage_options);
+    write_messages_to_sqlite(messages, writable_storage);
+    // Reserved space must not count as recorded data, otherwise the bag would split right away
+    EXPECT_LT(writable_storage->get_bagfile_size(), max_bagfile_size);
+  }
+
+  const auto file_size = rcpputils::fs::path(db_filename).file_size();
+  EXPECT_GT(file_size, 0u);
+  EXPECT_LT(file_size, max_bagfile_size);
+#ifdef __linux__
+  struct stat file_stat;
+  ASSERT_EQ(stat(db_filename.c_str(), &file_stat), 0);
+  EXPECT_LT(static_cast<uint64_t>(file_stat.st_blocks) * 512u, max_bagfile_size);
+#endif
+
+  auto read_messages = read_all_messages_from_sqlite();
+  ASSERT_THAT(read_messages, SizeIs(3));
+  for (size_t i = 0; i < string_messages.size(); ++i) {
+    EXPECT_THAT(deserialize_message(read_messages[i]->serialized_data), Eq(string_messages[i]));
+  }
+}
+
+TEST_F(StorageTestFixture, bagfile_size_is_estimated_from_written_messages) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  writable_storage->open({db_file, kPluginID});
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+  const uint64_t initial_size = writable_storage->get_bagfile_size();
+
+  const std::string payload(1024, 'p');
+  uint64_t previous_size = initial_size;
+  for (int64_t i = 0; i < 500; ++i) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->serialized_data = make_serialized_message(payload);
+    message->time_stamp = i;
+    message->topic_name = "topic1";
+    writable_storage->write(message);
+    // The estimate grows with every message, also between reads of the file size
+    const uint64_t size = writable_storage->get_bagfile_size();
+    EXPECT_GT(size, previous_size);
+    previous_size = size;
+  }
+  EXPECT_GE(previous_size, initial_size + 500u * payload.size());
+  writable_storage.reset();
+
+  const auto file_size = rcpputils::fs::path(db_file + ".db3").file_size();
+  EXPECT_GT(previous_size, file_size / 2);
+  EXPECT_LT(previous_size, file_size * 2);
+}
+
+TEST_F(StorageTestFixture, probe_accepts_only_sqlite_files) {
+  std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
+  string_messages = {std::make_tuple("first message", 1, "topic1", "type1", "rmw1")};
+  write_messages_to_sqlite(string_messages);
+  const auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  const auto other_filename = (rcpputils::fs::path(temporary_dir_path_) / "other.db3").string();
+  {
+    std::ofstream other(other_filename, std::ios::binary);
+    other << "not a sqlite file";
+  }
+
+  const auto storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  EXPECT_TRUE(storage->probe(db_filename));
+  EXPECT_FALSE(storage->probe(other_filename));
+}
+
 TEST_F(StorageTestFixture, loads_config_file) {
   // Check that storage opens with correct sqlite config file
   const auto valid_yaml = "write:\n  pragmas: [\"journal_mode = MEMORY\"]\n";
@@ -507,6 +1052,48 @@ TEST_F(StorageTestFixture, storage_preset_profile_applies_over_defaults) {
   EXPECT_EQ(writable_storage->get_storage_setting("synchronous"), "1");
 }
 
+TEST_F(StorageTestFixture, high_throughput_preset_profile_tunes_page_size_and_wal) {
+  auto temp_dir = rcpputils::fs::path(temporary_dir_path_);
+  const auto storage_uri = (temp_dir / "rosbag").string();
+  rosbag2_storage::StorageOptions options{storage_uri, kPluginID, 0, 0, 0, {}, ""};
+  options.storage_preset_profile = "high_throughput";
+
+  const auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  writable_storage->open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_WRITE);
+
+  // page size has to be applied before the database is switched to WAL mode
+  EXPECT_EQ(writable_storage->get_storage_setting("page_size"), "65536");
+  EXPECT_EQ(writable_storage->get_storage_setting("journal_mode"), "wal");
+  EXPECT_EQ(writable_storage->get_storage_setting("synchronous"), "0");
+  EXPECT_EQ(writable_storage->get_storage_setting("cache_size"), "-65536");
+  EXPECT_EQ(writable_storage->get_storage_setting("wal_autocheckpoint"), "4096");
+
+  write_messages_to_sqlite(
+    {std::make_tuple("message", 1, "topic", "type", "rmw")}, writable_storage);
+  const auto read_messages = read_all_messages_from_sqlite();
+  ASSERT_THAT(read_messages, SizeIs(1));
+  EXPECT_THAT(deserialize_message(read_messages[0]->serialized_data), Eq("message"));
+}
+
+TEST_F(StorageTestFixture, read_only_storage_applies_fast_read_settings) {
+  write_messages_to_sqlite({std::make_tuple("message", 1, "topic", "type", "rmw")});
+  const auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+
+  const auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {db_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  EXPECT_EQ(readable_storage->get_storage_setting("cache_size"), "-65536");
+  EXPECT_EQ(readable_storage->get_storage_setting("temp_store"), "2");
+
+  // configuration file settings take precedence over the read preset
+  const auto config_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  auto options = make_storage_options_with_config(
+    "read:\n  pragmas: [\"cache_size = 1337\"]\n", kPluginID);
+  options.uri = db_filename;
+  config_storage->open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  EXPECT_EQ(config_storage->get_storage_setting("cache_size"), "1337");
+}
+
 TEST_F(StorageTestFixture, throws_on_invalid_pragma_in_config_file) {
   // Check that storage throws on invalid pragma statement in sqlite config
   const auto invalid_yaml = "write:\n  pragmas: [\"unrecognized_pragma_name = 2\"]\n";
@@ -551,6 +1138,225 @@ TEST_F(StorageTestFixture, does_not_throw_on_message_too_big) {
   });
 }
 
+TEST_F(StorageTestFixture, batched_write_stores_all_messages_in_order) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  writable_storage->open({db_file, kPluginID});
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+  writable_storage->create_topic({"topic2", "type2", "rmw2", {}, ""}, {});
+
+  // Not a power of two, so the batch is split over several multi-row statements
+  const size_t message_count = 300;
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+  for (size_t i = 0; i < message_count; ++i) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->serialized_data = make_serialized_message("message " + std::to_string(i));
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+    message->topic_name = i % 2 == 0 ? "topic1" : "topic2";
+    messages.push_back(message);
+  }
+  writable_storage->write(messages);
+  writable_storage.reset();
+
+  auto read_messages = read_all_messages_from_sqlite();
+  ASSERT_THAT(read_messages, SizeIs(message_count));
+  for (size_t i = 0; i < message_count; ++i) {
+    EXPECT_THAT(
+      deserialize_message(read_messages[i]->serialized_data), Eq("message " + std::to_string(i)));
+    EXPECT_THAT(read_messages[i]->time_stamp, Eq(static_cast<rcutils_time_point_value_t>(i)));
+    EXPECT_THAT(read_messages[i]->topic_name, Eq(i % 2 == 0 ? "topic1" : "topic2"));
+  }
+}
+
+TEST_F(StorageTestFixture, durability_policy_groups_batches_into_synced_commits) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  rosbag2_storage::StorageOptions options{
+    (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string(), kPluginID};
+  options.durability_bytes = 1024;
+  writable_storage->open(options);
+  EXPECT_EQ(writable_storage->get_storage_setting("journal_mode"), "wal");
+  EXPECT_EQ(writable_storage->get_storage_setting("synchronous"), "2");
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+
+  auto make_batch = [](size_t message_count, size_t data_size) {
+      std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+      for (size_t i = 0; i < message_count; ++i) {
+        auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+        message->serialized_data = make_serialized_message(std::string(data_size, 'x'));
+        message->topic_name = "topic1";
+        messages.push_back(message);
+      }
+      return messages;
+    };
+  // The batches stay in one open transaction until 1024 bytes were written
+  writable_storage->write(make_batch(2, 100));
+  writable_storage->write(make_batch(2, 100));
+  writable_storage->commit_if_due();
+  EXPECT_THAT(read_all_messages_from_sqlite(), IsEmpty());
+
+  writable_storage->write(make_batch(8, 100));
+  EXPECT_THAT(read_all_messages_from_sqlite(), SizeIs(12));
+}
+
+TEST_F(StorageTestFixture, reads_messages_in_publish_time_order) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  writable_storage->open({db_file, kPluginID});
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+
+  // Received in the order they were written, published in a different order. The message
+  // without publish time is ordered by its receive time.
+  using Times = std::pair<rcutils_time_point_value_t, rcutils_time_point_value_t>;
+  const std::vector<Times> receive_and_send_times = {{10, 5}, {20, 3}, {30, 0}, {40, 8}, {50, 1}};
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+  for (const auto & [receive_time, send_time] : receive_and_send_times) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->serialized_data = make_serialized_message("message");
+    message->time_stamp = receive_time;
+    message->send_timestamp = send_time;
+    message->topic_name = "topic1";
+    messages.push_back(message);
+  }
+  writable_storage->write(messages.front());
+  writable_storage->write({messages.begin() + 1, messages.end()});
+  const auto read_only_filename = writable_storage->get_relative_file_path();
+  writable_storage.reset();
+
+  auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {read_only_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  auto read_times = [&readable_storage]() {
+      std::vector<Times> times;
+      while (readable_storage->has_next()) {
+        auto message = readable_storage->read_next();
+        times.emplace_back(message->time_stamp, message->send_timestamp);
+      }
+      return times;
+    };
+
+  EXPECT_THAT(
+    read_times(),
+    ElementsAre(Times{10, 5}, Times{20, 3}, Times{30, 30}, Times{40, 8}, Times{50, 1}));
+
+  ASSERT_TRUE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::PublishedTimestamp, false}));
+  readable_storage->seek(4);
+  EXPECT_THAT(read_times(), ElementsAre(Times{10, 5}, Times{40, 8}, Times{30, 30}));
+
+  ASSERT_TRUE(
+    readable_storage->set_read_order({rosbag2_storage::ReadOrder::PublishedTimestamp, true}));
+  readable_storage->seek(8);
+  EXPECT_THAT(
+    read_times(), ElementsAre(Times{40, 8}, Times{10, 5}, Times{20, 3}, Times{50, 1}));
+}
+
+TEST_F(StorageTestFixture, reads_messages_in_file_order) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  writable_storage->open({db_file, kPluginID});
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+  for (rcutils_time_point_value_t time_stamp : {30, 10, 20, 50, 40}) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->serialized_data = make_serialized_message("message");
+    message->time_stamp = time_stamp;
+    message->topic_name = "topic1";
+    writable_storage->write(message);
+  }
+  const auto read_only_filename = writable_storage->get_relative_file_path();
+  writable_storage.reset();
+
+  auto readable_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  readable_storage->open(
+    {read_only_filename, kPluginID}, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  auto read_times = [&readable_storage]() {
+      std::vector<rcutils_time_point_value_t> times;
+      while (readable_storage->has_next()) {
+        times.push_back(readable_storage->read_next()->time_stamp);
+      }
+      return times;
+    };
+
+  ASSERT_TRUE(readable_storage->set_read_order({rosbag2_storage::ReadOrder::File, false}));
+  EXPECT_THAT(read_times(), ElementsAre(30, 10, 20, 50, 40));
+
+  // Seeking skips the messages before the time, but keeps the order of the file
+  readable_storage->seek(20);
+  EXPECT_THAT(read_times(), ElementsAre(30, 20, 50, 40));
+
+  ASSERT_TRUE(readable_storage->set_read_order({rosbag2_storage::ReadOrder::File, true}));
+  readable_storage->seek(40);
+  EXPECT_THAT(read_times(), ElementsAre(40, 20, 10, 30));
+}
+
+TEST_F(StorageTestFixture, large_messages_are_stored_in_blob_file) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  writable_storage->open(
+    make_storage_options_with_config("write:\n  external_blob_threshold: 100\n", kPluginID));
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+
+  // Messages above the SQLite limit are stored in the blob file instead of being dropped
+  const size_t artificial_limit = 1000;
+  sqlite3_limit(
+    writable_storage->get_sqlite_database_wrapper().get_database(),
+    SQLITE_LIMIT_LENGTH,
+    static_cast<int>(artificial_limit));
+  const std::vector<std::string> payloads = {
+    "small", std::string(200, 'a'), std::string(artificial_limit + 1, 'b'), "also small",
+    std::string(300, 'c')};
+  auto make_message = [this, &payloads](size_t i) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->serialized_data = make_serialized_message(payloads[i]);
+      message->time_stamp = static_cast<rcutils_time_point_value_t>(i);
+      message->topic_name = "topic1";
+      return message;
+    };
+  writable_storage->write(make_message(0));
+  writable_storage->write(make_message(1));
+  writable_storage->write(
+    std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>>{
+    make_message(2), make_message(3), make_message(4)});
+  writable_storage.reset();
+
+  const auto db_filename = (rcpputils::fs::path(temporary_dir_path_) / "rosbag.db3").string();
+  EXPECT_TRUE(rcpputils::fs::path(db_filename + ".blobs").exists());
+
+  auto read_messages = read_all_messages_from_sqlite();
+  ASSERT_THAT(read_messages, SizeIs(payloads.size()));
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    EXPECT_THAT(deserialize_message(read_messages[i]->serialized_data), Eq(payloads[i]));
+  }
+
+  auto options = make_storage_options_with_config("read:\n  prefetch_size: 64\n", kPluginID);
+  options.uri = db_filename;
+  auto prefetching_storage = std::make_unique<rosbag2_storage_plugins::SqliteStorage>();
+  prefetching_storage->open(options, rosbag2_storage::storage_interfaces::IOFlag::READ_ONLY);
+  for (const auto & payload : payloads) {
+    ASSERT_TRUE(prefetching_storage->has_next());
+    EXPECT_THAT(
+      deserialize_message(prefetching_storage->read_next()->serialized_data), Eq(payload));
+  }
+}
+
+TEST_F(StorageTestFixture, batched_write_keeps_messages_before_unknown_topic) {
+  auto writable_storage = std::make_shared<rosbag2_storage_plugins::SqliteStorage>();
+  const auto db_file = (rcpputils::fs::path(temporary_dir_path_) / "rosbag").string();
+  writable_storage->open({db_file, kPluginID});
+  writable_storage->create_topic({"topic1", "type1", "rmw1", {}, ""}, {});
+
+  std::vector<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> messages;
+  for (const auto & topic_name : {"topic1", "topic1", "unknown_topic", "topic1"}) {
+    auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+    message->serialized_data = make_serialized_message("message");
+    message->time_stamp = static_cast<rcutils_time_point_value_t>(messages.size());
+    message->topic_name = topic_name;
+    messages.push_back(message);
+  }
+  EXPECT_THROW(writable_storage->write(messages), rosbag2_storage_plugins::SqliteException);
+  writable_storage.reset();
+
+  EXPECT_THAT(read_all_messages_from_sqlite(), SizeIs(2));
+}
+
 TEST_F(StorageTestFixture, read_next_returns_filtered_messages_regex) {
   std::vector<std::tuple<std::string, int64_t, std::string, std::string, std::string>>
   string_messages =
@@ -591,6 +1397,9 @@ TEST_F(StorageTestFixture, read_next_returns_filtered_messages_regex) {
   EXPECT_TRUE(readable_storage2->has_next());
   auto fourth_message = readable_storage2->read_next();
   EXPECT_THAT(fourth_message->topic_name, Eq("topic2"));
+  // Messages of the same topic share its interned name, also across storages
+  EXPECT_THAT(fourth_message->interned_topic, NotNull());
+  EXPECT_THAT(fourth_message->interned_topic, Eq(first_message->interned_topic));
   EXPECT_TRUE(readable_storage2->has_next());
   auto fifth_message = readable_storage2->read_next();
   EXPECT_THAT(fifth_message->topic_name, Eq("topic3"));
@@ -637,6 +1446,9 @@ TEST_F(StorageTestFixture, read_next_returns_filtered_messages_topics_regex_to_e
   EXPECT_TRUE(readable_storage2->has_next());
   auto fourth_message = readable_storage2->read_next();
   EXPECT_THAT(fourth_message->topic_name, Eq("topic2"));
+  // Messages of the same topic share its interned name, also across storages
+  EXPECT_THAT(fourth_message->interned_topic, NotNull());
+  EXPECT_THAT(fourth_message->interned_topic, Eq(first_message->interned_topic));
   EXPECT_TRUE(readable_storage2->has_next());
   auto fifth_message = readable_storage2->read_next();
   EXPECT_THAT(fifth_message->topic_name, Eq("topic3"));
@@ -656,6 +1468,14 @@ TEST(StoragePresetProfileValidation, parse_storage_preset_profile_works) {
     rosbag2_storage_plugins::SqliteStorage::parse_preset_profile("resilient"),
     rosbag2_storage_plugins::SqliteStorage::PresetProfile::Resilient
   );
+  EXPECT_EQ(
+    rosbag2_storage_plugins::SqliteStorage::parse_preset_profile("high_throughput"),
+    rosbag2_storage_plugins::SqliteStorage::PresetProfile::HighThroughput
+  );
+  EXPECT_EQ(
+    rosbag2_storage_plugins::SqliteStorage::parse_preset_profile("fast_read"),
+    rosbag2_storage_plugins::SqliteStorage::PresetProfile::FastRead
+  );
   EXPECT_THROW(
     rosbag2_storage_plugins::SqliteStorage::parse_preset_profile("anything"),
     std::runtime_error);
@@ -81,6 +81,20 @@ TEST_F(SqliteWrapperTestFixture, reuse_prepared_statement) {
   ASSERT_THAT(std::get<0>(*row_iter), Eq(2));
 }
 
+TEST_F(SqliteWrapperTestFixture, cached_statement_is_prepared_once) {
+  db_.prepare_statement("CREATE TABLE test (col INTEGER);")->execute_and_reset();
+
+  const std::string insert = "INSERT INTO test (col) VALUES (?), (?);";
+  auto statement = db_.prepare_cached_statement(insert);
+  statement->bind(1, 2)->execute_and_reset();
+  EXPECT_EQ(db_.prepare_cached_statement(insert), statement);
+  db_.prepare_cached_statement(insert)->bind(3, 4)->execute_and_reset();
+  EXPECT_NE(db_.prepare_cached_statement("SELECT COUNT(*) FROM test;"), statement);
+
+  auto row_iter = db_.prepare_statement("SELECT COUNT(*) FROM test;")->execute_query<int>().begin();
+  ASSERT_THAT(std::get<0>(*row_iter), Eq(4));
+}
+
 TEST_F(SqliteWrapperTestFixture, all_result_rows_are_available) {
   db_.prepare_statement("CREATE TABLE test (col INTEGER);")->execute_and_reset();
   db_.prepare_statement("INSERT INTO test (col) VALUES (1);")->execute_and_reset();
@@ -170,3 +184,21 @@ TEST_F(SqliteWrapperTestFixture, table_exists) {
   EXPECT_TRUE(db_.table_exists("test_table"));
   EXPECT_FALSE(db_.table_exists("non_existent_table"));
 }
+
+TEST_F(SqliteWrapperTestFixture, read_blob_reads_whole_blob_of_row) {
+  db_.prepare_statement("CREATE TABLE test_table (id INTEGER PRIMARY KEY, data BLOB);")
+  ->execute_and_reset();
+  const std::string msg_content(1024 * 1024, 'x');
+  db_.prepare_statement("INSERT INTO test_table (data) VALUES (?);")
+  ->bind(make_serialized_message(msg_content))->execute_and_reset();
+  const auto row_id = static_cast<int64_t>(db_.get_last_insert_id());
+  const auto size = static_cast<size_t>(std::get<0>(
+      db_.prepare_statement("SELECT length(data) FROM test_table;")
+      ->execute_query<int>().get_single_line()));
+
+  auto blob = db_.read_blob("test_table", "data", row_id, size);
+  EXPECT_THAT(deserialize_message(blob), Eq(msg_content));
+  EXPECT_THROW(
+    db_.read_blob("test_table", "data", row_id + 1, size),
+    rosbag2_storage_plugins::SqliteException);
+}
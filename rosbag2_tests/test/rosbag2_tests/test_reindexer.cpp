@@ -160,6 +160,26 @@ TEST_P(ReindexTestFixture, test_multiple_files) {
   }
 }
 
+TEST_P(ReindexTestFixture, test_files_are_aggregated_in_file_order) {
+  // More files than most machines have hardware threads, so workers are handed several files
+  create_test_bag(4, 40);
+
+  rosbag2_storage::MetadataIo metadata_io{};
+  rosbag2_cpp::Reindexer reindexer{};
+  rosbag2_storage::StorageOptions storage_options{};
+  storage_options.uri = root_bag_path_.string();
+  reindexer.reindex(storage_options);
+
+  auto generated_metadata = metadata_io.read_metadata(root_bag_path_.string());
+  EXPECT_EQ(generated_metadata.relative_file_paths, original_metadata_.relative_file_paths);
+  EXPECT_EQ(generated_metadata.message_count, original_metadata_.message_count);
+  EXPECT_EQ(generated_metadata.starting_time, original_metadata_.starting_time);
+  ASSERT_THAT(generated_metadata.topics_with_message_count, SizeIs(1));
+  EXPECT_EQ(
+    generated_metadata.topics_with_message_count[0].message_count,
+    original_metadata_.message_count);
+}
+
 INSTANTIATE_TEST_SUITE_P(
   ParametrizedReindexerTests,
   ReindexTestFixture,
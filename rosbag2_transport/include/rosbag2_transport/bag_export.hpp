@@ -0,0 +1,61 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__BAG_EXPORT_HPP_
+#define ROSBAG2_TRANSPORT__BAG_EXPORT_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/storage_options.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+struct ExportOptions
+{
+  /// Directory to write the Parquet files to, one per topic. Created if it does not exist.
+  std::string output_directory;
+  /// Topics to export. All topics are exported if empty.
+  std::vector<std::string> topics;
+  /// Maximum number of rows of a row group of the Parquet files.
+  size_t row_group_size = 64 * 1024;
+  /// Compression codec of the Parquet files, e.g. "uncompressed", "snappy" or "zstd".
+  std::string compression = "snappy";
+};
+
+/// Export the messages of a bag into Parquet files for columnar analytics.
+///
+/// Every message is flattened into one row of the file of its topic: a "timestamp" column with
+/// the receive time stamp of the message in nanoseconds, followed by one column per primitive
+/// field of the message type and its nested messages, named by the path of the field, e.g.
+/// "header.stamp.sec". Arrays and strings are not exported.
+/// The topics are flattened and written concurrently, each on a thread of its own.
+/// Topics whose message type is not available on the system are skipped with a warning.
+///
+/// Output files are named after their topic, without the leading slash and with slashes
+/// replaced by dots, e.g. "camera.info.parquet" for "/camera/info".
+///
+/// \param input_options Settings to create a Reader for the bag to export
+/// \param export_options Settings of the Parquet files
+/// \throws std::runtime_error if rosbag2_transport was built without Apache Arrow and Parquet,
+///   or if a Parquet file cannot be written.
+ROSBAG2_TRANSPORT_PUBLIC
+void bag_export(
+  const rosbag2_storage::StorageOptions & input_options,
+  const ExportOptions & export_options);
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__BAG_EXPORT_HPP_
@@ -39,7 +39,9 @@ namespace rosbag2_transport
 /// \param input_options vector of settings to create Readers for bags to read messages from
 /// \param output_bags - full "recording" configuration of the bag(s) to write messages to
 ///   Each output bag will be passed messages from every input bag,
-///   on topics that pass its filtering settings
+///   on topics that pass its filtering settings.
+///   Output bags with RecordOptions::time_slices greater than 1 are converted after the other
+///   ones, in slices of time which are read and written concurrently.
 ROSBAG2_TRANSPORT_PUBLIC
 void bag_rewrite(
   const std::vector<rosbag2_storage::StorageOptions> & input_options,
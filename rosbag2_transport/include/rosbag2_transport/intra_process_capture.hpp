@@ -0,0 +1,162 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__INTRA_PROCESS_CAPTURE_HPP_
+#define ROSBAG2_TRANSPORT__INTRA_PROCESS_CAPTURE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "rclcpp/node.hpp"
+#include "rclcpp/publisher.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_transport
+{
+
+/**
+ * Process wide hand-over of messages from publishers to recorders running in the same process,
+ * e.g. composed into the same component container.
+ *
+ * A recorder with RecordOptions::intra_process_capture adds a sink for every topic it records.
+ * Publishers which publish through a CapturingPublisher hand their messages serialized to the
+ * sinks of their topic, on the thread which publishes them, instead of the recorder receiving
+ * them through the middleware.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC IntraProcessCapture
+{
+public:
+  using Sink = std::function<void (std::shared_ptr<const rclcpp::SerializedMessage> message)>;
+
+  /// Removes its sink when destroyed, once no message is being handed to it anymore.
+  class ROSBAG2_TRANSPORT_PUBLIC Registration
+  {
+public:
+    ~Registration();
+
+private:
+    friend class IntraProcessCapture;
+    Registration(std::string topic_name, uint64_t id);
+
+    std::string topic_name_;
+    uint64_t id_;
+  };
+
+  static IntraProcessCapture & instance();
+
+  /// Add a sink for the messages of the fully qualified topic_name.
+  std::unique_ptr<Registration> add_sink(const std::string & topic_name, Sink sink);
+
+  /// \returns true if a sink takes the messages of topic_name.
+  bool is_captured(const std::string & topic_name) const;
+
+  /// Hand the message to all sinks of topic_name.
+  void capture(
+    const std::string & topic_name, std::shared_ptr<const rclcpp::SerializedMessage> message) const;
+
+private:
+  IntraProcessCapture() = default;
+
+  void remove_sink(const std::string & topic_name, uint64_t id);
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, std::map<uint64_t, Sink>> sinks_;
+  uint64_t next_id_ = 0;
+};
+
+/**
+ * Publisher which hands its messages to the recorders in the same process which capture its
+ * topic, in addition to publishing them.
+ *
+ * Messages are only serialized if a recorder captures the topic. Already serialized messages,
+ * e.g. of a camera driver, are handed over without a copy.
+ */
+template<typename MessageT>
+class CapturingPublisher
+{
+public:
+  using SharedPtr = std::shared_ptr<CapturingPublisher<MessageT>>;
+
+  CapturingPublisher(rclcpp::Node & node, const std::string & topic_name, const rclcpp::QoS & qos)
+  : publisher_(node.create_publisher<MessageT>(topic_name, qos)),
+    topic_name_(publisher_->get_topic_name())
+  {}
+
+  void publish(const MessageT & message)
+  {
+    capture(message);
+    publisher_->publish(message);
+  }
+
+  void publish(std::unique_ptr<MessageT> message)
+  {
+    capture(*message);
+    publisher_->publish(std::move(message));
+  }
+
+  void publish(std::shared_ptr<const rclcpp::SerializedMessage> message)
+  {
+    auto & intra_process_capture = IntraProcessCapture::instance();
+    if (intra_process_capture.is_captured(topic_name_)) {
+      intra_process_capture.capture(topic_name_, message);
+    }
+    publisher_->publish(*message);
+  }
+
+  typename rclcpp::Publisher<MessageT>::SharedPtr get_publisher() const
+  {
+    return publisher_;
+  }
+
+private:
+  void capture(const MessageT & message)
+  {
+    auto & intra_process_capture = IntraProcessCapture::instance();
+    if (!intra_process_capture.is_captured(topic_name_)) {
+      return;
+    }
+    auto serialized_message = std::make_shared<rclcpp::SerializedMessage>();
+    serialization_.serialize_message(&message, serialized_message.get());
+    intra_process_capture.capture(topic_name_, std::move(serialized_message));
+  }
+
+  typename rclcpp::Publisher<MessageT>::SharedPtr publisher_;
+  std::string topic_name_;
+  rclcpp::Serialization<MessageT> serialization_;
+};
+
+}  // namespace rosbag2_transport
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_TRANSPORT__INTRA_PROCESS_CAPTURE_HPP_
@@ -0,0 +1,175 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__INTRA_PROCESS_PLAYBACK_HPP_
+#define ROSBAG2_TRANSPORT__INTRA_PROCESS_PLAYBACK_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+#include "rclcpp/message_info.hpp"
+#include "rclcpp/node.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rmw/types.h"
+#include "rosbag2_transport/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_transport
+{
+
+/**
+ * Process wide hand-over of played messages from players to typed subscribers running in the
+ * same process, e.g. composed into the same component container.
+ *
+ * Subscribers which subscribe through a PlaybackSubscription add themselves for their topic and
+ * message type. A player with PlayOptions::intra_process_playback deserializes each message once
+ * per message type of the subscribers of its topic and hands the same immutable message to all of
+ * them, on the thread which publishes it. It only publishes the message through the middleware if
+ * the topic has other subscribers, whose messages from the player the PlaybackSubscriptions
+ * ignore.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC IntraProcessPlayback
+{
+public:
+  using Deserializer =
+    std::function<std::shared_ptr<const void>(const rclcpp::SerializedMessage & message)>;
+  using Callback = std::function<void (std::shared_ptr<const void> message)>;
+
+  /// Removes its subscriber or publisher when destroyed, once no message is being handed to a
+  /// subscriber anymore.
+  class ROSBAG2_TRANSPORT_PUBLIC Registration
+  {
+public:
+    ~Registration();
+
+private:
+    friend class IntraProcessPlayback;
+    explicit Registration(std::function<void()> remove);
+
+    std::function<void()> remove_;
+  };
+
+  static IntraProcessPlayback & instance();
+
+  /// Add a subscriber for the messages of the fully qualified topic_name, which are deserialized
+  /// by deserializer into messages of the given type.
+  std::unique_ptr<Registration> add_subscriber(
+    const std::string & topic_name, std::type_index type, Deserializer deserializer,
+    Callback callback);
+
+  /// Add a publisher of a player, whose messages the subscribers take from the player instead.
+  std::unique_ptr<Registration> add_player_publisher(const rmw_gid_t & gid);
+
+  /// \returns true if gid is the publisher of a player added by add_player_publisher.
+  bool is_player_publisher(const rmw_gid_t & gid) const;
+
+  /// Hand the message to all subscribers of topic_name.
+  /// \returns the number of subscribers the message was handed to.
+  size_t deliver(const std::string & topic_name, const rclcpp::SerializedMessage & message) const;
+
+private:
+  IntraProcessPlayback() = default;
+
+  struct Subscriber
+  {
+    std::type_index type;
+    Deserializer deserializer;
+    Callback callback;
+  };
+
+  void remove_subscriber(const std::string & topic_name, uint64_t id);
+  void remove_player_publisher(uint64_t id);
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, std::map<uint64_t, Subscriber>> subscribers_;
+  std::map<uint64_t, rmw_gid_t> player_publishers_;
+  uint64_t next_id_ = 0;
+};
+
+/**
+ * Subscription which takes the messages of the players in the same process from them directly,
+ * deserialized once and shared with the other subscribers of the same type, and all other
+ * messages of its topic through the middleware.
+ *
+ * The messages of players are handed to the callback on the thread of the player, the others on
+ * the executor of the node.
+ */
+template<typename MessageT>
+class PlaybackSubscription
+{
+public:
+  using SharedPtr = std::shared_ptr<PlaybackSubscription<MessageT>>;
+  using Callback = std::function<void (std::shared_ptr<const MessageT> message)>;
+
+  PlaybackSubscription(
+    rclcpp::Node & node, const std::string & topic_name, const rclcpp::QoS & qos,
+    Callback callback)
+  {
+    subscription_ = node.create_subscription<MessageT>(
+      topic_name, qos,
+      [callback](std::shared_ptr<const MessageT> message, const rclcpp::MessageInfo & info) {
+        if (!IntraProcessPlayback::instance().is_player_publisher(
+          info.get_rmw_message_info().publisher_gid))
+        {
+          callback(std::move(message));
+        }
+      });
+    registration_ = IntraProcessPlayback::instance().add_subscriber(
+      subscription_->get_topic_name(), std::type_index(typeid(MessageT)),
+      [](const rclcpp::SerializedMessage & serialized_message) {
+        static const rclcpp::Serialization<MessageT> serialization;
+        auto message = std::make_shared<MessageT>();
+        serialization.deserialize_message(&serialized_message, message.get());
+        return std::shared_ptr<const void>(std::move(message));
+      },
+      [callback](std::shared_ptr<const void> message) {
+        callback(std::static_pointer_cast<const MessageT>(std::move(message)));
+      });
+  }
+
+  typename rclcpp::Subscription<MessageT>::SharedPtr get_subscription() const
+  {
+    return subscription_;
+  }
+
+private:
+  typename rclcpp::Subscription<MessageT>::SharedPtr subscription_;
+  // Destroyed first, so that the callback is not called from a player anymore
+  std::unique_ptr<IntraProcessPlayback::Registration> registration_;
+};
+
+}  // namespace rosbag2_transport
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_TRANSPORT__INTRA_PROCESS_PLAYBACK_HPP_
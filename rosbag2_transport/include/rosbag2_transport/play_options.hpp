@@ -24,6 +24,8 @@
 #include "keyboard_handler/keyboard_handler.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rosbag2_storage/yaml.hpp"
+#include "rosbag2_transport/topic_decimation.hpp"
+#include "rosbag2_transport/topic_publish_policy.hpp"
 #include "rosbag2_transport/visibility_control.hpp"
 
 namespace rosbag2_transport
@@ -34,6 +36,8 @@ struct PlayOptions
 public:
   size_t read_ahead_queue_size = 1000;
   std::string node_prefix = "";
+  // Speed of playback relative to the bag time. A negative rate plays the bag backwards in
+  // time, starting at its end or at the end of playback.
   float rate = 1.0;
 
   // Topic names to whitelist when playing a bag.
@@ -55,6 +59,16 @@ public:
   bool loop = false;
   std::vector<std::string> topic_remapping_options = {};
 
+  // Per topic reduction of the played messages, e.g. to play images at a fifth of their rate
+  // next to full rate /tf. Messages which are not played are dropped when they are read, before
+  // they are queued. max_frequency is measured in bag time.
+  std::unordered_map<std::string, TopicDecimation> topic_decimation{};
+
+  // Per topic deadlines of the publish calls and what to do if they are missed, so that a
+  // subscriber which stops taking the messages of its topic does not hold up the playback of the
+  // other topics. Missed deadlines and dropped messages are counted in the play statistics.
+  std::unordered_map<std::string, TopicPublishPolicy> topic_publish_policies{};
+
   // Rate in Hz at which to publish to /clock.
   // 0 (or negative) means that no publisher will be created
   double clock_publish_frequency = 0.0;
@@ -100,6 +114,99 @@ public:
 
   // Disable to publish as loaned message
   bool disable_loan_message = false;
+
+  // Maximum size of the serialized messages read from storage ahead of time on a separate
+  // thread, in bytes. 0 reads them on the thread which fills the play queue.
+  size_t prefetch_queue_bytes = 0;
+
+  // Maximum size of the messages in the play queue, in bytes. If not 0, it bounds the queue
+  // instead of read_ahead_queue_size, which suits bags mixing small and large messages.
+  size_t read_ahead_queue_bytes = 0;
+
+  // Number of threads publishing the messages, each for a part of the topics so that the
+  // messages of a topic keep their order. 0 publishes them on the playback thread.
+  size_t publishing_threads = 0;
+
+  // Time before the publish time of each message which the playback thread spends spinning
+  // instead of sleeping, in nanoseconds, to publish more precisely than it would be woken up.
+  // 0 sleeps until the publish time.
+  int64_t precise_timing_spin_duration = 0;
+
+  // Real-time priority of the playback thread. 0 keeps the default scheduling policy.
+  // Only supported on Linux.
+  int playback_thread_priority = 0;
+
+  // Real-time scheduling policy of the playback thread, "fifo" or "rr", used if
+  // playback_thread_priority is set.
+  std::string playback_thread_policy = "fifo";
+
+  // CPUs the playback thread is pinned to. Empty lets it run on any CPU.
+  // Only supported on Linux.
+  std::vector<size_t> playback_thread_cpus = {};
+
+  // Real-time priority, scheduling policy and CPUs of the thread reading messages from storage
+  // into the play queue, like those of the playback thread.
+  int storage_loading_thread_priority = 0;
+  std::string storage_loading_thread_policy = "fifo";
+  std::vector<size_t> storage_loading_thread_cpus = {};
+
+  // Time after the time stamp of a message which is due for publishing, in nanoseconds of
+  // bag time. The messages up to that time stamp are published with it in one wake-up of the
+  // playback thread. 0 still publishes messages with the same time stamp together.
+  int64_t release_window = 0;
+
+  // Publish the messages as fast as the reader and the publishers allow, ignoring their time
+  // stamps and the rate. The clock follows the published messages. If wait_acked_timeout is not
+  // negative, the player waits for the subscribers to acknowledge the messages of a topic
+  // whenever its publisher history is full.
+  bool as_fast_as_possible = false;
+
+  // Time of bag time before the playhead for which played messages are kept in memory, in
+  // nanoseconds. Seeks into them or into the messages read ahead do not access the storage.
+  // 0 keeps no played messages.
+  int64_t seek_history_duration = 0;
+
+  // Number of threads creating the publishers of the topics when the player starts, which
+  // shortens the startup for bags with many topics. 0 or 1 creates them one by one.
+  size_t publisher_creation_threads = 0;
+
+  // Maximum size of the messages kept in memory during the first pass through the bag, in
+  // bytes. If the whole playback fits, loops, seeks and later play() calls replay it from memory
+  // without accessing the storage. 0 keeps no messages.
+  size_t loop_cache_bytes = 0;
+
+  // Read all messages to play into one memory arena when the player is created, and play them
+  // from memory, so that the timing of playback does not depend on the storage.
+  bool preload = false;
+
+  // Maximum size of the preloaded messages, in bytes. If the size estimated from the metadata of
+  // the bag, or the size of the messages read, exceeds it, they are played from storage instead.
+  // 0 does not limit the size.
+  size_t preload_max_bytes = 0;
+
+  // Topic of rosgraph_msgs/msg/Clock steps of an external driver, e.g. a simulator running in
+  // lockstep with playback. If set, the time of playback only advances to the time of each step.
+  // Once all messages up to it were published, the time of the step is published on
+  // ~/step_completed. Empty plays at the rate of the playback clock.
+  std::string step_clock_topic = "";
+
+  // Hand the messages directly to the PlaybackSubscriptions in the same process, deserialized
+  // once per message type, instead of through the middleware. The messages are only published
+  // through the middleware if their topic has other subscribers as well.
+  bool intra_process_playback = false;
+
+  // Publish /clock at clock_publish_frequency on a dedicated thread instead of a timer of the
+  // executor of the player node, so that the updates are not delayed by other callbacks.
+  bool clock_publish_thread = false;
+
+  // SCHED_FIFO priority of the thread publishing /clock if clock_publish_thread is set.
+  // 0 keeps the default scheduling policy. Only supported on Linux.
+  int clock_publish_thread_priority = 0;
+
+  // Interval to publish the timing accuracy of playback, the depth of the play queue, the read
+  // and publish latencies and the starvations of the play queue on the ~/play_statistics topic
+  // of the player, in nanoseconds. 0 disables measuring them.
+  int64_t statistics_publish_interval = 0;
 };
 
 }  // namespace rosbag2_transport
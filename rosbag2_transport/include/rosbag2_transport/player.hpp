@@ -116,6 +116,24 @@ public:
     const std::string & node_name = "rosbag2_player",
     const rclcpp::NodeOptions & node_options = rclcpp::NodeOptions());
 
+  /// \brief Constructor which will construct Player class playing several bags merged by time,
+  /// with default KeyboardHandler class.
+  /// \note The bags are played from one clock and one playback thread, see
+  /// ReaderWriterFactory::make_reader() of several bags.
+  /// \param storage_options Storage options of the bags. get_storage_options() returns the
+  /// storage options of the first bag.
+  /// \param play_options Playback settings for Player class.
+  /// \param node_name Name for the underlying node.
+  /// \param node_options Node options which will be used during construction of the underlying
+  /// node.
+  /// \throws std::invalid_argument if there are no bags.
+  ROSBAG2_TRANSPORT_PUBLIC
+  Player(
+    const std::vector<rosbag2_storage::StorageOptions> & storage_options,
+    const rosbag2_transport::PlayOptions & play_options,
+    const std::string & node_name = "rosbag2_player",
+    const rclcpp::NodeOptions & node_options = rclcpp::NodeOptions());
+
   /// \brief Constructor which will construct Player class with provided parameters and default
   /// KeyboardHandler class initialized with parameter which is disabling signal handlers in it.
   /// \param reader Unique pointer to the rosbag2_cpp::Reader class which will be moved to the
@@ -213,7 +231,8 @@ public:
   /// \param num_messages The number of messages to burst from the queue. Specifying zero means no
   /// limit (i.e. burst the entire bag).
   /// \details This call will play the next \p num_messages from the queue in burst mode. The
-  /// timing of the messages is ignored.
+  /// timing of the messages is ignored, and the clock is moved to the time stamp of the last
+  /// message once the burst is done.
   /// \note If internal player queue is starving and storage has not been completely loaded,
   /// this method will wait until new element will be pushed to the queue.
   /// \return The number of messages that was played.
@@ -253,6 +272,8 @@ public:
   /// \brief Delete pre or post on play message callback from internal player lists.
   /// \param handle Callback's handle returned from #add_on_play_message_pre_callback or
   /// #add_on_play_message_post_callback
+  /// \note Waits for calls of the deleted callback in progress on other threads to return, so
+  /// that it is not called anymore once this returns. May be called from within a callback.
   ROSBAG2_TRANSPORT_PUBLIC
   void delete_on_play_message_callback(const callback_handle_t & handle);
 
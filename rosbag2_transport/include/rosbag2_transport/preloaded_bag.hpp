@@ -0,0 +1,94 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__PRELOADED_BAG_HPP_
+#define ROSBAG2_TRANSPORT__PRELOADED_BAG_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rcutils/time.h"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+
+/**
+ * The messages of a bag held in one contiguous arena, for playback without storage access.
+ *
+ * The payloads are appended to the arena back to back. Each message is indexed by the offset and
+ * length of its payload, its time stamps and its topic, whose name is interned. Messages are
+ * handed out with their payload viewing the arena, which they keep alive.
+ *
+ * Messages have to be added in the order of their time stamps, which is the order a reader
+ * returns them in. Not thread safe. The player adds all messages before playback starts and
+ * takes them under its reader mutex.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC PreloadedBag
+{
+public:
+  /// max_bytes bounds the size_in_bytes(). A value of 0 does not bound it.
+  explicit PreloadedBag(size_t max_bytes = 0);
+
+  /// Reserve the arena for bytes of payloads, e.g. as estimated from the metadata of the bag,
+  /// so that it is not copied while it grows. Must be called before messages are taken.
+  void reserve(size_t bytes);
+
+  /// Copy the payload of message into the arena. The topic_id of message is kept.
+  /// Must not be called after messages were taken, since growing the arena moves it.
+  /// \returns false, without adding the message, if it would exceed max_bytes.
+  bool add(const rosbag2_storage::SerializedBagMessage & message);
+
+  /// \returns the number of messages.
+  size_t size() const;
+
+  /// \returns the memory taken by the payloads, the index and the topic names, in bytes.
+  size_t size_in_bytes() const;
+
+  /// \returns the index of the first message with a time stamp of at least time_point, or
+  /// size() if there is none.
+  size_t find(rcutils_time_point_value_t time_point) const;
+
+  /// \returns the message at index, with its payload viewing the arena.
+  rosbag2_storage::SerializedBagMessageSharedPtr get(size_t index) const;
+
+private:
+  struct Entry
+  {
+    rcutils_time_point_value_t time_stamp;
+    rcutils_time_point_value_t send_timestamp;
+    uint64_t sequence_number;
+    uint64_t offset;
+    uint64_t length;
+    // Index into topic_names_
+    uint32_t topic_index;
+    uint32_t topic_id;
+  };
+
+  size_t max_bytes_;
+  std::shared_ptr<std::vector<uint8_t>> arena_;
+  std::vector<Entry> entries_;
+  std::vector<std::string> topic_names_;
+  std::unordered_map<std::string, uint32_t> topic_indices_;
+  size_t topic_names_bytes_ = 0;
+};
+
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__PRELOADED_BAG_HPP_
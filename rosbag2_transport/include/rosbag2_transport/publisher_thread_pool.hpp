@@ -0,0 +1,83 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__PUBLISHER_THREAD_POOL_HPP_
+#define ROSBAG2_TRANSPORT__PUBLISHER_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_transport/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_transport
+{
+
+/// Runs tasks on a fixed number of threads. Tasks queued with the same key, e.g. the messages
+/// of a topic, run one after another on the same thread in the order they were queued.
+class ROSBAG2_TRANSPORT_PUBLIC PublisherThreadPool
+{
+public:
+  explicit PublisherThreadPool(size_t number_of_threads);
+
+  /// Discards the tasks which did not start yet and joins the threads.
+  virtual ~PublisherThreadPool();
+
+  PublisherThreadPool(const PublisherThreadPool &) = delete;
+  PublisherThreadPool & operator=(const PublisherThreadPool &) = delete;
+
+  /// Queue a task on the thread of its key without waiting for the tasks queued before.
+  void queue(const std::string & key, std::function<void()> task);
+
+  /// Wait until all tasks queued so far have finished.
+  void wait_for_queued_tasks();
+
+  size_t get_number_of_threads() const;
+
+private:
+  struct Worker
+  {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> tasks;
+    bool running_task = false;
+    bool stop = false;
+    std::thread thread;
+  };
+
+  void run(Worker & worker);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace rosbag2_transport
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_TRANSPORT__PUBLISHER_THREAD_POOL_HPP_
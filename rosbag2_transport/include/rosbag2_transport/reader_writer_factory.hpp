@@ -15,7 +15,9 @@
 #ifndef ROSBAG2_TRANSPORT__READER_WRITER_FACTORY_HPP_
 #define ROSBAG2_TRANSPORT__READER_WRITER_FACTORY_HPP_
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "rosbag2_cpp/reader.hpp"
 #include "rosbag2_cpp/writer.hpp"
@@ -28,9 +30,30 @@ namespace rosbag2_transport
 class ROSBAG2_TRANSPORT_PUBLIC ReaderWriterFactory
 {
 public:
-  /// Create a Reader with the appropriate underlying implementation.
+  /**
+   * Create a Reader with the appropriate underlying implementation.
+   *
+   * \param storage_options Options of the bag to read.
+   * \param prefetch_queue_bytes If not 0, messages are read ahead on a background thread
+   * until their serialized data reaches this size, see rosbag2_cpp::readers::PrefetchingReader.
+   */
   static std::unique_ptr<rosbag2_cpp::Reader> make_reader(
-    const rosbag2_storage::StorageOptions & storage_options);
+    const rosbag2_storage::StorageOptions & storage_options,
+    size_t prefetch_queue_bytes = 0);
+
+  /**
+   * Create a Reader of several bags, which merges their messages by time.
+   *
+   * \param storage_options Options of the bags to read.
+   * \param prefetch_queue_bytes Each bag is read ahead on its own background thread until the
+   * serialized data of its messages reaches this size, or a default size if 0. A single bag
+   * is read like by make_reader() of its storage options.
+   * \throws std::invalid_argument if there are no bags.
+   * \see rosbag2_cpp::readers::MultiBagReader
+   */
+  static std::unique_ptr<rosbag2_cpp::Reader> make_reader(
+    const std::vector<rosbag2_storage::StorageOptions> & storage_options,
+    size_t prefetch_queue_bytes = 0);
 
   /// Create a Writer with the appropriate underlying implementation.
   static std::unique_ptr<rosbag2_cpp::Writer> make_writer(
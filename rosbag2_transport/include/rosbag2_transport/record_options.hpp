@@ -16,6 +16,7 @@
 #define ROSBAG2_TRANSPORT__RECORD_OPTIONS_HPP_
 
 #include <chrono>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -23,10 +24,28 @@
 #include "keyboard_handler/keyboard_handler.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rosbag2_storage/yaml.hpp"
+#include "rosbag2_transport/topic_decimation.hpp"
 #include "rosbag2_transport/visibility_control.hpp"
 
 namespace rosbag2_transport
 {
+// Route of the topics matching topics_regex into a sub-bag of the recorded bag, which is written
+// by its own writer with its own message cache, compression and split policy.
+struct TopicRoute
+{
+  // Name of the sub-bag, which is a directory in the bag directory
+  std::string name;
+  std::string topics_regex;
+  // Compression of the sub-bag. "" takes the compression of the bag, compression_mode "none"
+  // records the sub-bag uncompressed.
+  std::string compression_format = "";
+  std::string compression_mode = "";
+  // Split policy and message cache size of the sub-bag. Unset takes those of the bag.
+  std::optional<uint64_t> max_bagfile_size;
+  std::optional<uint64_t> max_bagfile_duration;
+  std::optional<uint64_t> max_cache_size;
+};
+
 struct RecordOptions
 {
 public:
@@ -43,18 +62,126 @@ public:
   uint64_t compression_queue_size = 1;
   uint64_t compression_threads = 0;
   int32_t compression_threads_priority = 0;
+  uint64_t compression_dictionary_training_messages = 0;
+  std::string compression_dictionary = "";
+  bool compression_adaptive_level = false;
+  int32_t compression_min_level = -5;
+  int32_t compression_max_level = 1;
+  // Whether messages are compressed in the message mode: "always", "never", or "auto" to stop
+  // compressing topics whose first compression_probe_messages messages compressed to more than
+  // compression_skip_ratio of their size. compression_topic_policies overrides it per topic.
+  std::string compression_policy = "always";
+  std::unordered_map<std::string, std::string> compression_topic_policies{};
+  uint64_t compression_probe_messages = 8;
+  double compression_skip_ratio = 0.95;
+  // Worker threads each file is compressed with in the file mode, 0 for none
+  uint64_t compression_file_workers = 0;
+  // Lower the I/O priority of the threads compressing files in the file mode to the idle class,
+  // so that reading back closed files yields to the recording. Linux only.
+  bool compression_file_idle_io = false;
+  // Files compressed at the same time in the file mode, 0 for one per compression thread
+  uint64_t compression_file_max_concurrent = 0;
+  // Bytes per second the file mode reads from the files it compresses while the message cache
+  // is filled to compression_file_throttle_cache_fill or more, 0 never throttles
+  uint64_t compression_file_read_bandwidth = 0;
+  double compression_file_throttle_cache_fill = 0.5;
   std::unordered_map<std::string, rclcpp::QoS> topic_qos_profile_overrides{};
   bool include_hidden_topics = false;
   bool include_unpublished_topics = false;
   bool ignore_leaf_topics = false;
   bool start_paused = false;
   bool use_sim_time = false;
+  // Record the publish time and the publisher sequence number of messages, as reported by the
+  // middleware. Storage plugins which support it write them along with the receive time.
+  bool record_publish_info = false;
+  // Take the time stamps of messages from the receive time reported by the middleware instead
+  // of the clock of the node. Messages which the middleware reports no receive time for are
+  // stamped with the steady clock, offset to the system time. Not compatible with use_sim_time.
+  bool use_receive_timestamp = false;
+  // Number of written messages per topic whose buffers are kept to take the next messages into,
+  // instead of allocating a buffer for every message. 0 allocates every message.
+  uint64_t message_buffer_pool_size = 0;
+  // Bytes reserved up front on huge pages for the buffers of received messages, which stay in
+  // the message cache until they are written. Buffers beyond it are allocated as usual.
+  // 0 allocates every buffer as usual.
+  uint64_t message_buffer_arena_size = 0;
+  // NUMA node the message buffer arena is bound to. The cache consumer thread is pinned to the
+  // CPUs of the node, unless cache_consumer_thread_cpus of the storage options are set. -1 binds
+  // the arena to no node.
+  int32_t message_buffer_numa_node = -1;
+  // Number of threads of the executor which runs the subscription callbacks of ros2 bag record.
+  // More than one thread only takes messages in parallel if the subscriptions are in several
+  // callback groups.
+  uint64_t executor_threads = 1;
+  // Partitioning of the subscriptions into mutually exclusive callback groups. "" subscribes all
+  // topics in the default callback group of the node, "topic" puts every
+  // topics_per_callback_group topics into a group of their own and "qos" groups the topics by
+  // reliability and durability of their subscription.
+  std::string callback_groups = "";
+  uint64_t topics_per_callback_group = 1;
+  // Number of threads querying the publishers of the discovered topics and creating their
+  // subscriptions, which shortens the start of recordings with many topics. 0 or 1 subscribes
+  // the topics one by one.
+  uint64_t subscription_creation_threads = 0;
+  // Number of writers which write the split files of an output bag of bag_rewrite concurrently.
+  // The messages are handed to the writers in segments of max_bagfile_duration and
+  // max_bagfile_size. Only used if the output bag is split, and not used for recording.
+  uint64_t split_writers = 1;
+  // Number of time slices which an output bag of bag_rewrite is converted in concurrently. Every
+  // slice is read by readers of its own and written by a writer of its own, the files of the
+  // slices are merged into the output bag. Slices start at input files if the inputs have enough
+  // files. Not used for recording.
+  uint64_t time_slices = 1;
+  // Interval to publish the latency histograms and queue depths of the record pipeline on the
+  // ~/record_statistics topic of the recorder. The statistics are also logged when the recording
+  // stops. 0 disables measuring them.
+  std::chrono::milliseconds pipeline_statistics_interval{0};
+  // Directories, e.g. on separate disks, to stripe the recorded bag over. Every directory gets a
+  // bag of its own, written by its own writer, and the metadata of the bag lists their files.
+  // Empty records into the bag directory only. Not compatible with compression.
+  std::vector<std::string> stripe_directories;
+  // Assignment of messages to stripes: "topic" writes all messages of a topic to one stripe and
+  // "batch" writes batches of stripe_batch_size bytes of messages to the stripes in turns.
+  std::string stripe_by = "topic";
+  uint64_t stripe_batch_size = 4 * 1024 * 1024;
+  // Shards of the bag within the bag directory, each written to files of its own by its own
+  // writer thread and assigned messages by stripe_by like stripes. 0 and 1 write a single shard.
+  // Not compatible with stripe_directories and compression.
+  uint64_t writer_shards = 1;
+  // Command run in the background for every closed file of the bag, e.g. to upload it to an
+  // object storage while the recording continues. {file} is replaced with the path of the file
+  // and {key} with the name of the bag directory and the file. Empty does not upload files.
+  std::string upload_command = "";
+  // Average upload rate in bytes per second. 0 does not limit the rate.
+  uint64_t upload_max_bandwidth = 0;
+  // File listing the files not uploaded yet, which are uploaded first by the next recording
+  // with the same journal. Empty does not keep a journal.
+  std::string upload_journal = "";
+  // Per topic reduction of the recorded messages. Messages which are not recorded are dropped in
+  // the subscription callback, before the writer copies or caches them.
+  std::unordered_map<std::string, TopicDecimation> topic_decimation{};
+  // Take the messages of publishers in the same process, which publish through a
+  // CapturingPublisher, directly from the publisher instead of through the middleware. Messages
+  // of other publishers in the same process are not recorded.
+  bool intra_process_capture = false;
+  // Routes of topics into sub-bags of the bag, e.g. to record camera images apart from
+  // telemetry. A topic is recorded into the sub-bag of the first route it matches, topics which
+  // match no route into the sub-bag "default". Empty records all topics into the bag itself.
+  // Not compatible with stripe_directories and writer_shards.
+  std::vector<TopicRoute> topic_routes;
 };
 
 }  // namespace rosbag2_transport
 
 namespace YAML
 {
+template<>
+struct ROSBAG2_TRANSPORT_PUBLIC convert<rosbag2_transport::TopicRoute>
+{
+  static Node encode(const rosbag2_transport::TopicRoute & route);
+  static bool decode(const Node & node, rosbag2_transport::TopicRoute & route);
+};
+
 template<>
 struct ROSBAG2_TRANSPORT_PUBLIC convert<rosbag2_transport::RecordOptions>
 {
@@ -0,0 +1,116 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__RECYCLING_GENERIC_SUBSCRIPTION_HPP_
+#define ROSBAG2_TRANSPORT__RECYCLING_GENERIC_SUBSCRIPTION_HPP_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/generic_subscription.hpp"
+#include "rclcpp/node.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rosbag2_cpp/typesupport_helpers.hpp"
+#include "rosbag2_storage/buffer_pool.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_transport
+{
+
+/// GenericSubscription which takes messages into recycled buffers.
+///
+/// The recorder keeps the serialized messages of a GenericSubscription until they are written
+/// to storage, after which their buffers are freed. This subscription keeps up to
+/// max_free_messages of the written messages instead, and the middleware takes the next
+/// messages into their buffers. Large messages, e.g. camera images, then are not allocated and
+/// faulted in again for every message. Messages may be released on any thread.
+class ROSBAG2_TRANSPORT_PUBLIC RecyclingGenericSubscription : public rclcpp::GenericSubscription
+{
+public:
+  RecyclingGenericSubscription(
+    rclcpp::node_interfaces::NodeBaseInterface * node_base,
+    const std::shared_ptr<rcpputils::SharedLibrary> ts_lib,
+    const std::string & topic_name,
+    const std::string & topic_type,
+    const rclcpp::QoS & qos,
+    rclcpp::AnySubscriptionCallback<rclcpp::SerializedMessage, std::allocator<void>> callback,
+    const rclcpp::SubscriptionOptions & options,
+    size_t max_free_messages,
+    std::shared_ptr<rosbag2_storage::BufferPool> buffer_pool = nullptr);
+
+  std::shared_ptr<rclcpp::SerializedMessage> create_serialized_message() override;
+
+  void return_serialized_message(std::shared_ptr<rclcpp::SerializedMessage> & message) override;
+
+  /// Number of released messages whose buffers are kept for the next messages.
+  size_t get_number_of_free_messages() const;
+
+private:
+  // Shared with the deleters of the messages, which may outlive the subscription
+  struct MessagePool
+  {
+    // Allocates the buffers of new messages, if set. Declared first to outlive the free messages.
+    std::shared_ptr<rosbag2_storage::BufferPool> buffer_pool;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<rclcpp::SerializedMessage>> free_messages;
+    size_t max_free_messages;
+  };
+
+  std::shared_ptr<MessagePool> pool_;
+};
+
+/// Create a RecyclingGenericSubscription and add it to the node, like
+/// rclcpp::Node::create_generic_subscription(), with the shared typesupport library of
+/// rosbag2_cpp::get_typesupport_library().
+template<typename CallbackT>
+std::shared_ptr<RecyclingGenericSubscription> create_recycling_generic_subscription(
+  rclcpp::Node & node,
+  const std::string & topic_name,
+  const std::string & topic_type,
+  const rclcpp::QoS & qos,
+  CallbackT && callback,
+  const rclcpp::SubscriptionOptions & options,
+  size_t max_free_messages,
+  std::shared_ptr<rosbag2_storage::BufferPool> buffer_pool = nullptr)
+{
+  auto ts_lib = rosbag2_cpp::get_typesupport_library(topic_type, "rosidl_typesupport_cpp");
+  rclcpp::AnySubscriptionCallback<rclcpp::SerializedMessage, std::allocator<void>>
+  any_subscription_callback(*options.get_allocator());
+  any_subscription_callback.set(std::forward<CallbackT>(callback));
+
+  auto subscription = std::make_shared<RecyclingGenericSubscription>(
+    node.get_node_base_interface().get(), std::move(ts_lib), topic_name, topic_type, qos,
+    any_subscription_callback, options, max_free_messages, std::move(buffer_pool));
+  node.get_node_topics_interface()->add_subscription(subscription, options.callback_group);
+  return subscription;
+}
+
+}  // namespace rosbag2_transport
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_TRANSPORT__RECYCLING_GENERIC_SUBSCRIPTION_HPP_
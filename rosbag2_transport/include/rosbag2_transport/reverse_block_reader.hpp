@@ -0,0 +1,80 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__REVERSE_BLOCK_READER_HPP_
+#define ROSBAG2_TRANSPORT__REVERSE_BLOCK_READER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "rcutils/time.h"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/serialized_bag_message.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+
+/**
+ * Reads the messages of a bag backwards in time, for reverse playback.
+ *
+ * Reading in reverse order from storage makes plugins seek, or decode chunks, per message.
+ * Instead, the bag is read in blocks of time going backwards: each block is read forward with
+ * one seek, bounded by a time filter, and its messages are then returned in reverse order.
+ * The duration of the blocks adapts to the density of the bag, so that a block holds about
+ * block_messages messages.
+ *
+ * Changes the filter and the position of the reader, which has to outlive this object. Not
+ * thread safe.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC ReverseBlockReader
+{
+public:
+  /// \param reader The reader of the bag.
+  /// \param storage_filter The topics to read. Its time range is replaced for each block.
+  /// \param start_time No messages before this time stamp are read.
+  /// \param block_messages Number of messages a block should hold.
+  ReverseBlockReader(
+    rosbag2_cpp::Reader & reader,
+    const rosbag2_storage::StorageFilter & storage_filter,
+    rcutils_time_point_value_t start_time,
+    size_t block_messages);
+
+  /// Continue backwards from the last message with a time stamp of at most time_point.
+  void seek(rcutils_time_point_value_t time_point);
+
+  bool has_next();
+
+  /// \returns the next message backwards in time. Must only be called if has_next().
+  rosbag2_storage::SerializedBagMessageSharedPtr read_next();
+
+private:
+  // Read the block of messages before block_end_ and adapt the block duration
+  void read_block();
+
+  rosbag2_cpp::Reader & reader_;
+  rosbag2_storage::StorageFilter storage_filter_;
+  rcutils_time_point_value_t start_time_;
+  size_t block_messages_;
+  rcutils_duration_value_t block_duration_;
+  // Messages before this time stamp are not read yet
+  rcutils_time_point_value_t block_end_;
+  // The messages of the current block in forward order, returned from the back
+  std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> block_;
+};
+
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__REVERSE_BLOCK_READER_HPP_
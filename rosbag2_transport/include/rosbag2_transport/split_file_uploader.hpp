@@ -0,0 +1,129 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__SPLIT_FILE_UPLOADER_HPP_
+#define ROSBAG2_TRANSPORT__SPLIT_FILE_UPLOADER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "rosbag2_transport/visibility_control.hpp"
+
+// This is necessary because of using stl types here. It is completely safe, because
+// a) the member is not accessible from the outside
+// b) there are no inline functions.
+#ifdef _WIN32
+# pragma warning(push)
+# pragma warning(disable:4251)
+#endif
+
+namespace rosbag2_transport
+{
+
+/**
+ * Uploads the files of a bag in the background once the writer closed them, e.g. on the
+ * WRITE_SPLIT event, while the recording continues.
+ *
+ * Files are uploaded one after another on a thread of the lowest CPU and IO priority, so that
+ * the upload never takes the disk from the writer. By default, a file is uploaded by running
+ * a command, e.g. `aws s3 cp {file} s3://bucket/{key}`, which takes care of the protocol of
+ * the object storage, e.g. multipart uploads. A failed upload is retried until it succeeds.
+ *
+ * The files which are not uploaded yet are kept in a journal, so that the files still pending
+ * when the process stops are uploaded by the next uploader with the same journal.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC SplitFileUploader
+{
+public:
+  struct Options
+  {
+    /// Command run by a shell for every file. {file} is replaced with the quoted absolute path
+    /// of the file and {key} with the quoted name of its bag directory and the file name.
+    std::string command;
+    /// Average upload rate in bytes per second, enforced by pausing between files.
+    /// 0 does not limit the rate.
+    uint64_t max_bandwidth = 0;
+    /// File listing the files not uploaded yet. Empty does not keep a journal.
+    std::string journal_path;
+    /// Wait before the first retry of a failed upload, doubled for every further retry.
+    std::chrono::milliseconds retry_interval{1000};
+    std::chrono::milliseconds max_retry_interval{300000};
+  };
+
+  /// Uploads file as key. \returns true if the file was uploaded.
+  using UploadFunction = std::function<bool (const std::string & file, const std::string & key)>;
+
+  /**
+   * Start the upload thread with the files left over in the journal.
+   * \param upload Uploads a file. By default, runs options.command.
+   * \throws std::invalid_argument if neither a command nor an upload function is given.
+   */
+  explicit SplitFileUploader(Options options, UploadFunction upload = nullptr);
+
+  /// Calls stop().
+  virtual ~SplitFileUploader();
+
+  SplitFileUploader(const SplitFileUploader &) = delete;
+  SplitFileUploader & operator=(const SplitFileUploader &) = delete;
+
+  /// Queue a closed file for upload.
+  void enqueue(const std::string & file);
+
+  /// Wait until all queued files are uploaded or timeout elapsed.
+  /// \returns true if no files are pending.
+  bool wait_for_uploads(std::chrono::milliseconds timeout);
+
+  /// Terminate the running upload and join the upload thread. Pending files stay in the journal.
+  void stop();
+
+  /// Number of files queued and not uploaded yet.
+  size_t pending_count() const;
+
+  /// Key of a file, made of the name of its bag directory and the file name.
+  static std::string make_key(const std::string & file);
+
+  /// Replace {file} and {key} in command with the shell quoted file and key.
+  static std::string expand_command(
+    const std::string & command, const std::string & file, const std::string & key);
+
+private:
+  void run();
+  bool run_command(const std::string & file, const std::string & key);
+  void write_journal();
+
+  const Options options_;
+  UploadFunction upload_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<std::string> pending_;
+  bool stop_ = false;
+  std::atomic<int64_t> running_process_{0};
+  std::thread thread_;
+};
+
+}  // namespace rosbag2_transport
+
+#ifdef _WIN32
+# pragma warning(pop)
+#endif
+
+#endif  // ROSBAG2_TRANSPORT__SPLIT_FILE_UPLOADER_HPP_
@@ -0,0 +1,47 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__TOPIC_DECIMATION_HPP_
+#define ROSBAG2_TRANSPORT__TOPIC_DECIMATION_HPP_
+
+#include <cstdint>
+
+#include "rosbag2_storage/yaml.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+// Reduction of the messages of a topic which are recorded or played, for topics of which only a
+// part of the messages is needed, e.g. debug images or high rate IMU data.
+struct TopicDecimation
+{
+  // Keep only every n-th message. 1 keeps every message.
+  uint64_t keep_every_n = 1;
+  // Keep at most this many messages per second, measured with the time stamps the messages are
+  // recorded or played with. 0 does not limit the rate.
+  double max_frequency = 0.0;
+};
+}  // namespace rosbag2_transport
+
+namespace YAML
+{
+template<>
+struct ROSBAG2_TRANSPORT_PUBLIC convert<rosbag2_transport::TopicDecimation>
+{
+  static Node encode(const rosbag2_transport::TopicDecimation & decimation);
+  static bool decode(const Node & node, rosbag2_transport::TopicDecimation & decimation);
+};
+}  // namespace YAML
+
+#endif  // ROSBAG2_TRANSPORT__TOPIC_DECIMATION_HPP_
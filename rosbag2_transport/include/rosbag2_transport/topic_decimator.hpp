@@ -0,0 +1,57 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__TOPIC_DECIMATOR_HPP_
+#define ROSBAG2_TRANSPORT__TOPIC_DECIMATOR_HPP_
+
+#include <cstdint>
+
+#include "rcutils/time.h"
+#include "rosbag2_transport/topic_decimation.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+
+/**
+ * Decides which messages of a topic are recorded or played, according to its TopicDecimation.
+ *
+ * Every keep_every_n-th received message passes the count, starting with the first one. Of
+ * those, a message is only kept if at least 1 / max_frequency seconds passed since the last kept
+ * message. If the time jumps back, e.g. because a simulation was restarted, the next message is
+ * kept.
+ *
+ * Not thread safe. The recorder only calls it from the callback of one subscription, which is
+ * never run concurrently with itself, the player while reading the bag.
+ */
+class ROSBAG2_TRANSPORT_PUBLIC TopicDecimator
+{
+public:
+  /// \throws std::invalid_argument if keep_every_n is 0 or max_frequency is negative.
+  explicit TopicDecimator(const TopicDecimation & decimation);
+
+  /// \returns true if the message at time_stamp is to be recorded or played.
+  bool keep(rcutils_time_point_value_t time_stamp);
+
+private:
+  uint64_t keep_every_n_;
+  rcutils_duration_value_t min_period_ = 0;
+  uint64_t received_count_ = 0;
+  bool has_kept_ = false;
+  rcutils_time_point_value_t last_kept_time_stamp_ = 0;
+};
+
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__TOPIC_DECIMATOR_HPP_
@@ -16,9 +16,9 @@
 #define ROSBAG2_TRANSPORT__TOPIC_FILTER_HPP_
 
 #include <map>
+#include <regex>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "rosbag2_transport/record_options.hpp"
@@ -44,23 +44,33 @@ public:
     bool allow_unknown_types = false);
   virtual ~TopicFilter();
 
-  /// Filter all topic_names_and_types via take_topic method, return the resulting filtered set
+  /// Filter all topic_names_and_types via take_topic method, return the resulting filtered set.
+  /// The decisions based on topic names and types are cached, so that repeated filtering of
+  /// the same topics is cheap.
   /// Filtering order is:
-  /// - remove topics with multiple types, unknown type, and hidden topics
   /// - topics list
   /// - exclude regex
   /// - include regex OR "all"
+  /// - remove hidden topics
+  /// - remove unpublished and leaf topics, if requested
+  /// - remove topics with multiple types and unknown type
   std::unordered_map<std::string, std::string> filter_topics(
     const std::map<std::string, std::vector<std::string>> & topic_names_and_types);
 
 private:
   /// Return true if the topic passes all filter criteria
   bool take_topic(const std::string & topic_name, const std::vector<std::string> & topic_types);
+  /// Return true if the topic name passes the topics list, regex and hidden topic criteria.
+  /// These only depend on the name, so that the decision is cached per topic name.
+  bool take_topic_name(const std::string & topic_name);
   bool type_is_known(const std::string & topic_name, const std::string & topic_type);
 
   RecordOptions record_options_;
   bool allow_unknown_types_ = false;
-  std::unordered_set<std::string> already_warned_unknown_types_;
+  std::regex include_regex_;
+  std::regex exclude_regex_;
+  std::unordered_map<std::string, bool> topic_name_decisions_;
+  std::unordered_map<std::string, bool> known_types_;
   rclcpp::node_interfaces::NodeGraphInterface::SharedPtr node_graph_;
 };
 }  // namespace rosbag2_transport
@@ -0,0 +1,53 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__TOPIC_PUBLISH_POLICY_HPP_
+#define ROSBAG2_TRANSPORT__TOPIC_PUBLISH_POLICY_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "rosbag2_storage/yaml.hpp"
+#include "rosbag2_transport/visibility_control.hpp"
+
+namespace rosbag2_transport
+{
+// What the player does if publishing a message of a topic takes longer than a deadline, e.g.
+// because a reliable subscriber stopped taking messages and the history of the publisher is full.
+struct TopicPublishPolicy
+{
+  // Time a publish call of the topic may take, in nanoseconds. 0 disables the policy.
+  int64_t deadline = 0;
+  // "block" waits for the publish call like topics without a policy, only reporting it.
+  // "skip" publishes the messages on a thread of the topic and stops waiting for it at the
+  // deadline. Messages of the topic are skipped while it still publishes an earlier one.
+  // "detach" publishes on a thread of the topic as well, but once a publish call missed its
+  // deadline, the messages of the topic are queued for that thread without waiting, up to the
+  // history depth of the publisher, dropping the oldest ones. The topic waits for its publish
+  // calls again once the thread caught up.
+  std::string overflow = "block";
+};
+}  // namespace rosbag2_transport
+
+namespace YAML
+{
+template<>
+struct ROSBAG2_TRANSPORT_PUBLIC convert<rosbag2_transport::TopicPublishPolicy>
+{
+  static Node encode(const rosbag2_transport::TopicPublishPolicy & policy);
+  static bool decode(const Node & node, rosbag2_transport::TopicPublishPolicy & policy);
+};
+}  // namespace YAML
+
+#endif  // ROSBAG2_TRANSPORT__TOPIC_PUBLISH_POLICY_HPP_
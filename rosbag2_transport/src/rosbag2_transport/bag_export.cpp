@@ -0,0 +1,388 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/bag_export.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef ROSBAG2_TRANSPORT_HAS_PARQUET
+#include "arrow/api.h"
+#include "arrow/io/file.h"
+#include "arrow/util/compression.h"
+#include "parquet/arrow/writer.h"
+#include "parquet/properties.h"
+#endif
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "rosbag2_cpp/field_extractor.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "rosbag2_transport/reader_writer_factory.hpp"
+
+#include "logging.hpp"
+
+namespace
+{
+
+#ifdef ROSBAG2_TRANSPORT_HAS_PARQUET
+
+void check(const arrow::Status & status, const std::string & what)
+{
+  if (!status.ok()) {
+    throw std::runtime_error(what + ": " + status.ToString());
+  }
+}
+
+template<typename T>
+T check(arrow::Result<T> result, const std::string & what)
+{
+  check(result.status(), what);
+  return std::move(result).ValueUnsafe();
+}
+
+std::shared_ptr<arrow::DataType> to_arrow_type(uint8_t type_id)
+{
+  namespace ts = rosidl_typesupport_introspection_cpp;
+  switch (type_id) {
+    case ts::ROS_TYPE_FLOAT:
+      return arrow::float32();
+    case ts::ROS_TYPE_DOUBLE:
+      return arrow::float64();
+    case ts::ROS_TYPE_BOOLEAN:
+      return arrow::boolean();
+    case ts::ROS_TYPE_INT8:
+      return arrow::int8();
+    case ts::ROS_TYPE_CHAR:
+    case ts::ROS_TYPE_OCTET:
+    case ts::ROS_TYPE_UINT8:
+      return arrow::uint8();
+    case ts::ROS_TYPE_INT16:
+      return arrow::int16();
+    case ts::ROS_TYPE_WCHAR:
+    case ts::ROS_TYPE_UINT16:
+      return arrow::uint16();
+    case ts::ROS_TYPE_INT32:
+      return arrow::int32();
+    case ts::ROS_TYPE_UINT32:
+      return arrow::uint32();
+    case ts::ROS_TYPE_INT64:
+      return arrow::int64();
+    default:
+      return arrow::uint64();
+  }
+}
+
+std::string get_file_name(const std::string & topic_name)
+{
+  std::string name = topic_name;
+  if (!name.empty() && name.front() == '/') {
+    name.erase(0, 1);
+  }
+  std::replace(name.begin(), name.end(), '/', '.');
+  return name + ".parquet";
+}
+
+/// Flattens the messages of a topic into rows and writes them to a Parquet file on a thread of
+/// its own. Messages are queued until their serialized data reaches kMaxQueuedBytes.
+/// Every row group is built in memory and written at once when it is full.
+class TopicParquetWriter
+{
+public:
+  static constexpr size_t kMaxQueuedBytes = 16 * 1024 * 1024;
+
+  TopicParquetWriter(
+    const rosbag2_storage::TopicMetadata & topic,
+    const rosbag2_transport::ExportOptions & export_options)
+  : field_paths_(rosbag2_cpp::FieldExtractor::primitive_field_paths(topic.type)),
+    extractor_(topic.type, field_paths_, topic.serialization_format),
+    row_group_size_(std::max<size_t>(export_options.row_group_size, 1))
+  {
+    arrow::FieldVector fields{arrow::field("timestamp", arrow::int64(), false)};
+    for (size_t i = 0; i < field_paths_.size(); ++i) {
+      fields.push_back(
+        arrow::field(field_paths_[i], to_arrow_type(extractor_.field_types()[i]), false));
+      field_sizes_.push_back(
+        rosbag2_cpp::FieldExtractor::field_type_size(extractor_.field_types()[i]));
+    }
+    schema_ = arrow::schema(fields);
+
+    const auto path =
+      std::filesystem::path(export_options.output_directory) / get_file_name(topic.name);
+    sink_ = check(
+      arrow::io::FileOutputStream::Open(path.string()), "Could not open " + path.string());
+    const auto codec = check(
+      arrow::util::Codec::GetCompressionType(export_options.compression),
+      "Unknown compression " + export_options.compression);
+    auto properties = parquet::WriterProperties::Builder()
+      .compression(codec)
+      ->max_row_group_length(static_cast<int64_t>(row_group_size_))
+      ->build();
+    writer_ = check(
+      parquet::arrow::FileWriter::Open(
+        *schema_, arrow::default_memory_pool(), sink_, properties),
+      "Could not create Parquet writer for " + path.string());
+    start_row_group();
+
+    thread_ = std::thread(&TopicParquetWriter::write_queued_messages, this);
+  }
+
+  /// Discards messages which are still queued if finish() was not called.
+  ~TopicParquetWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      should_exit_ = true;
+    }
+    message_queued_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  /// Queue a message, waiting while the queue is full.
+  /// \throws the exception of a previous write.
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message)
+  {
+    const size_t message_bytes = message->serialized_data->buffer_length;
+    std::unique_lock<std::mutex> lock(mutex_);
+    message_written_.wait(
+      lock, [this]() {
+        return error_ || queue_.empty() || queued_bytes_ < kMaxQueuedBytes;
+      });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    queued_bytes_ += message_bytes;
+    queue_.push_back(std::move(message));
+    message_queued_.notify_one();
+  }
+
+  /// Wait until all queued messages are written and close the file.
+  /// \throws the exception of a write.
+  void finish()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finishing_ = true;
+    }
+    message_queued_.notify_one();
+    thread_.join();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    write_row_group();
+    check(writer_->Close(), "Could not close Parquet writer");
+    check(sink_->Close(), "Could not close Parquet file");
+  }
+
+private:
+  void write_queued_messages()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      message_queued_.wait(
+        lock, [this]() {return should_exit_ || finishing_ || !queue_.empty();});
+      if (should_exit_ || queue_.empty()) {
+        return;
+      }
+      auto message = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+
+      std::exception_ptr error;
+      try {
+        add_row(*message);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      queued_bytes_ -= message->serialized_data->buffer_length;
+      if (error) {
+        error_ = error;
+        queue_.clear();
+        message_written_.notify_one();
+        return;
+      }
+      message_written_.notify_one();
+    }
+  }
+
+  void start_row_group()
+  {
+    timestamps_.assign(row_group_size_, 0);
+    columns_.clear();
+    column_pointers_.clear();
+    for (const auto field_size : field_sizes_) {
+      columns_.emplace_back(row_group_size_ * field_size);
+      column_pointers_.push_back(columns_.back().data());
+    }
+    rows_ = 0;
+  }
+
+  void add_row(const rosbag2_storage::SerializedBagMessage & message)
+  {
+    timestamps_[rows_] = message.time_stamp;
+    extractor_.extract(*message.serialized_data, column_pointers_, rows_);
+    if (++rows_ == row_group_size_) {
+      write_row_group();
+      start_row_group();
+    }
+  }
+
+  void write_row_group()
+  {
+    if (rows_ == 0) {
+      return;
+    }
+    const auto rows = static_cast<int64_t>(rows_);
+    timestamps_.resize(rows_);
+    arrow::ArrayVector arrays{
+      arrow::MakeArray(
+        arrow::ArrayData::Make(
+          arrow::int64(), rows, {nullptr, arrow::Buffer::FromVector(std::move(timestamps_))}))};
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const auto type = schema_->field(static_cast<int>(i + 1))->type();
+      columns_[i].resize(rows_ * field_sizes_[i]);
+      if (type->id() == arrow::Type::BOOL) {
+        // Arrow stores booleans as bits
+        arrow::BooleanBuilder builder;
+        check(builder.AppendValues(columns_[i].data(), rows), "Could not build column");
+        std::shared_ptr<arrow::Array> array;
+        check(builder.Finish(&array), "Could not build column");
+        arrays.push_back(array);
+      } else {
+        arrays.push_back(
+          arrow::MakeArray(
+            arrow::ArrayData::Make(
+              type, rows, {nullptr, arrow::Buffer::FromVector(std::move(columns_[i]))})));
+      }
+    }
+    const auto table = arrow::Table::Make(schema_, arrays, rows);
+    check(
+      writer_->WriteTable(*table, static_cast<int64_t>(row_group_size_)),
+      "Could not write row group");
+    rows_ = 0;
+  }
+
+  std::vector<std::string> field_paths_;
+  rosbag2_cpp::FieldExtractor extractor_;
+  std::vector<size_t> field_sizes_;
+  size_t row_group_size_;
+  std::shared_ptr<arrow::Schema> schema_;
+  std::shared_ptr<arrow::io::FileOutputStream> sink_;
+  std::unique_ptr<parquet::arrow::FileWriter> writer_;
+
+  // Row group being built, only accessed by the writing thread
+  std::vector<int64_t> timestamps_;
+  std::vector<std::vector<uint8_t>> columns_;
+  std::vector<void *> column_pointers_;
+  size_t rows_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable message_queued_;
+  std::condition_variable message_written_;
+  std::deque<std::shared_ptr<const rosbag2_storage::SerializedBagMessage>> queue_;
+  size_t queued_bytes_ = 0;
+  bool finishing_ = false;
+  bool should_exit_ = false;
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+#endif  // ROSBAG2_TRANSPORT_HAS_PARQUET
+
+}  // namespace
+
+namespace rosbag2_transport
+{
+
+#ifdef ROSBAG2_TRANSPORT_HAS_PARQUET
+
+void bag_export(
+  const rosbag2_storage::StorageOptions & input_options,
+  const ExportOptions & export_options)
+{
+  auto reader = ReaderWriterFactory::make_reader(input_options);
+  reader->open(input_options);
+  if (!export_options.topics.empty()) {
+    rosbag2_storage::StorageFilter filter;
+    filter.topics = export_options.topics;
+    reader->set_filter(filter);
+  }
+  std::filesystem::create_directories(export_options.output_directory);
+
+  std::unordered_map<std::string, std::unique_ptr<TopicParquetWriter>> writers;
+  for (const auto & topic : reader->get_all_topics_and_types()) {
+    if (!export_options.topics.empty() &&
+      std::find(export_options.topics.begin(), export_options.topics.end(), topic.name) ==
+      export_options.topics.end())
+    {
+      continue;
+    }
+    try {
+      writers.emplace(topic.name, std::make_unique<TopicParquetWriter>(topic, export_options));
+    } catch (const std::runtime_error & e) {
+      ROSBAG2_TRANSPORT_LOG_WARN_STREAM(
+        "Skipping export of topic " << topic.name << ": " << e.what());
+    }
+  }
+
+  while (reader->has_next()) {
+    auto message = reader->read_next();
+    const auto writer = writers.find(message->topic_name);
+    if (writer != writers.end()) {
+      writer->second->write(std::move(message));
+    }
+  }
+
+  std::exception_ptr error;
+  for (auto & [topic_name, writer] : writers) {
+    try {
+      writer->finish();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#else
+
+void bag_export(const rosbag2_storage::StorageOptions &, const ExportOptions &)
+{
+  throw std::runtime_error(
+          "Can't export bag: rosbag2_transport was built without Apache Arrow and Parquet");
+}
+
+#endif  // ROSBAG2_TRANSPORT_HAS_PARQUET
+
+}  // namespace rosbag2_transport
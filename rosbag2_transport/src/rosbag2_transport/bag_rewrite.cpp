@@ -14,16 +14,33 @@
 
 #include "rosbag2_transport/bag_rewrite.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_cpp/readers/merging_reader.hpp"
 #include "rosbag2_cpp/writer.hpp"
+#include "rosbag2_cpp/writer_interfaces/base_writer_interface.hpp"
+#include "rosbag2_storage/metadata_io.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_transport/reader_writer_factory.hpp"
 
 #include "logging.hpp"
@@ -32,42 +49,483 @@
 namespace
 {
 
-/// Find the next chronological message from all opened input bags.
-/// Updates the next_messages queue as necessary.
-/// next_messages is needed because Reader has no "peek" interface, we cannot put a message back.
-/// Returns nullptr when all input bags have been fully read.
-std::shared_ptr<rosbag2_storage::SerializedBagMessage> get_next(
-  const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags,
-  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> & next_messages)
+/// Merges the messages of all opened input bags in chronological order.
+/// The next message of every input bag is kept in a min-heap, because Reader has no "peek"
+/// interface and we cannot put a message back.
+/// Messages with equal time stamps are returned in the order of the input bags.
+class MessageMerger
 {
-  // find message with lowest timestamp
-  std::shared_ptr<rosbag2_storage::SerializedBagMessage> earliest_msg = nullptr;
-  size_t earliest_msg_index = -1;
-  for (size_t i = 0; i < next_messages.size(); i++) {
-    // refill queue if bag not empty
-    if (next_messages[i] == nullptr && input_bags[i]->has_next()) {
-      next_messages[i] = input_bags[i]->read_next();
+public:
+  explicit MessageMerger(const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags)
+  : input_bags_(input_bags)
+  {
+    for (size_t i = 0; i < input_bags_.size(); i++) {
+      read_next_of(i);
     }
+  }
 
-    auto & msg = next_messages[i];
-    if (msg == nullptr) {
-      continue;
+  /// Returns nullptr when all input bags have been fully read.
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> get_next()
+  {
+    if (next_messages_.empty()) {
+      return nullptr;
+    }
+    auto next = next_messages_.top();
+    next_messages_.pop();
+    // refill heap from the bag of the returned message
+    read_next_of(next.input_index);
+    return next.message;
+  }
+
+private:
+  struct NextMessage
+  {
+    std::shared_ptr<rosbag2_storage::SerializedBagMessage> message;
+    size_t input_index;
+  };
+
+  struct IsLater
+  {
+    bool operator()(const NextMessage & left, const NextMessage & right) const
+    {
+      return std::tie(left.message->time_stamp, left.input_index) >
+             std::tie(right.message->time_stamp, right.input_index);
+    }
+  };
+
+  void read_next_of(size_t input_index)
+  {
+    if (input_bags_[input_index]->has_next()) {
+      next_messages_.push({input_bags_[input_index]->read_next(), input_index});
+    }
+  }
+
+  const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags_;
+  std::priority_queue<NextMessage, std::vector<NextMessage>, IsLater> next_messages_;
+};
+
+/// Writes messages to a Writer on a thread of its own, so that several output bags are written
+/// concurrently. Messages are queued until their serialized data reaches kMaxQueuedBytes.
+class OutputBagWriter
+{
+public:
+  static constexpr size_t kMaxQueuedBytes = 16 * 1024 * 1024;
+
+  explicit OutputBagWriter(rosbag2_cpp::Writer & writer)
+  : writer_(writer),
+    thread_(&OutputBagWriter::write_queued_messages, this)
+  {}
+
+  /// Discards messages which are still queued if finish() was not called.
+  ~OutputBagWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      should_exit_ = true;
+    }
+    message_queued_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  /// Queue a message, waiting while the queue is full.
+  /// If split_before is set, the writer starts a new bag file before writing the message.
+  /// \throws the exception of a previous write of the writer.
+  void write(
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message,
+    bool split_before = false)
+  {
+    const size_t message_bytes = get_size(*message);
+    std::unique_lock<std::mutex> lock(mutex_);
+    message_written_.wait(
+      lock, [this]() {
+        return error_ || queue_.empty() || queued_bytes_ < kMaxQueuedBytes;
+      });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    queued_bytes_ += message_bytes;
+    queue_.push_back({std::move(message), split_before});
+    message_queued_.notify_one();
+  }
+
+  /// Wait until all queued messages are written.
+  /// \throws the exception of a write of the writer.
+  void finish()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finishing_ = true;
+    }
+    message_queued_.notify_one();
+    thread_.join();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  struct QueuedMessage
+  {
+    std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message;
+    bool split_before;
+  };
+
+  static size_t get_size(const rosbag2_storage::SerializedBagMessage & message)
+  {
+    return message.serialized_data ? message.serialized_data->buffer_length : 0;
+  }
+
+  void write_queued_messages()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      message_queued_.wait(
+        lock, [this]() {return should_exit_ || finishing_ || !queue_.empty();});
+      if (should_exit_ || queue_.empty()) {
+        return;
+      }
+      auto queued = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+
+      std::exception_ptr error;
+      try {
+        if (queued.split_before) {
+          writer_.split_bagfile();
+        }
+        writer_.write(queued.message);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      queued_bytes_ -= get_size(*queued.message);
+      if (error) {
+        error_ = error;
+        queue_.clear();
+        message_written_.notify_one();
+        return;
+      }
+      message_written_.notify_one();
+    }
+  }
+
+  rosbag2_cpp::Writer & writer_;
+  std::mutex mutex_;
+  std::condition_variable message_queued_;
+  std::condition_variable message_written_;
+  std::deque<QueuedMessage> queue_;
+  size_t queued_bytes_ = 0;
+  bool finishing_ = false;
+  bool should_exit_ = false;
+  std::exception_ptr error_;
+  // Last member, so that the thread starts after all other members are initialized
+  std::thread thread_;
+};
+
+/// Move the files of bags written into part directories of a bag directory into the bag
+/// directory, named and ordered as if a single Writer had written them, and write the merged
+/// metadata of the parts. The part directories are removed.
+void merge_part_bags(const std::string & base_folder, const std::vector<std::string> & part_uris)
+{
+  rosbag2_storage::MetadataIo metadata_io;
+  std::vector<rosbag2_storage::BagMetadata> parts_metadata;
+  for (const auto & part_uri : part_uris) {
+    parts_metadata.push_back(metadata_io.read_metadata(part_uri));
+  }
+
+  struct PartFile
+  {
+    std::filesystem::path path;
+    std::string extension;
+    rosbag2_storage::FileInformation info;
+  };
+  std::vector<PartFile> files;
+  std::vector<PartFile> empty_files;
+  for (size_t i = 0; i < parts_metadata.size(); ++i) {
+    // Files of a part are named after its directory
+    const std::string prefix = std::filesystem::path(part_uris[i]).filename().string() + "_";
+    for (const auto & file_info : parts_metadata[i].files) {
+      const std::string file_name = std::filesystem::path(file_info.path).filename().string();
+      // Keep what follows the file index, e.g. ".mcap" or ".db3.zstd"
+      const size_t extension_begin = file_name.find_first_not_of("0123456789", prefix.size());
+      // Parts which got no messages leave an empty file
+      (file_info.message_count > 0 ? files : empty_files).push_back(
+        {std::filesystem::path(part_uris[i]) / file_name,
+          extension_begin == std::string::npos ? "" : file_name.substr(extension_begin),
+          file_info});
+    }
+  }
+  if (files.empty() && !empty_files.empty()) {
+    // A bag without messages still has a file
+    files.push_back(empty_files.front());
+  }
+  std::stable_sort(
+    files.begin(), files.end(), [](const PartFile & left, const PartFile & right) {
+      return left.info.starting_time < right.info.starting_time;
+    });
+
+  rosbag2_storage::BagMetadata metadata = parts_metadata.front();
+  metadata.relative_file_paths.clear();
+  metadata.files.clear();
+  metadata.topics_with_message_count.clear();
+  metadata.message_count = 0;
+  metadata.bag_size = 0;
+  std::unordered_map<std::string, size_t> topic_indices;
+  for (const auto & part_metadata : parts_metadata) {
+    metadata.bag_size += part_metadata.bag_size;
+    for (const auto & topic_info : part_metadata.topics_with_message_count) {
+      auto [topic_index, inserted] = topic_indices.emplace(
+        topic_info.topic_metadata.name, metadata.topics_with_message_count.size());
+      if (inserted) {
+        metadata.topics_with_message_count.push_back(topic_info);
+      } else {
+        metadata.topics_with_message_count[topic_index->second].message_count +=
+          topic_info.message_count;
+      }
     }
-    if (earliest_msg == nullptr || msg->time_stamp < earliest_msg->time_stamp) {
-      earliest_msg = msg;
-      earliest_msg_index = i;
+  }
+
+  const std::filesystem::path bag_path(base_folder);
+  const std::string bag_name = bag_path.filename().string();
+  auto end_time = metadata.starting_time;
+  for (size_t i = 0; i < files.size(); ++i) {
+    auto & file = files[i];
+    const std::string file_name = bag_name + "_" + std::to_string(i) + file.extension;
+    std::filesystem::rename(file.path, bag_path / file_name);
+    file.info.path = file_name;
+    if (i == 0) {
+      metadata.starting_time = file.info.starting_time;
+      end_time = file.info.starting_time;
     }
+    end_time = std::max(end_time, file.info.starting_time + file.info.duration);
+    metadata.message_count += file.info.message_count;
+    metadata.relative_file_paths.push_back(file_name);
+    metadata.files.push_back(file.info);
   }
+  metadata.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    end_time - metadata.starting_time);
+  metadata_io.write_metadata(base_folder, metadata);
 
-  // clear returned message from queue before returning it, so it can be refilled next time
-  if (earliest_msg != nullptr) {
-    next_messages[earliest_msg_index].reset();
+  for (const auto & part_uri : part_uris) {
+    std::filesystem::remove_all(part_uri);
   }
-  return earliest_msg;
+}
+
+/// Writes a split output bag with several Writers concurrently.
+/// The messages are partitioned into segments of max_bagfile_duration and max_bagfile_size
+/// bytes of serialized data, which are handed to the Writers in turn. Every Writer writes its
+/// segments into split files of a part directory within the bag. On close, the files of all
+/// parts are moved into the bag directory in chronological order and their metadata is merged.
+class ParallelSplitWriter : public rosbag2_cpp::writer_interfaces::BaseWriterInterface
+{
+public:
+  ParallelSplitWriter(
+    const rosbag2_transport::RecordOptions & record_options, size_t number_of_writers)
+  : record_options_(record_options),
+    number_of_writers_(std::max<size_t>(number_of_writers, 1))
+  {}
+
+  ~ParallelSplitWriter() override
+  {
+    try {
+      close();
+    } catch (const std::exception & e) {
+      ROSBAG2_TRANSPORT_LOG_ERROR_STREAM(
+        "Failed to merge the parts of bag " << base_folder_ << ": " << e.what());
+    }
+  }
+
+  void open(
+    const rosbag2_storage::StorageOptions & storage_options,
+    const rosbag2_cpp::ConverterOptions & converter_options) override
+  {
+    base_folder_ = storage_options.uri;
+    const std::filesystem::path bag_path(base_folder_);
+    if (std::filesystem::is_directory(bag_path)) {
+      std::stringstream error;
+      error << "Bag directory already exists (" << bag_path.string() <<
+        "), can't overwrite existing bag";
+      throw std::runtime_error{error.str()};
+    }
+    std::filesystem::create_directories(bag_path);
+
+    max_bagfile_size_ = storage_options.max_bagfile_size;
+    max_bagfile_duration_ns_ = static_cast<rcutils_time_point_value_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::seconds(storage_options.max_bagfile_duration)).count());
+    for (size_t i = 0; i < number_of_writers_; ++i) {
+      auto part_options = storage_options;
+      part_options.uri = get_part_uri(i);
+      auto writer = rosbag2_transport::ReaderWriterFactory::make_writer(record_options_);
+      writer->open(part_options, converter_options);
+      parts_.push_back({std::move(writer), nullptr, std::nullopt});
+    }
+    for (auto & part : parts_) {
+      part.output_writer = std::make_unique<OutputBagWriter>(*part.writer);
+    }
+  }
+
+  /// Wait until all messages are written and merge the parts into the bag.
+  void close() override
+  {
+    if (parts_.empty()) {
+      return;
+    }
+    auto parts = std::move(parts_);
+    parts_.clear();
+    std::exception_ptr error;
+    for (auto & part : parts) {
+      try {
+        part.output_writer->finish();
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    for (auto & part : parts) {
+      part.output_writer.reset();
+      part.writer->close();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    std::vector<std::string> part_uris;
+    for (size_t i = 0; i < number_of_writers_; ++i) {
+      part_uris.push_back(get_part_uri(i));
+    }
+    merge_part_bags(base_folder_, part_uris);
+  }
+
+  void create_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override
+  {
+    for (auto & part : parts_) {
+      part.writer->create_topic(topic_with_type);
+    }
+  }
+
+  void create_topic(
+    const rosbag2_storage::TopicMetadata & topic_with_type,
+    const rosbag2_storage::MessageDefinition & message_definition) override
+  {
+    for (auto & part : parts_) {
+      part.writer->create_topic(topic_with_type, message_definition);
+    }
+  }
+
+  void remove_topic(const rosbag2_storage::TopicMetadata & topic_with_type) override
+  {
+    for (auto & part : parts_) {
+      part.writer->remove_topic(topic_with_type);
+    }
+  }
+
+  void write(std::shared_ptr<const rosbag2_storage::SerializedBagMessage> message) override
+  {
+    if (parts_.empty()) {
+      throw std::runtime_error("Bag is not open. Call open() before writing.");
+    }
+    const uint64_t segment = assign_segment(*message);
+    auto & part = parts_[segment % parts_.size()];
+    // Segments of a part are not contiguous, every one goes into a file of its own
+    const bool split_before = part.last_segment.has_value() && *part.last_segment != segment;
+    part.last_segment = segment;
+    part.output_writer->write(std::move(message), split_before);
+  }
+
+  bool take_snapshot() override
+  {
+    return false;
+  }
+
+  void split_bagfile() override
+  {
+    split_requested_ = true;
+  }
+
+  void add_event_callbacks(const rosbag2_cpp::bag_events::WriterEventCallbacks & callbacks)
+  override
+  {
+    for (auto & part : parts_) {
+      // Writer takes the callbacks by non-const reference
+      auto part_callbacks = callbacks;
+      part.writer->add_event_callbacks(part_callbacks);
+    }
+  }
+
+private:
+  struct Part
+  {
+    std::unique_ptr<rosbag2_cpp::Writer> writer;
+    std::unique_ptr<OutputBagWriter> output_writer;
+    std::optional<uint64_t> last_segment;
+  };
+
+  std::string get_part_uri(size_t part_index) const
+  {
+    return (std::filesystem::path(base_folder_) / ("part_" + std::to_string(part_index))).string();
+  }
+
+  /// Segment of a message, starting a new segment when the current one reached its duration or
+  /// size limit or a split was requested.
+  uint64_t assign_segment(const rosbag2_storage::SerializedBagMessage & message)
+  {
+    if (messages_in_segment_ > 0 &&
+      (split_requested_ ||
+      (max_bagfile_duration_ns_ > 0 &&
+      message.time_stamp - segment_start_time_ >= max_bagfile_duration_ns_) ||
+      (max_bagfile_size_ > 0 && bytes_in_segment_ >= max_bagfile_size_)))
+    {
+      ++segment_;
+      messages_in_segment_ = 0;
+      bytes_in_segment_ = 0;
+    }
+    split_requested_ = false;
+    if (messages_in_segment_ == 0) {
+      segment_start_time_ = message.time_stamp;
+    }
+    ++messages_in_segment_;
+    bytes_in_segment_ += message.serialized_data ? message.serialized_data->buffer_length : 0;
+    return segment_;
+  }
+
+  const rosbag2_transport::RecordOptions record_options_;
+  const size_t number_of_writers_;
+  std::string base_folder_;
+  uint64_t max_bagfile_size_ = 0;
+  rcutils_time_point_value_t max_bagfile_duration_ns_ = 0;
+  std::vector<Part> parts_;
+
+  uint64_t segment_ = 0;
+  rcutils_time_point_value_t segment_start_time_ = 0;
+  size_t messages_in_segment_ = 0;
+  uint64_t bytes_in_segment_ = 0;
+  bool split_requested_ = false;
+};
+
+/// Path of the only file of an opened input bag, empty if the bag consists of several files.
+std::string get_single_file_path(
+  const rosbag2_storage::StorageOptions & storage_options, rosbag2_cpp::Reader & reader)
+{
+  const auto metadata = reader.get_metadata();
+  if (metadata.relative_file_paths.size() != 1) {
+    return "";
+  }
+  std::filesystem::path file_path(metadata.relative_file_paths.front());
+  const std::filesystem::path bag_path(storage_options.uri);
+  if (file_path.is_relative() && std::filesystem::is_directory(bag_path)) {
+    file_path = bag_path / file_path;
+  }
+  return file_path.string();
 }
 
 /// Discover what topics are in the inputs, filter out topics that can't be processed,
 /// create_topic on Writers that will receive topics.
+/// If copy_from_file is set, the messages of the filtered topics are copied from that file, the
+/// only input, to Writers whose storage can copy them as stored. No topics are created on those.
 /// Return a map f topic -> vector of which Writers want to receive that topic,
 /// based on the RecordOptions.
 /// The output vector has bare pointers to the uniquely owned Writers,
@@ -77,7 +535,8 @@ setup_topic_filtering(
   const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags,
   const std::vector<
     std::pair<std::unique_ptr<rosbag2_cpp::Writer>, rosbag2_transport::RecordOptions>
-  > & output_bags)
+  > & output_bags,
+  const std::string & copy_from_file)
 {
   std::unordered_map<std::string, std::vector<rosbag2_cpp::Writer *>> filtered_outputs;
   std::map<std::string, std::vector<std::string>> input_topics;
@@ -114,6 +573,19 @@ setup_topic_filtering(
     rosbag2_transport::TopicFilter topic_filter{record_options};
     auto filtered_topics_and_types = topic_filter.filter_topics(input_topics);
 
+    // Messages can be copied as stored if they keep their serialization format
+    bool copyable = !copy_from_file.empty() && !filtered_topics_and_types.empty();
+    rosbag2_storage::StorageFilter storage_filter;
+    for (const auto & [topic_name, topic_type] : filtered_topics_and_types) {
+      copyable = copyable && (record_options.rmw_serialization_format.empty() ||
+        record_options.rmw_serialization_format == input_topics_serialization_format[topic_name]);
+      storage_filter.topics.push_back(topic_name);
+    }
+    if (copyable && writer->copy_bag_file(copy_from_file, storage_filter)) {
+      ROSBAG2_TRANSPORT_LOG_INFO_STREAM("Copied messages of " << copy_from_file << " as stored");
+      continue;
+    }
+
     // Done filtering - set up writer
     for (const auto & [topic_name, topic_type] : filtered_topics_and_types) {
       rosbag2_storage::TopicMetadata topic_metadata;
@@ -148,27 +620,225 @@ void perform_rewrite(
   const std::vector<std::unique_ptr<rosbag2_cpp::Reader>> & input_bags,
   const std::vector<
     std::pair<std::unique_ptr<rosbag2_cpp::Writer>, rosbag2_transport::RecordOptions>
-  > & output_bags
+  > & output_bags,
+  const std::string & copy_from_file
 )
 {
   if (input_bags.empty() || output_bags.empty()) {
     throw std::runtime_error("Must provide at least one input and one output bag to rewrite.");
   }
 
-  auto topic_outputs = setup_topic_filtering(input_bags, output_bags);
+  auto topic_outputs = setup_topic_filtering(input_bags, output_bags, copy_from_file);
+  if (topic_outputs.empty()) {
+    return;
+  }
 
-  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> next_messages;
-  next_messages.resize(input_bags.size(), nullptr);
+  // A single output bag is written on this thread, several ones concurrently on threads of
+  // their own.
+  std::unordered_map<rosbag2_cpp::Writer *, std::unique_ptr<OutputBagWriter>> output_writers;
+  if (output_bags.size() > 1) {
+    for (const auto & output_bag : output_bags) {
+      output_writers.emplace(
+        output_bag.first.get(), std::make_unique<OutputBagWriter>(*output_bag.first));
+    }
+  }
 
+  MessageMerger message_merger(input_bags);
   std::shared_ptr<rosbag2_storage::SerializedBagMessage> next_msg;
-  while ((next_msg = get_next(input_bags, next_messages))) {
+  while ((next_msg = message_merger.get_next())) {
     auto topic_writers = topic_outputs.find(next_msg->topic_name);
     if (topic_writers != topic_outputs.end()) {
       for (auto writer : topic_writers->second) {
-        writer->write(next_msg);
+        auto output_writer = output_writers.find(writer);
+        if (output_writer != output_writers.end()) {
+          output_writer->second->write(next_msg);
+        } else {
+          writer->write(next_msg);
+        }
       }
     }
   }
+  for (auto & output_writer : output_writers) {
+    output_writer.second->finish();
+  }
+}
+
+std::vector<std::unique_ptr<rosbag2_cpp::Reader>> open_input_bags(
+  const std::vector<rosbag2_storage::StorageOptions> & input_options)
+{
+  std::vector<std::unique_ptr<rosbag2_cpp::Reader>> input_bags;
+  for (const auto & storage_options : input_options) {
+    // Read every input bag ahead on a thread of its own while the messages are merged
+    auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(
+      storage_options, rosbag2_cpp::readers::MergingReader::kDefaultMaxPrefetchedBytesPerFile);
+    reader->open(storage_options);
+    input_bags.push_back(std::move(reader));
+  }
+  return input_bags;
+}
+
+std::unique_ptr<rosbag2_cpp::Writer> open_output_bag(
+  const rosbag2_storage::StorageOptions & storage_options,
+  const rosbag2_transport::RecordOptions & record_options)
+{
+  // TODO(emersonknapp) - utilize cache to get better performance.
+  // For now, zero cache allows for synchronous writes which are guaranteed to go through.
+  // With cache enabled, the buffer could overflow and drop messages in this fast-write loop.
+  // To enable the cache we will need to implement a mechanism for the writer to take messages
+  // only when it is able to, which will likely require some new APIs.
+  auto zero_cache_storage_options = storage_options;
+  zero_cache_storage_options.max_cache_size = 0u;
+  std::unique_ptr<rosbag2_cpp::Writer> writer;
+  if (record_options.split_writers > 1 && !storage_options.snapshot_mode &&
+    (storage_options.max_bagfile_size > 0 || storage_options.max_bagfile_duration > 0))
+  {
+    writer = std::make_unique<rosbag2_cpp::Writer>(
+      std::make_unique<ParallelSplitWriter>(record_options, record_options.split_writers));
+  } else {
+    writer = rosbag2_transport::ReaderWriterFactory::make_writer(record_options);
+  }
+  writer->open(zero_cache_storage_options);
+  return writer;
+}
+
+rcutils_time_point_value_t to_nanoseconds(
+  const std::chrono::time_point<std::chrono::high_resolution_clock> & time)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+/// Start times of up to number_of_slices time slices, which divide the time range of the input
+/// bags into slices of about the same number of messages.
+/// If the inputs consist of enough files, the slices start where files start, so that every file
+/// is read for one slice only. Otherwise the time range is divided evenly.
+std::vector<rcutils_time_point_value_t> get_time_slice_starts(
+  const std::vector<rosbag2_storage::BagMetadata> & inputs_metadata, size_t number_of_slices)
+{
+  std::optional<rcutils_time_point_value_t> start_time;
+  rcutils_time_point_value_t end_time = 0;
+  uint64_t message_count = 0;
+  // Messages of the input files by their starting time
+  std::map<rcutils_time_point_value_t, uint64_t> file_message_counts;
+  for (const auto & metadata : inputs_metadata) {
+    if (metadata.message_count == 0) {
+      continue;
+    }
+    const auto bag_start_time = to_nanoseconds(metadata.starting_time);
+    start_time = start_time ? std::min(*start_time, bag_start_time) : bag_start_time;
+    end_time = std::max(end_time, to_nanoseconds(metadata.starting_time + metadata.duration));
+    message_count += metadata.message_count;
+    for (const auto & file_info : metadata.files) {
+      if (file_info.message_count > 0) {
+        file_message_counts[to_nanoseconds(file_info.starting_time)] += file_info.message_count;
+      }
+    }
+  }
+  if (!start_time) {
+    return {0};
+  }
+
+  std::vector<rcutils_time_point_value_t> slice_starts{*start_time};
+  if (file_message_counts.size() >= number_of_slices) {
+    uint64_t messages_before_file = 0;
+    for (const auto & [file_start_time, file_message_count] : file_message_counts) {
+      if (slice_starts.size() == number_of_slices) {
+        break;
+      }
+      if (file_start_time > slice_starts.back() &&
+        messages_before_file * number_of_slices >= message_count * slice_starts.size())
+      {
+        slice_starts.push_back(file_start_time);
+      }
+      messages_before_file += file_message_count;
+    }
+  } else {
+    const auto slice_duration =
+      (end_time - *start_time) / static_cast<rcutils_time_point_value_t>(number_of_slices);
+    for (size_t i = 1; i < number_of_slices && slice_duration > 0; ++i) {
+      slice_starts.push_back(*start_time + slice_duration * static_cast<int64_t>(i));
+    }
+  }
+  return slice_starts;
+}
+
+/// Convert the input bags into an output bag in time slices, which are converted concurrently.
+/// Every slice is read by readers of its own and written by a Writer of its own into a slice
+/// directory within the output bag, whose files are merged into the output bag at last.
+void rewrite_in_time_slices(
+  const std::vector<rosbag2_storage::StorageOptions> & input_options,
+  const rosbag2_storage::StorageOptions & storage_options,
+  const rosbag2_transport::RecordOptions & record_options)
+{
+  if (input_options.empty()) {
+    throw std::runtime_error("Must provide at least one input and one output bag to rewrite.");
+  }
+  std::vector<std::vector<std::unique_ptr<rosbag2_cpp::Reader>>> slice_inputs;
+  slice_inputs.push_back(open_input_bags(input_options));
+  std::vector<rosbag2_storage::BagMetadata> inputs_metadata;
+  for (const auto & input_bag : slice_inputs.front()) {
+    inputs_metadata.push_back(input_bag->get_metadata());
+  }
+  const auto slice_starts = get_time_slice_starts(inputs_metadata, record_options.time_slices);
+
+  const std::filesystem::path bag_path(storage_options.uri);
+  if (std::filesystem::is_directory(bag_path)) {
+    std::stringstream error;
+    error << "Bag directory already exists (" << bag_path.string() <<
+      "), can't overwrite existing bag";
+    throw std::runtime_error{error.str()};
+  }
+  std::filesystem::create_directories(bag_path);
+
+  // Readers and Writers are opened on this thread, as loading their plugins is not thread safe
+  auto slice_record_options = record_options;
+  slice_record_options.time_slices = 1;
+  std::vector<std::string> slice_uris;
+  std::vector<
+    std::vector<std::pair<std::unique_ptr<rosbag2_cpp::Writer>, rosbag2_transport::RecordOptions>>
+  > slice_outputs(slice_starts.size());
+  for (size_t i = 0; i < slice_starts.size(); ++i) {
+    if (i > 0) {
+      slice_inputs.push_back(open_input_bags(input_options));
+    }
+    // Time stamps are inclusive, the next slice starts right after the end of this one
+    rosbag2_storage::StorageFilter slice_filter;
+    slice_filter.start_time_ns = i > 0 ? slice_starts[i] : -1;
+    slice_filter.end_time_ns = i + 1 < slice_starts.size() ? slice_starts[i + 1] - 1 : -1;
+    for (auto & input_bag : slice_inputs[i]) {
+      input_bag->set_filter(slice_filter);
+    }
+
+    auto slice_storage_options = storage_options;
+    slice_storage_options.uri = (bag_path / ("slice_" + std::to_string(i))).string();
+    slice_uris.push_back(slice_storage_options.uri);
+    slice_outputs[i].emplace_back(
+      open_output_bag(slice_storage_options, slice_record_options), slice_record_options);
+  }
+
+  std::vector<std::exception_ptr> errors(slice_starts.size());
+  auto rewrite_slice = [&](size_t i) {
+      try {
+        // Files are not copied as stored, since only a time slice of them is wanted
+        perform_rewrite(slice_inputs[i], slice_outputs[i], "");
+        slice_outputs[i].front().first->close();
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < slice_starts.size(); ++i) {
+    threads.emplace_back(rewrite_slice, i);
+  }
+  rewrite_slice(0);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (const auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  merge_part_bags(storage_options.uri, slice_uris);
 }
 
 }  // namespace
@@ -182,30 +852,42 @@ void bag_rewrite(
   > & output_options
 )
 {
-  std::vector<std::unique_ptr<rosbag2_cpp::Reader>> input_bags;
-  std::vector<
-    std::pair<std::unique_ptr<rosbag2_cpp::Writer>, rosbag2_transport::RecordOptions>
-  > output_bags;
-
-  for (const auto & storage_options : input_options) {
-    auto reader = ReaderWriterFactory::make_reader(storage_options);
-    reader->open(storage_options);
-    input_bags.push_back(std::move(reader));
+  std::vector<std::pair<rosbag2_storage::StorageOptions, rosbag2_transport::RecordOptions>>
+  whole_output_options;
+  std::vector<std::pair<rosbag2_storage::StorageOptions, rosbag2_transport::RecordOptions>>
+  sliced_output_options;
+  for (const auto & output : output_options) {
+    if (output.second.time_slices > 1 && !output.first.snapshot_mode) {
+      sliced_output_options.push_back(output);
+    } else {
+      whole_output_options.push_back(output);
+    }
   }
 
-  for (auto & [storage_options, record_options] : output_options) {
-    // TODO(emersonknapp) - utilize cache to get better performance.
-    // For now, zero cache allows for synchronous writes which are guaranteed to go through.
-    // With cache enabled, the buffer could overflow and drop messages in this fast-write loop.
-    // To enable the cache we will need to implement a mechanism for the writer to take messages
-    // only when it is able to, which will likely require some new APIs.
-    auto zero_cache_storage_options = storage_options;
-    zero_cache_storage_options.max_cache_size = 0u;
-    auto writer = ReaderWriterFactory::make_writer(record_options);
-    writer->open(zero_cache_storage_options);
-    output_bags.push_back(std::make_pair(std::move(writer), record_options));
+  if (!whole_output_options.empty() || sliced_output_options.empty()) {
+    auto input_bags = open_input_bags(input_options);
+    std::vector<
+      std::pair<std::unique_ptr<rosbag2_cpp::Writer>, rosbag2_transport::RecordOptions>
+    > output_bags;
+    for (const auto & [storage_options, record_options] : whole_output_options) {
+      output_bags.emplace_back(open_output_bag(storage_options, record_options), record_options);
+    }
+
+    // The messages of a single input file may be copied without deserializing them
+    std::string copy_from_file;
+    if (input_bags.size() == 1) {
+      copy_from_file = get_single_file_path(input_options.front(), *input_bags.front());
+    }
+    perform_rewrite(input_bags, output_bags, copy_from_file);
+    // Close explicitly, so that errors while finishing the output bags are not only logged
+    for (auto & output_bag : output_bags) {
+      output_bag.first->close();
+    }
   }
 
-  perform_rewrite(input_bags, output_bags);
+  // Output bags converted in time slices read the inputs with readers of their own
+  for (const auto & [storage_options, record_options] : sliced_output_options) {
+    rewrite_in_time_slices(input_options, storage_options, record_options);
+  }
 }
 }  // namespace rosbag2_transport
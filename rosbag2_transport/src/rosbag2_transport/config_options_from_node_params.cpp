@@ -111,6 +111,34 @@ rclcpp::Duration get_duration_from_node_param(
   return rclcpp::Duration::from_nanoseconds(total_nanoseconds);
 }
 
+// Declare a list of CPU numbers, e.g. to pin a thread to
+template<typename T>
+std::vector<T> declare_cpus_node_param(rclcpp::Node & node, const std::string & name)
+{
+  std::vector<T> cpus;
+  auto cpu_numbers = node.declare_parameter<std::vector<int64_t>>(name, std::vector<int64_t>());
+  for (const auto cpu : cpu_numbers) {
+    if (cpu < 0) {
+      std::stringstream ss;
+      ss << "The " << name << " expected to be a list of CPU numbers. Got negative " << cpu;
+      throw std::invalid_argument(ss.str());
+    }
+    cpus.push_back(static_cast<T>(cpu));
+  }
+  return cpus;
+}
+
+// Declare a real-time scheduling policy of a thread, "fifo" or "rr"
+std::string declare_thread_policy_node_param(rclcpp::Node & node, const std::string & name)
+{
+  auto policy = node.declare_parameter<std::string>(name, "fifo");
+  if (policy != "fifo" && policy != "rr") {
+    throw std::invalid_argument(
+            "The " + name + " expected to be \"fifo\" or \"rr\". Got \"" + policy + "\"");
+  }
+  return policy;
+}
+
 }  // namespace param_utils
 
 PlayOptions get_play_options_from_node_params(rclcpp::Node & node)
@@ -121,9 +149,10 @@ PlayOptions get_play_options_from_node_params(rclcpp::Node & node)
 
   play_options.node_prefix = node.declare_parameter<std::string>("play.node_prefix", "");
 
+  // A negative rate plays backwards in time
   auto desc_rate = param_utils::float_param_description(
     "Playback rate (hz)",
-    0.000001f,
+    std::numeric_limits<float>::lowest(),
     std::numeric_limits<float>::max());
   play_options.rate =
     static_cast<float>(node.declare_parameter<float>("play.rate", 1.0f, desc_rate));
@@ -155,6 +184,23 @@ PlayOptions get_play_options_from_node_params(rclcpp::Node & node)
     }
   }
 
+  std::string topic_decimation_path =
+    node.declare_parameter<std::string>("play.topic_decimation_path", "");
+
+  if (!topic_decimation_path.empty()) {
+    try {
+      YAML::Node yaml_file = YAML::LoadFile(topic_decimation_path);
+      for (auto topic_decimation : yaml_file) {
+        play_options.topic_decimation.emplace(
+          topic_decimation.first.as<std::string>(),
+          topic_decimation.second.as<rosbag2_transport::TopicDecimation>());
+      }
+    } catch (const YAML::Exception & ex) {
+      throw std::runtime_error(
+              std::string("Exception on parsing topic decimation file: ") + ex.what());
+    }
+  }
+
   play_options.loop = node.declare_parameter<bool>("play.loop", false);
 
   auto topic_remapping_options = node.declare_parameter<std::vector<std::string>>(
@@ -198,6 +244,71 @@ PlayOptions get_play_options_from_node_params(rclcpp::Node & node)
   play_options.disable_loan_message =
     node.declare_parameter<bool>("play.disable_loan_message", false);
 
+  play_options.prefetch_queue_bytes = param_utils::declare_integer_node_params<size_t>(
+    node, "play.prefetch_queue_bytes", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.read_ahead_queue_bytes = param_utils::declare_integer_node_params<size_t>(
+    node, "play.read_ahead_queue_bytes", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.publishing_threads = param_utils::declare_integer_node_params<size_t>(
+    node, "play.publishing_threads", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.precise_timing_spin_duration = param_utils::get_duration_from_node_param(
+    node, "play.precise_timing_spin_duration", 0, 0).nanoseconds();
+
+  play_options.playback_thread_priority = param_utils::declare_integer_node_params<int>(
+    node, "play.playback_thread_priority", 0, 99, 0);
+
+  play_options.playback_thread_policy =
+    param_utils::declare_thread_policy_node_param(node, "play.playback_thread_policy");
+
+  play_options.playback_thread_cpus =
+    param_utils::declare_cpus_node_param<size_t>(node, "play.playback_thread_cpus");
+
+  play_options.storage_loading_thread_priority = param_utils::declare_integer_node_params<int>(
+    node, "play.storage_loading_thread_priority", 0, 99, 0);
+
+  play_options.storage_loading_thread_policy =
+    param_utils::declare_thread_policy_node_param(node, "play.storage_loading_thread_policy");
+
+  play_options.storage_loading_thread_cpus =
+    param_utils::declare_cpus_node_param<size_t>(node, "play.storage_loading_thread_cpus");
+
+  play_options.release_window = param_utils::get_duration_from_node_param(
+    node, "play.release_window", 0, 0).nanoseconds();
+
+  play_options.as_fast_as_possible =
+    node.declare_parameter<bool>("play.as_fast_as_possible", false);
+
+  play_options.seek_history_duration = param_utils::get_duration_from_node_param(
+    node, "play.seek_history_duration", 0, 0).nanoseconds();
+
+  play_options.publisher_creation_threads = param_utils::declare_integer_node_params<size_t>(
+    node, "play.publisher_creation_threads", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.loop_cache_bytes = param_utils::declare_integer_node_params<size_t>(
+    node, "play.loop_cache_bytes", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.preload = node.declare_parameter<bool>("play.preload", false);
+
+  play_options.preload_max_bytes = param_utils::declare_integer_node_params<size_t>(
+    node, "play.preload_max_bytes", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  play_options.step_clock_topic =
+    node.declare_parameter<std::string>("play.step_clock_topic", "");
+
+  play_options.intra_process_playback =
+    node.declare_parameter<bool>("play.intra_process_playback", false);
+
+  play_options.clock_publish_thread =
+    node.declare_parameter<bool>("play.clock_publish_thread", false);
+
+  play_options.clock_publish_thread_priority = param_utils::declare_integer_node_params<int>(
+    node, "play.clock_publish_thread_priority", 0, 99, 0);
+
+  play_options.statistics_publish_interval = param_utils::get_duration_from_node_param(
+    node, "play.statistics_publish_interval", 0, 0).nanoseconds();
+
   return play_options;
 }
 
@@ -257,6 +368,36 @@ RecordOptions get_record_options_from_node_params(rclcpp::Node & node)
     }
   }
 
+  std::string topic_decimation_path =
+    node.declare_parameter<std::string>("record.topic_decimation_path", "");
+
+  if (!topic_decimation_path.empty()) {
+    try {
+      YAML::Node yaml_file = YAML::LoadFile(topic_decimation_path);
+      for (auto topic_decimation : yaml_file) {
+        record_options.topic_decimation.emplace(
+          topic_decimation.first.as<std::string>(),
+          topic_decimation.second.as<rosbag2_transport::TopicDecimation>());
+      }
+    } catch (const YAML::Exception & ex) {
+      throw std::runtime_error(
+              std::string("Exception on parsing topic decimation file: ") + ex.what());
+    }
+  }
+
+  std::string topic_routes_path =
+    node.declare_parameter<std::string>("record.topic_routes_path", "");
+
+  if (!topic_routes_path.empty()) {
+    try {
+      record_options.topic_routes = YAML::LoadFile(topic_routes_path)
+        .as<std::vector<rosbag2_transport::TopicRoute>>();
+    } catch (const YAML::Exception & ex) {
+      throw std::runtime_error(
+              std::string("Exception on parsing topic routes file: ") + ex.what());
+    }
+  }
+
   record_options.include_hidden_topics =
     node.declare_parameter<bool>("record.include_hidden_topics", false);
 
@@ -268,6 +409,47 @@ RecordOptions get_record_options_from_node_params(rclcpp::Node & node)
 
   record_options.start_paused = node.declare_parameter<bool>("record.start_paused", false);
 
+  record_options.record_publish_info =
+    node.declare_parameter<bool>("record.record_publish_info", false);
+
+  record_options.use_receive_timestamp =
+    node.declare_parameter<bool>("record.use_receive_timestamp", false);
+
+  record_options.intra_process_capture =
+    node.declare_parameter<bool>("record.intra_process_capture", false);
+
+  record_options.message_buffer_pool_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "record.message_buffer_pool_size", 0, std::numeric_limits<int64_t>::max(),
+    record_options.message_buffer_pool_size);
+
+  record_options.message_buffer_arena_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "record.message_buffer_arena_size", 0, std::numeric_limits<int64_t>::max(),
+    record_options.message_buffer_arena_size);
+
+  record_options.message_buffer_numa_node = param_utils::declare_integer_node_params<int32_t>(
+    node, "record.message_buffer_numa_node", -1, std::numeric_limits<int32_t>::max(),
+    record_options.message_buffer_numa_node);
+
+  record_options.executor_threads = param_utils::declare_integer_node_params<uint64_t>(
+    node, "record.executor_threads", 1, std::numeric_limits<int64_t>::max(),
+    record_options.executor_threads);
+
+  record_options.callback_groups =
+    node.declare_parameter<std::string>("record.callback_groups", "");
+
+  record_options.topics_per_callback_group = param_utils::declare_integer_node_params<uint64_t>(
+    node, "record.topics_per_callback_group", 1, std::numeric_limits<int64_t>::max(),
+    record_options.topics_per_callback_group);
+
+  record_options.subscription_creation_threads =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "record.subscription_creation_threads", 0, std::numeric_limits<int64_t>::max(),
+    record_options.subscription_creation_threads);
+
+  record_options.pipeline_statistics_interval = param_utils::get_duration_from_node_param(
+    node, "record.pipeline_statistics_interval",
+    0, 0).to_chrono<std::chrono::milliseconds>();
+
   record_options.use_sim_time = node.get_parameter("use_sim_time").get_value<bool>();
 
   if (record_options.use_sim_time && record_options.is_discovery_disabled) {
@@ -275,6 +457,11 @@ RecordOptions get_record_options_from_node_params(rclcpp::Node & node)
             "'use_sim_time' and 'is_discovery_disabled' both set, but are incompatible settings. "
             "The `/clock` topic needs to be discovered to record with sim time.");
   }
+  if (record_options.use_sim_time && record_options.use_receive_timestamp) {
+    throw std::invalid_argument(
+            "'use_sim_time' and 'use_receive_timestamp' both set, but are incompatible settings. "
+            "The middleware reports receive timestamps in system time.");
+  }
   return record_options;
 }
 
@@ -307,6 +494,25 @@ get_storage_options_from_node_params(rclcpp::Node & node)
 
   storage_options.snapshot_mode = node.declare_parameter<bool>("storage.snapshot_mode", false);
 
+  storage_options.snapshot_duration_ms = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.snapshot_duration_ms", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.snapshot_duration_ms);
+
+  storage_options.snapshot_post_trigger_duration_ms =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.snapshot_post_trigger_duration_ms", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.snapshot_post_trigger_duration_ms);
+
+  storage_options.snapshot_contiguous_buffer =
+    node.declare_parameter<bool>("storage.snapshot_contiguous_buffer", false);
+
+  storage_options.read_buffer_pool_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.read_buffer_pool_size", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.read_buffer_pool_size);
+
+  storage_options.lock_free_cache =
+    node.declare_parameter<bool>("storage.lock_free_cache", false);
+
   auto list_of_key_value_strings = node.declare_parameter<std::vector<std::string>>(
     "storage.custom_data",
     std::vector<std::string>());
@@ -323,6 +529,165 @@ get_storage_options_from_node_params(rclcpp::Node & node)
     storage_options.custom_data[key_string] = value_string;
   }
 
+  storage_options.shard_cache_per_topic =
+    node.declare_parameter<bool>("storage.shard_cache_per_topic", false);
+
+  auto list_of_topic_groups = node.declare_parameter<std::vector<std::string>>(
+    "storage.cache_topic_groups",
+    std::vector<std::string>());
+  for (const auto & topic_group_string : list_of_topic_groups) {
+    auto delimiter_pos = topic_group_string.find("=", 0);
+    if (delimiter_pos == std::string::npos) {
+      std::stringstream ss;
+      ss << "The storage.cache_topic_groups expected to be as list of the "
+        "group=topic[,topic...] strings. The `=` not found in the " << topic_group_string;
+      throw std::invalid_argument(ss.str());
+    }
+    auto & topics =
+      storage_options.cache_topic_groups[topic_group_string.substr(0, delimiter_pos)];
+    std::stringstream topics_stream(topic_group_string.substr(delimiter_pos + 1));
+    std::string topic;
+    while (std::getline(topics_stream, topic, ',')) {
+      if (!topic.empty()) {
+        topics.push_back(topic);
+      }
+    }
+  }
+
+  auto list_of_shard_sizes = node.declare_parameter<std::vector<std::string>>(
+    "storage.cache_shard_sizes",
+    std::vector<std::string>());
+  for (const auto & shard_size_string : list_of_shard_sizes) {
+    auto delimiter_pos = shard_size_string.find("=", 0);
+    if (delimiter_pos == std::string::npos) {
+      std::stringstream ss;
+      ss << "The storage.cache_shard_sizes expected to be as list of the name=bytes strings. "
+        "The `=` not found in the " << shard_size_string;
+      throw std::invalid_argument(ss.str());
+    }
+    storage_options.cache_shard_sizes[shard_size_string.substr(0, delimiter_pos)] =
+      std::stoull(shard_size_string.substr(delimiter_pos + 1));
+  }
+
+  auto list_of_shard_policies = node.declare_parameter<std::vector<std::string>>(
+    "storage.cache_shard_policies",
+    std::vector<std::string>());
+  for (const auto & shard_policy_string : list_of_shard_policies) {
+    auto delimiter_pos = shard_policy_string.find("=", 0);
+    if (delimiter_pos == std::string::npos) {
+      std::stringstream ss;
+      ss << "The storage.cache_shard_policies expected to be as list of the name=policy "
+        "strings. The `=` not found in the " << shard_policy_string;
+      throw std::invalid_argument(ss.str());
+    }
+    storage_options.cache_shard_policies[shard_policy_string.substr(0, delimiter_pos)] =
+      shard_policy_string.substr(delimiter_pos + 1);
+  }
+
+  auto list_of_topic_priorities = node.declare_parameter<std::vector<std::string>>(
+    "storage.cache_topic_priorities",
+    std::vector<std::string>());
+  for (const auto & topic_priority_string : list_of_topic_priorities) {
+    auto delimiter_pos = topic_priority_string.find("=", 0);
+    if (delimiter_pos == std::string::npos) {
+      std::stringstream ss;
+      ss << "The storage.cache_topic_priorities expected to be as list of the topic=priority "
+        "strings. The `=` not found in the " << topic_priority_string;
+      throw std::invalid_argument(ss.str());
+    }
+    storage_options.cache_topic_priorities[topic_priority_string.substr(0, delimiter_pos)] =
+      static_cast<uint32_t>(std::stoul(topic_priority_string.substr(delimiter_pos + 1)));
+  }
+
+  storage_options.cache_overflow_policy =
+    node.declare_parameter<std::string>("storage.cache_overflow_policy", "drop_newest");
+
+  storage_options.cache_block_timeout_ms = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.cache_block_timeout_ms", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.cache_spill_directory =
+    node.declare_parameter<std::string>("storage.cache_spill_directory", "");
+
+  storage_options.cache_spill_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.cache_spill_size", 1, std::numeric_limits<int64_t>::max(),
+    storage_options.cache_spill_size);
+
+  storage_options.cache_min_batch_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.cache_min_batch_size", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.cache_max_batch_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.cache_max_batch_size", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.cache_max_batch_latency_ms =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.cache_max_batch_latency_ms", 1, std::numeric_limits<int64_t>::max(),
+    storage_options.cache_max_batch_latency_ms);
+
+  storage_options.cache_adaptive_batching =
+    node.declare_parameter<bool>("storage.cache_adaptive_batching", false);
+
+  storage_options.async_split = node.declare_parameter<bool>("storage.async_split", false);
+
+  storage_options.max_bag_retention_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.max_bag_retention_size", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.max_bag_retention_duration =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.max_bag_retention_duration", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.preallocate_bagfiles =
+    node.declare_parameter<bool>("storage.preallocate_bagfiles", false);
+
+  storage_options.durability_interval_ms = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.durability_interval_ms", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.durability_bytes = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.durability_bytes", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.message_definition_cache_directory =
+    node.declare_parameter<std::string>("storage.message_definition_cache_directory", "");
+
+  storage_options.message_definition_threads = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.message_definition_threads", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.message_definition_threads);
+
+  storage_options.cache_consumer_thread_policy =
+    param_utils::declare_thread_policy_node_param(node, "storage.cache_consumer_thread_policy");
+
+  storage_options.cache_consumer_thread_priority =
+    param_utils::declare_integer_node_params<int32_t>(
+    node, "storage.cache_consumer_thread_priority", 0, 99, 0);
+
+  storage_options.cache_consumer_thread_cpus =
+    param_utils::declare_cpus_node_param<uint64_t>(node, "storage.cache_consumer_thread_cpus");
+
+  storage_options.deduplication_min_payload_size =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.deduplication_min_payload_size", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.deduplication_min_payload_size);
+
+  storage_options.deduplication_cache_size = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.deduplication_cache_size", 0, std::numeric_limits<int64_t>::max(),
+    storage_options.deduplication_cache_size);
+
+  storage_options.delta_encoded_topics = node.declare_parameter<std::vector<std::string>>(
+    "storage.delta_encoded_topics", std::vector<std::string>());
+
+  storage_options.delta_keyframe_interval = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.delta_keyframe_interval", 1, std::numeric_limits<int64_t>::max(),
+    storage_options.delta_keyframe_interval);
+
+  storage_options.preview_bucket_duration_ms =
+    param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.preview_bucket_duration_ms", 0, std::numeric_limits<int64_t>::max(), 0);
+
+  storage_options.preview_sample_topics = node.declare_parameter<std::vector<std::string>>(
+    "storage.preview_sample_topics", std::vector<std::string>());
+
+  storage_options.preview_sample_interval = param_utils::declare_integer_node_params<uint64_t>(
+    node, "storage.preview_sample_interval", 1, std::numeric_limits<int64_t>::max(),
+    storage_options.preview_sample_interval);
+
   storage_options.start_time_ns = param_utils::declare_integer_node_params<int64_t>(
     node, "storage.start_time_ns", std::numeric_limits<int64_t>::min(),
     std::numeric_limits<int64_t>::max(), storage_options.start_time_ns);
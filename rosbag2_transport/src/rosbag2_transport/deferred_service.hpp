@@ -0,0 +1,69 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSBAG2_TRANSPORT__DEFERRED_SERVICE_HPP_
+#define ROSBAG2_TRANSPORT__DEFERRED_SERVICE_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rosbag2_transport/publisher_thread_pool.hpp"
+
+namespace rosbag2_transport
+{
+
+/**
+ * Create a service whose requests are handled on a thread of the given pool instead of the
+ * executor, for requests which may wait on playback or on the writer.
+ *
+ * The executor only queues the request and returns, the response is sent from the pool once
+ * the handler returned. The requests of all deferred services sharing the pool are handled one
+ * after another, in the order they were received.
+ */
+template<typename ServiceT>
+typename rclcpp::Service<ServiceT>::SharedPtr create_deferred_service(
+  rclcpp::Node & node,
+  const std::string & service_name,
+  PublisherThreadPool & pool,
+  std::function<void(
+    const std::shared_ptr<typename ServiceT::Request> &,
+    typename ServiceT::Response &)> handler,
+  rclcpp::CallbackGroup::SharedPtr callback_group)
+{
+  return node.create_service<ServiceT>(
+    service_name,
+    [&pool, handler = std::move(handler)](
+      std::shared_ptr<rclcpp::Service<ServiceT>> service,
+      std::shared_ptr<rmw_request_id_t> request_header,
+      std::shared_ptr<typename ServiceT::Request> request)
+    {
+      std::weak_ptr<rclcpp::Service<ServiceT>> weak_service = service;
+      pool.queue(
+        "control", [weak_service, request_header, request, handler]() {
+          typename ServiceT::Response response;
+          handler(request, response);
+          if (auto service = weak_service.lock()) {
+            service->send_response(*request_header, response);
+          }
+        });
+    },
+    rclcpp::ServicesQoS(), std::move(callback_group));
+}
+
+}  // namespace rosbag2_transport
+
+#endif  // ROSBAG2_TRANSPORT__DEFERRED_SERVICE_HPP_
@@ -0,0 +1,83 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/intra_process_capture.hpp"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+
+namespace rosbag2_transport
+{
+
+IntraProcessCapture::Registration::Registration(std::string topic_name, uint64_t id)
+: topic_name_(std::move(topic_name)), id_(id)
+{}
+
+IntraProcessCapture::Registration::~Registration()
+{
+  IntraProcessCapture::instance().remove_sink(topic_name_, id_);
+}
+
+IntraProcessCapture & IntraProcessCapture::instance()
+{
+  static IntraProcessCapture capture;
+  return capture;
+}
+
+std::unique_ptr<IntraProcessCapture::Registration> IntraProcessCapture::add_sink(
+  const std::string & topic_name, Sink sink)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const uint64_t id = next_id_++;
+  sinks_[topic_name].emplace(id, std::move(sink));
+  return std::unique_ptr<Registration>(new Registration(topic_name, id));
+}
+
+bool IntraProcessCapture::is_captured(const std::string & topic_name) const
+{
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return sinks_.count(topic_name) > 0;
+}
+
+void IntraProcessCapture::capture(
+  const std::string & topic_name, std::shared_ptr<const rclcpp::SerializedMessage> message) const
+{
+  // Sinks are called under the shared lock, so that removing a sink waits for its running calls
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto topic_sinks = sinks_.find(topic_name);
+  if (topic_sinks == sinks_.end()) {
+    return;
+  }
+  for (const auto & [id, sink] : topic_sinks->second) {
+    sink(message);
+  }
+}
+
+void IntraProcessCapture::remove_sink(const std::string & topic_name, uint64_t id)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto topic_sinks = sinks_.find(topic_name);
+  if (topic_sinks == sinks_.end()) {
+    return;
+  }
+  topic_sinks->second.erase(id);
+  if (topic_sinks->second.empty()) {
+    sinks_.erase(topic_sinks);
+  }
+}
+
+}  // namespace rosbag2_transport
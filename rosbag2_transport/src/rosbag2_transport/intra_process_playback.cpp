@@ -0,0 +1,120 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/intra_process_playback.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rosbag2_transport
+{
+
+IntraProcessPlayback::Registration::Registration(std::function<void()> remove)
+: remove_(std::move(remove))
+{}
+
+IntraProcessPlayback::Registration::~Registration()
+{
+  remove_();
+}
+
+IntraProcessPlayback & IntraProcessPlayback::instance()
+{
+  static IntraProcessPlayback playback;
+  return playback;
+}
+
+std::unique_ptr<IntraProcessPlayback::Registration> IntraProcessPlayback::add_subscriber(
+  const std::string & topic_name, std::type_index type, Deserializer deserializer,
+  Callback callback)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const uint64_t id = next_id_++;
+  subscribers_[topic_name].emplace(
+    id, Subscriber{type, std::move(deserializer), std::move(callback)});
+  return std::unique_ptr<Registration>(
+    new Registration([this, topic_name, id]() {remove_subscriber(topic_name, id);}));
+}
+
+std::unique_ptr<IntraProcessPlayback::Registration> IntraProcessPlayback::add_player_publisher(
+  const rmw_gid_t & gid)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const uint64_t id = next_id_++;
+  player_publishers_.emplace(id, gid);
+  return std::unique_ptr<Registration>(
+    new Registration([this, id]() {remove_player_publisher(id);}));
+}
+
+bool IntraProcessPlayback::is_player_publisher(const rmw_gid_t & gid) const
+{
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return std::any_of(
+    player_publishers_.begin(), player_publishers_.end(),
+    [&gid](const auto & player_publisher) {
+      return std::memcmp(player_publisher.second.data, gid.data, RMW_GID_STORAGE_SIZE) == 0;
+    });
+}
+
+size_t IntraProcessPlayback::deliver(
+  const std::string & topic_name, const rclcpp::SerializedMessage & message) const
+{
+  // Subscribers are called under the shared lock, so that removing a subscriber waits for its
+  // running calls
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto topic_subscribers = subscribers_.find(topic_name);
+  if (topic_subscribers == subscribers_.end()) {
+    return 0;
+  }
+  // Deserialized once per type, topics rarely have subscribers of more than one type
+  std::vector<std::pair<std::type_index, std::shared_ptr<const void>>> deserialized;
+  for (const auto & [id, subscriber] : topic_subscribers->second) {
+    auto typed_message = std::find_if(
+      deserialized.begin(), deserialized.end(),
+      [&subscriber](const auto & entry) {return entry.first == subscriber.type;});
+    if (typed_message == deserialized.end()) {
+      typed_message = deserialized.emplace(
+        deserialized.end(), subscriber.type, subscriber.deserializer(message));
+    }
+    subscriber.callback(typed_message->second);
+  }
+  return topic_subscribers->second.size();
+}
+
+void IntraProcessPlayback::remove_subscriber(const std::string & topic_name, uint64_t id)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto topic_subscribers = subscribers_.find(topic_name);
+  if (topic_subscribers == subscribers_.end()) {
+    return;
+  }
+  topic_subscribers->second.erase(id);
+  if (topic_subscribers->second.empty()) {
+    subscribers_.erase(topic_subscribers);
+  }
+}
+
+void IntraProcessPlayback::remove_player_publisher(uint64_t id)
+{
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  player_publishers_.erase(id);
+}
+
+}  // namespace rosbag2_transport
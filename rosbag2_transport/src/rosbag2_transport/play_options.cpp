@@ -38,6 +38,12 @@ Node convert<rosbag2_transport::PlayOptions>::encode(
     play_options.topic_qos_profile_overrides);
   node["loop"] = play_options.loop;
   node["topic_remapping_options"] = play_options.topic_remapping_options;
+  for (const auto & [topic, decimation] : play_options.topic_decimation) {
+    node["topic_decimation"][topic] = decimation;
+  }
+  for (const auto & [topic, policy] : play_options.topic_publish_policies) {
+    node["topic_publish_policies"][topic] = policy;
+  }
   node["clock_publish_frequency"] = play_options.clock_publish_frequency;
   node["clock_publish_on_topic_publish"] = play_options.clock_publish_on_topic_publish;
   node["clock_trigger_topics"] = play_options.clock_trigger_topics;
@@ -55,6 +61,32 @@ Node convert<rosbag2_transport::PlayOptions>::encode(
     std::chrono::nanoseconds(play_options.wait_acked_timeout));
 
   node["disable_loan_message"] = play_options.disable_loan_message;
+  node["prefetch_queue_bytes"] = play_options.prefetch_queue_bytes;
+  node["read_ahead_queue_bytes"] = play_options.read_ahead_queue_bytes;
+  node["publishing_threads"] = play_options.publishing_threads;
+  node["precise_timing_spin_duration"] = YAML::convert<rclcpp::Duration>::encode(
+    std::chrono::nanoseconds(play_options.precise_timing_spin_duration));
+  node["playback_thread_priority"] = play_options.playback_thread_priority;
+  node["playback_thread_policy"] = play_options.playback_thread_policy;
+  node["playback_thread_cpus"] = play_options.playback_thread_cpus;
+  node["storage_loading_thread_priority"] = play_options.storage_loading_thread_priority;
+  node["storage_loading_thread_policy"] = play_options.storage_loading_thread_policy;
+  node["storage_loading_thread_cpus"] = play_options.storage_loading_thread_cpus;
+  node["release_window"] = YAML::convert<rclcpp::Duration>::encode(
+    std::chrono::nanoseconds(play_options.release_window));
+  node["as_fast_as_possible"] = play_options.as_fast_as_possible;
+  node["seek_history_duration"] = YAML::convert<rclcpp::Duration>::encode(
+    std::chrono::nanoseconds(play_options.seek_history_duration));
+  node["publisher_creation_threads"] = play_options.publisher_creation_threads;
+  node["loop_cache_bytes"] = play_options.loop_cache_bytes;
+  node["preload"] = play_options.preload;
+  node["preload_max_bytes"] = play_options.preload_max_bytes;
+  node["step_clock_topic"] = play_options.step_clock_topic;
+  node["intra_process_playback"] = play_options.intra_process_playback;
+  node["clock_publish_thread"] = play_options.clock_publish_thread;
+  node["clock_publish_thread_priority"] = play_options.clock_publish_thread_priority;
+  node["statistics_publish_interval"] = YAML::convert<rclcpp::Duration>::encode(
+    std::chrono::nanoseconds(play_options.statistics_publish_interval));
 
   return node;
 }
@@ -74,6 +106,24 @@ bool convert<rosbag2_transport::PlayOptions>::decode(
   optional_assign<std::unordered_map<std::string, rclcpp::QoS>>(
     node, "topic_qos_profile_overrides", play_options.topic_qos_profile_overrides);
 
+  if (node["topic_decimation"]) {
+    play_options.topic_decimation.clear();
+    for (const auto & topic_decimation : node["topic_decimation"]) {
+      play_options.topic_decimation.emplace(
+        topic_decimation.first.as<std::string>(),
+        topic_decimation.second.as<rosbag2_transport::TopicDecimation>());
+    }
+  }
+
+  if (node["topic_publish_policies"]) {
+    play_options.topic_publish_policies.clear();
+    for (const auto & topic_policy : node["topic_publish_policies"]) {
+      play_options.topic_publish_policies.emplace(
+        topic_policy.first.as<std::string>(),
+        topic_policy.second.as<rosbag2_transport::TopicPublishPolicy>());
+    }
+  }
+
   optional_assign<double>(node, "clock_publish_frequency", play_options.clock_publish_frequency);
 
   optional_assign<bool>(
@@ -103,7 +153,75 @@ bool convert<rosbag2_transport::PlayOptions>::decode(
   play_options.wait_acked_timeout = wait_acked_timeout.nanoseconds();
 
   optional_assign<bool>(node, "disable_loan_message", play_options.disable_loan_message);
+  optional_assign<uint64_t>(node, "prefetch_queue_bytes", play_options.prefetch_queue_bytes);
+  optional_assign<uint64_t>(node, "read_ahead_queue_bytes", play_options.read_ahead_queue_bytes);
+  optional_assign<uint64_t>(node, "publishing_threads", play_options.publishing_threads);
+
+  rclcpp::Duration precise_timing_spin_duration(
+    std::chrono::nanoseconds(play_options.precise_timing_spin_duration));
+  optional_assign<rclcpp::Duration>(
+    node, "precise_timing_spin_duration", precise_timing_spin_duration);
+  play_options.precise_timing_spin_duration = precise_timing_spin_duration.nanoseconds();
+
+  optional_assign<int>(node, "playback_thread_priority", play_options.playback_thread_priority);
+  optional_assign<std::string>(node, "playback_thread_policy", play_options.playback_thread_policy);
+  optional_assign<std::vector<size_t>>(
+    node, "playback_thread_cpus", play_options.playback_thread_cpus);
+  optional_assign<int>(
+    node, "storage_loading_thread_priority", play_options.storage_loading_thread_priority);
+  optional_assign<std::string>(
+    node, "storage_loading_thread_policy", play_options.storage_loading_thread_policy);
+  optional_assign<std::vector<size_t>>(
+    node, "storage_loading_thread_cpus", play_options.storage_loading_thread_cpus);
+
+  rclcpp::Duration release_window(std::chrono::nanoseconds(play_options.release_window));
+  optional_assign<rclcpp::Duration>(node, "release_window", release_window);
+  play_options.release_window = release_window.nanoseconds();
+
+  optional_assign<bool>(node, "as_fast_as_possible", play_options.as_fast_as_possible);
+
+  rclcpp::Duration seek_history_duration(
+    std::chrono::nanoseconds(play_options.seek_history_duration));
+  optional_assign<rclcpp::Duration>(node, "seek_history_duration", seek_history_duration);
+  play_options.seek_history_duration = seek_history_duration.nanoseconds();
+
+  optional_assign<uint64_t>(
+    node, "publisher_creation_threads", play_options.publisher_creation_threads);
+  optional_assign<uint64_t>(node, "loop_cache_bytes", play_options.loop_cache_bytes);
+  optional_assign<bool>(node, "preload", play_options.preload);
+  optional_assign<uint64_t>(node, "preload_max_bytes", play_options.preload_max_bytes);
+  optional_assign<std::string>(node, "step_clock_topic", play_options.step_clock_topic);
+  optional_assign<bool>(node, "intra_process_playback", play_options.intra_process_playback);
+  optional_assign<bool>(node, "clock_publish_thread", play_options.clock_publish_thread);
+  optional_assign<int>(
+    node, "clock_publish_thread_priority", play_options.clock_publish_thread_priority);
+
+  rclcpp::Duration statistics_publish_interval(
+    std::chrono::nanoseconds(play_options.statistics_publish_interval));
+  optional_assign<rclcpp::Duration>(
+    node, "statistics_publish_interval", statistics_publish_interval);
+  play_options.statistics_publish_interval = statistics_publish_interval.nanoseconds();
+
+  return true;
+}
 
+Node convert<rosbag2_transport::TopicPublishPolicy>::encode(
+  const rosbag2_transport::TopicPublishPolicy & policy)
+{
+  Node node;
+  node["deadline"] = YAML::convert<rclcpp::Duration>::encode(
+    std::chrono::nanoseconds(policy.deadline));
+  node["overflow"] = policy.overflow;
+  return node;
+}
+
+bool convert<rosbag2_transport::TopicPublishPolicy>::decode(
+  const Node & node, rosbag2_transport::TopicPublishPolicy & policy)
+{
+  rclcpp::Duration deadline(std::chrono::nanoseconds(policy.deadline));
+  optional_assign<rclcpp::Duration>(node, "deadline", deadline);
+  policy.deadline = deadline.nanoseconds();
+  optional_assign<std::string>(node, "overflow", policy.overflow);
   return true;
 }
 
@@ -15,8 +15,18 @@
 #include "rosbag2_transport/player.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -26,14 +36,32 @@
 #include "rcl/graph.h"
 
 #include "rclcpp/rclcpp.hpp"
+#include "rcpputils/scope_exit.hpp"
 #include "rcpputils/unique_lock.hpp"
+#include "rcutils/allocator.h"
 #include "rcutils/time.h"
 
+#include "rosbag2_cpp/clocks/external_step_clock.hpp"
 #include "rosbag2_cpp/clocks/time_controller_clock.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
 #include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_cpp/thread_scheduling.hpp"
+#include "rosbag2_cpp/tracing.hpp"
+#include "rosbag2_cpp/typesupport_helpers.hpp"
+#include "rosbag2_interfaces/msg/play_statistics.hpp"
+#include "rosbag2_interfaces/msg/topic_publish_incidents.hpp"
+#include "rosbag2_storage/interned_topic.hpp"
 #include "rosbag2_storage/storage_filter.hpp"
 #include "rosbag2_storage/qos.hpp"
 #include "rosbag2_transport/config_options_from_node_params.hpp"
+#include "rosbag2_transport/intra_process_playback.hpp"
+#include "rosbag2_transport/preloaded_bag.hpp"
+#include "rosbag2_transport/publisher_thread_pool.hpp"
+#include "rosbag2_transport/reader_writer_factory.hpp"
+#include "rosbag2_transport/reverse_block_reader.hpp"
+#include "rosbag2_transport/topic_decimator.hpp"
+
+#include "deferred_service.hpp"
 
 namespace
 {
@@ -67,6 +95,113 @@ rclcpp::QoS publisher_qos_for_topic(
     topic.name,
     rosbag2_storage::from_rclcpp_qos_vector(topic.offered_qos_profiles));
 }
+
+void deallocate_nothing(void *, void *) {}
+
+/**
+ * Wrap serialized data read from a bag in a SerializedMessage without copying it.
+ *
+ * The SerializedMessage does not free the buffer, which must outlive it.
+ */
+rclcpp::SerializedMessage make_serialized_message_view(
+  const rcutils_uint8_array_t & serialized_data)
+{
+  rcl_serialized_message_t view = serialized_data;
+  view.allocator = rcutils_get_default_allocator();
+  view.allocator.deallocate = deallocate_nothing;
+  return rclcpp::SerializedMessage(std::move(view));
+}
+
+/// Counts how late messages are released for publishing, in doubling buckets from 1 us.
+class PublishDelayHistogram
+{
+public:
+  void add(std::chrono::nanoseconds delay)
+  {
+    const auto delay_us = std::max<int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(delay).count(), 0);
+    size_t bucket = 0;
+    while (bucket + 1 < counts_.size() && (int64_t{1} << bucket) <= delay_us) {
+      ++bucket;
+    }
+    ++counts_[bucket];
+    ++count_;
+    max_delay_ = std::max(max_delay_, delay);
+  }
+
+  size_t count() const
+  {
+    return count_;
+  }
+
+  void clear()
+  {
+    counts_.fill(0);
+    count_ = 0;
+    max_delay_ = std::chrono::nanoseconds{0};
+  }
+
+  std::string to_string() const
+  {
+    std::ostringstream oss;
+    oss << count_ << " releases, max " <<
+      std::chrono::duration_cast<std::chrono::microseconds>(max_delay_).count() << " us:";
+    for (size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+      if (counts_[bucket] == 0) {
+        continue;
+      }
+      if (bucket + 1 < counts_.size()) {
+        oss << " <" << (int64_t{1} << bucket) << " us: ";
+      } else {
+        oss << " >=" << (int64_t{1} << (bucket - 1)) << " us: ";
+      }
+      oss << counts_[bucket];
+    }
+    return oss.str();
+  }
+
+private:
+  // The last bucket counts the delays of at least 2^20 us, i.e. about a second
+  std::array<size_t, 22> counts_{};
+  size_t count_ = 0;
+  std::chrono::nanoseconds max_delay_{0};
+};
+
+rosbag2_interfaces::msg::PipelineStageStatistics to_stage_statistics(
+  const std::string & stage, const rosbag2_cpp::LatencyHistogram & histogram)
+{
+  rosbag2_interfaces::msg::PipelineStageStatistics statistics;
+  statistics.stage = stage;
+  statistics.count = histogram.count();
+  statistics.mean = histogram.mean().count();
+  statistics.p50 = histogram.percentile(50.0).count();
+  statistics.p90 = histogram.percentile(90.0).count();
+  statistics.p99 = histogram.percentile(99.0).count();
+  statistics.max = histogram.max().count();
+  return statistics;
+}
+
+const rosbag2_storage::StorageOptions & get_first_bag(
+  const std::vector<rosbag2_storage::StorageOptions> & storage_options)
+{
+  if (storage_options.empty()) {
+    throw std::invalid_argument("Player needs at least one bag to play.");
+  }
+  return storage_options.front();
+}
+
+// Reader counts of on-play message callbacks the calling thread is in, innermost last
+thread_local std::vector<const std::atomic<size_t> *> on_play_msg_callbacks_readers_of_thread;
+
+rosbag2_cpp::ThreadScheduling make_thread_scheduling(
+  const std::string & policy, int priority, const std::vector<size_t> & cpus)
+{
+  rosbag2_cpp::ThreadScheduling scheduling;
+  scheduling.policy = policy;
+  scheduling.priority = priority;
+  scheduling.cpus = cpus;
+  return scheduling;
+}
 }  // namespace
 
 namespace rosbag2_transport
@@ -205,17 +340,48 @@ protected:
     play_msg_callback_t callback;
   };
 
+  using play_msg_callbacks_t = std::forward_list<play_msg_callback_data>;
+
+  // The callback lists are replaced by modified copies under on_play_msg_callbacks_mutex_ and
+  // read through std::atomic_load() without locking, so that registering callbacks does not
+  // stall playback. The flags tell publish_message() that a list is empty without loading it.
   std::mutex on_play_msg_callbacks_mutex_;
-  std::forward_list<play_msg_callback_data> on_play_msg_pre_callbacks_;
-  std::forward_list<play_msg_callback_data> on_play_msg_post_callbacks_;
+  std::shared_ptr<const play_msg_callbacks_t> on_play_msg_pre_callbacks_;
+  std::shared_ptr<const play_msg_callbacks_t> on_play_msg_post_callbacks_;
+  std::atomic_bool has_on_play_msg_pre_callbacks_{false};
+  std::atomic_bool has_on_play_msg_post_callbacks_{false};
+  // Grace period of deleted callbacks. Threads calling a list count themselves as readers of the
+  // current epoch. A deletion flips the epoch and waits for the readers of the previous epoch to
+  // leave, until it waited for both slots. Then no thread calls a list loaded before the deletion.
+  std::atomic<size_t> on_play_msg_callbacks_epoch_{0};
+  std::array<std::atomic<size_t>, 2> on_play_msg_callbacks_readers_{};
+  std::atomic<size_t> on_play_msg_callbacks_waiting_for_readers_{0};
+  std::mutex on_play_msg_callbacks_readers_mutex_;
+  std::condition_variable on_play_msg_callbacks_readers_cv_;
+
+  // Replace callbacks by a copy changed by update. Requires on_play_msg_callbacks_mutex_.
+  static void update_on_play_msg_callbacks(
+    std::shared_ptr<const play_msg_callbacks_t> & callbacks, std::atomic_bool & has_callbacks,
+    const std::function<void(play_msg_callbacks_t &)> & update);
+  // Wait for the calls of callbacks replaced before to return. Must be called without holding
+  // on_play_msg_callbacks_mutex_, which callbacks may take to register callbacks.
+  void wait_for_on_play_msg_callbacks_readers();
+  void call_on_play_msg_callbacks(
+    const std::shared_ptr<const play_msg_callbacks_t> & callbacks,
+    const std::atomic_bool & has_callbacks,
+    const rosbag2_storage::SerializedBagMessageSharedPtr & message);
+  static size_t count_on_play_msg_callbacks(
+    const std::shared_ptr<const play_msg_callbacks_t> & callbacks);
 
   class PlayerPublisher final
   {
 public:
     explicit PlayerPublisher(
       std::shared_ptr<rclcpp::GenericPublisher> pub,
-      bool disable_loan_message)
-    : publisher_(std::move(pub))
+      bool disable_loan_message,
+      bool intra_process_playback = false)
+    : publisher_(std::move(pub)),
+      topic_name_(publisher_->get_topic_name())
     {
       using std::placeholders::_1;
       if (disable_loan_message || !publisher_->can_loan_messages()) {
@@ -223,12 +389,24 @@ public:
       } else {
         publish_func_ = std::bind(&rclcpp::GenericPublisher::publish_as_loaned_msg, publisher_, _1);
       }
+      if (intra_process_playback) {
+        intra_process_registration_ =
+          IntraProcessPlayback::instance().add_player_publisher(publisher_->get_gid());
+      }
     }
 
     ~PlayerPublisher() = default;
 
     void publish(const rclcpp::SerializedMessage & message)
     {
+      if (intra_process_registration_) {
+        const size_t delivered = IntraProcessPlayback::instance().deliver(topic_name_, message);
+        // Only the subscribers outside of the intra-process playback need the middleware
+        if (delivered > 0 && publisher_->get_subscription_count() <= delivered) {
+          return;
+        }
+      }
+      unacked_.store(true, std::memory_order_relaxed);
       publish_func_(message);
     }
 
@@ -237,9 +415,230 @@ public:
       return publisher_;
     }
 
+    // Count a published message and wait for the subscribers to acknowledge all of them once the
+    // history of the publisher is full, so that none is overwritten before it is delivered.
+    // Return false if they were not acknowledged within the timeout.
+    bool wait_for_acked_history(std::chrono::milliseconds timeout)
+    {
+      if (history_depth_ == 0) {
+        history_depth_ = std::max<size_t>(publisher_->get_actual_qos().depth(), 1);
+      }
+      if (++unacked_messages_ < history_depth_) {
+        return true;
+      }
+      unacked_messages_ = 0;
+      return wait_for_acked(timeout);
+    }
+
+    // Whether messages were handed to the middleware since the subscribers last acknowledged
+    // all of them
+    bool has_unacked_messages() const
+    {
+      return unacked_.load(std::memory_order_relaxed);
+    }
+
+    // Wait for the subscribers to acknowledge the published messages, without waiting if
+    // nothing was published since they last did. Return false if they were not acknowledged
+    // within the timeout.
+    bool wait_for_acked(std::chrono::milliseconds timeout)
+    {
+      if (!unacked_.exchange(false)) {
+        return true;
+      }
+      bool acked = false;
+      try {
+        acked = publisher_->wait_for_all_acked(timeout);
+      } catch (...) {
+        unacked_ = true;
+        throw;
+      }
+      if (!acked) {
+        unacked_ = true;
+      }
+      return acked;
+    }
+
 private:
     std::shared_ptr<rclcpp::GenericPublisher> publisher_;
+    std::string topic_name_;
     std::function<void(const rclcpp::SerializedMessage &)> publish_func_;
+    // Set if the messages are handed to PlaybackSubscriptions in the process directly
+    std::unique_ptr<IntraProcessPlayback::Registration> intra_process_registration_;
+    size_t history_depth_ = 0;
+    size_t unacked_messages_ = 0;
+    std::atomic_bool unacked_{false};
+  };
+  // Publishes the messages of a topic with a PlayOptions::topic_publish_policies entry. Unless its
+  // overflow is "block", the messages are published on a thread of the topic, and playback only
+  // waits for them until the deadline, so that a subscriber which stops taking the messages of
+  // the topic does not hold up the other topics.
+  class IsolatedPublisher final
+  {
+public:
+    IsolatedPublisher(
+      std::shared_ptr<PlayerPublisher> publisher, const TopicPublishPolicy & policy,
+      const std::string & topic_name, rclcpp::Logger logger)
+    : publisher_(std::move(publisher)),
+      deadline_(policy.deadline),
+      block_(policy.overflow == "block"),
+      detach_(policy.overflow == "detach"),
+      topic_name_(topic_name),
+      logger_(std::move(logger))
+    {
+      if (!block_ && !detach_ && policy.overflow != "skip") {
+        throw std::runtime_error(
+                "Invalid publish overflow policy '" + policy.overflow + "' of topic '" +
+                topic_name + "', expected 'block', 'skip' or 'detach'");
+      }
+      if (policy.deadline <= 0) {
+        throw std::runtime_error(
+                "The publish deadline of topic '" + topic_name + "' must be positive");
+      }
+      if (block_) {
+        return;
+      }
+      // A detached topic keeps as many messages as its publisher would
+      max_queued_messages_ = detach_ ?
+        std::max<size_t>(publisher_->generic_publisher()->get_actual_qos().depth(), 1) : 0;
+      thread_ = std::thread(&IsolatedPublisher::run, this);
+    }
+
+    ~IsolatedPublisher()
+    {
+      if (!thread_.joinable()) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        queue_.clear();
+        condition_.notify_all();
+      }
+      // Waits for a publish call in progress, which returns once the middleware gives up on it
+      thread_.join();
+    }
+
+    // Return false if the message was skipped because the topic was still publishing earlier
+    // messages
+    bool publish(const rosbag2_storage::SerializedBagMessageSharedPtr & message)
+    {
+      if (block_) {
+        const auto publish_start = std::chrono::steady_clock::now();
+        publisher_->publish(make_serialized_message_view(*message->serialized_data));
+        if (std::chrono::steady_clock::now() - publish_start > deadline_) {
+          missed_deadlines_++;
+        }
+        return true;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (publishing_ || !queue_.empty()) {
+        // Still publishing a message which missed its deadline, playback does not wait again
+        if (queue_.size() >= max_queued_messages_) {
+          dropped_messages_++;
+          if (!detach_) {
+            return false;
+          }
+          queue_.pop_front();
+          finished_messages_++;
+        }
+        queue_.push_back(message);
+        queued_messages_++;
+        condition_.notify_all();
+        return true;
+      }
+      queue_.push_back(message);
+      const uint64_t message_number = ++queued_messages_;
+      condition_.notify_all();
+      if (!condition_.wait_for(
+          lock, deadline_, [this, message_number]() {
+            return finished_messages_ >= message_number;
+          }))
+      {
+        missed_deadlines_++;
+        detached_ = detach_;
+        RCLCPP_WARN_STREAM(
+          logger_,
+          "Publishing a message on '" << topic_name_ << "' missed its deadline, " <<
+            (detach_ ? "queueing" : "skipping") << " the messages of the topic until it is " <<
+            "published.");
+      }
+      return true;
+    }
+
+    rosbag2_interfaces::msg::TopicPublishIncidents get_incidents() const
+    {
+      rosbag2_interfaces::msg::TopicPublishIncidents incidents;
+      incidents.topic = topic_name_;
+      incidents.missed_deadlines = missed_deadlines_;
+      incidents.dropped_messages = dropped_messages_;
+      std::lock_guard<std::mutex> lock(mutex_);
+      incidents.detached = detached_;
+      return incidents;
+    }
+
+    void reset_incidents()
+    {
+      missed_deadlines_ = 0;
+      dropped_messages_ = 0;
+    }
+
+private:
+    void run()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true) {
+        condition_.wait(
+          lock, [this]() {
+            return stop_ || !queue_.empty();
+          });
+        if (stop_) {
+          return;
+        }
+        auto message = std::move(queue_.front());
+        queue_.pop_front();
+        publishing_ = true;
+        lock.unlock();
+        try {
+          publisher_->publish(make_serialized_message_view(*message->serialized_data));
+        } catch (const std::exception & e) {
+          RCLCPP_ERROR_STREAM(
+            logger_, "Failed to publish message on '" << topic_name_ << "' topic. \nError: " <<
+              e.what());
+        }
+        message.reset();
+        lock.lock();
+        publishing_ = false;
+        finished_messages_++;
+        if (detached_ && queue_.empty()) {
+          detached_ = false;
+          RCLCPP_INFO_STREAM(logger_, "Publishing on '" << topic_name_ << "' caught up.");
+        }
+        condition_.notify_all();
+      }
+    }
+
+    std::shared_ptr<PlayerPublisher> publisher_;
+    const std::chrono::nanoseconds deadline_;
+    const bool block_;
+    const bool detach_;
+    const std::string topic_name_;
+    rclcpp::Logger logger_;
+    size_t max_queued_messages_ = 0;
+    std::atomic<uint64_t> missed_deadlines_{0};
+    std::atomic<uint64_t> dropped_messages_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<rosbag2_storage::SerializedBagMessageSharedPtr> queue_;
+    // Messages queued and published or dropped so far, to wait for a message to be published
+    uint64_t queued_messages_ = 0;
+    uint64_t finished_messages_ = 0;
+    bool publishing_ = false;
+    bool detached_ = false;
+    bool stop_ = false;
+    // Started last, once the members it uses are initialized
+    std::thread thread_;
   };
   bool is_ready_to_play_from_queue_{false};
   std::mutex ready_to_play_from_queue_mutex_;
@@ -248,12 +647,95 @@ private:
   std::unordered_map<std::string, std::shared_ptr<PlayerImpl::PlayerPublisher>> publishers_;
 
 private:
+  // A topic with a publisher, looked up by the topic_id which enqueue_up_to_boundary() assigns
+  // to the messages read from storage
+  struct PlayedTopic
+  {
+    std::shared_ptr<PlayerPublisher> publisher;
+    // Whether publishing a message of the topic publishes the clock
+    bool triggers_clock = false;
+    // Durations of the publish calls, if PlayOptions::statistics_publish_interval is set
+    std::shared_ptr<rosbag2_cpp::LatencyHistogram> publish_durations;
+    // Publishes the messages of the topic if it has a PlayOptions::topic_publish_policies entry
+    std::shared_ptr<IsolatedPublisher> isolated_publisher;
+  };
+  // A topic prepare_publishers() creates a publisher for
+  struct TopicToPublish
+  {
+    const rosbag2_storage::TopicMetadata * topic;
+    rclcpp::QoS qos;
+    std::shared_ptr<rcpputils::SharedLibrary> typesupport_library;
+    std::shared_ptr<rclcpp::GenericPublisher> publisher;
+    // Why the publisher could not be created
+    std::string error;
+  };
+  // Create the publishers of the topics which have a type support library, on
+  // PlayOptions::publisher_creation_threads threads. They still have to be added to the node.
+  void create_generic_publishers(std::vector<TopicToPublish> & topics_to_publish);
+  // The id in played_topics_ of the topic of a message read from the bag
+  uint32_t find_played_topic_id(const rosbag2_storage::SerializedBagMessage & message) const;
+  // The topic of a message tagged by enqueue_up_to_boundary(), nullptr if it has no publisher
+  const PlayedTopic * get_played_topic(const rosbag2_storage::SerializedBagMessage & message) const;
   rosbag2_storage::SerializedBagMessageSharedPtr peek_next_message_from_queue();
   void load_storage_content();
   bool is_storage_completely_loaded() const;
-  void enqueue_up_to_boundary(size_t boundary) RCPPUTILS_TSA_REQUIRES(reader_mutex_);
-  void wait_for_filled_queue() const;
+  // Read the messages of the whole playback into preloaded_bag_ if PlayOptions::preload is set
+  // and they fit into PlayOptions::preload_max_bytes
+  void preload_bag() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Create the decimators of the played topics in PlayOptions::topic_decimation
+  void create_topic_decimators() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  void enqueue_up_to_boundary() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Read from the preloaded bag or the loop cache when replaying it, otherwise from storage.
+  // Read backwards in time during reverse playback.
+  bool has_next_message() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  rosbag2_storage::SerializedBagMessageSharedPtr read_next_message()
+  RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Read the messages from time_point on, or up to it backwards in time if reverse
+  void seek_message_source(rcutils_time_point_value_t time_point, bool reverse)
+  RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Topic filter of the reader, with the end of playback
+  rosbag2_storage::StorageFilter get_playback_storage_filter() const
+  RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Time from which reverse playback starts, the end of playback or of the bag
+  rcutils_time_point_value_t get_reverse_starting_time() const;
+  // Keep the messages read from storage from the start of playback in the loop cache
+  void start_recording_loop_cache() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  // Drop the loop cache, e.g. when the messages no longer fit into it
+  void stop_recording_loop_cache() RCPPUTILS_TSA_REQUIRES(reader_mutex_);
+  void wait_for_filled_queue();
+  // Start load_storage_content() on a separate thread
+  void start_loading_storage_content();
+  // Size of a queued message, counted against read_ahead_queue_bytes
+  static size_t get_queued_size(const rosbag2_storage::SerializedBagMessage & message);
+  // Pop the front of the message queue, false if it is empty
+  bool pop_message_from_queue();
+  // Pop the front of message_queue_, keeping it in the seek history if
+  // PlayOptions::seek_history_duration is set
+  bool pop_message_from_read_ahead_queue() RCPPUTILS_TSA_REQUIRES(seek_history_mutex_);
+  // Drop the played messages older than seek_history_duration from the seek history
+  void trim_seek_history() RCPPUTILS_TSA_REQUIRES(seek_history_mutex_);
+  // Drop the queued messages and the seek history
+  void purge_message_queue();
+  // Move the playhead to time_point within the seek history or the messages read ahead.
+  // Return false if the messages from time_point on have to be read from storage.
+  bool seek_in_memory(rcutils_time_point_value_t time_point);
+  // Wake up the threads waiting for a change of the message queue
+  void notify_message_queue_changed();
+  // The queue is bounded by read_ahead_queue_bytes if set, otherwise by read_ahead_queue_size
+  bool is_message_queue_below_lower_boundary() const;
+  bool is_message_queue_full() const;
   void play_messages_from_queue();
+  // Wait on the clock until the message is due, or only while paused if as_fast_as_possible.
+  // Return false if the message is not due yet.
+  bool wait_for_message_time(rcutils_time_point_value_t time_stamp);
+  // PlayOptions::wait_acked_timeout, with 0 waiting without timeout
+  std::chrono::milliseconds get_wait_acked_timeout() const;
+  // Apply the playback_thread_* scheduling of the PlayOptions to the calling thread
+  void configure_playback_thread();
+  std::chrono::nanoseconds get_clock_publish_period() const;
+  // Publish /clock with a period until stop_clock_publish_thread() is called
+  void publish_clock_on_thread(std::chrono::nanoseconds publish_period);
+  void stop_clock_publish_thread();
   void prepare_publishers();
   bool publish_message(rosbag2_storage::SerializedBagMessageSharedPtr message);
   static callback_handle_t get_new_on_play_msg_callback_handle();
@@ -263,8 +745,14 @@ private:
     const std::string & op_name);
   void add_keyboard_callbacks();
   void create_control_services();
+  // Subscribe to the steps of PlayOptions::step_clock_topic and publish their completion
+  void create_step_clock_interfaces();
   void configure_play_until_timestamp();
   bool shall_stop_at_timestamp(const rcutils_time_point_value_t & msg_timestamp) const;
+  // Clear the statistics of playback, at the start of play()
+  void reset_playback_statistics();
+  // Publish the statistics measured since play() on ~/play_statistics
+  void publish_playback_statistics();
 
   static constexpr double read_ahead_lower_bound_percentage_ = 0.9;
   static const std::chrono::milliseconds queue_read_wait_period_;
@@ -273,6 +761,30 @@ private:
 
   std::mutex reader_mutex_;
   std::unique_ptr<rosbag2_cpp::Reader> reader_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  // Topic filter of the reader, without the end of playback
+  rosbag2_storage::StorageFilter storage_filter_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  // Messages of the whole playback kept in memory if PlayOptions::loop_cache_bytes is set, so
+  // that loops and seeks after the first pass through the bag do not access the storage
+  std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> loop_cache_
+  RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  size_t loop_cache_bytes_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = 0;
+  bool loop_cache_recording_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = false;
+  // Whether loop_cache_ holds all messages from the start of playback
+  bool loop_cache_complete_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = false;
+  bool replaying_loop_cache_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = false;
+  size_t loop_cache_position_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = 0;
+  // All messages of the playback, read before playback if PlayOptions::preload is set. Played
+  // from memory instead of the storage.
+  std::unique_ptr<PreloadedBag> preloaded_bag_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  size_t preloaded_bag_position_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_) = 0;
+  // Indexed by topic_id like played_topics_, nullptr for the topics which are not decimated.
+  // Empty if no topic is decimated.
+  std::vector<std::unique_ptr<TopicDecimator>> topic_decimators_
+  RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  // Reads the storage backwards in blocks during reverse playback
+  std::unique_ptr<ReverseBlockReader> reverse_reader_ RCPPUTILS_TSA_GUARDED_BY(reader_mutex_);
+  // Whether the messages are read and played backwards in time, for a negative rate
+  std::atomic_bool reverse_playback_{false};
 
   void publish_clock_update();
   void publish_clock_update(const rclcpp::Time & time);
@@ -282,11 +794,39 @@ private:
   rosbag2_transport::PlayOptions play_options_;
   rcutils_time_point_value_t play_until_timestamp_ = -1;
   moodycamel::ReaderWriterQueue<rosbag2_storage::SerializedBagMessageSharedPtr> message_queue_;
+  // Size of the messages in message_queue_, see get_queued_size()
+  std::atomic<size_t> message_queue_bytes_{0};
+  // The thread filling the message queue and the threads taking messages from it wait on
+  // message_queue_cv_ for each other instead of polling the queue
+  std::mutex message_queue_mutex_;
+  std::condition_variable message_queue_cv_;
+  bool storage_loading_finished_ RCPPUTILS_TSA_GUARDED_BY(message_queue_mutex_) = false;
+  // Indexed by topic id, starting with an empty entry for rosbag2_storage::UNASSIGNED_TOPIC_ID.
+  // Only changed by prepare_publishers() in the constructor.
+  std::vector<PlayedTopic> played_topics_;
+  std::unordered_map<std::string, uint32_t> played_topic_ids_;
+  // The same ids indexed by InternedTopic::id, for messages read with an interned topic
+  std::vector<uint32_t> played_topic_ids_by_interned_id_;
+  // Messages taken from message_queue_ kept for seeking without storage access. The ones before
+  // the playhead were played, the ones from it on are played again after seeking back.
+  std::mutex seek_history_mutex_;
+  std::deque<rosbag2_storage::SerializedBagMessageSharedPtr> seek_history_
+  RCPPUTILS_TSA_GUARDED_BY(seek_history_mutex_);
+  size_t seek_history_playhead_ RCPPUTILS_TSA_GUARDED_BY(seek_history_mutex_) = 0;
   mutable std::future<void> storage_loading_future_;
   std::atomic_bool load_storage_content_{true};
   std::unordered_map<std::string, rclcpp::QoS> topic_qos_profile_overrides_;
   std::unique_ptr<rosbag2_cpp::PlayerClock> clock_;
+  // The clock_ if it is stepped by PlayOptions::step_clock_topic, nullptr otherwise
+  rosbag2_cpp::ExternalStepClock * step_clock_ = nullptr;
+  rclcpp::Subscription<rosgraph_msgs::msg::Clock>::SharedPtr step_clock_sub_;
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr step_completed_pub_;
   std::shared_ptr<rclcpp::TimerBase> clock_publish_timer_;
+  // Publishes /clock instead of clock_publish_timer_ if PlayOptions::clock_publish_thread is set
+  std::thread clock_publish_thread_;
+  std::mutex clock_publish_thread_mutex_;
+  std::condition_variable clock_publish_thread_cv_;
+  bool stop_clock_publish_thread_ RCPPUTILS_TSA_GUARDED_BY(clock_publish_thread_mutex_) = false;
   std::mutex skip_message_in_main_play_loop_mutex_;
   bool skip_message_in_main_play_loop_ RCPPUTILS_TSA_GUARDED_BY(
     skip_message_in_main_play_loop_mutex_) = false;
@@ -296,8 +836,13 @@ private:
   std::condition_variable playback_finished_cv_;
 
   rcutils_time_point_value_t starting_time_;
+  // Time stamp of the last message of the bag
+  rcutils_time_point_value_t ending_time_;
 
   // control services
+  rclcpp::CallbackGroup::SharedPtr control_callback_group_;
+  // Handles the control requests which wait on playback, off the executor
+  std::unique_ptr<PublisherThreadPool> control_request_pool_;
   rclcpp::Service<rosbag2_interfaces::srv::Pause>::SharedPtr srv_pause_;
   rclcpp::Service<rosbag2_interfaces::srv::Resume>::SharedPtr srv_resume_;
   rclcpp::Service<rosbag2_interfaces::srv::TogglePaused>::SharedPtr srv_toggle_paused_;
@@ -315,6 +860,25 @@ private:
   // defaults
   std::shared_ptr<KeyboardHandler> keyboard_handler_;
   std::vector<KeyboardHandler::callback_handle_t> keyboard_callbacks_;
+
+  // How late play_messages_from_queue() released the messages. Only used by the playback thread.
+  PublishDelayHistogram publish_delay_histogram_;
+
+  // Statistics of playback, only measured if PlayOptions::statistics_publish_interval is set.
+  // Starvations of the play queue are always counted.
+  bool measure_statistics_ = false;
+  rosbag2_cpp::LatencyHistogram publish_lateness_;
+  rosbag2_cpp::LatencyHistogram publish_earliness_;
+  rosbag2_cpp::LatencyHistogram read_latency_;
+  std::atomic<uint64_t> min_queue_messages_{std::numeric_limits<uint64_t>::max()};
+  std::atomic<uint64_t> starvation_events_{0};
+  std::atomic<int64_t> starved_duration_ns_{0};
+  rclcpp::Publisher<rosbag2_interfaces::msg::PlayStatistics>::SharedPtr statistics_pub_;
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+
+  // Publishes messages in play_messages_from_queue() if PlayOptions::publishing_threads is set.
+  // Declared last, so that its threads are joined before the publishers are destroyed.
+  std::unique_ptr<PublisherThreadPool> publisher_thread_pool_;
 };
 
 PlayerImpl::PlayerImpl(
@@ -336,6 +900,7 @@ PlayerImpl::PlayerImpl(
     auto metadata = reader_->get_metadata();
     starting_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
       metadata.starting_time.time_since_epoch()).count();
+    ending_time_ = starting_time_ + metadata.duration.count();
     // If a non-default (positive) starting time offset is provided in PlayOptions,
     // then add the offset to the starting time obtained from reader metadata
     if (play_options_.start_offset < 0) {
@@ -347,23 +912,65 @@ PlayerImpl::PlayerImpl(
     } else {
       starting_time_ += play_options_.start_offset;
     }
-    clock_ = std::make_unique<rosbag2_cpp::TimeControllerClock>(
-      starting_time_, std::chrono::steady_clock::now,
-      std::chrono::milliseconds{100}, play_options_.start_paused);
+    if (play_options_.step_clock_topic.empty()) {
+      clock_ = std::make_unique<rosbag2_cpp::TimeControllerClock>(
+        starting_time_, std::chrono::steady_clock::now,
+        std::chrono::milliseconds{100}, play_options_.start_paused,
+        std::chrono::nanoseconds{std::max<int64_t>(play_options_.precise_timing_spin_duration, 0)});
+    } else {
+      auto step_clock = std::make_unique<rosbag2_cpp::ExternalStepClock>(
+        starting_time_, std::chrono::milliseconds{100}, play_options_.start_paused);
+      step_clock_ = step_clock.get();
+      clock_ = std::move(step_clock);
+    }
     set_rate(play_options_.rate);
     topic_qos_profile_overrides_ = play_options_.topic_qos_profile_overrides;
+    measure_statistics_ = play_options_.statistics_publish_interval > 0;
     prepare_publishers();
+    create_topic_decimators();
     configure_play_until_timestamp();
+    reverse_reader_ = std::make_unique<ReverseBlockReader>(
+      *reader_, storage_filter_, starting_time_, play_options_.read_ahead_queue_size);
+    if (play_options_.preload) {
+      preload_bag();
+    }
+    if (play_options_.publishing_threads > 0) {
+      publisher_thread_pool_ =
+        std::make_unique<PublisherThreadPool>(play_options_.publishing_threads);
+    }
   }
   create_control_services();
+  if (step_clock_) {
+    create_step_clock_interfaces();
+  }
   add_keyboard_callbacks();
+  if (measure_statistics_) {
+    statistics_pub_ = owner_->create_publisher<rosbag2_interfaces::msg::PlayStatistics>(
+      "~/play_statistics", 10);
+    statistics_timer_ = owner_->create_wall_timer(
+      std::chrono::nanoseconds(play_options_.statistics_publish_interval),
+      [this]() {publish_playback_statistics();});
+  }
+  // Started last, since the destructor which joins it is not called if the constructor throws
+  if (play_options_.clock_publish_frequency > 0.f && play_options_.clock_publish_thread) {
+    clock_publish_thread_ = std::thread(
+      [this]() {
+        rosbag2_cpp::apply_thread_scheduling(
+          "clock", make_thread_scheduling("fifo", play_options_.clock_publish_thread_priority, {}));
+        publish_clock_on_thread(get_clock_publish_period());
+      });
+  }
 }
 
 PlayerImpl::~PlayerImpl()
 {
+  // Drop the control requests which are not handled yet and wait for the one in progress, so
+  // that no request starts playback again after it is stopped below
+  control_request_pool_.reset();
   // Force to stop playback to avoid hangout in case of unexpected exception or when smart
   // pointer to the player object goes out of scope
   stop();
+  stop_clock_publish_thread();
 
   // remove callbacks on key_codes to prevent race conditions
   // Note: keyboard_handler handles locks between removing & executing callbacks
@@ -421,6 +1028,8 @@ bool PlayerImpl::play()
   }
   playback_thread_ = std::thread(
     [&, delay]() {
+      configure_playback_thread();
+      reset_playback_statistics();
       try {
         do {
           if (delay > rclcpp::Duration(0, 0)) {
@@ -430,20 +1039,49 @@ bool PlayerImpl::play()
           }
           {
             std::lock_guard<std::mutex> lk(reader_mutex_);
-            reader_->seek(starting_time_);
-            clock_->jump(starting_time_);
+            const bool reverse = clock_->get_rate() < 0;
+            const auto time_point = reverse ? get_reverse_starting_time() : starting_time_;
+            seek_message_source(time_point, reverse);
+            if (!preloaded_bag_ && !loop_cache_complete_) {
+              // Only a forward pass through the storage fills the loop cache
+              if (reverse) {
+                stop_recording_loop_cache();
+              } else {
+                start_recording_loop_cache();
+              }
+            }
+            clock_->jump(time_point);
           }
-          load_storage_content_ = true;
-          storage_loading_future_ = std::async(
-            std::launch::async, [this]() {
-              load_storage_content();
-            });
+          start_loading_storage_content();
           wait_for_filled_queue();
+          publish_delay_histogram_.clear();
           play_messages_from_queue();
+          if (publisher_thread_pool_) {
+            publisher_thread_pool_->wait_for_queued_tasks();
+          }
+          if (step_clock_) {
+            // Nothing more to play up to the last step
+            step_clock_->complete_step();
+          }
+          if (publish_delay_histogram_.count() > 0) {
+            const bool tuned_timing = play_options_.precise_timing_spin_duration > 0 ||
+              play_options_.playback_thread_priority > 0 ||
+              !play_options_.playback_thread_cpus.empty();
+            if (tuned_timing) {
+              RCLCPP_INFO_STREAM(
+                owner_->get_logger(),
+                "Publish delays: " << publish_delay_histogram_.to_string());
+            } else {
+              RCLCPP_DEBUG_STREAM(
+                owner_->get_logger(),
+                "Publish delays: " << publish_delay_histogram_.to_string());
+            }
+          }
 
           load_storage_content_ = false;
+          notify_message_queue_changed();
           if (storage_loading_future_.valid()) {storage_loading_future_.get();}
-          while (message_queue_.pop()) {}     // cleanup queue
+          purge_message_queue();
           {
             std::lock_guard<std::mutex> lk(ready_to_play_from_queue_mutex_);
             is_ready_to_play_from_queue_ = false;
@@ -453,8 +1091,9 @@ bool PlayerImpl::play()
       } catch (std::runtime_error & e) {
         RCLCPP_ERROR(owner_->get_logger(), "Failed to play: %s", e.what());
         load_storage_content_ = false;
+        notify_message_queue_changed();
         if (storage_loading_future_.valid()) {storage_loading_future_.get();}
-        while (message_queue_.pop()) {}     // cleanup queue
+        purge_message_queue();
       }
 
       {
@@ -463,29 +1102,55 @@ bool PlayerImpl::play()
         ready_to_play_from_queue_cv_.notify_all();
       }
 
-      // Wait for all published messages to be acknowledged.
+      // Wait for all published messages to be acknowledged. Only the topics which published
+      // since their subscribers last acknowledged and are still not acknowledged are waited for,
+      // each on a thread of its own, so that a slow subscriber does not delay the others.
       if (play_options_.wait_acked_timeout >= 0) {
-        std::chrono::milliseconds timeout(play_options_.wait_acked_timeout);
-        if (timeout == std::chrono::milliseconds(0)) {
-          timeout = std::chrono::milliseconds(-1);
+        const auto timeout = get_wait_acked_timeout();
+        std::vector<std::pair<std::string, std::future<bool>>> acked_futures;
+        for (const auto & [topic, publisher] : publishers_) {
+          // Topics which are acknowledged already do not need a thread
+          bool acked = false;
+          try {
+            acked = publisher->wait_for_acked(std::chrono::milliseconds(0));
+          } catch (const std::exception &) {
+            // Reported by the wait on the thread
+          }
+          if (!acked) {
+            acked_futures.emplace_back(
+              topic, std::async(
+                std::launch::async, [publisher = publisher, timeout]() {
+                  return publisher->wait_for_acked(timeout);
+                }));
+          }
         }
-        for (const auto & pub : publishers_) {
+        for (auto & [topic, acked] : acked_futures) {
           try {
-            if (!pub.second->generic_publisher()->wait_for_all_acked(timeout)) {
+            if (!acked.get()) {
               RCLCPP_ERROR(
                 owner_->get_logger(),
                 "Timed out while waiting for all published messages to be acknowledged "
-                "for topic %s", pub.first.c_str());
+                "for topic %s", topic.c_str());
             }
           } catch (std::exception & e) {
             RCLCPP_ERROR(
               owner_->get_logger(),
               "Exception occurred while waiting for all published messages to be acknowledged for "
-              "topic %s : %s", pub.first.c_str(), e.what());
+              "topic %s : %s", topic.c_str(), e.what());
           }
         }
       }
 
+      if (starvation_events_ > 0) {
+        RCLCPP_WARN_STREAM(
+          owner_->get_logger(),
+          "Message queue starved " << starvation_events_ << " times during playback, for " <<
+            starved_duration_ns_ / 1000000 << " ms in total. Messages were delayed.");
+      }
+      if (measure_statistics_) {
+        publish_playback_statistics();
+      }
+
       {
         rcpputils::unique_lock<std::mutex> is_in_playback_lk(is_in_playback_mutex_);
         is_in_playback_ = false;
@@ -518,6 +1183,7 @@ void PlayerImpl::stop()
   } else {
     RCLCPP_INFO_STREAM(owner_->get_logger(), "Stopping playback.");
     stop_playback_ = true;
+    notify_message_queue_changed();
     // Temporary stop playback in play_messages_from_queue() and block play_next() and seek() or
     // wait until those operations will be finished with stop_playback_ = true;
     {
@@ -573,9 +1239,14 @@ double PlayerImpl::get_rate() const
 
 bool PlayerImpl::set_rate(double rate)
 {
+  const bool was_reverse = clock_->get_rate() < 0;
   bool ok = clock_->set_rate(rate);
   if (ok) {
     RCLCPP_INFO_STREAM(owner_->get_logger(), "Set rate to " << rate);
+    // The messages read ahead are in the wrong order once the direction of playback changed
+    if ((rate < 0) != was_reverse && is_in_playback_) {
+      seek(clock_->now());
+    }
   } else {
     RCLCPP_WARN_STREAM(owner_->get_logger(), "Failed to set rate to invalid value " << rate);
   }
@@ -584,19 +1255,42 @@ bool PlayerImpl::set_rate(double rate)
 
 rosbag2_storage::SerializedBagMessageSharedPtr PlayerImpl::peek_next_message_from_queue()
 {
+  {
+    std::lock_guard<std::mutex> lk(seek_history_mutex_);
+    if (seek_history_playhead_ < seek_history_.size()) {
+      return seek_history_[seek_history_playhead_];
+    }
+  }
   rosbag2_storage::SerializedBagMessageSharedPtr * message_ptr_ptr = message_queue_.peek();
+  bool starved = false;
+  std::chrono::steady_clock::time_point starved_since;
   while (!stop_playback_ && message_ptr_ptr == nullptr &&
     !is_storage_completely_loaded() && rclcpp::ok())
   {
+    if (!starved) {
+      starved = true;
+      starved_since = std::chrono::steady_clock::now();
+      starvation_events_++;
+    }
     RCLCPP_WARN_THROTTLE(
       owner_->get_logger(),
       *owner_->get_clock(),
       1000,
       "Message queue starved. Messages will be delayed. Consider "
-      "increasing the --read-ahead-queue-size option.");
-
-    std::this_thread::sleep_for(std::chrono::microseconds(100));
-    message_ptr_ptr = message_queue_.peek();
+      "increasing the --read-ahead-queue-size or --read-ahead-queue-bytes option.");
+
+    // Woken up as soon as a message is queued. The timeout only bounds the time to notice that
+    // rclcpp was shut down.
+    std::unique_lock<std::mutex> lk(message_queue_mutex_);
+    message_queue_cv_.wait_for(
+      lk, queue_read_wait_period_, [this, &message_ptr_ptr]() {
+        message_ptr_ptr = message_queue_.peek();
+        return message_ptr_ptr != nullptr || stop_playback_ || storage_loading_finished_;
+      });
+  }
+  if (starved) {
+    starved_duration_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - starved_since).count();
   }
 
   // Workaround for race condition between peek and is_storage_completely_loaded()
@@ -636,6 +1330,10 @@ bool PlayerImpl::play_next()
     ready_to_play_from_queue_cv_.wait(lk, [this] {return is_ready_to_play_from_queue_;});
   }
 
+  // Keep the order of the messages already handed to the publishing threads
+  if (publisher_thread_pool_) {
+    publisher_thread_pool_->wait_for_queued_tasks();
+  }
   rosbag2_storage::SerializedBagMessageSharedPtr message_ptr = peek_next_message_from_queue();
 
   bool next_message_published = false;
@@ -645,7 +1343,7 @@ bool PlayerImpl::play_next()
     next_message_published = publish_message(message_ptr);
     clock_->jump(message_ptr->time_stamp);
 
-    message_queue_.pop();
+    pop_message_from_queue();
     message_ptr = peek_next_message_from_queue();
   }
   return next_message_published;
@@ -658,16 +1356,41 @@ size_t PlayerImpl::burst(const size_t num_messages)
     return 0;
   }
 
-  uint64_t messages_played = 0;
+  RCLCPP_INFO_STREAM(owner_->get_logger(), "Bursting " << num_messages << " messages.");
+
+  // Take over playback from play_messages_from_queue() once for the whole burst, as play_next()
+  // does for one message
+  std::lock_guard<std::mutex> main_play_loop_lk(skip_message_in_main_play_loop_mutex_);
+  if (!clock_->is_paused()) {
+    RCLCPP_WARN_STREAM(owner_->get_logger(), "Burst can only be used when in the paused state.");
+    return 0;
+  }
+  skip_message_in_main_play_loop_ = true;
+  {
+    std::unique_lock<std::mutex> lk(ready_to_play_from_queue_mutex_);
+    ready_to_play_from_queue_cv_.wait(lk, [this] {return is_ready_to_play_from_queue_;});
+  }
+  if (publisher_thread_pool_) {
+    publisher_thread_pool_->wait_for_queued_tasks();
+  }
 
-  for (auto ii = 0u; ii < num_messages || num_messages == 0; ++ii) {
-    if (play_next()) {
+  // The clock is only moved to the last message of the burst
+  size_t messages_played = 0;
+  rosbag2_storage::SerializedBagMessageSharedPtr last_message_ptr;
+  rosbag2_storage::SerializedBagMessageSharedPtr message_ptr = peek_next_message_from_queue();
+  while (rclcpp::ok() && (messages_played < num_messages || num_messages == 0) &&
+    !stop_playback_ && message_ptr != nullptr && !shall_stop_at_timestamp(message_ptr->time_stamp))
+  {
+    if (publish_message(message_ptr)) {
       ++messages_played;
-    } else {
-      break;
     }
+    last_message_ptr = std::move(message_ptr);
+    pop_message_from_queue();
+    message_ptr = peek_next_message_from_queue();
+  }
+  if (last_message_ptr != nullptr) {
+    clock_->jump(last_message_ptr->time_stamp);
   }
-
   return messages_played;
 }
 
@@ -690,16 +1413,23 @@ void PlayerImpl::seek(rcutils_time_point_value_t time_point)
   }
   {
     std::lock_guard<std::mutex> lk(reader_mutex_);
+    const bool reverse = clock_->get_rate() < 0;
+    if (reverse == reverse_playback_ && seek_in_memory(time_point)) {
+      clock_->jump(time_point);
+      return;
+    }
     // Purge current messages in queue.
-    while (message_queue_.pop()) {}
-    reader_->seek(time_point);
+    purge_message_queue();
+    if (!preloaded_bag_ && !loop_cache_complete_) {
+      // The cache would miss the messages skipped by the seek
+      stop_recording_loop_cache();
+    }
+    seek_message_source(time_point, reverse);
     clock_->jump(time_point);
     // Restart queuing thread if it has finished running (previously reached end of bag),
     // otherwise, queueing should continue automatically after releasing mutex
     if (is_storage_completely_loaded() && rclcpp::ok()) {
-      load_storage_content_ = true;
-      storage_loading_future_ =
-        std::async(std::launch::async, [this]() {load_storage_content();});
+      start_loading_storage_content();
     }
   }
 }
@@ -712,7 +1442,11 @@ Player::callback_handle_t PlayerImpl::add_on_play_message_pre_callback(
   }
   std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
   callback_handle_t new_handle = get_new_on_play_msg_callback_handle();
-  on_play_msg_pre_callbacks_.emplace_front(play_msg_callback_data{new_handle, callback});
+  update_on_play_msg_callbacks(
+    on_play_msg_pre_callbacks_, has_on_play_msg_pre_callbacks_,
+    [&](play_msg_callbacks_t & callbacks) {
+      callbacks.emplace_front(play_msg_callback_data{new_handle, callback});
+    });
   return new_handle;
 }
 
@@ -724,21 +1458,111 @@ Player::callback_handle_t PlayerImpl::add_on_play_message_post_callback(
   }
   std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
   callback_handle_t new_handle = get_new_on_play_msg_callback_handle();
-  on_play_msg_post_callbacks_.emplace_front(play_msg_callback_data{new_handle, callback});
+  update_on_play_msg_callbacks(
+    on_play_msg_post_callbacks_, has_on_play_msg_post_callbacks_,
+    [&](play_msg_callbacks_t & callbacks) {
+      callbacks.emplace_front(play_msg_callback_data{new_handle, callback});
+    });
   return new_handle;
 }
 
 void PlayerImpl::delete_on_play_message_callback(const callback_handle_t & handle)
 {
-  std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
-  on_play_msg_pre_callbacks_.remove_if(
-    [handle](const play_msg_callback_data & data) {
-      return data.handle == handle;
-    });
-  on_play_msg_post_callbacks_.remove_if(
-    [handle](const play_msg_callback_data & data) {
-      return data.handle == handle;
+  {
+    std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
+    const auto remove_handle = [handle](play_msg_callbacks_t & callbacks) {
+        callbacks.remove_if(
+          [handle](const play_msg_callback_data & data) {
+            return data.handle == handle;
+          });
+      };
+    update_on_play_msg_callbacks(
+      on_play_msg_pre_callbacks_, has_on_play_msg_pre_callbacks_, remove_handle);
+    update_on_play_msg_callbacks(
+      on_play_msg_post_callbacks_, has_on_play_msg_post_callbacks_, remove_handle);
+  }
+  wait_for_on_play_msg_callbacks_readers();
+}
+
+void PlayerImpl::update_on_play_msg_callbacks(
+  std::shared_ptr<const play_msg_callbacks_t> & callbacks, std::atomic_bool & has_callbacks,
+  const std::function<void(play_msg_callbacks_t &)> & update)
+{
+  const auto current_callbacks = std::atomic_load(&callbacks);
+  auto new_callbacks = current_callbacks ?
+    std::make_shared<play_msg_callbacks_t>(*current_callbacks) :
+    std::make_shared<play_msg_callbacks_t>();
+  update(*new_callbacks);
+  const bool empty = new_callbacks->empty();
+  std::atomic_store(
+    &callbacks,
+    empty ? nullptr : std::shared_ptr<const play_msg_callbacks_t>(std::move(new_callbacks)));
+  has_callbacks = !empty;
+}
+
+void PlayerImpl::wait_for_on_play_msg_callbacks_readers()
+{
+  on_play_msg_callbacks_waiting_for_readers_++;
+  // Flipping the epoch keeps new readers out of the slot waited for. A concurrent deletion may
+  // flip it as well, so the slot of a flip is not known in advance.
+  std::array<bool, 2> waited_for_slot{false, false};
+  while (!waited_for_slot[0] || !waited_for_slot[1]) {
+    const size_t slot = on_play_msg_callbacks_epoch_.fetch_add(1) % 2;
+    const auto & readers = on_play_msg_callbacks_readers_[slot];
+    // A callback deleting callbacks is itself a reader, which can't be waited for
+    const auto own_reads = static_cast<size_t>(
+      std::count(
+        on_play_msg_callbacks_readers_of_thread.begin(),
+        on_play_msg_callbacks_readers_of_thread.end(), &readers));
+    std::unique_lock<std::mutex> lk(on_play_msg_callbacks_readers_mutex_);
+    on_play_msg_callbacks_readers_cv_.wait(
+      lk, [&readers, own_reads] {
+        return readers <= own_reads;
+      });
+    waited_for_slot[slot] = true;
+  }
+  on_play_msg_callbacks_waiting_for_readers_--;
+}
+
+void PlayerImpl::call_on_play_msg_callbacks(
+  const std::shared_ptr<const play_msg_callbacks_t> & callbacks,
+  const std::atomic_bool & has_callbacks,
+  const rosbag2_storage::SerializedBagMessageSharedPtr & message)
+{
+  if (!has_callbacks) {
+    return;
+  }
+  // Count as a reader before loading the snapshot, so that a deletion either replaced the
+  // snapshot already or waits for this call to return
+  auto & readers = on_play_msg_callbacks_readers_[on_play_msg_callbacks_epoch_ % 2];
+  readers++;
+  on_play_msg_callbacks_readers_of_thread.push_back(&readers);
+  const auto leave = rcpputils::make_scope_exit(
+    [this, &readers]() {
+      on_play_msg_callbacks_readers_of_thread.pop_back();
+      readers--;
+      if (on_play_msg_callbacks_waiting_for_readers_ > 0) {
+        std::lock_guard<std::mutex> lk(on_play_msg_callbacks_readers_mutex_);
+        on_play_msg_callbacks_readers_cv_.notify_all();
+      }
     });
+  // The snapshot stays valid while the callbacks are replaced
+  const auto snapshot = std::atomic_load(&callbacks);
+  if (snapshot == nullptr) {
+    return;
+  }
+  for (const auto & callback_data : *snapshot) {
+    if (callback_data.callback != nullptr) {  // Sanity check
+      callback_data.callback(message);
+    }
+  }
+}
+
+size_t PlayerImpl::count_on_play_msg_callbacks(
+  const std::shared_ptr<const play_msg_callbacks_t> & callbacks)
+{
+  const auto snapshot = std::atomic_load(&callbacks);
+  return snapshot ? static_cast<size_t>(std::distance(snapshot->begin(), snapshot->end())) : 0;
 }
 
 std::unordered_map<std::string,
@@ -764,24 +1588,12 @@ void PlayerImpl::wait_for_playback_to_start()
 
 size_t PlayerImpl::get_number_of_registered_on_play_msg_pre_callbacks()
 {
-  size_t callback_counter = 0;
-  std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
-  for (auto & pre_callback_data : on_play_msg_pre_callbacks_) {
-    (void)pre_callback_data;
-    callback_counter++;
-  }
-  return callback_counter;
+  return count_on_play_msg_callbacks(on_play_msg_pre_callbacks_);
 }
 
 size_t PlayerImpl::get_number_of_registered_on_play_msg_post_callbacks()
 {
-  size_t callback_counter = 0;
-  std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
-  for (auto & post_callback_data : on_play_msg_post_callbacks_) {
-    (void)post_callback_data;
-    callback_counter++;
-  }
-  return callback_counter;
+  return count_on_play_msg_callbacks(on_play_msg_post_callbacks_);
 }
 
 Player::callback_handle_t PlayerImpl::get_new_on_play_msg_callback_handle()
@@ -790,45 +1602,430 @@ Player::callback_handle_t PlayerImpl::get_new_on_play_msg_callback_handle()
   return handle_count.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
-void PlayerImpl::wait_for_filled_queue() const
+void PlayerImpl::wait_for_filled_queue()
 {
+  std::unique_lock<std::mutex> lk(message_queue_mutex_);
   while (
-    message_queue_.size_approx() < play_options_.read_ahead_queue_size &&
-    !is_storage_completely_loaded() && rclcpp::ok() && !stop_playback_)
+    !is_message_queue_full() && !storage_loading_finished_ && rclcpp::ok() && !stop_playback_)
   {
-    std::this_thread::sleep_for(queue_read_wait_period_);
+    message_queue_cv_.wait_for(lk, queue_read_wait_period_);
   }
 }
 
-void PlayerImpl::load_storage_content()
+void PlayerImpl::start_loading_storage_content()
+{
+  {
+    std::lock_guard<std::mutex> lk(message_queue_mutex_);
+    storage_loading_finished_ = false;
+  }
+  load_storage_content_ = true;
+  storage_loading_future_ = std::async(
+    std::launch::async, [this]() {
+      rosbag2_cpp::apply_thread_scheduling(
+        "storage loading", make_thread_scheduling(
+          play_options_.storage_loading_thread_policy,
+          play_options_.storage_loading_thread_priority,
+          play_options_.storage_loading_thread_cpus));
+      load_storage_content();
+      std::lock_guard<std::mutex> lk(message_queue_mutex_);
+      storage_loading_finished_ = true;
+      message_queue_cv_.notify_all();
+    });
+}
+
+size_t PlayerImpl::get_queued_size(const rosbag2_storage::SerializedBagMessage & message)
+{
+  // Messages without payload still take memory, so that the byte budget bounds their count too
+  return sizeof(message) +
+         (message.serialized_data ? message.serialized_data->buffer_length : 0);
+}
+
+bool PlayerImpl::pop_message_from_queue()
+{
+  std::lock_guard<std::mutex> lk(seek_history_mutex_);
+  if (seek_history_playhead_ < seek_history_.size()) {
+    // Played again after seeking back
+    ++seek_history_playhead_;
+    trim_seek_history();
+    return true;
+  }
+  return pop_message_from_read_ahead_queue();
+}
+
+bool PlayerImpl::pop_message_from_read_ahead_queue()
+{
+  rosbag2_storage::SerializedBagMessageSharedPtr * message_ptr_ptr = message_queue_.peek();
+  if (message_ptr_ptr == nullptr) {
+    return false;
+  }
+  // The history is ordered forward in time
+  if (play_options_.seek_history_duration > 0 && !reverse_playback_) {
+    seek_history_.push_back(*message_ptr_ptr);
+    seek_history_playhead_ = seek_history_.size();
+    trim_seek_history();
+  }
+  message_queue_bytes_ -= get_queued_size(**message_ptr_ptr);
+  message_queue_.pop();
+  notify_message_queue_changed();
+  return true;
+}
+
+void PlayerImpl::trim_seek_history()
+{
+  if (seek_history_playhead_ == 0) {
+    return;
+  }
+  const auto oldest_time_stamp = seek_history_[seek_history_playhead_ - 1]->time_stamp -
+    play_options_.seek_history_duration;
+  while (seek_history_playhead_ > 1 && seek_history_.front()->time_stamp < oldest_time_stamp) {
+    seek_history_.pop_front();
+    --seek_history_playhead_;
+  }
+}
+
+void PlayerImpl::purge_message_queue()
+{
+  std::lock_guard<std::mutex> lk(seek_history_mutex_);
+  seek_history_.clear();
+  seek_history_playhead_ = 0;
+  rosbag2_storage::SerializedBagMessageSharedPtr * message_ptr_ptr = message_queue_.peek();
+  while (message_ptr_ptr != nullptr) {
+    message_queue_bytes_ -= get_queued_size(**message_ptr_ptr);
+    message_queue_.pop();
+    message_ptr_ptr = message_queue_.peek();
+  }
+  notify_message_queue_changed();
+}
+
+bool PlayerImpl::seek_in_memory(rcutils_time_point_value_t time_point)
+{
+  if (play_options_.seek_history_duration <= 0 || reverse_playback_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lk(seek_history_mutex_);
+  // Earlier messages may have been dropped from the history
+  if (seek_history_.empty() || time_point < seek_history_.front()->time_stamp) {
+    return false;
+  }
+  auto message_it = std::find_if(
+    seek_history_.begin(), seek_history_.end(),
+    [time_point](const auto & message) {return message->time_stamp >= time_point;});
+  if (message_it != seek_history_.end()) {
+    seek_history_playhead_ = static_cast<size_t>(message_it - seek_history_.begin());
+    return true;
+  }
+  // Skip the messages read ahead up to time_point
+  seek_history_playhead_ = seek_history_.size();
+  rosbag2_storage::SerializedBagMessageSharedPtr * message_ptr_ptr = message_queue_.peek();
+  while (message_ptr_ptr != nullptr) {
+    if ((*message_ptr_ptr)->time_stamp >= time_point) {
+      return true;
+    }
+    pop_message_from_read_ahead_queue();
+    message_ptr_ptr = message_queue_.peek();
+  }
+  return false;
+}
+
+void PlayerImpl::notify_message_queue_changed()
+{
+  // Changes made before taking the mutex are seen by the waiting threads when they wake up
+  std::lock_guard<std::mutex> lk(message_queue_mutex_);
+  message_queue_cv_.notify_all();
+}
+
+bool PlayerImpl::is_message_queue_below_lower_boundary() const
 {
-  auto queue_lower_boundary =
-    static_cast<size_t>(play_options_.read_ahead_queue_size * read_ahead_lower_bound_percentage_);
-  auto queue_upper_boundary = play_options_.read_ahead_queue_size;
+  // With a byte budget, the queue holds as many messages as fit, so that it is deep enough for
+  // small messages at a high rate without holding too many large ones
+  if (play_options_.read_ahead_queue_bytes > 0) {
+    return message_queue_bytes_ < static_cast<size_t>(
+      play_options_.read_ahead_queue_bytes * read_ahead_lower_bound_percentage_);
+  }
+  return message_queue_.size_approx() < static_cast<size_t>(
+    play_options_.read_ahead_queue_size * read_ahead_lower_bound_percentage_);
+}
+
+bool PlayerImpl::is_message_queue_full() const
+{
+  if (play_options_.read_ahead_queue_bytes > 0) {
+    return message_queue_bytes_ >= play_options_.read_ahead_queue_bytes;
+  }
+  return message_queue_.size_approx() >= play_options_.read_ahead_queue_size;
+}
 
+void PlayerImpl::load_storage_content()
+{
   while (rclcpp::ok() && load_storage_content_ && !stop_playback_) {
+    {
+      // Woken up when messages are taken from the queue. The timeout only bounds the time to
+      // notice that rclcpp was shut down.
+      std::unique_lock<std::mutex> lk(message_queue_mutex_);
+      message_queue_cv_.wait_for(
+        lk, queue_read_wait_period_, [this]() {
+          return is_message_queue_below_lower_boundary() || !load_storage_content_ ||
+          stop_playback_;
+        });
+    }
     rcpputils::unique_lock lk(reader_mutex_);
-    if (!reader_->has_next()) {break;}
+    if (!has_next_message()) {
+      if (loop_cache_recording_) {
+        loop_cache_recording_ = false;
+        loop_cache_complete_ = true;
+      }
+      break;
+    }
 
-    if (message_queue_.size_approx() < queue_lower_boundary) {
-      enqueue_up_to_boundary(queue_upper_boundary);
+    if (is_message_queue_below_lower_boundary()) {
+      enqueue_up_to_boundary();
+    }
+  }
+}
+
+void PlayerImpl::preload_bag()
+{
+  // Estimate the size of the played topics from their share of the messages in the bag files
+  const auto metadata = reader_->get_metadata();
+  uint64_t played_message_count = 0;
+  for (const auto & topic : metadata.topics_with_message_count) {
+    if (played_topic_ids_.count(topic.topic_metadata.name) > 0) {
+      played_message_count += topic.message_count;
+    }
+  }
+  size_t estimated_bytes = 0;
+  if (metadata.message_count > 0) {
+    estimated_bytes = static_cast<size_t>(
+      static_cast<double>(metadata.bag_size) * static_cast<double>(played_message_count) /
+      static_cast<double>(metadata.message_count));
+  }
+  if (play_options_.preload_max_bytes > 0 && estimated_bytes > play_options_.preload_max_bytes) {
+    RCLCPP_WARN_STREAM(
+      owner_->get_logger(),
+      "The messages to play take about " << estimated_bytes << " bytes, more than the " <<
+        play_options_.preload_max_bytes << " bytes allowed for preloading. Playing them from "
+        "storage.");
+    return;
+  }
+
+  auto preloaded_bag = std::make_unique<PreloadedBag>(play_options_.preload_max_bytes);
+  preloaded_bag->reserve(estimated_bytes);
+  reader_->set_filter(get_playback_storage_filter());
+  reader_->seek(starting_time_);
+  while (reader_->has_next()) {
+    auto message = reader_->read_next();
+    message->topic_id = find_played_topic_id(*message);
+    // Compressed bag files take less space than the messages, so the estimate may be too low
+    if (!preloaded_bag->add(*message)) {
+      RCLCPP_WARN_STREAM(
+        owner_->get_logger(),
+        "The messages to play do not fit into the " << play_options_.preload_max_bytes <<
+          " bytes allowed for preloading. Playing them from storage.");
+      return;
+    }
+  }
+  RCLCPP_INFO_STREAM(
+    owner_->get_logger(),
+    "Preloaded " << preloaded_bag->size() << " messages taking " <<
+      preloaded_bag->size_in_bytes() << " bytes.");
+  preloaded_bag_ = std::move(preloaded_bag);
+}
+
+bool PlayerImpl::has_next_message()
+{
+  if (preloaded_bag_) {
+    return reverse_playback_ ? preloaded_bag_position_ > 0 :
+           preloaded_bag_position_ < preloaded_bag_->size();
+  }
+  if (replaying_loop_cache_) {
+    return reverse_playback_ ? loop_cache_position_ > 0 :
+           loop_cache_position_ < loop_cache_.size();
+  }
+  if (reverse_playback_) {
+    return reverse_reader_->has_next();
+  }
+  return reader_->has_next();
+}
+
+rosbag2_storage::SerializedBagMessageSharedPtr PlayerImpl::read_next_message()
+{
+  // In reverse, the position is behind the next message
+  if (preloaded_bag_) {
+    return preloaded_bag_->get(
+      reverse_playback_ ? --preloaded_bag_position_ : preloaded_bag_position_++);
+  }
+  if (replaying_loop_cache_) {
+    return loop_cache_[reverse_playback_ ? --loop_cache_position_ : loop_cache_position_++];
+  }
+  if (reverse_playback_) {
+    return reverse_reader_->read_next();
+  }
+  auto message = reader_->read_next();
+  if (loop_cache_recording_) {
+    loop_cache_bytes_ += get_queued_size(*message);
+    if (loop_cache_bytes_ > play_options_.loop_cache_bytes) {
+      RCLCPP_INFO_STREAM(
+        owner_->get_logger(),
+        "The bag does not fit into the loop cache of " << play_options_.loop_cache_bytes <<
+          " bytes. Replays read it from storage.");
+      stop_recording_loop_cache();
     } else {
-      lk.unlock();
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      loop_cache_.push_back(message);
+    }
+  }
+  return message;
+}
+
+void PlayerImpl::seek_message_source(rcutils_time_point_value_t time_point, bool reverse)
+{
+  reverse_playback_ = reverse;
+  if (preloaded_bag_) {
+    preloaded_bag_position_ = preloaded_bag_->find(reverse ? time_point + 1 : time_point);
+  } else if (loop_cache_complete_) {
+    replaying_loop_cache_ = true;
+    loop_cache_position_ = static_cast<size_t>(
+      std::find_if(
+        loop_cache_.begin(), loop_cache_.end(),
+        [time_point, reverse](const auto & message) {
+          return reverse ? message->time_stamp > time_point : message->time_stamp >= time_point;
+        }) - loop_cache_.begin());
+  } else if (reverse) {
+    reverse_reader_->seek(time_point);
+  } else {
+    reader_->set_filter(get_playback_storage_filter());
+    reader_->seek(time_point);
+  }
+}
+
+rosbag2_storage::StorageFilter PlayerImpl::get_playback_storage_filter() const
+{
+  // Messages and files after the end of playback are not read from storage
+  auto storage_filter = storage_filter_;
+  if (play_until_timestamp_ > 0) {
+    storage_filter.end_time_ns = play_until_timestamp_;
+  }
+  return storage_filter;
+}
+
+rcutils_time_point_value_t PlayerImpl::get_reverse_starting_time() const
+{
+  if (play_until_timestamp_ > 0) {
+    return std::min(play_until_timestamp_, ending_time_);
+  }
+  return ending_time_;
+}
+
+void PlayerImpl::start_recording_loop_cache()
+{
+  replaying_loop_cache_ = false;
+  loop_cache_.clear();
+  loop_cache_bytes_ = 0;
+  loop_cache_recording_ = play_options_.loop_cache_bytes > 0;
+}
+
+void PlayerImpl::stop_recording_loop_cache()
+{
+  loop_cache_recording_ = false;
+  loop_cache_.clear();
+  loop_cache_.shrink_to_fit();
+  loop_cache_bytes_ = 0;
+}
+
+uint32_t PlayerImpl::find_played_topic_id(
+  const rosbag2_storage::SerializedBagMessage & message) const
+{
+  if (message.interned_topic) {
+    // Topics interned after prepare_publishers() are not played
+    const auto interned_id = message.interned_topic->id;
+    return interned_id < played_topic_ids_by_interned_id_.size() ?
+      played_topic_ids_by_interned_id_[interned_id] : rosbag2_storage::UNASSIGNED_TOPIC_ID;
+  }
+  auto topic_id = played_topic_ids_.find(message.topic_name);
+  return topic_id != played_topic_ids_.end() ?
+    topic_id->second : rosbag2_storage::UNASSIGNED_TOPIC_ID;
+}
+
+void PlayerImpl::create_topic_decimators()
+{
+  for (const auto & [topic, decimation] : play_options_.topic_decimation) {
+    std::unique_ptr<TopicDecimator> decimator;
+    try {
+      decimator = std::make_unique<TopicDecimator>(decimation);
+    } catch (const std::invalid_argument & e) {
+      throw std::runtime_error("Invalid decimation of topic '" + topic + "': " + e.what());
     }
+    auto topic_id = played_topic_ids_.find(topic);
+    if (topic_id == played_topic_ids_.end()) {
+      continue;
+    }
+    if (topic_decimators_.empty()) {
+      topic_decimators_.resize(played_topics_.size());
+    }
+    topic_decimators_[topic_id->second] = std::move(decimator);
   }
 }
 
-void PlayerImpl::enqueue_up_to_boundary(size_t boundary)
+void PlayerImpl::enqueue_up_to_boundary()
 {
   rosbag2_storage::SerializedBagMessageSharedPtr message;
-  for (size_t i = message_queue_.size_approx(); i < boundary; i++) {
-    if (!reader_->has_next()) {
-      break;
+  // A message larger than the byte budget is still queued when the queue is empty
+  while (!is_message_queue_full() && has_next_message()) {
+    if (measure_statistics_) {
+      const auto read_start = std::chrono::steady_clock::now();
+      message = read_next_message();
+      read_latency_.record(std::chrono::steady_clock::now() - read_start);
+    } else {
+      message = read_next_message();
+    }
+    ROSBAG2_CPP_TRACEPOINT(player_read, message->topic_name.c_str(), message->time_stamp);
+    // Resolve the topic once here instead of on each publish. Preloaded messages were tagged
+    // when they were read.
+    if (!preloaded_bag_) {
+      message->topic_id = find_played_topic_id(*message);
     }
-    message = reader_->read_next();
+    if (message->topic_id < topic_decimators_.size() && topic_decimators_[message->topic_id]) {
+      // Negated backwards in time, so that the decimator sees the time stamps increase
+      const auto time_stamp = reverse_playback_ ? -message->time_stamp : message->time_stamp;
+      if (!topic_decimators_[message->topic_id]->keep(time_stamp)) {
+        continue;
+      }
+    }
+    message_queue_bytes_ += get_queued_size(*message);
+    ROSBAG2_CPP_TRACEPOINT(player_enqueue, message->topic_name.c_str(), message->time_stamp);
     message_queue_.enqueue(message);
+    notify_message_queue_changed();
+  }
+}
+
+bool PlayerImpl::wait_for_message_time(rcutils_time_point_value_t time_stamp)
+{
+  if (!play_options_.as_fast_as_possible) {
+    const bool due = clock_->sleep_until(time_stamp);
+    ROSBAG2_CPP_TRACEPOINT(player_wake, time_stamp, due);
+    return due;
+  }
+  if (!clock_->is_paused()) {
+    return true;
+  }
+  // Sleeps until resumed, or for the sleep time of the paused clock
+  clock_->sleep_until(time_stamp);
+  return false;
+}
+
+std::chrono::milliseconds PlayerImpl::get_wait_acked_timeout() const
+{
+  std::chrono::milliseconds timeout(play_options_.wait_acked_timeout);
+  if (timeout == std::chrono::milliseconds(0)) {
+    timeout = std::chrono::milliseconds(-1);
   }
+  return timeout;
+}
+
+void PlayerImpl::configure_playback_thread()
+{
+  rosbag2_cpp::apply_thread_scheduling(
+    "playback", make_thread_scheduling(
+      play_options_.playback_thread_policy, play_options_.playback_thread_priority,
+      play_options_.playback_thread_cpus));
 }
 
 void PlayerImpl::play_messages_from_queue()
@@ -849,7 +2046,7 @@ void PlayerImpl::play_messages_from_queue()
   {
     // Do not move on until sleep_until returns true
     // It will always sleep, so this is not a tight busy loop on pause
-    while (rclcpp::ok() && !clock_->sleep_until(message_ptr->time_stamp)) {
+    while (rclcpp::ok() && !wait_for_message_time(message_ptr->time_stamp)) {
       if (std::atomic_exchange(&cancel_wait_for_next_message_, false)) {
         break;
       }
@@ -862,9 +2059,44 @@ void PlayerImpl::play_messages_from_queue()
         message_ptr = peek_next_message_from_queue();
         continue;
       }
-      publish_message(message_ptr);
+      // The messages due within the release window are published without waiting on the
+      // clock again
+      const bool reverse = reverse_playback_;
+      const auto release_until = reverse ?
+        message_ptr->time_stamp - play_options_.release_window :
+        message_ptr->time_stamp + play_options_.release_window;
+      if (play_options_.as_fast_as_possible) {
+        // The clock follows the messages instead, so that /clock keeps up with them
+        clock_->jump(message_ptr->time_stamp);
+      } else {
+        publish_delay_histogram_.add(
+          std::chrono::steady_clock::now() - clock_->ros_to_steady(message_ptr->time_stamp));
+      }
+      do {
+        if (measure_statistics_) {
+          const uint64_t queue_messages = message_queue_.size_approx();
+          uint64_t min_queue_messages = min_queue_messages_.load(std::memory_order_relaxed);
+          while (queue_messages < min_queue_messages &&
+            !min_queue_messages_.compare_exchange_weak(min_queue_messages, queue_messages))
+          {
+          }
+        }
+        if (publisher_thread_pool_) {
+          // Only the messages of the same topic wait for a slow publisher
+          publisher_thread_pool_->queue(
+            message_ptr->topic_name, [this, message_ptr]() {publish_message(message_ptr);});
+        } else {
+          publish_message(message_ptr);
+        }
+        pop_message_from_queue();
+        message_ptr = peek_next_message_from_queue();
+      } while (message_ptr != nullptr &&
+        (reverse ? message_ptr->time_stamp >= release_until :
+        message_ptr->time_stamp <= release_until) &&
+        rclcpp::ok() && !stop_playback_ && !shall_stop_at_timestamp(message_ptr->time_stamp));
+      continue;
     }
-    message_queue_.pop();
+    pop_message_from_queue();
     message_ptr = peek_next_message_from_queue();
   }
   // while we're in pause state, make sure we don't return
@@ -881,6 +2113,7 @@ void PlayerImpl::prepare_publishers()
   storage_filter.topics_regex = play_options_.topics_regex_to_filter;
   storage_filter.topics_regex_to_exclude = play_options_.topics_regex_to_exclude;
   reader_->set_filter(storage_filter);
+  storage_filter_ = storage_filter;
 
   // Create /clock publisher
   if (play_options_.clock_publish_frequency > 0.f || play_options_.clock_publish_on_topic_publish) {
@@ -890,12 +2123,9 @@ void PlayerImpl::prepare_publishers()
       "/clock", rclcpp::ClockQoS());
   }
 
-  if (play_options_.clock_publish_frequency > 0.f) {
-    const auto publish_period = std::chrono::nanoseconds(
-      static_cast<uint64_t>(RCUTILS_S_TO_NS(1) / play_options_.clock_publish_frequency));
-
+  if (play_options_.clock_publish_frequency > 0.f && !play_options_.clock_publish_thread) {
     clock_publish_timer_ = owner_->create_wall_timer(
-      publish_period, [this]() {
+      get_clock_publish_period(), [this]() {
         publish_clock_update();
       });
   }
@@ -903,24 +2133,24 @@ void PlayerImpl::prepare_publishers()
   if (play_options_.clock_publish_on_topic_publish) {
     add_on_play_message_pre_callback(
       [this](const std::shared_ptr<rosbag2_storage::SerializedBagMessage> msg) {
-        if (play_options_.clock_trigger_topics.empty()) {
+        const auto * played_topic = get_played_topic(*msg);
+        if (played_topic != nullptr && played_topic->triggers_clock) {
           publish_clock_update();
-        } else {
-          for (const auto & topic : play_options_.clock_trigger_topics) {
-            if (topic == msg->topic_name) {
-              publish_clock_update();
-              break;
-            }
-          }
         }
       });
   }
 
   // Create topic publishers
   auto topics = reader_->get_all_topics_and_types();
-  std::string topic_without_support_acked;
+  std::vector<TopicToPublish> topics_to_publish;
   for (const auto & topic : topics) {
-    if (publishers_.find(topic.name) != publishers_.end()) {
+    if (publishers_.find(topic.name) != publishers_.end() ||
+      std::any_of(
+        topics_to_publish.begin(), topics_to_publish.end(),
+        [&topic](const TopicToPublish & topic_to_publish) {
+          return topic_to_publish.topic->name == topic.name;
+        }))
+    {
       continue;
     }
     // filter topics to add publishers if necessary
@@ -932,27 +2162,68 @@ void PlayerImpl::prepare_publishers()
       }
     }
 
-    auto topic_qos = publisher_qos_for_topic(
-      topic, topic_qos_profile_overrides_,
-      owner_->get_logger());
+    TopicToPublish topic_to_publish{&topic, publisher_qos_for_topic(
+        topic, topic_qos_profile_overrides_,
+        owner_->get_logger()), nullptr, nullptr, ""};
+    // The type support library of a package is loaded once for all of its message types
     try {
-      std::shared_ptr<rclcpp::GenericPublisher> pub =
-        owner_->create_generic_publisher(topic.name, topic.type, topic_qos);
-      std::shared_ptr<PlayerImpl::PlayerPublisher> player_pub =
-        std::make_shared<PlayerImpl::PlayerPublisher>(
-        std::move(pub), play_options_.disable_loan_message);
-      publishers_.insert(std::make_pair(topic.name, player_pub));
-      if (play_options_.wait_acked_timeout >= 0 &&
-        topic_qos.reliability() == rclcpp::ReliabilityPolicy::BestEffort)
-      {
-        topic_without_support_acked += topic.name + ", ";
-      }
+      topic_to_publish.typesupport_library =
+        rosbag2_cpp::get_typesupport_library(topic.type, "rosidl_typesupport_cpp");
     } catch (const std::runtime_error & e) {
+      topic_to_publish.error = e.what();
+    }
+    topics_to_publish.push_back(std::move(topic_to_publish));
+  }
+  create_generic_publishers(topics_to_publish);
+
+  std::string topic_without_support_acked;
+  for (auto & topic_to_publish : topics_to_publish) {
+    const auto & topic = *topic_to_publish.topic;
+    if (topic_to_publish.publisher == nullptr) {
       // using a warning log seems better than adding a new option
       // to ignore some unknown message type library
       RCLCPP_WARN(
         owner_->get_logger(),
-        "Ignoring a topic '%s', reason: %s.", topic.name.c_str(), e.what());
+        "Ignoring a topic '%s', reason: %s.", topic.name.c_str(), topic_to_publish.error.c_str());
+      continue;
+    }
+    owner_->get_node_topics_interface()->add_publisher(topic_to_publish.publisher, nullptr);
+    std::shared_ptr<PlayerImpl::PlayerPublisher> player_pub =
+      std::make_shared<PlayerImpl::PlayerPublisher>(
+      std::move(topic_to_publish.publisher), play_options_.disable_loan_message,
+      play_options_.intra_process_playback);
+    publishers_.insert(std::make_pair(topic.name, player_pub));
+    PlayedTopic played_topic;
+    played_topic.publisher = player_pub;
+    if (measure_statistics_) {
+      played_topic.publish_durations = std::make_shared<rosbag2_cpp::LatencyHistogram>();
+    }
+    const auto publish_policy = play_options_.topic_publish_policies.find(topic.name);
+    if (publish_policy != play_options_.topic_publish_policies.end() &&
+      publish_policy->second.deadline != 0)
+    {
+      played_topic.isolated_publisher = std::make_shared<IsolatedPublisher>(
+        player_pub, publish_policy->second, topic.name, owner_->get_logger());
+    }
+    const auto & clock_trigger_topics = play_options_.clock_trigger_topics;
+    played_topic.triggers_clock = clock_trigger_topics.empty() ||
+      std::find(clock_trigger_topics.begin(), clock_trigger_topics.end(), topic.name) !=
+      clock_trigger_topics.end();
+    if (played_topics_.empty()) {
+      played_topics_.emplace_back();  // rosbag2_storage::UNASSIGNED_TOPIC_ID
+    }
+    played_topic_ids_.emplace(topic.name, static_cast<uint32_t>(played_topics_.size()));
+    const auto interned_id = rosbag2_storage::intern_topic(topic.name).id;
+    if (interned_id >= played_topic_ids_by_interned_id_.size()) {
+      played_topic_ids_by_interned_id_.resize(
+        interned_id + 1, rosbag2_storage::UNASSIGNED_TOPIC_ID);
+    }
+    played_topic_ids_by_interned_id_[interned_id] = static_cast<uint32_t>(played_topics_.size());
+    played_topics_.push_back(std::move(played_topic));
+    if (play_options_.wait_acked_timeout >= 0 &&
+      topic_to_publish.qos.reliability() == rclcpp::ReliabilityPolicy::BestEffort)
+    {
+      topic_without_support_acked += topic.name + ", ";
     }
   }
 
@@ -983,36 +2254,121 @@ void PlayerImpl::prepare_publishers()
   reader_->add_event_callbacks(callbacks);
 }
 
+void PlayerImpl::create_generic_publishers(std::vector<TopicToPublish> & topics_to_publish)
+{
+  const auto create_generic_publisher = [this](TopicToPublish & topic_to_publish) {
+      if (topic_to_publish.typesupport_library == nullptr) {
+        return;
+      }
+      try {
+        topic_to_publish.publisher = std::make_shared<rclcpp::GenericPublisher>(
+          owner_->get_node_base_interface().get(), topic_to_publish.typesupport_library,
+          topic_to_publish.topic->name, topic_to_publish.topic->type, topic_to_publish.qos,
+          rclcpp::PublisherOptions());
+      } catch (const std::runtime_error & e) {
+        topic_to_publish.error = e.what();
+      }
+    };
+
+  const size_t number_of_threads = std::min(
+    play_options_.publisher_creation_threads, topics_to_publish.size());
+  if (number_of_threads <= 1) {
+    for (auto & topic_to_publish : topics_to_publish) {
+      create_generic_publisher(topic_to_publish);
+    }
+    return;
+  }
+  // The middleware entities are created in parallel. Each thread takes the next topic.
+  std::atomic<size_t> next_topic{0};
+  std::vector<std::thread> threads;
+  threads.reserve(number_of_threads);
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    threads.emplace_back(
+      [&]() {
+        for (size_t topic = next_topic++; topic < topics_to_publish.size(); topic = next_topic++) {
+          create_generic_publisher(topics_to_publish[topic]);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+}
+
+const PlayerImpl::PlayedTopic * PlayerImpl::get_played_topic(
+  const rosbag2_storage::SerializedBagMessage & message) const
+{
+  if (message.topic_id == rosbag2_storage::UNASSIGNED_TOPIC_ID ||
+    message.topic_id >= played_topics_.size())
+  {
+    return nullptr;
+  }
+  return &played_topics_[message.topic_id];
+}
+
 bool PlayerImpl::publish_message(rosbag2_storage::SerializedBagMessageSharedPtr message)
 {
   bool message_published = false;
-  auto publisher_iter = publishers_.find(message->topic_name);
-  if (publisher_iter != publishers_.end()) {
-    {  // Calling on play message pre-callbacks
-      std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
-      for (auto & pre_callback_data : on_play_msg_pre_callbacks_) {
-        if (pre_callback_data.callback != nullptr) {  // Sanity check
-          pre_callback_data.callback(message);
+  const auto * played_topic = get_played_topic(*message);
+  if (played_topic != nullptr) {
+    const auto & publisher = played_topic->publisher;
+    // Calling on play message pre-callbacks
+    call_on_play_msg_callbacks(
+      on_play_msg_pre_callbacks_, has_on_play_msg_pre_callbacks_, message);
+
+    std::chrono::steady_clock::time_point publish_start;
+    if (measure_statistics_) {
+      publish_start = std::chrono::steady_clock::now();
+      if (!play_options_.as_fast_as_possible) {
+        const auto error = publish_start - clock_->ros_to_steady(message->time_stamp);
+        if (error >= std::chrono::nanoseconds(0)) {
+          publish_lateness_.record(error);
+        } else {
+          publish_earliness_.record(-error);
         }
       }
     }
-
     try {
-      publisher_iter->second->publish(rclcpp::SerializedMessage(*message->serialized_data));
-      message_published = true;
+      // The message is deserialized straight from the bag into a loaned message if publishing
+      // as loaned message, and published without a copy otherwise.
+      ROSBAG2_CPP_TRACEPOINT(player_publish, message->topic_name.c_str(), message->time_stamp);
+      if (played_topic->isolated_publisher) {
+        message_published = played_topic->isolated_publisher->publish(message);
+      } else {
+        publisher->publish(make_serialized_message_view(*message->serialized_data));
+        message_published = true;
+      }
+      if (played_topic->publish_durations) {
+        played_topic->publish_durations->record(std::chrono::steady_clock::now() - publish_start);
+      }
     } catch (const std::exception & e) {
       RCLCPP_ERROR_STREAM(
         owner_->get_logger(), "Failed to publish message on '" << message->topic_name <<
           "' topic. \nError: " << e.what());
     }
 
-    // Calling on play message post-callbacks
-    std::lock_guard<std::mutex> lk(on_play_msg_callbacks_mutex_);
-    for (auto & post_callback_data : on_play_msg_post_callbacks_) {
-      if (post_callback_data.callback != nullptr) {  // Sanity check
-        post_callback_data.callback(message);
+    // Without the clock pacing playback, the subscribers pace it by acknowledging the messages
+    if (message_published && play_options_.as_fast_as_possible &&
+      play_options_.wait_acked_timeout >= 0)
+    {
+      try {
+        if (!publisher->wait_for_acked_history(get_wait_acked_timeout())) {
+          RCLCPP_ERROR_STREAM(
+            owner_->get_logger(),
+            "Timed out while waiting for published messages to be acknowledged for topic " <<
+              message->topic_name);
+        }
+      } catch (const std::exception & e) {
+        RCLCPP_ERROR_STREAM(
+          owner_->get_logger(),
+          "Exception occurred while waiting for published messages to be acknowledged for topic " <<
+            message->topic_name << " : " << e.what());
       }
     }
+
+    // Calling on play message post-callbacks
+    call_on_play_msg_callbacks(
+      on_play_msg_post_callbacks_, has_on_play_msg_post_callbacks_, message);
   }
   return message_published;
 }
@@ -1071,8 +2427,42 @@ void PlayerImpl::add_keyboard_callbacks()
   );
 }
 
+void PlayerImpl::create_step_clock_interfaces()
+{
+  // Steps are neither dropped nor coalesced, so that each of them is completed
+  const auto qos = rclcpp::QoS(rclcpp::KeepAll()).reliable();
+  step_completed_pub_ = owner_->create_publisher<rosgraph_msgs::msg::Clock>(
+    "~/step_completed", qos);
+  step_clock_->set_step_completed_callback(
+    [this](rcutils_time_point_value_t time_point) {
+      // Called from the playback thread once it waits for a message after the step
+      if (publisher_thread_pool_) {
+        publisher_thread_pool_->wait_for_queued_tasks();
+      }
+      rosgraph_msgs::msg::Clock completed;
+      completed.clock = rclcpp::Time(time_point);
+      step_completed_pub_->publish(completed);
+    });
+  step_clock_sub_ = owner_->create_subscription<rosgraph_msgs::msg::Clock>(
+    play_options_.step_clock_topic, qos,
+    [this](const rosgraph_msgs::msg::Clock::SharedPtr step) {
+      step_clock_->step(rclcpp::Time(step->clock).nanoseconds());
+      if (!is_in_playback_) {
+        // Nothing is played up to the step
+        step_clock_->complete_step();
+      }
+    });
+}
+
 void PlayerImpl::create_control_services()
 {
+  // The services do not share a callback group with the /clock timer and the other callbacks
+  // of the node. Requests which wait on playback are handled on control_request_pool_, so that
+  // they do not block the executor either.
+  control_callback_group_ =
+    owner_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+  control_request_pool_ = std::make_unique<PublisherThreadPool>(1);
+
   // Note: Use upper level public API from owner class for callbacks to facilitate unit tests
   srv_pause_ = owner_->create_service<rosbag2_interfaces::srv::Pause>(
     "~/pause",
@@ -1081,7 +2471,8 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::Pause::Response::SharedPtr)
     {
       owner_->pause();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
   srv_resume_ = owner_->create_service<rosbag2_interfaces::srv::Resume>(
     "~/resume",
     [this](
@@ -1089,7 +2480,8 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::Resume::Response::SharedPtr)
     {
       owner_->resume();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
   srv_toggle_paused_ = owner_->create_service<rosbag2_interfaces::srv::TogglePaused>(
     "~/toggle_paused",
     [this](
@@ -1097,7 +2489,8 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::TogglePaused::Response::SharedPtr)
     {
       owner_->toggle_paused();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
   srv_is_paused_ = owner_->create_service<rosbag2_interfaces::srv::IsPaused>(
     "~/is_paused",
     [this](
@@ -1105,7 +2498,8 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::IsPaused::Response::SharedPtr response)
     {
       response->paused = owner_->is_paused();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
   srv_get_rate_ = owner_->create_service<rosbag2_interfaces::srv::GetRate>(
     "~/get_rate",
     [this](
@@ -1113,7 +2507,8 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::GetRate::Response::SharedPtr response)
     {
       response->rate = owner_->get_rate();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
   srv_set_rate_ = owner_->create_service<rosbag2_interfaces::srv::SetRate>(
     "~/set_rate",
     [this](
@@ -1121,53 +2516,59 @@ void PlayerImpl::create_control_services()
       rosbag2_interfaces::srv::SetRate::Response::SharedPtr response)
     {
       response->success = owner_->set_rate(request->rate);
-    });
-  srv_play_ = owner_->create_service<rosbag2_interfaces::srv::Play>(
-    "~/play",
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
+  srv_play_ = create_deferred_service<rosbag2_interfaces::srv::Play>(
+    *owner_, "~/play", *control_request_pool_,
     [this](
-      rosbag2_interfaces::srv::Play::Request::ConstSharedPtr request,
-      rosbag2_interfaces::srv::Play::Response::SharedPtr response)
+      const rosbag2_interfaces::srv::Play::Request::SharedPtr & request,
+      rosbag2_interfaces::srv::Play::Response & response)
     {
       play_options_.start_offset = rclcpp::Time(request->start_offset).nanoseconds();
       play_options_.playback_duration = rclcpp::Duration(request->playback_duration);
       play_options_.playback_until_timestamp =
       rclcpp::Time(request->playback_until_timestamp).nanoseconds();
       configure_play_until_timestamp();
-      response->success = owner_->play();
-    });
-  srv_play_next_ = owner_->create_service<rosbag2_interfaces::srv::PlayNext>(
-    "~/play_next",
+      response.success = owner_->play();
+    },
+    control_callback_group_);
+  srv_play_next_ = create_deferred_service<rosbag2_interfaces::srv::PlayNext>(
+    *owner_, "~/play_next", *control_request_pool_,
     [this](
-      rosbag2_interfaces::srv::PlayNext::Request::ConstSharedPtr,
-      rosbag2_interfaces::srv::PlayNext::Response::SharedPtr response)
+      const rosbag2_interfaces::srv::PlayNext::Request::SharedPtr &,
+      rosbag2_interfaces::srv::PlayNext::Response & response)
     {
-      response->success = owner_->play_next();
-    });
-  srv_burst_ = owner_->create_service<rosbag2_interfaces::srv::Burst>(
-    "~/burst",
+      response.success = owner_->play_next();
+    },
+    control_callback_group_);
+  srv_burst_ = create_deferred_service<rosbag2_interfaces::srv::Burst>(
+    *owner_, "~/burst", *control_request_pool_,
     [this](
-      rosbag2_interfaces::srv::Burst::Request::ConstSharedPtr request,
-      rosbag2_interfaces::srv::Burst::Response::SharedPtr response)
+      const rosbag2_interfaces::srv::Burst::Request::SharedPtr & request,
+      rosbag2_interfaces::srv::Burst::Response & response)
     {
-      response->actually_burst = owner_->burst(request->num_messages);
-    });
-  srv_seek_ = owner_->create_service<rosbag2_interfaces::srv::Seek>(
-    "~/seek",
+      response.actually_burst = owner_->burst(request->num_messages);
+    },
+    control_callback_group_);
+  srv_seek_ = create_deferred_service<rosbag2_interfaces::srv::Seek>(
+    *owner_, "~/seek", *control_request_pool_,
     [this](
-      rosbag2_interfaces::srv::Seek::Request::ConstSharedPtr request,
-      rosbag2_interfaces::srv::Seek::Response::SharedPtr response)
+      const rosbag2_interfaces::srv::Seek::Request::SharedPtr & request,
+      rosbag2_interfaces::srv::Seek::Response & response)
     {
       owner_->seek(rclcpp::Time(request->time).nanoseconds());
-      response->success = true;
-    });
-  srv_stop_ = owner_->create_service<rosbag2_interfaces::srv::Stop>(
-    "~/stop",
+      response.success = true;
+    },
+    control_callback_group_);
+  srv_stop_ = create_deferred_service<rosbag2_interfaces::srv::Stop>(
+    *owner_, "~/stop", *control_request_pool_,
     [this](
-      rosbag2_interfaces::srv::Stop::Request::ConstSharedPtr,
-      rosbag2_interfaces::srv::Stop::Response::SharedPtr)
+      const rosbag2_interfaces::srv::Stop::Request::SharedPtr &,
+      rosbag2_interfaces::srv::Stop::Response &)
     {
       owner_->stop();
-    });
+    },
+    control_callback_group_);
 }
 
 void PlayerImpl::configure_play_until_timestamp()
@@ -1189,6 +2590,10 @@ void PlayerImpl::configure_play_until_timestamp()
 inline bool PlayerImpl::shall_stop_at_timestamp(
   const rcutils_time_point_value_t & msg_timestamp) const
 {
+  // Reverse playback starts at the end of playback and stops at its start
+  if (reverse_playback_) {
+    return play_until_timestamp_ == 0 || msg_timestamp < starting_time_;
+  }
   if ((play_until_timestamp_ > -1 && msg_timestamp > play_until_timestamp_) ||
     play_until_timestamp_ == 0)
   {
@@ -1198,6 +2603,96 @@ inline bool PlayerImpl::shall_stop_at_timestamp(
   }
 }
 
+void PlayerImpl::reset_playback_statistics()
+{
+  publish_lateness_.reset();
+  publish_earliness_.reset();
+  read_latency_.reset();
+  for (const auto & played_topic : played_topics_) {
+    if (played_topic.publish_durations) {
+      played_topic.publish_durations->reset();
+    }
+    if (played_topic.isolated_publisher) {
+      played_topic.isolated_publisher->reset_incidents();
+    }
+  }
+  min_queue_messages_ = std::numeric_limits<uint64_t>::max();
+  starvation_events_ = 0;
+  starved_duration_ns_ = 0;
+}
+
+void PlayerImpl::publish_playback_statistics()
+{
+  rosbag2_interfaces::msg::PlayStatistics message;
+  message.stamp = owner_->now();
+  message.publish_lateness = to_stage_statistics("publish_lateness", publish_lateness_);
+  message.publish_earliness = to_stage_statistics("publish_earliness", publish_earliness_);
+  message.read_latency = to_stage_statistics("read_latency", read_latency_);
+  for (const auto & topic_id : played_topic_ids_) {
+    const auto & publish_durations = played_topics_[topic_id.second].publish_durations;
+    if (publish_durations && publish_durations->count() > 0) {
+      message.topic_publish_durations.push_back(
+        to_stage_statistics(topic_id.first, *publish_durations));
+    }
+    const auto & isolated_publisher = played_topics_[topic_id.second].isolated_publisher;
+    if (isolated_publisher) {
+      message.topic_publish_incidents.push_back(isolated_publisher->get_incidents());
+    }
+  }
+  message.queue_messages = message_queue_.size_approx();
+  message.queue_bytes = message_queue_bytes_;
+  const uint64_t min_queue_messages =
+    min_queue_messages_.exchange(std::numeric_limits<uint64_t>::max());
+  message.min_queue_messages =
+    min_queue_messages == std::numeric_limits<uint64_t>::max() ? 0u : min_queue_messages;
+  message.starvation_events = starvation_events_;
+  message.starved_duration = static_cast<uint64_t>(starved_duration_ns_.load());
+  try {
+    statistics_pub_->publish(message);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR_STREAM(
+      owner_->get_logger(),
+      "Failed to publish message on '~/play_statistics' topic. \nError: " << e.what());
+  }
+}
+
+std::chrono::nanoseconds PlayerImpl::get_clock_publish_period() const
+{
+  return std::chrono::nanoseconds(
+    static_cast<uint64_t>(RCUTILS_S_TO_NS(1) / play_options_.clock_publish_frequency));
+}
+
+void PlayerImpl::publish_clock_on_thread(std::chrono::nanoseconds publish_period)
+{
+  auto next_publish_time = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lk(clock_publish_thread_mutex_);
+  while (!stop_clock_publish_thread_) {
+    lk.unlock();
+    publish_clock_update();
+    lk.lock();
+    next_publish_time += publish_period;
+    const auto now = std::chrono::steady_clock::now();
+    if (next_publish_time < now) {
+      // Skip the updates which are overdue instead of publishing them in a burst
+      next_publish_time = now;
+    }
+    clock_publish_thread_cv_.wait_until(
+      lk, next_publish_time, [this]() {return stop_clock_publish_thread_;});
+  }
+}
+
+void PlayerImpl::stop_clock_publish_thread()
+{
+  {
+    std::lock_guard<std::mutex> lk(clock_publish_thread_mutex_);
+    stop_clock_publish_thread_ = true;
+  }
+  clock_publish_thread_cv_.notify_all();
+  if (clock_publish_thread_.joinable()) {
+    clock_publish_thread_.join();
+  }
+}
+
 void PlayerImpl::publish_clock_update()
 {
   publish_clock_update(rclcpp::Time(clock_->now()));
@@ -1245,7 +2740,8 @@ Player::Player(const std::string & node_name, const rclcpp::NodeOptions & node_o
   auto keyboard_handler = std::shared_ptr<KeyboardHandler>(new KeyboardHandler());
   #endif
 
-  auto reader = std::make_unique<rosbag2_cpp::Reader>();
+  auto reader = ReaderWriterFactory::make_reader(
+    storage_options, play_options.prefetch_queue_bytes);
 
   pimpl_ = std::make_unique<PlayerImpl>(
     this, std::move(reader), keyboard_handler, storage_options, play_options);
@@ -1257,10 +2753,19 @@ Player::Player(
   const rosbag2_transport::PlayOptions & play_options,
   const std::string & node_name,
   const rclcpp::NodeOptions & node_options)
-: Player(std::make_unique<rosbag2_cpp::Reader>(),
+: Player(ReaderWriterFactory::make_reader(storage_options, play_options.prefetch_queue_bytes),
     storage_options, play_options, node_name, node_options)
 {}
 
+Player::Player(
+  const std::vector<rosbag2_storage::StorageOptions> & storage_options,
+  const rosbag2_transport::PlayOptions & play_options,
+  const std::string & node_name,
+  const rclcpp::NodeOptions & node_options)
+: Player(ReaderWriterFactory::make_reader(storage_options, play_options.prefetch_queue_bytes),
+    get_first_bag(storage_options), play_options, node_name, node_options)
+{}
+
 Player::Player(
   std::unique_ptr<rosbag2_cpp::Reader> reader,
   const rosbag2_storage::StorageOptions & storage_options,
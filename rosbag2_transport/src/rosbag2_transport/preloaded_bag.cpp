@@ -0,0 +1,101 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/preloaded_bag.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rosbag2_storage/ros_helper.hpp"
+
+namespace rosbag2_transport
+{
+
+PreloadedBag::PreloadedBag(size_t max_bytes)
+: max_bytes_(max_bytes), arena_(std::make_shared<std::vector<uint8_t>>())
+{}
+
+void PreloadedBag::reserve(size_t bytes)
+{
+  if (max_bytes_ > 0) {
+    bytes = std::min(bytes, max_bytes_);
+  }
+  arena_->reserve(bytes);
+}
+
+bool PreloadedBag::add(const rosbag2_storage::SerializedBagMessage & message)
+{
+  const size_t length = message.serialized_data ? message.serialized_data->buffer_length : 0;
+  auto topic_index = topic_indices_.find(message.topic_name);
+  const size_t topic_name_bytes =
+    topic_index == topic_indices_.end() ? message.topic_name.size() : 0;
+  if (max_bytes_ > 0 &&
+    size_in_bytes() + length + sizeof(Entry) + topic_name_bytes > max_bytes_)
+  {
+    return false;
+  }
+  if (topic_index == topic_indices_.end()) {
+    topic_index = topic_indices_.emplace(
+      message.topic_name, static_cast<uint32_t>(topic_names_.size())).first;
+    topic_names_.push_back(message.topic_name);
+    topic_names_bytes_ += topic_name_bytes;
+  }
+  const size_t offset = arena_->size();
+  if (length > 0) {
+    arena_->insert(
+      arena_->end(), message.serialized_data->buffer, message.serialized_data->buffer + length);
+  }
+  entries_.push_back(
+    Entry{message.time_stamp, message.send_timestamp, message.sequence_number, offset, length,
+      topic_index->second, message.topic_id});
+  return true;
+}
+
+size_t PreloadedBag::size() const
+{
+  return entries_.size();
+}
+
+size_t PreloadedBag::size_in_bytes() const
+{
+  return arena_->size() + entries_.size() * sizeof(Entry) + topic_names_bytes_;
+}
+
+size_t PreloadedBag::find(rcutils_time_point_value_t time_point) const
+{
+  auto entry = std::lower_bound(
+    entries_.begin(), entries_.end(), time_point,
+    [](const Entry & entry, rcutils_time_point_value_t time_point) {
+      return entry.time_stamp < time_point;
+    });
+  return static_cast<size_t>(entry - entries_.begin());
+}
+
+rosbag2_storage::SerializedBagMessageSharedPtr PreloadedBag::get(size_t index) const
+{
+  const Entry & entry = entries_.at(index);
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->serialized_data = rosbag2_storage::make_serialized_message_view(
+    arena_->data() + entry.offset, entry.length, arena_);
+  message->time_stamp = entry.time_stamp;
+  message->topic_name = topic_names_[entry.topic_index];
+  message->topic_id = entry.topic_id;
+  message->send_timestamp = entry.send_timestamp;
+  message->sequence_number = entry.sequence_number;
+  return message;
+}
+
+}  // namespace rosbag2_transport
@@ -0,0 +1,107 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/publisher_thread_pool.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "logging.hpp"
+
+namespace rosbag2_transport
+{
+
+PublisherThreadPool::PublisherThreadPool(size_t number_of_threads)
+{
+  if (number_of_threads == 0) {
+    throw std::invalid_argument("PublisherThreadPool needs at least one thread");
+  }
+  workers_.reserve(number_of_threads);
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (auto & worker : workers_) {
+    worker->thread = std::thread(&PublisherThreadPool::run, this, std::ref(*worker));
+  }
+}
+
+PublisherThreadPool::~PublisherThreadPool()
+{
+  for (auto & worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->stop = true;
+    worker->tasks.clear();
+    worker->condition.notify_all();
+  }
+  for (auto & worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void PublisherThreadPool::queue(const std::string & key, std::function<void()> task)
+{
+  auto & worker = *workers_[std::hash<std::string>{}(key) % workers_.size()];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  worker.tasks.push_back(std::move(task));
+  worker.condition.notify_all();
+}
+
+void PublisherThreadPool::wait_for_queued_tasks()
+{
+  for (auto & worker : workers_) {
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    worker->condition.wait(
+      lock, [&worker]() {
+        return worker->tasks.empty() && !worker->running_task;
+      });
+  }
+}
+
+size_t PublisherThreadPool::get_number_of_threads() const
+{
+  return workers_.size();
+}
+
+void PublisherThreadPool::run(Worker & worker)
+{
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  while (true) {
+    worker.condition.wait(
+      lock, [&worker]() {
+        return worker.stop || !worker.tasks.empty();
+      });
+    if (worker.stop) {
+      return;
+    }
+    auto task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    worker.running_task = true;
+    lock.unlock();
+    try {
+      task();
+    } catch (const std::exception & e) {
+      ROSBAG2_TRANSPORT_LOG_ERROR_STREAM("Publishing task failed: " << e.what());
+    }
+    lock.lock();
+    worker.running_task = false;
+    // Wake up wait_for_queued_tasks()
+    worker.condition.notify_all();
+  }
+}
+
+}  // namespace rosbag2_transport
@@ -14,37 +14,110 @@
 
 #include "rosbag2_transport/reader_writer_factory.hpp"
 
+#include <cstddef>
+#include <filesystem>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "rosbag2_compression/compression_options.hpp"
 #include "rosbag2_compression/sequential_compression_reader.hpp"
 #include "rosbag2_compression/sequential_compression_writer.hpp"
+#include "rosbag2_cpp/header_stamp_index.hpp"
+#include "rosbag2_cpp/readers/header_stamp_order_reader.hpp"
+#include "rosbag2_cpp/readers/merging_reader.hpp"
+#include "rosbag2_cpp/readers/multi_bag_reader.hpp"
+#include "rosbag2_cpp/readers/prefetching_reader.hpp"
+#include "rosbag2_cpp/writers/routing_writer.hpp"
+#include "rosbag2_cpp/writers/striped_writer.hpp"
 #include "rosbag2_storage/metadata_io.hpp"
 
 namespace rosbag2_transport
 {
 
-std::unique_ptr<rosbag2_cpp::Reader> ReaderWriterFactory::make_reader(
-  const rosbag2_storage::StorageOptions & storage_options)
+namespace
+{
+std::unique_ptr<rosbag2_cpp::reader_interfaces::BaseReaderInterface> make_reader_impl(
+  const rosbag2_storage::StorageOptions & storage_options,
+  size_t prefetch_queue_bytes)
 {
   rosbag2_storage::MetadataIo metadata_io;
   std::unique_ptr<rosbag2_cpp::reader_interfaces::BaseReaderInterface> reader_impl;
 
   if (metadata_io.metadata_file_exists(storage_options.uri)) {
     auto metadata = metadata_io.read_metadata(storage_options.uri);
+    auto sub_bags = metadata.custom_data.find(rosbag2_cpp::writers::RoutingWriter::kSubBagsKey);
+    if (sub_bags != metadata.custom_data.end()) {
+      // Sub-bags of a routed bag, which may be compressed differently, read merged by time
+      std::vector<rosbag2_cpp::readers::MultiBagReader::Bag> bags;
+      std::istringstream sub_bag_names(sub_bags->second);
+      std::string sub_bag_name;
+      while (std::getline(sub_bag_names, sub_bag_name, ',')) {
+        auto sub_bag_options = storage_options;
+        sub_bag_options.uri =
+          (std::filesystem::path(storage_options.uri) / sub_bag_name).string();
+        bags.push_back(
+          {sub_bag_options, make_reader_impl(sub_bag_options, prefetch_queue_bytes)});
+      }
+      return std::make_unique<rosbag2_cpp::readers::MultiBagReader>(std::move(bags));
+    }
     if (!metadata.compression_format.empty()) {
       reader_impl = std::make_unique<rosbag2_compression::SequentialCompressionReader>();
+    } else if (rosbag2_cpp::readers::MergingReader::files_overlap(metadata)) {
+      // Files of a striped bag, which are only in time order if read merged. The MergingReader
+      // prefetches from every file itself.
+      return std::make_unique<rosbag2_cpp::readers::MergingReader>();
     }
   }
   if (!reader_impl) {
     reader_impl = std::make_unique<rosbag2_cpp::readers::SequentialReader>();
   }
+  if (rosbag2_cpp::HeaderStampIndex::exists(storage_options.uri)) {
+    // Adds ReadOrder::HeaderTimestamp, other read orders are passed on
+    reader_impl = std::make_unique<rosbag2_cpp::readers::HeaderStampOrderReader>(
+      std::move(reader_impl));
+  }
+  if (prefetch_queue_bytes > 0) {
+    reader_impl = std::make_unique<rosbag2_cpp::readers::PrefetchingReader>(
+      std::move(reader_impl), prefetch_queue_bytes);
+  }
+  return reader_impl;
+}
+}  // namespace
 
-  return std::make_unique<rosbag2_cpp::Reader>(std::move(reader_impl));
+std::unique_ptr<rosbag2_cpp::Reader> ReaderWriterFactory::make_reader(
+  const rosbag2_storage::StorageOptions & storage_options,
+  size_t prefetch_queue_bytes)
+{
+  return std::make_unique<rosbag2_cpp::Reader>(
+    make_reader_impl(storage_options, prefetch_queue_bytes));
 }
 
-std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
+std::unique_ptr<rosbag2_cpp::Reader> ReaderWriterFactory::make_reader(
+  const std::vector<rosbag2_storage::StorageOptions> & storage_options,
+  size_t prefetch_queue_bytes)
+{
+  if (storage_options.size() == 1) {
+    return make_reader(storage_options.front(), prefetch_queue_bytes);
+  }
+  if (prefetch_queue_bytes == 0) {
+    prefetch_queue_bytes = rosbag2_cpp::readers::PrefetchingReader::kDefaultMaxPrefetchedBytes;
+  }
+  std::vector<rosbag2_cpp::readers::MultiBagReader::Bag> bags;
+  for (const auto & bag_storage_options : storage_options) {
+    bags.push_back(
+      {bag_storage_options, make_reader_impl(bag_storage_options, prefetch_queue_bytes)});
+  }
+  return std::make_unique<rosbag2_cpp::Reader>(
+    std::make_unique<rosbag2_cpp::readers::MultiBagReader>(std::move(bags)));
+}
+
+namespace
+{
+std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> make_writer_impl(
   const rosbag2_transport::RecordOptions & record_options)
 {
   std::unique_ptr<rosbag2_cpp::writer_interfaces::BaseWriterInterface> writer_impl;
@@ -55,7 +128,28 @@ std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
       record_options.compression_queue_size,
       record_options.compression_threads,
       record_options.compression_threads_priority,
+      record_options.compression_dictionary_training_messages,
+      record_options.compression_dictionary,
+      record_options.compression_adaptive_level,
+      record_options.compression_min_level,
+      record_options.compression_max_level,
     };
+    compression_options.compression_policy =
+      rosbag2_compression::compression_policy_from_string(record_options.compression_policy);
+    for (const auto & [topic, policy] : record_options.compression_topic_policies) {
+      compression_options.topic_compression_policies[topic] =
+        rosbag2_compression::compression_policy_from_string(policy);
+    }
+    compression_options.compression_probe_messages = record_options.compression_probe_messages;
+    compression_options.compression_skip_ratio = record_options.compression_skip_ratio;
+    compression_options.file_compression_workers = record_options.compression_file_workers;
+    compression_options.file_compression_idle_io = record_options.compression_file_idle_io;
+    compression_options.max_concurrent_file_compressions =
+      record_options.compression_file_max_concurrent;
+    compression_options.file_compression_read_bandwidth =
+      record_options.compression_file_read_bandwidth;
+    compression_options.file_compression_throttle_cache_fill =
+      record_options.compression_file_throttle_cache_fill;
     if (compression_options.compression_threads < 1) {
       compression_options.compression_threads = std::thread::hardware_concurrency();
     }
@@ -64,7 +158,84 @@ std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
   } else {
     writer_impl = std::make_unique<rosbag2_cpp::writers::SequentialWriter>();
   }
+  return writer_impl;
+}
 
+std::unique_ptr<rosbag2_cpp::Writer> make_routing_writer(
+  const rosbag2_transport::RecordOptions & record_options)
+{
+  using rosbag2_cpp::writers::RoutingWriter;
+  if (!record_options.stripe_directories.empty() || record_options.writer_shards > 1) {
+    throw std::invalid_argument(
+            "Routing topics into sub-bags is not compatible with striping or sharding the bag.");
+  }
+  std::vector<RoutingWriter::Route> routes;
+  for (const auto & route : record_options.topic_routes) {
+    routes.push_back(
+      {route.name, route.topics_regex, route.max_bagfile_size, route.max_bagfile_duration,
+        route.max_cache_size});
+  }
+  auto writer_impl = std::make_unique<RoutingWriter>(
+    std::move(routes),
+    [record_options](const std::string & route_name) {
+      auto sub_bag_options = record_options;
+      for (const auto & route : record_options.topic_routes) {
+        if (route.name != route_name) {
+          continue;
+        }
+        if (!route.compression_format.empty()) {
+          sub_bag_options.compression_format = route.compression_format;
+        }
+        if (!route.compression_mode.empty()) {
+          sub_bag_options.compression_mode = route.compression_mode;
+        }
+      }
+      if (rosbag2_compression::compression_mode_from_string(sub_bag_options.compression_mode) ==
+        rosbag2_compression::CompressionMode::NONE)
+      {
+        sub_bag_options.compression_format.clear();
+      }
+      return make_writer_impl(sub_bag_options);
+    });
+  return std::make_unique<rosbag2_cpp::Writer>(std::move(writer_impl));
+}
+}  // namespace
+
+std::unique_ptr<rosbag2_cpp::Writer> ReaderWriterFactory::make_writer(
+  const rosbag2_transport::RecordOptions & record_options)
+{
+  if (!record_options.topic_routes.empty()) {
+    return make_routing_writer(record_options);
+  }
+  if (record_options.stripe_directories.empty() && record_options.writer_shards <= 1) {
+    return std::make_unique<rosbag2_cpp::Writer>(make_writer_impl(record_options));
+  }
+
+  using rosbag2_cpp::writers::StripedWriter;
+  if (!record_options.stripe_directories.empty() && record_options.writer_shards > 1) {
+    throw std::invalid_argument(
+            "Sharding a bag is not compatible with striping it over several directories.");
+  }
+  if (!record_options.compression_format.empty()) {
+    throw std::invalid_argument(
+            "Striping or sharding a bag is not compatible with compression.");
+  }
+  StripedWriter::StripeBy stripe_by;
+  if (record_options.stripe_by == "topic") {
+    stripe_by = StripedWriter::StripeBy::TOPIC;
+  } else if (record_options.stripe_by == "batch") {
+    stripe_by = StripedWriter::StripeBy::BATCH;
+  } else {
+    throw std::invalid_argument(
+            "Invalid stripe_by '" + record_options.stripe_by + "', expected 'topic' or 'batch'.");
+  }
+  // Shards are stripes in the bag directory, which StripedWriter takes as empty directories
+  auto writer_impl = std::make_unique<StripedWriter>(
+    record_options.stripe_directories.empty() ?
+    std::vector<std::string>(record_options.writer_shards, "") :
+    record_options.stripe_directories,
+    [record_options]() {return make_writer_impl(record_options);},
+    stripe_by, record_options.stripe_batch_size);
   return std::make_unique<rosbag2_cpp::Writer>(std::move(writer_impl));
 }
 
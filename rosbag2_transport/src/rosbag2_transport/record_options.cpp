@@ -23,6 +23,44 @@
 namespace YAML
 {
 
+Node convert<rosbag2_transport::TopicRoute>::encode(const rosbag2_transport::TopicRoute & route)
+{
+  Node node;
+  node["name"] = route.name;
+  node["topics_regex"] = route.topics_regex;
+  node["compression_format"] = route.compression_format;
+  node["compression_mode"] = route.compression_mode;
+  if (route.max_bagfile_size) {
+    node["max_bagfile_size"] = *route.max_bagfile_size;
+  }
+  if (route.max_bagfile_duration) {
+    node["max_bagfile_duration"] = *route.max_bagfile_duration;
+  }
+  if (route.max_cache_size) {
+    node["max_cache_size"] = *route.max_cache_size;
+  }
+  return node;
+}
+
+bool convert<rosbag2_transport::TopicRoute>::decode(
+  const Node & node, rosbag2_transport::TopicRoute & route)
+{
+  optional_assign<std::string>(node, "name", route.name);
+  optional_assign<std::string>(node, "topics_regex", route.topics_regex);
+  optional_assign<std::string>(node, "compression_format", route.compression_format);
+  optional_assign<std::string>(node, "compression_mode", route.compression_mode);
+  if (node["max_bagfile_size"]) {
+    route.max_bagfile_size = node["max_bagfile_size"].as<uint64_t>();
+  }
+  if (node["max_bagfile_duration"]) {
+    route.max_bagfile_duration = node["max_bagfile_duration"].as<uint64_t>();
+  }
+  if (node["max_cache_size"]) {
+    route.max_cache_size = node["max_cache_size"].as<uint64_t>();
+  }
+  return true;
+}
+
 Node convert<rosbag2_transport::RecordOptions>::encode(
   const rosbag2_transport::RecordOptions & record_options)
 {
@@ -40,11 +78,52 @@ Node convert<rosbag2_transport::RecordOptions>::encode(
   node["compression_queue_size"] = record_options.compression_queue_size;
   node["compression_threads"] = record_options.compression_threads;
   node["compression_threads_priority"] = record_options.compression_threads_priority;
+  node["compression_dictionary_training_messages"] =
+    record_options.compression_dictionary_training_messages;
+  node["compression_dictionary"] = record_options.compression_dictionary;
+  node["compression_adaptive_level"] = record_options.compression_adaptive_level;
+  node["compression_min_level"] = record_options.compression_min_level;
+  node["compression_max_level"] = record_options.compression_max_level;
+  node["compression_policy"] = record_options.compression_policy;
+  for (const auto & [topic, policy] : record_options.compression_topic_policies) {
+    node["compression_topic_policies"][topic] = policy;
+  }
+  node["compression_probe_messages"] = record_options.compression_probe_messages;
+  node["compression_skip_ratio"] = record_options.compression_skip_ratio;
+  node["compression_file_workers"] = record_options.compression_file_workers;
+  node["compression_file_idle_io"] = record_options.compression_file_idle_io;
+  node["compression_file_max_concurrent"] = record_options.compression_file_max_concurrent;
+  node["compression_file_read_bandwidth"] = record_options.compression_file_read_bandwidth;
+  node["compression_file_throttle_cache_fill"] =
+    record_options.compression_file_throttle_cache_fill;
   node["topic_qos_profile_overrides"] =
     convert<std::unordered_map<std::string, rclcpp::QoS>>::encode(
     record_options.topic_qos_profile_overrides);
   node["include_hidden_topics"] = record_options.include_hidden_topics;
   node["include_unpublished_topics"] = record_options.include_unpublished_topics;
+  node["use_receive_timestamp"] = record_options.use_receive_timestamp;
+  node["message_buffer_pool_size"] = record_options.message_buffer_pool_size;
+  node["message_buffer_arena_size"] = record_options.message_buffer_arena_size;
+  node["message_buffer_numa_node"] = record_options.message_buffer_numa_node;
+  node["executor_threads"] = record_options.executor_threads;
+  node["callback_groups"] = record_options.callback_groups;
+  node["topics_per_callback_group"] = record_options.topics_per_callback_group;
+  node["subscription_creation_threads"] = record_options.subscription_creation_threads;
+  node["split_writers"] = record_options.split_writers;
+  node["time_slices"] = record_options.time_slices;
+  node["pipeline_statistics_interval"] = record_options.pipeline_statistics_interval;
+  node["stripe_directories"] = record_options.stripe_directories;
+  node["stripe_by"] = record_options.stripe_by;
+  node["stripe_batch_size"] = record_options.stripe_batch_size;
+  node["writer_shards"] = record_options.writer_shards;
+  node["upload_command"] = record_options.upload_command;
+  node["upload_max_bandwidth"] = record_options.upload_max_bandwidth;
+  node["upload_journal"] = record_options.upload_journal;
+  node["intra_process_capture"] = record_options.intra_process_capture;
+  for (const auto & [topic, decimation] : record_options.topic_decimation) {
+    node["topic_decimation"][topic] = decimation;
+  }
+  node["topic_routes"] = record_options.topic_routes;
   return node;
 }
 
@@ -70,6 +149,37 @@ bool convert<rosbag2_transport::RecordOptions>::decode(
   optional_assign<int32_t>(
     node, "compression_threads_priority",
     record_options.compression_threads_priority);
+  optional_assign<uint64_t>(
+    node, "compression_dictionary_training_messages",
+    record_options.compression_dictionary_training_messages);
+  optional_assign<std::string>(
+    node, "compression_dictionary", record_options.compression_dictionary);
+  optional_assign<bool>(
+    node, "compression_adaptive_level", record_options.compression_adaptive_level);
+  optional_assign<int32_t>(node, "compression_min_level", record_options.compression_min_level);
+  optional_assign<int32_t>(node, "compression_max_level", record_options.compression_max_level);
+  optional_assign<std::string>(node, "compression_policy", record_options.compression_policy);
+  if (node["compression_topic_policies"]) {
+    record_options.compression_topic_policies.clear();
+    for (const auto & topic_policy : node["compression_topic_policies"]) {
+      record_options.compression_topic_policies.emplace(
+        topic_policy.first.as<std::string>(), topic_policy.second.as<std::string>());
+    }
+  }
+  optional_assign<uint64_t>(
+    node, "compression_probe_messages", record_options.compression_probe_messages);
+  optional_assign<double>(node, "compression_skip_ratio", record_options.compression_skip_ratio);
+  optional_assign<uint64_t>(
+    node, "compression_file_workers", record_options.compression_file_workers);
+  optional_assign<bool>(
+    node, "compression_file_idle_io", record_options.compression_file_idle_io);
+  optional_assign<uint64_t>(
+    node, "compression_file_max_concurrent", record_options.compression_file_max_concurrent);
+  optional_assign<uint64_t>(
+    node, "compression_file_read_bandwidth", record_options.compression_file_read_bandwidth);
+  optional_assign<double>(
+    node, "compression_file_throttle_cache_fill",
+    record_options.compression_file_throttle_cache_fill);
 
   std::unordered_map<std::string, rclcpp::QoS> qos_overrides;
   if (node["topic_qos_profile_overrides"]) {
@@ -82,6 +192,42 @@ bool convert<rosbag2_transport::RecordOptions>::decode(
   optional_assign<bool>(
     node, "include_unpublished_topics",
     record_options.include_unpublished_topics);
+  optional_assign<bool>(node, "use_receive_timestamp", record_options.use_receive_timestamp);
+  optional_assign<uint64_t>(
+    node, "message_buffer_pool_size", record_options.message_buffer_pool_size);
+  optional_assign<uint64_t>(
+    node, "message_buffer_arena_size", record_options.message_buffer_arena_size);
+  optional_assign<int32_t>(
+    node, "message_buffer_numa_node", record_options.message_buffer_numa_node);
+  optional_assign<uint64_t>(node, "executor_threads", record_options.executor_threads);
+  optional_assign<std::string>(node, "callback_groups", record_options.callback_groups);
+  optional_assign<uint64_t>(
+    node, "topics_per_callback_group", record_options.topics_per_callback_group);
+  optional_assign<uint64_t>(
+    node, "subscription_creation_threads", record_options.subscription_creation_threads);
+  optional_assign<uint64_t>(node, "split_writers", record_options.split_writers);
+  optional_assign<uint64_t>(node, "time_slices", record_options.time_slices);
+  optional_assign<std::chrono::milliseconds>(
+    node, "pipeline_statistics_interval", record_options.pipeline_statistics_interval);
+  optional_assign<std::vector<std::string>>(
+    node, "stripe_directories", record_options.stripe_directories);
+  optional_assign<std::string>(node, "stripe_by", record_options.stripe_by);
+  optional_assign<uint64_t>(node, "stripe_batch_size", record_options.stripe_batch_size);
+  optional_assign<uint64_t>(node, "writer_shards", record_options.writer_shards);
+  optional_assign<std::string>(node, "upload_command", record_options.upload_command);
+  optional_assign<uint64_t>(node, "upload_max_bandwidth", record_options.upload_max_bandwidth);
+  optional_assign<std::string>(node, "upload_journal", record_options.upload_journal);
+  optional_assign<bool>(node, "intra_process_capture", record_options.intra_process_capture);
+  if (node["topic_decimation"]) {
+    record_options.topic_decimation.clear();
+    for (const auto & topic_decimation : node["topic_decimation"]) {
+      record_options.topic_decimation.emplace(
+        topic_decimation.first.as<std::string>(),
+        topic_decimation.second.as<rosbag2_transport::TopicDecimation>());
+    }
+  }
+  optional_assign<std::vector<rosbag2_transport::TopicRoute>>(
+    node, "topic_routes", record_options.topic_routes);
   return true;
 }
 
@@ -15,11 +15,19 @@
 #include "rosbag2_transport/recorder.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -28,17 +36,30 @@
 
 #include "rclcpp/logging.hpp"
 #include "rclcpp/clock.hpp"
+#include "rclcpp/generic_subscription.hpp"
+#include "rclcpp/message_info.hpp"
 
 #include "rosbag2_cpp/bag_events.hpp"
+#include "rosbag2_cpp/pipeline_statistics.hpp"
+#include "rosbag2_cpp/thread_scheduling.hpp"
+#include "rosbag2_cpp/typesupport_helpers.hpp"
 #include "rosbag2_cpp/writer.hpp"
 
+#include "rosbag2_interfaces/msg/record_statistics.hpp"
 #include "rosbag2_interfaces/srv/snapshot.hpp"
 
+#include "rosbag2_storage/buffer_pool.hpp"
 #include "rosbag2_storage/yaml.hpp"
 #include "rosbag2_storage/qos.hpp"
 
+#include "deferred_service.hpp"
 #include "logging.hpp"
 #include "rosbag2_transport/config_options_from_node_params.hpp"
+#include "rosbag2_transport/intra_process_capture.hpp"
+#include "rosbag2_transport/publisher_thread_pool.hpp"
+#include "rosbag2_transport/recycling_generic_subscription.hpp"
+#include "rosbag2_transport/split_file_uploader.hpp"
+#include "rosbag2_transport/topic_decimator.hpp"
 #include "rosbag2_transport/topic_filter.hpp"
 
 namespace rosbag2_transport
@@ -85,6 +106,9 @@ public:
   rosbag2_transport::RecordOptions record_options_;
   std::atomic<bool> stop_discovery_ = false;
   std::unordered_map<std::string, std::shared_ptr<rclcpp::SubscriptionBase>> subscriptions_;
+  // Sinks of the topics captured from publishers in the same process
+  std::unordered_map<std::string, std::unique_ptr<IntraProcessCapture::Registration>>
+  intra_process_captures_;
 
 private:
   void topics_discovery();
@@ -92,14 +116,67 @@ private:
   std::unordered_map<std::string, std::string>
   get_missing_topics(const std::unordered_map<std::string, std::string> & all_topics);
 
+  // Subscribe the topics in the order of their cache priority, on
+  // record_options_.subscription_creation_threads threads
   void subscribe_topics(
     const std::unordered_map<std::string, std::string> & topics_and_types);
 
-  void subscribe_topic(const rosbag2_storage::TopicMetadata & topic);
+  void subscribe_topic(const rosbag2_storage::TopicMetadata & topic, const rclcpp::QoS & qos);
+
+  // Call task with the indexes from 0 to count - 1 in ascending order, on up to
+  // record_options_.subscription_creation_threads threads which each take the next index. The
+  // first exception of a task is rethrown once all tasks are done.
+  void for_each_topic_on_threads(
+    size_t count, const std::function<void(size_t)> & task) const;
 
   std::shared_ptr<rclcpp::GenericSubscription> create_subscription(
     const std::string & topic_name, const std::string & topic_type, const rclcpp::QoS & qos);
 
+  // Take the messages which CapturingPublishers in this process publish on the topic
+  void capture_intra_process(const std::string & topic_name, const std::string & topic_type);
+
+  // \returns the decimator of the topic, or nullptr if all of its messages are recorded
+  std::shared_ptr<TopicDecimator> create_decimator(const std::string & topic_name) const;
+
+  // Create the subscription of a topic, which recycles the buffers of its messages if
+  // record_options_.message_buffer_pool_size is set, and allocates them from the message buffer
+  // arena if there is one
+  template<typename CallbackT>
+  std::shared_ptr<rclcpp::GenericSubscription> create_generic_subscription(
+    const std::string & topic_name, const std::string & topic_type, const rclcpp::QoS & qos,
+    CallbackT && callback, const rclcpp::SubscriptionOptions & options)
+  {
+    if (record_options_.message_buffer_pool_size > 0 || message_buffer_pool_) {
+      return create_recycling_generic_subscription(
+        *node, topic_name, topic_type, qos, std::forward<CallbackT>(callback), options,
+        record_options_.message_buffer_pool_size, message_buffer_pool_);
+    }
+    // Like node->create_generic_subscription(), but with the typesupport library shared by
+    // all topics of its package instead of loading it for every topic
+    auto ts_lib = rosbag2_cpp::get_typesupport_library(topic_type, "rosidl_typesupport_cpp");
+    rclcpp::AnySubscriptionCallback<rclcpp::SerializedMessage, std::allocator<void>>
+    any_subscription_callback(*options.get_allocator());
+    any_subscription_callback.set(std::forward<CallbackT>(callback));
+    auto subscription = std::make_shared<rclcpp::GenericSubscription>(
+      node->get_node_base_interface().get(), std::move(ts_lib), topic_name, topic_type, qos,
+      any_subscription_callback, options);
+    node->get_node_topics_interface()->add_subscription(subscription, options.callback_group);
+    return subscription;
+  }
+
+  /**
+   * Find the callback group of the subscription of a new topic, as partitioned by
+   * record_options_.callback_groups.
+   *
+   *   \param qos The QoS profile of the subscription.
+   *   \return The callback group, or nullptr for the default callback group of the node.
+   */
+  rclcpp::CallbackGroup::SharedPtr callback_group_for_topic(const rclcpp::QoS & qos);
+
+  // Receive time of a message, as reported by the middleware, or from the steady clock if the
+  // middleware does not report it
+  rclcpp::Time receive_time(const rmw_message_info_t & message_info) const;
+
   /**
    * Find the QoS profile that should be used for subscribing.
    *
@@ -107,9 +184,12 @@ private:
    * Otherwise, falls back to Rosbag2QoS::adapt_request_to_offers
    *
    *   \param topic_name The full name of the topic, with namespace (ex. /arm/joint_status).
+   *   \param topics_endpoint_info The publishers of the topic.
    *   \return The QoS profile to be used for subscribing.
    */
-  rclcpp::QoS subscription_qos_for_topic(const std::string & topic_name) const;
+  rclcpp::QoS subscription_qos_for_topic(
+    const std::string & topic_name,
+    const std::vector<rclcpp::TopicEndpointInfo> & topics_endpoint_info) const;
 
   // Get all currently offered QoS profiles for a topic.
   std::vector<rclcpp::QoS> offered_qos_profiles_for_topic(
@@ -120,12 +200,29 @@ private:
   void event_publisher_thread_main();
   bool event_publisher_thread_should_wake();
 
+  // Publish the latencies and queue depths measured so far on ~/record_statistics
+  void publish_pipeline_statistics();
+
   rclcpp::Node * node;
   std::unique_ptr<TopicFilter> topic_filter_;
   std::future<void> discovery_future_;
   std::string serialization_format_;
   std::unordered_map<std::string, rclcpp::QoS> topic_qos_profile_overrides_;
   std::unordered_set<std::string> topic_unknown_types_;
+  // Offset of the system clock to the steady clock, for the receive_time() fallback
+  std::chrono::nanoseconds steady_to_system_time_offset_{0};
+  // Guards subscriptions_, intra_process_captures_ and the callback groups while
+  // subscribe_topics() subscribes on several threads
+  std::mutex subscribe_mutex_;
+  // Callback groups of the subscriptions, if record_options_.callback_groups is set
+  rclcpp::CallbackGroup::SharedPtr last_topics_callback_group_;
+  size_t topics_in_last_callback_group_ = 0;
+  std::map<std::pair<rclcpp::ReliabilityPolicy, rclcpp::DurabilityPolicy>,
+    rclcpp::CallbackGroup::SharedPtr> qos_callback_groups_;
+  // The control services do not share a callback group with the subscriptions. Snapshots and
+  // splits are handled on control_request_pool_, off the executor.
+  rclcpp::CallbackGroup::SharedPtr control_callback_group_;
+  std::unique_ptr<PublisherThreadPool> control_request_pool_;
   rclcpp::Service<rosbag2_interfaces::srv::IsPaused>::SharedPtr srv_is_paused_;
   rclcpp::Service<rosbag2_interfaces::srv::Pause>::SharedPtr srv_pause_;
   rclcpp::Service<rosbag2_interfaces::srv::Resume>::SharedPtr srv_resume_;
@@ -146,6 +243,17 @@ private:
   std::mutex event_publisher_thread_mutex_;
   std::condition_variable event_publisher_thread_wake_cv_;
   std::thread event_publisher_thread_;
+
+  // Latencies of the record pipeline, if record_options_.pipeline_statistics_interval is set
+  std::shared_ptr<rosbag2_cpp::PipelineStatistics> pipeline_statistics_;
+  // Allocates the buffers of received messages from the arena of
+  // record_options_.message_buffer_arena_size, if set
+  std::shared_ptr<rosbag2_storage::BufferPool> message_buffer_pool_;
+  rclcpp::Publisher<rosbag2_interfaces::msg::RecordStatistics>::SharedPtr statistics_pub_;
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+
+  // Uploads the closed files of the bag, if record_options_.upload_command is set
+  std::unique_ptr<SplitFileUploader> split_file_uploader_;
 };
 
 RecorderImpl::RecorderImpl(
@@ -167,6 +275,45 @@ RecorderImpl::RecorderImpl(
             "use_sim_time and is_discovery_disabled both set, but are incompatible settings. "
             "The /clock topic needs to be discovered to record with sim time.");
   }
+  if (record_options_.use_sim_time && record_options_.use_receive_timestamp) {
+    throw std::runtime_error(
+            "use_sim_time and use_receive_timestamp both set, but are incompatible settings. "
+            "The middleware reports receive timestamps in system time.");
+  }
+  if (!record_options_.callback_groups.empty() && record_options_.callback_groups != "topic" &&
+    record_options_.callback_groups != "qos")
+  {
+    throw std::runtime_error(
+            "Unknown callback group partitioning '" + record_options_.callback_groups +
+            "'. Use \"topic\", \"qos\" or an empty string for the default callback group.");
+  }
+  for (const auto & [topic, decimation] : record_options_.topic_decimation) {
+    try {
+      TopicDecimator{decimation};
+    } catch (const std::invalid_argument & e) {
+      throw std::runtime_error("Invalid decimation of topic '" + topic + "': " + e.what());
+    }
+  }
+  if (record_options_.message_buffer_arena_size > 0) {
+    rosbag2_storage::BufferPool::ArenaOptions arena_options;
+    arena_options.size = record_options_.message_buffer_arena_size;
+    arena_options.numa_node = record_options_.message_buffer_numa_node;
+    message_buffer_pool_ = std::make_shared<rosbag2_storage::BufferPool>(
+      rosbag2_storage::BufferPool::kDefaultMaxCachedBytes, arena_options);
+  }
+  if (record_options_.message_buffer_numa_node >= 0 &&
+    storage_options_.cache_consumer_thread_cpus.empty())
+  {
+    // Write the cache from the node its buffers are on
+    const auto cpus = rosbag2_cpp::get_numa_node_cpus(record_options_.message_buffer_numa_node);
+    if (cpus.empty()) {
+      RCLCPP_WARN_STREAM(
+        node->get_logger(),
+        "No CPUs found for NUMA node " << record_options_.message_buffer_numa_node <<
+          ". The cache consumer thread is not pinned.");
+    }
+    storage_options_.cache_consumer_thread_cpus.assign(cpus.begin(), cpus.end());
+  }
 
   std::string key_str = enum_key_code_to_str(Recorder::kPauseResumeToggleKey);
   toggle_paused_key_callback_handle_ =
@@ -206,8 +353,32 @@ void RecorderImpl::stop()
     }
   }
   paused_ = true;
+  intra_process_captures_.clear();
   subscriptions_.clear();
+  if (control_request_pool_) {
+    // Snapshots and splits requested so far are written before the bag is closed
+    control_request_pool_->wait_for_queued_tasks();
+  }
   writer_->close();  // Call writer->close() to finalize current bag file and write metadata
+  if (split_file_uploader_) {
+    // Files which are not uploaded yet stay in the upload journal
+    split_file_uploader_->stop();
+    if (split_file_uploader_->pending_count() > 0) {
+      RCLCPP_WARN_STREAM(
+        node->get_logger(),
+        split_file_uploader_->pending_count() << " files of the bag are not uploaded yet.");
+    }
+    split_file_uploader_.reset();
+  }
+
+  if (pipeline_statistics_ && statistics_timer_) {
+    statistics_timer_->cancel();
+    statistics_timer_.reset();
+    publish_pipeline_statistics();
+    RCLCPP_INFO_STREAM(
+      node->get_logger(),
+      "Record pipeline statistics:" << pipeline_statistics_->summary());
+  }
 
   {
     std::lock_guard<std::mutex> lock(event_publisher_thread_mutex_);
@@ -232,36 +403,53 @@ void RecorderImpl::record()
   paused_ = record_options_.start_paused;
   stop_discovery_ = record_options_.is_discovery_disabled;
   topic_qos_profile_overrides_ = record_options_.topic_qos_profile_overrides;
+  steady_to_system_time_offset_ =
+    std::chrono::system_clock::now().time_since_epoch() -
+    std::chrono::steady_clock::now().time_since_epoch();
   if (record_options_.rmw_serialization_format.empty()) {
     throw std::runtime_error("No serialization format specified!");
   }
 
+  if (record_options_.pipeline_statistics_interval.count() > 0) {
+    pipeline_statistics_ = std::make_shared<rosbag2_cpp::PipelineStatistics>();
+  } else {
+    pipeline_statistics_.reset();
+  }
+  writer_->set_pipeline_statistics(pipeline_statistics_);
+
   writer_->open(
     storage_options_,
     {rmw_get_serialization_format(), record_options_.rmw_serialization_format});
 
+  // Kept when recording again, the services of the previous recording may still queue requests
+  if (!control_callback_group_) {
+    control_callback_group_ =
+      node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    control_request_pool_ = std::make_unique<PublisherThreadPool>(1);
+  }
+
   // Only expose snapshot service when mode is enabled
   if (storage_options_.snapshot_mode) {
-    srv_snapshot_ = node->create_service<rosbag2_interfaces::srv::Snapshot>(
-      "~/snapshot",
+    srv_snapshot_ = create_deferred_service<rosbag2_interfaces::srv::Snapshot>(
+      *node, "~/snapshot", *control_request_pool_,
       [this](
-        const std::shared_ptr<rmw_request_id_t>/* request_header */,
-        const std::shared_ptr<rosbag2_interfaces::srv::Snapshot::Request>/* request */,
-        const std::shared_ptr<rosbag2_interfaces::srv::Snapshot::Response> response)
+        const std::shared_ptr<rosbag2_interfaces::srv::Snapshot::Request> &/* request */,
+        rosbag2_interfaces::srv::Snapshot::Response & response)
       {
-        response->success = writer_->take_snapshot();
-      });
+        response.success = writer_->take_snapshot();
+      },
+      control_callback_group_);
   }
 
-  srv_split_bagfile_ = node->create_service<rosbag2_interfaces::srv::SplitBagfile>(
-    "~/split_bagfile",
+  srv_split_bagfile_ = create_deferred_service<rosbag2_interfaces::srv::SplitBagfile>(
+    *node, "~/split_bagfile", *control_request_pool_,
     [this](
-      const std::shared_ptr<rmw_request_id_t>/* request_header */,
-      const std::shared_ptr<rosbag2_interfaces::srv::SplitBagfile::Request>/* request */,
-      const std::shared_ptr<rosbag2_interfaces::srv::SplitBagfile::Response>/* response */)
+      const std::shared_ptr<rosbag2_interfaces::srv::SplitBagfile::Request> &/* request */,
+      rosbag2_interfaces::srv::SplitBagfile::Response &/* response */)
     {
       writer_->split_bagfile();
-    });
+    },
+    control_callback_group_);
 
   srv_pause_ = node->create_service<rosbag2_interfaces::srv::Pause>(
     "~/pause",
@@ -271,7 +459,8 @@ void RecorderImpl::record()
       const std::shared_ptr<rosbag2_interfaces::srv::Pause::Response>/* response */)
     {
       pause();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
 
   srv_resume_ = node->create_service<rosbag2_interfaces::srv::Resume>(
     "~/resume",
@@ -281,7 +470,8 @@ void RecorderImpl::record()
       const std::shared_ptr<rosbag2_interfaces::srv::Resume::Response>/* response */)
     {
       resume();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
 
   srv_is_paused_ = node->create_service<rosbag2_interfaces::srv::IsPaused>(
     "~/is_paused",
@@ -291,7 +481,8 @@ void RecorderImpl::record()
       const std::shared_ptr<rosbag2_interfaces::srv::IsPaused::Response> response)
     {
       response->paused = is_paused();
-    });
+    },
+    rclcpp::ServicesQoS(), control_callback_group_);
 
   split_event_pub_ =
     node->create_publisher<rosbag2_interfaces::msg::WriteSplitEvent>("events/write_split", 1);
@@ -299,9 +490,28 @@ void RecorderImpl::record()
   // Start the thread that will publish events
   event_publisher_thread_ = std::thread(&RecorderImpl::event_publisher_thread_main, this);
 
+  if (pipeline_statistics_) {
+    statistics_pub_ = node->create_publisher<rosbag2_interfaces::msg::RecordStatistics>(
+      "~/record_statistics", 10);
+    statistics_timer_ = node->create_wall_timer(
+      record_options_.pipeline_statistics_interval,
+      [this]() {publish_pipeline_statistics();});
+  }
+
+  if (!record_options_.upload_command.empty()) {
+    SplitFileUploader::Options upload_options;
+    upload_options.command = record_options_.upload_command;
+    upload_options.max_bandwidth = record_options_.upload_max_bandwidth;
+    upload_options.journal_path = record_options_.upload_journal;
+    split_file_uploader_ = std::make_unique<SplitFileUploader>(upload_options);
+  }
+
   rosbag2_cpp::bag_events::WriterEventCallbacks callbacks;
   callbacks.write_split_callback =
     [this](rosbag2_cpp::bag_events::BagSplitInfo & info) {
+      if (split_file_uploader_ && !info.closed_file.empty()) {
+        split_file_uploader_->enqueue(info.closed_file);
+      }
       {
         std::lock_guard<std::mutex> lock(event_publisher_thread_mutex_);
         bag_split_info_ = info;
@@ -338,6 +548,16 @@ void RecorderImpl::event_publisher_thread_main()
       auto message = rosbag2_interfaces::msg::WriteSplitEvent();
       message.closed_file = bag_split_info_.closed_file;
       message.opened_file = bag_split_info_.opened_file;
+      const auto & statistics = bag_split_info_.closed_file_statistics;
+      message.closed_file_size = statistics.size;
+      message.closed_file_message_count = statistics.message_count;
+      message.write_latency_p50 = statistics.write_latency_p50.count();
+      message.write_latency_p90 = statistics.write_latency_p90.count();
+      message.write_latency_p99 = statistics.write_latency_p99.count();
+      message.write_latency_max = statistics.write_latency_max.count();
+      message.dropped_message_count = statistics.dropped_message_count;
+      message.compression_ratio = statistics.compression_ratio;
+      message.close_duration = statistics.close_duration.count();
       try {
         split_event_pub_->publish(message);
       } catch (const std::exception & e) {
@@ -359,6 +579,53 @@ bool RecorderImpl::event_publisher_thread_should_wake()
   return write_split_has_occurred_ || event_publisher_thread_should_exit_;
 }
 
+void RecorderImpl::publish_pipeline_statistics()
+{
+  using rosbag2_cpp::PipelineQueue;
+  using rosbag2_cpp::PipelineStage;
+
+  rosbag2_interfaces::msg::RecordStatistics message;
+  message.stamp = node->get_clock()->now();
+  for (size_t i = 0; i < static_cast<size_t>(PipelineStage::COUNT); ++i) {
+    const auto stage = static_cast<PipelineStage>(i);
+    const auto & histogram = pipeline_statistics_->histogram(stage);
+    if (histogram.count() == 0) {
+      continue;
+    }
+    rosbag2_interfaces::msg::PipelineStageStatistics stage_statistics;
+    stage_statistics.stage = rosbag2_cpp::pipeline_stage_to_string(stage);
+    stage_statistics.count = histogram.count();
+    stage_statistics.mean = histogram.mean().count();
+    stage_statistics.p50 = histogram.percentile(50.0).count();
+    stage_statistics.p90 = histogram.percentile(90.0).count();
+    stage_statistics.p99 = histogram.percentile(99.0).count();
+    stage_statistics.max = histogram.max().count();
+    message.stages.push_back(std::move(stage_statistics));
+  }
+  message.cache_batch_messages =
+    pipeline_statistics_->queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES);
+  message.max_cache_batch_messages =
+    pipeline_statistics_->max_queue_depth(PipelineQueue::CACHE_BATCH_MESSAGES);
+  message.cache_batch_bytes = pipeline_statistics_->queue_depth(PipelineQueue::CACHE_BATCH_BYTES);
+  message.max_cache_batch_bytes =
+    pipeline_statistics_->max_queue_depth(PipelineQueue::CACHE_BATCH_BYTES);
+  message.compression_queue_messages =
+    pipeline_statistics_->queue_depth(PipelineQueue::COMPRESSION_QUEUE_MESSAGES);
+  message.max_compression_queue_messages =
+    pipeline_statistics_->max_queue_depth(PipelineQueue::COMPRESSION_QUEUE_MESSAGES);
+  for (const auto & [priority, dropped] : pipeline_statistics_->cache_dropped_messages()) {
+    message.cache_drop_priorities.push_back(priority);
+    message.cache_dropped_messages.push_back(dropped);
+  }
+  try {
+    statistics_pub_->publish(message);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR_STREAM(
+      node->get_logger(),
+      "Failed to publish message on '~/record_statistics' topic. \nError: " << e.what());
+  }
+}
+
 const rosbag2_cpp::Writer & RecorderImpl::get_writer_handle()
 {
   return *writer_;
@@ -406,7 +673,18 @@ void RecorderImpl::topics_discovery()
       RCLCPP_INFO(node->get_logger(), "Sim time /clock found, starting recording.");
     }
   }
+  // Topics are only rediscovered when the ROS graph changed, instead of querying the graph and
+  // filtering all topics every polling interval. The interval bounds the wait, so that stop() is
+  // noticed in time.
+  auto graph_event = node->get_graph_event();
+  bool discover_topics = true;
   while (rclcpp::ok() && stop_discovery_ == false) {
+    if (!discover_topics) {
+      node->wait_for_graph_change(graph_event, record_options_.topic_polling_interval);
+      discover_topics = graph_event->check_and_clear();
+      continue;
+    }
+    discover_topics = false;
     try {
       auto topics_to_subscribe = get_requested_or_available_topics();
       for (const auto & topic_and_type : topics_to_subscribe) {
@@ -425,10 +703,15 @@ void RecorderImpl::topics_discovery()
       }
     } catch (const std::exception & e) {
       RCLCPP_ERROR_STREAM(node->get_logger(), "Failure in topics discovery.\nError: " << e.what());
+      discover_topics = true;
     } catch (...) {
       RCLCPP_ERROR_STREAM(node->get_logger(), "Failure in topics discovery.");
+      discover_topics = true;
+    }
+    if (discover_topics) {
+      // Retry a failed discovery after the polling interval, even without a graph change
+      std::this_thread::sleep_for(record_options_.topic_polling_interval);
     }
-    std::this_thread::sleep_for(record_options_.topic_polling_interval);
   }
 }
 
@@ -455,30 +738,97 @@ RecorderImpl::get_missing_topics(const std::unordered_map<std::string, std::stri
 void RecorderImpl::subscribe_topics(
   const std::unordered_map<std::string, std::string> & topics_and_types)
 {
+  std::vector<rosbag2_storage::TopicMetadata> topics;
+  topics.reserve(topics_and_types.size());
   for (const auto & topic_with_type : topics_and_types) {
-    auto endpoint_infos = node->get_publishers_info_by_topic(topic_with_type.first);
-    subscribe_topic(
-      {
-        topic_with_type.first,
-        topic_with_type.second,
-        serialization_format_,
-        offered_qos_profiles_for_topic(endpoint_infos),
-        type_description_hash_for_topic(endpoint_infos),
+    topics.push_back(
+      {topic_with_type.first, topic_with_type.second, serialization_format_, {}, ""});
+  }
+  // Topics with a higher cache priority are recorded first, while the others are still being
+  // subscribed
+  const auto & priorities = storage_options_.cache_topic_priorities;
+  const auto priority_of = [&priorities](const rosbag2_storage::TopicMetadata & topic) {
+      const auto priority = priorities.find(topic.name);
+      return priority != priorities.end() ? priority->second : 0u;
+    };
+  std::stable_sort(
+    topics.begin(), topics.end(),
+    [&priority_of](const auto & a, const auto & b) {return priority_of(a) > priority_of(b);});
+
+  // The publishers of every topic are queried once, for its metadata and the QoS profile of
+  // its subscription
+  std::vector<std::optional<rclcpp::QoS>> subscription_qos_profiles(topics.size());
+  for_each_topic_on_threads(
+    topics.size(), [this, &topics, &subscription_qos_profiles](size_t i) {
+      auto endpoint_infos = node->get_publishers_info_by_topic(topics[i].name);
+      topics[i].offered_qos_profiles = offered_qos_profiles_for_topic(endpoint_infos);
+      topics[i].type_description_hash = type_description_hash_for_topic(endpoint_infos);
+      subscription_qos_profiles[i] = subscription_qos_for_topic(topics[i].name, endpoint_infos);
+    });
+  // The definitions of all topics are looked up in the background while the topics are
+  // subscribed
+  writer_->prefetch_message_definitions(topics);
+  for_each_topic_on_threads(
+    topics.size(), [this, &topics, &subscription_qos_profiles](size_t i) {
+      subscribe_topic(topics[i], *subscription_qos_profiles[i]);
+    });
+}
+
+void RecorderImpl::for_each_topic_on_threads(
+  size_t count, const std::function<void(size_t)> & task) const
+{
+  const size_t number_of_threads = std::min<size_t>(
+    record_options_.subscription_creation_threads, count);
+  if (number_of_threads <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      task(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next_index{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  std::vector<std::thread> threads;
+  threads.reserve(number_of_threads);
+  for (size_t i = 0; i < number_of_threads; ++i) {
+    threads.emplace_back(
+      [&]() {
+        for (size_t index = next_index++; index < count; index = next_index++) {
+          try {
+            task(index);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        }
       });
   }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
 }
 
-void RecorderImpl::subscribe_topic(const rosbag2_storage::TopicMetadata & topic)
+void RecorderImpl::subscribe_topic(
+  const rosbag2_storage::TopicMetadata & topic, const rclcpp::QoS & qos)
 {
   // Need to create topic in writer before we are trying to create subscription. Since in
   // callback for subscription we are calling writer_->write(bag_message); and it could happened
   // that callback called before we reached out the line: writer_->create_topic(topic)
   writer_->create_topic(topic);
 
-  rosbag2_storage::Rosbag2QoS subscription_qos{subscription_qos_for_topic(topic.name)};
+  rosbag2_storage::Rosbag2QoS subscription_qos{qos};
   auto subscription = create_subscription(topic.name, topic.type, subscription_qos);
+  std::lock_guard<std::mutex> lock(subscribe_mutex_);
   if (subscription) {
     subscriptions_.insert({topic.name, subscription});
+    if (record_options_.intra_process_capture) {
+      capture_intra_process(topic.name, topic.type);
+    }
     RCLCPP_INFO_STREAM(
       node->get_logger(),
       "Subscribed to topic '" << topic.name << "'");
@@ -492,18 +842,149 @@ std::shared_ptr<rclcpp::GenericSubscription>
 RecorderImpl::create_subscription(
   const std::string & topic_name, const std::string & topic_type, const rclcpp::QoS & qos)
 {
-  auto subscription = node->create_generic_subscription(
+  rclcpp::SubscriptionOptions subscription_options;
+  {
+    std::lock_guard<std::mutex> lock(subscribe_mutex_);
+    subscription_options.callback_group = callback_group_for_topic(qos);
+  }
+  // Messages of publishers in this process are captured before they reach the middleware
+  subscription_options.ignore_local_publications = record_options_.intra_process_capture;
+  // Owned by the callback, which is the only one using it
+  std::shared_ptr<TopicDecimator> decimator = create_decimator(topic_name);
+  if (record_options_.record_publish_info || record_options_.use_receive_timestamp) {
+    return create_generic_subscription(
+      topic_name,
+      topic_type,
+      qos,
+      [this, topic_name, topic_type, decimator](
+        std::shared_ptr<const rclcpp::SerializedMessage> message,
+        const rclcpp::MessageInfo & message_info) {
+        // Messages which are discarded anyway are dropped before anything else is done for them
+        if (paused_.load(std::memory_order_relaxed)) {
+          return;
+        }
+        rosbag2_cpp::StageTimer timer(
+          pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::SUBSCRIPTION_CALLBACK);
+        const rmw_message_info_t & rmw_message_info = message_info.get_rmw_message_info();
+        const rclcpp::Time time = record_options_.use_receive_timestamp ?
+          receive_time(rmw_message_info) : node->get_clock()->now();
+        if (!writer_->is_within_time_window(time.nanoseconds()) ||
+          (decimator && !decimator->keep(time.nanoseconds())))
+        {
+          return;
+        }
+        if (record_options_.record_publish_info) {
+          // The middleware reports a sequence number of 0 if it does not support them
+          writer_->write(
+            message, topic_name, topic_type, time,
+            rmw_message_info.source_timestamp, rmw_message_info.publication_sequence_number);
+        } else {
+          writer_->write(message, topic_name, topic_type, time);
+        }
+      },
+      subscription_options);
+  }
+  auto subscription = create_generic_subscription(
     topic_name,
     topic_type,
     qos,
-    [this, topic_name, topic_type](std::shared_ptr<const rclcpp::SerializedMessage> message) {
-      if (!paused_.load()) {
-        writer_->write(message, topic_name, topic_type, node->get_clock()->now());
+    [this, topic_name, topic_type, decimator](
+      std::shared_ptr<const rclcpp::SerializedMessage> message) {
+      if (paused_.load(std::memory_order_relaxed)) {
+        return;
       }
-    });
+      rosbag2_cpp::StageTimer timer(
+        pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::SUBSCRIPTION_CALLBACK);
+      const rclcpp::Time time = node->get_clock()->now();
+      if (!writer_->is_within_time_window(time.nanoseconds()) ||
+        (decimator && !decimator->keep(time.nanoseconds())))
+      {
+        return;
+      }
+      writer_->write(message, topic_name, topic_type, time);
+    },
+    subscription_options);
   return subscription;
 }
 
+void RecorderImpl::capture_intra_process(
+  const std::string & topic_name, const std::string & topic_type)
+{
+  // The sink is called on the threads of the publishers, which may publish concurrently
+  auto decimator = create_decimator(topic_name);
+  auto decimator_mutex = std::make_shared<std::mutex>();
+  intra_process_captures_[topic_name] = IntraProcessCapture::instance().add_sink(
+    topic_name,
+    [this, topic_name, topic_type, decimator, decimator_mutex](
+      std::shared_ptr<const rclcpp::SerializedMessage> message) {
+      if (paused_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      rosbag2_cpp::StageTimer timer(
+        pipeline_statistics_.get(), rosbag2_cpp::PipelineStage::SUBSCRIPTION_CALLBACK);
+      // Captured messages have no receive time, they are stamped when they are published
+      const rclcpp::Time time = node->get_clock()->now();
+      if (!writer_->is_within_time_window(time.nanoseconds())) {
+        return;
+      }
+      if (decimator) {
+        std::lock_guard<std::mutex> lock(*decimator_mutex);
+        if (!decimator->keep(time.nanoseconds())) {
+          return;
+        }
+      }
+      writer_->write(std::move(message), topic_name, topic_type, time);
+    });
+}
+
+std::shared_ptr<TopicDecimator>
+RecorderImpl::create_decimator(const std::string & topic_name) const
+{
+  auto decimation = record_options_.topic_decimation.find(topic_name);
+  if (decimation == record_options_.topic_decimation.end()) {
+    return nullptr;
+  }
+  return std::make_shared<TopicDecimator>(decimation->second);
+}
+
+rclcpp::Time RecorderImpl::receive_time(const rmw_message_info_t & message_info) const
+{
+  if (message_info.received_timestamp != 0) {
+    return rclcpp::Time(message_info.received_timestamp, RCL_SYSTEM_TIME);
+  }
+  // Reading the steady clock is cheaper than the ROS clock and uses the same time base here,
+  // because use_sim_time is not allowed with receive timestamps
+  const auto now = std::chrono::steady_clock::now().time_since_epoch() +
+    steady_to_system_time_offset_;
+  return rclcpp::Time(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), RCL_SYSTEM_TIME);
+}
+
+rclcpp::CallbackGroup::SharedPtr RecorderImpl::callback_group_for_topic(const rclcpp::QoS & qos)
+{
+  // The groups are mutually exclusive, so that the messages of a topic are written in the order
+  // of their arrival. The writer is safe to call from the callbacks of several groups at once.
+  if (record_options_.callback_groups == "topic") {
+    if (!last_topics_callback_group_ ||
+      topics_in_last_callback_group_ >= record_options_.topics_per_callback_group)
+    {
+      last_topics_callback_group_ =
+        node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+      topics_in_last_callback_group_ = 0;
+    }
+    ++topics_in_last_callback_group_;
+    return last_topics_callback_group_;
+  }
+  if (record_options_.callback_groups == "qos") {
+    auto & callback_group = qos_callback_groups_[{qos.reliability(), qos.durability()}];
+    if (!callback_group) {
+      callback_group = node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    }
+    return callback_group;
+  }
+  return nullptr;
+}
+
 std::vector<rclcpp::QoS> RecorderImpl::offered_qos_profiles_for_topic(
   const std::vector<rclcpp::TopicEndpointInfo> & topics_endpoint_info) const
 {
@@ -569,7 +1050,9 @@ std::string type_description_hash_for_topic(
   return type_hash_to_string(result_hash);
 }
 
-rclcpp::QoS RecorderImpl::subscription_qos_for_topic(const std::string & topic_name) const
+rclcpp::QoS RecorderImpl::subscription_qos_for_topic(
+  const std::string & topic_name,
+  const std::vector<rclcpp::TopicEndpointInfo> & topics_endpoint_info) const
 {
   if (topic_qos_profile_overrides_.count(topic_name)) {
     RCLCPP_INFO_STREAM(
@@ -577,8 +1060,7 @@ rclcpp::QoS RecorderImpl::subscription_qos_for_topic(const std::string & topic_n
       "Overriding subscription profile for " << topic_name);
     return topic_qos_profile_overrides_.at(topic_name);
   }
-  return rosbag2_storage::Rosbag2QoS::adapt_request_to_offers(
-    topic_name, node->get_publishers_info_by_topic(topic_name));
+  return rosbag2_storage::Rosbag2QoS::adapt_request_to_offers(topic_name, topics_endpoint_info);
 }
 
 void RecorderImpl::warn_if_new_qos_for_subscribed_topic(const std::string & topic_name)
@@ -0,0 +1,90 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "rosbag2_transport/recycling_generic_subscription.hpp"
+
+namespace rosbag2_transport
+{
+
+RecyclingGenericSubscription::RecyclingGenericSubscription(
+  rclcpp::node_interfaces::NodeBaseInterface * node_base,
+  const std::shared_ptr<rcpputils::SharedLibrary> ts_lib,
+  const std::string & topic_name,
+  const std::string & topic_type,
+  const rclcpp::QoS & qos,
+  rclcpp::AnySubscriptionCallback<rclcpp::SerializedMessage, std::allocator<void>> callback,
+  const rclcpp::SubscriptionOptions & options,
+  size_t max_free_messages,
+  std::shared_ptr<rosbag2_storage::BufferPool> buffer_pool)
+: rclcpp::GenericSubscription(
+    node_base, ts_lib, topic_name, topic_type, qos, callback, options),
+  pool_(std::make_shared<MessagePool>())
+{
+  pool_->buffer_pool = std::move(buffer_pool);
+  pool_->max_free_messages = max_free_messages;
+  pool_->free_messages.reserve(max_free_messages);
+}
+
+std::shared_ptr<rclcpp::SerializedMessage>
+RecyclingGenericSubscription::create_serialized_message()
+{
+  std::unique_ptr<rclcpp::SerializedMessage> message;
+  {
+    std::lock_guard<std::mutex> lock(pool_->mutex);
+    if (!pool_->free_messages.empty()) {
+      message = std::move(pool_->free_messages.back());
+      pool_->free_messages.pop_back();
+    }
+  }
+  if (message) {
+    // The buffer keeps its capacity, only its content is taken again
+    message->get_rcl_serialized_message().buffer_length = 0;
+  } else if (pool_->buffer_pool) {
+    // The middleware grows the buffer with the allocator of the message
+    message = std::make_unique<rclcpp::SerializedMessage>(
+      0, pool_->buffer_pool->get_allocator());
+  } else {
+    message = std::make_unique<rclcpp::SerializedMessage>(0);
+  }
+
+  return std::shared_ptr<rclcpp::SerializedMessage>(
+    message.release(),
+    [pool = pool_](rclcpp::SerializedMessage * released_message) {
+      std::unique_ptr<rclcpp::SerializedMessage> free_message(released_message);
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      if (pool->free_messages.size() < pool->max_free_messages) {
+        pool->free_messages.push_back(std::move(free_message));
+      }
+    });
+}
+
+void RecyclingGenericSubscription::return_serialized_message(
+  std::shared_ptr<rclcpp::SerializedMessage> & message)
+{
+  // The message goes back to the pool when the last reference, e.g. of the cache, is released
+  message.reset();
+}
+
+size_t RecyclingGenericSubscription::get_number_of_free_messages() const
+{
+  std::lock_guard<std::mutex> lock(pool_->mutex);
+  return pool_->free_messages.size();
+}
+
+}  // namespace rosbag2_transport
@@ -0,0 +1,103 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/reverse_block_reader.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace rosbag2_transport
+{
+
+namespace
+{
+constexpr rcutils_duration_value_t kMinBlockDuration = RCUTILS_MS_TO_NS(1);
+constexpr rcutils_duration_value_t kDefaultBlockDuration = RCUTILS_S_TO_NS(1);
+}  // namespace
+
+ReverseBlockReader::ReverseBlockReader(
+  rosbag2_cpp::Reader & reader,
+  const rosbag2_storage::StorageFilter & storage_filter,
+  rcutils_time_point_value_t start_time,
+  size_t block_messages)
+: reader_(reader),
+  storage_filter_(storage_filter),
+  start_time_(start_time),
+  block_messages_(std::max<size_t>(block_messages, 1)),
+  block_duration_(kDefaultBlockDuration),
+  block_end_(start_time)
+{
+  // Start with blocks of the average density of the bag
+  const auto & metadata = reader_.get_metadata();
+  if (metadata.message_count > 0 && metadata.duration.count() > 0) {
+    block_duration_ = std::max(
+      kMinBlockDuration, static_cast<rcutils_duration_value_t>(
+        static_cast<double>(metadata.duration.count()) * static_cast<double>(block_messages_) /
+        static_cast<double>(metadata.message_count)));
+  }
+}
+
+void ReverseBlockReader::seek(rcutils_time_point_value_t time_point)
+{
+  block_.clear();
+  block_end_ = time_point < start_time_ ? start_time_ : time_point + 1;
+}
+
+bool ReverseBlockReader::has_next()
+{
+  while (block_.empty() && block_end_ > start_time_) {
+    read_block();
+  }
+  return !block_.empty();
+}
+
+rosbag2_storage::SerializedBagMessageSharedPtr ReverseBlockReader::read_next()
+{
+  auto message = std::move(block_.back());
+  block_.pop_back();
+  return message;
+}
+
+void ReverseBlockReader::read_block()
+{
+  const rcutils_time_point_value_t block_start = block_end_ - start_time_ > block_duration_ ?
+    block_end_ - block_duration_ : start_time_;
+  auto storage_filter = storage_filter_;
+  storage_filter.start_time_ns = block_start;
+  storage_filter.end_time_ns = block_end_ - 1;
+  reader_.set_filter(storage_filter);
+  reader_.seek(block_start);
+  // Storage plugins may return messages out of the time range of the filter
+  while (reader_.has_next()) {
+    auto message = reader_.read_next();
+    if (message->time_stamp >= block_end_) {
+      break;
+    }
+    if (message->time_stamp >= block_start) {
+      block_.push_back(std::move(message));
+    }
+  }
+  block_end_ = block_start;
+
+  // Sparse parts of the bag are crossed in few reads, dense parts are not read ahead too far
+  if (block_.size() < block_messages_ / 2) {
+    block_duration_ =
+      std::min(block_duration_, std::numeric_limits<rcutils_duration_value_t>::max() / 2) * 2;
+  } else if (block_.size() > block_messages_ * 2) {
+    block_duration_ = std::max(kMinBlockDuration, block_duration_ / 2);
+  }
+}
+
+}  // namespace rosbag2_transport
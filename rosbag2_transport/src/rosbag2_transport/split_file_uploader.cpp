@@ -0,0 +1,304 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/split_file_uploader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "logging.hpp"
+
+#ifndef _WIN32
+extern char ** environ;
+#endif
+
+namespace rosbag2_transport
+{
+
+namespace
+{
+/// Give the calling thread, and the processes it starts, the lowest CPU and IO priority.
+void lower_thread_priority()
+{
+#ifdef __linux__
+  // ioprio_set(IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)) applies to the
+  // calling thread only. The idle class only gets disk time when no other process uses the disk.
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassIdle = 3;
+  constexpr int kIoprioClassShift = 13;
+  if (syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift) != 0) {
+    ROSBAG2_TRANSPORT_LOG_DEBUG("Failed to set the IO priority of the upload thread.");
+  }
+  // The nice value is per thread on Linux as well
+  if (setpriority(PRIO_PROCESS, 0, 19) != 0) {
+    ROSBAG2_TRANSPORT_LOG_DEBUG("Failed to set the CPU priority of the upload thread.");
+  }
+#endif
+}
+
+std::string quote(const std::string & argument)
+{
+#ifdef _WIN32
+  return "\"" + argument + "\"";
+#else
+  std::string quoted = "'";
+  for (char c : argument) {
+    if (c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+#endif
+}
+}  // namespace
+
+SplitFileUploader::SplitFileUploader(Options options, UploadFunction upload)
+: options_(std::move(options)), upload_(std::move(upload))
+{
+  if (!upload_) {
+    if (options_.command.empty()) {
+      throw std::invalid_argument("SplitFileUploader needs an upload command.");
+    }
+    upload_ = [this](const std::string & file, const std::string & key) {
+        return run_command(file, key);
+      };
+  }
+  if (!options_.journal_path.empty()) {
+    std::ifstream journal(options_.journal_path);
+    std::string file;
+    while (std::getline(journal, file)) {
+      if (!file.empty()) {
+        pending_.push_back(file);
+      }
+    }
+    if (!pending_.empty()) {
+      ROSBAG2_TRANSPORT_LOG_INFO_STREAM(
+        "Resuming the upload of " << pending_.size() << " files from " << options_.journal_path);
+    }
+  }
+  thread_ = std::thread(&SplitFileUploader::run, this);
+}
+
+SplitFileUploader::~SplitFileUploader()
+{
+  stop();
+}
+
+void SplitFileUploader::enqueue(const std::string & file)
+{
+  std::error_code error;
+  auto absolute_path = std::filesystem::absolute(file, error);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(error ? file : absolute_path.string());
+    write_journal();
+  }
+  condition_.notify_all();
+}
+
+bool SplitFileUploader::wait_for_uploads(std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  return condition_.wait_for(lock, timeout, [this]() {return pending_.empty();});
+}
+
+void SplitFileUploader::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+#ifndef _WIN32
+  const auto process = static_cast<pid_t>(running_process_.load());
+  if (process > 0) {
+    kill(-process, SIGTERM);
+  }
+#endif
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+size_t SplitFileUploader::pending_count() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.size();
+}
+
+std::string SplitFileUploader::make_key(const std::string & file)
+{
+  const std::filesystem::path path(file);
+  const auto bag_directory = path.parent_path().filename();
+  if (bag_directory.empty()) {
+    return path.filename().generic_string();
+  }
+  return (bag_directory / path.filename()).generic_string();
+}
+
+std::string SplitFileUploader::expand_command(
+  const std::string & command, const std::string & file, const std::string & key)
+{
+  std::string expanded;
+  size_t position = 0;
+  while (position < command.size()) {
+    if (command.compare(position, 6, "{file}") == 0) {
+      expanded += quote(file);
+      position += 6;
+    } else if (command.compare(position, 5, "{key}") == 0) {
+      expanded += quote(key);
+      position += 5;
+    } else {
+      expanded += command[position++];
+    }
+  }
+  return expanded;
+}
+
+void SplitFileUploader::run()
+{
+  lower_thread_priority();
+  auto retry_interval = options_.retry_interval;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [this]() {return stop_ || !pending_.empty();});
+    if (stop_) {
+      return;
+    }
+    const std::string file = pending_.front();
+    lock.unlock();
+
+    const auto start = std::chrono::steady_clock::now();
+    bool done = false;
+    uint64_t file_size = 0;
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(file, error)) {
+      ROSBAG2_TRANSPORT_LOG_ERROR_STREAM("Not uploading '" << file << "', it does not exist.");
+      done = true;
+    } else {
+      file_size = std::filesystem::file_size(file, error);
+      try {
+        done = upload_(file, make_key(file));
+      } catch (const std::exception & e) {
+        ROSBAG2_TRANSPORT_LOG_ERROR_STREAM("Failed to upload '" << file << "': " << e.what());
+      }
+    }
+
+    lock.lock();
+    if (done) {
+      pending_.pop_front();
+      write_journal();
+      retry_interval = options_.retry_interval;
+      condition_.notify_all();
+      if (options_.max_bandwidth > 0 && file_size > 0) {
+        const auto min_duration = std::chrono::duration<double>(
+          static_cast<double>(file_size) / static_cast<double>(options_.max_bandwidth));
+        condition_.wait_until(
+          lock, start + std::chrono::duration_cast<std::chrono::nanoseconds>(min_duration),
+          [this]() {return stop_;});
+      }
+    } else if (!stop_) {
+      ROSBAG2_TRANSPORT_LOG_WARN_STREAM(
+        "Failed to upload '" << file << "', retrying in " << retry_interval.count() << " ms.");
+      condition_.wait_for(lock, retry_interval, [this]() {return stop_;});
+      retry_interval = std::min(retry_interval * 2, options_.max_retry_interval);
+    }
+  }
+}
+
+bool SplitFileUploader::run_command(const std::string & file, const std::string & key)
+{
+  const std::string command = expand_command(options_.command, file, key);
+#ifdef _WIN32
+  return std::system(command.c_str()) == 0;
+#else
+  // The command runs in a process group of its own, so that stop() terminates the processes it
+  // started as well
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  std::string shell = "sh";
+  std::string shell_flag = "-c";
+  char * argv[] = {shell.data(), shell_flag.data(), const_cast<char *>(command.c_str()), nullptr};
+  pid_t process = 0;
+  const int result = posix_spawn(&process, "/bin/sh", nullptr, &attributes, argv, environ);
+  posix_spawnattr_destroy(&attributes);
+  if (result != 0) {
+    ROSBAG2_TRANSPORT_LOG_ERROR_STREAM(
+      "Failed to start upload command '" << command << "': error " << result);
+    return false;
+  }
+  running_process_ = process;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) {
+      kill(-process, SIGTERM);
+    }
+  }
+  int status = 0;
+  while (waitpid(process, &status, 0) < 0 && errno == EINTR) {
+  }
+  running_process_ = 0;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+void SplitFileUploader::write_journal()
+{
+  if (options_.journal_path.empty()) {
+    return;
+  }
+  // Replace the journal at once, so that it is never left half written
+  const std::string temporary_path = options_.journal_path + ".tmp";
+  {
+    std::ofstream journal(temporary_path, std::ios::trunc);
+    for (const auto & file : pending_) {
+      journal << file << "\n";
+    }
+    if (!journal) {
+      ROSBAG2_TRANSPORT_LOG_ERROR_STREAM(
+        "Failed to write upload journal '" << options_.journal_path << "'.");
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary_path, options_.journal_path, error);
+  if (error) {
+    ROSBAG2_TRANSPORT_LOG_ERROR_STREAM(
+      "Failed to write upload journal '" << options_.journal_path << "': " << error.message());
+  }
+}
+
+}  // namespace rosbag2_transport
@@ -0,0 +1,75 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rosbag2_transport/topic_decimator.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace rosbag2_transport
+{
+
+TopicDecimator::TopicDecimator(const TopicDecimation & decimation)
+: keep_every_n_(decimation.keep_every_n)
+{
+  if (decimation.keep_every_n == 0) {
+    throw std::invalid_argument("keep_every_n must be at least 1.");
+  }
+  if (!(decimation.max_frequency >= 0.0)) {
+    throw std::invalid_argument("max_frequency must not be negative.");
+  }
+  if (decimation.max_frequency > 0.0) {
+    min_period_ = static_cast<rcutils_duration_value_t>(
+      std::llround(RCUTILS_S_TO_NS(1.0) / decimation.max_frequency));
+  }
+}
+
+bool TopicDecimator::keep(rcutils_time_point_value_t time_stamp)
+{
+  if (received_count_++ % keep_every_n_ != 0) {
+    return false;
+  }
+  if (min_period_ > 0 && has_kept_ && time_stamp >= last_kept_time_stamp_ &&
+    time_stamp - last_kept_time_stamp_ < min_period_)
+  {
+    return false;
+  }
+  has_kept_ = true;
+  last_kept_time_stamp_ = time_stamp;
+  return true;
+}
+
+}  // namespace rosbag2_transport
+
+namespace YAML
+{
+
+Node convert<rosbag2_transport::TopicDecimation>::encode(
+  const rosbag2_transport::TopicDecimation & decimation)
+{
+  Node node;
+  node["keep_every_n"] = decimation.keep_every_n;
+  node["max_frequency"] = decimation.max_frequency;
+  return node;
+}
+
+bool convert<rosbag2_transport::TopicDecimation>::decode(
+  const Node & node, rosbag2_transport::TopicDecimation & decimation)
+{
+  optional_assign<uint64_t>(node, "keep_every_n", decimation.keep_every_n);
+  optional_assign<double>(node, "max_frequency", decimation.max_frequency);
+  return true;
+}
+
+}  // namespace YAML
@@ -96,6 +96,8 @@ TopicFilter::TopicFilter(
   bool allow_unknown_types)
 : record_options_(record_options),
   allow_unknown_types_(allow_unknown_types),
+  include_regex_(record_options_.regex, std::regex::optimize),
+  exclude_regex_(record_options_.exclude, std::regex::optimize),
   node_graph_(node_graph)
 {}
 
@@ -117,6 +119,10 @@ std::unordered_map<std::string, std::string> TopicFilter::filter_topics(
 bool TopicFilter::take_topic(
   const std::string & topic_name, const std::vector<std::string> & topic_types)
 {
+  if (!take_topic_name(topic_name)) {
+    return false;
+  }
+
   if (!record_options_.include_unpublished_topics && node_graph_ &&
     topic_is_unpublished(topic_name, *node_graph_))
   {
@@ -129,58 +135,65 @@ bool TopicFilter::take_topic(
     return false;
   }
 
-  if (!record_options_.topics.empty() && !topic_in_list(topic_name, record_options_.topics)) {
+  if (!has_single_type(topic_name, topic_types)) {
     return false;
   }
 
-  std::regex exclude_regex(record_options_.exclude);
-  if (!record_options_.exclude.empty() && std::regex_search(topic_name, exclude_regex)) {
+  const std::string & topic_type = topic_types[0];
+  if (!allow_unknown_types_ && !type_is_known(topic_name, topic_type)) {
     return false;
   }
 
-  std::regex include_regex(record_options_.regex);
-  if (
-    !record_options_.all &&  // All takes precedence over regex
-    !record_options_.regex.empty() &&  // empty regex matches nothing, but should be ignored
-    !std::regex_search(topic_name, include_regex))
-  {
-    return false;
-  }
+  return true;
+}
 
-  if (!has_single_type(topic_name, topic_types)) {
-    return false;
+bool TopicFilter::take_topic_name(const std::string & topic_name)
+{
+  auto decision = topic_name_decisions_.find(topic_name);
+  if (decision != topic_name_decisions_.end()) {
+    return decision->second;
   }
 
-  if (!record_options_.include_hidden_topics && topic_is_hidden(topic_name)) {
+  bool take = true;
+  if (!record_options_.topics.empty() && !topic_in_list(topic_name, record_options_.topics)) {
+    take = false;
+  } else if (!record_options_.exclude.empty() && std::regex_search(topic_name, exclude_regex_)) {
+    take = false;
+  } else if (
+    !record_options_.all &&  // All takes precedence over regex
+    !record_options_.regex.empty() &&  // empty regex matches nothing, but should be ignored
+    !std::regex_search(topic_name, include_regex_))
+  {
+    take = false;
+  } else if (!record_options_.include_hidden_topics && topic_is_hidden(topic_name)) {
     RCUTILS_LOG_WARN_ONCE_NAMED(
       ROSBAG2_TRANSPORT_PACKAGE_NAME,
       "Hidden topics are not recorded. Enable them with --include-hidden-topics");
-    return false;
-  }
-
-  const std::string & topic_type = topic_types[0];
-  if (!allow_unknown_types_ && !type_is_known(topic_name, topic_type)) {
-    return false;
+    take = false;
   }
-
-  return true;
+  topic_name_decisions_.emplace(topic_name, take);
+  return take;
 }
 
 bool TopicFilter::type_is_known(const std::string & topic_name, const std::string & topic_type)
 {
+  auto known_type = known_types_.find(topic_type);
+  if (known_type != known_types_.end()) {
+    return known_type->second;
+  }
   try {
     auto package_name = std::get<0>(rosbag2_cpp::extract_type_identifier(topic_type));
     rosbag2_cpp::get_typesupport_library_path(package_name, "rosidl_typesupport_cpp");
   } catch (std::runtime_error & e) {
-    if (already_warned_unknown_types_.find(topic_type) == already_warned_unknown_types_.end()) {
-      already_warned_unknown_types_.emplace(topic_type);
-      ROSBAG2_TRANSPORT_LOG_WARN_STREAM(
-        "Topic '" << topic_name <<
-          "' has unknown type '" << topic_type <<
-          "' . Only topics with known type are supported. Reason: '" << e.what());
-    }
+    // Warns once per type, as the decision is cached
+    ROSBAG2_TRANSPORT_LOG_WARN_STREAM(
+      "Topic '" << topic_name <<
+        "' has unknown type '" << topic_type <<
+        "' . Only topics with known type are supported. Reason: '" << e.what());
+    known_types_.emplace(topic_type, false);
     return false;
   }
+  known_types_.emplace(topic_type, true);
   return true;
 }
 }  // namespace rosbag2_transport
@@ -15,6 +15,7 @@
 #ifndef ROSBAG2_TRANSPORT__MOCK_SEQUENTIAL_READER_HPP_
 #define ROSBAG2_TRANSPORT__MOCK_SEQUENTIAL_READER_HPP_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -102,6 +103,7 @@ public:
   {
     seek_time_ = timestamp;
     num_read_ = 0;
+    ++num_seeks_;
   }
 
   void
@@ -123,6 +125,8 @@ public:
       const auto message_timestamp = std::chrono::time_point<std::chrono::high_resolution_clock>(
         std::chrono::nanoseconds(messages[0]->time_stamp));
       metadata_.starting_time = message_timestamp;
+      metadata_.duration = std::chrono::nanoseconds(
+        messages.back()->time_stamp - messages.front()->time_stamp);
     }
     messages_ = std::move(messages);
     topics_ = std::move(topics);
@@ -133,12 +137,18 @@ public:
     return max_messages_per_file_;
   }
 
+  size_t get_number_of_seeks() const
+  {
+    return num_seeks_;
+  }
+
 private:
   std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages_;
   rosbag2_storage::BagMetadata metadata_;
   std::vector<rosbag2_storage::TopicMetadata> topics_;
   size_t num_read_;
   rcutils_time_point_value_t seek_time_ = 0;
+  std::atomic<size_t> num_seeks_{0};
   rosbag2_storage::StorageFilter filter_;
   rosbag2_cpp::bag_events::EventCallbackManager callback_manager_;
   size_t file_number_ = 0;
@@ -60,6 +60,17 @@ public:
       std::launch::async, [node]() -> void {rclcpp::spin(node);});
   }
 
+  template<class T>
+  void start_async_multi_threaded_spin(T node, size_t number_of_threads)
+  {
+    future_ = std::async(
+      std::launch::async, [node, number_of_threads]() -> void {
+        rclcpp::executors::MultiThreadedExecutor exec(rclcpp::ExecutorOptions(), number_of_threads);
+        exec.add_node(node);
+        exec.spin();
+      });
+  }
+
   void stop_spinning()
   {
     rclcpp::shutdown();
@@ -0,0 +1,94 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+
+#include "arrow/api.h"
+#include "arrow/io/file.h"
+#include "parquet/arrow/reader.h"
+
+#include "rcpputils/filesystem_helper.hpp"
+#include "rosbag2_test_common/tested_storage_ids.hpp"
+#include "rosbag2_transport/bag_export.hpp"
+
+using namespace ::testing;  // NOLINT
+
+class TestBagExport : public Test, public WithParamInterface<std::string>
+{
+public:
+  TestBagExport()
+  : output_dir_(rcpputils::fs::create_temp_directory("test_bag_export"))
+  {
+    const auto bags_path = rcpputils::fs::path{_SRC_RESOURCES_DIR_PATH} / GetParam();
+    input_.uri = (bags_path / "rewriter_a").string();
+    input_.storage_id = GetParam();
+  }
+
+  ~TestBagExport()
+  {
+    rcpputils::fs::remove_all(output_dir_);
+  }
+
+  std::shared_ptr<arrow::Table> read_table(const std::string & file_name)
+  {
+    auto file = arrow::io::ReadableFile::Open((output_dir_ / file_name).string()).ValueOrDie();
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    EXPECT_TRUE(parquet::arrow::OpenFile(file, arrow::default_memory_pool(), &reader).ok());
+    std::shared_ptr<arrow::Table> table;
+    EXPECT_TRUE(reader->ReadTable(&table).ok());
+    num_row_groups_ = reader->num_row_groups();
+    return table;
+  }
+
+  const rcpputils::fs::path output_dir_;
+  rosbag2_storage::StorageOptions input_;
+  int num_row_groups_ = 0;
+};
+
+TEST_P(TestBagExport, exports_primitive_fields_of_selected_topics) {
+  rosbag2_transport::ExportOptions options;
+  options.output_directory = output_dir_.string();
+  options.topics = {"b_basictypes"};
+  options.row_group_size = 20;
+  rosbag2_transport::bag_export(input_, options);
+
+  EXPECT_FALSE((output_dir_ / "a_empty.parquet").exists());
+  const auto table = read_table("b_basictypes.parquet");
+  EXPECT_EQ(table->num_rows(), 50);
+  EXPECT_EQ(num_row_groups_, 3);
+  EXPECT_THAT(
+    table->schema()->field_names(), ElementsAre(
+      "timestamp", "bool_value", "byte_value", "char_value", "float32_value", "float64_value",
+      "int8_value", "uint8_value", "int16_value", "uint16_value", "int32_value", "uint32_value",
+      "int64_value", "uint64_value"));
+  EXPECT_EQ(table->schema()->field(5)->type()->id(), arrow::Type::DOUBLE);
+}
+
+TEST_P(TestBagExport, exports_all_topics_by_default) {
+  rosbag2_transport::ExportOptions options;
+  options.output_directory = output_dir_.string();
+  rosbag2_transport::bag_export(input_, options);
+
+  EXPECT_EQ(read_table("a_empty.parquet")->num_rows(), 100);
+  EXPECT_EQ(read_table("b_basictypes.parquet")->num_rows(), 50);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  ParametrizedBagExportTests,
+  TestBagExport,
+  ValuesIn(rosbag2_test_common::kTestedStorageIDs)
+);
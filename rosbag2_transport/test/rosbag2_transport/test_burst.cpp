@@ -22,6 +22,7 @@
 
 #include "mock_player.hpp"
 #include "rosbag2_play_test_fixture.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
 #include "test_msgs/message_fixtures.hpp"
 #include "test_msgs/msg/arrays.hpp"
 #include "test_msgs/msg/basic_types.hpp"
@@ -366,3 +367,66 @@ TEST_F(RosBag2PlayTestFixture, burst_bursting_only_filtered_topics) {
   // All we care is that any messages arrived
   EXPECT_THAT(replayed_topic2, SizeIs(Eq(EXPECTED_BURST_COUNT)));
 }
+
+TEST_F(RosBag2PlayTestFixture, burst_moves_the_clock_once_to_its_last_message) {
+  auto primitive_message = get_messages_basic_types()[0];
+  primitive_message->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""}};
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {
+    serialize_test_message("topic1", 1000, primitive_message),
+    serialize_test_message("topic1", 1100, primitive_message),
+    serialize_test_message("topic1", 1200, primitive_message),
+    serialize_test_message("topic1", 1300, primitive_message),
+    serialize_test_message("topic1", 1400, primitive_message)
+  };
+
+  // The clock is published before each message, which shows the clock during the bursts
+  play_options_.clock_publish_on_topic_publish = true;
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  sub_ = std::make_shared<SubscriptionManager>();
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", messages.size());
+  sub_->add_subscription<rosgraph_msgs::msg::Clock>(
+    "/clock", messages.size(), rclcpp::QoS(messages.size()).best_effort());
+
+  // Wait for discovery to match publishers with subscribers
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->pause();
+  ASSERT_TRUE(player->is_paused());
+
+  player->play();
+
+  ASSERT_EQ(player->burst(3), 3u);
+  ASSERT_EQ(player->burst(2), 2u);
+  ASSERT_TRUE(player->is_paused());
+  player->resume();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  // The first burst starts at the beginning of the bag and leaves the clock at its last message,
+  // where the second burst starts. Neither moves the clock while publishing.
+  auto received_clock = sub_->get_received_messages<rosgraph_msgs::msg::Clock>("/clock");
+  std::vector<rcutils_time_point_value_t> clock_times;
+  for (const auto & clock : received_clock) {
+    clock_times.push_back(rclcpp::Time(clock->clock).nanoseconds());
+  }
+  const auto before_first_burst = messages[0]->time_stamp;
+  const auto after_first_burst = messages[2]->time_stamp;
+  EXPECT_THAT(
+    clock_times,
+    ElementsAre(
+      before_first_burst, before_first_burst, before_first_burst,
+      after_first_burst, after_first_burst));
+}
@@ -156,6 +156,29 @@ TEST_P(ComposablePlayerTests, player_can_parse_parameters_from_file) {
   EXPECT_EQ(play_options.start_offset, 999999999);
   EXPECT_EQ(play_options.wait_acked_timeout, -999999999);
   EXPECT_EQ(play_options.disable_loan_message, false);
+  EXPECT_EQ(play_options.prefetch_queue_bytes, 1048576u);
+  EXPECT_EQ(play_options.read_ahead_queue_bytes, 268435456u);
+  EXPECT_EQ(play_options.publishing_threads, 4u);
+  EXPECT_EQ(play_options.precise_timing_spin_duration, 200000);
+  EXPECT_EQ(play_options.playback_thread_priority, 10);
+  std::vector<size_t> playback_thread_cpus {1, 3};
+  EXPECT_EQ(play_options.playback_thread_cpus, playback_thread_cpus);
+  EXPECT_EQ(play_options.playback_thread_policy, "rr");
+  EXPECT_EQ(play_options.storage_loading_thread_priority, 5);
+  EXPECT_EQ(play_options.storage_loading_thread_policy, "fifo");
+  std::vector<size_t> storage_loading_thread_cpus {2};
+  EXPECT_EQ(play_options.storage_loading_thread_cpus, storage_loading_thread_cpus);
+  EXPECT_EQ(play_options.release_window, 1000000);
+  EXPECT_EQ(play_options.as_fast_as_possible, true);
+  EXPECT_EQ(play_options.seek_history_duration, 5000000000);
+  EXPECT_EQ(play_options.publisher_creation_threads, 8u);
+  EXPECT_EQ(play_options.loop_cache_bytes, 1073741824u);
+  EXPECT_TRUE(play_options.preload);
+  EXPECT_EQ(play_options.preload_max_bytes, 2147483648u);
+  EXPECT_EQ(play_options.step_clock_topic, "/sim/step");
+  EXPECT_TRUE(play_options.intra_process_playback);
+  EXPECT_TRUE(play_options.clock_publish_thread);
+  EXPECT_EQ(play_options.clock_publish_thread_priority, 20);
 
   EXPECT_EQ(storage_options.uri, uri_str);
   EXPECT_EQ(storage_options.storage_id, GetParam());
@@ -165,6 +188,7 @@ TEST_P(ComposablePlayerTests, player_can_parse_parameters_from_file) {
   EXPECT_EQ(storage_options.max_cache_size, 9898);
   EXPECT_EQ(storage_options.storage_preset_profile, "resilient");
   EXPECT_EQ(storage_options.snapshot_mode, false);
+  EXPECT_EQ(storage_options.read_buffer_pool_size, 16777216u);
   std::unordered_map<std::string, std::string> custom_data{
     std::pair{"key1", "value1"},
     std::pair{"key2", "value2"}
@@ -231,6 +231,16 @@ TEST_P(ComposableRecorderTests, recorder_can_parse_parameters_from_file) {
   EXPECT_EQ(record_options.include_unpublished_topics, true);
   EXPECT_EQ(record_options.ignore_leaf_topics, false);
   EXPECT_EQ(record_options.start_paused, false);
+  EXPECT_EQ(record_options.record_publish_info, true);
+  EXPECT_EQ(record_options.use_receive_timestamp, true);
+  EXPECT_EQ(record_options.intra_process_capture, true);
+  EXPECT_EQ(record_options.message_buffer_pool_size, 16);
+  EXPECT_EQ(record_options.message_buffer_arena_size, 4194304u);
+  EXPECT_EQ(record_options.message_buffer_numa_node, 0);
+  EXPECT_EQ(record_options.executor_threads, 4);
+  EXPECT_EQ(record_options.callback_groups, "topic");
+  EXPECT_EQ(record_options.topics_per_callback_group, 8);
+  EXPECT_EQ(record_options.subscription_creation_threads, 4);
   EXPECT_EQ(record_options.use_sim_time, false);
 
   EXPECT_EQ(storage_options.uri, root_bag_path_.generic_string());
@@ -241,6 +251,59 @@ TEST_P(ComposableRecorderTests, recorder_can_parse_parameters_from_file) {
   EXPECT_EQ(storage_options.max_cache_size, 989888);
   EXPECT_EQ(storage_options.storage_preset_profile, "none");
   EXPECT_EQ(storage_options.snapshot_mode, false);
+  EXPECT_EQ(storage_options.snapshot_duration_ms, 30000u);
+  EXPECT_EQ(storage_options.snapshot_post_trigger_duration_ms, 5000u);
+  EXPECT_EQ(storage_options.snapshot_contiguous_buffer, true);
+  EXPECT_EQ(storage_options.lock_free_cache, true);
+  EXPECT_EQ(storage_options.shard_cache_per_topic, true);
+  std::unordered_map<std::string, std::vector<std::string>> cache_topic_groups{
+    {"low_rate", {"/tf", "/diagnostics"}}
+  };
+  EXPECT_EQ(storage_options.cache_topic_groups, cache_topic_groups);
+  std::unordered_map<std::string, uint64_t> cache_shard_sizes{
+    {"low_rate", 1048576},
+    {"/points", 419430400}
+  };
+  EXPECT_EQ(storage_options.cache_shard_sizes, cache_shard_sizes);
+  std::unordered_map<std::string, std::string> cache_shard_policies{
+    {"low_rate", "block"},
+    {"/points", "drop_oldest"}
+  };
+  EXPECT_EQ(storage_options.cache_shard_policies, cache_shard_policies);
+  std::unordered_map<std::string, uint32_t> cache_topic_priorities{
+    {"/cmd_vel", 10},
+    {"/points", 1}
+  };
+  EXPECT_EQ(storage_options.cache_topic_priorities, cache_topic_priorities);
+  EXPECT_EQ(storage_options.cache_overflow_policy, "block");
+  EXPECT_EQ(storage_options.cache_block_timeout_ms, 250u);
+  EXPECT_EQ(storage_options.cache_spill_directory, "/mnt/scratch");
+  EXPECT_EQ(storage_options.cache_spill_size, 2147483648u);
+  EXPECT_EQ(storage_options.cache_min_batch_size, 65536u);
+  EXPECT_EQ(storage_options.cache_max_batch_size, 8388608u);
+  EXPECT_EQ(storage_options.cache_max_batch_latency_ms, 50u);
+  EXPECT_TRUE(storage_options.cache_adaptive_batching);
+  EXPECT_TRUE(storage_options.async_split);
+  EXPECT_EQ(storage_options.max_bag_retention_size, 10737418240u);
+  EXPECT_EQ(storage_options.max_bag_retention_duration, 3600u);
+  EXPECT_TRUE(storage_options.preallocate_bagfiles);
+  EXPECT_EQ(storage_options.durability_interval_ms, 200u);
+  EXPECT_EQ(storage_options.durability_bytes, 16777216u);
+  EXPECT_EQ(storage_options.message_definition_cache_directory, "/var/cache/rosbag2");
+  EXPECT_EQ(storage_options.message_definition_threads, 4u);
+  EXPECT_EQ(storage_options.cache_consumer_thread_policy, "rr");
+  EXPECT_EQ(storage_options.cache_consumer_thread_priority, 20);
+  std::vector<uint64_t> cache_consumer_thread_cpus {2, 3};
+  EXPECT_EQ(storage_options.cache_consumer_thread_cpus, cache_consumer_thread_cpus);
+  EXPECT_EQ(storage_options.deduplication_min_payload_size, 65536u);
+  EXPECT_EQ(storage_options.deduplication_cache_size, 134217728u);
+  std::vector<std::string> delta_encoded_topics {"/map"};
+  EXPECT_EQ(storage_options.delta_encoded_topics, delta_encoded_topics);
+  EXPECT_EQ(storage_options.delta_keyframe_interval, 20u);
+  EXPECT_EQ(storage_options.preview_bucket_duration_ms, 1000u);
+  std::vector<std::string> preview_sample_topics {"/camera/image_raw"};
+  EXPECT_EQ(storage_options.preview_sample_topics, preview_sample_topics);
+  EXPECT_EQ(storage_options.preview_sample_interval, 30u);
   std::unordered_map<std::string, std::string> custom_data{
     std::pair{"key1", "value1"},
     std::pair{"key2", "value2"}
@@ -17,6 +17,7 @@
 #include <chrono>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -24,8 +25,11 @@
 
 #include "rclcpp/rclcpp.hpp"
 
+#include "rosbag2_interfaces/msg/play_statistics.hpp"
+
 #include "rosbag2_test_common/subscription_manager.hpp"
 
+#include "rosbag2_transport/intra_process_playback.hpp"
 #include "rosbag2_transport/player.hpp"
 
 #include "test_msgs/msg/arrays.hpp"
@@ -108,6 +112,465 @@ TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_for_all_topics)
           ElementsAre(40.0f, 2.0f, 0.0f)))));
 }
 
+TEST_F(RosBag2PlayTestFixture, messages_are_published_without_taking_their_serialized_data)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int32_t i = 0; i < 3; ++i) {
+    auto primitive_message = get_messages_basic_types()[0];
+    primitive_message->int32_value = i;
+    messages.push_back(serialize_test_message("topic1", 500 + 100 * i, primitive_message));
+  }
+  // The player publishes views of these buffers, which must neither free nor change them
+  std::vector<rcutils_uint8_array_t> serialized_data_before_playback;
+  std::vector<std::vector<uint8_t>> payloads_before_playback;
+  for (const auto & message : messages) {
+    serialized_data_before_playback.push_back(*message->serialized_data);
+    payloads_before_playback.emplace_back(
+      message->serialized_data->buffer,
+      message->serialized_data->buffer + message->serialized_data->buffer_length);
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 3);
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+  player.reset();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/topic1");
+  ASSERT_THAT(replayed_test_primitives, SizeIs(3u));
+  for (int32_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(replayed_test_primitives[i]->int32_value, i);
+  }
+  for (size_t i = 0; i < messages.size(); ++i) {
+    const auto & serialized_data = *messages[i]->serialized_data;
+    EXPECT_EQ(serialized_data.buffer, serialized_data_before_playback[i].buffer);
+    EXPECT_EQ(serialized_data.buffer_length, serialized_data_before_playback[i].buffer_length);
+    EXPECT_EQ(
+      serialized_data.buffer_capacity, serialized_data_before_playback[i].buffer_capacity);
+    EXPECT_THAT(
+      std::vector<uint8_t>(
+        serialized_data.buffer, serialized_data.buffer + serialized_data.buffer_length),
+      ElementsAreArray(payloads_before_playback[i]));
+  }
+}
+
+TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_with_read_ahead_queue_bounded_by_bytes)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic1", 700, primitive_message1),
+    serialize_test_message("topic1", 900, primitive_message1)};
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 2);
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  // Messages larger than the byte budget are queued one by one
+  play_options_.read_ahead_queue_bytes = 1;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/topic1");
+  EXPECT_THAT(replayed_test_primitives, SizeIs(Ge(2u)));
+  EXPECT_THAT(
+    replayed_test_primitives,
+    Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 42))));
+}
+
+TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_with_release_window)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic1", 501, primitive_message1),
+    serialize_test_message("topic1", 900, primitive_message1)};
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 3);
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  play_options_.release_window = RCUTILS_MS_TO_NS(10);
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/topic1");
+  EXPECT_THAT(replayed_test_primitives, SizeIs(Ge(3u)));
+  EXPECT_THAT(
+    replayed_test_primitives,
+    Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 42))));
+}
+
+TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_backwards_with_negative_rate)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int32_t value = 1; value <= 3; ++value) {
+    auto primitive_message = get_messages_basic_types()[0];
+    primitive_message->int32_value = value;
+    messages.push_back(serialize_test_message("topic1", 400 + 100 * value, primitive_message));
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 3);
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  play_options_.rate = -1.0;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/topic1");
+  EXPECT_THAT(
+    replayed_test_primitives,
+    ElementsAre(
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 3)),
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 2)),
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 1))));
+}
+
+TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_with_topic_decimation)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic2", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int32_t value = 1; value <= 6; ++value) {
+    auto primitive_message = get_messages_basic_types()[0];
+    primitive_message->int32_value = value;
+    messages.push_back(serialize_test_message("topic1", 100 * value, primitive_message));
+    messages.push_back(serialize_test_message("topic2", 100 * value, primitive_message));
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 3);
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic2", 6);
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  play_options_.topic_decimation["topic1"].keep_every_n = 2;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  EXPECT_THAT(
+    sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic1"),
+    ElementsAre(
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 1)),
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 3)),
+      Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 5))));
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic2"), SizeIs(6u));
+}
+
+TEST_F(RosBag2PlayTestFixture, messages_are_handed_to_playback_subscriptions_in_the_process)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int32_t value = 1; value <= 3; ++value) {
+    auto primitive_message = get_messages_basic_types()[0];
+    primitive_message->int32_value = value;
+    messages.push_back(serialize_test_message("topic1", 100 * value, primitive_message));
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  // Messages of the player are handed over on its thread, the node does not need to be spun
+  std::mutex received_mutex;
+  std::vector<std::shared_ptr<const test_msgs::msg::BasicTypes>> received_first;
+  std::vector<std::shared_ptr<const test_msgs::msg::BasicTypes>> received_second;
+  auto subscriber_node = std::make_shared<rclcpp::Node>("playback_subscriber_node");
+  PlaybackSubscription<test_msgs::msg::BasicTypes> first_subscription(
+    *subscriber_node, "/topic1", rclcpp::QoS(10),
+    [&](std::shared_ptr<const test_msgs::msg::BasicTypes> message) {
+      std::lock_guard<std::mutex> lock(received_mutex);
+      received_first.push_back(message);
+    });
+  PlaybackSubscription<test_msgs::msg::BasicTypes> second_subscription(
+    *subscriber_node, "/topic1", rclcpp::QoS(10),
+    [&](std::shared_ptr<const test_msgs::msg::BasicTypes> message) {
+      std::lock_guard<std::mutex> lock(received_mutex);
+      received_second.push_back(message);
+    });
+
+  play_options_.intra_process_playback = true;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  player->wait_for_playback_to_finish();
+
+  std::lock_guard<std::mutex> lock(received_mutex);
+  ASSERT_THAT(received_first, SizeIs(3u));
+  EXPECT_EQ(received_first[0]->int32_value, 1);
+  EXPECT_EQ(received_first[2]->int32_value, 3);
+  // Deserialized once for both subscriptions
+  EXPECT_EQ(received_first, received_second);
+}
+
+TEST_F(RosBag2PlayTestFixture, playback_statistics_are_published)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic1", 600, primitive_message1),
+    serialize_test_message("topic1", 700, primitive_message1)};
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  play_options_.statistics_publish_interval = RCUTILS_S_TO_NS(10);
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  // The statistics are published once more when playback finishes
+  sub_->add_subscription<rosbag2_interfaces::msg::PlayStatistics>(
+    "/rosbag2_player/play_statistics", 1);
+  ASSERT_TRUE(sub_->spin_and_wait_for_matched({"/rosbag2_player/play_statistics"}));
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->play();
+  ASSERT_TRUE(player->wait_for_playback_to_finish(std::chrono::seconds(30)));
+  await_received_messages.get();
+
+  auto statistics = sub_->get_received_messages<rosbag2_interfaces::msg::PlayStatistics>(
+    "/rosbag2_player/play_statistics");
+  ASSERT_THAT(statistics, SizeIs(Ge(1u)));
+  const auto & last = *statistics.back();
+  EXPECT_EQ(last.publish_lateness.count + last.publish_earliness.count, messages.size());
+  EXPECT_EQ(last.read_latency.count, messages.size());
+  ASSERT_THAT(last.topic_publish_durations, SizeIs(1u));
+  EXPECT_EQ(last.topic_publish_durations[0].stage, "/topic1");
+  EXPECT_EQ(last.topic_publish_durations[0].count, messages.size());
+}
+
+TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_as_fast_as_possible)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  // Played in real time, the messages would span an hour
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic1", 1800000, primitive_message1),
+    serialize_test_message("topic1", 3600000, primitive_message1)};
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  play_options_.as_fast_as_possible = true;
+  play_options_.wait_acked_timeout = 0;
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", messages.size());
+  // Wait for discovery to match publishers with subscribers
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->play();
+  ASSERT_TRUE(player->wait_for_playback_to_finish(std::chrono::seconds(30)));
+  await_received_messages.get();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/topic1");
+  EXPECT_THAT(replayed_test_primitives, SizeIs(messages.size()));
+  EXPECT_THAT(
+    replayed_test_primitives,
+    Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, 42))));
+}
+
+TEST_F(RosBag2PlayTestFixture, playback_waits_for_acknowledgements_of_all_topics_at_once)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic3", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages =
+  {serialize_test_message("topic1", 500, primitive_message1),
+    serialize_test_message("topic3", 600, primitive_message1),
+    serialize_test_message("topic1", 700, primitive_message1),
+    serialize_test_message("topic3", 800, primitive_message1)};
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  play_options_.as_fast_as_possible = true;
+  play_options_.publishing_threads = 2;
+  play_options_.wait_acked_timeout = 5000;
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 2);
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic3", 2);
+  // Wait for discovery to match publishers with subscribers
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->play();
+  ASSERT_TRUE(player->wait_for_playback_to_finish(std::chrono::seconds(30)));
+  await_received_messages.get();
+
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic1"), SizeIs(2u));
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic3"), SizeIs(2u));
+}
+
+TEST_F(RosBag2PlayTestFixture, topics_with_publish_policies_publish_all_messages_in_time)
+{
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = 42;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic2", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic3", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int64_t i = 0; i < 3; i++) {
+    for (const auto & topic : topic_types) {
+      messages.push_back(serialize_test_message(topic.name, 500 + i * 100, primitive_message1));
+    }
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  const int64_t deadline = RCUTILS_S_TO_NS(5);
+  play_options_.topic_publish_policies["topic1"] = {deadline, "block"};
+  play_options_.topic_publish_policies["topic2"] = {deadline, "skip"};
+  play_options_.topic_publish_policies["topic3"] = {deadline, "detach"};
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 3);
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic2", 3);
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic3", 3);
+  // Wait for discovery to match publishers with subscribers
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->play();
+  ASSERT_TRUE(player->wait_for_playback_to_finish(std::chrono::seconds(30)));
+  await_received_messages.get();
+
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic1"), SizeIs(3u));
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic2"), SizeIs(3u));
+  EXPECT_THAT(sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic3"), SizeIs(3u));
+}
+
+TEST_F(RosBag2PlayTestFixture, player_rejects_unknown_publish_overflow_policies)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+  };
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare({}, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  play_options_.topic_publish_policies["topic1"] = {RCUTILS_MS_TO_NS(10), "drop"};
+  EXPECT_THROW(
+    std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_),
+    std::runtime_error);
+}
+
+TEST_F(RosBag2PlayTestFixture, publishers_are_created_on_threads_for_topics_with_known_type)
+{
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic2", "test_msgs/Arrays", "", {}, ""},
+    {"topic3", "unknown_msgs/UnknownType", "", {}, ""},
+    {"topic4", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare({}, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  play_options_.publisher_creation_threads = 3;
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  std::vector<std::string> topic_names;
+  for (const auto * publisher : player->get_list_of_publishers()) {
+    topic_names.push_back(publisher->get_topic_name());
+  }
+  EXPECT_THAT(topic_names, UnorderedElementsAre("/topic1", "/topic2", "/topic4"));
+}
+
 TEST_F(RosBag2PlayTestFixture, recorded_messages_are_played_for_all_topics_with_unknown_type)
 {
   auto primitive_message1 = get_messages_basic_types()[0];
@@ -14,9 +14,12 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include <utility>
 
@@ -156,3 +159,56 @@ TEST_F(Rosbag2PlayCallbacksTestFixture, call_callbacks) {
   player.wait_for_playback_to_finish();
   EXPECT_FALSE(player.play_next());
 }
+
+TEST_F(Rosbag2PlayCallbacksTestFixture, delete_callback_waits_for_its_call_in_progress) {
+  MockPlayer player(move(reader_), storage_options_, play_options_);
+
+  std::atomic_size_t num_calls{0};
+  std::atomic_bool deleted{false};
+  std::atomic_bool called_after_deletion{false};
+  std::promise<void> first_call_started;
+  auto pre_callback_handle = player.add_on_play_message_pre_callback(
+    [&](std::shared_ptr<rosbag2_storage::SerializedBagMessage>) {
+      if (deleted) {
+        called_after_deletion = true;
+      }
+      if (num_calls++ == 0) {
+        first_call_started.set_value();
+        // Still running while the callback is deleted
+        std::this_thread::sleep_for(50ms);
+      }
+      if (deleted) {
+        called_after_deletion = true;
+      }
+    });
+  ASSERT_NE(pre_callback_handle, Player::invalid_callback_handle);
+
+  player.play();
+  first_call_started.get_future().wait();
+  player.delete_on_play_message_callback(pre_callback_handle);
+  deleted = true;
+  EXPECT_EQ(num_calls, 1u);
+
+  player.wait_for_playback_to_finish();
+  EXPECT_FALSE(called_after_deletion);
+  EXPECT_EQ(num_calls, 1u);
+  EXPECT_EQ(player.get_number_of_registered_pre_callbacks(), 0U);
+}
+
+TEST_F(Rosbag2PlayCallbacksTestFixture, callback_can_delete_itself) {
+  MockPlayer player(move(reader_), storage_options_, play_options_);
+
+  size_t num_calls = 0;
+  Player::callback_handle_t post_callback_handle = Player::invalid_callback_handle;
+  post_callback_handle = player.add_on_play_message_post_callback(
+    [&](std::shared_ptr<rosbag2_storage::SerializedBagMessage>) {
+      num_calls++;
+      player.delete_on_play_message_callback(post_callback_handle);
+    });
+  ASSERT_NE(post_callback_handle, Player::invalid_callback_handle);
+
+  player.play();
+  ASSERT_TRUE(player.wait_for_playback_to_finish(30s));
+  EXPECT_EQ(num_calls, 1u);
+  EXPECT_EQ(player.get_number_of_registered_post_callbacks(), 0U);
+}
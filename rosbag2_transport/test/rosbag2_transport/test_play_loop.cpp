@@ -150,3 +150,106 @@ TEST_F(RosBag2PlayTestFixture, messages_played_in_loop) {
     replayed_test_primitives,
     Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, test_value))));
 }
+
+TEST_F(RosBag2PlayTestFixture, messages_played_in_loop_from_loop_cache) {
+  const int test_value = 42;
+  const size_t num_messages = 3;
+  const size_t expected_number_of_messages = num_messages * 3;
+
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = test_value;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"loop_test_topic", "test_msgs/BasicTypes", "", {}, ""}
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int64_t i = 0; i < static_cast<int64_t>(num_messages); ++i) {
+    messages.push_back(
+      serialize_test_message("loop_test_topic", 700 + 10 * i, primitive_message1));
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto mock_reader = prepared_mock_reader.get();
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>(
+    "/loop_test_topic",
+    expected_number_of_messages);
+
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  play_options_.loop = true;
+  play_options_.delay = rclcpp::Duration(1, 0);
+  play_options_.loop_cache_bytes = 1024 * 1024;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  player->play();
+  await_received_messages.get();
+
+  // Only the first pass through the bag seeked the storage
+  EXPECT_EQ(mock_reader->get_number_of_seeks(), 1u);
+  rclcpp::shutdown();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/loop_test_topic");
+
+  EXPECT_THAT(replayed_test_primitives.size(), Ge(expected_number_of_messages));
+  EXPECT_THAT(
+    replayed_test_primitives,
+    Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, test_value))));
+}
+
+TEST_F(RosBag2PlayTestFixture, messages_played_in_loop_from_preloaded_bag) {
+  const int test_value = 42;
+  const size_t num_messages = 3;
+  const size_t expected_number_of_messages = num_messages * 3;
+
+  auto primitive_message1 = get_messages_basic_types()[0];
+  primitive_message1->int32_value = test_value;
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"loop_test_topic", "test_msgs/BasicTypes", "", {}, ""}
+  };
+
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  for (int64_t i = 0; i < static_cast<int64_t>(num_messages); ++i) {
+    messages.push_back(
+      serialize_test_message("loop_test_topic", 700 + 10 * i, primitive_message1));
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto mock_reader = prepared_mock_reader.get();
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>(
+    "/loop_test_topic",
+    expected_number_of_messages);
+
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  play_options_.loop = true;
+  play_options_.delay = rclcpp::Duration(1, 0);
+  play_options_.preload = true;
+  play_options_.preload_max_bytes = 1024 * 1024;
+  auto player = std::make_shared<rosbag2_transport::Player>(
+    std::move(reader), storage_options_, play_options_);
+  // The whole bag was read when the player was created
+  EXPECT_EQ(mock_reader->get_number_of_seeks(), 1u);
+  EXPECT_FALSE(mock_reader->has_next());
+  player->play();
+  await_received_messages.get();
+
+  EXPECT_EQ(mock_reader->get_number_of_seeks(), 1u);
+  rclcpp::shutdown();
+
+  auto replayed_test_primitives = sub_->get_received_messages<test_msgs::msg::BasicTypes>(
+    "/loop_test_topic");
+
+  EXPECT_THAT(replayed_test_primitives.size(), Ge(expected_number_of_messages));
+  EXPECT_THAT(
+    replayed_test_primitives,
+    Each(Pointee(Field(&test_msgs::msg::BasicTypes::int32_value, test_value))));
+}
@@ -131,8 +131,82 @@ TEST_F(ClockPublishFixture, clock_respects_playback_rate)
   run_test();
 }
 
+TEST_F(ClockPublishFixture, clock_is_published_at_chosen_frequency_on_clock_thread)
+{
+  play_options_.clock_publish_frequency = 20;
+  play_options_.clock_publish_thread = true;
+  run_test();
+}
+
 TEST_F(ClockPublishFixture, clock_is_published_from_topic_trigger)
 {
   play_options_.clock_publish_on_topic_publish = true;
   run_test();
 }
+
+TEST_F(ClockPublishFixture, clock_is_published_only_from_chosen_trigger_topics)
+{
+  play_options_.clock_publish_on_topic_publish = true;
+  play_options_.clock_trigger_topics = {"topic2"};
+
+  auto topic_types = std::vector<rosbag2_storage::TopicMetadata>{
+    {"topic1", "test_msgs/BasicTypes", "", {}, ""},
+    {"topic2", "test_msgs/BasicTypes", "", {}, ""},
+  };
+
+  // Messages every 100 ms, alternating between topic1 and topic2 and ending on topic1
+  const int64_t milliseconds_between_messages = 100;
+  std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+  std::vector<int64_t> trigger_timestamps;
+  for (int32_t i = 0; i < 9; i++) {
+    auto message = get_messages_basic_types()[0];
+    message->int32_value = i;
+    const bool is_trigger = i % 2 == 1;
+    messages.push_back(
+      serialize_test_message(
+        is_trigger ? "topic2" : "topic1", milliseconds_between_messages * i, message));
+    if (is_trigger) {
+      trigger_timestamps.push_back(messages.back()->time_stamp);
+    }
+  }
+
+  auto prepared_mock_reader = std::make_unique<MockSequentialReader>();
+  prepared_mock_reader->prepare(messages, topic_types);
+  auto reader = std::make_unique<rosbag2_cpp::Reader>(std::move(prepared_mock_reader));
+
+  auto player = std::make_shared<MockPlayer>(std::move(reader), storage_options_, play_options_);
+
+  rclcpp::executors::SingleThreadedExecutor exec;
+  exec.add_node(player);
+  auto spin_thread = std::thread(
+    [&exec]() {
+      exec.spin();
+    });
+
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", 5);
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic2", trigger_timestamps.size());
+  sub_->add_subscription<rosgraph_msgs::msg::Clock>(
+    "/clock", trigger_timestamps.size(), rclcpp::ClockQoS());
+
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->play();
+  player->wait_for_playback_to_finish();
+
+  await_received_messages.get();
+  exec.cancel();
+  spin_thread.join();
+
+  // One clock update per message on topic2, showing the time that message was played at
+  auto received_clock = sub_->get_received_messages<rosgraph_msgs::msg::Clock>("/clock");
+  ASSERT_THAT(received_clock, SizeIs(trigger_timestamps.size()));
+  for (size_t i = 0; i < trigger_timestamps.size(); i++) {
+    const auto clock_time = rclcpp::Time(received_clock[i]->clock).nanoseconds();
+    EXPECT_GE(clock_time, trigger_timestamps[i]) << "Clock update " << i;
+    EXPECT_LT(clock_time, trigger_timestamps[i] + RCUTILS_MS_TO_NS(milliseconds_between_messages))
+      << "Clock update " << i;
+  }
+}
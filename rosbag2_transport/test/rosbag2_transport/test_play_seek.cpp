@@ -264,6 +264,53 @@ TEST_P(RosBag2PlaySeekTestFixture, seek_back_in_time_from_the_end_of_the_bag) {
   }
 }
 
+TEST_P(RosBag2PlaySeekTestFixture, seek_back_in_time_within_seek_history) {
+  const size_t expected_number_of_messages = num_msgs_in_bag_ + num_msgs_in_bag_ - 2;
+  play_options_.seek_history_duration = RCUTILS_S_TO_NS(10);
+  auto player = std::make_shared<MockPlayer>(std::move(reader_), storage_options_, play_options_);
+
+  sub_ = std::make_shared<SubscriptionManager>();
+  sub_->add_subscription<test_msgs::msg::BasicTypes>("/topic1", expected_number_of_messages);
+
+  // Wait for discovery to match publishers with subscribers
+  ASSERT_TRUE(
+    sub_->spin_and_wait_for_matched(player->get_list_of_publishers(), std::chrono::seconds(30)));
+
+  auto await_received_messages = sub_->spin_subscriptions();
+
+  player->pause();
+  ASSERT_TRUE(player->is_paused());
+
+  player->play();
+
+  EXPECT_TRUE(player->is_paused());
+  // Play all messages from bag, keeping them in the seek history
+  for (size_t i = 0; i < num_msgs_in_bag_; i++) {
+    EXPECT_TRUE(player->play_next());
+  }
+  EXPECT_FALSE(player->play_next());  // Make sure there are no messages to play
+
+  // Jump on third message (1200 ms), which is played again from memory
+  player->seek((start_time_ms_ + message_spacing_ms_ * 2) * 1000000);
+  EXPECT_TRUE(player->play_next());
+  player->resume();
+  player->wait_for_playback_to_finish();
+  await_received_messages.get();
+
+  auto replayed_topic1 = sub_->get_received_messages<test_msgs::msg::BasicTypes>("/topic1");
+  EXPECT_THAT(replayed_topic1, SizeIs(expected_number_of_messages));
+
+  for (size_t i = 0; i < num_msgs_in_bag_; i++) {
+    EXPECT_EQ(replayed_topic1[i]->int32_value, static_cast<int32_t>(i + 1)) << "i=" << i;
+  }
+
+  for (size_t i = 0; i < (replayed_topic1.size() - num_msgs_in_bag_); i++) {
+    EXPECT_EQ(
+      replayed_topic1[i + num_msgs_in_bag_]->int32_value,
+      static_cast<int32_t>(i + 3)) << "i=" << i;
+  }
+}
+
 TEST_P(RosBag2PlaySeekTestFixture, seek_forward_from_the_end_of_the_bag) {
   const size_t expected_number_of_messages = num_msgs_in_bag_;
   auto player = std::make_shared<MockPlayer>(std::move(reader_), storage_options_, play_options_);
@@ -20,6 +20,7 @@
 #include <utility>
 #include <condition_variable>
 #include <mutex>
+#include <future>
 
 #include "rclcpp/client.hpp"
 #include "rclcpp/executors/single_threaded_executor.hpp"
@@ -30,6 +31,7 @@
 #include "rosbag2_interfaces/srv/is_paused.hpp"
 #include "rosbag2_interfaces/srv/pause.hpp"
 #include "rosbag2_interfaces/srv/resume.hpp"
+#include "rosbag2_interfaces/srv/seek.hpp"
 #include "rosbag2_interfaces/srv/stop.hpp"
 #include "rosbag2_interfaces/srv/toggle_paused.hpp"
 #include "rosbag2_transport/player.hpp"
@@ -56,6 +58,7 @@ public:
   using GetRate = rosbag2_interfaces::srv::GetRate;
   using SetRate = rosbag2_interfaces::srv::SetRate;
   using PlayNext = rosbag2_interfaces::srv::PlayNext;
+  using Seek = rosbag2_interfaces::srv::Seek;
   using Stop = rosbag2_interfaces::srv::Stop;
 
   PlaySrvsTest()
@@ -83,6 +86,7 @@ public:
     cli_get_rate_ = client_node_->create_client<GetRate>(ns + "/get_rate");
     cli_set_rate_ = client_node_->create_client<SetRate>(ns + "/set_rate");
     cli_play_next_ = client_node_->create_client<PlayNext>(ns + "/play_next");
+    cli_seek_ = client_node_->create_client<Seek>(ns + "/seek");
     cli_stop_ = client_node_->create_client<Stop>(ns + "/stop");
     topic_sub_ = client_node_->create_subscription<test_msgs::msg::BasicTypes>(
       test_topic_, 10,
@@ -103,6 +107,7 @@ public:
     ASSERT_TRUE(cli_get_rate_->wait_for_service(service_wait_timeout_));
     ASSERT_TRUE(cli_set_rate_->wait_for_service(service_wait_timeout_));
     ASSERT_TRUE(cli_play_next_->wait_for_service(service_wait_timeout_));
+    ASSERT_TRUE(cli_seek_->wait_for_service(service_wait_timeout_));
     ASSERT_TRUE(cli_stop_->wait_for_service(service_wait_timeout_));
   }
 
@@ -262,6 +267,7 @@ public:
   rclcpp::Client<GetRate>::SharedPtr cli_get_rate_;
   rclcpp::Client<SetRate>::SharedPtr cli_set_rate_;
   rclcpp::Client<PlayNext>::SharedPtr cli_play_next_;
+  rclcpp::Client<Seek>::SharedPtr cli_seek_;
   rclcpp::Client<Stop>::SharedPtr cli_stop_;
 
   // Mechanism to check on playback status
@@ -447,3 +453,73 @@ TEST_F(PlaySrvsTest, stop_in_active_play) {
   player_->wait_for_playback_to_finish();
   ASSERT_EQ(calls, 1);
 }
+
+TEST_F(PlaySrvsTest, control_services_do_not_wait_for_blocked_publish) {
+  struct PublishState
+  {
+    std::mutex m;
+    std::condition_variable cv;
+    bool release = false;
+    std::vector<rcutils_time_point_value_t> published_time_stamps;
+  };
+  auto state = std::make_shared<PublishState>();
+  ASSERT_TRUE(player_->is_paused());
+
+  // Block the first publish until released
+  const auto callback = [state](std::shared_ptr<rosbag2_storage::SerializedBagMessage> msg) {
+      std::unique_lock<std::mutex> lk{state->m};
+      state->published_time_stamps.push_back(msg->time_stamp);
+      state->cv.notify_all();
+      state->cv.wait_for(lk, 10s, [state] {return state->release;});
+    };
+  const auto pre_callback_handle = player_->add_on_play_message_pre_callback(callback);
+  ASSERT_NE(pre_callback_handle, rosbag2_transport::Player::invalid_callback_handle);
+
+  start_playback();
+  {
+    std::unique_lock<std::mutex> lk{state->m};
+    ASSERT_TRUE(
+      state->cv.wait_for(lk, 2s, [state] {return !state->published_time_stamps.empty();}));
+  }
+
+  // Pause and set_rate respond while the publish is blocked
+  service_call_pause();
+  ASSERT_TRUE(player_->is_paused());
+  auto set_request = std::make_shared<SetRate::Request>();
+  set_request->rate = 2.0;
+  ASSERT_TRUE(service_call_set_rate(set_request)->success);
+  ASSERT_EQ(service_call_get_rate()->rate, 2.0);
+
+  // Seek waits for the publish to return, without holding up the other services meanwhile
+  const auto seek_time_stamp =
+    static_cast<rcutils_time_point_value_t>(RCUTILS_MS_TO_NS(100 * ms_between_msgs_));
+  auto seek_request = std::make_shared<Seek::Request>();
+  seek_request->time = rclcpp::Time(seek_time_stamp);
+  auto seek_future = cli_seek_->async_send_request(seek_request);
+  EXPECT_EQ(seek_future.wait_for(200ms), std::future_status::timeout);
+  ASSERT_TRUE(service_call_is_paused());
+
+  {
+    std::lock_guard<std::mutex> lk{state->m};
+    state->release = true;
+  }
+  state->cv.notify_all();
+  ASSERT_EQ(seek_future.wait_for(service_call_timeout_), std::future_status::ready);
+  EXPECT_TRUE(seek_future.get()->success);
+
+  // Paused at the boundary after the blocked message, and continuing from the sought message
+  {
+    std::unique_lock<std::mutex> lk{state->m};
+    EXPECT_FALSE(
+      state->cv.wait_for(lk, 200ms, [state] {return state->published_time_stamps.size() > 1;}));
+  }
+  service_call_resume();
+  {
+    std::unique_lock<std::mutex> lk{state->m};
+    ASSERT_TRUE(
+      state->cv.wait_for(lk, 2s, [state] {return state->published_time_stamps.size() > 1;}));
+    EXPECT_EQ(state->published_time_stamps[0], 0);
+    EXPECT_EQ(state->published_time_stamps[1], seek_time_stamp);
+  }
+  player_->delete_on_play_message_callback(pre_callback_handle);
+}
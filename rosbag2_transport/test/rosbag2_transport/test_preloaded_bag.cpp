@@ -0,0 +1,122 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+
+#include "rosbag2_storage/ros_helper.hpp"
+#include "rosbag2_transport/preloaded_bag.hpp"
+
+using namespace ::testing;  // NOLINT
+
+using rosbag2_transport::PreloadedBag;
+
+namespace
+{
+rosbag2_storage::SerializedBagMessage make_message(
+  const std::string & topic_name, rcutils_time_point_value_t time_stamp, const std::string & data)
+{
+  rosbag2_storage::SerializedBagMessage message;
+  message.topic_name = topic_name;
+  message.time_stamp = time_stamp;
+  message.serialized_data = rosbag2_storage::make_serialized_message(data.data(), data.size());
+  return message;
+}
+
+std::string payload(const rosbag2_storage::SerializedBagMessage & message)
+{
+  return std::string(
+    reinterpret_cast<const char *>(message.serialized_data->buffer),
+    message.serialized_data->buffer_length);
+}
+}  // namespace
+
+TEST(TestPreloadedBag, messages_are_returned_with_payload_topic_and_time_stamps) {
+  PreloadedBag bag;
+  auto first = make_message("/a", 10, "first");
+  first.topic_id = 1;
+  first.send_timestamp = 9;
+  first.sequence_number = 3;
+  auto second = make_message("/b", 20, "second");
+  second.topic_id = 2;
+  ASSERT_TRUE(bag.add(first));
+  ASSERT_TRUE(bag.add(second));
+  ASSERT_TRUE(bag.add(make_message("/a", 30, "")));
+
+  ASSERT_EQ(bag.size(), 3u);
+  const auto message = bag.get(0);
+  EXPECT_EQ(message->topic_name, "/a");
+  EXPECT_EQ(message->topic_id, 1u);
+  EXPECT_EQ(message->time_stamp, 10);
+  EXPECT_EQ(message->send_timestamp, 9);
+  EXPECT_EQ(message->sequence_number, 3u);
+  EXPECT_EQ(payload(*message), "first");
+  EXPECT_EQ(payload(*bag.get(1)), "second");
+  EXPECT_EQ(bag.get(1)->topic_name, "/b");
+  EXPECT_EQ(bag.get(2)->topic_name, "/a");
+  EXPECT_EQ(bag.get(2)->serialized_data->buffer_length, 0u);
+}
+
+TEST(TestPreloadedBag, payloads_are_contiguous_in_the_arena) {
+  PreloadedBag bag;
+  ASSERT_TRUE(bag.add(make_message("/a", 10, "abc")));
+  ASSERT_TRUE(bag.add(make_message("/a", 20, "de")));
+
+  const auto first = bag.get(0);
+  const auto second = bag.get(1);
+  EXPECT_EQ(first->serialized_data->buffer + 3, second->serialized_data->buffer);
+}
+
+TEST(TestPreloadedBag, messages_outlive_the_bag) {
+  rosbag2_storage::SerializedBagMessageSharedPtr message;
+  {
+    PreloadedBag bag;
+    ASSERT_TRUE(bag.add(make_message("/a", 10, "kept")));
+    message = bag.get(0);
+  }
+  EXPECT_EQ(payload(*message), "kept");
+}
+
+TEST(TestPreloadedBag, find_returns_first_message_at_or_after_time_point) {
+  PreloadedBag bag;
+  ASSERT_TRUE(bag.add(make_message("/a", 10, "x")));
+  ASSERT_TRUE(bag.add(make_message("/a", 20, "x")));
+  ASSERT_TRUE(bag.add(make_message("/b", 20, "x")));
+  ASSERT_TRUE(bag.add(make_message("/a", 30, "x")));
+
+  EXPECT_EQ(bag.find(0), 0u);
+  EXPECT_EQ(bag.find(10), 0u);
+  EXPECT_EQ(bag.find(15), 1u);
+  EXPECT_EQ(bag.find(20), 1u);
+  EXPECT_EQ(bag.find(30), 3u);
+  EXPECT_EQ(bag.find(31), 4u);
+}
+
+TEST(TestPreloadedBag, messages_exceeding_the_budget_are_not_added) {
+  const std::string data(100, 'x');
+  PreloadedBag bag(250);
+  ASSERT_TRUE(bag.add(make_message("/a", 10, data)));
+  const size_t one_message = bag.size_in_bytes();
+  EXPECT_GT(one_message, data.size());
+
+  while (bag.size_in_bytes() + one_message <= 250) {
+    ASSERT_TRUE(bag.add(make_message("/a", 20, data)));
+  }
+  const size_t size = bag.size();
+  EXPECT_FALSE(bag.add(make_message("/a", 30, data)));
+  EXPECT_EQ(bag.size(), size);
+  EXPECT_LE(bag.size_in_bytes(), 250u);
+}
@@ -0,0 +1,93 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_transport/publisher_thread_pool.hpp"
+
+using namespace ::testing;  // NOLINT
+
+TEST(PublisherThreadPoolTest, runs_tasks_of_a_key_in_queued_order) {
+  rosbag2_transport::PublisherThreadPool pool(4);
+  std::mutex mutex;
+  std::map<std::string, std::vector<int>> order;
+  for (int i = 0; i < 1000; ++i) {
+    const std::string key = "/topic" + std::to_string(i % 7);
+    pool.queue(
+      key, [&mutex, &order, key, i]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order[key].push_back(i);
+      });
+  }
+  pool.wait_for_queued_tasks();
+
+  ASSERT_THAT(order, SizeIs(7u));
+  for (const auto & [key, values] : order) {
+    EXPECT_THAT(values, SizeIs(Ge(142u)));
+    for (size_t i = 1; i < values.size(); ++i) {
+      EXPECT_EQ(values[i], values[i - 1] + 7) << key;
+    }
+  }
+}
+
+TEST(PublisherThreadPoolTest, slow_task_does_not_block_tasks_of_other_threads) {
+  rosbag2_transport::PublisherThreadPool pool(2);
+  // Find a key which is run on another thread than "slow"
+  std::promise<std::thread::id> slow_thread;
+  pool.queue("slow", [&slow_thread]() {slow_thread.set_value(std::this_thread::get_id());});
+  const auto slow_thread_id = slow_thread.get_future().get();
+  std::string other_key;
+  for (int i = 0; other_key.empty(); ++i) {
+    std::promise<std::thread::id> thread;
+    const auto key = "key" + std::to_string(i);
+    pool.queue(key, [&thread]() {thread.set_value(std::this_thread::get_id());});
+    if (thread.get_future().get() != slow_thread_id) {
+      other_key = key;
+    }
+  }
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  pool.queue("slow", [released]() {released.wait();});
+  std::promise<void> other_done;
+  pool.queue(other_key, [&other_done]() {other_done.set_value();});
+  EXPECT_EQ(
+    other_done.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  release.set_value();
+  pool.wait_for_queued_tasks();
+}
+
+TEST(PublisherThreadPoolTest, keeps_running_after_task_throws) {
+  rosbag2_transport::PublisherThreadPool pool(1);
+  std::atomic<int> runs{0};
+  pool.queue("a", []() {throw std::runtime_error("failed");});
+  pool.queue("a", [&runs]() {++runs;});
+  pool.wait_for_queued_tasks();
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(pool.get_number_of_threads(), 1u);
+}
+
+TEST(PublisherThreadPoolTest, throws_without_threads) {
+  EXPECT_THROW(rosbag2_transport::PublisherThreadPool(0), std::invalid_argument);
+}
@@ -14,8 +14,12 @@
 
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -25,6 +29,9 @@
 #include "rosbag2_test_common/publication_manager.hpp"
 #include "rosbag2_test_common/wait_for.hpp"
 
+#include "rosbag2_interfaces/msg/record_statistics.hpp"
+
+#include "rosbag2_transport/intra_process_capture.hpp"
 #include "rosbag2_transport/recorder.hpp"
 
 #include "test_msgs/msg/arrays.hpp"
@@ -88,6 +95,211 @@ TEST_F(RecordIntegrationTestFixture, published_messages_from_multiple_topics_are
   EXPECT_THAT(array_messages[0]->float32_values, Eq(array_message->float32_values));
 }
 
+TEST_F(RecordIntegrationTestFixture, records_receive_timestamps_if_requested)
+{
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(string_topic, string_message, 3);
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic}, "rmw_format", 50ms};
+  record_options.use_receive_timestamp = true;
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  const auto start_time = std::chrono::system_clock::now().time_since_epoch();
+  recorder->record();
+
+  start_async_spin(recorder);
+
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+  pub_manager.run_publishers();
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  size_t expected_messages = 3;
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, &expected_messages]() {
+      return mock_writer.get_messages().size() >= expected_messages;
+    });
+  const auto end_time = std::chrono::system_clock::now().time_since_epoch();
+  auto recorded_messages = mock_writer.get_messages();
+  EXPECT_TRUE(ret) << "failed to capture expected messages in time";
+  ASSERT_THAT(recorded_messages, SizeIs(expected_messages));
+
+  for (size_t i = 0; i < recorded_messages.size(); ++i) {
+    EXPECT_GE(
+      recorded_messages[i]->time_stamp,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start_time).count());
+    EXPECT_LE(
+      recorded_messages[i]->time_stamp,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time).count());
+    if (i > 0) {
+      EXPECT_GE(recorded_messages[i]->time_stamp, recorded_messages[i - 1]->time_stamp);
+    }
+  }
+}
+
+TEST_F(RecordIntegrationTestFixture, measures_pipeline_latencies_if_requested)
+{
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(string_topic, string_message, 3);
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic}, "rmw_format", 50ms};
+  record_options.pipeline_statistics_interval = 10ms;
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  std::atomic<size_t> statistics_received{0};
+  auto statistics_sub = recorder->create_subscription<rosbag2_interfaces::msg::RecordStatistics>(
+    "~/record_statistics", 10,
+    [&statistics_received](rosbag2_interfaces::msg::RecordStatistics::ConstSharedPtr) {
+      statistics_received++;
+    });
+
+  start_async_spin(recorder);
+
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+  pub_manager.run_publishers();
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  size_t expected_messages = 3;
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, &expected_messages, &statistics_received]() {
+      return mock_writer.get_messages().size() >= expected_messages && statistics_received > 0;
+    });
+  EXPECT_TRUE(ret) << "failed to capture expected messages and statistics in time";
+
+  auto statistics = writer.get_pipeline_statistics();
+  ASSERT_NE(statistics, nullptr);
+  EXPECT_GE(
+    statistics->histogram(rosbag2_cpp::PipelineStage::SUBSCRIPTION_CALLBACK).count(),
+    expected_messages);
+  EXPECT_GE(
+    statistics->histogram(rosbag2_cpp::PipelineStage::WRITER_WRITE).count(), expected_messages);
+}
+
+TEST_F(RecordIntegrationTestFixture, throws_on_receive_timestamps_with_sim_time)
+{
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {"/string_topic"}, "rmw_format", 50ms};
+  record_options.use_sim_time = true;
+  record_options.use_receive_timestamp = true;
+  EXPECT_THROW(
+    std::make_shared<rosbag2_transport::Recorder>(
+      std::move(writer_), storage_options_, record_options), std::runtime_error);
+}
+
+TEST_F(RecordIntegrationTestFixture, records_topics_in_callback_groups_on_multiple_threads)
+{
+  auto array_message = get_messages_arrays()[0];
+  std::string array_topic = "/array_topic";
+
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(array_topic, array_message, 5);
+  pub_manager.setup_publisher(string_topic, string_message, 5);
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic, array_topic}, "rmw_format", 50ms};
+  record_options.callback_groups = "topic";
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  start_async_multi_threaded_spin(recorder, 2);
+
+  ASSERT_TRUE(pub_manager.wait_for_matched(array_topic.c_str()));
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+
+  pub_manager.run_publishers();
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  size_t expected_messages = 10;
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, &expected_messages]() {
+      return mock_writer.get_messages().size() >= expected_messages;
+    });
+  auto recorded_messages = mock_writer.get_messages();
+  EXPECT_TRUE(ret) << "failed to capture expected messages in time";
+  ASSERT_THAT(recorded_messages, SizeIs(expected_messages));
+  EXPECT_THAT(filter_messages<test_msgs::msg::Strings>(recorded_messages, string_topic), SizeIs(5));
+  EXPECT_THAT(filter_messages<test_msgs::msg::Arrays>(recorded_messages, array_topic), SizeIs(5));
+}
+
+TEST_F(RecordIntegrationTestFixture, records_topics_subscribed_on_multiple_threads)
+{
+  auto array_message = get_messages_arrays()[0];
+  std::string array_topic = "/array_topic";
+
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(array_topic, array_message, 5);
+  pub_manager.setup_publisher(string_topic, string_message, 5);
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic, array_topic}, "rmw_format", 50ms};
+  record_options.subscription_creation_threads = 2;
+  storage_options_.cache_topic_priorities = {{string_topic, 1}};
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  start_async_spin(recorder);
+
+  ASSERT_TRUE(pub_manager.wait_for_matched(array_topic.c_str()));
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+
+  pub_manager.run_publishers();
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  size_t expected_messages = 10;
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, &expected_messages]() {
+      return mock_writer.get_messages().size() >= expected_messages;
+    });
+  auto recorded_messages = mock_writer.get_messages();
+  EXPECT_TRUE(ret) << "failed to capture expected messages in time";
+  ASSERT_THAT(recorded_messages, SizeIs(expected_messages));
+  EXPECT_THAT(filter_messages<test_msgs::msg::Strings>(recorded_messages, string_topic), SizeIs(5));
+  EXPECT_THAT(filter_messages<test_msgs::msg::Arrays>(recorded_messages, array_topic), SizeIs(5));
+}
+
+TEST_F(RecordIntegrationTestFixture, throws_on_unknown_callback_group_partitioning)
+{
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {"/string_topic"}, "rmw_format", 50ms};
+  record_options.callback_groups = "per_message";
+  EXPECT_THROW(
+    std::make_shared<rosbag2_transport::Recorder>(
+      std::move(writer_), storage_options_, record_options), std::runtime_error);
+}
+
 TEST_F(RecordIntegrationTestFixture, can_record_again_after_stop)
 {
   auto string_message = get_messages_strings()[1];
@@ -415,3 +627,94 @@ TEST_F(RecordIntegrationTestFixture, write_split_callback_is_called)
   EXPECT_EQ(closed_file, "BagFile0");
   EXPECT_EQ(opened_file, "BagFile1");
 }
+
+TEST_F(RecordIntegrationTestFixture, records_publish_info_if_requested)
+{
+  auto string_message = get_messages_strings()[1];
+  std::string string_topic = "/string_topic";
+
+  rosbag2_test_common::PublicationManager pub_manager;
+  pub_manager.setup_publisher(string_topic, string_message, 3);
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {string_topic}, "rmw_format", 50ms};
+  record_options.record_publish_info = true;
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  start_async_spin(recorder);
+
+  ASSERT_TRUE(pub_manager.wait_for_matched(string_topic.c_str()));
+  pub_manager.run_publishers();
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+
+  size_t expected_messages = 3;
+  auto ret = rosbag2_test_common::wait_until_shutdown(
+    std::chrono::seconds(5),
+    [&mock_writer, &expected_messages]() {
+      return mock_writer.get_messages().size() >= expected_messages;
+    });
+  auto recorded_messages = mock_writer.get_messages();
+  EXPECT_TRUE(ret) << "failed to capture expected messages in time";
+  ASSERT_THAT(recorded_messages, SizeIs(expected_messages));
+
+  for (size_t i = 0; i < recorded_messages.size(); ++i) {
+    EXPECT_GT(recorded_messages[i]->send_timestamp, 0);
+    EXPECT_LE(recorded_messages[i]->send_timestamp, recorded_messages[i]->time_stamp);
+    // Not every middleware supports sequence numbers, they are 0 if it does not
+    if (i > 0 && recorded_messages[i]->sequence_number != 0) {
+      EXPECT_GT(recorded_messages[i]->sequence_number, recorded_messages[i - 1]->sequence_number);
+    }
+  }
+}
+
+TEST_F(RecordIntegrationTestFixture, captures_messages_of_publishers_in_the_same_process)
+{
+  std::string topic = "/captured_topic";
+  auto publisher_node = std::make_shared<rclcpp::Node>("capturing_publisher_node");
+  rosbag2_transport::CapturingPublisher<test_msgs::msg::Strings> publisher(
+    *publisher_node, topic, rclcpp::QoS(10));
+
+  rosbag2_transport::RecordOptions record_options =
+  {false, false, {topic}, "rmw_format", 50ms};
+  record_options.intra_process_capture = true;
+  record_options.topic_decimation[topic].keep_every_n = 2;
+  auto recorder = std::make_shared<rosbag2_transport::Recorder>(
+    std::move(writer_), storage_options_, record_options);
+  recorder->record();
+
+  start_async_spin(recorder);
+
+  ASSERT_TRUE(
+    rosbag2_test_common::wait_until_shutdown(
+      std::chrono::seconds(5),
+      [&topic]() {return rosbag2_transport::IntraProcessCapture::instance().is_captured(topic);}));
+
+  test_msgs::msg::Strings message;
+  for (size_t i = 0; i < 6; ++i) {
+    message.string_value = std::to_string(i);
+    publisher.publish(message);
+  }
+
+  auto & writer = recorder->get_writer_handle();
+  MockSequentialWriter & mock_writer =
+    static_cast<MockSequentialWriter &>(writer.get_implementation_handle());
+  // Captured messages are written on the thread which publishes them
+  auto string_messages = filter_messages<test_msgs::msg::Strings>(
+    mock_writer.get_messages(), topic);
+  ASSERT_THAT(string_messages, SizeIs(3));
+  EXPECT_EQ(string_messages[0]->string_value, "0");
+  EXPECT_EQ(string_messages[1]->string_value, "2");
+  EXPECT_EQ(string_messages[2]->string_value, "4");
+
+  // The subscription of the recorder ignores the messages published in this process
+  std::this_thread::sleep_for(200ms);
+  EXPECT_THAT(mock_writer.get_messages(), SizeIs(3));
+
+  recorder->stop();
+  EXPECT_FALSE(rosbag2_transport::IntraProcessCapture::instance().is_captured(topic));
+}
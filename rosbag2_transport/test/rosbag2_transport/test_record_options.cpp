@@ -33,9 +33,32 @@ TEST(record_options, test_yaml_serialization)
   original.compression_format = "h264";
   original.compression_queue_size = 2;
   original.compression_threads = 123;
+  original.compression_dictionary_training_messages = 1000;
+  original.compression_dictionary = "tf.dict";
+  original.compression_adaptive_level = true;
+  original.compression_min_level = -3;
+  original.compression_max_level = 5;
+  original.compression_policy = "auto";
+  original.compression_topic_policies["/camera"] = "never";
+  original.compression_probe_messages = 16;
+  original.compression_skip_ratio = 0.8;
+  original.compression_file_workers = 4;
+  original.compression_file_idle_io = true;
+  original.compression_file_max_concurrent = 2;
+  original.compression_file_read_bandwidth = 50000000;
+  original.compression_file_throttle_cache_fill = 0.75;
   original.topic_qos_profile_overrides.emplace("topic", rclcpp::QoS(10).transient_local());
   original.include_hidden_topics = true;
   original.include_unpublished_topics = true;
+  original.topic_decimation["/camera"].keep_every_n = 10;
+  original.topic_decimation["/imu"].max_frequency = 50.0;
+  rosbag2_transport::TopicRoute camera_route;
+  camera_route.name = "camera";
+  camera_route.topics_regex = "/camera/.*";
+  camera_route.compression_format = "zstd";
+  camera_route.compression_mode = "file";
+  camera_route.max_bagfile_size = 1024;
+  original.topic_routes.push_back(camera_route);
 
   auto node = YAML::convert<rosbag2_transport::RecordOptions>().encode(original);
 
@@ -49,5 +72,32 @@ TEST(record_options, test_yaml_serialization)
   CHECK(is_discovery_disabled);
   CHECK(topics);
   CHECK(rmw_serialization_format);
+  CHECK(compression_dictionary_training_messages);
+  CHECK(compression_dictionary);
+  CHECK(compression_adaptive_level);
+  CHECK(compression_min_level);
+  CHECK(compression_max_level);
+  CHECK(compression_policy);
+  CHECK(compression_topic_policies);
+  CHECK(compression_probe_messages);
+  CHECK(compression_skip_ratio);
+  CHECK(compression_file_workers);
+  CHECK(compression_file_idle_io);
+  CHECK(compression_file_max_concurrent);
+  CHECK(compression_file_read_bandwidth);
+  CHECK(compression_file_throttle_cache_fill);
   #undef CHECK
+  ASSERT_EQ(reconstructed.topic_decimation.size(), 2u);
+  EXPECT_EQ(reconstructed.topic_decimation["/camera"].keep_every_n, 10u);
+  EXPECT_EQ(reconstructed.topic_decimation["/camera"].max_frequency, 0.0);
+  EXPECT_EQ(reconstructed.topic_decimation["/imu"].keep_every_n, 1u);
+  EXPECT_EQ(reconstructed.topic_decimation["/imu"].max_frequency, 50.0);
+  ASSERT_EQ(reconstructed.topic_routes.size(), 1u);
+  EXPECT_EQ(reconstructed.topic_routes[0].name, "camera");
+  EXPECT_EQ(reconstructed.topic_routes[0].topics_regex, "/camera/.*");
+  EXPECT_EQ(reconstructed.topic_routes[0].compression_format, "zstd");
+  EXPECT_EQ(reconstructed.topic_routes[0].compression_mode, "file");
+  EXPECT_EQ(reconstructed.topic_routes[0].max_bagfile_size, 1024u);
+  EXPECT_FALSE(reconstructed.topic_routes[0].max_bagfile_duration.has_value());
+  EXPECT_FALSE(reconstructed.topic_routes[0].max_cache_size.has_value());
 }
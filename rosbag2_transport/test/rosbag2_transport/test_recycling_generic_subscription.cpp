@@ -0,0 +1,93 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <thread>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "rosbag2_transport/recycling_generic_subscription.hpp"
+
+using namespace ::testing;  // NOLINT
+
+class RecyclingGenericSubscriptionTest : public Test
+{
+public:
+  void SetUp() override
+  {
+    rclcpp::init(0, nullptr);
+    node_ = std::make_shared<rclcpp::Node>("recycling_generic_subscription_test_node");
+  }
+
+  void TearDown() override
+  {
+    node_.reset();
+    rclcpp::shutdown();
+  }
+
+  std::shared_ptr<rosbag2_transport::RecyclingGenericSubscription> create_subscription(
+    size_t max_free_messages)
+  {
+    return rosbag2_transport::create_recycling_generic_subscription(
+      *node_, "/topic", "test_msgs/msg/Strings", rclcpp::QoS(10),
+      [](std::shared_ptr<const rclcpp::SerializedMessage>) {}, rclcpp::SubscriptionOptions(),
+      max_free_messages);
+  }
+
+  std::shared_ptr<rclcpp::Node> node_;
+};
+
+TEST_F(RecyclingGenericSubscriptionTest, takes_next_message_into_buffer_of_released_message)
+{
+  auto subscription = create_subscription(1);
+  auto message = subscription->create_serialized_message();
+  message->reserve(1024);
+  message->get_rcl_serialized_message().buffer_length = 1000;
+  const auto buffer = message->get_rcl_serialized_message().buffer;
+
+  subscription->return_serialized_message(message);
+  EXPECT_EQ(subscription->get_number_of_free_messages(), 1u);
+
+  auto next_message = subscription->create_serialized_message();
+  EXPECT_EQ(next_message->get_rcl_serialized_message().buffer, buffer);
+  EXPECT_EQ(next_message->capacity(), 1024u);
+  EXPECT_EQ(next_message->size(), 0u);
+  EXPECT_EQ(subscription->get_number_of_free_messages(), 0u);
+}
+
+TEST_F(RecyclingGenericSubscriptionTest, keeps_at_most_max_free_messages)
+{
+  auto subscription = create_subscription(2);
+  auto first = subscription->create_serialized_message();
+  auto second = subscription->create_serialized_message();
+  auto third = subscription->create_serialized_message();
+
+  first.reset();
+  second.reset();
+  third.reset();
+  EXPECT_EQ(subscription->get_number_of_free_messages(), 2u);
+}
+
+TEST_F(RecyclingGenericSubscriptionTest, messages_may_outlive_subscription_and_thread)
+{
+  auto subscription = create_subscription(1);
+  std::shared_ptr<const rclcpp::SerializedMessage> message =
+    subscription->create_serialized_message();
+  subscription.reset();
+
+  std::thread release_thread([message = std::move(message)]() mutable {message.reset();});
+  release_thread.join();
+}
@@ -0,0 +1,125 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_transport/reverse_block_reader.hpp"
+
+#include "mock_sequential_reader.hpp"
+
+using namespace ::testing;  // NOLINT
+
+using rosbag2_transport::ReverseBlockReader;
+
+class ReverseBlockReaderTest : public Test
+{
+public:
+  // Prepare messages with the given time stamps, on /a, or /b for odd time stamps
+  void prepare(const std::vector<rcutils_time_point_value_t> & time_stamps)
+  {
+    std::vector<std::shared_ptr<rosbag2_storage::SerializedBagMessage>> messages;
+    for (const auto time_stamp : time_stamps) {
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->time_stamp = time_stamp;
+      message->topic_name = time_stamp % 2 == 0 ? "/a" : "/b";
+      messages.push_back(message);
+    }
+    auto mock_reader = std::make_unique<MockSequentialReader>();
+    mock_reader->prepare(messages, {{"/a", "type", "cdr", {}, ""}, {"/b", "type", "cdr", {}, ""}});
+    mock_reader_ = mock_reader.get();
+    reader_ = std::make_unique<rosbag2_cpp::Reader>(std::move(mock_reader));
+  }
+
+  std::vector<rcutils_time_point_value_t> read_all(ReverseBlockReader & reverse_reader)
+  {
+    std::vector<rcutils_time_point_value_t> time_stamps;
+    while (reverse_reader.has_next()) {
+      time_stamps.push_back(reverse_reader.read_next()->time_stamp);
+    }
+    return time_stamps;
+  }
+
+  MockSequentialReader * mock_reader_ = nullptr;
+  std::unique_ptr<rosbag2_cpp::Reader> reader_;
+};
+
+TEST_F(ReverseBlockReaderTest, reads_messages_backwards_in_blocks) {
+  std::vector<rcutils_time_point_value_t> time_stamps;
+  for (rcutils_time_point_value_t time_stamp = 0; time_stamp < RCUTILS_MS_TO_NS(100);
+    time_stamp += RCUTILS_MS_TO_NS(1))
+  {
+    time_stamps.push_back(time_stamp);
+  }
+  prepare(time_stamps);
+  ReverseBlockReader reverse_reader(*reader_, {}, 0, 10);
+
+  reverse_reader.seek(time_stamps.back());
+  const auto read = read_all(reverse_reader);
+  EXPECT_THAT(read, ElementsAreArray(time_stamps.rbegin(), time_stamps.rend()));
+  // Each block was read with one seek
+  EXPECT_GT(mock_reader_->get_number_of_seeks(), 1u);
+  EXPECT_LT(mock_reader_->get_number_of_seeks(), 20u);
+}
+
+TEST_F(ReverseBlockReaderTest, messages_at_block_boundaries_are_read_once) {
+  // Blocks are at least a millisecond long
+  const rcutils_time_point_value_t ms = RCUTILS_MS_TO_NS(1);
+  prepare({0, 0, ms, 2 * ms, 2 * ms, 2 * ms, 3 * ms, 4 * ms, 4 * ms});
+  ReverseBlockReader reverse_reader(*reader_, {}, 0, 1);
+
+  reverse_reader.seek(4 * ms);
+  EXPECT_THAT(
+    read_all(reverse_reader),
+    ElementsAre(4 * ms, 4 * ms, 3 * ms, 2 * ms, 2 * ms, 2 * ms, ms, 0, 0));
+  EXPECT_EQ(mock_reader_->get_number_of_seeks(), 5u);
+}
+
+TEST_F(ReverseBlockReaderTest, seek_continues_from_last_message_up_to_time_point) {
+  prepare({10, 20, 30, 40, 50});
+  ReverseBlockReader reverse_reader(*reader_, {}, 0, 2);
+
+  reverse_reader.seek(35);
+  ASSERT_TRUE(reverse_reader.has_next());
+  EXPECT_EQ(reverse_reader.read_next()->time_stamp, 30);
+
+  reverse_reader.seek(40);
+  EXPECT_THAT(read_all(reverse_reader), ElementsAre(40, 30, 20, 10));
+}
+
+TEST_F(ReverseBlockReaderTest, stops_at_start_time) {
+  prepare({10, 20, 30, 40, 50});
+  ReverseBlockReader reverse_reader(*reader_, {}, 20, 2);
+
+  reverse_reader.seek(50);
+  EXPECT_THAT(read_all(reverse_reader), ElementsAre(50, 40, 30, 20));
+
+  reverse_reader.seek(15);
+  EXPECT_FALSE(reverse_reader.has_next());
+}
+
+TEST_F(ReverseBlockReaderTest, keeps_topic_filter) {
+  prepare({10, 11, 20, 21, 30});
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {"/a"};
+  ReverseBlockReader reverse_reader(*reader_, storage_filter, 0, 2);
+
+  reverse_reader.seek(30);
+  EXPECT_THAT(read_all(reverse_reader), ElementsAre(30, 20, 10));
+}
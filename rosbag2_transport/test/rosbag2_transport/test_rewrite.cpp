@@ -136,6 +136,32 @@ TEST_P(TestRewrite, test_merge) {
   }
 }
 
+TEST_P(TestRewrite, test_merge_writes_messages_in_chronological_order) {
+  use_input_a();
+  use_input_b();
+
+  rosbag2_storage::StorageOptions output_storage;
+  output_storage.uri = (output_dir_ / "merged_in_order").string();
+  output_storage.storage_id = storage_id_;
+  rosbag2_transport::RecordOptions output_record;
+  output_record.all = true;
+  output_bags_.push_back({output_storage, output_record});
+
+  rosbag2_transport::bag_rewrite(input_bags_, output_bags_);
+
+  auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(output_storage);
+  reader->open(output_storage);
+  size_t message_count = 0;
+  rcutils_time_point_value_t previous_time_stamp = 0;
+  while (reader->has_next()) {
+    const auto message = reader->read_next();
+    EXPECT_GE(message->time_stamp, previous_time_stamp);
+    previous_time_stamp = message->time_stamp;
+    message_count++;
+  }
+  EXPECT_EQ(message_count, 100u + 50u + 50u + 25u);
+}
+
 TEST_P(TestRewrite, test_message_definitions_stored_with_merge) {
   use_input_a();
   use_input_b();
@@ -248,6 +274,93 @@ TEST_P(TestRewrite, test_compress) {
   EXPECT_TRUE(first_storage.is_regular_file());
 }
 
+TEST_P(TestRewrite, test_split_files_written_concurrently) {
+  use_input_a();
+
+  rosbag2_storage::StorageOptions output_storage;
+  auto out_bag = output_dir_ / "split_concurrently";
+  output_storage.uri = out_bag.string();
+  output_storage.storage_id = storage_id_;
+  // Smallest split size of the storage, so that the MCAP output gets several segments
+  output_storage.max_bagfile_size = storage_id_ == "mcap" ? 1024 : 86016;
+  rosbag2_transport::RecordOptions output_record;
+  output_record.all = true;
+  output_record.split_writers = 3;
+  output_bags_.push_back({output_storage, output_record});
+
+  rosbag2_transport::bag_rewrite(input_bags_, output_bags_);
+
+  rosbag2_storage::MetadataIo metadata_io;
+  const auto metadata = metadata_io.read_metadata(out_bag.string());
+  EXPECT_EQ(metadata.message_count, 100u + 50u);
+  ASSERT_THAT(metadata.topics_with_message_count, SizeIs(2));
+  for (const auto & topic_info : metadata.topics_with_message_count) {
+    EXPECT_EQ(topic_info.message_count, topic_info.topic_metadata.name == "a_empty" ? 100u : 50u);
+  }
+  ASSERT_EQ(metadata.files.size(), metadata.relative_file_paths.size());
+  size_t file_message_count = 0;
+  for (const auto & file_info : metadata.files) {
+    EXPECT_TRUE((out_bag / file_info.path).is_regular_file());
+    file_message_count += file_info.message_count;
+  }
+  EXPECT_EQ(file_message_count, metadata.message_count);
+  // The part directories of the writers were merged into the bag
+  EXPECT_FALSE((out_bag / "part_0").exists());
+
+  auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(output_storage);
+  reader->open(output_storage);
+  size_t message_count = 0;
+  rcutils_time_point_value_t previous_time_stamp = 0;
+  while (reader->has_next()) {
+    const auto message = reader->read_next();
+    EXPECT_GE(message->time_stamp, previous_time_stamp);
+    previous_time_stamp = message->time_stamp;
+    message_count++;
+  }
+  EXPECT_EQ(message_count, 100u + 50u);
+}
+
+TEST_P(TestRewrite, test_time_slices_converted_concurrently) {
+  use_input_a();
+
+  rosbag2_storage::StorageOptions output_storage;
+  auto out_bag = output_dir_ / "time_slices";
+  output_storage.uri = out_bag.string();
+  output_storage.storage_id = storage_id_;
+  rosbag2_transport::RecordOptions output_record;
+  output_record.all = true;
+  output_record.time_slices = 3;
+  output_bags_.push_back({output_storage, output_record});
+
+  rosbag2_transport::bag_rewrite(input_bags_, output_bags_);
+
+  rosbag2_storage::MetadataIo metadata_io;
+  const auto metadata = metadata_io.read_metadata(out_bag.string());
+  EXPECT_EQ(metadata.message_count, 100u + 50u);
+  ASSERT_THAT(metadata.topics_with_message_count, SizeIs(2));
+  for (const auto & topic_info : metadata.topics_with_message_count) {
+    EXPECT_EQ(topic_info.message_count, topic_info.topic_metadata.name == "a_empty" ? 100u : 50u);
+  }
+  // Every slice was written into a file of its own
+  EXPECT_EQ(metadata.files.size(), 3u);
+  for (size_t i = 1; i < metadata.files.size(); ++i) {
+    EXPECT_GT(metadata.files[i].starting_time, metadata.files[i - 1].starting_time);
+  }
+  EXPECT_FALSE((out_bag / "slice_0").exists());
+
+  auto reader = rosbag2_transport::ReaderWriterFactory::make_reader(output_storage);
+  reader->open(output_storage);
+  size_t message_count = 0;
+  rcutils_time_point_value_t previous_time_stamp = 0;
+  while (reader->has_next()) {
+    const auto message = reader->read_next();
+    EXPECT_GE(message->time_stamp, previous_time_stamp);
+    previous_time_stamp = message->time_stamp;
+    message_count++;
+  }
+  EXPECT_EQ(message_count, 100u + 50u);
+}
+
 INSTANTIATE_TEST_SUITE_P(
   ParametrizedRewriteTests,
   TestRewrite,
@@ -0,0 +1,157 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rosbag2_transport/split_file_uploader.hpp"
+
+using namespace testing;  // NOLINT
+using namespace std::chrono_literals;  // NOLINT
+
+using rosbag2_transport::SplitFileUploader;
+
+class SplitFileUploaderTest : public Test
+{
+public:
+  SplitFileUploaderTest()
+  {
+    directory_ = std::filesystem::temp_directory_path() /
+      ("split_file_uploader_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+    std::filesystem::create_directories(directory_ / "bag");
+  }
+
+  ~SplitFileUploaderTest() override
+  {
+    std::filesystem::remove_all(directory_);
+  }
+
+  std::string make_file(const std::string & name)
+  {
+    const auto path = directory_ / "bag" / name;
+    std::ofstream(path) << "data of " << name;
+    return path.string();
+  }
+
+  SplitFileUploader::UploadFunction record_uploads(size_t failures = 0)
+  {
+    return [this, failures](const std::string &, const std::string & key) mutable {
+             if (failures > 0) {
+               --failures;
+               return false;
+             }
+             std::lock_guard<std::mutex> lock(mutex_);
+             uploaded_keys_.push_back(key);
+             return true;
+           };
+  }
+
+  std::vector<std::string> uploaded_keys()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return uploaded_keys_;
+  }
+
+  std::filesystem::path directory_;
+  std::mutex mutex_;
+  std::vector<std::string> uploaded_keys_;
+};
+
+TEST_F(SplitFileUploaderTest, uploads_files_in_order) {
+  SplitFileUploader::Options options;
+  options.command = "unused";
+  SplitFileUploader uploader(options, record_uploads());
+  uploader.enqueue(make_file("bag_0.mcap"));
+  uploader.enqueue(make_file("bag_1.mcap"));
+  ASSERT_TRUE(uploader.wait_for_uploads(10s));
+  EXPECT_THAT(uploaded_keys(), ElementsAre("bag/bag_0.mcap", "bag/bag_1.mcap"));
+  EXPECT_EQ(uploader.pending_count(), 0u);
+}
+
+TEST_F(SplitFileUploaderTest, retries_failed_uploads) {
+  SplitFileUploader::Options options;
+  options.command = "unused";
+  options.retry_interval = 1ms;
+  SplitFileUploader uploader(options, record_uploads(3));
+  uploader.enqueue(make_file("bag_0.mcap"));
+  ASSERT_TRUE(uploader.wait_for_uploads(10s));
+  EXPECT_THAT(uploaded_keys(), ElementsAre("bag/bag_0.mcap"));
+}
+
+TEST_F(SplitFileUploaderTest, resumes_pending_uploads_from_journal) {
+  SplitFileUploader::Options options;
+  options.command = "unused";
+  options.journal_path = (directory_ / "journal.txt").string();
+  options.retry_interval = 1h;
+  {
+    SplitFileUploader failing_uploader(
+      options, [](const std::string &, const std::string &) {return false;});
+    failing_uploader.enqueue(make_file("bag_0.mcap"));
+    failing_uploader.enqueue(make_file("bag_1.mcap"));
+    EXPECT_FALSE(failing_uploader.wait_for_uploads(10ms));
+  }
+
+  SplitFileUploader uploader(options, record_uploads());
+  ASSERT_TRUE(uploader.wait_for_uploads(10s));
+  EXPECT_THAT(uploaded_keys(), ElementsAre("bag/bag_0.mcap", "bag/bag_1.mcap"));
+  std::ifstream journal(options.journal_path);
+  std::string line;
+  EXPECT_FALSE(std::getline(journal, line));
+}
+
+TEST_F(SplitFileUploaderTest, expands_and_quotes_command_arguments) {
+#ifndef _WIN32
+  EXPECT_EQ(
+    SplitFileUploader::expand_command("up {file} s3://b/{key}", "/it's/a.mcap", "d/a.mcap"),
+    "up '/it'\\''s/a.mcap' s3://b/'d/a.mcap'");
+#endif
+  EXPECT_EQ(SplitFileUploader::make_key("/data/bag/bag_0.mcap"), "bag/bag_0.mcap");
+  EXPECT_EQ(SplitFileUploader::make_key("bag_0.mcap"), "bag_0.mcap");
+}
+
+#ifndef _WIN32
+TEST_F(SplitFileUploaderTest, runs_upload_command) {
+  const auto destination = directory_ / "uploaded";
+  std::filesystem::create_directories(destination / "bag");
+  SplitFileUploader::Options options;
+  options.command = "cp {file} '" + destination.string() + "'/{key}";
+  SplitFileUploader uploader(options);
+  uploader.enqueue(make_file("bag_0.mcap"));
+  ASSERT_TRUE(uploader.wait_for_uploads(10s));
+  std::ifstream uploaded(destination / "bag" / "bag_0.mcap");
+  std::string content;
+  std::getline(uploaded, content);
+  EXPECT_EQ(content, "data of bag_0.mcap");
+}
+
+TEST_F(SplitFileUploaderTest, stop_terminates_running_upload) {
+  SplitFileUploader::Options options;
+  options.command = "sleep 60";
+  SplitFileUploader uploader(options);
+  uploader.enqueue(make_file("bag_0.mcap"));
+  const auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(100ms);
+  uploader.stop();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 30s);
+  EXPECT_EQ(uploader.pending_count(), 1u);
+}
+#endif
@@ -0,0 +1,92 @@
+// Copyright 2024 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "rosbag2_transport/topic_decimator.hpp"
+
+using namespace ::testing;  // NOLINT
+
+using rosbag2_transport::TopicDecimation;
+using rosbag2_transport::TopicDecimator;
+
+namespace
+{
+constexpr rcutils_time_point_value_t kMillisecond = 1000000;
+
+// Indices of the kept messages, received every period starting at 0
+std::vector<int> kept_messages(
+  TopicDecimator & decimator, int count, rcutils_time_point_value_t period)
+{
+  std::vector<int> kept;
+  for (int i = 0; i < count; ++i) {
+    if (decimator.keep(i * period)) {
+      kept.push_back(i);
+    }
+  }
+  return kept;
+}
+}  // namespace
+
+TEST(TopicDecimatorTest, keeps_every_message_by_default) {
+  TopicDecimator decimator{TopicDecimation{}};
+  EXPECT_THAT(kept_messages(decimator, 4, 0), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(TopicDecimatorTest, keeps_every_nth_message_starting_with_the_first) {
+  TopicDecimation decimation;
+  decimation.keep_every_n = 3;
+  TopicDecimator decimator(decimation);
+  EXPECT_THAT(kept_messages(decimator, 8, kMillisecond), ElementsAre(0, 3, 6));
+}
+
+TEST(TopicDecimatorTest, limits_rate_of_kept_messages) {
+  TopicDecimation decimation;
+  decimation.max_frequency = 100.0;
+  TopicDecimator decimator(decimation);
+  // Received at 400 Hz
+  EXPECT_THAT(
+    kept_messages(decimator, 10, 5 * kMillisecond / 2), ElementsAre(0, 4, 8));
+}
+
+TEST(TopicDecimatorTest, applies_rate_limit_to_every_nth_message) {
+  TopicDecimation decimation;
+  decimation.keep_every_n = 2;
+  decimation.max_frequency = 100.0;
+  TopicDecimator decimator(decimation);
+  // Every second message is 6 ms after the last one, so that only every fourth one is kept
+  EXPECT_THAT(kept_messages(decimator, 10, 3 * kMillisecond), ElementsAre(0, 4, 8));
+}
+
+TEST(TopicDecimatorTest, keeps_next_message_when_time_jumps_back) {
+  TopicDecimation decimation;
+  decimation.max_frequency = 1.0;
+  TopicDecimator decimator(decimation);
+  EXPECT_TRUE(decimator.keep(1000 * kMillisecond));
+  EXPECT_FALSE(decimator.keep(1500 * kMillisecond));
+  EXPECT_TRUE(decimator.keep(0));
+  EXPECT_FALSE(decimator.keep(500 * kMillisecond));
+}
+
+TEST(TopicDecimatorTest, rejects_invalid_decimation) {
+  TopicDecimation decimation;
+  decimation.keep_every_n = 0;
+  EXPECT_THROW(TopicDecimator{decimation}, std::invalid_argument);
+  decimation.keep_every_n = 1;
+  decimation.max_frequency = -1.0;
+  EXPECT_THROW(TopicDecimator{decimation}, std::invalid_argument);
+}
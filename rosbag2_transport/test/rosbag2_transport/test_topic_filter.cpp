@@ -204,6 +204,21 @@ TEST_F(RegexFixture, regex_all_and_filter)
   EXPECT_THAT(filtered_topics, SizeIs(6));
 }
 
+TEST_F(RegexFixture, repeated_filter_uses_cached_names_but_current_types)
+{
+  rosbag2_transport::RecordOptions record_options;
+  record_options.regex = "^/inval";
+  record_options.all = false;
+  rosbag2_transport::TopicFilter filter{record_options, nullptr, true};
+  EXPECT_THAT(filter.filter_topics(topics_and_types_), SizeIs(2));
+
+  topics_and_types_["/invalid_topic"].push_back("other_topic_type");
+  topics_and_types_["/inverted"] = {"inverted_topic_type"};
+  auto filtered_topics = filter.filter_topics(topics_and_types_);
+  EXPECT_THAT(filtered_topics, SizeIs(1));
+  EXPECT_TRUE(filtered_topics.find("/invalidated_topic") != filtered_topics.end());
+}
+
 TEST_F(RegexFixture, do_not_print_warning_about_unknown_types_if_topic_is_not_selected) {
   {  // Check for topics explicitly selected via "topics" list
     rosbag2_transport::RecordOptions record_options;